@@ -0,0 +1,74 @@
+/**
+ * @file callbacks_bench.cpp
+ *
+ * Benchmarks of the overhead of the callbacks on the steps of SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+using namespace ens::test;
+
+//! A callback that only implements EndEpoch().
+class EndEpochOnly
+{
+ public:
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  {
+    benchmark::DoNotOptimize(objective);
+  }
+};
+
+//! A callback that is called after every step.
+class CountSteps
+{
+ public:
+  CountSteps() : steps(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    ++steps;
+  }
+
+  size_t steps;
+};
+
+/**
+ * Run SGD with one point per batch on the 2-dimensional Rosenbrock function,
+ * so that the steps are so cheap that the overhead of the callbacks shows;
+ * the argument is the number of steps.  Without callbacks and with callbacks
+ * that don't implement the per-step methods, the times should be the same.
+ */
+template<typename... CallbackTypes>
+static void BM_SGDCallbacks(benchmark::State& state)
+{
+  const size_t steps = state.range(0);
+  GeneralizedRosenbrockFunction f(2);
+  StandardSGD s(1e-6, 1, steps, -1.0, false);
+
+  for (auto _ : state)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    benchmark::DoNotOptimize(s.Optimize(f, coordinates, CallbackTypes()...));
+  }
+
+  state.SetItemsProcessed(state.iterations() * steps);
+}
+
+BENCHMARK(BM_SGDCallbacks<>)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_SGDCallbacks, EndEpochOnly)->Arg(100000);
+BENCHMARK_TEMPLATE(BM_SGDCallbacks, CountSteps)->Arg(100000);
@@ -0,0 +1,72 @@
+/**
+ * @file evolution_bench.cpp
+ *
+ * Benchmarks of the cost of a generation of CMA-ES and NSGA-II.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run a fixed number of CMA-ES generations on the generalized Rosenbrock
+ * function; the argument is the dimension of the problem.
+ */
+template<typename CMAESType>
+static void BM_CMAESGenerations(benchmark::State& state)
+{
+  const size_t generations = 10;
+  GeneralizedRosenbrockFunction f(state.range(0));
+
+  // A negative tolerance disables the convergence check.
+  CMAESType cmaes(0, -1, 1, 32, generations, -1.0);
+
+  for (auto _ : state)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    benchmark::DoNotOptimize(cmaes.Optimize(f, coordinates));
+  }
+
+  state.counters["generations"] = benchmark::Counter(
+      state.iterations() * generations, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_TEMPLATE(BM_CMAESGenerations, CMAES<>)
+    ->RangeMultiplier(10)->Range(10, 1000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_CMAESGenerations, ApproxCMAES<>)
+    ->RangeMultiplier(10)->Range(10, 1000)->Unit(benchmark::kMillisecond);
+
+/**
+ * Run a fixed number of NSGA-II generations on the Fonseca-Fleming function;
+ * the argument is the population size.
+ */
+static void BM_NSGA2Generations(benchmark::State& state)
+{
+  const size_t generations = 10;
+  FonsecaFlemingFunction<arma::mat> fonsecaFleming;
+  const arma::vec lowerBound = { -4, -4, -4 };
+  const arma::vec upperBound = { 4, 4, 4 };
+
+  NSGA2 opt(state.range(0), generations, 0.6, 0.3, 1e-3, 1e-6, lowerBound,
+      upperBound);
+
+  for (auto _ : state)
+  {
+    arma::mat coordinates = fonsecaFleming.GetInitialPoint();
+    auto objectives = fonsecaFleming.GetObjectives();
+    benchmark::DoNotOptimize(opt.Optimize(objectives, coordinates));
+  }
+
+  state.counters["generations"] = benchmark::Counter(
+      state.iterations() * generations, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_NSGA2Generations)->RangeMultiplier(4)->Range(20, 1280)
+    ->Unit(benchmark::kMillisecond);
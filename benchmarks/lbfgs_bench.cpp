@@ -0,0 +1,44 @@
+/**
+ * @file lbfgs_bench.cpp
+ *
+ * Benchmarks of the cost of an L-BFGS iteration on the generalized Rosenbrock
+ * function, for several dimensions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run a fixed number of L-BFGS iterations; the argument is the dimension of
+ * the problem.
+ */
+static void BM_LBFGSIterations(benchmark::State& state)
+{
+  const size_t iterations = 20;
+  GeneralizedRosenbrockFunction f(state.range(0));
+
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = iterations;
+  lbfgs.MinGradientNorm() = 0.0;
+  lbfgs.Factr() = 0.0;
+
+  for (auto _ : state)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    benchmark::DoNotOptimize(lbfgs.Optimize(f, coordinates));
+  }
+
+  state.counters["iterations"] = benchmark::Counter(
+      state.iterations() * iterations, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_LBFGSIterations)->RangeMultiplier(10)->Range(10, 10000)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,52 @@
+/**
+ * @file parallel_sgd_bench.cpp
+ *
+ * Benchmarks of the scaling of ParallelSGD with the number of threads.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run one pass of ParallelSGD over the 100000-dimensional generalized
+ * Rosenbrock function; the argument is the number of threads.  The wall clock
+ * time is reported, since the CPU time of all threads is not of interest.
+ */
+static void BM_ParallelSGDThreads(benchmark::State& state)
+{
+  const size_t threads = state.range(0);
+#ifdef ENS_USE_OPENMP
+  omp_set_num_threads(threads);
+#else
+  if (threads > 1)
+  {
+    state.SkipWithError("ensmallen was compiled without OpenMP.");
+    return;
+  }
+#endif
+
+  GeneralizedRosenbrockFunction f(100000);
+  const size_t numFunctions = f.NumFunctions();
+  // With two iterations there is a single pass over the data.
+  ParallelSGD<ConstantStep> s(2, (numFunctions + threads - 1) / threads, -1.0,
+      true, ConstantStep(1e-6));
+
+  for (auto _ : state)
+  {
+    arma::mat coordinates = f.GetInitialPoint();
+    benchmark::DoNotOptimize(s.Optimize(f, coordinates));
+  }
+
+  state.SetItemsProcessed(state.iterations() * numFunctions);
+}
+
+BENCHMARK(BM_ParallelSGDThreads)->RangeMultiplier(2)->Range(1, 64)
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
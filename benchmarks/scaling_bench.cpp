@@ -0,0 +1,367 @@
+/**
+ * @file scaling_bench.cpp
+ *
+ * A harness that measures the time and the number of function evaluations
+ * that optimizers need to reach a given objective on the large-scale problems
+ * (IllConditionedQuadraticFunction, SparseLogisticRegressionFunction and
+ * MatrixFactorizationFunction), sweeping the problem size and the number of
+ * threads.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A function that forwards to another function, and counts the number of
+ * evaluated functions (points): a call with a batch counts the size of the
+ * batch, and a call without counts all functions.  An Evaluate() and a
+ * Gradient() call for the same batch count twice.
+ */
+template<typename FunctionType>
+class CountedFunction
+{
+ public:
+  CountedFunction(FunctionType& function) : function(function), count(0) { }
+
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  void Shuffle() { function.Shuffle(); }
+
+  template<typename MatType>
+  auto Evaluate(const MatType& coordinates) const
+      -> decltype(std::declval<FunctionType&>().Evaluate(coordinates))
+  {
+    count += function.NumFunctions();
+    return function.Evaluate(coordinates);
+  }
+
+  template<typename MatType>
+  auto Evaluate(const MatType& coordinates,
+                const size_t begin,
+                const size_t batchSize) const
+      -> decltype(std::declval<FunctionType&>().Evaluate(coordinates, begin,
+          batchSize))
+  {
+    count += batchSize;
+    return function.Evaluate(coordinates, begin, batchSize);
+  }
+
+  template<typename MatType, typename GradType>
+  auto Gradient(const MatType& coordinates, GradType& gradient) const
+      -> decltype(std::declval<FunctionType&>().Gradient(coordinates,
+          gradient))
+  {
+    count += function.NumFunctions();
+    function.Gradient(coordinates, gradient);
+  }
+
+  template<typename MatType, typename GradType>
+  auto Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize) const
+      -> decltype(std::declval<FunctionType&>().Gradient(coordinates, begin,
+          gradient, batchSize))
+  {
+    count += batchSize;
+    function.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+  //! Get the number of evaluated functions.
+  size_t Count() const { return count; }
+
+ private:
+  FunctionType& function;
+  mutable std::atomic<size_t> count;
+};
+
+/**
+ * A callback that terminates the optimization once the objective reaches the
+ * target, and records the time and the number of evaluated functions.  The
+ * objective is either given by the optimizer (to Evaluate(), for optimizers
+ * that evaluate the full objective), or computed after every step or epoch.
+ * The time spent computing the objective is not counted.
+ */
+template<typename FunctionType>
+class ToleranceStop
+{
+ public:
+  enum Check { Step, Epoch, Evaluation };
+
+  ToleranceStop(FunctionType& function,
+                const CountedFunction<FunctionType>& counted,
+                const double target,
+                const Check check) :
+      function(function),
+      counted(counted),
+      target(target),
+      check(check),
+      reached(false),
+      seconds(0.0),
+      evaluations(0)
+  { }
+
+  template<typename OptimizerType, typename FunctionType2, typename MatType>
+  void BeginOptimization(OptimizerType&, FunctionType2&, MatType&)
+  {
+    start = std::chrono::steady_clock::now();
+    excluded = std::chrono::steady_clock::duration::zero();
+  }
+
+  template<typename OptimizerType, typename FunctionType2, typename MatType>
+  bool Evaluate(OptimizerType&, FunctionType2&, const MatType&,
+                const double objective)
+  {
+    return (check == Evaluation) && Reached(objective);
+  }
+
+  template<typename OptimizerType, typename FunctionType2, typename MatType>
+  bool StepTaken(OptimizerType&, FunctionType2&, const MatType& coordinates)
+  {
+    return (check == Step) && Reached(Objective(coordinates));
+  }
+
+  template<typename OptimizerType, typename FunctionType2, typename MatType>
+  bool EndEpoch(OptimizerType&, FunctionType2&, const MatType& coordinates,
+                const size_t, const double)
+  {
+    return (check == Epoch) && Reached(Objective(coordinates));
+  }
+
+  bool Succeeded() const { return reached; }
+  double Seconds() const { return seconds; }
+  size_t Evaluations() const { return evaluations; }
+
+ private:
+  //! Compute the full objective, without counting the time.
+  template<typename MatType>
+  double Objective(const MatType& coordinates)
+  {
+    const auto begin = std::chrono::steady_clock::now();
+    const double objective = function.Evaluate(coordinates);
+    excluded += std::chrono::steady_clock::now() - begin;
+    return objective;
+  }
+
+  bool Reached(const double objective)
+  {
+    if (reached || objective > target)
+      return reached;
+
+    reached = true;
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+        start - excluded).count();
+    evaluations = counted.Count();
+    return true;
+  }
+
+  FunctionType& function;
+  const CountedFunction<FunctionType>& counted;
+  double target;
+  Check check;
+  bool reached;
+  double seconds;
+  size_t evaluations;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::duration excluded;
+};
+
+//! Use the given number of threads; return false if that isn't possible.
+static bool SetThreads(benchmark::State& state, const size_t threads)
+{
+#ifdef ENS_USE_OPENMP
+  omp_set_num_threads(threads);
+  return true;
+#else
+  if (threads > 1)
+    state.SkipWithError("ensmallen was compiled without OpenMP.");
+  return threads == 1;
+#endif
+}
+
+/**
+ * Optimize until the objective is reduced to the given fraction of the
+ * objective at the initial point, and report the time and the number of
+ * evaluated functions (also as passes over the data).
+ */
+template<typename OptimizerType, typename FunctionType>
+static void RunToTolerance(benchmark::State& state,
+                           OptimizerType& optimizer,
+                           FunctionType& function,
+                           const double fraction,
+                           const typename ToleranceStop<FunctionType>::Check
+                               check)
+{
+  if (!SetThreads(state, state.range(1)))
+    return;
+
+  for (auto _ : state)
+  {
+    arma::mat coordinates = function.template GetInitialPoint<arma::mat>();
+    const double target = fraction * function.Evaluate(coordinates);
+
+    CountedFunction<FunctionType> counted(function);
+    ToleranceStop<FunctionType> stop(function, counted, target, check);
+    optimizer.Optimize(counted, coordinates, stop);
+
+    state.counters["reached"] = stop.Succeeded();
+    state.counters["seconds_to_tol"] = stop.Seconds();
+    state.counters["evaluations_to_tol"] = stop.Evaluations();
+    state.counters["passes_to_tol"] = (double) stop.Evaluations() /
+        function.NumFunctions();
+  }
+}
+
+//! The sizes and thread counts of the sweep.
+static void Sweep(benchmark::internal::Benchmark* b,
+                  const std::vector<int64_t>& sizes)
+{
+  for (const int64_t size : sizes)
+    for (int64_t threads = 1; threads <= 8; threads *= 2)
+      b->Args({ size, threads });
+
+  b->Iterations(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+// The quadratic function, with condition number 1000, split into 100 blocks.
+// The argument is the dimension.
+
+static void BM_QuadraticSGD(benchmark::State& state)
+{
+  IllConditionedQuadraticFunction f(state.range(0), 1000.0, 100);
+  StandardSGD sgd(1e-3, 1, 1000 * f.NumFunctions(), -1.0);
+  RunToTolerance(state, sgd, f, 1e-4,
+      ToleranceStop<IllConditionedQuadraticFunction>::Epoch);
+}
+
+static void BM_QuadraticAdam(benchmark::State& state)
+{
+  IllConditionedQuadraticFunction f(state.range(0), 1000.0, 100);
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 1000 * f.NumFunctions(), -1.0);
+  RunToTolerance(state, adam, f, 1e-4,
+      ToleranceStop<IllConditionedQuadraticFunction>::Epoch);
+}
+
+static void BM_QuadraticLBFGS(benchmark::State& state)
+{
+  IllConditionedQuadraticFunction f(state.range(0), 1000.0, 100);
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 10000;
+  RunToTolerance(state, lbfgs, f, 1e-4,
+      ToleranceStop<IllConditionedQuadraticFunction>::Step);
+}
+
+static void QuadraticSweep(benchmark::internal::Benchmark* b)
+{
+  Sweep(b, { 10000, 100000, 1000000 });
+}
+
+BENCHMARK(BM_QuadraticSGD)->Apply(QuadraticSweep);
+BENCHMARK(BM_QuadraticAdam)->Apply(QuadraticSweep);
+BENCHMARK(BM_QuadraticLBFGS)->Apply(QuadraticSweep);
+
+// Sparse logistic regression with 10 points per feature and a density of 1%.
+// The argument is the number of features.
+
+static SparseLogisticRegressionFunction SparseLogisticRegression(
+    const size_t dimensionality)
+{
+  arma::arma_rng::set_seed(42);
+  return SparseLogisticRegressionFunction(dimensionality, 10 * dimensionality,
+      0.01);
+}
+
+static void BM_SparseLogisticRegressionSGD(benchmark::State& state)
+{
+  SparseLogisticRegressionFunction f = SparseLogisticRegression(
+      state.range(0));
+  StandardSGD sgd(0.01, 32, 100 * f.NumFunctions(), -1.0);
+  RunToTolerance(state, sgd, f, 0.5,
+      ToleranceStop<SparseLogisticRegressionFunction>::Epoch);
+}
+
+static void BM_SparseLogisticRegressionAdam(benchmark::State& state)
+{
+  SparseLogisticRegressionFunction f = SparseLogisticRegression(
+      state.range(0));
+  Adam adam(0.001, 32, 0.9, 0.999, 1e-8, 100 * f.NumFunctions(), -1.0);
+  RunToTolerance(state, adam, f, 0.5,
+      ToleranceStop<SparseLogisticRegressionFunction>::Epoch);
+}
+
+static void BM_SparseLogisticRegressionLBFGS(benchmark::State& state)
+{
+  SparseLogisticRegressionFunction f = SparseLogisticRegression(
+      state.range(0));
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 1000;
+  RunToTolerance(state, lbfgs, f, 0.5,
+      ToleranceStop<SparseLogisticRegressionFunction>::Step);
+}
+
+static void BM_SparseLogisticRegressionParallelSGD(benchmark::State& state)
+{
+  SparseLogisticRegressionFunction f = SparseLogisticRegression(
+      state.range(0));
+  ParallelSGD<ConstantStep> sgd(100, (f.NumFunctions() + state.range(1) - 1) /
+      state.range(1), -1.0, true, ConstantStep(0.01));
+  RunToTolerance(state, sgd, f, 0.5,
+      ToleranceStop<SparseLogisticRegressionFunction>::Evaluation);
+}
+
+static void SparseLogisticRegressionSweep(benchmark::internal::Benchmark* b)
+{
+  Sweep(b, { 1000, 10000, 100000 });
+}
+
+BENCHMARK(BM_SparseLogisticRegressionSGD)
+    ->Apply(SparseLogisticRegressionSweep);
+BENCHMARK(BM_SparseLogisticRegressionAdam)
+    ->Apply(SparseLogisticRegressionSweep);
+BENCHMARK(BM_SparseLogisticRegressionLBFGS)
+    ->Apply(SparseLogisticRegressionSweep);
+BENCHMARK(BM_SparseLogisticRegressionParallelSGD)
+    ->Apply(SparseLogisticRegressionSweep);
+
+// Rank-10 factorization of a square matrix with 1% observed elements.  The
+// argument is the number of rows and columns.
+
+static MatrixFactorizationFunction MatrixFactorization(const size_t size)
+{
+  arma::arma_rng::set_seed(42);
+  return MatrixFactorizationFunction(size, size, 10, 0.01);
+}
+
+static void BM_MatrixFactorizationSGD(benchmark::State& state)
+{
+  MatrixFactorizationFunction f = MatrixFactorization(state.range(0));
+  StandardSGD sgd(0.01, 1, 100 * f.NumFunctions(), -1.0);
+  RunToTolerance(state, sgd, f, 0.1,
+      ToleranceStop<MatrixFactorizationFunction>::Epoch);
+}
+
+static void BM_MatrixFactorizationParallelSGD(benchmark::State& state)
+{
+  MatrixFactorizationFunction f = MatrixFactorization(state.range(0));
+  ParallelSGD<ConstantStep> sgd(100, (f.NumFunctions() + state.range(1) - 1) /
+      state.range(1), -1.0, true, ConstantStep(0.01));
+  RunToTolerance(state, sgd, f, 0.1,
+      ToleranceStop<MatrixFactorizationFunction>::Evaluation);
+}
+
+static void MatrixFactorizationSweep(benchmark::internal::Benchmark* b)
+{
+  Sweep(b, { 1000, 10000 });
+}
+
+BENCHMARK(BM_MatrixFactorizationSGD)->Apply(MatrixFactorizationSweep);
+BENCHMARK(BM_MatrixFactorizationParallelSGD)
+    ->Apply(MatrixFactorizationSweep);
@@ -0,0 +1,145 @@
+/**
+ * @file sdp_bench.cpp
+ *
+ * Benchmarks of LRSDP and the primal-dual SDP solver on the SDP instances in
+ * tests/data/.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+
+/**
+ * Load the edges of the johnson8-4-4 graph (one edge per column).
+ */
+static bool LoadJohnson844(arma::mat& edges)
+{
+  if (!edges.load(ENS_BENCH_DATA_DIR "johnson8-4-4.csv", arma::csv_ascii))
+    return false;
+
+  edges = edges.t();
+  return true;
+}
+
+/**
+ * Construct the Lovasz-Theta SDP of the given graph, as in Monteiro and Burer
+ * 2004.
+ */
+static SDP<arma::mat> LovaszThetaSDP(const arma::mat& edges)
+{
+  const size_t vertices = arma::max(arma::max(edges)) + 1;
+
+  SDP<arma::mat> sdp(vertices, edges.n_cols + 1, 0);
+  sdp.C().ones();
+  sdp.C() *= -1.;
+  sdp.SparseA()[0].eye(vertices, vertices);
+  for (size_t i = 0; i < edges.n_cols; ++i)
+  {
+    sdp.SparseA()[i + 1].zeros(vertices, vertices);
+    sdp.SparseA()[i + 1](edges(0, i), edges(1, i)) = 1.;
+    sdp.SparseA()[i + 1](edges(1, i), edges(0, i)) = 1.;
+  }
+  sdp.SparseB().zeros();
+  sdp.SparseB()[0] = 1.;
+  return sdp;
+}
+
+/**
+ * Solve the Lovasz-Theta SDP of johnson8-4-4 with LRSDP.
+ */
+static void BM_LRSDPLovaszTheta(benchmark::State& state)
+{
+  arma::mat edges;
+  if (!LoadJohnson844(edges))
+  {
+    state.SkipWithError("couldn't load johnson8-4-4.csv");
+    return;
+  }
+
+  const size_t vertices = arma::max(arma::max(edges)) + 1;
+  const size_t m = edges.n_cols + 1;
+  const size_t r = std::min(vertices, (size_t) std::ceil(0.5 +
+      std::sqrt(0.25 + 2 * m)));
+
+  for (auto _ : state)
+  {
+    // The initial point of Section 4 of Monteiro and Burer.
+    arma::mat coordinates(vertices, r);
+    coordinates.fill(std::sqrt(1.0 / (vertices * m)));
+    coordinates.diag() += std::sqrt(1.0 / r);
+
+    LRSDP<SDP<arma::mat>> lovasz(m, 0, coordinates);
+    lovasz.SDP() = LovaszThetaSDP(edges);
+    lovasz.AugLag().Lambda().ones(m);
+    lovasz.AugLag().Lambda() *= -1;
+    lovasz.AugLag().Lambda()[0] = -((double) vertices);
+
+    benchmark::DoNotOptimize(lovasz.Optimize(coordinates));
+  }
+}
+
+BENCHMARK(BM_LRSDPLovaszTheta)->Unit(benchmark::kMillisecond);
+
+/**
+ * Solve the Lovasz-Theta SDP of johnson8-4-4 with the primal-dual solver.
+ */
+static void BM_PrimalDualLovaszTheta(benchmark::State& state)
+{
+  arma::mat edges;
+  if (!LoadJohnson844(edges))
+  {
+    state.SkipWithError("couldn't load johnson8-4-4.csv");
+    return;
+  }
+
+  SDP<arma::mat> sdp = LovaszThetaSDP(edges);
+  PrimalDualSolver solver;
+
+  for (auto _ : state)
+  {
+    arma::mat X, Z, ysparse, ydense;
+    sdp.GetInitialPoints(X, ysparse, ydense, Z);
+    benchmark::DoNotOptimize(solver.Optimize(sdp, X, ysparse, ydense, Z));
+  }
+}
+
+BENCHMARK(BM_PrimalDualLovaszTheta)->Unit(benchmark::kMillisecond);
+
+/**
+ * Solve the MaxCut SDP of the r10 Laplacian with the primal-dual solver.
+ */
+static void BM_PrimalDualMaxCut(benchmark::State& state)
+{
+  arma::mat laplacian;
+  if (!laplacian.load(ENS_BENCH_DATA_DIR "r10.txt"))
+  {
+    state.SkipWithError("couldn't load r10.txt");
+    return;
+  }
+
+  SDP<arma::sp_mat> sdp(laplacian.n_rows, laplacian.n_rows, 0);
+  sdp.C() = -arma::sp_mat(laplacian);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+  {
+    sdp.SparseA()[i].zeros(laplacian.n_rows, laplacian.n_rows);
+    sdp.SparseA()[i](i, i) = 1.;
+  }
+  sdp.SparseB().ones();
+
+  PrimalDualSolver solver;
+
+  for (auto _ : state)
+  {
+    arma::mat X, Z, ysparse, ydense;
+    sdp.GetInitialPoints(X, ysparse, ydense, Z);
+    benchmark::DoNotOptimize(solver.Optimize(sdp, X, ysparse, ydense, Z));
+  }
+}
+
+BENCHMARK(BM_PrimalDualMaxCut)->Unit(benchmark::kMillisecond);
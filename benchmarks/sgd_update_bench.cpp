@@ -0,0 +1,69 @@
+/**
+ * @file sgd_update_bench.cpp
+ *
+ * Benchmarks of the cost of a single step of each SGD update policy, for
+ * several numbers of parameters.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include <benchmark/benchmark.h>
+
+using namespace ens;
+
+/**
+ * Time one call to Update() of the instantiated policy.  The argument is the
+ * number of parameters.
+ */
+template<typename UpdatePolicyType>
+static void BM_SGDUpdate(benchmark::State& state)
+{
+  const size_t n = state.range(0);
+  arma::arma_rng::set_seed(42);
+  arma::mat iterate(n, 1, arma::fill::randn);
+  const arma::mat gradient(n, 1, arma::fill::randn);
+
+  UpdatePolicyType updatePolicy;
+  typename UpdatePolicyType::template Policy<arma::mat, arma::mat> policy(
+      updatePolicy, n, 1);
+
+  for (auto _ : state)
+  {
+    policy.Update(iterate, 1e-6, gradient);
+    benchmark::DoNotOptimize(iterate.memptr());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * n);
+  state.SetBytesProcessed(state.iterations() * n * 2 * sizeof(double));
+}
+
+#define ENS_BENCH_SGD_UPDATE(UpdatePolicyType) \
+    BENCHMARK_TEMPLATE(BM_SGDUpdate, UpdatePolicyType) \
+        ->RangeMultiplier(100)->Range(100, 10000000)
+
+ENS_BENCH_SGD_UPDATE(VanillaUpdate);
+ENS_BENCH_SGD_UPDATE(MomentumUpdate);
+ENS_BENCH_SGD_UPDATE(NesterovMomentumUpdate);
+ENS_BENCH_SGD_UPDATE(QHUpdate);
+ENS_BENCH_SGD_UPDATE(AdaBoundUpdate);
+ENS_BENCH_SGD_UPDATE(AdaDeltaUpdate);
+ENS_BENCH_SGD_UPDATE(AdaGradUpdate);
+ENS_BENCH_SGD_UPDATE(AdamUpdate);
+ENS_BENCH_SGD_UPDATE(AdaMaxUpdate);
+ENS_BENCH_SGD_UPDATE(AMSBoundUpdate);
+ENS_BENCH_SGD_UPDATE(AMSGradUpdate);
+ENS_BENCH_SGD_UPDATE(FTMLUpdate);
+ENS_BENCH_SGD_UPDATE(NadamUpdate);
+ENS_BENCH_SGD_UPDATE(NadaMaxUpdate);
+ENS_BENCH_SGD_UPDATE(OptimisticAdamUpdate);
+ENS_BENCH_SGD_UPDATE(PadamUpdate);
+ENS_BENCH_SGD_UPDATE(QHAdamUpdate);
+ENS_BENCH_SGD_UPDATE(RMSPropUpdate);
+ENS_BENCH_SGD_UPDATE(SMORMS3Update);
+ENS_BENCH_SGD_UPDATE(SWATSUpdate);
+ENS_BENCH_SGD_UPDATE(WNGradUpdate);
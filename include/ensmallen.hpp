@@ -9,74 +9,41 @@
  * http://www.opensource.org/licenses/BSD-3-Clause for more information.
  */
 
-// NOTE: When using the ensmallen library in your code, only include the ensmallen.hpp header.
-// NOTE: Do not include any of the files in the ensmallen_bits folder.
+// NOTE: When using the ensmallen library in your code, include either the
+// NOTE: ensmallen.hpp header, which has everything, or the headers in the
+// NOTE: ensmallen/ folder (e.g. <ensmallen/adam.hpp>), which have a single
+// NOTE: optimizer.  Do not include any of the files in the ensmallen_bits
+// NOTE: folder.
 
 #ifndef ENSMALLEN_HPP
 #define ENSMALLEN_HPP
 
-// certain compilers are way behind the curve
-#if (defined(_MSVC_LANG) && (_MSVC_LANG >= 201402L))
-  #undef  ARMA_USE_CXX11
-  #define ARMA_USE_CXX11
-#endif
-
-#include <armadillo>
-
-#if !defined(ARMA_USE_CXX11)
-  // armadillo automatically enables ARMA_USE_CXX11
-  // when a C++11/C++14/C++17/etc compiler is detected
-  #error "please enable C++11/C++14 mode in your compiler"
-#endif
-
-#if ((ARMA_VERSION_MAJOR < 8) || ((ARMA_VERSION_MAJOR == 8) && (ARMA_VERSION_MINOR < 400)))
-  #error "need Armadillo version 8.400 or later"
-#endif
+#include "ensmallen_bits/core.hpp"
 
-#include <cctype>
-#include <cfloat>
-#include <climits>
-#include <cmath>
-#include <cstdint>
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <iostream>
-#include <map>
-#include <set>
-#include <limits>
-#include <sstream>
-#include <stdexcept>
-#include <string>
-#include <tuple>
-#include <utility>
-#include <vector>
+// Wrappers of functions, which no optimizer needs.
+#include "ensmallen_bits/function/cached_function.hpp"
+#include "ensmallen_bits/function/memoized_function.hpp"
+#include "ensmallen_bits/function/parallel_separable_function.hpp"
+#include "ensmallen_bits/function/mixed_precision_function.hpp"
+#include "ensmallen_bits/function/numerical_gradient_function.hpp"
 
-// On Visual Studio, disable C4519 (default arguments for function templates)
-// since it's by default an error, which doesn't even make any sense because
-// it's part of the C++11 standard.
-#ifdef _MSC_VER
-  #pragma warning(disable : 4519)
-#endif
-
-#include "ensmallen_bits/config.hpp"
-#include "ensmallen_bits/ens_version.hpp"
-#include "ensmallen_bits/log.hpp" // TODO: should move to another place
-
-#include "ensmallen_bits/utility/any.hpp"
-#include "ensmallen_bits/utility/arma_traits.hpp"
-
-// Contains traits, must be placed before report callback.
-#include "ensmallen_bits/function.hpp" // TODO: should move to function/
-
-// Callbacks.
-#include "ensmallen_bits/callbacks/callbacks.hpp"
+// Built-in callbacks.
+#include "ensmallen_bits/callbacks/async_callback.hpp"
+#include "ensmallen_bits/callbacks/async_early_stop_at_min_loss.hpp"
+#include "ensmallen_bits/callbacks/checkpoint.hpp"
 #include "ensmallen_bits/callbacks/early_stop_at_min_loss.hpp"
+#include "ensmallen_bits/callbacks/evaluation_budget.hpp"
+#include "ensmallen_bits/callbacks/memory_footprint.hpp"
+#include "ensmallen_bits/callbacks/metrics.hpp"
 #include "ensmallen_bits/callbacks/print_loss.hpp"
+#include "ensmallen_bits/callbacks/profiler.hpp"
 #include "ensmallen_bits/callbacks/progress_bar.hpp"
 #include "ensmallen_bits/callbacks/report.hpp"
+#include "ensmallen_bits/callbacks/step_size_finder.hpp"
 #include "ensmallen_bits/callbacks/store_best_coordinates.hpp"
 #include "ensmallen_bits/callbacks/timer_stop.hpp"
+#include "ensmallen_bits/callbacks/trace_recorder.hpp"
+#include "ensmallen_bits/callbacks/warm_start.hpp"
 
 #include "ensmallen_bits/problems/problems.hpp" // TODO: should move to another place
 
@@ -86,44 +53,68 @@
 #include "ensmallen_bits/adam/adam.hpp"
 #include "ensmallen_bits/qhadam/qhadam.hpp"
 #include "ensmallen_bits/aug_lagrangian/aug_lagrangian.hpp"
+#include "ensmallen_bits/autotune/autotuner.hpp"
 #include "ensmallen_bits/bigbatch_sgd/bigbatch_sgd.hpp"
 #include "ensmallen_bits/cmaes/cmaes.hpp"
 #include "ensmallen_bits/cne/cne.hpp"
 #include "ensmallen_bits/de/de.hpp"
+#include "ensmallen_bits/distributed/all_reduce_function.hpp"
+#include "ensmallen_bits/distributed/consensus_admm.hpp"
+#include "ensmallen_bits/distributed/model_averaging.hpp"
 #include "ensmallen_bits/eve/eve.hpp"
 #include "ensmallen_bits/ftml/ftml.hpp"
 
 #include "ensmallen_bits/fw/frank_wolfe.hpp"
+#include "ensmallen_bits/fw/stochastic_frank_wolfe.hpp"
 #include "ensmallen_bits/gradient_descent/gradient_descent.hpp"
 #include "ensmallen_bits/grid_search/grid_search.hpp"
 #include "ensmallen_bits/iqn/iqn.hpp"
 #include "ensmallen_bits/katyusha/katyusha.hpp"
 #include "ensmallen_bits/lbfgs/lbfgs.hpp"
+#include "ensmallen_bits/lbfgs/lbfgs_b.hpp"
 #include "ensmallen_bits/lookahead/lookahead.hpp"
+#include "ensmallen_bits/moead/moead.hpp"
+#include "ensmallen_bits/multistart/multi_start.hpp"
+#include "ensmallen_bits/newton_cg/newton_cg.hpp"
 #include "ensmallen_bits/nsga2/nsga2.hpp"
+#include "ensmallen_bits/owlqn/owlqn.hpp"
 #include "ensmallen_bits/padam/padam.hpp"
 #include "ensmallen_bits/parallel_sgd/parallel_sgd.hpp"
+#include "ensmallen_bits/pbt/population_based_training.hpp"
+#include "ensmallen_bits/proximal_gradient/proximal_gradient.hpp"
 #include "ensmallen_bits/pso/pso.hpp"
 #include "ensmallen_bits/rmsprop/rmsprop.hpp"
 
 #include "ensmallen_bits/sa/sa.hpp"
+#include "ensmallen_bits/saga/saga.hpp"
 #include "ensmallen_bits/sarah/sarah.hpp"
 #include "ensmallen_bits/scd/scd.hpp"
+#include "ensmallen_bits/scd/regularization_path.hpp"
 #include "ensmallen_bits/sdp/sdp.hpp"
 #include "ensmallen_bits/sdp/lrsdp.hpp"
 #include "ensmallen_bits/sdp/primal_dual.hpp"
+#include "ensmallen_bits/sdp/sdpa.hpp"
 
 #include "ensmallen_bits/sgd/sgd.hpp"
 // TODO: this should probably be included in sgd.hpp
 #include "ensmallen_bits/sgd/update_policies/gradient_clipping.hpp"
+#include "ensmallen_bits/sgd/update_policies/gradient_compression.hpp"
+#include "ensmallen_bits/sgd/update_policies/iterate_averaging.hpp"
+#include "ensmallen_bits/sgd/update_policies/parameter_groups.hpp"
+#include "ensmallen_bits/sgd/lockstep_sgd.hpp"
+#include "ensmallen_bits/sgd/online_sgd.hpp"
 #include "ensmallen_bits/sgdr/sgdr.hpp"
 #include "ensmallen_bits/sgdr/snapshot_ensembles.hpp"
 #include "ensmallen_bits/sgdr/snapshot_sgdr.hpp"
 #include "ensmallen_bits/smorms3/smorms3.hpp"
 #include "ensmallen_bits/spalera_sgd/spalera_sgd.hpp"
 #include "ensmallen_bits/spsa/spsa.hpp"
+#include "ensmallen_bits/sqn/sqn.hpp"
 #include "ensmallen_bits/svrg/svrg.hpp"
 #include "ensmallen_bits/swats/swats.hpp"
 #include "ensmallen_bits/wn_grad/wn_grad.hpp"
 
+// Must be included after all optimizers.
+#include "ensmallen_bits/instantiations.hpp"
+
 #endif
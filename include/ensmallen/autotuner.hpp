@@ -0,0 +1,21 @@
+/**
+ * @file autotuner.hpp
+ *
+ * Include the Autotuner, without the optimizers and the test problems; include
+ * the header of the optimizer to tune too.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_AUTOTUNER_HPP
+#define ENSMALLEN_INCLUDE_AUTOTUNER_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/autotune/autotuner.hpp"
+
+#include "../ensmallen_bits/instantiations.hpp"
+
+#endif
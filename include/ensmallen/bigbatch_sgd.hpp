@@ -0,0 +1,21 @@
+/**
+ * @file bigbatch_sgd.hpp
+ *
+ * Include BigBatchSGD, without the other optimizers, the test problems and the
+ * built-in callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_BIGBATCH_SGD_HPP
+#define ENSMALLEN_INCLUDE_BIGBATCH_SGD_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/bigbatch_sgd/bigbatch_sgd.hpp"
+
+#include "../ensmallen_bits/instantiations.hpp"
+
+#endif
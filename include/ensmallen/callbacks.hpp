@@ -0,0 +1,34 @@
+/**
+ * @file callbacks.hpp
+ *
+ * Include the built-in callbacks (PrintLoss, ProgressBar, EarlyStopAtMinLoss,
+ * Checkpoint, ...).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_CALLBACKS_HPP
+#define ENSMALLEN_INCLUDE_CALLBACKS_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/callbacks/async_callback.hpp"
+#include "../ensmallen_bits/callbacks/async_early_stop_at_min_loss.hpp"
+#include "../ensmallen_bits/callbacks/checkpoint.hpp"
+#include "../ensmallen_bits/callbacks/early_stop_at_min_loss.hpp"
+#include "../ensmallen_bits/callbacks/evaluation_budget.hpp"
+#include "../ensmallen_bits/callbacks/memory_footprint.hpp"
+#include "../ensmallen_bits/callbacks/metrics.hpp"
+#include "../ensmallen_bits/callbacks/print_loss.hpp"
+#include "../ensmallen_bits/callbacks/profiler.hpp"
+#include "../ensmallen_bits/callbacks/progress_bar.hpp"
+#include "../ensmallen_bits/callbacks/report.hpp"
+#include "../ensmallen_bits/callbacks/step_size_finder.hpp"
+#include "../ensmallen_bits/callbacks/store_best_coordinates.hpp"
+#include "../ensmallen_bits/callbacks/timer_stop.hpp"
+#include "../ensmallen_bits/callbacks/trace_recorder.hpp"
+#include "../ensmallen_bits/callbacks/warm_start.hpp"
+
+#endif
@@ -0,0 +1,24 @@
+/**
+ * @file functions.hpp
+ *
+ * Include the wrappers of functions (CachedFunction, MemoizedFunction,
+ * ParallelSeparableFunction, MixedPrecisionFunction and
+ * NumericalGradientFunction).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_FUNCTIONS_HPP
+#define ENSMALLEN_INCLUDE_FUNCTIONS_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/function/cached_function.hpp"
+#include "../ensmallen_bits/function/memoized_function.hpp"
+#include "../ensmallen_bits/function/parallel_separable_function.hpp"
+#include "../ensmallen_bits/function/mixed_precision_function.hpp"
+#include "../ensmallen_bits/function/numerical_gradient_function.hpp"
+
+#endif
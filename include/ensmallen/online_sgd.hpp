@@ -0,0 +1,21 @@
+/**
+ * @file online_sgd.hpp
+ *
+ * Include OnlineSGD (and SGD with its update and decay policies), without the
+ * other optimizers, the test problems and the built-in callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_ONLINE_SGD_HPP
+#define ENSMALLEN_INCLUDE_ONLINE_SGD_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/sgd/online_sgd.hpp"
+
+#include "../ensmallen_bits/instantiations.hpp"
+
+#endif
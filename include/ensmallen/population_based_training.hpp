@@ -0,0 +1,21 @@
+/**
+ * @file population_based_training.hpp
+ *
+ * Include PopulationBasedTraining, without the other optimizers and the test
+ * problems; include the header of the optimizer of the members too.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_POPULATION_BASED_TRAINING_HPP
+#define ENSMALLEN_INCLUDE_POPULATION_BASED_TRAINING_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/pbt/population_based_training.hpp"
+
+#include "../ensmallen_bits/instantiations.hpp"
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * @file problems.hpp
+ *
+ * Include the test problems (in the ens::test namespace) that the tests and the
+ * examples use.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_PROBLEMS_HPP
+#define ENSMALLEN_INCLUDE_PROBLEMS_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/problems/problems.hpp"
+
+#endif
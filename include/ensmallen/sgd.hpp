@@ -0,0 +1,25 @@
+/**
+ * @file sgd.hpp
+ *
+ * Include SGD and its update and decay policies, without the other optimizers,
+ * the test problems and the built-in callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_INCLUDE_SGD_HPP
+#define ENSMALLEN_INCLUDE_SGD_HPP
+
+#include "../ensmallen_bits/core.hpp"
+
+#include "../ensmallen_bits/sgd/sgd.hpp"
+#include "../ensmallen_bits/sgd/update_policies/gradient_clipping.hpp"
+#include "../ensmallen_bits/sgd/update_policies/gradient_compression.hpp"
+#include "../ensmallen_bits/sgd/update_policies/iterate_averaging.hpp"
+#include "../ensmallen_bits/sgd/update_policies/parameter_groups.hpp"
+
+#include "../ensmallen_bits/instantiations.hpp"
+
+#endif
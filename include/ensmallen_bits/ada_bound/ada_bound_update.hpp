@@ -13,6 +13,8 @@
 #ifndef ENSMALLEN_ADA_BOUND_UPDATE_HPP
 #define ENSMALLEN_ADA_BOUND_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -92,6 +94,12 @@ class AdaBoundUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -128,9 +136,6 @@ class AdaBoundUpdate
                 const double stepSize,
                 const GradType& gradient)
     {
-      // Convenience typedefs.
-      typedef typename MatType::elem_type ElemType;
-
       // Save the initial step size.
       if (first)
       {
@@ -141,6 +146,72 @@ class AdaBoundUpdate
       // Increment the iteration counter variable.
       ++parent.iteration;
 
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          (double) parent.iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
+          (double) parent.iteration);
+
+      const double fl = parent.finalLr * stepSize / initialStepSize;
+      const double lower = fl * (1.0 - 1.0 / (parent.gamma *
+          parent.iteration + 1));
+      const double upper = fl * (1.0 + 1.0 / (parent.gamma *
+          parent.iteration));
+
+      Update(iterate, stepSize * std::sqrt(biasCorrection2) / biasCorrection1,
+          lower, upper, gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements, with
+    //! the step sizes clamped to the bounds by min() and max().
+    void Update(MatType& iterate,
+                const double alpha,
+                const double lower,
+                const double upper,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+      const ElemType lowerBound = ElemType(lower);
+      const ElemType upperBound = ElemType(upper);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          const ElemType step = std::min(std::max(a / (std::sqrt(vi) + eps),
+              lowerBound), upperBound);
+          mp[i] = mi;
+          vp[i] = vi;
+          x[i] -= step * mi;
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double alpha,
+                const double lower,
+                const double upper,
+                const GradType& gradient,
+                std::false_type /* fused */)
+    {
       // Decay the first and second moment running average coefficient.
       m *= parent.beta1;
       m += (1 - parent.beta1) * gradient;
@@ -148,24 +219,11 @@ class AdaBoundUpdate
       v *= parent.beta2;
       v += (1 - parent.beta2) * (gradient % gradient);
 
-      const ElemType biasCorrection1 = 1.0 - std::pow(parent.beta1,
-          parent.iteration);
-      const ElemType biasCorrection2 = 1.0 - std::pow(parent.beta2,
-          parent.iteration);
-
-      const ElemType fl = parent.finalLr * stepSize / initialStepSize;
-      const ElemType lower = fl * (1.0 - 1.0 / (parent.gamma *
-          parent.iteration + 1));
-      const ElemType upper = fl * (1.0 + 1.0 / (parent.gamma *
-          parent.iteration));
-
-       // Applies bounds on actual learning rate.
-      iterate -= arma::clamp((stepSize *
-          std::sqrt(biasCorrection2) / biasCorrection1) / (arma::sqrt(v) +
-          parent.epsilon), lower, upper) % m;
+      // Applies bounds on actual learning rate.
+      iterate -= arma::clamp(alpha / (arma::sqrt(v) + parent.epsilon),
+          lower, upper) % m;
     }
 
-   private:
     // Instantiated parent object.
     AdaBoundUpdate& parent;
 
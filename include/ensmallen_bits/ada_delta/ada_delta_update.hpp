@@ -13,6 +13,8 @@
 #ifndef ENSMALLEN_ADA_DELTA_ADA_DELTA_UPDATE_HPP
 #define ENSMALLEN_ADA_DELTA_ADA_DELTA_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -61,6 +63,13 @@ class AdaDeltaUpdate
   //! Modify the value used to initialise the mean squared gradient parameter.
   double& Epsilon() { return epsilon; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the moving averages of the squared gradients and
+  //! updates.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -100,6 +109,62 @@ class AdaDeltaUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the mean squared gradients and updates, e.g. for a
+     * checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(meanSquaredGradient);
+      ar(meanSquaredGradientDx);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType rho = ElemType(parent.rho);
+      const ElemType oneMinusRho = ElemType(1 - parent.rho);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* msg = meanSquaredGradient.memptr();
+      ElemType* msgDx = meanSquaredGradientDx.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType si = rho * msg[i] + oneMinusRho * (gi * gi);
+          const ElemType dx = std::sqrt((msgDx[i] + eps) / (si + eps)) * gi;
+          msg[i] = si;
+          msgDx[i] = rho * msgDx[i] + oneMinusRho * (dx * dx);
+          x[i] -= a * dx;
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* fused */)
     {
       // Accumulate gradient.
       meanSquaredGradient *= parent.rho;
@@ -115,7 +180,6 @@ class AdaDeltaUpdate
       iterate -= (stepSize * dx);
     }
 
-   private:
     // The instantiated parent class.
     AdaDeltaUpdate& parent;
 
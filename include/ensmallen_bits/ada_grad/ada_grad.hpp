@@ -118,6 +118,22 @@ class AdaGrad
         std::forward<CallbackTypes>(callbacks)...);
   }
 
+  //! Save the state of the optimizer; see SGD::SaveState().
+  template<typename MatType, typename GradType = MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& iterate)
+  { optimizer.template SaveState<MatType, GradType>(ar, iterate); }
+
+  //! Restore the state of the optimizer; see SGD::LoadState().
+  template<typename MatType, typename GradType = MatType>
+  void LoadState(CheckpointReader& ar, const MatType& iterate)
+  { optimizer.template LoadState<MatType, GradType>(ar, iterate); }
+
+  //! Return the number of bytes that Optimize() keeps for coordinates of the
+  //! given size; see SGD::StateBytes().
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return optimizer.template StateBytes<MatType, GradType>(rows, cols); }
+
   //! Get the step size.
   double StepSize() const { return optimizer.StepSize(); }
   //! Modify the step size.
@@ -160,6 +176,17 @@ class AdaGrad
   //! are reset before Optimize call.
   bool& ResetPolicy() { return optimizer.ResetPolicy(); }
 
+  //! Get whether or not each minibatch is split across multiple threads.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not each minibatch is split across multiple threads.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get whether or not parallel minibatch reductions are deterministic.
+  bool DeterministicReduction() const
+  { return optimizer.DeterministicReduction(); }
+  //! Modify whether or not parallel minibatch reductions are deterministic.
+  bool& DeterministicReduction() { return optimizer.DeterministicReduction(); }
+
  private:
   //! The Stochastic Gradient Descent object with AdaGrad policy.
   SGD<AdaGradUpdate> optimizer;
@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_ADA_GRAD_ADA_GRAD_UPDATE_HPP
 #define ENSMALLEN_ADA_GRAD_ADA_GRAD_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -54,6 +56,12 @@ class AdaGradUpdate
   //! Modify the value used to initialise the squared gradient parameter.
   double& Epsilon() { return epsilon; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the sum of the squared gradients.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -64,6 +72,16 @@ class AdaGradUpdate
   class Policy
   {
    public:
+    /**
+     * The squared gradient matrix is dense if the gradient is sparse but the
+     * iterate is dense, so that sparse updates only touch the nonzero elements
+     * of the gradient; otherwise it has the same type as the gradient.
+     */
+    typedef typename std::conditional<
+        UseSparseUpdate<MatType, GradType>::value,
+        arma::Mat<typename MatType::elem_type>,
+        GradType>::type StateType;
+
     /**
      * This constructor is called by the SGD optimizer before the start of the
      * iteration update process. In AdaGrad update policy, squared gradient
@@ -94,17 +112,97 @@ class AdaGradUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseSparseUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the sum of squared gradients, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(squaredGradient);
+    }
+
+   private:
+    //! Sparse update: only the nonzero elements of the gradient are visited.
+    //! Since AdaGrad has no decay, this is exactly the same as the dense
+    //! update.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::true_type /* sparse */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      ElemType* sq = squaredGradient.memptr();
+      ForEachNonzero(gradient, [&](const size_t i, const ElemType g)
+      {
+        sq[i] += g * g;
+        x[i] -= a * g / (std::sqrt(sq[i]) + eps);
+      });
+    }
+
+    //! Dense update: fused if the matrices are dense.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* sparse */)
+    {
+      DenseUpdate(iterate, stepSize, gradient,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    //! Fused update for dense matrices: one pass over all the elements.
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* sq = squaredGradient.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType si = sq[i] + gi * gi;
+          sq[i] = si;
+          x[i] -= a * gi / (std::sqrt(si) + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     std::false_type /* fused */)
     {
       squaredGradient += (gradient % gradient);
       iterate -= (stepSize * gradient) / (arma::sqrt(squaredGradient) +
           parent.epsilon);
     }
 
-   private:
     // Instantiated parent class.
     AdaGradUpdate& parent;
     // The squared gradient matrix.
-    GradType squaredGradient;
+    StateType squaredGradient;
   };
 
  private:
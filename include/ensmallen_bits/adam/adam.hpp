@@ -29,6 +29,7 @@
 #include "nadam_update.hpp"
 #include "nadamax_update.hpp"
 #include "optimisticadam_update.hpp"
+#include "lazy_adam_update.hpp"
 
 namespace ens {
 
@@ -120,7 +121,7 @@ class AdamType
            typename MatType,
            typename GradType,
            typename... CallbackTypes>
-  typename std::enable_if<IsArmaType<GradType>::value,
+  typename std::enable_if<IsMatrixType<GradType>::value,
       typename MatType::elem_type>::type
   Optimize(SeparableFunctionType& function,
            MatType& iterate,
@@ -144,6 +145,22 @@ class AdamType
         std::forward<CallbackTypes>(callbacks)...);
   }
 
+  //! Save the state of the optimizer; see SGD::SaveState().
+  template<typename MatType, typename GradType = MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& iterate)
+  { optimizer.template SaveState<MatType, GradType>(ar, iterate); }
+
+  //! Restore the state of the optimizer; see SGD::LoadState().
+  template<typename MatType, typename GradType = MatType>
+  void LoadState(CheckpointReader& ar, const MatType& iterate)
+  { optimizer.template LoadState<MatType, GradType>(ar, iterate); }
+
+  //! Return the number of bytes that Optimize() keeps for coordinates of the
+  //! given size; see SGD::StateBytes().
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return optimizer.template StateBytes<MatType, GradType>(rows, cols); }
+
   //! Get the step size.
   double StepSize() const { return optimizer.StepSize(); }
   //! Modify the step size.
@@ -196,6 +213,17 @@ class AdamType
   //! are reset before Optimize call.
   bool& ResetPolicy() { return optimizer.ResetPolicy(); }
 
+  //! Get whether or not each minibatch is split across multiple threads.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not each minibatch is split across multiple threads.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get whether or not parallel minibatch reductions are deterministic.
+  bool DeterministicReduction() const
+  { return optimizer.DeterministicReduction(); }
+  //! Modify whether or not parallel minibatch reductions are deterministic.
+  bool& DeterministicReduction() { return optimizer.DeterministicReduction(); }
+
  private:
   //! The Stochastic Gradient Descent object with Adam policy.
   SGD<UpdateRule> optimizer;
@@ -213,6 +241,8 @@ using NadaMax = AdamType<NadaMaxUpdate>;
 
 using OptimisticAdam = AdamType<OptimisticAdamUpdate>;
 
+using LazyAdam = AdamType<LazyAdamUpdate>;
+
 } // namespace ens
 
 // Include implementation.
@@ -78,6 +78,12 @@ class AdamUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -88,6 +94,16 @@ class AdamUpdate
   class Policy
   {
    public:
+    /**
+     * The moment estimates are dense if the gradient is sparse but the iterate
+     * is dense (see UseSparseUpdate); otherwise they have the same type as the
+     * gradient.
+     */
+    typedef typename std::conditional<
+        UseSparseUpdate<MatType, GradType>::value,
+        arma::Mat<typename MatType::elem_type>,
+        GradType>::type StateType;
+
     /**
      * This constructor is called by the SGD Optimize() method before the start
      * of the iteration update process.
@@ -99,8 +115,8 @@ class AdamUpdate
     Policy(AdamUpdate& parent, const size_t rows, const size_t cols) :
         parent(parent)
     {
-      m.zeros(rows, cols);
-      v.zeros(rows, cols);
+      mMemory.Zeros(m, rows, cols);
+      vMemory.Zeros(v, rows, cols);
     }
 
     /**
@@ -114,15 +130,72 @@ class AdamUpdate
                 const double stepSize,
                 const GradType& gradient)
     {
-      // Increment the iteration counter variable.
-      ++parent.iteration;
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
 
-      // And update the iterate.
-      m *= parent.beta1;
-      m += (1 - parent.beta1) * gradient;
+    /**
+     * Update step for Adam, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> or UseSparseUpdate<MatType, GradType>
+     * is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
+    {
+      Update(iterate, Alpha(stepSize), gradient, transform, NoSink(),
+          UseSparseUpdate<MatType, GradType>());
+    }
 
-      v *= parent.beta2;
-      v += (1 - parent.beta2) * (gradient % gradient);
+    /**
+     * Update step for Adam, where each element of the iterate is passed to the
+     * given sink (see AverageSink) after it is written.  This is only
+     * supported if UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param sink The sink to pass each element of the iterate to.
+     */
+    template<typename SinkType>
+    void SinkUpdate(MatType& iterate,
+                    const double stepSize,
+                    const GradType& gradient,
+                    const SinkType& sink)
+    {
+      DenseUpdate(iterate, Alpha(stepSize), gradient, IdentityTransform(),
+          sink, std::true_type());
+    }
+
+    /**
+     * Save or restore the moving averages and the iteration counter, e.g. for a
+     * checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(parent.iteration);
+    }
+
+   private:
+    //! Increment the iteration counter, and return the bias-corrected step
+    //! size of this iteration.
+    double Alpha(const double stepSize)
+    {
+      // Increment the iteration counter variable.
+      ++parent.iteration;
 
       const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
           parent.iteration);
@@ -134,19 +207,146 @@ class AdamUpdate
        * following expression is an approximation of the following actual term;
        * m / (arma::sqrt(v) + (arma::sqrt(biasCorrection2) * eps).
        */
-      iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-          m / (arma::sqrt(v) + parent.epsilon);
+      return stepSize * std::sqrt(biasCorrection2) / biasCorrection1;
+    }
+
+    //! Sparse update: the moments are decayed in one pass, the nonzero
+    //! elements of the gradient are added to them, and the step is taken in a
+    //! second pass.  This gives exactly the dense update, but each step still
+    //! visits all the elements (see LazyAdamUpdate).
+    template<typename TransformType, typename SinkType>
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                const TransformType& transform,
+                const SinkType& sink,
+                std::true_type /* sparse */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+
+      ElemType* x = iterate.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          mp[i] *= beta1;
+          vp[i] *= beta2;
+        }
+      });
+
+      ForEachNonzero(gradient, [&](const size_t i, const ElemType g)
+      {
+        const ElemType gi = transform(g);
+        mp[i] += oneMinusBeta1 * gi;
+        vp[i] += oneMinusBeta2 * (gi * gi);
+      });
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          x[i] -= a * mp[i] / (std::sqrt(vp[i]) + eps);
+          sink(i, x[i]);
+        }
+      });
+    }
+
+    //! Dense update: fused if the matrices are dense.
+    template<typename TransformType, typename SinkType>
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                const TransformType& transform,
+                const SinkType& sink,
+                std::false_type /* sparse */)
+    {
+      DenseUpdate(iterate, alpha, gradient, transform, sink,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType, typename SinkType>
+    void DenseUpdate(MatType& iterate,
+                     const double alpha,
+                     const GradType& gradient,
+                     const TransformType& transform,
+                     const SinkType& sink,
+                     std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(g[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          mp[i] = mi;
+          vp[i] = vi;
+          x[i] -= a * mi / (std::sqrt(vi) + eps);
+          sink(i, x[i]);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void DenseUpdate(MatType& iterate,
+                     const double alpha,
+                     const GradType& gradient,
+                     const IdentityTransform& /* transform */,
+                     const NoSink& /* sink */,
+                     std::false_type /* fused */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      // The element-wise functions are found by argument-dependent lookup, so
+      // that Bandicoot matrices are updated on the device.
+      iterate -= alpha * m / (sqrt(v) + parent.epsilon);
     }
 
-   private:
     // Instantiated parent object.
     AdamUpdate& parent;
 
+    // The memory of the StateAllocator (see SetStateAllocator()) for m and v,
+    // if any.
+    StateMemory mMemory;
+    StateMemory vMemory;
+
     // The exponential moving average of gradient values.
-    GradType m;
+    StateType m;
 
     // The exponential moving average of squared gradient values.
-    GradType v;
+    StateType v;
   };
 
  private:
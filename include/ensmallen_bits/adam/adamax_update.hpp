@@ -80,6 +80,12 @@ class AdaMaxUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the first moment estimate and the infinity norm.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -115,26 +121,111 @@ class AdaMaxUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for AdaMax, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
     {
       // Increment the iteration counter variable.
       ++parent.iteration;
 
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          parent.iteration);
+
+      Update(iterate, stepSize, biasCorrection1, gradient, transform,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the moving averages and the iteration counter, e.g. for a
+     * checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(m);
+      ar(u);
+      ar(parent.iteration);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const double biasCorrection1,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType eps = ElemType(parent.epsilon);
+      const bool step = (biasCorrection1 != 0);
+      const ElemType a = step ? ElemType(stepSize / biasCorrection1) : 0;
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* up = u.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(g[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType ui = std::max(beta2 * up[i], std::abs(gi));
+          mp[i] = mi;
+          up[i] = ui;
+          if (step)
+            x[i] -= a * mi / (ui + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const double biasCorrection1,
+                const GradType& gradient,
+                const IdentityTransform& /* transform */,
+                std::false_type /* fused */)
+    {
       // And update the iterate.
       m *= parent.beta1;
       m += (1 - parent.beta1) * gradient;
 
       // Update the exponentially weighted infinity norm.
       u *= parent.beta2;
-      u = arma::max(u, arma::abs(gradient));
-
-      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
-          parent.iteration);
+      u = max(u, abs(gradient));
 
       if (biasCorrection1 != 0)
         iterate -= (stepSize / biasCorrection1 * m / (u + parent.epsilon));
     }
 
-   private:
     // Instantiated parent object.
     AdaMaxUpdate& parent;
     // The exponential moving average of gradient values.
@@ -73,6 +73,12 @@ class AMSGradUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates and the maximum of the second.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 3 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -109,30 +115,117 @@ class AMSGradUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for AMSGrad, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
     {
       // Increment the iteration counter variable.
       ++parent.iteration;
 
-      // And update the iterate.
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          parent.iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
+          parent.iteration);
+
+      const double alpha = stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1;
+
+      Update(iterate, alpha, gradient, transform,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the moving averages and the iteration counter, e.g. for a
+     * checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(vImproved);
+      ar(parent.iteration);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+      ElemType* vImprovedp = vImproved.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(g[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          const ElemType vImprovedi = std::max(vImprovedp[i], vi);
+          mp[i] = mi;
+          vp[i] = vi;
+          vImprovedp[i] = vImprovedi;
+          x[i] -= a * mi / (std::sqrt(vImprovedi) + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                const IdentityTransform& /* transform */,
+                std::false_type /* fused */)
+    {
       m *= parent.beta1;
       m += (1 - parent.beta1) * gradient;
 
       v *= parent.beta2;
       v += (1 - parent.beta2) * (gradient % gradient);
 
-      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
-          parent.iteration);
-      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
-          parent.iteration);
-
       // Element wise maximum of past and present squared gradients.
-      vImproved = arma::max(vImproved, v);
+      vImproved = max(vImproved, v);
 
-      iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-                  m / (arma::sqrt(vImproved) + parent.epsilon);
+      iterate -= alpha * m / (sqrt(vImproved) + parent.epsilon);
     }
 
-   private:
     // Instantiated parent AMSGradUpdate object.
     AMSGradUpdate& parent;
 
@@ -0,0 +1,227 @@
+/**
+ * @file lazy_adam_update.hpp
+ *
+ * Lazy Adam update for sparse gradients.  Only the elements of the iterate
+ * that have a nonzero gradient are updated in each step.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_ADAM_LAZY_ADAM_UPDATE_HPP
+#define ENSMALLEN_ADAM_LAZY_ADAM_UPDATE_HPP
+
+namespace ens {
+
+/**
+ * LazyAdam is a variant of Adam for problems with sparse gradients, such as
+ * embedding models where each batch only touches a small fraction of the
+ * parameters.  When the gradient is a sparse matrix and the iterate is dense,
+ * each step only visits the nonzero elements of the gradient: their first and
+ * second moment estimates are first decayed by all the steps that were skipped
+ * since that element was last updated (which is tracked per element), then
+ * updated with the gradient, and only those elements of the iterate are
+ * updated.  The cost of a step is therefore proportional to the number of
+ * nonzero elements of the gradient, not to the size of the iterate.
+ *
+ * Note that this is not the same as Adam: in Adam, the elements with zero
+ * gradient are still moved by their (decaying) first moment estimate, whereas
+ * in LazyAdam they stay where they are until their next nonzero gradient.  For
+ * dense gradients, LazyAdam is the same as Adam.
+ */
+class LazyAdamUpdate
+{
+ public:
+  /**
+   * Construct the LazyAdam update policy with the given parameters.
+   *
+   * @param epsilon The epsilon value used to initialise the squared gradient
+   *        parameter.
+   * @param beta1 The smoothing parameter.
+   * @param beta2 The second moment coefficient.
+   */
+  LazyAdamUpdate(const double epsilon = 1e-8,
+                 const double beta1 = 0.9,
+                 const double beta2 = 0.999) :
+    epsilon(epsilon),
+    beta1(beta1),
+    beta2(beta2),
+    iteration(0)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the value used to initialise the squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the current iteration number.
+  size_t Iteration() const { return iteration; }
+  //! Modify the current iteration number.
+  size_t& Iteration() { return iteration; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates, and for sparse gradients the
+  //! iteration of the last update of each element.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return 2 * MatrixBytes<GradType>(rows, cols) +
+        (UseSparseUpdate<MatType, GradType>::value ?
+        MatrixBytes<arma::umat>(rows, cols) : 0);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * The moment estimates are dense if the gradient is sparse but the iterate
+     * is dense, so that the lazy updates take constant time per element;
+     * otherwise they have the same type as the gradient.
+     */
+    typedef typename std::conditional<
+        UseSparseUpdate<MatType, GradType>::value,
+        arma::Mat<typename MatType::elem_type>,
+        GradType>::type StateType;
+
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent LazyAdamUpdate object.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(LazyAdamUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent)
+    {
+      m.zeros(rows, cols);
+      v.zeros(rows, cols);
+      if (UseSparseUpdate<MatType, GradType>::value)
+        lastUpdate.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for LazyAdam.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      // Increment the iteration counter variable.
+      ++parent.iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          parent.iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
+          parent.iteration);
+
+      const double alpha = stepSize * std::sqrt(biasCorrection2) /
+          biasCorrection1;
+
+      Update(iterate, alpha, gradient, UseSparseUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Lazy update: only the nonzero elements of the gradient are visited.
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                std::true_type /* sparse */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+
+      ElemType* x = iterate.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+      arma::uword* last = lastUpdate.memptr();
+      ForEachNonzero(gradient, [&](const size_t i, const ElemType g)
+      {
+        // Apply the decay of all the steps since the last update of this
+        // element at once.  (If this element has never been updated, its
+        // moment estimates are zero, so the decay does not matter.)
+        const double steps = double(parent.iteration - last[i]);
+        const ElemType decay1 = ElemType(std::pow(parent.beta1, steps));
+        const ElemType decay2 = ElemType(std::pow(parent.beta2, steps));
+        last[i] = parent.iteration;
+
+        mp[i] = decay1 * mp[i] + oneMinusBeta1 * g;
+        vp[i] = decay2 * vp[i] + oneMinusBeta2 * (g * g);
+        x[i] -= a * mp[i] / (std::sqrt(vp[i]) + eps);
+      });
+    }
+
+    //! Dense update, for all other matrix types; this is the Adam update.
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                std::false_type /* sparse */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      iterate -= alpha * m / (arma::sqrt(v) + parent.epsilon);
+    }
+
+    // Instantiated parent object.
+    LazyAdamUpdate& parent;
+
+    // The exponential moving average of gradient values.
+    StateType m;
+
+    // The exponential moving average of squared gradient values.
+    StateType v;
+
+    // The iteration at which each element was last updated (only used for
+    // sparse gradients).
+    arma::umat lastUpdate;
+  };
+
+ private:
+  // The epsilon value used to initialise the squared gradient parameter.
+  double epsilon;
+
+  // The smoothing parameter.
+  double beta1;
+
+  // The second moment coefficient.
+  double beta2;
+
+  // The number of iterations.
+  size_t iteration;
+};
+
+} // namespace ens
+
+#endif
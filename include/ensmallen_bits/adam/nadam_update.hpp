@@ -81,6 +81,12 @@ class NadamUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -117,17 +123,30 @@ class NadamUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for Nadam, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
     {
       // Increment the iteration counter variable.
       ++parent.iteration;
 
-      // And update the iterate.
-      m *= parent.beta1;
-      m += (1 - parent.beta1) * gradient;
-
-      v *= parent.beta2;
-      v += (1 - parent.beta2) * gradient % gradient;
-
       double beta1T = parent.beta1 * (1 - (0.5 *
           std::pow(0.96, parent.iteration * parent.scheduleDecay)));
 
@@ -146,12 +165,90 @@ class NadamUpdate
       /* Note :- arma::sqrt(v) + epsilon * sqrt(biasCorrection2) is approximated
        * as arma::sqrt(v) + epsilon
        */
-      iterate -= (stepSize * (((1 - beta1T) / biasCorrection1) * gradient
-          + (beta1T1 / biasCorrection3) * m) * sqrt(biasCorrection2))
-          / (arma::sqrt(v) + parent.epsilon);
+      const double alpha = stepSize * std::sqrt(biasCorrection2);
+      const double gradCoef = (1 - beta1T) / biasCorrection1;
+      const double mCoef = beta1T1 / biasCorrection3;
+
+      Update(iterate, alpha, gradCoef, mCoef, gradient, transform,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the moving averages, the decay product and the iteration
+     * counter, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(cumBeta1);
+      ar(parent.iteration);
     }
 
    private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double alpha,
+                const double gradCoef,
+                const double mCoef,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+      const ElemType cg = ElemType(gradCoef);
+      const ElemType cm = ElemType(mCoef);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(g[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          mp[i] = mi;
+          vp[i] = vi;
+          x[i] -= a * (cg * gi + cm * mi) / (std::sqrt(vi) + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double alpha,
+                const double gradCoef,
+                const double mCoef,
+                const GradType& gradient,
+                const IdentityTransform& /* transform */,
+                std::false_type /* fused */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * gradient % gradient;
+
+      iterate -= (alpha * (gradCoef * gradient + mCoef * m)) /
+          (sqrt(v) + parent.epsilon);
+    }
+
     // Instantiated parent object.
     NadamUpdate& parent;
 
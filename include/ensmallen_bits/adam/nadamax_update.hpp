@@ -81,6 +81,12 @@ class NadaMaxUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the first moment estimate and the infinity norm.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -117,16 +123,30 @@ class NadaMaxUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for NadaMax, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
     {
       // Increment the iteration counter variable.
       ++parent.iteration;
 
-      // And update the iterate.
-      m *= parent.beta1;
-      m += (1 - parent.beta1) * gradient;
-
-      u = arma::max(u * parent.beta2, arma::abs(gradient));
-
       double beta1T = parent.beta1 * (1 - (0.5 *
           std::pow(0.96, parent.iteration * parent.scheduleDecay)));
 
@@ -139,14 +159,96 @@ class NadaMaxUpdate
 
       const double biasCorrection2 = 1.0 - (cumBeta1 * beta1T1);
 
-      if ((biasCorrection1 != 0) && (biasCorrection2 != 0))
+      // The iterate is only updated if both bias corrections are nonzero; the
+      // moment estimates are always updated.
+      const bool step = (biasCorrection1 != 0) && (biasCorrection2 != 0);
+      const double gradCoef = step ? (1 - beta1T) / biasCorrection1 : 0.0;
+      const double mCoef = step ? beta1T1 / biasCorrection2 : 0.0;
+
+      Update(iterate, stepSize, step, gradCoef, mCoef, gradient, transform,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the moving averages, the decay product and the iteration
+     * counter, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(m);
+      ar(u);
+      ar(cumBeta1);
+      ar(parent.iteration);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const bool step,
+                const double gradCoef,
+                const double mCoef,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+      const ElemType cg = ElemType(gradCoef);
+      const ElemType cm = ElemType(mCoef);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* up = u.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
       {
-         iterate -= (stepSize * (((1 - beta1T) / biasCorrection1) * gradient
-             + (beta1T1 / biasCorrection2) * m)) / (u + parent.epsilon);
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(g[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType ui = std::max(up[i] * beta2, std::abs(gi));
+          mp[i] = mi;
+          up[i] = ui;
+          if (step)
+            x[i] -= a * (cg * gi + cm * mi) / (ui + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const bool step,
+                const double gradCoef,
+                const double mCoef,
+                const GradType& gradient,
+                const IdentityTransform& /* transform */,
+                std::false_type /* fused */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      u = max(u * parent.beta2, abs(gradient));
+
+      if (step)
+      {
+         iterate -= (stepSize * (gradCoef * gradient + mCoef * m)) /
+             (u + parent.epsilon);
       }
     }
 
-   private:
     // Instantiated parent object.
     NadaMaxUpdate& parent;
 
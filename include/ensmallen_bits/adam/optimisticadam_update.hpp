@@ -77,6 +77,12 @@ class OptimisticAdamUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates and the last gradient.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 3 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -113,31 +119,110 @@ class OptimisticAdamUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for OptimisticAdam, where each element of the gradient is
+     * passed through the given element-wise transform (see ClipTransform) as it
+     * is read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
     {
       // Increment the iteration counter variable.
       ++parent.iteration;
 
-      // And update the iterate.
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          parent.iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
+          parent.iteration);
+
+      Update(iterate, stepSize, biasCorrection1, biasCorrection2, gradient,
+          transform, UseFusedUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const double biasCorrection1,
+                const double biasCorrection2,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+      const ElemType bc1 = ElemType(biasCorrection1);
+      const ElemType bc2 = ElemType(biasCorrection2);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* gradp = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+      ElemType* gp = g.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(gradp[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          const ElemType update = (mi / bc1) / (std::sqrt(vi / bc2) + eps);
+          mp[i] = mi;
+          vp[i] = vi;
+          x[i] -= (2 * a * update - a * gp[i]);
+          gp[i] = update;
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const double biasCorrection1,
+                const double biasCorrection2,
+                const GradType& gradient,
+                const IdentityTransform& /* transform */,
+                std::false_type /* fused */)
+    {
       m *= parent.beta1;
       m += (1 - parent.beta1) * gradient;
 
       v *= parent.beta2;
-      v += (1 - parent.beta2) * arma::square(gradient);
+      v += (1 - parent.beta2) * square(gradient);
 
-      GradType mCorrected = m / (1.0 - std::pow(parent.beta1,
-          parent.iteration));
-      GradType vCorrected = v / (1.0 - std::pow(parent.beta2,
-          parent.iteration));
+      GradType mCorrected = m / biasCorrection1;
+      GradType vCorrected = v / biasCorrection2;
 
       GradType update = mCorrected /
-          (arma::sqrt(vCorrected) + parent.epsilon);
+          (sqrt(vCorrected) + parent.epsilon);
 
       iterate -= (2 * stepSize * update - stepSize * g);
 
       g = std::move(update);
     }
 
-   private:
     // Instantiated parent object.
     OptimisticAdamUpdate& parent;
 
@@ -2,9 +2,9 @@
  * @file aug_lagrangian.hpp
  * @author Ryan Curtin
  *
- * Definition of AugLagrangian class, which implements the Augmented Lagrangian
- * optimization method (also called the 'method of multipliers'.  This class
- * uses the L-BFGS optimizer.
+ * Definition of AugLagrangianType class, which implements the Augmented
+ * Lagrangian optimization method (also called the 'method of multipliers'.
+ * This class uses the L-BFGS optimizer by default.
  *
  * ensmallen is free software; you may redistribute it and/or modify it under
  * the terms of the 3-clause BSD license.  You should have received a copy of
@@ -29,12 +29,24 @@ namespace ens {
  * AugLagrangian can optimize constrained functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * Each outer iteration minimizes the augmented Lagrangian with the inner
+ * optimizer.  If WarmStart() is true and the inner optimizer has a
+ * ResetPolicy() option (like L_BFGS), its state (for L_BFGS, the stored s and y
+ * vectors and so the scaling factor of the first step) is kept from one inner
+ * solve to the next as long as only the Lagrange multipliers are updated.
+ * That changes the augmented Lagrangian only slightly, while an update of
+ * sigma scales the curvature of the penalty term, so the state is discarded
+ * after it.
+ *
+ * @tparam InnerOptimizerType Optimizer for the unconstrained subproblems.
  */
-class AugLagrangian
+template<typename InnerOptimizerType = L_BFGS>
+class AugLagrangianType
 {
  public:
   /**
-   * Initialize the Augmented Lagrangian with the default L-BFGS optimizer.
+   * Initialize the Augmented Lagrangian with the given inner optimizer.
    * @param penaltyThresholdFactor When the penalty threshold is updated set
    *    the penalty threshold to the penalty multplied by this factor. The
    *    default value of 0.25 is is taken from Burer and Monteiro (2002).
@@ -42,11 +54,13 @@ class AugLagrangian
    *    value. The default value of 10 is taken from Burer and Monteiro (2002).
    * @param maxIterations Maximum number of iterations of the Augmented
    *     Lagrangian algorithm.  0 indicates no maximum.
+   * @param optimizer Instantiated inner optimizer.
    */
-  AugLagrangian(const size_t maxIterations = 1000,
-                const double penaltyThresholdFactor = 0.25,
-                const double sigmaUpdateFactor = 10.0,
-                const L_BFGS& lbfgs = L_BFGS());
+  AugLagrangianType(const size_t maxIterations = 1000,
+                    const double penaltyThresholdFactor = 0.25,
+                    const double sigmaUpdateFactor = 10.0,
+                    const InnerOptimizerType& optimizer =
+                        InnerOptimizerType());
 
   /**
    * Optimize the function.  The value '1' is used for the initial value of each
@@ -127,10 +141,24 @@ class AugLagrangian
         std::forward<CallbackTypes>(callbacks)...);
   }
 
-  //! Get the L-BFGS object used for the actual optimization.
-  const L_BFGS& LBFGS() const { return lbfgs; }
-  //! Modify the L-BFGS object used for the actual optimization.
-  L_BFGS& LBFGS() { return lbfgs; }
+  //! Get the inner optimizer used for the actual optimization.
+  const InnerOptimizerType& InnerOptimizer() const { return optimizer; }
+  //! Modify the inner optimizer used for the actual optimization.
+  InnerOptimizerType& InnerOptimizer() { return optimizer; }
+
+  //! Get the L-BFGS object used for the actual optimization (the same as
+  //! InnerOptimizer()).
+  const InnerOptimizerType& LBFGS() const { return optimizer; }
+  //! Modify the L-BFGS object used for the actual optimization (the same as
+  //! InnerOptimizer()).
+  InnerOptimizerType& LBFGS() { return optimizer; }
+
+  //! Get whether or not the state of the inner optimizer is kept between
+  //! inner solves.
+  bool WarmStart() const { return warmStart; }
+  //! Modify whether or not the state of the inner optimizer is kept between
+  //! inner solves.
+  bool& WarmStart() { return warmStart; }
 
   //! Get the Lagrange multipliers.
   const arma::vec& Lambda() const { return lambda; }
@@ -142,6 +170,36 @@ class AugLagrangian
   //! Modify the penalty parameter.
   double& Sigma() { return sigma; }
 
+  /**
+   * Save the Lagrange multipliers and the penalty parameter of the last
+   * (successful) optimization.  Optimize() without initial multipliers starts
+   * from them, so after LoadState() it is warm-started, e.g. on a similar
+   * problem with the same constraints (see WarmStartStore).
+   *
+   * @param ar The CheckpointWriter to save to.
+   * @param coordinates The coordinates of the optimization.
+   */
+  template<typename MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& /* coordinates */)
+  {
+    ar(lambda);
+    ar(sigma);
+  }
+
+  /**
+   * Restore the Lagrange multipliers and the penalty parameter saved by
+   * SaveState().
+   *
+   * @param ar The CheckpointReader to restore from.
+   * @param coordinates The coordinates of the optimization.
+   */
+  template<typename MatType>
+  void LoadState(CheckpointReader& ar, const MatType& /* coordinates */)
+  {
+    ar(lambda);
+    ar(sigma);
+  }
+
   //! Get the maximum iterations
   size_t MaxIterations() const { return maxIterations; }
   //! Modify the maximum iterations
@@ -157,6 +215,14 @@ class AugLagrangian
   //! Modify the sigma update factor
   double& SigmaUpdateFactor() { return sigmaUpdateFactor; }
 
+  //! Get whether or not the per-constraint methods of the function are called
+  //! in parallel when it has no EvaluateConstraints()/GradientConstraints().
+  bool ParallelConstraints() const { return parallelConstraints; }
+  //! Modify whether or not the per-constraint methods of the function are
+  //! called in parallel when it has no EvaluateConstraints() or
+  //! GradientConstraints().
+  bool& ParallelConstraints() { return parallelConstraints; }
+
  private:
   //! Maximum number of iterations.
   size_t maxIterations;
@@ -167,8 +233,15 @@ class AugLagrangian
   //! Parameter for updating sigma
   double sigmaUpdateFactor;
 
-  //! The L-BFGS optimizer that we will use.
-  L_BFGS lbfgs;
+  //! The inner optimizer that we will use.
+  InnerOptimizerType optimizer;
+
+  //! Whether or not the state of the inner optimizer is kept between inner
+  //! solves.
+  bool warmStart;
+
+  //! Whether or not the per-constraint methods are called in parallel.
+  bool parallelConstraints;
 
   //! Controls early termination of the optimization process.
   bool terminate;
@@ -204,8 +277,33 @@ class AugLagrangian
         CallbackTypes...>(function, coordinates,
         std::forward<CallbackTypes>(callbacks)...);
   }
+
+  //! Set the ResetPolicy() option of the inner optimizer, if it has one, and
+  //! return its previous value.
+  template<typename T>
+  static typename std::enable_if<traits::HasResetPolicySignature<T>::value,
+      bool>::type
+  SetResetPolicy(T& optimizer, const bool resetPolicy)
+  {
+    const bool previous = optimizer.ResetPolicy();
+    optimizer.ResetPolicy() = resetPolicy;
+    return previous;
+  }
+
+  template<typename T>
+  static typename std::enable_if<!traits::HasResetPolicySignature<T>::value,
+      bool>::type
+  SetResetPolicy(T& /* optimizer */, const bool /* resetPolicy */)
+  {
+    return true;
+  }
 };
 
+/**
+ * The Augmented Lagrangian method with L-BFGS as the inner optimizer.
+ */
+using AugLagrangian = AugLagrangianType<L_BFGS>;
+
 } // namespace ens
 
 #include "aug_lagrangian_impl.hpp"
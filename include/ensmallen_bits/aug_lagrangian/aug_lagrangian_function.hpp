@@ -29,6 +29,12 @@ namespace ens {
  * of the methods (unfortunately, C++ specialization rules mean you have to
  * re-implement everything).
  *
+ * If the LagrangianFunction provides the bulk methods EvaluateConstraints() and
+ * GradientConstraints() (see the documentation for AugLagrangian), they are
+ * used instead of one call per constraint.  Otherwise, the per-constraint
+ * methods are called serially, or in parallel if ParallelConstraints() is set
+ * to true, in which case they must be safe to call concurrently.
+ *
  * @tparam LagrangianFunction Lagrangian function to be used.
  */
 template<typename LagrangianFunction>
@@ -94,6 +100,11 @@ class AugLagrangianFunction
   //! Modify sigma (the penalty parameter).
   double& Sigma() { return sigma; }
 
+  //! Get whether or not the per-constraint methods are called in parallel.
+  bool ParallelConstraints() const { return parallelConstraints; }
+  //! Modify whether or not the per-constraint methods are called in parallel.
+  bool& ParallelConstraints() { return parallelConstraints; }
+
   //! Get the Lagrangian function.
   const LagrangianFunction& Function() const { return function; }
   //! Modify the Lagrangian function.
@@ -107,6 +118,8 @@ class AugLagrangianFunction
   arma::vec lambda;
   //! The penalty parameter.
   double sigma;
+  //! Whether or not the per-constraint methods are called in parallel.
+  bool parallelConstraints;
 };
 
 } // namespace ens
@@ -16,6 +16,7 @@
 
 // In case it hasn't been included.
 #include "aug_lagrangian_function.hpp"
+#include <ensmallen_bits/utility/evaluate_constraints.hpp>
 
 namespace ens {
 
@@ -25,7 +26,8 @@ AugLagrangianFunction<LagrangianFunction>::AugLagrangianFunction(
     LagrangianFunction& function) :
     function(function),
     lambda(function.NumConstraints()),
-    sigma(10)
+    sigma(10),
+    parallelConstraints(false)
 {
   // Initialize lambda vector to all zeroes.
   lambda.zeros();
@@ -39,7 +41,8 @@ AugLagrangianFunction<LagrangianFunction>::AugLagrangianFunction(
     const double sigma) :
     function(function),
     lambda(lambda),
-    sigma(sigma)
+    sigma(sigma),
+    parallelConstraints(false)
 {
   // Nothing else to do.
 }
@@ -58,13 +61,13 @@ typename MatType::elem_type AugLagrangianFunction<LagrangianFunction>::Evaluate(
   // First get the function's objective value.
   ElemType objective = function.Evaluate(coordinates);
 
-  // Now loop for each constraint.
-  for (size_t i = 0; i < function.NumConstraints(); ++i)
+  // Now add the term of each constraint.
+  arma::Col<ElemType> constraints;
+  EvaluateConstraints(function, coordinates, constraints, parallelConstraints);
+  for (size_t i = 0; i < constraints.n_elem; ++i)
   {
-    ElemType constraint = function.EvaluateConstraint(i, coordinates);
-
-    objective += (-lambda[i] * constraint) +
-        sigma * std::pow(constraint, 2) / 2;
+    objective += (-lambda[i] * constraints[i]) +
+        sigma * std::pow(constraints[i], 2) / 2;
   }
 
   return objective;
@@ -79,20 +82,21 @@ void AugLagrangianFunction<LagrangianFunction>::Gradient(
 {
   // The augmented Lagrangian's gradient is evaluted as
   // f'(x) + {(-lambda_i + sigma * c_i(x)) * c'_i(x)} for all constraints
+  typedef typename MatType::elem_type ElemType;
+
   gradient.zeros();
   function.Gradient(coordinates, gradient);
 
-  GradType constraintGradient; // Temporary for constraint gradients.
-  for (size_t i = 0; i < function.NumConstraints(); i++)
-  {
-    function.GradientConstraint(i, coordinates, constraintGradient);
+  // The scaling factor of each constraint gradient.
+  arma::Col<ElemType> weights;
+  EvaluateConstraints(function, coordinates, weights, parallelConstraints);
+  for (size_t i = 0; i < weights.n_elem; ++i)
+    weights[i] = -lambda[i] + sigma * weights[i];
 
-    // Now calculate scaling factor and add to existing gradient.
-    GradType tmpGradient;
-    tmpGradient = (-lambda[i] + sigma *
-        function.EvaluateConstraint(i, coordinates)) * constraintGradient;
-    gradient += tmpGradient;
-  }
+  GradType constraintGradient;
+  GradientConstraints(function, coordinates, weights, constraintGradient,
+      parallelConstraints);
+  gradient += constraintGradient;
 }
 
 // Get the initial point.
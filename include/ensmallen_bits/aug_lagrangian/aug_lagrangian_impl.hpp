@@ -15,51 +15,61 @@
 
 #include <ensmallen_bits/lbfgs/lbfgs.hpp>
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/evaluate_constraints.hpp>
 #include "aug_lagrangian_function.hpp"
 
 namespace ens {
 
-inline AugLagrangian::AugLagrangian(const size_t maxIterations,
-                                    const double penaltyThresholdFactor,
-                                    const double sigmaUpdateFactor,
-                                    const L_BFGS& lbfgs) :
+template<typename InnerOptimizerType>
+inline AugLagrangianType<InnerOptimizerType>::AugLagrangianType(
+    const size_t maxIterations,
+    const double penaltyThresholdFactor,
+    const double sigmaUpdateFactor,
+    const InnerOptimizerType& optimizer) :
     maxIterations(maxIterations),
     penaltyThresholdFactor(penaltyThresholdFactor),
     sigmaUpdateFactor(sigmaUpdateFactor),
-    lbfgs(lbfgs),
+    optimizer(optimizer),
+    warmStart(false),
+    parallelConstraints(false),
     terminate(false),
     sigma(0.0)
 {
 }
 
+template<typename InnerOptimizerType>
 template<typename LagrangianFunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
 typename std::enable_if<IsArmaType<GradType>::value, bool>::type
-AugLagrangian::Optimize(LagrangianFunctionType& function,
-                        MatType& coordinates,
-                        const arma::vec& initLambda,
-                        const double initSigma,
-                        CallbackTypes&&... callbacks)
+AugLagrangianType<InnerOptimizerType>::Optimize(
+    LagrangianFunctionType& function,
+    MatType& coordinates,
+    const arma::vec& initLambda,
+    const double initSigma,
+    CallbackTypes&&... callbacks)
 {
   lambda = initLambda;
   sigma = initSigma;
 
   AugLagrangianFunction<LagrangianFunctionType> augfunc(function,
       lambda, sigma);
+  augfunc.ParallelConstraints() = parallelConstraints;
 
   return Optimize(augfunc, coordinates, callbacks...);
 }
 
+template<typename InnerOptimizerType>
 template<typename LagrangianFunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
 typename std::enable_if<IsArmaType<GradType>::value, bool>::type
-AugLagrangian::Optimize(LagrangianFunctionType& function,
-                        MatType& coordinates,
-                        CallbackTypes&&... callbacks)
+AugLagrangianType<InnerOptimizerType>::Optimize(
+    LagrangianFunctionType& function,
+    MatType& coordinates,
+    CallbackTypes&&... callbacks)
 {
   // If the user did not specify the right size for sigma and lambda, we will
   // use defaults.
@@ -67,21 +77,24 @@ AugLagrangian::Optimize(LagrangianFunctionType& function,
   {
     AugLagrangianFunction<LagrangianFunctionType> augfunc(function, lambda,
         sigma);
+    augfunc.ParallelConstraints() = parallelConstraints;
     return Optimize(augfunc, coordinates, callbacks...);
   }
   else
   {
     AugLagrangianFunction<LagrangianFunctionType> augfunc(function);
+    augfunc.ParallelConstraints() = parallelConstraints;
     return Optimize(augfunc, coordinates, callbacks...);
   }
 }
 
+template<typename InnerOptimizerType>
 template<typename LagrangianFunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
 typename std::enable_if<IsArmaType<GradType>::value, bool>::type
-AugLagrangian::Optimize(
+AugLagrangianType<InnerOptimizerType>::Optimize(
     AugLagrangianFunction<LagrangianFunctionType>& augfunc,
     MatType& coordinatesIn,
     CallbackTypes&&... callbacks)
@@ -113,10 +126,13 @@ AugLagrangian::Optimize(
   ElemType tolerance = 1e3 * std::numeric_limits<ElemType>::epsilon();
 
   // Then, calculate the current penalty.
+  arma::Col<ElemType> constraints;
+  EvaluateConstraints(function, coordinates, constraints,
+      augfunc.ParallelConstraints());
   ElemType penalty = 0;
-  for (size_t i = 0; i < function.NumConstraints(); i++)
+  for (size_t i = 0; i < constraints.n_elem; i++)
   {
-    const ElemType p = std::pow(function.EvaluateConstraint(i, coordinates), 2);
+    const ElemType p = std::pow(constraints[i], 2);
     Callback::EvaluateConstraint(*this, function, coordinates, i, p,
           callbacks...);
 
@@ -131,12 +147,23 @@ AugLagrangian::Optimize(
   size_t it;
   terminate |= Callback::BeginOptimization(*this, function, coordinates,
       callbacks...);
+
+  // With warm starts, the state of the inner optimizer is kept after lambda
+  // updates; the first inner solve always starts from scratch.  The original
+  // setting of the inner optimizer is restored at the end.
+  bool keepInnerState = false;
+  const bool innerResetPolicy = warmStart ? SetResetPolicy(optimizer, true) :
+      true;
+
   for (it = 0; it != (maxIterations - 1) && !terminate; it++)
   {
     Info << "AugLagrangian on iteration " << it
         << ", starting with objective "  << lastObjective << "." << std::endl;
 
-    if (!lbfgs.Optimize(augfunc, coordinates, callbacks...))
+    if (warmStart)
+      SetResetPolicy(optimizer, !keepInnerState);
+
+    if (!optimizer.Optimize(augfunc, coordinates, callbacks...))
       Info << "L-BFGS reported an error during optimization."
           << std::endl;
     Info << "Done with L-BFGS: " << coordinates << "\n";
@@ -154,6 +181,8 @@ AugLagrangian::Optimize(
       lambda = std::move(augfunc.Lambda());
       sigma = augfunc.Sigma();
 
+      if (warmStart)
+        SetResetPolicy(optimizer, innerResetPolicy);
       Callback::EndOptimization(*this, function, coordinates, callbacks...);
       return true;
     }
@@ -164,12 +193,14 @@ AugLagrangian::Optimize(
     // we now update either lambda or sigma.  We update sigma if the penalty
     // term is too high, and we update lambda otherwise.
 
-    // First, calculate the current penalty.
+    // First, calculate the current penalty.  The constraint values are kept
+    // for the update of lambda.
+    EvaluateConstraints(function, coordinates, constraints,
+        augfunc.ParallelConstraints());
     ElemType penalty = 0;
-    for (size_t i = 0; i < function.NumConstraints(); i++)
+    for (size_t i = 0; i < constraints.n_elem; i++)
     {
-      const ElemType p = std::pow(function.EvaluateConstraint(i, coordinates),
-          2);
+      const ElemType p = std::pow(constraints[i], 2);
       Callback::EvaluateConstraint(*this, function, coordinates, i, p,
           callbacks...);
 
@@ -183,9 +214,9 @@ AugLagrangian::Optimize(
     {
       // We use the update: lambda_{k + 1} = lambda_k - sigma * c(coordinates),
       // but we have to write a loop to do this for each constraint.
-      for (size_t i = 0; i < function.NumConstraints(); i++)
+      for (size_t i = 0; i < constraints.n_elem; i++)
       {
-        const ElemType p = function.EvaluateConstraint(i, coordinates);
+        const ElemType p = constraints[i];
         Callback::EvaluateConstraint(*this, function, coordinates, i, p,
           callbacks...);
 
@@ -196,16 +227,21 @@ AugLagrangian::Optimize(
       // penalty.
       penaltyThreshold = penaltyThresholdFactor * penalty;
       Info << "Lagrange multiplier estimates updated." << std::endl;
+      keepInnerState = true;
     }
     else
     {
-      // We multiply sigma by a constant value.
+      // We multiply sigma by a constant value.  This scales the curvature of
+      // the penalty term, so the state of the inner optimizer is discarded.
       augfunc.Sigma() *= sigmaUpdateFactor;
+      keepInnerState = false;
       Info << "Updated sigma to " << augfunc.Sigma() << "." << std::endl;
       if (augfunc.Sigma() >= std::numeric_limits<ElemType>::max() / 2.0)
       {
         Warn << "AugLagrangian::Optimize(): sigma too large for element type; "
             << "terminating." << std::endl;
+        if (warmStart)
+          SetResetPolicy(optimizer, innerResetPolicy);
         Callback::EndOptimization(*this, function, coordinates, callbacks...);
         return false;
       }
@@ -215,6 +251,8 @@ AugLagrangian::Optimize(
         callbacks...);
   }
 
+  if (warmStart)
+    SetResetPolicy(optimizer, innerResetPolicy);
   Callback::EndOptimization(*this, function, coordinates, callbacks...);
   return false;
 }
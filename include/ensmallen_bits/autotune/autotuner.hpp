@@ -0,0 +1,258 @@
+/**
+ * @file autotuner.hpp
+ *
+ * Pick the settings of an optimizer (batch size, thread share size, number of
+ * threads, ...) with the best throughput from short timed probes.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_AUTOTUNE_AUTOTUNER_HPP
+#define ENSMALLEN_AUTOTUNE_AUTOTUNER_HPP
+
+namespace ens {
+
+/**
+ * A callback that counts the steps of a probe, and terminates the
+ * optimization once its time budget is spent.
+ */
+class AutotuneProbe
+{
+ public:
+  /**
+   * Create the probe.
+   *
+   * @param seconds The time budget of the probe.
+   */
+  AutotuneProbe(const double seconds) : seconds(seconds), steps(0), elapsed(0)
+  { /* Nothing to do. */ }
+
+  //! Start the clock.
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    steps = 0;
+    elapsed = 0;
+    start = std::chrono::steady_clock::now();
+  }
+
+  //! Count the step, and terminate once the time budget is spent.
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    ++steps;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+        start).count();
+    return elapsed >= seconds;
+  }
+
+  //! Get the number of steps of the probe.
+  size_t Steps() const { return steps; }
+
+  //! Get the time between the start and the last step, in seconds.
+  double Elapsed() const { return elapsed; }
+
+ private:
+  //! The time budget of the probe.
+  double seconds;
+  //! The number of steps of the probe.
+  size_t steps;
+  //! The time between the start and the last step.
+  double elapsed;
+  //! The start of the probe.
+  std::chrono::steady_clock::time_point start;
+};
+
+/**
+ * Autotuner chooses the settings of an optimizer that process the most points
+ * per second on the given function and machine.  Each setting (e.g. the batch
+ * size, the ThreadShareSize() of ParallelSGD or the number of OpenMP threads)
+ * is added with its candidate values; Tune() then runs a short probe of
+ * Optimize() on a copy of the coordinates for every combination of the
+ * candidates, and applies the combination with the best throughput to the
+ * optimizer.
+ *
+ * Each probe runs on a copy of the optimizer for `probeSeconds` seconds (as
+ * measured by the StepTaken() callback, so the optimizer must call it), and
+ * its throughput is the number of steps times the BatchSize() of the probe (1
+ * if the optimizer has no BatchSize()) divided by the time from the start of
+ * the optimization to the last step.  Each combination is probed
+ * `repetitions` times, and its best throughput is kept, which discounts cold
+ * caches and other transient delays.
+ *
+ * If `cacheFile` is not empty, the best combination is appended to that file,
+ * keyed by the machine (the number of hardware threads), the types of the
+ * optimizer and the function, the shape of the coordinates, the number of
+ * functions and the candidates; if the file already holds the key, Tune()
+ * applies the cached combination without any probe.
+ *
+ * @code
+ * ParallelSGD<> optimizer(100, 1024);
+ * Autotuner<ParallelSGD<>> tuner(0.05, 3, "ensmallen_tune.txt");
+ * tuner.AddThreadShareSize({ 256, 1024, 4096 });
+ * tuner.AddThreads({ 4, 8, 16 });
+ * tuner.Tune(optimizer, f, coordinates);
+ * optimizer.Optimize(f, coordinates);
+ * @endcode
+ *
+ * @tparam OptimizerType Type of the optimizer to tune.
+ */
+template<typename OptimizerType>
+class Autotuner
+{
+ public:
+  //! The type of the functions that apply a value of a setting.
+  typedef std::function<void(OptimizerType&, const size_t)> SetterType;
+
+  /**
+   * Create the autotuner, without any setting.
+   *
+   * @param probeSeconds The duration of each probe.
+   * @param repetitions The number of probes of each combination.
+   * @param cacheFile The file of the cached results (empty for no cache).
+   */
+  Autotuner(const double probeSeconds = 0.05,
+            const size_t repetitions = 3,
+            const std::string& cacheFile = "");
+
+  /**
+   * Add a setting to tune.
+   *
+   * @param name The name of the setting (without whitespace).
+   * @param candidates The candidate values of the setting.
+   * @param setter The function that applies a value to the optimizer.
+   */
+  Autotuner& AddParameter(const std::string& name,
+                          const std::vector<size_t>& candidates,
+                          const SetterType& setter);
+
+  //! Tune the BatchSize() of the optimizer.
+  Autotuner& AddBatchSize(const std::vector<size_t>& candidates);
+
+  //! Tune the ThreadShareSize() of the optimizer (i.e. ParallelSGD).
+  Autotuner& AddThreadShareSize(const std::vector<size_t>& candidates);
+
+  //! Tune the number of OpenMP threads; this sets the number of threads of
+  //! the whole program, and has no effect without OpenMP.
+  Autotuner& AddThreads(const std::vector<size_t>& candidates);
+
+  /**
+   * Probe every combination of the candidates (or read the best one from the
+   * cache), and apply the best one to the optimizer.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of the coordinates.
+   * @param optimizer The optimizer to tune.
+   * @param function The function to optimize.
+   * @param iterate The starting point of the probes (not modified).
+   * @return The throughput of the best combination, in points per second.
+   */
+  template<typename FunctionType, typename MatType>
+  double Tune(OptimizerType& optimizer,
+              FunctionType& function,
+              const MatType& iterate);
+
+  //! Get the duration of each probe.
+  double ProbeSeconds() const { return probeSeconds; }
+  //! Modify the duration of each probe.
+  double& ProbeSeconds() { return probeSeconds; }
+
+  //! Get the number of probes of each combination.
+  size_t Repetitions() const { return repetitions; }
+  //! Modify the number of probes of each combination.
+  size_t& Repetitions() { return repetitions; }
+
+  //! Get the file of the cached results.
+  const std::string& CacheFile() const { return cacheFile; }
+  //! Modify the file of the cached results.
+  std::string& CacheFile() { return cacheFile; }
+
+  //! Get the names of the settings.
+  const std::vector<std::string>& Names() const { return names; }
+
+  //! Get the combinations of the last Tune(), one per column.
+  const arma::umat& Configurations() const { return configurations; }
+
+  //! Get the throughput of each combination of the last Tune().
+  const arma::vec& Throughputs() const { return throughputs; }
+
+  //! Get the best combination of the last Tune().
+  const std::vector<size_t>& Best() const { return best; }
+
+  //! Get whether the last Tune() used the cache.
+  bool FromCache() const { return fromCache; }
+
+ private:
+  //! Return the number of points of each step of the optimizer.
+  static size_t PointsPerStep(OptimizerType& optimizer,
+                              std::true_type /* hasBatchSize */)
+  {
+    return std::max(optimizer.BatchSize(), (size_t) 1);
+  }
+
+  //! Each step of an optimizer without a batch size is one point.
+  static size_t PointsPerStep(OptimizerType& /* optimizer */,
+                              std::false_type /* hasBatchSize */)
+  {
+    return 1;
+  }
+
+  //! Return the number of functions of a separable function.
+  template<typename FunctionType>
+  static size_t NumFunctions(const FunctionType& function,
+                             std::true_type /* hasNumFunctions */)
+  {
+    return function.NumFunctions();
+  }
+
+  //! The number of functions of other functions is 0.
+  template<typename FunctionType>
+  static size_t NumFunctions(const FunctionType& /* function */,
+                             std::false_type /* hasNumFunctions */)
+  {
+    return 0;
+  }
+
+  //! Return the key of the cache.
+  template<typename FunctionType, typename MatType>
+  std::string CacheKey(const FunctionType& function,
+                       const MatType& iterate) const;
+
+  //! Apply the given combination to the optimizer.
+  void Apply(OptimizerType& optimizer,
+             const std::vector<size_t>& values) const;
+
+  //! The duration of each probe.
+  double probeSeconds;
+  //! The number of probes of each combination.
+  size_t repetitions;
+  //! The file of the cached results.
+  std::string cacheFile;
+  //! The names of the settings.
+  std::vector<std::string> names;
+  //! The candidate values of each setting.
+  std::vector<std::vector<size_t>> candidates;
+  //! The functions that apply the settings.
+  std::vector<SetterType> setters;
+  //! The combinations of the last Tune().
+  arma::umat configurations;
+  //! The throughput of each combination of the last Tune().
+  arma::vec throughputs;
+  //! The best combination of the last Tune().
+  std::vector<size_t> best;
+  //! Whether the last Tune() used the cache.
+  bool fromCache;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "autotuner_impl.hpp"
+
+#endif
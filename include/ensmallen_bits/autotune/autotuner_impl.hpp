@@ -0,0 +1,242 @@
+/**
+ * @file autotuner_impl.hpp
+ *
+ * Implementation of the Autotuner.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_AUTOTUNE_AUTOTUNER_IMPL_HPP
+#define ENSMALLEN_AUTOTUNE_AUTOTUNER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "autotuner.hpp"
+
+#include <fstream>
+#include <typeinfo>
+
+namespace ens {
+
+template<typename OptimizerType>
+inline Autotuner<OptimizerType>::Autotuner(const double probeSeconds,
+                                           const size_t repetitions,
+                                           const std::string& cacheFile) :
+    probeSeconds(probeSeconds),
+    repetitions(repetitions),
+    cacheFile(cacheFile),
+    fromCache(false)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType>
+inline Autotuner<OptimizerType>& Autotuner<OptimizerType>::AddParameter(
+    const std::string& name,
+    const std::vector<size_t>& parameterCandidates,
+    const SetterType& setter)
+{
+  if (parameterCandidates.empty())
+  {
+    throw std::invalid_argument("Autotuner::AddParameter(): there must be at "
+        "least one candidate for " + name);
+  }
+
+  names.push_back(name);
+  candidates.push_back(parameterCandidates);
+  setters.push_back(setter);
+  return *this;
+}
+
+template<typename OptimizerType>
+inline Autotuner<OptimizerType>& Autotuner<OptimizerType>::AddBatchSize(
+    const std::vector<size_t>& parameterCandidates)
+{
+  return AddParameter("batchSize", parameterCandidates,
+      [](OptimizerType& optimizer, const size_t value)
+      {
+        optimizer.BatchSize() = value;
+      });
+}
+
+template<typename OptimizerType>
+inline Autotuner<OptimizerType>& Autotuner<OptimizerType>::AddThreadShareSize(
+    const std::vector<size_t>& parameterCandidates)
+{
+  return AddParameter("threadShareSize", parameterCandidates,
+      [](OptimizerType& optimizer, const size_t value)
+      {
+        optimizer.ThreadShareSize() = value;
+      });
+}
+
+template<typename OptimizerType>
+inline Autotuner<OptimizerType>& Autotuner<OptimizerType>::AddThreads(
+    const std::vector<size_t>& parameterCandidates)
+{
+  return AddParameter("threads", parameterCandidates,
+      [](OptimizerType& /* optimizer */, const size_t value)
+      {
+        #ifdef ENS_USE_OPENMP
+          omp_set_num_threads((int) std::max(value, (size_t) 1));
+        #else
+          (void) value;
+        #endif
+      });
+}
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType>
+double Autotuner<OptimizerType>::Tune(OptimizerType& optimizer,
+                                      FunctionType& function,
+                                      const MatType& iterate)
+{
+  if (candidates.empty())
+  {
+    throw std::invalid_argument("Autotuner::Tune(): no setting to tune; call "
+        "AddParameter() first");
+  }
+
+  // The number of combinations; the first setting varies the slowest.
+  size_t numConfigurations = 1;
+  for (size_t p = 0; p < candidates.size(); ++p)
+    numConfigurations *= candidates[p].size();
+
+  const std::string key = CacheKey(function, iterate);
+  fromCache = false;
+  best.assign(candidates.size(), 0);
+
+  // The last entry of the cache with the same key wins.
+  if (!cacheFile.empty())
+  {
+    std::ifstream cache(cacheFile.c_str());
+    std::string line;
+    while (std::getline(cache, line))
+    {
+      const size_t tab = line.find('\t');
+      if (tab == std::string::npos || line.substr(0, tab) != key)
+        continue;
+
+      std::istringstream values(line.substr(tab + 1));
+      std::vector<size_t> cached(candidates.size());
+      double throughput = 0.0;
+      for (size_t p = 0; p < cached.size(); ++p)
+        values >> cached[p];
+      values >> throughput;
+      if (values.fail())
+        continue;
+
+      best = cached;
+      configurations.set_size(candidates.size(), 1);
+      for (size_t p = 0; p < best.size(); ++p)
+        configurations(p, 0) = best[p];
+      throughputs.set_size(1);
+      throughputs(0) = throughput;
+      fromCache = true;
+    }
+
+    if (fromCache)
+    {
+      Info << "Autotuner: using the cached settings for " << key << "."
+          << std::endl;
+      Apply(optimizer, best);
+      return throughputs(0);
+    }
+  }
+
+  configurations.set_size(candidates.size(), numConfigurations);
+  throughputs.zeros(numConfigurations);
+  size_t bestConfiguration = 0;
+  std::vector<size_t> values(candidates.size());
+  for (size_t c = 0; c < numConfigurations; ++c)
+  {
+    size_t index = c;
+    for (size_t p = candidates.size(); p > 0; --p)
+    {
+      values[p - 1] = candidates[p - 1][index % candidates[p - 1].size()];
+      index /= candidates[p - 1].size();
+    }
+    for (size_t p = 0; p < values.size(); ++p)
+      configurations(p, c) = values[p];
+
+    for (size_t r = 0; r < std::max(repetitions, (size_t) 1); ++r)
+    {
+      OptimizerType probe(optimizer);
+      Apply(probe, values);
+
+      MatType coordinates(iterate);
+      AutotuneProbe timer(probeSeconds);
+      probe.Optimize(function, coordinates, timer);
+
+      if (timer.Steps() > 0 && timer.Elapsed() > 0.0)
+      {
+        const double throughput = double(timer.Steps()) * PointsPerStep(probe,
+            std::integral_constant<bool,
+            traits::HasBatchSizeSignature<OptimizerType>::value>()) /
+            timer.Elapsed();
+        throughputs(c) = std::max(throughputs(c), throughput);
+      }
+    }
+
+    Info << "Autotuner: configuration " << c << " (";
+    for (size_t p = 0; p < values.size(); ++p)
+      Info << (p > 0 ? ", " : "") << names[p] << " = " << values[p];
+    Info << "): " << throughputs(c) << " points per second." << std::endl;
+
+    if (throughputs(c) > throughputs(bestConfiguration))
+      bestConfiguration = c;
+  }
+
+  for (size_t p = 0; p < best.size(); ++p)
+    best[p] = configurations(p, bestConfiguration);
+  Apply(optimizer, best);
+
+  if (!cacheFile.empty())
+  {
+    std::ofstream cache(cacheFile.c_str(), std::ios::app);
+    cache << key << '\t';
+    for (size_t p = 0; p < best.size(); ++p)
+      cache << best[p] << ' ';
+    cache << throughputs(bestConfiguration) << '\n';
+    if (!cache)
+    {
+      Warn << "Autotuner: could not write the cache file " << cacheFile
+          << "." << std::endl;
+    }
+  }
+
+  return throughputs(bestConfiguration);
+}
+
+template<typename OptimizerType>
+template<typename FunctionType, typename MatType>
+std::string Autotuner<OptimizerType>::CacheKey(const FunctionType& function,
+                                               const MatType& iterate) const
+{
+  std::ostringstream key;
+  key << "hardware_threads=" << std::thread::hardware_concurrency()
+      << " optimizer=" << typeid(OptimizerType).name()
+      << " function=" << typeid(FunctionType).name()
+      << " shape=" << iterate.n_rows << "x" << iterate.n_cols
+      << " functions=" << NumFunctions(function, std::integral_constant<bool,
+      traits::HasNumFunctionsSignature<FunctionType>::value>());
+  for (size_t p = 0; p < names.size(); ++p)
+  {
+    key << " " << names[p] << "=";
+    for (size_t i = 0; i < candidates[p].size(); ++i)
+      key << (i > 0 ? "," : "") << candidates[p][i];
+  }
+
+  return key.str();
+}
+
+template<typename OptimizerType>
+void Autotuner<OptimizerType>::Apply(OptimizerType& optimizer,
+                                     const std::vector<size_t>& values) const
+{
+  for (size_t p = 0; p < setters.size(); ++p)
+    setters[p](optimizer, values[p]);
+}
+
+} // namespace ens
+
+#endif
@@ -15,6 +15,8 @@
 #ifndef ENSMALLEN_BIGBATCH_SGD_BACKTRACKING_LINE_SEARCH_HPP
 #define ENSMALLEN_BIGBATCH_SGD_BACKTRACKING_LINE_SEARCH_HPP
 
+#include <ensmallen_bits/utility/executor.hpp>
+
 namespace ens {
 
 /**
@@ -35,6 +37,12 @@ namespace ens {
  *   url     = {http://arxiv.org/abs/1610.05792},
  * }
  * @endcode
+ *
+ * Each rejected step size is halved, so the next trials are known in advance;
+ * if `parallelTrials` is greater than 1, up to that many of them are evaluated
+ * at once on the threads of the executor (see ParallelFor()), and the largest
+ * acceptable one is taken.  The result is the same as with sequential trials,
+ * but the Evaluate() method of the function must then be thread-safe.
  */
 class BacktrackingLineSearch
 {
@@ -45,10 +53,14 @@ class BacktrackingLineSearch
    * problem, so it is suggested that the values used be tailored to the task at
    * hand.
    *
-   * @param function Function to be optimized (minimized).
+   * @param searchParameter The sufficient decrease parameter.
+   * @param parallelTrials Maximum number of trial step sizes evaluated at
+   *     once.
    */
-  BacktrackingLineSearch(const double searchParameter = 0.1) :
-      searchParameter(searchParameter)
+  BacktrackingLineSearch(const double searchParameter = 0.1,
+                         const size_t parallelTrials = 1) :
+      searchParameter(searchParameter),
+      parallelTrials(parallelTrials)
   { /* Nothing to do here. */ }
 
   //! Get the search parameter.
@@ -56,6 +68,11 @@ class BacktrackingLineSearch
   //! Modify the search parameter.
   double& SearchParameter() { return searchParameter; }
 
+  //! Get the maximum number of trial step sizes evaluated at once.
+  size_t ParallelTrials() const { return parallelTrials; }
+  //! Modify the maximum number of trial step sizes evaluated at once.
+  size_t& ParallelTrials() { return parallelTrials; }
+
   template<typename MatType>
   class Policy
   {
@@ -103,6 +120,17 @@ class BacktrackingLineSearch
       ElemType overallObjectiveUpdate = function.Evaluate(iterateUpdate, offset,
           backtrackingBatchSize);
 
+      if (parent.parallelTrials > 1)
+      {
+        if (overallObjectiveUpdate > (overallObjective -
+            parent.searchParameter * stepSize * gradientNorm))
+        {
+          HalveInParallel(function, stepSize, iterate, gradient,
+              gradientNorm, overallObjective, offset, backtrackingBatchSize);
+        }
+        return;
+      }
+
       while (overallObjectiveUpdate >
           (overallObjective - parent.searchParameter * stepSize *
            gradientNorm))
@@ -116,6 +144,45 @@ class BacktrackingLineSearch
     }
 
    private:
+    /**
+     * Halve the rejected step size until it is acceptable, evaluating up to
+     * parallelTrials halvings at once.
+     */
+    template<typename SeparableFunctionType,
+             typename GradType,
+             typename ElemType>
+    void HalveInParallel(SeparableFunctionType& function,
+                         double& stepSize,
+                         const MatType& iterate,
+                         const GradType& gradient,
+                         const double gradientNorm,
+                         const ElemType overallObjective,
+                         const size_t offset,
+                         const size_t backtrackingBatchSize)
+    {
+      const size_t numTrials = parent.parallelTrials;
+      std::vector<ElemType> objectives(numTrials);
+      while (true)
+      {
+        ParallelFor(numTrials, [&](const size_t j)
+        {
+          const double trialStep = stepSize / std::pow(2.0, (double) (j + 1));
+          MatType iterateUpdate = iterate - (trialStep * gradient);
+          objectives[j] = function.Evaluate(iterateUpdate, offset,
+              backtrackingBatchSize);
+        });
+
+        // The first acceptable trial is the largest one.
+        for (size_t j = 0; j < numTrials; ++j)
+        {
+          stepSize /= 2;
+          if (objectives[j] <= (overallObjective - parent.searchParameter *
+              stepSize * gradientNorm))
+            return;
+        }
+      }
+    }
+
     //! Reference to instantiated parent object.
     BacktrackingLineSearch& parent;
   };
@@ -123,6 +190,8 @@ class BacktrackingLineSearch
  private:
   //! The search parameter for each iteration.
   double searchParameter;
+  //! The maximum number of trial step sizes evaluated at once.
+  size_t parallelTrials;
 };
 
 } // namespace ens
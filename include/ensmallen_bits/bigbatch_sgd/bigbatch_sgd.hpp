@@ -69,6 +69,15 @@ namespace ens {
  * details, see the documentation on function types included with this
  * distribution or on the ensmallen website.
  *
+ * The batch size is adapted from the variance of the per-sample gradients of
+ * each batch.  If the function has a GradientMoments() method (see
+ * ens::GradientMoments()), the summed gradient and the squared norms of the
+ * per-sample gradients are obtained from it in one call per batch; otherwise
+ * Gradient() is called for each sample, on multiple threads if ParallelBatch()
+ * is set to true (and OpenMP is enabled).  If DeterministicReduction() is also
+ * set, the ranges of samples and the order in which their sums are reduced do
+ * not depend on the number of threads.
+ *
  * @tparam UpdatePolicyType Update policy used during the iterative update
  *     process. By default the AdaptiveStepsize update policy is used.
  */
@@ -184,6 +193,20 @@ class BigBatchSGD
   //! Modify whether or not the actual objective is calculated.
   bool& ExactObjective() { return exactObjective; }
 
+  //! Get whether or not the per-sample gradients are computed on multiple
+  //! threads.
+  bool ParallelBatch() const { return parallelBatch; }
+  //! Modify whether or not the per-sample gradients are computed on multiple
+  //! threads.
+  bool& ParallelBatch() { return parallelBatch; }
+
+  //! Get whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool DeterministicReduction() const { return deterministicReduction; }
+  //! Modify whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool& DeterministicReduction() { return deterministicReduction; }
+
  private:
   //! The size of the current batch.
   size_t batchSize;
@@ -207,6 +230,14 @@ class BigBatchSGD
   //! Controls whether or not the actual Objective value is calculated.
   bool exactObjective;
 
+  //! Controls whether or not the per-sample gradients are computed on multiple
+  //! threads.
+  bool parallelBatch;
+
+  //! Controls whether or not parallel reductions are independent of the number
+  //! of threads.
+  bool deterministicReduction;
+
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
 
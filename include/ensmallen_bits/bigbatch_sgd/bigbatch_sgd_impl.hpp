@@ -16,6 +16,7 @@
 #include "bigbatch_sgd.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/gradient_moments.hpp>
 
 namespace ens {
 
@@ -35,6 +36,8 @@ BigBatchSGD<UpdatePolicyType>::BigBatchSGD(
     tolerance(tolerance),
     shuffle(shuffle),
     exactObjective(exactObjective),
+    parallelBatch(false),
+    deterministicReduction(false),
     updatePolicy(UpdatePolicyType())
 { /* Nothing to do. */ }
 
@@ -79,11 +82,7 @@ BigBatchSGD<UpdatePolicyType>::Optimize(
       InstUpdatePolicyType;
 
   if (!instUpdatePolicy.Has<InstUpdatePolicyType>())
-  {
-    instUpdatePolicy.Clean();
-    instUpdatePolicy.Set<InstUpdatePolicyType>(
-        new InstUpdatePolicyType(updatePolicy));
-  }
+    instUpdatePolicy.Emplace<InstUpdatePolicyType>(updatePolicy);
 
   // Find the number of functions to use.
   const size_t numFunctions = f.NumFunctions();
@@ -94,7 +93,9 @@ BigBatchSGD<UpdatePolicyType>::Optimize(
   ElemType overallObjective = 0;
   ElemType lastObjective = DBL_MAX;
   bool reset = false;
-  BaseGradType delta0, delta1;
+
+  // Per-thread buffers for the per-sample gradients.
+  std::vector<BaseGradType> buffers;
 
   // Controls early termination of the optimization process.
   bool terminate = false;
@@ -118,32 +119,18 @@ BigBatchSGD<UpdatePolicyType>::Optimize(
         std::min(batchSize, actualMaxIterations - i),
         numFunctions - currentFunction);
 
-    size_t k = 1;
-    double vB = 0;
-
-    // Compute the stochastic gradient estimation.
-    f.Gradient(iterate, currentFunction, gradient, 1);
+    // Compute the stochastic gradient estimation, and the sum of the squared
+    // norms of the per-sample gradients, from which the sample variance
+    // sum_i ||g_i - mean||^2 = sum_i ||g_i||^2 - ||sum_i g_i||^2 / n follows.
+    double squaredNorms = GradientMoments(f, iterate, currentFunction,
+        gradient, effectiveBatchSize, buffers, parallelBatch,
+        deterministicReduction);
 
     terminate |= Callback::Gradient(*this, f, iterate, gradient, callbacks...);
 
-    delta1 = gradient;
-    for (size_t j = 1; j < effectiveBatchSize; ++j, ++k)
-    {
-      f.Gradient(iterate, currentFunction + j, functionGradient, 1);
-
-      terminate |= Callback::Gradient(*this, f, iterate, functionGradient,
-          callbacks...);
-
-      delta0 = delta1 + (functionGradient - delta1) / k;
-
-      // Compute sample variance.
-      vB += arma::norm(functionGradient - delta1, 2.0) *
-          arma::norm(functionGradient - delta0, 2.0);
-
-      delta1 = delta0;
-      gradient += functionGradient;
-    }
-    double gB = std::pow(arma::norm(gradient / effectiveBatchSize, 2), 2.0);
+    double sumNorm = arma::dot(gradient, gradient);
+    double vB = std::max(squaredNorms - sumNorm / effectiveBatchSize, 0.0);
+    double gB = sumNorm / ((double) effectiveBatchSize * effectiveBatchSize);
 
     // Reset the batch size update process counter.
     reset = false;
@@ -165,22 +152,17 @@ BigBatchSGD<UpdatePolicyType>::Optimize(
         // Update the stochastic gradient estimation.
         const size_t batchStart = (currentFunction + batchSize + batchOffset
             - 1) < numFunctions ? currentFunction + batchSize - 1 : 0;
-        for (size_t j = 0; j < batchOffset; ++j, ++k)
-        {
-          f.Gradient(iterate, batchStart + j, functionGradient, 1);
-          terminate |= Callback::Gradient(*this, f, iterate,
-              functionGradient, callbacks...);
-
-          delta0 = delta1 + (functionGradient - delta1) / (k + 1);
-
-          // Compute sample variance.
-          vB += arma::norm(functionGradient - delta1, 2.0) *
-              arma::norm(functionGradient - delta0, 2.0);
-
-          delta1 = delta0;
-          gradient += functionGradient;
-        }
-        gB = std::pow(arma::norm(gradient / (batchSize + batchOffset), 2), 2.0);
+        squaredNorms += GradientMoments(f, iterate, batchStart,
+            functionGradient, batchOffset, buffers, parallelBatch,
+            deterministicReduction);
+        terminate |= Callback::Gradient(*this, f, iterate, functionGradient,
+            callbacks...);
+        gradient += functionGradient;
+
+        const size_t n = batchSize + batchOffset;
+        sumNorm = arma::dot(gradient, gradient);
+        vB = std::max(squaredNorms - sumNorm / n, 0.0);
+        gB = sumNorm / ((double) n * n);
 
         // Update the batchSize.
         batchSize += batchOffset;
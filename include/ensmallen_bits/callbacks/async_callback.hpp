@@ -0,0 +1,531 @@
+/**
+ * @file async_callback.hpp
+ *
+ * An adapter that runs a callback on a background thread.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_ASYNC_CALLBACK_HPP
+#define ENSMALLEN_CALLBACKS_ASYNC_CALLBACK_HPP
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+/**
+ * AsyncCallback runs the wrapped callback on a background thread, so that
+ * callbacks that print or log (such as PrintLoss, ProgressBar or Report) don't
+ * stall the optimizer.  The Evaluate(), EvaluateConstraint(), StepTaken(),
+ * BeginEpoch() and EndEpoch() calls are recorded (the objective and the epoch
+ * or constraint index) in a lock-free single-producer single-consumer ring
+ * buffer, and replayed on the background thread in the same order.
+ * BeginOptimization() and EndOptimization() are called directly on the
+ * optimizing thread; EndOptimization() waits until all recorded calls have been
+ * replayed.  Gradient() and GradientConstraint() are not forwarded, since that
+ * would need a copy of the gradient.  Only the calls that the wrapped callback
+ * implements are recorded.
+ *
+ * Since the optimizer keeps running while the calls are replayed, the wrapped
+ * callback never sees the objects of the optimization itself.  It is called
+ * with copies of the optimizer and the function that are made in
+ * BeginOptimization(); before each replayed call, the step size of the copy of
+ * the optimizer (if it has a StepSize() method) is set to the step size at the
+ * time of the call.  Types that can't be copied are passed directly, and the
+ * wrapped callback must then not read their state that changes during the
+ * optimization.  The coordinates are also a copy, which is made at the
+ * beginning of the optimization and then every `coordinatesInterval` calls to
+ * StepTaken() or EndEpoch() (never, if it is 0); each recorded call refers to
+ * the latest copy at the time it was recorded, so callbacks that use the
+ * coordinates see slightly outdated values.  Changes that the wrapped callback
+ * makes to any of these copies are lost.
+ *
+ * If the wrapped callback returns true to terminate the optimization, the
+ * optimizer sees this at the next recorded call.  If the ring buffer is full,
+ * the optimizer waits for the background thread, unless `dropWhenFull` is
+ * true; then the call is dropped and counted in Dropped().
+ *
+ * @code
+ * std::ofstream log("loss.log");
+ * optimizer.Optimize(f, coordinates, AsyncCallback<PrintLoss>(PrintLoss(log)));
+ * @endcode
+ *
+ * @tparam CallbackType Type of the wrapped callback.
+ */
+template<typename CallbackType>
+class AsyncCallback
+{
+ public:
+  /**
+   * Wrap the given callback.
+   *
+   * @param callback The callback to run on the background thread.
+   * @param capacity The number of calls that can be recorded before they are
+   *     replayed (rounded up to a power of two).
+   * @param coordinatesInterval The number of StepTaken() or EndEpoch() calls
+   *     between two copies of the coordinates (0 copies them only once).
+   * @param dropWhenFull Whether or not to drop calls when the buffer is full
+   *     instead of waiting.
+   */
+  AsyncCallback(const CallbackType& callback = CallbackType(),
+                const size_t capacity = 1024,
+                const size_t coordinatesInterval = 0,
+                const bool dropWhenFull = false) :
+      callback(callback),
+      capacity(capacity),
+      coordinatesInterval(coordinatesInterval),
+      dropWhenFull(dropWhenFull)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Call BeginOptimization() of the wrapped callback, and start the background
+   * thread.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginOptimization(OptimizerType& optimizer,
+                         FunctionType& function,
+                         MatType& coordinates)
+  {
+    if (state)
+      state->Stop();
+
+    const bool terminate = Callback::BeginOptimization(optimizer, function,
+        coordinates, callback);
+
+    // The background thread only uses copies of the objects of the
+    // optimization, so that it doesn't race with the optimizer.
+    const bool setStepSize =
+        std::is_copy_constructible<OptimizerType>::value &&
+        traits::HasStepSizeSignature<OptimizerType>::value;
+    std::shared_ptr<OptimizerType> o = Copy(optimizer,
+        std::is_copy_constructible<OptimizerType>());
+    std::shared_ptr<FunctionType> f = Copy(function,
+        std::is_copy_constructible<FunctionType>());
+
+    state.reset(new State(capacity));
+    State* s = state.get();
+    s->snapshot = std::make_shared<MatType>(coordinates);
+    CallbackType* c = &callback;
+    s->Start([s, c, o, f, setStepSize](const Event& event)
+    {
+      MatType& snapshot = *static_cast<MatType*>(event.coordinates.get());
+      if (setStepSize)
+        SetStepSize(*o, event.stepSize, 0);
+
+      bool terminate = false;
+      switch (event.kind)
+      {
+        case Event::Evaluate:
+          terminate = Callback::Evaluate(*o, *f, snapshot, event.objective,
+              *c);
+          break;
+        case Event::EvaluateConstraint:
+          terminate = Callback::EvaluateConstraint(*o, *f, snapshot,
+              event.index, event.objective, *c);
+          break;
+        case Event::StepTaken:
+          terminate = Callback::StepTaken(*o, *f, snapshot, *c);
+          break;
+        case Event::BeginEpoch:
+          terminate = Callback::BeginEpoch(*o, *f, snapshot, event.index,
+              event.objective, *c);
+          break;
+        case Event::EndEpoch:
+          terminate = Callback::EndEpoch(*o, *f, snapshot, event.index,
+              event.objective, *c);
+          break;
+      }
+
+      if (terminate)
+        s->terminate.store(true, std::memory_order_relaxed);
+    });
+
+    return terminate;
+  }
+
+  /**
+   * Wait until all recorded calls have been replayed, stop the background
+   * thread, and call EndOptimization() of the wrapped callback.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndOptimization(OptimizerType& optimizer,
+                       FunctionType& function,
+                       MatType& coordinates)
+  {
+    if (state)
+      state->Stop();
+
+    return Callback::EndOptimization(optimizer, function, coordinates,
+        callback);
+  }
+
+  /**
+   * Record a call to Evaluate().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double objective)
+  {
+    if (callbacks::traits::HasEvaluateSignature<CallbackType, OptimizerType,
+        FunctionType, MatType>::value)
+      Record(Event::Evaluate, 0, objective, StepSizeOf(optimizer));
+  }
+
+  /**
+   * Record a call to EvaluateConstraint().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param constraint The index of the constraint.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EvaluateConstraint(OptimizerType& optimizer,
+                          FunctionType& /* function */,
+                          const MatType& /* coordinates */,
+                          const size_t constraint,
+                          const double objective)
+  {
+    if (callbacks::traits::HasEvaluateConstraintSignature<CallbackType,
+        OptimizerType, FunctionType, MatType>::value)
+    {
+      Record(Event::EvaluateConstraint, constraint, objective,
+          StepSizeOf(optimizer));
+    }
+  }
+
+  /**
+   * Record a call to StepTaken().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& optimizer,
+                 FunctionType& /* function */,
+                 const MatType& coordinates)
+  {
+    if (!callbacks::traits::HasStepTakenSignature<CallbackType, OptimizerType,
+        FunctionType, MatType>::hasNone)
+    {
+      Snapshot(coordinates);
+      Record(Event::StepTaken, 0, 0, StepSizeOf(optimizer));
+    }
+
+    return Terminate();
+  }
+
+  /**
+   * Record a call to BeginEpoch().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginEpoch(OptimizerType& optimizer,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t epoch,
+                  const double objective)
+  {
+    if (callbacks::traits::HasBeginEpochSignature<CallbackType, OptimizerType,
+        FunctionType, MatType>::value)
+      Record(Event::BeginEpoch, epoch, objective, StepSizeOf(optimizer));
+
+    return Terminate();
+  }
+
+  /**
+   * Record a call to EndEpoch().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t epoch,
+                const double objective)
+  {
+    if (!callbacks::traits::HasEndEpochSignature<CallbackType, OptimizerType,
+        FunctionType, MatType>::hasNone)
+    {
+      Snapshot(coordinates);
+      Record(Event::EndEpoch, epoch, objective, StepSizeOf(optimizer));
+    }
+
+    return Terminate();
+  }
+
+  //! Get the wrapped callback.
+  const CallbackType& Wrapped() const { return callback; }
+  //! Modify the wrapped callback.
+  CallbackType& Wrapped() { return callback; }
+
+  //! Get the number of calls dropped in the last optimization.
+  size_t Dropped() const { return state ? state->dropped : 0; }
+
+ private:
+  //! A recorded call.
+  struct Event
+  {
+    //! The recorded callback.
+    enum Kind { Evaluate, EvaluateConstraint, StepTaken, BeginEpoch, EndEpoch };
+
+    Kind kind;
+    //! The epoch or constraint index.
+    size_t index;
+    //! The objective.
+    double objective;
+    //! The step size of the optimizer.
+    double stepSize;
+    //! The latest copy of the coordinates (of type MatType).
+    std::shared_ptr<void> coordinates;
+  };
+
+  //! The state shared with the background thread.
+  class State
+  {
+   public:
+    State(const size_t capacity) :
+        buffer(RoundUp(capacity)),
+        mask(buffer.size() - 1),
+        head(0),
+        tail(0),
+        stop(false),
+        terminate(false),
+        dropped(0),
+        calls(0)
+    { }
+
+    ~State() { Stop(); }
+
+    //! Start the background thread with the given replay function.
+    template<typename DispatchType>
+    void Start(DispatchType dispatch)
+    {
+      worker = std::thread([this, dispatch]()
+      {
+        Event event;
+        while (true)
+        {
+          if (Pop(event))
+          {
+            dispatch(event);
+            continue;
+          }
+
+          // All calls recorded before Stop() must be replayed.
+          if (stop.load(std::memory_order_acquire))
+          {
+            while (Pop(event))
+              dispatch(event);
+            break;
+          }
+
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+      });
+    }
+
+    //! Replay the remaining calls and stop the background thread.
+    void Stop()
+    {
+      stop.store(true, std::memory_order_release);
+      if (worker.joinable())
+        worker.join();
+    }
+
+    //! Record a call; return false if the buffer is full.
+    bool Push(const Event& event)
+    {
+      const size_t t = tail.load(std::memory_order_relaxed);
+      if (t - head.load(std::memory_order_acquire) == buffer.size())
+        return false;
+
+      buffer[t & mask] = event;
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    //! Take the oldest recorded call; return false if there is none.
+    bool Pop(Event& event)
+    {
+      const size_t h = head.load(std::memory_order_relaxed);
+      if (h == tail.load(std::memory_order_acquire))
+        return false;
+
+      // Move the event out, so that the buffer doesn't keep old copies of the
+      // coordinates alive.
+      event = std::move(buffer[h & mask]);
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    //! The ring buffer.
+    std::vector<Event> buffer;
+    //! The size of the ring buffer minus one.
+    size_t mask;
+    //! The number of replayed calls.
+    std::atomic<size_t> head;
+    //! The number of recorded calls.
+    std::atomic<size_t> tail;
+    //! Whether or not the background thread should stop.
+    std::atomic<bool> stop;
+    //! Whether or not the wrapped callback asked to terminate.
+    std::atomic<bool> terminate;
+    //! The number of dropped calls.
+    size_t dropped;
+    //! The number of StepTaken() and EndEpoch() calls.
+    size_t calls;
+    //! The latest copy of the coordinates (of type MatType); only used by the
+    //! optimizing thread.
+    std::shared_ptr<void> snapshot;
+    //! The background thread.
+    std::thread worker;
+
+   private:
+    //! Round up to the next power of two.
+    static size_t RoundUp(const size_t n)
+    {
+      size_t size = 1;
+      while (size < n)
+        size *= 2;
+      return size;
+    }
+  };
+
+  //! Record a call, or count it as dropped.
+  void Record(const typename Event::Kind kind,
+              const size_t index,
+              const double objective,
+              const double stepSize)
+  {
+    if (!state)
+      return;
+
+    Event event;
+    event.kind = kind;
+    event.index = index;
+    event.objective = objective;
+    event.stepSize = stepSize;
+    event.coordinates = state->snapshot;
+    while (!state->Push(event))
+    {
+      if (dropWhenFull)
+      {
+        ++state->dropped;
+        return;
+      }
+
+      std::this_thread::yield();
+    }
+  }
+
+  //! Copy the coordinates if it is due.  The calls that are already recorded
+  //! keep the previous copy.
+  template<typename MatType>
+  void Snapshot(const MatType& coordinates)
+  {
+    if (!state || coordinatesInterval == 0 ||
+        (++state->calls % coordinatesInterval) != 0)
+      return;
+
+    state->snapshot = std::make_shared<MatType>(coordinates);
+  }
+
+  //! Copy the given object for the background thread.
+  template<typename T>
+  static std::shared_ptr<T> Copy(T& t, std::true_type /* copyable */)
+  {
+    return std::make_shared<T>(t);
+  }
+
+  //! Refer to the given object, which can't be copied, without owning it.
+  template<typename T>
+  static std::shared_ptr<T> Copy(T& t, std::false_type /* copyable */)
+  {
+    return std::shared_ptr<T>(&t, [](T*) { });
+  }
+
+  //! Return the step size of the optimizer.
+  template<typename OptimizerType>
+  static typename std::enable_if<
+      traits::HasStepSizeSignature<OptimizerType>::value, double>::type
+  StepSizeOf(const OptimizerType& optimizer)
+  {
+    return optimizer.StepSize();
+  }
+
+  //! Return 0 for optimizers without a step size.
+  template<typename OptimizerType>
+  static typename std::enable_if<
+      !traits::HasStepSizeSignature<OptimizerType>::value, double>::type
+  StepSizeOf(const OptimizerType& /* optimizer */)
+  {
+    return 0;
+  }
+
+  //! Set the step size of the copy of the optimizer.
+  template<typename OptimizerType>
+  static auto SetStepSize(OptimizerType& optimizer,
+                          const double stepSize,
+                          int) -> decltype(optimizer.StepSize() = stepSize,
+                                           void())
+  {
+    optimizer.StepSize() = stepSize;
+  }
+
+  //! Do nothing for optimizers whose step size can't be set.
+  template<typename OptimizerType>
+  static void SetStepSize(OptimizerType& /* optimizer */,
+                          const double /* stepSize */,
+                          long) { }
+
+  //! Return whether the wrapped callback asked to terminate.
+  bool Terminate() const
+  {
+    return state && state->terminate.load(std::memory_order_relaxed);
+  }
+
+  //! The wrapped callback.
+  CallbackType callback;
+  //! The capacity of the ring buffer.
+  size_t capacity;
+  //! The number of calls between two copies of the coordinates.
+  size_t coordinatesInterval;
+  //! Whether or not to drop calls when the buffer is full.
+  bool dropWhenFull;
+  //! The state of the current optimization.
+  std::unique_ptr<State> state;
+};
+
+} // namespace ens
+
+#endif
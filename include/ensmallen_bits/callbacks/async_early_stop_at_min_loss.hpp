@@ -0,0 +1,270 @@
+/**
+ * @file async_early_stop_at_min_loss.hpp
+ *
+ * Implementation of an early stopping callback that evaluates a validation
+ * loss on a background thread.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_ASYNC_EARLY_STOP_AT_MIN_LOSS_HPP
+#define ENSMALLEN_CALLBACKS_ASYNC_EARLY_STOP_AT_MIN_LOSS_HPP
+
+#include <functional>
+
+namespace ens {
+
+/**
+ * Early stopping based on a validation loss that is computed on a background
+ * thread, so that the optimization does not wait for it.  At the end of each
+ * epoch, the coordinates are copied and handed to the background thread, which
+ * evaluates the given validation function on them.  If the background thread
+ * is still busy with an earlier epoch, the copy replaces the one that is
+ * waiting, so only the most recent coordinates are validated.  Once the
+ * validation loss has not decreased for `patience` validations in a row, the
+ * optimization is terminated at the end of the next epoch.
+ *
+ * The validation function is called on the background thread, so it must not
+ * modify any state that is used by the optimization.  The coordinates with the
+ * lowest validation loss are kept by the background thread, and are published
+ * in EndOptimization(), after the thread is joined; they can then be accessed
+ * with BestCoordinates().
+ *
+ * @code
+ * AsyncEarlyStopAtMinLoss cb([&](const arma::mat& coordinates)
+ *     {
+ *       return validationFunction.Evaluate(coordinates);
+ *     }, 5);
+ * optimizer.Optimize(f, coordinates, cb);
+ * @endcode
+ *
+ * @tparam MatType Type of the model coordinates.
+ */
+template<typename MatType = arma::mat>
+class AsyncEarlyStopAtMinLossType
+{
+ public:
+  /**
+   * Set up the asynchronous early stopping callback.
+   *
+   * @param validationFunction Function that returns the validation loss of the
+   *     given coordinates.
+   * @param patience The number of validations without improvement before the
+   *     optimization is terminated (Default: 10).
+   */
+  AsyncEarlyStopAtMinLossType(
+      std::function<double(const MatType&)> validationFunction,
+      const size_t patience = 10) :
+      validationFunction(validationFunction),
+      patience(patience),
+      bestObjective(std::numeric_limits<double>::max()),
+      validations(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the beginning of the optimization; the
+   * background thread is started here.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    if (state)
+      state->Stop();
+
+    bestObjective = std::numeric_limits<double>::max();
+    bestCoordinates.reset();
+    validations = 0;
+
+    state.reset(new State());
+    State* s = state.get();
+    s->worker = std::thread([this, s]() { Validate(*s); });
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data; the
+   * coordinates are handed to the background thread.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t /* epoch */,
+                const double /* objective */)
+  {
+    if (!state)
+      return false;
+
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->pending = coordinates;
+      state->hasPending = true;
+    }
+    state->condition.notify_one();
+
+    return state->terminate.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Callback function called at the end of the optimization; this waits
+   * until the last coordinates have been validated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    if (!state)
+      return;
+
+    // Once the background thread is joined, its results can be published.
+    state->Stop();
+    bestObjective = state->bestObjective;
+    bestCoordinates = std::move(state->bestCoordinates);
+    validations = state->validations;
+    state.reset();
+  }
+
+  //! Get the lowest validation loss.  Only valid after the optimization.
+  double BestObjective() const { return bestObjective; }
+
+  //! Get the coordinates with the lowest validation loss.  Only valid after
+  //! the optimization.
+  const MatType& BestCoordinates() const { return bestCoordinates; }
+
+  //! Get the number of validations.  Only valid after the optimization.
+  size_t Validations() const { return validations; }
+
+  //! Get the number of validations without improvement before terminating.
+  size_t Patience() const { return patience; }
+  //! Modify the number of validations without improvement before
+  //! terminating.
+  size_t& Patience() { return patience; }
+
+ private:
+  //! The state shared with the background thread.
+  struct State
+  {
+    State() :
+        hasPending(false),
+        stop(false),
+        terminate(false),
+        bestObjective(std::numeric_limits<double>::max()),
+        validations(0)
+    { }
+
+    ~State() { Stop(); }
+
+    //! Validate the waiting coordinates and stop the background thread.
+    void Stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      condition.notify_one();
+      if (worker.joinable())
+        worker.join();
+    }
+
+    //! The coordinates waiting to be validated.
+    MatType pending;
+    //! Whether or not there are coordinates waiting to be validated.
+    bool hasPending;
+    //! Whether or not the background thread should stop.
+    bool stop;
+    //! Lock for the members above.
+    std::mutex mutex;
+    //! Signals new coordinates or a stop.
+    std::condition_variable condition;
+    //! Whether or not the optimization should be terminated.
+    std::atomic<bool> terminate;
+    //! The background thread.
+    std::thread worker;
+
+    //! The lowest validation loss; only used by the background thread until
+    //! it is joined.
+    double bestObjective;
+    //! The coordinates with the lowest validation loss; only used by the
+    //! background thread until it is joined.
+    MatType bestCoordinates;
+    //! The number of validations; only used by the background thread until it
+    //! is joined.
+    size_t validations;
+  };
+
+  //! The loop of the background thread.
+  void Validate(State& s)
+  {
+    MatType current;
+    size_t steps = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.condition.wait(lock, [&s]() { return s.hasPending || s.stop; });
+        if (!s.hasPending)
+          break;
+
+        std::swap(current, s.pending);
+        s.hasPending = false;
+      }
+
+      const double objective = validationFunction(current);
+      ++s.validations;
+      if (objective < s.bestObjective)
+      {
+        steps = 0;
+        s.bestObjective = objective;
+        s.bestCoordinates = current;
+      }
+      else if (++steps >= patience)
+      {
+        Info << "Minimum validation loss reached; terminate optimization."
+            << std::endl;
+        s.terminate.store(true, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  //! The validation loss function.
+  std::function<double(const MatType&)> validationFunction;
+
+  //! The number of validations without improvement before terminating.
+  size_t patience;
+
+  //! The lowest validation loss of the last optimization.
+  double bestObjective;
+
+  //! The coordinates with the lowest validation loss of the last optimization.
+  MatType bestCoordinates;
+
+  //! The number of validations of the last optimization.
+  size_t validations;
+
+  //! The state of the current optimization.
+  std::unique_ptr<State> state;
+};
+
+using AsyncEarlyStopAtMinLoss = AsyncEarlyStopAtMinLossType<arma::mat>;
+
+} // namespace ens
+
+#endif
@@ -13,6 +13,7 @@
 #define ENSMALLEN_CALLBACKS_CALLBACKS_HPP
 
 #include <ensmallen_bits/callbacks/traits.hpp>
+#include <ensmallen_bits/utility/timeline.hpp>
 
 namespace ens {
 
@@ -46,6 +47,16 @@ namespace ens {
  *
  * - EndOptimization(optimizer, function, coordinates):
  *   called at the end of the optimization.
+ *
+ * - BeginPhase(optimizer, function, coordinates, phase):
+ *   called before the optimizer enters one of the phases of an iteration
+ *   (see Phase); only optimizers that report phases call it.
+ *
+ * - EndPhase(optimizer, function, coordinates, phase):
+ *   called after the optimizer leaves the given phase.
+ *
+ * With ENS_TIMELINE, the phases and the calls of the callbacks are recorded
+ * into the timeline set with SetTimeline() (see Timeline).
  */
 class Callback
 {
@@ -125,12 +136,11 @@ class Callback
                                 MatType& coordinates,
                                 CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::BeginOptimizationFunction(callbacks, optimizer,
-            function, coordinates)... };
-     return result;
+    typedef callbacks::traits::AnyOf<!callbacks::traits::
+        HasBeginOptimizationSignature<CallbackTypes, OptimizerType,
+        FunctionType, MatType>::hasNone...> AnyCallback;
+    return Callback::BeginOptimizationCallbacks(AnyCallback(), optimizer,
+        function, coordinates, callbacks...);
   }
 
   /**
@@ -188,12 +198,11 @@ class Callback
                               MatType& coordinates,
                               CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::EndOptimizationFunction(callbacks, optimizer,
-            function, coordinates)... };
-     return result;
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasEndOptimizationSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::value...> AnyCallback;
+    return Callback::EndOptimizationCallbacks(AnyCallback(), optimizer,
+        function, coordinates, callbacks...);
   }
 
   /**
@@ -255,13 +264,11 @@ class Callback
                        const double objective,
                        CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)(objective);  // prevent spurious compiler warnings
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::EvaluateFunction(callbacks, optimizer, function,
-        coordinates, objective)... };
-     return result;
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasEvaluateSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::value...> AnyCallback;
+    return Callback::EvaluateCallbacks(AnyCallback(), optimizer, function,
+        coordinates, objective, callbacks...);
   }
 
   /**
@@ -331,14 +338,11 @@ class Callback
                                  const double constraintValue,
                                  CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)(constraint);  // prevent spurious compiler warnings
-    (void)(constraintValue);
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::EvaluateConstraintFunction(callbacks, optimizer,
-            function, coordinates, constraint, constraintValue)... };
-     return result;
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasEvaluateConstraintSignature<CallbackTypes, OptimizerType,
+        FunctionType, MatType>::value...> AnyCallback;
+    return Callback::EvaluateConstraintCallbacks(AnyCallback(), optimizer,
+        function, coordinates, constraint, constraintValue, callbacks...);
   }
 
   /**
@@ -403,12 +407,11 @@ class Callback
                        GradType& gradient,
                        CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::GradientFunction(callbacks, optimizer, function,
-        coordinates, gradient)... };
-     return result;
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasGradientSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType, GradType>::value...> AnyCallback;
+    return Callback::GradientCallbacks(AnyCallback(), optimizer, function,
+        coordinates, gradient, callbacks...);
   }
 
   /**
@@ -479,13 +482,11 @@ class Callback
                        GradType& gradient,
                        CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)(constraint);  // prevent spurious compiler warnings
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::GradientConstraintFunction(callbacks, optimizer,
-        function, coordinates, constraint, gradient)... };
-     return result;
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasGradientConstraintSignature<CallbackTypes, OptimizerType,
+        FunctionType, MatType, GradType>::value...> AnyCallback;
+    return Callback::GradientConstraintCallbacks(AnyCallback(), optimizer,
+        function, coordinates, constraint, gradient, callbacks...);
   }
 
   /**
@@ -511,17 +512,13 @@ class Callback
                                    GradType& gradient,
                                    CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)(objective);  // prevent spurious compiler warnings
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::EvaluateFunction(callbacks, optimizer, function,
-        coordinates, objective)... };
-
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::GradientFunction(callbacks, optimizer, function,
-        coordinates, gradient)... };
-     return result;
+    typedef callbacks::traits::AnyOf<(callbacks::traits::
+        HasEvaluateSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::value || callbacks::traits::
+        HasGradientSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType, GradType>::value)...> AnyCallback;
+    return Callback::EvaluateWithGradientCallbacks(AnyCallback(), optimizer,
+        function, coordinates, objective, gradient, callbacks...);
   }
 
   /**
@@ -587,14 +584,11 @@ class Callback
                          const double objective,
                          CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)(epoch);  // prevent spurious compiler warnings
-    (void)(objective);
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::BeginEpochFunction(callbacks, optimizer, function,
-        coordinates, epoch, objective)... };
-     return result;
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasBeginEpochSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::value...> AnyCallback;
+    return Callback::BeginEpochCallbacks(AnyCallback(), optimizer, function,
+        coordinates, epoch, objective, callbacks...);
   }
 
   /**
@@ -677,14 +671,11 @@ class Callback
                        const double objective,
                        CallbackTypes&... callbacks)
   {
-    // This will return immediately once a callback returns true.
-    bool result = false;
-    (void)(epoch);  // prevent spurious compiler warnings
-    (void)(objective);
-    (void)std::initializer_list<bool>{ result =
-        result || Callback::EndEpochFunction(callbacks, optimizer, function,
-        coordinates, epoch, objective)... };
-     return result;
+    typedef callbacks::traits::AnyOf<!callbacks::traits::
+        HasEndEpochSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::hasNone...> AnyCallback;
+    return Callback::EndEpochCallbacks(AnyCallback(), optimizer, function,
+        coordinates, epoch, objective, callbacks...);
   }
 
   /**
@@ -762,6 +753,506 @@ class Callback
                         MatType& coordinates,
                         CallbackTypes&... callbacks)
   {
+    typedef callbacks::traits::AnyOf<!callbacks::traits::
+        HasStepTakenSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::hasNone...> AnyCallback;
+    return Callback::StepTakenCallbacks(AnyCallback(), optimizer, function,
+        coordinates, callbacks...);
+  }
+
+  /**
+   * Invoke the BeginPhase() callback if it exists.
+   *
+   * @param callback The callback to call.
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param phase The phase that begins.
+   */
+  template<typename CallbackType,
+           typename OptimizerType,
+           typename FunctionType,
+           typename MatType>
+  static typename std::enable_if<callbacks::traits::HasBeginPhaseSignature<
+      CallbackType, OptimizerType, FunctionType, MatType>::value,
+      bool>::type
+  BeginPhaseFunction(CallbackType& callback,
+                     OptimizerType& optimizer,
+                     FunctionType& function,
+                     const MatType& coordinates,
+                     const Phase phase)
+  {
+    const_cast<CallbackType&>(callback).BeginPhase(optimizer, function,
+        coordinates, phase);
+    return false;
+  }
+
+  template<typename CallbackType,
+           typename OptimizerType,
+           typename FunctionType,
+           typename MatType>
+  static typename std::enable_if<!callbacks::traits::HasBeginPhaseSignature<
+      CallbackType, OptimizerType, FunctionType, MatType>::value,
+      bool>::type
+  BeginPhaseFunction(CallbackType& /* callback */,
+                     OptimizerType& /* optimizer */,
+                     FunctionType& /* function */,
+                     const MatType& /* coordinates */,
+                     const Phase /* phase */)
+  { return false; }
+
+  /**
+   * Iterate over the callbacks and invoke the BeginPhase() callback if it
+   * exists.  Phases can't terminate the optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param phase The phase that begins.
+   * @param callbacks The callbacks container.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void BeginPhase(OptimizerType& optimizer,
+                         FunctionType& function,
+                         const MatType& coordinates,
+                         const Phase phase,
+                         CallbackTypes&... callbacks)
+  {
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasBeginPhaseSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::value...> AnyCallback;
+    Callback::BeginPhaseCallbacks(AnyCallback(), optimizer, function,
+        coordinates, phase, callbacks...);
+    // The phase begins on the timeline after its callbacks.
+    ENS_TIMELINE_BEGIN(PhaseName(phase));
+  }
+
+  /**
+   * Invoke the EndPhase() callback if it exists.
+   *
+   * @param callback The callback to call.
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param phase The phase that ends.
+   */
+  template<typename CallbackType,
+           typename OptimizerType,
+           typename FunctionType,
+           typename MatType>
+  static typename std::enable_if<callbacks::traits::HasEndPhaseSignature<
+      CallbackType, OptimizerType, FunctionType, MatType>::value,
+      bool>::type
+  EndPhaseFunction(CallbackType& callback,
+                   OptimizerType& optimizer,
+                   FunctionType& function,
+                   const MatType& coordinates,
+                   const Phase phase)
+  {
+    const_cast<CallbackType&>(callback).EndPhase(optimizer, function,
+        coordinates, phase);
+    return false;
+  }
+
+  template<typename CallbackType,
+           typename OptimizerType,
+           typename FunctionType,
+           typename MatType>
+  static typename std::enable_if<!callbacks::traits::HasEndPhaseSignature<
+      CallbackType, OptimizerType, FunctionType, MatType>::value,
+      bool>::type
+  EndPhaseFunction(CallbackType& /* callback */,
+                   OptimizerType& /* optimizer */,
+                   FunctionType& /* function */,
+                   const MatType& /* coordinates */,
+                   const Phase /* phase */)
+  { return false; }
+
+  /**
+   * Iterate over the callbacks and invoke the EndPhase() callback if it exists.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param phase The phase that ends.
+   * @param callbacks The callbacks container.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void EndPhase(OptimizerType& optimizer,
+                       FunctionType& function,
+                       const MatType& coordinates,
+                       const Phase phase,
+                       CallbackTypes&... callbacks)
+  {
+    typedef callbacks::traits::AnyOf<callbacks::traits::
+        HasEndPhaseSignature<CallbackTypes, OptimizerType, FunctionType,
+        MatType>::value...> AnyCallback;
+    // The phase ends on the timeline before its callbacks.
+    ENS_TIMELINE_END(PhaseName(phase));
+    Callback::EndPhaseCallbacks(AnyCallback(), optimizer, function, coordinates,
+        phase, callbacks...);
+  }
+
+ private:
+  //! Invoke the BeginOptimization() callbacks; at least one of the
+  //! callbacks has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginOptimizationCallbacks(std::true_type /* any */,
+                                         OptimizerType& optimizer,
+                                         FunctionType& function,
+                                         MatType& coordinates,
+                                         CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("BeginOptimization callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::BeginOptimizationFunction(callbacks, optimizer,
+            function, coordinates)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginOptimizationCallbacks(std::false_type /* any */,
+                                         OptimizerType& /* optimizer */,
+                                         FunctionType& /* function */,
+                                         MatType& /* coordinates */,
+                                         CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the EndOptimization() callbacks; at least one of the
+  //! callbacks has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EndOptimizationCallbacks(std::true_type /* any */,
+                                       OptimizerType& optimizer,
+                                       FunctionType& function,
+                                       MatType& coordinates,
+                                       CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("EndOptimization callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::EndOptimizationFunction(callbacks, optimizer,
+            function, coordinates)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EndOptimizationCallbacks(std::false_type /* any */,
+                                       OptimizerType& /* optimizer */,
+                                       FunctionType& /* function */,
+                                       MatType& /* coordinates */,
+                                       CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the Evaluate() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EvaluateCallbacks(std::true_type /* any */,
+                                OptimizerType& optimizer,
+                                FunctionType& function,
+                                const MatType& coordinates,
+                                const double objective,
+                                CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("Evaluate callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)(objective);  // prevent spurious compiler warnings
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::EvaluateFunction(callbacks, optimizer, function,
+        coordinates, objective)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EvaluateCallbacks(std::false_type /* any */,
+                                OptimizerType& /* optimizer */,
+                                FunctionType& /* function */,
+                                const MatType& /* coordinates */,
+                                const double /* objective */,
+                                CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the EvaluateConstraint() callbacks; at least one of the
+  //! callbacks has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EvaluateConstraintCallbacks(std::true_type /* any */,
+                                          OptimizerType& optimizer,
+                                          FunctionType& function,
+                                          const MatType& coordinates,
+                                          const size_t constraint,
+                                          const double constraintValue,
+                                          CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("EvaluateConstraint callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)(constraint);  // prevent spurious compiler warnings
+    (void)(constraintValue);
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::EvaluateConstraintFunction(callbacks, optimizer,
+            function, coordinates, constraint, constraintValue)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EvaluateConstraintCallbacks(std::false_type /* any */,
+                                          OptimizerType& /* optimizer */,
+                                          FunctionType& /* function */,
+                                          const MatType& /* coordinates */,
+                                          const size_t /* constraint */,
+                                          const double /* constraintValue */,
+                                          CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the Gradient() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool GradientCallbacks(std::true_type /* any */,
+                                OptimizerType& optimizer,
+                                FunctionType& function,
+                                const MatType& coordinates,
+                                GradType& gradient,
+                                CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("Gradient callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::GradientFunction(callbacks, optimizer, function,
+        coordinates, gradient)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool GradientCallbacks(std::false_type /* any */,
+                                OptimizerType& /* optimizer */,
+                                FunctionType& /* function */,
+                                const MatType& /* coordinates */,
+                                GradType& /* gradient */,
+                                CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the GradientConstraint() callbacks; at least one of the
+  //! callbacks has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool GradientConstraintCallbacks(std::true_type /* any */,
+                                          OptimizerType& optimizer,
+                                          FunctionType& function,
+                                          const MatType& coordinates,
+                                          const size_t constraint,
+                                          GradType& gradient,
+                                          CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("GradientConstraint callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)(constraint);  // prevent spurious compiler warnings
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::GradientConstraintFunction(callbacks, optimizer,
+        function, coordinates, constraint, gradient)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool GradientConstraintCallbacks(std::false_type /* any */,
+                                          OptimizerType& /* optimizer */,
+                                          FunctionType& /* function */,
+                                          const MatType& /* coordinates */,
+                                          const size_t /* constraint */,
+                                          GradType& /* gradient */,
+                                          CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the Evaluate() and Gradient() callbacks; at least one of
+  //! the callbacks has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool EvaluateWithGradientCallbacks(std::true_type /* any */,
+                                            OptimizerType& optimizer,
+                                            FunctionType& function,
+                                            const MatType& coordinates,
+                                            const double objective,
+                                            GradType& gradient,
+                                            CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("EvaluateWithGradient callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)(objective);  // prevent spurious compiler warnings
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::EvaluateFunction(callbacks, optimizer, function,
+        coordinates, objective)... };
+
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::GradientFunction(callbacks, optimizer, function,
+        coordinates, gradient)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  static bool EvaluateWithGradientCallbacks(std::false_type /* any */,
+                                            OptimizerType& /* optimizer */,
+                                            FunctionType& /* function */,
+                                            const MatType& /* coordinates */,
+                                            const double /* objective */,
+                                            GradType& /* gradient */,
+                                            CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the BeginEpoch() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginEpochCallbacks(std::true_type /* any */,
+                                  OptimizerType& optimizer,
+                                  FunctionType& function,
+                                  const MatType& coordinates,
+                                  const size_t epoch,
+                                  const double objective,
+                                  CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("BeginEpoch callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)(epoch);  // prevent spurious compiler warnings
+    (void)(objective);
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::BeginEpochFunction(callbacks, optimizer, function,
+        coordinates, epoch, objective)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool BeginEpochCallbacks(std::false_type /* any */,
+                                  OptimizerType& /* optimizer */,
+                                  FunctionType& /* function */,
+                                  const MatType& /* coordinates */,
+                                  const size_t /* epoch */,
+                                  const double /* objective */,
+                                  CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the EndEpoch() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EndEpochCallbacks(std::true_type /* any */,
+                                OptimizerType& optimizer,
+                                FunctionType& function,
+                                const MatType& coordinates,
+                                const size_t epoch,
+                                const double objective,
+                                CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("EndEpoch callbacks");
+    // This will return immediately once a callback returns true.
+    bool result = false;
+    (void)(epoch);  // prevent spurious compiler warnings
+    (void)(objective);
+    (void)std::initializer_list<bool>{ result =
+        result || Callback::EndEpochFunction(callbacks, optimizer, function,
+        coordinates, epoch, objective)... };
+     return result;
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool EndEpochCallbacks(std::false_type /* any */,
+                                OptimizerType& /* optimizer */,
+                                FunctionType& /* function */,
+                                const MatType& /* coordinates */,
+                                const size_t /* epoch */,
+                                const double /* objective */,
+                                CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the StepTaken() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool StepTakenCallbacks(std::true_type /* any */,
+                                 OptimizerType& optimizer,
+                                 FunctionType& function,
+                                 MatType& coordinates,
+                                 CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("StepTaken callbacks");
     // This will return immediately once a callback returns true.
     bool result = false;
     (void)std::initializer_list<bool>{ result =
@@ -769,6 +1260,80 @@ class Callback
             function, coordinates)... };
      return result;
   }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static bool StepTakenCallbacks(std::false_type /* any */,
+                                 OptimizerType& /* optimizer */,
+                                 FunctionType& /* function */,
+                                 MatType& /* coordinates */,
+                                 CallbackTypes&... /* callbacks */)
+  { return false; }
+
+  //! Invoke the BeginPhase() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void BeginPhaseCallbacks(std::true_type /* any */,
+                                  OptimizerType& optimizer,
+                                  FunctionType& function,
+                                  const MatType& coordinates,
+                                  const Phase phase,
+                                  CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("BeginPhase callbacks");
+    (void)std::initializer_list<bool>{ Callback::BeginPhaseFunction(callbacks,
+        optimizer, function, coordinates, phase)... };
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void BeginPhaseCallbacks(std::false_type /* any */,
+                                  OptimizerType& /* optimizer */,
+                                  FunctionType& /* function */,
+                                  const MatType& /* coordinates */,
+                                  const Phase /* phase */,
+                                  CallbackTypes&... /* callbacks */)
+  { }
+
+  //! Invoke the EndPhase() callbacks; at least one of the callbacks
+  //! has the method.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void EndPhaseCallbacks(std::true_type /* any */,
+                                OptimizerType& optimizer,
+                                FunctionType& function,
+                                const MatType& coordinates,
+                                const Phase phase,
+                                CallbackTypes&... callbacks)
+  {
+    ENS_TIMELINE_SCOPE("EndPhase callbacks");
+    (void)std::initializer_list<bool>{ Callback::EndPhaseFunction(callbacks,
+        optimizer, function, coordinates, phase)... };
+  }
+
+  //! None of the callbacks has the method, so there is nothing to do.
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  static void EndPhaseCallbacks(std::false_type /* any */,
+                                OptimizerType& /* optimizer */,
+                                FunctionType& /* function */,
+                                const MatType& /* coordinates */,
+                                const Phase /* phase */,
+                                CallbackTypes&... /* callbacks */)
+  { }
 };
 
 } // namespace ens
@@ -0,0 +1,263 @@
+/**
+ * @file checkpoint.hpp
+ *
+ * Implementation of a callback that periodically saves the coordinates and the
+ * state of the optimizer to a file.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_CHECKPOINT_HPP
+#define ENSMALLEN_CALLBACKS_CHECKPOINT_HPP
+
+#include <ensmallen_bits/utility/checkpoint.hpp>
+#include <fstream>
+
+namespace ens {
+
+namespace traits {
+
+//! Detect a SaveState() method that accepts the given coordinates.
+template<typename OptimizerType, typename MatType>
+struct HasSaveState
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().SaveState(
+      std::declval<CheckpointWriter&>(), std::declval<const MatType&>()),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<OptimizerType>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * The Checkpoint callback saves the coordinates and, for optimizers that
+ * implement SaveState() (such as SGD and all optimizers based on it), the
+ * state of the optimizer every `epochInterval` epochs.  The file is written in
+ * the aligned binary format of CheckpointWriter, first to `filename.tmp`, which
+ * is then renamed, so an existing checkpoint is never left half-written.  An
+ * interrupted optimization can be resumed warm with Checkpoint::Load():
+ *
+ * @code
+ * Adam adam;
+ * arma::mat coordinates = f.GetInitialPoint();
+ * if (std::ifstream("adam.ckpt"))
+ *   Checkpoint::Load("adam.ckpt", adam, coordinates);
+ * adam.Optimize(f, coordinates, Checkpoint("adam.ckpt"));
+ * @endcode
+ *
+ * A std::runtime_error is thrown if the file can't be written or read.
+ */
+class Checkpoint
+{
+ public:
+  /**
+   * Set up the checkpoint callback.
+   *
+   * @param filename The file to save the checkpoints to.
+   * @param epochInterval The number of epochs between two checkpoints.
+   */
+  Checkpoint(const std::string& filename, const size_t epochInterval = 1) :
+      filename(filename),
+      epochInterval(epochInterval == 0 ? 1 : epochInterval),
+      epochs(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the end of a pass over the data; a checkpoint
+   * is saved if it is due.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& coordinates,
+                const size_t /* epoch */,
+                const double /* objective */)
+  {
+    if (++epochs % epochInterval == 0)
+      Save(filename, optimizer, coordinates);
+  }
+
+  /**
+   * Save the coordinates and the state of the optimizer to the given file.
+   *
+   * @param filename The file to save to.
+   * @param optimizer The optimizer.
+   * @param coordinates The coordinates.
+   */
+  template<typename OptimizerType, typename MatType>
+  static void Save(const std::string& filename,
+                   OptimizerType& optimizer,
+                   const MatType& coordinates)
+  {
+    const std::string tmpFilename = filename + ".tmp";
+    {
+      std::ofstream stream(tmpFilename.c_str(), std::ios::binary);
+      if (!stream)
+      {
+        throw std::runtime_error("Checkpoint::Save(): cannot open '" +
+            tmpFilename + "' for writing.");
+      }
+
+      Save(stream, optimizer, coordinates);
+    }
+
+    if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+      throw std::runtime_error("Checkpoint::Save(): cannot rename '" +
+          tmpFilename + "' to '" + filename + "'.");
+    }
+  }
+
+  /**
+   * Restore the coordinates and the state of the optimizer from the given
+   * file.  The optimizer must be of the same type as the saved one.
+   *
+   * @param filename The file to restore from.
+   * @param optimizer The optimizer.
+   * @param coordinates The coordinates.
+   */
+  template<typename OptimizerType, typename MatType>
+  static void Load(const std::string& filename,
+                   OptimizerType& optimizer,
+                   MatType& coordinates)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream)
+    {
+      throw std::runtime_error("Checkpoint::Load(): cannot open '" + filename +
+          "' for reading.");
+    }
+
+    Restore(stream, "'" + filename + "' is not", optimizer, coordinates);
+  }
+
+  /**
+   * Save the coordinates and the state of the optimizer to the given stream,
+   * e.g. a std::ostringstream for an in-memory snapshot.
+   *
+   * @param stream The stream to save to.
+   * @param optimizer The optimizer.
+   * @param coordinates The coordinates.
+   */
+  template<typename OptimizerType, typename MatType>
+  static void Save(std::ostream& stream,
+                   OptimizerType& optimizer,
+                   const MatType& coordinates)
+  {
+    CheckpointWriter ar(stream);
+    ar.WriteBytes(Magic(), 8);
+    ar(coordinates);
+    SaveOptimizer(ar, optimizer, coordinates);
+  }
+
+  /**
+   * Restore the coordinates and the state of the optimizer from the given
+   * stream.  The optimizer must be of the same type as the saved one.
+   *
+   * @param stream The stream to restore from.
+   * @param optimizer The optimizer.
+   * @param coordinates The coordinates.
+   */
+  template<typename OptimizerType, typename MatType>
+  static void Load(std::istream& stream,
+                   OptimizerType& optimizer,
+                   MatType& coordinates)
+  {
+    Restore(stream, "the stream does not hold", optimizer, coordinates);
+  }
+
+ private:
+  //! The first bytes of a checkpoint file.
+  static const char* Magic() { return "ENSCKPT1"; }
+
+  //! Restore a checkpoint from the stream; the subject of the error message
+  //! names the source.
+  template<typename OptimizerType, typename MatType>
+  static void Restore(std::istream& stream,
+                      const std::string& subject,
+                      OptimizerType& optimizer,
+                      MatType& coordinates)
+  {
+    CheckpointReader ar(stream);
+    char magic[8];
+    ar.ReadBytes(magic, 8);
+    if (std::memcmp(magic, Magic(), 8) != 0)
+    {
+      throw std::runtime_error("Checkpoint::Load(): " + subject +
+          " a checkpoint.");
+    }
+
+    ar(coordinates);
+    LoadOptimizer(ar, optimizer, coordinates);
+  }
+
+  //! Save the state of an optimizer that implements SaveState().
+  template<typename OptimizerType, typename MatType>
+  static typename std::enable_if<
+      traits::HasSaveState<OptimizerType, MatType>::value>::type
+  SaveOptimizer(CheckpointWriter& ar,
+                OptimizerType& optimizer,
+                const MatType& coordinates)
+  {
+    SerializeFlag(ar, true);
+    optimizer.SaveState(ar, coordinates);
+  }
+
+  //! Other optimizers have no state to save.
+  template<typename OptimizerType, typename MatType>
+  static typename std::enable_if<
+      !traits::HasSaveState<OptimizerType, MatType>::value>::type
+  SaveOptimizer(CheckpointWriter& ar,
+                OptimizerType& /* optimizer */,
+                const MatType& /* coordinates */)
+  {
+    SerializeFlag(ar, false);
+  }
+
+  //! Restore the state of an optimizer that implements SaveState().
+  template<typename OptimizerType, typename MatType>
+  static typename std::enable_if<
+      traits::HasSaveState<OptimizerType, MatType>::value>::type
+  LoadOptimizer(CheckpointReader& ar,
+                OptimizerType& optimizer,
+                const MatType& coordinates)
+  {
+    SerializeFlag(ar, true);
+    optimizer.LoadState(ar, coordinates);
+  }
+
+  //! Other optimizers have no state to restore.
+  template<typename OptimizerType, typename MatType>
+  static typename std::enable_if<
+      !traits::HasSaveState<OptimizerType, MatType>::value>::type
+  LoadOptimizer(CheckpointReader& ar,
+                OptimizerType& /* optimizer */,
+                const MatType& /* coordinates */)
+  {
+    SerializeFlag(ar, false);
+  }
+
+  //! The file to save the checkpoints to.
+  std::string filename;
+  //! The number of epochs between two checkpoints.
+  size_t epochInterval;
+  //! The number of epochs so far.
+  size_t epochs;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,288 @@
+/**
+ * @file evaluation_budget.hpp
+ *
+ * Implementation of a callback that stops an optimization once a budget of
+ * function evaluations or of wall clock time is used up.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_EVALUATION_BUDGET_HPP
+#define ENSMALLEN_CALLBACKS_EVALUATION_BUDGET_HPP
+
+namespace ens {
+
+/**
+ * The EvaluationBudget callback counts the evaluations of the objective (the
+ * Evaluate() callbacks, which every optimizer reports for each Evaluate() or
+ * EvaluateWithGradient() call of the function) and of the gradient, and
+ * terminates the optimization at the first step or epoch after the number of
+ * evaluations reaches the budget, or after the optimization has run for the
+ * given number of seconds.  This works for any optimizer; SGD and its
+ * variants, which take a step after each evaluation, stop exactly at the
+ * budget, while population-based optimizers like DE and CMAES finish the
+ * generation in which the budget is used up.
+ *
+ * To keep the overhead low when the function is cheap, the clock is only read
+ * every `clockInterval` events (evaluations, gradients, steps and epochs), so
+ * the time budget may be exceeded by the time of that many events.  The
+ * counters are atomics, so the callback can be used by optimizers that
+ * evaluate the function on several threads.
+ *
+ * The EvaluationBudget can be passed as an lvalue to inspect the counters
+ * after the optimization:
+ *
+ * @code
+ * EvaluationBudget budget(10000, 60.0);
+ * optimizer.Optimize(f, coordinates, budget);
+ * std::cout << budget.EvaluationsPerSecond() << std::endl;
+ * @endcode
+ */
+class EvaluationBudget
+{
+ public:
+  /**
+   * Set up the budget.
+   *
+   * @param maxEvaluations Maximum number of evaluations of the objective (0
+   *     means no limit).
+   * @param maxTime Maximum wall clock time in seconds (0 means no limit).
+   * @param clockInterval Number of events between two reads of the clock.
+   */
+  EvaluationBudget(const size_t maxEvaluations = 0,
+                   const double maxTime = 0.0,
+                   const size_t clockInterval = 32) :
+      maxEvaluations(maxEvaluations),
+      maxTime(maxTime),
+      clockInterval(std::max(clockInterval, (size_t) 1)),
+      evaluations(0),
+      gradients(0),
+      events(0),
+      elapsed(0),
+      exhausted(false),
+      start(std::chrono::steady_clock::now())
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the begin of the optimization process; the
+   * counters and the timer are restarted.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    evaluations.store(0, std::memory_order_relaxed);
+    gradients.store(0, std::memory_order_relaxed);
+    events.store(0, std::memory_order_relaxed);
+    elapsed.store(0, std::memory_order_relaxed);
+    exhausted.store(false, std::memory_order_relaxed);
+    start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Callback function called at the end of the optimization process; the
+   * elapsed time is measured exactly.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    ReadClock();
+  }
+
+  /**
+   * Callback function called at any call to Evaluate().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double /* objective */)
+  {
+    const size_t count = evaluations.fetch_add(1,
+        std::memory_order_relaxed) + 1;
+    if (maxEvaluations != 0 && count == maxEvaluations)
+    {
+      Info << "EvaluationBudget: " << maxEvaluations << " evaluations used; "
+          << "terminating optimization." << std::endl;
+      exhausted.store(true, std::memory_order_relaxed);
+    }
+    Tick();
+  }
+
+  /**
+   * Callback function called at any call to Gradient().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param gradient Matrix that holds the gradient.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const MatType& /* gradient */)
+  {
+    gradients.fetch_add(1, std::memory_order_relaxed);
+    Tick();
+  }
+
+  /**
+   * Callback function called once a step is taken; the optimization
+   * terminates if the budget is used up.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    Tick();
+    return Exhausted();
+  }
+
+  /**
+   * Callback function called at the beginning of a pass over the data; the
+   * optimization terminates if the budget is used up.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool BeginEpoch(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t /* epoch */,
+                  const double /* objective */)
+  {
+    return Exhausted();
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data; the
+   * optimization terminates if the budget is used up.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double /* objective */)
+  {
+    Tick();
+    return Exhausted();
+  }
+
+  //! Get the number of evaluations of the objective.
+  size_t Evaluations() const
+  { return evaluations.load(std::memory_order_relaxed); }
+  //! Get the number of evaluations of the gradient.
+  size_t GradientEvaluations() const
+  { return gradients.load(std::memory_order_relaxed); }
+
+  //! Get the elapsed time in seconds, as of the last read of the clock (the
+  //! end of the optimization, once it has terminated).
+  double ElapsedTime() const { return elapsed.load(std::memory_order_relaxed); }
+
+  //! Get the number of evaluations of the objective per second.
+  double EvaluationsPerSecond() const
+  {
+    const double time = ElapsedTime();
+    return (time > 0) ? Evaluations() / time : 0.0;
+  }
+
+  //! Get whether the budget is used up.
+  bool Exhausted() const { return exhausted.load(std::memory_order_relaxed); }
+
+  //! Get the maximum number of evaluations (0 means no limit).
+  size_t MaxEvaluations() const { return maxEvaluations; }
+  //! Modify the maximum number of evaluations (0 means no limit).
+  size_t& MaxEvaluations() { return maxEvaluations; }
+
+  //! Get the maximum wall clock time in seconds (0 means no limit).
+  double MaxTime() const { return maxTime; }
+  //! Modify the maximum wall clock time in seconds (0 means no limit).
+  double& MaxTime() { return maxTime; }
+
+  //! Get the number of events between two reads of the clock.
+  size_t ClockInterval() const { return clockInterval; }
+  //! Modify the number of events between two reads of the clock.
+  size_t& ClockInterval() { return clockInterval; }
+
+ private:
+  //! Count an event, and read the clock every clockInterval events.
+  void Tick()
+  {
+    const size_t count = events.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count % clockInterval == 0)
+      ReadClock();
+  }
+
+  //! Update the elapsed time, and check the time budget.
+  void ReadClock()
+  {
+    const double time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    elapsed.store(time, std::memory_order_relaxed);
+    if (maxTime > 0 && time > maxTime &&
+        !exhausted.exchange(true, std::memory_order_relaxed))
+    {
+      Info << "EvaluationBudget: time budget of " << maxTime << " seconds "
+          << "used; terminating optimization." << std::endl;
+    }
+  }
+
+  //! The maximum number of evaluations.
+  size_t maxEvaluations;
+  //! The maximum wall clock time in seconds.
+  double maxTime;
+  //! The number of events between two reads of the clock.
+  size_t clockInterval;
+
+  //! The number of evaluations of the objective.
+  std::atomic<size_t> evaluations;
+  //! The number of evaluations of the gradient.
+  std::atomic<size_t> gradients;
+  //! The number of events since the start of the optimization.
+  std::atomic<size_t> events;
+  //! The elapsed time at the last read of the clock.
+  std::atomic<double> elapsed;
+  //! Whether the budget is used up.
+  std::atomic<bool> exhausted;
+  //! The start of the optimization.
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace ens
+
+#endif
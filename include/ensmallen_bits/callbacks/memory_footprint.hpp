@@ -0,0 +1,252 @@
+/**
+ * @file memory_footprint.hpp
+ *
+ * Implementation of a callback that reports the estimated state of the
+ * optimizer and the peak memory of an optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_MEMORY_FOOTPRINT_HPP
+#define ENSMALLEN_CALLBACKS_MEMORY_FOOTPRINT_HPP
+
+#include <ensmallen_bits/utility/state_bytes.hpp>
+
+#if defined(__linux__)
+  #include <unistd.h>
+#endif
+
+namespace ens {
+
+/**
+ * The MemoryFootprint callback compares the memory that the optimizer is
+ * expected to keep with the memory that the optimization actually uses.  At
+ * the beginning of the optimization, the estimate of the optimizer is taken
+ * with StateBytes() (UnknownStateBytes for optimizers that don't provide one).
+ * During the optimization, the resident memory of the process is sampled every
+ * `sampleInterval` events (evaluations, gradients, steps and epochs), and the
+ * peak increase over the resident memory when the callback was created (or
+ * Reset()) is kept; this includes the state of the optimizer, its temporaries
+ * and any memory that the function allocates.  The baseline is not taken at
+ * the beginning of the optimization, since most optimizers allocate their
+ * state before that.  At the end, both are printed with Info.
+ *
+ * The resident memory is read from /proc/self/statm, so it is only measured
+ * on Linux; elsewhere PeakBytes() is 0.  Pages that the optimizer allocates
+ * but never touches don't count, and memory that is freed and allocated again
+ * between two samples may be missed, so a smaller interval gives a more
+ * precise peak at the cost of more reads.
+ *
+ * @code
+ * MemoryFootprint footprint; // Created right before the optimization.
+ * optimizer.Optimize(f, coordinates, footprint);
+ * std::cout << footprint.EstimatedBytes() << " " << footprint.PeakBytes()
+ *     << std::endl;
+ * @endcode
+ */
+class MemoryFootprint
+{
+ public:
+  /**
+   * Set up the callback.
+   *
+   * @param sampleInterval Number of events between two samples of the
+   *     resident memory.
+   */
+  MemoryFootprint(const size_t sampleInterval = 16) :
+      sampleInterval(std::max(sampleInterval, (size_t) 1)),
+      estimatedBytes(0),
+      baselineBytes(ResidentBytes()),
+      peakBytes(0),
+      events(0)
+  { /* Nothing to do here. */ }
+
+  //! Take the current resident memory as the new baseline, and clear the
+  //! peak.
+  void Reset()
+  {
+    baselineBytes = ResidentBytes();
+    peakBytes.store(0, std::memory_order_relaxed);
+    events.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Callback function called at the begin of the optimization process; the
+   * estimate of the optimizer is taken.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& optimizer,
+                         FunctionType& /* function */,
+                         MatType& coordinates)
+  {
+    estimatedBytes = ens::StateBytes<MatType>(optimizer, coordinates.n_rows,
+        coordinates.n_cols);
+    Sample();
+  }
+
+  /**
+   * Callback function called at the end of the optimization process; the
+   * memory is sampled one last time, and the footprint is printed.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    Sample();
+    Info << "MemoryFootprint: estimated state ";
+    if (estimatedBytes == UnknownStateBytes)
+      Info << "unknown";
+    else
+      Info << estimatedBytes << " bytes";
+    Info << "; peak resident memory increase " << PeakBytes() << " bytes."
+        << std::endl;
+  }
+
+  /**
+   * Callback function called at any call to Evaluate().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double /* objective */)
+  {
+    Tick();
+  }
+
+  /**
+   * Callback function called at any call to Gradient().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param gradient Matrix that holds the gradient.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const MatType& /* gradient */)
+  {
+    Tick();
+  }
+
+  /**
+   * Callback function called once a step is taken.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    Tick();
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double /* objective */)
+  {
+    Tick();
+  }
+
+  //! Get the number of bytes of state estimated by the optimizer, or
+  //! UnknownStateBytes if the optimizer doesn't provide an estimate.
+  size_t EstimatedBytes() const { return estimatedBytes; }
+
+  //! Get the peak increase of the resident memory, in bytes, as of the last
+  //! sample.
+  size_t PeakBytes() const
+  {
+    return peakBytes.load(std::memory_order_relaxed);
+  }
+
+  //! Get the number of events between two samples.
+  size_t SampleInterval() const { return sampleInterval; }
+  //! Modify the number of events between two samples.
+  size_t& SampleInterval() { return sampleInterval; }
+
+  //! Return the resident memory of the process in bytes, or 0 if it can't be
+  //! measured.
+  static size_t ResidentBytes()
+  {
+    #if defined(__linux__)
+    std::FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+      return 0;
+
+    unsigned long size = 0, resident = 0;
+    const int fields = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+    return (fields == 2) ? (size_t) resident * sysconf(_SC_PAGESIZE) : 0;
+    #else
+    return 0;
+    #endif
+  }
+
+ private:
+  //! Count an event, and sample the memory every sampleInterval events.
+  void Tick()
+  {
+    const size_t count = events.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count % sampleInterval == 0)
+      Sample();
+  }
+
+  //! Sample the resident memory, and update the peak.
+  void Sample()
+  {
+    const size_t resident = ResidentBytes();
+    const size_t increase = (resident > baselineBytes) ?
+        resident - baselineBytes : 0;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (increase > peak && !peakBytes.compare_exchange_weak(peak, increase,
+        std::memory_order_relaxed)) { }
+  }
+
+  //! The number of events between two samples.
+  size_t sampleInterval;
+  //! The number of bytes of state estimated by the optimizer.
+  size_t estimatedBytes;
+  //! The resident memory at the beginning of the optimization.
+  size_t baselineBytes;
+  //! The peak increase of the resident memory.
+  std::atomic<size_t> peakBytes;
+  //! The number of events since the beginning of the optimization.
+  std::atomic<size_t> events;
+};
+
+} // namespace ens
+
+#endif
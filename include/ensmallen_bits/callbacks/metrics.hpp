@@ -0,0 +1,431 @@
+/**
+ * @file metrics.hpp
+ *
+ * Implementation of a callback that collects metrics of an optimization for
+ * monitoring systems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_METRICS_HPP
+#define ENSMALLEN_CALLBACKS_METRICS_HPP
+
+namespace ens {
+
+/**
+ * The Metrics callback collects counters and gauges of an optimization (the
+ * number of steps, epochs, Evaluate() and Gradient() calls, the last objective
+ * and gradient norm, the step rate) and a histogram of the epoch durations, so
+ * that they can be exported to a monitoring system.  All values are stored in
+ * atomics, so the callback doesn't allocate or lock on the optimizing thread,
+ * and the metrics can be exported from any thread while the optimization runs.
+ *
+ * The metrics can be pulled in the Prometheus / OpenMetrics text format with
+ * WriteOpenMetrics() (e.g. from the handler of an HTTP endpoint), or in the
+ * StatsD line format with WriteStatsD().  To push them, a function can be
+ * given that receives the StatsD payload at most once every `pushInterval`
+ * seconds, from the optimizing thread; it can e.g. send the payload in a UDP
+ * datagram.
+ *
+ * @code
+ * Metrics metrics("my_model");
+ * std::thread optimization([&]() { optimizer.Optimize(f, coordinates, metrics);
+ *     });
+ * // In the handler of the /metrics endpoint:
+ * std::ostringstream response;
+ * metrics.WriteOpenMetrics(response);
+ * @endcode
+ */
+class Metrics
+{
+ public:
+  //! The type of the push function.
+  typedef std::function<void(const std::string&)> PushType;
+
+  //! The number of finite buckets of the epoch duration histogram.
+  static constexpr size_t NumBuckets = 8;
+
+  /**
+   * Set up the metrics callback.
+   *
+   * @param prefix The prefix of the metric names.
+   * @param push Function that receives the StatsD payload (none by default).
+   * @param pushInterval The minimum number of seconds between two pushes.
+   */
+  Metrics(const std::string& prefix = "ensmallen",
+          const PushType& push = PushType(),
+          const double pushInterval = 10.0) :
+      prefix(prefix),
+      push(push),
+      pushInterval(pushInterval),
+      steps(0),
+      optimizationSteps(0),
+      epochs(0),
+      evaluations(0),
+      gradients(0),
+      objective(0),
+      gradientNorm(0),
+      epochDurationSum(0),
+      epochDurationCount(0),
+      pushedSteps(0),
+      pushedEpochs(0),
+      pushedEvaluations(0),
+      pushedGradients(0)
+  {
+    for (size_t i = 0; i < NumBuckets; ++i)
+      buckets[i].store(0, std::memory_order_relaxed);
+
+    const auto now = std::chrono::steady_clock::now();
+    start = now;
+    epochStart = now;
+    lastPush = now;
+  }
+
+  /**
+   * Callback function called at the begin of the optimization process.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    // The counters are kept over several optimizations, as monitoring systems
+    // expect; only the step rate is restarted.
+    const auto now = std::chrono::steady_clock::now();
+    start = now;
+    epochStart = now;
+    optimizationSteps.store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * Callback function called at the end of the optimization process; the
+   * metrics are pushed if a push function is set.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    if (push)
+      Push(std::chrono::steady_clock::now());
+  }
+
+  /**
+   * Callback function called at any call to Evaluate().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param objectiveIn Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double objectiveIn)
+  {
+    objective.store(objectiveIn, std::memory_order_relaxed);
+    evaluations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Callback function called at any call to Gradient().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param gradient Matrix that holds the gradient.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const MatType& gradient)
+  {
+    gradientNorm.store(arma::norm(gradient), std::memory_order_relaxed);
+    gradients.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Callback function called once a step is taken.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    steps.fetch_add(1, std::memory_order_relaxed);
+    optimizationSteps.fetch_add(1, std::memory_order_relaxed);
+    if (push)
+      MaybePush();
+  }
+
+  /**
+   * Callback function called at the beginning of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginEpoch(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t /* epoch */,
+                  const double /* objective */)
+  {
+    epochStart = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objectiveIn Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objectiveIn)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double duration =
+        std::chrono::duration<double>(now - epochStart).count();
+    epochStart = now;
+
+    objective.store(objectiveIn, std::memory_order_relaxed);
+    epochs.fetch_add(1, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < NumBuckets; ++i)
+    {
+      if (duration <= BucketBound(i))
+      {
+        buckets[i].fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+    }
+    AtomicAdd(epochDurationSum, duration);
+    epochDurationCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Write the metrics in the Prometheus / OpenMetrics text format.
+   *
+   * @param out The output stream.
+   */
+  void WriteOpenMetrics(std::ostream& out) const
+  {
+    WriteCounter(out, "steps", "Number of steps taken.", Steps());
+    WriteCounter(out, "epochs", "Number of passes over the data.", Epochs());
+    WriteCounter(out, "evaluations", "Number of Evaluate() calls.",
+        Evaluations());
+    WriteCounter(out, "gradient_evaluations", "Number of Gradient() calls.",
+        GradientEvaluations());
+    WriteGauge(out, "objective", "Last objective value.", Objective());
+    WriteGauge(out, "gradient_norm", "Norm of the last gradient.",
+        GradientNorm());
+    WriteGauge(out, "step_rate", "Steps per second in the current "
+        "optimization.", StepRate());
+
+    const std::string name = prefix + "_epoch_duration_seconds";
+    out << "# HELP " << name << " Duration of the passes over the data."
+        << std::endl;
+    out << "# TYPE " << name << " histogram" << std::endl;
+    size_t cumulative = 0;
+    for (size_t i = 0; i < NumBuckets; ++i)
+    {
+      cumulative += buckets[i].load(std::memory_order_relaxed);
+      out << name << "_bucket{le=\"" << BucketBound(i) << "\"} " << cumulative
+          << std::endl;
+    }
+    const size_t count = epochDurationCount.load(std::memory_order_relaxed);
+    out << name << "_bucket{le=\"+Inf\"} " << count << std::endl;
+    out << name << "_sum " << epochDurationSum.load(std::memory_order_relaxed)
+        << std::endl;
+    out << name << "_count " << count << std::endl;
+    out << "# EOF" << std::endl;
+  }
+
+  /**
+   * Write the metrics in the StatsD line format.  The counters are written as
+   * the increments since the last call, so this should only be called by one
+   * consumer (and not together with a push function).
+   *
+   * @param out The output stream.
+   */
+  void WriteStatsD(std::ostream& out)
+  {
+    WriteStatsDCounter(out, "steps", Steps(), pushedSteps);
+    WriteStatsDCounter(out, "epochs", Epochs(), pushedEpochs);
+    WriteStatsDCounter(out, "evaluations", Evaluations(), pushedEvaluations);
+    WriteStatsDCounter(out, "gradient_evaluations", GradientEvaluations(),
+        pushedGradients);
+    out << prefix << ".objective:" << Objective() << "|g\n";
+    out << prefix << ".gradient_norm:" << GradientNorm() << "|g\n";
+    out << prefix << ".step_rate:" << StepRate() << "|g\n";
+  }
+
+  //! Get the number of steps taken.
+  size_t Steps() const { return steps.load(std::memory_order_relaxed); }
+  //! Get the number of passes over the data.
+  size_t Epochs() const { return epochs.load(std::memory_order_relaxed); }
+  //! Get the number of Evaluate() calls.
+  size_t Evaluations() const
+  { return evaluations.load(std::memory_order_relaxed); }
+  //! Get the number of Gradient() calls.
+  size_t GradientEvaluations() const
+  { return gradients.load(std::memory_order_relaxed); }
+  //! Get the last objective value.
+  double Objective() const { return objective.load(std::memory_order_relaxed); }
+  //! Get the norm of the last gradient.
+  double GradientNorm() const
+  { return gradientNorm.load(std::memory_order_relaxed); }
+
+  //! Get the number of steps per second in the current optimization.
+  double StepRate() const
+  {
+    const double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start.load()).count();
+    return (elapsed > 0) ?
+        optimizationSteps.load(std::memory_order_relaxed) / elapsed : 0.0;
+  }
+
+ private:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  //! Return the upper bound of the i-th bucket of the histogram in seconds.
+  static double BucketBound(const size_t i)
+  {
+    static const double bounds[NumBuckets] =
+        { 0.001, 0.01, 0.1, 1.0, 10.0, 60.0, 600.0, 3600.0 };
+    return bounds[i];
+  }
+
+  //! Add to an atomic double.
+  static void AtomicAdd(std::atomic<double>& value, const double increment)
+  {
+    double current = value.load(std::memory_order_relaxed);
+    while (!value.compare_exchange_weak(current, current + increment,
+        std::memory_order_relaxed)) { }
+  }
+
+  //! Push the metrics if the push interval has passed.
+  void MaybePush()
+  {
+    // Reading the clock is cheap, but not free, so it is only done once every
+    // 64 steps.
+    if ((steps.load(std::memory_order_relaxed) & 63) != 0)
+      return;
+
+    const auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastPush).count() >= pushInterval)
+      Push(now);
+  }
+
+  //! Push the metrics.
+  void Push(const TimePoint now)
+  {
+    lastPush = now;
+    std::ostringstream payload;
+    WriteStatsD(payload);
+    push(payload.str());
+  }
+
+  //! Write a counter in the OpenMetrics format.
+  void WriteCounter(std::ostream& out,
+                    const std::string& name,
+                    const std::string& help,
+                    const size_t value) const
+  {
+    out << "# HELP " << prefix << "_" << name << " " << help << std::endl;
+    out << "# TYPE " << prefix << "_" << name << " counter" << std::endl;
+    out << prefix << "_" << name << "_total " << value << std::endl;
+  }
+
+  //! Write a gauge in the OpenMetrics format.
+  void WriteGauge(std::ostream& out,
+                  const std::string& name,
+                  const std::string& help,
+                  const double value) const
+  {
+    out << "# HELP " << prefix << "_" << name << " " << help << std::endl;
+    out << "# TYPE " << prefix << "_" << name << " gauge" << std::endl;
+    out << prefix << "_" << name << " " << value << std::endl;
+  }
+
+  //! Write the increment of a counter in the StatsD format.
+  void WriteStatsDCounter(std::ostream& out,
+                          const std::string& name,
+                          const size_t value,
+                          size_t& pushed) const
+  {
+    out << prefix << "." << name << ":" << (value - pushed) << "|c\n";
+    pushed = value;
+  }
+
+  //! The prefix of the metric names.
+  std::string prefix;
+  //! The push function.
+  PushType push;
+  //! The minimum number of seconds between two pushes.
+  double pushInterval;
+
+  //! The number of steps.
+  std::atomic<size_t> steps;
+  //! The number of steps in the current optimization.
+  std::atomic<size_t> optimizationSteps;
+  //! The number of epochs.
+  std::atomic<size_t> epochs;
+  //! The number of Evaluate() calls.
+  std::atomic<size_t> evaluations;
+  //! The number of Gradient() calls.
+  std::atomic<size_t> gradients;
+  //! The last objective.
+  std::atomic<double> objective;
+  //! The last gradient norm.
+  std::atomic<double> gradientNorm;
+  //! The number of epochs in each bucket of the histogram.
+  std::atomic<size_t> buckets[NumBuckets];
+  //! The sum of the epoch durations.
+  std::atomic<double> epochDurationSum;
+  //! The number of epoch durations.
+  std::atomic<size_t> epochDurationCount;
+
+  //! The start of the current optimization.
+  std::atomic<TimePoint> start;
+  //! The start of the current epoch.
+  TimePoint epochStart;
+  //! The time of the last push.
+  TimePoint lastPush;
+
+  //! The counter values at the last StatsD export.
+  size_t pushedSteps;
+  size_t pushedEpochs;
+  size_t pushedEvaluations;
+  size_t pushedGradients;
+};
+
+} // namespace ens
+
+#endif
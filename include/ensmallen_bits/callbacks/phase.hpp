@@ -0,0 +1,55 @@
+/**
+ * @file phase.hpp
+ *
+ * The phases of an optimization that can be reported to callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_PHASE_HPP
+#define ENSMALLEN_CALLBACKS_PHASE_HPP
+
+namespace ens {
+
+/**
+ * The phases of an optimization that optimizers report to the BeginPhase() and
+ * EndPhase() callbacks.
+ */
+enum class Phase
+{
+  //! Evaluation of the objective and/or the gradient of the function.
+  Function,
+  //! Update of the coordinates by the update policy.
+  Update,
+  //! Update of the step size by the decay policy.
+  Decay,
+  //! Shuffling of the function between epochs.
+  Shuffle
+};
+
+//! The number of phases.
+constexpr size_t NumPhases = 4;
+
+//! Return a readable name for the given phase.
+inline const char* PhaseName(const Phase phase)
+{
+  switch (phase)
+  {
+    case Phase::Function:
+      return "function";
+    case Phase::Update:
+      return "update policy";
+    case Phase::Decay:
+      return "decay policy";
+    case Phase::Shuffle:
+      return "shuffle";
+  }
+
+  return "unknown";
+}
+
+} // namespace ens
+
+#endif
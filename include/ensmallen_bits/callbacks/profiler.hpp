@@ -0,0 +1,454 @@
+/**
+ * @file profiler.hpp
+ *
+ * Implementation of a callback that measures the time spent in each phase of
+ * an optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_PROFILER_HPP
+#define ENSMALLEN_CALLBACKS_PROFILER_HPP
+
+#include <ensmallen_bits/callbacks/phase.hpp>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+
+// Hardware counters are read with perf_event on Linux, if ENS_USE_PERF_EVENTS
+// is defined; otherwise only the timers are available.
+#if defined(ENS_USE_PERF_EVENTS) && defined(__linux__)
+  #include <cstring>
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+
+  #define ENS_HAVE_PERF_EVENT
+#endif
+
+namespace ens {
+
+/**
+ * The Profiler callback measures the cumulative wall clock time, CPU time and
+ * number of calls of each phase of an optimization (see Phase), as reported by
+ * the optimizer through the BeginPhase() and EndPhase() callbacks.  The time
+ * that is not spent in any phase (e.g. in the other callbacks, or in the
+ * bookkeeping of the optimizer) is reported as "other".  Currently SGD and all
+ * optimizers based on it report their phases; other optimizers only report the
+ * total time.
+ *
+ * If `hardwareCounters` is true and perf_event is available (on Linux, when
+ * ENS_USE_PERF_EVENTS is defined before including ensmallen), the CPU cycles,
+ * instructions and cache misses of the optimizing thread are counted as well.
+ * If the counters can't be opened (e.g. because of the perf_event_paranoid
+ * setting), or perf_event is not available, they are silently disabled.
+ *
+ * The CPU time is the time used by the whole process, so for phases that use
+ * several threads it can be larger than the wall clock time.
+ *
+ * The Profiler can be passed as an lvalue to inspect the results after the
+ * optimization:
+ *
+ * @code
+ * Profiler profiler(false);
+ * optimizer.Optimize(f, coordinates, profiler);
+ * std::cout << profiler.WallTime(Phase::Update) << std::endl;
+ * @endcode
+ */
+class Profiler
+{
+ public:
+  /**
+   * Set up the profiler.
+   *
+   * @param printReport Whether or not to print the results at the end of the
+   *     optimization.
+   * @param output Ostream which receives output from this object.
+   * @param hardwareCounters Whether or not to read the hardware counters.
+   */
+  Profiler(const bool printReport = true,
+           std::ostream& output = arma::get_cout_stream(),
+           const bool hardwareCounters = false) :
+      printReport(printReport),
+      output(output),
+      hardwareCounters(hardwareCounters),
+      totalWallTime(0),
+      totalCPUTime(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the begin of the optimization process.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    for (size_t i = 0; i < NumPhases; ++i)
+      phases[i] = PhaseStatistics();
+
+    if (hardwareCounters)
+      counters.Open();
+
+    totalWallTime = 0;
+    totalCPUTime = 0;
+    wallStart = std::chrono::steady_clock::now();
+    cpuStart = std::clock();
+  }
+
+  /**
+   * Callback function called at the end of the optimization process.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    totalWallTime = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    totalCPUTime = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    counters.Close();
+
+    if (printReport)
+      Print(output);
+  }
+
+  /**
+   * Callback function called before the optimizer enters a phase.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param phase The phase that begins.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginPhase(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const Phase phase)
+  {
+    PhaseStatistics& stats = phases[size_t(phase)];
+    counters.Read(stats.counterStart);
+    stats.cpuStart = std::clock();
+    stats.wallStart = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Callback function called after the optimizer leaves a phase.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param phase The phase that ends.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndPhase(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const Phase phase)
+  {
+    PhaseStatistics& stats = phases[size_t(phase)];
+    stats.wallTime += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - stats.wallStart).count();
+    stats.cpuTime += double(std::clock() - stats.cpuStart) / CLOCKS_PER_SEC;
+    ++stats.calls;
+
+    uint64_t counterEnd[NumCounters];
+    if (counters.Read(counterEnd))
+    {
+      for (size_t i = 0; i < NumCounters; ++i)
+        stats.counters[i] += counterEnd[i] - stats.counterStart[i];
+    }
+  }
+
+  /**
+   * Print the results of the last optimization.
+   *
+   * @param out The output stream.
+   */
+  void Print(std::ostream& out) const
+  {
+    std::streamsize streamPrecision = out.precision(4);
+
+    out << "Optimization Profile" << std::endl;
+    out << std::string(80, '-') << std::endl;
+    PrintElement(out, "phase", 16);
+    PrintElement(out, "calls");
+    PrintElement(out, "wall time");
+    PrintElement(out, "cpu time");
+    PrintElement(out, "% wall");
+    if (counters.Available())
+    {
+      PrintElement(out, "cycles");
+      PrintElement(out, "instr.");
+      PrintElement(out, "cache misses");
+    }
+    out << std::endl;
+
+    double phasesWallTime = 0;
+    double phasesCPUTime = 0;
+    for (size_t i = 0; i < NumPhases; ++i)
+    {
+      const PhaseStatistics& stats = phases[i];
+      phasesWallTime += stats.wallTime;
+      phasesCPUTime += stats.cpuTime;
+      if (stats.calls == 0)
+        continue;
+
+      PrintElement(out, PhaseName(Phase(i)), 16);
+      PrintElement(out, stats.calls);
+      PrintElement(out, stats.wallTime);
+      PrintElement(out, stats.cpuTime);
+      PrintElement(out, Percentage(stats.wallTime));
+      if (counters.Available())
+      {
+        for (size_t c = 0; c < NumCounters; ++c)
+          PrintElement(out, stats.counters[c]);
+      }
+      out << std::endl;
+    }
+
+    PrintElement(out, "other", 16);
+    PrintElement(out, "-");
+    PrintElement(out, std::max(0.0, totalWallTime - phasesWallTime));
+    PrintElement(out, std::max(0.0, totalCPUTime - phasesCPUTime));
+    PrintElement(out, Percentage(std::max(0.0,
+        totalWallTime - phasesWallTime)));
+    out << std::endl;
+
+    PrintElement(out, "total", 16);
+    PrintElement(out, "-");
+    PrintElement(out, totalWallTime);
+    PrintElement(out, totalCPUTime);
+    out << std::endl << std::string(80, '-') << std::endl;
+
+    out.precision(streamPrecision);
+  }
+
+  //! Get the number of calls of the given phase.
+  size_t Calls(const Phase phase) const { return phases[size_t(phase)].calls; }
+
+  //! Get the cumulative wall clock time of the given phase in seconds.
+  double WallTime(const Phase phase) const
+  { return phases[size_t(phase)].wallTime; }
+
+  //! Get the cumulative CPU time of the given phase in seconds.
+  double CPUTime(const Phase phase) const
+  { return phases[size_t(phase)].cpuTime; }
+
+  //! Get the number of CPU cycles of the given phase (0 without counters).
+  uint64_t Cycles(const Phase phase) const
+  { return phases[size_t(phase)].counters[0]; }
+
+  //! Get the number of instructions of the given phase (0 without counters).
+  uint64_t Instructions(const Phase phase) const
+  { return phases[size_t(phase)].counters[1]; }
+
+  //! Get the number of cache misses of the given phase (0 without counters).
+  uint64_t CacheMisses(const Phase phase) const
+  { return phases[size_t(phase)].counters[2]; }
+
+  //! Get the total wall clock time of the last optimization in seconds.
+  double TotalWallTime() const { return totalWallTime; }
+
+  //! Get the total CPU time of the last optimization in seconds.
+  double TotalCPUTime() const { return totalCPUTime; }
+
+ private:
+  //! The number of hardware counters.
+  static constexpr size_t NumCounters = 3;
+
+  //! The statistics of a single phase.
+  struct PhaseStatistics
+  {
+    PhaseStatistics() : calls(0), wallTime(0), cpuTime(0), cpuStart(0)
+    {
+      for (size_t i = 0; i < NumCounters; ++i)
+      {
+        counters[i] = 0;
+        counterStart[i] = 0;
+      }
+    }
+
+    //! The number of calls.
+    size_t calls;
+    //! The cumulative wall clock time.
+    double wallTime;
+    //! The cumulative CPU time.
+    double cpuTime;
+    //! The cumulative hardware counters.
+    uint64_t counters[NumCounters];
+    //! The wall clock time at the start of the current call.
+    std::chrono::steady_clock::time_point wallStart;
+    //! The CPU time at the start of the current call.
+    std::clock_t cpuStart;
+    //! The hardware counters at the start of the current call.
+    uint64_t counterStart[NumCounters];
+  };
+
+  /**
+   * A group of perf_event hardware counters (CPU cycles, instructions and cache
+   * misses) of the calling thread.  Copies don't own the counters.
+   */
+  class HardwareCounters
+  {
+   public:
+    HardwareCounters()
+    {
+      for (size_t i = 0; i < NumCounters; ++i)
+        fds[i] = -1;
+    }
+
+    HardwareCounters(const HardwareCounters& /* other */) :
+        HardwareCounters() { }
+
+    HardwareCounters& operator=(const HardwareCounters& /* other */)
+    {
+      Close();
+      return *this;
+    }
+
+    ~HardwareCounters() { Close(); }
+
+    //! Open and start the counters; on failure they stay unavailable.
+    void Open()
+    {
+      Close();
+      #ifdef ENS_HAVE_PERF_EVENT
+      const uint64_t configs[NumCounters] = { PERF_COUNT_HW_CPU_CYCLES,
+          PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES };
+      for (size_t i = 0; i < NumCounters; ++i)
+      {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = (i == 0) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1,
+            (i == 0) ? -1 : fds[0], 0);
+        if (fds[i] == -1)
+        {
+          Close();
+          return;
+        }
+      }
+
+      ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      #endif
+    }
+
+    //! Stop and close the counters.
+    void Close()
+    {
+      #ifdef ENS_HAVE_PERF_EVENT
+      for (size_t i = NumCounters; i > 0; --i)
+      {
+        if (fds[i - 1] != -1)
+          close(fds[i - 1]);
+      }
+      #endif
+
+      for (size_t i = 0; i < NumCounters; ++i)
+        fds[i] = -1;
+    }
+
+    //! Return whether the counters are open.
+    bool Available() const { return fds[0] != -1; }
+
+    //! Read the counters into `values`; return false if they are unavailable.
+    bool Read(uint64_t* values) const
+    {
+      if (!Available())
+        return false;
+
+      #ifdef ENS_HAVE_PERF_EVENT
+      // With PERF_FORMAT_GROUP, the number of counters precedes the values.
+      uint64_t buffer[NumCounters + 1];
+      if (read(fds[0], buffer, sizeof(buffer)) != (ssize_t) sizeof(buffer))
+        return false;
+
+      for (size_t i = 0; i < NumCounters; ++i)
+        values[i] = buffer[i + 1];
+      return true;
+      #else
+      (void) values;
+      return false;
+      #endif
+    }
+
+   private:
+    //! The file descriptors of the counters; the first is the group leader.
+    int fds[NumCounters];
+  };
+
+  //! Return the given time as a percentage of the total wall clock time.
+  double Percentage(const double time) const
+  {
+    return (totalWallTime > 0) ? 100.0 * time / totalWallTime : 0.0;
+  }
+
+  /**
+   * Output formatted data.
+   *
+   * @param out Output stream.
+   * @param data The data to print on the given stream.
+   * @param width The width of the the formatted output data.
+   */
+  template<typename T>
+  static void PrintElement(std::ostream& out,
+                           const T& data,
+                           const size_t width = 14)
+  {
+    out << std::left << std::setw(width) << std::setfill(' ')
+        << std::setprecision(3) << data;
+  }
+
+  //! Whether or not to print the results at the end of the optimization.
+  bool printReport;
+
+  //! The output stream that all data is to be sent to; example: std::cout.
+  std::ostream& output;
+
+  //! Whether or not to read the hardware counters.
+  bool hardwareCounters;
+
+  //! The statistics of each phase.
+  PhaseStatistics phases[NumPhases];
+
+  //! The hardware counters.
+  HardwareCounters counters;
+
+  //! The total wall clock time of the last optimization.
+  double totalWallTime;
+
+  //! The total CPU time of the last optimization.
+  double totalCPUTime;
+
+  //! The wall clock time at the start of the optimization.
+  std::chrono::steady_clock::time_point wallStart;
+
+  //! The CPU time at the start of the optimization.
+  std::clock_t cpuStart;
+};
+
+} // namespace ens
+
+#endif
@@ -19,6 +19,15 @@ namespace ens {
 
 /**
  * A simple optimization report.
+ *
+ * By default the objective, the gradient norm, the step size and the time of
+ * every step are stored until the end of the optimization.  For very long
+ * runs, the number of stored steps can be bounded with `maxStoredSteps`: once
+ * the history is full, every other stored step is dropped and only every
+ * second step is stored from then on, so the history is always evenly spaced
+ * over the whole run and starts at the first step.  The summary values (final
+ * loss, number of iterations, maximum gradient norm, ...) are kept as running
+ * values, so the report has the same shape in both cases.
  */
 class Report
 {
@@ -31,13 +40,23 @@ class Report
    * @param outputIn Ostream which receives output from this object.
    * @param outputMatrixSizeIn The number of values to output for the function
    *     coordinates.
+   * @param maxStoredStepsIn The maximum number of steps to store for the
+   *     report (0 stores every step; otherwise at least 2).
    */
   Report(const double iterationsPercentageIn = 0.1,
          std::ostream& outputIn = arma::get_cout_stream(),
-         const size_t outputMatrixSizeIn = 4) :
+         const size_t outputMatrixSizeIn = 4,
+         const size_t maxStoredStepsIn = 0) :
       iterationsPercentage(iterationsPercentageIn),
       output(outputIn),
       outputMatrixSize(outputMatrixSizeIn),
+      maxStoredSteps(maxStoredStepsIn == 1 ? 2 : maxStoredStepsIn),
+      stride(1),
+      steps(0),
+      lastObjective(0),
+      lastTiming(0),
+      lastStepSize(0),
+      maxGradientNorm(0),
       objective(0),
       gradientNorm(0),
       hasGradient(false),
@@ -114,7 +133,7 @@ class Report
 
     for (size_t i = 0; i < objectives.size(); i += iterationStep)
     {
-      PrettyPrintElement(i);
+      PrettyPrintElement(i * stride);
       PrettyPrintElement(objectives[i]);
       PrettyPrintElement(
           i > 0 ? objectives[i - iterationStep] - objectives[i] : 0);
@@ -151,11 +170,12 @@ class Report
 
     // If we did not take any steps, at least fill what the initial objective
     // was.
-    const bool tookStep = (objectives.size() > 0);
-    if (objectives.size() == 0 && evaluateCalls > 0)
+    const bool tookStep = (steps > 0);
+    if (steps == 0 && evaluateCalls > 0)
     {
       objectives.push_back(objective);
-      timings.push_back(optimizationTimer.toc());
+      lastObjective = objective;
+      lastTiming = optimizationTimer.toc();
     }
     else if (evaluateCalls == 0)
     {
@@ -173,9 +193,9 @@ class Report
     PrettyPrintElement("Initial", 30);
     output << objectives[0] << std::endl;
     PrettyPrintElement("Final", 30);
-    output << objectives[objectives.size() - 1] << std::endl;
+    output << lastObjective << std::endl;
     PrettyPrintElement("Change", 30);
-    output << objectives[0] - objectives[objectives.size() - 1] << std::endl;
+    output << objectives[0] - lastObjective << std::endl;
 
     output << std::endl << "Optimizer:" << std::endl;
     std::stringstream optimizerStream;
@@ -187,7 +207,7 @@ class Report
 
     PrettyPrintElement("Iterations:", 30);
     if (tookStep)
-      output << objectives.size() << std::endl;
+      output << steps << std::endl;
     else
       output << "0 (No steps taken! Did the optimization fail?)" << std::endl;
 
@@ -203,14 +223,13 @@ class Report
       output << stepsizes.front() << std::endl;
 
       PrettyPrintElement("Final step size:", 30);
-      output << stepsizes.back() << std::endl;
+      output << lastStepSize << std::endl;
     }
 
     if (hasGradient && gradientsNorm.size() > 0)
     {
       PrettyPrintElement("Coordinates max. norm:", 30);
-      output << *std::max_element(std::begin(gradientsNorm),
-          std::end(gradientsNorm)) << std::endl;
+      output << maxGradientNorm << std::endl;
     }
 
     PrettyPrintElement("Evaluate calls:", 30);
@@ -223,7 +242,7 @@ class Report
     }
 
     PrettyPrintElement("Time (in seconds):", 30);
-    output << timings[timings.size() - 1] << std::endl;
+    output << lastTiming << std::endl;
 
     // Restore precision.
     output.precision(streamPrecision);
@@ -273,15 +292,12 @@ class Report
       timings.clear();
       gradientsNorm.clear();
       stepsizes.clear();
+      stride = 1;
+      steps = 0;
+      maxGradientNorm = 0;
     }
 
-    objectives.push_back(objective);
-    timings.push_back(optimizationTimer.toc());
-
-    if (hasGradient)
-      gradientsNorm.push_back(gradientNorm);
-
-    SaveStepSize(optimizer);
+    SaveStep(optimizer, objective);
   }
 
   /**
@@ -298,15 +314,7 @@ class Report
                  const MatType& /* coordinates */)
   {
     if (!hasEndEpoch)
-    {
-      objectives.push_back(objective);
-      timings.push_back(optimizationTimer.toc());
-
-      if (hasGradient)
-        gradientsNorm.push_back(gradientNorm);
-
-      SaveStepSize(optimizer);
-    }
+      SaveStep(optimizer, objective);
   }
 
   /**
@@ -425,7 +433,7 @@ class Report
     stream << optimizer.MaxIterations() << std::endl;
 
     PrettyPrintElement(stream, "Reached maximum iterations:", 30);
-    stream << std::string(optimizer.MaxIterations() == objectives.size() ?
+    stream << std::string(optimizer.MaxIterations() == steps ?
         "true" : "false") << std::endl;
   }
 
@@ -542,23 +550,78 @@ class Report
     }
   }
 
+  /**
+   * Helper function to record a step.  The running values are always updated,
+   * but the step is only stored if it falls on the current stride; if that
+   * fills the history, it is decimated.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param objectiveIn Objective value of the current point.
+   */
+  template<typename OptimizerType>
+  void SaveStep(const OptimizerType& optimizer, const double objectiveIn)
+  {
+    const bool store = (steps % stride == 0);
+
+    lastObjective = objectiveIn;
+    lastTiming = optimizationTimer.toc();
+    if (hasGradient)
+      maxGradientNorm = std::max(maxGradientNorm, gradientNorm);
+    SaveStepSize(optimizer, store);
+
+    if (store)
+    {
+      objectives.push_back(lastObjective);
+      timings.push_back(lastTiming);
+
+      if (hasGradient)
+        gradientsNorm.push_back(gradientNorm);
+
+      if (maxStoredSteps > 0 && objectives.size() >= maxStoredSteps)
+      {
+        Decimate(objectives);
+        Decimate(timings);
+        Decimate(gradientsNorm);
+        Decimate(stepsizes);
+        stride *= 2;
+      }
+    }
+
+    ++steps;
+  }
+
+  /**
+   * Keep only the stored values with an even index.
+   *
+   * @param values The stored values.
+   */
+  static void Decimate(std::vector<double>& values)
+  {
+    for (size_t i = 0; 2 * i < values.size(); ++i)
+      values[i] = values[2 * i];
+    values.resize((values.size() + 1) / 2);
+  }
+
   /**
    * Helper function to store the step-size.
    *
    * @param optimizer The instantiated optimzer that implements StepSize().
+   * @param store Whether or not to add the step-size to the history.
    */
   template<typename OptimizerType>
   typename std::enable_if<traits::HasStepSizeSignature<OptimizerType>::value,
       void>::type
-  SaveStepSize(const OptimizerType& optimizer)
+  SaveStepSize(const OptimizerType& optimizer, const bool store)
   {
-    stepsizes.push_back(optimizer.StepSize());
+    lastStepSize = optimizer.StepSize();
+    if (store)
+      stepsizes.push_back(lastStepSize);
   }
 
   template<typename OptimizerType>
   typename std::enable_if<!traits::HasStepSizeSignature<OptimizerType>::value,
       void>::type
-  SaveStepSize(const OptimizerType& /* optimizer */) { }
+  SaveStepSize(const OptimizerType& /* optimizer */, const bool /* store */) { }
 
   //! The number of iterations to print in percent.
   double iterationsPercentage;
@@ -568,6 +631,28 @@ class Report
 
   //! The number of values to print for the function coordinates.
   size_t outputMatrixSize;
+
+  //! The maximum number of stored steps (0 for no limit).
+  size_t maxStoredSteps;
+
+  //! The number of steps between two stored steps.
+  size_t stride;
+
+  //! The number of steps taken.
+  size_t steps;
+
+  //! The objective of the last step.
+  double lastObjective;
+
+  //! The time of the last step.
+  double lastTiming;
+
+  //! The step-size of the last step.
+  double lastStepSize;
+
+  //! The largest gradient norm of all steps.
+  double maxGradientNorm;
+
   //! The initial coordinates.
   arma::mat initialCoordinates;
 
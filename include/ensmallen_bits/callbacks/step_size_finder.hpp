@@ -0,0 +1,407 @@
+/**
+ * @file step_size_finder.hpp
+ *
+ * Implementation of a callback that sweeps the step size of an optimizer over
+ * a few batches to find a good step size, and of a helper that optimizes with
+ * the found step size and rolls back on divergence.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_STEP_SIZE_FINDER_HPP
+#define ENSMALLEN_CALLBACKS_STEP_SIZE_FINDER_HPP
+
+#include <ensmallen_bits/callbacks/checkpoint.hpp>
+#include <sstream>
+
+namespace ens {
+
+/**
+ * The StepSizeFinder callback runs a step size range test: the step size of
+ * the optimizer (set with its StepSize() method, as for SGD and the optimizers
+ * based on it) is increased exponentially from `minStepSize` to `maxStepSize`
+ * over `steps` steps, and the objective of each batch is recorded against the
+ * step size of the step before it.  The objectives are smoothed with an
+ * exponential moving average, and the sweep is stopped once the smoothed
+ * objective exceeds `divergence` times its minimum.  The chosen step size,
+ * available with StepSize(), is the step size with the lowest smoothed
+ * objective divided by `divisor`, since the minimum is usually close to the
+ * edge of divergence.
+ *
+ * The sweep changes the coordinates, so Find() runs it on copies of the
+ * optimizer and of the coordinates, and sets the step size of the optimizer:
+ *
+ * @code
+ * Adam adam;
+ * StepSizeFinder finder;
+ * finder.Find(adam, f, coordinates);
+ * adam.Optimize(f, coordinates);
+ * @endcode
+ *
+ * Optimize() also finds the step size, then runs the optimization one epoch at
+ * a time.  After each epoch, a snapshot of the coordinates and of the state of
+ * the optimizer is kept in memory with Checkpoint::Save(); if the objective of
+ * an epoch is not finite or exceeds `divergence` times the best objective of
+ * an epoch so far, the snapshot at the beginning of the last accepted epoch is
+ * restored and the step size is multiplied by `backoff`, at most
+ * MaxRollbacks() times.  Since the divergence tests are ratios, the objective
+ * should be positive.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @inproceedings{smith2017,
+ *   author    = {Smith, Leslie N.},
+ *   title     = {Cyclical Learning Rates for Training Neural Networks},
+ *   booktitle = {2017 IEEE Winter Conference on Applications of Computer
+ *                Vision (WACV)},
+ *   pages     = {464--472},
+ *   year      = {2017}
+ * }
+ * @endcode
+ */
+class StepSizeFinder
+{
+ public:
+  /**
+   * Set up the step size finder.
+   *
+   * @param minStepSize The first step size of the sweep.
+   * @param maxStepSize The last step size of the sweep.
+   * @param steps The number of steps of the sweep.
+   * @param divergence The ratio of an objective to the best objective above
+   *     which the optimization has diverged.
+   * @param backoff The factor that the step size is multiplied by when
+   *     Optimize() rolls back.
+   */
+  StepSizeFinder(const double minStepSize = 1e-6,
+                 const double maxStepSize = 10.0,
+                 const size_t steps = 100,
+                 const double divergence = 4.0,
+                 const double backoff = 0.5) :
+      minStepSize(minStepSize),
+      maxStepSize(maxStepSize),
+      steps(std::max(steps, (size_t) 2)),
+      divergence(divergence),
+      backoff(backoff),
+      divisor(10.0),
+      smoothing(0.98),
+      maxRollbacks(10),
+      step(0),
+      finished(false),
+      average(0.0),
+      bestObjective(0.0),
+      bestStepSize(minStepSize),
+      rollbacks(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the begin of the optimization process; the
+   * sweep is started.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& optimizer,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    step = 0;
+    finished = false;
+    average = 0.0;
+    bestObjective = std::numeric_limits<double>::infinity();
+    bestStepSize = minStepSize;
+    optimizer.StepSize() = minStepSize;
+  }
+
+  /**
+   * Callback function called at any call to Evaluate(); the objective is
+   * recorded, and the step size of the next step is set.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param objective Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double objective)
+  {
+    if (finished)
+      return;
+
+    // The objective is the result of the step taken with the previous step
+    // size.
+    if (step > 0)
+    {
+      average = smoothing * average + (1.0 - smoothing) * objective;
+      const double smoothed = average / (1.0 - std::pow(smoothing,
+          (double) step));
+      if (!std::isfinite(smoothed) || smoothed > divergence * bestObjective)
+      {
+        finished = true;
+        return;
+      }
+
+      if (smoothed < bestObjective)
+      {
+        bestObjective = smoothed;
+        bestStepSize = SweepStepSize(step - 1);
+      }
+    }
+
+    if (step == steps)
+    {
+      finished = true;
+      return;
+    }
+
+    optimizer.StepSize() = SweepStepSize(step++);
+  }
+
+  /**
+   * Callback function called once a step is taken; the optimization is
+   * terminated at the end of the sweep.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    return finished;
+  }
+
+  /**
+   * Run the sweep on copies of the optimizer and of the coordinates, and set
+   * the step size of the optimizer to the chosen step size.
+   *
+   * @param optimizer The optimizer.
+   * @param function Function to optimize.
+   * @param coordinates Starting point of the sweep.
+   * @return The chosen step size.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  double Find(OptimizerType& optimizer,
+              FunctionType& function,
+              const MatType& coordinates)
+  {
+    // One more batch is evaluated to see the result of the last step.
+    OptimizerType sweep(optimizer);
+    sweep.MaxIterations() = (steps + 1) * sweep.BatchSize();
+    sweep.Tolerance() = -1.0;
+    MatType sweepCoordinates(coordinates);
+    sweep.Optimize(function, sweepCoordinates, *this);
+
+    optimizer.StepSize() = StepSize();
+    return StepSize();
+  }
+
+  /**
+   * Find the step size, then optimize one epoch at a time, and roll back to
+   * the last snapshot (with a smaller step size) if an epoch diverges.  The
+   * callbacks are given to the optimizer for each epoch.
+   *
+   * @param optimizer The optimizer.
+   * @param function Function to optimize.
+   * @param coordinates Starting point; the final coordinates are stored here.
+   * @param callbacks Callback functions.
+   * @return The objective of the last accepted epoch.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  double Optimize(OptimizerType& optimizer,
+                  FunctionType& function,
+                  MatType& coordinates,
+                  CallbackTypes&&... callbacks)
+  {
+    Find(optimizer, function, coordinates);
+
+    const size_t numFunctions = function.NumFunctions();
+    const size_t maxIterations = optimizer.MaxIterations();
+    const bool resetPolicy = optimizer.ResetPolicy();
+
+    // The objective of an epoch is the sum of the objectives of its batches,
+    // each taken before its step, so it validates the state at the beginning
+    // of the epoch but not the last step.  So, a rollback restores the state
+    // at the beginning of the last accepted epoch.  An empty snapshot stands
+    // for the starting point, from which the optimizer starts over.
+    std::string validated, pending;
+    const MatType initialCoordinates(coordinates);
+    bool fresh = true;
+
+    EpochObjective epochObjective;
+    double best = std::numeric_limits<double>::infinity();
+    double last = std::numeric_limits<double>::infinity();
+    rollbacks = 0;
+    size_t iterations = 0;
+    while (maxIterations == 0 || iterations < maxIterations)
+    {
+      const size_t epochIterations = (maxIterations == 0) ? numFunctions :
+          std::min(numFunctions, maxIterations - iterations);
+      optimizer.MaxIterations() = epochIterations;
+      optimizer.ResetPolicy() = fresh && (resetPolicy || rollbacks > 0);
+      epochObjective.objective = std::numeric_limits<double>::quiet_NaN();
+      optimizer.Optimize(function, coordinates, epochObjective, callbacks...);
+      iterations += epochIterations;
+
+      // A partial last epoch is kept as it is.
+      const double objective = epochObjective.objective;
+      if (epochIterations < numFunctions)
+        break;
+
+      if (!std::isfinite(objective) || objective > divergence * best)
+      {
+        if (++rollbacks > maxRollbacks)
+          break;
+
+        const double stepSize = optimizer.StepSize() * backoff;
+        if (validated.empty())
+        {
+          coordinates = initialCoordinates;
+          fresh = true;
+        }
+        else
+        {
+          std::istringstream stream(validated);
+          Checkpoint::Load(stream, optimizer, coordinates);
+        }
+        optimizer.StepSize() = stepSize;
+        pending = validated;
+        continue;
+      }
+
+      std::ostringstream stream;
+      Checkpoint::Save(stream, optimizer, coordinates);
+      validated.swap(pending);
+      pending = stream.str();
+      fresh = false;
+
+      best = std::min(best, objective);
+      const bool converged = (std::abs(last - objective) * numFunctions <
+          optimizer.Tolerance());
+      last = objective;
+      if (converged)
+        break;
+    }
+
+    optimizer.MaxIterations() = maxIterations;
+    optimizer.ResetPolicy() = resetPolicy;
+    return last * numFunctions;
+  }
+
+  //! Get the chosen step size of the last sweep.
+  double StepSize() const { return bestStepSize / divisor; }
+
+  //! Get the number of rollbacks of the last call to Optimize().
+  size_t Rollbacks() const { return rollbacks; }
+
+  //! Get the first step size of the sweep.
+  double MinStepSize() const { return minStepSize; }
+  //! Modify the first step size of the sweep.
+  double& MinStepSize() { return minStepSize; }
+
+  //! Get the last step size of the sweep.
+  double MaxStepSize() const { return maxStepSize; }
+  //! Modify the last step size of the sweep.
+  double& MaxStepSize() { return maxStepSize; }
+
+  //! Get the number of steps of the sweep.
+  size_t Steps() const { return steps; }
+  //! Modify the number of steps of the sweep.
+  size_t& Steps() { return steps; }
+
+  //! Get the divergence ratio.
+  double Divergence() const { return divergence; }
+  //! Modify the divergence ratio.
+  double& Divergence() { return divergence; }
+
+  //! Get the step size factor of a rollback.
+  double Backoff() const { return backoff; }
+  //! Modify the step size factor of a rollback.
+  double& Backoff() { return backoff; }
+
+  //! Get the divisor of the step size with the lowest objective.
+  double Divisor() const { return divisor; }
+  //! Modify the divisor of the step size with the lowest objective.
+  double& Divisor() { return divisor; }
+
+  //! Get the smoothing factor of the objectives.
+  double Smoothing() const { return smoothing; }
+  //! Modify the smoothing factor of the objectives.
+  double& Smoothing() { return smoothing; }
+
+  //! Get the maximum number of rollbacks of Optimize().
+  size_t MaxRollbacks() const { return maxRollbacks; }
+  //! Modify the maximum number of rollbacks of Optimize().
+  size_t& MaxRollbacks() { return maxRollbacks; }
+
+ private:
+  //! Keep the objective of the last epoch.
+  struct EpochObjective
+  {
+    template<typename OptimizerType, typename FunctionType, typename MatType>
+    void EndEpoch(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t /* epoch */,
+                  const double epochObjective)
+    {
+      objective = epochObjective;
+    }
+
+    //! The objective of the last epoch.
+    double objective;
+  };
+
+  //! Return the step size of the given step of the sweep.
+  double SweepStepSize(const size_t k) const
+  {
+    return minStepSize * std::pow(maxStepSize / minStepSize,
+        (double) k / (steps - 1));
+  }
+
+  //! The first step size of the sweep.
+  double minStepSize;
+  //! The last step size of the sweep.
+  double maxStepSize;
+  //! The number of steps of the sweep.
+  size_t steps;
+  //! The divergence ratio.
+  double divergence;
+  //! The step size factor of a rollback.
+  double backoff;
+  //! The divisor of the step size with the lowest objective.
+  double divisor;
+  //! The smoothing factor of the objectives.
+  double smoothing;
+  //! The maximum number of rollbacks of Optimize().
+  size_t maxRollbacks;
+  //! The current step of the sweep.
+  size_t step;
+  //! Whether the sweep is over.
+  bool finished;
+  //! The moving average of the objectives.
+  double average;
+  //! The lowest smoothed objective.
+  double bestObjective;
+  //! The step size with the lowest smoothed objective.
+  double bestStepSize;
+  //! The number of rollbacks of the last call to Optimize().
+  size_t rollbacks;
+};
+
+} // namespace ens
+
+#endif
@@ -17,6 +17,13 @@ namespace ens {
 /**
  * Store best coordinates function, based on the Evaluate callback function.
  *
+ * Every improvement of the objective copies the coordinates, which can be
+ * expensive for large models early in the optimization, when nearly every step
+ * improves the objective.  To reduce this cost, only every
+ * `evaluationInterval`-th call to Evaluate() can be considered.  In addition,
+ * large dense coordinates are copied into the already allocated buffer in
+ * chunks, in parallel when OpenMP is enabled.
+ *
  * @tparam MatType Type of the model coordinates (arma::colvec, arma::mat,
  *     arma::sp_mat or arma::cube).
  */
@@ -27,8 +34,14 @@ class StoreBestCoordinates
   /**
    * Set up the store best model class, which keeps the best-performing
    * coordinates and objective.
+   *
+   * @param evaluationInterval Only consider every evaluationInterval-th call to
+   *     Evaluate() (1 considers every call).
    */
-  StoreBestCoordinates() : bestObjective(std::numeric_limits<double>::max())
+  StoreBestCoordinates(const size_t evaluationInterval = 1) :
+      evaluationInterval(evaluationInterval == 0 ? 1 : evaluationInterval),
+      evaluations(0),
+      bestObjective(std::numeric_limits<double>::max())
   { /* Nothing to do here. */ }
 
   /**
@@ -45,10 +58,13 @@ class StoreBestCoordinates
                 const MatType& coordinates,
                 const double objective)
   {
+    if (++evaluations % evaluationInterval != 0)
+      return;
+
     if (objective < bestObjective)
     {
       bestObjective = objective;
-      bestCoordinates = coordinates;
+      Copy(coordinates);
     }
   }
 
@@ -57,12 +73,65 @@ class StoreBestCoordinates
   //! Modify the best coordinates.
   ModelMatType& BestCoordinates() { return bestCoordinates; }
 
+  //! Get the number of calls to Evaluate() between two checks.
+  size_t EvaluationInterval() const { return evaluationInterval; }
+  //! Modify the number of calls to Evaluate() between two checks.
+  size_t& EvaluationInterval() { return evaluationInterval; }
+
   //! Get the best objective.
   double const& BestObjective() const { return bestObjective; }
   //! Modify the best objective.
   double& BestObjective() { return bestObjective; }
 
  private:
+  //! Dense coordinates of the same type are copied chunk by chunk.
+  template<typename MatType>
+  typename std::enable_if<std::is_same<MatType, ModelMatType>::value &&
+      arma::is_Mat<MatType>::value>::type
+  Copy(const MatType& coordinates)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    // Below this size the copy isn't worth distributing.
+    const size_t chunkSize = 1 << 16;
+    const size_t n = coordinates.n_elem;
+    if (n <= chunkSize)
+    {
+      bestCoordinates = coordinates;
+      return;
+    }
+
+    // This does not reallocate if the size did not change.
+    bestCoordinates.set_size(coordinates.n_rows, coordinates.n_cols);
+
+    const ElemType* source = coordinates.memptr();
+    ElemType* destination = bestCoordinates.memptr();
+    const size_t chunks = (n + chunkSize - 1) / chunkSize;
+
+    ParallelFor(chunks, [&](const size_t i)
+    {
+      const size_t begin = (size_t) i * chunkSize;
+      const size_t end = std::min(n, begin + chunkSize);
+      std::memcpy(destination + begin, source + begin,
+          sizeof(ElemType) * (end - begin));
+    });
+  }
+
+  //! Any other type is assigned.
+  template<typename MatType>
+  typename std::enable_if<!(std::is_same<MatType, ModelMatType>::value &&
+      arma::is_Mat<MatType>::value)>::type
+  Copy(const MatType& coordinates)
+  {
+    bestCoordinates = coordinates;
+  }
+
+  //! The number of calls to Evaluate() between two checks.
+  size_t evaluationInterval;
+
+  //! The number of calls to Evaluate() so far.
+  size_t evaluations;
+
   //! Locally-stored best objective.
   double bestObjective;
 
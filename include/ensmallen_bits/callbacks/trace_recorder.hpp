@@ -0,0 +1,526 @@
+/**
+ * @file trace_recorder.hpp
+ *
+ * Implementation of a callback that records the progress of an optimization
+ * into a columnar binary file.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_TRACE_RECORDER_HPP
+#define ENSMALLEN_CALLBACKS_TRACE_RECORDER_HPP
+
+#include <fstream>
+#include <deque>
+
+namespace ens {
+
+/**
+ * The TraceRecorder callback records one row for every `stepInterval`'th step
+ * and for every epoch of an optimization into a binary file, so that runs can
+ * be compared without producing and parsing the text output of PrintLoss or
+ * Report.  Each row has the columns
+ *
+ *  - Kind: the kind of event (TraceRecorder::StepEvent or EpochEvent),
+ *  - Index: the number of the step (starting at 1), or the epoch,
+ *  - Time: the wall clock time since the beginning of the optimization, in
+ *    seconds,
+ *  - Objective: the objective of the epoch, or the last objective passed to
+ *    Evaluate() for a step (NaN if there was none),
+ *  - GradientNorm: the Frobenius norm of the last gradient of a recorded step
+ *    (NaN if there was none),
+ *  - StepSize: the step size of the optimizer, if it has a StepSize() method
+ *    (NaN otherwise),
+ *  - Evaluations, Gradients: the number of Evaluate() and Gradient() calls so
+ *    far.
+ *
+ * The rows are collected into blocks of `blockRows` rows in memory, and each
+ * full block is handed to a background thread that writes it, so the
+ * optimizing thread only stores eight values per recorded row; the gradient
+ * norm is only computed for the steps that are recorded.  The file is written
+ * when the optimization begins and completed when it ends; a
+ * std::runtime_error is thrown if it can't be written.
+ *
+ * The file starts with the 8 characters "ENSTRACE", the format version (1) and
+ * the number of columns (8) as uint64_t.  Then each block is stored as its
+ * number of rows n (a uint64_t), followed by the n values of each column in
+ * the order above, as doubles.  The byte order is the one of the machine that
+ * wrote the file.  Load() reads a file into a matrix with one row per event;
+ * other tools can read each block with two reads, e.g. in numpy:
+ *
+ * @code
+ * n = numpy.fromfile(f, numpy.uint64, 1)[0]
+ * block = numpy.fromfile(f, numpy.float64, 8 * n).reshape(8, n)
+ * @endcode
+ *
+ * @code
+ * optimizer.Optimize(f, coordinates, TraceRecorder("trace.bin", 100));
+ * arma::mat trace;
+ * TraceRecorder::Load("trace.bin", trace);
+ * // The rows of the epochs.
+ * arma::mat epochs = trace.rows(arma::find(trace.col(TraceRecorder::Kind) ==
+ *     double(TraceRecorder::EpochEvent)));
+ * @endcode
+ */
+class TraceRecorder
+{
+ public:
+  //! The columns of a trace.
+  enum Column
+  {
+    Kind = 0,
+    Index,
+    Time,
+    Objective,
+    GradientNorm,
+    StepSize,
+    Evaluations,
+    Gradients
+  };
+
+  //! The kinds of recorded events.
+  enum EventKind
+  {
+    StepEvent = 0,
+    EpochEvent = 1
+  };
+
+  //! The number of columns of a trace.
+  static constexpr size_t NumColumns = 8;
+
+  /**
+   * Set up the trace recorder.
+   *
+   * @param filename The file to write the trace to.
+   * @param stepInterval The number of steps between two recorded steps (0
+   *     records only the epochs).
+   * @param blockRows The number of rows of each block that is written.
+   */
+  TraceRecorder(const std::string& filename,
+                const size_t stepInterval = 1,
+                const size_t blockRows = 65536) :
+      filename(filename),
+      stepInterval(stepInterval),
+      blockRows(std::max(blockRows, (size_t) 1)),
+      steps(0),
+      evaluations(0),
+      gradients(0),
+      objective(std::numeric_limits<double>::quiet_NaN()),
+      gradientNorm(std::numeric_limits<double>::quiet_NaN()),
+      rows(0),
+      blockFill(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the begin of the optimization process; the
+   * file is created.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    writer.reset();
+    writer.reset(new Writer(filename));
+
+    steps = 0;
+    evaluations = 0;
+    gradients = 0;
+    objective = std::numeric_limits<double>::quiet_NaN();
+    gradientNorm = std::numeric_limits<double>::quiet_NaN();
+    rows = 0;
+    blockFill = 0;
+    block = writer->Acquire(blockRows);
+    start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Callback function called at the end of the optimization process; the
+   * remaining rows are written, and the file is closed.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& /* optimizer */,
+                       FunctionType& /* function */,
+                       MatType& /* coordinates */)
+  {
+    if (!writer)
+      return;
+
+    if (blockFill > 0)
+      writer->Submit(block, blockFill, blockRows);
+    blockFill = 0;
+
+    const bool written = writer->Finish();
+    writer.reset();
+    if (!written)
+    {
+      throw std::runtime_error("TraceRecorder: cannot write to '" + filename +
+          "'.");
+    }
+  }
+
+  /**
+   * Callback function called at any call to Evaluate().
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param objectiveIn Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Evaluate(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const double objectiveIn)
+  {
+    ++evaluations;
+    objective = objectiveIn;
+  }
+
+  /**
+   * Callback function called at any call to Gradient(); the norm of the
+   * gradient is only computed if the current step is recorded.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param gradient Matrix that holds the gradient.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const MatType& gradient)
+  {
+    ++gradients;
+    if (stepInterval != 0 && (steps + 1) % stepInterval == 0)
+      gradientNorm = arma::norm(gradient, "fro");
+  }
+
+  /**
+   * Callback function called after any step is taken; the step is recorded if
+   * it is due.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& optimizer,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    ++steps;
+    if (stepInterval != 0 && steps % stepInterval == 0)
+      Record(StepEvent, steps, objective, GetStepSize(optimizer));
+  }
+
+  /**
+   * Callback function called at the end of a pass over the data; the epoch is
+   * recorded.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The current function parameter.
+   * @param epoch The index of the current epoch.
+   * @param objectiveIn Objective value of the current point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& optimizer,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t epoch,
+                const double objectiveIn)
+  {
+    Record(EpochEvent, epoch, objectiveIn, GetStepSize(optimizer));
+  }
+
+  /**
+   * Load a trace from the given file into a matrix with one row per recorded
+   * event and one column per Column.  A std::runtime_error is thrown if the
+   * file can't be read or isn't a trace.
+   *
+   * @param filename The file to read.
+   * @param trace The matrix to store the trace into.
+   */
+  static void Load(const std::string& filename, arma::mat& trace)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    char magic[8];
+    uint64_t version = 0, columns = 0;
+    stream.read(magic, 8);
+    stream.read((char*) &version, sizeof(version));
+    stream.read((char*) &columns, sizeof(columns));
+    if (!stream || std::string(magic, 8) != "ENSTRACE" || version != 1 ||
+        columns != NumColumns)
+    {
+      throw std::runtime_error("TraceRecorder::Load(): cannot read a trace "
+          "from '" + filename + "'.");
+    }
+
+    std::vector<arma::mat> blocks;
+    size_t totalRows = 0;
+    uint64_t n;
+    while (stream.read((char*) &n, sizeof(n)))
+    {
+      arma::mat values(n, NumColumns);
+      if (!stream.read((char*) values.memptr(), sizeof(double) * n *
+          NumColumns))
+      {
+        throw std::runtime_error("TraceRecorder::Load(): the trace in '" +
+            filename + "' is truncated.");
+      }
+
+      totalRows += n;
+      blocks.push_back(std::move(values));
+    }
+
+    trace.set_size(totalRows, NumColumns);
+    size_t row = 0;
+    for (size_t b = 0; b < blocks.size(); ++b)
+    {
+      if (blocks[b].n_rows == 0)
+        continue;
+
+      trace.rows(row, row + blocks[b].n_rows - 1) = blocks[b];
+      row += blocks[b].n_rows;
+    }
+  }
+
+  //! Get the file the trace is written to.
+  const std::string& Filename() const { return filename; }
+
+  //! Get the number of steps between two recorded steps.
+  size_t StepInterval() const { return stepInterval; }
+
+  //! Get the number of rows of each block.
+  size_t BlockRows() const { return blockRows; }
+
+  //! Get the number of rows recorded in the last optimization.
+  size_t Rows() const { return rows; }
+
+ private:
+  /**
+   * Writer writes the blocks of a trace to its file on a background thread.
+   * The filled blocks are queued under a lock, and the written blocks are
+   * kept for reuse, so that no memory is allocated once the first blocks are
+   * written.
+   */
+  class Writer
+  {
+   public:
+    //! Create the file, write the header, and start the background thread.
+    Writer(const std::string& filename) :
+        stream(filename.c_str(), std::ios::binary),
+        stop(false)
+    {
+      if (!stream)
+      {
+        throw std::runtime_error("TraceRecorder: cannot open '" + filename +
+            "' for writing.");
+      }
+
+      const uint64_t version = 1;
+      const uint64_t columns = NumColumns;
+      stream.write("ENSTRACE", 8);
+      stream.write((const char*) &version, sizeof(version));
+      stream.write((const char*) &columns, sizeof(columns));
+
+      worker = std::thread([this]() { Run(); });
+    }
+
+    ~Writer() { Finish(); }
+
+    //! Get an empty block of the given number of rows.
+    std::vector<double> Acquire(const size_t blockRows)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (freeBlocks.empty())
+        return std::vector<double>(NumColumns * blockRows);
+
+      std::vector<double> block = std::move(freeBlocks.back());
+      freeBlocks.pop_back();
+      return block;
+    }
+
+    //! Queue the first n rows of the given block for writing.
+    void Submit(std::vector<double>& block,
+                const size_t n,
+                const size_t blockRows)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(Pending(std::move(block), n, blockRows));
+      }
+      ready.notify_one();
+    }
+
+    //! Write the queued blocks, stop the background thread, and return
+    //! whether the file was written correctly.
+    bool Finish()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      ready.notify_one();
+      if (worker.joinable())
+        worker.join();
+
+      if (stream.is_open())
+      {
+        stream.flush();
+        stream.close();
+      }
+
+      return !stream.fail();
+    }
+
+   private:
+    //! A block that is queued for writing.
+    struct Pending
+    {
+      Pending(std::vector<double>&& values,
+              const size_t n,
+              const size_t blockRows) :
+          values(std::move(values)), n(n), blockRows(blockRows)
+      { }
+
+      std::vector<double> values;
+      size_t n;
+      size_t blockRows;
+    };
+
+    //! Write the queued blocks until Finish() is called.
+    void Run()
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true)
+      {
+        ready.wait(lock, [this]() { return stop || !queue.empty(); });
+        if (queue.empty())
+          break;
+
+        Pending pending = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        const uint64_t n = pending.n;
+        stream.write((const char*) &n, sizeof(n));
+        for (size_t c = 0; c < NumColumns; ++c)
+        {
+          stream.write((const char*) (pending.values.data() +
+              c * pending.blockRows), sizeof(double) * pending.n);
+        }
+
+        lock.lock();
+        freeBlocks.push_back(std::move(pending.values));
+      }
+    }
+
+    //! The file of the trace.
+    std::ofstream stream;
+    //! The blocks that are queued for writing.
+    std::deque<Pending> queue;
+    //! The written blocks, for reuse.
+    std::vector<std::vector<double>> freeBlocks;
+    //! Whether or not the background thread should stop.
+    bool stop;
+    //! Lock for the queue, the written blocks and the stop flag.
+    std::mutex mutex;
+    //! Signals new blocks or the stop flag to the background thread.
+    std::condition_variable ready;
+    //! The background thread.
+    std::thread worker;
+  };
+
+  //! Record a row, and hand the block to the writer once it is full.
+  void Record(const EventKind kind,
+              const size_t index,
+              const double rowObjective,
+              const double stepSize)
+  {
+    if (!writer)
+      return;
+
+    const double time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    double* values = block.data() + blockFill;
+    values[Kind * blockRows] = (double) kind;
+    values[Index * blockRows] = (double) index;
+    values[Time * blockRows] = time;
+    values[Objective * blockRows] = rowObjective;
+    values[GradientNorm * blockRows] = (kind == StepEvent) ? gradientNorm :
+        std::numeric_limits<double>::quiet_NaN();
+    values[StepSize * blockRows] = stepSize;
+    values[Evaluations * blockRows] = (double) evaluations;
+    values[Gradients * blockRows] = (double) gradients;
+    ++rows;
+
+    if (++blockFill == blockRows)
+    {
+      writer->Submit(block, blockFill, blockRows);
+      block = writer->Acquire(blockRows);
+      blockFill = 0;
+    }
+  }
+
+  //! Get the step size of an optimizer that has a StepSize() method.
+  template<typename OptimizerType>
+  typename std::enable_if<traits::HasStepSizeSignature<OptimizerType>::value,
+      double>::type
+  GetStepSize(const OptimizerType& optimizer) const
+  {
+    return optimizer.StepSize();
+  }
+
+  //! Return NaN for an optimizer without a StepSize() method.
+  template<typename OptimizerType>
+  typename std::enable_if<!traits::HasStepSizeSignature<OptimizerType>::value,
+      double>::type
+  GetStepSize(const OptimizerType& /* optimizer */) const
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  //! The file to write the trace to.
+  std::string filename;
+  //! The number of steps between two recorded steps.
+  size_t stepInterval;
+  //! The number of rows of each block.
+  size_t blockRows;
+  //! The number of steps so far.
+  size_t steps;
+  //! The number of Evaluate() calls so far.
+  size_t evaluations;
+  //! The number of Gradient() calls so far.
+  size_t gradients;
+  //! The last objective passed to Evaluate().
+  double objective;
+  //! The norm of the last gradient of a recorded step.
+  double gradientNorm;
+  //! The number of recorded rows.
+  size_t rows;
+  //! The number of rows in the current block.
+  size_t blockFill;
+  //! The current block, stored column by column.
+  std::vector<double> block;
+  //! The beginning of the optimization.
+  std::chrono::steady_clock::time_point start;
+  //! The writer of the current optimization.
+  std::unique_ptr<Writer> writer;
+};
+
+} // namespace ens
+
+#endif
@@ -14,6 +14,7 @@
 #define ENSMALLEN_CALLBACKS_TRAITS_HPP
 
 #include <ensmallen_bits/function/sfinae_utility.hpp>
+#include <ensmallen_bits/callbacks/phase.hpp>
 
 namespace ens {
 namespace callbacks {
@@ -37,6 +38,10 @@ ENS_HAS_EXACT_METHOD_FORM(BeginEpoch, HasBeginEpoch)
 ENS_HAS_EXACT_METHOD_FORM(EndEpoch, HasEndEpoch)
 //! Detect an StepTaken() method.
 ENS_HAS_EXACT_METHOD_FORM(StepTaken, HasStepTaken)
+//! Detect a BeginPhase() method.
+ENS_HAS_EXACT_METHOD_FORM(BeginPhase, HasBeginPhase)
+//! Detect an EndPhase() method.
+ENS_HAS_EXACT_METHOD_FORM(EndPhase, HasEndPhase)
 
 template<typename OptimizerType,
          typename FunctionType,
@@ -189,6 +194,14 @@ struct TypedForms
       void(CallbackType::*)(OptimizerType&,
                             FunctionType&,
                             const MatType&);
+
+  //! This is the form of a BeginPhase() or EndPhase() callback method.
+  template<typename CallbackType>
+  using PhaseForm =
+      void(CallbackType::*)(OptimizerType&,
+                            FunctionType&,
+                            const MatType&,
+                            const Phase);
 };
 
 //! Utility struct, check if either void BeginOptimization() or
@@ -365,6 +378,44 @@ struct HasStepTakenSignature
          FunctionType, MatType>::template StepTakenVoidForm>::value;
 };
 
+//! Utility struct, check if void BeginPhase() exists.
+template<typename CallbackType,
+         typename OptimizerType,
+         typename FunctionType,
+         typename MatType>
+struct HasBeginPhaseSignature
+{
+  const static bool value =
+      HasBeginPhase<CallbackType, TypedForms<OptimizerType,
+      FunctionType, MatType>::template PhaseForm>::value;
+};
+
+//! Utility struct, check if void EndPhase() exists.
+template<typename CallbackType,
+         typename OptimizerType,
+         typename FunctionType,
+         typename MatType>
+struct HasEndPhaseSignature
+{
+  const static bool value =
+      HasEndPhase<CallbackType, TypedForms<OptimizerType,
+      FunctionType, MatType>::template PhaseForm>::value;
+};
+
+/**
+ * AnyOf<B...>::value is true if any of the given values is true, and false if
+ * there are none.  It derives from std::true_type or std::false_type, so that
+ * the callbacks of a stage are dispatched at compile time: if no callback has
+ * the method (or no callback is given), the call does nothing at all.
+ */
+template<bool... Values>
+struct AnyOf : public std::false_type { };
+
+template<bool First, bool... Rest>
+struct AnyOf<First, Rest...> : public std::integral_constant<bool,
+    First || AnyOf<Rest...>::value>
+{ };
+
 } // namespace traits
 } // namespace callbacks
 } // namespace ens
@@ -0,0 +1,414 @@
+/**
+ * @file warm_start.hpp
+ *
+ * A store of the final coordinates and optimizer states of past optimizations,
+ * keyed by a signature of the problem, to warm-start the optimization of
+ * similar problems; and a callback that fills it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CALLBACKS_WARM_START_HPP
+#define ENSMALLEN_CALLBACKS_WARM_START_HPP
+
+#include "checkpoint.hpp"
+#include <list>
+#include <typeinfo>
+
+namespace ens {
+
+/**
+ * WarmStartStore keeps the final coordinates and the state of the optimizer
+ * (as saved by Checkpoint::Save()) of up to Capacity() past optimizations,
+ * each under a signature of its problem: a vector chosen by the user, e.g. the
+ * costs of an SDP or summary statistics of the data of a fit.  Lookup() finds
+ * the stored optimization with the nearest signature (in Euclidean distance)
+ * for the same optimizer and coordinate types, and restores its coordinates
+ * and optimizer state, so that a problem that is similar to one solved before
+ * starts close to its solution.  The optimizer state includes the s and y
+ * vectors of L_BFGS, the Lagrange multipliers of AugLagrangian, and the state
+ * of SGD and the optimizers based on it (e.g. the moments of Adam); for other
+ * optimizers only the coordinates are restored.
+ *
+ * @code
+ * WarmStartStore store;
+ * L_BFGS lbfgs;
+ *
+ * // For each request:
+ * arma::mat coordinates = f.GetInitialPoint();
+ * store.Lookup(signature, lbfgs, coordinates);
+ * lbfgs.Optimize(f, coordinates, StoreWarmStart(store, signature));
+ * @endcode
+ *
+ * When the store is full, the least recently used optimization is forgotten.
+ * The store can be saved to a file and loaded again (e.g. when a server
+ * restarts), by programs built with the same compiler, since the optimizer
+ * types are identified by their std::type_info names.  All methods can be
+ * called concurrently.
+ */
+class WarmStartStore
+{
+ public:
+  /**
+   * Create an empty store.
+   *
+   * @param capacity The maximum number of optimizations to store (0 means no
+   *     limit).
+   */
+  WarmStartStore(const size_t capacity = 1000) :
+      capacity(capacity),
+      hits(0),
+      misses(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Store the coordinates and the state of the optimizer under the given
+   * signature, as the most recently used optimization; a stored optimization
+   * of the same types with the same signature is replaced.
+   *
+   * @param signature The signature of the problem.
+   * @param optimizer The optimizer.
+   * @param coordinates The coordinates.
+   */
+  template<typename OptimizerType, typename MatType>
+  void Insert(const arma::vec& signature,
+              OptimizerType& optimizer,
+              const MatType& coordinates)
+  {
+    std::ostringstream stream;
+    Checkpoint::Save(stream, optimizer, coordinates);
+    const std::string type = Type<OptimizerType, MatType>();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (ListType::iterator it = entries.begin(); it != entries.end(); ++it)
+    {
+      if (it->type == type && it->signature.n_elem == signature.n_elem &&
+          arma::all(it->signature == signature))
+      {
+        entries.erase(it);
+        break;
+      }
+    }
+
+    entries.push_front(Entry(type, signature, stream.str()));
+    Shrink();
+  }
+
+  /**
+   * Look for the stored optimization of the same types with the signature
+   * nearest to the given one; if there is one and its distance is at most
+   * `maxDistance`, its coordinates and optimizer state are restored, and it
+   * becomes the most recently used optimization.
+   *
+   * @param signature The signature of the problem.
+   * @param optimizer The optimizer to restore the state of.
+   * @param coordinates Set to the stored coordinates, if an optimization was
+   *     found.
+   * @param maxDistance The maximum distance of the signatures.
+   * @return Whether or not an optimization was found.
+   */
+  template<typename OptimizerType, typename MatType>
+  bool Lookup(const arma::vec& signature,
+              OptimizerType& optimizer,
+              MatType& coordinates,
+              const double maxDistance = DBL_MAX)
+  {
+    const std::string type = Type<OptimizerType, MatType>();
+    std::string state;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ListType::iterator nearest = entries.end();
+      double nearestDistance = DBL_MAX;
+      for (ListType::iterator it = entries.begin(); it != entries.end(); ++it)
+      {
+        if (it->type != type || it->signature.n_elem != signature.n_elem)
+          continue;
+
+        const double distance = arma::norm(it->signature - signature, 2);
+        if (nearest == entries.end() || distance < nearestDistance)
+        {
+          nearest = it;
+          nearestDistance = distance;
+        }
+      }
+
+      if (nearest == entries.end() || nearestDistance > maxDistance)
+      {
+        ++misses;
+        return false;
+      }
+
+      entries.splice(entries.begin(), entries, nearest);
+      state = nearest->state;
+      ++hits;
+    }
+
+    std::istringstream stream(state);
+    Checkpoint::Load(stream, optimizer, coordinates);
+    return true;
+  }
+
+  /**
+   * Save the stored optimizations to the given file; as for Checkpoint, the
+   * file is written to `filename.tmp` first and then renamed.  A
+   * std::runtime_error is thrown if the file can't be written.
+   *
+   * @param filename The file to save to.
+   */
+  void Save(const std::string& filename) const
+  {
+    const std::string tmpFilename = filename + ".tmp";
+    {
+      std::ofstream stream(tmpFilename.c_str(), std::ios::binary);
+      if (!stream)
+      {
+        throw std::runtime_error("WarmStartStore::Save(): cannot open '" +
+            tmpFilename + "' for writing.");
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      CheckpointWriter ar(stream);
+      ar.WriteBytes(Magic(), 8);
+      ar(entries.size());
+      for (ListType::const_iterator it = entries.begin(); it != entries.end();
+          ++it)
+      {
+        WriteString(ar, it->type);
+        ar(it->signature);
+        WriteString(ar, it->state);
+      }
+    }
+
+    if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+    {
+      throw std::runtime_error("WarmStartStore::Save(): cannot rename '" +
+          tmpFilename + "' to '" + filename + "'.");
+    }
+  }
+
+  /**
+   * Replace the stored optimizations with the ones saved to the given file by
+   * Save(); if there are more than Capacity(), the least recently used ones
+   * are forgotten.  A std::runtime_error is thrown if the file can't be read.
+   *
+   * @param filename The file to load from.
+   */
+  void Load(const std::string& filename)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream)
+    {
+      throw std::runtime_error("WarmStartStore::Load(): cannot open '" +
+          filename + "' for reading.");
+    }
+
+    CheckpointReader ar(stream);
+    char magic[8];
+    ar.ReadBytes(magic, 8);
+    if (std::memcmp(magic, Magic(), 8) != 0)
+    {
+      throw std::runtime_error("WarmStartStore::Load(): '" + filename +
+          "' is not a warm start store.");
+    }
+
+    size_t size;
+    ar(size);
+    ListType loaded;
+    for (size_t i = 0; i < size; ++i)
+    {
+      Entry entry;
+      ReadString(ar, entry.type);
+      ar(entry.signature);
+      ReadString(ar, entry.state);
+      loaded.push_back(std::move(entry));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.swap(loaded);
+    Shrink();
+  }
+
+  //! Forget all the stored optimizations; the counts of hits and misses are
+  //! kept.
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+  }
+
+  //! Get the number of stored optimizations.
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+  //! Get the number of lookups that restored an optimization.
+  size_t Hits() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  //! Get the number of lookups that did not restore an optimization.
+  size_t Misses() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  //! Get the maximum number of stored optimizations (0 means no limit).
+  size_t Capacity() const { return capacity; }
+  //! Modify the maximum number of stored optimizations (0 means no limit); the
+  //! store is shrunk by the next Insert().  This must not be called
+  //! concurrently with the other methods.
+  size_t& Capacity() { return capacity; }
+
+ private:
+  //! A stored optimization.
+  struct Entry
+  {
+    Entry() { }
+
+    Entry(const std::string& type,
+          const arma::vec& signature,
+          const std::string& state) :
+        type(type), signature(signature), state(state) { }
+
+    //! The names of the optimizer and coordinate types.
+    std::string type;
+    //! The signature of the problem.
+    arma::vec signature;
+    //! The coordinates and the optimizer state, as saved by Checkpoint.
+    std::string state;
+  };
+
+  //! The stored optimizations, the most recently used first.
+  typedef std::list<Entry> ListType;
+
+  //! The first bytes of a store file.
+  static const char* Magic() { return "ENSWARM1"; }
+
+  //! Return the key of the given optimizer and coordinate types.
+  template<typename OptimizerType, typename MatType>
+  static std::string Type()
+  {
+    return std::string(typeid(OptimizerType).name()) + " " +
+        typeid(MatType).name();
+  }
+
+  //! Forget the least recently used optimizations of a store over capacity.
+  void Shrink()
+  {
+    while (capacity > 0 && entries.size() > capacity)
+      entries.pop_back();
+  }
+
+  //! Write a string as its length and its characters.
+  static void WriteString(CheckpointWriter& ar, const std::string& s)
+  {
+    ar(s.size());
+    ar.WriteBytes(s.data(), s.size());
+  }
+
+  //! Read a string written by WriteString().
+  static void ReadString(CheckpointReader& ar, std::string& s)
+  {
+    size_t length;
+    ar(length);
+    s.resize(length);
+    if (length > 0)
+      ar.ReadBytes(&s[0], length);
+  }
+
+  //! The maximum number of stored optimizations.
+  size_t capacity;
+  //! The stored optimizations.
+  ListType entries;
+  //! The number of lookups that restored an optimization.
+  size_t hits;
+  //! The number of lookups that did not restore an optimization.
+  size_t misses;
+  //! Lock for all the members above but the capacity.
+  mutable std::mutex mutex;
+};
+
+/**
+ * The StoreWarmStart callback inserts the final coordinates and the state of
+ * the optimizer into a WarmStartStore at the end of the optimization, under
+ * the given signature.  Optimizers that run inner optimizations with the same
+ * callbacks (such as AugLagrangian) are stored, not their inner optimizers.
+ * The stored optimizer is the one that is given to the callbacks: for the
+ * optimizers that are implemented with SGD, such as Adam, that is the SGD
+ * object (e.g. SGD<AdamUpdate>), which a lookup with the Adam object would not
+ * find; for those, call WarmStartStore::Insert() after Optimize() instead.
+ */
+class StoreWarmStart
+{
+ public:
+  /**
+   * Set up the callback.  The store is held by reference, so it must outlive
+   * this object.
+   *
+   * @param store The store to insert into.
+   * @param signature The signature of the problem.
+   */
+  StoreWarmStart(WarmStartStore& store, const arma::vec& signature) :
+      store(store),
+      signature(signature),
+      depth(0)
+  { /* Nothing to do here. */ }
+
+  /**
+   * Callback function called at the beginning of an optimization.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates Starting point.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginOptimization(OptimizerType& /* optimizer */,
+                         FunctionType& /* function */,
+                         MatType& /* coordinates */)
+  {
+    ++depth;
+  }
+
+  /**
+   * Callback function called at the end of an optimization; the outermost
+   * optimization is stored.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The final coordinates.
+   */
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndOptimization(OptimizerType& optimizer,
+                       FunctionType& /* function */,
+                       MatType& coordinates)
+  {
+    if (depth > 0)
+      --depth;
+    if (depth == 0)
+      store.Insert(signature, optimizer, coordinates);
+  }
+
+  //! Get the signature of the problem.
+  const arma::vec& Signature() const { return signature; }
+  //! Modify the signature of the problem.
+  arma::vec& Signature() { return signature; }
+
+ private:
+  //! The store to insert into.
+  WarmStartStore& store;
+  //! The signature of the problem.
+  arma::vec signature;
+  //! The number of optimizations that have begun but not ended.
+  size_t depth;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,233 @@
+/**
+ * @file adaptive_selection.hpp
+ *
+ * Select a growing random subsample of the dataset for the Evaluation step,
+ * until the ranking of the population is stable.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_ADAPTIVE_SELECTION_HPP
+#define ENSMALLEN_CMAES_ADAPTIVE_SELECTION_HPP
+
+namespace ens {
+
+/**
+ * Evaluate the whole population of a generation on a growing random subsample
+ * of the batches of the dataset, until the ranking of the candidates is
+ * stable.  The batches are visited in a random order; all candidates are first
+ * evaluated on `initialFraction` of the batches, then the subsample is grown
+ * by a factor of `growth` at a time.  After each growth, the ranking on the
+ * enlarged subsample is compared with the ranking on the previous one, as in
+ * the rank-change test of UH-CMA-ES; once the fraction of pairs of candidates
+ * whose order changed is at most `tolerance` (or all batches are used), the
+ * ranking is kept.  The objectives are the means over the evaluated points,
+ * scaled to the number of functions, so they estimate the full objective.
+ *
+ * So, when the candidates are far apart, they are ranked on a few batches, and
+ * the subsample only grows to the whole dataset when the differences between
+ * the candidates are below the noise of the subsample.  The mean of the
+ * distribution, which is kept as the best point, is still evaluated on all
+ * batches with Select().
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{hansen2009,
+ *   author  = {Hansen, Nikolaus and Niederberger, Andre S. P. and
+ *              Guzzella, Lino and Koumoutsakos, Petros},
+ *   title   = {A Method for Handling Uncertainty in Evolutionary Optimization
+ *              With an Application to Feedback Control of Combustion},
+ *   journal = {IEEE Transactions on Evolutionary Computation},
+ *   year    = {2009},
+ *   volume  = {13},
+ *   number  = {1},
+ *   pages   = {180--197}
+ * }
+ * @endcode
+ */
+class AdaptiveSelection
+{
+ public:
+  /**
+   * Constructor for the adaptive selection strategy.
+   *
+   * @param initialFraction The fraction of the batches that the population is
+   *     first evaluated on (Default 0.1).
+   * @param growth The factor that the subsample is grown by (Default 2).
+   * @param tolerance The largest fraction of pairs of candidates whose order
+   *     may change when the subsample is grown, for the ranking to be stable
+   *     (Default 0.05).
+   */
+  AdaptiveSelection(const double initialFraction = 0.1,
+                    const double growth = 2.0,
+                    const double tolerance = 0.05) :
+      initialFraction(initialFraction),
+      growth(growth),
+      tolerance(tolerance),
+      batchEvaluations(0)
+  {
+    // Nothing to do here.
+  }
+
+  //! Get the initial dataset fraction.
+  double InitialFraction() const { return initialFraction; }
+  //! Modify the initial dataset fraction.
+  double& InitialFraction() { return initialFraction; }
+
+  //! Get the growth factor of the subsample.
+  double Growth() const { return growth; }
+  //! Modify the growth factor of the subsample.
+  double& Growth() { return growth; }
+
+  //! Get the rank-change tolerance.
+  double Tolerance() const { return tolerance; }
+  //! Modify the rank-change tolerance.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the number of batch evaluations so far.
+  size_t BatchEvaluations() const { return batchEvaluations; }
+  //! Modify the number of batch evaluations so far.
+  size_t& BatchEvaluations() { return batchEvaluations; }
+
+  /**
+   * Select the full dataset to calculate the objective function of a single
+   * point.
+   *
+   * @tparam SeparableFunctionType Type of the function to be evaluated.
+   * @param function Function to optimize.
+   * @param batchSize Batch size to use for each step.
+   * @param iterate starting point.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  double Select(SeparableFunctionType& function,
+                const size_t batchSize,
+                const MatType& iterate,
+                CallbackTypes&... callbacks)
+  {
+    const size_t numFunctions = function.NumFunctions();
+
+    typename MatType::elem_type objective = 0;
+    for (size_t f = 0; f < numFunctions; f += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
+      objective += function.Evaluate(iterate, f, effectiveBatchSize);
+      ++batchEvaluations;
+
+      Callback::Evaluate(*this, f, iterate, objective, callbacks...);
+    }
+
+    return objective;
+  }
+
+  /**
+   * Calculate the objectives of a whole population on a subsample of the
+   * dataset that is grown until the ranking of the population is stable.
+   *
+   * @tparam SeparableFunctionType Type of the function to be evaluated.
+   * @param function Function to optimize.
+   * @param batchSize Batch size to use for each step.
+   * @param population The candidates to evaluate.
+   * @param objectives Vector to store the estimated objectives into.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void SelectPopulation(SeparableFunctionType& function,
+                        const size_t batchSize,
+                        const std::vector<MatType>& population,
+                        arma::Col<typename MatType::elem_type>& objectives,
+                        CallbackTypes&... callbacks)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    const size_t numFunctions = function.NumFunctions();
+    const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+    const size_t lambda = population.size();
+
+    // Visit the batches in a random order.  The stream is seeded from the
+    // generator of Armadillo of this thread.
+    RandomStream rng;
+    const RandomPermutation order(numBatches, rng);
+
+    objectives.zeros(lambda);
+    arma::uvec ranks, previousRanks;
+    size_t used = 0, points = 0;
+    size_t target = std::min(numBatches, std::max((size_t) 1,
+        (size_t) std::ceil(initialFraction * numBatches)));
+    while (true)
+    {
+      for (size_t b = used; b < target; ++b)
+      {
+        const size_t begin = order(b) * batchSize;
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - begin);
+        for (size_t j = 0; j < lambda; ++j)
+        {
+          objectives(j) += function.Evaluate(population[j], begin,
+              effectiveBatchSize);
+        }
+        points += effectiveBatchSize;
+        batchEvaluations += lambda;
+      }
+      used = target;
+
+      if (used == numBatches)
+        break;
+
+      ranks = arma::sort_index(arma::sort_index(objectives));
+      if (previousRanks.n_elem == lambda &&
+          Discordance(previousRanks, ranks) <= tolerance)
+        break;
+
+      previousRanks = ranks;
+      target = std::min(numBatches, std::max(used + 1,
+          (size_t) std::ceil(growth * used)));
+    }
+
+    objectives *= ElemType(numFunctions) / ElemType(points);
+    for (size_t j = 0; j < lambda; ++j)
+    {
+      Callback::Evaluate(*this, function, population[j], objectives(j),
+          callbacks...);
+    }
+  }
+
+ private:
+  //! Return the fraction of pairs of candidates that the two rankings order
+  //! differently.
+  static double Discordance(const arma::uvec& a, const arma::uvec& b)
+  {
+    if (a.n_elem < 2)
+      return 0.0;
+
+    size_t discordant = 0;
+    for (size_t i = 0; i < a.n_elem; ++i)
+    {
+      for (size_t j = i + 1; j < a.n_elem; ++j)
+      {
+        if ((a(i) < a(j)) != (b(i) < b(j)))
+          ++discordant;
+      }
+    }
+
+    return 2.0 * discordant / (a.n_elem * (a.n_elem - 1.0));
+  }
+
+  //! The initial dataset fraction.
+  double initialFraction;
+  //! The growth factor of the subsample.
+  double growth;
+  //! The rank-change tolerance.
+  double tolerance;
+  //! The number of batch evaluations so far.
+  size_t batchEvaluations;
+};
+
+} // namespace ens
+
+#endif
@@ -17,9 +17,52 @@
 
 #include "full_selection.hpp"
 #include "random_selection.hpp"
+#include "adaptive_selection.hpp"
+#include "full_covariance.hpp"
+#include "diagonal_covariance.hpp"
+#include "limited_memory_covariance.hpp"
+#include "quadratic_surrogate.hpp"
 
 namespace ens {
 
+namespace traits {
+
+//! Detect a TransformColumns() method of a covariance policy, which transforms
+//! many standard normal samples (one per column) at once.
+template<typename PolicyType, typename MatType>
+struct HasTransformColumns
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<const U&>().TransformColumns(
+      std::declval<const MatType&>(), std::declval<MatType&>()),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+//! Detect a SelectPopulation() method of a selection policy, which calculates
+//! the objectives of a whole population at once.
+template<typename PolicyType, typename FunctionType, typename MatType>
+struct HasSelectPopulation
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().SelectPopulation(
+      std::declval<FunctionType&>(), size_t(),
+      std::declval<const std::vector<MatType>&>(),
+      std::declval<arma::Col<typename MatType::elem_type>&>()),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+} // namespace traits
+
 /**
  * CMA-ES - Covariance Matrix Adaptation Evolution Strategy is s a stochastic
  * search algorithm. CMA-ES is a second order approach estimating a positive
@@ -45,9 +88,77 @@ namespace ens {
  * documentation on function types included with this distribution or on the
  * ensmallen website.
  *
+ * If ParallelEvaluation() is set to true (and OpenMP is enabled), the objective
+ * of each candidate in a generation is computed on its own thread; the
+ * candidates themselves are still sampled serially.  The function's Evaluate()
+ * (and any callbacks with an Evaluate() method) must then be safe to call
+ * concurrently.  Each candidate is evaluated with its own random seed drawn
+ * from the main generator, so the result depends only on the seed and not on
+ * the number of threads, although it differs from the result of a serial run.
+ *
+ * If the FullSelection policy is used and the function has an EvaluateBatch()
+ * method (see the documentation on function types), the whole population is
+ * evaluated with one call to it instead.
+ *
+ * The samples of a generation are drawn at once, and if the covariance policy
+ * has a TransformColumns() method (as FullCovariance and DiagonalCovariance do)
+ * and the iterate is a column vector, they are transformed with a single
+ * matrix product.  With MirroredSampling(), each pair of candidates uses one
+ * sample z and its mirror -z, which halves the samples and reduces the
+ * variance of the selection.  With SequentialSelection(), the candidates are
+ * evaluated in order, and the generation stops early, after at least mu
+ * candidates (and after a whole mirrored pair), as soon as a candidate is
+ * better than the best point so far; this only applies if the candidates are
+ * evaluated one at a time (i.e. not in parallel or with EvaluateBatch()).
+ * With ActiveCovariance(), the covariance update also uses the worst
+ * candidates with negative weights (active CMA-ES), which shrinks the
+ * distribution in unpromising directions; LimitedMemoryCovariance ignores it.
+ * See the following papers:
+ *
+ * @code
+ * @inproceedings{Brockhoff2010,
+ *   author    = {Brockhoff, Dimo and Auger, Anne and Hansen, Nikolaus and
+ *                Arnold, Dirk V. and Hohm, Tim},
+ *   title     = {Mirrored Sampling and Sequential Selection for Evolution
+ *                Strategies},
+ *   booktitle = {Parallel Problem Solving from Nature, PPSN XI},
+ *   year      = {2010},
+ *   pages     = {11--21}
+ * }
+ *
+ * @inproceedings{Jastrebski2006,
+ *   author    = {Jastrebski, Grahame A. and Arnold, Dirk V.},
+ *   title     = {Improving Evolution Strategies through Active Covariance
+ *                Matrix Adaptation},
+ *   booktitle = {IEEE Congress on Evolutionary Computation},
+ *   year      = {2006},
+ *   pages     = {2814--2821}
+ * }
+ * @endcode
+ *
+ * For expensive objectives, Surrogate() enables the pre-screening of the
+ * candidates with a linear-quadratic model of the objective (see
+ * QuadraticSurrogate), fit on an archive of all the evaluated points
+ * (lq-CMA-ES).  The candidates are evaluated in the order of the predictions
+ * of the model, a few at a time, and the model is refit after each batch; as
+ * soon as the Kendall rank correlation between the model and the most recent
+ * evaluations reaches SurrogateRankCorrelation(), the whole generation is
+ * ranked with the model instead of evaluating the remaining candidates.  The
+ * candidates are still evaluated with the selection policy, one at a time (so
+ * neither ParallelEvaluation() nor EvaluateBatch() is used when the model is
+ * used).
+ *
+ * The CovariancePolicyType controls how the covariance matrix of the search
+ * distribution is represented and adapted.  FullCovariance (the default) adapts
+ * the full matrix; for high-dimensional problems DiagonalCovariance
+ * (sep-CMA-ES) needs only O(n) and LimitedMemoryCovariance (LM-CMA-ES) only
+ * O(mn) memory and time per generation.
+ *
  * @tparam SelectionPolicy The selection strategy used for the evaluation step.
+ * @tparam CovariancePolicyType The covariance adaptation strategy.
  */
-template<typename SelectionPolicyType = FullSelection>
+template<typename SelectionPolicyType = FullSelection,
+         typename CovariancePolicyType = FullCovariance>
 class CMAES
 {
  public:
@@ -68,6 +179,8 @@ class CMAES
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
    * @param selectionPolicy Instantiated selection policy used to calculate the
    *     objective.
+   * @param covariancePolicy Instantiated covariance policy used to adapt the
+   *     search distribution.
    */
   CMAES(const size_t lambda = 0,
         const double lowerBound = -10,
@@ -75,7 +188,8 @@ class CMAES
         const size_t batchSize = 32,
         const size_t maxIterations = 1000,
         const double tolerance = 1e-5,
-        const SelectionPolicyType& selectionPolicy = SelectionPolicyType());
+        const SelectionPolicyType& selectionPolicy = SelectionPolicyType(),
+        const CovariancePolicyType& covariancePolicy = CovariancePolicyType());
 
   /**
    * Optimize the given function using CMA-ES. The given starting point will be
@@ -97,6 +211,50 @@ class CMAES
                                        MatType& iterate,
                                        CallbackTypes&&... callbacks);
 
+  //! The state of an optimization that is run step by step with Begin() and
+  //! Step(); it is defined below.
+  template<typename SeparableFunctionType, typename MatType>
+  class State;
+
+  /**
+   * Start an optimization of the given function that is run step by step with
+   * Step(), instead of to completion; e.g. a scheduler can interleave many
+   * such optimizations on a few threads, or stop one at a deadline.  This
+   * evaluates the starting mean of the search distribution.  The optimization
+   * is the same as with Optimize(), except that no callbacks are called.  Each
+   * state has its own search distribution and buffers.
+   *
+   * @code
+   * CMAES<> cmaes;
+   * auto state = cmaes.Begin(f, coordinates);
+   * while (cmaes.Step(state))
+   * {
+   *   // Do other work between generations.
+   * }
+   * @endcode
+   *
+   * @param function Function to optimize; it must outlive the state.
+   * @param iterate Coordinates to store the best point in; it must outlive the
+   *     state.
+   * @return The state of the optimization.
+   */
+  template<typename SeparableFunctionType, typename MatType>
+  State<SeparableFunctionType, MatType> Begin(SeparableFunctionType& function,
+                                              MatType& iterate);
+
+  /**
+   * Run up to n generations of the optimization of the given state, with the
+   * parameters of this optimizer.  Once the optimization has terminated, the
+   * coordinates are the best point found and state.Objective() is the value
+   * Optimize() would have returned.
+   *
+   * @param state State returned by Begin().
+   * @param n Maximum number of generations to run.
+   * @return false if the optimization has terminated.
+   */
+  template<typename SeparableFunctionType, typename MatType>
+  bool Step(State<SeparableFunctionType, MatType>& state, const size_t n = 1);
+
   //! Get the step size.
   size_t PopulationSize() const { return lambda; }
   //! Modify the step size.
@@ -132,7 +290,234 @@ class CMAES
   //! Modify the selection policy.
   SelectionPolicyType& SelectionPolicy() { return selectionPolicy; }
 
+  //! Get the covariance policy.
+  const CovariancePolicyType& CovariancePolicy() const
+  { return covariancePolicy; }
+  //! Modify the covariance policy.
+  CovariancePolicyType& CovariancePolicy() { return covariancePolicy; }
+
+  //! Get whether or not the population is evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether or not the population is evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get whether or not the candidates are sampled in mirrored pairs.
+  bool MirroredSampling() const { return mirroredSampling; }
+  //! Modify whether or not the candidates are sampled in mirrored pairs.
+  bool& MirroredSampling() { return mirroredSampling; }
+
+  //! Get whether or not a generation may stop once a candidate improves.
+  bool SequentialSelection() const { return sequentialSelection; }
+  //! Modify whether or not a generation may stop once a candidate improves.
+  bool& SequentialSelection() { return sequentialSelection; }
+
+  //! Get whether or not the worst candidates update the covariance with
+  //! negative weights.
+  bool ActiveCovariance() const { return activeCovariance; }
+  //! Modify whether or not the worst candidates update the covariance with
+  //! negative weights.
+  bool& ActiveCovariance() { return activeCovariance; }
+
+  //! Get whether or not the candidates are pre-screened with a surrogate.
+  bool Surrogate() const { return surrogate; }
+  //! Modify whether or not the candidates are pre-screened with a surrogate.
+  bool& Surrogate() { return surrogate; }
+
+  //! Get the rank correlation at which the surrogate ranks a generation.
+  double SurrogateRankCorrelation() const { return surrogateRankCorrelation; }
+  //! Modify the rank correlation at which the surrogate ranks a generation.
+  double& SurrogateRankCorrelation() { return surrogateRankCorrelation; }
+
+  /**
+   * Return the number of bytes that Optimize() keeps for coordinates of the
+   * given size: the state of the covariance policy (e.g. the n x n covariance
+   * and its Cholesky factor with FullCovariance), the candidates and their
+   * steps, the samples of a generation, and the archive of the surrogate if
+   * Surrogate() is true.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Unused; for consistency with the other optimizers.
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   */
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const;
+
  private:
+  /**
+   * The buffers used by Optimize(); they are kept between calls, so that
+   * repeated calls on problems of the same size do not allocate them again.
+   */
+  template<typename MatType>
+  struct Workspace
+  {
+    //! The weights of the parents.
+    MatType w;
+    //! The mean of the distribution of the last two iterations.
+    std::vector<MatType> mPosition;
+    //! The weighted step of the mean.
+    MatType step;
+    //! The steps of the candidates.
+    std::vector<MatType> pStep;
+    //! The candidates.
+    std::vector<MatType> pPosition;
+    //! The objectives of the candidates.
+    arma::Col<typename MatType::elem_type> pObjective;
+    //! The evolution paths of the step size of the last two iterations.
+    std::vector<MatType> ps;
+    //! The evolution paths of the covariance of the last two iterations.
+    std::vector<MatType> pc;
+    //! The step transformed for the step size path.
+    MatType pathStep;
+    //! The standard normal samples of a generation, one per column.
+    MatType z;
+    //! The transformed samples of a generation, one per column.
+    MatType y;
+    //! The squared norm of the sample of each candidate.
+    arma::Col<typename MatType::elem_type> zNorms;
+    //! The negative weights of the worst candidates (active update).
+    MatType negativeWeights;
+    //! The weights of the steps of the covariance update.
+    MatType updateWeights;
+    //! The candidates, sorted by their objectives.
+    arma::uvec idx;
+  };
+
+  //! Set up the search distribution of the given state, and evaluate its
+  //! starting mean.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void Initialize(State<SeparableFunctionType, MatType>& state,
+                  CallbackTypes&... callbacks);
+
+  //! Run one generation of the given state; return false if the optimization
+  //! has terminated.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  bool Iteration(State<SeparableFunctionType, MatType>& state,
+                 bool& terminate,
+                 CallbackTypes&... callbacks);
+
+  //! Transform the standard normal samples z (one per column, each of the
+  //! given shape) into the steps y with the covariance policy, with one call
+  //! to TransformColumns() if the policy has it and the iterate is a column.
+  template<typename PolicyType, typename MatType>
+  static void TransformSamples(const PolicyType& covariance,
+                               const MatType& z,
+                               MatType& y,
+                               const size_t rows,
+                               const size_t cols,
+                               const std::true_type hasTransformColumns);
+
+  //! Transform the standard normal samples one at a time with Transform().
+  template<typename PolicyType, typename MatType>
+  static void TransformSamples(const PolicyType& covariance,
+                               const MatType& z,
+                               MatType& y,
+                               const size_t rows,
+                               const size_t cols,
+                               const std::false_type hasTransformColumns);
+
+  /**
+   * Evaluate the candidates of a generation in the order of the predictions
+   * of the surrogate, until the surrogate ranks them well enough, and set the
+   * objectives of the population to the predictions of the final model (or to
+   * the evaluated objectives, if all candidates were evaluated).
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void ScreenPopulation(State<SeparableFunctionType, MatType>& state,
+                        CallbackTypes&... callbacks);
+
+  //! Give the vector n matrices of the given size, reusing their memory.
+  template<typename MatType>
+  static void Resize(std::vector<MatType>& matrices,
+                     const size_t n,
+                     const size_t rows,
+                     const size_t cols);
+
+  /**
+   * Evaluate the objective of a candidate with the EvaluateBounded() method of
+   * the function: the candidate can only be selected if its objective is at
+   * most the bound.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type EvaluateCandidate(
+      SeparableFunctionType& function,
+      const MatType& candidate,
+      const typename MatType::elem_type bound,
+      const std::true_type useEvaluateBounded,
+      CallbackTypes&... callbacks);
+
+  //! Evaluate the objective of a candidate with the selection policy.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type EvaluateCandidate(
+      SeparableFunctionType& function,
+      const MatType& candidate,
+      const typename MatType::elem_type /* bound */,
+      const std::false_type /* useEvaluateBounded */,
+      CallbackTypes&... callbacks)
+  {
+    return selectionPolicy.Select(function, batchSize, candidate,
+        callbacks...);
+  }
+
+  /**
+   * Evaluate the objective of every candidate of the population at once with
+   * the EvaluateBatch() method of the function.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void EvaluatePopulation(SeparableFunctionType& function,
+                          const std::vector<MatType>& population,
+                          arma::Col<typename MatType::elem_type>& objectives,
+                          const std::true_type useEvaluateBatch,
+                          CallbackTypes&... callbacks);
+
+  /**
+   * Evaluate the objective of every candidate of the population in parallel
+   * with the selection policy.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void EvaluatePopulation(SeparableFunctionType& function,
+                          const std::vector<MatType>& population,
+                          arma::Col<typename MatType::elem_type>& objectives,
+                          const std::false_type useEvaluateBatch,
+                          CallbackTypes&... callbacks);
+
+  /**
+   * Calculate the objective of every candidate of the population at once with
+   * the SelectPopulation() method of the selection policy.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void SelectPopulation(SeparableFunctionType& function,
+                        const std::vector<MatType>& population,
+                        arma::Col<typename MatType::elem_type>& objectives,
+                        const std::true_type useSelectPopulation,
+                        CallbackTypes&... callbacks);
+
+  //! The selection policy has no SelectPopulation() method; never called.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  void SelectPopulation(SeparableFunctionType& /* function */,
+                        const std::vector<MatType>& /* population */,
+                        arma::Col<typename MatType::elem_type>& /* obj */,
+                        const std::false_type /* useSelectPopulation */,
+                        CallbackTypes&... /* callbacks */) { }
+
   //! Population size.
   size_t lambda;
 
@@ -153,6 +538,120 @@ class CMAES
 
   //! The selection policy used to calculate the objective.
   SelectionPolicyType selectionPolicy;
+
+  //! The covariance policy used to adapt the search distribution.
+  CovariancePolicyType covariancePolicy;
+
+  //! Whether or not the population is evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! Whether or not the candidates are sampled in mirrored pairs.
+  bool mirroredSampling;
+
+  //! Whether or not a generation may stop once a candidate improves.
+  bool sequentialSelection;
+
+  //! Whether or not the covariance update uses negative weights.
+  bool activeCovariance;
+
+  //! Whether or not the candidates are pre-screened with a surrogate.
+  bool surrogate;
+
+  //! The rank correlation at which the surrogate ranks a generation.
+  double surrogateRankCorrelation;
+
+  //! The workspace of the last call to Optimize().
+  Any workspace;
+};
+
+/**
+ * The state of a CMA-ES optimization that is run with Begin() and Step().  It
+ * refers to the function and the coordinates given to Begin(), which must
+ * outlive it, and holds the search distribution.
+ */
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType, typename MatType>
+class CMAES<SelectionPolicyType, CovariancePolicyType>::State
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename CovariancePolicyType::template Policy<BaseMatType>
+      InstCovariancePolicyType;
+
+  //! Create the state of an optimization of the given function with the
+  //! given optimizer.
+  State(const CMAES& optimizer,
+        SeparableFunctionType& function,
+        MatType& iterate) :
+      function(&function),
+      iterate(&((BaseMatType&) iterate)),
+      covariance(optimizer.CovariancePolicy(), iterate.n_rows,
+          iterate.n_cols),
+      sigma(2, 1),
+      lambda(0),
+      mu(0),
+      muEffective(0),
+      cs(0),
+      ds(0),
+      enn(0),
+      cc(0),
+      h(0),
+      c1(0),
+      cmu(0),
+      overallObjective(0),
+      lastObjective(std::numeric_limits<ElemType>::max()),
+      iterations(1),
+      finished(false)
+  { }
+
+  //! Get the best point found so far.
+  const BaseMatType& Iterate() const { return *iterate; }
+  //! Get the objective of the best point found so far.
+  ElemType Objective() const { return overallObjective; }
+  //! Get the number of the next generation.
+  size_t Iterations() const { return iterations; }
+  //! Get whether or not the optimization has terminated.
+  bool Finished() const { return finished; }
+  //! Get the instantiated covariance policy of the search distribution.
+  const InstCovariancePolicyType& Covariance() const { return covariance; }
+
+ private:
+  friend class CMAES<SelectionPolicyType, CovariancePolicyType>;
+
+  //! The function to optimize.
+  SeparableFunctionType* function;
+  //! The coordinates of the best point.
+  BaseMatType* iterate;
+  //! The covariance of the search distribution.
+  InstCovariancePolicyType covariance;
+  //! The surrogate of the objective (if Surrogate() is enabled).
+  QuadraticSurrogate<BaseMatType> surrogate;
+  //! The buffers of the optimization.
+  Workspace<BaseMatType> ws;
+  //! The stream that the candidates are sampled from; it is seeded from the
+  //! generator of Armadillo when the state is created.
+  RandomStream rng;
+  //! The step sizes of the last two generations.
+  BaseMatType sigma;
+  //! The population size.
+  size_t lambda;
+  //! The number of parents.
+  size_t mu;
+  //! The number of effective solutions.
+  double muEffective;
+  //! The step size control parameters.
+  double cs, ds, enn;
+  //! The covariance update parameters.
+  double cc, h, c1, cmu;
+  //! The objective of the best point.
+  ElemType overallObjective;
+  //! The objective of the best point of the previous generation.
+  ElemType lastObjective;
+  //! The number of the next generation.
+  size_t iterations;
+  //! Whether or not the optimization has terminated.
+  bool finished;
 };
 
 /**
@@ -161,6 +660,18 @@ class CMAES
 template<typename SelectionPolicyType = RandomSelection>
 using ApproxCMAES = CMAES<SelectionPolicyType>;
 
+/**
+ * Convenient typedef for CMAES with a diagonal covariance (sep-CMA-ES).
+ */
+template<typename SelectionPolicyType = FullSelection>
+using SepCMAES = CMAES<SelectionPolicyType, DiagonalCovariance>;
+
+/**
+ * Convenient typedef for CMAES with a limited-memory covariance (LM-CMA-ES).
+ */
+template<typename SelectionPolicyType = FullSelection>
+using LMCMAES = CMAES<SelectionPolicyType, LimitedMemoryCovariance>;
+
 } // namespace ens
 
 // Include implementation.
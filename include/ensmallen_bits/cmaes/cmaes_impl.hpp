@@ -19,46 +19,140 @@
 #include "cmaes.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/evaluate_batch.hpp>
+#include <ensmallen_bits/utility/evaluate_bounded.hpp>
 
 namespace ens {
 
-template<typename SelectionPolicyType>
-CMAES<SelectionPolicyType>::CMAES(const size_t lambda,
-                                  const double lowerBound,
-                                  const double upperBound,
-                                  const size_t batchSize,
-                                  const size_t maxIterations,
-                                  const double tolerance,
-                                  const SelectionPolicyType& selectionPolicy) :
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+CMAES<SelectionPolicyType, CovariancePolicyType>::CMAES(
+    const size_t lambda,
+    const double lowerBound,
+    const double upperBound,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const SelectionPolicyType& selectionPolicy,
+    const CovariancePolicyType& covariancePolicy) :
     lambda(lambda),
     lowerBound(lowerBound),
     upperBound(upperBound),
     batchSize(batchSize),
     maxIterations(maxIterations),
     tolerance(tolerance),
-    selectionPolicy(selectionPolicy)
+    selectionPolicy(selectionPolicy),
+    covariancePolicy(covariancePolicy),
+    parallelEvaluation(false),
+    mirroredSampling(false),
+    sequentialSelection(false),
+    activeCovariance(false),
+    surrogate(false),
+    surrogateRankCorrelation(0.85)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
-template<typename SelectionPolicyType>
+template<typename SelectionPolicyType, typename CovariancePolicyType>
 template<typename SeparableFunctionType,
          typename MatType,
          typename... CallbackTypes>
-typename MatType::elem_type CMAES<SelectionPolicyType>::Optimize(
+typename MatType::elem_type
+CMAES<SelectionPolicyType, CovariancePolicyType>::Optimize(
     SeparableFunctionType& function,
-    MatType& iterateIn,
+    MatType& iterate,
     CallbackTypes&&... callbacks)
 {
-  // Convenience typedefs.
-  typedef typename MatType::elem_type ElemType;
-  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef State<SeparableFunctionType, MatType> StateType;
+  typedef typename StateType::BaseMatType BaseMatType;
 
   // Make sure that we have the methods that we need.  Long name...
   traits::CheckArbitrarySeparableFunctionTypeAPI<
       SeparableFunctionType, BaseMatType>();
   RequireDenseFloatingPointType<BaseMatType>();
 
-  BaseMatType& iterate = (BaseMatType&) iterateIn;
+  // The storage of the previous call is reused; if the problem and the
+  // population have the same size, none of the buffers are allocated.  The
+  // state holds it during the optimization.
+  typedef Workspace<BaseMatType> WorkspaceType;
+  if (!workspace.Has<WorkspaceType>())
+    workspace.Emplace<WorkspaceType>();
+
+  StateType state(*this, function, iterate);
+  state.ws = std::move(workspace.As<WorkspaceType>());
+  Initialize(state, callbacks...);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  // Now iterate!
+  terminate |= Callback::BeginOptimization(*this, function, *state.iterate,
+      callbacks...);
+  while (state.iterations < maxIterations && !terminate)
+  {
+    if (!Iteration(state, terminate, callbacks...))
+      break;
+  }
+
+  workspace.As<WorkspaceType>() = std::move(state.ws);
+
+  Callback::EndOptimization(*this, function, *state.iterate, callbacks...);
+  return state.overallObjective;
+}
+
+//! Start an optimization that is run with Step().
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType, typename MatType>
+typename CMAES<SelectionPolicyType, CovariancePolicyType>::template State<
+    SeparableFunctionType, MatType>
+CMAES<SelectionPolicyType, CovariancePolicyType>::Begin(
+    SeparableFunctionType& function,
+    MatType& iterate)
+{
+  typedef State<SeparableFunctionType, MatType> StateType;
+
+  // Make sure that we have the methods that we need.
+  traits::CheckArbitrarySeparableFunctionTypeAPI<
+      SeparableFunctionType, typename StateType::BaseMatType>();
+  RequireDenseFloatingPointType<typename StateType::BaseMatType>();
+
+  StateType state(*this, function, iterate);
+  Initialize(state);
+  return state;
+}
+
+//! Run up to n iterations of an optimization started with Begin().
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType, typename MatType>
+bool CMAES<SelectionPolicyType, CovariancePolicyType>::Step(
+    State<SeparableFunctionType, MatType>& state,
+    const size_t n)
+{
+  // No callbacks are called, so nothing can request termination.
+  bool terminate = false;
+  for (size_t k = 0; k < n && !state.finished; ++k)
+  {
+    if (state.iterations >= maxIterations || !Iteration(state, terminate))
+      state.finished = true;
+  }
+
+  return !state.finished;
+}
+
+//! Set up the search distribution and evaluate the starting mean.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::Initialize(
+    State<SeparableFunctionType, MatType>& state,
+    CallbackTypes&... callbacks)
+{
+  typedef State<SeparableFunctionType, MatType> StateType;
+  typedef typename StateType::ElemType ElemType;
+  typedef typename StateType::BaseMatType BaseMatType;
+
+  SeparableFunctionType& function = *state.function;
+  const BaseMatType& iterate = *state.iterate;
+  Workspace<BaseMatType>& ws = state.ws;
 
   // Find the number of functions to use.
   const size_t numFunctions = function.NumFunctions();
@@ -66,44 +160,75 @@ typename MatType::elem_type CMAES<SelectionPolicyType>::Optimize(
   // Population size.
   if (lambda == 0)
     lambda = (4 + std::round(3 * std::log(iterate.n_elem))) * 10;
+  state.lambda = lambda;
 
   // Parent weights.
-  const size_t mu = std::round(lambda / 2);
-  BaseMatType w = std::log(mu + 0.5) - arma::log(
-      arma::linspace<BaseMatType>(0, mu - 1, mu) + 1.0);
+  state.mu = std::round(lambda / 2);
+  const size_t mu = state.mu;
+  BaseMatType& w = ws.w;
+  w.set_size(mu, 1);
+  for (size_t j = 0; j < mu; ++j)
+    w(j) = std::log(mu + 0.5) - std::log(j + 1.0);
   w /= arma::accu(w);
 
   // Number of effective solutions.
   const double muEffective = 1 / arma::accu(arma::pow(w, 2));
+  state.muEffective = muEffective;
 
   // Step size control parameters.
-  BaseMatType sigma(2, 1); // sigma is vector-shaped.
-  sigma(0) = 0.3 * (upperBound - lowerBound);
-  const double cs = (muEffective + 2) / (iterate.n_elem + muEffective + 5);
-  const double ds = 1 + cs + 2 * std::max(std::sqrt((muEffective - 1) /
+  state.sigma(0) = 0.3 * (upperBound - lowerBound);
+  state.cs = (muEffective + 2) / (iterate.n_elem + muEffective + 5);
+  state.ds = 1 + state.cs + 2 * std::max(std::sqrt((muEffective - 1) /
       (iterate.n_elem + 1)) - 1, 0.0);
-  const double enn = std::sqrt(iterate.n_elem) * (1.0 - 1.0 /
+  state.enn = std::sqrt(iterate.n_elem) * (1.0 - 1.0 /
       (4.0 * iterate.n_elem) + 1.0 / (21 * std::pow(iterate.n_elem, 2)));
 
   // Covariance update parameters.
   // Cumulation for distribution.
-  const double cc = (4 + muEffective / iterate.n_elem) /
+  state.cc = (4 + muEffective / iterate.n_elem) /
       (4 + iterate.n_elem + 2 * muEffective / iterate.n_elem);
-  const double h = (1.4 + 2.0 / (iterate.n_elem + 1.0)) * enn;
+  state.h = (1.4 + 2.0 / (iterate.n_elem + 1.0)) * state.enn;
 
-  const double c1 = 2 / (std::pow(iterate.n_elem + 1.3, 2) + muEffective);
+  state.c1 = 2 / (std::pow(iterate.n_elem + 1.3, 2) + muEffective);
   const double alphaMu = 2;
-  const double cmu = std::min(1 - c1, alphaMu * (muEffective - 2 + 1 /
+  state.cmu = std::min(1 - state.c1, alphaMu * (muEffective - 2 + 1 /
       muEffective) / (std::pow(iterate.n_elem + 2, 2) +
       alphaMu * muEffective / 2));
 
-  std::vector<BaseMatType> mPosition(2, BaseMatType(iterate.n_rows,
-      iterate.n_cols));
-  mPosition[0] = lowerBound + arma::randu<BaseMatType>(
-      iterate.n_rows, iterate.n_cols) * (upperBound - lowerBound);
+  // The covariance policy holds the covariance of the search distribution and
+  // may adjust the learning rates to its representation.
+  state.covariance.LearningRates(muEffective, state.c1, state.cmu);
 
-  BaseMatType step(iterate.n_rows, iterate.n_cols);
-  step.zeros();
+  // The negative weights of the worst lambda - mu candidates for the active
+  // covariance update, scaled so that their sum is bounded by the positive
+  // weights and the update stays positive definite (see Hansen's tutorial).
+  BaseMatType& negativeWeights = ws.negativeWeights;
+  if (activeCovariance && lambda > mu && state.cmu > 0)
+  {
+    negativeWeights.set_size(lambda - mu, 1);
+    for (size_t j = mu; j < lambda; ++j)
+      negativeWeights(j - mu) = std::log(mu + 0.5) - std::log(j + 1.0);
+
+    const double negativeSum = -arma::accu(negativeWeights);
+    const double muEffectiveNegative = negativeSum * negativeSum /
+        arma::accu(arma::square(negativeWeights));
+    const double alpha = std::min(std::min(1 + state.c1 / state.cmu,
+        1 + 2 * muEffectiveNegative / (muEffective + 2)),
+        (1 - state.c1 - state.cmu) / (iterate.n_elem * state.cmu));
+    negativeWeights *= std::max(alpha, 0.0) / negativeSum;
+  }
+  else
+  {
+    negativeWeights.reset();
+  }
+
+  std::vector<BaseMatType>& mPosition = ws.mPosition;
+  Resize(mPosition, 2, iterate.n_rows, iterate.n_cols);
+  state.rng.FillUniform(mPosition[0]);
+  mPosition[0] *= (upperBound - lowerBound);
+  mPosition[0] += lowerBound;
+
+  ws.step.zeros(iterate.n_rows, iterate.n_cols);
 
   // Calculate the first objective function.
   ElemType currentObjective = 0;
@@ -118,199 +243,513 @@ typename MatType::elem_type CMAES<SelectionPolicyType>::Optimize(
         callbacks...);
   }
 
-  ElemType overallObjective = currentObjective;
-  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+  state.overallObjective = currentObjective;
+  state.lastObjective = std::numeric_limits<ElemType>::max();
 
   // Population parameters.
-  std::vector<BaseMatType> pStep(lambda, BaseMatType(iterate.n_rows,
-      iterate.n_cols));
-  std::vector<BaseMatType> pPosition(lambda, BaseMatType(iterate.n_rows,
-      iterate.n_cols));
-  BaseMatType pObjective(lambda, 1); // pObjective is vector-shaped.
-  std::vector<BaseMatType> ps(2, BaseMatType(iterate.n_rows, iterate.n_cols));
-  ps[0].zeros();
-  ps[1].zeros();
-  std::vector<BaseMatType> pc = ps;
-  std::vector<BaseMatType> C(2, BaseMatType(iterate.n_elem, iterate.n_elem));
-  C[0].eye();
-
-  // Covariance matrix parameters.
-  arma::Col<ElemType> eigval; // TODO: might need a more general type.
-  BaseMatType eigvec;
-  BaseMatType eigvalZero(iterate.n_elem, 1); // eigvalZero is vector-shaped.
-  eigvalZero.zeros();
+  Resize(ws.pStep, lambda, iterate.n_rows, iterate.n_cols);
+  Resize(ws.pPosition, lambda, iterate.n_rows, iterate.n_cols);
+  ws.pObjective.set_size(lambda);
+  Resize(ws.ps, 2, iterate.n_rows, iterate.n_cols);
+  ws.ps[0].zeros();
+  ws.ps[1].zeros();
+  Resize(ws.pc, 2, iterate.n_rows, iterate.n_cols);
+  ws.pc[0].zeros();
+  ws.pc[1].zeros();
+  ws.pathStep.set_size(iterate.n_rows, iterate.n_cols);
+  ws.zNorms.set_size(lambda);
+  if (surrogate)
+    state.surrogate.Reset(iterate.n_elem);
 
   // The current visitation order (sorted by population objectives).
-  arma::uvec idx = arma::linspace<arma::uvec>(0, lambda - 1, lambda);
+  ws.idx.set_size(lambda);
+  for (size_t j = 0; j < lambda; ++j)
+    ws.idx(j) = j;
 
-  // Controls early termination of the optimization process.
-  bool terminate = false;
+  state.iterations = 1;
+}
 
-  // Now iterate!
-  terminate |= Callback::BeginOptimization(*this, function, iterate,
-      callbacks...);
-  for (size_t i = 1; i < maxIterations && !terminate; ++i)
+//! Run one generation: sample, evaluate and select the population, and adapt
+//! the search distribution.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+bool CMAES<SelectionPolicyType, CovariancePolicyType>::Iteration(
+    State<SeparableFunctionType, MatType>& state,
+    bool& terminate,
+    CallbackTypes&... callbacks)
+{
+  typedef State<SeparableFunctionType, MatType> StateType;
+  typedef typename StateType::ElemType ElemType;
+  typedef typename StateType::BaseMatType BaseMatType;
+
+  // If the full objective is selected and the function can evaluate a whole
+  // population at once, we do that.
+  const bool useEvaluateBatch = traits::HasEvaluateBatchSignature<
+      SeparableFunctionType, BaseMatType>::value &&
+      std::is_same<SelectionPolicyType, FullSelection>::value;
+
+  // A selection policy that ranks the whole population at once (e.g.
+  // AdaptiveSelection) is used for the population instead.
+  const bool useSelectPopulation = traits::HasSelectPopulation<
+      SelectionPolicyType, SeparableFunctionType, BaseMatType>::value;
+
+  // If the full objective is selected and the function can stop an
+  // evaluation once it exceeds a bound, the candidates are evaluated with the
+  // bound of the mu'th best objective so far, since only the best mu are
+  // used.  The active update and the surrogate model need the exact
+  // objectives of all candidates, so then no bound is used.
+  const bool useEvaluateBounded = traits::HasEvaluateBoundedSignature<
+      SeparableFunctionType, BaseMatType>::value &&
+      std::is_same<SelectionPolicyType, FullSelection>::value;
+
+  SeparableFunctionType& function = *state.function;
+  BaseMatType& iterate = *state.iterate;
+  Workspace<BaseMatType>& ws = state.ws;
+  std::vector<BaseMatType>& mPosition = ws.mPosition;
+  std::vector<BaseMatType>& pStep = ws.pStep;
+  std::vector<BaseMatType>& pPosition = ws.pPosition;
+  arma::Col<ElemType>& pObjective = ws.pObjective;
+  std::vector<BaseMatType>& ps = ws.ps;
+  std::vector<BaseMatType>& pc = ws.pc;
+  BaseMatType& step = ws.step;
+  arma::uvec& idx = ws.idx;
+  BaseMatType& sigma = state.sigma;
+  const BaseMatType& w = ws.w;
+  const size_t lambda = state.lambda;
+  const size_t mu = state.mu;
+  const double cs = state.cs;
+  const double cc = state.cc;
+
+  // To keep track of where we are.
+  const size_t i = state.iterations;
+  const size_t idx0 = (i - 1) % 2;
+  const size_t idx1 = i % 2;
+
+  // Prepare the covariance for sampling.
+  state.covariance.Factorize();
+
+  // Draw the standard normal samples of the whole generation at once, one per
+  // column, and transform them; with mirrored sampling, candidates 2p and
+  // 2p + 1 use sample p and its mirror.
+  const size_t n = iterate.n_elem;
+  const size_t draws = mirroredSampling ? (lambda + 1) / 2 : lambda;
+  ws.z.set_size(n, draws);
+  ws.y.set_size(n, draws);
+  state.rng.FillNormal(ws.z);
+  TransformSamples(state.covariance, ws.z, ws.y, iterate.n_rows,
+      iterate.n_cols, std::integral_constant<bool,
+      traits::HasTransformColumns<typename StateType::InstCovariancePolicyType,
+      BaseMatType>::value>());
+  const arma::Row<ElemType> drawNorms = arma::sum(arma::square(ws.z), 0);
+
+  // The candidates are pre-screened if there are enough evaluated points for
+  // a model.
+  const bool useSurrogate = surrogate &&
+      state.surrogate.Fit(mPosition[idx0], sigma(idx0));
+  const bool evaluateEach = !useSurrogate && !useEvaluateBatch &&
+      !useSelectPopulation && !parallelEvaluation;
+  size_t evaluated = lambda;
+  ElemType bestObjective = std::numeric_limits<ElemType>::max();
+  SelectionBound<ElemType> bound((useEvaluateBounded && !surrogate &&
+      ws.negativeWeights.is_empty()) ? mu : 0);
+  for (size_t j = 0; j < lambda; ++j)
   {
-    // To keep track of where we are.
-    const size_t idx0 = (i - 1) % 2;
-    const size_t idx1 = i % 2;
-
-    // Perform Cholesky decomposition. If the matrix is not positive definite,
-    // add a small value and try again.
-    BaseMatType covLower;
-    while (!arma::chol(covLower, C[idx0], "lower"))
-      C[idx0].diag() += 1e-16;
-
-    for (size_t j = 0; j < lambda; ++j)
+    const size_t p = mirroredSampling ? j / 2 : j;
+    const ElemType sign = (mirroredSampling && j % 2 == 1) ? -1 : 1;
+    const ElemType* y = ws.y.colptr(p);
+    ElemType* s = pStep[idx(j)].memptr();
+    for (size_t k = 0; k < n; ++k)
+      s[k] = sign * y[k];
+    ws.zNorms(idx(j)) = drawNorms(p);
+
+    pPosition[idx(j)] = mPosition[idx0] + sigma(idx0) * pStep[idx(j)];
+
+    // Calculate the objective function, unless the whole population is
+    // evaluated at once below.
+    if (evaluateEach)
     {
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        pStep[idx(j)] = covLower *
-            arma::randn<BaseMatType>(iterate.n_rows, iterate.n_cols);
-      }
-      else
+      pObjective(idx(j)) = EvaluateCandidate(function, pPosition[idx(j)],
+          bound.Bound(), std::integral_constant<bool, useEvaluateBounded>(),
+          callbacks...);
+      bound.Add(pObjective(idx(j)));
+      bestObjective = std::min(bestObjective, pObjective(idx(j)));
+
+      // With sequential selection, stop once a candidate improves on the best
+      // point, after at least mu candidates and a whole mirrored pair.
+      if (sequentialSelection && j + 1 >= mu && j + 1 < lambda &&
+          (!mirroredSampling || j % 2 == 1) &&
+          bestObjective < state.overallObjective)
       {
-        pStep[idx(j)] = arma::randn<BaseMatType>(iterate.n_rows, iterate.n_cols)
-            * covLower;
+        evaluated = j + 1;
+        break;
       }
+    }
+  }
 
-      pPosition[idx(j)] = mPosition[idx0] + sigma(idx0) * pStep[idx(j)];
+  // The candidates that were not evaluated are sorted last.
+  for (size_t j = evaluated; j < lambda; ++j)
+    pObjective(idx(j)) = std::numeric_limits<ElemType>::max();
 
-      // Calculate the objective function.
-      pObjective(idx(j)) = selectionPolicy.Select(function, batchSize,
-          pPosition[idx(j)], callbacks...);
+  if (useSurrogate)
+  {
+    ScreenPopulation(state, callbacks...);
+  }
+  else
+  {
+    if (useSelectPopulation)
+    {
+      SelectPopulation(function, pPosition, pObjective,
+          std::integral_constant<bool, useSelectPopulation>(), callbacks...);
+    }
+    else if (useEvaluateBatch || parallelEvaluation)
+    {
+      EvaluatePopulation(function, pPosition, pObjective,
+          std::integral_constant<bool, useEvaluateBatch>(), callbacks...);
     }
 
-    // Sort population.
-    idx = arma::sort_index(pObjective);
+    if (surrogate)
+    {
+      for (size_t j = 0; j < evaluated; ++j)
+        state.surrogate.Add(pPosition[idx(j)], pObjective(idx(j)));
+    }
+  }
 
-    step = w(0) * pStep[idx(0)];
-    for (size_t j = 1; j < mu; ++j)
-      step += w(j) * pStep[idx(j)];
+  // Sort population.
+  idx = arma::sort_index(pObjective);
 
-    mPosition[idx1] = mPosition[idx0] + sigma(idx0) * step;
+  step = w(0) * pStep[idx(0)];
+  for (size_t j = 1; j < mu; ++j)
+    step += w(j) * pStep[idx(j)];
 
-    // Calculate the objective function.
-    currentObjective = selectionPolicy.Select(function, batchSize,
-        mPosition[idx1], callbacks...);
+  mPosition[idx1] = mPosition[idx0] + sigma(idx0) * step;
 
-    // Update best parameters.
-    if (currentObjective < overallObjective)
-    {
-      overallObjective = currentObjective;
-      iterate = mPosition[idx1];
+  // Calculate the objective function.
+  const ElemType currentObjective = selectionPolicy.Select(function,
+      batchSize, mPosition[idx1], callbacks...);
+  if (surrogate)
+    state.surrogate.Add(mPosition[idx1], currentObjective);
 
-      terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
-    }
+  // Update best parameters.
+  if (currentObjective < state.overallObjective)
+  {
+    state.overallObjective = currentObjective;
+    iterate = mPosition[idx1];
 
-    // Update Step Size.
-    if (iterate.n_rows > iterate.n_cols)
-    {
-      ps[idx1] = (1 - cs) * ps[idx0] + std::sqrt(
-          cs * (2 - cs) * muEffective) * covLower.t() * step;
-    }
-    else
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+  }
+
+  // Update Step Size.
+  state.covariance.PathTransform(step, ws.pathStep);
+  ps[idx1] = (1 - cs) * ps[idx0] + std::sqrt(
+      cs * (2 - cs) * state.muEffective) * ws.pathStep;
+
+  const ElemType psNorm = arma::norm(ps[idx1]);
+  sigma(idx1) = sigma(idx0) * std::exp(cs / state.ds * (psNorm / state.enn -
+      1));
+
+  // Update covariance matrix.
+  const bool hsig = (psNorm / sqrt(1 - std::pow(1 - cs, 2 * i))) < state.h;
+  if (hsig)
+  {
+    pc[idx1] = (1 - cc) * pc[idx0] + std::sqrt(cc * (2 - cc) *
+      state.muEffective) * step;
+  }
+  else
+  {
+    pc[idx1] = (1 - cc) * pc[idx0];
+  }
+
+  // With the active update, the evaluated candidates after the best mu have
+  // negative weights, scaled by n / ||z||^2 so that the steps of long samples
+  // don't make the covariance indefinite.
+  const BaseMatType& negativeWeights = ws.negativeWeights;
+  if (activeCovariance && !negativeWeights.is_empty())
+  {
+    BaseMatType& updateWeights = ws.updateWeights;
+    updateWeights.set_size(evaluated, 1);
+    updateWeights.head_rows(mu) = w;
+    for (size_t j = mu; j < evaluated; ++j)
     {
-      ps[idx1] = (1 - cs) * ps[idx0] + std::sqrt(
-          cs * (2 - cs) * muEffective) * step * covLower.t();
+      updateWeights(j) = negativeWeights(j - mu) * ElemType(n) /
+          std::max(ws.zNorms(idx(j)), std::numeric_limits<ElemType>::min());
     }
 
-    const ElemType psNorm = arma::norm(ps[idx1]);
-    sigma(idx1) = sigma(idx0) * std::exp(cs / ds * ( psNorm / enn - 1));
+    state.covariance.Update(pc[idx1], hsig, pStep, idx, updateWeights,
+        evaluated, state.c1, state.cmu, cc);
+  }
+  else
+  {
+    state.covariance.Update(pc[idx1], hsig, pStep, idx, w, mu, state.c1,
+        state.cmu, cc);
+  }
 
-    // Update covariance matrix.
-    if ((psNorm / sqrt(1 - std::pow(1 - cs, 2 * i))) < h)
-    {
-      pc[idx1] = (1 - cc) * pc[idx0] + std::sqrt(cc * (2 - cc) *
-        muEffective) * step;
+  ++state.iterations;
 
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        C[idx1] = (1 - c1 - cmu) * C[idx0] + c1 *
-          (pc[idx1] * pc[idx1].t());
-      }
-      else
-      {
-        C[idx1] = (1 - c1 - cmu) * C[idx0] + c1 *
-          (pc[idx1].t() * pc[idx1]);
-      }
-    }
-    else
-    {
-      pc[idx1] = (1 - cc) * pc[idx0];
+  // Output current objective function.
+  Info << "CMA-ES: iteration " << i << ", objective "
+      << state.overallObjective << "." << std::endl;
 
-      if (iterate.n_rows > iterate.n_cols)
-      {
-        C[idx1] = (1 - c1 - cmu) * C[idx0] + c1 * (pc[idx1] *
-            pc[idx1].t() + (cc * (2 - cc)) * C[idx0]);
-      }
-      else
-      {
-        C[idx1] = (1 - c1 - cmu) * C[idx0] + c1 *
-            (pc[idx1].t() * pc[idx1] + (cc * (2 - cc)) * C[idx0]);
-      }
-    }
+  if (std::isnan(state.overallObjective) ||
+      std::isinf(state.overallObjective))
+  {
+    Warn << "CMA-ES: converged to " << state.overallObjective << "; "
+        << "terminating with failure.  Try a smaller step size?" << std::endl;
+    return false;
+  }
 
-    if (iterate.n_rows > iterate.n_cols)
-    {
-      for (size_t j = 0; j < mu; ++j)
-      {
-        C[idx1] = C[idx1] + cmu * w(j) *
-            pStep[idx(j)] * pStep[idx(j)].t();
-      }
-    }
-    else
+  if (std::abs(state.lastObjective - state.overallObjective) < tolerance)
+  {
+    Info << "CMA-ES: minimized within tolerance " << tolerance << "; "
+        << "terminating optimization." << std::endl;
+    return false;
+  }
+
+  state.lastObjective = state.overallObjective;
+  return true;
+}
+
+//! Pre-screen the candidates of a generation with the surrogate.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::ScreenPopulation(
+    State<SeparableFunctionType, MatType>& state,
+    CallbackTypes&... callbacks)
+{
+  typedef State<SeparableFunctionType, MatType> StateType;
+  typedef typename StateType::ElemType ElemType;
+  typedef typename StateType::BaseMatType BaseMatType;
+
+  SeparableFunctionType& function = *state.function;
+  Workspace<BaseMatType>& ws = state.ws;
+  const std::vector<BaseMatType>& pPosition = ws.pPosition;
+  arma::Col<ElemType>& pObjective = ws.pObjective;
+  QuadraticSurrogate<BaseMatType>& model = state.surrogate;
+  const size_t lambda = state.lambda;
+  const size_t idx0 = (state.iterations - 1) % 2;
+  const BaseMatType& mean = ws.mPosition[idx0];
+  const ElemType sigma = state.sigma(idx0);
+
+  arma::Col<ElemType> predicted(lambda);
+  for (size_t j = 0; j < lambda; ++j)
+    predicted(j) = model.Predict(pPosition[j]);
+  arma::uvec order = arma::sort_index(predicted);
+
+  // Evaluate the most promising candidates first, in batches that grow while
+  // the model ranks the evaluations badly.
+  size_t evaluated = 0;
+  size_t increment = std::max((size_t) 1, lambda / 10);
+  bool ranked = false;
+  while (evaluated < lambda)
+  {
+    const size_t end = std::min(lambda, evaluated + increment);
+    for (size_t k = evaluated; k < end; ++k)
     {
-      for (size_t j = 0; j < mu; ++j)
-      {
-        C[idx1] = C[idx1] + cmu * w(j) *
-            pStep[idx(j)].t() * pStep[idx(j)];
-      }
+      const size_t j = order(k);
+      pObjective(j) = selectionPolicy.Select(function, batchSize,
+          pPosition[j], callbacks...);
+      model.Add(pPosition[j], pObjective(j));
     }
+    evaluated = end;
+    if (evaluated == lambda || !model.Fit(mean, sigma))
+      continue;
 
-    arma::eig_sym(eigval, eigvec, C[idx1]);
-    const arma::uvec negativeEigval = arma::find(eigval < 0, 1);
-    if (!negativeEigval.is_empty())
+    if (model.RankCorrelation(std::max((size_t) 15, evaluated)) >=
+        surrogateRankCorrelation)
     {
-      if (negativeEigval(0) == 0)
-      {
-        C[idx1].zeros();
-      }
-      else
-      {
-        C[idx1] = eigvec.cols(0, negativeEigval(0) - 1) *
-            arma::diagmat(eigval.subvec(0, negativeEigval(0) - 1)) *
-            eigvec.cols(0, negativeEigval(0) - 1).t();
-      }
+      ranked = true;
+      break;
     }
 
-    // Output current objective function.
-    Info << "CMA-ES: iteration " << i << ", objective " << overallObjective
-        << "." << std::endl;
+    // Visit the remaining candidates in the order of the new model.
+    for (size_t k = evaluated; k < lambda; ++k)
+      predicted(order(k)) = model.Predict(pPosition[order(k)]);
+    const arma::uvec remaining = order.tail(lambda - evaluated);
+    const arma::uvec sorted = arma::sort_index(predicted.elem(remaining));
+    order.tail(lambda - evaluated) = remaining.elem(sorted);
+    increment = (increment * 3 + 1) / 2;
+  }
 
-    if (std::isnan(overallObjective) || std::isinf(overallObjective))
-    {
-      Warn << "CMA-ES: converged to " << overallObjective << "; "
-          << "terminating with failure.  Try a smaller step size?" << std::endl;
+  // The generation is ranked by the model.
+  if (ranked)
+  {
+    for (size_t j = 0; j < lambda; ++j)
+      pObjective(j) = model.Predict(pPosition[j]);
+  }
+}
 
-      Callback::EndOptimization(*this, function, iterate, callbacks...);
-      return overallObjective;
-    }
+//! Transform all the samples with one call to TransformColumns().
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename PolicyType, typename MatType>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::TransformSamples(
+    const PolicyType& covariance,
+    const MatType& z,
+    MatType& y,
+    const size_t rows,
+    const size_t cols,
+    const std::true_type /* hasTransformColumns */)
+{
+  if (cols == 1)
+  {
+    covariance.TransformColumns(z, y);
+    return;
+  }
 
-    if (std::abs(lastObjective - overallObjective) < tolerance)
-    {
-      Info << "CMA-ES: minimized within tolerance " << tolerance << "; "
-          << "terminating optimization." << std::endl;
+  TransformSamples(covariance, z, y, rows, cols, std::false_type());
+}
 
-      Callback::EndOptimization(*this, function, iterate, callbacks...);
-      return overallObjective;
-    }
+//! Transform each sample with Transform().
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename PolicyType, typename MatType>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::TransformSamples(
+    const PolicyType& covariance,
+    const MatType& z,
+    MatType& y,
+    const size_t rows,
+    const size_t cols,
+    const std::false_type /* hasTransformColumns */)
+{
+  typedef typename MatType::elem_type ElemType;
 
-    lastObjective = overallObjective;
+  for (size_t j = 0; j < z.n_cols; ++j)
+  {
+    // Each column is seen as a matrix of the shape of the iterate.
+    const MatType zj(const_cast<ElemType*>(z.colptr(j)), rows, cols, false,
+        true);
+    MatType yj(y.colptr(j), rows, cols, false, true);
+    covariance.Transform(zj, yj);
+  }
+}
+
+//! Give the vector n matrices of the given size, reusing their memory.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename MatType>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::Resize(
+    std::vector<MatType>& matrices,
+    const size_t n,
+    const size_t rows,
+    const size_t cols)
+{
+  matrices.resize(n);
+  for (size_t i = 0; i < n; ++i)
+    matrices[i].set_size(rows, cols);
+}
+
+//! Evaluate the population with the EvaluateBatch() method of the function.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::EvaluatePopulation(
+    SeparableFunctionType& function,
+    const std::vector<MatType>& population,
+    arma::Col<typename MatType::elem_type>& objectives,
+    const std::true_type /* useEvaluateBatch */,
+    CallbackTypes&... callbacks)
+{
+  EvaluateBatch(function, population, objectives);
+
+  for (size_t j = 0; j < population.size(); ++j)
+  {
+    Callback::Evaluate(*this, function, population[j], objectives(j),
+        callbacks...);
+  }
+}
+
+//! Evaluate the population in parallel with the selection policy.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::EvaluatePopulation(
+    SeparableFunctionType& function,
+    const std::vector<MatType>& population,
+    arma::Col<typename MatType::elem_type>& objectives,
+    const std::false_type /* useEvaluateBatch */,
+    CallbackTypes&... callbacks)
+{
+  // Each candidate is evaluated with the random number generator of its
+  // thread seeded from its own seed, and the generator of this thread is
+  // reseeded afterwards; so the results only depend on the seed, not on the
+  // number of threads or on scheduling.
+  const arma::uvec seeds = arma::randi<arma::uvec>(population.size() + 1,
+      arma::distr_param(0, std::numeric_limits<int>::max()));
+
+  ParallelFor(population.size(), [&](const size_t j)
+  {
+    arma::arma_rng::set_seed(seeds(j));
+    objectives(j) = selectionPolicy.Select(function, batchSize, population[j],
+        callbacks...);
+  });
+
+  arma::arma_rng::set_seed(seeds(population.size()));
+}
+
+//! Evaluate a candidate with the EvaluateBounded() method of the function.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+CMAES<SelectionPolicyType, CovariancePolicyType>::EvaluateCandidate(
+    SeparableFunctionType& function,
+    const MatType& candidate,
+    const typename MatType::elem_type bound,
+    const std::true_type /* useEvaluateBounded */,
+    CallbackTypes&... callbacks)
+{
+  const typename MatType::elem_type objective = EvaluateBounded(function,
+      candidate, bound);
+  Callback::Evaluate(*this, function, candidate, objective, callbacks...);
+  return objective;
+}
+
+//! Calculate the objectives of the population with the selection policy.
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+void CMAES<SelectionPolicyType, CovariancePolicyType>::SelectPopulation(
+    SeparableFunctionType& function,
+    const std::vector<MatType>& population,
+    arma::Col<typename MatType::elem_type>& objectives,
+    const std::true_type /* useSelectPopulation */,
+    CallbackTypes&... callbacks)
+{
+  selectionPolicy.SelectPopulation(function, batchSize, population,
+      objectives, callbacks...);
+}
+
+template<typename SelectionPolicyType, typename CovariancePolicyType>
+template<typename MatType, typename GradType>
+size_t CMAES<SelectionPolicyType, CovariancePolicyType>::StateBytes(
+    const size_t rows,
+    const size_t cols) const
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatType::elem_type ElemType;
+
+  // See Initialize() and Iteration().
+  const size_t n = rows * cols;
+  const size_t populationSize = (lambda == 0) ?
+      (4 + std::round(3 * std::log(n))) * 10 : lambda;
+  const size_t draws = mirroredSampling ? (populationSize + 1) / 2 :
+      populationSize;
+
+  size_t bytes =
+      ens::PolicyStateBytes<BaseMatType>(covariancePolicy, rows, cols) +
+      (2 * populationSize + 2 * draws + 8) * n * sizeof(ElemType) +
+      populationSize * (2 * sizeof(ElemType) + sizeof(arma::uword));
+  if (surrogate)
+  {
+    bytes += QuadraticSurrogate<BaseMatType>::Capacity(n) * (n + 1) *
+        sizeof(ElemType);
   }
 
-  Callback::EndOptimization(*this, function, iterate, callbacks...);
-  return overallObjective;
+  return bytes;
 }
 
 } // namespace ens
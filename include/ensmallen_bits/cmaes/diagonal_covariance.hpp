@@ -0,0 +1,182 @@
+/**
+ * @file diagonal_covariance.hpp
+ *
+ * Diagonal covariance matrix adaptation for CMA-ES (sep-CMA-ES).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_DIAGONAL_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_DIAGONAL_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Adapt only the diagonal of the covariance matrix of the search distribution,
+ * as in sep-CMA-ES.  Memory and time per generation are O(n), so this can be
+ * used for problems with very many dimensions; the price is that correlations
+ * between the decision variables are not learned.  As proposed in the paper,
+ * the learning rates are increased by a factor of (n + 2) / 3.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Ros2008,
+ *   author    = {Ros, Raymond and Hansen, Nikolaus},
+ *   title     = {A Simple Modification in CMA-ES Achieving Linear Time and
+ *                Space Complexity},
+ *   booktitle = {Parallel Problem Solving from Nature -- PPSN X},
+ *   year      = {2008},
+ *   pages     = {296--305},
+ *   publisher = {Springer}
+ * }
+ * @endcode
+ *
+ * See FullCovariance for the interface of covariance policies.
+ */
+class DiagonalCovariance
+{
+ public:
+  //! Return the number of bytes of state that the policy keeps for iterates
+  //! of the given size: the diagonal and its square root.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<MatType>(rows, cols); }
+
+  /**
+   * The Policy holds the diagonal of the covariance matrix.
+   *
+   * @tparam MatType Type of the iterate.
+   */
+  template<typename MatType>
+  class Policy
+  {
+   public:
+    /**
+     * Initialize the covariance to the identity.
+     *
+     * @param parent Instantiated parent policy.
+     * @param rows Number of rows of the iterate.
+     * @param cols Number of columns of the iterate.
+     */
+    Policy(const DiagonalCovariance& /* parent */,
+           const size_t rows,
+           const size_t cols) :
+        d(rows, cols, arma::fill::ones),
+        sqrtD(rows, cols, arma::fill::ones)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Increase the learning rates by a factor of (n + 2) / 3.
+     *
+     * @param muEffective Number of effective solutions.
+     * @param c1 Learning rate of the rank-one update.
+     * @param cmu Learning rate of the rank-mu update.
+     */
+    void LearningRates(const double /* muEffective */, double& c1, double& cmu)
+    {
+      const double factor = (d.n_elem + 2.0) / 3.0;
+      c1 = std::min(1.0, c1 * factor);
+      cmu = std::min(1.0 - c1, cmu * factor);
+    }
+
+    /**
+     * Compute the square root of the diagonal.
+     */
+    void Factorize()
+    {
+      sqrtD = arma::sqrt(d);
+    }
+
+    /**
+     * Scale the standard normal sample z by the standard deviations.
+     *
+     * @param z Standard normal sample.
+     * @param y Matrix to store the step into.
+     */
+    void Transform(const MatType& z, MatType& y) const
+    {
+      y = z % sqrtD;
+    }
+
+    /**
+     * Scale the standard normal samples of a column iterate, one per column,
+     * by the standard deviations.
+     *
+     * @param z Standard normal samples.
+     * @param y Matrix to store the steps into.
+     */
+    void TransformColumns(const MatType& z, MatType& y) const
+    {
+      y = z.each_col() % arma::vectorise(sqrtD);
+    }
+
+    /**
+     * Scale the mean step by the inverse standard deviations, for the step
+     * size evolution path.
+     *
+     * @param step Weighted mean of the best steps.
+     * @param out Matrix to store the transformed step into.
+     */
+    void PathTransform(const MatType& step, MatType& out) const
+    {
+      out = step / sqrtD;
+    }
+
+    /**
+     * Apply the rank-one and rank-mu updates to the diagonal.
+     *
+     * @param pc Evolution path of the covariance.
+     * @param hsig Whether or not the evolution path was updated.
+     * @param steps Steps of the population.
+     * @param order Indices of the steps sorted by objective.
+     * @param weights Weights of the best mu steps (the last ones may be
+     *     negative).
+     * @param mu Number of steps used for the update.
+     * @param c1 Learning rate of the rank-one update.
+     * @param cmu Learning rate of the rank-mu update.
+     * @param cc Cumulation constant of the evolution path.
+     */
+    void Update(const MatType& pc,
+                const bool hsig,
+                const std::vector<MatType>& steps,
+                const arma::uvec& order,
+                const MatType& weights,
+                const size_t mu,
+                const double c1,
+                const double cmu,
+                const double cc)
+    {
+      // The weights sum to one, unless some are negative (active update).
+      const double decay = 1 - c1 - cmu * arma::accu(weights.head_rows(mu));
+      if (hsig)
+        d = decay * d + c1 * arma::square(pc);
+      else
+        d = decay * d + c1 * (arma::square(pc) + (cc * (2 - cc)) * d);
+
+      for (size_t j = 0; j < mu; ++j)
+        d += cmu * weights(j) * arma::square(steps[order(j)]);
+
+      // Keep the distribution from collapsing in any coordinate.
+      d.clamp(std::numeric_limits<typename MatType::elem_type>::min(),
+          std::numeric_limits<typename MatType::elem_type>::max());
+    }
+
+    //! Get the diagonal of the covariance matrix.
+    const MatType& Covariance() const { return d; }
+
+   private:
+    //! The diagonal of the covariance matrix.
+    MatType d;
+    //! The square root of the diagonal.
+    MatType sqrtD;
+  };
+};
+
+} // namespace ens
+
+#endif
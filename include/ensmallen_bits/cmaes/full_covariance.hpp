@@ -0,0 +1,291 @@
+/**
+ * @file full_covariance.hpp
+ *
+ * Full covariance matrix adaptation for CMA-ES.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_FULL_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_FULL_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Adapt the full n x n covariance matrix of the search distribution, as in the
+ * original CMA-ES.  This needs O(n^2) memory, and an O(n^3) Cholesky
+ * factorization that is only refreshed every max(1, 1 / (10 n (c1 + cmu)))
+ * generations; in between, the previous factor is reused, as proposed by
+ * Hansen.  With LazyFactorization() set to false, the factor is refreshed in
+ * every generation instead.  It is best suited to problems with up to a few
+ * thousand dimensions; see DiagonalCovariance and LimitedMemoryCovariance for
+ * larger problems.
+ *
+ * A covariance policy is a class with an inner class template Policy<MatType>
+ * that holds the state for a given matrix type.  Policy is constructed with the
+ * parent object and the shape of the iterate, and provides the following
+ * methods:
+ *
+ * @code
+ * // Adjust the default learning rates of the rank-one and rank-mu updates.
+ * void LearningRates(const double muEffective, double& c1, double& cmu);
+ *
+ * // Prepare the sampling transformation for the next generation.
+ * void Factorize();
+ *
+ * // Transform a standard normal sample z into a step y ~ N(0, C).
+ * void Transform(const MatType& z, MatType& y);
+ *
+ * // (Optional.) Transform many standard normal samples of a column iterate,
+ * // one per column, at once.
+ * void TransformColumns(const MatType& z, MatType& y);
+ *
+ * // Transform the mean step for the step size evolution path.
+ * void PathTransform(const MatType& step, MatType& out);
+ *
+ * // Update the covariance from the evolution path pc and the best mu steps;
+ * // with the active update, the weights after the best ones are negative.
+ * void Update(const MatType& pc, const bool hsig,
+ *             const std::vector<MatType>& steps, const arma::uvec& order,
+ *             const MatType& weights, const size_t mu, const double c1,
+ *             const double cmu, const double cc);
+ * @endcode
+ */
+class FullCovariance
+{
+ public:
+  /**
+   * Construct the full covariance policy.
+   *
+   * @param lazyFactorization If true, the Cholesky factor is only refreshed
+   *     every few generations; otherwise, it is refreshed in every generation.
+   */
+  FullCovariance(const bool lazyFactorization = true) :
+      lazyFactorization(lazyFactorization)
+  { /* Nothing to do. */ }
+
+  //! Get whether or not the factorization is only refreshed every few
+  //! generations.
+  bool LazyFactorization() const { return lazyFactorization; }
+  //! Modify whether or not the factorization is only refreshed every few
+  //! generations.
+  bool& LazyFactorization() { return lazyFactorization; }
+
+  //! Return the number of bytes of state that the policy keeps for iterates
+  //! of the given size: the covariance matrix and its Cholesky factor.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<MatType>(rows * cols, rows * cols); }
+
+  /**
+   * The Policy holds the covariance matrix and its Cholesky factor.
+   *
+   * @tparam MatType Type of the iterate.
+   */
+  template<typename MatType>
+  class Policy
+  {
+   public:
+    /**
+     * Initialize the covariance to the identity.
+     *
+     * @param parent Instantiated parent policy.
+     * @param rows Number of rows of the iterate.
+     * @param cols Number of columns of the iterate.
+     */
+    Policy(const FullCovariance& parent,
+           const size_t rows,
+           const size_t cols) :
+        C(rows * cols, rows * cols, arma::fill::eye),
+        lazy(parent.LazyFactorization()),
+        interval(1),
+        generation(0),
+        factorizations(0)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * The default learning rates are used for the full covariance; with the
+     * lazy factorization, they determine how often it is refreshed.
+     *
+     * @param muEffective Number of effective solutions.
+     * @param c1 Learning rate of the rank-one update.
+     * @param cmu Learning rate of the rank-mu update.
+     */
+    void LearningRates(const double /* muEffective */,
+                       double& c1,
+                       double& cmu)
+    {
+      const double generations = 1.0 / (10.0 * C.n_rows * (c1 + cmu));
+      interval = lazy ? std::max((size_t) 1, (size_t) std::floor(generations)) :
+          1;
+    }
+
+    /**
+     * Refresh the Cholesky decomposition of the covariance, if it is due.  If
+     * the matrix is not positive definite because of round-off errors, its
+     * negative eigenvalues are clipped, and an increasing value is added to
+     * the diagonal until the factorization succeeds.
+     */
+    void Factorize()
+    {
+      if ((generation++ % interval) != 0)
+        return;
+
+      ++factorizations;
+
+      // Remove the asymmetry that accumulates from round-off errors.
+      C = 0.5 * (C + C.t());
+      if (arma::chol(covLower, C, "lower"))
+        return;
+
+      arma::eig_sym(eigval, eigvec, C);
+      eigval.clamp(0, std::numeric_limits<ElemType>::max());
+      C = eigvec * arma::diagmat(eigval) * eigvec.t();
+
+      ElemType jitter = std::max(ElemType(1), C.diag().max()) *
+          std::numeric_limits<ElemType>::epsilon();
+      while (!arma::chol(covLower, C, "lower"))
+      {
+        C.diag() += jitter;
+        jitter *= 10;
+      }
+    }
+
+    /**
+     * Transform the standard normal sample z with the Cholesky factor.
+     *
+     * @param z Standard normal sample.
+     * @param y Matrix to store the step into.
+     */
+    void Transform(const MatType& z, MatType& y) const
+    {
+      if (z.n_rows > z.n_cols)
+        y = covLower * z;
+      else
+        y = z * covLower;
+    }
+
+    /**
+     * Transform the standard normal samples of a column iterate, one per
+     * column, with a single product with the Cholesky factor.
+     *
+     * @param z Standard normal samples.
+     * @param y Matrix to store the steps into.
+     */
+    void TransformColumns(const MatType& z, MatType& y) const
+    {
+      y = covLower * z;
+    }
+
+    /**
+     * Transform the mean step with the transposed Cholesky factor, for the
+     * step size evolution path.
+     *
+     * @param step Weighted mean of the best steps.
+     * @param out Matrix to store the transformed step into.
+     */
+    void PathTransform(const MatType& step, MatType& out) const
+    {
+      if (step.n_rows > step.n_cols)
+        out = covLower.t() * step;
+      else
+        out = step * covLower.t();
+    }
+
+    /**
+     * Apply the rank-one and rank-mu updates to the covariance in place.  The
+     * rank-mu update is computed as a single matrix product of the best mu
+     * steps.
+     *
+     * @param pc Evolution path of the covariance.
+     * @param hsig Whether or not the evolution path was updated.
+     * @param steps Steps of the population.
+     * @param order Indices of the steps sorted by objective.
+     * @param weights Weights of the best mu steps (the last ones may be
+     *     negative).
+     * @param mu Number of steps used for the update.
+     * @param c1 Learning rate of the rank-one update.
+     * @param cmu Learning rate of the rank-mu update.
+     * @param cc Cumulation constant of the evolution path.
+     */
+    void Update(const MatType& pc,
+                const bool hsig,
+                const std::vector<MatType>& steps,
+                const arma::uvec& order,
+                const MatType& weights,
+                const size_t mu,
+                const double c1,
+                const double cmu,
+                const double cc)
+    {
+      // Without the update of the evolution path, its variance is compensated
+      // by a fraction of the old covariance.  The weights sum to one, unless
+      // some are negative (active update).
+      const double weightSum = arma::accu(weights.head_rows(mu));
+      const double decay = hsig ? (1 - c1 - cmu * weightSum) :
+          (1 - c1 - cmu * weightSum + c1 * cc * (2 - cc));
+
+      // Steps and the evolution path are treated as columns regardless of
+      // their shape.
+      const arma::Col<ElemType> pcCol(const_cast<ElemType*>(pc.memptr()),
+          pc.n_elem, false, true);
+
+      samples.set_size(C.n_rows, mu);
+      for (size_t j = 0; j < mu; ++j)
+      {
+        std::copy(steps[order(j)].begin(), steps[order(j)].end(),
+            samples.colptr(j));
+      }
+      weightedSamples = samples.each_row() %
+          (cmu * weights.head_rows(mu).t());
+
+      C *= decay;
+      C += c1 * pcCol * pcCol.t();
+      C += weightedSamples * samples.t();
+    }
+
+    //! Get the covariance matrix.
+    const MatType& Covariance() const { return C; }
+
+    //! Get the number of times the factorization was refreshed.
+    size_t Factorizations() const { return factorizations; }
+
+   private:
+    typedef typename MatType::elem_type ElemType;
+
+    //! The covariance matrix.
+    MatType C;
+    //! The lower Cholesky factor of the covariance matrix.
+    MatType covLower;
+    //! Whether or not the factorization is only refreshed every few
+    //! generations.
+    bool lazy;
+    //! The number of generations between refreshes of the factorization.
+    size_t interval;
+    //! The number of generations so far.
+    size_t generation;
+    //! The number of refreshes of the factorization so far.
+    size_t factorizations;
+    //! The best mu steps, one per column.
+    MatType samples;
+    //! The best mu steps scaled by their weights and the learning rate.
+    MatType weightedSamples;
+    //! Eigenvalues of the covariance matrix.
+    arma::Col<ElemType> eigval;
+    //! Eigenvectors of the covariance matrix.
+    MatType eigvec;
+  };
+
+ private:
+  //! Whether or not the factorization is only refreshed every few
+  //! generations.
+  bool lazyFactorization;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * @file limited_memory_covariance.hpp
+ *
+ * Limited-memory covariance matrix adaptation for CMA-ES (LM-CMA-ES).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_LIMITED_MEMORY_COVARIANCE_HPP
+#define ENSMALLEN_CMAES_LIMITED_MEMORY_COVARIANCE_HPP
+
+namespace ens {
+
+/**
+ * Represent the Cholesky factor A of the covariance matrix C = A A^T of the
+ * search distribution implicitly by the last m rank-one updates, as in
+ * LM-CMA-ES.  Each rank-one update C' = (1 - c1) C + c1 pc pc^T is applied to
+ * the factor as A' = A (a I + b v v^T) with v = A^{-1} pc, so only the vectors
+ * v and the scalars b have to be stored, and both A z and A^{-1} z can be
+ * computed in O(mn) time.  The rank-mu update is not used, and the learning
+ * rate of the rank-one update is set to 1 / (10 log(n + 1)) as proposed in the
+ * paper.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Loshchilov2014,
+ *   author    = {Loshchilov, Ilya},
+ *   title     = {A Computationally Efficient Limited Memory CMA-ES for Large
+ *                Scale Optimization},
+ *   booktitle = {Proceedings of the 2014 Annual Conference on Genetic and
+ *                Evolutionary Computation},
+ *   year      = {2014},
+ *   pages     = {397--404},
+ *   publisher = {ACM}
+ * }
+ * @endcode
+ *
+ * See FullCovariance for the interface of covariance policies.
+ */
+class LimitedMemoryCovariance
+{
+ public:
+  /**
+   * Construct the limited-memory covariance policy.
+   *
+   * @param memory Number of rank-one updates to keep (0 uses 4 + 3 log(n)).
+   */
+  LimitedMemoryCovariance(const size_t memory = 0) : memory(memory)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the number of rank-one updates to keep.
+  size_t Memory() const { return memory; }
+  //! Modify the number of rank-one updates to keep.
+  size_t& Memory() { return memory; }
+
+  //! Return the number of bytes of state that the policy keeps for iterates
+  //! of the given size: the stored rank-one updates.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    const size_t stored = (memory == 0) ?
+        4 + (size_t) std::floor(3 * std::log((double) (rows * cols))) : memory;
+    return stored * MatrixBytes<MatType>(rows, cols);
+  }
+
+  /**
+   * The Policy holds the stored rank-one updates of the Cholesky factor.
+   *
+   * @tparam MatType Type of the iterate.
+   */
+  template<typename MatType>
+  class Policy
+  {
+   public:
+    /**
+     * Initialize the covariance to the identity.
+     *
+     * @param parent Instantiated parent policy.
+     * @param rows Number of rows of the iterate.
+     * @param cols Number of columns of the iterate.
+     */
+    Policy(const LimitedMemoryCovariance& parent,
+           const size_t rows,
+           const size_t cols) :
+        memory(parent.Memory() == 0 ?
+            4 + (size_t) std::floor(3 * std::log((double) (rows * cols))) :
+            parent.Memory()),
+        n(rows * cols),
+        a(1)
+    {
+      // Nothing to do.
+    }
+
+    /**
+     * Use the learning rate 1 / (10 log(n + 1)) for the rank-one update, and no
+     * rank-mu update.
+     *
+     * @param muEffective Number of effective solutions.
+     * @param c1 Learning rate of the rank-one update.
+     * @param cmu Learning rate of the rank-mu update.
+     */
+    void LearningRates(const double /* muEffective */, double& c1, double& cmu)
+    {
+      c1 = 1.0 / (10.0 * std::log(n + 1.0));
+      cmu = 0;
+      a = std::sqrt(1 - c1);
+    }
+
+    //! Nothing needs to be prepared for sampling.
+    void Factorize() { }
+
+    /**
+     * Apply the Cholesky factor to the standard normal sample z.
+     *
+     * @param z Standard normal sample.
+     * @param y Matrix to store the step into.
+     */
+    void Transform(const MatType& z, MatType& y) const
+    {
+      // A = (a I + b_1 v_1 v_1^T) ... (a I + b_m v_m v_m^T), so the most recent
+      // factor is applied first.
+      y = z;
+      for (size_t t = v.size(); t > 0; --t)
+        y = a * y + (b[t - 1] * arma::dot(v[t - 1], y)) * v[t - 1];
+    }
+
+    /**
+     * Apply the inverse of the Cholesky factor to the mean step, for the step
+     * size evolution path.
+     *
+     * @param step Weighted mean of the best steps.
+     * @param out Matrix to store the transformed step into.
+     */
+    void PathTransform(const MatType& step, MatType& out) const
+    {
+      InverseTransform(step, out);
+    }
+
+    /**
+     * Apply the rank-one update to the Cholesky factor, dropping the oldest
+     * update if the memory is full.
+     *
+     * @param pc Evolution path of the covariance.
+     * @param hsig Whether or not the evolution path was updated.
+     * @param steps Steps of the population.
+     * @param order Indices of the steps sorted by objective.
+     * @param weights Weights of the best mu steps.
+     * @param mu Number of steps used for the update.
+     * @param c1 Learning rate of the rank-one update.
+     * @param cmu Learning rate of the rank-mu update.
+     * @param cc Cumulation constant of the evolution path.
+     */
+    void Update(const MatType& pc,
+                const bool hsig,
+                const std::vector<MatType>& /* steps */,
+                const arma::uvec& /* order */,
+                const MatType& /* weights */,
+                const size_t /* mu */,
+                const double c1,
+                const double /* cmu */,
+                const double /* cc */)
+    {
+      // The evolution path is stale if its update was stalled.
+      if (!hsig || memory == 0)
+        return;
+
+      MatType newV;
+      InverseTransform(pc, newV);
+      const double norm = arma::dot(newV, newV);
+      if (norm <= 0 || !std::isfinite(norm))
+        return;
+
+      const double newB = a / norm * (std::sqrt(1 + c1 / (1 - c1) * norm) - 1);
+
+      if (v.size() == memory)
+      {
+        v.erase(v.begin());
+        b.erase(b.begin());
+        bInv.erase(bInv.begin());
+      }
+
+      v.push_back(std::move(newV));
+      b.push_back(newB);
+      bInv.push_back(newB / (a + newB * norm));
+    }
+
+   private:
+    /**
+     * Apply the inverse of the Cholesky factor.  The inverse of each factor is
+     * (I - b / (a + b |v|^2) v v^T) / a, and the oldest is applied first.
+     */
+    void InverseTransform(const MatType& x, MatType& y) const
+    {
+      y = x;
+      for (size_t t = 0; t < v.size(); ++t)
+        y = (y - (bInv[t] * arma::dot(v[t], y)) * v[t]) / a;
+    }
+
+    //! The number of rank-one updates to keep.
+    size_t memory;
+    //! The number of dimensions.
+    size_t n;
+    //! The scaling of each factor, sqrt(1 - c1).
+    double a;
+    //! The stored vectors v.
+    std::vector<MatType> v;
+    //! The stored coefficients b.
+    std::vector<double> b;
+    //! The coefficients of the inverse factors, b / (a + b |v|^2).
+    std::vector<double> bInv;
+  };
+
+ private:
+  //! The number of rank-one updates to keep.
+  size_t memory;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * @file quadratic_surrogate.hpp
+ *
+ * A linear-quadratic surrogate of the objective, fit on an archive of the
+ * evaluated points, which CMAES can use to pre-screen its candidates
+ * (lq-CMA-ES).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CMAES_QUADRATIC_SURROGATE_HPP
+#define ENSMALLEN_CMAES_QUADRATIC_SURROGATE_HPP
+
+namespace ens {
+
+/**
+ * QuadraticSurrogate keeps an archive of the most recent evaluated points and
+ * their objectives, and fits a model of the objective to them by least
+ * squares, as proposed for lq-CMA-ES:
+ *
+ * @code
+ * @inproceedings{Hansen2019,
+ *   author    = {Hansen, Nikolaus},
+ *   title     = {A Global Surrogate Assisted CMA-ES},
+ *   booktitle = {Proceedings of the Genetic and Evolutionary Computation
+ *                Conference},
+ *   year      = {2019},
+ *   pages     = {664--672}
+ * }
+ * @endcode
+ *
+ * The model is the richest of a linear, a diagonal quadratic and a full
+ * quadratic model whose number of coefficients times 1.1 does not exceed the
+ * number of archived points; it is fit on the most recent points (at most
+ * twice its number of coefficients), in the coordinates (x - m) / sigma of the
+ * current search distribution, so that it stays well conditioned as the step
+ * size shrinks.  The archive is limited to a number of points that depends on
+ * the dimension, so the full quadratic model is only used for small problems
+ * (with up to about 30 variables).
+ *
+ * @tparam MatType Type of the iterate.
+ */
+template<typename MatType>
+class QuadraticSurrogate
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Create an empty surrogate; Reset() must be called before use.
+  QuadraticSurrogate() : n(0), count(0), next(0), dof(0), scale(1) { }
+
+  //! Return the number of points that the archive holds for points with the
+  //! given number of elements.
+  static size_t Capacity(const size_t elements)
+  {
+    const size_t diagonal = 2 * elements + 1;
+    const size_t full = (elements + 1) * (elements + 2) / 2;
+    return std::max(2 * diagonal, std::min(2 * full, (size_t) 1000));
+  }
+
+  /**
+   * Clear the archive and the model, for points with the given number of
+   * elements.
+   *
+   * @param elements Number of elements of each point.
+   */
+  void Reset(const size_t elements)
+  {
+    n = elements;
+    const size_t capacity = Capacity(n);
+
+    points.set_size(n, capacity);
+    values.set_size(capacity);
+    count = 0;
+    next = 0;
+    dof = 0;
+  }
+
+  /**
+   * Add an evaluated point to the archive, replacing the oldest one if the
+   * archive is full.
+   *
+   * @param x The point.
+   * @param objective The objective of the point.
+   */
+  void Add(const MatType& x, const ElemType objective)
+  {
+    if (!std::isfinite(objective))
+      return;
+
+    std::copy(x.begin(), x.end(), points.colptr(next));
+    values(next) = objective;
+    next = (next + 1) % points.n_cols;
+    count = std::min(count + 1, (size_t) points.n_cols);
+  }
+
+  //! Get the number of archived points.
+  size_t Size() const { return count; }
+
+  /**
+   * Fit the model to the archive, in the coordinates of the given search
+   * distribution.  Return false (and leave no model) if there are not enough
+   * points for any model, or if the least squares problem can't be solved.
+   *
+   * @param mean The mean of the search distribution.
+   * @param sigma The step size of the search distribution.
+   */
+  bool Fit(const MatType& mean, const ElemType sigma)
+  {
+    const size_t models[3] = { (n + 1) * (n + 2) / 2, 2 * n + 1, n + 1 };
+    dof = 0;
+    for (size_t k = 0; k < 3 && dof == 0; ++k)
+    {
+      if (1.1 * models[k] <= count)
+        dof = models[k];
+    }
+
+    if (dof == 0)
+      return false;
+
+    center = arma::vectorise(mean);
+    scale = (sigma > 0) ? sigma : ElemType(1);
+
+    // The most recent points, newest first.
+    const size_t used = std::min(count, 2 * dof);
+    arma::Mat<ElemType> features(used, dof);
+    arma::Col<ElemType> targets(used);
+    arma::Row<ElemType> row(dof);
+    for (size_t k = 0; k < used; ++k)
+    {
+      const size_t j = Recent(k);
+      Features(points.colptr(j), row);
+      features.row(k) = row;
+      targets(k) = values(j);
+    }
+
+    if (!arma::solve(coefficients, features, targets,
+        arma::solve_opts::no_approx) || !coefficients.is_finite())
+    {
+      dof = 0;
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Return the prediction of the model for the given point; Fit() must have
+   * succeeded.
+   *
+   * @param x The point.
+   */
+  ElemType Predict(const MatType& x) const
+  {
+    return PredictPoint(x.memptr());
+  }
+
+  /**
+   * Return the Kendall rank correlation between the predictions of the model
+   * and the objectives of the given number of most recent archived points
+   * (1 if the ranks agree, -1 if they are reversed).
+   *
+   * @param recent Number of most recent points.
+   */
+  double RankCorrelation(const size_t recent) const
+  {
+    const size_t c = std::min(recent, count);
+    if (c < 2)
+      return 1.0;
+
+    arma::Col<ElemType> predicted(c), actual(c);
+    for (size_t k = 0; k < c; ++k)
+    {
+      predicted(k) = PredictPoint(points.colptr(Recent(k)));
+      actual(k) = values(Recent(k));
+    }
+
+    double concordance = 0;
+    for (size_t a = 0; a < c; ++a)
+    {
+      for (size_t b = a + 1; b < c; ++b)
+      {
+        const ElemType product = (predicted(a) - predicted(b)) *
+            (actual(a) - actual(b));
+        concordance += (product > 0) ? 1 : ((product < 0) ? -1 : 0);
+      }
+    }
+
+    return 2 * concordance / (c * (c - 1.0));
+  }
+
+ private:
+  //! Return the archive column of the k'th most recent point.
+  size_t Recent(const size_t k) const
+  {
+    return (next + points.n_cols - 1 - k) % points.n_cols;
+  }
+
+  //! Compute the features of the model of the given point.
+  void Features(const ElemType* x, arma::Row<ElemType>& row) const
+  {
+    row(0) = 1;
+    for (size_t i = 0; i < n; ++i)
+      row(1 + i) = (x[i] - center(i)) / scale;
+
+    if (dof == 2 * n + 1)
+    {
+      for (size_t i = 0; i < n; ++i)
+        row(1 + n + i) = row(1 + i) * row(1 + i);
+    }
+    else if (dof > 2 * n + 1)
+    {
+      size_t k = 1 + n;
+      for (size_t i = 0; i < n; ++i)
+        for (size_t j = i; j < n; ++j)
+          row(k++) = row(1 + i) * row(1 + j);
+    }
+  }
+
+  //! Return the prediction of the model for the given point.
+  ElemType PredictPoint(const ElemType* x) const
+  {
+    arma::Row<ElemType> row(dof);
+    Features(x, row);
+    return arma::dot(row, coefficients);
+  }
+
+  //! The number of elements of each point.
+  size_t n;
+  //! The archived points, one per column.
+  arma::Mat<ElemType> points;
+  //! The objectives of the archived points.
+  arma::Col<ElemType> values;
+  //! The number of archived points.
+  size_t count;
+  //! The column of the next archived point.
+  size_t next;
+  //! The number of coefficients of the model (0 if there is no model).
+  size_t dof;
+  //! The coefficients of the model.
+  arma::Col<ElemType> coefficients;
+  //! The center of the coordinates of the model.
+  arma::Col<ElemType> center;
+  //! The scale of the coordinates of the model.
+  ElemType scale;
+};
+
+} // namespace ens
+
+#endif
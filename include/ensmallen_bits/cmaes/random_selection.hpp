@@ -54,11 +54,14 @@ class RandomSelection
     // Find the number of functions to use.
     const size_t numFunctions = function.NumFunctions();
 
+    // The stream is seeded from the generator of Armadillo of this thread,
+    // which CMAES seeds for each candidate that is evaluated in parallel.
+    RandomStream rng;
+
     typename MatType::elem_type objective = 0;
     for (size_t f = 0; f < std::floor(numFunctions * fraction); f += batchSize)
     {
-      const size_t selection = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numFunctions - 1)));
+      const size_t selection = rng.Integer(numFunctions);
       const size_t effectiveBatchSize = std::min(batchSize,
           numFunctions - selection);
 
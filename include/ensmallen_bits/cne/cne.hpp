@@ -65,11 +65,36 @@ namespace ens {
  *
  * The final value and the parameters are returned by the Optimize() method.
  *
+ * If ParallelEvaluation() is set to true (and OpenMP is enabled), the
+ * candidates of each generation are evaluated on multiple threads, so the
+ * function's Evaluate() must be safe to call concurrently.  If the function
+ * has an EvaluateBatch() method, the whole population is evaluated with one
+ * call to it instead.
+ *
+ * If Islands() is greater than 1, the population is split into that many
+ * islands of populationSize / Islands() members, which evolve independently
+ * on the threads of the executor (see ParallelFor()); every
+ * MigrationInterval() generations, the Migrants() best members of each island
+ * replace the worst members of the next island on a ring, or of a random
+ * island if RandomMigration() is true (see MigrateIslands()).  The tolerance
+ * is then checked after each migration, and Evaluate() must be safe to call
+ * concurrently.  Each island draws from its own random stream, so the results
+ * don't depend on the number of threads.
+ *
+ * The initial population is drawn in [0, 1) around the starting point with
+ * the sampling policy: by default independent uniform values (UniformSampling),
+ * or a low-discrepancy sample (e.g. SobolSampling), which covers the space
+ * more evenly with the same number of candidates.
+ *
  * CNE can optimize arbitrary functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * @tparam SamplingType Sampling policy of the initial population (see
+ *     UniformSampling).
  */
-class CNE
+template<typename SamplingType = UniformSampling>
+class CNEType
 {
  public:
   /**
@@ -89,13 +114,15 @@ class CNE
    *     the next generation.
    * @param tolerance The final value of the objective function for termination.
    *     If set to negative value, tolerance is not considered.
+   * @param sampling Sampling policy of the initial population.
    */
-  CNE(const size_t populationSize = 500,
-      const size_t maxGenerations = 5000,
-      const double mutationProb = 0.1,
-      const double mutationSize = 0.02,
-      const double selectPercent = 0.2,
-      const double tolerance = 1e-5);
+  CNEType(const size_t populationSize = 500,
+          const size_t maxGenerations = 5000,
+          const double mutationProb = 0.1,
+          const double mutationSize = 0.02,
+          const double selectPercent = 0.2,
+          const double tolerance = 1e-5,
+          const SamplingType& sampling = SamplingType());
 
   /**
    * Optimize the given function using CNE. The given
@@ -147,16 +174,71 @@ class CNE
   //! Modify the tolerance.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether or not the population is evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether or not the population is evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the number of islands of the population.
+  size_t Islands() const { return islands; }
+  //! Modify the number of islands of the population.
+  size_t& Islands() { return islands; }
+
+  //! Get the number of generations between migrations (0 disables them).
+  size_t MigrationInterval() const { return migrationInterval; }
+  //! Modify the number of generations between migrations (0 disables them).
+  size_t& MigrationInterval() { return migrationInterval; }
+
+  //! Get the number of members that each island sends at a migration.
+  size_t Migrants() const { return migrants; }
+  //! Modify the number of members that each island sends at a migration.
+  size_t& Migrants() { return migrants; }
+
+  //! Get whether or not the islands send their members to random islands.
+  bool RandomMigration() const { return randomMigration; }
+  //! Modify whether or not the islands send their members to random islands.
+  bool& RandomMigration() { return randomMigration; }
+
+  //! Get the sampling policy of the initial population.
+  const SamplingType& Sampling() const { return sampling; }
+  //! Modify the sampling policy of the initial population.
+  SamplingType& Sampling() { return sampling; }
+
  private:
-  //! Reproduce candidates to create the next generation.
+  /**
+   * Run the island model (see Islands()) from the given starting point, and
+   * return the objective of the best member.
+   */
+  template<typename ArbitraryFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type OptimizeIslands(ArbitraryFunctionType& function,
+                                              MatType& iterate,
+                                              CallbackTypes&... callbacks);
+
+  //! Fill the population with the sampling policy, around the given point.
+  template<typename MatType>
+  void Sample(std::vector<MatType>& population,
+              const MatType& iterate,
+              RandomStream& rng);
+
+  //! Reproduce candidates to create the next generation, using mask and noise
+  //! as buffers for the random numbers, which are drawn from rng.
   template<typename MatType>
   void Reproduce(std::vector<MatType>& population,
-                 const MatType& fitnessValues,
-                 arma::uvec& index);
+                 const arma::Col<typename MatType::elem_type>& fitnessValues,
+                 arma::uvec& index,
+                 MatType& mask,
+                 MatType& noise,
+                 RandomStream& rng);
 
   //! Modify weights with some noise for the evolution of next generation.
   template<typename MatType>
-  void Mutate(std::vector<MatType>& population, arma::uvec& index);
+  void Mutate(std::vector<MatType>& population,
+              arma::uvec& index,
+              MatType& mask,
+              MatType& noise,
+              RandomStream& rng);
 
   /**
    * Crossover parents and create new childs. Two parents create two new childs.
@@ -169,13 +251,17 @@ class CNE
    * @param dropout2 The place to delete the candidate of the present
    *                 generation and place a child over there for the
    *                 next generation.
+   * @param mask Buffer for the random numbers of the crossover.
+   * @param rng Random number stream to draw the crossover from.
    */
   template<typename MatType>
   void Crossover(std::vector<MatType>& population,
                  const size_t mom,
                  const size_t dad,
                  const size_t dropout1,
-                 const size_t dropout2);
+                 const size_t dropout2,
+                 MatType& mask,
+                 RandomStream& rng);
 
   //! The number of candidates in the population.
   size_t populationSize;
@@ -200,8 +286,29 @@ class CNE
 
   //! Store the number of elements in a cube slice or a matrix column.
   size_t elements;
+
+  //! Whether or not the population is evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! The number of islands of the population.
+  size_t islands;
+
+  //! The number of generations between migrations.
+  size_t migrationInterval;
+
+  //! The number of members that each island sends at a migration.
+  size_t migrants;
+
+  //! Whether or not the islands send their members to random islands.
+  bool randomMigration;
+
+  //! The sampling policy of the initial population.
+  SamplingType sampling;
 };
 
+//! CNE with independent uniform initial candidates.
+using CNE = CNEType<UniformSampling>;
+
 } // namespace ens
 
 // Include implementation.
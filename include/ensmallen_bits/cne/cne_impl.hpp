@@ -17,15 +17,19 @@
 #define ENSMALLEN_CNE_CNE_IMPL_HPP
 
 #include "cne.hpp"
+#include <ensmallen_bits/utility/evaluate_batch.hpp>
+#include <ensmallen_bits/utility/evaluate_bounded.hpp>
 
 namespace ens {
 
-inline CNE::CNE(const size_t populationSize,
-                const size_t maxGenerations,
-                const double mutationProb,
-                const double mutationSize,
-                const double selectPercent,
-                const double tolerance) :
+template<typename SamplingType>
+inline CNEType<SamplingType>::CNEType(const size_t populationSize,
+                                      const size_t maxGenerations,
+                                      const double mutationProb,
+                                      const double mutationSize,
+                                      const double selectPercent,
+                                      const double tolerance,
+                                      const SamplingType& sampling) :
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     mutationProb(mutationProb),
@@ -33,16 +37,24 @@ inline CNE::CNE(const size_t populationSize,
     selectPercent(selectPercent),
     tolerance(tolerance),
     numElite(0),
-    elements(0)
+    elements(0),
+    parallelEvaluation(false),
+    islands(1),
+    migrationInterval(10),
+    migrants(1),
+    randomMigration(false),
+    sampling(sampling)
 { /* Nothing to do here. */ }
 
 //! Optimize the function.
+template<typename SamplingType>
 template<typename ArbitraryFunctionType,
          typename MatType,
          typename... CallbackTypes>
-typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
-                                          MatType& iterateIn,
-                                          CallbackTypes&&... callbacks)
+typename MatType::elem_type CNEType<SamplingType>::Optimize(
+    ArbitraryFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
 {
   // Convenience typedefs.
   typedef typename MatType::elem_type ElemType;
@@ -54,7 +66,7 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
   RequireDenseFloatingPointType<BaseMatType>();
 
   // Vector of fitness values corresponding to each candidate.
-  BaseMatType fitnessValues;
+  arma::Col<ElemType> fitnessValues;
   //! Index of sorted fitness values.
   arma::uvec index;
 
@@ -65,11 +77,20 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
         " 4!");
   }
 
+  // With the island model, each island is a population of its own.
+  const size_t size = (islands > 1) ? populationSize / islands :
+      populationSize;
+  if (size < 4)
+  {
+    throw std::logic_error("CNE::Optimize(): each island should have at least "
+        "4 members!");
+  }
+
   // Find the number of elite canditates from population.
-  numElite = floor(selectPercent * populationSize);
+  numElite = floor(selectPercent * size);
 
   // Making sure we have even number of candidates to remove and create.
-  if ((populationSize - numElite) % 2 != 0)
+  if ((size - numElite) % 2 != 0)
     numElite--;
 
   // Terminate if two parents can not be created.
@@ -80,7 +101,7 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
   }
 
   // Terminate if at least two childs are not possible.
-  if ((populationSize - numElite) < 2)
+  if ((size - numElite) < 2)
   {
     throw std::logic_error("CNE::Optimize(): no space to accomodate even 2 "
         "children. Increase population size.");
@@ -88,14 +109,16 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
 
   BaseMatType& iterate = (BaseMatType&) iterateIn;
 
-  // Generate the population based on a Gaussian distribution around the given
-  // starting point.
-  std::vector<BaseMatType> population;
-  for (size_t i = 0 ; i < populationSize; ++i)
-  {
-    population.push_back(arma::randu<BaseMatType>(iterate.n_rows,
-        iterate.n_cols) + iterate);
-  }
+  if (islands > 1)
+    return OptimizeIslands(function, iterate, callbacks...);
+
+  // All the random numbers of the optimization are drawn from this stream.
+  RandomStream rng;
+
+  // Generate the population with the sampling policy, in [0, 1) around the
+  // given starting point.
+  std::vector<BaseMatType> population(populationSize);
+  Sample(population, iterate, rng);
 
   // Store the number of elements in the objective matrix.
   elements = iterate.n_rows * iterate.n_cols;
@@ -103,6 +126,11 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
   // Initialize helper variables.
   fitnessValues.set_size(populationSize);
 
+  // Buffers for the random numbers of crossover and mutation; these are reused
+  // across generations.
+  BaseMatType mask(iterate.n_rows, iterate.n_cols);
+  BaseMatType noise(iterate.n_rows, iterate.n_cols);
+
   // Controls early termination of the optimization process.
   bool terminate = false;
 
@@ -118,18 +146,18 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
       callbacks...);
   for (size_t gen = 1; gen <= maxGenerations && !terminate; gen++)
   {
-    // Calculating fitness values of all candidates.
+    // Calculating fitness values of all candidates; the candidates are
+    // evaluated in place.  Only the elite candidates are kept, so the others
+    // may be evaluated with a bound (see EvaluateSelection()).
+    EvaluateSelection(function, population, fitnessValues, numElite,
+        parallelEvaluation);
+
     for (size_t i = 0; i < populationSize; i++)
     {
-       // Select a candidate and insert the parameters in the function.
-       iterate = population[i];
-       terminate |= Callback::StepTaken(*this, function, iterate,
+       terminate |= Callback::StepTaken(*this, function, population[i],
           callbacks...);
 
-       // Find fitness of candidate.
-       fitnessValues[i] = function.Evaluate(iterate);
-
-       Callback::Evaluate(*this, function, iterate, fitnessValues[i],
+       Callback::Evaluate(*this, function, population[i], fitnessValues[i],
           callbacks...);
     }
 
@@ -137,7 +165,7 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
         << fitnessValues.min() << std::endl;
 
     // Create next generation of species.
-    Reproduce(population, fitnessValues, index);
+    Reproduce(population, fitnessValues, index, mask, noise, rng);
 
     // Check for termination criteria.
     if (std::abs(lastBestFitness - fitnessValues.min()) < tolerance)
@@ -161,11 +189,169 @@ typename MatType::elem_type CNE::Optimize(ArbitraryFunctionType& function,
   return objective;
 }
 
+//! Run the island model.
+template<typename SamplingType>
+template<typename ArbitraryFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+typename MatType::elem_type CNEType<SamplingType>::OptimizeIslands(
+    ArbitraryFunctionType& function,
+    MatType& iterate,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t islandSize = populationSize / islands;
+  elements = iterate.n_rows * iterate.n_cols;
+
+  // The stream of the migrations; island k draws from stream k + 1.
+  RandomStream rng;
+  std::vector<RandomStream> streams;
+  for (size_t k = 0; k < islands; ++k)
+    streams.push_back(rng.Split(k + 1));
+
+  std::vector<std::vector<MatType>> populations(islands);
+  std::vector<arma::Col<ElemType>> islandFitness(islands);
+  std::vector<arma::uvec> indices(islands);
+  std::vector<MatType> masks(islands), noises(islands);
+
+  // The callbacks are called by one island at a time.
+  std::mutex callbackMutex;
+  std::atomic<bool> stop(false);
+
+  // Evolve island k for the given number of generations (0 only creates and
+  // evaluates its population); the population is evaluated after each
+  // generation, so the fitness values are always those of the members.
+  auto evolve = [&](const size_t k, const size_t generations)
+  {
+    std::vector<MatType>& population = populations[k];
+    arma::Col<ElemType>& fitness = islandFitness[k];
+    if (generations == 0)
+    {
+      population.resize(islandSize);
+      Sample(population, iterate, streams[k]);
+
+      EvaluateBatch(function, population, fitness, parallelEvaluation);
+
+      std::unique_lock<std::mutex> lock(callbackMutex);
+      for (size_t i = 0; i < islandSize; ++i)
+      {
+        Callback::Evaluate(*this, function, population[i], fitness[i],
+            callbacks...);
+      }
+    }
+
+    for (size_t gen = 0; gen < generations && !stop; ++gen)
+    {
+      Reproduce(population, fitness, indices[k], masks[k], noises[k],
+          streams[k]);
+      EvaluateSelection(function, population, fitness, numElite,
+          parallelEvaluation);
+
+      std::unique_lock<std::mutex> lock(callbackMutex);
+      for (size_t i = 0; i < islandSize; ++i)
+      {
+        if (Callback::StepTaken(*this, function, population[i],
+            callbacks...))
+        {
+          stop = true;
+        }
+
+        Callback::Evaluate(*this, function, population[i], fitness[i],
+            callbacks...);
+      }
+    }
+  };
+
+  // Find the fitness before optimization using given iterate parameters.
+  ElemType lastBestFitness = function.Evaluate(iterate);
+  Callback::Evaluate(*this, function, iterate, lastBestFitness, callbacks...);
+
+  ParallelFor(islands, [&](const size_t k) { evolve(k, 0); });
+
+  // Find the best member of all islands.
+  auto best = [&](size_t& island)
+  {
+    island = 0;
+    for (size_t k = 1; k < islands; ++k)
+    {
+      if (islandFitness[k].min() < islandFitness[island].min())
+        island = k;
+    }
+    return islandFitness[island].min();
+  };
+
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  size_t bestIsland;
+  const size_t epoch = (migrationInterval == 0) ? 1 : migrationInterval;
+  for (size_t gen = 0; gen < maxGenerations && !terminate; gen += epoch)
+  {
+    const size_t generations = std::min(epoch, maxGenerations - gen);
+    ParallelFor(islands, [&](const size_t k) { evolve(k, generations); });
+    terminate |= stop;
+
+    if (migrationInterval > 0)
+    {
+      MigrateIslands(populations, islandFitness, migrants, randomMigration,
+          rng);
+    }
+
+    const ElemType bestFitness = best(bestIsland);
+    Info << "Generation number: " << gen + generations << " best fitness = "
+        << bestFitness << std::endl;
+
+    // Check for termination criteria.
+    if (std::abs(lastBestFitness - bestFitness) < tolerance)
+    {
+      Info << "CNE: minimized within tolerance " << tolerance << "; "
+            << "terminating optimization." << std::endl;
+      break;
+    }
+
+    lastBestFitness = bestFitness;
+  }
+
+  // Set the best candidate into the network parameters.
+  best(bestIsland);
+  iterate = populations[bestIsland][islandFitness[bestIsland].index_min()];
+
+  const ElemType objective = function.Evaluate(iterate);
+  Callback::Evaluate(*this, function, iterate, objective, callbacks...);
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return objective;
+}
+
+//! Sample the population around the given point.
+template<typename SamplingType>
+template<typename MatType>
+inline void CNEType<SamplingType>::Sample(std::vector<MatType>& population,
+                                          const MatType& iterate,
+                                          RandomStream& rng)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The whole population is sampled at once, one candidate per column.
+  arma::Mat<ElemType> points(iterate.n_elem, population.size());
+  sampling.Fill(points, rng);
+  for (size_t i = 0; i < population.size(); ++i)
+  {
+    population[i] = MatType(points.colptr(i), iterate.n_rows, iterate.n_cols);
+    population[i] += iterate;
+  }
+}
+
 //! Reproduce candidates to create the next generation.
+template<typename SamplingType>
 template<typename MatType>
-inline void CNE::Reproduce(std::vector<MatType>& population,
-                           const MatType& fitnessValues,
-                           arma::uvec& index)
+inline void CNEType<SamplingType>::Reproduce(
+    std::vector<MatType>& population,
+    const arma::Col<typename MatType::elem_type>& fitnessValues,
+    arma::uvec& index,
+    MatType& mask,
+    MatType& noise,
+    RandomStream& rng)
 {
   // Sort fitness values. Smaller fitness value means better performance.
   index = arma::sort_index(fitnessValues);
@@ -176,14 +362,12 @@ inline void CNE::Reproduce(std::vector<MatType>& population,
   // Second parent.
   size_t dad;
 
-  for (size_t i = numElite; i < populationSize - 1; i++)
+  // Each pair of parents replaces two dropped-out candidates.
+  for (size_t i = numElite; i < population.size() - 1; i += 2)
   {
     // Select 2 different parents from elite group randomly [0, numElite).
-    mom = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numElite - 1)));
-
-    dad = arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, numElite - 1)));
+    mom = rng.Integer(numElite);
+    dad = rng.Integer(numElite);
 
     // Making sure both parents are not the same.
     if (mom == dad)
@@ -200,56 +384,90 @@ inline void CNE::Reproduce(std::vector<MatType>& population,
 
     // Parents generate 2 children replacing the dropped-out candidates.
     // Also finding the index of these candidates in the population matrix.
-    Crossover(population, index[mom], index[dad], index[i], index[i + 1]);
+    Crossover(population, index[mom], index[dad], index[i], index[i + 1],
+        mask, rng);
+  }
+
+  // If an odd number of candidates dropped out, the last one is replaced by a
+  // copy of a random elite parent, which is then mutated like the others.
+  if ((population.size() - numElite) % 2 == 1)
+  {
+    const size_t last = index[population.size() - 1];
+    population[last] = population[index[rng.Integer(numElite)]];
   }
 
   // Mutating the weights with small noise values.
   // This is done to bring change in the next generation.
-  Mutate(population, index);
+  Mutate(population, index, mask, noise, rng);
 }
 
 //! Crossover parents to create new children.
+template<typename SamplingType>
 template<typename MatType>
-inline void CNE::Crossover(std::vector<MatType>& population,
-                           const size_t mom,
-                           const size_t dad,
-                           const size_t child1,
-                           const size_t child2)
+inline void CNEType<SamplingType>::Crossover(std::vector<MatType>& population,
+                                             const size_t mom,
+                                             const size_t dad,
+                                             const size_t child1,
+                                             const size_t child2,
+                                             MatType& mask,
+                                             RandomStream& rng)
 {
-  // Replace the candidates with parents at their place.
-  population[child1] = population[mom];
-  population[child2] = population[dad];
+  typedef typename MatType::elem_type ElemType;
+
+  // The children take the place (and memory) of dropped-out candidates.
+  population[child1].set_size(population[mom].n_rows, population[mom].n_cols);
+  population[child2].set_size(population[mom].n_rows, population[mom].n_cols);
 
   // Randomly alter mom and dad genome weights to get two different children.
+  mask.set_size(population[mom].n_rows, population[mom].n_cols);
+  rng.FillUniform(mask);
+
+  const ElemType* m = population[mom].memptr();
+  const ElemType* d = population[dad].memptr();
+  const ElemType* r = mask.memptr();
+  ElemType* c1 = population[child1].memptr();
+  ElemType* c2 = population[child2].memptr();
+
+  ENS_PRAGMA_OMP_SIMD
   for (size_t i = 0; i < elements; i++)
   {
-    // Using it to alter the weights of the children.
-    const double random = arma::randu<typename MatType::elem_type>();
-    if (random > 0.5)
-    {
-      population[child1](i) = population[mom](i);
-      population[child2](i) = population[dad](i);
-    }
-    else
-    {
-      population[child1](i) = population[dad](i);
-      population[child2](i) = population[mom](i);
-    }
+    const bool fromMom = (r[i] > ElemType(0.5));
+    c1[i] = fromMom ? m[i] : d[i];
+    c2[i] = fromMom ? d[i] : m[i];
   }
 }
 
 //! Modify weights with some noise for the evolution of next generation.
+template<typename SamplingType>
 template<typename MatType>
-inline void CNE::Mutate(std::vector<MatType>& population, arma::uvec& index)
+inline void CNEType<SamplingType>::Mutate(std::vector<MatType>& population,
+                                          arma::uvec& index,
+                                          MatType& mask,
+                                          MatType& noise,
+                                          RandomStream& rng)
 {
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType probability = (ElemType) mutationProb;
+  const ElemType size = (ElemType) mutationSize;
+
   // Mutate the whole matrix with the given rate and probability.
   // The best candidate is not altered.
-  for (size_t i = 1; i < populationSize; i++)
+  for (size_t i = 1; i < population.size(); i++)
   {
-    population[index(i)] += (arma::randu<MatType>(population[index(i)].n_rows,
-        population[index(i)].n_cols) < mutationProb) %
-        (mutationSize * arma::randn<MatType>(population[index(i)].n_rows,
-        population[index(i)].n_cols));
+    MatType& candidate = population[index(i)];
+    mask.set_size(candidate.n_rows, candidate.n_cols);
+    noise.set_size(candidate.n_rows, candidate.n_cols);
+    rng.FillUniform(mask);
+    rng.FillNormal(noise);
+
+    ElemType* x = candidate.memptr();
+    const ElemType* r = mask.memptr();
+    const ElemType* z = noise.memptr();
+
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t j = 0; j < candidate.n_elem; j++)
+      x[j] += (r[j] < probability) ? size * z[j] : ElemType(0);
   }
 }
 
@@ -18,6 +18,22 @@
   // #define ENS_PRINT_WARN
 #endif
 
+#if !defined(ENS_LOG_SINK)
+  // #define ENS_LOG_SINK
+#endif
+
+#if !defined(ENS_TIMELINE)
+  // #define ENS_TIMELINE
+#endif
+
+#if !defined(ENS_USE_OPENMP_SIMD)
+  // #define ENS_USE_OPENMP_SIMD
+#endif
+
+#if !defined(ENS_USE_PERF_EVENTS)
+  // #define ENS_USE_PERF_EVENTS
+#endif
+
 #if defined(ARMA_USE_OPENMP)
   #undef  ENS_USE_OPENMP
   #define ENS_USE_OPENMP
@@ -35,6 +51,22 @@
   #undef ENS_PRINT_WARN
 #endif
 
+#if defined(ENS_DONT_LOG_SINK)
+  #undef ENS_LOG_SINK
+#endif
+
+#if defined(ENS_DONT_TIMELINE)
+  #undef ENS_TIMELINE
+#endif
+
+#if defined(ENS_DONT_USE_OPENMP_SIMD)
+  #undef ENS_USE_OPENMP_SIMD
+#endif
+
+#if defined(ENS_DONT_USE_PERF_EVENTS)
+  #undef ENS_USE_PERF_EVENTS
+#endif
+
 #if defined(ENS_DONT_USE_OPENMP)
   #undef ENS_USE_OPENMP
 #endif
@@ -48,12 +80,43 @@
   #define ENS_PRAGMA_OMP_ATOMIC   _Pragma("omp atomic")
   #define ENS_PRAGMA_OMP_CRITICAL _Pragma("omp critical")
   #define ENS_PRAGMA_OMP_CRITICAL_NAMED _Pragma("omp critical(section)")
+  #define ENS_PRAGMA_OMP_PARALLEL_FOR _Pragma("omp parallel for")
+  #define ENS_PRAGMA_OMP_FOR_DYNAMIC _Pragma("omp for schedule(dynamic)")
 #else
   #define ENS_PRAGMA_OMP_PARALLEL
   #define ENS_PRAGMA_OMP_ATOMIC
   #define ENS_PRAGMA_OMP_CRITICAL
   #define ENS_PRAGMA_OMP_CRITICAL_NAMED
+  #define ENS_PRAGMA_OMP_PARALLEL_FOR
+  #define ENS_PRAGMA_OMP_FOR_DYNAMIC
+#endif
+
+// The fused update kernels use 'omp simd' to request vectorization; this needs
+// OpenMP 4.0 or newer.  The pragma is enabled when compiling with OpenMP
+// (e.g. -fopenmp), or when ENS_USE_OPENMP_SIMD is defined.  The -fopenmp-simd
+// flag of gcc and clang enables the simd pragmas without the OpenMP runtime,
+// but it does not define _OPENMP, so ENS_USE_OPENMP_SIMD must be defined
+// along with it.
+#define ENS_PRAGMA(x) _Pragma(#x)
+#if (defined(_OPENMP) && (_OPENMP >= 201307)) || defined(ENS_USE_OPENMP_SIMD)
+  #define ENS_PRAGMA_OMP_SIMD _Pragma("omp simd")
+  #define ENS_PRAGMA_OMP_SIMD_SUM(x) ENS_PRAGMA(omp simd reduction(+:x))
+  #define ENS_PRAGMA_OMP_SIMD_SUM2(x, y) ENS_PRAGMA(omp simd reduction(+:x, y))
+#else
+  #define ENS_PRAGMA_OMP_SIMD
+  #define ENS_PRAGMA_OMP_SIMD_SUM(x)
+  #define ENS_PRAGMA_OMP_SIMD_SUM2(x, y)
+#endif
+
+// Visual Studio only supports OpenMP 2.0, which requires signed loop variables
+// in parallel for loops.
+namespace ens {
+#if defined(ENS_USE_OPENMP) && defined(_MSC_VER)
+  typedef long long omp_size_t;
+#else
+  typedef size_t omp_size_t;
 #endif
+} // namespace ens
 
 
 // Define ens_deprecated for deprecated functionality.
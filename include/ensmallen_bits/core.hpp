@@ -0,0 +1,124 @@
+/**
+ * @file core.hpp
+ *
+ * The parts of ensmallen that every optimizer needs: Armadillo, the standard
+ * headers, the configuration, logging, the utilities, the Function wrapper and
+ * the dispatch of callbacks.  The headers in include/ensmallen/ include this
+ * and a single optimizer, so that a program that only uses one optimizer does
+ * not have to preprocess all the others, the test problems and the built-in
+ * callbacks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_CORE_HPP
+#define ENSMALLEN_CORE_HPP
+
+// certain compilers are way behind the curve
+#if (defined(_MSVC_LANG) && (_MSVC_LANG >= 201402L))
+  #undef  ARMA_USE_CXX11
+  #define ARMA_USE_CXX11
+#endif
+
+#include <armadillo>
+
+#if !defined(ARMA_USE_CXX11)
+  // armadillo automatically enables ARMA_USE_CXX11
+  // when a C++11/C++14/C++17/etc compiler is detected
+  #error "please enable C++11/C++14 mode in your compiler"
+#endif
+
+#if ((ARMA_VERSION_MAJOR < 8) || ((ARMA_VERSION_MAJOR == 8) && (ARMA_VERSION_MINOR < 400)))
+  #error "need Armadillo version 8.400 or later"
+#endif
+
+// Bandicoot (GPU) matrices can be optimized if bandicoot is included before
+// ensmallen, or if ENS_USE_COOT is defined.
+#if defined(ENS_USE_COOT)
+  #include <bandicoot>
+#endif
+
+#if defined(COOT_VERSION_MAJOR)
+  #define ENS_HAVE_COOT
+#endif
+
+// The TBBExecutor is available if ENS_USE_TBB is defined.
+#if defined(ENS_USE_TBB)
+  #include <tbb/parallel_for.h>
+  #include <tbb/task_arena.h>
+  #include <tbb/task_group.h>
+#endif
+
+#include <atomic>
+#include <cctype>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// On Visual Studio, disable C4519 (default arguments for function templates)
+// since it's by default an error, which doesn't even make any sense because
+// it's part of the C++11 standard.
+#ifdef _MSC_VER
+  #pragma warning(disable : 4519)
+#endif
+
+#include "config.hpp"
+#include "ens_version.hpp"
+#include "log.hpp" // TODO: should move to another place
+
+#include "utility/any.hpp"
+#include "utility/arma_traits.hpp"
+#include "utility/checkpoint.hpp"
+#include "utility/compact_state.hpp"
+#include "utility/timeline.hpp"
+#include "utility/executor.hpp"
+#include "utility/fused_update.hpp"
+#include "utility/gather_columns.hpp"
+#include "utility/locality_ordering.hpp"
+#include "utility/mapped_matrix.hpp"
+#include "utility/objective_feedback.hpp"
+#include "utility/parallel_batch.hpp"
+#include "utility/random.hpp"
+#include "utility/random_permutation.hpp"
+#include "utility/async_evaluation.hpp"
+#include "utility/island_model.hpp"
+#include "utility/alias_table.hpp"
+#include "utility/row_sparse_mat.hpp"
+#include "utility/state_allocator.hpp"
+#include "utility/state_bytes.hpp"
+
+// The sampling policies of the initial populations.
+#include "sampling/sampling.hpp"
+
+// Contains traits, must be placed before report callback.
+#include "function.hpp" // TODO: should move to function/
+
+// The dispatch of callbacks; the built-in callbacks are not included.
+#include "callbacks/callbacks.hpp"
+
+#endif
@@ -41,6 +41,39 @@ namespace ens {
  *
  * The final value and the parameters are returned by the Optimize() method.
  *
+ * The population and the trials are each stored in an arma::Cube, one candidate
+ * per slice, so that a generation is contiguous in memory: it is passed to
+ * EvaluateBatch() as is, and the mutation and crossover of a trial are a
+ * single pass over the slices of its parents, without temporaries.
+ *
+ * By default each member is replaced as soon as its trial is evaluated, so
+ * later trials of the same generation can already use it.  If
+ * ParallelEvaluation() is set to true, all trials of a generation are
+ * generated from the same population first and are then evaluated at once: in
+ * parallel (if OpenMP is enabled, in which case the function's Evaluate() must
+ * be safe to call concurrently), or with a single call to EvaluateBatch() if
+ * the function has that method.
+ *
+ * If AsyncEvaluation() is set to true, the optimization is steady-state
+ * instead: a trial is kept in flight for as many members as there are
+ * workers (see AsyncEvaluator), and as soon as any evaluation is done, its
+ * member is replaced if the trial is better, and the trial of the next member
+ * is generated from the current population and started.  This keeps all of the
+ * workers busy when the evaluation times vary.  The budget is still
+ * maxGenerations times populationSize evaluations, and the tolerance is
+ * checked after each populationSize evaluations.  The function's Evaluate()
+ * must be safe to call concurrently, unless the function has EvaluateAsync().
+ *
+ * If Islands() is greater than 1, the population is split into that many
+ * islands of populationSize / Islands() members, which evolve independently
+ * on the threads of the executor (see ParallelFor()); every
+ * MigrationInterval() generations, the Migrants() best members of each island
+ * replace the worst members of the next island on a ring, or of a random
+ * island if RandomMigration() is true (see MigrateIslands()).  The tolerance
+ * is then checked after each migration, and Evaluate() must be safe to call
+ * concurrently.  Each island draws from its own random stream, so the results
+ * don't depend on the number of threads.
+ *
  * For more information, see the following:
  *
  * @code
@@ -52,11 +85,21 @@ namespace ens {
  * }
  * @endcode
  *
+ * The initial population is drawn from a standard normal distribution around
+ * the starting point with the sampling policy: by default independent values
+ * (UniformSampling), or a low-discrepancy sample (e.g. SobolSampling) mapped
+ * through the normal quantile function, which covers the space more evenly
+ * with the same number of candidates.
+ *
  * DE can optimize arbitrary functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * @tparam SamplingType Sampling policy of the initial population (see
+ *     UniformSampling).
  */
-class DE
+template<typename SamplingType = UniformSampling>
+class DEType
 {
  public:
   /**
@@ -73,12 +116,14 @@ class DE
    * @param differentialWeight A parameter used in the mutation of candidate
    *     solutions controls amplification factor of the differentiation.
    * @param tolerance The final value of the objective function for termination.
+   * @param sampling Sampling policy of the initial population.
    */
-  DE(const size_t populationSize = 100,
-     const size_t maxGenerations = 2000,
-     const double crossoverRate = 0.6,
-     const double differentialWeight = 0.8,
-     const double tolerance = 1e-5);
+  DEType(const size_t populationSize = 100,
+         const size_t maxGenerations = 2000,
+         const double crossoverRate = 0.6,
+         const double differentialWeight = 0.8,
+         const double tolerance = 1e-5,
+         const SamplingType& sampling = SamplingType());
 
   /**
    * Optimize the given function using DE. The given
@@ -125,7 +170,81 @@ class DE
   //! Modify the tolerance.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether or not whole generations are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether or not whole generations are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get whether or not the optimization is steady-state and asynchronous.
+  bool AsyncEvaluation() const { return asyncEvaluation; }
+  //! Modify whether or not the optimization is steady-state and asynchronous.
+  bool& AsyncEvaluation() { return asyncEvaluation; }
+
+  //! Get the number of islands of the population.
+  size_t Islands() const { return islands; }
+  //! Modify the number of islands of the population.
+  size_t& Islands() { return islands; }
+
+  //! Get the number of generations between migrations (0 disables them).
+  size_t MigrationInterval() const { return migrationInterval; }
+  //! Modify the number of generations between migrations (0 disables them).
+  size_t& MigrationInterval() { return migrationInterval; }
+
+  //! Get the number of members that each island sends at a migration.
+  size_t Migrants() const { return migrants; }
+  //! Modify the number of members that each island sends at a migration.
+  size_t& Migrants() { return migrants; }
+
+  //! Get whether or not the islands send their members to random islands.
+  bool RandomMigration() const { return randomMigration; }
+  //! Modify whether or not the islands send their members to random islands.
+  bool& RandomMigration() { return randomMigration; }
+
+  //! Get the sampling policy of the initial population.
+  const SamplingType& Sampling() const { return sampling; }
+  //! Modify the sampling policy of the initial population.
+  SamplingType& Sampling() { return sampling; }
+
  private:
+  /**
+   * Run the island model (see Islands()) from the given starting point, and
+   * return the objective of the best member.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type OptimizeIslands(FunctionType& function,
+                                              MatType& iterate,
+                                              CallbackTypes&... callbacks);
+
+  //! Fill the population, one candidate per slice, with standard normal
+  //! values from the sampling policy around the given point.
+  template<typename MatType, typename ElemType>
+  void Sample(arma::Cube<ElemType>& population,
+              const MatType& iterate,
+              RandomStream& rng) const;
+
+  /**
+   * Generate a trial candidate from the best candidate and two other random
+   * members of the population (mutation), and mix it with the given member
+   * (crossover).
+   *
+   * @param population The current population, one member per slice.
+   * @param member Index of the member to generate the trial for.
+   * @param bestElement The best candidate of the previous generation.
+   * @param trial Matrix to store the trial into, of the size of a member.
+   * @param mask Buffer for the crossover random numbers, of the size of a
+   *     member.
+   * @param rng Random number stream to draw the trial from.
+   */
+  template<typename MatType, typename ElemType>
+  void GenerateTrial(const arma::Cube<ElemType>& population,
+                     const size_t member,
+                     const MatType& bestElement,
+                     arma::Mat<ElemType>& trial,
+                     arma::Mat<ElemType>& mask,
+                     RandomStream& rng) const;
+
   //! The number of candidates in the population.
   size_t populationSize;
 
@@ -140,8 +259,32 @@ class DE
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! Whether or not whole generations are evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! Whether or not the optimization is steady-state and asynchronous.
+  bool asyncEvaluation;
+
+  //! The number of islands of the population.
+  size_t islands;
+
+  //! The number of generations between migrations.
+  size_t migrationInterval;
+
+  //! The number of members that each island sends at a migration.
+  size_t migrants;
+
+  //! Whether or not the islands send their members to random islands.
+  bool randomMigration;
+
+  //! The sampling policy of the initial population.
+  SamplingType sampling;
 };
 
+//! DE with independent normal initial candidates.
+using DE = DEType<UniformSampling>;
+
 } // namespace ens
 
 // Include implementation.
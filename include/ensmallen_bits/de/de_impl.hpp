@@ -14,28 +14,41 @@
 #define ENSMALLEN_DE_DE_IMPL_HPP
 
 #include "de.hpp"
+#include <ensmallen_bits/utility/evaluate_batch.hpp>
+#include <ensmallen_bits/utility/evaluate_bounded.hpp>
 
 namespace ens {
 
-inline DE::DE(const size_t populationSize ,
-              const size_t maxGenerations,
-              const double crossoverRate,
-              const double differentialWeight,
-              const double tolerance):
+template<typename SamplingType>
+inline DEType<SamplingType>::DEType(const size_t populationSize,
+                                    const size_t maxGenerations,
+                                    const double crossoverRate,
+                                    const double differentialWeight,
+                                    const double tolerance,
+                                    const SamplingType& sampling) :
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     crossoverRate(crossoverRate),
     differentialWeight(differentialWeight),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    parallelEvaluation(false),
+    asyncEvaluation(false),
+    islands(1),
+    migrationInterval(10),
+    migrants(1),
+    randomMigration(false),
+    sampling(sampling)
 { /* Nothing to do here. */ }
 
 //!Optimize the function
+template<typename SamplingType>
 template<typename FunctionType,
          typename MatType,
          typename... CallbackTypes>
-typename MatType::elem_type DE::Optimize(FunctionType& function,
-                                         MatType& iterateIn,
-                                         CallbackTypes&&... callbacks)
+typename MatType::elem_type DEType<SamplingType>::Optimize(
+    FunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
 {
   // Convenience typedefs.
   typedef typename MatType::elem_type ElemType;
@@ -43,9 +56,10 @@ typename MatType::elem_type DE::Optimize(FunctionType& function,
 
   BaseMatType& iterate = (BaseMatType&) iterateIn;
 
-  // Population matrix. Each column is a candidate.
-  std::vector<BaseMatType> population;
-  population.resize(populationSize);
+  // The population, one candidate per slice; the candidates are stored
+  // contiguously, so that the whole population can be passed to
+  // EvaluateBatch() without copies.
+  arma::Cube<ElemType> population;
   // Vector of fitness values corresponding to each candidate.
   arma::Col<ElemType> fitnessValues;
 
@@ -61,6 +75,9 @@ typename MatType::elem_type DE::Optimize(FunctionType& function,
         " 3!");
   }
 
+  if (islands > 1)
+    return OptimizeIslands(function, iterate, callbacks...);
+
   // Initialize helper variables.
   fitnessValues.set_size(populationSize);
   ElemType lastBestFitness = DBL_MAX;
@@ -69,80 +86,166 @@ typename MatType::elem_type DE::Optimize(FunctionType& function,
   // Controls early termination of the optimization process.
   bool terminate = false;
 
+  // All the random numbers of the optimization are drawn from this stream.
+  RandomStream rng;
+
   // Generate a population based on a Gaussian distribution around the given
-  // starting point. Also finds the best element of the population.
+  // starting point, with the sampling policy. Also finds the best element of
+  // the population.
+  population.set_size(iterate.n_rows, iterate.n_cols, populationSize);
+  Sample(population, iterate, rng);
+
+  EvaluateBatch(function, population, fitnessValues);
+
   for (size_t i = 0; i < populationSize; i++)
   {
-    population[i].randn(iterate.n_rows, iterate.n_cols);
-    population[i] += iterate;
-    fitnessValues[i] = function.Evaluate(population[i]);
-
-    Callback::Evaluate(*this, function, population[i], fitnessValues[i],
+    Callback::Evaluate(*this, function, population.slice(i), fitnessValues[i],
         callbacks...);
 
     if (fitnessValues[i] < lastBestFitness)
     {
       lastBestFitness = fitnessValues[i];
-      bestElement = population[i];
+      bestElement = population.slice(i);
     }
   }
 
+  // Buffers for the trials of a generation, stored like the population, and
+  // the crossover random numbers.
+  arma::Cube<ElemType> trials(iterate.n_rows, iterate.n_cols,
+      (parallelEvaluation || asyncEvaluation) ? populationSize : 1);
+  arma::Col<ElemType> trialFitnessValues;
+  arma::Mat<ElemType> mask(iterate.n_rows, iterate.n_cols);
+
   // Iterate until maximum number of generations are completed.
   terminate |= Callback::BeginOptimization(*this, function, iterate,
       callbacks...);
-  for (size_t gen = 0; gen < maxGenerations && !terminate; gen++)
+
+  if (asyncEvaluation)
   {
-    // Generate new population based on /best/1/bin strategy.
-    for (size_t member = 0; member < populationSize; member++)
+    // Steady-state evolution: keep a trial in flight for each worker, and
+    // replace its member as soon as it is done.
+    AsyncEvaluator<FunctionType, arma::Mat<ElemType>> evaluator(function);
+    const size_t slots = std::min(evaluator.Concurrency(), populationSize);
+    const size_t budget = maxGenerations * populationSize;
+    std::vector<char> inFlight(populationSize, 0);
+    size_t nextMember = 0, submitted = 0, completed = 0;
+    while (completed < budget && !terminate)
     {
-      iterate = population[member];
-
-      // Generate two different random numbers to choose two random members.
-      size_t l = 0, m = 0;
-      do
+      while (evaluator.Pending() < slots && submitted < budget)
       {
-        l = arma::randi<arma::uword>(arma::distr_param(0, populationSize - 1));
+        while (inFlight[nextMember])
+          nextMember = (nextMember + 1) % populationSize;
+
+        GenerateTrial(population, nextMember, bestElement,
+            trials.slice(nextMember), mask, rng);
+        evaluator.Submit(nextMember, trials.slice(nextMember));
+        inFlight[nextMember] = 1;
+        nextMember = (nextMember + 1) % populationSize;
+        ++submitted;
       }
-      while (l == member);
 
-      do
+      ElemType trialValue;
+      const size_t member = evaluator.WaitAny(trialValue);
+      inFlight[member] = 0;
+      ++completed;
+      Callback::Evaluate(*this, function, trials.slice(member), trialValue,
+          callbacks...);
+
+      // Replace the member if the trial is better; later trials already use
+      // it.
+      if (trialValue < fitnessValues[member])
       {
-        m = arma::randi<arma::uword>(arma::distr_param(0, populationSize - 1));
-      }
-      while (m == member && m == l);
+        population.slice(member) = trials.slice(member);
+        fitnessValues[member] = trialValue;
+        if (trialValue <= fitnessValues.min())
+          bestElement = population.slice(member);
 
-      // Generate new "mutant" from two randomly chosen members.
-      BaseMatType mutant = bestElement + differentialWeight *
-          (population[l] - population[m]);
+        terminate |= Callback::StepTaken(*this, function,
+            population.slice(member), callbacks...);
+      }
 
-      // Perform crossover.
-      const BaseMatType cr = arma::randu<BaseMatType>(iterate.n_rows);
-      for (size_t it = 0; it < iterate.n_rows; it++)
+      // Check for termination after each populationSize evaluations.
+      if (completed % populationSize == 0)
       {
-        if (cr[it] >= crossoverRate)
+        if (std::abs(lastBestFitness - fitnessValues.min()) < tolerance)
         {
-          mutant[it] = iterate[it];
+          Info << "DE: minimized within tolerance " << tolerance << "; "
+              << "terminating optimization." << std::endl;
+          break;
         }
+
+        lastBestFitness = fitnessValues.min();
       }
+    }
 
-      ElemType iterateValue = function.Evaluate(iterate);
-      Callback::Evaluate(*this, function, iterate, iterateValue, callbacks...);
+    lastBestFitness = fitnessValues.min();
+    for (size_t it = 0; it < populationSize; it++)
+    {
+      if (fitnessValues[it] == lastBestFitness)
+      {
+        bestElement = population.slice(it);
+        break;
+      }
+    }
+  }
 
-      const ElemType mutantValue = function.Evaluate(mutant);
-      Callback::Evaluate(*this, function, mutant, mutantValue, callbacks...);
+  for (size_t gen = 0; gen < maxGenerations && !terminate && !asyncEvaluation;
+      gen++)
+  {
+    if (parallelEvaluation)
+    {
+      // Generate all trials from the current population, then evaluate them
+      // at once.
+      for (size_t member = 0; member < populationSize; member++)
+      {
+        GenerateTrial(population, member, bestElement, trials.slice(member),
+            mask, rng);
+      }
+
+      EvaluateBatch(function, trials, trialFitnessValues, true);
 
-      // Replace the current member if mutant is better.
-      if (mutantValue < iterateValue)
+      for (size_t member = 0; member < populationSize; member++)
       {
-        iterate = mutant;
-        iterateValue = mutantValue;
+        Callback::Evaluate(*this, function, trials.slice(member),
+            trialFitnessValues[member], callbacks...);
 
-        terminate |= Callback::StepTaken(*this, function, iterate,
-            callbacks...);
+        // Replace the current member if the trial is better.
+        if (trialFitnessValues[member] < fitnessValues[member])
+        {
+          population.slice(member) = trials.slice(member);
+          fitnessValues[member] = trialFitnessValues[member];
+
+          terminate |= Callback::StepTaken(*this, function,
+              population.slice(member), callbacks...);
+        }
       }
+    }
+    else
+    {
+      // Generate new population based on /best/1/bin strategy.
+      for (size_t member = 0; member < populationSize; member++)
+      {
+        GenerateTrial(population, member, bestElement, trials.slice(0), mask,
+            rng);
+
+        // The fitness of the current member is already known; the trial only
+        // replaces it if it is better, so its evaluation can stop once it is
+        // worse.
+        const ElemType trialValue = EvaluateBounded(function, trials.slice(0),
+            fitnessValues[member]);
+        Callback::Evaluate(*this, function, trials.slice(0), trialValue,
+            callbacks...);
+
+        // Replace the current member if the trial is better.
+        if (trialValue < fitnessValues[member])
+        {
+          population.slice(member) = trials.slice(0);
+          fitnessValues[member] = trialValue;
 
-      fitnessValues[member] = iterateValue;
-      population[member] = iterate;
+          terminate |= Callback::StepTaken(*this, function,
+              population.slice(member), callbacks...);
+        }
+      }
     }
 
     // Check for termination criteria.
@@ -159,7 +262,7 @@ typename MatType::elem_type DE::Optimize(FunctionType& function,
     {
       if (fitnessValues[it] == lastBestFitness)
       {
-        bestElement = population[it];
+        bestElement = population.slice(it);
         break;
       }
     }
@@ -171,6 +274,209 @@ typename MatType::elem_type DE::Optimize(FunctionType& function,
   return lastBestFitness;
 }
 
+//! Run the island model.
+template<typename SamplingType>
+template<typename FunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+typename MatType::elem_type DEType<SamplingType>::OptimizeIslands(
+    FunctionType& function,
+    MatType& iterate,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t islandSize = populationSize / islands;
+  if (islandSize < 3)
+  {
+    throw std::logic_error("DE::Optimize(): each island should have at least "
+        "3 members!");
+  }
+
+  // The stream of the migrations; island k draws from stream k + 1.
+  RandomStream rng;
+  std::vector<RandomStream> streams;
+  for (size_t k = 0; k < islands; ++k)
+    streams.push_back(rng.Split(k + 1));
+
+  std::vector<arma::Cube<ElemType>> populations(islands);
+  std::vector<arma::Col<ElemType>> fitnessValues(islands);
+  std::vector<arma::Mat<ElemType>> bestElements(islands), trials(islands),
+      masks(islands);
+
+  // The callbacks are called by one island at a time.
+  std::mutex callbackMutex;
+  std::atomic<bool> stop(false);
+
+  // Evolve island k for the given number of generations (0 only creates and
+  // evaluates its population).
+  auto evolve = [&](const size_t k, const size_t generations)
+  {
+    arma::Cube<ElemType>& population = populations[k];
+    arma::Col<ElemType>& fitness = fitnessValues[k];
+    if (generations == 0)
+    {
+      population.set_size(iterate.n_rows, iterate.n_cols, islandSize);
+      fitness.set_size(islandSize);
+      trials[k].set_size(iterate.n_rows, iterate.n_cols);
+      masks[k].set_size(iterate.n_rows, iterate.n_cols);
+      Sample(population, iterate, streams[k]);
+      for (size_t i = 0; i < islandSize; ++i)
+      {
+        fitness[i] = function.Evaluate(population.slice(i));
+
+        std::unique_lock<std::mutex> lock(callbackMutex);
+        Callback::Evaluate(*this, function, population.slice(i), fitness[i],
+            callbacks...);
+      }
+    }
+
+    for (size_t gen = 0; gen < generations && !stop; ++gen)
+    {
+      for (size_t member = 0; member < islandSize; ++member)
+      {
+        GenerateTrial(population, member, bestElements[k], trials[k],
+            masks[k], streams[k]);
+        const ElemType trialValue = EvaluateBounded(function, trials[k],
+            fitness[member]);
+
+        std::unique_lock<std::mutex> lock(callbackMutex);
+        Callback::Evaluate(*this, function, trials[k], trialValue,
+            callbacks...);
+        if (trialValue < fitness[member])
+        {
+          population.slice(member) = trials[k];
+          fitness[member] = trialValue;
+
+          if (Callback::StepTaken(*this, function, population.slice(member),
+              callbacks...))
+          {
+            stop = true;
+          }
+        }
+      }
+
+      bestElements[k] = population.slice(fitness.index_min());
+    }
+
+    if (generations == 0)
+      bestElements[k] = population.slice(fitness.index_min());
+  };
+
+  ParallelFor(islands, [&](const size_t k) { evolve(k, 0); });
+
+  // Find the best member of all islands.
+  auto best = [&](size_t& island)
+  {
+    island = 0;
+    for (size_t k = 1; k < islands; ++k)
+    {
+      if (fitnessValues[k].min() < fitnessValues[island].min())
+        island = k;
+    }
+    return fitnessValues[island].min();
+  };
+
+  size_t bestIsland;
+  ElemType lastBestFitness = best(bestIsland);
+
+  bool terminate = Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  const size_t epoch = (migrationInterval == 0) ? 1 : migrationInterval;
+  for (size_t gen = 0; gen < maxGenerations && !terminate; gen += epoch)
+  {
+    const size_t generations = std::min(epoch, maxGenerations - gen);
+    ParallelFor(islands, [&](const size_t k) { evolve(k, generations); });
+    terminate |= stop;
+
+    if (migrationInterval > 0)
+    {
+      MigrateIslands(populations, fitnessValues, migrants, randomMigration,
+          rng);
+      for (size_t k = 0; k < islands; ++k)
+        bestElements[k] = populations[k].slice(fitnessValues[k].index_min());
+    }
+
+    // Check for termination criteria.
+    const ElemType bestFitness = best(bestIsland);
+    if (std::abs(lastBestFitness - bestFitness) < tolerance)
+    {
+      Info << "DE: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+      lastBestFitness = bestFitness;
+      break;
+    }
+
+    lastBestFitness = bestFitness;
+  }
+
+  iterate = bestElements[bestIsland];
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return lastBestFitness;
+}
+
+//! Sample the population around the given point.
+template<typename SamplingType>
+template<typename MatType, typename ElemType>
+inline void DEType<SamplingType>::Sample(arma::Cube<ElemType>& population,
+                                         const MatType& iterate,
+                                         RandomStream& rng) const
+{
+  // The slices of the cube are contiguous, so the whole population is sampled
+  // at once as a matrix with one candidate per column.
+  arma::Mat<ElemType> points(population.memptr(), iterate.n_elem,
+      population.n_slices, false, true);
+  sampling.FillNormal(points, rng);
+  for (size_t i = 0; i < population.n_slices; ++i)
+    population.slice(i) += iterate;
+}
+
+//! Generate a trial candidate for the given member.
+template<typename SamplingType>
+template<typename MatType, typename ElemType>
+inline void DEType<SamplingType>::GenerateTrial(
+    const arma::Cube<ElemType>& population,
+    const size_t member,
+    const MatType& bestElement,
+    arma::Mat<ElemType>& trial,
+    arma::Mat<ElemType>& mask,
+    RandomStream& rng) const
+{
+  // Generate two different random numbers to choose two random members.
+  const size_t size = population.n_slices;
+  size_t l = 0, m = 0;
+  do
+  {
+    l = rng.Integer(size);
+  }
+  while (l == member);
+
+  do
+  {
+    m = rng.Integer(size);
+  }
+  while (m == member || m == l);
+
+  rng.FillUniform(mask);
+
+  // Generate the new "mutant" from the two randomly chosen members, and
+  // perform crossover in the same pass: keep the parameters of the member
+  // wherever the random number is at least the crossover rate.
+  ElemType* t = trial.memptr();
+  const ElemType* p = population.slice_memptr(member);
+  const ElemType* a = population.slice_memptr(l);
+  const ElemType* b = population.slice_memptr(m);
+  const ElemType* best = bestElement.memptr();
+  const ElemType* r = mask.memptr();
+  const ElemType rate = (ElemType) crossoverRate;
+  const ElemType weight = (ElemType) differentialWeight;
+
+  ENS_PRAGMA_OMP_SIMD
+  for (size_t i = 0; i < trial.n_elem; ++i)
+    t[i] = (r[i] >= rate) ? p[i] : best[i] + weight * (a[i] - b[i]);
+}
+
 } // namespace ens
 
 #endif
@@ -0,0 +1,188 @@
+/**
+ * @file all_reduce_function.hpp
+ *
+ * A function wrapper that sums the objective and gradient of a function over
+ * all processes of a communicator, for data-parallel distributed optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_ALL_REDUCE_FUNCTION_HPP
+#define ENSMALLEN_DISTRIBUTED_ALL_REDUCE_FUNCTION_HPP
+
+#include "communicator.hpp"
+
+namespace ens {
+
+/**
+ * AllReduceFunction wraps a function whose data is sharded over several
+ * processes: on each process, `function` represents the local shard.  Every
+ * evaluation of the objective or the gradient is done on the local shard, and
+ * the result is then summed over all processes with the communicator, so that
+ * each process sees the objective and gradient of the whole dataset (or of the
+ * union of the local batches, for separable functions).
+ *
+ * Since every process sees the same gradient, every process takes the same
+ * steps when the same optimizer is run on every process with the same starting
+ * point; so this turns any optimizer into a synchronous data-parallel one.  For
+ * example, to run L-BFGS or SGD on a dataset split over MPI processes:
+ *
+ * @code
+ * // On each process, `local` is the function for the local shard.
+ * MPICommunicator comm;
+ * AllReduceFunction<MyFunction, MPICommunicator> f(local, comm);
+ *
+ * L_BFGS lbfgs;
+ * lbfgs.Optimize(f, coordinates);
+ * @endcode
+ *
+ * For separable functions, every process must have the same number of
+ * functions (i.e. the shards must be the same size), so that all processes
+ * take the same number of steps.  Since the batch indices refer to the local
+ * shard, each process may shuffle its own shard independently.
+ *
+ * The gradient must be a dense matrix.
+ *
+ * @tparam FunctionType Type of the local function.
+ * @tparam CommunicatorType Type of the communicator (see LocalCommunicator).
+ */
+template<typename FunctionType, typename CommunicatorType = LocalCommunicator>
+class AllReduceFunction
+{
+ public:
+  /**
+   * Construct the AllReduceFunction around the given local function.
+   *
+   * @param function Function for the local shard of the data.
+   * @param communicator Communicator used to sum the results.
+   */
+  AllReduceFunction(FunctionType& function, CommunicatorType& communicator) :
+      function(function),
+      communicator(communicator)
+  { /* Nothing to do. */ }
+
+  //! Return the number of functions in the local shard.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the local shard.
+  void Shuffle() { function.Shuffle(); }
+
+  /**
+   * Evaluate the objective of the given batch of every process, and return the
+   * sum.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize)
+  {
+    typename MatType::elem_type objective = Full<MatType, MatType>().Evaluate(
+        coordinates, begin, batchSize);
+    communicator.AllReduceSum(&objective, 1);
+    return objective;
+  }
+
+  /**
+   * Evaluate the gradient of the given batch of every process, and store the
+   * sum in `gradient`.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize)
+  {
+    Full<MatType, GradType>().Gradient(coordinates, begin, gradient,
+        batchSize);
+    Reduce(gradient);
+  }
+
+  /**
+   * Evaluate the objective and gradient of the given batch of every process,
+   * and return the sum of the objectives; the sum of the gradients is stored
+   * in `gradient`.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   const size_t begin,
+                                                   GradType& gradient,
+                                                   const size_t batchSize)
+  {
+    typename MatType::elem_type objective =
+        Full<MatType, GradType>().EvaluateWithGradient(coordinates, begin,
+        gradient, batchSize);
+    communicator.AllReduceSum(&objective, 1);
+    Reduce(gradient);
+    return objective;
+  }
+
+  //! Evaluate the objective of every process, and return the sum.
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates)
+  {
+    typename MatType::elem_type objective =
+        Full<MatType, MatType>().Evaluate(coordinates);
+    communicator.AllReduceSum(&objective, 1);
+    return objective;
+  }
+
+  //! Evaluate the gradient of every process, and store the sum in `gradient`.
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates, GradType& gradient)
+  {
+    Full<MatType, GradType>().Gradient(coordinates, gradient);
+    Reduce(gradient);
+  }
+
+  /**
+   * Evaluate the objective and gradient of every process, and return the sum
+   * of the objectives; the sum of the gradients is stored in `gradient`.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   GradType& gradient)
+  {
+    typename MatType::elem_type objective =
+        Full<MatType, GradType>().EvaluateWithGradient(coordinates, gradient);
+    communicator.AllReduceSum(&objective, 1);
+    Reduce(gradient);
+    return objective;
+  }
+
+  //! Get the local function.
+  const FunctionType& LocalFunction() const { return function; }
+  //! Modify the local function.
+  FunctionType& LocalFunction() { return function; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+ private:
+  //! Return the local function, with all the methods that ensmallen can
+  //! derive from the ones it has.
+  template<typename MatType, typename GradType>
+  Function<FunctionType, MatType, GradType>& Full()
+  {
+    return static_cast<Function<FunctionType, MatType, GradType>&>(function);
+  }
+
+  //! Sum the given gradient over all processes.
+  template<typename GradType>
+  void Reduce(GradType& gradient)
+  {
+    communicator.AllReduceSum(gradient.memptr(), gradient.n_elem);
+  }
+
+  //! The function for the local shard.
+  FunctionType& function;
+  //! The communicator used to sum results.
+  CommunicatorType& communicator;
+};
+
+} // namespace ens
+
+#endif
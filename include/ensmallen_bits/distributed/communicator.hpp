@@ -0,0 +1,117 @@
+/**
+ * @file communicator.hpp
+ *
+ * Communicators used by the distributed optimization tools to combine data
+ * across processes.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_COMMUNICATOR_HPP
+#define ENSMALLEN_DISTRIBUTED_COMMUNICATOR_HPP
+
+#ifdef ENS_USE_MPI
+  #include <mpi.h>
+#endif
+
+namespace ens {
+
+/**
+ * A communicator is the interface between the distributed optimization tools
+ * (AllReduceFunction and ModelAveraging) and whatever transport is used between
+ * the processes (or "ranks").  Any class with the following methods can be
+ * used:
+ *
+ * @code
+ * // Return the index of this process.
+ * size_t Rank() const;
+ * // Return the total number of processes.
+ * size_t Size() const;
+ * // Replace data[0 .. n - 1] on every process with the elementwise sum of the
+ * // data of all processes.
+ * void AllReduceSum(double* data, const size_t n);
+ * void AllReduceSum(float* data, const size_t n);
+ * @endcode
+ *
+ * The LocalCommunicator is a communicator for a single process; it is useful
+ * for testing, and for code that should also run without a cluster.
+ */
+class LocalCommunicator
+{
+ public:
+  //! Return the index of this process; this is always 0.
+  size_t Rank() const { return 0; }
+
+  //! Return the total number of processes; this is always 1.
+  size_t Size() const { return 1; }
+
+  //! Sum the given data over all processes; with one process this does
+  //! nothing.
+  template<typename ElemType>
+  void AllReduceSum(ElemType* /* data */, const size_t /* n */) { }
+};
+
+#ifdef ENS_USE_MPI
+
+/**
+ * A communicator that uses MPI.  This is only available if ENS_USE_MPI is
+ * defined before ensmallen.hpp is included; the program must then be linked
+ * against an MPI implementation, and MPI_Init() must have been called before
+ * the communicator is used.
+ */
+class MPICommunicator
+{
+ public:
+  /**
+   * Construct the communicator with the given MPI communicator.
+   *
+   * @param comm MPI communicator of the processes that take part.
+   */
+  MPICommunicator(MPI_Comm comm = MPI_COMM_WORLD) : comm(comm)
+  { /* Nothing to do. */ }
+
+  //! Return the index of this process.
+  size_t Rank() const
+  {
+    int rank = 0;
+    MPI_Comm_rank(comm, &rank);
+    return (size_t) rank;
+  }
+
+  //! Return the total number of processes.
+  size_t Size() const
+  {
+    int size = 1;
+    MPI_Comm_size(comm, &size);
+    return (size_t) size;
+  }
+
+  //! Sum the given data over all processes.
+  void AllReduceSum(double* data, const size_t n)
+  {
+    MPI_Allreduce(MPI_IN_PLACE, data, (int) n, MPI_DOUBLE, MPI_SUM, comm);
+  }
+
+  //! Sum the given data over all processes.
+  void AllReduceSum(float* data, const size_t n)
+  {
+    MPI_Allreduce(MPI_IN_PLACE, data, (int) n, MPI_FLOAT, MPI_SUM, comm);
+  }
+
+  //! Get the MPI communicator.
+  MPI_Comm Comm() const { return comm; }
+  //! Modify the MPI communicator.
+  MPI_Comm& Comm() { return comm; }
+
+ private:
+  //! The MPI communicator.
+  MPI_Comm comm;
+};
+
+#endif
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,190 @@
+/**
+ * @file consensus_admm.hpp
+ *
+ * Consensus ADMM for objectives that are sums of blocks, with the blocks
+ * solved in parallel on the threads of each process and over the processes of
+ * a communicator.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_CONSENSUS_ADMM_HPP
+#define ENSMALLEN_DISTRIBUTED_CONSENSUS_ADMM_HPP
+
+#include <ensmallen_bits/lbfgs/lbfgs.hpp>
+#include "communicator.hpp"
+#include "consensus_admm_function.hpp"
+
+namespace ens {
+
+/**
+ * ConsensusADMM minimizes an objective of the form
+ *
+ *   f(x) = sum_k f_k(x),
+ *
+ * where each block f_k is typically the objective of one shard of the data.
+ * It solves the equivalent problem of minimizing sum_k f_k(x_k) subject to
+ * x_k = z for every k with the alternating direction method of multipliers:
+ * every round, each block solves its own subproblem
+ *
+ *   x_k = argmin f_k(x) + (rho / 2) || x - z + u_k ||^2
+ *
+ * with the given optimizer, warm-started from its solution of the previous
+ * round; then the consensus point z is the average of the (over-relaxed)
+ * x_k + u_k, and each scaled dual variable u_k accumulates the disagreement
+ * x_k - z.  The subproblems are independent, so they are solved in parallel,
+ * and the blocks may be spread over the processes of a communicator; the only
+ * communication is one sum of the coordinates per round.  Each block keeps its
+ * own copy of the optimizer, and if the optimizer has a ResetPolicy() option,
+ * it is set to false so that its state (for instance, the curvature pairs of
+ * L_BFGS) is kept between rounds.
+ *
+ * With over-relaxation, x_k is replaced by alpha x_k + (1 - alpha) z in the
+ * updates of z and u_k; values of alpha in [1.5, 1.8] often converge faster
+ * than alpha = 1, which is plain ADMM.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{boyd2011distributed,
+ *   title   = {Distributed Optimization and Statistical Learning via the
+ *              Alternating Direction Method of Multipliers},
+ *   author  = {Boyd, Stephen and Parikh, Neal and Chu, Eric and Peleato,
+ *              Borja and Eckstein, Jonathan},
+ *   journal = {Foundations and Trends in Machine Learning},
+ *   volume  = {3},
+ *   number  = {1},
+ *   pages   = {1--122},
+ *   year    = {2011}
+ * }
+ * @endcode
+ *
+ * The optimization terminates when both the primal residual
+ * sqrt(sum_k || x_k - z ||^2) and the dual residual rho sqrt(K) || z - z_old ||
+ * are below the tolerance, where K is the number of blocks over all processes.
+ * Both are summed over all processes, so every process runs the same number of
+ * rounds.
+ *
+ * ConsensusADMM can optimize sums of functions with dense coordinates, as long
+ * as the given optimizer can optimize the subproblems; since the subproblems
+ * only have the non-separable Evaluate(), Gradient() and
+ * EvaluateWithGradient() methods, the optimizer must be one for arbitrary or
+ * differentiable functions (e.g. L_BFGS or GradientDescent).
+ *
+ * @tparam OptimizerType Optimizer used on the subproblems.
+ * @tparam CommunicatorType Type of the communicator (see LocalCommunicator).
+ */
+template<typename OptimizerType = L_BFGS,
+         typename CommunicatorType = LocalCommunicator>
+class ConsensusADMM
+{
+ public:
+  /**
+   * Construct the ConsensusADMM optimizer.
+   *
+   * @param optimizer Optimizer used on the subproblems.
+   * @param communicator Communicator used to sum the blocks of all processes.
+   * @param rho Penalty parameter of the augmented Lagrangian.
+   * @param alpha Over-relaxation parameter (in (0, 2); 1 means no
+   *     relaxation).
+   * @param maxRounds Maximum number of rounds (0 means no limit).
+   * @param tolerance Maximum primal and dual residuals to terminate the
+   *     algorithm.
+   */
+  ConsensusADMM(const OptimizerType& optimizer = OptimizerType(),
+                const CommunicatorType& communicator = CommunicatorType(),
+                const double rho = 1.0,
+                const double alpha = 1.5,
+                const size_t maxRounds = 100,
+                const double tolerance = 1e-5);
+
+  /**
+   * Minimize the sum of the given blocks, and of the blocks of all other
+   * processes, with consensus ADMM.  The given starting point will be modified
+   * to store the consensus point at the end of the algorithm (which is the same
+   * on every process), and the objective of the final point, summed over all
+   * blocks of all processes, is returned.
+   *
+   * @tparam FunctionType Type of the functions of the blocks.
+   * @tparam MatType Type of matrix to optimize with.
+   * @param functions Functions of the local blocks (may be empty).
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename MatType>
+  typename MatType::elem_type Optimize(std::vector<FunctionType>& functions,
+                                       MatType& iterate);
+
+  //! Get the optimizer used on the subproblems.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer used on the subproblems.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+  //! Get the penalty parameter.
+  double Rho() const { return rho; }
+  //! Modify the penalty parameter.
+  double& Rho() { return rho; }
+
+  //! Get the over-relaxation parameter.
+  double Alpha() const { return alpha; }
+  //! Modify the over-relaxation parameter.
+  double& Alpha() { return alpha; }
+
+  //! Get the maximum number of rounds (0 indicates no limit).
+  size_t MaxRounds() const { return maxRounds; }
+  //! Modify the maximum number of rounds (0 indicates no limit).
+  size_t& MaxRounds() { return maxRounds; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! Keep the state of the optimizer of a block between rounds, if it has a
+  //! ResetPolicy() option.
+  template<typename T>
+  static typename std::enable_if<traits::HasResetPolicySignature<T>::value,
+      void>::type
+  KeepPolicy(T& optimizer)
+  {
+    optimizer.ResetPolicy() = false;
+  }
+
+  template<typename T>
+  static typename std::enable_if<!traits::HasResetPolicySignature<T>::value,
+      void>::type
+  KeepPolicy(T& /* optimizer */) { }
+
+  //! The optimizer used on the subproblems.
+  OptimizerType optimizer;
+
+  //! The communicator used to sum the blocks of all processes.
+  CommunicatorType communicator;
+
+  //! The penalty parameter.
+  double rho;
+
+  //! The over-relaxation parameter.
+  double alpha;
+
+  //! The maximum number of rounds.
+  size_t maxRounds;
+
+  //! The tolerance for termination.
+  double tolerance;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "consensus_admm_impl.hpp"
+
+#endif
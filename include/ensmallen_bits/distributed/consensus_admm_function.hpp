@@ -0,0 +1,116 @@
+/**
+ * @file consensus_admm_function.hpp
+ *
+ * The augmented subproblem of one block of consensus ADMM.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_CONSENSUS_ADMM_FUNCTION_HPP
+#define ENSMALLEN_DISTRIBUTED_CONSENSUS_ADMM_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * ConsensusADMMFunction wraps the function f_k of one block of a consensus
+ * ADMM problem, and represents the subproblem
+ *
+ *   f_k(x) + (rho / 2) || x - c ||^2,
+ *
+ * where the center c = z - u_k is the difference of the consensus point and
+ * the scaled dual variable of the block.  The center is set by ConsensusADMM
+ * before each round; only the non-separable Evaluate(), Gradient() and
+ * EvaluateWithGradient() methods are provided, for any of which ensmallen can
+ * derive from the methods of the wrapped function.
+ *
+ * @tparam FunctionType Type of the function of the block.
+ * @tparam MatType Type of the center.
+ */
+template<typename FunctionType, typename MatType>
+class ConsensusADMMFunction
+{
+ public:
+  //! Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Construct the subproblem of the given block.
+   *
+   * @param function Function of the block.
+   * @param rho Penalty parameter.
+   */
+  ConsensusADMMFunction(FunctionType& function, const double rho) :
+      function(&function),
+      rho(rho)
+  { /* Nothing to do. */ }
+
+  //! Evaluate the subproblem at the given coordinates.
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    return Full<MatType>().Evaluate(coordinates) + Penalty(coordinates);
+  }
+
+  //! Evaluate the gradient of the subproblem at the given coordinates.
+  template<typename GradType>
+  void Gradient(const MatType& coordinates, GradType& gradient)
+  {
+    Full<GradType>().Gradient(coordinates, gradient);
+    gradient += rho * (coordinates - center);
+  }
+
+  //! Evaluate the subproblem and its gradient at the given coordinates.
+  template<typename GradType>
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                GradType& gradient)
+  {
+    const ElemType objective = Full<GradType>().EvaluateWithGradient(
+        coordinates, gradient);
+    gradient += rho * (coordinates - center);
+    return objective + Penalty(coordinates);
+  }
+
+  //! Get the function of the block.
+  const FunctionType& BlockFunction() const { return *function; }
+  //! Modify the function of the block.
+  FunctionType& BlockFunction() { return *function; }
+
+  //! Get the center of the penalty.
+  const MatType& Center() const { return center; }
+  //! Modify the center of the penalty.
+  MatType& Center() { return center; }
+
+  //! Get the penalty parameter.
+  double Rho() const { return rho; }
+  //! Modify the penalty parameter.
+  double& Rho() { return rho; }
+
+ private:
+  //! Return the function of the block, with all the methods that ensmallen
+  //! can derive from the ones it has.
+  template<typename GradType>
+  Function<FunctionType, MatType, GradType>& Full()
+  {
+    return static_cast<Function<FunctionType, MatType, GradType>&>(*function);
+  }
+
+  //! Return the value of the penalty at the given coordinates.
+  ElemType Penalty(const MatType& coordinates) const
+  {
+    const ElemType distance = arma::norm(coordinates - center, "fro");
+    return 0.5 * rho * distance * distance;
+  }
+
+  //! The function of the block; a pointer, so that the subproblems can be
+  //! stored in a std::vector.
+  FunctionType* function;
+  //! The center of the penalty.
+  MatType center;
+  //! The penalty parameter.
+  double rho;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ * @file consensus_admm_impl.hpp
+ *
+ * Implementation of consensus ADMM.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_CONSENSUS_ADMM_IMPL_HPP
+#define ENSMALLEN_DISTRIBUTED_CONSENSUS_ADMM_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "consensus_admm.hpp"
+
+#include <ensmallen_bits/utility/executor.hpp>
+
+namespace ens {
+
+template<typename OptimizerType, typename CommunicatorType>
+ConsensusADMM<OptimizerType, CommunicatorType>::ConsensusADMM(
+    const OptimizerType& optimizer,
+    const CommunicatorType& communicator,
+    const double rho,
+    const double alpha,
+    const size_t maxRounds,
+    const double tolerance) :
+    optimizer(optimizer),
+    communicator(communicator),
+    rho(rho),
+    alpha(alpha),
+    maxRounds(maxRounds),
+    tolerance(tolerance)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType, typename CommunicatorType>
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type
+ConsensusADMM<OptimizerType, CommunicatorType>::Optimize(
+    std::vector<FunctionType>& functions,
+    MatType& iterateIn)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef ConsensusADMMFunction<FunctionType, BaseMatType> SubproblemType;
+  typedef Function<FunctionType, BaseMatType, BaseMatType> FullFunctionType;
+
+  RequireDenseFloatingPointType<BaseMatType>();
+
+  if (rho <= 0.0 || alpha <= 0.0 || alpha >= 2.0)
+  {
+    throw std::invalid_argument("ConsensusADMM::Optimize(): rho must be "
+        "positive and alpha must be in (0, 2)!");
+  }
+
+  BaseMatType& z = (BaseMatType&) iterateIn;
+
+  // Count the blocks of all processes; the sum is done in floating point since
+  // that is what the communicator can sum.
+  const size_t numLocalBlocks = functions.size();
+  ElemType numBlocks = (ElemType) numLocalBlocks;
+  communicator.AllReduceSum(&numBlocks, 1);
+  if (numBlocks == 0)
+  {
+    throw std::invalid_argument("ConsensusADMM::Optimize(): no blocks to "
+        "optimize!");
+  }
+
+  // Make sure that every process starts from the same point.
+  const size_t size = communicator.Size();
+  if (size > 1)
+  {
+    communicator.AllReduceSum(z.memptr(), z.n_elem);
+    z /= (ElemType) size;
+  }
+
+  // Every block has its own subproblem, optimizer, local solution (which is
+  // the starting point of the next round) and scaled dual variable.
+  std::vector<SubproblemType> subproblems;
+  subproblems.reserve(numLocalBlocks);
+  for (size_t k = 0; k < numLocalBlocks; ++k)
+    subproblems.push_back(SubproblemType(functions[k], rho));
+
+  std::vector<OptimizerType> optimizers(numLocalBlocks, optimizer);
+  for (size_t k = 0; k < numLocalBlocks; ++k)
+    KeepPolicy(optimizers[k]);
+
+  std::vector<BaseMatType> x(numLocalBlocks, z);
+  std::vector<BaseMatType> u(numLocalBlocks,
+      BaseMatType(z.n_rows, z.n_cols, arma::fill::zeros));
+  BaseMatType oldZ;
+
+  const size_t actualMaxRounds = (maxRounds == 0) ?
+      std::numeric_limits<size_t>::max() : maxRounds;
+  size_t i = 0;
+  for (; i < actualMaxRounds; ++i)
+  {
+    // Solve the subproblems of the local blocks.
+    ParallelFor(numLocalBlocks, [&](const size_t k)
+    {
+      subproblems[k].Center() = z - u[k];
+      optimizers[k].Optimize(subproblems[k], x[k]);
+    });
+
+    // The over-relaxed solutions are accumulated in place into the dual
+    // variables, so that u_k holds alpha x_k + (1 - alpha) z + u_k while the
+    // new consensus point is computed, and losing the old z costs nothing.
+    oldZ = z;
+    z.zeros();
+    for (size_t k = 0; k < numLocalBlocks; ++k)
+    {
+      u[k] += alpha * x[k] + (1.0 - alpha) * oldZ;
+      z += u[k];
+    }
+    communicator.AllReduceSum(z.memptr(), z.n_elem);
+    z /= numBlocks;
+
+    ElemType primalResidual = 0;
+    for (size_t k = 0; k < numLocalBlocks; ++k)
+    {
+      u[k] -= z;
+      const ElemType distance = arma::norm(x[k] - z, "fro");
+      primalResidual += distance * distance;
+    }
+    communicator.AllReduceSum(&primalResidual, 1);
+    primalResidual = std::sqrt(primalResidual);
+    const ElemType dualResidual = rho * std::sqrt(numBlocks) *
+        arma::norm(z - oldZ, "fro");
+
+    Info << "ConsensusADMM: round " << i << ", primal residual "
+        << primalResidual << ", dual residual " << dualResidual << "."
+        << std::endl;
+
+    if (std::isnan(primalResidual) || std::isinf(primalResidual) ||
+        std::isnan(dualResidual) || std::isinf(dualResidual))
+    {
+      Warn << "ConsensusADMM: residuals are not finite; terminating with "
+          << "failure.  Try a larger rho?" << std::endl;
+      break;
+    }
+
+    if (primalResidual < tolerance && dualResidual < tolerance)
+    {
+      Info << "ConsensusADMM: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      break;
+    }
+  }
+
+  if (i == actualMaxRounds)
+  {
+    Info << "ConsensusADMM: maximum rounds (" << maxRounds << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  ElemType objective = 0;
+  for (size_t k = 0; k < numLocalBlocks; ++k)
+    objective += static_cast<FullFunctionType&>(functions[k]).Evaluate(z);
+  communicator.AllReduceSum(&objective, 1);
+
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file model_averaging.hpp
+ *
+ * Local SGD with periodic model averaging over the processes of a
+ * communicator.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_MODEL_AVERAGING_HPP
+#define ENSMALLEN_DISTRIBUTED_MODEL_AVERAGING_HPP
+
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include "communicator.hpp"
+
+namespace ens {
+
+/**
+ * ModelAveraging implements local SGD (also known as parallel SGD with
+ * periodic averaging): every process owns a shard of the data and runs the
+ * given optimizer on its own shard for `period` iterations, then the
+ * coordinates of all processes are averaged with the communicator, and the
+ * next round starts from the average.  Compared to summing gradients at every
+ * step (see AllReduceFunction), this needs one round of communication every
+ * `period` iterations instead of every batch.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{stich2019local,
+ *   title     = {Local {SGD} Converges Fast and Communicates Little},
+ *   author    = {Stich, Sebastian U.},
+ *   booktitle = {International Conference on Learning Representations},
+ *   year      = {2019}
+ * }
+ * @endcode
+ *
+ * Every process must run the same number of rounds, so the termination
+ * criteria only use values that are summed over all processes.
+ *
+ * ModelAveraging can optimize differentiable separable functions with dense
+ * coordinates, as long as the given optimizer can.
+ *
+ * @tparam OptimizerType Optimizer run on the local shard; it must provide
+ *     MaxIterations().
+ * @tparam CommunicatorType Type of the communicator (see LocalCommunicator).
+ */
+template<typename OptimizerType = StandardSGD,
+         typename CommunicatorType = LocalCommunicator>
+class ModelAveraging
+{
+ public:
+  /**
+   * Construct the ModelAveraging optimizer.
+   *
+   * @param optimizer Optimizer to run on the local shard.
+   * @param communicator Communicator used to average the coordinates.
+   * @param period Number of iterations of the local optimizer between two
+   *     averaging steps.
+   * @param maxRounds Maximum number of averaging rounds (0 means no limit).
+   * @param tolerance Maximum absolute tolerance to terminate the algorithm.
+   */
+  ModelAveraging(const OptimizerType& optimizer = OptimizerType(),
+                 const CommunicatorType& communicator = CommunicatorType(),
+                 const size_t period = 1000,
+                 const size_t maxRounds = 100,
+                 const double tolerance = 1e-5);
+
+  /**
+   * Optimize the given function using model averaging.  The given starting
+   * point will be modified to store the finishing point of the algorithm (which
+   * is the same on every process), and the sum of the final objective
+   * estimates of all processes is returned.
+   *
+   * @tparam SeparableFunctionType Type of the function for the local shard.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function for the local shard of the data.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the local optimizer.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the local optimizer.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the communicator.
+  const CommunicatorType& Communicator() const { return communicator; }
+  //! Modify the communicator.
+  CommunicatorType& Communicator() { return communicator; }
+
+  //! Get the number of local iterations between two averaging steps.
+  size_t Period() const { return period; }
+  //! Modify the number of local iterations between two averaging steps.
+  size_t& Period() { return period; }
+
+  //! Get the maximum number of averaging rounds (0 indicates no limit).
+  size_t MaxRounds() const { return maxRounds; }
+  //! Modify the maximum number of averaging rounds (0 indicates no limit).
+  size_t& MaxRounds() { return maxRounds; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! Replace the coordinates of every process by the average over all
+  //! processes.
+  template<typename MatType>
+  void Average(MatType& iterate);
+
+  //! Keep the state of the local optimizer between rounds, if it has a
+  //! ResetPolicy() option.
+  template<typename T>
+  static typename std::enable_if<traits::HasResetPolicySignature<T>::value,
+      void>::type
+  KeepPolicy(T& optimizer)
+  {
+    optimizer.ResetPolicy() = false;
+  }
+
+  template<typename T>
+  static typename std::enable_if<!traits::HasResetPolicySignature<T>::value,
+      void>::type
+  KeepPolicy(T& /* optimizer */) { }
+
+  //! The optimizer run on the local shard.
+  OptimizerType optimizer;
+
+  //! The communicator used to average the coordinates.
+  CommunicatorType communicator;
+
+  //! The number of local iterations between two averaging steps.
+  size_t period;
+
+  //! The maximum number of averaging rounds.
+  size_t maxRounds;
+
+  //! The tolerance for termination.
+  double tolerance;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "model_averaging_impl.hpp"
+
+#endif
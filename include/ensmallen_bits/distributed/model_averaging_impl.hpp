@@ -0,0 +1,124 @@
+/**
+ * @file model_averaging_impl.hpp
+ *
+ * Implementation of local SGD with periodic model averaging.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_DISTRIBUTED_MODEL_AVERAGING_IMPL_HPP
+#define ENSMALLEN_DISTRIBUTED_MODEL_AVERAGING_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "model_averaging.hpp"
+
+namespace ens {
+
+template<typename OptimizerType, typename CommunicatorType>
+ModelAveraging<OptimizerType, CommunicatorType>::ModelAveraging(
+    const OptimizerType& optimizer,
+    const CommunicatorType& communicator,
+    const size_t period,
+    const size_t maxRounds,
+    const double tolerance) :
+    optimizer(optimizer),
+    communicator(communicator),
+    period(period),
+    maxRounds(maxRounds),
+    tolerance(tolerance)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType, typename CommunicatorType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+ModelAveraging<OptimizerType, CommunicatorType>::Optimize(
+    SeparableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  RequireDenseFloatingPointType<BaseMatType>();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  // Each round runs the local optimizer for the given period, and the state
+  // of the local optimizer is kept between rounds.
+  optimizer.MaxIterations() = period;
+  KeepPolicy(optimizer);
+
+  // Make sure that every process starts from the same point.
+  Average(iterate);
+
+  ElemType overallObjective = std::numeric_limits<ElemType>::max();
+  ElemType lastObjective;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+  const size_t actualMaxRounds = (maxRounds == 0) ?
+      std::numeric_limits<size_t>::max() : maxRounds;
+  for (size_t i = 0; i < actualMaxRounds && !terminate; ++i)
+  {
+    lastObjective = overallObjective;
+
+    // Take the local steps, then average.  The objective estimates of all
+    // processes are summed, so that every process makes the same decision
+    // about termination.
+    overallObjective = optimizer.Optimize(function, iterate, callbacks...);
+    communicator.AllReduceSum(&overallObjective, 1);
+    Average(iterate);
+
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Warn << "ModelAveraging: converged to " << overallObjective
+          << "; terminating with failure.  Try a smaller step size?"
+          << std::endl;
+
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Info << "ModelAveraging: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+
+      Callback::EndOptimization(*this, function, iterate, callbacks...);
+      return overallObjective;
+    }
+  }
+
+  Info << "ModelAveraging: maximum rounds (" << maxRounds << ") reached; "
+      << "terminating optimization." << std::endl;
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return overallObjective;
+}
+
+template<typename OptimizerType, typename CommunicatorType>
+template<typename MatType>
+void ModelAveraging<OptimizerType, CommunicatorType>::Average(
+    MatType& iterate)
+{
+  const size_t size = communicator.Size();
+  if (size <= 1)
+    return;
+
+  communicator.AllReduceSum(iterate.memptr(), iterate.n_elem);
+  iterate /= (typename MatType::elem_type) size;
+}
+
+} // namespace ens
+
+#endif
@@ -13,6 +13,9 @@
 #ifndef ENSMALLEN_EVE_EVE_HPP
 #define ENSMALLEN_EVE_EVE_HPP
 
+#include <ensmallen_bits/sgd/sgd.hpp>
+#include "eve_update.hpp"
+
 namespace ens {
 
 /**
@@ -48,6 +51,10 @@ namespace ens {
  * Eve can optimize differentiable separable functions.  For more details,
  * see the documentation on function types included with this distribution or on
  * the ensmallen website.
+ *
+ * Eve is SGD with the EveUpdate policy, so it can also split its minibatches
+ * across threads and save and restore its state; EveUpdate can also be used
+ * directly with SGD, e.g. in ParameterGroups.
  */
 class Eve
 {
@@ -110,7 +117,12 @@ class Eve
       typename MatType::elem_type>::type
   Optimize(SeparableFunctionType& function,
            MatType& iterate,
-           CallbackTypes&&... callbacks);
+           CallbackTypes&&... callbacks)
+  {
+    return optimizer.template Optimize<
+        SeparableFunctionType, MatType, GradType, CallbackTypes...>(
+        function, iterate, std::forward<CallbackTypes>(callbacks)...);
+  }
 
   //! Forward the MatType as GradType.
   template<typename SeparableFunctionType,
@@ -125,95 +137,98 @@ class Eve
         std::forward<CallbackTypes>(callbacks)...);
   }
 
+  //! Save the state of the optimizer; see SGD::SaveState().
+  template<typename MatType, typename GradType = MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& iterate)
+  { optimizer.template SaveState<MatType, GradType>(ar, iterate); }
+
+  //! Restore the state of the optimizer; see SGD::LoadState().
+  template<typename MatType, typename GradType = MatType>
+  void LoadState(CheckpointReader& ar, const MatType& iterate)
+  { optimizer.template LoadState<MatType, GradType>(ar, iterate); }
+
+  //! Return the number of bytes that Optimize() keeps for coordinates of the
+  //! given size; see SGD::StateBytes().
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return optimizer.template StateBytes<MatType, GradType>(rows, cols); }
+
   //! Get the step size.
-  double StepSize() const { return stepSize; }
+  double StepSize() const { return optimizer.StepSize(); }
   //! Modify the step size.
-  double& StepSize() { return stepSize; }
+  double& StepSize() { return optimizer.StepSize(); }
 
   //! Get the batch size.
-  size_t BatchSize() const { return batchSize; }
+  size_t BatchSize() const { return optimizer.BatchSize(); }
   //! Modify the batch size.
-  size_t& BatchSize() { return batchSize; }
+  size_t& BatchSize() { return optimizer.BatchSize(); }
 
   //! Get the smoothing parameter.
-  double Beta1() const { return beta1; }
+  double Beta1() const { return optimizer.UpdatePolicy().Beta1(); }
   //! Modify the smoothing parameter.
-  double& Beta1() { return beta1; }
+  double& Beta1() { return optimizer.UpdatePolicy().Beta1(); }
 
   //! Get the second moment coefficient.
-  double Beta2() const { return beta2; }
+  double Beta2() const { return optimizer.UpdatePolicy().Beta2(); }
   //! Modify the second moment coefficient.
-  double& Beta2() { return beta2; }
+  double& Beta2() { return optimizer.UpdatePolicy().Beta2(); }
 
   //! Get the exponential decay rate for relative change.
-  double Beta3() const { return beta3; }
+  double Beta3() const { return optimizer.UpdatePolicy().Beta3(); }
   //! Modify the exponential decay rate for relative change.
-  double& Beta3() { return beta3; }
+  double& Beta3() { return optimizer.UpdatePolicy().Beta3(); }
 
   //! Get the value used to initialise the mean squared gradient parameter.
-  double Epsilon() const { return epsilon; }
+  double Epsilon() const { return optimizer.UpdatePolicy().Epsilon(); }
   //! Modify the value used to initialise the mean squared gradient parameter.
-  double& Epsilon() { return epsilon; }
+  double& Epsilon() { return optimizer.UpdatePolicy().Epsilon(); }
 
   //! Get the clipping range to avoid extreme valus.
-  double Clip() const { return clip; }
+  double Clip() const { return optimizer.UpdatePolicy().Clip(); }
   //! Modify the clipping range to avoid extreme valus.
-  double& Clip() { return clip; }
+  double& Clip() { return optimizer.UpdatePolicy().Clip(); }
 
   //! Get the maximum number of iterations (0 indicates no limit).
-  size_t MaxIterations() const { return maxIterations; }
+  size_t MaxIterations() const { return optimizer.MaxIterations(); }
   //! Modify the maximum number of iterations (0 indicates no limit).
-  size_t& MaxIterations() { return maxIterations; }
+  size_t& MaxIterations() { return optimizer.MaxIterations(); }
 
   //! Get the tolerance for termination.
-  double Tolerance() const { return tolerance; }
+  double Tolerance() const { return optimizer.Tolerance(); }
   //! Modify the tolerance for termination.
-  double& Tolerance() { return tolerance; }
+  double& Tolerance() { return optimizer.Tolerance(); }
 
   //! Get whether or not the individual functions are shuffled.
-  bool Shuffle() const { return shuffle; }
+  bool Shuffle() const { return optimizer.Shuffle(); }
   //! Modify whether or not the individual functions are shuffled.
-  bool& Shuffle() { return shuffle; }
+  bool& Shuffle() { return optimizer.Shuffle(); }
 
   //! Get whether or not the actual objective is calculated.
-  bool ExactObjective() const { return exactObjective; }
+  bool ExactObjective() const { return optimizer.ExactObjective(); }
   //! Modify whether or not the actual objective is calculated.
-  bool& ExactObjective() { return exactObjective; }
+  bool& ExactObjective() { return optimizer.ExactObjective(); }
+
+  //! Get whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool ResetPolicy() const { return optimizer.ResetPolicy(); }
+  //! Modify whether or not the update policy parameters
+  //! are reset before Optimize call.
+  bool& ResetPolicy() { return optimizer.ResetPolicy(); }
+
+  //! Get whether or not each minibatch is split across multiple threads.
+  bool ParallelBatch() const { return optimizer.ParallelBatch(); }
+  //! Modify whether or not each minibatch is split across multiple threads.
+  bool& ParallelBatch() { return optimizer.ParallelBatch(); }
+
+  //! Get whether or not parallel minibatch reductions are deterministic.
+  bool DeterministicReduction() const
+  { return optimizer.DeterministicReduction(); }
+  //! Modify whether or not parallel minibatch reductions are deterministic.
+  bool& DeterministicReduction() { return optimizer.DeterministicReduction(); }
 
  private:
-  //! The step size for each example.
-  double stepSize;
-
-  //! The batch size for processing.
-  size_t batchSize;
-
-  //! The smoothing parameter.
-  double beta1;
-
-  //! The second moment coefficient.
-  double beta2;
-
-  //! The third moment coefficient.
-  double beta3;
-
-  //! The epsilon value used to initialise the squared gradient parameter.
-  double epsilon;
-
-  //! The clip value used to clip the term to avoid extreme values.
-  double clip;
-
-  //! The maximum number of allowed iterations.
-  size_t maxIterations;
-
-  //! The tolerance for termination.
-  double tolerance;
-
-  //! Controls whether or not the individual functions are shuffled when
-  //! iterating.
-  bool shuffle;
-
-  //! Controls whether or not the actual Objective value is calculated.
-  bool exactObjective;
+  //! The Stochastic Gradient Descent object with the Eve policy.
+  SGD<EveUpdate> optimizer;
 };
 
 } // namespace ens
@@ -0,0 +1,321 @@
+/**
+ * @file eve_update.hpp
+ *
+ * Eve update policy for SGD: Adam whose step size is scaled by the relative
+ * change of the objective.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_EVE_EVE_UPDATE_HPP
+#define ENSMALLEN_EVE_EVE_UPDATE_HPP
+
+#include <ensmallen_bits/utility/fused_update.hpp>
+
+namespace ens {
+
+/**
+ * The Eve update policy.  This is the Adam update, with the step size divided
+ * by a moving average of the clipped relative change of the objective between
+ * consecutive batches; the objective is given to the policy through
+ * ObjectiveFeedback() (see NotifyObjective()).  If no objective is given, the
+ * step size is not scaled, and the update is that of Adam.
+ *
+ * For dense matrices, the moments, the bias correction and the step are fused
+ * into one pass over the elements, as in AdamUpdate.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Koushik2016,
+ *   author  = {Jayanth Koushik and Hiroaki Hayashi},
+ *   title   = {Improving Stochastic Gradient Descent with Feedback},
+ *   journal = {CoRR},
+ *   year    = {2016},
+ *   url     = {http://arxiv.org/abs/1611.01505}
+ * }
+ * @endcode
+ */
+class EveUpdate
+{
+ public:
+  /**
+   * Construct the Eve update policy with the given parameters.
+   *
+   * @param beta1 Exponential decay rate for the first moment estimates.
+   * @param beta2 Exponential decay rate for the second moment estimates.
+   * @param beta3 Exponential decay rate for relative change.
+   * @param epsilon Value used to initialise the mean squared gradient
+   *     parameter.
+   * @param clip Clipping range to avoid extreme values.
+   */
+  EveUpdate(const double beta1 = 0.9,
+            const double beta2 = 0.999,
+            const double beta3 = 0.999,
+            const double epsilon = 1e-8,
+            const double clip = 10) :
+      beta1(beta1),
+      beta2(beta2),
+      beta3(beta3),
+      epsilon(epsilon),
+      clip(clip)
+  { /* Nothing to do. */ }
+
+  //! Get the smoothing parameter.
+  double Beta1() const { return beta1; }
+  //! Modify the smoothing parameter.
+  double& Beta1() { return beta1; }
+
+  //! Get the second moment coefficient.
+  double Beta2() const { return beta2; }
+  //! Modify the second moment coefficient.
+  double& Beta2() { return beta2; }
+
+  //! Get the exponential decay rate for relative change.
+  double Beta3() const { return beta3; }
+  //! Modify the exponential decay rate for relative change.
+  double& Beta3() { return beta3; }
+
+  //! Get the value used to initialise the mean squared gradient parameter.
+  double Epsilon() const { return epsilon; }
+  //! Modify the value used to initialise the mean squared gradient parameter.
+  double& Epsilon() { return epsilon; }
+
+  //! Get the clipping range to avoid extreme values.
+  double Clip() const { return clip; }
+  //! Modify the clipping range to avoid extreme values.
+  double& Clip() { return clip; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 2 * MatrixBytes<GradType>(rows, cols); }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.
+     *
+     * @param parent EveUpdate object.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const EveUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        iteration(0),
+        dt(1),
+        objective(0),
+        lastObjective(0),
+        hasObjective(false),
+        hasLastObjective(false)
+    {
+      m.zeros(rows, cols);
+      v.zeros(rows, cols);
+    }
+
+    /**
+     * Keep the objective of the current batch, for the next Update().
+     *
+     * @param batchObjective The objective of the current batch.
+     */
+    void ObjectiveFeedback(const double batchObjective)
+    {
+      objective = batchObjective;
+      hasObjective = true;
+    }
+
+    /**
+     * Update step for Eve.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for Eve, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
+    {
+      // Increment the iteration counter variable.
+      ++iteration;
+
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          (double) iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
+          (double) iteration);
+
+      // Track the relative change of the objective.
+      if (hasObjective)
+      {
+        if (hasLastObjective)
+        {
+          const double d = std::abs(objective - lastObjective) /
+              (std::min(objective, lastObjective) + parent.epsilon);
+
+          dt = parent.beta3 * dt + (1 - parent.beta3) *
+              std::min(std::max(d, 1.0 / parent.clip), parent.clip);
+        }
+
+        lastObjective = objective;
+        hasLastObjective = true;
+        hasObjective = false;
+      }
+
+      Update(iterate, stepSize / (dt * biasCorrection1), biasCorrection2,
+          gradient, transform, UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the moving averages, the feedback and the iteration
+     * counter, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(m);
+      ar(v);
+      ar(iteration);
+      ar(dt);
+      ar(lastObjective);
+      ar(hasLastObjective);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double alpha,
+                const double biasCorrection2,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+      const ElemType c2 = ElemType(1.0 / biasCorrection2);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = transform(g[i]);
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          mp[i] = mi;
+          vp[i] = vi;
+          x[i] -= a * mi / (std::sqrt(vi * c2) + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double alpha,
+                const double biasCorrection2,
+                const GradType& gradient,
+                const IdentityTransform& /* transform */,
+                std::false_type /* fused */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      iterate -= alpha * m / (arma::sqrt(v / biasCorrection2) +
+          parent.epsilon);
+    }
+
+    //! Instantiated parent object.
+    const EveUpdate& parent;
+
+    //! The exponential moving average of gradient values.
+    GradType m;
+
+    //! The exponential moving average of squared gradient values.
+    GradType v;
+
+    //! The number of steps taken.
+    size_t iteration;
+
+    //! The moving average of the clipped relative change of the objective.
+    double dt;
+
+    //! The objective of the current batch.
+    double objective;
+
+    //! The objective of the previous batch.
+    double lastObjective;
+
+    //! Whether or not the objective of the current batch was given.
+    bool hasObjective;
+
+    //! Whether or not the objective of a previous batch is known.
+    bool hasLastObjective;
+  };
+
+ private:
+  //! The smoothing parameter.
+  double beta1;
+
+  //! The second moment coefficient.
+  double beta2;
+
+  //! The third moment coefficient.
+  double beta3;
+
+  //! The epsilon value used to initialise the squared gradient parameter.
+  double epsilon;
+
+  //! The clip value used to clip the term to avoid extreme values.
+  double clip;
+};
+
+} // namespace ens
+
+#endif
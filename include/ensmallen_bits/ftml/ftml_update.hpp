@@ -12,6 +12,9 @@
 #ifndef ENSMALLEN_FTML_FTML_UPDATE_HPP
 #define ENSMALLEN_FTML_FTML_UPDATE_HPP
 
+#include <ensmallen_bits/utility/compact_state.hpp>
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -19,6 +22,13 @@ namespace ens {
  * weighted more heavily in each iteration, so FTML can adapt more quickly to
  * changes.
  *
+ * For dense matrices, the update is fused into one pass over the elements, and
+ * the parameter update term of the previous step is recomputed from the
+ * previous second moment estimates instead of being stored, so the state has
+ * two elements per coordinate instead of three.  These moments can also be
+ * stored in bfloat16 or in 8-bit blocks (see CompactState), to divide the
+ * memory of the state by 2 or 4.
+ *
  * For more information, see the following.
  *
  * @code
@@ -44,14 +54,19 @@ class FTMLUpdate
    * @param beta1 Exponential decay rate for the first moment estimates.
    * @param beta2 Exponential decay rate for the weighted infinity norm
    *        estimates.
+   * @param stateBits Number of bits per element of the moment estimates: 0
+   *        (full precision), 16 (bfloat16) or 8 (8-bit blocks); only dense
+   *        matrices support 16 and 8.
    */
   FTMLUpdate(const double epsilon = 1e-8,
              const double beta1 = 0.9,
-             const double beta2 = 0.999) :
+             const double beta2 = 0.999,
+             const size_t stateBits = 0) :
       epsilon(epsilon),
       beta1(beta1),
       beta2(beta2),
-      iteration(0)
+      iteration(0),
+      stateBits(stateBits)
   { /* Do nothing. */ }
 
   //! Get the value used to initialise the squared gradient parameter.
@@ -74,6 +89,20 @@ class FTMLUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Get the number of bits per element of the moment estimates.
+  size_t StateBits() const { return stateBits; }
+  //! Modify the number of bits per element of the moment estimates.
+  size_t& StateBits() { return stateBits; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: v, z and d.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return 2 * MatrixBytes<GradType>(rows, cols) +
+        MatrixBytes<MatType>(rows, cols);
+  }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -93,11 +122,11 @@ class FTMLUpdate
      * @param cols Number of columns in the gradient matrix.
      */
     Policy(FTMLUpdate& parent, const size_t rows, const size_t cols) :
-        parent(parent)
+        parent(parent),
+        lastScale(0),
+        lastC2(1)
     {
-      v.zeros(rows, cols);
-      z.zeros(rows, cols);
-      d.zeros(rows, cols);
+      Initialize(rows, cols, UseFusedUpdate<MatType, GradType>());
     }
 
     /**
@@ -114,15 +143,110 @@ class FTMLUpdate
       // Increment the iteration counter variable.
       ++parent.iteration;
 
-      // And update the iterate.
-      v *= parent.beta2;
-      v += (1 - parent.beta2) * (gradient % gradient);
-
       const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
           parent.iteration);
       const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
           parent.iteration);
 
+      Update(iterate, stepSize, biasCorrection1, biasCorrection2, gradient,
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! The type of the moment estimates: compact for dense matrices.
+    typedef typename std::conditional<UseFusedUpdate<MatType, GradType>::value,
+        CompactState<typename MatType::elem_type>, GradType>::type StateType;
+
+    //! Initialize the compact moment estimates.
+    void Initialize(const size_t rows, const size_t cols, std::true_type)
+    {
+      v = StateType(parent.stateBits);
+      z = StateType(parent.stateBits);
+      v.Zeros(rows * cols);
+      z.Zeros(rows * cols);
+    }
+
+    //! Initialize the moment estimates and the parameter update term.
+    void Initialize(const size_t rows, const size_t cols, std::false_type)
+    {
+      if (parent.stateBits != 0)
+      {
+        throw std::invalid_argument("FTMLUpdate: the moment estimates can "
+            "only have fewer bits for dense matrices.");
+      }
+
+      v.zeros(rows, cols);
+      z.zeros(rows, cols);
+      d.zeros(rows, cols);
+    }
+
+    //! Fused update for dense matrices: one pass over the elements, one block
+    //! of the moment estimates at a time.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const double biasCorrection1,
+                const double biasCorrection2,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType scale = ElemType(biasCorrection1 / stepSize);
+      const ElemType c2 = ElemType(1.0 / biasCorrection2);
+      const ElemType prevScale = ElemType(lastScale);
+      const ElemType prevC2 = ElemType(lastC2);
+
+      ElemType vScratch[StateType::BlockSize];
+      ElemType zScratch[StateType::BlockSize];
+      for (size_t b = 0; b < v.NumBlocks(); ++b)
+      {
+        const size_t begin = b * StateType::BlockSize;
+        const size_t length = v.BlockLength(b);
+        ElemType* x = iterate.memptr() + begin;
+        const ElemType* g = gradient.memptr() + begin;
+        ElemType* vp = v.Block(b, vScratch);
+        ElemType* zp = z.Block(b, zScratch);
+
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = 0; i < length; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType lastD = prevScale * (std::sqrt(vp[i] * prevC2) + eps);
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          const ElemType di = scale * (std::sqrt(vi * c2) + eps);
+          const ElemType sigma = di - beta1 * lastD;
+          const ElemType zi = beta1 * zp[i] + oneMinusBeta1 * gi -
+              sigma * x[i];
+          vp[i] = vi;
+          zp[i] = zi;
+          x[i] = -zi / di;
+        }
+
+        v.Store(b, vp);
+        z.Store(b, zp);
+      }
+
+      lastScale = biasCorrection1 / stepSize;
+      lastC2 = 1.0 / biasCorrection2;
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const double biasCorrection1,
+                const double biasCorrection2,
+                const GradType& gradient,
+                std::false_type /* fused */)
+    {
+      // And update the iterate.
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
       MatType sigma = -parent.beta1 * d;
       d = biasCorrection1 / stepSize *
         (arma::sqrt(v / biasCorrection2) + parent.epsilon);
@@ -133,18 +257,23 @@ class FTMLUpdate
       iterate = -z / d;
     }
 
-   private:
     // Reference to instantiated parent object.
     FTMLUpdate& parent;
 
-    // The exponential moving average of gradient values.
-    GradType v;
-
     // The exponential moving average of squared gradient values.
-    GradType z;
+    StateType v;
+
+    // The exponential moving average of the gradient and update terms.
+    StateType z;
 
-    // Parameter update term.
+    // Parameter update term (only stored for the generic update).
     MatType d;
+
+    // The scale of the parameter update term of the previous step.
+    double lastScale;
+
+    // The inverse of the second bias correction of the previous step.
+    double lastC2;
   };
 
  private:
@@ -159,6 +288,9 @@ class FTMLUpdate
 
   // The number of iterations.
   size_t iteration;
+
+  // The number of bits per element of the moment estimates.
+  size_t stateBits;
 };
 
 } // namespace ens
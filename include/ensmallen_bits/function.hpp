@@ -110,4 +110,9 @@ class Function :
 
 } // namespace ens
 
+// The wrappers in function/ (CachedFunction, MemoizedFunction,
+// ParallelSeparableFunction, MixedPrecisionFunction and
+// NumericalGradientFunction) are not used by any optimizer, so they are
+// included by ensmallen.hpp and <ensmallen/functions.hpp> rather than here.
+
 #endif
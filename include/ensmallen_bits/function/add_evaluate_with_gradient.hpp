@@ -80,6 +80,20 @@ class AddEvaluateWithGradient<FunctionType,
 /**
  * If the FunctionType has Evaluate() and Gradient(), provide
  * EvaluateWithGradient().
+ *
+ * If the FunctionType also declares a Workspace type, and has the overloads
+ *
+ * @code
+ * eT Evaluate(const MatType& coordinates, Workspace& workspace);
+ * void Gradient(const MatType& coordinates,
+ *               GradType& gradient,
+ *               Workspace& workspace);
+ * @endcode
+ *
+ * then EvaluateWithGradient() calls these with a new workspace: Evaluate()
+ * stores the intermediate results that the gradient needs (e.g. the
+ * predictions of a model) in the workspace, and Gradient() uses them at the
+ * same coordinates instead of computing them again.
  */
 template<typename FunctionType, typename MatType, typename GradType>
 class AddEvaluateWithGradient<FunctionType, MatType, GradType, true, false>
@@ -94,6 +108,34 @@ class AddEvaluateWithGradient<FunctionType, MatType, GradType, true, false>
    */
   typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
                                                    GradType& gradient)
+  {
+    return WorkspaceEvaluateWithGradient(coordinates, gradient,
+        std::integral_constant<bool, traits::HasWorkspaceSignature<
+        FunctionType, MatType, GradType>::value>());
+  }
+
+ private:
+  //! Evaluate() fills a workspace, which Gradient() then uses.
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::true_type /* workspace */)
+  {
+    FunctionType& f = *static_cast<FunctionType*>(
+        static_cast<Function<FunctionType, MatType, GradType>*>(this));
+
+    typename FunctionType::Workspace workspace;
+    const typename MatType::elem_type objective = f.Evaluate(coordinates,
+        workspace);
+    f.Gradient(coordinates, gradient, workspace);
+    return objective;
+  }
+
+  //! Call Evaluate() and then Gradient().
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::false_type /* workspace */)
   {
     const typename MatType::elem_type objective =
         static_cast<Function<FunctionType,
@@ -165,7 +207,9 @@ class AddEvaluateWithGradientConst<FunctionType,
 
 /**
  * If the FunctionType has Evaluate() const and Gradient() const, provide
- * EvaluateWithGradient() const.
+ * EvaluateWithGradient() const.  As for AddEvaluateWithGradient, a Workspace
+ * type is used if the FunctionType declares it and has the overloads of
+ * Evaluate() const and Gradient() const that take it.
  */
 template<typename FunctionType, typename MatType, typename GradType>
 class AddEvaluateWithGradientConst<FunctionType, MatType, GradType, true, false>
@@ -180,6 +224,34 @@ class AddEvaluateWithGradientConst<FunctionType, MatType, GradType, true, false>
    */
   typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
                                                    GradType& gradient) const
+  {
+    return WorkspaceEvaluateWithGradient(coordinates, gradient,
+        std::integral_constant<bool, traits::HasWorkspaceSignature<
+        FunctionType, MatType, GradType>::constValue>());
+  }
+
+ private:
+  //! Evaluate() fills a workspace, which Gradient() then uses.
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::true_type /* workspace */) const
+  {
+    const FunctionType& f = *static_cast<const FunctionType*>(
+        static_cast<const Function<FunctionType, MatType, GradType>*>(this));
+
+    typename FunctionType::Workspace workspace;
+    const typename MatType::elem_type objective = f.Evaluate(coordinates,
+        workspace);
+    f.Gradient(coordinates, gradient, workspace);
+    return objective;
+  }
+
+  //! Call Evaluate() and then Gradient().
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::false_type /* workspace */) const
   {
     const typename MatType::elem_type objective =
         static_cast<const Function<FunctionType,
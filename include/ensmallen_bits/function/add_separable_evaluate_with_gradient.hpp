@@ -86,6 +86,24 @@ class AddSeparableEvaluateWithGradient<FunctionType, MatType, GradType,
  * If we have a both separable Evaluate() and a separable Gradient() but
  * not a separable EvaluateWithGradient(), add a separable
  * EvaluateWithGradient() method.
+ *
+ * If the FunctionType also declares a Workspace type, and has the overloads
+ *
+ * @code
+ * eT Evaluate(const MatType& coordinates,
+ *             const size_t begin,
+ *             const size_t batchSize,
+ *             Workspace& workspace);
+ * void Gradient(const MatType& coordinates,
+ *               const size_t begin,
+ *               GradType& gradient,
+ *               const size_t batchSize,
+ *               Workspace& workspace);
+ * @endcode
+ *
+ * then EvaluateWithGradient() calls these with a new workspace, which
+ * Evaluate() fills with the intermediate results of the batch, and which
+ * Gradient() then uses for the same coordinates and batch.
  */
 template<typename FunctionType, typename MatType, typename GradType>
 class AddSeparableEvaluateWithGradient<FunctionType, MatType, GradType, true,
@@ -106,6 +124,39 @@ class AddSeparableEvaluateWithGradient<FunctionType, MatType, GradType, true,
                                                    const size_t begin,
                                                    GradType& gradient,
                                                    const size_t batchSize)
+  {
+    return WorkspaceEvaluateWithGradient(coordinates, begin, gradient,
+        batchSize, std::integral_constant<bool,
+        traits::HasSeparableWorkspaceSignature<FunctionType, MatType,
+        GradType>::value>());
+  }
+
+ private:
+  //! Evaluate() fills a workspace, which Gradient() then uses.
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize,
+      std::true_type /* workspace */)
+  {
+    FunctionType& f = *static_cast<FunctionType*>(
+        static_cast<Function<FunctionType, MatType, GradType>*>(this));
+
+    typename FunctionType::Workspace workspace;
+    const typename MatType::elem_type objective = f.Evaluate(coordinates,
+        begin, batchSize, workspace);
+    f.Gradient(coordinates, begin, gradient, batchSize, workspace);
+    return objective;
+  }
+
+  //! Call Evaluate() and then Gradient().
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize,
+      std::false_type /* workspace */)
   {
     const typename MatType::elem_type objective =
         static_cast<Function<FunctionType, MatType, GradType>*>(this)->Evaluate(
@@ -181,7 +232,10 @@ class AddSeparableEvaluateWithGradientConst<FunctionType, MatType, GradType,
 /**
  * If we have both a separable const Evaluate() and a separable const
  * Gradient() but not a separable const EvaluateWithGradient(), add a
- * separable const EvaluateWithGradient() method.
+ * separable const EvaluateWithGradient() method.  As for
+ * AddSeparableEvaluateWithGradient, a Workspace type is used if the
+ * FunctionType declares it and has the overloads of the separable
+ * Evaluate() const and Gradient() const that take it.
  */
 template<typename FunctionType, typename MatType, typename GradType>
 class AddSeparableEvaluateWithGradientConst<FunctionType, MatType, GradType,
@@ -202,6 +256,39 @@ class AddSeparableEvaluateWithGradientConst<FunctionType, MatType, GradType,
                                                    const size_t begin,
                                                    GradType& gradient,
                                                    const size_t batchSize) const
+  {
+    return WorkspaceEvaluateWithGradient(coordinates, begin, gradient,
+        batchSize, std::integral_constant<bool,
+        traits::HasSeparableWorkspaceSignature<FunctionType, MatType,
+        GradType>::constValue>());
+  }
+
+ private:
+  //! Evaluate() fills a workspace, which Gradient() then uses.
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize,
+      std::true_type /* workspace */) const
+  {
+    const FunctionType& f = *static_cast<const FunctionType*>(
+        static_cast<const Function<FunctionType, MatType, GradType>*>(this));
+
+    typename FunctionType::Workspace workspace;
+    const typename MatType::elem_type objective = f.Evaluate(coordinates,
+        begin, batchSize, workspace);
+    f.Gradient(coordinates, begin, gradient, batchSize, workspace);
+    return objective;
+  }
+
+  //! Call Evaluate() and then Gradient().
+  typename MatType::elem_type WorkspaceEvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize,
+      std::false_type /* workspace */) const
   {
     const typename MatType::elem_type objective =
         static_cast<const Function<FunctionType,
@@ -45,6 +45,64 @@ struct MatTypeTraits<arma::SpRow<eT>>
   typedef arma::SpMat<eT> BaseMatType;
 };
 
+#ifdef ENS_HAVE_COOT
+
+template<typename eT>
+struct MatTypeTraits<coot::Col<eT>>
+{
+  typedef coot::Mat<eT> BaseMatType;
+};
+
+template<typename eT>
+struct MatTypeTraits<coot::Row<eT>>
+{
+  typedef coot::Mat<eT> BaseMatType;
+};
+
+template<typename eT>
+struct MatTypeTraits<coot::subview<eT>>
+{
+  static_assert(sizeof(coot::subview<eT>) == 0,
+      "Bandicoot subviews cannot be passed to Optimize()!  Create a matrix "
+      "instead!");
+};
+
+#endif
+
+/**
+ * Get the dense matrix type with the given element type that lives where
+ * MatType lives: a Bandicoot matrix for Bandicoot types, so that state kept by
+ * an optimizer stays on the device, and an Armadillo matrix otherwise.
+ */
+template<typename MatType, typename ElemType>
+struct DenseMatType
+{
+  typedef arma::Mat<ElemType> type;
+};
+
+#ifdef ENS_HAVE_COOT
+
+template<typename eT, typename ElemType>
+struct DenseMatType<coot::Mat<eT>, ElemType>
+{
+  typedef coot::Mat<ElemType> type;
+};
+
+#endif
+
+/**
+ * The type used to accumulate sums of objective values of the given element
+ * type, e.g. over an epoch.  Sums of many float objectives lose precision
+ * quickly, so they are accumulated in double; other types are accumulated in
+ * their own precision.
+ */
+template<typename ElemType>
+struct AccumulatorType
+{
+  typedef typename std::conditional<std::is_floating_point<ElemType>::value &&
+      (sizeof(ElemType) < sizeof(double)), double, ElemType>::type type;
+};
+
 /**
  * Disable usage of arma::subviews and related types for optimizers.  It might
  * be nice to also explicitly disable Armadillo expressions, but we'll hope for
@@ -152,6 +210,17 @@ template<>
 inline void RequireFloatingPointType<arma::sp_mat>() { }
 template<>
 inline void RequireFloatingPointType<arma::sp_fmat>() { }
+template<>
+inline void RequireFloatingPointType<RowSparseMat<double> >() { }
+template<>
+inline void RequireFloatingPointType<RowSparseMat<float> >() { }
+
+#ifdef ENS_HAVE_COOT
+template<>
+inline void RequireFloatingPointType<coot::mat>() { }
+template<>
+inline void RequireFloatingPointType<coot::fmat>() { }
+#endif
 
 /**
  * Require that the internal element type of the matrix type and gradient type
@@ -0,0 +1,342 @@
+/**
+ * @file cached_function.hpp
+ *
+ * A thread-safe cache of the objectives of the points a function was
+ * evaluated at, and a wrapper that answers repeated evaluations from it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_CACHED_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_CACHED_FUNCTION_HPP
+
+#include <list>
+#include <unordered_map>
+
+namespace ens {
+
+/**
+ * EvaluationCache stores the objectives of up to Capacity() points, and
+ * forgets the least recently used point when a new one is inserted into a
+ * full cache.  Points are found by a hash of their shape and elements, and
+ * then compared element by element, so a hash collision never returns the
+ * objective of another point.  All methods can be called concurrently.
+ *
+ * @tparam MatType Type of the points.
+ */
+template<typename MatType = arma::mat>
+class EvaluationCache
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Create an empty cache.
+   *
+   * @param capacity The maximum number of points to store (0 means no limit).
+   */
+  EvaluationCache(const size_t capacity = 100000) :
+      capacity(capacity),
+      hits(0),
+      misses(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Look for the given point; if it is stored, its objective is stored in
+   * `value`, and it becomes the most recently used point.
+   *
+   * @param point The point to look for.
+   * @param value Set to the stored objective of the point, if any.
+   * @return Whether or not the point was found.
+   */
+  bool Lookup(const MatType& point, ElemType& value)
+  {
+    const size_t hash = Hash(point);
+    std::lock_guard<std::mutex> lock(mutex);
+    const typename IndexType::iterator it = Find(hash, point);
+    if (it == index.end())
+    {
+      ++misses;
+      return false;
+    }
+
+    entries.splice(entries.begin(), entries, it->second);
+    value = it->second->value;
+    ++hits;
+    return true;
+  }
+
+  /**
+   * Store the objective of the given point, as the most recently used point.
+   * If the cache is then over capacity, the least recently used points are
+   * forgotten.
+   *
+   * @param point The point.
+   * @param value The objective of the point.
+   */
+  void Insert(const MatType& point, const ElemType value)
+  {
+    const size_t hash = Hash(point);
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Another thread may have inserted the same point meanwhile.
+    const typename IndexType::iterator it = Find(hash, point);
+    if (it != index.end())
+    {
+      it->second->value = value;
+      entries.splice(entries.begin(), entries, it->second);
+      return;
+    }
+
+    entries.push_front(Entry(hash, point, value));
+    index.insert(std::make_pair(hash, entries.begin()));
+
+    while (capacity > 0 && entries.size() > capacity)
+    {
+      const typename ListType::iterator last = std::prev(entries.end());
+      std::pair<typename IndexType::iterator, typename IndexType::iterator>
+          range = index.equal_range(last->hash);
+      for (typename IndexType::iterator i = range.first; i != range.second;
+          ++i)
+      {
+        if (i->second == last)
+        {
+          index.erase(i);
+          break;
+        }
+      }
+      entries.pop_back();
+    }
+  }
+
+  //! Forget all the stored points; the counts of hits and misses are kept.
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    entries.clear();
+  }
+
+  //! Get the number of stored points.
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+  //! Get the number of lookups that found their point.
+  size_t Hits() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+  }
+
+  //! Get the number of lookups that did not find their point.
+  size_t Misses() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+  }
+
+  //! Get the maximum number of stored points (0 means no limit).
+  size_t Capacity() const { return capacity; }
+  //! Modify the maximum number of stored points (0 means no limit); the cache
+  //! is shrunk by the next Insert().  This must not be called concurrently
+  //! with the other methods.
+  size_t& Capacity() { return capacity; }
+
+  /**
+   * Return the hash of the shape and the elements of the given point, with
+   * the FNV-1a hash of their bytes; -0 and 0 have the same hash, since they
+   * compare equal.
+   *
+   * @param point The point to hash.
+   */
+  static size_t Hash(const MatType& point)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    HashBytes(hash, (uint64_t) point.n_rows);
+    HashBytes(hash, (uint64_t) point.n_cols);
+    for (size_t i = 0; i < point.n_elem; ++i)
+    {
+      const ElemType value = (point[i] == ElemType(0)) ? ElemType(0) :
+          ElemType(point[i]);
+      HashBytes(hash, value);
+    }
+
+    return (size_t) hash;
+  }
+
+ private:
+  //! A stored point.
+  struct Entry
+  {
+    Entry(const size_t hash, const MatType& point, const ElemType value) :
+        hash(hash), point(point), value(value) { }
+
+    //! The hash of the point.
+    size_t hash;
+    //! The point.
+    MatType point;
+    //! The objective of the point.
+    ElemType value;
+  };
+
+  //! The stored points, the most recently used first.
+  typedef std::list<Entry> ListType;
+  //! The stored points by hash.
+  typedef std::unordered_multimap<size_t, typename ListType::iterator>
+      IndexType;
+
+  //! Return the index entry of the given point, or index.end().
+  typename IndexType::iterator Find(const size_t hash, const MatType& point)
+  {
+    std::pair<typename IndexType::iterator, typename IndexType::iterator>
+        range = index.equal_range(hash);
+    for (typename IndexType::iterator i = range.first; i != range.second; ++i)
+    {
+      const MatType& stored = i->second->point;
+      if (stored.n_rows == point.n_rows && stored.n_cols == point.n_cols &&
+          std::equal(point.begin(), point.end(), stored.begin()))
+        return i;
+    }
+
+    return index.end();
+  }
+
+  //! Add the bytes of the given value to the hash.
+  template<typename T>
+  static void HashBytes(uint64_t& hash, const T& value)
+  {
+    const unsigned char* bytes = (const unsigned char*) &value;
+    for (size_t i = 0; i < sizeof(T); ++i)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  //! The maximum number of stored points.
+  size_t capacity;
+  //! The stored points.
+  ListType entries;
+  //! The stored points by hash.
+  IndexType index;
+  //! The number of lookups that found their point.
+  size_t hits;
+  //! The number of lookups that did not find their point.
+  size_t misses;
+  //! Lock for all the members above but the capacity.
+  mutable std::mutex mutex;
+};
+
+/**
+ * CachedFunction wraps a function whose evaluations are expensive (e.g. a
+ * simulation) and keeps their results in an EvaluationCache, so that a point
+ * that was already evaluated costs a hash lookup instead of a call to the
+ * wrapped function.  This helps optimizers that revisit identical points,
+ * such as GridSearch over categorical combinations, or SA and DE on
+ * integer-coded or bounded problems.  Only Evaluate() is provided, so the
+ * wrapper is meant for optimizers of arbitrary functions; the wrapped function
+ * may implement any of the methods of differentiable functions instead, which
+ * are used as for Function<>.
+ *
+ * The cache may be owned by the wrapper, or shared with other wrappers of the
+ * same function (e.g. by a GridSearch and then an SA run), provided that the
+ * function doesn't change meanwhile:
+ *
+ * @code
+ * MySimulation f;
+ * EvaluationCache<> cache(10000);
+ * CachedFunction<MySimulation> cached(f, cache);
+ *
+ * SA<> sa;
+ * sa.Optimize(cached, coordinates);
+ * @endcode
+ *
+ * The cache is thread-safe, so the wrapper can be used by optimizers that
+ * evaluate points in parallel, if the wrapped function can.  The wrapped
+ * function is called without holding the lock, so two threads that miss the
+ * same point at the same time may both evaluate it.
+ *
+ * @tparam FunctionType Type of the wrapped function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient (only used by Function<>).
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class CachedFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function, with a cache of its own.  The function is held
+   * by reference, so it must outlive this object.
+   *
+   * @param function Function to wrap.
+   * @param capacity The maximum number of points to store (0 means no limit).
+   */
+  CachedFunction(FunctionType& function, const size_t capacity = 100000) :
+      function(static_cast<Function<FunctionType, MatType, GradType>&>(
+          function)),
+      ownCache(capacity),
+      cache(&ownCache)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Wrap the given function, with the given (possibly shared) cache.  The
+   * function and the cache are held by reference, so they must outlive this
+   * object.
+   *
+   * @param function Function to wrap.
+   * @param cache The cache to use.
+   */
+  CachedFunction(FunctionType& function, EvaluationCache<MatType>& cache) :
+      function(static_cast<Function<FunctionType, MatType, GradType>&>(
+          function)),
+      ownCache(0),
+      cache(&cache)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Return the objective at the given coordinates, from the cache if they
+   * were evaluated before.
+   *
+   * @param coordinates Point to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    ElemType objective;
+    if (cache->Lookup(coordinates, objective))
+      return objective;
+
+    objective = function.Evaluate(coordinates);
+    cache->Insert(coordinates, objective);
+    return objective;
+  }
+
+  //! Get the cache.
+  const EvaluationCache<MatType>& Cache() const { return *cache; }
+  //! Modify the cache.
+  EvaluationCache<MatType>& Cache() { return *cache; }
+
+ private:
+  //! The wrapped function.
+  Function<FunctionType, MatType, GradType>& function;
+  //! The cache, if it is not shared.
+  EvaluationCache<MatType> ownCache;
+  //! The cache in use.
+  EvaluationCache<MatType>* cache;
+};
+
+} // namespace ens
+
+#endif
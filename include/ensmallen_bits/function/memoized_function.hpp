@@ -0,0 +1,209 @@
+/**
+ * @file memoized_function.hpp
+ *
+ * A wrapper for differentiable functions that remembers the objective and the
+ * gradient of the last point they were computed at.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_MEMOIZED_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_MEMOIZED_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * MemoizedFunction wraps a differentiable function and stores the objective
+ * and the gradient of the last point that Evaluate(), Gradient() or
+ * EvaluateWithGradient() was called with.  If the next call is for exactly the
+ * same point, the stored values are returned instead of calling the wrapped
+ * function again.  This is useful for expensive objectives when optimizers
+ * evaluate the objective and then the gradient (or both) at the same point.
+ *
+ * The wrapped function may implement any of the combinations of methods
+ * described for differentiable functions; missing methods are provided in the
+ * same way as for Function<>.  The point is compared element by element, and
+ * each comparison is much cheaper than an evaluation, but this is still a
+ * waste for cheap functions, so memoization is opt-in:
+ *
+ * @code
+ * MyExpensiveFunction f;
+ * MemoizedFunction<MyExpensiveFunction> memoized(f);
+ * L_BFGS lbfgs;
+ * lbfgs.Optimize(memoized, coordinates);
+ * @endcode
+ *
+ * If the wrapped function changes between calls (e.g. because its parameters
+ * are modified), Clear() must be called to forget the stored values.
+ *
+ * @tparam FunctionType Type of the wrapped function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class MemoizedFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive this object.
+   *
+   * @param function Function to wrap.
+   */
+  MemoizedFunction(FunctionType& function) :
+      function(static_cast<Function<FunctionType, MatType, GradType>&>(
+          function)),
+      hasObjective(false),
+      hasGradient(false),
+      objective(0),
+      hits(0)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Return the objective at the given coordinates.
+   *
+   * @param coordinates Point to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    if (IsLastPoint(coordinates))
+    {
+      if (hasObjective)
+      {
+        ++hits;
+        return objective;
+      }
+    }
+    else
+    {
+      SetLastPoint(coordinates);
+    }
+
+    objective = function.Evaluate(coordinates);
+    hasObjective = true;
+    return objective;
+  }
+
+  /**
+   * Store the gradient at the given coordinates in `gradient`.
+   *
+   * @param coordinates Point to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient into.
+   */
+  void Gradient(const MatType& coordinates, GradType& gradient)
+  {
+    if (IsLastPoint(coordinates))
+    {
+      if (hasGradient)
+      {
+        ++hits;
+        gradient = lastGradient;
+        return;
+      }
+    }
+    else
+    {
+      SetLastPoint(coordinates);
+    }
+
+    function.Gradient(coordinates, gradient);
+    lastGradient = gradient;
+    hasGradient = true;
+  }
+
+  /**
+   * Return the objective at the given coordinates, and store the gradient in
+   * `gradient`.  If only the objective is stored for these coordinates, only
+   * the gradient is computed.
+   *
+   * @param coordinates Point to evaluate the function at.
+   * @param gradient Matrix to store the gradient into.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates, GradType& gradient)
+  {
+    if (IsLastPoint(coordinates))
+    {
+      if (hasObjective && hasGradient)
+      {
+        ++hits;
+        gradient = lastGradient;
+        return objective;
+      }
+
+      if (hasObjective)
+      {
+        ++hits;
+        function.Gradient(coordinates, gradient);
+        lastGradient = gradient;
+        hasGradient = true;
+        return objective;
+      }
+    }
+    else
+    {
+      SetLastPoint(coordinates);
+    }
+
+    objective = function.EvaluateWithGradient(coordinates, gradient);
+    lastGradient = gradient;
+    hasObjective = true;
+    hasGradient = true;
+    return objective;
+  }
+
+  //! Forget the stored point, objective and gradient.
+  void Clear()
+  {
+    hasObjective = false;
+    hasGradient = false;
+    lastPoint.reset();
+  }
+
+  //! Get the number of calls that were answered (at least partly) from the
+  //! stored values.
+  size_t Hits() const { return hits; }
+
+ private:
+  //! Return whether the given coordinates are the stored point.
+  bool IsLastPoint(const MatType& coordinates) const
+  {
+    return (coordinates.n_rows == lastPoint.n_rows) &&
+        (coordinates.n_cols == lastPoint.n_cols) &&
+        std::equal(coordinates.begin(), coordinates.end(), lastPoint.begin());
+  }
+
+  //! Store the given coordinates and forget the values of the previous point.
+  void SetLastPoint(const MatType& coordinates)
+  {
+    lastPoint = coordinates;
+    hasObjective = false;
+    hasGradient = false;
+  }
+
+  //! The wrapped function.
+  Function<FunctionType, MatType, GradType>& function;
+  //! The last point.
+  MatType lastPoint;
+  //! The gradient at the last point.
+  GradType lastGradient;
+  //! Whether or not the objective at the last point is stored.
+  bool hasObjective;
+  //! Whether or not the gradient at the last point is stored.
+  bool hasGradient;
+  //! The objective at the last point.
+  ElemType objective;
+  //! The number of calls answered from the stored values.
+  size_t hits;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file mixed_precision_function.hpp
+ *
+ * A wrapper that evaluates a function in a lower precision than the precision
+ * of the coordinates kept by the optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_MIXED_PRECISION_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_MIXED_PRECISION_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * MixedPrecisionFunction lets an optimizer keep "master" coordinates (and its
+ * own state, such as the moments of Adam) in MatType, while the wrapped
+ * function is evaluated in the lower precision LowMatType.  Before each call,
+ * the coordinates are rounded to LowMatType; the objective and the gradient
+ * returned by the wrapped function are converted back to the precision of
+ * MatType.  Small updates are thus accumulated exactly in the master
+ * coordinates, while the function (and its data) only needs the bandwidth of
+ * the lower precision.
+ *
+ * @code
+ * arma::fmat data = ...;
+ * LogisticRegressionFunction<arma::fmat> lrf(data, responses);
+ * MixedPrecisionFunction<LogisticRegressionFunction<arma::fmat>> f(lrf);
+ *
+ * arma::mat coordinates(1, data.n_rows + 1, arma::fill::zeros);
+ * Adam adam;
+ * adam.Optimize(f, coordinates);
+ * @endcode
+ *
+ * The conversion buffers are reused between calls, so the wrapper must not be
+ * used from several threads at the same time.
+ *
+ * @tparam FunctionType Type of the wrapped function, which takes LowMatType.
+ * @tparam LowMatType Type of the coordinates the wrapped function takes.
+ * @tparam MatType Type of the master coordinates.
+ */
+template<typename FunctionType,
+         typename LowMatType = arma::fmat,
+         typename MatType = arma::mat>
+class MixedPrecisionFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive this object.
+   *
+   * @param function Function to wrap.
+   */
+  MixedPrecisionFunction(FunctionType& function) :
+      function(static_cast<Function<FunctionType, LowMatType, LowMatType>&>(
+          function))
+  {
+    // Nothing to do.
+  }
+
+  //! Return the number of separable functions of the wrapped function.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the wrapped function.
+  void Shuffle() { function.Shuffle(); }
+
+  //! Evaluate the wrapped function at the rounded coordinates.
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    Convert(coordinates, lowCoordinates);
+    return ElemType(function.Evaluate(lowCoordinates));
+  }
+
+  //! Evaluate the given batch of the wrapped function at the rounded
+  //! coordinates.
+  ElemType Evaluate(const MatType& coordinates,
+                    const size_t begin,
+                    const size_t batchSize)
+  {
+    Convert(coordinates, lowCoordinates);
+    return ElemType(function.Evaluate(lowCoordinates, begin, batchSize));
+  }
+
+  //! Compute the gradient of the wrapped function at the rounded coordinates.
+  void Gradient(const MatType& coordinates, MatType& gradient)
+  {
+    Convert(coordinates, lowCoordinates);
+    function.Gradient(lowCoordinates, lowGradient);
+    Convert(lowGradient, gradient);
+  }
+
+  //! Compute the gradient of the given batch of the wrapped function at the
+  //! rounded coordinates.
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                MatType& gradient,
+                const size_t batchSize)
+  {
+    Convert(coordinates, lowCoordinates);
+    function.Gradient(lowCoordinates, begin, lowGradient, batchSize);
+    Convert(lowGradient, gradient);
+  }
+
+  //! Evaluate the wrapped function and its gradient at the rounded
+  //! coordinates.
+  ElemType EvaluateWithGradient(const MatType& coordinates, MatType& gradient)
+  {
+    Convert(coordinates, lowCoordinates);
+    const ElemType objective = ElemType(function.EvaluateWithGradient(
+        lowCoordinates, lowGradient));
+    Convert(lowGradient, gradient);
+    return objective;
+  }
+
+  //! Evaluate the given batch of the wrapped function and its gradient at the
+  //! rounded coordinates.
+  ElemType EvaluateWithGradient(const MatType& coordinates,
+                                const size_t begin,
+                                MatType& gradient,
+                                const size_t batchSize)
+  {
+    Convert(coordinates, lowCoordinates);
+    const ElemType objective = ElemType(function.EvaluateWithGradient(
+        lowCoordinates, begin, lowGradient, batchSize));
+    Convert(lowGradient, gradient);
+    return objective;
+  }
+
+ private:
+  //! Convert the elements of a matrix to another element type, reusing the
+  //! memory of the output.
+  template<typename InType, typename OutType>
+  static void Convert(const InType& in, OutType& out)
+  {
+    typedef typename OutType::elem_type OutElemType;
+
+    out.set_size(in.n_rows, in.n_cols);
+    const typename InType::elem_type* inMem = in.memptr();
+    OutElemType* outMem = out.memptr();
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = 0; i < in.n_elem; ++i)
+      outMem[i] = OutElemType(inMem[i]);
+  }
+
+  //! The wrapped function.
+  Function<FunctionType, LowMatType, LowMatType>& function;
+  //! The rounded coordinates.
+  LowMatType lowCoordinates;
+  //! The gradient computed by the wrapped function.
+  LowMatType lowGradient;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * @file numerical_gradient_function.hpp
+ *
+ * A wrapper for arbitrary functions that provides the gradient by finite
+ * differences, computed in parallel.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_NUMERICAL_GRADIENT_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_NUMERICAL_GRADIENT_FUNCTION_HPP
+
+#include <ensmallen_bits/utility/executor.hpp>
+
+namespace ens {
+
+/**
+ * NumericalGradientFunction wraps a function that only has Evaluate(), and
+ * provides Gradient() and EvaluateWithGradient() by finite differences, so
+ * that the function can be optimized with the optimizers for differentiable
+ * functions (e.g. L_BFGS).  With central differences (the default), the i-th
+ * element of the gradient is
+ *
+ *   (f(x + h_i e_i) - f(x - h_i e_i)) / (2 h_i),
+ *
+ * which takes 2n evaluations for n coordinates and is accurate to O(h^2);
+ * forward differences (f(x + h_i e_i) - f(x)) / h_i take n evaluations (plus
+ * f(x), which EvaluateWithGradient() returns anyway) and are accurate to O(h).
+ * Unless a relative step is given, the step is h_i = s max(|x_i|, 1) with
+ * s = eps^(1/3) for central and s = eps^(1/2) for forward differences, where
+ * eps is the machine epsilon of the element type; these balance the truncation
+ * error and the rounding error of the evaluations.
+ *
+ * The perturbed evaluations are independent, so they are run in parallel with
+ * ParallelFor(): the coordinates are split into one range per thread, and each
+ * range perturbs its own copy of the point.  The Evaluate() method of the
+ * wrapped function must then be safe to call from several threads at once; if
+ * it isn't, `parallel` should be false.
+ *
+ * @code
+ * MyEvaluateOnlyFunction f;
+ * NumericalGradientFunction<MyEvaluateOnlyFunction> g(f);
+ * L_BFGS lbfgs;
+ * lbfgs.Optimize(g, coordinates);
+ * @endcode
+ *
+ * @tparam FunctionType Type of the wrapped function.
+ * @tparam MatType Type of the coordinates and of the gradient.
+ */
+template<typename FunctionType, typename MatType = arma::mat>
+class NumericalGradientFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given function.  The function is held by reference, so it must
+   * outlive this object.
+   *
+   * @param function Function to wrap.
+   * @param central Whether to use central (or else forward) differences.
+   * @param relativeStep Step relative to max(|x_i|, 1) (0 chooses it
+   *     automatically).
+   * @param parallel Whether to evaluate the perturbed points in parallel.
+   */
+  NumericalGradientFunction(FunctionType& function,
+                            const bool central = true,
+                            const double relativeStep = 0.0,
+                            const bool parallel = true) :
+      function(static_cast<Function<FunctionType, MatType, MatType>&>(
+          function)),
+      central(central),
+      relativeStep(relativeStep),
+      parallel(parallel)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Return the objective at the given coordinates.
+   *
+   * @param coordinates Point to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    return function.Evaluate(coordinates);
+  }
+
+  /**
+   * Store the finite-difference gradient at the given coordinates in
+   * `gradient`.
+   *
+   * @param coordinates Point to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient into.
+   */
+  void Gradient(const MatType& coordinates, MatType& gradient)
+  {
+    const ElemType objective = central ? ElemType(0) :
+        function.Evaluate(coordinates);
+    Differences(coordinates, objective, gradient);
+  }
+
+  /**
+   * Return the objective at the given coordinates, and store the
+   * finite-difference gradient in `gradient`.
+   *
+   * @param coordinates Point to evaluate the function at.
+   * @param gradient Matrix to store the gradient into.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates, MatType& gradient)
+  {
+    const ElemType objective = function.Evaluate(coordinates);
+    Differences(coordinates, objective, gradient);
+    return objective;
+  }
+
+  //! Get whether central (or else forward) differences are used.
+  bool Central() const { return central; }
+  //! Modify whether central (or else forward) differences are used.
+  bool& Central() { return central; }
+
+  //! Get the relative step (0 means it is chosen automatically).
+  double RelativeStep() const { return relativeStep; }
+  //! Modify the relative step (0 means it is chosen automatically).
+  double& RelativeStep() { return relativeStep; }
+
+  //! Get whether the perturbed points are evaluated in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the perturbed points are evaluated in parallel.
+  bool& Parallel() { return parallel; }
+
+ private:
+  /**
+   * Compute the finite differences at the given coordinates; `objective` is
+   * the objective at the coordinates, which is only used by forward
+   * differences.
+   */
+  void Differences(const MatType& coordinates,
+                   const ElemType objective,
+                   MatType& gradient)
+  {
+    const ElemType epsilon = std::numeric_limits<ElemType>::epsilon();
+    const ElemType step = (relativeStep > 0.0) ? ElemType(relativeStep) :
+        (central ? std::cbrt(epsilon) : std::sqrt(epsilon));
+
+    gradient.set_size(coordinates.n_rows, coordinates.n_cols);
+    const size_t n = coordinates.n_elem;
+    const size_t ranges = parallel ? std::max(std::min(MaxThreads(), n),
+        (size_t) 1) : 1;
+
+    ParallelFor(ranges, [&](const size_t r)
+    {
+      MatType point(coordinates);
+      const size_t end = (r + 1) * n / ranges;
+      for (size_t i = r * n / ranges; i < end; ++i)
+      {
+        const ElemType x = coordinates[i];
+        // Make the step exactly representable, so that the difference of the
+        // perturbed coordinates is the step that the objectives are divided
+        // by.
+        const ElemType temp = x + step * std::max(std::abs(x), ElemType(1));
+        const ElemType h = temp - x;
+
+        point[i] = x + h;
+        const ElemType plus = function.Evaluate(point);
+        if (central)
+        {
+          point[i] = x - h;
+          const ElemType minus = function.Evaluate(point);
+          gradient[i] = (plus - minus) / (2 * h);
+        }
+        else
+        {
+          gradient[i] = (plus - objective) / h;
+        }
+        point[i] = x;
+      }
+    }, parallel);
+  }
+
+  //! The wrapped function.
+  Function<FunctionType, MatType, MatType>& function;
+  //! Whether to use central (or else forward) differences.
+  bool central;
+  //! The relative step (0 means it is chosen automatically).
+  double relativeStep;
+  //! Whether to evaluate the perturbed points in parallel.
+  bool parallel;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file parallel_separable_function.hpp
+ *
+ * A wrapper that provides the full-batch Evaluate(), Gradient() and
+ * EvaluateWithGradient() of a separable function by summing over all of its
+ * points in parallel.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FUNCTION_PARALLEL_SEPARABLE_FUNCTION_HPP
+#define ENSMALLEN_FUNCTION_PARALLEL_SEPARABLE_FUNCTION_HPP
+
+namespace ens {
+
+/**
+ * ParallelSeparableFunction turns a separable function (one that implements
+ * NumFunctions() and the separable Evaluate() and/or Gradient() or
+ * EvaluateWithGradient() taking `begin` and `batchSize`) into a differentiable
+ * function for full-batch optimizers such as L_BFGS or GradientDescent.  Its
+ * Evaluate(), Gradient() and EvaluateWithGradient() split [0, NumFunctions())
+ * into contiguous ranges that are computed on separate OpenMP threads, and sum
+ * the results.  See ParallelEvaluateWithGradient() for the meaning of
+ * `deterministic` and `chunkSize`.
+ *
+ * @code
+ * LogisticRegressionFunction<> lrf(data, responses);
+ * ParallelSeparableFunction<LogisticRegressionFunction<>> f(lrf);
+ * L_BFGS lbfgs;
+ * lbfgs.Optimize(f, coordinates);
+ * @endcode
+ *
+ * Since the separable methods of the wrapped function are called concurrently,
+ * they must be safe to call in parallel on disjoint ranges of points.
+ *
+ * @tparam FunctionType Type of the wrapped separable function.
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename FunctionType,
+         typename MatType = arma::mat,
+         typename GradType = MatType>
+class ParallelSeparableFunction
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Wrap the given separable function.  The function is held by reference, so
+   * it must outlive this object.
+   *
+   * @param function Function to wrap.
+   * @param deterministic Whether or not the ranges should be independent of the
+   *     number of threads.
+   * @param chunkSize Number of points in each range in deterministic mode.
+   */
+  ParallelSeparableFunction(FunctionType& function,
+                            const bool deterministic = false,
+                            const size_t chunkSize = 32) :
+      function(static_cast<Function<FunctionType, MatType, GradType>&>(
+          function)),
+      deterministic(deterministic),
+      chunkSize(chunkSize)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Return the sum of the objectives of all points.
+   *
+   * @param coordinates Point to evaluate the function at.
+   */
+  ElemType Evaluate(const MatType& coordinates)
+  {
+    return ParallelEvaluate(function, coordinates, 0, function.NumFunctions(),
+        deterministic, chunkSize);
+  }
+
+  /**
+   * Store the sum of the gradients of all points in `gradient`.
+   *
+   * @param coordinates Point to evaluate the gradient at.
+   * @param gradient Matrix to store the gradient into.
+   */
+  void Gradient(const MatType& coordinates, GradType& gradient)
+  {
+    ParallelGradient(function, coordinates, 0, gradient,
+        function.NumFunctions(), buffers, deterministic, chunkSize);
+  }
+
+  /**
+   * Return the sum of the objectives of all points, and store the sum of their
+   * gradients in `gradient`.
+   *
+   * @param coordinates Point to evaluate the function at.
+   * @param gradient Matrix to store the gradient into.
+   */
+  ElemType EvaluateWithGradient(const MatType& coordinates, GradType& gradient)
+  {
+    return ParallelEvaluateWithGradient(function, coordinates, 0, gradient,
+        function.NumFunctions(), buffers, deterministic, chunkSize);
+  }
+
+  //! Return the number of points of the wrapped function.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Get whether or not the ranges are independent of the number of threads.
+  bool Deterministic() const { return deterministic; }
+  //! Modify whether or not the ranges are independent of the number of threads.
+  bool& Deterministic() { return deterministic; }
+
+  //! Get the number of points in each range in deterministic mode.
+  size_t ChunkSize() const { return chunkSize; }
+  //! Modify the number of points in each range in deterministic mode.
+  size_t& ChunkSize() { return chunkSize; }
+
+ private:
+  //! The wrapped function.
+  Function<FunctionType, MatType, GradType>& function;
+  //! Whether or not the ranges are independent of the number of threads.
+  bool deterministic;
+  //! The number of points in each range in deterministic mode.
+  size_t chunkSize;
+  //! The gradient of each range, kept between calls.
+  std::vector<GradType> buffers;
+};
+
+} // namespace ens
+
+#endif
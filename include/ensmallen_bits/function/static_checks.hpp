@@ -471,6 +471,32 @@ inline void CheckArbitrarySeparableFunctionTypeAPI()
 #endif
 }
 
+/**
+ * Perform checks for the StreamFunctionType API.  The gradient is checked on
+ * the Function<> wrapper, which provides EvaluateWithGradient() from
+ * Evaluate() and Gradient().
+ */
+template<typename StreamType, typename FunctionType, typename MatType,
+         typename GradType>
+inline void CheckStreamFunctionTypeAPI()
+{
+#ifndef ENS_DISABLE_TYPE_CHECKS
+  static_assert(HasAvailableSignature<StreamType>::value,
+      "The FunctionType does not have a correct definition of Available(). "
+      "Please check that the FunctionType fully satisfies the requirements of "
+      "the StreamFunctionType API; see the optimizer tutorial for more "
+      "details.");
+
+  static_assert(CheckSeparableEvaluateWithGradient<FunctionType,
+                                                   MatType,
+                                                   GradType>::value,
+      "The FunctionType does not have a correct definition of a separable "
+      "EvaluateWithGradient() method.  Please check that the FunctionType "
+      "fully satisfies the requirements of the StreamFunctionType API; see "
+      "the optimizer tutorial for more details.");
+#endif
+}
+
 } // namespace traits
 } // namespace ens
 
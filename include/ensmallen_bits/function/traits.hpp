@@ -35,6 +35,10 @@ ENS_HAS_EXACT_METHOD_FORM(NumConstraints, HasNumConstraints)
 ENS_HAS_EXACT_METHOD_FORM(EvaluateConstraint, HasEvaluateConstraint)
 //! Detect a GradientConstraint() method.
 ENS_HAS_EXACT_METHOD_FORM(GradientConstraint, HasGradientConstraint)
+//! Detect an EvaluateConstraints() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateConstraints, HasEvaluateConstraints)
+//! Detect a GradientConstraints() method.
+ENS_HAS_EXACT_METHOD_FORM(GradientConstraints, HasGradientConstraints)
 //! Detect a NumFeatures() method.
 ENS_HAS_EXACT_METHOD_FORM(NumFeatures, HasNumFeatures)
 //! Detect a PartialGradient() method.
@@ -47,6 +51,35 @@ ENS_HAS_EXACT_METHOD_FORM(ResetPolicy, HasResetPolicy)
 ENS_HAS_EXACT_METHOD_FORM(BatchSize, HasBatchSize)
 //! Detect an StepSize() method.
 ENS_HAS_EXACT_METHOD_FORM(StepSize, HasStepSize)
+//! Detect a PrepareBatch() method.
+ENS_HAS_EXACT_METHOD_FORM(PrepareBatch, HasPrepareBatch)
+//! Detect an Available() method.
+ENS_HAS_EXACT_METHOD_FORM(Available, HasAvailable)
+//! Detect an EvaluateBatch() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateBatch, HasEvaluateBatch)
+//! Detect a GradientMoments() method.
+ENS_HAS_EXACT_METHOD_FORM(GradientMoments, HasGradientMoments)
+//! Detect an EvaluateDelta() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateDelta, HasEvaluateDelta)
+//! Detect an EvaluateWithBudget() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateWithBudget, HasEvaluateWithBudget)
+//! Detect an EvaluateBounded() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateBounded, HasEvaluateBounded)
+//! Detect an EvaluateWithPredictionGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(EvaluateWithPredictionGradient,
+    HasEvaluateWithPredictionGradient)
+//! Detect an AddFeatureGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(AddFeatureGradient, HasAddFeatureGradient)
+//! Detect a RegularizationGradient() method.
+ENS_HAS_EXACT_METHOD_FORM(RegularizationGradient, HasRegularizationGradient)
+ENS_HAS_EXACT_METHOD_FORM(AffectedFeatures, HasAffectedFeatures)
+//! Detect a SparsityPattern() method.
+ENS_HAS_EXACT_METHOD_FORM(SparsityPattern, HasSparsityPattern)
+//! Detect a Stratify() method.
+ENS_HAS_EXACT_METHOD_FORM(Stratify, HasStratify)
+//! Detect a HessianVectorProduct() method.
+ENS_HAS_EXACT_METHOD_FORM(HessianVectorProduct, HasHessianVectorProduct)
+ENS_HAS_EXACT_METHOD_FORM(PartialGradientColumn, HasPartialGradientColumn)
 
 template<typename MatType, typename GradType>
 struct TypedForms
@@ -447,6 +480,480 @@ struct HasResetPolicySignature
       HasResetPolicy<OptimizerType, HasResetPolicyForm>::value;
 };
 
+//! Utility struct, check if void PrepareBatch(const size_t, const size_t)
+//! const or void PrepareBatch(const size_t, const size_t) exists.
+template<typename FunctionType>
+struct HasPrepareBatchSignature
+{
+  template<typename C>
+  using PrepareBatchConstForm = void(C::*)(const size_t, const size_t) const;
+
+  template<typename C>
+  using PrepareBatchForm = void(C::*)(const size_t, const size_t);
+
+  const static bool value =
+      HasPrepareBatch<FunctionType, PrepareBatchForm>::value ||
+      HasPrepareBatch<FunctionType, PrepareBatchConstForm>::value;
+};
+
+//! Utility struct, check if size_t Available(const size_t, const size_t)
+//! const or size_t Available(const size_t, const size_t) exists.
+template<typename FunctionType>
+struct HasAvailableSignature
+{
+  template<typename C>
+  using AvailableConstForm = size_t(C::*)(const size_t, const size_t) const;
+
+  template<typename C>
+  using AvailableForm = size_t(C::*)(const size_t, const size_t);
+
+  const static bool value =
+      HasAvailable<FunctionType, AvailableForm>::value ||
+      HasAvailable<FunctionType, AvailableConstForm>::value;
+};
+
+//! Utility struct, check if void EvaluateBatch(const arma::Cube<eT>&,
+//! arma::Col<eT>&) const or void EvaluateBatch(const arma::Cube<eT>&,
+//! arma::Col<eT>&) exists, where eT is the element type of MatType.
+template<typename FunctionType, typename MatType>
+struct HasEvaluateBatchSignature
+{
+  typedef typename MatType::elem_type ElemType;
+
+  template<typename C>
+  using EvaluateBatchConstForm = void(C::*)(const arma::Cube<ElemType>&,
+                                            arma::Col<ElemType>&) const;
+
+  template<typename C>
+  using EvaluateBatchForm = void(C::*)(const arma::Cube<ElemType>&,
+                                       arma::Col<ElemType>&);
+
+  const static bool value =
+      HasEvaluateBatch<FunctionType, EvaluateBatchForm>::value ||
+      HasEvaluateBatch<FunctionType, EvaluateBatchConstForm>::value;
+};
+
+//! Utility struct, check if eT GradientMoments(const MatType&, const size_t,
+//! GradType&, const size_t) const or eT GradientMoments(const MatType&,
+//! const size_t, GradType&, const size_t) exists, where eT is the element type
+//! of MatType.
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasGradientMomentsSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using GradientMomentsConstForm = ElemType(C::*)(const BaseMatType&,
+                                                  const size_t,
+                                                  BaseGradType&,
+                                                  const size_t) const;
+
+  template<typename C>
+  using GradientMomentsForm = ElemType(C::*)(const BaseMatType&,
+                                             const size_t,
+                                             BaseGradType&,
+                                             const size_t);
+
+  const static bool value =
+      HasGradientMoments<FunctionType, GradientMomentsForm>::value ||
+      HasGradientMoments<FunctionType, GradientMomentsConstForm>::value;
+};
+
+//! Utility struct, check if eT EvaluateDelta(const MatType&, const size_t,
+//! const eT) const or eT EvaluateDelta(const MatType&, const size_t, const eT)
+//! exists, where eT is the element type of MatType.
+template<typename FunctionType, typename MatType>
+struct HasEvaluateDeltaSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using EvaluateDeltaConstForm = ElemType(C::*)(const BaseMatType&,
+                                                const size_t,
+                                                const ElemType) const;
+
+  template<typename C>
+  using EvaluateDeltaForm = ElemType(C::*)(const BaseMatType&,
+                                           const size_t,
+                                           const ElemType);
+
+  const static bool value =
+      HasEvaluateDelta<FunctionType, EvaluateDeltaForm>::value ||
+      HasEvaluateDelta<FunctionType, EvaluateDeltaConstForm>::value;
+};
+
+//! Utility struct, check if eT EvaluateWithBudget(const MatType&, const size_t)
+//! const or eT EvaluateWithBudget(const MatType&, const size_t) exists, where
+//! eT is the element type of MatType.
+template<typename FunctionType, typename MatType>
+struct HasEvaluateWithBudgetSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using EvaluateWithBudgetConstForm = ElemType(C::*)(const BaseMatType&,
+                                                     const size_t) const;
+
+  template<typename C>
+  using EvaluateWithBudgetForm = ElemType(C::*)(const BaseMatType&,
+                                                const size_t);
+
+  const static bool value =
+      HasEvaluateWithBudget<FunctionType, EvaluateWithBudgetForm>::value ||
+      HasEvaluateWithBudget<FunctionType, EvaluateWithBudgetConstForm>::value;
+};
+
+//! Utility struct, check if eT EvaluateBounded(const MatType&, const eT) const
+//! or eT EvaluateBounded(const MatType&, const eT) exists, where eT is the
+//! element type of MatType.
+template<typename FunctionType, typename MatType>
+struct HasEvaluateBoundedSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using EvaluateBoundedConstForm = ElemType(C::*)(const BaseMatType&,
+                                                  const ElemType) const;
+
+  template<typename C>
+  using EvaluateBoundedForm = ElemType(C::*)(const BaseMatType&,
+                                             const ElemType);
+
+  const static bool value =
+      HasEvaluateBounded<FunctionType, EvaluateBoundedForm>::value ||
+      HasEvaluateBounded<FunctionType, EvaluateBoundedConstForm>::value;
+};
+
+//! Utility struct, check if void EvaluateConstraints(const MatType&,
+//! arma::Col<eT>&) const or void EvaluateConstraints(const MatType&,
+//! arma::Col<eT>&) exists, where eT is the element type of MatType.
+template<typename FunctionType, typename MatType>
+struct HasEvaluateConstraintsSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using EvaluateConstraintsConstForm = void(C::*)(const BaseMatType&,
+                                                  arma::Col<ElemType>&) const;
+
+  template<typename C>
+  using EvaluateConstraintsForm = void(C::*)(const BaseMatType&,
+                                             arma::Col<ElemType>&);
+
+  const static bool value =
+      HasEvaluateConstraints<FunctionType, EvaluateConstraintsForm>::value ||
+      HasEvaluateConstraints<FunctionType, EvaluateConstraintsConstForm>::value;
+};
+
+//! Utility struct, check if void GradientConstraints(const MatType&,
+//! const arma::Col<eT>&, GradType&) const or its non-const form exists, where
+//! eT is the element type of MatType.
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasGradientConstraintsSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using GradientConstraintsConstForm = void(C::*)(const BaseMatType&,
+      const arma::Col<ElemType>&, BaseGradType&) const;
+
+  template<typename C>
+  using GradientConstraintsForm = void(C::*)(const BaseMatType&,
+      const arma::Col<ElemType>&, BaseGradType&);
+
+  const static bool value =
+      HasGradientConstraints<FunctionType, GradientConstraintsForm>::value ||
+      HasGradientConstraints<FunctionType, GradientConstraintsConstForm>::value;
+};
+
+//! Utility struct, check if the function has the (const or non-const) methods
+//!
+//!   eT EvaluateWithPredictionGradient(const MatType&, const size_t,
+//!       arma::Row<eT>&, const size_t);
+//!   void AddFeatureGradient(const size_t, const arma::Row<eT>&, GradType&,
+//!       const size_t);
+//!   void RegularizationGradient(const MatType&, GradType&);
+//!
+//! of a separable linear model, where eT is the element type of MatType.
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasLinearGradientSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using EvaluateWithPredictionGradientConstForm = ElemType(C::*)(
+      const BaseMatType&, const size_t, arma::Row<ElemType>&,
+      const size_t) const;
+
+  template<typename C>
+  using EvaluateWithPredictionGradientForm = ElemType(C::*)(
+      const BaseMatType&, const size_t, arma::Row<ElemType>&, const size_t);
+
+  template<typename C>
+  using AddFeatureGradientConstForm = void(C::*)(const size_t,
+      const arma::Row<ElemType>&, BaseGradType&, const size_t) const;
+
+  template<typename C>
+  using AddFeatureGradientForm = void(C::*)(const size_t,
+      const arma::Row<ElemType>&, BaseGradType&, const size_t);
+
+  template<typename C>
+  using RegularizationGradientConstForm = void(C::*)(const BaseMatType&,
+      BaseGradType&) const;
+
+  template<typename C>
+  using RegularizationGradientForm = void(C::*)(const BaseMatType&,
+      BaseGradType&);
+
+  const static bool value =
+      (HasEvaluateWithPredictionGradient<FunctionType,
+          EvaluateWithPredictionGradientForm>::value ||
+       HasEvaluateWithPredictionGradient<FunctionType,
+          EvaluateWithPredictionGradientConstForm>::value) &&
+      (HasAddFeatureGradient<FunctionType, AddFeatureGradientForm>::value ||
+       HasAddFeatureGradient<FunctionType,
+          AddFeatureGradientConstForm>::value) &&
+      (HasRegularizationGradient<FunctionType,
+          RegularizationGradientForm>::value ||
+       HasRegularizationGradient<FunctionType,
+          RegularizationGradientConstForm>::value);
+};
+
+//! Utility struct, check if the function has the const method
+//!
+//!   void AffectedFeatures(const size_t, arma::uvec&) const;
+//!
+//! that returns the features whose partial gradients may change when the given
+//! feature of the iterate changes.
+template<typename FunctionType>
+struct HasAffectedFeaturesSignature
+{
+  template<typename C>
+  using AffectedFeaturesForm = void(C::*)(const size_t, arma::uvec&) const;
+
+  const static bool value =
+      HasAffectedFeatures<FunctionType, AffectedFeaturesForm>::value;
+};
+
+//! Utility struct, check if the function has the const method
+//!
+//!   void SparsityPattern(const size_t, const size_t, arma::uvec&) const;
+//!
+//! that returns the elements of the iterate that the given batch of functions
+//! depends on.
+template<typename FunctionType>
+struct HasSparsityPatternSignature
+{
+  template<typename C>
+  using SparsityPatternForm = void(C::*)(const size_t, const size_t,
+                                         arma::uvec&) const;
+
+  const static bool value =
+      HasSparsityPattern<FunctionType, SparsityPatternForm>::value;
+};
+
+//! Utility struct, check if the function has the method
+//!
+//!   void Stratify(const size_t, arma::uvec&);
+//!
+//! that orders the functions by the blocks of a grid of strata.
+template<typename FunctionType>
+struct HasStratifySignature
+{
+  template<typename C>
+  using StratifyForm = void(C::*)(const size_t, arma::uvec&);
+
+  const static bool value = HasStratify<FunctionType, StratifyForm>::value;
+};
+
+//! Utility struct, check if void HessianVectorProduct(const MatType&,
+//! const MatType&, MatType&) const or non-const exists, which stores the
+//! product of the Hessian at the first argument with the second argument in the
+//! third.
+template<typename FunctionType, typename MatType>
+struct HasHessianVectorProductSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  template<typename C>
+  using HessianVectorProductConstForm = void(C::*)(const BaseMatType&,
+                                                   const BaseMatType&,
+                                                   BaseMatType&) const;
+
+  template<typename C>
+  using HessianVectorProductForm = void(C::*)(const BaseMatType&,
+                                              const BaseMatType&,
+                                              BaseMatType&);
+
+  const static bool value =
+      HasHessianVectorProduct<FunctionType,
+          HessianVectorProductForm>::value ||
+      HasHessianVectorProduct<FunctionType,
+          HessianVectorProductConstForm>::value;
+};
+
+//! Utility struct, check if void HessianVectorProduct(const MatType&,
+//! const size_t, const MatType&, MatType&, const size_t) const or non-const
+//! exists, which stores the product of the Hessian of a batch of separable
+//! functions with a direction.
+template<typename FunctionType, typename MatType>
+struct HasSeparableHessianVectorProductSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  template<typename C>
+  using HessianVectorProductConstForm = void(C::*)(const BaseMatType&,
+                                                   const size_t,
+                                                   const BaseMatType&,
+                                                   BaseMatType&,
+                                                   const size_t) const;
+
+  template<typename C>
+  using HessianVectorProductForm = void(C::*)(const BaseMatType&,
+                                              const size_t,
+                                              const BaseMatType&,
+                                              BaseMatType&,
+                                              const size_t);
+
+  const static bool value =
+      HasHessianVectorProduct<FunctionType,
+          HessianVectorProductForm>::value ||
+      HasHessianVectorProduct<FunctionType,
+          HessianVectorProductConstForm>::value;
+};
+
+//! Utility struct, check if void PartialGradientColumn(const MatType&,
+//! const size_t, arma::Col<eT>&) const or non-const exists, where eT is the
+//! element type of MatType.
+template<typename FunctionType, typename MatType>
+struct HasPartialGradientColumnSignature
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename BaseMatType::elem_type ElemType;
+
+  template<typename C>
+  using PartialGradientColumnConstForm = void(C::*)(const BaseMatType&,
+                                                    const size_t,
+                                                    arma::Col<ElemType>&) const;
+
+  template<typename C>
+  using PartialGradientColumnForm = void(C::*)(const BaseMatType&,
+                                               const size_t,
+                                               arma::Col<ElemType>&);
+
+  const static bool value =
+      HasPartialGradientColumn<FunctionType,
+          PartialGradientColumnForm>::value ||
+      HasPartialGradientColumn<FunctionType,
+          PartialGradientColumnConstForm>::value;
+};
+
+//! The type of the workspaces of functions that don't declare a Workspace
+//! type.
+struct NoWorkspace { };
+
+//! Utility struct: type is the Workspace type declared by FunctionType, which
+//! its Evaluate() fills and its Gradient() then uses (see
+//! AddEvaluateWithGradient), or NoWorkspace if there is none.
+template<typename FunctionType, typename = void>
+struct WorkspaceType
+{
+  typedef NoWorkspace type;
+  const static bool value = false;
+};
+
+template<typename FunctionType>
+struct WorkspaceType<FunctionType, typename std::conditional<true, void,
+    typename FunctionType::Workspace>::type>
+{
+  typedef typename FunctionType::Workspace type;
+  const static bool value = true;
+};
+
+//! Utility struct, check if FunctionType declares a Workspace type, and has
+//! eT Evaluate(const MatType&, Workspace&) and void Gradient(const MatType&,
+//! GradType&, Workspace&), where eT is the element type of MatType.  value is
+//! true if both can be called on a non-const object, and constValue if both
+//! are const.
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasWorkspaceSignature
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef typename WorkspaceType<FunctionType>::type Workspace;
+
+  template<typename C>
+  using EvaluateConstForm = ElemType(C::*)(const MatType&, Workspace&) const;
+
+  template<typename C>
+  using EvaluateForm = ElemType(C::*)(const MatType&, Workspace&);
+
+  template<typename C>
+  using GradientConstForm = void(C::*)(const MatType&, GradType&,
+                                       Workspace&) const;
+
+  template<typename C>
+  using GradientForm = void(C::*)(const MatType&, GradType&, Workspace&);
+
+  const static bool constValue = WorkspaceType<FunctionType>::value &&
+      HasEvaluate<FunctionType, EvaluateConstForm>::value &&
+      HasGradient<FunctionType, GradientConstForm>::value;
+
+  const static bool value = WorkspaceType<FunctionType>::value &&
+      (HasEvaluate<FunctionType, EvaluateForm>::value ||
+       HasEvaluate<FunctionType, EvaluateConstForm>::value) &&
+      (HasGradient<FunctionType, GradientForm>::value ||
+       HasGradient<FunctionType, GradientConstForm>::value);
+};
+
+//! Utility struct, check if FunctionType declares a Workspace type, and has
+//! eT Evaluate(const MatType&, const size_t, const size_t, Workspace&) and
+//! void Gradient(const MatType&, const size_t, GradType&, const size_t,
+//! Workspace&), where eT is the element type of MatType.  value is true if
+//! both can be called on a non-const object, and constValue if both are const.
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasSeparableWorkspaceSignature
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef typename WorkspaceType<FunctionType>::type Workspace;
+
+  template<typename C>
+  using EvaluateConstForm = ElemType(C::*)(const MatType&, const size_t,
+                                           const size_t, Workspace&) const;
+
+  template<typename C>
+  using EvaluateForm = ElemType(C::*)(const MatType&, const size_t,
+                                      const size_t, Workspace&);
+
+  template<typename C>
+  using GradientConstForm = void(C::*)(const MatType&, const size_t,
+                                       GradType&, const size_t,
+                                       Workspace&) const;
+
+  template<typename C>
+  using GradientForm = void(C::*)(const MatType&, const size_t, GradType&,
+                                  const size_t, Workspace&);
+
+  const static bool constValue = WorkspaceType<FunctionType>::value &&
+      HasEvaluate<FunctionType, EvaluateConstForm>::value &&
+      HasGradient<FunctionType, GradientConstForm>::value;
+
+  const static bool value = WorkspaceType<FunctionType>::value &&
+      (HasEvaluate<FunctionType, EvaluateForm>::value ||
+       HasEvaluate<FunctionType, EvaluateConstForm>::value) &&
+      (HasGradient<FunctionType, GradientForm>::value ||
+       HasGradient<FunctionType, GradientConstForm>::value);
+};
+
 } // namespace traits
 } // namespace ens
 
@@ -20,6 +20,13 @@ namespace ens {
  * Class to hold the information and operations of current atoms in the
  * soluton space.  This is not fully templatized, and may cost some extra
  * operations for the conversion.
+ *
+ * Since atoms are added and removed one at a time, the Gram matrix P^T P of the
+ * projected atoms P (A * atom, one per column) and the products P^T b are kept
+ * up to date with one row and column per change, at a cost of O(mk) to add an
+ * atom and O(k^2) to remove one, for k atoms and m rows of A.  The update rules
+ * then solve their subproblems in the k-dimensional space of the coefficients
+ * instead of forming the products with A again.
  */
 class Atoms
 {
@@ -27,34 +34,111 @@ class Atoms
   Atoms(){ /* Nothing to do. */ }
 
   /**
-   * Add atom into the solution space.
+   * Add atom into the solution space, after the current atoms.  If the atom is
+   * already in the solution space (e.g. because it was reused by a lazy
+   * FrankWolfe iteration), c is added to its coefficient instead.
    *
    * @param v new atom to be added.
    * @param c coefficient of the new atom.
+   * @return Index of the atom.
    */
-  void AddAtom(const arma::mat& v, FuncSq& function, const double c = 0)
+  template<typename FuncSqType>
+  size_t AddAtom(const arma::mat& v, FuncSqType& function, const double c = 0)
   {
+    for (size_t j = 0; j < currentAtoms.n_cols; ++j)
+    {
+      if (std::equal(v.begin(), v.end(), currentAtoms.begin_col(j)))
+      {
+        currentCoeffs(j) += c;
+        return j;
+      }
+    }
+
+    arma::vec projected;
+    function.Project(v, projected);
     if (currentAtoms.is_empty())
     {
-      CurrentAtoms() = v;
+      CurrentAtoms() = arma::vectorise(v);
       CurrentCoeffs().set_size(1);
       CurrentCoeffs().fill(c);
-      atomSqTerm.set_size(1);
-      atomSqTerm(0) = std::pow(norm(function.MatrixA() * v, 2), 2);
+      projectedAtoms = projected;
+      gram.set_size(1, 1);
+      gram(0, 0) = arma::dot(projected, projected);
+      projectedB.set_size(1);
+      projectedB(0) = arma::dot(projected, function.Vectorb());
     }
     else
     {
-      currentAtoms.insert_cols(0, v);
+      // Extend the Gram matrix by the products of the new atom with the
+      // previous ones.
+      const size_t k = currentAtoms.n_cols;
+      const arma::vec products = projectedAtoms.t() * projected;
+      gram.resize(k + 1, k + 1);
+      gram.submat(0, k, k - 1, k) = products;
+      gram.submat(k, 0, k, k - 1) = products.t();
+      gram(k, k) = arma::dot(projected, projected);
+      projectedB.resize(k + 1);
+      projectedB(k) = arma::dot(projected, function.Vectorb());
+
+      currentAtoms.insert_cols(currentAtoms.n_cols, arma::vectorise(v));
       arma::vec cVec(1);
       cVec(0) = c;
-      currentCoeffs.insert_rows(0, cVec);
-      double tmp = std::pow(norm(function.MatrixA() * v, 2), 2);
-      arma::vec tmpVec(1);
-      tmpVec(0) = tmp;
-      atomSqTerm.insert_rows(0, tmpVec);
+      currentCoeffs.insert_rows(currentCoeffs.n_rows, cVec);
+      projectedAtoms.insert_cols(projectedAtoms.n_cols, projected);
     }
+
+    return currentAtoms.n_cols - 1;
   }
 
+  /**
+   * Remove the atom with the given index from the solution space.
+   *
+   * @param j index of the atom to be removed.
+   */
+  void RemoveAtom(const size_t j)
+  {
+    currentAtoms.shed_col(j);
+    currentCoeffs.shed_row(j);
+    projectedAtoms.shed_col(j);
+    gram.shed_row(j);
+    gram.shed_col(j);
+    projectedB.shed_row(j);
+  }
+
+  //! Remove the atoms whose coefficients are not positive.
+  void PruneZeroCoeffs()
+  {
+    for (size_t j = currentAtoms.n_cols; j > 0; --j)
+    {
+      if (currentCoeffs(j - 1) <= 0)
+        RemoveAtom(j - 1);
+    }
+  }
+
+  /**
+   * Find the away atom: the atom with positive coefficient whose inner product
+   * with the gradient is the largest.  Used in the away-step and pairwise
+   * update rules.
+   *
+   * @param atomGradients inner products of the current atoms with the
+   *     gradient.
+   * @return Index of the away atom.
+   */
+  size_t AwayAtom(const arma::vec& atomGradients) const
+  {
+    size_t away = 0;
+    double largest = -std::numeric_limits<double>::infinity();
+    for (size_t j = 0; j < currentCoeffs.n_elem; ++j)
+    {
+      if (currentCoeffs(j) > 0 && atomGradients(j) > largest)
+      {
+        largest = atomGradients(j);
+        away = j;
+      }
+    }
+
+    return away;
+  }
 
   //! Recover the solution coordinate from the coefficients of current atoms.
   void RecoverVector(arma::mat& x)
@@ -78,46 +162,71 @@ class Atoms
    * }
    * @endcode
    *
+   * The gradient with respect to the coefficients and the reoptimized
+   * coefficients are computed from the Gram matrix of the projected atoms.
+   *
+   * @param F thresholding number.
+   * @param function function to be optimized.
+   */
+  template<typename FuncSqType>
+  void PruneSupport(const double F, FuncSqType& function)
+  {
+    std::vector<size_t> removed;
+    PruneSupport(F, function, removed);
+  }
+
+  /**
+   * Prune the support as above, and also return the indices of the deleted
+   * atoms, in the order in which they were deleted (each index is that of the
+   * atom in the current atoms when it was deleted).
+   *
    * @param F thresholding number.
    * @param function function to be optimized.
+   * @param removed indices of the deleted atoms.
    */
-  void PruneSupport(const double F, FuncSq& function)
+  template<typename FuncSqType>
+  void PruneSupport(const double F,
+                    FuncSqType& function,
+                    std::vector<size_t>& removed)
   {
-    arma::vec sqTerm = 0.5 * atomSqTerm % square(currentCoeffs);
+    removed.clear();
+    arma::vec sqTerm = 0.5 * gram.diag() % square(currentCoeffs);
 
     while (currentAtoms.n_cols > 1)
     {
-      // Solve for current gradient.
-      arma::mat x;
-      RecoverVector(x);
-      arma::mat gradient(arma::size(x));
-      function.Gradient(x, gradient);
-
-      // Find possible atom to be deleted.
+      // Find possible atom to be deleted; the gradient with respect to the
+      // coefficients is P^T (P * c - b) = G * c - P^T b.
       arma::vec gap = sqTerm -
-          currentCoeffs % trans(gradient.t() * currentAtoms);
+          currentCoeffs % (gram * currentCoeffs - projectedB);
       arma::uword ind;
       gap.min(ind);
 
       // Try deleting the atom.
-      arma::mat newAtoms(currentAtoms.n_rows, currentAtoms.n_cols - 1);
-      if (ind > 0)
-        newAtoms.cols(0, ind - 1) = currentAtoms.cols(0, ind - 1);
-      if (ind < (currentAtoms.n_cols - 1))
-      {
-        newAtoms.cols(ind, newAtoms.n_cols - 1) =
-            currentAtoms.cols(ind + 1, currentAtoms.n_cols - 1);
-      }
+      arma::mat newProjected = projectedAtoms;
+      newProjected.shed_col(ind);
 
       // Reoptimize the coefficients, we brute-forcely reoptimize in the span,
       // which would be used in UpdateSpan class. Alternatively, if you want to
       // add an atom norm constraint, you could use projected gradient method,
-      // see the implementaton of ProjectedGradientEnhancement().
-      arma::vec newCoeffs =
-          solve(function.MatrixA() * newAtoms, function.Vectorb(), arma::solve_opts::fast);
+      // see the implementaton of ProjectedGradientEnhancement().  The normal
+      // equations are solved with the Gram matrix of the remaining atoms, and
+      // the least squares problem is only solved directly if it is singular.
+      arma::mat newGram = gram;
+      newGram.shed_row(ind);
+      newGram.shed_col(ind);
+      arma::vec newProjectedB = projectedB;
+      newProjectedB.shed_row(ind);
+      arma::vec newCoeffs;
+      if (!arma::solve(newCoeffs, newGram, newProjectedB,
+          arma::solve_opts::no_approx))
+      {
+        newCoeffs = solve(newProjected, function.Vectorb(),
+            arma::solve_opts::fast);
+      }
 
       // Evaluate the function again.
-      double Fnew = function.Evaluate(newAtoms * newCoeffs);
+      const arma::vec r = newProjected * newCoeffs - function.Vectorb();
+      double Fnew = 0.5 * arma::dot(r, r);
 
       if (Fnew > F)
         // Should not delete the atom.
@@ -125,10 +234,10 @@ class Atoms
       else
       {
         // Delete the atom from current atoms.
-        currentAtoms = newAtoms;
+        RemoveAtom(ind);
         currentCoeffs = newCoeffs;
-        atomSqTerm.shed_row(ind);
         sqTerm.shed_row(ind);
+        removed.push_back(ind);
       } // else
     } // while
   }
@@ -155,35 +264,44 @@ class Atoms
    * }
    * @endcode
    *
+   * The gradient G * c - P^T b and the objective
+   * 0.5 * c^T G c - c^T P^T b + 0.5 * b^T b are computed from the Gram matrix
+   * of the projected atoms, so each iteration costs O(k^2) and doesn't depend
+   * on the size of A.
+   *
    * @param function function to be minimized.
    * @param tau atom norm constraint.
    * @param stepSize step size for projected gradient method.
    * @param maxIteration maximum iteration number.
    * @param tolerance tolerance for projected gradient method.
    */
-  void ProjectedGradientEnhancement(FuncSq& function,
+  template<typename FuncSqType>
+  void ProjectedGradientEnhancement(FuncSqType& function,
                                     double tau,
                                     double stepSize,
                                     size_t maxIteration = 100,
                                     double tolerance = 1e-3)
   {
-    arma::mat x;
-    RecoverVector(x);
-    double value = function.Evaluate(x);
+    const double bb = 0.5 * arma::dot(function.Vectorb(),
+        function.Vectorb());
+    arma::vec gc = gram * currentCoeffs;
+    double value = 0.5 * arma::dot(currentCoeffs, gc) -
+        arma::dot(currentCoeffs, projectedB) + bb;
+
+    // Reused by every projection.
+    std::vector<double> workspace;
 
     for (size_t iter = 1; iter<maxIteration; iter++)
     {
       // Update currentCoeffs with gradient descent method.
-      arma::mat g;
-      function.Gradient(x, g);
-      g = currentAtoms.t() * g;
-      currentCoeffs = currentCoeffs - stepSize * g;
+      currentCoeffs -= stepSize * (gc - projectedB);
 
       // Projection of currentCoeffs to satisfy the atom norm constraint.
-      Proximal::ProjectToL1Ball(currentCoeffs, tau);
+      Proximal::ProjectToL1Ball(currentCoeffs, tau, workspace);
 
-      RecoverVector(x);
-      double valueNew = function.Evaluate(x);
+      gc = gram * currentCoeffs;
+      double valueNew = 0.5 * arma::dot(currentCoeffs, gc) -
+          arma::dot(currentCoeffs, projectedB) + bb;
 
       if ((value - valueNew) < tolerance)
         break;
@@ -203,6 +321,15 @@ class Atoms
   //! Modify the current atoms.
   arma::mat& CurrentAtoms() { return currentAtoms; }
 
+  //! Get the products A * atom of the current atoms, one per column.
+  const arma::mat& ProjectedAtoms() const { return projectedAtoms; }
+
+  //! Get the Gram matrix of the projected atoms.
+  const arma::mat& Gram() const { return gram; }
+
+  //! Get the products of the projected atoms with the vector b.
+  const arma::vec& ProjectedB() const { return projectedB; }
+
  private:
   //! Coefficients of current atoms.
   arma::vec currentCoeffs;
@@ -210,9 +337,14 @@ class Atoms
   //! Current atoms in the solution space.
   arma::mat currentAtoms;
 
-  //! Atom square term: ||A * atom||^2, used in PruneSupport(). It is computed
-  //! when an atom is added.
-  arma::vec atomSqTerm;
+  //! Products A * atom of the current atoms, computed when an atom is added.
+  arma::mat projectedAtoms;
+
+  //! Gram matrix of the projected atoms; its diagonal holds ||A * atom||^2.
+  arma::mat gram;
+
+  //! Products of the projected atoms with the vector b.
+  arma::vec projectedB;
 }; // class Atoms
 
 }  // namespace ens
@@ -15,9 +15,31 @@
 #define ENSMALLEN_FW_CONSTR_STRUCTURE_GROUP_HPP
 
 #include "constr_lpball.hpp"
+#include <ensmallen_bits/utility/executor.hpp>
 
 namespace ens {
 
+namespace traits {
+
+//! Detect a DualNorms() method, which computes the dual norms of all the
+//! groups at once.
+template<typename GroupType, typename MatType>
+struct HasDualNorms
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().DualNorms(
+      std::declval<const MatType&>(),
+      std::declval<arma::Col<typename MatType::elem_type>&>()),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<GroupType>(0))::value;
+};
+
+} // namespace traits
+
 /**
  * Linear Constrained Solver for FrankWolfe. Constrained domain given in the
  * form of unit ball of different structured group. That is, given original
@@ -58,6 +80,14 @@ namespace ens {
  *    ProjectToGroup(const arma::mat& v, const size_t groupId, arma::vec& y);
  *    void OptimalFromGroup(const arma::mat& v, const size_t groupId, arma::mat& s);
  *
+ *  The GroupType may also give
+ *
+ *    void DualNorms(const arma::mat& v, arma::vec& norms);
+ *
+ *  which computes the dual norms of the projections of v to all the groups at
+ *  once (norms[i] is the norm of group i + 1); it is then used instead of one
+ *  ProjectToGroup() and DualNorm() per group.
+ *
  * @tparam GroupType Class that implements functions to map original vectors to
  *                   each group, and to solve linear optimization problem in the
  *                   unit ball defined by the norm of each group.
@@ -84,6 +114,33 @@ class ConstrStructGroupSolver
    */
   template<typename MatType>
   void Optimize(const MatType& v, MatType& s)
+  {
+    const size_t optimalGroup = OptimalGroup(v,
+        std::integral_constant<bool,
+            traits::HasDualNorms<GroupType, MatType>::value>());
+
+    groupExtractor.OptimalFromGroup(v, optimalGroup, s);
+  }
+
+ private:
+  //! Find the group with the largest dual norm from the norms of all the
+  //! groups, computed at once.
+  template<typename MatType>
+  size_t OptimalGroup(const MatType& v, std::true_type /* batched */)
+  {
+    arma::Col<typename MatType::elem_type> norms;
+    groupExtractor.DualNorms(v, norms);
+
+    // As below, the first group with the largest positive norm is chosen, and
+    // the first group if all the norms are zero.
+    if (norms.is_empty() || norms.max() <= 0)
+      return 1;
+    return (size_t) norms.index_max() + 1;
+  }
+
+  //! Find the group with the largest dual norm, one group at a time.
+  template<typename MatType>
+  size_t OptimalGroup(const MatType& v, std::false_type /* batched */)
   {
     typedef typename MatType::elem_type ElemType;
 
@@ -106,10 +163,9 @@ class ConstrStructGroupSolver
       }
     }
 
-    groupExtractor.OptimalFromGroup(v, optimalGroup, s);
+    return optimalGroup;
   }
 
- private:
   //! Information and methods for groups.
   GroupType& groupExtractor;
 };
@@ -118,6 +174,12 @@ class ConstrStructGroupSolver
  * Implementation of Structured Group. The projection to each group is using
  * restriction of vector support here, and the norm in each group is using lp
  * norm.
+ *
+ * The indices of all the groups are packed into one contiguous array, with the
+ * offset of each group, so DualNorms() computes the dual norms of all the
+ * groups in a single streaming pass over v, without extracting any group; the
+ * groups are split into ranges that are computed in parallel (see
+ * ParallelFor()) when there are many indices.
  */
 class GroupLpBall
 {
@@ -134,9 +196,23 @@ class GroupLpBall
               std::vector<arma::uvec> groupIndicesList):
     p(p), numGroups(groupIndicesList.size()),
     dimOrig(dimOrig),
-    groupIndicesList(groupIndicesList),
+    groupOffsets(groupIndicesList.size() + 1),
     lpBallSolver(p)
-  {/* Nothing to do. */}
+  {
+    groupOffsets[0] = 0;
+    for (size_t g = 0; g < numGroups; ++g)
+      groupOffsets[g + 1] = groupOffsets[g] + groupIndicesList[g].n_elem;
+
+    groupIndices.set_size(groupOffsets[numGroups]);
+    for (size_t g = 0; g < numGroups; ++g)
+    {
+      if (groupIndicesList[g].n_elem > 0)
+      {
+        groupIndices.subvec(groupOffsets[g], groupOffsets[g + 1] - 1) =
+            groupIndicesList[g];
+      }
+    }
+  }
 
   /**
    * Projection to specific group.
@@ -148,12 +224,12 @@ class GroupLpBall
   template<typename MatType>
   void ProjectToGroup(const MatType& v, const size_t groupId, MatType& y)
   {
-    arma::uvec& indList = groupIndicesList[groupId - 1];
-    size_t dim = indList.n_elem;
+    const size_t first = groupOffsets[groupId - 1];
+    size_t dim = groupOffsets[groupId] - first;
     y.set_size(dim, 1);
 
     for (size_t i = 0; i < dim; ++i)
-      y(i) = v(indList(i));
+      y(i) = v(groupIndices(first + i));
   }
 
   /**
@@ -176,12 +252,12 @@ class GroupLpBall
     lpBallSolver.Optimize(yk, sProj);
 
     // Recover s to the original dimension.
-    arma::uvec& indList = groupIndicesList[groupId - 1];
-    size_t dim = indList.n_elem;  // dimension of the group.
+    const size_t first = groupOffsets[groupId - 1];
+    size_t dim = groupOffsets[groupId] - first;  // dimension of the group.
     s.zeros(dimOrig, 1);
 
     for (size_t i = 0; i < dim; ++i)
-      s(indList(i)) = sProj(i);
+      s(groupIndices(first + i)) = sProj(i);
   }
 
   //! Get the number of groups.
@@ -189,6 +265,66 @@ class GroupLpBall
   //! Modify the number of groups.
   size_t& NumGroups() {return numGroups;}
 
+  /**
+   * Compute the q-norm (1/p+1/q=1) of the projection of v to each group, in
+   * one pass over the packed indices of the groups.
+   *
+   * @param v input vector.
+   * @param norms output q-norm of each group; norms[i] is that of group i + 1.
+   */
+  template<typename MatType>
+  void DualNorms(const MatType& v,
+                 arma::Col<typename MatType::elem_type>& norms)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    norms.set_size(numGroups);
+    const ElemType* x = v.memptr();
+    const arma::uword* indices = groupIndices.memptr();
+    const bool infNorm = (p == 1.0);
+    const bool oneNorm = (p == std::numeric_limits<double>::infinity());
+    if (!infNorm && !oneNorm && p <= 1.0)
+      Log::Fatal << "Wrong norm p!" << std::endl;
+    const ElemType q = (infNorm || oneNorm) ? ElemType(1) :
+        ElemType(1.0 / (1.0 - 1.0 / p));
+
+    // The groups are split into ranges of about the same number of indices.
+    const size_t numRanges = std::max((size_t) 1,
+        std::min(numGroups, 4 * MaxThreads()));
+    ParallelFor(numRanges, [&](const size_t r)
+    {
+      for (size_t g = numGroups * r / numRanges;
+          g < numGroups * (r + 1) / numRanges; ++g)
+      {
+        ElemType norm = 0;
+        const size_t end = groupOffsets[g + 1];
+        if (infNorm)
+        {
+          for (size_t k = groupOffsets[g]; k < end; ++k)
+            norm = std::max(norm, ElemType(std::abs(x[indices[k]])));
+        }
+        else if (oneNorm)
+        {
+          for (size_t k = groupOffsets[g]; k < end; ++k)
+            norm += std::abs(x[indices[k]]);
+        }
+        else if (q == 2)
+        {
+          for (size_t k = groupOffsets[g]; k < end; ++k)
+            norm += x[indices[k]] * x[indices[k]];
+          norm = std::sqrt(norm);
+        }
+        else
+        {
+          for (size_t k = groupOffsets[g]; k < end; ++k)
+            norm += std::pow(std::abs(x[indices[k]]), q);
+          norm = std::pow(norm, 1 / q);
+        }
+        norms[g] = norm;
+      }
+    }, groupIndices.n_elem >= 16384);
+  }
+
   /**
    * Compute the q-norm of yk, 1/p+1/q=1.
    *
@@ -232,8 +368,11 @@ class GroupLpBall
   //! Original Problem Dimension.
   size_t dimOrig;
 
-  //! Indices list of each group, indices start from 0.
-  std::vector<arma::uvec> groupIndicesList;
+  //! The offset of each group in groupIndices, followed by its size.
+  std::vector<size_t> groupOffsets;
+
+  //! Indices of all the groups, one group after another; indices start from 0.
+  arma::uvec groupIndices;
 
   //! Each group uses lp norm
   ConstrLpBallSolver lpBallSolver;
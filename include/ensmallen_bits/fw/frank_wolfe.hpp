@@ -16,6 +16,8 @@
 #include "update_linesearch.hpp"
 #include "update_classic.hpp"
 #include "update_span.hpp"
+#include "update_away_step.hpp"
+#include "update_pairwise.hpp"
 #include "constr_lpball.hpp"
 
 namespace ens {
@@ -56,6 +58,28 @@ namespace ens {
  * The parameter \f$ \epsilon \f$ is specified by the tolerance parameter to the
  * constructor.
  *
+ * In lazy mode, the vertices returned by LinearConstrSolver are cached, and in
+ * each iteration the cached vertex \f$ v \f$ with the largest
+ * \f$ <x_k - v, \nabla f(x_k)> \f$ is used instead of solving the linear
+ * constrained problem, as long as that gap is at least \f$ \Phi / K \f$,
+ * where \f$ \Phi \f$ is the duality gap at the last call of the solver and
+ * \f$ K \f$ is the lazy factor.  The solver is only called when no cached
+ * vertex qualifies, so this is useful when its cost dominates the iteration,
+ * e.g. for polytopes with few vertices or structured constraints.  The
+ * duality gap is only checked for termination when the solver is called.  See
+ * the following paper:
+ *
+ * @code
+ * @inproceedings{braun2017lazifying,
+ *   title     = {Lazifying Conditional Gradient Algorithms},
+ *   author    = {Braun, G{\'a}bor and Pokutta, Sebastian and Zink, Daniel},
+ *   booktitle = {Proceedings of the 34th International Conference on Machine
+ *                Learning},
+ *   pages     = {566--575},
+ *   year      = {2017}
+ * }
+ * @endcode
+ *
  * FrankWolfe can optimize differentiable functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
@@ -97,11 +121,17 @@ class FrankWolfe
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param lazy If true, reuse cached vertices instead of calling the linear
+   *     constrained solver whenever they give a sufficient duality gap.
+   * @param lazyFactor Lazy factor K; a cached vertex is used if its gap is at
+   *     least 1 / K times the last duality gap.
    */
   FrankWolfe(const LinearConstrSolverType linearConstrSolver,
              const UpdateRuleType updateRule,
              const size_t maxIterations = 100000,
-             const double tolerance = 1e-10);
+             const double tolerance = 1e-10,
+             const bool lazy = false,
+             const double lazyFactor = 2.0);
 
   /**
    * Optimize the given function using FrankWolfe.  The given starting
@@ -166,6 +196,16 @@ class FrankWolfe
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get whether or not cached vertices are reused.
+  bool Lazy() const { return lazy; }
+  //! Modify whether or not cached vertices are reused.
+  bool& Lazy() { return lazy; }
+
+  //! Get the lazy factor K.
+  double LazyFactor() const { return lazyFactor; }
+  //! Modify the lazy factor K.
+  double& LazyFactor() { return lazyFactor; }
+
  private:
   //! The solver for constrained linear problem in first step.
   LinearConstrSolverType linearConstrSolver;
@@ -178,6 +218,12 @@ class FrankWolfe
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! Whether or not cached vertices are reused.
+  bool lazy;
+
+  //! The lazy factor K.
+  double lazyFactor;
 };
 
 /**
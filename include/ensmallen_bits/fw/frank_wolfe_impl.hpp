@@ -27,11 +27,15 @@ FrankWolfe<LinearConstrSolverType, UpdateRuleType>::
 FrankWolfe(const LinearConstrSolverType linearConstrSolver,
            const UpdateRuleType updateRule,
            const size_t maxIterations,
-           const double tolerance) :
+           const double tolerance,
+           const bool lazy,
+           const double lazyFactor) :
     linearConstrSolver(linearConstrSolver),
     updateRule(updateRule),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    lazy(lazy),
+    lazyFactor(lazyFactor)
 { /* Nothing to do*/ }
 
 
@@ -72,6 +76,11 @@ FrankWolfe<LinearConstrSolverType, UpdateRuleType>::Optimize(
   BaseMatType iterateNew(iterate.n_rows, iterate.n_cols);
   double gap = 0;
 
+  // In lazy mode, the vertices returned by the solver, one per column, and the
+  // duality gap at the last call of the solver.
+  BaseMatType vertices;
+  double lastGap = 0;
+
   // Controls early termination of the optimization process.
   bool terminate = false;
 
@@ -87,25 +96,59 @@ FrankWolfe<LinearConstrSolverType, UpdateRuleType>::Optimize(
     Info << "FrankWolfe::Optimize(): iteration " << i << ", objective "
         << currentObjective << "." << std::endl;
 
-    // Solve linear constrained problem, solution saved in s.
-    linearConstrSolver.Optimize(gradient, s, callbacks...);
-
-    // Check duality gap for return condition.
-    gap = std::fabs(dot(iterate - s, gradient));
-    if (gap < tolerance)
+    // In lazy mode, look for a cached vertex with a sufficient gap first.
+    bool cached = false;
+    if (lazy && vertices.n_cols > 0)
     {
-      Info << "FrankWolfe::Optimize(): minimized within tolerance "
-          << tolerance << "; " << "terminating optimization." << std::endl;
+      const arma::Row<ElemType> gaps = arma::dot(iterate, gradient) -
+          arma::vectorise(gradient).t() * vertices;
+      arma::uword best = 0;
+      gaps.max(best);
+      if (gaps(best) > 0 && gaps(best) >= lastGap / lazyFactor)
+      {
+        std::copy(vertices.begin_col(best), vertices.end_col(best), s.begin());
+        cached = true;
+      }
+    }
 
-      Callback::EndOptimization(*this, f, iterate, callbacks...);
-      return currentObjective;
+    if (!cached)
+    {
+      // Solve linear constrained problem, solution saved in s.
+      linearConstrSolver.Optimize(gradient, s, callbacks...);
+
+      // Check duality gap for return condition.
+      gap = std::fabs(dot(iterate - s, gradient));
+      if (gap < tolerance)
+      {
+        Info << "FrankWolfe::Optimize(): minimized within tolerance "
+            << tolerance << "; " << "terminating optimization." << std::endl;
+
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return currentObjective;
+      }
+
+      if (lazy)
+      {
+        lastGap = gap;
+        bool found = false;
+        for (size_t j = 0; j < vertices.n_cols && !found; ++j)
+          found = std::equal(s.begin(), s.end(), vertices.begin_col(j));
+
+        if (!found)
+        {
+          const size_t j = vertices.n_cols;
+          vertices.resize(s.n_elem, j + 1);
+          std::copy(s.begin(), s.end(), vertices.begin_col(j));
+        }
+      }
     }
 
     // Update solution, save in iterateNew.
     updateRule.template Update<FunctionType, BaseMatType, BaseGradType>(f,
         iterate, s, iterateNew, i);
 
-    iterate = std::move(iterateNew);
+    // Copy, so that the memory of the iterate is kept.
+    iterate = iterateNew;
     terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
   }
 
@@ -17,9 +17,22 @@ namespace ens {
 /**
  * Square loss function \f$ f(x) = 0.5 * ||Ax - b||_2^2 \f$.
  *
- * Contains matrix \f$ A \f$ and vector \f$ b \f$.
+ * Contains matrix \f$ A \f$ and vector \f$ b \f$.  The matrix may be dense
+ * (arma::mat) or sparse (arma::sp_mat), so that sparse recovery problems only
+ * cost sparse matrix-vector products.
+ *
+ * The residual \f$ r = Ax - b \f$ of the last point is cached, so calling
+ * Evaluate() and Gradient() with the same point only computes it once.  Update
+ * rules that know the residual of their new point (e.g. because it is a convex
+ * combination of atoms whose products with A are known) can store it with
+ * SetResidual(), and then the next evaluation only costs a comparison of the
+ * point and, for the gradient, one product with \f$ A^T \f$.  If A or b are
+ * modified after the function has been evaluated, Clear() must be called.
+ *
+ * @tparam MatType Type of the matrix A.
  */
-class FuncSq
+template<typename MatType = arma::mat>
+class BasicFuncSq
 {
  public:
   /**
@@ -28,7 +41,8 @@ class FuncSq
    * @param A matrix A.
    * @param b vector b.
    */
-  FuncSq(const arma::mat& A, const arma::vec& b) : A(A), b(b)
+  BasicFuncSq(const MatType& A, const arma::vec& b) :
+      A(A), b(b), hasResidual(false)
   {/* Nothing to do. */}
 
   /**
@@ -40,7 +54,7 @@ class FuncSq
    */
   double Evaluate(const arma::mat& coords)
   {
-    arma::vec r = A * coords - b;
+    const arma::vec& r = Residual(coords);
     return arma::dot(r, r) * 0.5;
   }
 
@@ -53,28 +67,116 @@ class FuncSq
    */
   void Gradient(const arma::mat& coords, arma::mat& gradient)
   {
-    arma::vec r = A * coords - b;
+    gradient = A.t() * Residual(coords);
+  }
+
+  /**
+   * Evaluation of the function and its gradient, computing the residual only
+   * once.
+   *
+   * @param coords input vector x.
+   * @param gradient output gradient vector.
+   * @return \f$ f(x) \f$.
+   */
+  double EvaluateWithGradient(const arma::mat& coords, arma::mat& gradient)
+  {
+    const arma::vec& r = Residual(coords);
     gradient = A.t() * r;
+    return arma::dot(r, r) * 0.5;
+  }
+
+  /**
+   * Get the residual \f$ Ax - b \f$ at the given point, computing it only if
+   * it is not the cached point.
+   *
+   * @param coords vector x.
+   */
+  const arma::vec& Residual(const arma::mat& coords)
+  {
+    if (!(hasResidual && coords.n_elem == lastCoords.n_elem &&
+        std::equal(coords.begin(), coords.end(), lastCoords.begin())))
+    {
+      Project(coords, residual);
+      residual -= b;
+      lastCoords = coords;
+      hasResidual = true;
+    }
+
+    return residual;
   }
 
+  /**
+   * Store the residual \f$ Ax - b \f$ of the given point, so that it does not
+   * have to be computed when the function is evaluated there.
+   *
+   * @param coords vector x.
+   * @param r residual at x.
+   */
+  void SetResidual(const arma::mat& coords, const arma::vec& r)
+  {
+    lastCoords = coords;
+    residual = r;
+    hasResidual = true;
+  }
+
+  /**
+   * Compute the product \f$ Av \f$.  If v has few nonzero elements (e.g. it is
+   * a vertex of an l1 ball), only the corresponding columns of A are used.
+   *
+   * @param v vector v.
+   * @param out output product.
+   */
+  void Project(const arma::mat& v, arma::vec& out) const
+  {
+    const arma::uvec nonzeros = arma::find(v);
+    if (4 * nonzeros.n_elem >= v.n_elem)
+    {
+      out = A * arma::vectorise(v);
+      return;
+    }
+
+    out.zeros(A.n_rows);
+    for (size_t i = 0; i < nonzeros.n_elem; ++i)
+      out += v(nonzeros(i)) * A.col(nonzeros(i));
+  }
+
+  //! Forget the cached residual; this must be called if A or b are modified
+  //! after the function has been evaluated.
+  void Clear() { hasResidual = false; }
+
   //! Get the matrix A.
-  arma::mat MatrixA() const {return A;}
+  const MatType& MatrixA() const { return A; }
   //! Modify the matrix A.
-  arma::mat& MatrixA() {return A;}
+  MatType& MatrixA() { return A; }
 
   //! Get the vector b.
-  arma::vec Vectorb() const { return b; }
+  const arma::vec& Vectorb() const { return b; }
   //! Modify the vector b.
   arma::vec& Vectorb() { return b; }
 
  private:
   //! Matrix A in square loss function.
-  arma::mat A;
+  MatType A;
 
   //! Vector b in square loss function.
   arma::vec b;
+
+  //! Whether or not the residual of lastCoords is cached.
+  bool hasResidual;
+
+  //! The point of the cached residual.
+  arma::mat lastCoords;
+
+  //! The cached residual.
+  arma::vec residual;
 };
 
+//! Square loss function with a dense matrix.
+typedef BasicFuncSq<arma::mat> FuncSq;
+
+//! Square loss function with a sparse matrix.
+typedef BasicFuncSq<arma::sp_mat> SparseFuncSq;
+
 } // namespace ens
 
 #endif
@@ -20,6 +20,10 @@ namespace ens {
  * Approximate a vector with another vector on lp ball. Currently support l0
  * ball and l1 ball with specific norm.
  * It can be used in projected gradient method.
+ *
+ * The projections onto the simplex and onto a box, and the proximal operators
+ * of the l1 norm and of the group lasso penalty, are used by the proximal
+ * operators of ProximalGradient and ProximalUpdate (see L1Penalty).
  */
 class Proximal
 {
@@ -31,6 +35,9 @@ class Proximal
    * w = argmin_w ||w - v||_2, \qquad s.t. ~ ||w||_1 \leqslant tau
    * \f]
    *
+   * This takes O(n) time in practice for n elements (see ProjectToSimplex()),
+   * and uses n elements of workspace.
+   *
    * @param v Input vector to be approxmated, the output optimal vector is
    *          also saved in v.
    * @param tau Norm of l1 ball.
@@ -38,6 +45,22 @@ class Proximal
   template<typename MatType>
   static void ProjectToL1Ball(MatType& v, double tau);
 
+  /**
+   * Project the vector onto the l1 ball with norm tau, using the given
+   * workspace, so that repeated projections don't allocate memory once the
+   * workspace has grown to the size of v.
+   *
+   * @param v Input vector to be approxmated, the output optimal vector is
+   *          also saved in v.
+   * @param tau Norm of l1 ball.
+   * @param workspace Workspace, reused between calls.
+   */
+  template<typename MatType>
+  static void ProjectToL1Ball(
+      MatType& v,
+      double tau,
+      std::vector<typename MatType::elem_type>& workspace);
+
   /**
    * Project the vector onto the l0 ball with norm tau. That is, we try to
    * approximate v with sparse vector w:
@@ -45,12 +68,135 @@ class Proximal
    * w = argmin_w ||w - v||_2, \qquad s.t. ~ ||w||_0 \leqslant tau
    * \f]
    *
+   * The tau elements with the largest absolute values are kept; they are found
+   * by selection (std::nth_element) in O(n) time, instead of a full sort.
+   *
    * @param v Input vector to be approxmated, the output optimal vector is
    *          also saved in v.
    * @param tau Norm of l0 ball.
    */
   template<typename MatType>
   static void ProjectToL0Ball(MatType& v, int tau);
+
+  /**
+   * Project the vector onto the l0 ball with norm tau, using the given
+   * workspace, so that repeated projections don't allocate memory once the
+   * workspace has grown to the size of v.
+   *
+   * @param v Input vector to be approxmated, the output optimal vector is
+   *          also saved in v.
+   * @param tau Norm of l0 ball.
+   * @param workspace Workspace, reused between calls.
+   */
+  template<typename MatType>
+  static void ProjectToL0Ball(
+      MatType& v,
+      int tau,
+      std::vector<typename MatType::elem_type>& workspace);
+
+  /**
+   * Project the vector onto the simplex of the given radius.  That is, we will
+   * solve for:
+   * \f[
+   * w = argmin_w ||w - v||_2, \qquad s.t. ~ w \geqslant 0, ~
+   * \sum_i w_i = radius
+   * \f]
+   *
+   * The threshold of the projection is found with the algorithm of Condat,
+   * without sorting; its running time is linear in the number of elements in
+   * practice (quadratic in the worst case), and it uses n elements of
+   * workspace.
+   *
+   * @code
+   * @article{Condat2016,
+   *   author  = {Condat, Laurent},
+   *   title   = {Fast Projection onto the Simplex and the l1 Ball},
+   *   journal = {Mathematical Programming},
+   *   volume  = {158},
+   *   number  = {1},
+   *   pages   = {575--585},
+   *   year    = {2016}
+   * }
+   * @endcode
+   *
+   * @param v Input vector to be projected, the output optimal vector is also
+   *          saved in v.
+   * @param radius Sum of the elements of the simplex.
+   */
+  template<typename MatType>
+  static void ProjectToSimplex(MatType& v, double radius);
+
+  /**
+   * Project the vector onto the simplex of the given radius, using the given
+   * workspace, so that repeated projections don't allocate memory once the
+   * workspace has grown to the size of v.
+   *
+   * @param v Input vector to be projected, the output optimal vector is also
+   *          saved in v.
+   * @param radius Sum of the elements of the simplex.
+   * @param workspace Workspace, reused between calls.
+   */
+  template<typename MatType>
+  static void ProjectToSimplex(
+      MatType& v,
+      double radius,
+      std::vector<typename MatType::elem_type>& workspace);
+
+  /**
+   * Project the vector onto the box [lower, upper], i.e. clamp each element.
+   *
+   * @param v Input vector to be projected, the output optimal vector is also
+   *          saved in v.
+   * @param lower Lower bound of each element.
+   * @param upper Upper bound of each element.
+   */
+  template<typename MatType>
+  static void ProjectToBox(MatType& v, double lower, double upper);
+
+  /**
+   * Apply the proximal operator of the l1 norm (soft thresholding):
+   * \f[
+   * w = argmin_w \frac{1}{2} ||w - v||_2^2 + \lambda ||w||_1
+   * \f]
+   *
+   * @param v Input vector, the output vector is also saved in v.
+   * @param lambda Threshold.
+   */
+  template<typename MatType>
+  static void SoftThreshold(MatType& v, double lambda);
+
+  /**
+   * Apply the proximal operator of the sum of the l2 norms of the given groups
+   * of elements (block soft thresholding):
+   * \f[
+   * w = argmin_w \frac{1}{2} ||w - v||_2^2 + \lambda \sum_g ||w_g||_2
+   * \f]
+   *
+   * The groups must not overlap; elements that are in no group are left
+   * unchanged.  The groups are given as in GroupLpBall.
+   *
+   * @param v Input vector, the output vector is also saved in v.
+   * @param lambda Threshold.
+   * @param groups Indices of the elements of each group.
+   */
+  template<typename MatType>
+  static void GroupSoftThreshold(MatType& v,
+                                 double lambda,
+                                 const std::vector<arma::uvec>& groups);
+
+ private:
+  /**
+   * Return the threshold of the projection of the given n values onto the
+   * simplex of the given radius (Condat's algorithm), using the given buffer
+   * of n elements.  If `absolute` is true, the absolute values of the given
+   * values are projected instead.
+   */
+  template<typename ElemType>
+  static ElemType SimplexThreshold(const ElemType* values,
+                                   const size_t n,
+                                   const ElemType radius,
+                                   const bool absolute,
+                                   ElemType* buffer);
 };  // class Proximal
 
 } // namespace ens
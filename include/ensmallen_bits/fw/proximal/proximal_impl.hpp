@@ -30,38 +30,48 @@ namespace ens {
  *    year         = {2008}}
  * @endcode
  *
- * This is just a soft thresholding.
+ * This is just a soft thresholding, whose threshold is that of the projection
+ * of the absolute values of v onto the simplex.
  */
 template<typename MatType>
 inline void Proximal::ProjectToL1Ball(MatType& v, double tau)
 {
-  MatType simplexSol = arma::abs(v);
+  std::vector<typename MatType::elem_type> workspace;
+  ProjectToL1Ball(v, tau, workspace);
+}
+
+template<typename MatType>
+inline void Proximal::ProjectToL1Ball(
+    MatType& v,
+    double tau,
+    std::vector<typename MatType::elem_type>& workspace)
+{
+  typedef typename MatType::elem_type ElemType;
 
   // Already with L1 norm <= tau.
-  if (arma::accu(simplexSol) <= tau)
+  if (arma::accu(arma::abs(v)) <= tau)
     return;
 
-  simplexSol = arma::sort(simplexSol, "descend");
-  MatType simplexSum = arma::cumsum(simplexSol);
-
-  double nu = 0;
-  size_t rho = 0;
-  for (size_t j = 1; j <= simplexSol.n_rows; j++)
+  if (tau <= 0.0)
   {
-    rho = simplexSol.n_rows - j;
-    nu = simplexSol(rho) - (simplexSum(rho) - tau) / (rho + 1);
-    if (nu > 0)
-      break;
+    v.zeros();
+    return;
   }
-  double theta = (simplexSum(rho) - tau) / rho;
+
+  workspace.resize(v.n_elem);
+  ElemType* x = v.memptr();
+  const ElemType theta = SimplexThreshold<ElemType>(x, v.n_elem, tau, true,
+      workspace.data());
 
   // Threshold on absolute value of v with theta.
-  for (arma::uword j = 0; j < simplexSol.n_rows; j++)
+  for (size_t j = 0; j < v.n_elem; ++j)
   {
-    if (v(j) >= 0.0)
-      v(j) = std::max(v(j) - theta, 0.0);
+    if (x[j] > theta)
+      x[j] -= theta;
+    else if (x[j] < -theta)
+      x[j] += theta;
     else
-      v(j) = std::min(v(j) + theta, 0.0);
+      x[j] = 0;
   }
 }
 
@@ -72,11 +82,209 @@ inline void Proximal::ProjectToL1Ball(MatType& v, double tau)
 template<typename MatType>
 inline void Proximal::ProjectToL0Ball(MatType& v, int tau)
 {
-  arma::uvec indices = arma::sort_index(arma::abs(v));
-  arma::uword numberToKill = v.n_elem - tau;
+  std::vector<typename MatType::elem_type> workspace;
+  ProjectToL0Ball(v, tau, workspace);
+}
+
+template<typename MatType>
+inline void Proximal::ProjectToL0Ball(
+    MatType& v,
+    int tau,
+    std::vector<typename MatType::elem_type>& workspace)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (tau <= 0)
+  {
+    v.zeros();
+    return;
+  }
+
+  const size_t keep = (size_t) tau;
+  if (keep >= v.n_elem)
+    return;
+
+  // Find the tau-th largest absolute value.
+  ElemType* x = v.memptr();
+  workspace.resize(v.n_elem);
+  for (size_t i = 0; i < v.n_elem; ++i)
+    workspace[i] = std::abs(x[i]);
+
+  std::nth_element(workspace.begin(), workspace.begin() + (keep - 1),
+      workspace.end(),
+      [](const ElemType a, const ElemType b) { return a > b; });
+  const ElemType threshold = workspace[keep - 1];
+
+  // Keep the elements above the threshold, and as many of the elements equal
+  // to it as are needed to keep tau elements.
+  size_t ties = keep;
+  for (size_t i = 0; i < v.n_elem; ++i)
+  {
+    if (std::abs(x[i]) > threshold)
+      --ties;
+  }
+
+  for (size_t i = 0; i < v.n_elem; ++i)
+  {
+    const ElemType a = std::abs(x[i]);
+    if (a < threshold)
+      x[i] = 0;
+    else if (a == threshold)
+    {
+      if (ties > 0)
+        --ties;
+      else
+        x[i] = 0;
+    }
+  }
+}
+
+/**
+ * Projection of the vector v onto the simplex with the given radius: each
+ * element is shifted by the threshold of Condat's algorithm, and clamped to 0.
+ */
+template<typename MatType>
+inline void Proximal::ProjectToSimplex(MatType& v, double radius)
+{
+  std::vector<typename MatType::elem_type> workspace;
+  ProjectToSimplex(v, radius, workspace);
+}
+
+template<typename MatType>
+inline void Proximal::ProjectToSimplex(
+    MatType& v,
+    double radius,
+    std::vector<typename MatType::elem_type>& workspace)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (v.n_elem == 0)
+    return;
+
+  if (radius <= 0.0)
+  {
+    v.zeros();
+    return;
+  }
+
+  workspace.resize(v.n_elem);
+  const ElemType theta = SimplexThreshold<ElemType>(v.memptr(), v.n_elem,
+      radius, false, workspace.data());
+
+  v -= theta;
+  v.clamp(0, std::numeric_limits<ElemType>::max());
+}
+
+/**
+ * Condat's algorithm: a running estimate of the threshold is kept for a set of
+ * candidates for the elements above it.  The first pass adds each element that
+ * is above the estimate, and sets the candidates aside when an element alone
+ * gives a larger estimate; the elements that were set aside and are still
+ * above the estimate are then added back, and finally the candidates that are
+ * below the estimate are removed until none is.
+ */
+template<typename ElemType>
+inline ElemType Proximal::SimplexThreshold(const ElemType* values,
+                                           const size_t n,
+                                           const ElemType radius,
+                                           const bool absolute,
+                                           ElemType* buffer)
+{
+  // The candidates are buffer[begin, end), and the elements set aside are
+  // buffer[0, begin).
+  size_t begin = 0;
+  size_t end = 1;
+  buffer[0] = absolute ? std::abs(values[0]) : values[0];
+  ElemType tau = buffer[0] - radius;
+  for (size_t i = 1; i < n; ++i)
+  {
+    const ElemType y = absolute ? std::abs(values[i]) : values[i];
+    if (y <= tau)
+      continue;
+
+    tau += (y - tau) / ElemType(end - begin + 1);
+    buffer[end++] = y;
+    if (tau <= y - radius)
+    {
+      tau = y - radius;
+      begin = end - 1;
+    }
+  }
+
+  // Add back the elements that were set aside and are above the estimate; the
+  // candidates grow towards the start of the buffer.
+  for (size_t j = begin; j-- > 0; )
+  {
+    if (buffer[j] > tau)
+    {
+      buffer[--begin] = buffer[j];
+      tau += (buffer[begin] - tau) / ElemType(end - begin);
+    }
+  }
+
+  // Remove the candidates below the estimate, until there are none.
+  ElemType* candidates = buffer + begin;
+  size_t length = end - begin;
+  size_t lastLength;
+  do
+  {
+    lastLength = length;
+    length = 0;
+    for (size_t i = 0; i < lastLength; ++i)
+    {
+      if (candidates[i] > tau)
+        candidates[length++] = candidates[i];
+      else
+        tau += (tau - candidates[i]) / ElemType(lastLength - i - 1 + length);
+    }
+  } while (length < lastLength);
+
+  return tau;
+}
+
+/**
+ * Projection of the vector v onto a box: each element is clamped.
+ */
+template<typename MatType>
+inline void Proximal::ProjectToBox(MatType& v, double lower, double upper)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  v.clamp(ElemType(lower), ElemType(upper));
+}
+
+/**
+ * Soft thresholding: each element is moved towards 0 by lambda, and set to 0
+ * if its absolute value is at most lambda.
+ */
+template<typename MatType>
+inline void Proximal::SoftThreshold(MatType& v, double lambda)
+{
+  typedef typename MatType::elem_type ElemType;
 
-  for (arma::uword i = 0; i < numberToKill; i++)
-    v(indices(i)) = 0.0;
+  v = arma::sign(v) % arma::clamp(arma::abs(v) - ElemType(lambda), 0,
+      std::numeric_limits<ElemType>::max());
+}
+
+/**
+ * Block soft thresholding: each group is scaled towards 0 so that its l2 norm
+ * decreases by lambda, and set to 0 if its norm is at most lambda.
+ */
+template<typename MatType>
+inline void Proximal::GroupSoftThreshold(MatType& v,
+                                         double lambda,
+                                         const std::vector<arma::uvec>& groups)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  for (size_t g = 0; g < groups.size(); ++g)
+  {
+    const ElemType groupNorm = arma::norm(v.elem(groups[g]), 2);
+    if (groupNorm <= ElemType(lambda))
+      v.elem(groups[g]).zeros();
+    else
+      v.elem(groups[g]) *= (1 - ElemType(lambda) / groupNorm);
+  }
 }
 
 } // namespace ens
@@ -0,0 +1,200 @@
+/**
+ * @file stochastic_frank_wolfe.hpp
+ *
+ * Stochastic variance-reduced Frank-Wolfe algorithm for separable functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_HPP
+#define ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_HPP
+
+#include "frank_wolfe.hpp"
+
+namespace ens {
+
+/**
+ * StochasticFrankWolfe minimizes a separable function
+ * \f$ f(x) = \sum_i f_i(x) \f$ over a compact convex set \f$ D \f$ with the
+ * stochastic variance-reduced Frank-Wolfe algorithm (SVRF).  Instead of the
+ * full gradient in each iteration, each iteration uses the gradient of a
+ * minibatch \f$ B \f$ of batchSize functions, corrected with the gradient of a
+ * snapshot \f$ w \f$:
+ *
+ * \f[
+ * g_k := \frac{1}{|B|} \sum_{i \in B} (\nabla f_i(x_k) - \nabla f_i(w))
+ *     + \frac{1}{n} \nabla f(w),
+ * \f]
+ *
+ * and then takes the same steps as FrankWolfe with the linear constrained
+ * solution \f$ s_k := arg\min_{s\in D} <s, g_k> \f$.  Every snapshotInterval
+ * iterations, the snapshot is moved to the current iterate, and the objective
+ * and the full gradient are computed in one pass over the data; that
+ * iteration uses the full gradient, and the duality gap
+ * \f$ <x_k - s_k, \nabla f(x_k)> \f$ at the snapshot is checked against the
+ * tolerance.  The variance of \f$ g_k \f$ vanishes as the iterates converge,
+ * so with the default snapshot interval of one pass over the batches, each
+ * iteration costs two minibatch gradients instead of one full gradient.
+ *
+ * The same LinearConstrSolverType and UpdateRuleType classes as for FrankWolfe
+ * can be used; UpdateClassic only uses the iteration number, while the other
+ * update rules evaluate the whole function, which then also needs the
+ * non-separable Evaluate() and Gradient() methods.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @inproceedings{hazan2016variance,
+ *   title     = {Variance-Reduced and Projection-Free Stochastic
+ *                Optimization},
+ *   author    = {Hazan, Elad and Luo, Haipeng},
+ *   booktitle = {Proceedings of the 33rd International Conference on Machine
+ *                Learning},
+ *   pages     = {1263--1271},
+ *   year      = {2016}
+ * }
+ * @endcode
+ *
+ * StochasticFrankWolfe can optimize differentiable separable functions.  For
+ * more details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ *
+ * @tparam LinearConstrSolverType Solver for the linear constrained problem.
+ * @tparam UpdateRuleType Rule to update the solution in each iteration.
+ */
+template<
+    typename LinearConstrSolverType,
+    typename UpdateRuleType>
+class StochasticFrankWolfe
+{
+ public:
+  /**
+   * Construct the stochastic Frank-Wolfe optimizer with the given parameters.
+   * The constraint domain \f$ D \f$ is given by the linear constrained solver.
+   *
+   * @param linearConstrSolver Solver for linear constrained problem.
+   * @param updateRule Rule for updating solution in each iteration.
+   * @param batchSize Number of functions in each minibatch.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param snapshotInterval Number of iterations between two snapshots (0
+   *     means one pass over the batches).
+   * @param tolerance Maximum absolute duality gap to terminate the algorithm.
+   * @param shuffle If true, the function order is shuffled after each pass
+   *     over the minibatches; otherwise, each function is visited in linear
+   *     order.
+   */
+  StochasticFrankWolfe(const LinearConstrSolverType linearConstrSolver,
+                       const UpdateRuleType updateRule,
+                       const size_t batchSize = 32,
+                       const size_t maxIterations = 100000,
+                       const size_t snapshotInterval = 0,
+                       const double tolerance = 1e-10,
+                       const bool shuffle = true);
+
+  /**
+   * Optimize the given function using stochastic Frank-Wolfe.  The given
+   * starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value is returned.
+   *
+   * @tparam SeparableFunctionType Type of function to be optimized.
+   * @tparam MatType Type of objective matrix.
+   * @tparam GradType Type of gradient matrix (default is MatType).
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to be optimized.
+   * @param iterate Input with starting point, and will be modified to save
+   *                the output optimial solution coordinates.
+   * @param callbacks Callback functions.
+   * @return Objective value at the final solution.
+   */
+  template<typename SeparableFunctionType, typename MatType, typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsArmaType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(SeparableFunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<SeparableFunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the linear constrained solver.
+  const LinearConstrSolverType& LinearConstrSolver()
+      const { return linearConstrSolver; }
+  //! Modify the linear constrained solver.
+  LinearConstrSolverType& LinearConstrSolver() { return linearConstrSolver; }
+
+  //! Get the update rule.
+  const UpdateRuleType& UpdateRule() const { return updateRule; }
+  //! Modify the update rule.
+  UpdateRuleType& UpdateRule() { return updateRule; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of iterations between two snapshots (0 means one pass
+  //! over the batches).
+  size_t SnapshotInterval() const { return snapshotInterval; }
+  //! Modify the number of iterations between two snapshots (0 means one pass
+  //! over the batches).
+  size_t& SnapshotInterval() { return snapshotInterval; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+ private:
+  //! The solver for constrained linear problem in first step.
+  LinearConstrSolverType linearConstrSolver;
+
+  //! The rule to update, used in the second step.
+  UpdateRuleType updateRule;
+
+  //! The number of functions in each minibatch.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The number of iterations between two snapshots.
+  size_t snapshotInterval;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "stochastic_frank_wolfe_impl.hpp"
+
+#endif
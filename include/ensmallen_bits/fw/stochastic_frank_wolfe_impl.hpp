@@ -0,0 +1,202 @@
+/**
+ * @file stochastic_frank_wolfe_impl.hpp
+ *
+ * Implementation of the stochastic variance-reduced Frank-Wolfe algorithm.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_IMPL_HPP
+#define ENSMALLEN_FW_STOCHASTIC_FRANK_WOLFE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "stochastic_frank_wolfe.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+template<
+    typename LinearConstrSolverType,
+    typename UpdateRuleType>
+StochasticFrankWolfe<LinearConstrSolverType, UpdateRuleType>::
+StochasticFrankWolfe(const LinearConstrSolverType linearConstrSolver,
+                     const UpdateRuleType updateRule,
+                     const size_t batchSize,
+                     const size_t maxIterations,
+                     const size_t snapshotInterval,
+                     const double tolerance,
+                     const bool shuffle) :
+    linearConstrSolver(linearConstrSolver),
+    updateRule(updateRule),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    snapshotInterval(snapshotInterval),
+    tolerance(tolerance),
+    shuffle(shuffle)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<
+    typename LinearConstrSolverType,
+    typename UpdateRuleType>
+template<typename SeparableFunctionType, typename MatType, typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsArmaType<GradType>::value,
+typename MatType::elem_type>::type
+StochasticFrankWolfe<LinearConstrSolverType, UpdateRuleType>::Optimize(
+    SeparableFunctionType& functionIn,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(functionIn));
+
+  // Make sure we have all necessary functions.
+  traits::CheckSeparableFunctionTypeAPI<SeparableFunctionType, BaseMatType,
+      BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  const size_t numFunctions = f.NumFunctions();
+  const size_t actualBatchSize = std::min(std::max(batchSize, (size_t) 1),
+      numFunctions);
+  const size_t numBatches = (numFunctions + actualBatchSize - 1) /
+      actualBatchSize;
+  const size_t actualSnapshotInterval = (snapshotInterval == 0) ?
+      numBatches : snapshotInterval;
+
+  // To keep track of the function value.
+  ElemType currentObjective = std::numeric_limits<ElemType>::max();
+
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+  BaseGradType snapshotGradient(iterate.n_rows, iterate.n_cols);
+  BaseGradType fullGradient(iterate.n_rows, iterate.n_cols);
+  BaseMatType s(iterate.n_rows, iterate.n_cols);
+  BaseMatType iterateNew(iterate.n_rows, iterate.n_cols);
+  BaseMatType snapshot;
+  double gap = 0;
+
+  // The first function of the next minibatch; a pass over the minibatches
+  // starts with a shuffle.
+  size_t currentFunction = numFunctions;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  for (size_t i = 1; i != maxIterations && !terminate; ++i)
+  {
+    if ((i - 1) % actualSnapshotInterval == 0)
+    {
+      // Take a snapshot: compute the objective and the mean gradient over all
+      // the functions.
+      currentObjective = 0;
+      fullGradient.zeros(iterate.n_rows, iterate.n_cols);
+      for (size_t b = 0; b < numFunctions; b += actualBatchSize)
+      {
+        const size_t effectiveBatchSize = std::min(actualBatchSize,
+            numFunctions - b);
+        currentObjective += f.EvaluateWithGradient(iterate, b, gradient,
+            effectiveBatchSize);
+        fullGradient += gradient;
+      }
+
+      terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+          currentObjective, fullGradient, callbacks...);
+      fullGradient /= (ElemType) numFunctions;
+
+      // Output current objective function.
+      Info << "StochasticFrankWolfe::Optimize(): iteration " << i
+          << ", objective " << currentObjective << "." << std::endl;
+
+      // Solve linear constrained problem with the full gradient, and check
+      // the duality gap of the whole objective for the return condition.
+      linearConstrSolver.Optimize(fullGradient, s, callbacks...);
+      gap = std::fabs(dot(iterate - s, fullGradient)) * numFunctions;
+      if (gap < tolerance)
+      {
+        Info << "StochasticFrankWolfe::Optimize(): minimized within "
+            << "tolerance " << tolerance << "; terminating optimization."
+            << std::endl;
+
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return currentObjective;
+      }
+
+      snapshot = iterate;
+    }
+    else
+    {
+      // Is this iteration the start of a pass over the minibatches?
+      if (currentFunction >= numFunctions)
+      {
+        currentFunction = 0;
+        if (shuffle)
+          f.Shuffle();
+      }
+
+      // Find the effective batch size (the last batch may be smaller).
+      const size_t effectiveBatchSize = std::min(actualBatchSize,
+          numFunctions - currentFunction);
+
+      // Calculate the variance reduced gradient.
+      f.Gradient(iterate, currentFunction, gradient, effectiveBatchSize);
+      terminate |= Callback::Gradient(*this, f, iterate, gradient,
+          callbacks...);
+      f.Gradient(snapshot, currentFunction, snapshotGradient,
+          effectiveBatchSize);
+      terminate |= Callback::Gradient(*this, f, snapshot, snapshotGradient,
+          callbacks...);
+
+      gradient = fullGradient + (gradient - snapshotGradient) /
+          (ElemType) effectiveBatchSize;
+      currentFunction += effectiveBatchSize;
+
+      // Solve linear constrained problem, solution saved in s.
+      linearConstrSolver.Optimize(gradient, s, callbacks...);
+    }
+
+    // Update solution, save in iterateNew.
+    updateRule.template Update<FullFunctionType, BaseMatType, BaseGradType>(
+        f, iterate, s, iterateNew, i);
+
+    // Copy, so that the memory of the iterate is kept.
+    iterate = iterateNew;
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  }
+
+  Info << "StochasticFrankWolfe::Optimize(): maximum iterations ("
+      << maxIterations << ") reached; " << "terminating optimization."
+      << std::endl;
+
+  // The iterate has moved since the last snapshot, so compute the final
+  // objective.
+  currentObjective = 0;
+  for (size_t b = 0; b < numFunctions; b += actualBatchSize)
+  {
+    const size_t effectiveBatchSize = std::min(actualBatchSize,
+        numFunctions - b);
+    const ElemType objective = f.Evaluate(iterate, b, effectiveBatchSize);
+    Callback::Evaluate(*this, f, iterate, objective, callbacks...);
+    currentObjective += objective;
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return currentObjective;
+} // Optimize()
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file update_away_step.hpp
+ *
+ * Away-step update method for FrankWolfe algorithm. Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_UPDATE_AWAY_STEP_HPP
+#define ENSMALLEN_FW_UPDATE_AWAY_STEP_HPP
+
+#include "func_sq.hpp"
+#include "atoms.hpp"
+
+namespace ens {
+
+/**
+ * Away-step update rule for FrankWolfe algorithm.  The solution is kept as a
+ * convex combination of the atoms returned by the linear constrained solver
+ * (starting with the initial point), and in each iteration either the usual
+ * step towards the new atom s, or an away step from the away atom v (the atom
+ * in the combination that is most aligned with the gradient) is taken,
+ * whichever has the larger duality gap:
+ *
+ * \f[
+ * x_{k+1} = x_k + \gamma (s - x_k) \quad \textrm{or} \quad
+ * x_{k+1} = x_k + \gamma (x_k - v),
+ * \f]
+ *
+ * with exact line search for \f$ \gamma \f$.  An away step can remove v from
+ * the combination, so the solution does not zig-zag towards a face of the
+ * domain, and the convergence is linear over polytopes.  The products A * atom
+ * are kept by Atoms and the residual is updated along the step, so each step
+ * costs O(mk) for k atoms, apart from the product of A and the new atom.  To
+ * keep the rounding errors of these updates from accumulating, the residual is
+ * recomputed from scratch after every drop step (an away step that removes an
+ * atom) and every `refreshInterval` iterations.  See the following paper:
+ *
+ * @code
+ * @inproceedings{lacoste2015global,
+ *   title     = {On the Global Linear Convergence of {Frank-Wolfe}
+ *                Optimization Variants},
+ *   author    = {Lacoste-Julien, Simon and Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {496--504},
+ *   year      = {2015}
+ * }
+ * @endcode
+ *
+ * The initial point must be in the constrained domain.  Currently only works
+ * for functions of the FuncSq or SparseFuncSq classes.
+ */
+class UpdateAwayStep
+{
+ public:
+  /**
+   * Construct the away-step update rule.
+   *
+   * @param refreshInterval Number of iterations after which the incrementally
+   *     updated residual is recomputed from scratch (0 means only after drop
+   *     steps).
+   */
+  UpdateAwayStep(const size_t refreshInterval = 100) :
+      refreshInterval(refreshInterval)
+  { /* Do nothing. */ }
+
+  //! Get the number of iterations between recomputations of the residual.
+  size_t RefreshInterval() const { return refreshInterval; }
+  //! Modify the number of iterations between recomputations of the residual.
+  size_t& RefreshInterval() { return refreshInterval; }
+
+  /**
+   * Away-step update rule for FrankWolfe.
+   *
+   * FuncSqType is an ignored type to match the requirements of the class.
+   *
+   * @param function Function to be optimized.
+   * @param oldCoords Previous solution coords.
+   * @param s Current linear_constr_solution result.
+   * @param newCoords Output new solution coords.
+   * @param numIter Current iteration number.
+   */
+  template<typename FuncSqType, typename MatType, typename GradType>
+  void Update(FuncSqType& function,
+              const MatType& oldCoords,
+              const MatType& s,
+              MatType& newCoords,
+              const size_t numIter)
+  {
+    // The initial point is the first atom of the combination.
+    if (numIter == 1 || atoms.CurrentAtoms().is_empty())
+    {
+      atoms = Atoms();
+      atoms.AddAtom(arma::mat(oldCoords), function, 1.0);
+    }
+
+    const size_t forward = atoms.AddAtom(arma::mat(s), function);
+    arma::vec& coeffs = atoms.CurrentCoeffs();
+    const arma::mat& projected = atoms.ProjectedAtoms();
+
+    // The gradient is A^T (Ax - b), so its inner products with the atoms only
+    // need the projected atoms and the residual, which is cached by the
+    // function.
+    const arma::vec r = function.Residual(arma::mat(oldCoords));
+    const arma::vec ax = r + function.Vectorb();
+    const arma::vec atomGradients = projected.t() * r;
+    const double xGradient = arma::dot(ax, r);
+    const size_t away = atoms.AwayAtom(atomGradients);
+
+    const double forwardGap = xGradient - atomGradients(forward);
+    const double awayGap = atomGradients(away) - xGradient;
+    const bool awayStep = (awayGap > forwardGap);
+
+    arma::vec direction;
+    double maxStep;
+    if (awayStep)
+    {
+      direction = ax - projected.col(away);
+      maxStep = coeffs(away) / (1.0 - coeffs(away));
+    }
+    else
+    {
+      direction = projected.col(forward) - ax;
+      maxStep = 1.0;
+    }
+
+    // Exact line search, f(x + gamma d) is quadratic in gamma.
+    const double sqNorm = arma::dot(direction, direction);
+    double gamma = 0;
+    if (sqNorm > 0)
+    {
+      gamma = std::max(std::min((awayStep ? awayGap : forwardGap) / sqNorm,
+          maxStep), 0.0);
+    }
+
+    // The new residual is updated in O(m) along the direction.
+    arma::vec newR = r + gamma * direction;
+    if (awayStep)
+    {
+      coeffs *= (1.0 + gamma);
+      coeffs(away) = (gamma == maxStep) ? 0.0 : coeffs(away) - gamma;
+    }
+    else
+    {
+      coeffs *= (1.0 - gamma);
+      coeffs(forward) += gamma;
+    }
+
+    const size_t numAtoms = atoms.CurrentAtoms().n_cols;
+    atoms.PruneZeroCoeffs();
+    const bool dropStep = (atoms.CurrentAtoms().n_cols < numAtoms);
+
+    arma::mat tmp;
+    atoms.RecoverVector(tmp);
+    newCoords = arma::conv_to<MatType>::from(tmp);
+
+    // Unless the residual is due to be recomputed, give the updated residual
+    // to the function; otherwise it computes A * x - b at the next evaluation.
+    const bool refresh = dropStep ||
+        (refreshInterval > 0 && numIter % refreshInterval == 0);
+    if (!refresh)
+      function.SetResidual(tmp, newR);
+  }
+
+ private:
+  //! Number of iterations between recomputations of the residual.
+  size_t refreshInterval;
+
+  //! Atoms information.
+  Atoms atoms;
+};
+
+} // namespace ens
+
+#endif
@@ -14,6 +14,7 @@
 #ifndef ENSMALLEN_FW_UPDATE_FULL_CORRECTION_HPP
 #define ENSMALLEN_FW_UPDATE_FULL_CORRECTION_HPP
 
+#include "func_sq.hpp"
 #include "atoms.hpp"
 
 namespace ens {
@@ -29,7 +30,7 @@ namespace ens {
  * smaller than or equal to tau. This constraint optimization problem is solved
  * by projected gradient method. See Atoms.ProjectedEnhancement().
  *
- * Currently only works for function in FuncSq class.
+ * Currently only works for functions of the FuncSq or SparseFuncSq classes.
  *
  */
 class UpdateFullCorrection
@@ -58,18 +59,21 @@ class UpdateFullCorrection
    * @param numIter Current iteration number.
    */
   template<typename FuncSqType, typename MatType, typename GradType>
-  void Update(FuncSq& function,
+  void Update(FuncSqType& function,
               const MatType& oldCoords,
               const MatType& s,
               MatType& newCoords,
               const size_t /* numIter */)
   {
-    // Line search, with explicit solution here.
-    MatType v = tau * s - oldCoords;
-    MatType b = function.Vectorb();
-    MatType A = function.MatrixA();
-    typename MatType::elem_type gamma = arma::dot(b - A * oldCoords, A * v);
-    gamma = gamma / std::pow(arma::norm(A * v, "fro"), 2);
+    // Line search, with explicit solution here.  A * v is computed from the
+    // cached residual of the old solution, A * (tau * s - x) = tau * A * s -
+    // (r + b).
+    arma::vec projectedS;
+    function.Project(arma::mat(s), projectedS);
+    const arma::vec& r = function.Residual(arma::mat(oldCoords));
+    const arma::vec projectedV = tau * projectedS - (r + function.Vectorb());
+    double gamma = -arma::dot(r, projectedV) /
+        arma::dot(projectedV, projectedV);
     gamma = std::min(gamma, 1.0);
     atoms.CurrentCoeffs() = (1.0 - gamma) * atoms.CurrentCoeffs();
     atoms.AddAtom(arma::mat(s), function, gamma * tau);
@@ -79,6 +83,8 @@ class UpdateFullCorrection
     arma::mat tmp;
     atoms.RecoverVector(tmp);
     newCoords = arma::conv_to<MatType>::from(tmp);
+    function.SetResidual(tmp, atoms.ProjectedAtoms() * atoms.CurrentCoeffs() -
+        function.Vectorb());
   }
 
  private:
@@ -0,0 +1,143 @@
+/**
+ * @file update_pairwise.hpp
+ *
+ * Pairwise update method for FrankWolfe algorithm. Used as UpdateRuleType.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_FW_UPDATE_PAIRWISE_HPP
+#define ENSMALLEN_FW_UPDATE_PAIRWISE_HPP
+
+#include "func_sq.hpp"
+#include "atoms.hpp"
+
+namespace ens {
+
+/**
+ * Pairwise update rule for FrankWolfe algorithm.  As in UpdateAwayStep, the
+ * solution is kept as a convex combination of atoms, but in each iteration
+ * the weight is moved directly from the away atom v to the new atom s:
+ *
+ * \f[
+ * x_{k+1} = x_k + \gamma (s - v), \quad 0 \leq \gamma \leq \alpha_v,
+ * \f]
+ *
+ * where \f$ \alpha_v \f$ is the coefficient of v, with exact line search for
+ * \f$ \gamma \f$.  This usually converges faster than the away-step rule in
+ * practice.  As in UpdateAwayStep, the residual is updated along the step and
+ * recomputed from scratch after every drop step and every `refreshInterval`
+ * iterations.  See the following paper:
+ *
+ * @code
+ * @inproceedings{lacoste2015global,
+ *   title     = {On the Global Linear Convergence of {Frank-Wolfe}
+ *                Optimization Variants},
+ *   author    = {Lacoste-Julien, Simon and Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {496--504},
+ *   year      = {2015}
+ * }
+ * @endcode
+ *
+ * The initial point must be in the constrained domain.  Currently only works
+ * for functions of the FuncSq or SparseFuncSq classes.
+ */
+class UpdatePairwise
+{
+ public:
+  /**
+   * Construct the pairwise update rule.
+   *
+   * @param refreshInterval Number of iterations after which the incrementally
+   *     updated residual is recomputed from scratch (0 means only after drop
+   *     steps).
+   */
+  UpdatePairwise(const size_t refreshInterval = 100) :
+      refreshInterval(refreshInterval)
+  { /* Do nothing. */ }
+
+  //! Get the number of iterations between recomputations of the residual.
+  size_t RefreshInterval() const { return refreshInterval; }
+  //! Modify the number of iterations between recomputations of the residual.
+  size_t& RefreshInterval() { return refreshInterval; }
+
+  /**
+   * Pairwise update rule for FrankWolfe.
+   *
+   * FuncSqType is an ignored type to match the requirements of the class.
+   *
+   * @param function Function to be optimized.
+   * @param oldCoords Previous solution coords.
+   * @param s Current linear_constr_solution result.
+   * @param newCoords Output new solution coords.
+   * @param numIter Current iteration number.
+   */
+  template<typename FuncSqType, typename MatType, typename GradType>
+  void Update(FuncSqType& function,
+              const MatType& oldCoords,
+              const MatType& s,
+              MatType& newCoords,
+              const size_t numIter)
+  {
+    // The initial point is the first atom of the combination.
+    if (numIter == 1 || atoms.CurrentAtoms().is_empty())
+    {
+      atoms = Atoms();
+      atoms.AddAtom(arma::mat(oldCoords), function, 1.0);
+    }
+
+    const size_t forward = atoms.AddAtom(arma::mat(s), function);
+    arma::vec& coeffs = atoms.CurrentCoeffs();
+    const arma::mat& projected = atoms.ProjectedAtoms();
+
+    // The gradient is A^T (Ax - b), so its inner products with the atoms only
+    // need the projected atoms and the residual, which is cached by the
+    // function.
+    const arma::vec r = function.Residual(arma::mat(oldCoords));
+    const arma::vec atomGradients = projected.t() * r;
+    const size_t away = atoms.AwayAtom(atomGradients);
+
+    // Exact line search, f(x + gamma d) is quadratic in gamma.
+    const arma::vec direction = projected.col(forward) - projected.col(away);
+    const double sqNorm = arma::dot(direction, direction);
+    const double maxStep = coeffs(away);
+    double gamma = 0;
+    if (sqNorm > 0)
+    {
+      gamma = std::max(std::min((atomGradients(away) -
+          atomGradients(forward)) / sqNorm, maxStep), 0.0);
+    }
+
+    coeffs(forward) += gamma;
+    coeffs(away) = (gamma == maxStep) ? 0.0 : coeffs(away) - gamma;
+
+    const size_t numAtoms = atoms.CurrentAtoms().n_cols;
+    atoms.PruneZeroCoeffs();
+    const bool dropStep = (atoms.CurrentAtoms().n_cols < numAtoms);
+
+    arma::mat tmp;
+    atoms.RecoverVector(tmp);
+    newCoords = arma::conv_to<MatType>::from(tmp);
+
+    // Unless the residual is due to be recomputed, give the updated residual
+    // to the function; otherwise it computes A * x - b at the next evaluation.
+    const bool refresh = dropStep ||
+        (refreshInterval > 0 && numIter % refreshInterval == 0);
+    if (!refresh)
+      function.SetResidual(tmp, r + gamma * direction);
+  }
+
+ private:
+  //! Number of iterations between recomputations of the residual.
+  size_t refreshInterval;
+
+  //! Atoms information.
+  Atoms atoms;
+};
+
+} // namespace ens
+
+#endif
@@ -22,7 +22,15 @@ namespace ens {
  * Recalculate the optimal solution in the span of all previous solution space,
  * used as update step for FrankWolfe algorithm.
  *
- * Currently only works for function in FuncSq class.
+ * The least squares problem in the span is solved through the normal
+ * equations, with a Cholesky factor of the Gram matrix of the projected atoms
+ * (A * atom, see Atoms::Gram()) that is extended by one row and column when an
+ * atom is added, and downdated with Givens rotations when an atom is pruned,
+ * so each step costs O(mk) for k atoms instead of a full factorization.  If it
+ * becomes numerically singular, the factor is recomputed, and the problem is
+ * solved directly if that fails too.
+ *
+ * Currently only works for functions of the FuncSq or SparseFuncSq classes.
  */
 class UpdateSpan
 {
@@ -46,40 +54,144 @@ class UpdateSpan
    * @param numIter current iteration number.
    */
   template<typename FuncSqType, typename MatType, typename GradType>
-  void Update(FuncSq& function,
+  void Update(FuncSqType& function,
               const MatType& oldCoords,
               const MatType& s,
               MatType& newCoords,
               const size_t /* numIter */)
   {
     // Add new atom into soluton space.
+    const size_t numAtoms = atoms.CurrentAtoms().n_cols;
     atoms.AddAtom(arma::mat(s), function);
 
     // Reoptimize the solution in the current space.
-    arma::vec b = function.Vectorb();
-    atoms.CurrentCoeffs() = solve(function.MatrixA() * atoms.CurrentAtoms(), b, arma::solve_opts::fast);
+    const arma::mat& projected = atoms.ProjectedAtoms();
+    const arma::vec& b = function.Vectorb();
+    if (atoms.CurrentAtoms().n_cols != numAtoms || R.n_cols != numAtoms)
+      UpdateFactor(atoms.Gram());
+
+    if (R.n_cols == projected.n_cols)
+    {
+      const arma::vec z = arma::solve(arma::trimatl(R.t()),
+          atoms.ProjectedB());
+      atoms.CurrentCoeffs() = arma::solve(arma::trimatu(R), z);
+    }
+    else
+    {
+      atoms.CurrentCoeffs() = solve(projected, b, arma::solve_opts::fast);
+    }
 
     // x has coords of only the current atoms, recover the solution
     // to the original size.
     arma::mat tmp;
     atoms.RecoverVector(tmp);
     newCoords = arma::conv_to<MatType>::from(tmp);
+    function.SetResidual(tmp, projected * atoms.CurrentCoeffs() - b);
 
     // Prune the support.
     if (isPrune)
     {
       double oldF = function.Evaluate(oldCoords);
       double F = 0.25 * oldF + 0.75 * function.Evaluate(newCoords);
-      atoms.PruneSupport(F, function);
+      std::vector<size_t> removed;
+      atoms.PruneSupport(F, function, removed);
+      if (R.n_cols == atoms.CurrentAtoms().n_cols + removed.size())
+      {
+        for (size_t i = 0; i < removed.size() && !R.is_empty(); ++i)
+          DeleteFromFactor(removed[i]);
+      }
+      else
+      {
+        R.reset();
+      }
       atoms.RecoverVector(tmp);
       newCoords = arma::conv_to<MatType>::from(tmp);
+      function.SetResidual(tmp, atoms.ProjectedAtoms() *
+          atoms.CurrentCoeffs() - b);
     }
   }
 
  private:
+  /**
+   * Extend the upper Cholesky factor R of the Gram matrix of the projected
+   * atoms by the last atom, or recompute it if it does not match the previous
+   * atoms.  If the Gram matrix is not numerically positive definite, R is
+   * left empty.
+   *
+   * @param gram Gram matrix of the projected atoms.
+   */
+  void UpdateFactor(const arma::mat& gram)
+  {
+    const size_t k = gram.n_cols;
+    const double aa = gram(k - 1, k - 1);
+    if (R.n_cols + 1 == k && k > 1)
+    {
+      // Append a row and a column: R^T r = P^T a, rho^2 = a^T a - r^T r.
+      const arma::vec r = arma::solve(arma::trimatl(R.t()),
+          gram.submat(0, k - 1, k - 2, k - 1));
+      const double rho2 = aa - arma::dot(r, r);
+      if (rho2 > 1e-12 * aa)
+      {
+        R.resize(k, k);
+        R.row(k - 1).zeros();
+        R.submat(0, k - 1, k - 2, k - 1) = r;
+        R(k - 1, k - 1) = std::sqrt(rho2);
+        return;
+      }
+    }
+    else if (k == 1 && aa > 0)
+    {
+      R.set_size(1, 1);
+      R(0, 0) = std::sqrt(aa);
+      return;
+    }
+
+    if (!arma::chol(R, gram))
+      R.reset();
+  }
+
+  /**
+   * Remove the given atom from the upper Cholesky factor R of the Gram matrix:
+   * R without its j'th column is only upper Hessenberg from the j'th column
+   * on, and the rotations that make it upper triangular again keep R^T R, so
+   * this costs O(k^2).  If the factor becomes singular, R is left empty.
+   *
+   * @param j Index of the removed atom.
+   */
+  void DeleteFromFactor(const size_t j)
+  {
+    R.shed_col(j);
+    for (size_t i = j; i < R.n_cols; ++i)
+    {
+      // Zero out R(i + 1, i) with a Givens rotation of rows i and i + 1.
+      const double a = R(i, i);
+      const double b = R(i + 1, i);
+      const double r = std::sqrt(a * a + b * b);
+      if (r == 0.0)
+        continue;
+
+      const double c = a / r;
+      const double s = b / r;
+      for (size_t l = i; l < R.n_cols; ++l)
+      {
+        const double x = R(i, l);
+        const double y = R(i + 1, l);
+        R(i, l) = c * x + s * y;
+        R(i + 1, l) = c * y - s * x;
+      }
+    }
+    R.shed_row(R.n_rows - 1);
+
+    if (R.n_cols > 0 && arma::min(R.diag()) <= 1e-6 * arma::max(R.diag()))
+      R.reset();
+  }
+
   //! Atoms information.
   Atoms atoms;
 
+  //! Upper Cholesky factor of the Gram matrix of the projected atoms.
+  arma::mat R;
+
   //! Flag for support prune step.
   bool isPrune;
 }; // class UpdateSpan
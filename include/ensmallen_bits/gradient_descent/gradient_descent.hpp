@@ -12,6 +12,11 @@
 #ifndef ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_HPP
 #define ENSMALLEN_GRADIENT_DESCENT_GRADIENT_DESCENT_HPP
 
+#include "step_policies/fixed_step.hpp"
+#include "step_policies/nesterov_step.hpp"
+#include "step_policies/barzilai_borwein_step.hpp"
+#include "step_policies/armijo_step.hpp"
+
 namespace ens {
 
 /**
@@ -36,11 +41,20 @@ namespace ens {
  * The parameter \f$\epsilon\f$ is specified by the tolerance parameter to the
  * constructor.
  *
+ * How each step is taken is selected with the StepPolicyType: FixedStep (the
+ * update above, the default), NesterovStep (FISTA acceleration with adaptive
+ * restart), BarzilaiBorweinStep (step sizes estimated from the last step) or
+ * ArmijoStep (backtracking line search).  GradientDescent is
+ * GradientDescentType<FixedStep>.
+ *
  * GradientDescent can optimize differentiable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * @tparam StepPolicyType The policy used to take each step.
  */
-class GradientDescent
+template<typename StepPolicyType = FixedStep>
+class GradientDescentType
 {
  public:
   /**
@@ -54,10 +68,12 @@ class GradientDescent
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param stepPolicy Instantiated step policy.
    */
-  GradientDescent(const double stepSize = 0.01,
-                  const size_t maxIterations = 100000,
-                  const double tolerance = 1e-5);
+  GradientDescentType(const double stepSize = 0.01,
+                      const size_t maxIterations = 100000,
+                      const double tolerance = 1e-5,
+                      const StepPolicyType& stepPolicy = StepPolicyType());
 
   /**
    * Optimize the given function using gradient descent.  The given starting
@@ -77,7 +93,7 @@ class GradientDescent
            typename MatType,
            typename GradType,
            typename... CallbackTypes>
-  typename std::enable_if<IsArmaType<GradType>::value,
+  typename std::enable_if<IsMatrixType<GradType>::value,
       typename MatType::elem_type>::type
   Optimize(FunctionType& function,
            MatType& iterate,
@@ -121,7 +137,7 @@ class GradientDescent
            typename MatType,
            typename GradType,
            typename... CallbackTypes>
-  typename std::enable_if<IsArmaType<GradType>::value,
+  typename std::enable_if<IsMatrixType<GradType>::value,
       typename MatType::elem_type>::type
   Optimize(FunctionType& function,
            MatType& iterate,
@@ -145,6 +161,109 @@ class GradientDescent
         numCategories, std::forward<CallbackTypes>(callbacks)...);
   }
 
+  /**
+   * The state of an optimization that is run step by step with Begin() and
+   * Step().  It refers to the function and the coordinates given to Begin(),
+   * which must outlive it, and holds everything else, so that many
+   * optimizations can be interleaved with the same optimizer.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  class State
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+    typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+    typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+    typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+    typedef typename StepPolicyType::template Policy<BaseMatType,
+        BaseGradType> InstStepPolicyType;
+
+    //! Create the state of an optimization of the given function with the
+    //! given optimizer.
+    State(GradientDescentType& optimizer,
+          FunctionType& function,
+          MatType& iterate) :
+        function(&static_cast<FullFunctionType&>(function)),
+        iterate(&((BaseMatType&) iterate)),
+        step(optimizer.StepPolicy(), iterate.n_rows, iterate.n_cols),
+        gradient(iterate.n_rows, iterate.n_cols),
+        objective(std::numeric_limits<ElemType>::max()),
+        lastObjective(std::numeric_limits<ElemType>::max()),
+        iterations(1),
+        finished(false)
+    { }
+
+    //! Get the current coordinates.
+    const BaseMatType& Iterate() const { return *iterate; }
+    //! Get the objective of the last iteration.
+    ElemType Objective() const { return objective; }
+    //! Get the number of the next iteration.
+    size_t Iterations() const { return iterations; }
+    //! Get whether or not the optimization has terminated.
+    bool Finished() const { return finished; }
+
+   private:
+    friend class GradientDescentType;
+
+    //! The function to optimize.
+    FullFunctionType* function;
+    //! The coordinates.
+    BaseMatType* iterate;
+    //! The instantiated step policy.
+    InstStepPolicyType step;
+    //! The gradient at the coordinates.
+    BaseGradType gradient;
+    //! The objective of the last iteration.
+    ElemType objective;
+    //! The objective of the iteration before.
+    ElemType lastObjective;
+    //! The number of the next iteration.
+    size_t iterations;
+    //! Whether or not the optimization has terminated.
+    bool finished;
+  };
+
+  /**
+   * Start an optimization of the given function that is run step by step with
+   * Step(), instead of to completion.  The optimization is the same as with
+   * Optimize(), except that no callbacks are called.
+   *
+   * @code
+   * GradientDescent gd;
+   * auto state = gd.Begin(f, coordinates);
+   * while (gd.Step(state, 10))
+   * {
+   *   // Do other work between every 10 iterations.
+   * }
+   * @endcode
+   *
+   * @param function Function to optimize; it must outlive the state.
+   * @param iterate Starting point (will be modified); it must outlive the
+   *     state.
+   * @return The state of the optimization.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  State<FunctionType, MatType, GradType> Begin(FunctionType& function,
+                                               MatType& iterate);
+
+  /**
+   * Run up to n iterations of the optimization of the given state, with the
+   * parameters of this optimizer.  Once the optimization has terminated, the
+   * coordinates are the final point and state.Objective() is the value
+   * Optimize() would have returned.
+   *
+   * @param state State returned by Begin().
+   * @param n Maximum number of iterations to run.
+   * @return false if the optimization has terminated.
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  bool Step(State<FunctionType, MatType, GradType>& state,
+            const size_t n = 1);
+
   //! Get the step size.
   double StepSize() const { return stepSize; }
   //! Modify the step size.
@@ -160,6 +279,20 @@ class GradientDescent
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get the step policy.
+  const StepPolicyType& StepPolicy() const { return stepPolicy; }
+  //! Modify the step policy.
+  StepPolicyType& StepPolicy() { return stepPolicy; }
+
+  //! Return the number of bytes that Optimize() keeps for coordinates of the
+  //! given size: the gradient, and the state of the step policy.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return MatrixBytes<GradType>(rows, cols) +
+        ens::PolicyStateBytes<MatType, GradType>(stepPolicy, rows, cols);
+  }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -169,8 +302,19 @@ class GradientDescent
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The step policy.
+  StepPolicyType stepPolicy;
 };
 
+using GradientDescent = GradientDescentType<FixedStep>;
+
+using AcceleratedGradientDescent = GradientDescentType<NesterovStep>;
+
+using BBGradientDescent = GradientDescentType<BarzilaiBorweinStep>;
+
+using ArmijoGradientDescent = GradientDescentType<ArmijoStep>;
+
 } // namespace ens
 
 #include "gradient_descent_impl.hpp"
@@ -20,25 +20,29 @@
 namespace ens {
 
 //! Constructor.
-inline GradientDescent::GradientDescent(
+template<typename StepPolicyType>
+GradientDescentType<StepPolicyType>::GradientDescentType(
     const double stepSize,
     const size_t maxIterations,
-    const double tolerance) :
+    const double tolerance,
+    const StepPolicyType& stepPolicy) :
     stepSize(stepSize),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    stepPolicy(stepPolicy)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
+template<typename StepPolicyType>
 template<typename FunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
-typename std::enable_if<IsArmaType<GradType>::value,
+typename std::enable_if<IsMatrixType<GradType>::value,
 typename MatType::elem_type>::type
-GradientDescent::Optimize(FunctionType& function,
-                          MatType& iterateIn,
-                          CallbackTypes&&... callbacks)
+GradientDescentType<StepPolicyType>::Optimize(FunctionType& function,
+                                              MatType& iterateIn,
+                                              CallbackTypes&&... callbacks)
 {
   // Convenience typedefs.
   typedef typename MatType::elem_type ElemType;
@@ -62,6 +66,10 @@ GradientDescent::Optimize(FunctionType& function,
   BaseMatType& iterate = (BaseMatType&) iterateIn;
   BaseGradType gradient(iterate.n_rows, iterate.n_cols);
 
+  // The step policy is instantiated for each optimization.
+  typename StepPolicyType::template Policy<BaseMatType, BaseGradType> instStep(
+      stepPolicy, iterate.n_rows, iterate.n_cols);
+
   // Controls early termination of the optimization process.
   bool terminate = false;
 
@@ -69,7 +77,7 @@ GradientDescent::Optimize(FunctionType& function,
   terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
   for (size_t i = 1; i != maxIterations && !terminate; ++i)
   {
-    overallObjective = f.EvaluateWithGradient(iterate, gradient);
+    overallObjective = instStep.Evaluate(f, iterate, gradient);
 
     terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
         overallObjective, gradient, callbacks...);
@@ -101,7 +109,7 @@ GradientDescent::Optimize(FunctionType& function,
     lastObjective = overallObjective;
 
     // And update the iterate.
-    iterate -= stepSize * gradient;
+    instStep.Update(f, iterate, overallObjective, gradient, stepSize);
     terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
   }
 
@@ -112,13 +120,71 @@ GradientDescent::Optimize(FunctionType& function,
   return overallObjective;
 }
 
+//! Start an optimization that is run with Step().
+template<typename StepPolicyType>
+template<typename FunctionType, typename MatType, typename GradType>
+typename GradientDescentType<StepPolicyType>::template State<FunctionType,
+    MatType, GradType>
+GradientDescentType<StepPolicyType>::Begin(FunctionType& function,
+                                           MatType& iterate)
+{
+  typedef State<FunctionType, MatType, GradType> StateType;
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<typename StateType::FullFunctionType,
+      typename StateType::BaseMatType, typename StateType::BaseGradType>();
+  RequireFloatingPointType<typename StateType::BaseMatType>();
+  RequireFloatingPointType<typename StateType::BaseGradType>();
+  RequireSameInternalTypes<typename StateType::BaseMatType,
+      typename StateType::BaseGradType>();
+
+  return StateType(*this, function, iterate);
+}
+
+//! Run up to n iterations of an optimization started with Begin().
+template<typename StepPolicyType>
+template<typename FunctionType, typename MatType, typename GradType>
+bool GradientDescentType<StepPolicyType>::Step(
+    State<FunctionType, MatType, GradType>& state,
+    const size_t n)
+{
+  for (size_t k = 0; k < n && !state.finished; ++k)
+  {
+    if (state.iterations == maxIterations)
+    {
+      state.finished = true;
+      break;
+    }
+
+    state.objective = state.step.Evaluate(*state.function, *state.iterate,
+        state.gradient);
+
+    // Stop on a diverged objective, or within the tolerance, as Optimize()
+    // does.
+    if (std::isnan(state.objective) || std::isinf(state.objective) ||
+        std::abs(state.lastObjective - state.objective) < tolerance)
+    {
+      state.finished = true;
+      break;
+    }
+
+    state.lastObjective = state.objective;
+    state.step.Update(*state.function, *state.iterate, state.objective,
+        state.gradient, stepSize);
+    ++state.iterations;
+  }
+
+  return !state.finished;
+}
+
+template<typename StepPolicyType>
 template<typename FunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
-typename std::enable_if<IsArmaType<GradType>::value,
+typename std::enable_if<IsMatrixType<GradType>::value,
 typename MatType::elem_type>::type
-GradientDescent::Optimize(
+GradientDescentType<StepPolicyType>::Optimize(
     FunctionType& function,
     MatType& iterate,
     const std::vector<bool>& categoricalDimensions,
@@ -0,0 +1,200 @@
+/**
+ * @file armijo_step.hpp
+ *
+ * Armijo backtracking line search step policy for GradientDescent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRADIENT_DESCENT_ARMIJO_STEP_HPP
+#define ENSMALLEN_GRADIENT_DESCENT_ARMIJO_STEP_HPP
+
+namespace ens {
+
+/**
+ * Armijo backtracking step policy for GradientDescent.  Each step starts with
+ * the last accepted step size divided by Contraction() (and the step size of
+ * the optimizer for the first step), capped at the step size of the
+ * optimizer, and multiplies it by Contraction() until the sufficient decrease
+ * condition
+ *
+ * \f[
+ * F(A_j - \alpha \nabla F(A_j)) \le F(A_j) - c \alpha \| \nabla F(A_j) \|^2
+ * \f]
+ *
+ * holds, with c = SufficientDecrease().  If it doesn't hold after
+ * MaxBacktracks() trials, the coordinates are left unchanged, so that the
+ * optimization terminates.  The objective of the accepted point is kept, so
+ * only its gradient is computed in the next iteration; the trial points are
+ * computed in one buffer, so the steps don't allocate.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Armijo1966,
+ *   author  = {Armijo, Larry},
+ *   title   = {Minimization of Functions Having Lipschitz Continuous First
+ *              Partial Derivatives},
+ *   journal = {Pacific Journal of Mathematics},
+ *   volume  = {16},
+ *   number  = {1},
+ *   pages   = {1--3},
+ *   year    = {1966}
+ * }
+ * @endcode
+ */
+class ArmijoStep
+{
+ public:
+  /**
+   * Construct the Armijo step policy.
+   *
+   * @param sufficientDecrease The fraction of the decrease predicted by the
+   *     gradient that a step must achieve.
+   * @param contraction The factor the step size is multiplied with after a
+   *     rejected trial.
+   * @param maxBacktracks The maximum number of trials of each step.
+   */
+  ArmijoStep(const double sufficientDecrease = 1e-4,
+             const double contraction = 0.5,
+             const size_t maxBacktracks = 50) :
+      sufficientDecrease(sufficientDecrease),
+      contraction(contraction),
+      maxBacktracks(maxBacktracks)
+  {
+    if (contraction <= 0.0 || contraction >= 1.0)
+    {
+      throw std::invalid_argument("ArmijoStep: the contraction must be in "
+          "(0, 1).");
+    }
+  }
+
+  //! Get the fraction of the predicted decrease a step must achieve.
+  double SufficientDecrease() const { return sufficientDecrease; }
+  //! Modify the fraction of the predicted decrease a step must achieve.
+  double& SufficientDecrease() { return sufficientDecrease; }
+
+  //! Get the factor the step size is multiplied with after a rejected trial.
+  double Contraction() const { return contraction; }
+  //! Modify the factor the step size is multiplied with after a rejected
+  //! trial.
+  double& Contraction() { return contraction; }
+
+  //! Get the maximum number of trials of each step.
+  size_t MaxBacktracks() const { return maxBacktracks; }
+  //! Modify the maximum number of trials of each step.
+  size_t& MaxBacktracks() { return maxBacktracks; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the trial point.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return MatrixBytes<MatType>(rows, cols); }
+
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the coordinates.
+     * @param cols Number of columns in the coordinates.
+     */
+    Policy(const ArmijoStep& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        trial(rows, cols),
+        step(0),
+        objective(0),
+        hasObjective(false)
+    { /* Nothing to do. */ }
+
+    /**
+     * Return the objective at the iterate, and store its gradient.  If the
+     * iterate is the point accepted by the last step, its objective is already
+     * known, and only the gradient is computed.
+     */
+    template<typename FunctionType>
+    ElemType Evaluate(FunctionType& function,
+                      const MatType& iterate,
+                      GradType& gradient)
+    {
+      if (hasObjective)
+      {
+        hasObjective = false;
+        function.Gradient(iterate, gradient);
+        return objective;
+      }
+
+      return function.EvaluateWithGradient(iterate, gradient);
+    }
+
+    //! Take the longest step along the negative gradient that satisfies the
+    //! sufficient decrease condition.
+    template<typename FunctionType>
+    void Update(FunctionType& function,
+                MatType& iterate,
+                const ElemType currentObjective,
+                const GradType& gradient,
+                const double stepSize)
+    {
+      const double squaredNorm = (double) arma::dot(gradient, gradient);
+      double alpha = (step == 0) ? stepSize :
+          std::min(stepSize, step / parent.Contraction());
+
+      for (size_t k = 0; k < parent.MaxBacktracks(); ++k)
+      {
+        trial = iterate - alpha * gradient;
+        const ElemType trialObjective = function.Evaluate(trial);
+        if (trialObjective <= currentObjective -
+            parent.SufficientDecrease() * alpha * squaredNorm)
+        {
+          iterate = trial;
+          step = alpha;
+          objective = trialObjective;
+          hasObjective = true;
+          return;
+        }
+
+        alpha *= parent.Contraction();
+      }
+
+      // No sufficient decrease; the iterate stays the same.
+      step = alpha;
+    }
+
+    //! Get the step size of the last step.
+    double Step() const { return step; }
+
+   private:
+    //! The instantiated parent class.
+    const ArmijoStep& parent;
+    //! The trial point.
+    MatType trial;
+    //! The step size of the last step.
+    double step;
+    //! The objective of the point accepted by the last step.
+    ElemType objective;
+    //! Whether or not the objective of the iterate is known.
+    bool hasObjective;
+  };
+
+ private:
+  //! The fraction of the predicted decrease a step must achieve.
+  double sufficientDecrease;
+  //! The factor the step size is multiplied with after a rejected trial.
+  double contraction;
+  //! The maximum number of trials of each step.
+  size_t maxBacktracks;
+};
+
+} // namespace ens
+
+#endif
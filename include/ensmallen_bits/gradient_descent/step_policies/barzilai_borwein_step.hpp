@@ -0,0 +1,163 @@
+/**
+ * @file barzilai_borwein_step.hpp
+ *
+ * Barzilai-Borwein step policy for GradientDescent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRADIENT_DESCENT_BARZILAI_BORWEIN_STEP_HPP
+#define ENSMALLEN_GRADIENT_DESCENT_BARZILAI_BORWEIN_STEP_HPP
+
+namespace ens {
+
+/**
+ * Barzilai-Borwein step policy for GradientDescent.  The first step has the
+ * step size of the optimizer; every later step has the step size
+ *
+ * \f[
+ * \alpha_j = \frac{s^T s}{s^T y}, \quad s = A_j - A_{j - 1}, \quad
+ * y = \nabla F(A_j) - \nabla F(A_{j - 1}),
+ * \f]
+ *
+ * clipped to [MinStepSize(), MaxStepSize()], which approximates the inverse
+ * curvature along the last step, as in BarzilaiBorweinDecay for SVRG.  If
+ * \f$ s^T y \le 0 \f$ (negative curvature), the step size of the optimizer
+ * is used again; keeping the last step size instead can stall the steps in a
+ * nonconvex valley (e.g. of the Rosenbrock function).  The differences are
+ * computed in place, in the buffers that hold the previous iterate and
+ * gradient, so that the steps don't allocate.
+ *
+ * @code
+ * @article{Barzilai1988,
+ *   author  = {Barzilai, Jonathan and Borwein, Jonathan M.},
+ *   title   = {Two-Point Step Size Gradient Methods},
+ *   journal = {IMA Journal of Numerical Analysis},
+ *   volume  = {8},
+ *   number  = {1},
+ *   pages   = {141--148},
+ *   year    = {1988}
+ * }
+ * @endcode
+ */
+class BarzilaiBorweinStep
+{
+ public:
+  /**
+   * Construct the Barzilai-Borwein step policy.
+   *
+   * @param maxStepSize The maximum step size.
+   * @param minStepSize The minimum step size.
+   */
+  BarzilaiBorweinStep(const double maxStepSize = DBL_MAX,
+                      const double minStepSize = 0.0) :
+      maxStepSize(maxStepSize),
+      minStepSize(minStepSize)
+  { /* Nothing to do. */ }
+
+  //! Get the maximum step size.
+  double MaxStepSize() const { return maxStepSize; }
+  //! Modify the maximum step size.
+  double& MaxStepSize() { return maxStepSize; }
+
+  //! Get the minimum step size.
+  double MinStepSize() const { return minStepSize; }
+  //! Modify the minimum step size.
+  double& MinStepSize() { return minStepSize; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the last iterate and the last gradient.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return MatrixBytes<MatType>(rows, cols) +
+        MatrixBytes<GradType>(rows, cols);
+  }
+
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the coordinates.
+     * @param cols Number of columns in the coordinates.
+     */
+    Policy(const BarzilaiBorweinStep& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        lastIterate(rows, cols),
+        lastGradient(rows, cols),
+        step(0),
+        first(true)
+    { /* Nothing to do. */ }
+
+    //! Return the objective at the iterate, and store its gradient.
+    template<typename FunctionType>
+    ElemType Evaluate(FunctionType& function,
+                      const MatType& iterate,
+                      GradType& gradient)
+    {
+      return function.EvaluateWithGradient(iterate, gradient);
+    }
+
+    //! Take a Barzilai-Borwein step along the negative gradient.
+    template<typename FunctionType>
+    void Update(FunctionType& /* function */,
+                MatType& iterate,
+                const ElemType /* objective */,
+                const GradType& gradient,
+                const double stepSize)
+    {
+      if (first)
+      {
+        step = stepSize;
+        first = false;
+      }
+      else
+      {
+        // lastIterate and lastGradient become -s and -y.
+        lastIterate -= iterate;
+        lastGradient -= gradient;
+        const double ss = (double) arma::dot(lastIterate, lastIterate);
+        const double sy = (double) arma::dot(lastIterate, lastGradient);
+        // Without positive curvature along the step, there is no estimate.
+        step = (sy > 0) ? std::min(std::max(ss / sy, parent.MinStepSize()),
+            parent.MaxStepSize()) : stepSize;
+      }
+
+      lastIterate = iterate;
+      lastGradient = gradient;
+      iterate -= step * gradient;
+    }
+
+   private:
+    //! The instantiated parent class.
+    const BarzilaiBorweinStep& parent;
+    //! The iterate of the last step.
+    MatType lastIterate;
+    //! The gradient of the last step.
+    GradType lastGradient;
+    //! The step size of the last step.
+    double step;
+    //! Whether or not no step has been taken yet.
+    bool first;
+  };
+
+ private:
+  //! The maximum step size.
+  double maxStepSize;
+  //! The minimum step size.
+  double minStepSize;
+};
+
+} // namespace ens
+
+#endif
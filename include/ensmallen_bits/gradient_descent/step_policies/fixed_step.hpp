@@ -0,0 +1,90 @@
+/**
+ * @file fixed_step.hpp
+ *
+ * Fixed step policy for GradientDescent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRADIENT_DESCENT_FIXED_STEP_HPP
+#define ENSMALLEN_GRADIENT_DESCENT_FIXED_STEP_HPP
+
+namespace ens {
+
+/**
+ * Fixed step policy for GradientDescent: every iteration takes a step of the
+ * step size of the optimizer along the negative gradient,
+ *
+ * \f[
+ * A_{j + 1} = A_j - \alpha \nabla F(A_j).
+ * \f]
+ *
+ * The StepPolicyType policy classes of GradientDescent must contain an
+ * internal 'Policy' template class with two template arguments, MatType and
+ * GradType, that is instantiated at the start of the optimization, with the
+ * methods
+ *
+ * @code
+ * // Return the objective at the iterate, and store its gradient.
+ * template<typename FunctionType>
+ * ElemType Evaluate(FunctionType& function,
+ *                   const MatType& iterate,
+ *                   GradType& gradient);
+ *
+ * // Take a step from the iterate, whose objective and gradient are given.
+ * template<typename FunctionType>
+ * void Update(FunctionType& function,
+ *             MatType& iterate,
+ *             const ElemType objective,
+ *             const GradType& gradient,
+ *             const double stepSize);
+ * @endcode
+ */
+class FixedStep
+{
+ public:
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the coordinates.
+     * @param cols Number of columns in the coordinates.
+     */
+    Policy(const FixedStep& /* parent */,
+           const size_t /* rows */,
+           const size_t /* cols */)
+    { /* Nothing to do. */ }
+
+    //! Return the objective at the iterate, and store its gradient.
+    template<typename FunctionType>
+    ElemType Evaluate(FunctionType& function,
+                      const MatType& iterate,
+                      GradType& gradient)
+    {
+      return function.EvaluateWithGradient(iterate, gradient);
+    }
+
+    //! Take a step of the given step size along the negative gradient.
+    template<typename FunctionType>
+    void Update(FunctionType& /* function */,
+                MatType& iterate,
+                const ElemType /* objective */,
+                const GradType& gradient,
+                const double stepSize)
+    {
+      iterate -= stepSize * gradient;
+    }
+  };
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,180 @@
+/**
+ * @file nesterov_step.hpp
+ *
+ * Nesterov (FISTA) accelerated step policy with adaptive restart for
+ * GradientDescent.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_GRADIENT_DESCENT_NESTEROV_STEP_HPP
+#define ENSMALLEN_GRADIENT_DESCENT_NESTEROV_STEP_HPP
+
+namespace ens {
+
+/**
+ * Nesterov's accelerated step policy for GradientDescent, with the momentum
+ * sequence of FISTA:
+ *
+ * \f[
+ * x_j = y_j - \alpha \nabla F(y_j), \quad
+ * t_{j + 1} = \frac{1 + \sqrt{1 + 4 t_j^2}}{2}, \quad
+ * y_{j + 1} = x_j + \frac{t_j - 1}{t_{j + 1}} (x_j - x_{j - 1}),
+ * \f]
+ *
+ * where \f$ y_j \f$ are the coordinates the optimizer evaluates the function
+ * at, so the objective and the final coordinates are those of the
+ * extrapolated points.  With AdaptiveRestart(), the momentum is reset
+ * (\f$ t_{j + 1} = 1 \f$) whenever \f$ \nabla F(y_j)^T (x_j - x_{j - 1}) > 0
+ * \f$, i.e. when the momentum points uphill; this keeps the
+ * \f$ O(1 / j^2) \f$ rate of convergence on smooth convex functions, and gives
+ * linear convergence on strongly convex functions without knowing their
+ * condition number.  The step size must be at most 1 / L, where L is the
+ * Lipschitz constant of the gradient.  Only one buffer (the previous
+ * \f$ x_j \f$) is kept, and the steps don't allocate.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @article{Beck2009,
+ *   author  = {Beck, Amir and Teboulle, Marc},
+ *   title   = {A Fast Iterative Shrinkage-Thresholding Algorithm for Linear
+ *              Inverse Problems},
+ *   journal = {SIAM Journal on Imaging Sciences},
+ *   volume  = {2},
+ *   number  = {1},
+ *   pages   = {183--202},
+ *   year    = {2009}
+ * }
+ *
+ * @article{ODonoghue2015,
+ *   author  = {O'Donoghue, Brendan and Cand\`es, Emmanuel},
+ *   title   = {Adaptive Restart for Accelerated Gradient Schemes},
+ *   journal = {Foundations of Computational Mathematics},
+ *   volume  = {15},
+ *   number  = {3},
+ *   pages   = {715--732},
+ *   year    = {2015}
+ * }
+ * @endcode
+ */
+class NesterovStep
+{
+ public:
+  /**
+   * Construct the Nesterov step policy.
+   *
+   * @param adaptiveRestart Whether or not the momentum is reset when it points
+   *     uphill.
+   */
+  NesterovStep(const bool adaptiveRestart = true) :
+      adaptiveRestart(adaptiveRestart)
+  { /* Nothing to do. */ }
+
+  //! Get whether or not the momentum is reset when it points uphill.
+  bool AdaptiveRestart() const { return adaptiveRestart; }
+  //! Modify whether or not the momentum is reset when it points uphill.
+  bool& AdaptiveRestart() { return adaptiveRestart; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the last iterate.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return MatrixBytes<MatType>(rows, cols); }
+
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+
+    /**
+     * This is called by the optimizer before the start of the optimization.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the coordinates.
+     * @param cols Number of columns in the coordinates.
+     */
+    Policy(const NesterovStep& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        lastX(rows, cols),
+        t(1),
+        first(true),
+        restarts(0)
+    { /* Nothing to do. */ }
+
+    //! Return the objective at the iterate, and store its gradient.
+    template<typename FunctionType>
+    ElemType Evaluate(FunctionType& function,
+                      const MatType& iterate,
+                      GradType& gradient)
+    {
+      return function.EvaluateWithGradient(iterate, gradient);
+    }
+
+    //! Take a gradient step from the extrapolated point, and extrapolate.
+    template<typename FunctionType>
+    void Update(FunctionType& /* function */,
+                MatType& iterate,
+                const ElemType /* objective */,
+                const GradType& gradient,
+                const double stepSize)
+    {
+      if (first)
+      {
+        lastX = iterate;
+        first = false;
+      }
+
+      // The iterate becomes x_j.
+      iterate -= stepSize * gradient;
+
+      double beta = 0;
+      if (parent.AdaptiveRestart() &&
+          arma::dot(gradient, iterate) > arma::dot(gradient, lastX))
+      {
+        t = 1;
+        ++restarts;
+      }
+      else
+      {
+        const double nextT = (1 + std::sqrt(1 + 4 * t * t)) / 2;
+        beta = (t - 1) / nextT;
+        t = nextT;
+      }
+
+      // lastX becomes x_j - x_{j - 1}, the iterate becomes y_{j + 1}, and
+      // lastX becomes x_j again.
+      lastX = iterate - lastX;
+      iterate += beta * lastX;
+      lastX = iterate - beta * lastX;
+    }
+
+    //! Get the number of times the momentum was reset.
+    size_t Restarts() const { return restarts; }
+
+   private:
+    //! The instantiated parent class.
+    const NesterovStep& parent;
+    //! The last gradient step x_{j - 1}.
+    MatType lastX;
+    //! The momentum sequence t_j.
+    double t;
+    //! Whether or not no step has been taken yet.
+    bool first;
+    //! The number of times the momentum was reset.
+    size_t restarts;
+  };
+
+ private:
+  //! Whether or not the momentum is reset when it points uphill.
+  bool adaptiveRestart;
+};
+
+} // namespace ens
+
+#endif
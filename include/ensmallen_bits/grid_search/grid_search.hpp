@@ -21,10 +21,72 @@ namespace ens {
  * GridSearch can optimize categorical functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * If `parallel` is true, the grid points are evaluated on OpenMP threads, and
+ * so Evaluate() must be safe to call concurrently.  The result is the same as
+ * for the serial search: of several points with the best objective, the first
+ * one in the order of the grid is returned.
+ *
+ * If `maxBudget` is not 0 and the function has a method
+ *
+ * @code
+ * double EvaluateWithBudget(const arma::mat& coordinates,
+ *                           const size_t budget);
+ * @endcode
+ *
+ * (const or non-const), which evaluates the function with the given budget
+ * (e.g. a number of training epochs, larger budgets giving more accurate
+ * objectives), then the grid is searched with successive halving: all points
+ * are evaluated with `minBudget`, the best 1 / eta of them are kept, and the
+ * budget is multiplied by eta, until the remaining points are evaluated with
+ * `maxBudget`.  Poor points are thus dropped after cheap evaluations.  For
+ * functions without EvaluateWithBudget(), the budget is ignored and every
+ * point is evaluated with Evaluate().
+ *
+ * If `refinementStride` is greater than 1, the categories of each dimension are
+ * taken to be ordered (e.g. the values of a discretized hyperparameter), and
+ * the grid is searched coarse-to-fine instead of exhaustively: first only every
+ * `refinementStride`-th category of each dimension (and the last one) is
+ * evaluated, then the stride is halved and the neighbours at that stride of the
+ * `refinementCells` best points found so far are evaluated, until the stride
+ * is 1.  Each level is evaluated in parallel if `parallel` is true, and no
+ * point is evaluated twice.  This needs far fewer evaluations than the full
+ * grid, and finds its optimum when the objective is smooth enough over the
+ * ordered categories.  Dimensions whose categories are unordered may be marked
+ * false in OrderedDimensions(); each of their categories is evaluated in the
+ * coarse level, and they keep the value of the refined point afterwards.
  */
 class GridSearch
 {
  public:
+  /**
+   * Construct the GridSearch optimizer.
+   *
+   * @param parallel If true, evaluate the grid points in parallel.
+   * @param minBudget Budget of the first round of successive halving.
+   * @param maxBudget Budget of the last round of successive halving (0
+   *     evaluates every point in full, without successive halving).
+   * @param eta Factor of the budget between two rounds; only the best 1 / eta
+   *     points of each round are kept.
+   * @param refinementStride Stride between the categories of the coarse level
+   *     of the coarse-to-fine search (0 or 1 searches the whole grid).
+   * @param refinementCells Number of best points refined at each level of the
+   *     coarse-to-fine search.
+   */
+  GridSearch(const bool parallel = false,
+             const size_t minBudget = 1,
+             const size_t maxBudget = 0,
+             const double eta = 3.0,
+             const size_t refinementStride = 0,
+             const size_t refinementCells = 1) :
+      parallel(parallel),
+      minBudget(minBudget),
+      maxBudget(maxBudget),
+      eta(eta),
+      refinementStride(refinementStride),
+      refinementCells(refinementCells)
+  { /* Nothing to do. */ }
+
   /**
    * Optimize (minimize) the given function by iterating through the all
    * possible combinations of values for the parameters specified in
@@ -46,13 +108,55 @@ class GridSearch
       const std::vector<bool>& categoricalDimensions,
       const arma::Row<size_t>& numCategories);
 
+  //! Get whether the grid points are evaluated in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the grid points are evaluated in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get the budget of the first round of successive halving.
+  size_t MinBudget() const { return minBudget; }
+  //! Modify the budget of the first round of successive halving.
+  size_t& MinBudget() { return minBudget; }
+
+  //! Get the budget of the last round of successive halving (0 means no
+  //! successive halving).
+  size_t MaxBudget() const { return maxBudget; }
+  //! Modify the budget of the last round of successive halving (0 means no
+  //! successive halving).
+  size_t& MaxBudget() { return maxBudget; }
+
+  //! Get the factor of the budget between two rounds.
+  double Eta() const { return eta; }
+  //! Modify the factor of the budget between two rounds.
+  double& Eta() { return eta; }
+
+  //! Get the stride of the coarse level of the coarse-to-fine search.
+  size_t RefinementStride() const { return refinementStride; }
+  //! Modify the stride of the coarse level of the coarse-to-fine search.
+  size_t& RefinementStride() { return refinementStride; }
+
+  //! Get the number of best points refined at each level.
+  size_t RefinementCells() const { return refinementCells; }
+  //! Modify the number of best points refined at each level.
+  size_t& RefinementCells() { return refinementCells; }
+
+  //! Get which dimensions have ordered categories in the coarse-to-fine search
+  //! (empty means all of them).
+  const std::vector<bool>& OrderedDimensions() const
+  { return orderedDimensions; }
+  //! Modify which dimensions have ordered categories in the coarse-to-fine
+  //! search (empty means all of them).
+  std::vector<bool>& OrderedDimensions() { return orderedDimensions; }
+
  private:
   /**
    * Iterate through the last (parameterValueCollections.size() - i) dimensions
    * of the grid and change the arguments bestObjective and bestParameters if
    * there is something better. The values for the first i dimensions
    * (parameters) are specified in the first i rows of the currentParameters
-   * argument.
+   * argument.  If the function has an EvaluateDelta() method, currentObjective
+   * holds the objective at currentParameters and is updated with each change
+   * of a parameter; otherwise it is unused.
    */
   template<typename FunctionType, typename MatType>
   void Optimize(
@@ -60,9 +164,115 @@ class GridSearch
       typename MatType::elem_type& bestObjective,
       MatType& bestParameters,
       MatType& currentParameters,
+      typename MatType::elem_type& currentObjective,
       const std::vector<bool>& categoricalDimensions,
       const arma::Row<size_t>& numCategories,
       size_t i);
+
+  /**
+   * Evaluate the given grid points (indices in the order of the grid), on
+   * several threads if `parallel` is true.  If UseBudget is true, the points
+   * are evaluated with EvaluateWithBudget() and the given budget.
+   */
+  template<bool UseBudget, typename FunctionType, typename MatType>
+  void EvaluatePoints(
+      FunctionType& function,
+      const std::vector<size_t>& points,
+      const arma::Row<size_t>& numCategories,
+      const size_t budget,
+      std::vector<typename MatType::elem_type>& objectives) const;
+
+  /**
+   * Evaluate every grid point (with successive halving if UseBudget is true),
+   * and store the best one into bestParameters.
+   */
+  template<bool UseBudget, typename FunctionType, typename MatType>
+  typename MatType::elem_type OptimizePoints(
+      FunctionType& function,
+      MatType& bestParameters,
+      const arma::Row<size_t>& numCategories) const;
+
+  /**
+   * Search the grid coarse-to-fine, evaluating each level with
+   * EvaluatePoints(), and store the best point found into bestParameters.
+   */
+  template<typename FunctionType, typename MatType>
+  typename MatType::elem_type OptimizeRefined(
+      FunctionType& function,
+      MatType& bestParameters,
+      const arma::Row<size_t>& numCategories) const;
+
+  //! Store the grid point of the given index into `parameters`; the last
+  //! dimension varies fastest, as in the recursive search.
+  template<typename MatType>
+  static void GridPoint(size_t index,
+                        const arma::Row<size_t>& numCategories,
+                        MatType& parameters)
+  {
+    for (size_t d = numCategories.n_elem; d > 0; --d)
+    {
+      parameters(d - 1) = index % numCategories(d - 1);
+      index /= numCategories(d - 1);
+    }
+  }
+
+  //! Append to `points` the indices of the grid points whose value in each
+  //! dimension d is one of values[d].
+  static void AppendProduct(const std::vector<std::vector<size_t>>& values,
+                            const arma::Row<size_t>& numCategories,
+                            std::vector<size_t>& points)
+  {
+    std::vector<size_t> position(values.size(), 0);
+    while (true)
+    {
+      size_t index = 0;
+      for (size_t d = 0; d < values.size(); ++d)
+        index = index * numCategories(d) + values[d][position[d]];
+      points.push_back(index);
+
+      // Move to the next combination; the last dimension varies fastest.
+      size_t d = values.size();
+      while (d > 0 && ++position[d - 1] == values[d - 1].size())
+        position[--d] = 0;
+      if (d == 0)
+        break;
+    }
+  }
+
+  //! Evaluate a grid point with the given budget.
+  template<typename FunctionType, typename MatType>
+  static typename MatType::elem_type EvaluatePoint(FunctionType& function,
+                                                   const MatType& point,
+                                                   const size_t budget,
+                                                   const std::true_type)
+  {
+    return function.EvaluateWithBudget(point, budget);
+  }
+
+  //! Evaluate a grid point in full.
+  template<typename FunctionType, typename MatType>
+  static typename MatType::elem_type EvaluatePoint(FunctionType& function,
+                                                   const MatType& point,
+                                                   const size_t /* budget */,
+                                                   const std::false_type)
+  {
+    return function.Evaluate(point);
+  }
+
+  //! Whether the grid points are evaluated in parallel.
+  bool parallel;
+  //! The budget of the first round of successive halving.
+  size_t minBudget;
+  //! The budget of the last round of successive halving.
+  size_t maxBudget;
+  //! The factor of the budget between two rounds.
+  double eta;
+  //! The stride of the coarse level of the coarse-to-fine search.
+  size_t refinementStride;
+  //! The number of best points refined at each level.
+  size_t refinementCells;
+  //! Which dimensions have ordered categories (empty means all).
+  std::vector<bool> orderedDimensions;
 };
 
 } // namespace ens
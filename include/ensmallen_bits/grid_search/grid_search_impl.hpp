@@ -12,8 +12,12 @@
 #ifndef ENSMALLEN_GRID_SEARCH_GRID_SEARCH_IMPL_HPP
 #define ENSMALLEN_GRID_SEARCH_GRID_SEARCH_IMPL_HPP
 
+#include <algorithm>
 #include <limits>
+#include <map>
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/evaluate_delta.hpp>
+#include <ensmallen_bits/utility/parallel_batch.hpp>
 
 namespace ens {
 
@@ -37,11 +41,64 @@ typename MatType::elem_type GridSearch::Optimize(
 
   // Convenience typedefs.
   typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  const bool useBudget = (maxBudget > 0) &&
+      traits::HasEvaluateWithBudgetSignature<FunctionType, BaseMatType>::value;
+  if (useBudget && (minBudget == 0 || minBudget > maxBudget))
+  {
+    throw std::invalid_argument("GridSearch::Optimize(): minBudget must be "
+        "positive and at most maxBudget");
+  }
+  if (useBudget && eta <= 1.0)
+  {
+    throw std::invalid_argument("GridSearch::Optimize(): eta must be greater "
+        "than 1");
+  }
+
+  if (refinementStride > 1)
+  {
+    if (useBudget)
+    {
+      throw std::invalid_argument("GridSearch::Optimize(): the coarse-to-fine "
+          "search can't be combined with successive halving");
+    }
+    if (!orderedDimensions.empty() &&
+        orderedDimensions.size() != numCategories.n_elem)
+    {
+      throw std::invalid_argument("GridSearch::Optimize(): OrderedDimensions() "
+          "must be empty or have one element per dimension");
+    }
+
+    return OptimizeRefined(function, bestParameters, numCategories);
+  }
+
+  // The grid points are enumerated explicitly for successive halving and for
+  // parallel evaluation.
+  if (useBudget)
+  {
+    return OptimizePoints<traits::HasEvaluateWithBudgetSignature<
+        FunctionType, BaseMatType>::value>(function, bestParameters,
+        numCategories);
+  }
+  else if (parallel)
+  {
+    return OptimizePoints<false>(function, bestParameters, numCategories);
+  }
 
   ElemType bestObjective = std::numeric_limits<ElemType>::max();
   bestParameters.set_size(categoricalDimensions.size(), 1);
   MatType currentParameters(categoricalDimensions.size(), 1);
 
+  // If the objective can be updated incrementally, it is evaluated once at
+  // the first grid point, and then updated for each change of a parameter.
+  ElemType currentObjective = 0;
+  if (traits::HasEvaluateDeltaSignature<FunctionType, BaseMatType>::value)
+  {
+    currentParameters.zeros();
+    currentObjective = function.Evaluate((BaseMatType&) currentParameters);
+  }
+
   /* Initialize best parameters for the case (very unlikely though) when no set
    * of parameters gives an objective value better than
    * std::numeric_limits<double>::max() */
@@ -49,7 +106,7 @@ typename MatType::elem_type GridSearch::Optimize(
     bestParameters(i, 0) = 0;
 
   Optimize(function, bestObjective, bestParameters, currentParameters,
-      categoricalDimensions, numCategories, 0);
+      currentObjective, categoricalDimensions, numCategories, 0);
 
   return bestObjective;
 }
@@ -60,6 +117,7 @@ void GridSearch::Optimize(
     typename MatType::elem_type& bestObjective,
     MatType& bestParameters,
     MatType& currentParameters,
+    typename MatType::elem_type& currentObjective,
     const std::vector<bool>& categoricalDimensions,
     const arma::Row<size_t>& numCategories,
     size_t i)
@@ -72,18 +130,32 @@ void GridSearch::Optimize(
   // type are needed.
   traits::CheckArbitraryFunctionTypeAPI<FunctionType, BaseMatType>();
 
+  const bool useDelta =
+      traits::HasEvaluateDeltaSignature<FunctionType, BaseMatType>::value;
+
   if (i < categoricalDimensions.size())
   {
     for (size_t j = 0; j < numCategories(i); ++j)
     {
-      currentParameters(i) = j;
+      if (useDelta && currentParameters(i) != ElemType(j))
+      {
+        currentObjective = EvaluateMove(function,
+            (BaseMatType&) currentParameters, i, ElemType(j),
+            currentObjective);
+      }
+      else
+      {
+        currentParameters(i) = j;
+      }
+
       Optimize(function, bestObjective, bestParameters, currentParameters,
-          categoricalDimensions, numCategories, i + 1);
+          currentObjective, categoricalDimensions, numCategories, i + 1);
     }
   }
   else
   {
-    ElemType objective = function.Evaluate((BaseMatType&) currentParameters);
+    const ElemType objective = useDelta ? currentObjective :
+        function.Evaluate((BaseMatType&) currentParameters);
     if (objective < bestObjective)
     {
       bestObjective = objective;
@@ -92,6 +164,233 @@ void GridSearch::Optimize(
   }
 }
 
+template<bool UseBudget, typename FunctionType, typename MatType>
+void GridSearch::EvaluatePoints(
+    FunctionType& function,
+    const std::vector<size_t>& points,
+    const arma::Row<size_t>& numCategories,
+    const size_t budget,
+    std::vector<typename MatType::elem_type>& objectives) const
+{
+  objectives.resize(points.size());
+
+  // Each range of points uses its own parameters.
+  const size_t numRanges = parallel ?
+      std::max(std::min(MaxThreads(), points.size()), (size_t) 1) : 1;
+  const size_t rangeSize = (points.size() + numRanges - 1) / numRanges;
+
+  ParallelFor(numRanges, [&](const size_t r)
+  {
+    MatType parameters(numCategories.n_elem, 1);
+    const size_t rangeBegin = std::min((size_t) r * rangeSize, points.size());
+    const size_t rangeEnd = std::min(rangeBegin + rangeSize, points.size());
+    for (size_t i = rangeBegin; i < rangeEnd; ++i)
+    {
+      GridPoint(points[i], numCategories, parameters);
+      objectives[i] = EvaluatePoint(function, parameters, budget,
+          std::integral_constant<bool, UseBudget>());
+    }
+  });
+}
+
+template<bool UseBudget, typename FunctionType, typename MatType>
+typename MatType::elem_type GridSearch::OptimizePoints(
+    FunctionType& function,
+    MatType& bestParameters,
+    const arma::Row<size_t>& numCategories) const
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  traits::CheckArbitraryFunctionTypeAPI<FunctionType, BaseMatType>();
+
+  size_t numPoints = 1;
+  for (size_t i = 0; i < numCategories.n_elem; ++i)
+    numPoints *= numCategories(i);
+
+  if (numPoints == 0)
+  {
+    bestParameters.zeros(numCategories.n_elem, 1);
+    return std::numeric_limits<ElemType>::max();
+  }
+
+  std::vector<size_t> points(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+    points[i] = i;
+
+  std::vector<ElemType> objectives;
+  size_t budget = UseBudget ? minBudget : 0;
+  while (true)
+  {
+    // A single remaining point only needs to be evaluated in full.
+    if (UseBudget && points.size() == 1)
+      budget = maxBudget;
+
+    EvaluatePoints<UseBudget, FunctionType, BaseMatType>(function, points,
+        numCategories, budget, objectives);
+    if (!UseBudget || budget >= maxBudget)
+      break;
+
+    // Keep the best 1 / eta of the points; of equal objectives, the first
+    // point of the grid is kept.
+    std::vector<size_t> order(points.size());
+    for (size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    const size_t numKept = std::max((size_t) (points.size() / eta),
+        (size_t) 1);
+    std::stable_sort(order.begin(), order.end(),
+        [&objectives](const size_t a, const size_t b)
+        { return objectives[a] < objectives[b]; });
+
+    std::vector<size_t> kept(numKept);
+    for (size_t i = 0; i < numKept; ++i)
+      kept[i] = points[order[i]];
+    std::sort(kept.begin(), kept.end());
+    points.swap(kept);
+
+    budget = std::min(std::max((size_t) std::ceil(budget * eta), budget + 1),
+        maxBudget);
+  }
+
+  // Take the first of the best points, in the order of the grid.
+  size_t best = 0;
+  for (size_t i = 1; i < points.size(); ++i)
+  {
+    if (objectives[i] < objectives[best])
+      best = i;
+  }
+
+  bestParameters.set_size(numCategories.n_elem, 1);
+  GridPoint(points[best], numCategories, bestParameters);
+  return objectives[best];
+}
+
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type GridSearch::OptimizeRefined(
+    FunctionType& function,
+    MatType& bestParameters,
+    const arma::Row<size_t>& numCategories) const
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  traits::CheckArbitraryFunctionTypeAPI<FunctionType, BaseMatType>();
+
+  // The points are identified by their index in the grid, so the grid may be
+  // very large, but its size must still fit into a size_t.
+  const size_t dims = numCategories.n_elem;
+  for (size_t d = 0, numPoints = 1; d < dims; ++d)
+  {
+    if (numCategories(d) == 0)
+    {
+      bestParameters.zeros(dims, 1);
+      return std::numeric_limits<ElemType>::max();
+    }
+    if (numPoints > std::numeric_limits<size_t>::max() / numCategories(d))
+    {
+      throw std::invalid_argument("GridSearch::Optimize(): the grid has too "
+          "many points");
+    }
+    numPoints *= numCategories(d);
+  }
+
+  // The coarse level takes every refinementStride-th category (and the last
+  // one) of the ordered dimensions, and every category of the others.
+  std::vector<std::vector<size_t>> values(dims);
+  for (size_t d = 0; d < dims; ++d)
+  {
+    const size_t stride = (orderedDimensions.empty() || orderedDimensions[d]) ?
+        refinementStride : 1;
+    for (size_t v = 0; v < numCategories(d); v += stride)
+      values[d].push_back(v);
+    if (values[d].back() != numCategories(d) - 1)
+      values[d].push_back(numCategories(d) - 1);
+  }
+
+  std::vector<size_t> points;
+  AppendProduct(values, numCategories, points);
+
+  // The objectives of all the points evaluated so far, in the order of the
+  // grid.
+  std::map<size_t, ElemType> evaluated;
+  std::vector<ElemType> objectives;
+  std::vector<std::pair<ElemType, size_t>> ranking;
+  arma::Col<size_t> cell(dims);
+  size_t stride = refinementStride;
+  while (true)
+  {
+    // Only evaluate each point once, even if it neighbours several cells or
+    // was evaluated in a previous level.
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    points.erase(std::remove_if(points.begin(), points.end(),
+        [&evaluated](const size_t p) { return evaluated.count(p) > 0; }),
+        points.end());
+
+    EvaluatePoints<false, FunctionType, BaseMatType>(function, points,
+        numCategories, 0, objectives);
+    for (size_t i = 0; i < points.size(); ++i)
+      evaluated[points[i]] = objectives[i];
+
+    if (stride <= 1)
+      break;
+    stride = (stride + 1) / 2;
+
+    // Rank the points by objective, and of equal objectives by their order in
+    // the grid; points with a NaN objective come last.
+    ranking.clear();
+    for (typename std::map<size_t, ElemType>::const_iterator it =
+        evaluated.begin(); it != evaluated.end(); ++it)
+    {
+      const ElemType objective = (it->second != it->second) ?
+          std::numeric_limits<ElemType>::max() : it->second;
+      ranking.push_back(std::make_pair(objective, it->first));
+    }
+    const size_t numCells = std::min(std::max(refinementCells, (size_t) 1),
+        ranking.size());
+    std::partial_sort(ranking.begin(), ranking.begin() + numCells,
+        ranking.end());
+
+    // The next level takes the neighbours at the new stride of the best
+    // points in the ordered dimensions.
+    points.clear();
+    for (size_t c = 0; c < numCells; ++c)
+    {
+      GridPoint(ranking[c].second, numCategories, cell);
+      for (size_t d = 0; d < dims; ++d)
+      {
+        values[d].clear();
+        const bool ordered = orderedDimensions.empty() || orderedDimensions[d];
+        if (ordered && cell(d) >= stride)
+          values[d].push_back(cell(d) - stride);
+        values[d].push_back(cell(d));
+        if (ordered && cell(d) + stride < numCategories(d))
+          values[d].push_back(cell(d) + stride);
+      }
+      AppendProduct(values, numCategories, points);
+    }
+  }
+
+  // Take the first of the best points, in the order of the grid.
+  ElemType bestObjective = std::numeric_limits<ElemType>::max();
+  size_t best = evaluated.begin()->first;
+  for (typename std::map<size_t, ElemType>::const_iterator it =
+      evaluated.begin(); it != evaluated.end(); ++it)
+  {
+    if (it->second < bestObjective)
+    {
+      bestObjective = it->second;
+      best = it->first;
+    }
+  }
+
+  bestParameters.set_size(dims, 1);
+  GridPoint(best, numCategories, bestParameters);
+  return bestObjective;
+}
+
 } // namespace ens
 
 #endif
@@ -0,0 +1,108 @@
+/**
+ * @file instantiations.hpp
+ *
+ * Explicit instantiations of the SGD update policies and the L-BFGS helpers
+ * that don't depend on the function type, for arma::mat and arma::fmat.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+// There is no include guard: the headers in include/ensmallen/ include this
+// file after their optimizer, so each section below is guarded separately, and
+// only used once the optimizer that it needs has been included.
+
+/**
+ * The Optimize() methods are templates over the type of the function, so they
+ * are always compiled in the translation units that call them.  But the update
+ * policies of SGD and the search direction and history updates of L-BFGS only
+ * depend on the matrix types, and these are compiled once in the
+ * ensmallen_instantiations library (built with the CMake option
+ * BUILD_INSTANTIATIONS).  Programs that link with that library get
+ * ENS_USE_INSTANTIATIONS defined, so the declarations below are `extern
+ * template`, which tells the compiler not to instantiate them again; the
+ * library itself defines ENS_INSTANTIATE, which turns them into explicit
+ * instantiations.  Without either macro, nothing changes.
+ *
+ * These parts are small, so the library only saves a small part of the
+ * compile time of a program; the Optimize() methods, where most of it goes,
+ * can't be precompiled without knowing the function type.
+ */
+#if defined(ENS_INSTANTIATE)
+  #define ENS_EXTERN_TEMPLATE template
+#elif defined(ENS_USE_INSTANTIATIONS)
+  #define ENS_EXTERN_TEMPLATE extern template
+#endif
+
+#ifdef ENS_EXTERN_TEMPLATE
+
+// SGD update policies.
+#if defined(ENSMALLEN_SGD_SGD_HPP) && \
+    !defined(ENSMALLEN_INSTANTIATIONS_SGD_HPP)
+#define ENSMALLEN_INSTANTIATIONS_SGD_HPP
+
+namespace ens {
+
+ENS_EXTERN_TEMPLATE class VanillaUpdate::Policy<arma::mat, arma::mat>;
+ENS_EXTERN_TEMPLATE class VanillaUpdate::Policy<arma::fmat, arma::fmat>;
+ENS_EXTERN_TEMPLATE class MomentumUpdate::Policy<arma::mat, arma::mat>;
+ENS_EXTERN_TEMPLATE class MomentumUpdate::Policy<arma::fmat, arma::fmat>;
+
+} // namespace ens
+
+#endif
+
+#if defined(ENSMALLEN_ADAM_ADAM_UPDATE_HPP) && \
+    !defined(ENSMALLEN_INSTANTIATIONS_ADAM_HPP)
+#define ENSMALLEN_INSTANTIATIONS_ADAM_HPP
+
+namespace ens {
+
+ENS_EXTERN_TEMPLATE class AdamUpdate::Policy<arma::mat, arma::mat>;
+ENS_EXTERN_TEMPLATE class AdamUpdate::Policy<arma::fmat, arma::fmat>;
+
+} // namespace ens
+
+#endif
+
+#if defined(ENSMALLEN_LBFGS_LBFGS_HPP) && \
+    !defined(ENSMALLEN_INSTANTIATIONS_LBFGS_HPP)
+#define ENSMALLEN_INSTANTIATIONS_LBFGS_HPP
+
+namespace ens {
+
+// L-BFGS, with a history in the precision of the iterate, or in float (see
+// L_BFGS::FloatHistory()).
+ENS_EXTERN_TEMPLATE double L_BFGS::ChooseScalingFactor<arma::mat, double>(
+    const size_t, const arma::mat&, const arma::mat&);
+ENS_EXTERN_TEMPLATE double L_BFGS::ChooseScalingFactor<arma::fmat, float>(
+    const size_t, const arma::fmat&, const arma::fmat&);
+
+ENS_EXTERN_TEMPLATE void L_BFGS::SearchDirection<arma::mat, arma::mat>(
+    const arma::mat&, const size_t, const double, const arma::mat&,
+    const arma::mat&, arma::mat&);
+ENS_EXTERN_TEMPLATE void L_BFGS::SearchDirection<arma::mat, arma::fmat>(
+    const arma::mat&, const size_t, const double, const arma::fmat&,
+    const arma::mat&, arma::mat&);
+ENS_EXTERN_TEMPLATE void L_BFGS::SearchDirection<arma::fmat, arma::fmat>(
+    const arma::fmat&, const size_t, const double, const arma::fmat&,
+    const arma::fmat&, arma::fmat&);
+
+ENS_EXTERN_TEMPLATE void L_BFGS::UpdateBasisSet<arma::mat, arma::mat,
+    arma::mat>(const size_t, const arma::mat&, const arma::mat&,
+    const arma::mat&, const arma::mat&, arma::mat&, arma::mat&);
+ENS_EXTERN_TEMPLATE void L_BFGS::UpdateBasisSet<arma::mat, arma::mat,
+    arma::fmat>(const size_t, const arma::mat&, const arma::mat&,
+    const arma::mat&, const arma::mat&, arma::fmat&, arma::mat&);
+ENS_EXTERN_TEMPLATE void L_BFGS::UpdateBasisSet<arma::fmat, arma::fmat,
+    arma::fmat>(const size_t, const arma::fmat&, const arma::fmat&,
+    const arma::fmat&, const arma::fmat&, arma::fmat&, arma::fmat&);
+
+} // namespace ens
+
+#endif
+
+#undef ENS_EXTERN_TEMPLATE
+
+#endif
@@ -14,6 +14,8 @@
 #ifndef ENSMALLEN_IQN_IQN_HPP
 #define ENSMALLEN_IQN_IQN_HPP
 
+#include "limited_memory_hessian.hpp"
+
 namespace ens {
 
 /**
@@ -46,6 +48,13 @@ namespace ens {
  * IQN can optimize differentiable separable functions.  For more details, see
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * By default, IQN stores a dense d x d Hessian approximation for every batch,
+ * and inverts their average in every step, which limits it to small problems.
+ * If Memory() is set to m > 0, each approximation is instead represented by its
+ * last m curvature pairs, and the inverse of the average is updated with the
+ * Sherman-Morrison-Woodbury formula; see IQNLimitedMemoryHessian.  This needs
+ * O(d m) memory per batch and O(d^2 m) time per step.
  */
 class IQN
 {
@@ -63,11 +72,14 @@ class IQN
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param memory Number of curvature pairs to store per batch (0 means that
+   *     a dense Hessian approximation is stored).
    */
   IQN(const double stepSize = 0.01,
       const size_t batchSize = 10,
       const size_t maxIterations = 100000,
-      const double tolerance = 1e-5);
+      const double tolerance = 1e-5,
+      const size_t memory = 0);
 
   /**
    * Optimize the given function using IQN. The given starting point will be
@@ -126,6 +138,11 @@ class IQN
   //! Modify the tolerance for termination.
   double& Tolerance() { return tolerance; }
 
+  //! Get the number of curvature pairs stored per batch (0 indicates dense).
+  size_t Memory() const { return memory; }
+  //! Modify the number of curvature pairs stored per batch (0 indicates dense).
+  size_t& Memory() { return memory; }
+
  private:
   //! The step size for each example.
   double stepSize;
@@ -138,6 +155,9 @@ class IQN
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The number of curvature pairs stored per batch.
+  size_t memory;
 };
 
 } // namespace ens
@@ -24,11 +24,13 @@ namespace ens {
 inline IQN::IQN(const double stepSize,
                 const size_t batchSize,
                 const size_t maxIterations,
-                const double tolerance) :
+                const double tolerance,
+                const size_t memory) :
     stepSize(stepSize),
     batchSize(batchSize),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    memory(memory)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -79,12 +81,20 @@ IQN::Optimize(SeparableFunctionType& functionIn,
       iterate.n_cols));
   std::vector<BaseMatType> t(numBatches, BaseMatType(iterate.n_rows,
       iterate.n_cols));
-  std::vector<BaseMatType> Q(numBatches, BaseMatType(iterate.n_elem,
-      iterate.n_elem));
   BaseMatType initialIterate = arma::randn<arma::Mat<ElemType>>(iterate.n_rows,
       iterate.n_cols);
-  BaseGradType B(iterate.n_elem, iterate.n_elem);
-  B.eye();
+
+  // The dense Hessian approximations are only used if memory is 0.
+  const bool dense = (memory == 0);
+  std::vector<BaseMatType> Q(dense ? numBatches : 0,
+      BaseMatType(iterate.n_elem, iterate.n_elem));
+  BaseGradType B;
+  if (dense)
+    B.eye(iterate.n_elem, iterate.n_elem);
+
+  IQNLimitedMemoryHessian<ElemType> hessian(dense ? 0 : numBatches,
+      dense ? 0 : iterate.n_elem, memory);
+  arma::Col<ElemType> productOld, productNew;
 
   BaseGradType g(iterate.n_rows, iterate.n_cols);
   g.zeros();
@@ -101,7 +111,8 @@ IQN::Optimize(SeparableFunctionType& functionIn,
     terminate |= Callback::Gradient(*this, function, initialIterate,
         y[f], callbacks...);
 
-    Q[f].eye();
+    if (dense)
+      Q[f].eye();
     g += y[f];
     y[f] /= (double) effectiveBatchSize;
 
@@ -137,28 +148,53 @@ IQN::Optimize(SeparableFunctionType& functionIn,
         const BaseMatType s = arma::vectorise(iterate - t[it]);
         const BaseGradType yy = arma::vectorise(gradient - y[it]);
 
-        const BaseGradType stochasticHessian = Q[it] + yy * yy.t() /
-            arma::as_scalar(yy.t() * s) - Q[it] * s * s.t() *
-            Q[it] / arma::as_scalar(s.t() * Q[it] * s);
-
-        // Update aggregate Hessian approximation.
-        B += (1.0 / numBatches) * (stochasticHessian - Q[it]);
-
-        // Update aggregate Hessian-variable product.
-        u += arma::reshape((1.0 / numBatches) * (stochasticHessian *
-            arma::vectorise(iterate) - Q[it] * arma::vectorise(t[it])),
-            u.n_rows, u.n_cols);;
+        if (dense)
+        {
+          const BaseGradType stochasticHessian = Q[it] + yy * yy.t() /
+              arma::as_scalar(yy.t() * s) - Q[it] * s * s.t() *
+              Q[it] / arma::as_scalar(s.t() * Q[it] * s);
+
+          // Update aggregate Hessian approximation.
+          B += (1.0 / numBatches) * (stochasticHessian - Q[it]);
+
+          // Update aggregate Hessian-variable product.
+          u += arma::reshape((1.0 / numBatches) * (stochasticHessian *
+              arma::vectorise(iterate) - Q[it] * arma::vectorise(t[it])),
+              u.n_rows, u.n_cols);;
+
+          Q[it] = std::move(stochasticHessian);
+        }
+        else
+        {
+          // Replace the oldest curvature pair of this batch, which also
+          // updates the inverse of the aggregate Hessian approximation, and
+          // update the aggregate Hessian-variable product.
+          hessian.Multiply(it, arma::vectorise(t[it]), productOld);
+          hessian.Update(it, s, yy);
+          hessian.Multiply(it, arma::vectorise(iterate), productNew);
+          u += arma::reshape((1.0 / numBatches) * (productNew - productOld),
+              u.n_rows, u.n_cols);
+        }
 
         // Update aggregate gradient.
         g += (1.0 / numBatches) * (gradient - y[it]);
 
         // Update the function information tables.
-        Q[it] = std::move(stochasticHessian);
         y[it] = std::move(gradient);
         t[it] = iterate;
 
-        iterate = arma::reshape(stepSize * B.i() * (u.t() - arma::vectorise(g)),
-            iterate.n_rows, iterate.n_cols) + (1 - stepSize) * iterate;
+        if (dense)
+        {
+          iterate = arma::reshape(stepSize * B.i() * (u.t() -
+              arma::vectorise(g)), iterate.n_rows, iterate.n_cols) +
+              (1 - stepSize) * iterate;
+        }
+        else
+        {
+          iterate = arma::reshape(stepSize * hessian.Inverse() *
+              (arma::vectorise(u) - arma::vectorise(g)), iterate.n_rows,
+              iterate.n_cols) + (1 - stepSize) * iterate;
+        }
 
         terminate |= Callback::StepTaken(*this, function, iterate,
             callbacks...);
@@ -167,6 +203,11 @@ IQN::Optimize(SeparableFunctionType& functionIn,
       f += effectiveBatchSize;
     }
 
+    // Recompute the inverse of the aggregate Hessian approximation once per
+    // pass, so that round-off errors of the updates do not accumulate.
+    if (!dense)
+      hessian.Refresh();
+
     overallObjective = 0;
     for (size_t f = 0; f < numFunctions; f += batchSize)
     {
@@ -0,0 +1,199 @@
+/**
+ * @file limited_memory_hessian.hpp
+ *
+ * Limited-memory storage of the per-batch Hessian approximations of IQN, and
+ * of the inverse of their average.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_IQN_LIMITED_MEMORY_HESSIAN_HPP
+#define ENSMALLEN_IQN_LIMITED_MEMORY_HESSIAN_HPP
+
+namespace ens {
+
+/**
+ * Store the Hessian approximation Q_i of each batch by its last m curvature
+ * pairs (s, y), in the compact form of Byrd, Nocedal and Schnabel:
+ *
+ * \f[
+ * Q_i = I - W_i N_i^{-1} W_i^T, \quad W_i = [S_i, Y_i], \quad
+ * N_i = \left[ \begin{array}{cc} S_i^T S_i & L_i \\ L_i^T & -D_i
+ * \end{array} \right]
+ * \f]
+ *
+ * where L_i is the strictly lower triangular part of S_i^T Y_i and D_i its
+ * diagonal.  With unlimited memory this is the same matrix as the one obtained
+ * by the BFGS updates of IQN from the identity.
+ *
+ * When the pairs of a batch change, the average B = (1 / n) sum_i Q_i changes
+ * by a matrix of rank at most 4m, so the inverse of B is updated with the
+ * Sherman-Morrison-Woodbury formula in O(d^2 m) time instead of being
+ * recomputed.  This needs O(d m) memory per batch and one d x d matrix.
+ *
+ * @tparam ElemType Type of the elements of the iterate.
+ */
+template<typename ElemType>
+class IQNLimitedMemoryHessian
+{
+ public:
+  typedef arma::Mat<ElemType> MatType;
+  typedef arma::Col<ElemType> ColType;
+
+  /**
+   * Initialize every Hessian approximation to the identity.
+   *
+   * @param numBatches Number of batches.
+   * @param dimensionality Number of elements of the iterate.
+   * @param memory Number of curvature pairs to keep per batch.
+   */
+  IQNLimitedMemoryHessian(const size_t numBatches,
+                          const size_t dimensionality,
+                          const size_t memory) :
+      s(numBatches),
+      y(numBatches),
+      inverse(dimensionality, dimensionality, arma::fill::eye),
+      memory(memory)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Add the curvature pair (sNew, yNew) to the given batch, dropping its
+   * oldest pair if the memory is full, and update the inverse of the average
+   * Hessian approximation.  Pairs without positive curvature are ignored, so
+   * that every Q_i stays positive definite.
+   *
+   * @param batch Index of the batch.
+   * @param sNew Change of the iterate.
+   * @param yNew Change of the (averaged) gradient of the batch.
+   */
+  void Update(const size_t batch, const ColType& sNew, const ColType& yNew)
+  {
+    const ElemType curvature = arma::dot(sNew, yNew);
+    if (!(curvature > std::numeric_limits<ElemType>::epsilon() *
+        arma::norm(sNew) * arma::norm(yNew)))
+    {
+      return;
+    }
+
+    // W and N of the old approximation.
+    MatType oldW, oldN;
+    Factor(batch, oldW, oldN);
+
+    if (s[batch].n_cols == 0)
+    {
+      s[batch] = sNew;
+      y[batch] = yNew;
+    }
+    else
+    {
+      if (s[batch].n_cols == memory)
+      {
+        s[batch].shed_col(0);
+        y[batch].shed_col(0);
+      }
+      s[batch].insert_cols(s[batch].n_cols, sNew);
+      y[batch].insert_cols(y[batch].n_cols, yNew);
+    }
+
+    MatType newW, newN;
+    Factor(batch, newW, newN);
+
+    // B changes by U C U^T with U = [oldW, newW] and
+    // C = (1 / n) diag(oldN^{-1}, -newN^{-1}), so
+    // B^{-1} changes by -B^{-1} U (C^{-1} + U^T B^{-1} U)^{-1} U^T B^{-1}.
+    const MatType U = arma::join_rows(oldW, newW);
+    const MatType inverseU = inverse * U;
+
+    const ElemType numBatches = s.size();
+    const size_t k = oldN.n_rows;
+    MatType K = U.t() * inverseU;
+    if (k > 0)
+      K.submat(0, 0, k - 1, k - 1) += numBatches * oldN;
+    K.submat(k, k, K.n_rows - 1, K.n_cols - 1) -= numBatches * newN;
+
+    MatType correction;
+    if (!arma::solve(correction, K, inverseU.t()))
+      return;
+
+    inverse -= inverseU * correction;
+  }
+
+  /**
+   * Store Q_i v in `out`.
+   *
+   * @param batch Index of the batch.
+   * @param v Vector to multiply.
+   * @param out Vector to store the result into.
+   */
+  void Multiply(const size_t batch, const ColType& v, ColType& out) const
+  {
+    out = v;
+    if (s[batch].n_cols == 0)
+      return;
+
+    MatType W, N;
+    Factor(batch, W, N);
+    out -= W * arma::solve(N, W.t() * v);
+  }
+
+  /**
+   * Recompute the inverse of the average Hessian approximation from the stored
+   * pairs, to remove the round-off errors accumulated by the updates.
+   */
+  void Refresh()
+  {
+    MatType average(inverse.n_rows, inverse.n_cols, arma::fill::eye);
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+      if (s[i].n_cols == 0)
+        continue;
+
+      MatType W, N;
+      Factor(i, W, N);
+      average -= (W * arma::solve(N, W.t())) / (ElemType) s.size();
+    }
+
+    // Remove the asymmetry that accumulates from round-off errors.
+    average = 0.5 * (average + average.t());
+    MatType newInverse;
+    if (arma::inv_sympd(newInverse, average))
+      inverse = std::move(newInverse);
+  }
+
+  //! Get the inverse of the average Hessian approximation.
+  const MatType& Inverse() const { return inverse; }
+
+ private:
+  //! Compute W and N of the given batch.
+  void Factor(const size_t batch, MatType& W, MatType& N) const
+  {
+    const MatType& S = s[batch];
+    const MatType& Y = y[batch];
+    const MatType SY = S.t() * Y;
+
+    MatType L = arma::trimatl(SY);
+    L.diag().zeros();
+    const MatType D = -arma::diagmat(SY);
+
+    W = arma::join_rows(S, Y);
+    N = arma::join_cols(arma::join_rows(S.t() * S, L),
+                        arma::join_rows(L.t(), D));
+  }
+
+  //! The stored iterate changes of each batch, one per column.
+  std::vector<MatType> s;
+  //! The stored gradient changes of each batch, one per column.
+  std::vector<MatType> y;
+  //! The inverse of the average Hessian approximation.
+  MatType inverse;
+  //! The number of curvature pairs to keep per batch.
+  size_t memory;
+};
+
+} // namespace ens
+
+#endif
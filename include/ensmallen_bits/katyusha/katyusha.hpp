@@ -38,6 +38,35 @@ namespace ens {
  * see the documentation on function types included with this distribution or on
  * the ensmallen website.
  *
+ * If ParallelFullGradient() is set to true (and OpenMP is enabled), the full
+ * objective and the full gradient of each outer iteration are computed by
+ * splitting the functions into contiguous ranges that are evaluated on separate
+ * threads, and then reduced; see ParallelEvaluateWithGradient().  The separable
+ * Evaluate() and Gradient() must then be safe to call concurrently on disjoint
+ * batches.  If DeterministicReduction() is also set, the functions are split
+ * into batches of BatchSize() that are reduced in a fixed order, so results do
+ * not depend on the number of threads.
+ *
+ * If CacheSnapshotGradients() is set to true, the gradient of each batch at
+ * the snapshot is kept when the full gradient is computed, and reused in the
+ * inner loop, which then computes one gradient per step instead of two.  This
+ * needs memory for one gradient per batch.  With shuffling, the functions are
+ * then shuffled once per outer iteration, before the full gradient.
+ *
+ * For dense matrices, each inner step takes two fused passes over the
+ * coordinates: one for the coupled iterate, and one that updates z, y and the
+ * weighted sum of the iterates.  If LazyUpdates() is set to true and the
+ * gradients are sparse (e.g. arma::sp_mat as GradType), the standard
+ * (non-proximal) variant only writes the coordinates where the batch gradient
+ * at the iterate or at the snapshot is nonzero.  Elsewhere, a step is the same
+ * affine map of z, y and the weighted sum of the iterates for every
+ * coordinate, so the steps skipped since a coordinate was last written are
+ * applied at once with powers of that map, the next time it is written (and
+ * for all coordinates at the end of the inner loop).  The iterate is then only
+ * up to date where the snapshot gradient of the current batch is nonzero, so
+ * the Gradient() of a batch may only read those coordinates, as for sparse
+ * linear models; the callbacks also see that partially updated iterate.
+ *
  * @tparam proximal Whether the proximal update should be used or not.
  */
 template<bool Proximal = false>
@@ -152,7 +181,144 @@ class KatyushaType
   //! Modify whether or not the actual objective is calculated.
   bool& ExactObjective() { return exactObjective; }
 
+  //! Get whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool DeterministicReduction() const { return deterministicReduction; }
+  //! Modify whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool& DeterministicReduction() { return deterministicReduction; }
+
+  //! Get whether or not the batch gradients at the snapshot are reused in the
+  //! inner loop.
+  bool CacheSnapshotGradients() const { return cacheSnapshotGradients; }
+  //! Modify whether or not the batch gradients at the snapshot are reused in
+  //! the inner loop.
+  bool& CacheSnapshotGradients() { return cacheSnapshotGradients; }
+
+  //! Get whether or not the coordinates untouched by sparse gradients are
+  //! updated lazily.
+  bool LazyUpdates() const { return lazyUpdates; }
+  //! Modify whether or not the coordinates untouched by sparse gradients are
+  //! updated lazily.
+  bool& LazyUpdates() { return lazyUpdates; }
+
  private:
+  /**
+   * Compute the coupled iterate tau1 * z + tau2 * iterate0 +
+   * (1 - tau1 - tau2) * y; in one pass for dense matrices.
+   */
+  template<typename MatType>
+  static void Couple(MatType& iterate,
+                     const MatType& z,
+                     const MatType& y,
+                     const MatType& iterate0,
+                     const double tau1,
+                     const double tau2,
+                     const std::true_type /* fused */);
+
+  //! Compute the coupled iterate with Armadillo expressions.
+  template<typename MatType>
+  static void Couple(MatType& iterate,
+                     const MatType& z,
+                     const MatType& y,
+                     const MatType& iterate0,
+                     const double tau1,
+                     const double tau2,
+                     const std::false_type /* fused */);
+
+  /**
+   * Take the step of z and y from the variance reduced gradient, and add
+   * the iterate to the weighted sum w; in one pass for dense matrices.
+   */
+  template<typename MatType, typename GradType>
+  void Step(MatType& z,
+            MatType& y,
+            MatType& w,
+            const MatType& iterate,
+            const GradType& fullGradient,
+            const GradType& gradient,
+            const GradType& snapshotGradient,
+            const double tau1,
+            const double alpha,
+            const double cw,
+            const std::true_type /* fused */) const;
+
+  //! Take the step with Armadillo expressions.
+  template<typename MatType, typename GradType>
+  void Step(MatType& z,
+            MatType& y,
+            MatType& w,
+            const MatType& iterate,
+            const GradType& fullGradient,
+            const GradType& gradient,
+            const GradType& snapshotGradient,
+            const double tau1,
+            const double alpha,
+            const double cw,
+            const std::false_type /* fused */) const;
+
+  /**
+   * Run the inner loop of an outer iteration with lazy updates, for sparse
+   * gradients (see LazyUpdates()).  At the end, iterate is the coupled
+   * iterate of the last step, and w is the weighted sum of the iterates.
+   *
+   * @return The number of steps taken.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  size_t LazyInnerLoop(SeparableFunctionType& function,
+                       MatType& iterate,
+                       MatType& z,
+                       MatType& y,
+                       MatType& w,
+                       const MatType& iterate0,
+                       const GradType& fullGradient,
+                       const std::vector<GradType>& snapshotGradients,
+                       GradType& gradient,
+                       GradType& gradient0,
+                       const double tau1,
+                       const double tau2,
+                       const double alpha,
+                       const double r,
+                       bool& terminate,
+                       const std::true_type /* sparse */,
+                       CallbackTypes&... callbacks);
+
+  //! Lazy updates need sparse gradients; this is never called.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  size_t LazyInnerLoop(SeparableFunctionType& /* function */,
+                       MatType& /* iterate */,
+                       MatType& /* z */,
+                       MatType& /* y */,
+                       MatType& /* w */,
+                       const MatType& /* iterate0 */,
+                       const GradType& /* fullGradient */,
+                       const std::vector<GradType>& /* snapshotGradients */,
+                       GradType& /* gradient */,
+                       GradType& /* gradient0 */,
+                       const double /* tau1 */,
+                       const double /* tau2 */,
+                       const double /* alpha */,
+                       const double /* r */,
+                       bool& /* terminate */,
+                       const std::false_type /* sparse */,
+                       CallbackTypes&... /* callbacks */)
+  {
+    return 0;
+  }
+
   //! The convexity regularization term.
   double convexity;
 
@@ -177,6 +343,22 @@ class KatyushaType
 
   //! Controls whether or not the actual Objective value is calculated.
   bool exactObjective;
+
+  //! Controls whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool parallelFullGradient;
+
+  //! Controls whether or not parallel reductions are independent of the number
+  //! of threads.
+  bool deterministicReduction;
+
+  //! Controls whether or not the batch gradients at the snapshot are reused in
+  //! the inner loop.
+  bool cacheSnapshotGradients;
+
+  //! Controls whether or not the coordinates untouched by sparse gradients are
+  //! updated lazily.
+  bool lazyUpdates;
 };
 
 // Convenience typedefs.
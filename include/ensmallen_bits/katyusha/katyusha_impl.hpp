@@ -16,6 +16,7 @@
 #include "katyusha.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/fused_update.hpp>
 
 namespace ens {
 
@@ -36,7 +37,11 @@ KatyushaType<Proximal>::KatyushaType(
     innerIterations(innerIterations),
     tolerance(tolerance),
     shuffle(shuffle),
-    exactObjective(exactObjective)
+    exactObjective(exactObjective),
+    parallelFullGradient(false),
+    deterministicReduction(false),
+    cacheSnapshotGradients(false),
+    lazyUpdates(false)
 { /* Nothing to do. */ }
 
 //! Optimize the function (minimize).
@@ -110,6 +115,13 @@ KatyushaType<Proximal>::Optimize(
   BaseMatType w(iterate.n_rows, iterate.n_cols);
   w.zeros();
 
+  // Per-thread gradient buffers, only used if parallelFullGradient is true.
+  std::vector<BaseGradType> threadGradients;
+
+  // The gradient of each batch at the snapshot, only used if
+  // cacheSnapshotGradients is true.
+  std::vector<BaseGradType> snapshotGradients;
+
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
   terminate |= Callback::BeginOptimization(*this, function, iterate,
@@ -118,14 +130,26 @@ KatyushaType<Proximal>::Optimize(
   {
     // Calculate the objective function.
     overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
+    if (parallelFullGradient)
     {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      const ElemType objective = function.Evaluate(iterate0, f,
-          effectiveBatchSize);
-      overallObjective += objective;
+      overallObjective = ParallelEvaluate(function, iterate0, 0, numFunctions,
+          deterministicReduction, batchSize);
+      Callback::Evaluate(*this, function, iterate0, overallObjective,
+          callbacks...);
+    }
+    else
+    {
+      for (size_t f = 0; f < numFunctions; f += batchSize)
+      {
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - f);
+        const ElemType objective = function.Evaluate(iterate0, f,
+            effectiveBatchSize);
+        overallObjective += objective;
 
-      Callback::Evaluate(*this, function, iterate0, objective, callbacks...);
+        Callback::Evaluate(*this, function, iterate0, objective,
+            callbacks...);
+      }
     }
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
@@ -151,22 +175,46 @@ KatyushaType<Proximal>::Optimize(
 
     // Compute the full gradient.
     size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
-    terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
+    if (cacheSnapshotGradients)
+    {
+      // The inner loop visits the batches in the order of this pass.
+      if (shuffle)
+        function.Shuffle();
+
+      BatchGradients(function, iterate0, batchSize, snapshotGradients,
+          fullGradient, parallelFullGradient);
+      for (size_t b = 0; b < snapshotGradients.size(); ++b)
+      {
+        terminate |= Callback::Gradient(*this, function, iterate0,
+            snapshotGradients[b], callbacks...);
+      }
+    }
+    else if (parallelFullGradient)
+    {
+      ParallelGradient(function, iterate0, 0, fullGradient, numFunctions,
+          threadGradients, deterministicReduction, batchSize);
+      terminate |= Callback::Gradient(*this, function, iterate0, fullGradient,
           callbacks...);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
+    }
+    else
     {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
+      function.Gradient(iterate0, 0, fullGradient, effectiveBatchSize);
+      terminate |= Callback::Gradient(*this, function, iterate0, fullGradient,
+            callbacks...);
+      for (size_t f = effectiveBatchSize; f < numFunctions;
+          /* incrementing done manually */)
+      {
+        // Find the effective batch size (the last batch may be smaller).
+        effectiveBatchSize = std::min(batchSize, numFunctions - f);
 
-      function.Gradient(iterate0, f, gradient, effectiveBatchSize);
-      fullGradient += gradient;
+        function.Gradient(iterate0, f, gradient, effectiveBatchSize);
+        fullGradient += gradient;
 
-      terminate |= Callback::Gradient(*this, function, iterate0, gradient,
-          callbacks...);
+        terminate |= Callback::Gradient(*this, function, iterate0, gradient,
+            callbacks...);
 
-      f += effectiveBatchSize;
+        f += effectiveBatchSize;
+      }
     }
     fullGradient /= (double) numFunctions;
 
@@ -174,68 +222,62 @@ KatyushaType<Proximal>::Optimize(
     double cw = 1;
     w.zeros();
 
-    for (size_t f = 0, currentFunction = 0; f < innerIterations;
-        /* incrementing done manually */)
+    if (lazyUpdates && !Proximal &&
+        UseSparseUpdate<BaseMatType, BaseGradType>::value)
+    {
+      LazyInnerLoop(function, iterate, z, y, w, iterate0, fullGradient,
+          snapshotGradients, gradient, gradient0, tau1, tau2, alpha, r,
+          terminate, UseSparseUpdate<BaseMatType, BaseGradType>(),
+          callbacks...);
+    }
+    else
     {
-      // Is this iteration the start of a sequence?
-      if ((currentFunction % numFunctions) == 0)
+      for (size_t f = 0, currentFunction = 0; f < innerIterations;
+          /* incrementing done manually */)
       {
-        currentFunction = 0;
-
-        // Determine order of visitation.
-        if (shuffle)
-          function.Shuffle();
-      }
-
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
-      iterate = tau1 * z + tau2 * iterate0 + (1 - tau1 - tau2) * y;
-
-      terminate |= Callback::StepTaken(*this, function, iterate,
+        // Is this iteration the start of a sequence?
+        if ((currentFunction % numFunctions) == 0)
+        {
+          currentFunction = 0;
+
+          // Determine order of visitation; the cached snapshot gradients need
+          // the order of the full gradient pass.
+          if (shuffle && !cacheSnapshotGradients)
+            function.Shuffle();
+        }
+
+        // Find the effective batch size (the last batch may be smaller).
+        effectiveBatchSize = std::min(batchSize,
+            numFunctions - currentFunction);
+        Couple(iterate, z, y, iterate0, tau1, tau2,
+            UseFusedUpdate<BaseMatType, BaseMatType>());
+
+        terminate |= Callback::StepTaken(*this, function, iterate,
+              callbacks...);
+
+        // Calculate variance reduced gradient.
+        function.Gradient(iterate, currentFunction, gradient,
+            effectiveBatchSize);
+        terminate |= Callback::Gradient(*this, function, iterate, gradient,
             callbacks...);
 
-      // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
-          effectiveBatchSize);
-      terminate |= Callback::Gradient(*this, function, iterate, gradient,
-          callbacks...);
-
-      function.Gradient(iterate0, currentFunction, gradient0,
-          effectiveBatchSize);
-      terminate |= Callback::Gradient(*this, function, iterate0, gradient0,
-          callbacks...);
-
-      // By the minimality definition of z_{k + 1}, we have that:
-      // z_{k+1} − z_k + \alpha * \sigma_{k+1} + \alpha g = 0.
-      BaseMatType zNew = z - alpha * (fullGradient + (gradient - gradient0) /
-          (double) batchSize);
-
-      // Proximal update, choose between Option I and Option II. Shift relative
-      // to the Lipschitz constant or take a constant step using the given step
-      // size.
-      if (Proximal)
-      {
-        // yk = x0 − 1 / (3L) * \delta1, k = 1
-        // yk = x0 − 1 / (3L) * \delta2 - ((1 - tau) / (3L)) + tau * alpha)
-        // * \delta1, k = 2
-        // yk = x0 − 1 / (3L) * \delta3 - ((1 - tau) / (3L)) + tau * alpha)
-        // * \delta2 - ((1-tau)^2 / (3L) + (1 - (1 - tau)^2) * alpha) * \delta1,
-        // k = 3.
-        y = iterate + 1.0 / (3.0 * lipschitz) * w;
-      }
-      else
-      {
-        y = iterate + tau1 * (zNew - z);
+        if (!cacheSnapshotGradients)
+        {
+          function.Gradient(iterate0, currentFunction, gradient0,
+              effectiveBatchSize);
+          terminate |= Callback::Gradient(*this, function, iterate0,
+              gradient0, callbacks...);
+        }
+        const BaseGradType& snapshotGradient = cacheSnapshotGradients ?
+            snapshotGradients[currentFunction / batchSize] : gradient0;
+
+        Step(z, y, w, iterate, fullGradient, gradient, snapshotGradient, tau1,
+            alpha, cw, UseFusedUpdate<BaseMatType, BaseGradType>());
+        cw *= r;
+
+        currentFunction += effectiveBatchSize;
+        f += effectiveBatchSize;
       }
-
-      z = std::move(zNew);
-
-      // sum_{j=0}^{m-1} 1 + std::min(alpha * convexity, 1 / (4 * m)^j * ys).
-      w += cw * iterate;
-      cw *= r;
-
-      currentFunction += effectiveBatchSize;
-      f += effectiveBatchSize;
     }
     iterate0 = normalizer * w;
   }
@@ -262,6 +304,335 @@ KatyushaType<Proximal>::Optimize(
   return overallObjective;
 }
 
+//! Compute the coupled iterate in one pass.
+template<bool Proximal>
+template<typename MatType>
+inline void KatyushaType<Proximal>::Couple(MatType& iterate,
+                                           const MatType& z,
+                                           const MatType& y,
+                                           const MatType& iterate0,
+                                           const double tau1,
+                                           const double tau2,
+                                           const std::true_type /* fused */)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  ElemType* x = iterate.memptr();
+  const ElemType* zp = z.memptr();
+  const ElemType* yp = y.memptr();
+  const ElemType* x0 = iterate0.memptr();
+  const ElemType a = ElemType(tau1);
+  const ElemType b = ElemType(tau2);
+  const ElemType c = ElemType(1 - tau1 - tau2);
+
+  FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+  {
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = begin; i < end; ++i)
+      x[i] = a * zp[i] + b * x0[i] + c * yp[i];
+  });
+}
+
+//! Compute the coupled iterate with Armadillo expressions.
+template<bool Proximal>
+template<typename MatType>
+inline void KatyushaType<Proximal>::Couple(MatType& iterate,
+                                           const MatType& z,
+                                           const MatType& y,
+                                           const MatType& iterate0,
+                                           const double tau1,
+                                           const double tau2,
+                                           const std::false_type /* fused */)
+{
+  iterate = tau1 * z + tau2 * iterate0 + (1 - tau1 - tau2) * y;
+}
+
+//! Take the step of z and y, and update w, in one pass.
+template<bool Proximal>
+template<typename MatType, typename GradType>
+inline void KatyushaType<Proximal>::Step(MatType& z,
+                                         MatType& y,
+                                         MatType& w,
+                                         const MatType& iterate,
+                                         const GradType& fullGradient,
+                                         const GradType& gradient,
+                                         const GradType& snapshotGradient,
+                                         const double tau1,
+                                         const double alpha,
+                                         const double cw,
+                                         const std::true_type /* fused */) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  ElemType* zp = z.memptr();
+  ElemType* yp = y.memptr();
+  ElemType* wp = w.memptr();
+  const ElemType* x = iterate.memptr();
+  const ElemType* fg = fullGradient.memptr();
+  const ElemType* g = gradient.memptr();
+  const ElemType* sg = snapshotGradient.memptr();
+  const ElemType a = ElemType(alpha);
+  const ElemType scale = ElemType(1.0 / (double) batchSize);
+  const ElemType t = ElemType(tau1);
+  const ElemType p = ElemType(1.0 / (3.0 * lipschitz));
+  const ElemType c = ElemType(cw);
+
+  FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+  {
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = begin; i < end; ++i)
+    {
+      // z_{k + 1} = z_k - alpha * g for the variance reduced gradient g, and
+      // y_{k + 1} as in the generic Step() below, with w_k.
+      const ElemType step = a * (fg[i] + scale * (g[i] - sg[i]));
+      yp[i] = Proximal ? x[i] + p * wp[i] : x[i] - t * step;
+      zp[i] -= step;
+      wp[i] += c * x[i];
+    }
+  });
+}
+
+//! Take the step with Armadillo expressions.
+template<bool Proximal>
+template<typename MatType, typename GradType>
+inline void KatyushaType<Proximal>::Step(MatType& z,
+                                         MatType& y,
+                                         MatType& w,
+                                         const MatType& iterate,
+                                         const GradType& fullGradient,
+                                         const GradType& gradient,
+                                         const GradType& snapshotGradient,
+                                         const double tau1,
+                                         const double alpha,
+                                         const double cw,
+                                         const std::false_type /* fused */)
+    const
+{
+  // By the minimality definition of z_{k + 1}, we have that:
+  // z_{k+1} − z_k + \alpha * \sigma_{k+1} + \alpha g = 0.
+  MatType zNew = z - alpha * (fullGradient + (gradient -
+      snapshotGradient) / (double) batchSize);
+
+  // Proximal update, choose between Option I and Option II. Shift relative
+  // to the Lipschitz constant or take a constant step using the given step
+  // size.
+  if (Proximal)
+  {
+    // yk = x0 − 1 / (3L) * \delta1, k = 1
+    // yk = x0 − 1 / (3L) * \delta2 - ((1 - tau) / (3L)) + tau * alpha)
+    // * \delta1, k = 2
+    // yk = x0 − 1 / (3L) * \delta3 - ((1 - tau) / (3L)) + tau * alpha)
+    // * \delta2 - ((1-tau)^2 / (3L) + (1 - (1 - tau)^2) * alpha) * \delta1,
+    // k = 3.
+    y = iterate + 1.0 / (3.0 * lipschitz) * w;
+  }
+  else
+  {
+    y = iterate + tau1 * (zNew - z);
+  }
+
+  z = std::move(zNew);
+
+  // sum_{j=0}^{m-1} 1 + std::min(alpha * convexity, 1 / (4 * m)^j * ys).
+  w += cw * iterate;
+}
+
+//! Run the inner loop with lazy updates.
+template<bool Proximal>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+size_t KatyushaType<Proximal>::LazyInnerLoop(
+    SeparableFunctionType& function,
+    MatType& iterate,
+    MatType& z,
+    MatType& y,
+    MatType& w,
+    const MatType& iterate0,
+    const GradType& fullGradient,
+    const std::vector<GradType>& snapshotGradients,
+    GradType& gradient,
+    GradType& gradient0,
+    const double tau1,
+    const double tau2,
+    const double alpha,
+    const double r,
+    bool& terminate,
+    const std::true_type /* sparse */,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t numFunctions = function.NumFunctions();
+  const double c = 1.0 - tau1 - tau2;
+  const arma::Mat<ElemType> denseFullGradient(fullGradient);
+
+  // During the inner loop, w holds w_k / r^k.  Then, in the variables
+  // (z, y, w, iterate0, alpha * fullGradient) of a coordinate, a step without
+  // variance reduction term is the same linear map A at every step k, and
+  // powers[i] holds A^(2^i).  Since the last two variables are constant, only
+  // the first three rows are used.
+  arma::mat stepMap(5, 5, arma::fill::zeros);
+  stepMap(0, 0) = 1.0;
+  stepMap(0, 4) = -1.0;
+  stepMap(1, 0) = tau1;
+  stepMap(1, 1) = c;
+  stepMap(1, 3) = tau2;
+  stepMap(1, 4) = -tau1;
+  stepMap(2, 0) = tau1 / r;
+  stepMap(2, 1) = c / r;
+  stepMap(2, 2) = 1.0 / r;
+  stepMap(2, 3) = tau2 / r;
+  stepMap(3, 3) = 1.0;
+  stepMap(4, 4) = 1.0;
+  std::vector<arma::mat> powers(1, stepMap);
+  while (((size_t) 1 << powers.size()) <= innerIterations)
+    powers.push_back(powers.back() * powers.back());
+
+  ElemType* x = iterate.memptr();
+  ElemType* zp = z.memptr();
+  ElemType* yp = y.memptr();
+  ElemType* wp = w.memptr();
+  const ElemType* x0 = iterate0.memptr();
+  const ElemType* fg = denseFullGradient.memptr();
+
+  // last[j] is the step that the variables of coordinate j are at, and
+  // marked[j] is one more than the last step at which it was touched.
+  std::vector<size_t> last(iterate.n_elem, 0), marked(iterate.n_elem, 0);
+  std::vector<size_t> touched;
+  arma::Mat<ElemType> correction(iterate.n_rows, iterate.n_cols);
+
+  // Apply the steps since the last write of coordinate j, up to the given
+  // step.
+  auto catchUp = [&](const size_t j, const size_t step)
+  {
+    size_t n = step - last[j];
+    double v[5] = { double(zp[j]), double(yp[j]), double(wp[j]),
+        double(x0[j]), alpha * double(fg[j]) };
+    for (size_t i = 0; n > 0; ++i, n >>= 1)
+    {
+      if ((n & 1) == 0)
+        continue;
+
+      const double* m = powers[i].memptr();
+      double next[3];
+      for (size_t row = 0; row < 3; ++row)
+      {
+        next[row] = m[row] * v[0] + m[row + 5] * v[1] + m[row + 10] * v[2] +
+            m[row + 15] * v[3] + m[row + 20] * v[4];
+      }
+      v[0] = next[0];
+      v[1] = next[1];
+      v[2] = next[2];
+    }
+
+    zp[j] = ElemType(v[0]);
+    yp[j] = ElemType(v[1]);
+    wp[j] = ElemType(v[2]);
+    last[j] = step;
+  };
+
+  // Bring coordinate j up to date at the given step, and compute its coupled
+  // iterate.
+  auto touch = [&](const size_t j, const size_t step)
+  {
+    if (marked[j] == step + 1)
+      return;
+
+    marked[j] = step + 1;
+    if (last[j] < step)
+      catchUp(j, step);
+    x[j] = ElemType(tau1 * zp[j] + tau2 * x0[j] + c * yp[j]);
+    correction[j] = 0;
+    touched.push_back(j);
+  };
+
+  size_t steps = 0;
+  for (size_t f = 0, currentFunction = 0; f < innerIterations; ++steps)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0)
+    {
+      currentFunction = 0;
+
+      // Determine order of visitation; the cached snapshot gradients need the
+      // order of the full gradient pass.
+      if (shuffle && snapshotGradients.empty())
+        function.Shuffle();
+    }
+
+    // Find the effective batch size (the last batch may be smaller).
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - currentFunction);
+
+    // The coordinates where the snapshot gradient of the batch is nonzero are
+    // brought up to date first, so that the gradient can be computed.
+    if (snapshotGradients.empty())
+    {
+      function.Gradient(iterate0, currentFunction, gradient0,
+          effectiveBatchSize);
+      terminate |= Callback::Gradient(*this, function, iterate0, gradient0,
+          callbacks...);
+    }
+    const GradType& snapshotGradient = snapshotGradients.empty() ?
+        gradient0 : snapshotGradients[currentFunction / batchSize];
+
+    touched.clear();
+    ForEachNonzero(snapshotGradient, [&](const size_t j, const ElemType)
+    {
+      touch(j, steps);
+    });
+
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
+    function.Gradient(iterate, currentFunction, gradient, effectiveBatchSize);
+    terminate |= Callback::Gradient(*this, function, iterate, gradient,
+        callbacks...);
+
+    ForEachNonzero(gradient, [&](const size_t j, const ElemType g)
+    {
+      touch(j, steps);
+      correction[j] += g;
+    });
+    ForEachNonzero(snapshotGradient, [&](const size_t j, const ElemType g)
+    {
+      correction[j] -= g;
+    });
+
+    // The step with the variance reduction term, for the touched coordinates.
+    const ElemType scale = ElemType(1.0 / (double) batchSize);
+    for (size_t k = 0; k < touched.size(); ++k)
+    {
+      const size_t j = touched[k];
+      const ElemType step = ElemType(alpha) * (fg[j] + scale * correction[j]);
+      yp[j] = x[j] - ElemType(tau1) * step;
+      zp[j] -= step;
+      wp[j] = (wp[j] + x[j]) / ElemType(r);
+      last[j] = steps + 1;
+    }
+
+    currentFunction += effectiveBatchSize;
+    f += effectiveBatchSize;
+  }
+
+  // Bring all coordinates up to date: the iterate is the coupled iterate of
+  // the last step, and w the weighted sum of the iterates.
+  const ElemType wScale = ElemType(std::pow(r, (double) steps));
+  for (size_t j = 0; j < iterate.n_elem; ++j)
+  {
+    if (last[j] < steps)
+    {
+      catchUp(j, steps - 1);
+      x[j] = ElemType(tau1 * zp[j] + tau2 * x0[j] + c * yp[j]);
+      catchUp(j, steps);
+    }
+    wp[j] *= wScale;
+  }
+
+  return steps;
+}
+
 } // namespace ens
 
 #endif
@@ -15,19 +15,29 @@
 
 #include <ensmallen_bits/function.hpp>
 
+#include "line_search_policies/wolfe_backtracking_line_search.hpp"
+#include "line_search_policies/more_thuente_line_search.hpp"
+
 namespace ens {
 
+// Forward declaration, for the friendship below.
+class SQN;
+
 /**
- * The L-BFGS optimizer, which uses a back-tracking line search algorithm to
- * minimize a function.  The parameters for the algorithm (number of memory
- * points, maximum step size, and so forth) are all configurable via either the
- * constructor or standalone modifier functions.
+ * The L-BFGS optimizer, which uses a line search algorithm to minimize a
+ * function.  The parameters for the algorithm (number of memory points, maximum
+ * step size, and so forth) are all configurable via either the constructor or
+ * standalone modifier functions.
  *
  * L_BFGS can optimize differentiable functions.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * @tparam LineSearchType Line search policy; WolfeBacktrackingLineSearch or
+ *     MoreThuenteLineSearch.
  */
-class L_BFGS
+template<typename LineSearchType = WolfeBacktrackingLineSearch>
+class L_BFGSType
 {
  public:
   /**
@@ -48,16 +58,18 @@ class L_BFGS
    *     (before giving up).
    * @param minStep The minimum step of the line search.
    * @param maxStep The maximum step of the line search.
+   * @param lineSearch Instantiated line search policy.
    */
-  L_BFGS(const size_t numBasis = 10, /* same default as scipy */
-         const size_t maxIterations = 10000, /* many but not infinite */
-         const double armijoConstant = 1e-4,
-         const double wolfe = 0.9,
-         const double minGradientNorm = 1e-6,
-         const double factr = 1e-15,
-         const size_t maxLineSearchTrials = 50,
-         const double minStep = 1e-20,
-         const double maxStep = 1e20);
+  L_BFGSType(const size_t numBasis = 10, /* same default as scipy */
+             const size_t maxIterations = 10000, /* many but not infinite */
+             const double armijoConstant = 1e-4,
+             const double wolfe = 0.9,
+             const double minGradientNorm = 1e-6,
+             const double factr = 1e-15,
+             const size_t maxLineSearchTrials = 50,
+             const double minStep = 1e-20,
+             const double maxStep = 1e20,
+             const LineSearchType& lineSearch = LineSearchType());
 
   /**
    * Use L-BFGS to optimize the given function, starting at the given iterate
@@ -80,7 +92,7 @@ class L_BFGS
            typename MatType,
            typename GradType,
            typename... CallbackTypes>
-  typename std::enable_if<IsArmaType<GradType>::value,
+  typename std::enable_if<IsMatrixType<GradType>::value,
       typename MatType::elem_type>::type
   Optimize(FunctionType& function,
            MatType& iterate,
@@ -99,6 +111,82 @@ class L_BFGS
         std::forward<CallbackTypes>(callbacks)...);
   }
 
+  /**
+   * Use L-BFGS to optimize a batch of independent problems: functions[i] is
+   * optimized starting at iterates[i], which is modified to store the final
+   * point, and its final objective is stored in objectives(i).  The problems
+   * are split into contiguous ranges, one per available thread; each range is
+   * solved with its own copy of this optimizer, and all the problems in a range
+   * reuse the same storage for the history and the temporaries.  So, when
+   * solving many small problems, nearly nothing is allocated after the first
+   * problem of each range.
+   *
+   * Since the problems are solved concurrently, the functions must be safe to
+   * evaluate in parallel with each other.  No callbacks are taken.
+   *
+   * @tparam FunctionType Type of the functions to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param functions Functions to optimize.
+   * @param iterates Starting points, one per function (will be modified).
+   * @param objectives Vector to store the final objectives into.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  void Optimize(std::vector<FunctionType>& functions,
+                std::vector<MatType>& iterates,
+                arma::Col<typename MatType::elem_type>& objectives);
+
+  //! The state of an optimization that is run step by step with Begin() and
+  //! Step(); it is defined below.
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  class State;
+
+  /**
+   * Start an optimization of the given function that is run step by step with
+   * Step(), instead of to completion; e.g. a scheduler can interleave many
+   * such optimizations on a few threads, or stop one at a deadline.  This
+   * evaluates the function once, at the starting point.  The optimization is
+   * the same as with Optimize(), except that no callbacks are called and the
+   * history is always stored in the precision of MatType.  Each state has its
+   * own history.
+   *
+   * @code
+   * L_BFGS lbfgs;
+   * auto state = lbfgs.Begin(f, coordinates);
+   * while (lbfgs.Step(state, 5))
+   * {
+   *   // Do other work between every 5 iterations.
+   * }
+   * @endcode
+   *
+   * @param function Function to optimize; it must outlive the state.
+   * @param iterate Starting point (will be modified); it must outlive the
+   *     state.
+   * @return The state of the optimization.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  State<FunctionType, MatType, GradType> Begin(FunctionType& function,
+                                               MatType& iterate);
+
+  /**
+   * Run up to n iterations of the optimization of the given state, with the
+   * parameters of this optimizer.  Once the optimization has terminated, the
+   * coordinates are the final point and state.Objective() is the value
+   * Optimize() would have returned.
+   *
+   * @param state State returned by Begin().
+   * @param n Maximum number of iterations to run.
+   * @return false if the optimization has terminated.
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  bool Step(State<FunctionType, MatType, GradType>& state, const size_t n = 1);
+
   //! Get the memory size.
   size_t NumBasis() const { return numBasis; }
   //! Modify the memory size.
@@ -144,7 +232,72 @@ class L_BFGS
   //! Modify the maximum line search step size.
   double& MaxStep() { return maxStep; }
 
- private:
+  //! Get whether or not the history is stored in single precision.
+  bool FloatHistory() const { return floatHistory; }
+  //! Modify whether or not the history is stored in single precision.
+  bool& FloatHistory() { return floatHistory; }
+
+  //! Get whether or not the history is discarded before every call to
+  //! Optimize().
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the history is discarded before every call to
+  //! Optimize().  If false, the s and y vectors of the previous call are used
+  //! from the first iteration on, if the problem has the same size.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the line search policy.
+  const LineSearchType& LineSearchPolicy() const { return lineSearch; }
+  //! Modify the line search policy.
+  LineSearchType& LineSearchPolicy() { return lineSearch; }
+
+  /**
+   * Return the number of bytes that Optimize() keeps for coordinates of the
+   * given size: the 2 * NumBasis() stored s and y vectors (in single precision
+   * if FloatHistory() is true), their inner products, five temporaries of the
+   * size of the coordinates, and the buffers of the line search.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   */
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const;
+
+  /**
+   * Save the s and y vectors stored by the last call to Optimize() with the
+   * given matrix types (none, if there was no such call), e.g. to warm-start
+   * the optimization of a similar function later (see WarmStartStore).
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param ar The CheckpointWriter to save to.
+   * @param iterate The coordinates of the optimization.
+   */
+  template<typename MatType, typename GradType = MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& iterate);
+
+  /**
+   * Restore the s and y vectors saved by SaveState().  The next call to
+   * Optimize() uses them from its first iteration on, even if ResetPolicy() is
+   * true, if the problem has the same size and NumBasis() did not change; as
+   * with ResetPolicy() false, they are dropped if they don't give a descent
+   * direction.  A std::runtime_error is thrown if the state was saved with a
+   * different FloatHistory().
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param ar The CheckpointReader to restore from.
+   * @param iterate The coordinates of the optimization.
+   */
+  template<typename MatType, typename GradType = MatType>
+  void LoadState(CheckpointReader& ar, const MatType& iterate);
+
+ protected:
+  //! SQN reuses the compact representation of the inverse Hessian
+  //! approximation.
+  friend class SQN;
+
   //! Size of memory for this L-BFGS optimizer.
   size_t numBasis;
   //! Maximum number of iterations.
@@ -163,53 +316,163 @@ class L_BFGS
   double minStep;
   //! Maximum step of the line search.
   double maxStep;
+  //! Whether or not to store the history in single precision.
+  bool floatHistory;
+  //! Whether or not to discard the history before every call to Optimize().
+  bool resetPolicy;
+  //! Whether or not the history was restored by LoadState() and must not be
+  //! discarded by the next call to Optimize().
+  bool isRestored;
+  //! The line search policy.
+  LineSearchType lineSearch;
   //! Controls early termination of the optimization process.
   bool terminate;
 
+  /**
+   * Storage used by OptimizeWithHistory(); it can be kept between runs on
+   * problems of the same size to avoid allocating it again.
+   */
+  template<typename MatType, typename GradType, typename HistoryElemType>
+  struct Workspace
+  {
+    Workspace() : iterations(0) { }
+
+    //! The trial points of the line search.
+    MatType newIterateTmp;
+    //! The iterate of the previous iteration.
+    MatType oldIterate;
+    //! The gradient at the iterate.
+    GradType gradient;
+    //! The gradient of the previous iteration.
+    GradType oldGradient;
+    //! The search direction.
+    GradType searchDirection;
+    //! The memory of the StateAllocator for the history, if any.
+    StateMemory historyMemory;
+    //! The stored s and y vectors; they are kept where MatType lives.
+    typename DenseMatType<MatType, HistoryElemType>::type history;
+    //! Inner products of the stored s and y vectors.
+    arma::Mat<typename MatType::elem_type> gram;
+    //! The number of s and y pairs stored so far; if this is not 0 when
+    //! OptimizeWithHistory() is called, the stored pairs are used.
+    size_t iterations;
+  };
+
+  /**
+   * Holds the workspace of the last call to Optimize(), so that its history
+   * can be used by the next call if ResetPolicy() is false.  A copy of the
+   * optimizer starts without any history.
+   */
+  class WorkspaceHolder
+  {
+   public:
+    WorkspaceHolder() { }
+    WorkspaceHolder(const WorkspaceHolder& /* other */) { }
+    WorkspaceHolder& operator=(const WorkspaceHolder& /* other */)
+    {
+      return *this;
+    }
+    ~WorkspaceHolder() { workspace.Clean(); }
+
+    //! Get the held workspace of the given type, creating it if needed.
+    template<typename MatType, typename GradType, typename HistoryElemType>
+    Workspace<MatType, GradType, HistoryElemType>& Get()
+    {
+      typedef Workspace<MatType, GradType, HistoryElemType> WorkspaceType;
+      if (!workspace.Has<WorkspaceType>())
+        workspace.Emplace<WorkspaceType>();
+
+      return workspace.As<WorkspaceType>();
+    }
+
+   private:
+    //! The held workspace.
+    Any workspace;
+  };
+
+  //! The workspace of the last call to Optimize().
+  WorkspaceHolder keptWorkspace;
+
   /**
    * Calculate the scaling factor, gamma, which is used to scale the Hessian
    * approximation matrix.  See method M3 in Section 4 of Liu and Nocedal
    * (1989).
    *
    * @return The calculated scaling factor.
+   * @param iterationNum The iteration number.
    * @param gradient The gradient at the initial point.
-   * @param s Differences between the iterate and old iterate matrix.
-   * @param y Differences between the gradient and the old gradient matrix.
+   * @param gram Inner products of the stored s and y vectors.
    */
-  template<typename MatType, typename CubeType>
+  template<typename MatType, typename ElemType>
   double ChooseScalingFactor(const size_t iterationNum,
                              const MatType& gradient,
-                             const CubeType& s,
-                             const CubeType& y);
+                             const arma::Mat<ElemType>& gram);
 
   /**
-   * Perform a back-tracking line search along the search direction to
-   * calculate a step size satisfying the Wolfe conditions.  The parameter
-   * iterate will be modified if the method is successful.
+   * Run the optimization, storing the s and y vectors with the given element
+   * type.  The function is expected to be wrapped with Function<> already.
    *
-   * @param function Function to optimize.
-   * @param functionValue Value of the function at the initial point.
-   * @param iterate The initial point to begin the line search from.
-   * @param gradient The gradient at the initial point.
-   * @param searchDirection A vector specifying the search direction.
-   * @param finalStepSize The resulting step size (0 if no step).
+   * @tparam HistoryElemType Element type of the stored s and y vectors.
+   * @param f Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param workspace Storage for the history and the temporaries.
    * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename HistoryElemType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename MatType::elem_type OptimizeWithHistory(
+      FunctionType& f,
+      MatType& iterate,
+      Workspace<MatType, GradType, HistoryElemType>& workspace,
+      CallbackTypes&... callbacks);
+
+  //! Size the storage of the workspace for the given iterate, and return the
+  //! number of pairs of a previous run that are used.
+  template<typename HistoryElemType, typename MatType, typename GradType>
+  size_t PrepareWorkspace(
+      const MatType& iterate,
+      Workspace<MatType, GradType, HistoryElemType>& workspace);
+
+  //! Save the stored s and y vectors of the given workspace.
+  template<typename HistoryElemType, typename MatType, typename GradType>
+  void SaveHistory(CheckpointWriter& ar,
+                   Workspace<MatType, GradType, HistoryElemType>& workspace);
+
+  //! Restore the stored s and y vectors of the given workspace.
+  template<typename HistoryElemType, typename MatType, typename GradType>
+  void LoadHistory(CheckpointReader& ar,
+                   Workspace<MatType, GradType, HistoryElemType>& workspace);
+
+  /**
+   * Run one iteration of the optimization.
    *
-   * @return false if no step size is suitable, true otherwise.
+   * @param f Function to optimize.
+   * @param iterate Current point (will be modified).
+   * @param workspace Storage for the history and the temporaries.
+   * @param functionValue Objective of the current point (will be modified).
+   * @param itNum Number of the iteration in this run.
+   * @param offset Number of pairs of a previous run that are used.
+   * @param stop Set to true if a callback requested termination.
+   * @param callbacks Callback functions.
+   * @return false if the optimization has terminated.
    */
-  template<typename FunctionType,
-           typename ElemType,
+  template<typename HistoryElemType,
+           typename FunctionType,
            typename MatType,
            typename GradType,
            typename... CallbackTypes>
-  bool LineSearch(FunctionType& function,
-                  ElemType& functionValue,
-                  MatType& iterate,
-                  GradType& gradient,
-                  MatType& newIterateTmp,
-                  const GradType& searchDirection,
-                  double& finalStepSize,
-                  CallbackTypes&... callbacks);
+  bool Iteration(FunctionType& f,
+                 MatType& iterate,
+                 Workspace<MatType, GradType, HistoryElemType>& workspace,
+                 typename MatType::elem_type& functionValue,
+                 const size_t itNum,
+                 size_t& offset,
+                 bool& stop,
+                 CallbackTypes&... callbacks);
 
   /**
    * Find the L-BFGS search direction.
@@ -217,41 +480,207 @@ class L_BFGS
    * @param gradient The gradient at the current point.
    * @param iterationNum The iteration number.
    * @param scalingFactor Scaling factor to use (see ChooseScalingFactor_()).
-   * @param s Differences between the iterate and old iterate matrix.
-   * @param y Differences between the gradient and the old gradient matrix.
+   * @param history The stored s and y vectors (see UpdateBasisSet()).
+   * @param gram Inner products of the stored s and y vectors.
    * @param searchDirection Vector to store search direction in.
    */
-  template<typename MatType, typename CubeType>
+  template<typename MatType, typename HistoryType>
   void SearchDirection(const MatType& gradient,
                        const size_t iterationNum,
                        const double scalingFactor,
-                       const CubeType& s,
-                       const CubeType& y,
+                       const HistoryType& history,
+                       const arma::Mat<typename MatType::elem_type>& gram,
                        MatType& searchDirection);
 
   /**
-   * Update the y and s matrices, which store the differences
-   * between the iterate and old iterate and the differences between the
-   * gradient and the old gradient, respectively.
+   * Update the stored s and y vectors, which are the differences between the
+   * iterate and old iterate and the differences between the gradient and the
+   * old gradient, respectively, as well as their inner products.
    *
    * @param iterationNum Iteration number.
    * @param iterate Current point.
    * @param oldIterate Point at last iteration.
    * @param gradient Gradient at current point (iterate).
    * @param oldGradient Gradient at last iteration point (oldIterate).
-   * @param s Differences between the iterate and old iterate matrix.
-   * @param y Differences between the gradient and the old gradient matrix.
+   * @param history The stored s and y vectors, one per column.
+   * @param gram Inner products of the stored s and y vectors.
    */
-  template<typename MatType, typename GradType, typename CubeType>
+  template<typename MatType, typename GradType, typename HistoryType>
   void UpdateBasisSet(const size_t iterationNum,
                       const MatType& iterate,
                       const MatType& oldIterate,
                       const GradType& gradient,
                       const GradType& oldGradient,
-                      CubeType& s,
-                      CubeType& y);
+                      HistoryType& history,
+                      arma::Mat<typename MatType::elem_type>& gram);
+
+  //! Store a - b for dense a and b in the given column of the history,
+  //! converting to the history precision.
+  template<typename ElemType, typename HistoryElemType>
+  static void StoreDifference(const arma::Mat<ElemType>& a,
+                              const arma::Mat<ElemType>& b,
+                              arma::Mat<HistoryElemType>& history,
+                              const size_t column);
+
+  //! Store a - b for sparse a and b in the given column of the history.
+  template<typename ElemType>
+  static void StoreDifference(const arma::SpMat<ElemType>& a,
+                              const arma::SpMat<ElemType>& b,
+                              arma::Mat<ElemType>& history,
+                              const size_t column);
+
+  //! Compute the inner products of the first `columns` columns of the history
+  //! with columns `first` and `first + 1`.
+  template<typename HistoryElemType, typename ElemType>
+  static void InnerProducts(const arma::Mat<HistoryElemType>& history,
+                            const size_t columns,
+                            const size_t first,
+                            arma::Mat<ElemType>& out);
+
+  //! Compute H^T vec(x) for a dense x, where H holds the first `columns`
+  //! columns of the history.
+  template<typename ElemType>
+  static void Project(const arma::Mat<ElemType>& history,
+                      const size_t columns,
+                      const arma::Mat<ElemType>& x,
+                      arma::Col<ElemType>& out);
+
+  //! Compute H^T vec(x) for a dense x and a history in another precision,
+  //! accumulating in double precision.
+  template<typename HistoryElemType, typename ElemType>
+  static void Project(const arma::Mat<HistoryElemType>& history,
+                      const size_t columns,
+                      const arma::Mat<ElemType>& x,
+                      arma::Col<ElemType>& out);
+
+  //! Compute H^T vec(x) for a sparse x.
+  template<typename ElemType>
+  static void Project(const arma::Mat<ElemType>& history,
+                      const size_t columns,
+                      const arma::SpMat<ElemType>& x,
+                      arma::Col<ElemType>& out);
+
+  //! Compute out = -(H * coefficients + c * x) for a dense x, where H holds
+  //! the first `columns` columns of the history.
+  template<typename ElemType>
+  static void Combine(const arma::Mat<ElemType>& history,
+                      const size_t columns,
+                      const arma::Col<ElemType>& coefficients,
+                      const ElemType c,
+                      const arma::Mat<ElemType>& x,
+                      arma::Mat<ElemType>& out);
+
+  //! Compute out = -(H * coefficients + c * x) for a dense x and a history in
+  //! another precision.
+  template<typename HistoryElemType, typename ElemType>
+  static void Combine(const arma::Mat<HistoryElemType>& history,
+                      const size_t columns,
+                      const arma::Col<HistoryElemType>& coefficients,
+                      const ElemType c,
+                      const arma::Mat<ElemType>& x,
+                      arma::Mat<ElemType>& out);
+
+  //! Compute out = -(H * coefficients + c * x) for a sparse x.
+  template<typename ElemType>
+  static void Combine(const arma::Mat<ElemType>& history,
+                      const size_t columns,
+                      const arma::Col<ElemType>& coefficients,
+                      const ElemType c,
+                      const arma::SpMat<ElemType>& x,
+                      arma::SpMat<ElemType>& out);
+
+  #ifdef ENS_HAVE_COOT
+  //! Store a - b for Bandicoot matrices; the history stays on the device.
+  template<typename ElemType>
+  static void StoreDifference(const coot::Mat<ElemType>& a,
+                              const coot::Mat<ElemType>& b,
+                              coot::Mat<ElemType>& history,
+                              const size_t column);
+
+  //! Compute the inner products of a Bandicoot history (see above).  Only the
+  //! small result is copied to the host.
+  template<typename ElemType>
+  static void InnerProducts(const coot::Mat<ElemType>& history,
+                            const size_t columns,
+                            const size_t first,
+                            arma::Mat<ElemType>& out);
+
+  //! Compute H^T vec(x) for Bandicoot matrices.
+  template<typename ElemType>
+  static void Project(const coot::Mat<ElemType>& history,
+                      const size_t columns,
+                      const coot::Mat<ElemType>& x,
+                      arma::Col<ElemType>& out);
+
+  //! Compute out = -(H * coefficients + c * x) for Bandicoot matrices.
+  template<typename ElemType>
+  static void Combine(const coot::Mat<ElemType>& history,
+                      const size_t columns,
+                      const arma::Col<ElemType>& coefficients,
+                      const ElemType c,
+                      const coot::Mat<ElemType>& x,
+                      coot::Mat<ElemType>& out);
+  #endif
+};
+
+/**
+ * The state of an L-BFGS optimization that is run with Begin() and Step().  It
+ * refers to the function and the coordinates given to Begin(), which must
+ * outlive it, and holds the history.
+ */
+template<typename LineSearchType>
+template<typename FunctionType, typename MatType, typename GradType>
+class L_BFGSType<LineSearchType>::State
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+
+  //! Create the state of an optimization of the given function.
+  State(FunctionType& function, MatType& iterate) :
+      function(&static_cast<FullFunctionType&>(function)),
+      iterate(&((BaseMatType&) iterate)),
+      objective(0),
+      iterations(0),
+      offset(0),
+      finished(false)
+  { }
+
+  //! Get the current coordinates.
+  const BaseMatType& Iterate() const { return *iterate; }
+  //! Get the objective of the current coordinates.
+  ElemType Objective() const { return objective; }
+  //! Get the number of iterations run so far.
+  size_t Iterations() const { return iterations; }
+  //! Get whether or not the optimization has terminated.
+  bool Finished() const { return finished; }
+
+ private:
+  friend class L_BFGSType<LineSearchType>;
+
+  //! The function to optimize.
+  FullFunctionType* function;
+  //! The coordinates.
+  BaseMatType* iterate;
+  //! The history and the temporaries.
+  Workspace<BaseMatType, BaseGradType, ElemType> workspace;
+  //! The objective of the current coordinates.
+  ElemType objective;
+  //! The number of iterations run so far.
+  size_t iterations;
+  //! The number of pairs of a previous run that are used (always 0 here).
+  size_t offset;
+  //! Whether or not the optimization has terminated.
+  bool finished;
 };
 
+/**
+ * L-BFGS with the back-tracking line search.
+ */
+using L_BFGS = L_BFGSType<WolfeBacktrackingLineSearch>;
+
 } // namespace ens
 
 #include "lbfgs_impl.hpp"
@@ -0,0 +1,258 @@
+/**
+ * @file lbfgs_b.hpp
+ *
+ * L-BFGS-B: L-BFGS with simple bounds on the coordinates.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_B_HPP
+#define ENSMALLEN_LBFGS_LBFGS_B_HPP
+
+#include "lbfgs.hpp"
+
+namespace ens {
+
+/**
+ * L-BFGS-B minimizes a differentiable function subject to the bounds
+ * \f$ l \le x \le u \f$ on each coordinate, without any penalty or
+ * projection step outside of the optimizer.  Each iteration
+ *
+ *  - computes the generalized Cauchy point, the first local minimizer of the
+ *    L-BFGS model of the function along the path of the projected steepest
+ *    descent direction, which fixes the coordinates that reach their bounds;
+ *  - minimizes the model over the remaining (free) coordinates, starting at
+ *    the Cauchy point, and shortens that step so that it stays in the box;
+ *  - runs the line search along the direction to the resulting point, with
+ *    the step limited so that every trial point is feasible.
+ *
+ * The model uses the stored s and y vectors and their inner products in the
+ * same (compact) form as L_BFGS, so all the work that depends on the number of
+ * coordinates is a few products with the history.  The optimization terminates
+ * when the largest component of the projected gradient is smaller than
+ * MinGradientNorm(), or as for L_BFGS.
+ *
+ * The bounds are matrices of the size of the coordinates, or 1x1 matrices (or
+ * doubles) for the same bound on every coordinate; a bound of -inf or inf
+ * leaves that side unconstrained.  The starting point is projected onto the
+ * box.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @article{Byrd1995,
+ *   author  = {Byrd, Richard H. and Lu, Peihuang and Nocedal, Jorge and
+ *              Zhu, Ciyou},
+ *   title   = {A Limited Memory Algorithm for Bound Constrained
+ *              Optimization},
+ *   journal = {SIAM Journal on Scientific Computing},
+ *   volume  = {16},
+ *   number  = {5},
+ *   pages   = {1190--1208},
+ *   year    = {1995}
+ * }
+ * @endcode
+ *
+ * L_BFGS_B can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ *
+ * @tparam LineSearchType Line search policy; it must not take steps larger
+ *     than MaxStep(), as MoreThuenteLineSearch does.
+ */
+template<typename LineSearchType = MoreThuenteLineSearch>
+class L_BFGS_BType : private L_BFGSType<LineSearchType>
+{
+ public:
+  /**
+   * Initialize the L-BFGS-B object, with the same bounds for all coordinates.
+   *
+   * @param lowerBound Lower bound of the coordinates.
+   * @param upperBound Upper bound of the coordinates.
+   * @param numBasis Number of memory points to be stored.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param wolfe Parameter for detecting the Wolfe condition.
+   * @param minGradientNorm Minimum largest component of the projected
+   *     gradient required to continue the optimization.
+   * @param factr Minimum relative function value decrease to continue
+   *     the optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line search
+   *     (before giving up).
+   * @param minStep The minimum step of the line search.
+   * @param maxStep The maximum step of the line search.
+   * @param lineSearch Instantiated line search policy.
+   */
+  L_BFGS_BType(const double lowerBound = -arma::datum::inf,
+               const double upperBound = arma::datum::inf,
+               const size_t numBasis = 10,
+               const size_t maxIterations = 10000,
+               const double armijoConstant = 1e-3,
+               const double wolfe = 0.9,
+               const double minGradientNorm = 1e-5,
+               const double factr = 1e-15,
+               const size_t maxLineSearchTrials = 50,
+               const double minStep = 1e-20,
+               const double maxStep = 1e20,
+               const LineSearchType& lineSearch = LineSearchType());
+
+  /**
+   * Initialize the L-BFGS-B object, with a bound for each coordinate.  See
+   * the other constructor for the description of the parameters.
+   *
+   * @param lowerBound Lower bounds of the coordinates (or a 1x1 matrix).
+   * @param upperBound Upper bounds of the coordinates (or a 1x1 matrix).
+   */
+  L_BFGS_BType(const arma::mat& lowerBound,
+               const arma::mat& upperBound,
+               const size_t numBasis = 10,
+               const size_t maxIterations = 10000,
+               const double armijoConstant = 1e-3,
+               const double wolfe = 0.9,
+               const double minGradientNorm = 1e-5,
+               const double factr = 1e-15,
+               const size_t maxLineSearchTrials = 50,
+               const double minStep = 1e-20,
+               const double maxStep = 1e20,
+               const LineSearchType& lineSearch = LineSearchType());
+
+  /**
+   * Use L-BFGS-B to optimize the given function within the bounds, starting
+   * at the given iterate point.  The given starting point will be modified to
+   * store the finishing point of the algorithm, and the final objective value
+   * is returned.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsArmaType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(FunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<FunctionType, MatType, MatType, CallbackTypes...>(
+        function, iterate, std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the lower bounds of the coordinates.
+  const arma::mat& LowerBound() const { return lowerBound; }
+  //! Modify the lower bounds of the coordinates.
+  arma::mat& LowerBound() { return lowerBound; }
+
+  //! Get the upper bounds of the coordinates.
+  const arma::mat& UpperBound() const { return upperBound; }
+  //! Modify the upper bounds of the coordinates.
+  arma::mat& UpperBound() { return upperBound; }
+
+  // The parameters shared with L_BFGS; see there.
+  using L_BFGSType<LineSearchType>::NumBasis;
+  using L_BFGSType<LineSearchType>::MaxIterations;
+  using L_BFGSType<LineSearchType>::ArmijoConstant;
+  using L_BFGSType<LineSearchType>::Wolfe;
+  using L_BFGSType<LineSearchType>::MinGradientNorm;
+  using L_BFGSType<LineSearchType>::Factr;
+  using L_BFGSType<LineSearchType>::MaxLineSearchTrials;
+  using L_BFGSType<LineSearchType>::MinStep;
+  using L_BFGSType<LineSearchType>::MaxStep;
+  using L_BFGSType<LineSearchType>::LineSearchPolicy;
+
+ private:
+  //! The L-BFGS optimizer whose history and line search are used.
+  typedef L_BFGSType<LineSearchType> Base;
+
+  //! The storage of the history and the temporaries.
+  template<typename MatType, typename GradType>
+  using WorkspaceType = typename Base::template Workspace<MatType, GradType,
+      typename MatType::elem_type>;
+
+  /**
+   * Run one iteration: compute the generalized Cauchy point and the search
+   * direction, run the line search, and update the history.
+   *
+   * @param f Function to optimize.
+   * @param iterate Current point (will be modified).
+   * @param lower Lower bounds of the coordinates.
+   * @param upper Upper bounds of the coordinates.
+   * @param workspace Storage for the history and the temporaries.
+   * @param functionValue Objective of the current point.
+   * @param stop Set to true if a callback requested termination.
+   * @param callbacks Callback functions.
+   * @return false if the optimization has converged or can't make progress.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  bool Iteration(FunctionType& f,
+                 MatType& iterate,
+                 const arma::vec& lower,
+                 const arma::vec& upper,
+                 WorkspaceType<MatType, GradType>& workspace,
+                 typename MatType::elem_type& functionValue,
+                 bool& stop,
+                 CallbackTypes&... callbacks);
+
+  /**
+   * Compute the direction from the iterate to the minimizer of the model
+   * within the box, through the generalized Cauchy point.
+   *
+   * @param x Current point.
+   * @param g Gradient at the current point.
+   * @param lower Lower bounds of the coordinates.
+   * @param upper Upper bounds of the coordinates.
+   * @param workspace Storage for the history.
+   * @param direction Vector to store the direction in.
+   * @return false if the compact form of the model is singular.
+   */
+  template<typename MatType, typename GradType>
+  bool Direction(const arma::vec& x,
+                 const arma::vec& g,
+                 const arma::vec& lower,
+                 const arma::vec& upper,
+                 const WorkspaceType<MatType, GradType>& workspace,
+                 arma::vec& direction);
+
+  //! Return the bounds of the given shape, expanding a 1x1 matrix.
+  static arma::vec Bounds(const arma::mat& bound,
+                          const size_t n,
+                          const char* name);
+
+  //! The lower bounds of the coordinates.
+  arma::mat lowerBound;
+  //! The upper bounds of the coordinates.
+  arma::mat upperBound;
+};
+
+/**
+ * L-BFGS-B with the More-Thuente line search.
+ */
+using L_BFGS_B = L_BFGS_BType<MoreThuenteLineSearch>;
+
+} // namespace ens
+
+#include "lbfgs_b_impl.hpp"
+
+#endif // ENSMALLEN_LBFGS_LBFGS_B_HPP
@@ -0,0 +1,510 @@
+/**
+ * @file lbfgs_b_impl.hpp
+ *
+ * Implementation of the L-BFGS-B optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
+#define ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lbfgs_b.hpp"
+
+namespace ens {
+
+template<typename LineSearchType>
+inline L_BFGS_BType<LineSearchType>::L_BFGS_BType(
+    const double lowerBound,
+    const double upperBound,
+    const size_t numBasis,
+    const size_t maxIterations,
+    const double armijoConstant,
+    const double wolfe,
+    const double minGradientNorm,
+    const double factr,
+    const size_t maxLineSearchTrials,
+    const double minStep,
+    const double maxStep,
+    const LineSearchType& lineSearch) :
+    Base(numBasis, maxIterations, armijoConstant, wolfe, minGradientNorm,
+        factr, maxLineSearchTrials, minStep, maxStep, lineSearch),
+    lowerBound(lowerBound * arma::ones(1, 1)),
+    upperBound(upperBound * arma::ones(1, 1))
+{ /* Nothing to do. */ }
+
+template<typename LineSearchType>
+inline L_BFGS_BType<LineSearchType>::L_BFGS_BType(
+    const arma::mat& lowerBound,
+    const arma::mat& upperBound,
+    const size_t numBasis,
+    const size_t maxIterations,
+    const double armijoConstant,
+    const double wolfe,
+    const double minGradientNorm,
+    const double factr,
+    const size_t maxLineSearchTrials,
+    const double minStep,
+    const double maxStep,
+    const LineSearchType& lineSearch) :
+    Base(numBasis, maxIterations, armijoConstant, wolfe, minGradientNorm,
+        factr, maxLineSearchTrials, minStep, maxStep, lineSearch),
+    lowerBound(lowerBound),
+    upperBound(upperBound)
+{ /* Nothing to do. */ }
+
+template<typename LineSearchType>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsArmaType<GradType>::value,
+typename MatType::elem_type>::type
+L_BFGS_BType<LineSearchType>::Optimize(
+    FunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+  RequireDenseFloatingPointType<BaseMatType>();
+  RequireDenseFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  const arma::vec lower = Bounds(lowerBound, iterate.n_elem, "lowerBound");
+  const arma::vec upper = Bounds(upperBound, iterate.n_elem, "upperBound");
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    if (lower(i) > upper(i))
+    {
+      std::ostringstream oss;
+      oss << "L_BFGS_B::Optimize(): the lower bound of coordinate " << i
+          << " is greater than its upper bound";
+      throw std::invalid_argument(oss.str());
+    }
+
+    // Start inside the box.
+    iterate(i) = ElemType(std::min(std::max(double(iterate(i)), lower(i)),
+        upper(i)));
+  }
+
+  // The history of a previous call is never used, since the bounds may have
+  // changed; only the memory is kept.
+  WorkspaceType<BaseMatType, BaseGradType>& workspace =
+      this->keptWorkspace.template Get<BaseMatType, BaseGradType, ElemType>();
+  workspace.iterations = 0;
+  this->PrepareWorkspace(iterate, workspace);
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  // The initial function value and gradient.
+  ElemType functionValue = f.EvaluateWithGradient(iterate, workspace.gradient);
+  terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+      functionValue, workspace.gradient, callbacks...);
+
+  // The main optimization loop.
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  const bool optimizeUntilConvergence = (this->maxIterations == 0);
+  for (size_t itNum = 0; (optimizeUntilConvergence ||
+      (itNum != this->maxIterations)) && !terminate; ++itNum)
+  {
+    if (!Iteration(f, iterate, lower, upper, workspace, functionValue,
+        terminate, callbacks...))
+      break;
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return functionValue;
+}
+
+template<typename LineSearchType>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+bool L_BFGS_BType<LineSearchType>::Iteration(
+    FunctionType& f,
+    MatType& iterate,
+    const arma::vec& lower,
+    const arma::vec& upper,
+    WorkspaceType<MatType, GradType>& workspace,
+    typename MatType::elem_type& functionValue,
+    bool& stop,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  MatType& oldIterate = workspace.oldIterate;
+  GradType& gradient = workspace.gradient;
+  GradType& oldGradient = workspace.oldGradient;
+  GradType& searchDirection = workspace.searchDirection;
+
+  const ElemType prevFunctionValue = functionValue;
+  const arma::vec x = arma::conv_to<arma::vec>::from(arma::vectorise(iterate));
+  const arma::vec g = arma::conv_to<arma::vec>::from(
+      arma::vectorise(gradient));
+
+  // Break when the largest component of the projected gradient becomes too
+  // small.
+  double projectedGradientNorm = 0.0;
+  for (size_t i = 0; i < x.n_elem; ++i)
+  {
+    projectedGradientNorm = std::max(projectedGradientNorm, std::abs(
+        std::min(std::max(x(i) - g(i), lower(i)), upper(i)) - x(i)));
+  }
+
+  if (projectedGradientNorm < this->minGradientNorm)
+  {
+    Info << "L-BFGS-B projected gradient norm too small (terminating "
+        << "successfully)." << std::endl;
+    return false;
+  }
+
+  // Break if the objective is not a number.
+  if (std::isnan(functionValue))
+  {
+    Warn << "L-BFGS-B terminated with objective " << functionValue << "; "
+        << "are the objective and gradient functions implemented correctly?"
+        << std::endl;
+    return false;
+  }
+
+  // If the stored pairs do not give a descent direction (which only happens
+  // through rounding errors), start again without them.
+  arma::vec direction;
+  bool descent = Direction<MatType, GradType>(x, g, lower, upper, workspace,
+      direction) && arma::dot(g, direction) < 0.0;
+  if (!descent && workspace.iterations > 0)
+  {
+    Info << "L-BFGS-B direction is not a descent direction; discarding the "
+        << "history." << std::endl;
+    workspace.iterations = 0;
+    workspace.gram.zeros();
+    descent = Direction<MatType, GradType>(x, g, lower, upper, workspace,
+        direction) && arma::dot(g, direction) < 0.0;
+  }
+
+  if (!descent)
+  {
+    Info << "L-BFGS-B cannot find a descent direction (terminating)."
+        << std::endl;
+    return false;
+  }
+
+  // The largest step along the direction that stays in the box; it is at
+  // least 1, since the end of the direction is in the box.
+  double maxFeasibleStep = arma::datum::inf;
+  for (size_t i = 0; i < x.n_elem; ++i)
+  {
+    if (direction(i) > 0.0)
+    {
+      maxFeasibleStep = std::min(maxFeasibleStep,
+          (upper(i) - x(i)) / direction(i));
+    }
+    else if (direction(i) < 0.0)
+    {
+      maxFeasibleStep = std::min(maxFeasibleStep,
+          (lower(i) - x(i)) / direction(i));
+    }
+  }
+
+  searchDirection.set_size(iterate.n_rows, iterate.n_cols);
+  for (size_t i = 0; i < x.n_elem; ++i)
+    searchDirection(i) = ElemType(direction(i));
+
+  // Save the old iterate and the gradient before stepping.
+  oldIterate = iterate;
+  oldGradient = gradient;
+
+  // The line search is limited to the box for this iteration only.
+  double stepSize; // Set by the line search.
+  const double userMaxStep = this->maxStep;
+  this->maxStep = std::min(userMaxStep, std::max(maxFeasibleStep, 1.0));
+  const bool found = this->lineSearch.Search(*this, f, functionValue, iterate,
+      gradient, workspace.newIterateTmp, searchDirection, stepSize, stop,
+      callbacks...);
+  this->maxStep = userMaxStep;
+
+  if (!found)
+  {
+    iterate = oldIterate;
+    gradient = oldGradient;
+    functionValue = prevFunctionValue;
+
+    // As for a direction that is not a descent direction, the history may be
+    // at fault; otherwise there is nothing else to try.
+    if (workspace.iterations > 0)
+    {
+      Info << "L-BFGS-B line search failed; discarding the history."
+          << std::endl;
+      workspace.iterations = 0;
+      workspace.gram.zeros();
+      return true;
+    }
+
+    Warn << "Line search failed.  Stopping optimization." << std::endl;
+    return false;
+  }
+
+  // Remove the rounding errors of a step to the boundary.
+  for (size_t i = 0; i < x.n_elem; ++i)
+  {
+    iterate(i) = ElemType(std::min(std::max(double(iterate(i)), lower(i)),
+        upper(i)));
+  }
+
+  if (stepSize == 0.0)
+  {
+    Info << "L-BFGS-B step size of 0 (terminating successfully)."
+        << std::endl;
+    return false;
+  }
+
+  // If we can't make progress on the gradient, then we'll also accept
+  // a stable function value.
+  const double denom = std::max(
+      std::max(std::abs(prevFunctionValue), std::abs(functionValue)),
+      (ElemType) 1.0);
+  if ((prevFunctionValue - functionValue) / denom <= this->factr)
+  {
+    Info << "L-BFGS-B function value stable (terminating successfully)."
+        << std::endl;
+    return false;
+  }
+
+  // Only store the pair if it keeps the model positive definite.
+  const double sy = arma::accu((iterate - oldIterate) %
+      (gradient - oldGradient));
+  const double yy = arma::accu(arma::square(gradient - oldGradient));
+  if (sy > std::numeric_limits<ElemType>::epsilon() * yy)
+  {
+    this->UpdateBasisSet(workspace.iterations, iterate, oldIterate, gradient,
+        oldGradient, workspace.history, workspace.gram);
+    ++workspace.iterations;
+  }
+
+  stop |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  return true;
+}
+
+template<typename LineSearchType>
+template<typename MatType, typename GradType>
+bool L_BFGS_BType<LineSearchType>::Direction(
+    const arma::vec& x,
+    const arma::vec& g,
+    const arma::vec& lower,
+    const arma::vec& upper,
+    const WorkspaceType<MatType, GradType>& workspace,
+    arma::vec& direction)
+{
+  // The model is B = theta I - W M W^T, with W = [Y theta S] and
+  //
+  //   M = [ -D  L^T           ]^-1
+  //       [  L  theta S^T S   ]
+  //
+  // where S and Y hold the stored pairs from the oldest to the newest, D is
+  // the diagonal of S^T Y and L its strictly lower triangle (Byrd, Nocedal and
+  // Schnabel, 1994).  All the inner products come from the cached gram
+  // matrix, so only W depends on the number of coordinates.
+  const size_t n = x.n_elem;
+  const size_t numBasis = this->numBasis;
+  const size_t pairs = std::min(workspace.iterations, numBasis);
+  const size_t limit = workspace.iterations - pairs;
+  const double theta = 1.0 / this->ChooseScalingFactor(workspace.iterations,
+      g, workspace.gram);
+
+  arma::uvec pos(pairs);
+  for (size_t i = 0; i < pairs; ++i)
+    pos(i) = (limit + i) % numBasis;
+
+  arma::mat w(n, 2 * pairs);
+  arma::mat mInv(2 * pairs, 2 * pairs, arma::fill::zeros);
+  for (size_t i = 0; i < pairs; ++i)
+  {
+    w.col(i) = arma::conv_to<arma::vec>::from(
+        workspace.history.col(2 * pos(i) + 1));
+    w.col(pairs + i) = theta * arma::conv_to<arma::vec>::from(
+        workspace.history.col(2 * pos(i)));
+
+    for (size_t j = 0; j < pairs; ++j)
+    {
+      const double sy = workspace.gram(2 * pos(i), 2 * pos(j) + 1);
+      if (i == j)
+      {
+        mInv(i, i) = -sy;
+      }
+      else if (i > j)
+      {
+        mInv(pairs + i, j) = sy;
+        mInv(j, pairs + i) = sy;
+      }
+
+      mInv(pairs + i, pairs + j) = theta *
+          workspace.gram(2 * pos(i), 2 * pos(j));
+    }
+  }
+
+  arma::mat m;
+  if (pairs > 0 && !arma::inv(m, mInv))
+    return false;
+
+  // The generalized Cauchy point: follow the projected steepest descent path
+  // x(t) = P(x - t g) through its breakpoints, where the coordinates reach
+  // their bounds, until the model stops decreasing along the current segment.
+  arma::vec breakpoints(n);
+  arma::vec d(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (g(i) < 0.0 && upper(i) < arma::datum::inf)
+      breakpoints(i) = (x(i) - upper(i)) / g(i);
+    else if (g(i) > 0.0 && lower(i) > -arma::datum::inf)
+      breakpoints(i) = (x(i) - lower(i)) / g(i);
+    else
+      breakpoints(i) = arma::datum::inf;
+
+    d(i) = (breakpoints(i) > 0.0) ? -g(i) : 0.0;
+  }
+
+  arma::vec cauchy = x;
+  arma::vec p = (pairs > 0) ? arma::vec(w.t() * d) : arma::vec();
+  arma::vec c(2 * pairs, arma::fill::zeros);
+
+  // The first and second derivatives of the model along the segment.
+  double slope = -arma::dot(d, d);
+  const double minCurvature = std::numeric_limits<double>::epsilon() *
+      (-theta * slope);
+  double curvature = -theta * slope - ((pairs > 0) ?
+      arma::dot(p, m * p) : 0.0);
+  double cauchyStep = (curvature > 0.0) ? -slope / curvature : 0.0;
+
+  const arma::uvec candidates = arma::find(breakpoints > 0.0 &&
+      breakpoints < arma::datum::inf);
+  const arma::uvec order = candidates(arma::sort_index(
+      breakpoints.elem(candidates)));
+  double t = 0.0;
+  for (size_t k = 0; k < order.n_elem; ++k)
+  {
+    const size_t b = order(k);
+    const double segment = breakpoints(b) - t;
+    if (cauchyStep < segment)
+      break;
+
+    // Coordinate b reaches its bound; update the derivatives for the next
+    // segment.
+    cauchy(b) = (d(b) > 0.0) ? upper(b) : lower(b);
+    const double z = cauchy(b) - x(b);
+    c += segment * p;
+    slope += segment * curvature + g(b) * g(b) + theta * g(b) * z;
+    curvature -= theta * g(b) * g(b);
+    if (pairs > 0)
+    {
+      const arma::vec wb = w.row(b).t();
+      const arma::vec mwb = m * wb;
+      slope -= g(b) * arma::dot(mwb, c);
+      curvature -= 2.0 * g(b) * arma::dot(mwb, p) + g(b) * g(b) *
+          arma::dot(wb, mwb);
+      p += g(b) * wb;
+    }
+
+    curvature = std::max(curvature, minCurvature);
+    d(b) = 0.0;
+    cauchyStep = -slope / curvature;
+    t = breakpoints(b);
+  }
+
+  cauchyStep = std::max(cauchyStep, 0.0);
+  t += cauchyStep;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (d(i) != 0.0)
+      cauchy(i) = x(i) + t * d(i);
+  }
+  c += cauchyStep * p;
+
+  // Minimize the model over the free coordinates, starting at the Cauchy
+  // point, with the Sherman-Morrison-Woodbury formula for the inverse of the
+  // reduced model; then go back along that step until it is in the box.
+  arma::vec target = cauchy;
+  const arma::uvec free = arma::find(cauchy > lower && cauchy < upper);
+  if (free.n_elem > 0)
+  {
+    arma::vec r = g.elem(free) + theta * (cauchy.elem(free) -
+        x.elem(free));
+    arma::vec step;
+    if (pairs > 0)
+    {
+      const arma::mat wz = w.rows(free);
+      r -= wz * (m * c);
+
+      const arma::mat middle = arma::eye(2 * pairs, 2 * pairs) -
+          m * (wz.t() * wz) / theta;
+      arma::vec v;
+      if (!arma::solve(v, middle, arma::vec(m * (wz.t() * r))))
+        return false;
+
+      step = -r / theta - wz * v / (theta * theta);
+    }
+    else
+    {
+      step = -r / theta;
+    }
+
+    double alpha = 1.0;
+    for (size_t k = 0; k < free.n_elem; ++k)
+    {
+      const size_t i = free(k);
+      if (step(k) > 0.0)
+        alpha = std::min(alpha, (upper(i) - cauchy(i)) / step(k));
+      else if (step(k) < 0.0)
+        alpha = std::min(alpha, (lower(i) - cauchy(i)) / step(k));
+    }
+
+    target.elem(free) += alpha * step;
+  }
+
+  direction = target - x;
+  return true;
+}
+
+template<typename LineSearchType>
+inline arma::vec L_BFGS_BType<LineSearchType>::Bounds(const arma::mat& bound,
+                                                      const size_t n,
+                                                      const char* name)
+{
+  if (bound.n_elem == 1)
+  {
+    arma::vec result(n);
+    result.fill(bound(0));
+    return result;
+  }
+
+  if (bound.n_elem != n)
+  {
+    std::ostringstream oss;
+    oss << "L_BFGS_B::Optimize(): " << name << " has " << bound.n_elem
+        << " elements, but the coordinates have " << n << " elements";
+    throw std::invalid_argument(oss.str());
+  }
+
+  return arma::vectorise(bound);
+}
+
+} // namespace ens
+
+#endif // ENSMALLEN_LBFGS_LBFGS_B_IMPL_HPP
@@ -37,16 +37,20 @@ namespace ens {
  *     (before giving up).
  * @param minStep The minimum step of the line search.
  * @param maxStep The maximum step of the line search.
+ * @param lineSearch Instantiated line search policy.
  */
-inline L_BFGS::L_BFGS(const size_t numBasis,
-                      const size_t maxIterations,
-                      const double armijoConstant,
-                      const double wolfe,
-                      const double minGradientNorm,
-                      const double factr,
-                      const size_t maxLineSearchTrials,
-                      const double minStep,
-                      const double maxStep) :
+template<typename LineSearchType>
+inline L_BFGSType<LineSearchType>::L_BFGSType(
+    const size_t numBasis,
+    const size_t maxIterations,
+    const double armijoConstant,
+    const double wolfe,
+    const double minGradientNorm,
+    const double factr,
+    const size_t maxLineSearchTrials,
+    const double minStep,
+    const double maxStep,
+    const LineSearchType& lineSearch) :
     numBasis(numBasis),
     maxIterations(maxIterations),
     armijoConstant(armijoConstant),
@@ -56,6 +60,10 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
     maxLineSearchTrials(maxLineSearchTrials),
     minStep(minStep),
     maxStep(maxStep),
+    floatHistory(false),
+    resetPolicy(true),
+    isRestored(false),
+    lineSearch(lineSearch),
     terminate(false)
 {
   // Nothing to do.
@@ -67,26 +75,24 @@ inline L_BFGS::L_BFGS(const size_t numBasis,
  * (1989).
  *
  * @return The calculated scaling factor.
+ * @param iterationNum The iteration number.
  * @param gradient The gradient at the initial point.
- * @param s Differences between the iterate and old iterate matrix.
- * @param y Differences between the gradient and the old gradient matrix.
+ * @param gram Inner products of the stored s and y vectors.
  */
-template<typename MatType, typename CubeType>
-double L_BFGS::ChooseScalingFactor(const size_t iterationNum,
-                                   const MatType& gradient,
-                                   const CubeType& s,
-                                   const CubeType& y)
+template<typename LineSearchType>
+template<typename MatType, typename ElemType>
+double L_BFGSType<LineSearchType>::ChooseScalingFactor(
+    const size_t iterationNum,
+    const MatType& gradient,
+    const arma::Mat<ElemType>& gram)
 {
-  typedef typename CubeType::elem_type CubeElemType;
-
   double scalingFactor = 1.0;
   if (iterationNum > 0)
   {
-    int previousPos = (iterationNum - 1) % numBasis;
-    // Get s and y matrices once instead of multiple times.
-    const arma::Mat<CubeElemType>& sMat = s.slice(previousPos);
-    const arma::Mat<CubeElemType>& yMat = y.slice(previousPos);
-    scalingFactor = dot(sMat, yMat) / dot(yMat, yMat);
+    // The inner products of the last (s, y) pair are already known.
+    const size_t previousPos = (iterationNum - 1) % numBasis;
+    scalingFactor = gram(2 * previousPos, 2 * previousPos + 1) /
+        gram(2 * previousPos + 1, 2 * previousPos + 1);
   }
   else
   {
@@ -102,212 +108,374 @@ double L_BFGS::ChooseScalingFactor(const size_t iterationNum,
  * @param gradient The gradient at the current point.
  * @param iterationNum The iteration number.
  * @param scalingFactor Scaling factor to use (see ChooseScalingFactor_()).
- * @param s Differences between the iterate and old iterate matrix.
- * @param y Differences between the gradient and the old gradient matrix.
+ * @param history The stored s and y vectors (see UpdateBasisSet()).
+ * @param gram Inner products of the stored s and y vectors.
  * @param searchDirection Vector to store search direction in.
  */
-template<typename MatType, typename CubeType>
-void L_BFGS::SearchDirection(const MatType& gradient,
-                             const size_t iterationNum,
-                             const double scalingFactor,
-                             const CubeType& s,
-                             const CubeType& y,
-                             MatType& searchDirection)
+template<typename LineSearchType>
+template<typename MatType, typename HistoryType>
+void L_BFGSType<LineSearchType>::SearchDirection(
+    const MatType& gradient,
+    const size_t iterationNum,
+    const double scalingFactor,
+    const HistoryType& history,
+    const arma::Mat<typename MatType::elem_type>& gram,
+    MatType& searchDirection)
 {
-  // Start from this point.
-  searchDirection = gradient;
+  typedef typename MatType::elem_type ElemType;
+  typedef typename HistoryType::elem_type HistoryElemType;
 
-  // See "A Recursive Formula to Compute H * g" in "Updating quasi-Newton
-  // matrices with limited storage" (Nocedal, 1980).
-  typedef typename CubeType::elem_type CubeElemType;
+  // We use the compact representation of the inverse Hessian approximation of
+  // Byrd, Nocedal and Schnabel (1994),
+  //
+  //   H = gamma I + [S gamma Y] [ R^-T (D + gamma Y^T Y) R^-1   -R^-T ] [ S^T ]
+  //                             [ -R^-1                          0    ] [ Y^T ]
+  //
+  // where S and Y hold the stored pairs from the oldest to the newest, R is the
+  // upper triangle of S^T Y and D its diagonal.  All inner products between
+  // the stored vectors are cached, so the only O(n) work is one product of the
+  // history with the gradient and one to form the direction; everything else
+  // works on (numBasis x numBasis) matrices.  This gives the same direction
+  // as the two-loop recursion of Nocedal (1980).
+  const size_t pairs = std::min(iterationNum, numBasis);
+  const size_t limit = iterationNum - pairs;
 
-  // Temporary variables.
-  arma::Col<CubeElemType> rho(numBasis);
-  arma::Col<CubeElemType> alpha(numBasis);
+  arma::Col<ElemType> gradientDots;
+  Project(history, 2 * pairs, gradient, gradientDots);
 
-  size_t limit = (numBasis > iterationNum) ? 0 : (iterationNum - numBasis);
-  for (size_t i = iterationNum; i != limit; i--)
+  // The position of the i'th oldest pair in the history.
+  arma::uvec pos(pairs);
+  for (size_t i = 0; i < pairs; ++i)
+    pos(i) = (limit + i) % numBasis;
+
+  // w = R^-1 S^T g.
+  arma::Col<ElemType> w(pairs);
+  for (size_t i = pairs; i > 0; --i)
   {
-    int translatedPosition = (i + (numBasis - 1)) % numBasis;
-    rho[iterationNum - i] = 1.0 / arma::dot(y.slice(translatedPosition),
-                                            s.slice(translatedPosition));
-    alpha[iterationNum - i] = rho[iterationNum - i] *
-        arma::dot(s.slice(translatedPosition), searchDirection);
-    searchDirection -= alpha[iterationNum - i] * y.slice(translatedPosition);
+    ElemType sum = gradientDots(2 * pos(i - 1));
+    for (size_t j = i; j < pairs; ++j)
+      sum -= gram(2 * pos(i - 1), 2 * pos(j) + 1) * w(j);
+    w(i - 1) = sum / gram(2 * pos(i - 1), 2 * pos(i - 1) + 1);
   }
 
-  searchDirection *= scalingFactor;
+  // v = R^-T ((D + gamma Y^T Y) w - gamma Y^T g).
+  arma::Col<ElemType> v(pairs);
+  for (size_t i = 0; i < pairs; ++i)
+  {
+    ElemType yDot = 0;
+    for (size_t j = 0; j < pairs; ++j)
+      yDot += gram(2 * pos(i) + 1, 2 * pos(j) + 1) * w(j);
 
-  for (size_t i = limit; i < iterationNum; i++)
+    ElemType sum = gram(2 * pos(i), 2 * pos(i) + 1) * w(i) +
+        scalingFactor * (yDot - gradientDots(2 * pos(i) + 1));
+    for (size_t j = 0; j < i; ++j)
+      sum -= gram(2 * pos(j), 2 * pos(i) + 1) * v(j);
+    v(i) = sum / gram(2 * pos(i), 2 * pos(i) + 1);
+  }
+
+  // H g = gamma g + S v - gamma Y w.
+  arma::Col<HistoryElemType> coefficients(2 * pairs);
+  for (size_t i = 0; i < pairs; ++i)
   {
-    int translatedPosition = i % numBasis;
-    double beta = rho[iterationNum - i - 1] *
-        arma::dot(y.slice(translatedPosition), searchDirection);
-    searchDirection += (alpha[iterationNum - i - 1] - beta) *
-        s.slice(translatedPosition);
+    coefficients(2 * pos(i)) = HistoryElemType(v(i));
+    coefficients(2 * pos(i) + 1) = HistoryElemType(-scalingFactor * w(i));
   }
 
   // Negate the search direction so that it is a descent direction.
-  searchDirection *= -1;
+  Combine(history, 2 * pairs, coefficients, (ElemType) scalingFactor, gradient,
+      searchDirection);
 }
 
 /**
- * Update the y and s matrices, which store the differences between
- * the iterate and old iterate and the differences between the gradient and the
- * old gradient, respectively.
+ * Update the stored s and y vectors, which are the differences between the
+ * iterate and old iterate and the differences between the gradient and the old
+ * gradient, respectively, as well as their inner products.  The vectors of
+ * pair i are stored in columns 2 * i and 2 * i + 1 of the history, so that the
+ * products with all of them are single matrix products.
  *
  * @param iterationNum Iteration number.
  * @param iterate Current point.
  * @param oldIterate Point at last iteration.
  * @param gradient Gradient at current point (iterate).
  * @param oldGradient Gradient at last iteration point (oldIterate).
- * @param s Differences between the iterate and old iterate matrix.
- * @param y Differences between the gradient and the old gradient matrix.
+ * @param history The stored s and y vectors, one per column.
+ * @param gram Inner products of the stored s and y vectors.
  */
-template<typename MatType, typename GradType, typename CubeType>
-void L_BFGS::UpdateBasisSet(const size_t iterationNum,
-                            const MatType& iterate,
-                            const MatType& oldIterate,
-                            const GradType& gradient,
-                            const GradType& oldGradient,
-                            CubeType& s,
-                            CubeType& y)
+template<typename LineSearchType>
+template<typename MatType, typename GradType, typename HistoryType>
+void L_BFGSType<LineSearchType>::UpdateBasisSet(
+    const size_t iterationNum,
+    const MatType& iterate,
+    const MatType& oldIterate,
+    const GradType& gradient,
+    const GradType& oldGradient,
+    HistoryType& history,
+    arma::Mat<typename MatType::elem_type>& gram)
 {
   // Overwrite a certain position instead of pushing everything in the vector
   // back one position.
-  int overwritePos = iterationNum % numBasis;
-  s.slice(overwritePos) = iterate - oldIterate;
-  y.slice(overwritePos) = gradient - oldGradient;
+  const size_t overwritePos = iterationNum % numBasis;
+  StoreDifference(iterate, oldIterate, history, 2 * overwritePos);
+  StoreDifference(gradient, oldGradient, history, 2 * overwritePos + 1);
+
+  // Compute the inner products of the new pair with all stored vectors
+  // (including itself) at once.
+  const size_t pairs = std::min(iterationNum + 1, numBasis);
+  arma::Mat<typename MatType::elem_type> dots;
+  InnerProducts(history, 2 * pairs, 2 * overwritePos, dots);
+
+  gram.submat(0, 2 * overwritePos, 2 * pairs - 1, 2 * overwritePos + 1) = dots;
+  gram.submat(2 * overwritePos, 0, 2 * overwritePos + 1, 2 * pairs - 1) =
+      dots.t();
 }
 
-/**
- * Perform a back-tracking line search along the search direction to calculate a
- * step size satisfying the Wolfe conditions.
- *
- * @param function Function to optimize.
- * @param functionValue Value of the function at the initial point.
- * @param iterate The initial point to begin the line search from.
- * @param gradient The gradient at the initial point.
- * @param searchDirection A vector specifying the search direction.
- * @param finalStepSize The resulting step size used.
- * @param callbacks Callback functions.
- *
- * @return false if no step size is suitable, true otherwise.
- */
-template<typename FunctionType,
-         typename ElemType,
-         typename MatType,
-         typename GradType,
-         typename... CallbackTypes>
-bool L_BFGS::LineSearch(FunctionType& function,
-                        ElemType& functionValue,
-                        MatType& iterate,
-                        GradType& gradient,
-                        MatType& newIterateTmp,
-                        const GradType& searchDirection,
-                        double& finalStepSize,
-                        CallbackTypes&... callbacks)
+template<typename LineSearchType>
+template<typename ElemType, typename HistoryElemType>
+inline void L_BFGSType<LineSearchType>::StoreDifference(
+    const arma::Mat<ElemType>& a,
+    const arma::Mat<ElemType>& b,
+    arma::Mat<HistoryElemType>& history,
+    const size_t column)
+{
+  const ElemType* aMem = a.memptr();
+  const ElemType* bMem = b.memptr();
+  HistoryElemType* outMem = history.colptr(column);
+
+  ENS_PRAGMA_OMP_SIMD
+  for (size_t i = 0; i < a.n_elem; ++i)
+    outMem[i] = HistoryElemType(aMem[i] - bMem[i]);
+}
+
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::StoreDifference(
+    const arma::SpMat<ElemType>& a,
+    const arma::SpMat<ElemType>& b,
+    arma::Mat<ElemType>& history,
+    const size_t column)
 {
-  // Default first step size of 1.0.
-  double stepSize = 1.0;
-  finalStepSize = 0.0; // Set only when we take the step.
+  arma::Mat<ElemType> out(history.colptr(column), a.n_rows, a.n_cols, false,
+      true);
+  out = a - b;
+}
 
-  // The initial linear term approximation in the direction of the
-  // search direction.
-  ElemType initialSearchDirectionDotGradient =
-      arma::dot(gradient, searchDirection);
+template<typename LineSearchType>
+template<typename HistoryElemType, typename ElemType>
+inline void L_BFGSType<LineSearchType>::InnerProducts(
+    const arma::Mat<HistoryElemType>& history,
+    const size_t columns,
+    const size_t first,
+    arma::Mat<ElemType>& out)
+{
+  typedef typename AccumulatorType<HistoryElemType>::type AccumulatorElemType;
 
-  // If it is not a descent direction, just report failure.
-  if (initialSearchDirectionDotGradient > 0.0)
+  if (std::is_same<AccumulatorElemType, HistoryElemType>::value)
   {
-    Warn << "L-BFGS line search direction is not a descent direction "
-        << "(terminating)!" << std::endl;
-    return false;
+    const arma::Mat<HistoryElemType> basis(
+        const_cast<HistoryElemType*>(history.memptr()), history.n_rows,
+        columns, false, true);
+    const arma::Mat<HistoryElemType> pair(
+        const_cast<HistoryElemType*>(history.colptr(first)), history.n_rows,
+        2, false, true);
+    out = arma::conv_to<arma::Mat<ElemType>>::from(basis.t() * pair);
+    return;
   }
 
-  // Save the initial function value.
-  ElemType initialFunctionValue = functionValue;
-
-  // Unit linear approximation to the decrease in function value.
-  ElemType linearApproxFunctionValueDecrease = armijoConstant *
-      initialSearchDirectionDotGradient;
+  // A single precision history keeps its inner products accurate by
+  // accumulating them in double precision.
+  out.set_size(columns, 2);
+  for (size_t k = 0; k < 2; ++k)
+  {
+    const HistoryElemType* b = history.colptr(first + k);
+    for (size_t j = 0; j < columns; ++j)
+    {
+      const HistoryElemType* a = history.colptr(j);
+      AccumulatorElemType sum = 0;
+      ENS_PRAGMA_OMP_SIMD_SUM(sum)
+      for (size_t i = 0; i < history.n_rows; ++i)
+        sum += AccumulatorElemType(a[i]) * AccumulatorElemType(b[i]);
+      out(j, k) = ElemType(sum);
+    }
+  }
+}
 
-  // The number of iteration in the search.
-  size_t numIterations = 0;
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::Project(
+    const arma::Mat<ElemType>& history,
+    const size_t columns,
+    const arma::Mat<ElemType>& x,
+    arma::Col<ElemType>& out)
+{
+  const arma::Mat<ElemType> basis(const_cast<ElemType*>(history.memptr()),
+      history.n_rows, columns, false, true);
+  const arma::Col<ElemType> xCol(const_cast<ElemType*>(x.memptr()), x.n_elem,
+      false, true);
+  out = basis.t() * xCol;
+}
 
-  // Armijo step size scaling factor for increase and decrease.
-  const double inc = 2.1;
-  const double dec = 0.5;
-  double width = 0;
-  double bestStepSize = 1.0;
-  ElemType bestObjective = std::numeric_limits<ElemType>::max();
+template<typename LineSearchType>
+template<typename HistoryElemType, typename ElemType>
+inline void L_BFGSType<LineSearchType>::Project(
+    const arma::Mat<HistoryElemType>& history,
+    const size_t columns,
+    const arma::Mat<ElemType>& x,
+    arma::Col<ElemType>& out)
+{
+  typedef typename AccumulatorType<HistoryElemType>::type AccumulatorElemType;
 
-  while (true)
+  // The products are accumulated in double precision, with x kept in its own
+  // precision.
+  const ElemType* xMem = x.memptr();
+  out.set_size(columns);
+  for (size_t j = 0; j < columns; ++j)
   {
-    // Perform a step and evaluate the gradient and the function values at that
-    // point.
-    newIterateTmp = iterate;
-    newIterateTmp += stepSize * searchDirection;
-    functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+    const HistoryElemType* a = history.colptr(j);
+    AccumulatorElemType sum = 0;
+    ENS_PRAGMA_OMP_SIMD_SUM(sum)
+    for (size_t i = 0; i < x.n_elem; ++i)
+      sum += AccumulatorElemType(a[i]) * AccumulatorElemType(xMem[i]);
+    out(j) = ElemType(sum);
+  }
+}
 
-    terminate |= Callback::EvaluateWithGradient(*this, function, newIterateTmp,
-        functionValue, gradient, callbacks...);
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::Project(
+    const arma::Mat<ElemType>& history,
+    const size_t columns,
+    const arma::SpMat<ElemType>& x,
+    arma::Col<ElemType>& out)
+{
+  const arma::Mat<ElemType> basis(const_cast<ElemType*>(history.memptr()),
+      history.n_rows, columns, false, true);
 
-    if (functionValue < bestObjective)
-    {
-      bestStepSize = stepSize;
-      bestObjective = functionValue;
-    }
-    numIterations++;
+  // Multiply from the left to avoid forming the transpose of the history.
+  const arma::Mat<ElemType> projection = arma::vectorise(x).t() * basis;
+  out = projection.t();
+}
 
-    if (functionValue > initialFunctionValue + stepSize *
-        linearApproxFunctionValueDecrease)
-    {
-      width = dec;
-    }
-    else
-    {
-      // Check Wolfe's condition.
-      ElemType searchDirectionDotGradient = arma::dot(gradient,
-          searchDirection);
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::Combine(
+    const arma::Mat<ElemType>& history,
+    const size_t columns,
+    const arma::Col<ElemType>& coefficients,
+    const ElemType c,
+    const arma::Mat<ElemType>& x,
+    arma::Mat<ElemType>& out)
+{
+  const arma::Mat<ElemType> basis(const_cast<ElemType*>(history.memptr()),
+      history.n_rows, columns, false, true);
+  out.set_size(x.n_rows, x.n_cols);
+  arma::Col<ElemType> outCol(out.memptr(), out.n_elem, false, true);
+  const arma::Col<ElemType> xCol(const_cast<ElemType*>(x.memptr()), x.n_elem,
+      false, true);
+  outCol = basis * (-coefficients);
+  outCol -= c * xCol;
+}
 
-      if (searchDirectionDotGradient < wolfe *
-          initialSearchDirectionDotGradient)
-      {
-        width = inc;
-      }
-      else
-      {
-        if (searchDirectionDotGradient > -wolfe *
-            initialSearchDirectionDotGradient)
-        {
-          width = dec;
-        }
-        else
-        {
-          break;
-        }
-      }
-    }
+template<typename LineSearchType>
+template<typename HistoryElemType, typename ElemType>
+inline void L_BFGSType<LineSearchType>::Combine(
+    const arma::Mat<HistoryElemType>& history,
+    const size_t columns,
+    const arma::Col<HistoryElemType>& coefficients,
+    const ElemType c,
+    const arma::Mat<ElemType>& x,
+    arma::Mat<ElemType>& out)
+{
+  const arma::Mat<HistoryElemType> basis(
+      const_cast<HistoryElemType*>(history.memptr()), history.n_rows, columns,
+      false, true);
+  const arma::Col<HistoryElemType> direction = basis * coefficients;
+  out.set_size(x.n_rows, x.n_cols);
 
-    // Terminate when the step size gets too small or too big or it
-    // exceeds the max number of iterations.
-    const bool cond1 = (stepSize < minStep);
-    const bool cond2 = (stepSize > maxStep);
-    const bool cond3 = (numIterations >= maxLineSearchTrials);
-    if (cond1 || cond2 || cond3)
-      break;
+  const HistoryElemType* directionMem = direction.memptr();
+  const ElemType* xMem = x.memptr();
+  ElemType* outMem = out.memptr();
 
-    // Scale the step size.
-    stepSize *= width;
-  }
+  ENS_PRAGMA_OMP_SIMD
+  for (size_t i = 0; i < x.n_elem; ++i)
+    outMem[i] = -(ElemType(directionMem[i]) + c * xMem[i]);
+}
 
-  // Move to the new iterate.
-  iterate += bestStepSize * searchDirection;
-  finalStepSize = bestStepSize;
-  return true;
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::Combine(
+    const arma::Mat<ElemType>& history,
+    const size_t columns,
+    const arma::Col<ElemType>& coefficients,
+    const ElemType c,
+    const arma::SpMat<ElemType>& x,
+    arma::SpMat<ElemType>& out)
+{
+  const arma::Mat<ElemType> basis(const_cast<ElemType*>(history.memptr()),
+      history.n_rows, columns, false, true);
+  arma::Mat<ElemType> direction = arma::reshape(basis * (-coefficients),
+      x.n_rows, x.n_cols);
+  direction -= c * x;
+  out = direction;
+}
+
+#ifdef ENS_HAVE_COOT
+
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::StoreDifference(
+    const coot::Mat<ElemType>& a,
+    const coot::Mat<ElemType>& b,
+    coot::Mat<ElemType>& history,
+    const size_t column)
+{
+  history.col(column) = coot::vectorise(a - b);
+}
+
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::InnerProducts(
+    const coot::Mat<ElemType>& history,
+    const size_t columns,
+    const size_t first,
+    arma::Mat<ElemType>& out)
+{
+  const coot::Mat<ElemType> dots = history.cols(0, columns - 1).t() *
+      history.cols(first, first + 1);
+  out = arma::Mat<ElemType>(dots);
+}
+
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::Project(
+    const coot::Mat<ElemType>& history,
+    const size_t columns,
+    const coot::Mat<ElemType>& x,
+    arma::Col<ElemType>& out)
+{
+  const coot::Mat<ElemType> dots = history.cols(0, columns - 1).t() *
+      coot::vectorise(x);
+  out = arma::vectorise(arma::Mat<ElemType>(dots));
+}
+
+template<typename LineSearchType>
+template<typename ElemType>
+inline void L_BFGSType<LineSearchType>::Combine(
+    const coot::Mat<ElemType>& history,
+    const size_t columns,
+    const arma::Col<ElemType>& coefficients,
+    const ElemType c,
+    const coot::Mat<ElemType>& x,
+    coot::Mat<ElemType>& out)
+{
+  // Only the (small) coefficients are copied to the device.
+  const coot::Mat<ElemType> deviceCoefficients(
+      arma::Mat<ElemType>(-coefficients));
+  out = coot::reshape(history.cols(0, columns - 1) * deviceCoefficients,
+      x.n_rows, x.n_cols) - c * x;
 }
 
+#endif
+
 /**
  * Use L_BFGS to optimize the given function, starting at the given iterate
  * point and performing no more than the specified number of maximum iterations.
@@ -318,15 +486,17 @@ bool L_BFGS::LineSearch(FunctionType& function,
  * @param iterate Starting point (will be modified)
  * @param callbacks Callback functions.
  */
+template<typename LineSearchType>
 template<typename FunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
-typename std::enable_if<IsArmaType<GradType>::value,
+typename std::enable_if<IsMatrixType<GradType>::value,
 typename MatType::elem_type>::type
-L_BFGS::Optimize(FunctionType& function,
-                 MatType& iterateIn,
-                 CallbackTypes&&... callbacks)
+L_BFGSType<LineSearchType>::Optimize(
+    FunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
 {
   // Convenience typedefs.
   typedef typename MatType::elem_type ElemType;
@@ -346,121 +516,527 @@ L_BFGS::Optimize(FunctionType& function,
 
   BaseMatType& iterate = (BaseMatType&) iterateIn;
 
-  // Ensure that the cubes holding past iterations' information are the right
-  // size.  Also set the current best point value to the maximum.
-  const size_t rows = iterate.n_rows;
-  const size_t cols = iterate.n_cols;
+  // The history can only be stored in single precision for dense matrices.
+  typedef typename std::conditional<
+      std::is_base_of<arma::Mat<ElemType>, BaseMatType>::value &&
+      std::is_base_of<arma::Mat<ElemType>, BaseGradType>::value,
+      float, ElemType>::type FloatHistoryElemType;
 
-  BaseMatType newIterateTmp(rows, cols);
-  arma::Cube<ElemType> s(rows, cols, numBasis);
-  arma::Cube<ElemType> y(rows, cols, numBasis);
+  // The workspace is kept, so that the next call can use its history if
+  // ResetPolicy() is false or the history was restored by LoadState().
+  const bool keepHistory = !resetPolicy || isRestored;
+  isRestored = false;
+  if (floatHistory)
+  {
+    Workspace<BaseMatType, BaseGradType, FloatHistoryElemType>& workspace =
+        keptWorkspace.template Get<BaseMatType, BaseGradType,
+        FloatHistoryElemType>();
+    if (!keepHistory)
+      workspace.iterations = 0;
 
-  // The old iterate to be saved.
-  BaseMatType oldIterate(iterate.n_rows, iterate.n_cols);
-  oldIterate.zeros();
+    return OptimizeWithHistory<FloatHistoryElemType, FullFunctionType,
+        BaseMatType, BaseGradType>(f, iterate, workspace, callbacks...);
+  }
+  else
+  {
+    Workspace<BaseMatType, BaseGradType, ElemType>& workspace =
+        keptWorkspace.template Get<BaseMatType, BaseGradType, ElemType>();
+    if (!keepHistory)
+      workspace.iterations = 0;
 
-  // Whether to optimize until convergence.
-  bool optimizeUntilConvergence = (maxIterations == 0);
+    return OptimizeWithHistory<ElemType, FullFunctionType, BaseMatType,
+        BaseGradType>(f, iterate, workspace, callbacks...);
+  }
+}
+
+/**
+ * Optimize a batch of independent problems, one range of problems per thread.
+ *
+ * @param functions Functions to optimize.
+ * @param iterates Starting points, one per function (will be modified).
+ * @param objectives Vector to store the final objectives into.
+ */
+template<typename LineSearchType>
+template<typename FunctionType, typename MatType, typename GradType>
+void L_BFGSType<LineSearchType>::Optimize(
+    std::vector<FunctionType>& functions,
+    std::vector<MatType>& iterates,
+    arma::Col<typename MatType::elem_type>& objectives)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  typedef typename std::conditional<
+      std::is_base_of<arma::Mat<ElemType>, BaseMatType>::value &&
+      std::is_base_of<arma::Mat<ElemType>, BaseGradType>::value,
+      float, ElemType>::type FloatHistoryElemType;
 
-  // The gradient: the current and the old.
-  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
-  gradient.zeros();
-  BaseGradType oldGradient(iterate.n_rows, iterate.n_cols);
-  oldGradient.zeros();
+  if (functions.size() != iterates.size())
+  {
+    std::ostringstream oss;
+    oss << "L_BFGS::Optimize(): expected one iterate per function, but got "
+        << functions.size() << " functions and " << iterates.size()
+        << " iterates";
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t numProblems = functions.size();
+  objectives.set_size(numProblems);
+  if (numProblems == 0)
+    return;
 
-  // The search direction.
-  BaseGradType searchDirection(iterate.n_rows, iterate.n_cols);
-  searchDirection.zeros();
+  const size_t numRanges = std::min(MaxThreads(), numProblems);
+  const size_t rangeSize = (numProblems + numRanges - 1) / numRanges;
+
+  ParallelFor(numRanges, [&](const size_t r)
+  {
+    // Each range gets its own optimizer, since the termination flag is part
+    // of its state, and its own storage, which is reused for every problem.
+    L_BFGSType optimizer(*this);
+    Workspace<BaseMatType, BaseGradType, ElemType> workspace;
+    Workspace<BaseMatType, BaseGradType, FloatHistoryElemType> floatWorkspace;
+
+    const size_t end = std::min((r + 1) * rangeSize, numProblems);
+    for (size_t i = r * rangeSize; i < end; ++i)
+    {
+      FullFunctionType& f = static_cast<FullFunctionType&>(functions[i]);
+      BaseMatType& iterate = (BaseMatType&) iterates[i];
+
+      optimizer.terminate = false;
+      workspace.iterations = 0;
+      floatWorkspace.iterations = 0;
+      if (floatHistory)
+      {
+        objectives(i) = optimizer.template OptimizeWithHistory<
+            FloatHistoryElemType, FullFunctionType, BaseMatType,
+            BaseGradType>(f, iterate, floatWorkspace);
+      }
+      else
+      {
+        objectives(i) = optimizer.template OptimizeWithHistory<ElemType,
+            FullFunctionType, BaseMatType, BaseGradType>(f, iterate,
+            workspace);
+      }
+    }
+  });
+}
+
+/**
+ * Run the optimization, storing the s and y vectors with the given element
+ * type.
+ *
+ * @param f Function to optimize.
+ * @param iterate Starting point (will be modified)
+ * @param workspace Storage for the history and the temporaries.
+ * @param callbacks Callback functions.
+ */
+template<typename LineSearchType>
+template<typename HistoryElemType,
+         typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename MatType::elem_type L_BFGSType<LineSearchType>::OptimizeWithHistory(
+    FunctionType& f,
+    MatType& iterate,
+    Workspace<MatType, GradType, HistoryElemType>& workspace,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  size_t offset = PrepareWorkspace(iterate, workspace);
+
+  // Whether to optimize until convergence.
+  bool optimizeUntilConvergence = (maxIterations == 0);
 
   // The initial function value and gradient.
-  ElemType functionValue = f.EvaluateWithGradient(iterate, gradient);
+  ElemType functionValue = f.EvaluateWithGradient(iterate, workspace.gradient);
 
   terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
-        functionValue, gradient, callbacks...);
-
-  ElemType prevFunctionValue = functionValue;
+        functionValue, workspace.gradient, callbacks...);
 
   // The main optimization loop.
   terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
   for (size_t itNum = 0; (optimizeUntilConvergence || (itNum != maxIterations))
       && !terminate; ++itNum)
   {
-    prevFunctionValue = functionValue;
-
-    // Break when the norm of the gradient becomes too small.
-    //
-    // But don't do this on the first iteration to ensure we always take at
-    // least one descent step.
-    if (arma::norm(gradient, 2) < minGradientNorm)
-    {
-      Info << "L-BFGS gradient norm too small (terminating successfully)."
-          << std::endl;
+    if (!Iteration(f, iterate, workspace, functionValue, itNum, offset,
+        terminate, callbacks...))
       break;
-    }
+  } // End of the optimization loop.
 
-    // Break if the objective is not a number.
-    if (std::isnan(functionValue))
-    {
-      Warn << "L-BFGS terminated with objective " << functionValue << "; "
-          << "are the objective and gradient functions implemented correctly?"
-          << std::endl;
-      break;
-    }
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return functionValue;
+}
 
-    // Choose the scaling factor.
-    double scalingFactor = ChooseScalingFactor(itNum, gradient, s, y);
-    if (scalingFactor == 0.0)
-    {
-      Info << "L-BFGS scaling factor computed as 0 (terminating successfully)."
-          << std::endl;
-      break;
-    }
+/**
+ * Size the storage of the given workspace for the given iterate, and return the
+ * number of pairs of a previous run that can be used.
+ *
+ * @param iterate Starting point.
+ * @param workspace Storage for the history and the temporaries.
+ * @return Number of stored pairs that are used.
+ */
+template<typename LineSearchType>
+template<typename HistoryElemType, typename MatType, typename GradType>
+size_t L_BFGSType<LineSearchType>::PrepareWorkspace(
+    const MatType& iterate,
+    Workspace<MatType, GradType, HistoryElemType>& workspace)
+{
+  // Ensure that the matrices holding past iterations' information are the right
+  // size.  If the workspace was used before for a problem of the same size,
+  // none of this allocates memory.
+  const size_t rows = iterate.n_rows;
+  const size_t cols = iterate.n_cols;
 
-    // Build an approximation to the Hessian and choose the search
-    // direction for the current iteration.
-    SearchDirection(gradient, itNum, scalingFactor, s, y, searchDirection);
+  workspace.newIterateTmp.set_size(rows, cols);
 
-    // Save the old iterate and the gradient before stepping.
-    oldIterate = iterate;
-    oldGradient = gradient;
+  // The pairs stored by a previous run are only used if they have the right
+  // size; the iterations of this run then continue their numbering, so that
+  // the positions in the history stay consistent.
+  size_t offset = workspace.iterations;
+  if (offset == 0 || workspace.history.n_rows != rows * cols ||
+      workspace.history.n_cols != 2 * numBasis)
+  {
+    offset = 0;
+    workspace.historyMemory.Zeros(workspace.history, rows * cols,
+        2 * numBasis);
+    workspace.gram.zeros(2 * numBasis, 2 * numBasis);
+  }
+  workspace.iterations = offset;
 
-    double stepSize; // Set by LineSearch().
-    if (!LineSearch(f, functionValue, iterate, gradient, newIterateTmp,
-        searchDirection, stepSize, callbacks...))
-    {
-      Warn << "Line search failed.  Stopping optimization." << std::endl;
-      break; // The line search failed; nothing else to try.
-    }
+  // The old iterate, the gradients, and the search direction.
+  workspace.oldIterate.zeros(rows, cols);
+  workspace.gradient.zeros(rows, cols);
+  workspace.oldGradient.zeros(rows, cols);
+  workspace.searchDirection.zeros(rows, cols);
 
-    // It is possible that the difference between the two coordinates is zero.
-    // In this case we terminate successfully.
-    if (stepSize == 0.0)
-    {
-      Info << "L-BFGS step size of 0 (terminating successfully)."
-          << std::endl;
-      break;
-    }
+  return offset;
+}
+
+/**
+ * Run one iteration of L-BFGS: choose the search direction, run the line
+ * search, and update the history.  functionValue and the gradient in the
+ * workspace hold the objective and the gradient of the iterate before and after
+ * the iteration.
+ *
+ * @param f Function to optimize.
+ * @param iterate Current point (will be modified).
+ * @param workspace Storage for the history and the temporaries.
+ * @param functionValue Objective of the current point.
+ * @param itNum Number of the iteration in this run.
+ * @param offset Number of pairs of a previous run that are used.
+ * @param stop Set to true if a callback requested termination.
+ * @param callbacks Callback functions.
+ * @return false if the optimization has converged or can't make progress.
+ */
+template<typename LineSearchType>
+template<typename HistoryElemType,
+         typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+bool L_BFGSType<LineSearchType>::Iteration(
+    FunctionType& f,
+    MatType& iterate,
+    Workspace<MatType, GradType, HistoryElemType>& workspace,
+    typename MatType::elem_type& functionValue,
+    const size_t itNum,
+    size_t& offset,
+    bool& stop,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  MatType& newIterateTmp = workspace.newIterateTmp;
+  typename DenseMatType<MatType, HistoryElemType>::type& history =
+      workspace.history;
+  arma::Mat<ElemType>& gram = workspace.gram;
+  MatType& oldIterate = workspace.oldIterate;
+  GradType& gradient = workspace.gradient;
+  GradType& oldGradient = workspace.oldGradient;
+  GradType& searchDirection = workspace.searchDirection;
+
+  const ElemType prevFunctionValue = functionValue;
+
+  // Break when the norm of the gradient becomes too small.
+  //
+  // But don't do this on the first iteration to ensure we always take at
+  // least one descent step.
+  if (norm(gradient, 2) < minGradientNorm)
+  {
+    Info << "L-BFGS gradient norm too small (terminating successfully)."
+        << std::endl;
+    return false;
+  }
+
+  // Break if the objective is not a number.
+  if (std::isnan(functionValue))
+  {
+    Warn << "L-BFGS terminated with objective " << functionValue << "; "
+        << "are the objective and gradient functions implemented correctly?"
+        << std::endl;
+    return false;
+  }
+
+  // Choose the scaling factor.
+  double scalingFactor = ChooseScalingFactor(offset + itNum, gradient, gram);
+
+  // The pairs of a previous run describe the curvature of a different
+  // function; if they do not give a positive scaling factor, they are
+  // dropped.
+  if (itNum == 0 && offset > 0 &&
+      !(scalingFactor > 0.0 && std::isfinite(scalingFactor)))
+  {
+    offset = 0;
+    workspace.iterations = 0;
+    gram.zeros();
+    scalingFactor = ChooseScalingFactor(0, gradient, gram);
+  }
+
+  if (scalingFactor == 0.0)
+  {
+    Info << "L-BFGS scaling factor computed as 0 (terminating successfully)."
+        << std::endl;
+    return false;
+  }
+
+  // Build an approximation to the Hessian and choose the search
+  // direction for the current iteration.
+  SearchDirection(gradient, offset + itNum, scalingFactor, history, gram,
+      searchDirection);
+
+  // Likewise, the pairs of a previous run are dropped if they do not give a
+  // descent direction.
+  if (itNum == 0 && offset > 0 && dot(gradient, searchDirection) >= 0)
+  {
+    offset = 0;
+    workspace.iterations = 0;
+    gram.zeros();
+    scalingFactor = ChooseScalingFactor(0, gradient, gram);
+    SearchDirection(gradient, 0, scalingFactor, history, gram,
+        searchDirection);
+  }
+
+  // Save the old iterate and the gradient before stepping.
+  oldIterate = iterate;
+  oldGradient = gradient;
+
+  // The line search leaves the objective and the gradient of the new
+  // iterate in functionValue and gradient.
+  double stepSize; // Set by the line search.
+  if (!lineSearch.Search(*this, f, functionValue, iterate, gradient,
+      newIterateTmp, searchDirection, stepSize, stop, callbacks...))
+  {
+    Warn << "Line search failed.  Stopping optimization." << std::endl;
+    return false; // The line search failed; nothing else to try.
+  }
+
+  // It is possible that the difference between the two coordinates is zero.
+  // In this case we terminate successfully.
+  if (stepSize == 0.0)
+  {
+    Info << "L-BFGS step size of 0 (terminating successfully)."
+        << std::endl;
+    return false;
+  }
+
+  // If we can't make progress on the gradient, then we'll also accept
+  // a stable function value.
+  const double denom = std::max(
+      std::max(std::abs(prevFunctionValue), std::abs(functionValue)),
+      (ElemType) 1.0);
+  if ((prevFunctionValue - functionValue) / denom <= factr)
+  {
+    Info << "L-BFGS function value stable (terminating successfully)."
+        << std::endl;
+    return false;
+  }
+
+  // Overwrite an old basis set.
+  UpdateBasisSet(offset + itNum, iterate, oldIterate, gradient, oldGradient,
+      history, gram);
+  workspace.iterations = offset + itNum + 1;
+
+  stop |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  return true;
+}
+
+//! Start an optimization that is run with Step().
+template<typename LineSearchType>
+template<typename FunctionType, typename MatType, typename GradType>
+typename L_BFGSType<LineSearchType>::template State<FunctionType, MatType,
+    GradType>
+L_BFGSType<LineSearchType>::Begin(FunctionType& function, MatType& iterate)
+{
+  typedef State<FunctionType, MatType, GradType> StateType;
+  typedef typename StateType::BaseMatType BaseMatType;
+  typedef typename StateType::BaseGradType BaseGradType;
 
-    // If we can't make progress on the gradient, then we'll also accept
-    // a stable function value.
-    const double denom = std::max(
-        std::max(std::abs(prevFunctionValue), std::abs(functionValue)),
-        (ElemType) 1.0);
-    if ((prevFunctionValue - functionValue) / denom <= factr)
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<typename StateType::FullFunctionType,
+      BaseMatType, BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  StateType state(function, iterate);
+  state.offset = PrepareWorkspace(*state.iterate, state.workspace);
+  state.objective = state.function->EvaluateWithGradient(*state.iterate,
+      state.workspace.gradient);
+  return state;
+}
+
+//! Run up to n iterations of an optimization started with Begin().
+template<typename LineSearchType>
+template<typename FunctionType, typename MatType, typename GradType>
+bool L_BFGSType<LineSearchType>::Step(
+    State<FunctionType, MatType, GradType>& state,
+    const size_t n)
+{
+  // No callbacks are called, so nothing can request termination.
+  bool stop = false;
+  for (size_t k = 0; k < n && !state.finished; ++k)
+  {
+    if ((maxIterations != 0 && state.iterations == maxIterations) ||
+        !Iteration(*state.function, *state.iterate, state.workspace,
+            state.objective, state.iterations, state.offset, stop))
     {
-      Info << "L-BFGS function value stable (terminating successfully)."
-          << std::endl;
+      state.finished = true;
       break;
     }
 
-    // Overwrite an old basis set.
-    UpdateBasisSet(itNum, iterate, oldIterate, gradient, oldGradient, s, y);
+    ++state.iterations;
+  }
 
-    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
-  } // End of the optimization loop.
+  return !state.finished;
+}
 
-  Callback::EndOptimization(*this, f, iterate, callbacks...);
-  return functionValue;
+template<typename LineSearchType>
+template<typename MatType, typename GradType>
+size_t L_BFGSType<LineSearchType>::StateBytes(const size_t rows,
+                                              const size_t cols) const
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename MatType::elem_type ElemType;
+
+  // See Optimize() and PrepareWorkspace().
+  const bool dense =
+      std::is_base_of<arma::Mat<ElemType>, BaseMatType>::value &&
+      std::is_base_of<arma::Mat<ElemType>, BaseGradType>::value;
+  const size_t historyElemSize = (floatHistory && dense) ? sizeof(float) :
+      sizeof(ElemType);
+
+  return 2 * numBasis * rows * cols * historyElemSize +
+      4 * numBasis * numBasis * sizeof(ElemType) +
+      2 * MatrixBytes<BaseMatType>(rows, cols) +
+      3 * MatrixBytes<BaseGradType>(rows, cols) +
+      ens::PolicyStateBytes<BaseMatType, BaseGradType>(lineSearch, rows,
+          cols);
+}
+
+template<typename LineSearchType>
+template<typename MatType, typename GradType>
+void L_BFGSType<LineSearchType>::SaveState(CheckpointWriter& ar,
+                                           const MatType& /* iterate */)
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // See Optimize().
+  typedef typename std::conditional<
+      std::is_base_of<arma::Mat<ElemType>, BaseMatType>::value &&
+      std::is_base_of<arma::Mat<ElemType>, BaseGradType>::value,
+      float, ElemType>::type FloatHistoryElemType;
+
+  ar(floatHistory);
+  if (floatHistory)
+  {
+    SaveHistory(ar, keptWorkspace.template Get<BaseMatType, BaseGradType,
+        FloatHistoryElemType>());
+  }
+  else
+  {
+    SaveHistory(ar, keptWorkspace.template Get<BaseMatType, BaseGradType,
+        ElemType>());
+  }
+}
+
+template<typename LineSearchType>
+template<typename MatType, typename GradType>
+void L_BFGSType<LineSearchType>::LoadState(CheckpointReader& ar,
+                                           const MatType& /* iterate */)
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // See Optimize().
+  typedef typename std::conditional<
+      std::is_base_of<arma::Mat<ElemType>, BaseMatType>::value &&
+      std::is_base_of<arma::Mat<ElemType>, BaseGradType>::value,
+      float, ElemType>::type FloatHistoryElemType;
+
+  bool savedFloatHistory;
+  ar(savedFloatHistory);
+  if (savedFloatHistory != floatHistory)
+  {
+    throw std::runtime_error("L_BFGS::LoadState(): the state was saved with "
+        "a different FloatHistory().");
+  }
+
+  if (floatHistory)
+  {
+    LoadHistory(ar, keptWorkspace.template Get<BaseMatType, BaseGradType,
+        FloatHistoryElemType>());
+  }
+  else
+  {
+    LoadHistory(ar, keptWorkspace.template Get<BaseMatType, BaseGradType,
+        ElemType>());
+  }
+
+  isRestored = true;
+}
+
+template<typename LineSearchType>
+template<typename HistoryElemType, typename MatType, typename GradType>
+void L_BFGSType<LineSearchType>::SaveHistory(
+    CheckpointWriter& ar,
+    Workspace<MatType, GradType, HistoryElemType>& workspace)
+{
+  ar(workspace.iterations);
+  ar(workspace.history);
+  ar(workspace.gram);
+}
+
+template<typename LineSearchType>
+template<typename HistoryElemType, typename MatType, typename GradType>
+void L_BFGSType<LineSearchType>::LoadHistory(
+    CheckpointReader& ar,
+    Workspace<MatType, GradType, HistoryElemType>& workspace)
+{
+  // The history may live in the memory of a StateAllocator, which can't be
+  // resized, so it is read into a temporary first.
+  arma::Mat<HistoryElemType> history;
+  ar(workspace.iterations);
+  ar(history);
+  ar(workspace.gram);
+
+  workspace.historyMemory.Zeros(workspace.history, history.n_rows,
+      history.n_cols);
+  workspace.history = history;
 }
 
 } // namespace ens
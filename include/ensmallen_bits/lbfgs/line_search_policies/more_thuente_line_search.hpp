@@ -0,0 +1,418 @@
+/**
+ * @file more_thuente_line_search.hpp
+ *
+ * The More-Thuente line search for L_BFGS.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LINE_SEARCH_POLICIES_MORE_THUENTE_LINE_SEARCH_HPP
+#define ENSMALLEN_LBFGS_LINE_SEARCH_POLICIES_MORE_THUENTE_LINE_SEARCH_HPP
+
+namespace ens {
+
+/**
+ * Search for a step size satisfying the strong Wolfe conditions with the
+ * algorithm of More and Thuente, as in MINPACK-2: the step is chosen by cubic
+ * and quadratic interpolation of the objective and its directional derivative
+ * at the previous trials, within an interval that is guaranteed to contain
+ * such a step once it has been bracketed.  This usually needs far fewer
+ * evaluations than WolfeBacktrackingLineSearch, and the accepted point is
+ * always the last one evaluated, so its objective and gradient are handed back
+ * directly.
+ *
+ * The sufficient decrease and curvature parameters are ArmijoConstant() and
+ * Wolfe() of the optimizer.  If the search stops early (it runs out of trials
+ * or the interval becomes too small) the last trial is accepted if it gives a
+ * sufficient decrease, and otherwise the best trial is evaluated again.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @article{More1994,
+ *   author  = {Mor\'e, Jorge J. and Thuente, David J.},
+ *   title   = {Line Search Algorithms with Guaranteed Sufficient Decrease},
+ *   journal = {ACM Transactions on Mathematical Software},
+ *   volume  = {20},
+ *   number  = {3},
+ *   pages   = {286--307},
+ *   year    = {1994}
+ * }
+ * @endcode
+ *
+ * See WolfeBacktrackingLineSearch for the interface of line search policies.
+ */
+class MoreThuenteLineSearch
+{
+ public:
+  /**
+   * Construct the line search.
+   *
+   * @param xTolerance Relative width of the interval of uncertainty below which
+   *     the search stops.
+   */
+  MoreThuenteLineSearch(const double xTolerance = 1e-16) :
+      xTolerance(xTolerance)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Perform the line search.
+   *
+   * @param optimizer The optimizer, for the parameters and the callbacks.
+   * @param function Function to optimize.
+   * @param functionValue Value of the function at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient The gradient at the initial point.
+   * @param newIterateTmp Storage for the trial points.
+   * @param searchDirection A vector specifying the search direction.
+   * @param finalStepSize The resulting step size (0 if no step).
+   * @param terminate Set to true if a callback requested termination.
+   * @param callbacks Callback functions.
+   * @return false if no step size is suitable, true otherwise.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename ElemType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  bool Search(OptimizerType& optimizer,
+              FunctionType& function,
+              ElemType& functionValue,
+              MatType& iterate,
+              GradType& gradient,
+              MatType& newIterateTmp,
+              const GradType& searchDirection,
+              double& finalStepSize,
+              bool& terminate,
+              CallbackTypes&... callbacks)
+  {
+    finalStepSize = 0.0; // Set only when we take the step.
+
+    const double initialDerivative = dot(gradient, searchDirection);
+    if (initialDerivative >= 0.0)
+    {
+      Warn << "L-BFGS line search direction is not a descent direction "
+          << "(terminating)!" << std::endl;
+      return false;
+    }
+
+    const double ftol = optimizer.ArmijoConstant();
+    const double gtol = optimizer.Wolfe();
+    const double minStep = optimizer.MinStep();
+    const double maxStep = optimizer.MaxStep();
+    const double initialValue = functionValue;
+    const double decreaseTest = ftol * initialDerivative;
+
+    // The interval of uncertainty is [stx, sty] (not necessarily ordered);
+    // stx is the best step so far.
+    bool bracketed = false;
+    bool firstStage = true;
+    double width = maxStep - minStep;
+    double previousWidth = 2.0 * width;
+    double stx = 0.0, fx = initialValue, gx = initialDerivative;
+    double sty = 0.0, fy = initialValue, gy = initialDerivative;
+    double step = std::min(std::max(1.0, minStep), maxStep);
+    double stepMin = 0.0;
+    double stepMax = 5.0 * step;
+
+    for (size_t trials = 1; ; ++trials)
+    {
+      newIterateTmp = iterate;
+      newIterateTmp += step * searchDirection;
+      functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+      terminate |= Callback::EvaluateWithGradient(optimizer, function,
+          newIterateTmp, functionValue, gradient, callbacks...);
+
+      const double f = functionValue;
+      const double g = dot(gradient, searchDirection);
+      const double sufficientValue = initialValue + step * decreaseTest;
+
+      if (firstStage && f <= sufficientValue &&
+          g >= std::min(ftol, gtol) * initialDerivative)
+      {
+        firstStage = false;
+      }
+
+      // The strong Wolfe conditions hold.
+      if (f <= sufficientValue && std::abs(g) <= gtol * (-initialDerivative))
+      {
+        iterate = newIterateTmp;
+        finalStepSize = step;
+        return true;
+      }
+
+      // Check whether any further progress can be made.
+      const bool stop = terminate ||
+          (trials >= optimizer.MaxLineSearchTrials()) ||
+          (bracketed && (step <= stepMin || step >= stepMax)) ||
+          (bracketed && stepMax - stepMin <= xTolerance * stepMax) ||
+          (step == maxStep && f <= sufficientValue && g <= decreaseTest) ||
+          (step == minStep && (f > sufficientValue || g >= decreaseTest));
+      if (stop)
+      {
+        if (f <= sufficientValue)
+        {
+          iterate = newIterateTmp;
+          finalStepSize = step;
+          return true;
+        }
+
+        // The best step so far has a lower objective than the initial point.
+        if (stx > 0.0)
+        {
+          iterate += stx * searchDirection;
+          functionValue = function.EvaluateWithGradient(iterate, gradient);
+          terminate |= Callback::EvaluateWithGradient(optimizer, function,
+              iterate, functionValue, gradient, callbacks...);
+          finalStepSize = stx;
+          return true;
+        }
+
+        functionValue = initialValue;
+        return false;
+      }
+
+      // In the first stage, as long as the step has a lower objective than the
+      // best one but no sufficient decrease, use the modified function
+      // f(step) - step * decreaseTest to choose the next step.
+      if (firstStage && f <= fx && f > sufficientValue)
+      {
+        double fxm = fx - stx * decreaseTest;
+        double fym = fy - sty * decreaseTest;
+        double gxm = gx - decreaseTest;
+        double gym = gy - decreaseTest;
+        Step(stx, fxm, gxm, sty, fym, gym, step, f - step * decreaseTest,
+            g - decreaseTest, bracketed, stepMin, stepMax);
+        fx = fxm + stx * decreaseTest;
+        fy = fym + sty * decreaseTest;
+        gx = gxm + decreaseTest;
+        gy = gym + decreaseTest;
+      }
+      else
+      {
+        Step(stx, fx, gx, sty, fy, gy, step, f, g, bracketed, stepMin,
+            stepMax);
+      }
+
+      // Force a sufficient decrease of the size of the interval.
+      if (bracketed)
+      {
+        if (std::abs(sty - stx) >= 0.66 * previousWidth)
+          step = stx + 0.5 * (sty - stx);
+        previousWidth = width;
+        width = std::abs(sty - stx);
+      }
+
+      // Set the bounds for the next step.
+      if (bracketed)
+      {
+        stepMin = std::min(stx, sty);
+        stepMax = std::max(stx, sty);
+      }
+      else
+      {
+        stepMin = step + 1.1 * (step - stx);
+        stepMax = step + 4.0 * (step - stx);
+      }
+
+      step = std::min(std::max(step, minStep), maxStep);
+
+      // If no further progress is possible, try the best step so far.
+      if (bracketed && (step <= stepMin || step >= stepMax ||
+          stepMax - stepMin <= xTolerance * stepMax))
+      {
+        step = stx;
+      }
+    }
+  }
+
+  //! Get the relative tolerance on the width of the interval.
+  double XTolerance() const { return xTolerance; }
+  //! Modify the relative tolerance on the width of the interval.
+  double& XTolerance() { return xTolerance; }
+
+ private:
+  /**
+   * Compute the next trial step and update the interval of uncertainty, as in
+   * dcstep of MINPACK-2.  Four cases are handled, depending on whether the
+   * objective at the trial step is higher than at the best step, and on the
+   * signs and magnitudes of the derivatives.
+   *
+   * @param stx Best step so far.
+   * @param fx Objective at stx.
+   * @param dx Derivative at stx.
+   * @param sty Other end point of the interval.
+   * @param fy Objective at sty.
+   * @param dy Derivative at sty.
+   * @param stp Current step; set to the next trial step.
+   * @param fp Objective at stp.
+   * @param dp Derivative at stp.
+   * @param bracketed Whether or not a minimizer has been bracketed.
+   * @param stpMin Lower bound for the step.
+   * @param stpMax Upper bound for the step.
+   */
+  static void Step(double& stx, double& fx, double& dx,
+                   double& sty, double& fy, double& dy,
+                   double& stp, const double fp, const double dp,
+                   bool& bracketed,
+                   const double stpMin, const double stpMax)
+  {
+    const double sgnd = dp * (dx / std::abs(dx));
+    double stpf;
+
+    if (fp > fx)
+    {
+      // Case 1: a higher objective; the minimum is bracketed.  Take the cubic
+      // step if it is closer to stx than the quadratic step, and the average
+      // of both otherwise.
+      const double theta = 3.0 * (fx - fp) / (stp - stx) + dx + dp;
+      const double s = std::max(std::abs(theta),
+          std::max(std::abs(dx), std::abs(dp)));
+      double gamma = s * std::sqrt((theta / s) * (theta / s) -
+          (dx / s) * (dp / s));
+      if (stp < stx)
+        gamma = -gamma;
+      const double p = (gamma - dx) + theta;
+      const double q = ((gamma - dx) + gamma) + dp;
+      const double r = p / q;
+      const double stpc = stx + r * (stp - stx);
+      const double stpq = stx + ((dx / ((fx - fp) / (stp - stx) + dx)) / 2.0) *
+          (stp - stx);
+      if (std::abs(stpc - stx) < std::abs(stpq - stx))
+        stpf = stpc;
+      else
+        stpf = stpc + (stpq - stpc) / 2.0;
+      bracketed = true;
+    }
+    else if (sgnd < 0.0)
+    {
+      // Case 2: a lower objective and derivatives of opposite sign; the
+      // minimum is bracketed.  Take the step farthest from stp.
+      const double theta = 3.0 * (fx - fp) / (stp - stx) + dx + dp;
+      const double s = std::max(std::abs(theta),
+          std::max(std::abs(dx), std::abs(dp)));
+      double gamma = s * std::sqrt((theta / s) * (theta / s) -
+          (dx / s) * (dp / s));
+      if (stp > stx)
+        gamma = -gamma;
+      const double p = (gamma - dp) + theta;
+      const double q = ((gamma - dp) + gamma) + dx;
+      const double r = p / q;
+      const double stpc = stp + r * (stx - stp);
+      const double stpq = stp + (dp / (dp - dx)) * (stx - stp);
+      if (std::abs(stpc - stp) > std::abs(stpq - stp))
+        stpf = stpc;
+      else
+        stpf = stpq;
+      bracketed = true;
+    }
+    else if (std::abs(dp) < std::abs(dx))
+    {
+      // Case 3: a lower objective, derivatives of the same sign, and a
+      // decreasing magnitude of the derivative.  The cubic step is only used if
+      // it is in the direction of stp, or the minimum is at infinity.
+      const double theta = 3.0 * (fx - fp) / (stp - stx) + dx + dp;
+      const double s = std::max(std::abs(theta),
+          std::max(std::abs(dx), std::abs(dp)));
+      double gamma = s * std::sqrt(std::max(0.0, (theta / s) * (theta / s) -
+          (dx / s) * (dp / s)));
+      if (stp > stx)
+        gamma = -gamma;
+      const double p = (gamma - dp) + theta;
+      const double q = (gamma + (dx - dp)) + gamma;
+      const double r = p / q;
+      double stpc;
+      if (r < 0.0 && gamma != 0.0)
+        stpc = stp + r * (stx - stp);
+      else if (stp > stx)
+        stpc = stpMax;
+      else
+        stpc = stpMin;
+      const double stpq = stp + (dp / (dp - dx)) * (stx - stp);
+
+      if (bracketed)
+      {
+        // Take the step closest to stp, but not too close to sty.
+        if (std::abs(stpc - stp) < std::abs(stpq - stp))
+          stpf = stpc;
+        else
+          stpf = stpq;
+        if (stp > stx)
+          stpf = std::min(stp + 0.66 * (sty - stp), stpf);
+        else
+          stpf = std::max(stp + 0.66 * (sty - stp), stpf);
+      }
+      else
+      {
+        // Take the step farthest from stp.
+        if (std::abs(stpc - stp) > std::abs(stpq - stp))
+          stpf = stpc;
+        else
+          stpf = stpq;
+        stpf = std::min(std::max(stpf, stpMin), stpMax);
+      }
+    }
+    else
+    {
+      // Case 4: a lower objective, derivatives of the same sign, and a
+      // magnitude of the derivative that does not decrease.  Without a bracket
+      // the step goes to the bound.
+      if (bracketed)
+      {
+        const double theta = 3.0 * (fp - fy) / (sty - stp) + dy + dp;
+        const double s = std::max(std::abs(theta),
+            std::max(std::abs(dy), std::abs(dp)));
+        double gamma = s * std::sqrt((theta / s) * (theta / s) -
+            (dy / s) * (dp / s));
+        if (stp > sty)
+          gamma = -gamma;
+        const double p = (gamma - dp) + theta;
+        const double q = ((gamma - dp) + gamma) + dy;
+        const double r = p / q;
+        stpf = stp + r * (sty - stp);
+      }
+      else if (stp > stx)
+      {
+        stpf = stpMax;
+      }
+      else
+      {
+        stpf = stpMin;
+      }
+    }
+
+    // Update the interval of uncertainty.
+    if (fp > fx)
+    {
+      sty = stp;
+      fy = fp;
+      dy = dp;
+    }
+    else
+    {
+      if (sgnd < 0.0)
+      {
+        sty = stx;
+        fy = fx;
+        dy = dx;
+      }
+      stx = stp;
+      fx = fp;
+      dx = dp;
+    }
+
+    stp = stpf;
+  }
+
+  //! Relative tolerance on the width of the interval of uncertainty.
+  double xTolerance;
+};
+
+} // namespace ens
+
+#endif
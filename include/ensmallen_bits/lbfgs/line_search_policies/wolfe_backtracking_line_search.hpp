@@ -0,0 +1,400 @@
+/**
+ * @file wolfe_backtracking_line_search.hpp
+ *
+ * The back-tracking line search used by default by L_BFGS.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_LBFGS_LINE_SEARCH_POLICIES_WOLFE_BACKTRACKING_LINE_SEARCH_HPP
+#define ENSMALLEN_LBFGS_LINE_SEARCH_POLICIES_WOLFE_BACKTRACKING_LINE_SEARCH_HPP
+
+#include <ensmallen_bits/utility/executor.hpp>
+
+namespace ens {
+
+/**
+ * Search for a step size satisfying the Wolfe conditions by repeatedly
+ * increasing the step (by a factor of 2.1) while the curvature condition does
+ * not hold, and decreasing it (by a factor of 2) while the sufficient decrease
+ * condition or the strong curvature condition does not hold.  If no step is
+ * found within the allowed number of trials, the best one seen is taken.
+ *
+ * A line search policy for L_BFGSType is a class with the method
+ *
+ * @code
+ * template<typename OptimizerType,
+ *          typename FunctionType,
+ *          typename ElemType,
+ *          typename MatType,
+ *          typename GradType,
+ *          typename... CallbackTypes>
+ * bool Search(OptimizerType& optimizer,
+ *             FunctionType& function,
+ *             ElemType& functionValue,
+ *             MatType& iterate,
+ *             GradType& gradient,
+ *             MatType& newIterateTmp,
+ *             const GradType& searchDirection,
+ *             double& finalStepSize,
+ *             bool& terminate,
+ *             CallbackTypes&... callbacks);
+ * @endcode
+ *
+ * that moves the iterate along the search direction.  The parameters of the
+ * search (ArmijoConstant(), Wolfe(), MinStep(), MaxStep() and
+ * MaxLineSearchTrials()) are taken from the optimizer.  It returns false if
+ * no step can be taken; otherwise functionValue and gradient must hold the
+ * objective and the gradient at the new iterate when it returns, so that they
+ * never have to be recomputed.  Each evaluation must be reported with
+ * Callback::EvaluateWithGradient() and its result or'ed into terminate.
+ *
+ * Until the direction of the search changes, the next trials are known in
+ * advance (they are the current one times powers of 2.1 or 0.5).  So if
+ * `parallelTrials` is greater than 1, up to that many of them are evaluated
+ * at once on the threads of the executor (see ParallelFor()), and then
+ * checked in order; the accepted step is the same as with sequential trials,
+ * and the trials after the first accepted one (or after the direction
+ * changes) are wasted.  The EvaluateWithGradient() method of the function
+ * must then be thread-safe.
+ */
+class WolfeBacktrackingLineSearch
+{
+ public:
+  /**
+   * Construct the line search.
+   *
+   * @param parallelTrials Maximum number of trial steps evaluated at once.
+   */
+  WolfeBacktrackingLineSearch(const size_t parallelTrials = 1) :
+      parallelTrials(parallelTrials)
+  { /* Nothing to do. */ }
+
+  /**
+   * Perform the line search.
+   *
+   * @param optimizer The optimizer, for the parameters and the callbacks.
+   * @param function Function to optimize.
+   * @param functionValue Value of the function at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient The gradient at the initial point.
+   * @param newIterateTmp Storage for the trial points.
+   * @param searchDirection A vector specifying the search direction.
+   * @param finalStepSize The resulting step size (0 if no step).
+   * @param terminate Set to true if a callback requested termination.
+   * @param callbacks Callback functions.
+   * @return false if no step size is suitable, true otherwise.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename ElemType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  bool Search(OptimizerType& optimizer,
+              FunctionType& function,
+              ElemType& functionValue,
+              MatType& iterate,
+              GradType& gradient,
+              MatType& newIterateTmp,
+              const GradType& searchDirection,
+              double& finalStepSize,
+              bool& terminate,
+              CallbackTypes&... callbacks)
+  {
+    if (parallelTrials > 1)
+    {
+      return ParallelSearch(optimizer, function, functionValue, iterate,
+          gradient, searchDirection, finalStepSize, terminate, callbacks...);
+    }
+
+    // Default first step size of 1.0.
+    double stepSize = 1.0;
+    finalStepSize = 0.0; // Set only when we take the step.
+
+    // The initial linear term approximation in the direction of the
+    // search direction.
+    ElemType initialSearchDirectionDotGradient =
+        dot(gradient, searchDirection);
+
+    // If it is not a descent direction, just report failure.
+    if (initialSearchDirectionDotGradient > 0.0)
+    {
+      Warn << "L-BFGS line search direction is not a descent direction "
+          << "(terminating)!" << std::endl;
+      return false;
+    }
+
+    // Save the initial function value.
+    ElemType initialFunctionValue = functionValue;
+
+    // Unit linear approximation to the decrease in function value.
+    ElemType linearApproxFunctionValueDecrease = optimizer.ArmijoConstant() *
+        initialSearchDirectionDotGradient;
+
+    // The number of iteration in the search.
+    size_t numIterations = 0;
+
+    // Armijo step size scaling factor for increase and decrease.
+    const double inc = 2.1;
+    const double dec = 0.5;
+    double width = 0;
+    double bestStepSize = 1.0;
+    ElemType bestObjective = std::numeric_limits<ElemType>::max();
+
+    while (true)
+    {
+      // Perform a step and evaluate the gradient and the function values at
+      // that point.
+      newIterateTmp = iterate;
+      newIterateTmp += stepSize * searchDirection;
+      functionValue = function.EvaluateWithGradient(newIterateTmp, gradient);
+
+      terminate |= Callback::EvaluateWithGradient(optimizer, function,
+          newIterateTmp, functionValue, gradient, callbacks...);
+
+      if (functionValue < bestObjective)
+      {
+        bestStepSize = stepSize;
+        bestObjective = functionValue;
+      }
+      numIterations++;
+
+      if (functionValue > initialFunctionValue + stepSize *
+          linearApproxFunctionValueDecrease)
+      {
+        width = dec;
+      }
+      else
+      {
+        // Check Wolfe's condition.
+        ElemType searchDirectionDotGradient = dot(gradient,
+            searchDirection);
+
+        if (searchDirectionDotGradient < optimizer.Wolfe() *
+            initialSearchDirectionDotGradient)
+        {
+          width = inc;
+        }
+        else
+        {
+          if (searchDirectionDotGradient > -optimizer.Wolfe() *
+              initialSearchDirectionDotGradient)
+          {
+            width = dec;
+          }
+          else
+          {
+            break;
+          }
+        }
+      }
+
+      // Terminate when the step size gets too small or too big or it
+      // exceeds the max number of iterations.
+      const bool cond1 = (stepSize < optimizer.MinStep());
+      const bool cond2 = (stepSize > optimizer.MaxStep());
+      const bool cond3 = (numIterations >= optimizer.MaxLineSearchTrials());
+      if (cond1 || cond2 || cond3)
+        break;
+
+      // Scale the step size.
+      stepSize *= width;
+    }
+
+    // Move to the new iterate.  The objective and the gradient are those of
+    // the last trial, so if the best trial was an earlier one, they have to be
+    // computed again.
+    if (bestStepSize == stepSize)
+    {
+      iterate = newIterateTmp;
+    }
+    else
+    {
+      iterate += bestStepSize * searchDirection;
+      functionValue = function.EvaluateWithGradient(iterate, gradient);
+      terminate |= Callback::EvaluateWithGradient(optimizer, function,
+          iterate, functionValue, gradient, callbacks...);
+    }
+
+    finalStepSize = bestStepSize;
+    return true;
+  }
+
+  //! Get the maximum number of trial steps evaluated at once.
+  size_t ParallelTrials() const { return parallelTrials; }
+  //! Modify the maximum number of trial steps evaluated at once.
+  size_t& ParallelTrials() { return parallelTrials; }
+
+  //! Return the number of bytes that the line search uses for coordinates of
+  //! the given size: the trial points and gradients evaluated at once, if
+  //! there are several.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return (parallelTrials > 1) ? parallelTrials *
+        (MatrixBytes<MatType>(rows, cols) + MatrixBytes<GradType>(rows, cols)) :
+        0;
+  }
+
+ private:
+  /**
+   * Perform the line search, evaluating up to parallelTrials trials at once.
+   * The trials are checked in the same order as by Search(), so the result is
+   * the same.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename ElemType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  bool ParallelSearch(OptimizerType& optimizer,
+                      FunctionType& function,
+                      ElemType& functionValue,
+                      MatType& iterate,
+                      GradType& gradient,
+                      const GradType& searchDirection,
+                      double& finalStepSize,
+                      bool& terminate,
+                      CallbackTypes&... callbacks)
+  {
+    finalStepSize = 0.0; // Set only when we take the step.
+
+    const ElemType initialSearchDirectionDotGradient =
+        dot(gradient, searchDirection);
+    if (initialSearchDirectionDotGradient > 0.0)
+    {
+      Warn << "L-BFGS line search direction is not a descent direction "
+          << "(terminating)!" << std::endl;
+      return false;
+    }
+
+    const ElemType initialFunctionValue = functionValue;
+    const ElemType linearApproxFunctionValueDecrease =
+        optimizer.ArmijoConstant() * initialSearchDirectionDotGradient;
+
+    const double inc = 2.1;
+    const double dec = 0.5;
+    const size_t maxTrials = optimizer.MaxLineSearchTrials();
+
+    // The first batch goes down, since most steps are accepted or shrunk.
+    double stepSize = 1.0;
+    double width = dec;
+    size_t numIterations = 0;
+    double bestStepSize = 1.0;
+    ElemType bestObjective = std::numeric_limits<ElemType>::max();
+    // The batch index of the best trial, if it is in the last batch.
+    size_t bestTrial = parallelTrials;
+
+    std::vector<MatType> trialIterates(parallelTrials);
+    std::vector<GradType> trialGradients(parallelTrials);
+    std::vector<ElemType> trialObjectives(parallelTrials);
+    std::vector<double> trialSteps(parallelTrials);
+
+    bool done = false;
+    while (!done)
+    {
+      const size_t numTrials = (numIterations < maxTrials) ?
+          std::min(parallelTrials, maxTrials - numIterations) : 1;
+      trialSteps[0] = stepSize;
+      for (size_t j = 1; j < numTrials; ++j)
+        trialSteps[j] = trialSteps[j - 1] * width;
+
+      ParallelFor(numTrials, [&](const size_t j)
+      {
+        trialIterates[j] = iterate + trialSteps[j] * searchDirection;
+        trialObjectives[j] = function.EvaluateWithGradient(trialIterates[j],
+            trialGradients[j]);
+      });
+
+      // Check the trials in order, as Search() would have evaluated them.
+      const double batchWidth = width;
+      bestTrial = parallelTrials;
+      for (size_t j = 0; j < numTrials; ++j)
+      {
+        stepSize = trialSteps[j];
+        terminate |= Callback::EvaluateWithGradient(optimizer, function,
+            trialIterates[j], trialObjectives[j], trialGradients[j],
+            callbacks...);
+
+        if (trialObjectives[j] < bestObjective)
+        {
+          bestStepSize = stepSize;
+          bestObjective = trialObjectives[j];
+          bestTrial = j;
+        }
+        numIterations++;
+
+        if (trialObjectives[j] > initialFunctionValue + stepSize *
+            linearApproxFunctionValueDecrease)
+        {
+          width = dec;
+        }
+        else
+        {
+          const ElemType searchDirectionDotGradient = dot(trialGradients[j],
+              searchDirection);
+          if (searchDirectionDotGradient < optimizer.Wolfe() *
+              initialSearchDirectionDotGradient)
+          {
+            width = inc;
+          }
+          else if (searchDirectionDotGradient > -optimizer.Wolfe() *
+              initialSearchDirectionDotGradient)
+          {
+            width = dec;
+          }
+          else
+          {
+            done = true;
+            break;
+          }
+        }
+
+        if (stepSize < optimizer.MinStep() || stepSize > optimizer.MaxStep() ||
+            numIterations >= maxTrials)
+        {
+          done = true;
+          break;
+        }
+
+        // The rest of the batch is only useful if the search keeps going in
+        // the same direction.
+        if (width != batchWidth)
+          break;
+      }
+
+      stepSize *= width;
+    }
+
+    // Move to the best trial; its objective and gradient are only still
+    // available if it was in the last batch.  The trial is copied, so that the
+    // memory of the iterate is kept.
+    if (bestTrial < parallelTrials)
+    {
+      iterate = trialIterates[bestTrial];
+      gradient = std::move(trialGradients[bestTrial]);
+      functionValue = trialObjectives[bestTrial];
+    }
+    else
+    {
+      iterate += bestStepSize * searchDirection;
+      functionValue = function.EvaluateWithGradient(iterate, gradient);
+      terminate |= Callback::EvaluateWithGradient(optimizer, function,
+          iterate, functionValue, gradient, callbacks...);
+    }
+
+    finalStepSize = bestStepSize;
+    return true;
+  }
+
+  //! The maximum number of trial steps evaluated at once.
+  size_t parallelTrials;
+};
+
+} // namespace ens
+
+#endif
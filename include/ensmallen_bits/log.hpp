@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_LOG_HPP
 #define ENSMALLEN_LOG_HPP
 
+#include "utility/log_sink.hpp"
+
 namespace ens {
 /**
  * This class does nothing and should be optimized out entirely by the compiler.
@@ -70,13 +72,18 @@ class NullOutStream
   NullOutStream& operator<<(const T&) { return *this; }
 };
 
-#ifdef ENS_PRINT_INFO
+// With ENS_LOG_SINK, the messages go to the sink set with SetLogSink().
+#if defined(ENS_LOG_SINK)
+  static LogStream Info(LogLevel::Info);
+#elif defined(ENS_PRINT_INFO)
   static std::ostream& Info = arma::get_cout_stream();
 #else
   static NullOutStream Info;
 #endif
 
-#ifdef ENS_PRINT_WARN
+#if defined(ENS_LOG_SINK)
+  static LogStream Warn(LogLevel::Warn);
+#elif defined(ENS_PRINT_WARN)
   static std::ostream& Warn = arma::get_cerr_stream();
 #else
   static NullOutStream Warn;
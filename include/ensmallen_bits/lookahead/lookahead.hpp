@@ -218,6 +218,29 @@ class Lookahead
         << "unchanged.";
   }
 
+  /**
+   * Move the slow weights `iterate` by `stepSize` towards the fast weights
+   * `iterateModel`, and set the fast weights to the result, in a single pass
+   * over both.
+   *
+   * @param iterate The slow weights.
+   * @param iterateModel The fast weights.
+   * @param stepSize The interpolation factor.
+   */
+  template<typename MatType>
+  static void Interpolate(MatType& iterate,
+                          MatType& iterateModel,
+                          const double stepSize,
+                          std::true_type /* fused */);
+
+  //! Interpolate the weights with Armadillo expressions, for all other matrix
+  //! types.
+  template<typename MatType>
+  static void Interpolate(MatType& iterate,
+                          MatType& iterateModel,
+                          const double stepSize,
+                          std::false_type /* fused */);
+
   //! The base optimizer for the forward step.
   BaseOptimizerType baseOptimizer;
 
@@ -249,6 +272,9 @@ class Lookahead
 
   //! The initialized decay policy.
   Any instDecayPolicy;
+
+  //! The fast weights, kept between calls to Optimize().
+  Any workspace;
 };
 
 } // namespace ens
@@ -64,6 +64,7 @@ template<typename BaseOptimizerType, typename DecayPolicyType>
 inline Lookahead<BaseOptimizerType, DecayPolicyType>::~Lookahead()
 {
   instDecayPolicy.Clean();
+  workspace.Clean();
 }
 
 //! Optimize the function (minimize).
@@ -126,20 +127,23 @@ Lookahead<BaseOptimizerType, DecayPolicyType>::Optimize(
   // Initialize the decay policy if needed.
   if (!isInitialized || !instDecayPolicy.Has<InstDecayPolicyType>())
   {
-    instDecayPolicy.Clean();
-    instDecayPolicy.Set<InstDecayPolicyType>(
-        new InstDecayPolicyType(decayPolicy));
+    instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
     isInitialized = true;
   }
 
+  // The fast weights are kept between calls, so that their memory is only
+  // allocated once; each outer iteration starts them from the slow weights.
+  if (!workspace.Has<BaseMatType>())
+    workspace.Emplace<BaseMatType>();
+  BaseMatType& iterateModel = workspace.As<BaseMatType>();
+  iterateModel = iterate;
+
   // Now iterate!
   terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
   for (size_t i = 0; i < actualMaxIterations && !terminate; i++)
   {
-    BaseMatType iterateModel = iterate;
-
     overallObjective = baseOptimizer.Optimize(f, iterateModel,
         callbacks...);
 
@@ -169,7 +173,10 @@ Lookahead<BaseOptimizerType, DecayPolicyType>::Optimize(
       return overallObjective;
     }
 
-    iterate += stepSize * (iterateModel - iterate);
+    // Move the slow weights towards the fast weights, and restart the fast
+    // weights from there.
+    Interpolate(iterate, iterateModel, stepSize,
+        UseFusedUpdate<BaseMatType, BaseMatType>());
     terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
 
     // Save the current objective.
@@ -206,6 +213,42 @@ Lookahead<BaseOptimizerType, DecayPolicyType>::Optimize(
   return overallObjective;
 }
 
+template<typename BaseOptimizerType, typename DecayPolicyType>
+template<typename MatType>
+inline void Lookahead<BaseOptimizerType, DecayPolicyType>::Interpolate(
+    MatType& iterate,
+    MatType& iterateModel,
+    const double stepSize,
+    std::true_type /* fused */)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType alpha = ElemType(stepSize);
+  ElemType* slow = iterate.memptr();
+  ElemType* fast = iterateModel.memptr();
+  const size_t n = iterate.n_elem;
+
+  ENS_PRAGMA_OMP_SIMD
+  for (size_t i = 0; i < n; ++i)
+  {
+    const ElemType s = slow[i] + alpha * (fast[i] - slow[i]);
+    slow[i] = s;
+    fast[i] = s;
+  }
+}
+
+template<typename BaseOptimizerType, typename DecayPolicyType>
+template<typename MatType>
+inline void Lookahead<BaseOptimizerType, DecayPolicyType>::Interpolate(
+    MatType& iterate,
+    MatType& iterateModel,
+    const double stepSize,
+    std::false_type /* fused */)
+{
+  iterate += stepSize * (iterateModel - iterate);
+  iterateModel = iterate;
+}
+
 } // namespace ens
 
 #endif
@@ -0,0 +1,88 @@
+/**
+ * @file pbi_decomposition.hpp
+ *
+ * The penalty-based boundary intersection decomposition of a multi-objective
+ * problem, for MOEA/D.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MOEAD_DECOMPOSITION_POLICIES_PBI_DECOMPOSITION_HPP
+#define ENSMALLEN_MOEAD_DECOMPOSITION_POLICIES_PBI_DECOMPOSITION_HPP
+
+namespace ens {
+
+/**
+ * The penalty-based boundary intersection (PBI) decomposition scores a
+ * candidate for a subproblem by its distance d1 to the ideal point along the
+ * weight vector, plus a penalty on its distance d2 to the line through the
+ * ideal point along the weight vector:
+ *
+ *   g(x | w, z) = d1 + theta d2.
+ *
+ * This spreads the solutions more evenly over the front than Tchebycheff on
+ * many objectives.  See Tchebycheff for the interface of decomposition
+ * policies.
+ */
+class PBI
+{
+ public:
+  /**
+   * Construct the PBI decomposition.
+   *
+   * @param theta The penalty on the distance to the line of the weight vector.
+   */
+  PBI(const double theta = 5.0) : theta(theta)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Return the scalarized objective of a candidate for a subproblem.
+   *
+   * @param weight Weight vector of the subproblem.
+   * @param idealPoint The best value of each objective found so far.
+   * @param fitness The objectives of the candidate.
+   */
+  template<typename WeightType, typename IdealType, typename FitnessType>
+  double Apply(const WeightType& weight,
+               const IdealType& idealPoint,
+               const FitnessType& fitness) const
+  {
+    double norm = 0.0, projection = 0.0;
+    for (size_t m = 0; m < weight.n_elem; ++m)
+    {
+      norm += (double) weight[m] * (double) weight[m];
+      projection += ((double) fitness[m] - (double) idealPoint[m]) *
+          (double) weight[m];
+    }
+    norm = std::sqrt(norm);
+    if (norm == 0.0)
+      return 0.0;
+
+    const double d1 = std::abs(projection) / norm;
+    double d2 = 0.0;
+    for (size_t m = 0; m < weight.n_elem; ++m)
+    {
+      const double diff = (double) fitness[m] - (double) idealPoint[m] -
+          d1 * (double) weight[m] / norm;
+      d2 += diff * diff;
+    }
+    return d1 + theta * std::sqrt(d2);
+  }
+
+  //! Get the penalty on the distance to the line of the weight vector.
+  double Theta() const { return theta; }
+  //! Modify the penalty on the distance to the line of the weight vector.
+  double& Theta() { return theta; }
+
+ private:
+  //! The penalty on the distance to the line of the weight vector.
+  double theta;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file tchebycheff_decomposition.hpp
+ *
+ * The Tchebycheff decomposition of a multi-objective problem, for MOEA/D.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MOEAD_DECOMPOSITION_POLICIES_TCHEBYCHEFF_DECOMPOSITION_HPP
+#define ENSMALLEN_MOEAD_DECOMPOSITION_POLICIES_TCHEBYCHEFF_DECOMPOSITION_HPP
+
+namespace ens {
+
+/**
+ * The Tchebycheff decomposition scores a candidate for a subproblem by its
+ * largest weighted distance to the ideal point:
+ *
+ *   g(x | w, z) = max_m w_m |f_m(x) - z_m|.
+ *
+ * Every Pareto-optimal point minimizes g for some weight vector, so this also
+ * finds the non-convex parts of the front.  Zero weights are replaced by a
+ * small value, so that every objective counts.
+ *
+ * A decomposition policy implements
+ *
+ * @code
+ * template<typename WeightType, typename IdealType, typename FitnessType>
+ * double Apply(const WeightType& weight,
+ *              const IdealType& idealPoint,
+ *              const FitnessType& fitness) const;
+ * @endcode
+ *
+ * where the arguments are vectors (or columns) with one element per objective,
+ * and a lower value is better.
+ */
+class Tchebycheff
+{
+ public:
+  /**
+   * Return the scalarized objective of a candidate for a subproblem.
+   *
+   * @param weight Weight vector of the subproblem.
+   * @param idealPoint The best value of each objective found so far.
+   * @param fitness The objectives of the candidate.
+   */
+  template<typename WeightType, typename IdealType, typename FitnessType>
+  double Apply(const WeightType& weight,
+               const IdealType& idealPoint,
+               const FitnessType& fitness) const
+  {
+    double value = 0.0;
+    for (size_t m = 0; m < weight.n_elem; ++m)
+    {
+      const double w = std::max((double) weight[m], 1e-6);
+      value = std::max(value,
+          w * std::abs((double) fitness[m] - (double) idealPoint[m]));
+    }
+    return value;
+  }
+};
+
+} // namespace ens
+
+#endif
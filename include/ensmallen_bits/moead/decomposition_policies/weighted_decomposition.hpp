@@ -0,0 +1,49 @@
+/**
+ * @file weighted_decomposition.hpp
+ *
+ * The weighted sum decomposition of a multi-objective problem, for MOEA/D.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MOEAD_DECOMPOSITION_POLICIES_WEIGHTED_DECOMPOSITION_HPP
+#define ENSMALLEN_MOEAD_DECOMPOSITION_POLICIES_WEIGHTED_DECOMPOSITION_HPP
+
+namespace ens {
+
+/**
+ * The weighted sum decomposition scores a candidate for a subproblem by the
+ * weighted sum of its objectives:
+ *
+ *   g(x | w) = sum_m w_m f_m(x).
+ *
+ * This is the cheapest decomposition, but it only finds the convex parts of
+ * the front.  See Tchebycheff for the interface of decomposition policies.
+ */
+class WeightedAverage
+{
+ public:
+  /**
+   * Return the scalarized objective of a candidate for a subproblem.
+   *
+   * @param weight Weight vector of the subproblem.
+   * @param idealPoint The best value of each objective found so far (unused).
+   * @param fitness The objectives of the candidate.
+   */
+  template<typename WeightType, typename IdealType, typename FitnessType>
+  double Apply(const WeightType& weight,
+               const IdealType& /* idealPoint */,
+               const FitnessType& fitness) const
+  {
+    double value = 0.0;
+    for (size_t m = 0; m < weight.n_elem; ++m)
+      value += (double) weight[m] * (double) fitness[m];
+    return value;
+  }
+};
+
+} // namespace ens
+
+#endif
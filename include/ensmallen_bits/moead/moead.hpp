@@ -0,0 +1,347 @@
+/**
+ * @file moead.hpp
+ *
+ * MOEA/D is a multi-objective optimization algorithm that decomposes the
+ * problem into scalar subproblems, one per weight vector, and optimizes them
+ * together, each with the help of the subproblems with the closest weights.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MOEAD_MOEAD_HPP
+#define ENSMALLEN_MOEAD_MOEAD_HPP
+
+#include <ensmallen_bits/nsga2/sort_policies/efficient_non_dominated_sort.hpp>
+#include "decomposition_policies/tchebycheff_decomposition.hpp"
+#include "decomposition_policies/weighted_decomposition.hpp"
+#include "decomposition_policies/pbi_decomposition.hpp"
+
+namespace ens {
+
+/**
+ * MOEA/D (Multi-Objective Evolutionary Algorithm based on Decomposition) is a
+ * multi-objective optimization algorithm.  This class implements the MOEA/D-DE
+ * variant.
+ *
+ * Each candidate of the population solves a scalar subproblem, given by a
+ * weight vector and the DecompositionPolicyType (e.g. the Tchebycheff distance
+ * to the ideal point).  The neighborhood of a subproblem is made of the
+ * `neighborSize` subproblems with the closest weight vectors.  In each
+ * generation, every subproblem creates a child by differential evolution from
+ * parents drawn from its neighborhood (or, with probability
+ * 1 - `neighborProb`, from the whole population), followed by polynomial
+ * mutation; the child then replaces the candidates of at most `maxReplace`
+ * subproblems of the same pool that it solves better.
+ *
+ * Unlike NSGA2, no global non-dominated sort or crowding distance is needed,
+ * so a generation takes O(N T) time (besides the evaluations) for N
+ * subproblems with neighborhoods of size T, which makes MOEA/D suited to many
+ * objectives and large populations.  The children of a generation are all
+ * created from the previous population, so their creation, their evaluation
+ * (see ParallelEvaluation()) and the replacements are run in parallel; every
+ * subproblem takes the best of the children that try to replace its candidate,
+ * so the result doesn't depend on the number of threads.
+ *
+ * The weight vectors are drawn uniformly from the simplex, except the first
+ * ones, which are the corners of the simplex, so that the extremes of the front
+ * are kept.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{li2009,
+ *   author  = {Li, Hui and Zhang, Qingfu},
+ *   title   = {Multiobjective Optimization Problems With Complicated Pareto
+ *              Sets, MOEA/D and NSGA-II},
+ *   journal = {IEEE Transactions on Evolutionary Computation},
+ *   year    = {2009},
+ *   volume  = {13},
+ *   number  = {2},
+ *   pages   = {284--302}
+ * }
+ * @endcode
+ *
+ * MOEA/D can optimize the same multi-objective functions as NSGA2: a
+ * std::tuple of arbitrary functions.  For more details, see the documentation
+ * on function types included with this distribution or on the ensmallen
+ * website.
+ *
+ * @tparam DecompositionPolicyType The decomposition of the problem into scalar
+ *     subproblems.
+ */
+template<typename DecompositionPolicyType = Tchebycheff>
+class MOEADType
+{
+ public:
+  /**
+   * Constructor for the MOEA/D optimizer.
+   *
+   * The default values provided over here are not necessarily suitable for a
+   * given function. Therefore it is highly recommended to adjust the
+   * parameters according to the problem.
+   *
+   * @param populationSize The number of subproblems (and candidates).
+   * @param maxGenerations The maximum number of generations.
+   * @param crossoverProb The probability that an element of a child is taken
+   *     from the differential evolution step.
+   * @param neighborProb The probability that the parents of a child are drawn
+   *     from its neighborhood (instead of from the whole population).
+   * @param neighborSize The number of subproblems in each neighborhood.
+   * @param distributionIndex The distribution index of the polynomial
+   *     mutation; larger values give smaller mutations.
+   * @param differentialWeight The amplification factor of the differential
+   *     evolution step.
+   * @param maxReplace The maximum number of candidates that a child replaces.
+   * @param lowerBound Lower bound of the coordinates.
+   * @param upperBound Upper bound of the coordinates.
+   * @param decompositionPolicy Instantiated decomposition policy.
+   */
+  MOEADType(const size_t populationSize = 150,
+            const size_t maxGenerations = 300,
+            const double crossoverProb = 1.0,
+            const double neighborProb = 0.9,
+            const size_t neighborSize = 20,
+            const double distributionIndex = 20,
+            const double differentialWeight = 0.5,
+            const size_t maxReplace = 2,
+            const arma::vec& lowerBound = arma::zeros(1, 1),
+            const arma::vec& upperBound = arma::ones(1, 1),
+            const DecompositionPolicyType& decompositionPolicy =
+                DecompositionPolicyType());
+
+  /**
+   * Constructor for the MOEA/D optimizer. This constructor provides an
+   * overload to use `lowerBound` and `upperBound` of type double.
+   *
+   * @param populationSize The number of subproblems (and candidates).
+   * @param maxGenerations The maximum number of generations.
+   * @param crossoverProb The probability that an element of a child is taken
+   *     from the differential evolution step.
+   * @param neighborProb The probability that the parents of a child are drawn
+   *     from its neighborhood (instead of from the whole population).
+   * @param neighborSize The number of subproblems in each neighborhood.
+   * @param distributionIndex The distribution index of the polynomial
+   *     mutation; larger values give smaller mutations.
+   * @param differentialWeight The amplification factor of the differential
+   *     evolution step.
+   * @param maxReplace The maximum number of candidates that a child replaces.
+   * @param lowerBound Lower bound of the coordinates.
+   * @param upperBound Upper bound of the coordinates.
+   * @param decompositionPolicy Instantiated decomposition policy.
+   */
+  MOEADType(const size_t populationSize,
+            const size_t maxGenerations,
+            const double crossoverProb,
+            const double neighborProb,
+            const size_t neighborSize,
+            const double distributionIndex,
+            const double differentialWeight,
+            const size_t maxReplace,
+            const double lowerBound,
+            const double upperBound,
+            const DecompositionPolicyType& decompositionPolicy =
+                DecompositionPolicyType());
+
+  /**
+   * Optimize a set of objectives. The initial population is generated around
+   * the starting point, within the bounds. The output is the best front of the
+   * final population.
+   *
+   * @tparam ArbitraryFunctionType std::tuple of multiple objectives.
+   * @tparam MatType Type of matrix to optimize.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param objectives Vector of objective functions to optimize for.
+   * @param iterate Starting point; set to the candidate of the best front with
+   *     the smallest sum of objectives.
+   * @param callbacks Callback functions.
+   * @return MatType::elem_type The minimum of the accumulated sum over the
+   *     objective values in the best front.
+   */
+  template<typename MatType,
+           typename... ArbitraryFunctionType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(
+      std::tuple<ArbitraryFunctionType...>& objectives,
+      MatType& iterate,
+      CallbackTypes&&... callbacks);
+
+  //! Get the population size.
+  size_t PopulationSize() const { return populationSize; }
+  //! Modify the population size.
+  size_t& PopulationSize() { return populationSize; }
+
+  //! Get the maximum number of generations.
+  size_t MaxGenerations() const { return maxGenerations; }
+  //! Modify the maximum number of generations.
+  size_t& MaxGenerations() { return maxGenerations; }
+
+  //! Get the crossover rate.
+  double CrossoverRate() const { return crossoverProb; }
+  //! Modify the crossover rate.
+  double& CrossoverRate() { return crossoverProb; }
+
+  //! Get the probability that the parents are drawn from the neighborhood.
+  double NeighborProb() const { return neighborProb; }
+  //! Modify the probability that the parents are drawn from the neighborhood.
+  double& NeighborProb() { return neighborProb; }
+
+  //! Get the size of the neighborhoods.
+  size_t NeighborSize() const { return neighborSize; }
+  //! Modify the size of the neighborhoods.
+  size_t& NeighborSize() { return neighborSize; }
+
+  //! Get the distribution index of the polynomial mutation.
+  double DistributionIndex() const { return distributionIndex; }
+  //! Modify the distribution index of the polynomial mutation.
+  double& DistributionIndex() { return distributionIndex; }
+
+  //! Get the amplification factor of the differential evolution step.
+  double DifferentialWeight() const { return differentialWeight; }
+  //! Modify the amplification factor of the differential evolution step.
+  double& DifferentialWeight() { return differentialWeight; }
+
+  //! Get the maximum number of candidates that a child replaces.
+  size_t MaxReplace() const { return maxReplace; }
+  //! Modify the maximum number of candidates that a child replaces.
+  size_t& MaxReplace() { return maxReplace; }
+
+  //! Retrieve value of lowerBound.
+  const arma::vec& LowerBound() const { return lowerBound; }
+  //! Modify value of lowerBound.
+  arma::vec& LowerBound() { return lowerBound; }
+
+  //! Retrieve value of upperBound.
+  const arma::vec& UpperBound() const { return upperBound; }
+  //! Modify value of upperBound.
+  arma::vec& UpperBound() { return upperBound; }
+
+  //! Get whether or not the objectives are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether or not the objectives are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get the decomposition policy.
+  const DecompositionPolicyType& DecompositionPolicy() const
+  { return decompositionPolicy; }
+  //! Modify the decomposition policy.
+  DecompositionPolicyType& DecompositionPolicy() { return decompositionPolicy; }
+
+  //! Retrieve the best front (the Pareto frontier).  This returns an empty
+  //! vector until `Optimize()` has been called.
+  const std::vector<arma::mat>& Front() const { return bestFront; }
+
+ private:
+  /**
+   * Evaluate the objectives for the given candidates.
+   *
+   * @tparam ArbitraryFunctionType std::tuple of multiple function types.
+   * @tparam MatType Type of matrix to optimize.
+   * @param population The candidates to evaluate.
+   * @param objectives The set of objectives.
+   * @param calculatedObjectives Matrix to store calculated objectives into,
+   *     one column per candidate.
+   */
+  template<std::size_t I = 0,
+           typename MatType,
+           typename ...ArbitraryFunctionType>
+  typename std::enable_if<I == sizeof...(ArbitraryFunctionType), void>::type
+  EvaluateObjectives(std::vector<MatType>&,
+                     std::tuple<ArbitraryFunctionType...>&,
+                     arma::Mat<typename MatType::elem_type>&);
+
+  template<std::size_t I = 0,
+           typename MatType,
+           typename ...ArbitraryFunctionType>
+  typename std::enable_if<I < sizeof...(ArbitraryFunctionType), void>::type
+  EvaluateObjectives(std::vector<MatType>& population,
+                     std::tuple<ArbitraryFunctionType...>& objectives,
+                     arma::Mat<typename MatType::elem_type>&
+                         calculatedObjectives);
+
+  /**
+   * Draw the weight vectors of the subproblems, one per column, and find the
+   * neighborhood of each subproblem.
+   *
+   * @param numObjectives The number of objectives.
+   * @param weights Matrix to store the weight vectors into.
+   * @param neighbors Matrix to store the neighborhoods into, one column per
+   *     subproblem, closest first.
+   * @param rng The random stream to draw the weights from.
+   */
+  void InitializeSubproblems(const size_t numObjectives,
+                             arma::mat& weights,
+                             arma::umat& neighbors,
+                             RandomStream& rng) const;
+
+  /**
+   * Create the child of a subproblem from the given parents, with the
+   * differential evolution step and polynomial mutation.
+   *
+   * @tparam MatType Type of matrix to optimize.
+   * @param child Matrix to store the child into.
+   * @param parent The candidate of the subproblem.
+   * @param parentA First parent of the differential step.
+   * @param parentB Second parent of the differential step.
+   * @param lower Lower bound of the coordinates.
+   * @param upper Upper bound of the coordinates.
+   * @param rng The random stream of the child.
+   */
+  template<typename MatType>
+  void CreateChild(MatType& child,
+                   const MatType& parent,
+                   const MatType& parentA,
+                   const MatType& parentB,
+                   const arma::vec& lower,
+                   const arma::vec& upper,
+                   RandomStream& rng) const;
+
+  //! The number of candidates in the population.
+  size_t populationSize;
+
+  //! Maximum number of generations before termination criteria is met.
+  size_t maxGenerations;
+
+  //! Probability that an element is taken from the differential step.
+  double crossoverProb;
+
+  //! Probability that the parents are drawn from the neighborhood.
+  double neighborProb;
+
+  //! The number of subproblems in each neighborhood.
+  size_t neighborSize;
+
+  //! The distribution index of the polynomial mutation.
+  double distributionIndex;
+
+  //! The amplification factor of the differential evolution step.
+  double differentialWeight;
+
+  //! The maximum number of candidates that a child replaces.
+  size_t maxReplace;
+
+  //! Lower bound of the coordinates.
+  arma::vec lowerBound;
+
+  //! Upper bound of the coordinates.
+  arma::vec upperBound;
+
+  //! The decomposition policy.
+  DecompositionPolicyType decompositionPolicy;
+
+  //! Whether or not the objectives are evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! Best front, stored after Optimize() is called.
+  std::vector<arma::mat> bestFront;
+};
+
+using MOEAD = MOEADType<Tchebycheff>;
+
+} // namespace ens
+
+// Include implementation.
+#include "moead_impl.hpp"
+
+#endif
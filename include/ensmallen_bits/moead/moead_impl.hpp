@@ -0,0 +1,412 @@
+/**
+ * @file moead_impl.hpp
+ *
+ * Implementation of the MOEA/D-DE algorithm. Used for multi-objective
+ * optimization problems on arbitrary functions.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MOEAD_MOEAD_IMPL_HPP
+#define ENSMALLEN_MOEAD_MOEAD_IMPL_HPP
+
+#include "moead.hpp"
+#include <ensmallen_bits/utility/evaluate_batch.hpp>
+
+namespace ens {
+
+template<typename DecompositionPolicyType>
+inline MOEADType<DecompositionPolicyType>::MOEADType(
+    const size_t populationSize,
+    const size_t maxGenerations,
+    const double crossoverProb,
+    const double neighborProb,
+    const size_t neighborSize,
+    const double distributionIndex,
+    const double differentialWeight,
+    const size_t maxReplace,
+    const arma::vec& lowerBound,
+    const arma::vec& upperBound,
+    const DecompositionPolicyType& decompositionPolicy) :
+    populationSize(populationSize),
+    maxGenerations(maxGenerations),
+    crossoverProb(crossoverProb),
+    neighborProb(neighborProb),
+    neighborSize(neighborSize),
+    distributionIndex(distributionIndex),
+    differentialWeight(differentialWeight),
+    maxReplace(maxReplace),
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    decompositionPolicy(decompositionPolicy),
+    parallelEvaluation(false)
+{ /* Nothing to do here. */ }
+
+template<typename DecompositionPolicyType>
+inline MOEADType<DecompositionPolicyType>::MOEADType(
+    const size_t populationSize,
+    const size_t maxGenerations,
+    const double crossoverProb,
+    const double neighborProb,
+    const size_t neighborSize,
+    const double distributionIndex,
+    const double differentialWeight,
+    const size_t maxReplace,
+    const double lowerBound,
+    const double upperBound,
+    const DecompositionPolicyType& decompositionPolicy) :
+    populationSize(populationSize),
+    maxGenerations(maxGenerations),
+    crossoverProb(crossoverProb),
+    neighborProb(neighborProb),
+    neighborSize(neighborSize),
+    distributionIndex(distributionIndex),
+    differentialWeight(differentialWeight),
+    maxReplace(maxReplace),
+    lowerBound(lowerBound * arma::ones(1, 1)),
+    upperBound(upperBound * arma::ones(1, 1)),
+    decompositionPolicy(decompositionPolicy),
+    parallelEvaluation(false)
+{ /* Nothing to do here. */ }
+
+//! Optimize the function.
+template<typename DecompositionPolicyType>
+template<typename MatType,
+         typename... ArbitraryFunctionType,
+         typename... CallbackTypes>
+typename MatType::elem_type MOEADType<DecompositionPolicyType>::Optimize(
+    std::tuple<ArbitraryFunctionType...>& objectives,
+    MatType& iterate,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t numObjectives = sizeof...(ArbitraryFunctionType);
+  if (populationSize < 2 || populationSize < numObjectives)
+  {
+    throw std::logic_error("MOEAD::Optimize(): population size should be at "
+        "least 2, and at least the number of objectives!");
+  }
+
+  if (neighborSize < 2 || neighborSize > populationSize)
+  {
+    throw std::logic_error("MOEAD::Optimize(): neighborhood size should be at "
+        "least 2, and at most the population size!");
+  }
+
+  if (maxReplace == 0)
+  {
+    throw std::logic_error("MOEAD::Optimize(): maxReplace should be at least "
+        "1!");
+  }
+
+  // A bound of a single dimension applies to all coordinates.
+  const size_t n = iterate.n_elem;
+  const arma::vec lower = (lowerBound.n_elem == 1) ?
+      arma::vec(lowerBound(0) * arma::ones<arma::vec>(n)) : lowerBound;
+  const arma::vec upper = (upperBound.n_elem == 1) ?
+      arma::vec(upperBound(0) * arma::ones<arma::vec>(n)) : upperBound;
+  if (lower.n_elem != n || upper.n_elem != n)
+  {
+    throw std::logic_error("MOEAD::Optimize(): the dimensions of lowerBound "
+        "and upperBound should match the dimensions of iterate!");
+  }
+
+  RandomStream rng;
+
+  // The weight vectors of the subproblems, and their neighborhoods.
+  arma::mat weights;
+  arma::umat neighbors;
+  InitializeSubproblems(numObjectives, weights, neighbors, rng);
+
+  // Generate the population based on a uniform distribution around the given
+  // starting point, within the bounds.
+  std::vector<MatType> population(populationSize);
+  for (size_t i = 0; i < populationSize; ++i)
+  {
+    population[i].set_size(iterate.n_rows, iterate.n_cols);
+    rng.FillUniform(population[i]);
+    population[i] += iterate - ElemType(0.5);
+    for (size_t k = 0; k < n; ++k)
+    {
+      population[i][k] = std::min(std::max(population[i][k],
+          ElemType(lower(k))), ElemType(upper(k)));
+    }
+  }
+
+  // The objectives of the candidates, one column per subproblem, and the best
+  // value of each objective found so far.
+  arma::Mat<ElemType> populationObjectives(numObjectives, populationSize);
+  EvaluateObjectives(population, objectives, populationObjectives);
+  arma::Col<ElemType> idealPoint = arma::min(populationObjectives, 1);
+
+  // The child of each subproblem, and its objectives.
+  std::vector<MatType> children(populationSize);
+  arma::Mat<ElemType> childObjectives(numObjectives, populationSize);
+  // The pool of each child, in random order: its neighborhood, or random
+  // members of the population.
+  arma::umat pools(neighborSize, populationSize);
+  // The candidates that each child tries to replace.
+  arma::umat proposals(maxReplace, populationSize);
+  std::vector<size_t> numProposals(populationSize);
+  // The children that try to replace each candidate.
+  std::vector<std::vector<size_t> > contenders(populationSize);
+
+  Info << "MOEAD initialized successfully. Optimization started." << std::endl;
+
+  bool terminate = Callback::BeginOptimization(*this, objectives, iterate,
+      callbacks...);
+
+  for (size_t generation = 1; generation <= maxGenerations && !terminate;
+      ++generation)
+  {
+    terminate |= Callback::StepTaken(*this, objectives, iterate, callbacks...);
+
+    // Create the child of each subproblem from the previous population.  Each
+    // child draws from a stream of its own, so that the children don't depend
+    // on the number of threads.
+    ParallelFor(populationSize, [&](const size_t i)
+    {
+      RandomStream local = rng.Split(generation * populationSize + i);
+      if (local.Uniform() < neighborProb)
+      {
+        pools.col(i) = neighbors.col(i);
+      }
+      else
+      {
+        for (size_t t = 0; t < neighborSize; ++t)
+          pools(t, i) = local.Integer(populationSize);
+      }
+
+      // Shuffle the pool, so that the first two members are the parents, and
+      // the replacements are tried in random order.
+      for (size_t t = neighborSize - 1; t > 0; --t)
+        std::swap(pools(t, i), pools(local.Integer(t + 1), i));
+
+      CreateChild(children[i], population[i], population[pools(0, i)],
+          population[pools(1, i)], lower, upper, local);
+    });
+
+    EvaluateObjectives(children, objectives, childObjectives);
+    for (size_t i = 0; i < populationSize; ++i)
+    {
+      for (size_t m = 0; m < numObjectives; ++m)
+        idealPoint(m) = std::min(idealPoint(m), childObjectives(m, i));
+    }
+
+    // Each child proposes to replace at most maxReplace candidates of its pool
+    // that it solves better.
+    ParallelFor(populationSize, [&](const size_t i)
+    {
+      size_t count = 0;
+      for (size_t t = 0; t < neighborSize && count < maxReplace; ++t)
+      {
+        const size_t j = pools(t, i);
+        bool proposed = false;
+        for (size_t c = 0; c < count; ++c)
+          proposed |= (proposals(c, i) == j);
+
+        if (!proposed && decompositionPolicy.Apply(weights.col(j), idealPoint,
+            childObjectives.col(i)) < decompositionPolicy.Apply(weights.col(j),
+            idealPoint, populationObjectives.col(j)))
+        {
+          proposals(count++, i) = j;
+        }
+      }
+      numProposals[i] = count;
+    });
+
+    for (size_t j = 0; j < populationSize; ++j)
+      contenders[j].clear();
+    for (size_t i = 0; i < populationSize; ++i)
+    {
+      for (size_t c = 0; c < numProposals[i]; ++c)
+        contenders[proposals(c, i)].push_back(i);
+    }
+
+    // Each candidate is replaced by the best of the children that propose to
+    // replace it.
+    ParallelFor(populationSize, [&](const size_t j)
+    {
+      if (contenders[j].empty())
+        return;
+
+      size_t best = contenders[j][0];
+      double bestValue = decompositionPolicy.Apply(weights.col(j), idealPoint,
+          childObjectives.col(best));
+      for (size_t c = 1; c < contenders[j].size(); ++c)
+      {
+        const size_t i = contenders[j][c];
+        const double value = decompositionPolicy.Apply(weights.col(j),
+            idealPoint, childObjectives.col(i));
+        if (value < bestValue)
+        {
+          best = i;
+          bestValue = value;
+        }
+      }
+
+      population[j] = children[best];
+      populationObjectives.col(j) = childObjectives.col(best);
+    });
+  }
+
+  // Set the candidates from the best front of the final population as the
+  // output.
+  EfficientNonDominatedSort sortPolicy;
+  std::vector<std::vector<size_t> > fronts;
+  std::vector<size_t> ranks;
+  sortPolicy.Sort(populationObjectives, fronts, ranks);
+
+  // bestFront is stored, can be obtained by the Front() getter.
+  bestFront.clear();
+  ElemType performance = std::numeric_limits<ElemType>::max();
+  size_t bestIndex = fronts[0][0];
+  for (size_t f: fronts[0])
+  {
+    bestFront.push_back(arma::conv_to<arma::mat>::from(population[f]));
+    const ElemType sum = arma::accu(populationObjectives.col(f));
+    if (sum < performance)
+    {
+      performance = sum;
+      bestIndex = f;
+    }
+  }
+
+  // Assign iterate to the element of the best front with the smallest sum of
+  // objectives.
+  iterate = population[bestIndex];
+
+  Callback::EndOptimization(*this, objectives, iterate, callbacks...);
+
+  return performance;
+}
+
+//! No objectives to evaluate.
+template<typename DecompositionPolicyType>
+template<std::size_t I,
+         typename MatType,
+         typename ...ArbitraryFunctionType>
+typename std::enable_if<I == sizeof...(ArbitraryFunctionType), void>::type
+MOEADType<DecompositionPolicyType>::EvaluateObjectives(
+    std::vector<MatType>&,
+    std::tuple<ArbitraryFunctionType...>&,
+    arma::Mat<typename MatType::elem_type>&)
+{
+  // Nothing to do here.
+}
+
+//! Evaluate the objectives for the given candidates.
+template<typename DecompositionPolicyType>
+template<std::size_t I,
+         typename MatType,
+         typename ...ArbitraryFunctionType>
+typename std::enable_if<I < sizeof...(ArbitraryFunctionType), void>::type
+MOEADType<DecompositionPolicyType>::EvaluateObjectives(
+    std::vector<MatType>& population,
+    std::tuple<ArbitraryFunctionType...>& objectives,
+    arma::Mat<typename MatType::elem_type>& calculatedObjectives)
+{
+  // Evaluate objective I for all candidates, then the remaining ones.
+  arma::Col<typename MatType::elem_type> values;
+  EvaluateBatch(std::get<I>(objectives), population, values,
+      parallelEvaluation);
+  calculatedObjectives.row(I) = values.t();
+
+  EvaluateObjectives<I + 1, MatType, ArbitraryFunctionType...>(population,
+      objectives, calculatedObjectives);
+}
+
+//! Draw the weight vectors, and find the neighborhoods.
+template<typename DecompositionPolicyType>
+inline void MOEADType<DecompositionPolicyType>::InitializeSubproblems(
+    const size_t numObjectives,
+    arma::mat& weights,
+    arma::umat& neighbors,
+    RandomStream& rng) const
+{
+  // Normalized exponential variables are uniform on the simplex; the first
+  // weight vectors are the corners of the simplex.
+  weights.set_size(numObjectives, populationSize);
+  rng.FillUniform(weights);
+  weights = -arma::log(1.0 - weights);
+  for (size_t m = 0; m < numObjectives; ++m)
+  {
+    weights.col(m).zeros();
+    weights(m, m) = 1.0;
+  }
+  weights.each_row() /= arma::sum(weights, 0);
+
+  // The neighborhood of a subproblem starts with the subproblem itself.
+  neighbors.set_size(neighborSize, populationSize);
+  ParallelFor(populationSize, [&](const size_t i)
+  {
+    arma::vec distances(populationSize);
+    for (size_t j = 0; j < populationSize; ++j)
+      distances(j) = arma::accu(arma::square(weights.col(j) - weights.col(i)));
+    distances(i) = -1.0;
+
+    const arma::uvec order = arma::sort_index(distances);
+    neighbors.col(i) = order.head(neighborSize);
+  });
+}
+
+//! Create a child with differential evolution and polynomial mutation.
+template<typename DecompositionPolicyType>
+template<typename MatType>
+inline void MOEADType<DecompositionPolicyType>::CreateChild(
+    MatType& child,
+    const MatType& parent,
+    const MatType& parentA,
+    const MatType& parentB,
+    const arma::vec& lower,
+    const arma::vec& upper,
+    RandomStream& rng) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  child = parent;
+  const size_t n = child.n_elem;
+  const double mutationProb = 1.0 / n;
+  for (size_t k = 0; k < n; ++k)
+  {
+    double x = (double) parent[k];
+    if (rng.Uniform() < crossoverProb)
+      x += differentialWeight * ((double) parentA[k] - (double) parentB[k]);
+
+    const double range = upper(k) - lower(k);
+    x = std::min(std::max(x, lower(k)), upper(k));
+    if (range > 0.0 && rng.Uniform() < mutationProb)
+    {
+      // Polynomial mutation, bounded to [lower(k), upper(k)].
+      const double u = rng.Uniform();
+      const double power = 1.0 / (distributionIndex + 1.0);
+      double delta;
+      if (u < 0.5)
+      {
+        const double xy = 1.0 - (x - lower(k)) / range;
+        const double value = 2.0 * u + (1.0 - 2.0 * u) *
+            std::pow(xy, distributionIndex + 1.0);
+        delta = std::pow(value, power) - 1.0;
+      }
+      else
+      {
+        const double xy = 1.0 - (upper(k) - x) / range;
+        const double value = 2.0 * (1.0 - u) + 2.0 * (u - 0.5) *
+            std::pow(xy, distributionIndex + 1.0);
+        delta = 1.0 - std::pow(value, power);
+      }
+
+      x = std::min(std::max(x + delta * range, lower(k)), upper(k));
+    }
+
+    child[k] = ElemType(x);
+  }
+}
+
+} // namespace ens
+
+#endif
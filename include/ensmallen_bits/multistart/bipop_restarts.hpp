@@ -0,0 +1,102 @@
+/**
+ * @file bipop_restarts.hpp
+ *
+ * BIPOP restart schedule of MultiStart for CMA-ES: restarts alternate between
+ * growing and small random population sizes.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTISTART_BIPOP_RESTARTS_HPP
+#define ENSMALLEN_MULTISTART_BIPOP_RESTARTS_HPP
+
+#include "ipop_restarts.hpp"
+
+namespace ens {
+
+/**
+ * BIPOPRestarts alternates between two regimes.  The odd starts use growing
+ * populations, as in IPOPRestarts: start 2k - 1 uses lambda * factor^k.  The
+ * even starts use small populations of random size,
+ *
+ *   floor(lambda * (lambdaL / (2 * lambda))^(u^2)),
+ *
+ * where lambdaL is the population of the previous large start and u is uniform
+ * in [0, 1); they search locally with many cheap runs.  Start 0 uses lambda,
+ * the population size of the given optimizer (or the default size of CMA-ES, if
+ * it is 0).  The optimizer must have a PopulationSize() method, like CMAES.
+ *
+ * The original BIPOP-CMA-ES also shrinks the initial step size of the small
+ * starts and balances the budgets of the two regimes; CMAES derives its step
+ * size from its bounds, which here also define the initial distribution, so
+ * only the population sizes are changed.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Hansen2009,
+ *   author    = {Hansen, N.},
+ *   title     = {Benchmarking a BI-Population CMA-ES on the BBOB-2009
+ *                Function Testbed},
+ *   booktitle = {Proceedings of the 11th Annual Conference Companion on
+ *                Genetic and Evolutionary Computation Conference},
+ *   pages     = {2389--2396},
+ *   year      = {2009}
+ * }
+ * @endcode
+ */
+class BIPOPRestarts
+{
+ public:
+  /**
+   * Construct the BIPOP restart schedule.
+   *
+   * @param factor Factor of the population size between two large starts.
+   */
+  BIPOPRestarts(const double factor = 2.0) : factor(factor) { }
+
+  /**
+   * Set the population size of the optimizer of the given start.
+   *
+   * @param optimizer Optimizer of the start.
+   * @param start Index of the start.
+   * @param dimensionality Number of elements of the coordinates.
+   * @param rng Random number generator of the schedule.
+   */
+  template<typename OptimizerType>
+  void Configure(OptimizerType& optimizer,
+                 const size_t start,
+                 const size_t dimensionality,
+                 std::mt19937& rng) const
+  {
+    const size_t lambda = IPOPRestarts::BasePopulationSize(optimizer,
+        dimensionality);
+    const double large = lambda * std::pow(factor, (double) ((start + 1) / 2));
+    if (start % 2 == 1 || start == 0)
+    {
+      optimizer.PopulationSize() = (size_t) std::round(large);
+      return;
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double u = uniform(rng);
+    const double small = lambda * std::pow(0.5 * large / lambda, u * u);
+    optimizer.PopulationSize() = std::max((size_t) std::floor(small),
+        (size_t) 2);
+  }
+
+  //! Get the factor of the population size between two large starts.
+  double Factor() const { return factor; }
+  //! Modify the factor of the population size between two large starts.
+  double& Factor() { return factor; }
+
+ private:
+  //! The factor of the population size between two large starts.
+  double factor;
+};
+
+} // namespace ens
+
+#endif
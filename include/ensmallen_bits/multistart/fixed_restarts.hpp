@@ -0,0 +1,47 @@
+/**
+ * @file fixed_restarts.hpp
+ *
+ * Restart policy of MultiStart that runs every start with the same
+ * configuration.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTISTART_FIXED_RESTARTS_HPP
+#define ENSMALLEN_MULTISTART_FIXED_RESTARTS_HPP
+
+#include <random>
+
+namespace ens {
+
+/**
+ * FixedRestarts runs every start of MultiStart with an unchanged copy of the
+ * given optimizer; the starts only differ by their starting point and by the
+ * seed of their random numbers.  It can be used with any optimizer.
+ */
+class FixedRestarts
+{
+ public:
+  /**
+   * Configure the optimizer of the given start (nothing is changed).
+   *
+   * @param optimizer Optimizer of the start.
+   * @param start Index of the start.
+   * @param dimensionality Number of elements of the coordinates.
+   * @param rng Random number generator of the schedule.
+   */
+  template<typename OptimizerType>
+  void Configure(OptimizerType& /* optimizer */,
+                 const size_t /* start */,
+                 const size_t /* dimensionality */,
+                 std::mt19937& /* rng */) const
+  {
+    // Nothing to do.
+  }
+};
+
+} // namespace ens
+
+#endif
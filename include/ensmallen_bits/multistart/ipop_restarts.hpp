@@ -0,0 +1,95 @@
+/**
+ * @file ipop_restarts.hpp
+ *
+ * IPOP restart schedule of MultiStart for CMA-ES: the population size grows
+ * with each restart.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTISTART_IPOP_RESTARTS_HPP
+#define ENSMALLEN_MULTISTART_IPOP_RESTARTS_HPP
+
+#include <random>
+
+namespace ens {
+
+/**
+ * IPOPRestarts multiplies the population size of the optimizer by a constant
+ * factor for each start: start i uses a population of lambda * factor^i, where
+ * lambda is the population size of the given optimizer (or the default size of
+ * CMA-ES, if it is 0).  Larger populations search more globally, so the later
+ * starts are more likely to find the basin of a good optimum of a multimodal
+ * function.  The optimizer must have a PopulationSize() method, like CMAES.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Auger2005,
+ *   author    = {Auger, A. and Hansen, N.},
+ *   title     = {A Restart CMA Evolution Strategy With Increasing Population
+ *                Size},
+ *   booktitle = {2005 IEEE Congress on Evolutionary Computation},
+ *   pages     = {1769--1776},
+ *   year      = {2005}
+ * }
+ * @endcode
+ */
+class IPOPRestarts
+{
+ public:
+  /**
+   * Construct the IPOP restart schedule.
+   *
+   * @param factor Factor of the population size between two starts.
+   */
+  IPOPRestarts(const double factor = 2.0) : factor(factor) { }
+
+  /**
+   * Set the population size of the optimizer of the given start.
+   *
+   * @param optimizer Optimizer of the start.
+   * @param start Index of the start.
+   * @param dimensionality Number of elements of the coordinates.
+   * @param rng Random number generator of the schedule.
+   */
+  template<typename OptimizerType>
+  void Configure(OptimizerType& optimizer,
+                 const size_t start,
+                 const size_t dimensionality,
+                 std::mt19937& /* rng */) const
+  {
+    const size_t lambda = BasePopulationSize(optimizer, dimensionality);
+    optimizer.PopulationSize() = (size_t) std::round(lambda *
+        std::pow(factor, (double) start));
+  }
+
+  /**
+   * Get the population size of the first start: the population size of the
+   * optimizer, or the default population size of CMA-ES if it is 0.
+   */
+  template<typename OptimizerType>
+  static size_t BasePopulationSize(const OptimizerType& optimizer,
+                                   const size_t dimensionality)
+  {
+    if (optimizer.PopulationSize() > 0)
+      return optimizer.PopulationSize();
+
+    return (4 + std::round(3 * std::log(dimensionality))) * 10;
+  }
+
+  //! Get the factor of the population size between two starts.
+  double Factor() const { return factor; }
+  //! Modify the factor of the population size between two starts.
+  double& Factor() { return factor; }
+
+ private:
+  //! The factor of the population size between two starts.
+  double factor;
+};
+
+} // namespace ens
+
+#endif
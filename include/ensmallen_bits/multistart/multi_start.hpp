@@ -0,0 +1,236 @@
+/**
+ * @file multi_start.hpp
+ *
+ * Meta-optimizer that runs another optimizer from several starting points and
+ * keeps the best result.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTISTART_MULTI_START_HPP
+#define ENSMALLEN_MULTISTART_MULTI_START_HPP
+
+#include "fixed_restarts.hpp"
+#include "ipop_restarts.hpp"
+#include "bipop_restarts.hpp"
+
+namespace ens {
+
+/**
+ * MultiStart runs `numStarts` independent copies of another optimizer, and
+ * returns the best of their results.  This is useful for multimodal functions,
+ * where a single run of a local (or even global) optimizer can get stuck in a
+ * poor local minimum.  The first start begins at the given coordinates; the
+ * others begin at points drawn uniformly in [lowerBound, upperBound].
+ *
+ * If `parallel` is true, the starts run concurrently on OpenMP threads; the
+ * function (and any callbacks) must then be safe to use from several threads.
+ * Each start seeds the random numbers of Armadillo on its thread with seed +
+ * its index, so the result only depends on the seed, not on the number of
+ * threads or their scheduling.  Of several starts with the same objective, the
+ * first one is returned.
+ *
+ * If `laggardSteps` is not 0, a start is terminated early once it has taken
+ * that many steps and the best objective it has seen is still worse than the
+ * final objective of an already finished start.  In parallel, this bound
+ * depends on the order in which the starts finish, so the result is then no
+ * longer fully deterministic.
+ *
+ * The RestartPolicyType may change the configuration of the optimizer for each
+ * start; FixedRestarts (the default) leaves it unchanged, and IPOPRestarts and
+ * BIPOPRestarts implement the restart schedules of IPOP-CMA-ES and
+ * BIPOP-CMA-ES.  A restart policy has the method
+ *
+ * @code
+ * template<typename OptimizerType>
+ * void Configure(OptimizerType& optimizer,
+ *                const size_t start,
+ *                const size_t dimensionality,
+ *                std::mt19937& rng) const;
+ * @endcode
+ *
+ * which is called for each start in order, before any start runs, with a
+ * generator seeded with `seed`.
+ *
+ * @tparam OptimizerType Type of the optimizer to run.
+ * @tparam RestartPolicyType Policy that configures the optimizer of each start.
+ */
+template<typename OptimizerType, typename RestartPolicyType = FixedRestarts>
+class MultiStart
+{
+ public:
+  /**
+   * Construct the MultiStart optimizer.
+   *
+   * @param optimizer Optimizer to run from each start.
+   * @param numStarts Number of starts.
+   * @param lowerBound Lower bound of the random starting points.
+   * @param upperBound Upper bound of the random starting points.
+   * @param seed Seed of the random starting points and of each start.
+   * @param parallel If true, run the starts in parallel.
+   * @param laggardSteps Number of steps after which a start that is worse
+   *     than a finished start is terminated (0 never terminates starts early).
+   * @param restartPolicy Instantiated restart policy.
+   */
+  MultiStart(const OptimizerType& optimizer = OptimizerType(),
+             const size_t numStarts = 10,
+             const double lowerBound = -10,
+             const double upperBound = 10,
+             const size_t seed = 0,
+             const bool parallel = false,
+             const size_t laggardSteps = 0,
+             const RestartPolicyType& restartPolicy = RestartPolicyType());
+
+  /**
+   * Optimize the given function from each start, and store the best final
+   * coordinates into `iterate`.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point of the first start (will be modified).
+   * @param callbacks Callback functions, passed to every start.
+   * @return Objective value of the best final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the optimizer.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the number of starts.
+  size_t NumStarts() const { return numStarts; }
+  //! Modify the number of starts.
+  size_t& NumStarts() { return numStarts; }
+
+  //! Get the lower bound of the random starting points.
+  double LowerBound() const { return lowerBound; }
+  //! Modify the lower bound of the random starting points.
+  double& LowerBound() { return lowerBound; }
+
+  //! Get the upper bound of the random starting points.
+  double UpperBound() const { return upperBound; }
+  //! Modify the upper bound of the random starting points.
+  double& UpperBound() { return upperBound; }
+
+  //! Get the seed.
+  size_t Seed() const { return seed; }
+  //! Modify the seed.
+  size_t& Seed() { return seed; }
+
+  //! Get whether the starts run in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the starts run in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get the number of steps before a laggard start is terminated.
+  size_t LaggardSteps() const { return laggardSteps; }
+  //! Modify the number of steps before a laggard start is terminated.
+  size_t& LaggardSteps() { return laggardSteps; }
+
+  //! Get the restart policy.
+  const RestartPolicyType& RestartPolicy() const { return restartPolicy; }
+  //! Modify the restart policy.
+  RestartPolicyType& RestartPolicy() { return restartPolicy; }
+
+  //! Get the final objective of each start of the last optimization.
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the index of the best start of the last optimization.
+  size_t BestStart() const { return bestStart; }
+
+ private:
+  /**
+   * Callback that terminates a start once it has taken `laggardSteps` steps
+   * and the best objective it has seen is worse than the shared bound.
+   */
+  class LaggardCallback
+  {
+   public:
+    LaggardCallback(const std::atomic<double>& bound,
+                    const size_t laggardSteps) :
+        bound(bound),
+        laggardSteps(laggardSteps),
+        steps(0),
+        bestObjective(std::numeric_limits<double>::max())
+    { }
+
+    template<typename CallbackOptimizerType,
+             typename CallbackFunctionType,
+             typename CallbackMatType>
+    void Evaluate(CallbackOptimizerType& /* optimizer */,
+                  CallbackFunctionType& /* function */,
+                  const CallbackMatType& /* coordinates */,
+                  const double objective)
+    {
+      bestObjective = std::min(bestObjective, objective);
+    }
+
+    template<typename CallbackOptimizerType,
+             typename CallbackFunctionType,
+             typename CallbackMatType>
+    bool StepTaken(CallbackOptimizerType& /* optimizer */,
+                   CallbackFunctionType& /* function */,
+                   const CallbackMatType& /* coordinates */)
+    {
+      return (laggardSteps > 0) && (++steps >= laggardSteps) &&
+          (bestObjective > bound.load());
+    }
+
+   private:
+    //! The best final objective of the finished starts.
+    const std::atomic<double>& bound;
+    //! The number of steps before the start can be terminated.
+    size_t laggardSteps;
+    //! The number of steps taken so far.
+    size_t steps;
+    //! The best objective seen so far.
+    double bestObjective;
+  };
+
+  //! The optimizer to run from each start.
+  OptimizerType optimizer;
+
+  //! The number of starts.
+  size_t numStarts;
+
+  //! The lower bound of the random starting points.
+  double lowerBound;
+
+  //! The upper bound of the random starting points.
+  double upperBound;
+
+  //! The seed.
+  size_t seed;
+
+  //! Whether the starts run in parallel.
+  bool parallel;
+
+  //! The number of steps before a laggard start is terminated.
+  size_t laggardSteps;
+
+  //! The restart policy.
+  RestartPolicyType restartPolicy;
+
+  //! The final objective of each start of the last optimization.
+  arma::vec objectives;
+
+  //! The index of the best start of the last optimization.
+  size_t bestStart;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "multi_start_impl.hpp"
+
+#endif
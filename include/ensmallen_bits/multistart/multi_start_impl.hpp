@@ -0,0 +1,118 @@
+/**
+ * @file multi_start_impl.hpp
+ *
+ * Implementation of the MultiStart meta-optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_MULTISTART_MULTI_START_IMPL_HPP
+#define ENSMALLEN_MULTISTART_MULTI_START_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "multi_start.hpp"
+
+namespace ens {
+
+template<typename OptimizerType, typename RestartPolicyType>
+inline MultiStart<OptimizerType, RestartPolicyType>::MultiStart(
+    const OptimizerType& optimizer,
+    const size_t numStarts,
+    const double lowerBound,
+    const double upperBound,
+    const size_t seed,
+    const bool parallel,
+    const size_t laggardSteps,
+    const RestartPolicyType& restartPolicy) :
+    optimizer(optimizer),
+    numStarts(numStarts),
+    lowerBound(lowerBound),
+    upperBound(upperBound),
+    seed(seed),
+    parallel(parallel),
+    laggardSteps(laggardSteps),
+    restartPolicy(restartPolicy),
+    bestStart(0)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType, typename RestartPolicyType>
+template<typename FunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+MultiStart<OptimizerType, RestartPolicyType>::Optimize(
+    FunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  RequireDenseFloatingPointType<BaseMatType>();
+
+  if (numStarts == 0)
+  {
+    throw std::invalid_argument("MultiStart::Optimize(): numStarts must be "
+        "positive");
+  }
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  // The starting points and the configurations of the starts are drawn
+  // serially, so they only depend on the seed.
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uniform(lowerBound, upperBound);
+  std::vector<BaseMatType> iterates(numStarts);
+  std::vector<OptimizerType> optimizers(numStarts, optimizer);
+  for (size_t i = 0; i < numStarts; ++i)
+  {
+    if (i == 0)
+    {
+      iterates[i] = iterate;
+    }
+    else
+    {
+      iterates[i].set_size(iterate.n_rows, iterate.n_cols);
+      iterates[i].imbue([&]() { return ElemType(uniform(rng)); });
+    }
+
+    restartPolicy.Configure(optimizers[i], i, iterate.n_elem, rng);
+  }
+
+  // The best final objective of the finished starts, used to terminate the
+  // laggards.
+  std::atomic<double> bound(std::numeric_limits<double>::max());
+  objectives.set_size(numStarts);
+
+  // If a start throws, the exception is rethrown once all starts are done.
+  ParallelFor(numStarts, [&](const size_t i)
+  {
+    arma::arma_rng::set_seed(seed + i);
+    LaggardCallback laggard(bound, laggardSteps);
+    objectives(i) = optimizers[i].Optimize(function, iterates[i], laggard,
+        callbacks...);
+
+    double current = bound.load();
+    while (objectives(i) < current &&
+        !bound.compare_exchange_weak(current, objectives(i))) { }
+  }, parallel);
+
+  // Take the first of the best starts; starts that diverged are ignored.
+  bestStart = 0;
+  for (size_t i = 1; i < numStarts; ++i)
+  {
+    if (std::isnan(objectives(bestStart)) ||
+        objectives(i) < objectives(bestStart))
+      bestStart = i;
+  }
+
+  iterate = iterates[bestStart];
+  return objectives(bestStart);
+}
+
+} // namespace ens
+
+#endif
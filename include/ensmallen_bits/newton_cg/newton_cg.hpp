@@ -0,0 +1,219 @@
+/**
+ * @file newton_cg.hpp
+ *
+ * Hessian-free trust-region Newton optimizer, whose steps are computed with
+ * truncated conjugate gradient (Steihaug-CG).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NEWTON_CG_NEWTON_CG_HPP
+#define ENSMALLEN_NEWTON_CG_NEWTON_CG_HPP
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+/**
+ * NewtonCG is a trust-region Newton method that never forms the Hessian: each
+ * step approximately minimizes the quadratic model
+ *
+ * \f[
+ * m(p) = f(x) + \nabla f(x)^T p + \frac{1}{2} p^T H p, \quad \|p\| \le \Delta,
+ * \f]
+ *
+ * with the truncated conjugate gradient method of Steihaug, which only needs
+ * products of the Hessian H with vectors.  CG stops when the residual is below
+ * min(0.5, sqrt(||g||)) ||g|| (so the convergence is superlinear near the
+ * minimum), on the boundary of the trust region if the step would leave it,
+ * or along a direction of negative curvature.  The step is accepted if the
+ * ratio rho of the actual decrease of the objective to the decrease of the
+ * model is above eta; the radius is divided by 4 if rho < 0.25, and doubled
+ * (up to the maximum radius) if rho > 0.75 and the step is on the boundary.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{Steihaug1983,
+ *   author  = {Steihaug, Trond},
+ *   title   = {The Conjugate Gradient Method and Trust Regions in Large Scale
+ *              Optimization},
+ *   journal = {SIAM Journal on Numerical Analysis},
+ *   volume  = {20},
+ *   number  = {3},
+ *   pages   = {626--637},
+ *   year    = {1983}
+ * }
+ * @endcode
+ *
+ * If the function has a method
+ *
+ * @code
+ * void HessianVectorProduct(const MatType& coordinates,
+ *                           const MatType& direction,
+ *                           MatType& product);
+ * @endcode
+ *
+ * (which may be const) it is used for the products; for generalized linear
+ * models like LogisticRegressionFunction and SoftmaxRegressionFunction a
+ * product costs about as much as a gradient, and a few CG iterations per step
+ * replace many first-order passes over the data.  Otherwise, the products are
+ * approximated with a forward difference of the gradient, at the cost of one
+ * gradient evaluation each.
+ *
+ * NewtonCG can optimize differentiable functions.  For more details, see the
+ * documentation on function types included with this distribution or on the
+ * ensmallen website.
+ */
+class NewtonCG
+{
+ public:
+  /**
+   * Construct the NewtonCG optimizer with the given parameters.  The defaults
+   * here are not necessarily good for the given problem, so it is suggested
+   * that the values used be tailored to the task at hand.
+   *
+   * @param maxIterations Maximum number of (outer) iterations allowed (0 means
+   *     no limit).
+   * @param maxCGIterations Maximum number of CG iterations of each step (0
+   *     means the number of coordinates).
+   * @param minGradientNorm Minimum gradient norm required to continue the
+   *     optimization.
+   * @param tolerance Minimum decrease of the objective of an accepted step
+   *     required to continue the optimization.
+   * @param initialRadius Initial radius of the trust region.
+   * @param maxRadius Maximum radius of the trust region.
+   * @param eta Minimum ratio of the actual to the predicted decrease for a step
+   *     to be accepted.
+   */
+  NewtonCG(const size_t maxIterations = 1000,
+           const size_t maxCGIterations = 0,
+           const double minGradientNorm = 1e-6,
+           const double tolerance = 1e-12,
+           const double initialRadius = 1.0,
+           const double maxRadius = 1e4,
+           const double eta = 1e-4);
+
+  /**
+   * Optimize the given function using NewtonCG.  The given starting point will
+   * be modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsMatrixType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(FunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<FunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the maximum number of CG iterations of each step (0 means the number
+  //! of coordinates).
+  size_t MaxCGIterations() const { return maxCGIterations; }
+  //! Modify the maximum number of CG iterations of each step (0 means the
+  //! number of coordinates).
+  size_t& MaxCGIterations() { return maxCGIterations; }
+
+  //! Get the minimum gradient norm.
+  double MinGradientNorm() const { return minGradientNorm; }
+  //! Modify the minimum gradient norm.
+  double& MinGradientNorm() { return minGradientNorm; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the initial radius of the trust region.
+  double InitialRadius() const { return initialRadius; }
+  //! Modify the initial radius of the trust region.
+  double& InitialRadius() { return initialRadius; }
+
+  //! Get the maximum radius of the trust region.
+  double MaxRadius() const { return maxRadius; }
+  //! Modify the maximum radius of the trust region.
+  double& MaxRadius() { return maxRadius; }
+
+  //! Get the acceptance threshold of the steps.
+  double Eta() const { return eta; }
+  //! Modify the acceptance threshold of the steps.
+  double& Eta() { return eta; }
+
+ private:
+  /**
+   * Store the product of the Hessian at the iterate with the direction, with
+   * the HessianVectorProduct() method of the function.
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  static void HessianVectorProduct(FunctionType& function,
+                                   const MatType& iterate,
+                                   const GradType& gradient,
+                                   const MatType& direction,
+                                   MatType& product,
+                                   const std::true_type /* hasProduct */);
+
+  /**
+   * Store an approximation of the product of the Hessian at the iterate with
+   * the direction, with a forward difference of the gradient (whose value at
+   * the iterate is given).
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  static void HessianVectorProduct(FunctionType& function,
+                                   const MatType& iterate,
+                                   const GradType& gradient,
+                                   const MatType& direction,
+                                   MatType& product,
+                                   const std::false_type /* hasProduct */);
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+  //! The maximum number of CG iterations of each step.
+  size_t maxCGIterations;
+  //! The minimum gradient norm.
+  double minGradientNorm;
+  //! The tolerance for termination.
+  double tolerance;
+  //! The initial radius of the trust region.
+  double initialRadius;
+  //! The maximum radius of the trust region.
+  double maxRadius;
+  //! The acceptance threshold of the steps.
+  double eta;
+};
+
+} // namespace ens
+
+#include "newton_cg_impl.hpp"
+
+#endif
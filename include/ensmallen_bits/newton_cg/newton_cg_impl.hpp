@@ -0,0 +1,245 @@
+/**
+ * @file newton_cg_impl.hpp
+ *
+ * Implementation of the Hessian-free trust-region Newton optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NEWTON_CG_NEWTON_CG_IMPL_HPP
+#define ENSMALLEN_NEWTON_CG_NEWTON_CG_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "newton_cg.hpp"
+
+namespace ens {
+
+inline NewtonCG::NewtonCG(const size_t maxIterations,
+                          const size_t maxCGIterations,
+                          const double minGradientNorm,
+                          const double tolerance,
+                          const double initialRadius,
+                          const double maxRadius,
+                          const double eta) :
+    maxIterations(maxIterations),
+    maxCGIterations(maxCGIterations),
+    minGradientNorm(minGradientNorm),
+    tolerance(tolerance),
+    initialRadius(initialRadius),
+    maxRadius(maxRadius),
+    eta(eta)
+{ /* Nothing to do. */ }
+
+template<typename FunctionType, typename MatType, typename GradType>
+inline void NewtonCG::HessianVectorProduct(
+    FunctionType& function,
+    const MatType& iterate,
+    const GradType& /* gradient */,
+    const MatType& direction,
+    MatType& product,
+    const std::true_type /* hasProduct */)
+{
+  function.HessianVectorProduct(iterate, direction, product);
+}
+
+template<typename FunctionType, typename MatType, typename GradType>
+inline void NewtonCG::HessianVectorProduct(
+    FunctionType& function,
+    const MatType& iterate,
+    const GradType& gradient,
+    const MatType& direction,
+    MatType& product,
+    const std::false_type /* hasProduct */)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // The difference step balances the truncation and the rounding errors.
+  const double directionNorm = arma::norm(direction, "fro");
+  if (directionNorm == 0.0)
+  {
+    product.zeros(direction.n_rows, direction.n_cols);
+    return;
+  }
+
+  const double step = std::sqrt(std::numeric_limits<ElemType>::epsilon()) *
+      (1.0 + arma::norm(iterate, "fro")) / directionNorm;
+  const MatType shifted = iterate + ElemType(step) * direction;
+  GradType shiftedGradient;
+  function.Gradient(shifted, shiftedGradient);
+  product = (shiftedGradient - gradient) / ElemType(step);
+}
+
+//! Optimize the function (minimize).
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsMatrixType<GradType>::value,
+typename MatType::elem_type>::type
+NewtonCG::Optimize(FunctionType& function,
+                   MatType& iterateIn,
+                   CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+  RequireDenseFloatingPointType<BaseMatType>();
+  RequireDenseFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  typedef std::integral_constant<bool,
+      traits::HasHessianVectorProductSignature<FunctionType,
+      BaseMatType>::value> HasProductType;
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+  BaseGradType trialGradient(iterate.n_rows, iterate.n_cols);
+
+  // The step, the residual of CG, its direction, and the products of the
+  // Hessian with the step and the direction.
+  BaseMatType p, r, d, hp, hd, trial;
+
+  const size_t cgIterations = (maxCGIterations == 0) ? iterate.n_elem :
+      maxCGIterations;
+  double radius = initialRadius;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  ElemType objective = f.EvaluateWithGradient(iterate, gradient);
+  terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+      gradient, callbacks...);
+
+  for (size_t i = 1; i != maxIterations && !terminate; ++i)
+  {
+    if (std::isnan(objective) || std::isinf(objective))
+    {
+      Warn << "NewtonCG: converged to " << objective << "; terminating with "
+          << "failure." << std::endl;
+      break;
+    }
+
+    const double gradientNorm = arma::norm(gradient, "fro");
+    if (gradientNorm < minGradientNorm)
+    {
+      Info << "NewtonCG: gradient norm " << gradientNorm << " is below the "
+          << "minimum " << minGradientNorm << "; terminating optimization."
+          << std::endl;
+      break;
+    }
+
+    // Approximately minimize the quadratic model within the trust region with
+    // Steihaug's truncated CG, starting from p = 0.
+    const double cgTolerance = std::min(0.5, std::sqrt(gradientNorm)) *
+        gradientNorm;
+    p.zeros(iterate.n_rows, iterate.n_cols);
+    hp.zeros(iterate.n_rows, iterate.n_cols);
+    r = gradient;
+    d = -r;
+    double rr = arma::dot(r, r);
+    bool onBoundary = false;
+    size_t j = 0;
+    for (; j < cgIterations; ++j)
+    {
+      HessianVectorProduct(f, iterate, gradient, d, hd, HasProductType());
+      const double dhd = arma::dot(d, hd);
+      const double alpha = (dhd > 0) ? rr / dhd : 0.0;
+      if (dhd <= 0 || arma::norm(p + ElemType(alpha) * d, "fro") >= radius)
+      {
+        // Follow the direction to the boundary: tau is the positive root of
+        // ||p + tau * d|| = radius.
+        const double dd = arma::dot(d, d);
+        const double pd = arma::dot(p, d);
+        const double pp = arma::dot(p, p);
+        const double tau = (-pd + std::sqrt(std::max(pd * pd + dd *
+            (radius * radius - pp), 0.0))) / dd;
+        p += ElemType(tau) * d;
+        hp += ElemType(tau) * hd;
+        onBoundary = true;
+        ++j;
+        break;
+      }
+
+      p += ElemType(alpha) * d;
+      hp += ElemType(alpha) * hd;
+      r += ElemType(alpha) * hd;
+      const double rrNext = arma::dot(r, r);
+      if (std::sqrt(rrNext) < cgTolerance)
+      {
+        ++j;
+        break;
+      }
+
+      d = ElemType(rrNext / rr) * d - r;
+      rr = rrNext;
+    }
+
+    // Compare the actual decrease with the decrease of the model.
+    const double predicted = -(arma::dot(gradient, p) + 0.5 *
+        arma::dot(p, hp));
+    trial = iterate + p;
+    const ElemType trialObjective = f.EvaluateWithGradient(trial,
+        trialGradient);
+    terminate |= Callback::EvaluateWithGradient(*this, f, trial,
+        trialObjective, trialGradient, callbacks...);
+
+    const double actual = objective - trialObjective;
+    const double rho = (predicted > 0 && std::isfinite(trialObjective)) ?
+        actual / predicted : -1.0;
+
+    Info << "NewtonCG: iteration " << i << ", objective " << objective
+        << ", " << j << " CG iterations, radius " << radius << ", ratio "
+        << rho << "." << std::endl;
+
+    if (rho < 0.25)
+      radius *= 0.25;
+    else if (rho > 0.75 && onBoundary)
+      radius = std::min(2.0 * radius, maxRadius);
+
+    if (rho > eta)
+    {
+      iterate = trial;
+      gradient = trialGradient;
+      objective = trialObjective;
+      terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+      if (std::abs(actual) < tolerance)
+      {
+        Info << "NewtonCG: minimized within tolerance " << tolerance << "; "
+            << "terminating optimization." << std::endl;
+        break;
+      }
+    }
+    else if (radius < std::numeric_limits<ElemType>::epsilon() *
+        (1.0 + arma::norm(iterate, "fro")))
+    {
+      Info << "NewtonCG: the trust region vanished; terminating "
+          << "optimization." << std::endl;
+      break;
+    }
+
+    if (i + 1 == maxIterations)
+    {
+      Info << "NewtonCG: maximum iterations (" << maxIterations << ") "
+          << "reached; terminating optimization." << std::endl;
+    }
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
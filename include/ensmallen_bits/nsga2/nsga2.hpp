@@ -16,6 +16,11 @@
 #ifndef ENSMALLEN_NSGA2_NSGA2_HPP
 #define ENSMALLEN_NSGA2_NSGA2_HPP
 
+#include "sort_policies/fast_non_dominated_sort.hpp"
+#include "sort_policies/efficient_non_dominated_sort.hpp"
+#include "sort_policies/divide_and_conquer_sort.hpp"
+#include "pareto_archive.hpp"
+
 namespace ens {
 
 /**
@@ -35,6 +40,21 @@ namespace ens {
  *
  * The best front (Pareto optimal) is returned by the Optimize() method.
  *
+ * The algorithm used to sort the population into fronts is given by the
+ * SortPolicyType; FastNonDominatedSort is the sort of the original paper,
+ * EfficientNonDominatedSort (the default) is fast for any number of objectives,
+ * and DivideAndConquerSort is the fastest for few objectives and large
+ * populations.
+ *
+ * The objectives of the candidates that survive a generation are kept, so
+ * only the children are evaluated.  If ParallelEvaluation() is set to true
+ * (and OpenMP is enabled), the children are evaluated on multiple threads, so
+ * the Evaluate() methods of the objectives must be safe to call concurrently.
+ *
+ * If UseArchive() is set to true, every evaluated candidate is also offered to
+ * a ParetoArchive, and the best front is the front of all candidates found
+ * during the optimization, instead of the front of the final population.
+ *
  * For more information, see the following:
  *
  * @code
@@ -49,8 +69,11 @@ namespace ens {
  * NSGA-II can optimize arbitrary multi-objective functions. For more details,
  * see the documentation on function types included with this distribution or
  * on the ensmallen website.
+ *
+ * @tparam SortPolicyType The non-dominated sorting algorithm to use.
  */
-class NSGA2 {
+template<typename SortPolicyType = EfficientNonDominatedSort>
+class NSGA2Type {
  public:
   /**
    * Constructor for the NSGA2 optimizer.
@@ -69,15 +92,17 @@ class NSGA2 {
    *     candidate solutions.
    * @param lowerBound Lower bound of the coordinates of the initial population.
    * @param upperBound Upper bound of the coordinates of the initial population.
+   * @param sortPolicy Instantiated non-dominated sort policy.
    */
-  NSGA2(const size_t populationSize = 100,
-        const size_t maxGenerations = 2000,
-        const double crossoverProb = 0.6,
-        const double mutationProb = 0.3,
-        const double mutationStrength = 1e-3,
-        const double epsilon = 1e-6,
-        const arma::vec& lowerBound = arma::zeros(1, 1),
-        const arma::vec& upperBound = arma::ones(1, 1));
+  NSGA2Type(const size_t populationSize = 100,
+            const size_t maxGenerations = 2000,
+            const double crossoverProb = 0.6,
+            const double mutationProb = 0.3,
+            const double mutationStrength = 1e-3,
+            const double epsilon = 1e-6,
+            const arma::vec& lowerBound = arma::zeros(1, 1),
+            const arma::vec& upperBound = arma::ones(1, 1),
+            const SortPolicyType& sortPolicy = SortPolicyType());
 
   /**
    * Constructor for the NSGA2 optimizer. This constructor provides an overload
@@ -97,15 +122,17 @@ class NSGA2 {
    *     candidate solutions.
    * @param lowerBound Lower bound of the coordinates of the initial population.
    * @param upperBound Upper bound of the coordinates of the initial population.
+   * @param sortPolicy Instantiated non-dominated sort policy.
    */
-  NSGA2(const size_t populationSize = 100,
-        const size_t maxGenerations = 2000,
-        const double crossoverProb = 0.6,
-        const double mutationProb = 0.3,
-        const double mutationStrength = 1e-3,
-        const double epsilon = 1e-6,
-        const double lowerBound = 0,
-        const double upperBound = 1);
+  NSGA2Type(const size_t populationSize = 100,
+            const size_t maxGenerations = 2000,
+            const double crossoverProb = 0.6,
+            const double mutationProb = 0.3,
+            const double mutationStrength = 1e-3,
+            const double epsilon = 1e-6,
+            const double lowerBound = 0,
+            const double upperBound = 1,
+            const SortPolicyType& sortPolicy = SortPolicyType());
 
   /**
    * Optimize a set of objectives. The initial population is generated using the
@@ -168,6 +195,27 @@ class NSGA2 {
   //! Modify value of upperBound.
   arma::vec& UpperBound() { return upperBound; }
 
+  //! Get whether or not the objectives are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether or not the objectives are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get whether or not the front of all evaluated candidates is kept.
+  bool UseArchive() const { return useArchive; }
+  //! Modify whether or not the front of all evaluated candidates is kept.
+  bool& UseArchive() { return useArchive; }
+
+  //! Get the archive of the front of all evaluated candidates; it is only
+  //! filled by Optimize() if UseArchive() is true.
+  const ParetoArchive& Archive() const { return archive; }
+  //! Modify the archive (e.g. its leaf size).
+  ParetoArchive& Archive() { return archive; }
+
+  //! Get the non-dominated sort policy.
+  const SortPolicyType& SortPolicy() const { return sortPolicy; }
+  //! Modify the non-dominated sort policy.
+  SortPolicyType& SortPolicy() { return sortPolicy; }
+
   //! Retrieve the best front (the Pareto frontier).  This returns an empty vector until `Optimize()`
   //! has been called.
   const std::vector<arma::mat>& Front() const { return bestFront; }
@@ -177,115 +225,96 @@ class NSGA2 {
    * Evaluate objectives for the elite population.
    *
    * @tparam ArbitraryFunctionType std::tuple of multiple function types.
-   * @tparam MatType Type of matrix to optimize.
-   * @param population The elite population.
+   * @tparam ElemType Type of the elements of the candidates.
+   * @param population The elite population, one candidate per slice.
    * @param objectives The set of objectives.
-   * @param calculatedObjectives Vector to store calculated objectives.
+   * @param calculatedObjectives Matrix to store calculated objectives into,
+   *     one column per candidate.
    */
   template<std::size_t I = 0,
-           typename MatType,
+           typename ElemType,
            typename ...ArbitraryFunctionType>
   typename std::enable_if<I == sizeof...(ArbitraryFunctionType), void>::type
-  EvaluateObjectives(std::vector<MatType>&,
+  EvaluateObjectives(const arma::Cube<ElemType>&,
                      std::tuple<ArbitraryFunctionType...>&,
-                     std::vector<arma::Col<double> >&);
+                     arma::Mat<ElemType>&);
 
   template<std::size_t I = 0,
-           typename MatType,
+           typename ElemType,
            typename ...ArbitraryFunctionType>
   typename std::enable_if<I < sizeof...(ArbitraryFunctionType), void>::type
-  EvaluateObjectives(std::vector<MatType>& population,
+  EvaluateObjectives(const arma::Cube<ElemType>& population,
                      std::tuple<ArbitraryFunctionType...>& objectives,
-                     std::vector<arma::Col<double> >& calculatedObjectives);
+                     arma::Mat<ElemType>& calculatedObjectives);
 
   /**
    * Reproduce candidates from the elite population to generate a new
-   * population.
+   * population.  The children are written in place, so `children` must hold
+   * as many candidates as the population.
    *
-   * @tparam MatType Type of matrix to optimize.
-   * @param population The elite population.
-   * @param objectives The set of objectives.
+   * @tparam ElemType Type of the elements of the candidates.
+   * @param population The elite population, one candidate per slice.
+   * @param children Cube to store the generated children into.
+   * @param mask Buffer for the random draws of the crossover and mutation.
+   * @param noise Buffer for the noise of the mutation.
    * @param lowerBound Lower bound of the coordinates of the initial population.
    * @param upperBound Upper bound of the coordinates of the initial population.
    */
-  template<typename MatType>
-  void BinaryTournamentSelection(std::vector<MatType>& population,
+  template<typename ElemType>
+  void BinaryTournamentSelection(const arma::Cube<ElemType>& population,
+                                 arma::Cube<ElemType>& children,
+                                 arma::Mat<ElemType>& mask,
+                                 arma::Mat<ElemType>& noise,
                                  const arma::vec& lowerBound,
                                  const arma::vec& upperBound);
 
   /**
-   * Crossover two parents to create a pair of new children.
+   * Crossover two parents to create a pair of new children, in place.
    *
    * @tparam MatType Type of matrix to optimize.
    * @param childA A newly generated candidate.
    * @param childB Another newly generated candidate.
    * @param parentA First parent from elite population.
    * @param parentB Second parent from elite population.
+   * @param mask Buffer for the random draws of the crossover.
    */
   template<typename MatType>
   void Crossover(MatType& childA,
                  MatType& childB,
                  const MatType& parentA,
-                 const MatType& parentB);
+                 const MatType& parentB,
+                 MatType& mask);
 
   /**
-   * Mutate the coordinates for a candidate.
+   * Mutate the coordinates for a candidate, in place.
    *
    * @tparam MatType Type of matrix to optimize.
    * @param child The candidate whose coordinates are being modified.
-   * @param objectives The set of objectives.
+   * @param mask Buffer for the random draws of the mutation.
+   * @param noise Buffer for the noise of the mutation.
    * @param lowerBound Lower bound of the coordinates of the initial population.
    * @param upperBound Upper bound of the coordinates of the initial population.
    */
   template<typename MatType>
   void Mutate(MatType& child,
+              MatType& mask,
+              MatType& noise,
               const arma::vec& lowerBound,
               const arma::vec& upperBound);
 
-  /**
-   * Sort the candidate population using their domination count and the set of
-   * dominated nodes.
-   *
-   * @tparam MatType Type of matrix to optimize.
-   * @param fronts The population is sorted into these Pareto fronts. The first
-   *     front is the best, the second worse and so on.
-   * @param ranks The assigned ranks, used for crowding distance based sorting.
-   * @param calculatedObjectives The previously calculated objectives.
-   */
-  template<typename MatType>
-  void FastNonDominatedSort(
-      std::vector<std::vector<size_t> >& fronts,
-      std::vector<size_t>& ranks,
-      std::vector<arma::Col<typename MatType::elem_type> >& calculatedObjectives);
-
-  /**
-   * Operator to check if one candidate Pareto-dominates the other.
-   *
-   * A candidate is said to dominate the other if it is at least as good as the
-   * other candidate for all the objectives and there exists at least one
-   * objective for which it is strictly better than the other candidate.
-   *
-   * @tparam MatType Type of matrix to optimize.
-   * @param calculatedObjectives The previously calculated objectives.
-   * @param candidateP The candidate being compared from the elite population.
-   * @param candidateQ The candidate being compared against.
-   * @return true if candidateP Pareto dominates candidateQ, otherwise, false.
-   */
-  template<typename MatType>
-  bool Dominates(
-      std::vector<arma::Col<typename MatType::elem_type> >& calculatedObjectives,
-      size_t candidateP,
-      size_t candidateQ);
-
   /**
    * Assigns crowding distance metric for sorting.
    *
-   * @param front The previously generated Pareto fronts.
-   * @param objectives The set of objectives.
-   * @param crowdingDistance The previously calculated objectives.
+   * @param front The previously generated Pareto front.
+   * @param calculatedObjectives The previously calculated objectives, one
+   *     column per candidate.
+   * @param crowdingDistance Vector to store the crowding distances into.
    */
-  void CrowdingDistanceAssignment(const std::vector<size_t>& front,
-                                  std::vector<double>& crowdingDistance);
+  template<typename ElemType>
+  void CrowdingDistanceAssignment(
+      const std::vector<size_t>& front,
+      const arma::Mat<ElemType>& calculatedObjectives,
+      std::vector<double>& crowdingDistance);
 
   /**
    * The operator used in the crowding distance based sorting.
@@ -337,10 +366,24 @@ class NSGA2 {
   //! Upper bound of the initial swarm.
   arma::vec upperBound;
 
+  //! The non-dominated sort policy.
+  SortPolicyType sortPolicy;
+
+  //! Whether or not the objectives are evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! Whether or not the front of all evaluated candidates is kept.
+  bool useArchive;
+
+  //! The front of all evaluated candidates.
+  ParetoArchive archive;
+
   //! Best front, stored after Optimize() is called.
   std::vector<arma::mat> bestFront;
 };
 
+using NSGA2 = NSGA2Type<EfficientNonDominatedSort>;
+
 } // namespace ens
 
 // Include implementation.
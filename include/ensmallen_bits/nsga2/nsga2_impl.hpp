@@ -15,18 +15,22 @@
 #define ENSMALLEN_NSGA2_NSGA2_IMPL_HPP
 
 #include "nsga2.hpp"
+#include <ensmallen_bits/utility/evaluate_batch.hpp>
 #include <assert.h>
 
 namespace ens {
 
-inline NSGA2::NSGA2(const size_t populationSize,
-                    const size_t maxGenerations,
-                    const double crossoverProb,
-                    const double mutationProb,
-                    const double mutationStrength,
-                    const double epsilon,
-                    const arma::vec& lowerBound,
-                    const arma::vec& upperBound) :
+template<typename SortPolicyType>
+inline NSGA2Type<SortPolicyType>::NSGA2Type(
+    const size_t populationSize,
+    const size_t maxGenerations,
+    const double crossoverProb,
+    const double mutationProb,
+    const double mutationStrength,
+    const double epsilon,
+    const arma::vec& lowerBound,
+    const arma::vec& upperBound,
+    const SortPolicyType& sortPolicy) :
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     crossoverProb(crossoverProb),
@@ -34,17 +38,23 @@ inline NSGA2::NSGA2(const size_t populationSize,
     mutationStrength(mutationStrength),
     epsilon(epsilon),
     lowerBound(lowerBound),
-    upperBound(upperBound)
+    upperBound(upperBound),
+    sortPolicy(sortPolicy),
+    parallelEvaluation(false),
+    useArchive(false)
 { /* Nothing to do here. */ }
 
-inline NSGA2::NSGA2(const size_t populationSize,
-                    const size_t maxGenerations,
-                    const double crossoverProb,
-                    const double mutationProb,
-                    const double mutationStrength,
-                    const double epsilon,
-                    const double lowerBound,
-                    const double upperBound) :
+template<typename SortPolicyType>
+inline NSGA2Type<SortPolicyType>::NSGA2Type(
+    const size_t populationSize,
+    const size_t maxGenerations,
+    const double crossoverProb,
+    const double mutationProb,
+    const double mutationStrength,
+    const double epsilon,
+    const double lowerBound,
+    const double upperBound,
+    const SortPolicyType& sortPolicy) :
     populationSize(populationSize),
     maxGenerations(maxGenerations),
     crossoverProb(crossoverProb),
@@ -52,14 +62,18 @@ inline NSGA2::NSGA2(const size_t populationSize,
     mutationStrength(mutationStrength),
     epsilon(epsilon),
     lowerBound(lowerBound * arma::ones(1, 1)),
-    upperBound(upperBound * arma::ones(1, 1))
+    upperBound(upperBound * arma::ones(1, 1)),
+    sortPolicy(sortPolicy),
+    parallelEvaluation(false),
+    useArchive(false)
 { /* Nothing to do here. */ }
 
 //! Optimize the function.
+template<typename SortPolicyType>
 template<typename MatType,
          typename... ArbitraryFunctionType,
          typename... CallbackTypes>
-typename MatType::elem_type NSGA2::Optimize(
+typename MatType::elem_type NSGA2Type<SortPolicyType>::Optimize(
     std::tuple<ArbitraryFunctionType...>& objectives,
     MatType& iterate,
     CallbackTypes&&... callbacks)
@@ -91,40 +105,59 @@ typename MatType::elem_type NSGA2::Optimize(
   numObjectives = sizeof...(ArbitraryFunctionType);
   numVariables = iterate.n_rows;
 
-  // Cache calculated objectives.
-  std::vector<arma::Col<ElemType> > calculatedObjectives;
-  // Pre-allocate space for the calculated objectives.
-  calculatedObjectives.resize(populationSize);
-
-  // Population size reserved to 2 * populationSize + 1 to accommodate
-  // for the size of intermediate candidate population.
-  std::vector<MatType> population;
-  population.reserve(2 * populationSize + 1);
+  // Cache calculated objectives, one column per candidate: the population
+  // in the first populationSize columns, and its children in the others.  The
+  // objectives of the surviving candidates are kept, so only the children are
+  // evaluated in each generation.
+  arma::Mat<ElemType> calculatedObjectives(numObjectives, 2 * populationSize);
+  // Objectives of the children (or initial population), and the survivors.
+  arma::Mat<ElemType> childObjectives(numObjectives, populationSize);
+  arma::Mat<ElemType> survivorObjectives(numObjectives, populationSize);
+
+  // The population, the children, and the survivors of each generation are
+  // each stored contiguously, one candidate per slice, and allocated once; the
+  // children are written in place, and the survivors are copied into the next
+  // population, which is then swapped with the current one, so that
+  // reproduction doesn't allocate.
+  arma::Cube<ElemType> population(iterate.n_rows, iterate.n_cols,
+      populationSize);
+  arma::Cube<ElemType> children(iterate.n_rows, iterate.n_cols,
+      populationSize);
+  arma::Cube<ElemType> next(iterate.n_rows, iterate.n_cols, populationSize);
+  // Random draws of the crossover and mutation of a child.
+  arma::Mat<ElemType> mask(iterate.n_rows, iterate.n_cols);
+  arma::Mat<ElemType> noise(iterate.n_rows, iterate.n_cols);
 
   // Pareto fronts, initialized during non-dominated sorting.
   std::vector<std::vector<size_t> > fronts;
   // Initialised in CrowdingDistanceAssignment.
-  std::vector<double> crowdingDistance;
+  std::vector<double> crowdingDistance(2 * populationSize);
   // Initialised during non-dominated sorting.
   std::vector<size_t> ranks;
+  // Indices of the candidates that survive to the next generation.
+  arma::uvec survivors(populationSize);
 
   // Controls early termination of the optimization process.
   bool terminate = false;
 
   // Generate the population based on a uniform distribution around the given
   // starting point.
+  population.randu();
+  population -= 0.5;
   for (size_t i = 0; i < populationSize; i++)
-  {
-    population.push_back(arma::randu<MatType>(iterate.n_rows,
-        iterate.n_cols) - 0.5 + iterate);
-  }
+    population.slice(i) += iterate;
 
   Info << "NSGA2 initialized successfully. Optimization started." << std::endl;
 
   // Evaluate the fitness before optimization.
-  for (size_t i = 0; i < population.size(); i++)
-    calculatedObjectives[i] = arma::Col<ElemType>(numObjectives, arma::fill::zeros);
-  EvaluateObjectives(population, objectives, calculatedObjectives);
+  EvaluateObjectives(population, objectives, childObjectives);
+  calculatedObjectives.cols(0, populationSize - 1) = childObjectives;
+  archive.Clear();
+  if (useArchive)
+  {
+    for (size_t i = 0; i < populationSize; i++)
+      archive.Insert(population.slice(i), childObjectives.col(i));
+  }
 
   // Iterate until maximum number of generations is obtained.
   terminate |= Callback::BeginOptimization(*this, objectives, iterate, callbacks...);
@@ -136,112 +169,149 @@ typename MatType::elem_type NSGA2::Optimize(
 
     // Create new population of candidate from the present elite population.
     // Have P_t, generate G_t using P_t.
-    BinaryTournamentSelection(population, lowerBound, upperBound);
-
-    // Evaluate the objectives for the new population.
-    calculatedObjectives.resize(population.size());
-    for (size_t i = 0; i < population.size(); i++)
-      calculatedObjectives[i] = arma::Col<ElemType>(numObjectives, arma::fill::zeros);
-    EvaluateObjectives(population, objectives, calculatedObjectives);
+    BinaryTournamentSelection(population, children, mask, noise, lowerBound,
+        upperBound);
+
+    // Evaluate the objectives for the children only; the children are the
+    // candidates populationSize to 2 * populationSize - 1 of P_t ∪ G_t.
+    EvaluateObjectives(children, objectives, childObjectives);
+    calculatedObjectives.cols(populationSize, 2 * populationSize - 1) =
+        childObjectives;
+    if (useArchive)
+    {
+      for (size_t i = 0; i < populationSize; i++)
+        archive.Insert(children.slice(i), childObjectives.col(i));
+    }
 
-    // Perform fast non dominated sort on P_t ∪ G_t.
-    ranks.resize(population.size());
-    FastNonDominatedSort<MatType>(fronts, ranks, calculatedObjectives);
+    // Perform non dominated sort on P_t ∪ G_t.
+    sortPolicy.Sort(calculatedObjectives, fronts, ranks);
 
     // Perform crowding distance assignment.
-    crowdingDistance.resize(population.size());
-
     for (size_t fNum = 0; fNum < fronts.size(); fNum++)
     {
-      CrowdingDistanceAssignment(fronts[fNum], crowdingDistance);
+      CrowdingDistanceAssignment(fronts[fNum], calculatedObjectives,
+          crowdingDistance);
     }
 
-    // Sort based on crowding distance.
-    std::sort(population.begin(), population.end(),
-              [this, ranks, crowdingDistance, population](MatType candidateP,
-                                                          MatType candidateQ)
-              {
-                size_t idxP, idxQ;
-                for (size_t i = 0; i < population.size(); i++)
-                {
-                  if (arma::approx_equal(population[i], candidateP, "absdiff", epsilon))
-                    idxP = i;
-
-                  if (arma::approx_equal(population[i], candidateQ, "absdiff", epsilon))
-                    idxQ = i;
-                }
-
-                return CrowdingOperator(idxP, idxQ, ranks, crowdingDistance);
-              }
-    );
-
-    // Yield a new population P_{t+1} of size populationSize.
-    population.resize(populationSize);
-  }
+    // Yield a new population P_{t+1} of size populationSize from the best
+    // fronts; the front that does not fit completely is cut by crowding
+    // distance.
+    size_t numSurvivors = 0;
+    for (size_t fNum = 0; fNum < fronts.size() &&
+        numSurvivors < populationSize; fNum++)
+    {
+      std::vector<size_t>& front = fronts[fNum];
+      if (numSurvivors + front.size() > populationSize)
+      {
+        std::sort(front.begin(), front.end(),
+            [this, &ranks, &crowdingDistance](const size_t idxP,
+                                              const size_t idxQ)
+            {
+              return CrowdingOperator(idxP, idxQ, ranks, crowdingDistance);
+            });
+      }
+
+      for (size_t i = 0; i < front.size() && numSurvivors < populationSize;
+          i++)
+      {
+        survivors(numSurvivors++) = front[i];
+      }
+    }
 
-  // Set the candidates from the best front as the output.
-  std::vector<MatType> front;
+    // Copy the survivors into the next population, and make it the current
+    // one.
+    for (size_t i = 0; i < populationSize; i++)
+    {
+      const size_t s = survivors(i);
+      next.slice(i) = (s < populationSize) ? population.slice(s) :
+          children.slice(s - populationSize);
+      survivorObjectives.col(i) = calculatedObjectives.col(s);
+    }
+    std::swap(population, next);
+    calculatedObjectives.cols(0, populationSize - 1) = survivorObjectives;
+  }
 
-  for (size_t f: fronts[0])
-    front.push_back(population[f]);
+  // Set the candidates from the best front of the final population as the
+  // output.
+  calculatedObjectives.resize(numObjectives, populationSize);
+  sortPolicy.Sort(calculatedObjectives, fronts, ranks);
 
   // bestFront is stored, can be obtained by the Front() getter.
-  bestFront = front;
+  bestFront.clear();
+  ElemType performance = std::numeric_limits<ElemType>::max();
+  for (size_t f: fronts[0])
+  {
+    bestFront.push_back(arma::conv_to<arma::mat>::from(population.slice(f)));
+    performance = std::min(performance,
+        (ElemType) arma::accu(calculatedObjectives.col(f)));
+  }
 
   // Assign iterate to first element of the best front.
-  iterate = bestFront[0];
-
-  Callback::EndOptimization(*this, objectives, iterate, callbacks...);
+  iterate = population.slice(fronts[0][0]);
 
-  ElemType performance = std::numeric_limits<ElemType>::max();
+  // With the archive, the best front is the front of all candidates, and
+  // iterate is set to its element with the smallest sum of objectives.
+  if (useArchive)
+  {
+    arma::mat archiveObjectives;
+    archive.Front(bestFront, archiveObjectives);
+    const arma::rowvec sums = arma::sum(archiveObjectives, 0);
+    performance = (ElemType) sums.min();
+    iterate = arma::conv_to<MatType>::from(bestFront[sums.index_min()]);
+  }
 
-  for(arma::Col<ElemType> objective: calculatedObjectives)
-    if (arma::accu(objective) < performance)
-      performance = arma::accu(objective);
+  Callback::EndOptimization(*this, objectives, iterate, callbacks...);
 
   return performance;
 }
 
 //! No objectives to evaluate.
+template<typename SortPolicyType>
 template<std::size_t I,
-         typename MatType,
+         typename ElemType,
          typename ...ArbitraryFunctionType>
 typename std::enable_if<I == sizeof...(ArbitraryFunctionType), void>::type
-NSGA2::EvaluateObjectives(
-    std::vector<MatType>&,
+NSGA2Type<SortPolicyType>::EvaluateObjectives(
+    const arma::Cube<ElemType>&,
     std::tuple<ArbitraryFunctionType...>&,
-    std::vector<arma::Col<double> >&)
+    arma::Mat<ElemType>&)
 {
   // Nothing to do here.
 }
 
 //! Evaluate the objectives for the entire population.
+template<typename SortPolicyType>
 template<std::size_t I,
-         typename MatType,
+         typename ElemType,
          typename ...ArbitraryFunctionType>
 typename std::enable_if<I < sizeof...(ArbitraryFunctionType), void>::type
-NSGA2::EvaluateObjectives(
-    std::vector<MatType>& population,
+NSGA2Type<SortPolicyType>::EvaluateObjectives(
+    const arma::Cube<ElemType>& population,
     std::tuple<ArbitraryFunctionType...>& objectives,
-    std::vector<arma::Col<double> >& calculatedObjectives)
+    arma::Mat<ElemType>& calculatedObjectives)
 {
-  for (size_t i = 0; i < populationSize; i++)
-  {
-    calculatedObjectives[i](I) = std::get<I>(objectives).Evaluate(population[i]);
-    EvaluateObjectives<I+1, MatType, ArbitraryFunctionType...>(population, objectives,
-                                                               calculatedObjectives);
-  }
+  // Evaluate objective I for the whole population, then the remaining ones.
+  arma::Col<ElemType> values;
+  EvaluateBatch(std::get<I>(objectives), population, values,
+      parallelEvaluation);
+  calculatedObjectives.row(I) = values.t();
+
+  EvaluateObjectives<I+1, ElemType, ArbitraryFunctionType...>(population,
+      objectives, calculatedObjectives);
 }
 
 //! Reproduce and generate new candidates.
-template<typename MatType>
-inline void NSGA2::BinaryTournamentSelection(std::vector<MatType>& population,
-                                             const arma::vec& lowerBound,
-                                             const arma::vec& upperBound)
+template<typename SortPolicyType>
+template<typename ElemType>
+inline void NSGA2Type<SortPolicyType>::BinaryTournamentSelection(
+    const arma::Cube<ElemType>& population,
+    arma::Cube<ElemType>& children,
+    arma::Mat<ElemType>& mask,
+    arma::Mat<ElemType>& noise,
+    const arma::vec& lowerBound,
+    const arma::vec& upperBound)
 {
-  std::vector<MatType> children;
-
-  while (children.size() < population.size())
+  for (size_t i = 0; i < children.n_slices; i += 2)
   {
     // Choose two random parents for reproduction from the elite population.
     size_t indexA = arma::randi<size_t>(arma::distr_param(0, populationSize - 1));
@@ -256,47 +326,69 @@ inline void NSGA2::BinaryTournamentSelection(std::vector<MatType>& population,
         indexB--;
     }
 
-    // Initialize the children to the respective parents.
-    MatType childA = population[indexA], childB = population[indexB];
+    // Write the children in place; if the population size is odd, the second
+    // child of the last pair is dropped.
+    const bool pair = (i + 1 < children.n_slices);
+    Crossover(children.slice(i), pair ? children.slice(i + 1) : noise,
+        population.slice(indexA), population.slice(indexB), mask);
 
-    Crossover(childA, childB, population[indexA], population[indexB]);
-
-    Mutate(childA, lowerBound, upperBound);
-    Mutate(childB, lowerBound, upperBound);
-
-    // Add the children to the candidate population.
-    children.push_back(childA);
-    children.push_back(childB);
+    Mutate(children.slice(i), mask, noise, lowerBound, upperBound);
+    if (pair)
+      Mutate(children.slice(i + 1), mask, noise, lowerBound, upperBound);
   }
-
-  // Add the candidates to the elite population.
-  population.insert(std::end(population), std::begin(children), std::end(children));
 }
 
 //! Perform crossover of genes for the children.
+template<typename SortPolicyType>
 template<typename MatType>
-inline void NSGA2::Crossover(MatType& childA,
-                             MatType& childB,
-                             const MatType& parentA,
-                             const MatType& parentB)
+inline void NSGA2Type<SortPolicyType>::Crossover(MatType& childA,
+                                                 MatType& childB,
+                                                 const MatType& parentA,
+                                                 const MatType& parentB,
+                                                 MatType& mask)
 {
-  // Indices at which crossover is to occur.
-  const arma::umat idx = arma::randu<MatType>(childA.n_rows, childA.n_cols) < crossoverProb;
+  typedef typename MatType::elem_type ElemType;
 
-  // Use traits from parentA for indices where idx is 1 and parentB otherwise.
-  childA = parentA % idx + parentB % (1 - idx);
-  // Use traits from parentB for indices where idx is 1 and parentA otherwise.
-  childB = parentA % (1 - idx) + parentA % idx;
+  // Indices at which crossover is to occur.
+  mask.randu();
+
+  const ElemType rate = ElemType(crossoverProb);
+  const ElemType* m = mask.memptr();
+  const ElemType* a = parentA.memptr();
+  const ElemType* b = parentB.memptr();
+  ElemType* outA = childA.memptr();
+  ElemType* outB = childB.memptr();
+  for (size_t i = 0; i < mask.n_elem; ++i)
+  {
+    // Use traits from parentA for indices where the mask is set and parentB
+    // otherwise for childA, and the other way around for childB.
+    const bool fromA = (m[i] < rate);
+    outA[i] = fromA ? a[i] : b[i];
+    outB[i] = fromA ? b[i] : a[i];
+  }
 }
 
 //! Perform mutation of the candidates weights with some noise.
+template<typename SortPolicyType>
 template<typename MatType>
-inline void NSGA2::Mutate(MatType& child,
-                          const arma::vec& lowerBound,
-                          const arma::vec& upperBound)
+inline void NSGA2Type<SortPolicyType>::Mutate(MatType& child,
+                                              MatType& mask,
+                                              MatType& noise,
+                                              const arma::vec& lowerBound,
+                                              const arma::vec& upperBound)
 {
-  child += (arma::randu<MatType>(child.n_rows, child.n_cols) < mutationProb) %
-      (mutationStrength * arma::randn<MatType>(child.n_rows, child.n_cols));
+  typedef typename MatType::elem_type ElemType;
+
+  mask.randu();
+  noise.randn();
+
+  const ElemType probability = ElemType(mutationProb);
+  const ElemType strength = ElemType(mutationStrength);
+  const ElemType* m = mask.memptr();
+  const ElemType* z = noise.memptr();
+  ElemType* out = child.memptr();
+  for (size_t i = 0; i < child.n_elem; ++i)
+    out[i] += (m[i] < probability) ? strength * z[i] : ElemType(0);
 
   // Constrain all genes to be between bounds.
   for (size_t idx = 0; idx < numVariables; idx++)
@@ -308,122 +400,65 @@ inline void NSGA2::Mutate(MatType& child,
   }
 }
 
-//! Sort population into Pareto fronts.
-template<typename MatType>
-inline void NSGA2::FastNonDominatedSort(
-    std::vector<std::vector<size_t> >& fronts,
-    std::vector<size_t>& ranks,
-    std::vector<arma::Col<typename MatType::elem_type> >& calculatedObjectives)
+//! Assign crowding distance to the population.
+template<typename SortPolicyType>
+template<typename ElemType>
+inline void NSGA2Type<SortPolicyType>::CrowdingDistanceAssignment(
+    const std::vector<size_t>& front,
+    const arma::Mat<ElemType>& calculatedObjectives,
+    std::vector<double>& crowdingDistance)
 {
-  std::map<size_t, size_t> dominationCount;
-  std::map<size_t, std::set<size_t> > dominated;
+  if (front.size() == 0)
+    return;
 
-  // Reset and initialize fronts.
-  fronts.clear();
-  fronts.push_back(std::vector<size_t>());
+  const size_t fSize = front.size();
+  const double maxDistance = std::numeric_limits<double>::max();
 
-  for (size_t p = 0; p < populationSize; p++)
-  {
-    dominated[p] = std::set<size_t>();
-    dominationCount[p] = 0;
+  // The distances are accumulated by position in the front, and each
+  // objective is sorted as packed (value, position) pairs, so that the sort
+  // and the distance computation don't read scattered columns of
+  // calculatedObjectives.
+  std::vector<double> distance(fSize, 0.0);
+  std::vector<std::pair<ElemType, size_t>> sorted(fSize);
 
-    for (size_t q = 0; q < populationSize; q++)
-    {
-      if (Dominates<MatType>(calculatedObjectives, p, q))
-        dominated[p].insert(q);
-      else if (Dominates<MatType>(calculatedObjectives, q, p))
-        dominationCount[p] += 1;
-    }
-
-    if (dominationCount[p] == 0)
-    {
-      ranks[p] = 0;
-      fronts[0].push_back(p);
-    }
-  }
-
-  size_t i = 0;
-
-  while (fronts[i].size() > 0)
+  for (size_t m = 0; m < numObjectives; m++)
   {
-    std::vector<size_t> nextFront;
+    for (size_t i = 0; i < fSize; ++i)
+      sorted[i] = std::make_pair(calculatedObjectives(m, front[i]), i);
+    // Ties are broken by position, so the order doesn't depend on the sort.
+    std::sort(sorted.begin(), sorted.end());
 
-    for (size_t p: fronts[i])
-    {
-      for (size_t q: dominated[p])
-      {
-        dominationCount[q]--;
+    // The boundary candidates are always preferred.
+    distance[sorted[0].second] = maxDistance;
+    distance[sorted[fSize - 1].second] = maxDistance;
 
-        if (dominationCount[q] == 0)
-        {
-          ranks[q] = i + 1;
-          nextFront.push_back(q);
-        }
-      }
-    }
+    const double range = (double) sorted[fSize - 1].first -
+        (double) sorted[0].first;
+    if (range <= 0)
+      continue;
 
-    i++;
-    fronts.push_back(nextFront);
-  }
-}
-
-//! Check if a candidate Pareto dominates another candidate.
-template<typename MatType>
-inline bool NSGA2::Dominates(
-    std::vector<arma::Col<typename MatType::elem_type> >& calculatedObjectives,
-    size_t candidateP,
-    size_t candidateQ)
-{
-  bool allBetterOrEqual = true;
-  bool atleastOneBetter = false;
-  size_t n_objectives = calculatedObjectives[0].n_elem;
-
-  for (size_t i = 0; i < n_objectives; i++)
-  {
-    // P is worse than Q for the i-th objective function.
-    if (calculatedObjectives[candidateP](i) > calculatedObjectives[candidateQ](i))
-      allBetterOrEqual = false;
-
-    // P is better than Q for the i-th objective function.
-    else if (calculatedObjectives[candidateP](i) < calculatedObjectives[candidateQ](i))
-      atleastOneBetter = true;
-  }
-
-  return allBetterOrEqual && atleastOneBetter;
-}
-
-//! Assign crowding distance to the population.
-inline void NSGA2::CrowdingDistanceAssignment(const std::vector<size_t>& front,
-                                              std::vector<double>& crowdingDistance)
-{
-  if (front.size() > 0)
-  {
-    for (size_t elem: front)
-      crowdingDistance[elem] = 0;
-
-    size_t fSize = front.size();
-
-    for (size_t m = 0; m < numObjectives; m++)
+    for (size_t i = 1; i < fSize - 1; i++)
     {
-      crowdingDistance[front[0]] = std::numeric_limits<double>::max();
-      crowdingDistance[front[fSize - 1]] = std::numeric_limits<double>::max();
+      double& d = distance[sorted[i].second];
+      if (d == maxDistance)
+        continue;
 
-      for (size_t i = 1; i < fSize - 1 ; i++)
-      {
-        crowdingDistance[front[i]] += (crowdingDistance[front[i - 1]] -
-            crowdingDistance[front[i + 1]]) /
-            (std::numeric_limits<double>::max() -
-            std::numeric_limits<double>::min());
-      }
+      d += ((double) sorted[i + 1].first - (double) sorted[i - 1].first) /
+          range;
     }
   }
+
+  for (size_t i = 0; i < fSize; ++i)
+    crowdingDistance[front[i]] = distance[i];
 }
 
 //! Comparator for crowding distance based sorting.
-inline bool NSGA2::CrowdingOperator(size_t idxP,
-                                    size_t idxQ,
-                                    const std::vector<size_t>& ranks,
-                                    const std::vector<double>& crowdingDistance)
+template<typename SortPolicyType>
+inline bool NSGA2Type<SortPolicyType>::CrowdingOperator(
+    size_t idxP,
+    size_t idxQ,
+    const std::vector<size_t>& ranks,
+    const std::vector<double>& crowdingDistance)
 {
   if (ranks[idxP] < ranks[idxQ])
     return true;
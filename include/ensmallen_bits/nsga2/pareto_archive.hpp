@@ -0,0 +1,391 @@
+/**
+ * @file pareto_archive.hpp
+ *
+ * An archive of the non-dominated candidates found by a multi-objective
+ * optimizer, maintained incrementally with an ND-tree.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NSGA2_PARETO_ARCHIVE_HPP
+#define ENSMALLEN_NSGA2_PARETO_ARCHIVE_HPP
+
+#include "sort_policies/dominance.hpp"
+#include <memory>
+
+namespace ens {
+
+/**
+ * A ParetoArchive keeps the candidates that no other inserted candidate
+ * dominates (candidates with the same objectives as an archived candidate are
+ * not kept).  The candidates are stored in an ND-tree: each node keeps a
+ * bounding box (ideal and nadir points) of the objectives of its subtree, so
+ * that an insertion only visits the nodes whose box can contain a candidate
+ * that dominates, or is dominated by, the new one.  A subtree whose nadir
+ * point dominates the new candidate rejects it at once, and a subtree whose
+ * ideal point it dominates is dropped at once; in practice, an insertion takes
+ * time sub-linear in the size of the archive.  Leaves hold at most
+ * `maxLeafSize` candidates, and are split into `numChildren` leaves of nearby
+ * candidates when they overflow.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{jaszkiewicz2018,
+ *   author  = {Jaszkiewicz, Andrzej and Lust, Thibaut},
+ *   title   = {ND-Tree-Based Update: A Fast Algorithm for the Dynamic
+ *              Nondominance Problem},
+ *   journal = {IEEE Transactions on Evolutionary Computation},
+ *   year    = {2018},
+ *   volume  = {22},
+ *   number  = {5},
+ *   pages   = {778--791}
+ * }
+ * @endcode
+ */
+class ParetoArchive
+{
+ public:
+  /**
+   * Create an empty archive.
+   *
+   * @param maxLeafSize The maximum number of candidates in a leaf.
+   * @param numChildren The number of leaves that a full leaf is split into (0
+   *     means the number of objectives plus one).
+   */
+  ParetoArchive(const size_t maxLeafSize = 20, const size_t numChildren = 0) :
+      maxLeafSize(std::max(maxLeafSize, (size_t) 1)),
+      numChildren(numChildren),
+      size(0)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Offer a candidate to the archive.  If no archived candidate weakly
+   * dominates it, it is added, and the archived candidates that it dominates
+   * are removed.
+   *
+   * @param coordinates Coordinates of the candidate.
+   * @param objectives Objectives of the candidate.
+   * @return true if the candidate was added.
+   */
+  template<typename MatType, typename ObjectivesType>
+  bool Insert(const MatType& coordinates, const ObjectivesType& objectives)
+  {
+    arma::vec y = arma::conv_to<arma::vec>::from(objectives);
+    if (size > 0 && y.n_elem != root.ideal.n_elem)
+    {
+      throw std::invalid_argument("ParetoArchive::Insert(): the number of "
+          "objectives differs from the archived candidates!");
+    }
+
+    if (size > 0 && !Update(root, y))
+      return false;
+
+    Point point;
+    point.objectives = std::move(y);
+    point.coordinates = arma::conv_to<arma::mat>::from(coordinates);
+    if (size == 0)
+    {
+      root = Node();
+      root.ideal = point.objectives;
+      root.nadir = point.objectives;
+    }
+    Insert(root, std::move(point));
+    ++size;
+    return true;
+  }
+
+  /**
+   * Get the archived candidates, in no particular order.
+   *
+   * @param coordinates Vector to store the coordinates into.
+   * @param objectives Matrix to store the objectives into, one column per
+   *     candidate.
+   */
+  void Front(std::vector<arma::mat>& coordinates, arma::mat& objectives) const
+  {
+    coordinates.clear();
+    coordinates.reserve(size);
+    objectives.set_size(size > 0 ? root.ideal.n_elem : 0, size);
+    if (size > 0)
+      Collect(root, coordinates, objectives);
+  }
+
+  //! Remove all candidates.
+  void Clear()
+  {
+    root = Node();
+    size = 0;
+  }
+
+  //! Get the number of archived candidates.
+  size_t Size() const { return size; }
+
+  //! Get the maximum number of candidates in a leaf.
+  size_t MaxLeafSize() const { return maxLeafSize; }
+  //! Modify the maximum number of candidates in a leaf.
+  size_t& MaxLeafSize() { return maxLeafSize; }
+
+  //! Get the number of leaves that a full leaf is split into.
+  size_t NumChildren() const { return numChildren; }
+  //! Modify the number of leaves that a full leaf is split into.
+  size_t& NumChildren() { return numChildren; }
+
+ private:
+  //! An archived candidate.
+  struct Point
+  {
+    //! The objectives of the candidate.
+    arma::vec objectives;
+    //! The coordinates of the candidate.
+    arma::mat coordinates;
+  };
+
+  //! A node of the ND-tree; a leaf holds points, other nodes children.
+  struct Node
+  {
+    //! Lower bound of the objectives of the points of the subtree.
+    arma::vec ideal;
+    //! Upper bound of the objectives of the points of the subtree.
+    arma::vec nadir;
+    //! The points of a leaf.
+    std::vector<Point> points;
+    //! The children of an internal node.
+    std::vector<std::unique_ptr<Node> > children;
+  };
+
+  //! Return whether a is at least as good as b for all objectives.
+  static bool WeaklyDominates(const arma::vec& a, const arma::vec& b)
+  {
+    for (size_t i = 0; i < a.n_elem; ++i)
+    {
+      if (a[i] > b[i])
+        return false;
+    }
+    return true;
+  }
+
+  //! Return whether the node holds no points.
+  static bool Empty(const Node& node)
+  {
+    return node.points.empty() && node.children.empty();
+  }
+
+  //! Return the number of points of the subtree.
+  static size_t Count(const Node& node)
+  {
+    size_t count = node.points.size();
+    for (size_t c = 0; c < node.children.size(); ++c)
+      count += Count(*node.children[c]);
+    return count;
+  }
+
+  //! Return the squared distance of y to the center of the box of the node.
+  static double Distance(const Node& node, const arma::vec& y)
+  {
+    double distance = 0.0;
+    for (size_t i = 0; i < y.n_elem; ++i)
+    {
+      const double d = y[i] - 0.5 * (node.ideal[i] + node.nadir[i]);
+      distance += d * d;
+    }
+    return distance;
+  }
+
+  //! Grow the box of the node to contain y.
+  static void Extend(Node& node, const arma::vec& y)
+  {
+    for (size_t i = 0; i < y.n_elem; ++i)
+    {
+      node.ideal[i] = std::min(node.ideal[i], y[i]);
+      node.nadir[i] = std::max(node.nadir[i], y[i]);
+    }
+  }
+
+  /**
+   * Remove the points of the subtree that y dominates.  Return false (and
+   * remove nothing) if a point of the subtree weakly dominates y; since the
+   * points are mutually non-dominated, y can't then dominate any point.  The
+   * boxes are not shrunk, so they stay bounds of the subtrees.
+   */
+  bool Update(Node& node, const arma::vec& y)
+  {
+    // Every point of the subtree weakly dominates y.
+    if (WeaklyDominates(node.nadir, y))
+      return false;
+
+    // y dominates every point of the subtree.
+    if (WeaklyDominates(y, node.ideal))
+    {
+      size -= Count(node);
+      node.points.clear();
+      node.children.clear();
+      return true;
+    }
+
+    // No point of the subtree can dominate, or be dominated by, y.
+    if (!WeaklyDominates(node.ideal, y) && !WeaklyDominates(y, node.nadir))
+      return true;
+
+    if (node.children.empty())
+    {
+      for (size_t i = 0; i < node.points.size(); )
+      {
+        const arma::vec& z = node.points[i].objectives;
+        if (WeaklyDominates(z, y))
+          return false;
+
+        if (ParetoDominates(y.memptr(), z.memptr(), y.n_elem))
+        {
+          std::swap(node.points[i], node.points.back());
+          node.points.pop_back();
+          --size;
+        }
+        else
+        {
+          ++i;
+        }
+      }
+      return true;
+    }
+
+    for (size_t c = 0; c < node.children.size(); )
+    {
+      if (!Update(*node.children[c], y))
+        return false;
+
+      if (Empty(*node.children[c]))
+        node.children.erase(node.children.begin() + c);
+      else
+        ++c;
+    }
+
+    // A node with a single child is replaced by the child.
+    if (node.children.size() == 1)
+    {
+      std::unique_ptr<Node> child = std::move(node.children[0]);
+      node = std::move(*child);
+    }
+    return true;
+  }
+
+  //! Insert the point in the leaf of the subtree with the closest box.
+  void Insert(Node& node, Point&& point)
+  {
+    Extend(node, point.objectives);
+    if (!node.children.empty())
+    {
+      size_t best = 0;
+      double bestDistance = Distance(*node.children[0], point.objectives);
+      for (size_t c = 1; c < node.children.size(); ++c)
+      {
+        const double distance = Distance(*node.children[c], point.objectives);
+        if (distance < bestDistance)
+        {
+          best = c;
+          bestDistance = distance;
+        }
+      }
+
+      Insert(*node.children[best], std::move(point));
+      return;
+    }
+
+    node.points.push_back(std::move(point));
+    if (node.points.size() > maxLeafSize)
+      Split(node);
+  }
+
+  /**
+   * Split a full leaf into leaves of nearby points.  The seed of each leaf is
+   * the point with the largest average distance to the seeds chosen so far
+   * (to all points for the first seed); the other points go to the leaf with
+   * the closest box.
+   */
+  void Split(Node& node)
+  {
+    std::vector<Point> points;
+    points.swap(node.points);
+
+    const size_t numObjectives = node.ideal.n_elem;
+    const size_t leaves = std::min(points.size(), std::max((size_t) 2,
+        (numChildren == 0) ? numObjectives + 1 : numChildren));
+
+    std::vector<bool> seed(points.size(), false);
+    std::vector<size_t> seeds;
+    while (seeds.size() < leaves)
+    {
+      size_t best = 0;
+      double bestDistance = -1.0;
+      for (size_t i = 0; i < points.size(); ++i)
+      {
+        if (seed[i])
+          continue;
+
+        double distance = 0.0;
+        const size_t count = seeds.empty() ? points.size() : seeds.size();
+        for (size_t k = 0; k < count; ++k)
+        {
+          const size_t j = seeds.empty() ? k : seeds[k];
+          distance += arma::accu(arma::square(points[i].objectives -
+              points[j].objectives));
+        }
+        if (distance / count > bestDistance)
+        {
+          best = i;
+          bestDistance = distance / count;
+        }
+      }
+
+      seed[best] = true;
+      seeds.push_back(best);
+    }
+
+    for (size_t k = 0; k < seeds.size(); ++k)
+    {
+      std::unique_ptr<Node> child(new Node());
+      child->ideal = points[seeds[k]].objectives;
+      child->nadir = points[seeds[k]].objectives;
+      child->points.push_back(std::move(points[seeds[k]]));
+      node.children.push_back(std::move(child));
+    }
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+      if (!seed[i])
+        Insert(node, std::move(points[i]));
+    }
+  }
+
+  //! Append the points of the subtree.
+  static void Collect(const Node& node,
+                      std::vector<arma::mat>& coordinates,
+                      arma::mat& objectives)
+  {
+    for (size_t i = 0; i < node.points.size(); ++i)
+    {
+      objectives.col(coordinates.size()) = node.points[i].objectives;
+      coordinates.push_back(node.points[i].coordinates);
+    }
+
+    for (size_t c = 0; c < node.children.size(); ++c)
+      Collect(*node.children[c], coordinates, objectives);
+  }
+
+  //! The maximum number of points in a leaf.
+  size_t maxLeafSize;
+  //! The number of leaves that a full leaf is split into.
+  size_t numChildren;
+  //! The number of archived points.
+  size_t size;
+  //! The root of the ND-tree.
+  Node root;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,385 @@
+/**
+ * @file divide_and_conquer_sort.hpp
+ *
+ * Divide-and-conquer non-dominated sort of Jensen, generalized by Fortin et al.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NSGA2_SORT_POLICIES_DIVIDE_AND_CONQUER_SORT_HPP
+#define ENSMALLEN_NSGA2_SORT_POLICIES_DIVIDE_AND_CONQUER_SORT_HPP
+
+#include "dominance.hpp"
+#include <map>
+
+namespace ens {
+
+/**
+ * Sort the population into Pareto fronts with the divide-and-conquer algorithm
+ * of Jensen, in the version of Fortin et al. that also handles candidates with
+ * equal objective values.  The candidates are recursively split at the median
+ * of one objective, and the problem with two objectives left is solved with a
+ * sweep.  This takes O(N log^{M - 1} N) time for N candidates and M objectives,
+ * so it is the fastest choice for large populations with few objectives; for
+ * many objectives, EfficientNonDominatedSort is usually faster.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @article{Jensen2003,
+ *   author  = {Jensen, Mikkel T.},
+ *   title   = {Reducing the Run-Time Complexity of Multiobjective EAs: The
+ *              NSGA-II and Other Algorithms},
+ *   journal = {IEEE Transactions on Evolutionary Computation},
+ *   year    = {2003},
+ *   volume  = {7},
+ *   number  = {5},
+ *   pages   = {503--515}
+ * }
+ *
+ * @inproceedings{Fortin2013,
+ *   author    = {Fortin, F{\'e}lix-Antoine and Grenier, Simon and Parizeau,
+ *                Marc},
+ *   title     = {Generalizing the Improved Run-Time Complexity Algorithm for
+ *                Non-Dominated Sorting},
+ *   booktitle = {Proceedings of the 15th Annual Conference on Genetic and
+ *                Evolutionary Computation},
+ *   year      = {2013},
+ *   pages     = {615--622},
+ *   publisher = {ACM}
+ * }
+ * @endcode
+ *
+ * See FastNonDominatedSort for the interface of sort policies.
+ */
+class DivideAndConquerSort
+{
+ public:
+  /**
+   * Sort the candidates into Pareto fronts.
+   *
+   * @tparam MatType Type of the objective matrix.
+   * @param objectives Objectives of the candidates, one column per candidate.
+   * @param fronts The candidates are sorted into these Pareto fronts. The first
+   *     front is the best, the second worse and so on.
+   * @param ranks The assigned ranks, i.e. the front of each candidate.
+   */
+  template<typename MatType>
+  void Sort(const MatType& objectives,
+            std::vector<std::vector<size_t> >& fronts,
+            std::vector<size_t>& ranks)
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    fronts.clear();
+    ranks.assign(objectives.n_cols, 0);
+    if (objectives.n_cols == 0)
+      return;
+
+    std::vector<size_t> order;
+    LexicographicOrder(objectives, order);
+
+    // Candidates with equal objectives get the same rank, so the recursion
+    // only works on the distinct points, which are stored in lexicographic
+    // order.  A point is then identified by its position in that order.
+    std::vector<size_t> point(order.size());
+    size_t numPoints = 0;
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      if (i > 0 && !std::equal(objectives.begin_col(order[i]),
+          objectives.end_col(order[i]), objectives.begin_col(order[i - 1])))
+      {
+        ++numPoints;
+      }
+      point[i] = numPoints;
+    }
+    ++numPoints;
+
+    arma::Mat<ElemType> points(objectives.n_rows, numPoints);
+    for (size_t i = 0; i < order.size(); ++i)
+      points.col(point[i]) = objectives.col(order[i]);
+
+    std::vector<size_t> pointRanks(numPoints, 0);
+    std::vector<size_t> all(numPoints);
+    for (size_t i = 0; i < numPoints; ++i)
+      all[i] = i;
+
+    HelperA(points, pointRanks, all, points.n_rows - 1);
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+      const size_t rank = pointRanks[point[i]];
+      ranks[order[i]] = rank;
+      if (rank >= fronts.size())
+        fronts.resize(rank + 1);
+    }
+
+    for (size_t i = 0; i < ranks.size(); ++i)
+      fronts[ranks[i]].push_back(i);
+  }
+
+ private:
+  /**
+   * Assign the ranks of the points in s among each other, taking into account
+   * objectives 0 to k.  The points in s are sorted, their objectives after k
+   * are equal, and their ranks already account for all points outside of s.
+   */
+  template<typename ElemType>
+  void HelperA(const arma::Mat<ElemType>& points,
+               std::vector<size_t>& ranks,
+               const std::vector<size_t>& s,
+               const size_t k)
+  {
+    if (s.size() < 2)
+      return;
+
+    if (s.size() == 2)
+    {
+      if (WeaklyDominates(points, s[0], s[1], k))
+        ranks[s[1]] = std::max(ranks[s[1]], ranks[s[0]] + 1);
+      return;
+    }
+
+    if (k == 0)
+    {
+      // The points only differ in the first objective, so they form a chain.
+      for (size_t i = 1; i < s.size(); ++i)
+        ranks[s[i]] = std::max(ranks[s[i]], ranks[s[i - 1]] + 1);
+      return;
+    }
+
+    if (k == 1)
+    {
+      SweepA(points, ranks, s);
+      return;
+    }
+
+    const ElemType median = Median(points, s, std::vector<size_t>(), k);
+    std::vector<size_t> less, equal, greater;
+    Split(points, s, k, median, less, equal, greater);
+
+    if (less.empty() && greater.empty())
+    {
+      HelperA(points, ranks, s, k - 1);
+      return;
+    }
+
+    HelperA(points, ranks, less, k);
+    HelperB(points, ranks, less, equal, k - 1);
+    HelperA(points, ranks, equal, k - 1);
+    HelperB(points, ranks, Merge(less, equal), greater, k - 1);
+    HelperA(points, ranks, greater, k);
+  }
+
+  /**
+   * Update the ranks of the points in h with the points in l, taking into
+   * account objectives 0 to k.  The ranks of the points in l are final, and
+   * every point in l is at least as good as every point in h in the objectives
+   * after k.
+   */
+  template<typename ElemType>
+  void HelperB(const arma::Mat<ElemType>& points,
+               std::vector<size_t>& ranks,
+               const std::vector<size_t>& l,
+               const std::vector<size_t>& h,
+               const size_t k)
+  {
+    if (l.empty() || h.empty())
+      return;
+
+    if (l.size() == 1 || h.size() == 1)
+    {
+      for (size_t q : h)
+      {
+        for (size_t p : l)
+        {
+          if (WeaklyDominates(points, p, q, k))
+            ranks[q] = std::max(ranks[q], ranks[p] + 1);
+        }
+      }
+      return;
+    }
+
+    if (k == 1)
+    {
+      SweepB(points, ranks, l, h);
+      return;
+    }
+
+    ElemType lMin = points(k, l[0]), lMax = lMin;
+    for (size_t p : l)
+    {
+      lMin = std::min(lMin, points(k, p));
+      lMax = std::max(lMax, points(k, p));
+    }
+
+    ElemType hMin = points(k, h[0]), hMax = hMin;
+    for (size_t q : h)
+    {
+      hMin = std::min(hMin, points(k, q));
+      hMax = std::max(hMax, points(k, q));
+    }
+
+    if (lMax <= hMin)
+    {
+      HelperB(points, ranks, l, h, k - 1);
+      return;
+    }
+    else if (lMin > hMax)
+    {
+      return;
+    }
+
+    const ElemType median = Median(points, l, h, k);
+    std::vector<size_t> lLess, lEqual, lGreater, hLess, hEqual, hGreater;
+    Split(points, l, k, median, lLess, lEqual, lGreater);
+    Split(points, h, k, median, hLess, hEqual, hGreater);
+
+    HelperB(points, ranks, lLess, hLess, k);
+    HelperB(points, ranks, Merge(lLess, lEqual), Merge(hEqual, hGreater),
+        k - 1);
+    HelperB(points, ranks, lGreater, hGreater, k);
+  }
+
+  /**
+   * Assign the ranks of the points in s with only the first two objectives
+   * left.  The points are swept in order, and a staircase holds the best rank
+   * for each value of the second objective seen so far.
+   */
+  template<typename ElemType>
+  void SweepA(const arma::Mat<ElemType>& points,
+              std::vector<size_t>& ranks,
+              const std::vector<size_t>& s)
+  {
+    std::map<ElemType, size_t> staircase;
+    for (size_t p : s)
+    {
+      Query(staircase, points(1, p), ranks[p]);
+      Insert(staircase, points(1, p), ranks[p]);
+    }
+  }
+
+  /**
+   * Update the ranks of the points in h with the points in l with only the
+   * first two objectives left.
+   */
+  template<typename ElemType>
+  void SweepB(const arma::Mat<ElemType>& points,
+              std::vector<size_t>& ranks,
+              const std::vector<size_t>& l,
+              const std::vector<size_t>& h)
+  {
+    std::map<ElemType, size_t> staircase;
+    size_t i = 0;
+    for (size_t q : h)
+    {
+      for (; i < l.size() && l[i] < q; ++i)
+        Insert(staircase, points(1, l[i]), ranks[l[i]]);
+
+      Query(staircase, points(1, q), ranks[q]);
+    }
+  }
+
+  //! Raise rank above the ranks of all staircase entries with key <= value.
+  template<typename ElemType>
+  static void Query(const std::map<ElemType, size_t>& staircase,
+                    const ElemType value,
+                    size_t& rank)
+  {
+    typename std::map<ElemType, size_t>::const_iterator it =
+        staircase.upper_bound(value);
+    if (it != staircase.begin())
+      rank = std::max(rank, std::prev(it)->second + 1);
+  }
+
+  //! Insert an entry into the staircase, whose ranks increase with the key.
+  template<typename ElemType>
+  static void Insert(std::map<ElemType, size_t>& staircase,
+                     const ElemType value,
+                     const size_t rank)
+  {
+    typename std::map<ElemType, size_t>::iterator it =
+        staircase.upper_bound(value);
+    if (it != staircase.begin() && std::prev(it)->second >= rank)
+      return;
+
+    it = staircase.lower_bound(value);
+    while (it != staircase.end() && it->second <= rank)
+      it = staircase.erase(it);
+
+    staircase[value] = rank;
+  }
+
+  //! Check if point p is at least as good as point q in objectives 0 to k.
+  template<typename ElemType>
+  static bool WeaklyDominates(const arma::Mat<ElemType>& points,
+                              const size_t p,
+                              const size_t q,
+                              const size_t k)
+  {
+    const ElemType* a = points.colptr(p);
+    const ElemType* b = points.colptr(q);
+    for (size_t i = 0; i <= k; ++i)
+    {
+      if (a[i] > b[i])
+        return false;
+    }
+
+    return true;
+  }
+
+  //! Compute the median of objective k over the points in a and b.
+  template<typename ElemType>
+  static ElemType Median(const arma::Mat<ElemType>& points,
+                         const std::vector<size_t>& a,
+                         const std::vector<size_t>& b,
+                         const size_t k)
+  {
+    std::vector<ElemType> values;
+    values.reserve(a.size() + b.size());
+    for (size_t p : a)
+      values.push_back(points(k, p));
+    for (size_t q : b)
+      values.push_back(points(k, q));
+
+    std::nth_element(values.begin(), values.begin() + values.size() / 2,
+        values.end());
+    return values[values.size() / 2];
+  }
+
+  //! Split the points in s by objective k, keeping them in order.
+  template<typename ElemType>
+  static void Split(const arma::Mat<ElemType>& points,
+                    const std::vector<size_t>& s,
+                    const size_t k,
+                    const ElemType median,
+                    std::vector<size_t>& less,
+                    std::vector<size_t>& equal,
+                    std::vector<size_t>& greater)
+  {
+    for (size_t p : s)
+    {
+      if (points(k, p) < median)
+        less.push_back(p);
+      else if (points(k, p) > median)
+        greater.push_back(p);
+      else
+        equal.push_back(p);
+    }
+  }
+
+  //! Merge two sorted lists of points.
+  static std::vector<size_t> Merge(const std::vector<size_t>& a,
+                                   const std::vector<size_t>& b)
+  {
+    std::vector<size_t> merged(a.size() + b.size());
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), merged.begin());
+    return merged;
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file dominance.hpp
+ *
+ * Helper functions shared by the non-dominated sorting policies of NSGA2.
+ * Objectives are stored in a matrix with one column per candidate, so that the
+ * objectives of a candidate are contiguous in memory.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NSGA2_SORT_POLICIES_DOMINANCE_HPP
+#define ENSMALLEN_NSGA2_SORT_POLICIES_DOMINANCE_HPP
+
+namespace ens {
+
+/**
+ * Check if the candidate with objectives a Pareto-dominates the candidate with
+ * objectives b, i.e. a is at least as good as b for all objectives and strictly
+ * better for at least one.
+ *
+ * @param a Objectives of the first candidate.
+ * @param b Objectives of the second candidate.
+ * @param numObjectives Number of objectives.
+ * @return true if a Pareto dominates b, otherwise, false.
+ */
+template<typename ElemType>
+inline bool ParetoDominates(const ElemType* a,
+                            const ElemType* b,
+                            const size_t numObjectives)
+{
+  bool atleastOneBetter = false;
+  for (size_t i = 0; i < numObjectives; ++i)
+  {
+    if (a[i] > b[i])
+      return false;
+    else if (a[i] < b[i])
+      atleastOneBetter = true;
+  }
+
+  return atleastOneBetter;
+}
+
+/**
+ * Compare candidate p with each of the candidates [begin, end), several
+ * candidates at a time: for each candidate q of the block, better[q - begin]
+ * is set to whether p is better than q for at least one objective, and
+ * worse[q - begin] to whether p is worse than q for at least one objective.
+ * Thus p Pareto-dominates q if better && !worse, and q Pareto-dominates p if
+ * worse && !better, exactly as with ParetoDominates().
+ *
+ * The objectives are packed with one column per objective (i.e. the transpose
+ * of the usual objective matrix), so that each objective of the block is
+ * contiguous and the comparisons of one objective are vectorized over the
+ * candidates (4 doubles or 8 floats per instruction with AVX2).
+ *
+ * @param packed Packed objectives: element (q, k) is objective k of q.
+ * @param p The candidate to compare.
+ * @param begin The first candidate of the block.
+ * @param end One past the last candidate of the block.
+ * @param better Array of (end - begin) flags: whether p is better than q for
+ *     some objective.
+ * @param worse Array of (end - begin) flags: whether p is worse than q for some
+ *     objective.
+ */
+template<typename ElemType>
+inline void ParetoDominanceBlock(const arma::Mat<ElemType>& packed,
+                                 const size_t p,
+                                 const size_t begin,
+                                 const size_t end,
+                                 unsigned char* better,
+                                 unsigned char* worse)
+{
+  const size_t size = end - begin;
+  std::fill(better, better + size, (unsigned char) 0);
+  std::fill(worse, worse + size, (unsigned char) 0);
+
+  for (size_t k = 0; k < packed.n_cols; ++k)
+  {
+    const ElemType* values = packed.colptr(k) + begin;
+    const ElemType a = packed(p, k);
+
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = 0; i < size; ++i)
+    {
+      better[i] |= (unsigned char) (a < values[i]);
+      worse[i] |= (unsigned char) (a > values[i]);
+    }
+  }
+}
+
+/**
+ * Compute the order of the candidates (columns of objectives) sorted
+ * lexicographically by their objectives; ties are broken by index.  After this
+ * ordering, a candidate can only be dominated by candidates that precede it.
+ *
+ * @param objectives Objectives of the candidates, one column per candidate.
+ * @param order Vector to store the sorted indices into.
+ */
+template<typename MatType>
+inline void LexicographicOrder(const MatType& objectives,
+                               std::vector<size_t>& order)
+{
+  order.resize(objectives.n_cols);
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+
+  std::sort(order.begin(), order.end(),
+      [&objectives](const size_t p, const size_t q)
+      {
+        const typename MatType::elem_type* a = objectives.colptr(p);
+        const typename MatType::elem_type* b = objectives.colptr(q);
+        for (size_t i = 0; i < objectives.n_rows; ++i)
+        {
+          if (a[i] != b[i])
+            return a[i] < b[i];
+        }
+
+        return p < q;
+      });
+}
+
+} // namespace ens
+
+#endif
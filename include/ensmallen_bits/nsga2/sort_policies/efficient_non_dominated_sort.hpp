@@ -0,0 +1,151 @@
+/**
+ * @file efficient_non_dominated_sort.hpp
+ *
+ * Efficient non-dominated sort (ENS) with sequential or binary search.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NSGA2_SORT_POLICIES_EFFICIENT_NON_DOMINATED_SORT_HPP
+#define ENSMALLEN_NSGA2_SORT_POLICIES_EFFICIENT_NON_DOMINATED_SORT_HPP
+
+#include "dominance.hpp"
+
+namespace ens {
+
+/**
+ * Sort the population into Pareto fronts with the efficient non-dominated sort
+ * (ENS) of Zhang et al.  The candidates are first sorted lexicographically by
+ * their objectives, so that a candidate can only be dominated by candidates
+ * that precede it; the candidates are then assigned to fronts one at a time,
+ * and a candidate only needs to be compared with the members of the fronts that
+ * are searched for it.  The front is either searched sequentially (ENS-SS) or
+ * with a binary search over the fronts (ENS-BS); the binary search is usually
+ * faster when there are many fronts.  The worst case is O(M N^2) time for N
+ * candidates and M objectives, but far fewer comparisons are needed in
+ * practice, and only O(N) memory is used.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @article{Zhang2015,
+ *   author  = {Zhang, Xingyi and Tian, Ye and Cheng, Ran and Jin, Yaochu},
+ *   title   = {An Efficient Approach to Nondominated Sorting for Evolutionary
+ *              Multiobjective Optimization},
+ *   journal = {IEEE Transactions on Evolutionary Computation},
+ *   year    = {2015},
+ *   volume  = {19},
+ *   number  = {2},
+ *   pages   = {201--213}
+ * }
+ * @endcode
+ *
+ * See FastNonDominatedSort for the interface of sort policies.
+ */
+class EfficientNonDominatedSort
+{
+ public:
+  /**
+   * Construct the efficient non-dominated sort.
+   *
+   * @param binarySearch Whether to search the front of a candidate with a
+   *     binary search (ENS-BS) instead of a sequential search (ENS-SS).
+   */
+  EfficientNonDominatedSort(const bool binarySearch = true) :
+      binarySearch(binarySearch)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Sort the candidates into Pareto fronts.
+   *
+   * @tparam MatType Type of the objective matrix.
+   * @param objectives Objectives of the candidates, one column per candidate.
+   * @param fronts The candidates are sorted into these Pareto fronts. The first
+   *     front is the best, the second worse and so on.
+   * @param ranks The assigned ranks, i.e. the front of each candidate.
+   */
+  template<typename MatType>
+  void Sort(const MatType& objectives,
+            std::vector<std::vector<size_t> >& fronts,
+            std::vector<size_t>& ranks)
+  {
+    fronts.clear();
+    ranks.assign(objectives.n_cols, 0);
+
+    LexicographicOrder(objectives, order);
+
+    for (size_t p : order)
+    {
+      size_t front = 0;
+      if (binarySearch)
+      {
+        // If a front dominates p, then so do all the fronts before it.
+        size_t last = fronts.size();
+        while (front < last)
+        {
+          const size_t mid = front + (last - front) / 2;
+          if (FrontDominates(objectives, fronts[mid], p))
+            front = mid + 1;
+          else
+            last = mid;
+        }
+      }
+      else
+      {
+        while (front < fronts.size() &&
+            FrontDominates(objectives, fronts[front], p))
+        {
+          ++front;
+        }
+      }
+
+      if (front == fronts.size())
+        fronts.push_back(std::vector<size_t>());
+
+      fronts[front].push_back(p);
+      ranks[p] = front;
+    }
+  }
+
+  //! Get whether or not a binary search is used.
+  bool BinarySearch() const { return binarySearch; }
+  //! Modify whether or not a binary search is used.
+  bool& BinarySearch() { return binarySearch; }
+
+ private:
+  /**
+   * Check if any member of the front dominates candidate p.  The most recently
+   * added members are the closest to p in the lexicographic order, and so they
+   * are checked first.
+   */
+  template<typename MatType>
+  bool FrontDominates(const MatType& objectives,
+                      const std::vector<size_t>& front,
+                      const size_t p) const
+  {
+    for (size_t i = front.size(); i > 0; --i)
+    {
+      if (ParetoDominates(objectives.colptr(front[i - 1]), objectives.colptr(p),
+          objectives.n_rows))
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  //! Whether or not a binary search is used.
+  bool binarySearch;
+
+  //! The lexicographic order of the candidates.
+  std::vector<size_t> order;
+};
+
+} // namespace ens
+
+#endif
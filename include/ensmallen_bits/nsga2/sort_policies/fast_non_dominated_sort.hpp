@@ -0,0 +1,158 @@
+/**
+ * @file fast_non_dominated_sort.hpp
+ *
+ * The fast non-dominated sort of the original NSGA-II paper.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_NSGA2_SORT_POLICIES_FAST_NON_DOMINATED_SORT_HPP
+#define ENSMALLEN_NSGA2_SORT_POLICIES_FAST_NON_DOMINATED_SORT_HPP
+
+#include "dominance.hpp"
+
+namespace ens {
+
+/**
+ * Sort the population into Pareto fronts by comparing every pair of candidates,
+ * as proposed by Deb et al. in the NSGA-II paper.  This takes O(M N^2) time and
+ * O(N^2) memory for N candidates and M objectives; for large populations,
+ * EfficientNonDominatedSort or DivideAndConquerSort are usually much faster.
+ * The objectives are packed with one column per objective, so that each
+ * candidate is compared with blocks of the following candidates with
+ * vectorized comparisons (see ParetoDominanceBlock()).
+ *
+ * A sort policy is a class with the following method:
+ *
+ * @code
+ * template<typename MatType>
+ * void Sort(const MatType& objectives,
+ *           std::vector<std::vector<size_t>>& fronts,
+ *           std::vector<size_t>& ranks);
+ * @endcode
+ *
+ * where `objectives` holds the objectives of the candidates, one column per
+ * candidate.  The indices of the candidates in each front, best front first,
+ * are stored in `fronts`, and the index of the front of each candidate is
+ * stored in `ranks`.  No front is empty.
+ */
+class FastNonDominatedSort
+{
+ public:
+  /**
+   * Sort the candidates into Pareto fronts.
+   *
+   * @tparam MatType Type of the objective matrix.
+   * @param objectives Objectives of the candidates, one column per candidate.
+   * @param fronts The candidates are sorted into these Pareto fronts. The first
+   *     front is the best, the second worse and so on.
+   * @param ranks The assigned ranks, i.e. the front of each candidate.
+   */
+  template<typename MatType>
+  void Sort(const MatType& objectives,
+            std::vector<std::vector<size_t> >& fronts,
+            std::vector<size_t>& ranks)
+  {
+    typedef typename MatType::elem_type ElemType;
+    const size_t n = objectives.n_cols;
+
+    fronts.clear();
+    ranks.assign(n, 0);
+    dominationCount.assign(n, 0);
+    offsets.assign(n + 1, 0);
+    edges.clear();
+
+    // Compare each pair of candidates once and collect the domination edges;
+    // each candidate is compared with blocks of the following candidates.
+    const arma::Mat<ElemType> packed = objectives.t();
+    better.resize(BlockSize);
+    worse.resize(BlockSize);
+    for (size_t p = 0; p < n; ++p)
+    {
+      for (size_t begin = p + 1; begin < n; begin += BlockSize)
+      {
+        const size_t end = std::min(begin + BlockSize, n);
+        ParetoDominanceBlock(packed, p, begin, end, better.data(),
+            worse.data());
+        for (size_t q = begin; q < end; ++q)
+        {
+          const unsigned char b = better[q - begin];
+          const unsigned char w = worse[q - begin];
+          if (b != w)
+          {
+            // Either p dominates q, or q dominates p.
+            edges.push_back(b ? p : q);
+            edges.push_back(b ? q : p);
+          }
+        }
+      }
+    }
+
+    // Store the candidates dominated by each candidate contiguously.
+    for (size_t e = 0; e < edges.size(); e += 2)
+    {
+      ++offsets[edges[e] + 1];
+      ++dominationCount[edges[e + 1]];
+    }
+    for (size_t p = 0; p < n; ++p)
+      offsets[p + 1] += offsets[p];
+
+    dominated.resize(edges.size() / 2);
+    next.assign(offsets.begin(), offsets.end() - 1);
+    for (size_t e = 0; e < edges.size(); e += 2)
+      dominated[next[edges[e]]++] = edges[e + 1];
+
+    std::vector<size_t> front;
+    for (size_t p = 0; p < n; ++p)
+    {
+      if (dominationCount[p] == 0)
+        front.push_back(p);
+    }
+
+    while (!front.empty())
+    {
+      std::vector<size_t> nextFront;
+      for (size_t p : front)
+      {
+        for (size_t i = offsets[p]; i < offsets[p + 1]; ++i)
+        {
+          const size_t q = dominated[i];
+          if (--dominationCount[q] == 0)
+          {
+            ranks[q] = fronts.size() + 1;
+            nextFront.push_back(q);
+          }
+        }
+      }
+
+      fronts.push_back(std::move(front));
+      front = std::move(nextFront);
+    }
+  }
+
+ private:
+  //! The number of candidates compared with a candidate at once.
+  static constexpr size_t BlockSize = 256;
+
+  //! The flags of the candidates of a block that p is better than.
+  std::vector<unsigned char> better;
+  //! The flags of the candidates of a block that p is worse than.
+  std::vector<unsigned char> worse;
+  //! The number of candidates dominating each candidate.
+  std::vector<size_t> dominationCount;
+  //! Pairs (p, q) of candidates where p dominates q.
+  std::vector<size_t> edges;
+  //! The candidates dominated by candidate p are stored in
+  //! dominated[offsets[p]] to dominated[offsets[p + 1] - 1].
+  std::vector<size_t> offsets;
+  //! The candidates dominated by each candidate.
+  std::vector<size_t> dominated;
+  //! The next free position in dominated for each candidate.
+  std::vector<size_t> next;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file owlqn.hpp
+ *
+ * Orthant-wise limited-memory quasi-Newton (OWL-QN) optimizer for
+ * L1-regularized objectives.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_OWLQN_OWLQN_HPP
+#define ENSMALLEN_OWLQN_OWLQN_HPP
+
+#include <ensmallen_bits/lbfgs/lbfgs.hpp>
+
+namespace ens {
+
+/**
+ * OWL-QN minimizes objectives of the form
+ *
+ * \f[
+ * F(x) = f(x) + \lambda \| x \|_1
+ * \f]
+ *
+ * where f(x) is a differentiable function, by restricting each step of L-BFGS
+ * to the orthant of the current iterate.  Within an orthant the L1 term is
+ * linear, so the L-BFGS approximation of f is used with the pseudo-gradient of
+ * F in place of the gradient, and every point of the line search is projected
+ * back onto the orthant.  Coordinates that would change sign are set to
+ * exactly zero instead, so the iterate stays sparse throughout the
+ * optimization.
+ *
+ * For more information, please refer to:
+ *
+ * @code
+ * @inproceedings{Andrew2007,
+ *   author    = {Andrew, Galen and Gao, Jianfeng},
+ *   title     = {Scalable Training of L1-Regularized Log-Linear Models},
+ *   booktitle = {Proceedings of the 24th International Conference on Machine
+ *                Learning},
+ *   year      = {2007},
+ *   pages     = {33--40}
+ * }
+ * @endcode
+ *
+ * OWLQN can optimize differentiable functions; the L1 penalty is added by the
+ * optimizer and must not be part of the function.  The history of the search
+ * directions is shared with L_BFGS, whose parameters are also available here.
+ */
+class OWLQN : public L_BFGS
+{
+ public:
+  /**
+   * Initialize the OWL-QN object.  There are many parameters that can be set
+   * for the optimization, but default values are given for each of them.
+   *
+   * @param lambda Strength of the L1 penalty.
+   * @param numBasis Number of memory points to be stored.
+   * @param maxIterations Maximum number of iterations for the optimization
+   *     (0 means no limit and may run indefinitely).
+   * @param armijoConstant Controls the accuracy of the line search routine for
+   *     determining the Armijo condition.
+   * @param minGradientNorm Minimum norm of the pseudo-gradient required to
+   *     continue the optimization.
+   * @param factr Minimum relative function value decrease to continue
+   *     the optimization.
+   * @param maxLineSearchTrials The maximum number of trials for the line search
+   *     (before giving up).
+   * @param minStep The minimum step of the line search.
+   */
+  OWLQN(const double lambda = 1.0,
+        const size_t numBasis = 10,
+        const size_t maxIterations = 10000,
+        const double armijoConstant = 1e-4,
+        const double minGradientNorm = 1e-6,
+        const double factr = 1e-15,
+        const size_t maxLineSearchTrials = 50,
+        const double minStep = 1e-20);
+
+  /**
+   * Use OWL-QN to minimize f(x) + lambda * |x|_1 for the given function f,
+   * starting at the given iterate point.  The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value (including the L1 penalty) is returned.
+   *
+   * @tparam FunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize; must have Evaluate() and Gradient().
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsArmaType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(FunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<SeparableFunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the strength of the L1 penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the strength of the L1 penalty.
+  double& Lambda() { return lambda; }
+
+ private:
+  //! The strength of the L1 penalty.
+  double lambda;
+
+  /**
+   * Compute the pseudo-gradient of f(x) + lambda * |x|_1: the gradient of the
+   * objective where it is differentiable, and otherwise the one-sided
+   * derivative with the smallest magnitude, or zero if x is a minimum along
+   * that coordinate.
+   *
+   * @param iterate Current point.
+   * @param gradient Gradient of f at the current point.
+   * @param pseudoGradient Matrix to store the pseudo-gradient into.
+   */
+  template<typename MatType, typename GradType>
+  void PseudoGradient(const MatType& iterate,
+                      const GradType& gradient,
+                      GradType& pseudoGradient) const;
+
+  /**
+   * Perform a back-tracking line search along the search direction, projecting
+   * each trial point onto the orthant of the current iterate, until the
+   * objective decreases sufficiently.
+   *
+   * @param function Function to optimize.
+   * @param objective Objective (including the penalty) at the initial point.
+   * @param iterate The initial point to begin the line search from.
+   * @param gradient Gradient of f at the initial point.
+   * @param newIterateTmp Storage for the trial points.
+   * @param pseudoGradient The pseudo-gradient at the initial point.
+   * @param searchDirection A vector specifying the search direction.
+   * @param finalStepSize The resulting step size (0 if no step).
+   * @param callbacks Callback functions.
+   *
+   * @return false if no step size is suitable, true otherwise.
+   */
+  template<typename FunctionType,
+           typename ElemType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  bool LineSearch(FunctionType& function,
+                  ElemType& objective,
+                  MatType& iterate,
+                  GradType& gradient,
+                  MatType& newIterateTmp,
+                  const GradType& pseudoGradient,
+                  const GradType& searchDirection,
+                  double& finalStepSize,
+                  CallbackTypes&... callbacks);
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "owlqn_impl.hpp"
+
+#endif
@@ -0,0 +1,268 @@
+/**
+ * @file owlqn_impl.hpp
+ *
+ * Implementation of the OWL-QN optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_OWLQN_OWLQN_IMPL_HPP
+#define ENSMALLEN_OWLQN_OWLQN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "owlqn.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline OWLQN::OWLQN(const double lambda,
+                    const size_t numBasis,
+                    const size_t maxIterations,
+                    const double armijoConstant,
+                    const double minGradientNorm,
+                    const double factr,
+                    const size_t maxLineSearchTrials,
+                    const double minStep) :
+    L_BFGS(numBasis, maxIterations, armijoConstant, 0.9, minGradientNorm,
+        factr, maxLineSearchTrials, minStep),
+    lambda(lambda)
+{
+  // Nothing to do.
+}
+
+template<typename MatType, typename GradType>
+inline void OWLQN::PseudoGradient(const MatType& iterate,
+                                  const GradType& gradient,
+                                  GradType& pseudoGradient) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  pseudoGradient.set_size(gradient.n_rows, gradient.n_cols);
+  const ElemType* x = iterate.memptr();
+  const ElemType* g = gradient.memptr();
+  ElemType* pg = pseudoGradient.memptr();
+  const ElemType l = (ElemType) lambda;
+
+  for (size_t i = 0; i < iterate.n_elem; ++i)
+  {
+    if (x[i] > 0)
+      pg[i] = g[i] + l;
+    else if (x[i] < 0)
+      pg[i] = g[i] - l;
+    else if (g[i] + l < 0)
+      pg[i] = g[i] + l;
+    else if (g[i] - l > 0)
+      pg[i] = g[i] - l;
+    else
+      pg[i] = 0;
+  }
+}
+
+template<typename FunctionType,
+         typename ElemType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+bool OWLQN::LineSearch(FunctionType& function,
+                       ElemType& objective,
+                       MatType& iterate,
+                       GradType& gradient,
+                       MatType& newIterateTmp,
+                       const GradType& pseudoGradient,
+                       const GradType& searchDirection,
+                       double& finalStepSize,
+                       CallbackTypes&... callbacks)
+{
+  finalStepSize = 0.0; // Set only when we take the step.
+
+  const ElemType initialObjective = objective;
+  const ElemType* x = iterate.memptr();
+  const ElemType* pg = pseudoGradient.memptr();
+  const ElemType* d = searchDirection.memptr();
+
+  double stepSize = 1.0;
+  for (size_t numIterations = 0; numIterations < maxLineSearchTrials;
+      ++numIterations)
+  {
+    // Take the step and project it onto the orthant of the iterate; for zero
+    // coordinates, that is the orthant the pseudo-gradient points away from.
+    // At the same time, compute the first order estimate of the decrease.
+    ElemType* newX = newIterateTmp.memptr();
+    ElemType penalty = 0;
+    ElemType decrease = 0;
+    for (size_t i = 0; i < iterate.n_elem; ++i)
+    {
+      const ElemType orthant = (x[i] != 0) ? x[i] : -pg[i];
+      newX[i] = x[i] + stepSize * d[i];
+      if (newX[i] * orthant <= 0)
+        newX[i] = 0;
+
+      penalty += std::abs(newX[i]);
+      decrease += pg[i] * (newX[i] - x[i]);
+    }
+
+    const ElemType functionValue = function.EvaluateWithGradient(
+        newIterateTmp, gradient);
+    terminate |= Callback::EvaluateWithGradient(*this, function, newIterateTmp,
+        functionValue, gradient, callbacks...);
+
+    objective = functionValue + lambda * penalty;
+    if (objective <= initialObjective + armijoConstant * decrease)
+    {
+      // Copy, so that the memory of the iterate is kept.
+      iterate = newIterateTmp;
+      finalStepSize = stepSize;
+      return true;
+    }
+
+    stepSize *= 0.5;
+    if (stepSize < minStep || terminate)
+      break;
+  }
+
+  return false;
+}
+
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsArmaType<GradType>::value,
+typename MatType::elem_type>::type
+OWLQN::Optimize(FunctionType& function,
+                MatType& iterateIn,
+                CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Use the Function<> wrapper to ensure the function has all of the functions
+  // that we need.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f = static_cast<FullFunctionType&>(function);
+
+  // Check that we have all the functions we will need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+  RequireDenseFloatingPointType<BaseMatType>();
+  RequireDenseFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  const size_t rows = iterate.n_rows;
+  const size_t cols = iterate.n_cols;
+
+  BaseMatType newIterateTmp(rows, cols);
+  arma::Mat<ElemType> history(rows * cols, 2 * numBasis);
+  arma::Mat<ElemType> gram(2 * numBasis, 2 * numBasis, arma::fill::zeros);
+
+  BaseMatType oldIterate(rows, cols, arma::fill::zeros);
+  BaseGradType gradient(rows, cols, arma::fill::zeros);
+  BaseGradType oldGradient(rows, cols, arma::fill::zeros);
+  BaseGradType pseudoGradient(rows, cols, arma::fill::zeros);
+  BaseGradType searchDirection(rows, cols, arma::fill::zeros);
+
+  // Whether to optimize until convergence.
+  const bool optimizeUntilConvergence = (maxIterations == 0);
+
+  // The initial function value and gradient.
+  const ElemType functionValue = f.EvaluateWithGradient(iterate, gradient);
+  terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+      functionValue, gradient, callbacks...);
+
+  ElemType objective = functionValue + lambda * arma::accu(arma::abs(iterate));
+  ElemType prevObjective = objective;
+
+  // The main optimization loop.
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  for (size_t itNum = 0; (optimizeUntilConvergence || (itNum != maxIterations))
+      && !terminate; ++itNum)
+  {
+    prevObjective = objective;
+
+    // The pseudo-gradient is zero exactly at the minimum.
+    PseudoGradient(iterate, gradient, pseudoGradient);
+    if (arma::norm(pseudoGradient, 2) < minGradientNorm)
+    {
+      Info << "OWL-QN pseudo-gradient norm too small (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    // Break if the objective is not a number.
+    if (std::isnan(objective))
+    {
+      Warn << "OWL-QN terminated with objective " << objective << "; "
+          << "are the objective and gradient functions implemented correctly?"
+          << std::endl;
+      break;
+    }
+
+    // The curvature pairs only describe f, so the L-BFGS direction is computed
+    // for the pseudo-gradient as if it were the gradient.
+    const double scalingFactor = ChooseScalingFactor(itNum, pseudoGradient,
+        gram);
+    if (scalingFactor == 0.0)
+    {
+      Info << "OWL-QN scaling factor computed as 0 (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    SearchDirection(pseudoGradient, itNum, scalingFactor, history, gram,
+        searchDirection);
+
+    // Only keep the components of the direction that agree in sign with the
+    // steepest descent direction, so that the step stays in the orthant.
+    ElemType* d = searchDirection.memptr();
+    const ElemType* pg = pseudoGradient.memptr();
+    for (size_t i = 0; i < searchDirection.n_elem; ++i)
+    {
+      if (d[i] * pg[i] >= 0)
+        d[i] = 0;
+    }
+
+    // Save the old iterate and the gradient before stepping.
+    oldIterate = iterate;
+    oldGradient = gradient;
+
+    double stepSize; // Set by LineSearch().
+    if (!LineSearch(f, objective, iterate, gradient, newIterateTmp,
+        pseudoGradient, searchDirection, stepSize, callbacks...))
+    {
+      // The iterate was not changed, but the objective was.
+      objective = prevObjective;
+      Warn << "Line search failed.  Stopping optimization." << std::endl;
+      break;
+    }
+
+    // If we can't make progress, then we'll accept a stable objective.
+    const double denom = std::max(
+        std::max(std::abs(prevObjective), std::abs(objective)),
+        (ElemType) 1.0);
+    if ((prevObjective - objective) / denom <= factr)
+    {
+      Info << "OWL-QN function value stable (terminating successfully)."
+          << std::endl;
+      break;
+    }
+
+    // Overwrite an old basis set.
+    UpdateBasisSet(itNum, iterate, oldIterate, gradient, oldGradient, history,
+        gram);
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  } // End of the optimization loop.
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return objective;
+}
+
+} // namespace ens
+
+#endif
@@ -12,6 +12,9 @@
 #ifndef ENSMALLEN_PADAM_PADAM_UPDATE_HPP
 #define ENSMALLEN_PADAM_PADAM_UPDATE_HPP
 
+#include <ensmallen_bits/utility/compact_state.hpp>
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -19,6 +22,10 @@ namespace ens {
  * adopts historical gradient information to automatically adjust the
  * learning rate.
  *
+ * For dense matrices, the update is fused into one pass over the elements, and
+ * the moment estimates can be stored in bfloat16 or in 8-bit blocks (see
+ * CompactState), to divide the memory of the state by 2 or 4.
+ *
  * For more information, see the following.
  *
  * @code
@@ -42,16 +49,21 @@ class PadamUpdate
    * @param beta1 The smoothing parameter.
    * @param beta2 The second moment coefficient.
    * @param partial Partially adaptive parameter.
+   * @param stateBits Number of bits per element of the moment estimates: 0
+   *     (full precision), 16 (bfloat16) or 8 (8-bit blocks); only dense
+   *     matrices support 16 and 8.
    */
   PadamUpdate(const double epsilon = 1e-8,
               const double beta1 = 0.9,
               const double beta2 = 0.999,
-              const double partial = 0.25) :
+              const double partial = 0.25,
+              const size_t stateBits = 0) :
       epsilon(epsilon),
       beta1(beta1),
       beta2(beta2),
       partial(partial),
-      iteration(0)
+      iteration(0),
+      stateBits(stateBits)
   {
     // Nothing to do.
   }
@@ -81,6 +93,17 @@ class PadamUpdate
   //! Modify the current iteration number.
   size_t& Iteration() { return iteration; }
 
+  //! Get the number of bits per element of the moment estimates.
+  size_t StateBits() const { return stateBits; }
+  //! Modify the number of bits per element of the moment estimates.
+  size_t& StateBits() { return stateBits; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the two moment estimates and the maximum of the second.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return 3 * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -102,9 +125,7 @@ class PadamUpdate
     Policy(PadamUpdate& parent, const size_t rows, const size_t cols) :
         parent(parent)
     {
-      m.zeros(rows, cols);
-      v.zeros(rows, cols);
-      vImproved.zeros(rows, cols);
+      Initialize(rows, cols, UseFusedUpdate<MatType, GradType>());
     }
 
     /**
@@ -121,6 +142,100 @@ class PadamUpdate
       // Increment the iteration counter variable.
       ++parent.iteration;
 
+      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
+          parent.iteration);
+      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
+          parent.iteration);
+
+      Update(iterate, stepSize * std::sqrt(biasCorrection2) / biasCorrection1,
+          gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! The type of the moment estimates: compact for dense matrices.
+    typedef typename std::conditional<UseFusedUpdate<MatType, GradType>::value,
+        CompactState<typename MatType::elem_type>, GradType>::type StateType;
+
+    //! Initialize the compact moment estimates.
+    void Initialize(const size_t rows, const size_t cols, std::true_type)
+    {
+      m = StateType(parent.stateBits);
+      v = StateType(parent.stateBits);
+      vImproved = StateType(parent.stateBits);
+      m.Zeros(rows * cols);
+      v.Zeros(rows * cols);
+      vImproved.Zeros(rows * cols);
+    }
+
+    //! Initialize the moment estimates.
+    void Initialize(const size_t rows, const size_t cols, std::false_type)
+    {
+      if (parent.stateBits != 0)
+      {
+        throw std::invalid_argument("PadamUpdate: the moment estimates can "
+            "only have fewer bits for dense matrices.");
+      }
+
+      m.zeros(rows, cols);
+      v.zeros(rows, cols);
+      vImproved.zeros(rows, cols);
+    }
+
+    //! Fused update for dense matrices: one pass over the elements, one block
+    //! of the moment estimates at a time.
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType partial = ElemType(parent.partial);
+      const ElemType a = ElemType(alpha);
+
+      ElemType mScratch[StateType::BlockSize];
+      ElemType vScratch[StateType::BlockSize];
+      ElemType vImprovedScratch[StateType::BlockSize];
+      for (size_t b = 0; b < m.NumBlocks(); ++b)
+      {
+        const size_t begin = b * StateType::BlockSize;
+        const size_t length = m.BlockLength(b);
+        ElemType* x = iterate.memptr() + begin;
+        const ElemType* g = gradient.memptr() + begin;
+        ElemType* mp = m.Block(b, mScratch);
+        ElemType* vp = v.Block(b, vScratch);
+        ElemType* vImprovedp = vImproved.Block(b, vImprovedScratch);
+
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = 0; i < length; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+          const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+          const ElemType vImprovedi = std::max(vImprovedp[i], vi);
+          mp[i] = mi;
+          vp[i] = vi;
+          vImprovedp[i] = vImprovedi;
+          x[i] -= a * mi / std::pow(vImprovedi + eps, partial);
+        }
+
+        m.Store(b, mp);
+        v.Store(b, vp);
+        vImproved.Store(b, vImprovedp);
+      }
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double alpha,
+                const GradType& gradient,
+                std::false_type /* fused */)
+    {
       // And update the iterate.
       m *= parent.beta1;
       m += (1 - parent.beta1) * gradient;
@@ -128,30 +243,24 @@ class PadamUpdate
       v *= parent.beta2;
       v += (1 - parent.beta2) * (gradient % gradient);
 
-      const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
-          parent.iteration);
-      const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
-          parent.iteration);
-
       // Element wise maximum of past and present squared gradients.
       vImproved = arma::max(vImproved, v);
 
-      iterate -= (stepSize * std::sqrt(biasCorrection2) / biasCorrection1) *
-          m / arma::pow(vImproved + parent.epsilon, parent.partial);
+      iterate -= alpha * m / arma::pow(vImproved + parent.epsilon,
+          parent.partial);
     }
 
-   private:
     //! Instantiated parent object.
     PadamUpdate& parent;
 
     //! The exponential moving average of gradient values.
-    GradType m;
+    StateType m;
 
     //! The exponential moving average of squared gradient values.
-    GradType v;
+    StateType v;
 
     //! The optimal sqaured gradient value.
-    GradType vImproved;
+    StateType vImproved;
   };
 
  private:
@@ -169,6 +278,9 @@ class PadamUpdate
 
   //! The number of iterations.
   size_t iteration;
+
+  //! The number of bits per element of the moment estimates.
+  size_t stateBits;
 };
 
 } // namespace ens
@@ -0,0 +1,119 @@
+/**
+ * @file callback_events.hpp
+ *
+ * A buffer of the Gradient() and StepTaken() callback events of one thread of
+ * a parallel optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_CALLBACK_EVENTS_HPP
+#define ENSMALLEN_PARALLEL_SGD_CALLBACK_EVENTS_HPP
+
+#include <ensmallen_bits/callbacks/callbacks.hpp>
+
+namespace ens {
+
+/**
+ * CallbackEvents records the steps that one thread of ParallelSGD (or of the
+ * asynchronous inner loop of SVRG, or a parallel chain of SARAH) takes, so
+ * that the Gradient() and StepTaken() callbacks can be called later by a
+ * single thread, instead of concurrently by all of them.  The gradient of each
+ * step is only copied if it is needed by a Gradient() callback; the storage of
+ * the copies is reused after each Replay().
+ *
+ * @tparam GradType Type of the gradients.
+ */
+template<typename GradType>
+class CallbackEvents
+{
+ public:
+  /**
+   * Create an empty buffer.
+   *
+   * @param capacity The number of steps after which Full() is true (0 means
+   *     no limit).
+   */
+  CallbackEvents(const size_t capacity = 0) :
+      capacity(capacity),
+      steps(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Record a step.
+   *
+   * @param gradient The gradient of the step.
+   * @param keepGradient Whether or not the gradient must be copied.
+   */
+  void Add(const GradType& gradient, const bool keepGradient)
+  {
+    if (keepGradient)
+    {
+      if (gradients.size() <= steps)
+        gradients.resize(steps + 1);
+      gradients[steps] = gradient;
+    }
+
+    ++steps;
+  }
+
+  /**
+   * Call the Gradient() (if the gradients were kept) and StepTaken() callbacks
+   * for each recorded step, in order, and clear the buffer.
+   *
+   * @param optimizer The optimizer used to update the function.
+   * @param function Function to optimize.
+   * @param coordinates The coordinates to give to the callbacks.
+   * @param keepGradients Whether or not the gradients were kept.
+   * @param callbacks The callbacks to call.
+   * @return true if a callback asked to terminate the optimization.
+   */
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  bool Replay(OptimizerType& optimizer,
+              FunctionType& function,
+              MatType& coordinates,
+              const bool keepGradients,
+              CallbackTypes&... callbacks)
+  {
+    bool terminate = false;
+    for (size_t k = 0; k < steps; ++k)
+    {
+      if (keepGradients)
+      {
+        terminate |= Callback::Gradient(optimizer, function, coordinates,
+            gradients[k], callbacks...);
+      }
+
+      terminate |= Callback::StepTaken(optimizer, function, coordinates,
+          callbacks...);
+    }
+
+    steps = 0;
+    return terminate;
+  }
+
+  //! Get the number of recorded steps.
+  size_t Steps() const { return steps; }
+
+  //! Return whether the buffer holds capacity steps.
+  bool Full() const { return capacity > 0 && steps >= capacity; }
+
+ private:
+  //! The number of steps after which the buffer is full.
+  size_t capacity;
+
+  //! The number of recorded steps.
+  size_t steps;
+
+  //! The gradients of the recorded steps, if they are kept.
+  std::vector<GradType> gradients;
+};
+
+} // namespace ens
+
+#endif
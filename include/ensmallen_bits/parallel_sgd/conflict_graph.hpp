@@ -0,0 +1,198 @@
+/**
+ * @file conflict_graph.hpp
+ *
+ * The conflict graph of a sample of batches, for the conflict-free scheduling
+ * of parallel SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PARALLEL_SGD_CONFLICT_GRAPH_HPP
+#define ENSMALLEN_PARALLEL_SGD_CONFLICT_GRAPH_HPP
+
+namespace ens {
+
+/**
+ * ConflictGraph partitions a sample of batches into groups that don't share
+ * any element of the iterate, as in CYCLADES:
+ *
+ * @code
+ * @inproceedings{Pan2016,
+ *   author    = {Pan, Xinghao and Lam, Maximilian and Tu, Stephen and
+ *                Papailiopoulos, Dimitris and Zhang, Ce and Jordan, Michael I.
+ *                and Ramchandran, Kannan and Re, Christopher and Recht,
+ *                Benjamin},
+ *   title     = {CYCLADES: Conflict-free Asynchronous Machine Learning},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   year      = {2016}
+ * }
+ * @endcode
+ *
+ * Two batches conflict if their sparsity patterns (the elements of the iterate
+ * that they read or update) intersect.  The connected components of the
+ * conflict graph are found with a union-find over the elements, in time linear
+ * in the total size of the patterns, and the components are then assigned to
+ * the threads, largest first, to the thread with the fewest batches so far.
+ * Each thread gets its batches in the order of the sample, so running the
+ * threads in parallel, without any locks or atomic operations, gives the same
+ * result as visiting the whole sample in that order.
+ */
+class ConflictGraph
+{
+ public:
+  //! Create an empty graph.
+  ConflictGraph() : round(0) { }
+
+  /**
+   * Partition the given number of batches into the given number of threads.
+   * The sparsity pattern of batch u is given by pattern(u, elements), which
+   * sets the linear indices of the elements of the iterate that it uses (in
+   * [0, numElements)).
+   *
+   * @param numBatches Number of batches of the sample.
+   * @param numElements Number of elements of the iterate.
+   * @param numThreads Number of threads to partition the batches into.
+   * @param pattern Callable that gives the sparsity pattern of a batch.
+   */
+  template<typename PatternType>
+  void Partition(const size_t numBatches,
+                 const size_t numElements,
+                 const size_t numThreads,
+                 PatternType pattern)
+  {
+    // The owners of the elements are reset lazily, with a round counter.
+    if (owner.size() != numElements)
+    {
+      owner.assign(numElements, 0);
+      stamp.assign(numElements, 0);
+      round = 0;
+    }
+    ++round;
+
+    parent.resize(numBatches);
+    for (size_t u = 0; u < numBatches; ++u)
+    {
+      parent[u] = u;
+      pattern(u, elements);
+      for (size_t k = 0; k < elements.n_elem; ++k)
+      {
+        const size_t e = elements[k];
+        if (e >= numElements)
+        {
+          throw std::invalid_argument("ConflictGraph::Partition(): the "
+              "sparsity pattern has an element outside of the iterate!");
+        }
+
+        if (stamp[e] == round)
+        {
+          Union(u, owner[e]);
+        }
+        else
+        {
+          stamp[e] = round;
+          owner[e] = u;
+        }
+      }
+    }
+
+    // Collect the batches of each component, in the order of the sample.
+    components.clear();
+    componentOf.assign(numBatches, numBatches);
+    for (size_t u = 0; u < numBatches; ++u)
+    {
+      const size_t root = Find(u);
+      if (componentOf[root] == numBatches)
+      {
+        componentOf[root] = components.size();
+        components.push_back(std::vector<size_t>());
+      }
+      components[componentOf[root]].push_back(u);
+    }
+
+    // Assign the largest components first, each to the least loaded thread.
+    std::vector<size_t> order(components.size());
+    for (size_t c = 0; c < order.size(); ++c)
+      order[c] = c;
+    std::stable_sort(order.begin(), order.end(),
+        [this](const size_t a, const size_t b)
+        { return components[a].size() > components[b].size(); });
+
+    const size_t threads = std::max(numThreads, (size_t) 1);
+    threadBatches.assign(threads, std::vector<size_t>());
+    for (size_t c = 0; c < order.size(); ++c)
+    {
+      size_t least = 0;
+      for (size_t t = 1; t < threads; ++t)
+      {
+        if (threadBatches[t].size() < threadBatches[least].size())
+          least = t;
+      }
+
+      const std::vector<size_t>& component = components[order[c]];
+      threadBatches[least].insert(threadBatches[least].end(),
+          component.begin(), component.end());
+    }
+  }
+
+  //! Get the number of connected components of the last partition.
+  size_t NumComponents() const { return components.size(); }
+
+  //! Get the size of the largest connected component of the last partition.
+  size_t LargestComponent() const
+  {
+    size_t largest = 0;
+    for (size_t c = 0; c < components.size(); ++c)
+      largest = std::max(largest, components[c].size());
+    return largest;
+  }
+
+  //! Get the batches (indices into the sample) assigned to the given thread.
+  const std::vector<size_t>& Batches(const size_t thread) const
+  {
+    return threadBatches[thread];
+  }
+
+ private:
+  //! Find the root of the given batch, halving the path.
+  size_t Find(size_t u)
+  {
+    while (parent[u] != u)
+    {
+      parent[u] = parent[parent[u]];
+      u = parent[u];
+    }
+    return u;
+  }
+
+  //! Merge the components of the given batches.
+  void Union(const size_t a, const size_t b)
+  {
+    const size_t ra = Find(a);
+    const size_t rb = Find(b);
+    if (ra != rb)
+      parent[std::max(ra, rb)] = std::min(ra, rb);
+  }
+
+  //! The last batch of the current round that used each element.
+  std::vector<size_t> owner;
+  //! The round in which each element was last used.
+  std::vector<size_t> stamp;
+  //! The current round.
+  size_t round;
+  //! The parent of each batch in the union-find.
+  std::vector<size_t> parent;
+  //! The component of each root batch.
+  std::vector<size_t> componentOf;
+  //! The batches of each component.
+  std::vector<std::vector<size_t>> components;
+  //! The batches assigned to each thread.
+  std::vector<std::vector<size_t>> threadBatches;
+  //! The sparsity pattern of the current batch.
+  arma::uvec elements;
+};
+
+} // namespace ens
+
+#endif
@@ -14,6 +14,8 @@
 
 #include "decay_policies/constant_step.hpp"
 #include "decay_policies/exponential_backoff.hpp"
+#include "conflict_graph.hpp"
+#include "callback_events.hpp"
 
 namespace ens {
 
@@ -34,6 +36,114 @@ namespace ens {
  * }
  * @endcode
  *
+ * If the iterate is a sparse matrix, every update of an element normally has to
+ * happen in a critical section, since it may change the sparsity pattern; this
+ * serializes the threads.  If FixedSparsity() is set to true, the sparsity
+ * pattern of the iterate is instead kept fixed to the pattern of the starting
+ * point: updates of elements in the pattern are done with atomic operations,
+ * and updates of elements outside of it are discarded.
+ *
+ * By default, each thread processes a fixed range of threadShareSize
+ * datapoints of the visitation order in each iteration, so datapoints beyond
+ * the ranges of all threads are skipped, and threads with more expensive
+ * datapoints finish later.  If DynamicScheduling() is set to true, the batches
+ * of the whole visitation order are instead handed out one at a time to
+ * whichever thread is free next, and threadShareSize is not used.
+ *
+ * Both of these schedules give results that depend on the number of threads
+ * and on the timing of the updates.  If DeterministicReduction() is set to
+ * true, every batch of the visitation order is instead processed in rounds of
+ * as many batches as fit in threadShareSize datapoints: the gradients of the
+ * batches of a round are computed in parallel at the same iterate, summed in a
+ * fixed pairwise order, and then applied at once.  The result is then the same
+ * for any number of threads (and the updates don't need atomic operations), at
+ * the cost of a synchronization after each round.  As with dynamic scheduling,
+ * each iteration then covers the whole visitation order, so it does more work
+ * than an iteration of the default schedule whenever the threadShareSize
+ * ranges of the threads don't cover all the datapoints; the number of rounds
+ * can't depend on the number of threads without losing reproducibility.
+ *
+ * With many cores, the threads all write to the same iterate, so the cache
+ * lines of frequently updated coordinates move between the cores (and sockets)
+ * all the time.  If Replicas() is set to r > 1, the threads are instead split
+ * into r contiguous groups, each of which runs HOGWILD! on its own copy of the
+ * iterate; the copies are averaged every AveragingInterval() iterations, and
+ * the objective is only evaluated (and the tolerance only checked) after an
+ * averaging.  With one replica per socket (e.g. OMP_PLACES=sockets and
+ * OMP_PROC_BIND=close), a coordinate is then only shared between the cores of
+ * one socket, at the cost of progress lost by averaging.  Replicas aren't used
+ * with DeterministicReduction(), and there are never more replicas than
+ * threads.
+ *
+ * On sparse problems with a few frequent features, the HOGWILD! updates of
+ * different threads conflict all the time.  If ConflictScheduling() is set to
+ * true, the batches of the visitation order are instead processed in samples
+ * of as many batches per thread as fit in threadShareSize datapoints; the
+ * batches of a sample are partitioned into the connected components of their
+ * conflict graph, from the sparsity patterns reported by the function (see
+ * ConflictGraph), the components are assigned to the threads, and each thread
+ * visits its batches in order.  The batches of different threads then never
+ * touch the same element, so the updates need no locks or atomic operations
+ * (except for the values of a sparse iterate with FixedSparsity()), and the
+ * result is the same as visiting each sample serially.  This requires the
+ * function to have the method
+ *
+ * @code
+ * void SparsityPattern(const size_t i,
+ *                      const size_t batchSize,
+ *                      arma::uvec& elements) const;
+ * @endcode
+ *
+ * which stores in elements the linear indices of the elements of the iterate
+ * that the objectives of the functions i, ..., i + batchSize - 1 depend on.  A
+ * sparse iterate without FixedSparsity() is updated by one thread.  Replicas
+ * aren't used with ConflictScheduling().
+ *
+ * Functions such as matrix factorizations, whose functions each depend on one
+ * row and one column of a matrix, can instead be scheduled by strata, as in
+ * DSGD and FPSGD.  If StratifiedScheduling() is set to true, the rows and the
+ * columns are split into p strata (NumStrata(), or the number of threads if it
+ * is 0), which splits the functions into p x p blocks.  Each iteration is then
+ * made of p sub-epochs; in each of them, the blocks (a, sigma(a)) for a
+ * permutation sigma visit their batches in order in parallel.  These blocks
+ * share no row and no column, so the updates need no locks or atomic
+ * operations, and the threads work on disjoint parts of the iterate.  Every
+ * batch is processed once per iteration, and threadShareSize is not used.  If
+ * shuffle is true, the order of the column strata and the order of the batches
+ * in each block are shuffled in each iteration.  For a fixed NumStrata(), the
+ * result doesn't depend on the number of threads.  This requires the function
+ * to have the method
+ *
+ * @code
+ * void Stratify(const size_t numStrata, arma::uvec& offsets);
+ * @endcode
+ *
+ * which reorders the functions so that the functions of block (a, b) are the
+ * contiguous functions offsets[a * numStrata + b], ...,
+ * offsets[a * numStrata + b + 1] - 1 (offsets has numStrata * numStrata + 1
+ * elements), and such that the functions of blocks in different row strata and
+ * column strata depend on disjoint elements of the iterate.  Replicas aren't
+ * used with StratifiedScheduling().
+ *
+ * At the start of each iteration, the objective is evaluated for the tolerance
+ * check.  If ParallelObjective() is set to true, it is evaluated in parallel
+ * over the batches (the separable Evaluate() must then be safe to call in
+ * parallel on disjoint batches); if ObjectiveSubsample() is set to m > 0, the
+ * convergence is only checked on the objective estimated from m functions (in
+ * whole batches) that are drawn at random once, so that the estimates of
+ * successive iterations are comparable.  The exact objective is still
+ * evaluated once, when the optimization terminates.
+ *
+ * The Gradient() and StepTaken() callbacks are never called concurrently, so
+ * callbacks need no locks.  Each thread records its steps (and copies of the
+ * gradients, if a callback has a Gradient() method), and the steps are
+ * replayed in order by one thread at the end of each parallel section (an
+ * iteration, a sub-epoch, a sample or a round), in the order of the threads.
+ * If CallbackBufferSize() is not 0, a thread also replays its steps under a
+ * lock once it has recorded that many; the callbacks then see the iterate
+ * while the other threads update it.  When a callback asks to terminate, an
+ * atomic flag stops all the threads before their next batch.
+ *
  * ParallelSGD can optimize sparse differentiable separable functions.  For more
  * details, see the documentation on function types included with this
  * distribution or on the ensmallen website.
@@ -48,7 +158,10 @@ class ParallelSGD
   /**
    * Construct the parallel SGD optimizer to optimize the given function with
    * the given parameters. One iteration means one batch of datapoints processed
-   * by each thread.
+   * by each thread.  Within that share, each thread computes the gradient of
+   * batchSize datapoints at a time, and applies it to the shared iterate in
+   * one pass over its nonzero elements.  The threadShareSize is rounded up to
+   * a whole number of batches.
    *
    * The defaults here are not necessarily good for the given problem, so it is
    * suggested that the values used be tailored to the task at hand.
@@ -61,12 +174,15 @@ class ParallelSGD
    * @param shuffle If true, the function order is shuffled; otherwise, each
    *     function is visited in linear order.
    * @param decayPolicy The step size update policy to use.
+   * @param batchSize Number of datapoints whose gradient is computed with one
+   *     call to Gradient() and applied to the iterate in one pass.
   */
   ParallelSGD(const size_t maxIterations,
               const size_t threadShareSize,
               const double tolerance = 1e-5,
               const bool shuffle = true,
-              const DecayPolicyType& decayPolicy = DecayPolicyType());
+              const DecayPolicyType& decayPolicy = DecayPolicyType(),
+              const size_t batchSize = 1);
 
   /**
    * Optimize the given function using the parallel SGD algorithm. The given
@@ -77,7 +193,7 @@ class ParallelSGD
    * @tparam SparseFunctionType Type of function to be optimized.
    * @tparam MatType Type of the objective function.
    * @tparam GradType Type of gradient (it is strongly suggested that this be a
-   *     sparse matrix of some sort!).
+   *     sparse matrix of some sort, e.g. arma::SpMat or RowSparseMat!).
    * @tparam CallbackTypes Types of callback functions.
    * @param function Function to be optimized(minimized).
    * @param iterate Starting point(will be modified).
@@ -88,8 +204,8 @@ class ParallelSGD
             typename MatType,
             typename GradType,
             typename... CallbackTypes>
-  typename std::enable_if<IsArmaType<GradType>::value,
-      typename MatType::elem_type>::type
+  typename std::enable_if<IsArmaType<GradType>::value ||
+      IsRowSparseType<GradType>::value, typename MatType::elem_type>::type
   Optimize(SparseFunctionType& function,
            MatType& iterate,
            CallbackTypes&&... callbacks);
@@ -119,6 +235,11 @@ class ParallelSGD
   //! thread.
   size_t& ThreadShareSize() { return threadShareSize; }
 
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
   //! Get the tolerance for termination.
   double Tolerance() const { return tolerance; }
   //! Modify the tolerance for termination.
@@ -134,13 +255,123 @@ class ParallelSGD
   //! Modify the step size decay policy.
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
+  //! Get whether or not the sparsity pattern of a sparse iterate is fixed.
+  bool FixedSparsity() const { return fixedSparsity; }
+  //! Modify whether or not the sparsity pattern of a sparse iterate is fixed.
+  bool& FixedSparsity() { return fixedSparsity; }
+
+  //! Get whether or not the batches are scheduled dynamically.
+  bool DynamicScheduling() const { return dynamicScheduling; }
+  //! Modify whether or not the batches are scheduled dynamically.
+  bool& DynamicScheduling() { return dynamicScheduling; }
+
+  //! Get whether or not the batches are processed in rounds whose updates
+  //! don't depend on the number of threads.
+  bool DeterministicReduction() const { return deterministicReduction; }
+  //! Modify whether or not the batches are processed in rounds whose updates
+  //! don't depend on the number of threads.
+  bool& DeterministicReduction() { return deterministicReduction; }
+
+  //! Get whether or not the batches are scheduled by their conflicts.
+  bool ConflictScheduling() const { return conflictScheduling; }
+  //! Modify whether or not the batches are scheduled by their conflicts.
+  bool& ConflictScheduling() { return conflictScheduling; }
+
+  //! Get whether or not the batches are scheduled by strata.
+  bool StratifiedScheduling() const { return stratifiedScheduling; }
+  //! Modify whether or not the batches are scheduled by strata.
+  bool& StratifiedScheduling() { return stratifiedScheduling; }
+
+  //! Get the number of strata of the stratified scheduling (0 means the
+  //! number of threads).
+  size_t NumStrata() const { return numStrata; }
+  //! Modify the number of strata of the stratified scheduling (0 means the
+  //! number of threads).
+  size_t& NumStrata() { return numStrata; }
+
+  //! Get whether or not the objective is evaluated in parallel.
+  bool ParallelObjective() const { return parallelObjective; }
+  //! Modify whether or not the objective is evaluated in parallel.
+  bool& ParallelObjective() { return parallelObjective; }
+
+  //! Get the number of functions that the convergence is checked on (0 means
+  //! all functions).
+  size_t ObjectiveSubsample() const { return objectiveSubsample; }
+  //! Modify the number of functions that the convergence is checked on (0
+  //! means all functions).
+  size_t& ObjectiveSubsample() { return objectiveSubsample; }
+
+  //! Get the number of replicas of the iterate.
+  size_t Replicas() const { return replicas; }
+  //! Modify the number of replicas of the iterate.
+  size_t& Replicas() { return replicas; }
+
+  //! Get the number of iterations between two averagings of the replicas.
+  size_t AveragingInterval() const { return averagingInterval; }
+  //! Modify the number of iterations between two averagings of the replicas.
+  size_t& AveragingInterval() { return averagingInterval; }
+
+  //! Get the number of steps a thread records before it replays them to the
+  //! callbacks (0 means only at the end of each parallel section).
+  size_t CallbackBufferSize() const { return callbackBufferSize; }
+  //! Modify the number of steps a thread records before it replays them to
+  //! the callbacks (0 means only at the end of each parallel section).
+  size_t& CallbackBufferSize() { return callbackBufferSize; }
+
  private:
+  //! Store the sparsity pattern of the given batch of the function.
+  template<typename SparseFunctionType>
+  static void SparsityPattern(const SparseFunctionType& function,
+                              const size_t begin,
+                              const size_t batchSize,
+                              arma::uvec& elements,
+                              const std::true_type /* hasSparsityPattern */)
+  {
+    function.SparsityPattern(begin, batchSize, elements);
+  }
+
+  //! The function has no sparsity pattern, so conflicts can't be scheduled.
+  template<typename SparseFunctionType>
+  static void SparsityPattern(const SparseFunctionType& /* function */,
+                              const size_t /* begin */,
+                              const size_t /* batchSize */,
+                              arma::uvec& /* elements */,
+                              const std::false_type /* hasSparsityPattern */)
+  {
+    throw std::logic_error("ParallelSGD::Optimize(): ConflictScheduling() "
+        "requires the function to have a SparsityPattern() method!");
+  }
+
+  //! Order the functions by the blocks of the strata.
+  template<typename SparseFunctionType>
+  static void Stratify(SparseFunctionType& function,
+                       const size_t strata,
+                       arma::uvec& offsets,
+                       const std::true_type /* hasStratify */)
+  {
+    function.Stratify(strata, offsets);
+  }
+
+  //! The function can't be stratified.
+  template<typename SparseFunctionType>
+  static void Stratify(SparseFunctionType& /* function */,
+                       const size_t /* strata */,
+                       arma::uvec& /* offsets */,
+                       const std::false_type /* hasStratify */)
+  {
+    throw std::logic_error("ParallelSGD::Optimize(): StratifiedScheduling() "
+        "requires the function to have a Stratify() method!");
+  }
+
   //! The maximum number of allowed iterations.
   size_t maxIterations;
 
   //! The number of datapoints to be processed in one iteration by each thread.
   size_t threadShareSize;
 
+  //! The number of datapoints in each batch.
+  size_t batchSize;
+
   //! The tolerance for termination.
   double tolerance;
 
@@ -150,6 +381,47 @@ class ParallelSGD
 
   //! The step size decay policy.
   DecayPolicyType decayPolicy;
+
+  //! If true, the sparsity pattern of a sparse iterate is fixed, so that its
+  //! values can be updated with atomic operations.
+  bool fixedSparsity;
+
+  //! If true, every batch is processed in each iteration, by whichever thread
+  //! is free next.
+  bool dynamicScheduling;
+
+  //! If true, the batches are processed in rounds, and the summed gradient of
+  //! each round is applied once all of its batches are done.
+  bool deterministicReduction;
+
+  //! If true, the batches are processed in samples that are partitioned into
+  //! conflict-free groups, one per thread.
+  bool conflictScheduling;
+
+  //! If true, the batches are processed by blocks of strata, the blocks of a
+  //! sub-epoch sharing no row and no column.
+  bool stratifiedScheduling;
+
+  //! The number of strata (0 means the number of threads).
+  size_t numStrata;
+
+  //! If true, the objective is evaluated in parallel over the batches.
+  bool parallelObjective;
+
+  //! The number of functions of the random subsample that the convergence is
+  //! checked on (0 means all functions).
+  size_t objectiveSubsample;
+
+  //! The number of copies of the iterate, each of which is updated by its own
+  //! group of threads.
+  size_t replicas;
+
+  //! The number of iterations after which the replicas are averaged.
+  size_t averagingInterval;
+
+  //! The number of steps a thread records before it replays them to the
+  //! callbacks.
+  size_t callbackBufferSize;
 };
 
 } // namespace ens
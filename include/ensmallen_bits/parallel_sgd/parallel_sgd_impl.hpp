@@ -19,44 +19,193 @@
 
 namespace ens {
 
+// Utility function to atomically subtract the given value from an element,
+// for any threads (not only OpenMP ones).  The element is accessed through a
+// std::atomic of the same size, with a compare-and-swap loop.
+template<typename eT>
+inline void AtomicSubtract(eT& location, const eT value)
+{
+  static_assert(sizeof(std::atomic<eT>) == sizeof(eT),
+      "AtomicSubtract(): std::atomic<eT> must have the size of eT");
+
+  std::atomic<eT>& element = reinterpret_cast<std::atomic<eT>&>(location);
+  eT expected = element.load(std::memory_order_relaxed);
+  while (!element.compare_exchange_weak(expected, expected - value,
+      std::memory_order_relaxed)) { }
+}
+
 // Utility function to update a location of a dense matrix or other type using
-// an atomic section.
+// an atomic update.
 template<typename MatType>
 inline void UpdateLocation(MatType& iterate,
                            const size_t row,
                            const size_t col,
                            const typename MatType::elem_type value)
 {
-  ENS_PRAGMA_OMP_ATOMIC
-  iterate(row, col) -= value;
+  AtomicSubtract(iterate(row, col), value);
 }
 
-// Utility function to update a location of a sparse matrix using a critical
-// section.
+// Utility function to update a location of a sparse matrix under a lock, since
+// the update may insert the element.
 template<typename eT>
 inline void UpdateLocation(arma::SpMat<eT>& iterate,
                            const size_t row,
                            const size_t col,
                            const eT value)
 {
-  ENS_PRAGMA_OMP_CRITICAL_NAMED
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  iterate(row, col) -= value;
+}
+
+// Utility function to update a location of a dense matrix or other type whose
+// sparsity pattern is fixed; for these types this is the same as
+// UpdateLocation().
+template<typename MatType>
+inline void UpdateFixedLocation(MatType& iterate,
+                                const size_t row,
+                                const size_t col,
+                                const typename MatType::elem_type value)
+{
+  UpdateLocation(iterate, row, col, value);
+}
+
+// Utility function to update a location of a sparse matrix whose sparsity
+// pattern is fixed, using an atomic update of its values array.  If the given
+// location is not part of the sparsity pattern, the update is discarded.
+template<typename eT>
+inline void UpdateFixedLocation(arma::SpMat<eT>& iterate,
+                                const size_t row,
+                                const size_t col,
+                                const eT value)
+{
+  const arma::uword* colBegin = iterate.row_indices + iterate.col_ptrs[col];
+  const arma::uword* colEnd = iterate.row_indices + iterate.col_ptrs[col + 1];
+  const arma::uword* pos = std::lower_bound(colBegin, colEnd,
+      (arma::uword) row);
+  if (pos == colEnd || (*pos) != row)
+    return;
+
+  eT* values = arma::access::rwp(iterate.values);
+  const size_t index = pos - iterate.row_indices;
+
+  AtomicSubtract(values[index], value);
+}
+
+// Utility function to make sure that the compressed representation of a matrix
+// is the only valid one, so that its values can be modified directly.  This
+// does nothing for dense matrices.
+template<typename MatType>
+inline void ResetSparseCache(MatType& /* iterate */) { }
+
+// Utility function to make sure that the compressed representation of a sparse
+// matrix is the only valid one, so that its values can be modified directly.
+// Copying the matrix discards Armadillo's element cache.
+template<typename eT>
+inline void ResetSparseCache(arma::SpMat<eT>& iterate)
+{
+  const arma::SpMat<eT> copy(iterate);
+  iterate = copy;
+}
+
+// Utility function to subtract the nonzero elements of the given sparse
+// gradient, times the step size, from the iterate.  If `atomic` is true, the
+// locations are updated with UpdateLocation(), since other threads may update
+// the iterate at the same time.
+template<typename MatType, typename GradType>
+inline void SubtractGradient(MatType& iterate,
+                             const GradType& gradient,
+                             const double stepSize,
+                             const bool fixedSparsity,
+                             const bool atomic)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  for (size_t i = 0; i < gradient.n_cols; ++i)
   {
-    iterate(row, col) -= value;
+    // Iterate over the non-zero elements.
+    const typename GradType::const_iterator curEnd = gradient.end_col(i);
+    for (typename GradType::const_iterator cur = gradient.begin_col(i);
+        cur != curEnd; ++cur)
+    {
+      const ElemType value = stepSize * (*cur);
+      if (fixedSparsity)
+        UpdateFixedLocation(iterate, cur.row(), i, value);
+      else if (atomic)
+        UpdateLocation(iterate, cur.row(), i, value);
+      else
+        iterate(cur.row(), i) -= value;
+    }
+  }
+}
+
+// Utility function to subtract the touched rows of the given row-sparse
+// gradient, times the step size, from the iterate, in the same way.
+template<typename MatType, typename eT>
+inline void SubtractGradient(MatType& iterate,
+                             const RowSparseMat<eT>& gradient,
+                             const double stepSize,
+                             const bool fixedSparsity,
+                             const bool atomic)
+{
+  for (size_t k = 0; k < gradient.NumTouchedRows(); ++k)
+  {
+    const size_t row = gradient.RowIndex(k);
+    const eT* values = gradient.RowValues(k);
+    for (size_t i = 0; i < gradient.n_cols; ++i)
+    {
+      const eT value = stepSize * values[i];
+      if (fixedSparsity)
+        UpdateFixedLocation(iterate, row, i, value);
+      else if (atomic)
+        UpdateLocation(iterate, row, i, value);
+      else
+        iterate(row, i) -= value;
+    }
   }
 }
 
+// Utility function to set the iterate to the average of the first n replicas,
+// and then all the replicas to the iterate.
+template<typename MatType>
+inline void AverageReplicas(MatType& iterate,
+                            std::vector<MatType>& replicas,
+                            const size_t n)
+{
+  iterate = replicas[0];
+  for (size_t r = 1; r < n; ++r)
+    iterate += replicas[r];
+  iterate /= (typename MatType::elem_type) n;
+
+  for (size_t r = 0; r < replicas.size(); ++r)
+    replicas[r] = iterate;
+}
+
 template <typename DecayPolicyType>
 ParallelSGD<DecayPolicyType>::ParallelSGD(
     const size_t maxIterations,
     const size_t threadShareSize,
     const double tolerance,
     const bool shuffle,
-    const DecayPolicyType& decayPolicy) :
+    const DecayPolicyType& decayPolicy,
+    const size_t batchSize) :
     maxIterations(maxIterations),
     threadShareSize(threadShareSize),
+    batchSize(batchSize),
     tolerance(tolerance),
     shuffle(shuffle),
-    decayPolicy(decayPolicy)
+    decayPolicy(decayPolicy),
+    fixedSparsity(false),
+    dynamicScheduling(false),
+    deterministicReduction(false),
+    conflictScheduling(false),
+    stratifiedScheduling(false),
+    numStrata(0),
+    parallelObjective(false),
+    objectiveSubsample(0),
+    replicas(1),
+    averagingInterval(1),
+    callbackBufferSize(64)
 { /* Nothing to do. */ }
 
 template <typename DecayPolicyType>
@@ -64,7 +213,8 @@ template <typename SparseFunctionType,
           typename MatType,
           typename GradType,
           typename... CallbackTypes>
-typename std::enable_if<IsArmaType<GradType>::value,
+typename std::enable_if<IsArmaType<GradType>::value ||
+    IsRowSparseType<GradType>::value,
 typename MatType::elem_type>::type ParallelSGD<DecayPolicyType>::Optimize(
     SparseFunctionType& function,
     MatType& iterateIn,
@@ -84,16 +234,206 @@ typename MatType::elem_type>::type ParallelSGD<DecayPolicyType>::Optimize(
 
   BaseMatType& iterate = (BaseMatType&) iterateIn;
 
+  // If the sparsity pattern is fixed, the values of a sparse iterate are
+  // updated in place, so Armadillo must not hold a cached copy of them.
+  if (fixedSparsity)
+    ResetSparseCache(iterate);
+
   ElemType overallObjective = DBL_MAX;
   ElemType lastObjective;
 
   // Controls early termination of the optimization process.
   bool terminate = false;
 
-  // The order in which the functions will be visited.
-  // TODO: maybe use function.Shuffle() instead?
-  arma::Col<size_t> visitationOrder = arma::linspace<arma::Col<size_t>>(0,
-      (function.NumFunctions() - 1), function.NumFunctions());
+  // The functions are visited in batches of contiguous functions; the last
+  // batch may be smaller than the others.  Each thread processes
+  // batchesPerThread batches in each iteration.
+  const size_t numFunctions = function.NumFunctions();
+  const size_t actualBatchSize = std::max(batchSize, (size_t) 1);
+  const size_t numBatches = (numFunctions + actualBatchSize - 1) /
+      actualBatchSize;
+  const size_t batchesPerThread = (threadShareSize + actualBatchSize - 1) /
+      actualBatchSize;
+
+  // The order in which the batches will be visited: the j'th batch is
+  // batch(j).  If shuffle is true, the order is an implicit random
+  // permutation that is redrawn in each iteration, so no order of numBatches
+  // indices is stored.  The stream is seeded from the generator of Armadillo.
+  RandomStream rng;
+  RandomPermutation visitationOrder(numBatches, rng);
+  auto batch = [&](const size_t j) -> size_t
+  {
+    return shuffle ? visitationOrder(j) : j;
+  };
+
+  // The convergence is checked on the objective of the first subsampleBatches
+  // batches of a random order that is drawn once, scaled to all functions.
+  const size_t subsampleBatches = (objectiveSubsample == 0) ? numBatches :
+      std::min(numBatches, (objectiveSubsample + actualBatchSize - 1) /
+      actualBatchSize);
+  RandomPermutation subsample;
+  size_t subsamplePoints = 0;
+  if (subsampleBatches < numBatches)
+  {
+    subsample.Reset(numBatches, rng);
+    for (size_t b = 0; b < subsampleBatches; ++b)
+    {
+      subsamplePoints += std::min(actualBatchSize,
+          numFunctions - subsample(b) * actualBatchSize);
+    }
+  }
+
+  // Return the objective (or its estimate on the subsample, if exact is
+  // false), evaluated in parallel over the batches if parallelObjective is
+  // true.  In parallel, the objectives of the batches are reduced in a fixed
+  // order, so they don't depend on the number of threads.
+  std::vector<ElemType> batchObjectives;
+  auto evaluate = [&](const bool exact) -> ElemType
+  {
+    const bool full = exact || subsampleBatches == numBatches;
+    if (full && !parallelObjective)
+      return function.Evaluate(iterate);
+
+    const size_t evaluatedBatches = full ? numBatches : subsampleBatches;
+    batchObjectives.assign(std::max(evaluatedBatches, (size_t) 1),
+        ElemType(0));
+    ParallelFor(evaluatedBatches, [&](const size_t b)
+    {
+      const size_t begin = (full ? b : subsample(b)) * actualBatchSize;
+      batchObjectives[b] = function.Evaluate(iterate, begin,
+          std::min(actualBatchSize, numFunctions - begin));
+    }, parallelObjective);
+
+    PairwiseReduce(batchObjectives, evaluatedBatches);
+    if (full)
+      return batchObjectives[0];
+
+    return batchObjectives[0] * ElemType(numFunctions) /
+        ElemType(subsamplePoints);
+  };
+
+  // With several replicas, each group of threads updates its own copy of the
+  // iterate, and the copies are averaged into the iterate every
+  // averagingInterval iterations.  There can't be more replicas than threads.
+  const size_t maxThreads = MaxThreads();
+  const size_t numReplicas = (deterministicReduction || conflictScheduling ||
+      stratifiedScheduling) ? 1 :
+      std::max(std::min(replicas, maxThreads), (size_t) 1);
+  const size_t actualAveragingInterval = std::max(averagingInterval,
+      (size_t) 1);
+  std::vector<BaseMatType> replicaIterates((numReplicas > 1) ? numReplicas :
+      0, iterate);
+  size_t activeReplicas = numReplicas;
+
+  // Whether or not the iterate holds all the updates; the objective is only
+  // evaluated then.
+  bool averaged = true;
+
+  // The partition of the samples of the conflict scheduling.
+  ConflictGraph conflictGraph;
+
+  // For the stratified scheduling, the functions are ordered by block once,
+  // and each block is split into batches; the first function of each batch is
+  // stored in batchBegins, and the batches of block k are batchBegins[k'] for
+  // blockBatches[k] <= k' < blockBatches[k + 1].
+  const size_t strata = (numStrata > 0) ? numStrata : MaxThreads();
+  arma::uvec blockOffsets, blockBatches, batchBegins;
+  if (stratifiedScheduling)
+  {
+    Stratify(function, strata, blockOffsets, std::integral_constant<bool,
+        traits::HasStratifySignature<SparseFunctionType>::value>());
+    if (blockOffsets.n_elem != strata * strata + 1 ||
+        blockOffsets[strata * strata] != numFunctions)
+    {
+      throw std::logic_error("ParallelSGD::Optimize(): Stratify() must "
+          "give the offsets of all the numStrata * numStrata blocks!");
+    }
+
+    blockBatches.zeros(strata * strata + 1);
+    for (size_t k = 0; k < strata * strata; ++k)
+    {
+      blockBatches[k + 1] = blockBatches[k] + (blockOffsets[k + 1] -
+          blockOffsets[k] + actualBatchSize - 1) / actualBatchSize;
+    }
+
+    batchBegins.set_size(blockBatches[strata * strata]);
+    for (size_t k = 0; k < strata * strata; ++k)
+    {
+      for (size_t b = blockBatches[k]; b < blockBatches[k + 1]; ++b)
+      {
+        batchBegins[b] = blockOffsets[k] + (b - blockBatches[k]) *
+            actualBatchSize;
+      }
+    }
+  }
+
+  // The Gradient() and StepTaken() callbacks are never called concurrently:
+  // each thread records its steps, and the steps are replayed by one thread
+  // when a buffer is full (under a lock) and at the end of each parallel
+  // section (in the order of the threads).  The gradients are only copied if
+  // a callback needs them.  A termination request is seen by all the threads
+  // through the atomic flag.
+  typedef ParallelSGD<DecayPolicyType> OptimizerType;
+  const bool keepGradients = callbacks::traits::AnyOf<callbacks::traits::
+      HasGradientSignature<typename std::remove_reference<CallbackTypes>::type,
+      OptimizerType, SparseFunctionType, BaseMatType, BaseGradType>::value...
+      >::value;
+  const bool recordSteps = keepGradients || callbacks::traits::AnyOf<
+      !callbacks::traits::HasStepTakenSignature<typename std::remove_reference<
+      CallbackTypes>::type, OptimizerType, SparseFunctionType,
+      BaseMatType>::hasNone...>::value;
+  std::vector<CallbackEvents<BaseGradType>> events;
+  std::mutex callbackMutex;
+  std::atomic<bool> stop(false);
+
+  // Record a step of the given thread, and replay its steps if its buffer is
+  // full.
+  auto record = [&](const size_t thread,
+                    BaseMatType& coordinates,
+                    const BaseGradType& gradient)
+  {
+    if (!recordSteps)
+      return;
+
+    events[thread].Add(gradient, keepGradients);
+    if (events[thread].Full())
+    {
+      std::lock_guard<std::mutex> lock(callbackMutex);
+      if (events[thread].Replay(*this, function, coordinates, keepGradients,
+          callbacks...))
+      {
+        stop.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // Make sure that there is a buffer for each of the given threads.
+  auto reserveEvents = [&](const size_t threads)
+  {
+    if (events.size() < threads)
+    {
+      events.resize(threads, CallbackEvents<BaseGradType>(
+          callbackBufferSize));
+    }
+  };
+
+  // Replay the remaining steps of all the threads, at the end of a parallel
+  // section.
+  auto replay = [&](const size_t threads,
+                    const std::function<BaseMatType&(size_t)>& coordinates)
+  {
+    for (size_t t = 0; t < threads && t < events.size(); ++t)
+    {
+      if (events[t].Steps() > 0 && events[t].Replay(*this, function,
+          coordinates(t), keepGradients, callbacks...))
+      {
+        stop.store(true, std::memory_order_relaxed);
+      }
+    }
+
+    terminate |= stop.load(std::memory_order_relaxed);
+  };
+  auto sharedIterate = [&](const size_t) -> BaseMatType& { return iterate; };
 
   // Iterate till the objective is within tolerance or the maximum number of
   // allowed iterations is reached. If maxIterations is 0, this will iterate
@@ -102,35 +442,41 @@ typename MatType::elem_type>::type ParallelSGD<DecayPolicyType>::Optimize(
       callbacks...);
   for (size_t i = 1; i != maxIterations && !terminate; ++i)
   {
-    // Calculate the overall objective.
-    lastObjective = overallObjective;
+    if (averaged)
+    {
+      // Calculate the overall objective.
+      lastObjective = overallObjective;
 
-    overallObjective = function.Evaluate(iterate);
+      overallObjective = evaluate(false);
 
-    terminate |= Callback::Evaluate(*this, function, iterate, overallObjective,
-        callbacks...);
+      terminate |= Callback::Evaluate(*this, function, iterate,
+          overallObjective, callbacks...);
 
-    // Output current objective function.
-    Info << "Parallel SGD: iteration " << i << ", objective "
-      << overallObjective << "." << std::endl;
+      // Output current objective function.
+      Info << "Parallel SGD: iteration " << i << ", objective "
+        << overallObjective << "." << std::endl;
 
-    if (std::isnan(overallObjective) || std::isinf(overallObjective))
-    {
-      Warn << "Parallel SGD: converged to " << overallObjective
-        << "; terminating with failure. Try a smaller step size?"
-        << std::endl;
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "Parallel SGD: converged to " << overallObjective
+          << "; terminating with failure. Try a smaller step size?"
+          << std::endl;
 
-      Callback::EndOptimization(*this, function, iterate, callbacks...);
-      return overallObjective;
-    }
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
 
-    if (std::abs(lastObjective - overallObjective) < tolerance)
-    {
-      Info << "SGD: minimized within tolerance " << tolerance << "; "
-        << "terminating optimization." << std::endl;
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "SGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
 
-      Callback::EndOptimization(*this, function, iterate, callbacks...);
-      return overallObjective;
+        if (subsampleBatches < numBatches)
+          overallObjective = evaluate(true);
+
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
     }
 
     // Get the stepsize for this iteration
@@ -140,56 +486,242 @@ typename MatType::elem_type>::type ParallelSGD<DecayPolicyType>::Optimize(
     if (shuffle)
     {
       // Determine order of visitation.
-      visitationOrder = arma::shuffle(visitationOrder);
+      visitationOrder.Reshuffle(rng);
     }
 
-    ENS_PRAGMA_OMP_PARALLEL
+    if (stratifiedScheduling)
     {
-      // Each processor gets a subset of the instances.
-      // Each subset is of size threadShareSize
-      size_t threadId = 0;
-      #ifdef ENS_USE_OPENMP
-        threadId = omp_get_thread_num();
-      #endif
+      // In sub-epoch s, the thread of row stratum a processes the block of
+      // column stratum columns[(a + s) % strata]; the blocks of a sub-epoch
+      // share no element, so each thread updates the iterate directly.  The
+      // values of a sparse iterate can only be updated in parallel if its
+      // sparsity pattern is fixed.
+      arma::uvec columns = arma::linspace<arma::uvec>(0, strata - 1, strata);
+      if (shuffle)
+      {
+        columns = arma::shuffle(columns);
+        for (size_t k = 0; k < strata * strata; ++k)
+        {
+          if (blockBatches[k + 1] > blockBatches[k] + 1)
+          {
+            batchBegins.subvec(blockBatches[k], blockBatches[k + 1] - 1) =
+                arma::shuffle(batchBegins.subvec(blockBatches[k],
+                blockBatches[k + 1] - 1));
+          }
+        }
+      }
 
-      for (size_t j = threadId * threadShareSize;
-          j < (threadId + 1) * threadShareSize && j < visitationOrder.n_elem;
-          ++j)
+      const bool parallelUpdates = fixedSparsity ||
+          !arma::is_arma_sparse_type<BaseMatType>::value;
+      reserveEvents(strata);
+      for (size_t s = 0; s < strata && !terminate; ++s)
       {
-        // Each instance affects only some components of the decision variable.
-        // So the gradient is sparse.
-        BaseGradType gradient;
+        ParallelFor(strata, [&](const size_t a)
+        {
+          BaseGradType gradient;
+          const size_t block = a * strata + columns[(a + s) % strata];
+          for (size_t b = blockBatches[block]; b < blockBatches[block + 1] &&
+              !stop.load(std::memory_order_relaxed); ++b)
+          {
+            const size_t begin = batchBegins[b];
+            const size_t effectiveBatchSize = std::min(actualBatchSize,
+                (size_t) blockOffsets[block + 1] - begin);
+            function.Gradient(iterate, begin, gradient, effectiveBatchSize);
+            SubtractGradient(iterate, gradient, stepSize, fixedSparsity,
+                false);
+            record(a, iterate, gradient);
+          }
+        }, parallelUpdates);
 
-        // Evaluate the sparse gradient.
-        // TODO: support for batch size > 1 could be really useful.
-        function.Gradient(iterate, visitationOrder[j], gradient, 1);
+        replay(strata, sharedIterate);
+      }
 
-        terminate |= Callback::Gradient(*this, function, iterate, gradient,
-            callbacks...);
+      continue;
+    }
 
-        // Update the decision variable with non-zero components of the
-        // gradient.
-        for (size_t i = 0; i < gradient.n_cols; ++i)
+    if (conflictScheduling)
+    {
+      // Process the visitation order in samples of batchesPerThread batches
+      // per thread; the batches of different threads don't conflict, so each
+      // thread updates the iterate directly.  The values of a sparse iterate
+      // can only be updated in parallel if its sparsity pattern is fixed.
+      const size_t threads = MaxThreads();
+      const size_t sampleSize = std::max(batchesPerThread, (size_t) 1) *
+          threads;
+      const bool parallelUpdates = fixedSparsity ||
+          !arma::is_arma_sparse_type<BaseMatType>::value;
+      for (size_t r = 0; r < numBatches && !terminate;
+          r += sampleSize)
+      {
+        const size_t sampleBatches = std::min(sampleSize,
+            numBatches - r);
+        conflictGraph.Partition(sampleBatches, iterate.n_elem, threads,
+            [&](const size_t u, arma::uvec& elements)
+            {
+              const size_t begin = batch(r + u) * actualBatchSize;
+              SparsityPattern(function, begin, std::min(actualBatchSize,
+                  numFunctions - begin), elements,
+                  std::integral_constant<bool, traits::
+                  HasSparsityPatternSignature<SparseFunctionType>::value>());
+            });
+
+        reserveEvents(threads);
+        ParallelFor(threads, [&](const size_t t)
         {
-          // Iterate over the non-zero elements.
-          const typename GradType::iterator curEnd = gradient.end_col(i);
-          for (typename GradType::iterator cur = gradient.begin_col(i);
-              cur != curEnd; ++cur)
+          BaseGradType gradient;
+          const std::vector<size_t>& batches = conflictGraph.Batches(t);
+          for (size_t k = 0; k < batches.size() &&
+              !stop.load(std::memory_order_relaxed); ++k)
           {
-            const ElemType value = (*cur);
-            const arma::uword row = cur.row();
-
-            // Call out to utility function to use the right type of OpenMP
-            // lock.
-            UpdateLocation(iterate, row, i, stepSize * value);
+            const size_t begin = batch(r + batches[k]) * actualBatchSize;
+            const size_t effectiveBatchSize = std::min(actualBatchSize,
+                numFunctions - begin);
+            {
+              ENS_TIMELINE_SCOPE("gradient");
+              function.Gradient(iterate, begin, gradient, effectiveBatchSize);
+            }
+            {
+              ENS_TIMELINE_SCOPE("update");
+              SubtractGradient(iterate, gradient, stepSize, fixedSparsity,
+                  false);
+            }
+            record(t, iterate, gradient);
           }
+        }, parallelUpdates);
+
+        replay(threads, sharedIterate);
+      }
+
+      continue;
+    }
+
+    if (deterministicReduction)
+    {
+      // Process the whole visitation order in rounds of batchesPerThread
+      // batches; the gradients of a round are all computed at the same
+      // iterate.  Unlike the default schedule, the work of an iteration does
+      // not depend on the number of threads (see the class documentation).
+      const size_t roundSize = std::max(batchesPerThread, (size_t) 1);
+      std::vector<BaseGradType> gradients(roundSize);
+      for (size_t r = 0; r < numBatches && !terminate;
+          r += roundSize)
+      {
+        const size_t roundBatches = std::min(roundSize,
+            numBatches - r);
+        ParallelFor(roundBatches, [&](const size_t j)
+        {
+          const size_t begin = batch(r + j) * actualBatchSize;
+          const size_t effectiveBatchSize = std::min(actualBatchSize,
+              numFunctions - begin);
+          function.Gradient(iterate, begin, gradients[j], effectiveBatchSize);
+        });
+
+        // The gradients are all kept, so the callbacks are called in the
+        // order of the batches once they are done.
+        for (size_t j = 0; j < roundBatches; ++j)
+        {
+          terminate |= Callback::Gradient(*this, function, iterate,
+              gradients[j], callbacks...);
         }
+
+        PairwiseReduce(gradients, roundBatches);
+        SubtractGradient(iterate, gradients[0], stepSize, fixedSparsity,
+            false);
+
         terminate |= Callback::StepTaken(*this, function, iterate,
             callbacks...);
       }
+
+      continue;
+    }
+
+    // One task is run per thread; the tasks may run on the executor set with
+    // SetExecutor(), so the task index takes the place of the thread id.
+    // Contiguous groups of tasks share a replica, so that each replica stays
+    // on one socket if the threads are bound to the sockets in order (e.g.
+    // with OMP_PLACES=sockets and OMP_PROC_BIND=close).
+    const size_t numTasks = maxThreads;
+    const size_t groups = std::min(numReplicas, numTasks);
+    activeReplicas = groups;
+    reserveEvents(numTasks);
+
+    // With dynamic scheduling, the next batch of the visitation order that no
+    // task has taken yet.
+    std::atomic<size_t> nextBatch(0);
+    ParallelFor(numTasks, [&](const size_t t)
+    {
+      // Each instance affects only some components of the decision variable.
+      // So the gradient is sparse.  The storage is reused for all the batches
+      // of this task.
+      BaseGradType gradient;
+      BaseMatType& local = (numReplicas > 1) ?
+          replicaIterates[t * groups / numTasks] : iterate;
+
+      // Process the j'th batch of the visitation order.
+      auto processBatch = [&](const size_t j)
+      {
+        const size_t begin = batch(j) * actualBatchSize;
+        const size_t effectiveBatchSize = std::min(actualBatchSize,
+            numFunctions - begin);
+
+        // Evaluate the sparse gradient.
+        {
+          ENS_TIMELINE_SCOPE("gradient");
+          function.Gradient(local, begin, gradient, effectiveBatchSize);
+        }
+
+        // Update the decision variable with non-zero components of the
+        // gradient; the utility functions use atomic updates or a lock.
+        {
+          ENS_TIMELINE_SCOPE("update");
+          SubtractGradient(local, gradient, stepSize, fixedSparsity, true);
+        }
+        record(t, local, gradient);
+      };
+
+      if (dynamicScheduling)
+      {
+        // Every batch is processed once, by whichever task is free next.
+        for (size_t j = nextBatch++; j < numBatches &&
+            !stop.load(std::memory_order_relaxed); j = nextBatch++)
+        {
+          processBatch(j);
+        }
+      }
+      else
+      {
+        // Each task gets a subset of the batches.
+        // Each subset is of size batchesPerThread.
+        for (size_t j = t * batchesPerThread;
+            j < (t + 1) * batchesPerThread && j < numBatches &&
+            !stop.load(std::memory_order_relaxed); ++j)
+        {
+          processBatch(j);
+        }
+      }
+    });
+
+    // Each task's remaining steps are replayed with the replica it updated.
+    replay(numTasks, [&](const size_t t) -> BaseMatType&
+    {
+      return (numReplicas > 1) ? replicaIterates[t * groups / numTasks] :
+          iterate;
+    });
+
+    averaged = (numReplicas == 1);
+    if (!averaged && (i % actualAveragingInterval) == 0)
+    {
+      AverageReplicas(iterate, replicaIterates, activeReplicas);
+      averaged = true;
     }
   }
 
+  if (!averaged)
+    AverageReplicas(iterate, replicaIterates, activeReplicas);
+
+  if (subsampleBatches < numBatches)
+    overallObjective = evaluate(true);
+
   Info << "\nParallel SGD terminated with objective : " << overallObjective
       << "." << std::endl;
 
@@ -0,0 +1,100 @@
+/**
+ * @file perturb_step_size.hpp
+ *
+ * Exploration policy of PopulationBasedTraining that changes the step size of
+ * the optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PBT_PERTURB_STEP_SIZE_HPP
+#define ENSMALLEN_PBT_PERTURB_STEP_SIZE_HPP
+
+#include <random>
+
+namespace ens {
+
+/**
+ * PerturbStepSize explores the step size of the members of
+ * PopulationBasedTraining.  Each member but the first starts with the step
+ * size of the given optimizer times a factor drawn log-uniformly in
+ * [1 / initialRange, initialRange], and each time a member copies another one,
+ * the copied step size is multiplied or divided by `factor`, with equal
+ * probability.  It can be used with any optimizer that has a StepSize()
+ * method, such as SGD and the optimizers based on it.
+ */
+class PerturbStepSize
+{
+ public:
+  /**
+   * Create the policy.
+   *
+   * @param factor Factor by which a copied step size is multiplied or divided.
+   * @param initialRange Range of the factors of the initial step sizes.
+   */
+  PerturbStepSize(const double factor = 1.2,
+                  const double initialRange = 10.0) :
+      factor(factor),
+      initialRange(initialRange)
+  { /* Nothing to do. */ }
+
+  /**
+   * Configure the optimizer of the given member before the training starts.
+   *
+   * @param optimizer Optimizer of the member.
+   * @param member Index of the member.
+   * @param rng Random number generator of the population.
+   */
+  template<typename OptimizerType>
+  void Configure(OptimizerType& optimizer,
+                 const size_t member,
+                 std::mt19937& rng) const
+  {
+    if (member == 0 || initialRange <= 1.0)
+      return;
+
+    std::uniform_real_distribution<double> exponent(-1.0, 1.0);
+    optimizer.StepSize() *= std::pow(initialRange, exponent(rng));
+  }
+
+  /**
+   * Perturb the optimizer of a member that has just copied another member.
+   *
+   * @param optimizer Optimizer of the member.
+   * @param member Index of the member.
+   * @param rng Random number generator of the population.
+   */
+  template<typename OptimizerType>
+  void Perturb(OptimizerType& optimizer,
+               const size_t /* member */,
+               std::mt19937& rng) const
+  {
+    std::bernoulli_distribution increase(0.5);
+    if (increase(rng))
+      optimizer.StepSize() *= factor;
+    else
+      optimizer.StepSize() /= factor;
+  }
+
+  //! Get the perturbation factor.
+  double Factor() const { return factor; }
+  //! Modify the perturbation factor.
+  double& Factor() { return factor; }
+
+  //! Get the range of the initial factors.
+  double InitialRange() const { return initialRange; }
+  //! Modify the range of the initial factors.
+  double& InitialRange() { return initialRange; }
+
+ private:
+  //! The perturbation factor.
+  double factor;
+  //! The range of the initial factors.
+  double initialRange;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,226 @@
+/**
+ * @file population_based_training.hpp
+ *
+ * Meta-optimizer that trains a population of copies of an optimizer, and
+ * replaces the worst members with perturbed copies of the best ones.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PBT_POPULATION_BASED_TRAINING_HPP
+#define ENSMALLEN_PBT_POPULATION_BASED_TRAINING_HPP
+
+#include <ensmallen_bits/callbacks/checkpoint.hpp>
+#include "perturb_step_size.hpp"
+
+namespace ens {
+
+/**
+ * PopulationBasedTraining (PBT) searches the hyperparameters of an optimizer
+ * during a single training, instead of running one full training for each
+ * configuration.  It trains `populationSize` copies ("members") of the given
+ * optimizer, each on its own copy of the coordinates, for `readyEpochs` epochs
+ * at a time.  After each round, the members are ranked by the objective
+ * returned by their Optimize() call, and each member of the worst `truncation`
+ * fraction copies the coordinates, the hyperparameters and the optimizer state
+ * (e.g. the moment estimates of Adam) of a random member of the best
+ * `truncation` fraction (exploit); its hyperparameters are then perturbed by
+ * the PerturbPolicyType (explore).  The total length of the training is the
+ * MaxIterations() of the given optimizer, which must not be 0.  The best
+ * member of the last round is returned.
+ *
+ * The OptimizerType must be an SGD-like optimizer of separable functions with
+ * MaxIterations() and ResetPolicy() methods (e.g. SGD, Adam or any other
+ * optimizer based on SGD); ResetPolicy() is set to false, so that each member
+ * continues its training in the next round.  The state of the optimizer is
+ * copied with SaveState() and LoadState() if the optimizer implements them;
+ * otherwise, only the coordinates and the hyperparameters are copied.
+ *
+ * If `parallel` is true, the members of each round are trained concurrently
+ * on OpenMP threads (or the executor set with SetExecutor()), so the whole
+ * search takes about as long as one training when there are enough cores.  The
+ * function (and any callbacks) must then be safe to use from several threads;
+ * in particular, SGD shuffles the function at every epoch unless Shuffle() is
+ * false.  The member i of round r seeds the random numbers of Armadillo on its
+ * thread with seed + r * populationSize + i, and all the decisions of the
+ * search use a generator seeded with `seed`, so the result only depends on the
+ * seed.
+ *
+ * The PerturbPolicyType has the methods
+ *
+ * @code
+ * template<typename OptimizerType>
+ * void Configure(OptimizerType& optimizer,
+ *                const size_t member,
+ *                std::mt19937& rng) const;
+ *
+ * template<typename OptimizerType>
+ * void Perturb(OptimizerType& optimizer,
+ *              const size_t member,
+ *              std::mt19937& rng) const;
+ * @endcode
+ *
+ * where Configure() sets the initial hyperparameters of each member, and
+ * Perturb() changes the hyperparameters a member has just copied.
+ * PerturbStepSize (the default) explores the step size.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{jaderberg2017population,
+ *   title   = {Population Based Training of Neural Networks},
+ *   author  = {Jaderberg, Max and Dalibard, Valentin and Osindero, Simon and
+ *              Czarnecki, Wojciech M. and Donahue, Jeff and Razavi, Ali and
+ *              Vinyals, Oriol and Green, Tim and Dunning, Iain and
+ *              Simonyan, Karen and Fernando, Chrisantha and
+ *              Kavukcuoglu, Koray},
+ *   journal = {arXiv preprint arXiv:1711.09846},
+ *   year    = {2017}
+ * }
+ * @endcode
+ *
+ * @tparam OptimizerType Type of the optimizer of each member.
+ * @tparam PerturbPolicyType Policy that explores the hyperparameters.
+ */
+template<typename OptimizerType, typename PerturbPolicyType = PerturbStepSize>
+class PopulationBasedTraining
+{
+ public:
+  /**
+   * Construct the PopulationBasedTraining optimizer.
+   *
+   * @param optimizer Optimizer of each member; its MaxIterations() is the
+   *     length of the whole training.
+   * @param populationSize Number of members.
+   * @param readyEpochs Number of epochs between two exploit and explore steps.
+   * @param truncation Fraction of the population that is replaced after each
+   *     round (at most 0.5).
+   * @param seed Seed of the search and of the members.
+   * @param parallel If true, train the members of each round in parallel.
+   * @param perturbPolicy Instantiated perturbation policy.
+   */
+  PopulationBasedTraining(const OptimizerType& optimizer = OptimizerType(),
+                          const size_t populationSize = 8,
+                          const size_t readyEpochs = 1,
+                          const double truncation = 0.25,
+                          const size_t seed = 0,
+                          const bool parallel = false,
+                          const PerturbPolicyType& perturbPolicy =
+                              PerturbPolicyType());
+
+  /**
+   * Train the population on the given function, and store the coordinates of
+   * the best member into `iterate`.
+   *
+   * @tparam SeparableFunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point of every member (will be modified).
+   * @param callbacks Callback functions, passed to every member in every
+   *     round.
+   * @return Objective value of the best member.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks);
+
+  //! Get the optimizer.
+  const OptimizerType& Optimizer() const { return optimizer; }
+  //! Modify the optimizer.
+  OptimizerType& Optimizer() { return optimizer; }
+
+  //! Get the number of members.
+  size_t PopulationSize() const { return populationSize; }
+  //! Modify the number of members.
+  size_t& PopulationSize() { return populationSize; }
+
+  //! Get the number of epochs between two exploit and explore steps.
+  size_t ReadyEpochs() const { return readyEpochs; }
+  //! Modify the number of epochs between two exploit and explore steps.
+  size_t& ReadyEpochs() { return readyEpochs; }
+
+  //! Get the fraction of the population that is replaced after each round.
+  double Truncation() const { return truncation; }
+  //! Modify the fraction of the population that is replaced after each round.
+  double& Truncation() { return truncation; }
+
+  //! Get the seed.
+  size_t Seed() const { return seed; }
+  //! Modify the seed.
+  size_t& Seed() { return seed; }
+
+  //! Get whether the members are trained in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the members are trained in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Get the perturbation policy.
+  const PerturbPolicyType& PerturbPolicy() const { return perturbPolicy; }
+  //! Modify the perturbation policy.
+  PerturbPolicyType& PerturbPolicy() { return perturbPolicy; }
+
+  //! Get the optimizers of the members after the last optimization (with the
+  //! hyperparameters they ended with).
+  const std::vector<OptimizerType>& Members() const { return members; }
+
+  //! Get the final objective of each member of the last optimization.
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the index of the best member of the last optimization.
+  size_t BestMember() const { return bestMember; }
+
+  //! Get the number of times a member copied another one in the last
+  //! optimization.
+  size_t Exploits() const { return exploits; }
+
+ private:
+  //! Copy the state of an optimizer that implements SaveState().
+  template<typename MatType>
+  void CopyState(OptimizerType& from,
+                 OptimizerType& to,
+                 const MatType& iterate,
+                 std::true_type /* hasSaveState */);
+
+  //! Only the hyperparameters are copied for other optimizers.
+  template<typename MatType>
+  void CopyState(OptimizerType& /* from */,
+                 OptimizerType& /* to */,
+                 const MatType& /* iterate */,
+                 std::false_type /* hasSaveState */) { }
+
+  //! The optimizer of each member.
+  OptimizerType optimizer;
+  //! The number of members.
+  size_t populationSize;
+  //! The number of epochs between two exploit and explore steps.
+  size_t readyEpochs;
+  //! The fraction of the population that is replaced after each round.
+  double truncation;
+  //! The seed of the search.
+  size_t seed;
+  //! Whether the members are trained in parallel.
+  bool parallel;
+  //! The perturbation policy.
+  PerturbPolicyType perturbPolicy;
+  //! The optimizers of the members of the last optimization.
+  std::vector<OptimizerType> members;
+  //! The final objective of each member of the last optimization.
+  arma::vec objectives;
+  //! The index of the best member of the last optimization.
+  size_t bestMember;
+  //! The number of exploit steps of the last optimization.
+  size_t exploits;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "population_based_training_impl.hpp"
+
+#endif
@@ -0,0 +1,165 @@
+/**
+ * @file population_based_training_impl.hpp
+ *
+ * Implementation of the PopulationBasedTraining meta-optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PBT_POPULATION_BASED_TRAINING_IMPL_HPP
+#define ENSMALLEN_PBT_POPULATION_BASED_TRAINING_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "population_based_training.hpp"
+
+namespace ens {
+
+template<typename OptimizerType, typename PerturbPolicyType>
+inline PopulationBasedTraining<OptimizerType, PerturbPolicyType>::
+PopulationBasedTraining(const OptimizerType& optimizer,
+                        const size_t populationSize,
+                        const size_t readyEpochs,
+                        const double truncation,
+                        const size_t seed,
+                        const bool parallel,
+                        const PerturbPolicyType& perturbPolicy) :
+    optimizer(optimizer),
+    populationSize(populationSize),
+    readyEpochs(readyEpochs),
+    truncation(truncation),
+    seed(seed),
+    parallel(parallel),
+    perturbPolicy(perturbPolicy),
+    bestMember(0),
+    exploits(0)
+{ /* Nothing to do. */ }
+
+template<typename OptimizerType, typename PerturbPolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename... CallbackTypes>
+typename MatType::elem_type
+PopulationBasedTraining<OptimizerType, PerturbPolicyType>::Optimize(
+    SeparableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+
+  RequireDenseFloatingPointType<BaseMatType>();
+
+  if (populationSize == 0)
+  {
+    throw std::invalid_argument("PopulationBasedTraining::Optimize(): "
+        "populationSize must be positive");
+  }
+  if (readyEpochs == 0)
+  {
+    throw std::invalid_argument("PopulationBasedTraining::Optimize(): "
+        "readyEpochs must be positive");
+  }
+  if (optimizer.MaxIterations() == 0)
+  {
+    throw std::invalid_argument("PopulationBasedTraining::Optimize(): the "
+        "MaxIterations() of the optimizer must be positive");
+  }
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  const size_t totalIterations = optimizer.MaxIterations();
+  const size_t roundIterations = readyEpochs * function.NumFunctions();
+  const size_t rounds = (totalIterations + roundIterations - 1) /
+      roundIterations;
+  const size_t numReplaced = std::min((size_t) (truncation * populationSize),
+      populationSize / 2);
+
+  // All the decisions of the search are drawn serially, so they only depend
+  // on the seed.
+  std::mt19937 rng(seed);
+  std::vector<BaseMatType> iterates(populationSize, iterate);
+  members.assign(populationSize, optimizer);
+  for (size_t i = 0; i < populationSize; ++i)
+  {
+    members[i].ResetPolicy() = false;
+    perturbPolicy.Configure(members[i], i, rng);
+  }
+
+  objectives.set_size(populationSize);
+  exploits = 0;
+  std::vector<size_t> order(populationSize);
+  for (size_t r = 0; r < rounds; ++r)
+  {
+    const size_t iterations = std::min(roundIterations,
+        totalIterations - r * roundIterations);
+
+    // If a member throws, the exception is rethrown once all members are done.
+    ParallelFor(populationSize, [&](const size_t i)
+    {
+      arma::arma_rng::set_seed(seed + r * populationSize + i);
+      members[i].MaxIterations() = iterations;
+      objectives(i) = members[i].Optimize(function, iterates[i],
+          callbacks...);
+    }, parallel);
+
+    // Rank the members; members that diverged are the worst.
+    for (size_t i = 0; i < populationSize; ++i)
+      order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+        [&](const size_t a, const size_t b)
+        {
+          const double oa = std::isnan(objectives(a)) ?
+              std::numeric_limits<double>::infinity() : objectives(a);
+          const double ob = std::isnan(objectives(b)) ?
+              std::numeric_limits<double>::infinity() : objectives(b);
+          return oa < ob;
+        });
+
+    if (r + 1 == rounds || numReplaced == 0)
+      continue;
+
+    // Exploit: each of the worst members copies one of the best members;
+    // explore: its hyperparameters are perturbed.
+    std::uniform_int_distribution<size_t> best(0, numReplaced - 1);
+    for (size_t j = 0; j < numReplaced; ++j)
+    {
+      const size_t from = order[best(rng)];
+      const size_t to = order[populationSize - 1 - j];
+
+      iterates[to] = iterates[from];
+      members[to] = members[from];
+      CopyState(members[from], members[to], iterates[from],
+          std::integral_constant<bool,
+          traits::HasSaveState<OptimizerType, BaseMatType>::value>());
+      objectives(to) = objectives(from);
+      perturbPolicy.Perturb(members[to], to, rng);
+      ++exploits;
+    }
+  }
+
+  bestMember = order[0];
+  iterate = iterates[bestMember];
+  return objectives(bestMember);
+}
+
+template<typename OptimizerType, typename PerturbPolicyType>
+template<typename MatType>
+void PopulationBasedTraining<OptimizerType, PerturbPolicyType>::CopyState(
+    OptimizerType& from,
+    OptimizerType& to,
+    const MatType& iterate,
+    std::true_type /* hasSaveState */)
+{
+  std::stringstream stream;
+  CheckpointWriter writer(stream);
+  from.SaveState(writer, iterate);
+
+  CheckpointReader reader(stream);
+  to.LoadState(reader, iterate);
+}
+
+} // namespace ens
+
+#endif
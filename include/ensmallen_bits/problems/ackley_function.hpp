@@ -111,7 +111,46 @@ class AckleyFunction
    * @param gradient The function gradient.
    */
   template<typename MatType, typename GradType>
-  void Gradient(const MatType& coordinates, GradType& gradient);
+  void Gradient(const MatType& coordinates, GradType& gradient) const;
+
+  /**
+   * Evaluate the objective and the gradient of a function for a particular
+   * batch-size; both share the same exponentials.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of points to process.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize) const;
+
+  /**
+   * Evaluate the objective and the gradient of a function with the given
+   * coordinates.
+   *
+   * @param coordinates The function coordinates.
+   * @param gradient The function gradient.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   GradType& gradient) const;
+
+  /**
+   * Evaluate the objective of each candidate (slice) of the given population,
+   * in parallel, without creating a matrix for each slice (see
+   * EvaluateBatch()).
+   *
+   * @param candidates The candidates to evaluate, one per slice.
+   * @param objectives Vector to store the objectives into.
+   */
+  template<typename ElemType>
+  void EvaluateBatch(const arma::Cube<ElemType>& candidates,
+                     arma::Col<ElemType>& objectives) const;
 
   //! Get the value used for c.
   double MultiplicativeConstant() const { return c; }
@@ -124,6 +163,10 @@ class AckleyFunction
   double& Epsilon() { return epsilon; }
 
  private:
+  //! Return the objective at the point (x1, x2).
+  template<typename ElemType>
+  ElemType Objective(const ElemType x1, const ElemType x2) const;
+
   //! The value of the multiplicative constant.
   double c;
   //! The value used for numerical stability.
@@ -33,15 +33,7 @@ typename MatType::elem_type AckleyFunction::Evaluate(
   // Convenience typedef.
   typedef typename MatType::elem_type ElemType;
 
-  // For convenience; we assume these temporaries will be optimized out.
-  const ElemType x1 = coordinates(0);
-  const ElemType x2 = coordinates(1);
-
-  const ElemType objective = -20 * std::exp(
-      -0.2 * std::sqrt(0.5 * (x1 * x1 + x2 * x2))) -
-      std::exp(0.5 * (std::cos(c * x1) + std::cos(c * x2))) + std::exp(1) + 20;
-
-  return objective;
+  return Objective<ElemType>(coordinates(0), coordinates(1));
 }
 
 template<typename MatType>
@@ -53,9 +45,26 @@ typename MatType::elem_type AckleyFunction::Evaluate(
 
 template<typename MatType, typename GradType>
 inline void AckleyFunction::Gradient(const MatType& coordinates,
-                                     const size_t /* begin */,
+                                     const size_t begin,
                                      GradType& gradient,
-                                     const size_t /* batchSize */) const
+                                     const size_t batchSize) const
+{
+  EvaluateWithGradient(coordinates, begin, gradient, batchSize);
+}
+
+template<typename MatType, typename GradType>
+inline void AckleyFunction::Gradient(const MatType& coordinates,
+                                     GradType& gradient) const
+{
+  Gradient(coordinates, 0, gradient, 1);
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type AckleyFunction::EvaluateWithGradient(
+    const MatType& coordinates,
+    const size_t /* begin */,
+    GradType& gradient,
+    const size_t /* batchSize */) const
 {
   // Convenience typedef.
   typedef typename MatType::elem_type ElemType;
@@ -63,23 +72,53 @@ inline void AckleyFunction::Gradient(const MatType& coordinates,
   // For convenience; we assume these temporaries will be optimized out.
   const ElemType x1 = coordinates(0);
   const ElemType x2 = coordinates(1);
+  const ElemType cx1 = ElemType(c) * x1;
+  const ElemType cx2 = ElemType(c) * x2;
+
+  // Both terms of the objective and of the gradient share these exponentials.
+  const ElemType t0 = std::sqrt(ElemType(0.5) * (x1 * x1 + x2 * x2));
+  const ElemType e0 = std::exp(ElemType(-0.2) * t0);
+  const ElemType e1 = std::exp(ElemType(0.5) * (std::cos(cx1) +
+      std::cos(cx2)));
 
-  // Aliases for different terms in the expression of the gradient.
-  const ElemType t0 = std::sqrt(0.5 * (x1 * x1 + x2 * x2));
-  const ElemType t1 = 2.0 * std::exp(- 0.2 * t0) / (t0 + epsilon);
-  const ElemType t2 = 0.5 * c *
-      std::exp(0.5 * (std::cos(c * x1) + std::cos(c * x2)));
+  const ElemType t1 = 2 * e0 / (t0 + ElemType(epsilon));
+  const ElemType t2 = ElemType(0.5 * c) * e1;
 
   gradient.set_size(2, 1);
-  gradient(0) = (x1 * t1) + (t2 * std::sin(c * x1));
-  gradient(1) = (x2 * t1) + (t2 * std::sin(c * x2));
+  gradient(0) = (x1 * t1) + (t2 * std::sin(cx1));
+  gradient(1) = (x2 * t1) + (t2 * std::sin(cx2));
+
+  return -20 * e0 - e1 + ElemType(std::exp(1.0) + 20);
 }
 
 template<typename MatType, typename GradType>
-inline void AckleyFunction::Gradient(const MatType& coordinates,
-                                     GradType& gradient)
+typename MatType::elem_type AckleyFunction::EvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient) const
 {
-  Gradient(coordinates, 0, gradient, 1);
+  return EvaluateWithGradient(coordinates, 0, gradient, 1);
+}
+
+template<typename ElemType>
+void AckleyFunction::EvaluateBatch(const arma::Cube<ElemType>& candidates,
+                                   arma::Col<ElemType>& objectives) const
+{
+  objectives.set_size(candidates.n_slices);
+  ParallelFor(candidates.n_slices, [&](const size_t i)
+  {
+    const ElemType* x = candidates.slice_memptr(i);
+    objectives[i] = Objective(x[0], x[1]);
+  });
+}
+
+template<typename ElemType>
+inline ElemType AckleyFunction::Objective(const ElemType x1,
+                                          const ElemType x2) const
+{
+  return -20 * std::exp(ElemType(-0.2) *
+      std::sqrt(ElemType(0.5) * (x1 * x1 + x2 * x2))) -
+      std::exp(ElemType(0.5) * (std::cos(ElemType(c) * x1) +
+      std::cos(ElemType(c) * x2))) + ElemType(std::exp(1.0) + 20);
 }
 
 } // namespace test
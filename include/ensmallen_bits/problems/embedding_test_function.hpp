@@ -0,0 +1,109 @@
+/**
+ * @file embedding_test_function.hpp
+ *
+ * Embedding test function, whose gradients are nonzero in a few dense rows.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_EMBEDDING_TEST_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_EMBEDDING_TEST_FUNCTION_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * A simple separable function over an embedding table: function i looks up
+ * one row of the coordinates (the row i % rows), and is the squared distance
+ * of that row to a target row.  The gradient of a batch is therefore nonzero
+ * only in the rows that the batch looks up, and each of these rows is dense;
+ * Gradient() fills either a dense matrix or a RowSparseMat.  The minimum is
+ * at the target rows, with objective 0.
+ */
+class EmbeddingTestFunction
+{
+ public:
+  /**
+   * Create the function with the given size of the table and number of
+   * functions (lookups).
+   *
+   * @param rows Number of rows of the table.
+   * @param cols Number of columns (width) of each row.
+   * @param numFunctions Number of functions.
+   */
+  EmbeddingTestFunction(const size_t rows = 50,
+                        const size_t cols = 8,
+                        const size_t numFunctions = 200);
+
+  //! Return the number of functions.
+  size_t NumFunctions() const { return numFunctions; }
+
+  //! Get the starting point.
+  template<typename MatType = arma::mat>
+  MatType GetInitialPoint() const
+  {
+    return arma::zeros<MatType>(targets.n_rows, targets.n_cols);
+  }
+
+  //! Get the final point.
+  template<typename MatType = arma::mat>
+  MatType GetFinalPoint() const
+  {
+    return arma::conv_to<MatType>::from(targets);
+  }
+
+  //! Get the final objective.
+  double GetFinalObjective() const { return 0.0; }
+
+  //! Evaluate the functions [begin, begin + batchSize).
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize = 1) const;
+
+  //! Evaluate all the functions.
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const;
+
+  //! Evaluate the gradient of the functions [begin, begin + batchSize).
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize = 1) const;
+
+ private:
+  //! Return the given element of a dense gradient.
+  template<typename GradType>
+  static typename GradType::elem_type& Element(GradType& gradient,
+                                               const size_t row,
+                                               const size_t col)
+  {
+    return gradient(row, col);
+  }
+
+  //! Return the given element of a row-sparse gradient.
+  template<typename eT>
+  static eT& Element(RowSparseMat<eT>& gradient,
+                     const size_t row,
+                     const size_t col)
+  {
+    return gradient.Row(row)[col];
+  }
+
+  //! The target rows.
+  arma::mat targets;
+
+  //! The number of functions.
+  size_t numFunctions;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "embedding_test_function_impl.hpp"
+
+#endif // ENSMALLEN_PROBLEMS_EMBEDDING_TEST_FUNCTION_HPP
@@ -0,0 +1,83 @@
+/**
+ * @file embedding_test_function_impl.hpp
+ *
+ * Implementation of the embedding test function.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_EMBEDDING_TEST_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_EMBEDDING_TEST_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "embedding_test_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline EmbeddingTestFunction::EmbeddingTestFunction(const size_t rows,
+                                                    const size_t cols,
+                                                    const size_t numFunctions) :
+    targets(rows, cols),
+    numFunctions(numFunctions)
+{
+  for (size_t c = 0; c < cols; ++c)
+    for (size_t r = 0; r < rows; ++r)
+      targets(r, c) = 0.1 * (r % 7) - 0.2 * (c % 3) + 0.05;
+}
+
+template<typename MatType>
+inline typename MatType::elem_type EmbeddingTestFunction::Evaluate(
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  ElemType objective = 0;
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t row = i % targets.n_rows;
+    for (size_t c = 0; c < targets.n_cols; ++c)
+    {
+      const ElemType d = coordinates(row, c) - ElemType(targets(row, c));
+      objective += d * d;
+    }
+  }
+
+  return objective;
+}
+
+template<typename MatType>
+inline typename MatType::elem_type EmbeddingTestFunction::Evaluate(
+    const MatType& coordinates) const
+{
+  return Evaluate(coordinates, 0, numFunctions);
+}
+
+template<typename MatType, typename GradType>
+inline void EmbeddingTestFunction::Gradient(const MatType& coordinates,
+                                            const size_t begin,
+                                            GradType& gradient,
+                                            const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t row = i % targets.n_rows;
+    for (size_t c = 0; c < targets.n_cols; ++c)
+    {
+      Element(gradient, row, c) += 2 * (coordinates(row, c) -
+          ElemType(targets(row, c)));
+    }
+  }
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
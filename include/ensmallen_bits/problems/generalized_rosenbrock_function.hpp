@@ -121,7 +121,110 @@ class GeneralizedRosenbrockFunction
   template<typename MatType, typename GradType>
   void Gradient(const MatType& coordinates, GradType& gradient) const;
 
+  /**
+   * Evaluate the objective and the gradient of a function for a particular
+   * batch-size, in a single pass over the batch.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of points to process.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize = 1) const;
+
+  /**
+   * Store the elements of the coordinates that the given functions depend on
+   * (see ParallelSGD::ConflictScheduling()); function p depends on the
+   * elements p and p + 1.
+   *
+   * @param begin The first function.
+   * @param batchSize Number of functions.
+   * @param elements The indices of the elements.
+   */
+  void SparsityPattern(const size_t begin,
+                       const size_t batchSize,
+                       arma::uvec& elements) const
+  {
+    elements.set_size(2 * batchSize);
+    for (size_t j = 0; j < batchSize; ++j)
+    {
+      elements[2 * j] = visitationOrder[begin + j];
+      elements[2 * j + 1] = visitationOrder[begin + j] + 1;
+    }
+  }
+
+  /**
+   * Evaluate the objective and the gradient of a function with the given
+   * coordinates, in a single pass over the coordinates.
+   *
+   * @param coordinates The function coordinates.
+   * @param gradient The function gradient.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   GradType& gradient) const;
+
+  /**
+   * Evaluate the objective of each candidate (slice) of the given population,
+   * for the population-based optimizers (see EvaluateBatch()).  The candidates
+   * are evaluated in parallel.
+   *
+   * @param candidates The candidates to evaluate, one per slice.
+   * @param objectives Vector to store the objectives into.
+   */
+  template<typename ElemType>
+  void EvaluateBatch(const arma::Cube<ElemType>& candidates,
+                     arma::Col<ElemType>& objectives) const;
+
  private:
+  //! Evaluate() for dense matrices: one loop over the raw memory.
+  template<typename MatType>
+  typename MatType::elem_type FusedEvaluate(const MatType& coordinates,
+                                            std::true_type /* fused */) const;
+
+  //! Evaluate() for all other matrix types.
+  template<typename MatType>
+  typename MatType::elem_type FusedEvaluate(const MatType& coordinates,
+                                            std::false_type /* fused */) const;
+
+  //! Gradient() for dense matrices: one loop over the raw memory.
+  template<typename MatType, typename GradType>
+  void FusedGradient(const MatType& coordinates,
+                     GradType& gradient,
+                     std::true_type /* fused */) const;
+
+  //! Gradient() for all other matrix types.
+  template<typename MatType, typename GradType>
+  void FusedGradient(const MatType& coordinates,
+                     GradType& gradient,
+                     std::false_type /* fused */) const;
+
+  //! EvaluateWithGradient() for dense matrices: one loop over the raw memory.
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type FusedEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::true_type /* fused */) const;
+
+  //! EvaluateWithGradient() for all other matrix types.
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type FusedEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::false_type /* fused */) const;
+
+  //! Return the sum of the terms [begin, end) of the objective, with the
+  //! coordinates x.
+  template<typename ElemType>
+  static ElemType ObjectiveKernel(const ElemType* x,
+                                  const size_t begin,
+                                  const size_t end);
+
   //! Locally-stored Initial point.
   arma::mat initialPoint;
 
@@ -51,12 +51,17 @@ typename MatType::elem_type GeneralizedRosenbrockFunction::Evaluate(
     const size_t begin,
     const size_t batchSize) const
 {
-  typename MatType::elem_type objective = 0.0;
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  ElemType objective = 0;
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
     const size_t p = visitationOrder[j];
-    objective += 100 * std::pow((std::pow(coordinates[p], 2)
-        - coordinates[p + 1]), 2) + std::pow(1 - coordinates[p], 2);
+    const ElemType x0 = coordinates(p);
+    const ElemType x1 = coordinates(p + 1);
+    const ElemType t = x0 * x0 - x1;
+    objective += 100 * t * t + (1 - x0) * (1 - x0);
   }
 
   return objective;
@@ -66,50 +71,227 @@ template<typename MatType>
 typename MatType::elem_type GeneralizedRosenbrockFunction::Evaluate(
     const MatType& coordinates) const
 {
-  typename MatType::elem_type fval = 0;
-  for (size_t i = 0; i < (n - 1); i++)
+  return FusedEvaluate(coordinates, UseFusedUpdate<MatType, MatType>());
+}
+
+template<typename MatType, typename GradType>
+inline void GeneralizedRosenbrockFunction::Gradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.zeros(n, 1);
+  for (size_t j = begin; j < begin + batchSize; ++j)
   {
-    fval += 100 * std::pow(std::pow(coordinates[i], 2) -
-        coordinates[i + 1], 2) + std::pow(1 - coordinates[i], 2);
+    // Consecutive terms share a coordinate, so their gradients are summed.
+    const size_t p = visitationOrder[j];
+    const ElemType x0 = coordinates(p);
+    const ElemType x1 = coordinates(p + 1);
+    const ElemType t = x0 * x0 - x1;
+    gradient(p) += 400 * x0 * t + 2 * (x0 - 1);
+    gradient(p + 1) += -200 * t;
   }
-
-  return fval;
 }
 
 template<typename MatType, typename GradType>
 inline void GeneralizedRosenbrockFunction::Gradient(
+    const MatType& coordinates,
+    GradType& gradient) const
+{
+  FusedGradient(coordinates, gradient, UseFusedUpdate<MatType, GradType>());
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type
+GeneralizedRosenbrockFunction::EvaluateWithGradient(
     const MatType& coordinates,
     const size_t begin,
     GradType& gradient,
     const size_t batchSize) const
 {
-  gradient.zeros(n);
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.zeros(n, 1);
+
+  ElemType objective = 0;
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
     const size_t p = visitationOrder[j];
-    gradient[p] = 400 * (std::pow(coordinates[p], 3) - coordinates[p] *
-        coordinates[p + 1]) + 2 * (coordinates[p] - 1);
-    gradient[p + 1] = 200 * (coordinates[p + 1] - std::pow(coordinates[p], 2));
+    const ElemType x0 = coordinates(p);
+    const ElemType x1 = coordinates(p + 1);
+    const ElemType t = x0 * x0 - x1;
+    objective += 100 * t * t + (1 - x0) * (1 - x0);
+    gradient(p) += 400 * x0 * t + 2 * (x0 - 1);
+    gradient(p + 1) += -200 * t;
   }
+
+  return objective;
 }
 
 template<typename MatType, typename GradType>
-inline void GeneralizedRosenbrockFunction::Gradient(
+typename MatType::elem_type
+GeneralizedRosenbrockFunction::EvaluateWithGradient(
     const MatType& coordinates,
     GradType& gradient) const
 {
-  gradient.zeros(n);
-  for (size_t i = 0; i < (n - 1); i++)
+  return FusedEvaluateWithGradient(coordinates, gradient,
+      UseFusedUpdate<MatType, GradType>());
+}
+
+template<typename ElemType>
+void GeneralizedRosenbrockFunction::EvaluateBatch(
+    const arma::Cube<ElemType>& candidates,
+    arma::Col<ElemType>& objectives) const
+{
+  objectives.set_size(candidates.n_slices);
+  ParallelFor(candidates.n_slices, [&](const size_t i)
+  {
+    objectives[i] = ObjectiveKernel(candidates.slice_memptr(i), 0,
+        candidates.n_elem_slice - 1);
+  });
+}
+
+template<typename MatType>
+typename MatType::elem_type GeneralizedRosenbrockFunction::FusedEvaluate(
+    const MatType& coordinates,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType* x = coordinates.memptr();
+  return FusedSum<ElemType>(n - 1, [&](const size_t begin, const size_t end)
+  {
+    return ObjectiveKernel(x, begin, end);
+  });
+}
+
+template<typename MatType>
+typename MatType::elem_type GeneralizedRosenbrockFunction::FusedEvaluate(
+    const MatType& coordinates,
+    std::false_type /* fused */) const
+{
+  return Evaluate(coordinates, 0, NumFunctions());
+}
+
+template<typename MatType, typename GradType>
+void GeneralizedRosenbrockFunction::FusedGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.set_size(n, 1);
+  const ElemType* x = coordinates.memptr();
+  ElemType* g = gradient.memptr();
+  FusedForEach(n, [&](const size_t begin, const size_t end)
+  {
+    // The first and the last coordinates only appear in one term.
+    const size_t first = std::max(begin, (size_t) 1);
+    const size_t last = std::max(std::min(end, n - 1), first);
+    if (begin == 0)
+      g[0] = (n > 1) ? 400 * x[0] * (x[0] * x[0] - x[1]) + 2 * (x[0] - 1) : 0;
+
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = first; i < last; ++i)
+    {
+      g[i] = 400 * x[i] * (x[i] * x[i] - x[i + 1]) + 2 * (x[i] - 1) +
+          200 * (x[i] - x[i - 1] * x[i - 1]);
+    }
+
+    if (end == n && n > 1)
+      g[n - 1] = 200 * (x[n - 1] - x[n - 2] * x[n - 2]);
+  });
+}
+
+template<typename MatType, typename GradType>
+void GeneralizedRosenbrockFunction::FusedGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::false_type /* fused */) const
+{
+  Gradient(coordinates, 0, gradient, NumFunctions());
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type
+GeneralizedRosenbrockFunction::FusedEvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.set_size(n, 1);
+  const ElemType* x = coordinates.memptr();
+  ElemType* g = gradient.memptr();
+  return FusedSum<ElemType>(n, [&](const size_t begin, const size_t end)
   {
-    gradient[i] = 400 * (std::pow(coordinates[i], 3) - coordinates[i] *
-        coordinates[i + 1]) + 2 * (coordinates[i] - 1);
+    // The range holds the gradient of coordinates [begin, end), and the terms
+    // [begin, end) of the objective; the last coordinate has no term.
+    const size_t first = std::max(begin, (size_t) 1);
+    const size_t last = std::max(std::min(end, n - 1), first);
+    ElemType objective = 0;
+    if (begin == 0)
+    {
+      g[0] = 0;
+      if (n > 1)
+      {
+        const ElemType t = x[0] * x[0] - x[1];
+        objective = 100 * t * t + (1 - x[0]) * (1 - x[0]);
+        g[0] = 400 * x[0] * t + 2 * (x[0] - 1);
+      }
+    }
+
+    ENS_PRAGMA_OMP_SIMD_SUM(objective)
+    for (size_t i = first; i < last; ++i)
+    {
+      const ElemType t = x[i] * x[i] - x[i + 1];
+      objective += 100 * t * t + (1 - x[i]) * (1 - x[i]);
+      g[i] = 400 * x[i] * t + 2 * (x[i] - 1) +
+          200 * (x[i] - x[i - 1] * x[i - 1]);
+    }
+
+    if (end == n && n > 1)
+      g[n - 1] = 200 * (x[n - 1] - x[n - 2] * x[n - 2]);
+
+    return objective;
+  });
+}
 
-    if (i > 0)
-      gradient[i] += 200 * (coordinates[i] - std::pow(coordinates[i - 1], 2));
+template<typename MatType, typename GradType>
+typename MatType::elem_type
+GeneralizedRosenbrockFunction::FusedEvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::false_type /* fused */) const
+{
+  return EvaluateWithGradient(coordinates, 0, gradient, NumFunctions());
+}
+
+template<typename ElemType>
+inline ElemType GeneralizedRosenbrockFunction::ObjectiveKernel(
+    const ElemType* x,
+    const size_t begin,
+    const size_t end)
+{
+  ElemType objective = 0;
+  ENS_PRAGMA_OMP_SIMD_SUM(objective)
+  for (size_t i = begin; i < end; ++i)
+  {
+    const ElemType t = x[i] * x[i] - x[i + 1];
+    objective += 100 * t * t + (1 - x[i]) * (1 - x[i]);
   }
 
-  gradient[n - 1] = 200 * (coordinates[n - 1] -
-      std::pow(coordinates[n - 2], 2));
+  return objective;
 }
 
 } // namespace test
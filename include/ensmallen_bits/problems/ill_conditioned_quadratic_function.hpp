@@ -0,0 +1,146 @@
+/**
+ * @file ill_conditioned_quadratic_function.hpp
+ *
+ * Definition of a quadratic function of any dimension with a given condition
+ * number.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_ILL_CONDITIONED_QUADRATIC_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_ILL_CONDITIONED_QUADRATIC_FUNCTION_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * A quadratic function in n dimensions with a given condition number, defined
+ * by
+ *
+ *  f(x) = 1 / 2 sum_i^n lambda_i (x_i - 1)^2
+ *  lambda_i = conditionNumber^(i / (n - 1))
+ *  x_0 = [0, 0, 0, ...]
+ *
+ * This should optimize to f(x) = 0, at x = [1, 1, 1, ...].  The eigenvalues
+ * lambda_i of the Hessian are spread logarithmically between 1 and the
+ * condition number, so the convergence of first-order methods slows down as
+ * the condition number grows.
+ *
+ * The function is separable: the coordinates are split into `numFunctions`
+ * contiguous blocks, and each function is the sum over one block.  The gradient
+ * of a function has therefore only the elements of its block, and Gradient()
+ * also accepts an arma::sp_mat.
+ */
+class IllConditionedQuadraticFunction
+{
+ public:
+  /**
+   * Initialize the IllConditionedQuadraticFunction.
+   *
+   * @param n Number of dimensions.
+   * @param conditionNumber The ratio of the largest and smallest eigenvalue of
+   *     the Hessian.
+   * @param numFunctions The number of blocks the coordinates are split into.
+   */
+  IllConditionedQuadraticFunction(const size_t n,
+                                  const double conditionNumber = 1000.0,
+                                  const size_t numFunctions = 1);
+
+  /**
+   * Shuffle the order of function visitation.  This may be called by the
+   * optimizer.
+   */
+  void Shuffle();
+
+  //! Return the number of functions (blocks).
+  size_t NumFunctions() const { return numFunctions; }
+
+  //! Get the starting point.
+  template<typename MatType = arma::mat>
+  MatType GetInitialPoint() const
+  {
+    return arma::zeros<MatType>(eigenvalues.n_elem, 1);
+  }
+
+  //! Get the final point.
+  template<typename MatType = arma::mat>
+  MatType GetFinalPoint() const
+  {
+    return arma::ones<MatType>(eigenvalues.n_elem, 1);
+  }
+
+  //! Get the final objective.
+  double GetFinalObjective() const { return 0.0; }
+
+  /**
+   * Evaluate the function for the given batch of blocks.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param batchSize Number of functions to process.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the function with the given coordinates.
+   *
+   * @param coordinates The function coordinates.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const;
+
+  /**
+   * Evaluate the gradient of the function for the given batch of blocks.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of functions to process.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the function with the given coordinates.
+   *
+   * @param coordinates The function coordinates.
+   * @param gradient The function gradient.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates, GradType& gradient) const;
+
+  //! Get the eigenvalues of the Hessian.
+  const arma::vec& Eigenvalues() const { return eigenvalues; }
+
+ private:
+  //! Return the first coordinate of the given block.
+  size_t BlockBegin(const size_t block) const
+  {
+    return block * eigenvalues.n_elem / numFunctions;
+  }
+
+  //! The eigenvalues of the Hessian.
+  arma::vec eigenvalues;
+
+  //! The number of blocks.
+  size_t numFunctions;
+
+  //! For shuffling.
+  arma::Row<size_t> visitationOrder;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "ill_conditioned_quadratic_function_impl.hpp"
+
+#endif // ENSMALLEN_PROBLEMS_ILL_CONDITIONED_QUADRATIC_FUNCTION_HPP
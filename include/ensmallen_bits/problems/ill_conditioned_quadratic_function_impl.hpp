@@ -0,0 +1,105 @@
+/**
+ * @file ill_conditioned_quadratic_function_impl.hpp
+ *
+ * Implementation of the IllConditionedQuadraticFunction class.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_ILL_CONDITIONED_QUADRATIC_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_ILL_CONDITIONED_QUADRATIC_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "ill_conditioned_quadratic_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline IllConditionedQuadraticFunction::IllConditionedQuadraticFunction(
+    const size_t n,
+    const double conditionNumber,
+    const size_t numFunctions) :
+    numFunctions(numFunctions),
+    visitationOrder(arma::linspace<arma::Row<size_t>>(0, numFunctions - 1,
+        numFunctions))
+{
+  if (n == 0 || numFunctions == 0 || numFunctions > n)
+  {
+    throw std::invalid_argument("IllConditionedQuadraticFunction::"
+        "IllConditionedQuadraticFunction(): the number of functions must be "
+        "between 1 and the number of dimensions!");
+  }
+
+  if (conditionNumber < 1.0)
+  {
+    throw std::invalid_argument("IllConditionedQuadraticFunction::"
+        "IllConditionedQuadraticFunction(): the condition number must be at "
+        "least 1!");
+  }
+
+  eigenvalues = arma::logspace<arma::vec>(0.0, std::log10(conditionNumber), n);
+}
+
+inline void IllConditionedQuadraticFunction::Shuffle()
+{
+  visitationOrder = arma::shuffle(visitationOrder);
+}
+
+template<typename MatType>
+typename MatType::elem_type IllConditionedQuadraticFunction::Evaluate(
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  typename MatType::elem_type objective = 0;
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t block = visitationOrder[i];
+    for (size_t j = BlockBegin(block); j < BlockBegin(block + 1); ++j)
+      objective += 0.5 * eigenvalues[j] * std::pow(coordinates[j] - 1, 2);
+  }
+
+  return objective;
+}
+
+template<typename MatType>
+typename MatType::elem_type IllConditionedQuadraticFunction::Evaluate(
+    const MatType& coordinates) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  return 0.5 * arma::dot(arma::conv_to<arma::Col<ElemType>>::from(
+      eigenvalues), arma::square(coordinates - 1));
+}
+
+template<typename MatType, typename GradType>
+void IllConditionedQuadraticFunction::Gradient(const MatType& coordinates,
+                                 const size_t begin,
+                                 GradType& gradient,
+                                 const size_t batchSize) const
+{
+  gradient.zeros(eigenvalues.n_elem, 1);
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t block = visitationOrder[i];
+    for (size_t j = BlockBegin(block); j < BlockBegin(block + 1); ++j)
+      gradient[j] = eigenvalues[j] * (coordinates[j] - 1);
+  }
+}
+
+template<typename MatType, typename GradType>
+void IllConditionedQuadraticFunction::Gradient(const MatType& coordinates,
+                                 GradType& gradient) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  gradient = arma::conv_to<arma::Col<ElemType>>::from(eigenvalues) %
+      (coordinates - 1);
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -14,6 +14,9 @@
 #ifndef ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
 #define ENSMALLEN_PROBLEMS_LOGISTIC_REGRESSION_FUNCTION_HPP
 
+#include "regression_kernels.hpp"
+#include <ensmallen_bits/utility/evaluate_bounded.hpp>
+
 namespace ens {
 namespace test {
 
@@ -21,24 +24,37 @@ namespace test {
  * The log-likelihood function for the logistic regression objective function.
  * This is used by various ensmallen optimizers to train a logistic regression
  * model.
+ *
+ * The predictors may be dense or sparse (MatType = arma::sp_mat); the
+ * parameters are always a dense row vector.  With sparse predictors, the
+ * gradients can also be computed into a sparse matrix (GradType =
+ * arma::sp_mat), in which case only the intercept, the features that appear in
+ * the batch and, if lambda is nonzero, the regularization are stored.
+ *
+ * @tparam MatType Type of the predictors.
  */
 template<typename MatType = arma::mat>
 class LogisticRegressionFunction
 {
  public:
+  //! The element type of the predictors and the parameters.
+  typedef typename MatType::elem_type ElemType;
+  //! The type of the parameters, which are dense even for sparse predictors.
+  typedef arma::Mat<ElemType> CoordinatesType;
+
   LogisticRegressionFunction(MatType& predictors,
                              arma::Row<size_t>& responses,
                              const double lambda = 0);
 
   LogisticRegressionFunction(MatType& predictors,
                              arma::Row<size_t>& responses,
-                             MatType& initialPoint,
+                             CoordinatesType& initialPoint,
                              const double lambda = 0);
 
   //! Return the initial point for the optimization.
-  const MatType& InitialPoint() const { return initialPoint; }
+  const CoordinatesType& InitialPoint() const { return initialPoint; }
   //! Modify the initial point for the optimization.
-  MatType& InitialPoint() { return initialPoint; }
+  CoordinatesType& InitialPoint() { return initialPoint; }
 
   //! Return the regularization parameter (lambda).
   const double& Lambda() const { return lambda; }
@@ -67,7 +83,8 @@ class LogisticRegressionFunction
    *
    * @param parameters Vector of logistic regression parameters.
    */
-  typename MatType::elem_type Evaluate(const MatType& parameters) const;
+  typename MatType::elem_type Evaluate(
+      const CoordinatesType& parameters) const;
 
   /**
    * Evaluate the logistic regression log-likelihood function with the given
@@ -86,10 +103,24 @@ class LogisticRegressionFunction
    * @param batchSize Number of points to be passed at a time to use for
    *     objective function evaluation.
    */
-  typename MatType::elem_type Evaluate(const MatType& parameters,
+  typename MatType::elem_type Evaluate(const CoordinatesType& parameters,
                                        const size_t begin,
                                        const size_t batchSize = 1) const;
 
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters, but stop as soon as the objective is known to exceed the given
+   * bound; then a partial sum above the bound is returned.  This is used by
+   * optimizers that only compare the objective of a candidate with a bound,
+   * such as DE and CNE.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param bound The largest objective whose exact value is needed.
+   */
+  typename MatType::elem_type EvaluateBounded(
+      const CoordinatesType& parameters,
+      const typename MatType::elem_type bound) const;
+
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
    * with the given parameters.
@@ -98,7 +129,7 @@ class LogisticRegressionFunction
    * @param gradient Vector to output gradient into.
    */
   template<typename GradType>
-  void Gradient(const MatType& parameters, GradType& gradient) const;
+  void Gradient(const CoordinatesType& parameters, GradType& gradient) const;
 
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
@@ -114,7 +145,7 @@ class LogisticRegressionFunction
    *     function gradient evaluation.
    */
   template<typename GradType>
-  void Gradient(const MatType& parameters,
+  void Gradient(const CoordinatesType& parameters,
                 const size_t begin,
                 GradType& gradient,
                 const size_t batchSize = 1) const;
@@ -130,28 +161,121 @@ class LogisticRegressionFunction
    *    be computed.
    * @param gradient Sparse matrix to output gradient into.
    */
-  void PartialGradient(const MatType& parameters,
+  void PartialGradient(const CoordinatesType& parameters,
                        const size_t j,
                        arma::sp_mat& gradient) const;
 
+  /**
+   * Evaluate only the (single) element of the partial gradient with respect to
+   * feature j, and store it in `column`.  Unlike PartialGradient(), no matrix
+   * of the size of the parameters is built.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param j Index of the feature with respect to which the gradient is to
+   *    be computed.
+   * @param column Vector to store the gradient into.
+   */
+  void PartialGradientColumn(
+      const CoordinatesType& parameters,
+      const size_t j,
+      arma::Col<typename MatType::elem_type>& column) const;
+
   /**
    * Evaluate the objective function and gradient of the logistic regression
    * log-likelihood function simultaneously with the given parameters.
    */
   template<typename GradType>
   typename MatType::elem_type EvaluateWithGradient(
-      const MatType& parameters,
+      const CoordinatesType& parameters,
       GradType& gradient) const;
 
   template<typename GradType>
   typename MatType::elem_type EvaluateWithGradient(
-      const MatType& parameters,
+      const CoordinatesType& parameters,
       const size_t begin,
       GradType& gradient,
       const size_t batchSize = 1) const;
 
+  /**
+   * Evaluate the objective of the given batch, and store the derivative of the
+   * loss of each point with respect to its linear prediction (the logit) in
+   * `derivatives`.  The gradient of the loss of point i is then
+   * derivatives(i) * [1, x_i^T]; see AddFeatureGradient().  This is used by
+   * SAGA to store a single number per point instead of a full gradient.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param derivatives Vector to store the derivatives into.
+   * @param batchSize Number of points in the batch.
+   */
+  typename MatType::elem_type EvaluateWithPredictionGradient(
+      const CoordinatesType& parameters,
+      const size_t begin,
+      arma::Row<typename MatType::elem_type>& derivatives,
+      const size_t batchSize = 1) const;
+
+  /**
+   * Add the loss gradients of the given batch, described by the derivatives
+   * with respect to the linear predictions, to `gradient`.  The regularization
+   * is not included.
+   *
+   * @param begin Index of the first point of the batch.
+   * @param derivatives Derivative of the loss of each point of the batch.
+   * @param gradient Vector to add the gradient to.
+   * @param batchSize Number of points in the batch.
+   */
+  template<typename GradType>
+  void AddFeatureGradient(
+      const size_t begin,
+      const arma::Row<typename MatType::elem_type>& derivatives,
+      GradType& gradient,
+      const size_t batchSize = 1) const;
+
+  /**
+   * Store the gradient of the L2-regularization term of the whole objective in
+   * `gradient`.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Vector to output the gradient into.
+   */
+  template<typename GradType>
+  void RegularizationGradient(const CoordinatesType& parameters,
+                              GradType& gradient) const;
+
+  /**
+   * Store the product of the Hessian of the whole objective at the given
+   * parameters with the given direction in `product`.  The Hessian is
+   * [1, X]^T D [1, X] plus the regularization, where D holds the second
+   * derivatives of the losses of the points, so the product takes two passes
+   * over the predictors and the Hessian is never formed.  This is used by
+   * NewtonCG.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param direction Vector to multiply the Hessian with.
+   * @param product Vector to store the product into.
+   */
+  void HessianVectorProduct(const CoordinatesType& parameters,
+                            const CoordinatesType& direction,
+                            CoordinatesType& product) const;
+
+  /**
+   * Store the product of the Hessian of the objective of the given batch (see
+   * Evaluate()) with the given direction in `product`.  This is used by SQN.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param direction Vector to multiply the Hessian with.
+   * @param product Vector to store the product into.
+   * @param batchSize Number of points in the batch.
+   */
+  void HessianVectorProduct(const CoordinatesType& parameters,
+                            const size_t begin,
+                            const CoordinatesType& direction,
+                            CoordinatesType& product,
+                            const size_t batchSize = 1) const;
+
   //! Return the initial point for the optimization.
-  const MatType& GetInitialPoint() const { return initialPoint; }
+  const CoordinatesType& GetInitialPoint() const { return initialPoint; }
 
   //! Return the number of separable functions (the number of predictor points).
   size_t NumFunctions() const { return predictors.n_cols; }
@@ -176,7 +300,7 @@ class LogisticRegressionFunction
    */
   double ComputeAccuracy(const MatType& predictors,
                          const arma::Row<size_t>& responses,
-                         const MatType& parameters,
+                         const CoordinatesType& parameters,
                          const double decisionBoundary = 0.5) const;
 
   /**
@@ -193,20 +317,66 @@ class LogisticRegressionFunction
    */
   void Classify(const MatType& dataset,
                 arma::Row<size_t>& labels,
-                const MatType& parameters,
+                const CoordinatesType& parameters,
                 const double decisionBoundary = 0.5) const;
 
  private:
+  //! Get the predictors of the given batch.  Until Shuffle() is called these
+  //! are the contiguous columns (an alias for dense predictors); afterwards the
+  //! columns are gathered in the visitation order.
+  MatType BatchPredictors(const size_t begin, const size_t batchSize) const;
+
+  //! Get the responses of the given batch, in the visitation order.
+  arma::Row<size_t> BatchResponses(const size_t begin,
+                                   const size_t batchSize) const;
+
+  //! Compute the linear predictions (including the intercept) of the given
+  //! points.
+  arma::Row<ElemType> Margins(const CoordinatesType& parameters,
+                              const MatType& points) const;
+
+  /**
+   * Store the gradient given the errors (sigmoid minus response) of the given
+   * points.  The regularization term is multiplied by the given scale.
+   */
+  template<typename GradType>
+  void AssembleGradient(const CoordinatesType& parameters,
+                        const MatType& points,
+                        const arma::Row<ElemType>& errors,
+                        const double regularizationScale,
+                        GradType& gradient) const;
+
+  //! Store the product of the Hessian of the loss of the given points with
+  //! the direction, plus the regularization multiplied by the given scale.
+  void HessianProduct(const CoordinatesType& parameters,
+                      const MatType& points,
+                      const CoordinatesType& direction,
+                      const double regularizationScale,
+                      CoordinatesType& product) const;
+
+  //! Store a sparse gradient; only the features present in the given points
+  //! (and the regularization, if lambda is nonzero) are stored.
+  void AssembleGradient(const CoordinatesType& parameters,
+                        const MatType& points,
+                        const arma::Row<ElemType>& errors,
+                        const double regularizationScale,
+                        arma::SpMat<ElemType>& gradient) const;
+
   //! The initial point, from which to start the optimization.
-  MatType initialPoint;
-  //! The matrix of data points (predictors).  This is an alias until shuffling
-  //! is done.
+  CoordinatesType initialPoint;
+  //! The matrix of data points (predictors).  This is an alias of the given
+  //! data, which is never modified; shuffling only changes the visitation
+  //! order.
   MatType& predictors;
-  //! The vector of responses to the input data points.  This is an alias until
-  //! shuffling is done.
+  //! The vector of responses to the input data points.  This is an alias of the
+  //! given responses.
   arma::Row<size_t>& responses;
   //! The regularization parameter for L2-regularization.
   double lambda;
+  //! The order in which the points are visited by the separable functions.
+  arma::uvec visitationOrder;
+  //! Whether or not Shuffle() was called.
+  bool shuffled;
 };
 
 // Convenience typedefs.
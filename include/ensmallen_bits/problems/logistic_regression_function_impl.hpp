@@ -26,7 +26,8 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
     // We promise to be well-behaved... the elements won't be modified.
     predictors(predictors),
     responses(responses),
-    lambda(lambda)
+    lambda(lambda),
+    shuffled(false)
 {
   initialPoint = arma::Row<typename MatType::elem_type>(predictors.n_rows + 1,
       arma::fill::zeros);
@@ -47,12 +48,13 @@ template<typename MatType>
 LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
     MatType& predictors,
     arma::Row<size_t>& responses,
-    MatType& initialPoint,
+    CoordinatesType& initialPoint,
     const double lambda) :
     initialPoint(initialPoint),
     predictors(predictors),
     responses(responses),
-    lambda(lambda)
+    lambda(lambda),
+    shuffled(false)
 {
   // To check if initialPoint is compatible with predictors.
   if (initialPoint.n_rows != (predictors.n_rows + 1) ||
@@ -62,25 +64,52 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
 }
 
 /**
- * Shuffle the datapoints.
+ * Shuffle the datapoints.  Only the visitation order is shuffled; the data
+ * stays in place.
  */
 template<typename MatType>
 void LogisticRegressionFunction<MatType>::Shuffle()
 {
-  MatType newPredictors;
-  arma::Row<size_t> newResponses;
-
-  arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
+  visitationOrder = arma::shuffle(arma::linspace<arma::uvec>(0,
       predictors.n_cols - 1, predictors.n_cols));
+  shuffled = true;
+}
+
+template<typename MatType>
+MatType LogisticRegressionFunction<MatType>::BatchPredictors(
+    const size_t begin,
+    const size_t batchSize) const
+{
+  // The columns are contiguous until the data is shuffled, so no copy is
+  // needed for dense predictors.
+  if (!shuffled)
+    return ColumnRange(predictors, begin, batchSize);
+
+  return GatherColumns(predictors,
+      visitationOrder.subvec(begin, begin + batchSize - 1));
+}
+
+template<typename MatType>
+arma::Row<size_t> LogisticRegressionFunction<MatType>::BatchResponses(
+    const size_t begin,
+    const size_t batchSize) const
+{
+  if (!shuffled)
+    return responses.subvec(begin, begin + batchSize - 1);
 
-  newPredictors.set_size(predictors.n_rows, predictors.n_cols);
-  for (size_t i = 0; i < predictors.n_cols; ++i)
-    newPredictors.col(i) = predictors.col(ordering[i]);
-  newResponses = responses.cols(ordering);
+  return responses.cols(visitationOrder.subvec(begin, begin + batchSize - 1));
+}
 
-  // Take ownership of the new data.
-  predictors = std::move(newPredictors);
-  responses = std::move(newResponses);
+template<typename MatType>
+arma::Row<typename MatType::elem_type>
+LogisticRegressionFunction<MatType>::Margins(
+    const CoordinatesType& parameters,
+    const MatType& points) const
+{
+  // The intercept term is parameters(0, 0) and does not need to be multiplied
+  // by any of the predictors.
+  return parameters(0, 0) + parameters.tail_cols(parameters.n_elem - 1) *
+      points;
 }
 
 /**
@@ -89,14 +118,14 @@ void LogisticRegressionFunction<MatType>::Shuffle()
  */
 template<typename MatType>
 typename MatType::elem_type LogisticRegressionFunction<MatType>::Evaluate(
-    const MatType& parameters) const
+    const CoordinatesType& parameters) const
 {
-  // The objective function is the log-likelihood function (w is the parameters
-  // vector for the model; y is the responses; x is the predictors; sig() is the
-  // sigmoid function):
-  //   f(w) = sum(y log(sig(w'x)) + (1 - y) log(sig(1 - w'x))).
-  // We want to minimize this function.  L2-regularization is just lambda
-  // multiplied by the squared l2-norm of the parameters then divided by two.
+  // The objective function is the negative log-likelihood function (w is the
+  // parameters vector for the model; y is the responses; x is the predictors;
+  // sig() is the sigmoid function):
+  //   f(w) = -sum(y log(sig(w'x)) + (1 - y) log(sig(-w'x))).
+  // L2-regularization is just lambda multiplied by the squared l2-norm of the
+  // parameters then divided by two.
   typedef typename MatType::elem_type ElemType;
 
   // For the regularization, we ignore the first term, which is the intercept
@@ -105,24 +134,12 @@ typename MatType::elem_type LogisticRegressionFunction<MatType>::Evaluate(
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
       parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate vectors of sigmoids.  The intercept term is parameters(0, 0) and
-  // does not need to be multiplied by any of the predictors.
-  const arma::Row<ElemType> sigmoid = 1.0 / (1.0 +
-      arma::exp(-(parameters(0, 0) +
-                parameters.tail_cols(parameters.n_elem - 1) * predictors)));
-
-  // Assemble full objective function.  Often the objective function and the
-  // regularization as given are divided by the number of features, but this
-  // doesn't actually affect the optimization result, so we'll just ignore those
-  // terms for computational efficiency.  Note that the conversion causes some
-  // copy and slowdown, but this is so negligible compared to the rest of the
-  // calculation it is not worth optimizing for.
-  const ElemType result = arma::accu(arma::log(1.0 -
-      arma::conv_to<arma::Row<ElemType>>::from(responses) + sigmoid %
-      (2 * arma::conv_to<arma::Row<ElemType>>::from(responses) - 1.0)));
-
-  // Invert the result, because it's a minimization.
-  return regularization - result;
+  // Often the objective function and the regularization as given are divided
+  // by the number of features, but this doesn't actually affect the
+  // optimization result, so we'll just ignore those terms for computational
+  // efficiency.
+  return regularization + LogisticLoss(Margins(parameters, predictors),
+      responses);
 }
 
 /**
@@ -131,7 +148,7 @@ typename MatType::elem_type LogisticRegressionFunction<MatType>::Evaluate(
  */
 template<typename MatType>
 typename MatType::elem_type LogisticRegressionFunction<MatType>::Evaluate(
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     const size_t begin,
     const size_t batchSize) const
 {
@@ -143,41 +160,32 @@ typename MatType::elem_type LogisticRegressionFunction<MatType>::Evaluate(
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
                 parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate the sigmoid function values.
-  const arma::Row<ElemType> sigmoid = 1.0 / (1.0 +
-      arma::exp(-(parameters(0, 0) +
-                  parameters.tail_cols(parameters.n_elem - 1) *
-                      predictors.cols(begin, begin + batchSize - 1))));
-
-  // Compute the objective for the given batch size from a given point.
-  arma::Row<ElemType> respD = arma::conv_to<arma::Row<ElemType>>::from(
-      responses.subvec(begin, begin + batchSize - 1));
-  const ElemType result = arma::accu(arma::log(1.0 - respD + sigmoid %
-      (2 * respD - 1.0)));
+  return regularization + LogisticLoss(Margins(parameters,
+      BatchPredictors(begin, batchSize)), BatchResponses(begin, batchSize));
+}
 
-  // Invert the result, because it's a minimization.
-  return regularization - result;
+//! Evaluate the logistic regression objective function up to a bound.
+template<typename MatType>
+typename MatType::elem_type
+LogisticRegressionFunction<MatType>::EvaluateBounded(
+    const CoordinatesType& parameters,
+    const typename MatType::elem_type bound) const
+{
+  // Each batch contributes a nonnegative loss and a share of the
+  // regularization, so the partial sums never decrease.
+  return EvaluateSeparableBounded(*this, parameters, bound, 256);
 }
 
 //! Evaluate the gradient of the logistic regression objective function.
 template<typename MatType>
 template<typename GradType>
 void LogisticRegressionFunction<MatType>::Gradient(
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     GradType& gradient) const
 {
-  typedef typename MatType::elem_type ElemType;
-  // Regularization term.
-  MatType regularization;
-  regularization = lambda * parameters.tail_cols(parameters.n_elem - 1);
-
-  const arma::Row<ElemType> sigmoids = (1 / (1 + arma::exp(-parameters(0, 0)
-      - parameters.tail_cols(parameters.n_elem - 1) * predictors)));
-
-  gradient.set_size(arma::size(parameters));
-  gradient[0] = -arma::accu(responses - sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids - responses) *
-      predictors.t() + regularization;
+  arma::Row<ElemType> errors;
+  LogisticLossAndErrors(Margins(parameters, predictors), responses, errors);
+  AssembleGradient(parameters, predictors, errors, 1.0, gradient);
 }
 
 //! Evaluate the gradient of the logistic regression objective function for a
@@ -185,30 +193,75 @@ void LogisticRegressionFunction<MatType>::Gradient(
 template<typename MatType>
 template<typename GradType>
 void LogisticRegressionFunction<MatType>::Gradient(
-                const MatType& parameters,
+                const CoordinatesType& parameters,
                 const size_t begin,
                 GradType& gradient,
                 const size_t batchSize) const
 {
-  typedef typename MatType::elem_type ElemType;
-
-  // Regularization term.
-  MatType regularization;
-  regularization = lambda * parameters.tail_cols(parameters.n_elem - 1)
-      / predictors.n_cols * batchSize;
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
 
-  const arma::Row<ElemType> exponents = parameters(0, 0) +
-      parameters.tail_cols(parameters.n_elem - 1) *
-      predictors.cols(begin, begin + batchSize - 1);
-  // Calculating the sigmoid function values.
-  const arma::Row<ElemType> sigmoids = 1.0 / (1.0 + arma::exp(-exponents));
+  arma::Row<ElemType> errors;
+  LogisticLossAndErrors(Margins(parameters, batchPredictors),
+      BatchResponses(begin, batchSize), errors);
+  AssembleGradient(parameters, batchPredictors, errors,
+      (double) batchSize / predictors.n_cols, gradient);
+}
 
+template<typename MatType>
+template<typename GradType>
+void LogisticRegressionFunction<MatType>::AssembleGradient(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const arma::Row<ElemType>& errors,
+    const double regularizationScale,
+    GradType& gradient) const
+{
   gradient.set_size(parameters.n_rows, parameters.n_cols);
-  gradient[0] = -arma::accu(responses.subvec(begin, begin + batchSize - 1) -
-      sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids -
-      responses.subvec(begin, begin + batchSize - 1)) *
-      predictors.cols(begin, begin + batchSize - 1).t() + regularization;
+  gradient[0] = arma::accu(errors);
+  gradient.tail_cols(parameters.n_elem - 1) = errors * points.t() +
+      (regularizationScale * lambda) *
+      parameters.tail_cols(parameters.n_elem - 1);
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::AssembleGradient(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const arma::Row<ElemType>& errors,
+    const double regularizationScale,
+    arma::SpMat<ElemType>& gradient) const
+{
+  // For sparse points this is a sparse-sparse product, whose nonzero elements
+  // are the features present in the points.
+  const arma::SpMat<ElemType> featureGradient(
+      arma::SpMat<ElemType>(errors) * points.t());
+
+  std::vector<arma::uword> cols;
+  std::vector<ElemType> values;
+  cols.push_back(0);
+  values.push_back(arma::accu(errors));
+  typename arma::SpMat<ElemType>::const_iterator it = featureGradient.begin();
+  for (; it != featureGradient.end(); ++it)
+  {
+    cols.push_back(it.col() + 1);
+    values.push_back(*it);
+  }
+
+  // The regularization makes the gradient dense.
+  if (lambda != 0.0)
+  {
+    for (size_t k = 1; k < parameters.n_elem; ++k)
+    {
+      cols.push_back(k);
+      values.push_back(regularizationScale * lambda * parameters[k]);
+    }
+  }
+
+  // The constructor sums duplicate locations.
+  arma::umat locations(2, cols.size(), arma::fill::zeros);
+  locations.row(1) = arma::urowvec(cols);
+  gradient = arma::SpMat<ElemType>(true, locations, arma::Col<ElemType>(values),
+      parameters.n_rows, parameters.n_cols);
 }
 
 /**
@@ -217,24 +270,43 @@ void LogisticRegressionFunction<MatType>::Gradient(
  */
 template <typename MatType>
 void LogisticRegressionFunction<MatType>::PartialGradient(
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     const size_t j,
     arma::sp_mat& gradient) const
 {
-  const arma::Row<typename MatType::elem_type> diffs = responses -
-      (1 / (1 + arma::exp(-parameters(0, 0) -
-                          parameters.tail_cols(parameters.n_elem - 1) *
-                              predictors)));
+  arma::Row<ElemType> errors;
+  LogisticLossAndErrors(Margins(parameters, predictors), responses, errors);
 
   gradient.set_size(arma::size(parameters));
 
   if (j == 0)
   {
-    gradient[j] = -arma::accu(diffs);
+    gradient[j] = arma::accu(errors);
   }
   else
   {
-    gradient[j] = arma::dot(-predictors.row(j - 1), diffs) + lambda *
+    gradient[j] = arma::dot(predictors.row(j - 1), errors) + lambda *
+      parameters(0, j);
+  }
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::PartialGradientColumn(
+    const CoordinatesType& parameters,
+    const size_t j,
+    arma::Col<typename MatType::elem_type>& column) const
+{
+  arma::Row<ElemType> errors;
+  LogisticLossAndErrors(Margins(parameters, predictors), responses, errors);
+
+  column.set_size(1);
+  if (j == 0)
+  {
+    column[0] = arma::accu(errors);
+  }
+  else
+  {
+    column[0] = arma::dot(predictors.row(j - 1), errors) + lambda *
       parameters(0, j);
   }
 }
@@ -243,87 +315,144 @@ template<typename MatType>
 template<typename GradType>
 typename MatType::elem_type
 LogisticRegressionFunction<MatType>::EvaluateWithGradient(
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     GradType& gradient) const
 {
   typedef typename MatType::elem_type ElemType;
 
-  // Regularization term.
-  MatType regularization = lambda *
-      parameters.tail_cols(parameters.n_elem - 1);
-
   const ElemType objectiveRegularization = lambda / 2.0 *
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
                 parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate the sigmoid function values.
-  const arma::Row<ElemType> sigmoids = 1.0 / (1.0 +
-      arma::exp(-(parameters(0, 0) +
-                  parameters.tail_cols(parameters.n_elem - 1) * predictors)));
-
-  gradient.set_size(arma::size(parameters));
-  gradient[0] = -arma::accu(responses - sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids - responses) *
-      predictors.t() + regularization;
-
-  // Now compute the objective function using the sigmoids.
-  ElemType result = arma::accu(arma::log(1.0 -
-      arma::conv_to<arma::Row<ElemType>>::from(responses) + sigmoids %
-      (2 * arma::conv_to<arma::Row<ElemType>>::from(responses) - 1.0)));
+  // The loss and the errors for the gradient are computed in the same pass.
+  arma::Row<ElemType> errors;
+  const ElemType loss = LogisticLossAndErrors(Margins(parameters, predictors),
+      responses, errors);
+  AssembleGradient(parameters, predictors, errors, 1.0, gradient);
 
-  // Invert the result, because it's a minimization.
-  return objectiveRegularization - result;
+  return objectiveRegularization + loss;
 }
 
 template<typename MatType>
 template<typename GradType>
 typename MatType::elem_type
 LogisticRegressionFunction<MatType>::EvaluateWithGradient(
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     const size_t begin,
     GradType& gradient,
     const size_t batchSize) const
 {
   typedef typename MatType::elem_type ElemType;
 
-  // Regularization term.
-  MatType regularization =
-      lambda * parameters.tail_cols(parameters.n_elem - 1) / predictors.n_cols *
-      batchSize;
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
 
   const ElemType objectiveRegularization = lambda *
       (batchSize / (2.0 * predictors.n_cols)) *
       arma::dot(parameters.tail_cols(parameters.n_elem - 1),
                 parameters.tail_cols(parameters.n_elem - 1));
 
-  // Calculate the sigmoid function values.
-  const arma::Row<ElemType> sigmoids = 1.0 / (1.0 +
-      arma::exp(-(parameters(0, 0) +
-                  parameters.tail_cols(parameters.n_elem - 1) *
-                      predictors.cols(begin, begin + batchSize - 1))));
+  // The loss and the errors for the gradient are computed in the same pass.
+  arma::Row<ElemType> errors;
+  const ElemType loss = LogisticLossAndErrors(Margins(parameters,
+      batchPredictors), BatchResponses(begin, batchSize), errors);
+  AssembleGradient(parameters, batchPredictors, errors,
+      (double) batchSize / predictors.n_cols, gradient);
 
-  gradient.set_size(parameters.n_rows, parameters.n_cols);
-  gradient[0] = -arma::accu(responses.subvec(begin, begin + batchSize - 1) -
-      sigmoids);
-  gradient.tail_cols(parameters.n_elem - 1) = (sigmoids -
-      responses.subvec(begin, begin + batchSize - 1)) *
-      predictors.cols(begin, begin + batchSize - 1).t() + regularization;
-
-  // Now compute the objective function using the sigmoids.
-  arma::Row<ElemType> respD = arma::conv_to<arma::Row<ElemType>>::from(
-      responses.subvec(begin, begin + batchSize - 1));
-  const ElemType result = arma::accu(arma::log(1.0 - respD + sigmoids %
-      (2 * respD - 1.0)));
-
-  // Invert the result, because it's a minimization.
-  return objectiveRegularization - result;
+  return objectiveRegularization + loss;
+}
+
+template<typename MatType>
+typename MatType::elem_type
+LogisticRegressionFunction<MatType>::EvaluateWithPredictionGradient(
+    const CoordinatesType& parameters,
+    const size_t begin,
+    arma::Row<typename MatType::elem_type>& derivatives,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType objectiveRegularization = lambda *
+      (batchSize / (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.tail_cols(parameters.n_elem - 1),
+                parameters.tail_cols(parameters.n_elem - 1));
+
+  return objectiveRegularization + LogisticLossAndErrors(Margins(parameters,
+      BatchPredictors(begin, batchSize)), BatchResponses(begin, batchSize),
+      derivatives);
+}
+
+template<typename MatType>
+template<typename GradType>
+void LogisticRegressionFunction<MatType>::AddFeatureGradient(
+    const size_t begin,
+    const arma::Row<typename MatType::elem_type>& derivatives,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  const MatType batchPredictors = BatchPredictors(begin, batchSize);
+
+  gradient[0] += arma::accu(derivatives);
+  gradient.tail_cols(gradient.n_elem - 1) += derivatives * batchPredictors.t();
+}
+
+template<typename MatType>
+template<typename GradType>
+void LogisticRegressionFunction<MatType>::RegularizationGradient(
+    const CoordinatesType& parameters,
+    GradType& gradient) const
+{
+  gradient.zeros(parameters.n_rows, parameters.n_cols);
+  gradient.tail_cols(parameters.n_elem - 1) = lambda *
+      parameters.tail_cols(parameters.n_elem - 1);
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::HessianVectorProduct(
+    const CoordinatesType& parameters,
+    const CoordinatesType& direction,
+    CoordinatesType& product) const
+{
+  HessianProduct(parameters, predictors, direction, 1.0, product);
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::HessianVectorProduct(
+    const CoordinatesType& parameters,
+    const size_t begin,
+    const CoordinatesType& direction,
+    CoordinatesType& product,
+    const size_t batchSize) const
+{
+  HessianProduct(parameters, BatchPredictors(begin, batchSize), direction,
+      (double) batchSize / predictors.n_cols, product);
+}
+
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::HessianProduct(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const CoordinatesType& direction,
+    const double regularizationScale,
+    CoordinatesType& product) const
+{
+  arma::Row<ElemType> curvatures;
+  LogisticCurvatures(Margins(parameters, points), curvatures);
+
+  // The directional derivatives of the margins, scaled by the curvatures.
+  const arma::Row<ElemType> scaled = curvatures % Margins(direction, points);
+
+  product.set_size(parameters.n_rows, parameters.n_cols);
+  product[0] = arma::accu(scaled);
+  product.tail_cols(parameters.n_elem - 1) = scaled * points.t() +
+      (regularizationScale * lambda) *
+      direction.tail_cols(parameters.n_elem - 1);
 }
 
 template<typename MatType>
 void LogisticRegressionFunction<MatType>::Classify(
     const MatType& dataset,
     arma::Row<size_t>& labels,
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     const double decisionBoundary) const
 {
   // Calculate sigmoid function for each point.  The (1.0 - decisionBoundary)
@@ -338,7 +467,7 @@ template<typename MatType>
 double LogisticRegressionFunction<MatType>::ComputeAccuracy(
     const MatType& predictors,
     const arma::Row<size_t>& responses,
-    const MatType& parameters,
+    const CoordinatesType& parameters,
     const double decisionBoundary) const
 {
   // Predict responses using the current model.
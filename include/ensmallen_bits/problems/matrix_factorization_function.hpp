@@ -0,0 +1,212 @@
+/**
+ * @file matrix_factorization_function.hpp
+ *
+ * Definition of a low-rank matrix factorization (matrix completion) function,
+ * with a generator of synthetic problems of any size.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * The regularized squared error of a low-rank factorization W H^T of a
+ * partially observed m x n matrix R, defined by
+ *
+ *  f(W, H) = sum_{(i, j) observed} (R_ij - w_i^T h_j)^2 +
+ *            lambda (||w_i||^2 + ||h_j||^2)
+ *
+ * where w_i and h_j are the rows of the m x rank matrix W and the n x rank
+ * matrix H.  The coordinates are a rank x (m + n) matrix whose first m columns
+ * are the w_i and whose last n columns are the h_j.
+ *
+ * The function is separable over the observed elements, and the gradient of
+ * a function has only the columns w_i and h_j of its element; Gradient() also
+ * accepts an arma::sp_mat, so the function can be used with ParallelSGD.
+ * Stratify() orders the observed elements by the blocks of a grid of row and
+ * column strata, for the stratified scheduling of ParallelSGD (see
+ * StratifiedScheduling()).
+ *
+ * Problems of any size can be generated with the second constructor: a random
+ * matrix of the given rank is observed at uniformly random positions, with
+ * some noise.
+ */
+class MatrixFactorizationFunction
+{
+ public:
+  /**
+   * Create the function for the given observed matrix.
+   *
+   * @param ratings The observed matrix; the non-zero elements are the observed
+   *     ones.
+   * @param rank The rank of the factorization.
+   * @param lambda The L2-regularization parameter.
+   */
+  MatrixFactorizationFunction(const arma::sp_mat& ratings,
+                              const size_t rank,
+                              const double lambda = 0.01);
+
+  /**
+   * Generate a random problem.  The generated data depends on the seed of the
+   * Armadillo random number generator.
+   *
+   * @param m The number of rows of the matrix.
+   * @param n The number of columns of the matrix.
+   * @param rank The rank of the generated matrix and of the factorization.
+   * @param density The fraction of observed elements.
+   * @param lambda The L2-regularization parameter.
+   * @param noise The standard deviation of the noise of the observed elements.
+   */
+  MatrixFactorizationFunction(const size_t m,
+                              const size_t n,
+                              const size_t rank,
+                              const double density,
+                              const double lambda = 0.01,
+                              const double noise = 0.01);
+
+  /**
+   * Shuffle the order of function visitation.  This may be called by the
+   * optimizer.
+   */
+  void Shuffle();
+
+  /**
+   * Order the functions by the blocks of a grid of numStrata x numStrata
+   * blocks of the matrix: row i is in row stratum i * numStrata / m, and
+   * column j in column stratum j * numStrata / n.  The functions of block
+   * (a, b) are then offsets[a * numStrata + b], ...,
+   * offsets[a * numStrata + b + 1] - 1; they only depend on the columns of the
+   * coordinates of the rows and columns of the matrix in these strata.  The
+   * order of the functions within a block is kept.  This is undone by
+   * Shuffle().
+   *
+   * @param numStrata The number of row strata and column strata.
+   * @param offsets Vector to store the numStrata * numStrata + 1 offsets of
+   *     the blocks into.
+   */
+  void Stratify(const size_t numStrata, arma::uvec& offsets);
+
+  //! Return the number of functions (observed elements).
+  size_t NumFunctions() const { return values.n_elem; }
+
+  //! Get the starting point.
+  template<typename MatType = arma::mat>
+  MatType GetInitialPoint() const
+  {
+    return arma::conv_to<MatType>::from(initialPoint);
+  }
+
+  /**
+   * Evaluate the function for the given batch of observed elements.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param batchSize Number of functions to process.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the function with the given coordinates.
+   *
+   * @param coordinates The function coordinates.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const;
+
+  /**
+   * Evaluate the gradient of the function for the given batch of observed
+   * elements.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of functions to process.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the sparse gradient of the function for the given batch of
+   * observed elements.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of functions to process.
+   */
+  template<typename MatType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                arma::SpMat<typename MatType::elem_type>& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the function with the given coordinates.
+   *
+   * @param coordinates The function coordinates.
+   * @param gradient The function gradient.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates, GradType& gradient) const;
+
+  //! Get the number of rows of the matrix.
+  size_t Rows() const { return m; }
+  //! Get the number of columns of the matrix.
+  size_t Cols() const { return n; }
+  //! Get the rank of the factorization.
+  size_t Rank() const { return initialPoint.n_rows; }
+
+  //! Get the L2-regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the L2-regularization parameter.
+  double& Lambda() { return lambda; }
+
+ private:
+  //! Store the observed elements of the given matrix, and set the initial
+  //! point.
+  void Initialize(const arma::sp_mat& ratings, const size_t rank);
+
+  //! The number of rows of the matrix.
+  size_t m;
+
+  //! The number of columns of the matrix.
+  size_t n;
+
+  //! The row of each observed element.
+  arma::Row<size_t> rowIndices;
+
+  //! The column of each observed element.
+  arma::Row<size_t> colIndices;
+
+  //! The value of each observed element.
+  arma::rowvec values;
+
+  //! The L2-regularization parameter.
+  double lambda;
+
+  //! The starting point.
+  arma::mat initialPoint;
+
+  //! For shuffling.
+  arma::Row<size_t> visitationOrder;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "matrix_factorization_function_impl.hpp"
+
+#endif // ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_HPP
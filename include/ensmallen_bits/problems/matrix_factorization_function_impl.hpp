@@ -0,0 +1,222 @@
+/**
+ * @file matrix_factorization_function_impl.hpp
+ *
+ * Implementation of the MatrixFactorizationFunction class.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_MATRIX_FACTORIZATION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "matrix_factorization_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline MatrixFactorizationFunction::MatrixFactorizationFunction(
+    const arma::sp_mat& ratings,
+    const size_t rank,
+    const double lambda) :
+    m(ratings.n_rows),
+    n(ratings.n_cols),
+    lambda(lambda)
+{
+  Initialize(ratings, rank);
+}
+
+inline MatrixFactorizationFunction::MatrixFactorizationFunction(
+    const size_t m,
+    const size_t n,
+    const size_t rank,
+    const double density,
+    const double lambda,
+    const double noise) :
+    m(m),
+    n(n),
+    lambda(lambda)
+{
+  // The observed elements of W H^T, with scaled factors so that the elements
+  // have unit variance.
+  const arma::mat w = arma::randn<arma::mat>(rank, m) / std::sqrt(rank);
+  const arma::mat h = arma::randn<arma::mat>(rank, n);
+  const arma::sp_mat pattern = arma::sprandu<arma::sp_mat>(m, n, density);
+  arma::umat locations(2, pattern.n_nonzero);
+  arma::vec ratingValues(pattern.n_nonzero);
+  size_t k = 0;
+  for (arma::sp_mat::const_iterator it = pattern.begin(); it != pattern.end();
+      ++it, ++k)
+  {
+    locations(0, k) = it.row();
+    locations(1, k) = it.col();
+    ratingValues[k] = arma::dot(w.col(it.row()), h.col(it.col())) +
+        noise * arma::randn();
+  }
+
+  Initialize(arma::sp_mat(locations, ratingValues, m, n), rank);
+}
+
+inline void MatrixFactorizationFunction::Initialize(
+    const arma::sp_mat& ratings,
+    const size_t rank)
+{
+  if (rank == 0)
+  {
+    throw std::invalid_argument("MatrixFactorizationFunction::"
+        "MatrixFactorizationFunction(): the rank must be positive!");
+  }
+
+  rowIndices.set_size(ratings.n_nonzero);
+  colIndices.set_size(ratings.n_nonzero);
+  values.set_size(ratings.n_nonzero);
+  size_t k = 0;
+  for (arma::sp_mat::const_iterator it = ratings.begin(); it != ratings.end();
+      ++it, ++k)
+  {
+    rowIndices[k] = it.row();
+    colIndices[k] = it.col();
+    values[k] = (*it);
+  }
+
+  visitationOrder = arma::linspace<arma::Row<size_t>>(0, values.n_elem - 1,
+      values.n_elem);
+  initialPoint = 0.1 * arma::randn<arma::mat>(rank, m + n);
+}
+
+inline void MatrixFactorizationFunction::Shuffle()
+{
+  visitationOrder = arma::shuffle(visitationOrder);
+}
+
+inline void MatrixFactorizationFunction::Stratify(const size_t numStrata,
+                                                  arma::uvec& offsets)
+{
+  if (numStrata == 0)
+  {
+    throw std::invalid_argument("MatrixFactorizationFunction::Stratify(): "
+        "the number of strata must be positive!");
+  }
+
+  // A counting sort of the functions by block, which keeps the order within
+  // each block.
+  arma::uvec blocks(values.n_elem);
+  offsets.zeros(numStrata * numStrata + 1);
+  for (size_t b = 0; b < values.n_elem; ++b)
+  {
+    const size_t k = visitationOrder[b];
+    blocks[b] = (rowIndices[k] * numStrata / m) * numStrata +
+        colIndices[k] * numStrata / n;
+    ++offsets[blocks[b] + 1];
+  }
+  offsets = arma::cumsum(offsets);
+
+  arma::uvec next(offsets);
+  arma::Row<size_t> order(values.n_elem);
+  for (size_t b = 0; b < values.n_elem; ++b)
+    order[next[blocks[b]]++] = visitationOrder[b];
+  visitationOrder = order;
+}
+
+template<typename MatType>
+typename MatType::elem_type MatrixFactorizationFunction::Evaluate(
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  typename MatType::elem_type objective = 0;
+  for (size_t b = begin; b < begin + batchSize; ++b)
+  {
+    const size_t k = visitationOrder[b];
+    const size_t i = rowIndices[k];
+    const size_t j = m + colIndices[k];
+    const typename MatType::elem_type error = values[k] -
+        arma::dot(coordinates.col(i), coordinates.col(j));
+    objective += error * error + lambda * (arma::dot(coordinates.col(i),
+        coordinates.col(i)) + arma::dot(coordinates.col(j),
+        coordinates.col(j)));
+  }
+
+  return objective;
+}
+
+template<typename MatType>
+typename MatType::elem_type MatrixFactorizationFunction::Evaluate(
+    const MatType& coordinates) const
+{
+  return Evaluate(coordinates, 0, NumFunctions());
+}
+
+template<typename MatType, typename GradType>
+void MatrixFactorizationFunction::Gradient(const MatType& coordinates,
+                                           const size_t begin,
+                                           GradType& gradient,
+                                           const size_t batchSize) const
+{
+  gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+  for (size_t b = begin; b < begin + batchSize; ++b)
+  {
+    const size_t k = visitationOrder[b];
+    const size_t i = rowIndices[k];
+    const size_t j = m + colIndices[k];
+    const typename MatType::elem_type error = arma::dot(coordinates.col(i),
+        coordinates.col(j)) - values[k];
+    gradient.col(i) += 2 * (error * coordinates.col(j) +
+        lambda * coordinates.col(i));
+    gradient.col(j) += 2 * (error * coordinates.col(i) +
+        lambda * coordinates.col(j));
+  }
+}
+
+template<typename MatType>
+void MatrixFactorizationFunction::Gradient(
+    const MatType& coordinates,
+    const size_t begin,
+    arma::SpMat<typename MatType::elem_type>& gradient,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Two columns per element; the constructor of the sparse matrix sums
+  // duplicate locations.
+  const size_t rank = coordinates.n_rows;
+  arma::umat locations(2, 2 * rank * batchSize);
+  arma::Col<ElemType> gradientValues(2 * rank * batchSize);
+  size_t p = 0;
+  for (size_t b = begin; b < begin + batchSize; ++b)
+  {
+    const size_t k = visitationOrder[b];
+    const size_t i = rowIndices[k];
+    const size_t j = m + colIndices[k];
+    const ElemType error = arma::dot(coordinates.col(i), coordinates.col(j)) -
+        values[k];
+    for (size_t r = 0; r < rank; ++r, p += 2)
+    {
+      locations(0, p) = r;
+      locations(1, p) = i;
+      gradientValues[p] = 2 * (error * coordinates(r, j) +
+          lambda * coordinates(r, i));
+      locations(0, p + 1) = r;
+      locations(1, p + 1) = j;
+      gradientValues[p + 1] = 2 * (error * coordinates(r, i) +
+          lambda * coordinates(r, j));
+    }
+  }
+
+  gradient = arma::SpMat<ElemType>(true, locations, gradientValues,
+      coordinates.n_rows, coordinates.n_cols);
+}
+
+template<typename MatType, typename GradType>
+void MatrixFactorizationFunction::Gradient(const MatType& coordinates,
+                                           GradType& gradient) const
+{
+  Gradient(coordinates, 0, gradient, NumFunctions());
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
@@ -16,6 +16,7 @@
 #include "cross_in_tray_function.hpp"
 #include "drop_wave_function.hpp"
 #include "easom_function.hpp"
+#include "embedding_test_function.hpp"
 #include "eggholder_function.hpp"
 #include "fonseca_fleming_function.hpp"
 #include "fw_test_function.hpp"
@@ -24,8 +25,10 @@
 #include "gradient_descent_test_function.hpp"
 #include "himmelblau_function.hpp"
 #include "holder_table_function.hpp"
+#include "ill_conditioned_quadratic_function.hpp"
 #include "levy_function_n13.hpp"
 #include "logistic_regression_function.hpp"
+#include "matrix_factorization_function.hpp"
 #include "matyas_function.hpp"
 #include "mc_cormick_function.hpp"
 #include "rastrigin_function.hpp"
@@ -37,6 +40,7 @@
 #include "schwefel_function.hpp"
 #include "sgd_test_function.hpp"
 #include "softmax_regression_function.hpp"
+#include "sparse_logistic_regression_function.hpp"
 #include "sparse_test_function.hpp"
 #include "sphere_function.hpp"
 #include "styblinski_tang_function.hpp"
@@ -42,14 +42,14 @@ typename MatType::elem_type RastriginFunction::Evaluate(
   // Convenience typedef.
   typedef typename MatType::elem_type ElemType;
 
-  ElemType objective = 0.0;
+  const ElemType twoPi = ElemType(2 * arma::datum::pi);
+
+  ElemType objective = 0;
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
-    const size_t p = visitationOrder[j];
-    objective += std::pow(coordinates(p), 2) - 10.0 *
-        std::cos(2.0 * arma::datum::pi * coordinates(p));
+    const ElemType x = coordinates(visitationOrder[j]);
+    objective += x * x - 10 * std::cos(twoPi * x) + 10;
   }
-  objective += 10.0 * n;
 
   return objective;
 }
@@ -58,32 +58,188 @@ template<typename MatType>
 typename MatType::elem_type RastriginFunction::Evaluate(
     const MatType& coordinates) const
 {
-  return Evaluate(coordinates, 0, NumFunctions());
+  return FusedEvaluate(coordinates, UseFusedUpdate<MatType, MatType>());
 }
 
 template<typename MatType, typename GradType>
-inline void RastriginFunction::Gradient(const MatType& coordinates,
-                                        const size_t begin,
-                                        GradType& gradient,
-                                        const size_t batchSize) const
+void RastriginFunction::Gradient(const MatType& coordinates,
+                                 const size_t begin,
+                                 GradType& gradient,
+                                 const size_t batchSize) const
 {
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType twoPi = ElemType(2 * arma::datum::pi);
+
   gradient.zeros(n, 1);
 
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
     const size_t p = visitationOrder[j];
-    gradient(p) += (10.0 * n) * (2 * (coordinates(p) + 10.0 * arma::datum::pi *
-        std::sin(2.0 * arma::datum::pi * coordinates(p))));
+    const ElemType x = coordinates(p);
+    gradient(p) += 2 * x + 10 * twoPi * std::sin(twoPi * x);
   }
 }
 
 template<typename MatType, typename GradType>
-inline void RastriginFunction::Gradient(const MatType& coordinates,
-                                        GradType& gradient)
+void RastriginFunction::Gradient(const MatType& coordinates,
+                                 GradType& gradient) const
+{
+  FusedGradient(coordinates, gradient, UseFusedUpdate<MatType, GradType>());
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type RastriginFunction::EvaluateWithGradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType twoPi = ElemType(2 * arma::datum::pi);
+
+  gradient.zeros(n, 1);
+
+  ElemType objective = 0;
+  for (size_t j = begin; j < begin + batchSize; ++j)
+  {
+    const size_t p = visitationOrder[j];
+    const ElemType x = coordinates(p);
+    objective += x * x - 10 * std::cos(twoPi * x) + 10;
+    gradient(p) += 2 * x + 10 * twoPi * std::sin(twoPi * x);
+  }
+
+  return objective;
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type RastriginFunction::EvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient) const
+{
+  return FusedEvaluateWithGradient(coordinates, gradient,
+      UseFusedUpdate<MatType, GradType>());
+}
+
+template<typename ElemType>
+void RastriginFunction::EvaluateBatch(const arma::Cube<ElemType>& candidates,
+                                      arma::Col<ElemType>& objectives) const
+{
+  objectives.set_size(candidates.n_slices);
+  ParallelFor(candidates.n_slices, [&](const size_t i)
+  {
+    objectives[i] = ObjectiveKernel(candidates.slice_memptr(i), 0,
+        candidates.n_elem_slice);
+  });
+}
+
+template<typename MatType>
+typename MatType::elem_type RastriginFunction::FusedEvaluate(
+    const MatType& coordinates,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType* x = coordinates.memptr();
+  return FusedSum<ElemType>(n, [&](const size_t begin, const size_t end)
+  {
+    return ObjectiveKernel(x, begin, end);
+  });
+}
+
+template<typename MatType>
+typename MatType::elem_type RastriginFunction::FusedEvaluate(
+    const MatType& coordinates,
+    std::false_type /* fused */) const
+{
+  return Evaluate(coordinates, 0, NumFunctions());
+}
+
+template<typename MatType, typename GradType>
+void RastriginFunction::FusedGradient(const MatType& coordinates,
+                                      GradType& gradient,
+                                      std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType twoPi = ElemType(2 * arma::datum::pi);
+
+  gradient.set_size(n, 1);
+  const ElemType* x = coordinates.memptr();
+  ElemType* g = gradient.memptr();
+  FusedForEach(n, [&](const size_t begin, const size_t end)
+  {
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = begin; i < end; ++i)
+      g[i] = 2 * x[i] + 10 * twoPi * std::sin(twoPi * x[i]);
+  });
+}
+
+template<typename MatType, typename GradType>
+void RastriginFunction::FusedGradient(const MatType& coordinates,
+                                      GradType& gradient,
+                                      std::false_type /* fused */) const
 {
   Gradient(coordinates, 0, gradient, NumFunctions());
 }
 
+template<typename MatType, typename GradType>
+typename MatType::elem_type RastriginFunction::FusedEvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType twoPi = ElemType(2 * arma::datum::pi);
+
+  gradient.set_size(n, 1);
+  const ElemType* x = coordinates.memptr();
+  ElemType* g = gradient.memptr();
+  return FusedSum<ElemType>(n, [&](const size_t begin, const size_t end)
+  {
+    ElemType objective = 0;
+    ENS_PRAGMA_OMP_SIMD_SUM(objective)
+    for (size_t i = begin; i < end; ++i)
+    {
+      objective += x[i] * x[i] - 10 * std::cos(twoPi * x[i]) + 10;
+      g[i] = 2 * x[i] + 10 * twoPi * std::sin(twoPi * x[i]);
+    }
+
+    return objective;
+  });
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type RastriginFunction::FusedEvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::false_type /* fused */) const
+{
+  return EvaluateWithGradient(coordinates, 0, gradient, NumFunctions());
+}
+
+template<typename ElemType>
+inline ElemType RastriginFunction::ObjectiveKernel(const ElemType* x,
+                                                   const size_t begin,
+                                                   const size_t end)
+{
+  const ElemType twoPi = ElemType(2 * arma::datum::pi);
+
+  ElemType objective = 0;
+  ENS_PRAGMA_OMP_SIMD_SUM(objective)
+  for (size_t i = begin; i < end; ++i)
+    objective += x[i] * x[i] - 10 * std::cos(twoPi * x[i]) + 10;
+
+  return objective;
+}
+
 } // namespace test
 } // namespace ens
 
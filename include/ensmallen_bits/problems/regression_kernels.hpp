@@ -0,0 +1,161 @@
+/**
+ * @file regression_kernels.hpp
+ *
+ * Fused, numerically stable kernels for the losses of the logistic and softmax
+ * regression problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_REGRESSION_KERNELS_HPP
+#define ENSMALLEN_PROBLEMS_REGRESSION_KERNELS_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * Compute the sum of the logistic losses log(1 + exp(-t_i)) of the given
+ * margins z_i, where t_i = z_i if the response is 1 and t_i = -z_i otherwise.
+ * The loss is computed as max(-t, 0) + log1p(exp(-|t|)), so no intermediate
+ * value can overflow and no logarithm of zero is taken.  All values are
+ * computed in a single loop over the margins that the compiler can vectorize.
+ *
+ * @param margins The linear predictions of the points.
+ * @param responses The responses (0 or 1) of the points.
+ * @return The sum of the losses.
+ */
+template<typename eT>
+inline eT LogisticLoss(const arma::Row<eT>& margins,
+                       const arma::Row<size_t>& responses)
+{
+  const eT* z = margins.memptr();
+  const size_t* y = responses.memptr();
+  const size_t n = margins.n_elem;
+
+  eT loss = 0;
+  ENS_PRAGMA_OMP_SIMD_SUM(loss)
+  for (size_t i = 0; i < n; ++i)
+  {
+    const eT t = (y[i] == 1) ? z[i] : -z[i];
+    loss += std::max(-t, eT(0)) + std::log1p(std::exp(-std::abs(t)));
+  }
+
+  return loss;
+}
+
+/**
+ * Compute the sum of the logistic losses (see LogisticLoss()), and store the
+ * derivative of each loss with respect to its margin, sigmoid(z_i) - y_i, in
+ * `errors`.  Both are computed from the same exp(-|t|) in a single loop.
+ *
+ * @param margins The linear predictions of the points.
+ * @param responses The responses (0 or 1) of the points.
+ * @param errors Vector to store the derivatives into.
+ * @return The sum of the losses.
+ */
+template<typename eT>
+inline eT LogisticLossAndErrors(const arma::Row<eT>& margins,
+                                const arma::Row<size_t>& responses,
+                                arma::Row<eT>& errors)
+{
+  errors.set_size(margins.n_elem);
+  const eT* z = margins.memptr();
+  const size_t* y = responses.memptr();
+  eT* e = errors.memptr();
+  const size_t n = margins.n_elem;
+
+  eT loss = 0;
+  ENS_PRAGMA_OMP_SIMD_SUM(loss)
+  for (size_t i = 0; i < n; ++i)
+  {
+    const eT t = (y[i] == 1) ? z[i] : -z[i];
+    const eT a = std::exp(-std::abs(t));
+    loss += std::max(-t, eT(0)) + std::log1p(a);
+
+    // sigmoid(-t), computed from a = exp(-|t|) without overflow.
+    const eT q = (t >= 0) ? a / (1 + a) : 1 / (1 + a);
+    e[i] = (y[i] == 1) ? -q : q;
+  }
+
+  return loss;
+}
+
+/**
+ * Store the second derivative of the logistic loss of each margin,
+ * sigmoid(z_i) * (1 - sigmoid(z_i)), in `curvatures`.  It doesn't depend on the
+ * response, and is computed as a / (1 + a)^2 with a = exp(-|z_i|), which can't
+ * overflow.
+ *
+ * @param margins The linear predictions of the points.
+ * @param curvatures Vector to store the second derivatives into.
+ */
+template<typename eT>
+inline void LogisticCurvatures(const arma::Row<eT>& margins,
+                               arma::Row<eT>& curvatures)
+{
+  curvatures.set_size(margins.n_elem);
+  const eT* z = margins.memptr();
+  eT* d = curvatures.memptr();
+  const size_t n = margins.n_elem;
+
+  ENS_PRAGMA_OMP_SIMD
+  for (size_t i = 0; i < n; ++i)
+  {
+    const eT a = std::exp(-std::abs(z[i]));
+    d[i] = a / ((1 + a) * (1 + a));
+  }
+}
+
+/**
+ * Turn each column of the given matrix of scores into the softmax
+ * probabilities of the classes, in place.  The largest score of each column is
+ * subtracted before exponentiating, so exp() can't overflow.  If labels are
+ * given, the sum of the negative log-probabilities of the labels is returned;
+ * it is computed from the scores as max + log(sum) - score, so it stays finite
+ * even when the probability underflows.  Each column is visited once.
+ *
+ * @param scores The scores (one column per point), replaced by the
+ *     probabilities.
+ * @param labels The labels of the points, or NULL.
+ * @return The sum of the negative log-probabilities of the labels (0 if no
+ *     labels are given).
+ */
+template<typename eT>
+inline eT SoftmaxInPlace(arma::Mat<eT>& scores, const arma::uword* labels)
+{
+  const size_t k = scores.n_rows;
+  eT loss = 0;
+  for (size_t j = 0; j < scores.n_cols; ++j)
+  {
+    eT* z = scores.colptr(j);
+    eT maxScore = z[0];
+    for (size_t c = 1; c < k; ++c)
+      maxScore = std::max(maxScore, z[c]);
+
+    const eT labelScore = (labels != NULL) ? z[labels[j]] : eT(0);
+    eT sum = 0;
+    ENS_PRAGMA_OMP_SIMD_SUM(sum)
+    for (size_t c = 0; c < k; ++c)
+    {
+      z[c] = std::exp(z[c] - maxScore);
+      sum += z[c];
+    }
+
+    const eT scale = 1 / sum;
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t c = 0; c < k; ++c)
+      z[c] *= scale;
+
+    if (labels != NULL)
+      loss += maxScore + std::log(sum) - labelScore;
+  }
+
+  return loss;
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
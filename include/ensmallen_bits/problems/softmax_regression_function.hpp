@@ -13,12 +13,46 @@
 #ifndef ENSMALLEN_PROBLEMS_SOFTMAX_REGRESSION_FUNCTION_HPP
 #define ENSMALLEN_PROBLEMS_SOFTMAX_REGRESSION_FUNCTION_HPP
 
+#include "regression_kernels.hpp"
+
 namespace ens {
 namespace test {
 
-class SoftmaxRegressionFunction
+/**
+ * The softmax regression objective function.  The data may be dense or sparse
+ * (MatType = arma::sp_mat); the parameters are always a dense matrix.  With
+ * sparse data, the gradients can also be computed into a sparse matrix, in
+ * which case only the columns of the features that appear in the batch and, if
+ * lambda is nonzero, the regularization are stored.
+ *
+ * With many classes, the gradients of a batch can instead be computed with a
+ * sampled softmax: if numSampled is nonzero, the separable Gradient() and
+ * EvaluateWithGradient() overloads draw numSampled classes (with replacement)
+ * from a proposal Q, shared by all the points of the batch, and each point is
+ * only scored against its label and the sampled classes.  The score of each
+ * sampled class c is corrected by -log(numSampled * Q(c)), the log of its
+ * expected number of draws, and a sampled class that is the label of a point
+ * is removed for that point; so the sum of the exponentiated scores of the
+ * draws estimates the normalizer of the other classes, and the sampled loss
+ * tends to the full softmax loss as numSampled grows.  Q is the frequency of
+ * the labels, smoothed by one.  The gradient is then nonzero only in the rows
+ * of the labels of the batch and of the sampled classes, and the
+ * regularization is restricted to these rows too, so a RowSparseMat gradient
+ * costs time proportional to the number of these classes instead of
+ * numClasses.  Evaluate() and the non-separable overloads always use the full
+ * softmax.
+ *
+ * @tparam MatType Type of the data.
+ */
+template<typename MatType = arma::mat>
+class SoftmaxRegressionFunctionType
 {
  public:
+  //! The element type of the data and the parameters.
+  typedef typename MatType::elem_type ElemType;
+  //! The type of the parameters, which are dense even for sparse data.
+  typedef arma::Mat<ElemType> CoordinatesType;
+
   /**
    * Construct the Softmax Regression objective function with the given
    * parameters.
@@ -29,18 +63,23 @@ class SoftmaxRegressionFunction
    * @param numClasses Number of classes for classification.
    * @param lambda L2-regularization constant.
    * @param fitIntercept Intercept term flag.
+   * @param numSampled Number of classes to sample for the gradients of a
+   *     batch, or 0 to use the full softmax.
    */
-  SoftmaxRegressionFunction(const arma::mat& data,
-                            const arma::Row<size_t>& labels,
-                            const size_t numClasses,
-                            const double lambda = 0.0001,
-                            const bool fitIntercept = false);
+  SoftmaxRegressionFunctionType(const MatType& data,
+                                const arma::Row<size_t>& labels,
+                                const size_t numClasses,
+                                const double lambda = 0.0001,
+                                const bool fitIntercept = false,
+                                const size_t numSampled = 0);
 
   //! Initializes the parameters of the model to suitable values.
-  const arma::mat InitializeWeights();
+  const CoordinatesType InitializeWeights();
 
   /**
-   * Shuffle the dataset.
+   * Shuffle the dataset.  Only the order in which the points are visited by the
+   * separable Evaluate() and Gradient() overloads is permuted; the data itself
+   * is not modified.
    */
   void Shuffle();
 
@@ -53,9 +92,9 @@ class SoftmaxRegressionFunction
    * @param fitIntercept If true, an intercept is fitted.
    * @return Initialized model weights.
    */
-  const arma::mat InitializeWeights(const size_t featureSize,
-                                    const size_t numClasses,
-                                    const bool fitIntercept = false);
+  const CoordinatesType InitializeWeights(const size_t featureSize,
+                                          const size_t numClasses,
+                                          const bool fitIntercept = false);
 
   /**
    * Initialize Softmax Regression weights (trainable parameters) with the given
@@ -66,7 +105,7 @@ class SoftmaxRegressionFunction
    * @param numClasses Number of classes for classification.
    * @param fitIntercept Intercept term flag.
    */
-  void InitializeWeights(arma::mat &weights,
+  void InitializeWeights(CoordinatesType& weights,
                          const size_t featureSize,
                          const size_t numClasses,
                          const bool fitIntercept = false);
@@ -78,7 +117,7 @@ class SoftmaxRegressionFunction
    * @param groundTruth Pointer to arma::mat which stores the computed matrix.
    */
   void GetGroundTruthMatrix(const arma::Row<size_t>& labels,
-                            arma::sp_mat& groundTruth);
+                            arma::SpMat<ElemType>& groundTruth);
 
   /**
    * Evaluate the probabilities matrix with the passed parameters.
@@ -91,8 +130,8 @@ class SoftmaxRegressionFunction
    * @param start Index of point to start at.
    * @param batchSize Number of points to calculate probabilities for.
    */
-  void GetProbabilitiesMatrix(const arma::mat& parameters,
-                              arma::mat& probabilities,
+  void GetProbabilitiesMatrix(const CoordinatesType& parameters,
+                              CoordinatesType& probabilities,
                               const size_t start,
                               const size_t batchSize) const;
 
@@ -105,7 +144,7 @@ class SoftmaxRegressionFunction
    *
    * @param parameters Current values of the model parameters.
    */
-  double Evaluate(const arma::mat& parameters) const;
+  double Evaluate(const CoordinatesType& parameters) const;
 
   /**
    * Evaluate the objective function of the softmax regression model for a
@@ -118,7 +157,7 @@ class SoftmaxRegressionFunction
    * @param start First index of the data points to use.
    * @param batchSize Number of data points to evaluate objective for.
    */
-  double Evaluate(const arma::mat& parameters,
+  double Evaluate(const CoordinatesType& parameters,
                   const size_t start,
                   const size_t batchSize = 1) const;
 
@@ -131,7 +170,19 @@ class SoftmaxRegressionFunction
    * @param parameters Current values of the model parameters.
    * @param gradient Matrix where gradient values will be stored.
    */
-  void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
+  void Gradient(const CoordinatesType& parameters,
+                CoordinatesType& gradient) const;
+
+  /**
+   * Evaluate the gradient into a sparse matrix.  Only the columns of the
+   * features with a nonzero entry in the data (and the intercept) are stored,
+   * unless lambda is nonzero.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Sparse matrix where gradient values will be stored.
+   */
+  void Gradient(const CoordinatesType& parameters,
+                arma::SpMat<ElemType>& gradient) const;
 
   /**
    * Evaluate the gradient of the objective function given the current set of
@@ -144,11 +195,71 @@ class SoftmaxRegressionFunction
    * @param gradient Matrix to store gradient into.
    * @param batchSize Number of data points to evaluate gradient for.
    */
-  void Gradient(const arma::mat& parameters,
+  void Gradient(const CoordinatesType& parameters,
                 const size_t start,
-                arma::mat& gradient,
+                CoordinatesType& gradient,
                 const size_t batchSize = 1) const;
 
+  /**
+   * Evaluate the gradient on a subset of the data into a sparse matrix.  Only
+   * the columns of the features with a nonzero entry in the batch (and the
+   * intercept) are stored, unless lambda is nonzero.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param start First index of the data points to use.
+   * @param gradient Sparse matrix to store gradient into.
+   * @param batchSize Number of data points to evaluate gradient for.
+   */
+  void Gradient(const CoordinatesType& parameters,
+                const size_t start,
+                arma::SpMat<ElemType>& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient on a subset of the data into a row-sparse matrix.
+   * With the sampled softmax, only the rows of the labels of the batch and of
+   * the sampled classes are touched; otherwise, all rows are.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param start First index of the data points to use.
+   * @param gradient Row-sparse matrix to store gradient into.
+   * @param batchSize Number of data points to evaluate gradient for.
+   */
+  void Gradient(const CoordinatesType& parameters,
+                const size_t start,
+                RowSparseMat<ElemType>& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the objective function and its gradient.  The probabilities are
+   * computed once and used for both.  GradType may be CoordinatesType or
+   * arma::SpMat<ElemType>.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  template<typename GradType>
+  double EvaluateWithGradient(const CoordinatesType& parameters,
+                              GradType& gradient) const;
+
+  /**
+   * Evaluate the objective function and its gradient on a subset of the data.
+   * The probabilities are computed once and used for both.  With the sampled
+   * softmax, the returned objective is the sampled loss that the gradient is
+   * taken of.  GradType may be CoordinatesType, arma::SpMat<ElemType> or
+   * RowSparseMat<ElemType>.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param start First index of the data points to use.
+   * @param gradient Matrix to store gradient into.
+   * @param batchSize Number of data points to evaluate for.
+   */
+  template<typename GradType>
+  double EvaluateWithGradient(const CoordinatesType& parameters,
+                              const size_t start,
+                              GradType& gradient,
+                              const size_t batchSize = 1) const;
+
   /**
    * Evaluates the gradient values of the objective function given the current
    * set of parameters for a single feature indexed by j.
@@ -158,12 +269,58 @@ class SoftmaxRegressionFunction
    *    gradient is to be computed.
    * @param gradient Out param for the gradient value.
    */
-  void PartialGradient(const arma::mat& parameters,
+  void PartialGradient(const CoordinatesType& parameters,
                        size_t j,
-                       arma::sp_mat& gradient) const;
+                       arma::SpMat<ElemType>& gradient) const;
+
+  /**
+   * Evaluates only column j of the partial gradient of the objective function
+   * with respect to feature j, and stores it in `column`.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param j The index of the feature with respect to which the partial
+   *    gradient is to be computed.
+   * @param column Out param for the column of the gradient.
+   */
+  void PartialGradientColumn(const CoordinatesType& parameters,
+                             const size_t j,
+                             arma::Col<ElemType>& column) const;
+
+  /**
+   * Store the product of the Hessian of the objective at the given parameters
+   * with the given direction in `product`.  With the probabilities P and the
+   * directional derivatives U of the scores, the product is
+   * (P % U - P % (1 * sum(P % U))) * [1; X]^T / n plus the regularization,
+   * so it takes two passes over the data and the Hessian is never formed.  This
+   * is used by NewtonCG.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param direction Matrix to multiply the Hessian with.
+   * @param product Matrix to store the product into.
+   */
+  void HessianVectorProduct(const CoordinatesType& parameters,
+                            const CoordinatesType& direction,
+                            CoordinatesType& product) const;
+
+  /**
+   * Store the product of the Hessian of the objective on a subset of the data
+   * (see Evaluate()) with the given direction in `product`.  This is used by
+   * SQN.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param start First index of the data points to use.
+   * @param direction Matrix to multiply the Hessian with.
+   * @param product Matrix to store the product into.
+   * @param batchSize Number of data points to use.
+   */
+  void HessianVectorProduct(const CoordinatesType& parameters,
+                            const size_t start,
+                            const CoordinatesType& direction,
+                            CoordinatesType& product,
+                            const size_t batchSize = 1) const;
 
   //! Return the initial point for the optimization.
-  const arma::mat& GetInitialPoint() const { return initialPoint; }
+  const CoordinatesType& GetInitialPoint() const { return initialPoint; }
 
   //! Gets the number of classes.
   size_t NumClasses() const { return numClasses; }
@@ -182,21 +339,128 @@ class SoftmaxRegressionFunction
   //! Gets the intercept flag.
   bool FitIntercept() const { return fitIntercept; }
 
+  //! Get the number of sampled classes (0 for the full softmax).
+  size_t NumSampled() const { return numSampled; }
+  //! Modify the number of sampled classes (0 for the full softmax).
+  size_t& NumSampled() { return numSampled; }
+
  private:
-  //! Training data matrix.  This is an alias until the data is shuffled.
-  arma::mat data;
+  /**
+   * Compute the probabilities matrix for the given points.  If labels are
+   * given, the negative log likelihood of the labels is computed in the same
+   * pass.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param points The points to compute the probabilities for.
+   * @param probabilities Matrix to store the probabilities into.
+   * @param labels The labels of the points, or NULL.
+   * @return The sum of the negative log-probabilities of the labels.
+   */
+  ElemType Probabilities(const CoordinatesType& parameters,
+                         const MatType& points,
+                         CoordinatesType& probabilities,
+                         const arma::uword* labels) const;
+
+  //! Store the product of the Hessian of the objective on the given points with
+  //! the direction.
+  void HessianProduct(const CoordinatesType& parameters,
+                      const MatType& points,
+                      const CoordinatesType& direction,
+                      CoordinatesType& product) const;
+
+  //! Subtract the ground truth of the given labels from the probabilities.
+  void SubtractLabels(CoordinatesType& probabilities,
+                      const arma::uword* labels) const;
+
+  /**
+   * Store the gradient given the difference between the probabilities and the
+   * ground truth of the given points.
+   */
+  void AssembleGradient(const CoordinatesType& parameters,
+                        const MatType& points,
+                        const CoordinatesType& inner,
+                        CoordinatesType& gradient) const;
+
+  //! Store the gradient into a sparse matrix.
+  void AssembleGradient(const CoordinatesType& parameters,
+                        const MatType& points,
+                        const CoordinatesType& inner,
+                        arma::SpMat<ElemType>& gradient) const;
+
+  //! Store the gradient into a row-sparse matrix, touching all rows.
+  void AssembleGradient(const CoordinatesType& parameters,
+                        const MatType& points,
+                        const CoordinatesType& inner,
+                        RowSparseMat<ElemType>& gradient) const;
+
+  /**
+   * Evaluate the sampled softmax loss of the given points and its gradient
+   * (see the class documentation).
+   *
+   * @param parameters Current values of the model parameters.
+   * @param points The points of the batch.
+   * @param labels The labels of the points.
+   * @param gradient Matrix to store gradient into.
+   * @return The sampled loss, with the regularization of the touched rows.
+   */
+  template<typename GradType>
+  double SampledEvaluateWithGradient(const CoordinatesType& parameters,
+                                     const MatType& points,
+                                     const arma::uvec& labels,
+                                     GradType& gradient) const;
+
+  //! Store the given rows of the gradient of the given classes into a dense
+  //! matrix; the other rows are zero.
+  void StoreRows(const arma::uvec& classes,
+                 const CoordinatesType& rows,
+                 CoordinatesType& gradient) const;
+
+  //! Store the given rows of the gradient of the given classes into a sparse
+  //! matrix.
+  void StoreRows(const arma::uvec& classes,
+                 const CoordinatesType& rows,
+                 arma::SpMat<ElemType>& gradient) const;
+
+  //! Store the given rows of the gradient of the given classes into a
+  //! row-sparse matrix, touching only these rows.
+  void StoreRows(const arma::uvec& classes,
+                 const CoordinatesType& rows,
+                 RowSparseMat<ElemType>& gradient) const;
+
+  //! Return the points of the given batch, in visitation order.  Unless the
+  //! data was shuffled, these are the contiguous columns (an alias for dense
+  //! data).
+  MatType BatchData(const size_t start, const size_t batchSize) const;
+
+  //! Return the labels of the given batch, in visitation order.
+  arma::uvec BatchLabels(const size_t start, const size_t batchSize) const;
+
+  //! Training data matrix.  This is a reference to the given data.
+  const MatType& data;
   //! Label matrix for the provided data.
-  arma::sp_mat groundTruth;
+  arma::SpMat<ElemType> groundTruth;
   //! Initial parameter point.
-  arma::mat initialPoint;
+  CoordinatesType initialPoint;
   //! Number of classes.
   size_t numClasses;
   //! L2-regularization constant.
   double lambda;
   //! Intercept term flag.
   bool fitIntercept;
+  //! Number of sampled classes, or 0 for the full softmax.
+  size_t numSampled;
+  //! The proposal distribution of the sampled classes.
+  arma::Col<ElemType> proposal;
+  //! The cumulative sum of the proposal, to draw from it.
+  arma::Col<ElemType> proposalCdf;
+  //! The order in which the points are visited.
+  arma::uvec visitationOrder;
+  //! Whether or not visitationOrder is used.
+  bool shuffled;
 };
 
+using SoftmaxRegressionFunction = SoftmaxRegressionFunctionType<arma::mat>;
+
 } // namespace test
 } // namespace ens
 
@@ -18,61 +18,72 @@
 namespace ens {
 namespace test {
 
-inline SoftmaxRegressionFunction::SoftmaxRegressionFunction(
-    const arma::mat& data,
+template<typename MatType>
+SoftmaxRegressionFunctionType<MatType>::SoftmaxRegressionFunctionType(
+    const MatType& data,
     const arma::Row<size_t>& labels,
     const size_t numClasses,
     const double lambda,
-    const bool fitIntercept) :
-    data(arma::mat(const_cast<arma::mat&>(data).memptr(), data.n_rows,
-      data.n_cols, false, false)),
+    const bool fitIntercept,
+    const size_t numSampled) :
+    data(data),
     numClasses(numClasses),
     lambda(lambda),
-    fitIntercept(fitIntercept)
+    fitIntercept(fitIntercept),
+    numSampled(numSampled),
+    shuffled(false)
 {
   // Initialize the parameters to suitable values.
   initialPoint = InitializeWeights();
 
   // Calculate the label matrix.
   GetGroundTruthMatrix(labels, groundTruth);
+
+  // The proposal of the sampled softmax is the frequency of the labels,
+  // smoothed by one so that every class can be sampled.
+  proposal.ones(numClasses);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    proposal[labels[i]] += 1;
+  proposal /= arma::accu(proposal);
+  proposalCdf = arma::cumsum(proposal);
 }
 
 /**
- * Shuffle the data.
+ * Shuffle the visitation order of the data.
  */
-inline void SoftmaxRegressionFunction::Shuffle()
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Shuffle()
 {
-  // Determine new ordering.
-  arma::uvec ordering = arma::shuffle(arma::linspace<arma::uvec>(0,
+  visitationOrder = arma::shuffle(arma::linspace<arma::uvec>(0,
       data.n_cols - 1, data.n_cols));
+  shuffled = true;
+}
 
-  // Re-sort data.
-  arma::mat newData = data.cols(ordering);
-  if (data.mem_state >= 1)
-    data.reset();
-  data = std::move(newData);
-
-  // Assemble data for batch constructor.  We need reverse orderings though...
-  arma::uvec reverseOrdering(ordering.n_elem);
-  for (size_t i = 0; i < ordering.n_elem; ++i)
-    reverseOrdering[ordering[i]] = i;
-
-  arma::umat newLocations(2, groundTruth.n_nonzero);
-  arma::vec values(groundTruth.n_nonzero);
-  arma::sp_mat::const_iterator it = groundTruth.begin();
-  size_t loc = 0;
-  while (it != groundTruth.end())
-  {
-    newLocations(0, loc) = reverseOrdering(it.col());
-    newLocations(1, loc) = it.row();
-    values(loc) = (*it);
+template<typename MatType>
+MatType SoftmaxRegressionFunctionType<MatType>::BatchData(
+    const size_t start,
+    const size_t batchSize) const
+{
+  if (!shuffled)
+    return ColumnRange(data, start, batchSize);
 
-    ++it;
-    ++loc;
-  }
+  return GatherColumns(data,
+      visitationOrder.subvec(start, start + batchSize - 1));
+}
 
-  groundTruth = arma::sp_mat(newLocations, values, groundTruth.n_rows,
-      groundTruth.n_cols);
+template<typename MatType>
+arma::uvec SoftmaxRegressionFunctionType<MatType>::BatchLabels(
+    const size_t start,
+    const size_t batchSize) const
+{
+  // Each column of the ground truth matrix holds exactly one entry, so the
+  // row index of column i is the label of point i.
+  const arma::uvec labels(const_cast<arma::uword*>(groundTruth.row_indices),
+      groundTruth.n_cols, false, true);
+  if (!shuffled)
+    return labels.subvec(start, start + batchSize - 1);
+
+  return labels.elem(visitationOrder.subvec(start, start + batchSize - 1));
 }
 
 /**
@@ -80,23 +91,28 @@ inline void SoftmaxRegressionFunction::Shuffle()
  * normal distribution. The weights cannot be initialized to zero, as that will
  * lead to each class output being the same.
  */
-inline const arma::mat SoftmaxRegressionFunction::InitializeWeights()
+template<typename MatType>
+const arma::Mat<typename MatType::elem_type>
+SoftmaxRegressionFunctionType<MatType>::InitializeWeights()
 {
   return InitializeWeights(data.n_rows, numClasses, fitIntercept);
 }
 
-inline const arma::mat SoftmaxRegressionFunction::InitializeWeights(
+template<typename MatType>
+const arma::Mat<typename MatType::elem_type>
+SoftmaxRegressionFunctionType<MatType>::InitializeWeights(
     const size_t featureSize,
     const size_t numClasses,
     const bool fitIntercept)
 {
-    arma::mat parameters;
+    CoordinatesType parameters;
     InitializeWeights(parameters, featureSize, numClasses, fitIntercept);
     return parameters;
 }
 
-inline void SoftmaxRegressionFunction::InitializeWeights(
-    arma::mat &weights,
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::InitializeWeights(
+    CoordinatesType& weights,
     const size_t featureSize,
     const size_t numClasses,
     const bool fitIntercept)
@@ -116,8 +132,9 @@ inline void SoftmaxRegressionFunction::InitializeWeights(
  * labels. The output is in the form of a matrix, which leads to simpler
  * calculations in the Evaluate() and Gradient() methods.
  */
-inline void SoftmaxRegressionFunction::GetGroundTruthMatrix(
-    const arma::Row<size_t>& labels, arma::sp_mat& groundTruth)
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::GetGroundTruthMatrix(
+    const arma::Row<size_t>& labels, arma::SpMat<ElemType>& groundTruth)
 {
   // Calculate the ground truth matrix according to the labels passed. The
   // ground truth matrix is a matrix of dimensions 'numClasses * numExamples',
@@ -130,6 +147,7 @@ inline void SoftmaxRegressionFunction::GetGroundTruthMatrix(
 
   // Row pointers are the labels of the examples, and column pointers are the
   // number of cumulative entries made uptil that column.
+  colPointers(0) = 0;
   for (size_t i = 0; i < labels.n_elem; i++)
   {
     rowPointers(i) = labels(i);
@@ -137,54 +155,72 @@ inline void SoftmaxRegressionFunction::GetGroundTruthMatrix(
   }
 
   // All entries are '1'.
-  arma::vec values;
+  arma::Col<ElemType> values;
   values.ones(labels.n_elem);
 
   // Calculate the matrix.
-  groundTruth = arma::sp_mat(rowPointers, colPointers, values, numClasses,
-                             labels.n_elem);
+  groundTruth = arma::SpMat<ElemType>(rowPointers, colPointers, values,
+      numClasses, labels.n_elem);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::GetProbabilitiesMatrix(
+    const CoordinatesType& parameters,
+    CoordinatesType& probabilities,
+    const size_t start,
+    const size_t batchSize) const
+{
+  Probabilities(parameters, BatchData(start, batchSize), probabilities, NULL);
 }
 
 /**
  * Evaluate the probabilities matrix. If fitIntercept flag is true,
  * it should consider the parameters.cols(0) intercept term.
  */
-inline void SoftmaxRegressionFunction::GetProbabilitiesMatrix(
-    const arma::mat& parameters,
-    arma::mat& probabilities,
-    const size_t start,
-    const size_t batchSize) const
+template<typename MatType>
+typename MatType::elem_type
+SoftmaxRegressionFunctionType<MatType>::Probabilities(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    CoordinatesType& probabilities,
+    const arma::uword* labels) const
 {
-  arma::mat hypothesis;
-
   if (fitIntercept)
   {
     // In order to add the intercept term, we should compute following matrix:
     //     [1; data] = arma::join_cols(ones(1, data.n_cols), data)
-    //     hypothesis = arma::exp(parameters * [1; data]).
+    //     hypothesis = parameters * [1; data].
     //
     // Since the cost of join may be high due to the copy of original data,
     // split the hypothesis computation to two components.
-    hypothesis = arma::exp(
-        arma::repmat(parameters.col(0), 1, batchSize) +
-        parameters.cols(1, parameters.n_cols - 1) *
-        data.cols(start, start + batchSize - 1));
+    probabilities = parameters.cols(1, parameters.n_cols - 1) * points;
+    probabilities.each_col() += parameters.col(0);
   }
   else
   {
-    hypothesis = arma::exp(parameters *
-        data.cols(start, start + batchSize - 1));
+    probabilities = parameters * points;
   }
 
-  probabilities = hypothesis / arma::repmat(arma::sum(hypothesis, 0),
-                                            numClasses, 1);
+  // The exponentiation and normalization are done in place, in one pass.
+  return SoftmaxInPlace(probabilities, labels);
+}
+
+//! Subtract the ground truth of the given labels from the probabilities.
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::SubtractLabels(
+    CoordinatesType& probabilities,
+    const arma::uword* labels) const
+{
+  for (size_t i = 0; i < probabilities.n_cols; ++i)
+    probabilities(labels[i], i) -= 1;
 }
 
 /**
  * Evaluates the objective function given the parameters.
  */
-inline double SoftmaxRegressionFunction::Evaluate(
-    const arma::mat& parameters) const
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::Evaluate(
+    const CoordinatesType& parameters) const
 {
   // The objective function is the negative log likelihood of the model
   // calculated over all the training examples. Mathematically it is as follows:
@@ -202,40 +238,31 @@ inline double SoftmaxRegressionFunction::Evaluate(
   // The sum is calculated over all the classes.
   // x_i is the input vector for a particular training example.
   // theta_j is the parameter vector associated with a particular class.
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
-
-  // Calculate the log likelihood and regularization terms.
-  double logLikelihood, weightDecay, cost;
-
-  logLikelihood = arma::accu(groundTruth % arma::log(probabilities)) /
-                  data.n_cols;
-  weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
+  // The log likelihood is computed along with the probabilities.
+  CoordinatesType probabilities;
+  const double logLikelihood = -Probabilities(parameters, data, probabilities,
+      groundTruth.row_indices) / data.n_cols;
+  const double weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
 
   // The cost is the sum of the negative log likelihood and the regularization
   // terms.
-  cost = -logLikelihood + weightDecay;
-
-  return cost;
+  return -logLikelihood + weightDecay;
 }
 
 /**
  * Evaluate the objective function for the given points given the parameters.
  */
-inline double SoftmaxRegressionFunction::Evaluate(
-    const arma::mat& parameters,
+template<typename MatType>
+double SoftmaxRegressionFunctionType<MatType>::Evaluate(
+    const CoordinatesType& parameters,
     const size_t start,
     const size_t batchSize) const
 {
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, start, batchSize);
-
-  // Calculate the log likelihood and regularization terms.
-  double logLikelihood, weightDecay;
-
-  logLikelihood = arma::accu(groundTruth.cols(start, start + batchSize - 1) %
-      arma::log(probabilities)) / batchSize;
-  weightDecay = 0.5 * lambda * arma::accu(parameters * parameters);
+  const arma::uvec labels = BatchLabels(start, batchSize);
+  CoordinatesType probabilities;
+  const double logLikelihood = -Probabilities(parameters,
+      BatchData(start, batchSize), probabilities, labels.memptr()) / batchSize;
+  const double weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
 
   return -logLikelihood + weightDecay;
 }
@@ -243,87 +270,340 @@ inline double SoftmaxRegressionFunction::Evaluate(
 /**
  * Calculates and stores the gradient values given a set of parameters.
  */
-inline void SoftmaxRegressionFunction::Gradient(
-    const arma::mat& parameters, arma::mat& gradient) const
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
+    const CoordinatesType& parameters, CoordinatesType& gradient) const
 {
-  // Calculate the class probabilities for each training example. The
-  // probabilities for each of the classes are given by:
-  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
-  // The sum is calculated over all the classes.
-  // x_i is the input vector for a particular training example.
-  // theta_j is the parameter vector associated with a particular class.
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+  EvaluateWithGradient(parameters, gradient);
+}
 
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
+    const CoordinatesType& parameters,
+    arma::SpMat<ElemType>& gradient) const
+{
+  EvaluateWithGradient(parameters, gradient);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
+    const CoordinatesType& parameters,
+    const size_t start,
+    CoordinatesType& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(parameters, start, gradient, batchSize);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
+    const CoordinatesType& parameters,
+    const size_t start,
+    arma::SpMat<ElemType>& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(parameters, start, gradient, batchSize);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::Gradient(
+    const CoordinatesType& parameters,
+    const size_t start,
+    RowSparseMat<ElemType>& gradient,
+    const size_t batchSize) const
+{
+  EvaluateWithGradient(parameters, start, gradient, batchSize);
+}
+
+template<typename MatType>
+template<typename GradType>
+double SoftmaxRegressionFunctionType<MatType>::EvaluateWithGradient(
+    const CoordinatesType& parameters,
+    GradType& gradient) const
+{
+  // The probabilities are turned into the difference from the ground truth in
+  // place, and used for the gradient.
+  CoordinatesType probabilities;
+  const double loss = Probabilities(parameters, data, probabilities,
+      groundTruth.row_indices) / data.n_cols;
+  SubtractLabels(probabilities, groundTruth.row_indices);
+  AssembleGradient(parameters, data, probabilities, gradient);
+
+  return loss + 0.5 * lambda * arma::accu(parameters % parameters);
+}
+
+template<typename MatType>
+template<typename GradType>
+double SoftmaxRegressionFunctionType<MatType>::EvaluateWithGradient(
+    const CoordinatesType& parameters,
+    const size_t start,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  const MatType batchData = BatchData(start, batchSize);
+  const arma::uvec labels = BatchLabels(start, batchSize);
+  if (numSampled > 0)
+    return SampledEvaluateWithGradient(parameters, batchData, labels, gradient);
+
+  CoordinatesType probabilities;
+  const double loss = Probabilities(parameters, batchData, probabilities,
+      labels.memptr()) / batchSize;
+  SubtractLabels(probabilities, labels.memptr());
+  AssembleGradient(parameters, batchData, probabilities, gradient);
+
+  return loss + 0.5 * lambda * arma::accu(parameters % parameters);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::AssembleGradient(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const CoordinatesType& inner,
+    CoordinatesType& gradient) const
+{
   // Calculate the parameter gradients.
   gradient.set_size(parameters.n_rows, parameters.n_cols);
   if (fitIntercept)
   {
     // Treating the intercept term parameters.col(0) seperately to avoid
     // the cost of building matrix [1; data].
-    arma::mat inner = probabilities - groundTruth;
-    gradient.col(0) =
-      inner * arma::ones<arma::mat>(data.n_cols, 1) / data.n_cols +
-      lambda * parameters.col(0);
+    gradient.col(0) = arma::sum(inner, 1) / points.n_cols +
+        lambda * parameters.col(0);
     gradient.cols(1, parameters.n_cols - 1) =
-      inner * data.t() / data.n_cols +
-      lambda * parameters.cols(1, parameters.n_cols - 1);
+        inner * points.t() / points.n_cols +
+        lambda * parameters.cols(1, parameters.n_cols - 1);
   }
   else
   {
-    gradient = (probabilities - groundTruth) * data.t() / data.n_cols +
-               lambda * parameters;
+    gradient = inner * points.t() / points.n_cols + lambda * parameters;
   }
 }
 
-inline void SoftmaxRegressionFunction::Gradient(
-    const arma::mat& parameters,
-    const size_t start,
-    arma::mat& gradient,
-    const size_t batchSize) const
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::AssembleGradient(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const CoordinatesType& inner,
+    arma::SpMat<ElemType>& gradient) const
 {
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, start, batchSize);
+  // For sparse points this is a sparse-sparse product, whose nonzero columns
+  // are the features present in the points.
+  const arma::SpMat<ElemType> featureGradient(
+      arma::SpMat<ElemType>(inner) * points.t());
+
+  const size_t offset = fitIntercept ? 1 : 0;
+  std::vector<arma::uword> rows, cols;
+  std::vector<ElemType> values;
+  typename arma::SpMat<ElemType>::const_iterator it = featureGradient.begin();
+  for (; it != featureGradient.end(); ++it)
+  {
+    rows.push_back(it.row());
+    cols.push_back(it.col() + offset);
+    values.push_back((*it) / points.n_cols);
+  }
 
-  // Calculate the parameter gradients.
-  gradient.set_size(parameters.n_rows, parameters.n_cols);
   if (fitIntercept)
   {
-    arma::mat inner = probabilities - groundTruth.cols(start, start +
-        batchSize - 1);
-    gradient.col(0) =
-        inner * arma::ones<arma::mat>(batchSize, 1) / batchSize +
-        lambda * parameters.col(0);
-    gradient.cols(1, parameters.n_cols - 1) =
-        inner * data.cols(start, start + batchSize - 1).t() / batchSize +
-        lambda * parameters.cols(1, parameters.n_cols - 1);
+    const arma::Col<ElemType> intercept = arma::sum(inner, 1) / points.n_cols;
+    for (size_t r = 0; r < intercept.n_elem; ++r)
+    {
+      rows.push_back(r);
+      cols.push_back(0);
+      values.push_back(intercept[r]);
+    }
+  }
+
+  // The regularization makes the gradient dense.
+  if (lambda != 0.0)
+  {
+    for (size_t c = 0; c < parameters.n_cols; ++c)
+    {
+      for (size_t r = 0; r < parameters.n_rows; ++r)
+      {
+        rows.push_back(r);
+        cols.push_back(c);
+        values.push_back(lambda * parameters(r, c));
+      }
+    }
+  }
+
+  // The constructor sums duplicate locations.
+  arma::umat locations(2, values.size());
+  locations.row(0) = arma::urowvec(rows);
+  locations.row(1) = arma::urowvec(cols);
+  gradient = arma::SpMat<ElemType>(true, locations, arma::Col<ElemType>(values),
+      parameters.n_rows, parameters.n_cols);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::AssembleGradient(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const CoordinatesType& inner,
+    RowSparseMat<ElemType>& gradient) const
+{
+  CoordinatesType dense;
+  AssembleGradient(parameters, points, inner, dense);
+  StoreRows(arma::linspace<arma::uvec>(0, parameters.n_rows - 1,
+      parameters.n_rows), dense, gradient);
+}
+
+template<typename MatType>
+template<typename GradType>
+double SoftmaxRegressionFunctionType<MatType>::SampledEvaluateWithGradient(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const arma::uvec& labels,
+    GradType& gradient) const
+{
+  const size_t batchSize = points.n_cols;
+
+  // Draw the negatives shared by the batch from the proposal.  The stream is
+  // seeded from the generator of Armadillo.
+  RandomStream rng;
+  arma::uvec sampled(numSampled);
+  const ElemType total = proposalCdf[numClasses - 1];
+  for (size_t k = 0; k < numSampled; ++k)
+  {
+    const ElemType u = rng.Uniform<ElemType>() * total;
+    const size_t c = std::upper_bound(proposalCdf.begin(), proposalCdf.end(),
+        u) - proposalCdf.begin();
+    sampled[k] = std::min(c, numClasses - 1);
+  }
+
+  // Only the labels of the batch and the sampled classes are scored; classes
+  // is sorted, so the slot of a class is found by binary search.
+  const arma::uvec classes = arma::unique(arma::join_cols(labels, sampled));
+  arma::uvec labelSlots(batchSize), sampledSlots(numSampled);
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    labelSlots[i] = std::lower_bound(classes.begin(), classes.end(),
+        labels[i]) - classes.begin();
+  }
+  for (size_t k = 0; k < numSampled; ++k)
+  {
+    sampledSlots[k] = std::lower_bound(classes.begin(), classes.end(),
+        sampled[k]) - classes.begin();
+  }
+
+  const CoordinatesType weights = parameters.rows(classes);
+  CoordinatesType scores;
+  if (fitIntercept)
+  {
+    scores = weights.cols(1, weights.n_cols - 1) * points;
+    scores.each_col() += weights.col(0);
   }
   else
   {
-    gradient = (probabilities - groundTruth.cols(start, start + batchSize - 1))
-        * data.cols(start, start + batchSize - 1).t() / batchSize
-        + lambda * parameters;
+    scores = weights * points;
+  }
+
+  // The log of the expected number of draws of each candidate class.
+  arma::Col<ElemType> logCounts(classes.n_elem);
+  for (size_t u = 0; u < classes.n_elem; ++u)
+    logCounts[u] = std::log(numSampled * proposal[classes[u]]);
+
+  // Row 0 holds the scores of the labels, and row k + 1 the corrected score of
+  // the k'th sampled class; a sampled class that is the label of the point is
+  // removed.  The label of every column is then 0.
+  CoordinatesType logits(numSampled + 1, batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    logits(0, i) = scores(labelSlots[i], i);
+    for (size_t k = 0; k < numSampled; ++k)
+    {
+      logits(k + 1, i) = (sampled[k] == labels[i]) ?
+          -std::numeric_limits<ElemType>::infinity() :
+          scores(sampledSlots[k], i) - logCounts[sampledSlots[k]];
+    }
+  }
+
+  const arma::uvec zeros(batchSize, arma::fill::zeros);
+  const double loss = SoftmaxInPlace(logits, zeros.memptr()) / batchSize;
+
+  // The derivatives of the loss of each point with respect to the scores of
+  // the candidate classes; a class drawn several times gets each of its draws.
+  CoordinatesType inner(classes.n_elem, batchSize, arma::fill::zeros);
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    inner(labelSlots[i], i) += logits(0, i) - 1;
+    for (size_t k = 0; k < numSampled; ++k)
+      inner(sampledSlots[k], i) += logits(k + 1, i);
+  }
+
+  CoordinatesType rows;
+  AssembleGradient(weights, points, inner, rows);
+  StoreRows(classes, rows, gradient);
+
+  return loss + 0.5 * lambda * arma::accu(weights % weights);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::StoreRows(
+    const arma::uvec& classes,
+    const CoordinatesType& rows,
+    CoordinatesType& gradient) const
+{
+  gradient.zeros(numClasses, rows.n_cols);
+  gradient.rows(classes) = rows;
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::StoreRows(
+    const arma::uvec& classes,
+    const CoordinatesType& rows,
+    arma::SpMat<ElemType>& gradient) const
+{
+  arma::umat locations(2, rows.n_elem);
+  arma::Col<ElemType> values(rows.n_elem);
+  size_t n = 0;
+  for (size_t c = 0; c < rows.n_cols; ++c)
+  {
+    for (size_t u = 0; u < rows.n_rows; ++u, ++n)
+    {
+      locations(0, n) = classes[u];
+      locations(1, n) = c;
+      values[n] = rows(u, c);
+    }
+  }
+
+  gradient = arma::SpMat<ElemType>(locations, values, numClasses, rows.n_cols);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::StoreRows(
+    const arma::uvec& classes,
+    const CoordinatesType& rows,
+    RowSparseMat<ElemType>& gradient) const
+{
+  gradient.zeros(numClasses, rows.n_cols);
+  for (size_t u = 0; u < classes.n_elem; ++u)
+  {
+    ElemType* row = gradient.Row(classes[u]);
+    for (size_t c = 0; c < rows.n_cols; ++c)
+      row[c] = rows(u, c);
   }
 }
 
-inline void SoftmaxRegressionFunction::PartialGradient(
-    const arma::mat& parameters,
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::PartialGradient(
+    const CoordinatesType& parameters,
     const size_t j,
-    arma::sp_mat& gradient) const
+    arma::SpMat<ElemType>& gradient) const
 {
   gradient.zeros(arma::size(parameters));
 
-  arma::mat probabilities;
-  GetProbabilitiesMatrix(parameters, probabilities, 0, data.n_cols);
+  CoordinatesType probabilities;
+  Probabilities(parameters, data, probabilities, NULL);
 
   // Calculate the required part of the gradient.
-  arma::mat inner = probabilities - groundTruth;
+  CoordinatesType inner = probabilities - groundTruth;
   if (fitIntercept)
   {
     if (j == 0)
     {
       gradient.col(j) =
-          inner * arma::ones<arma::mat>(data.n_cols, 1) / data.n_cols +
+          inner * arma::ones<CoordinatesType>(data.n_cols, 1) / data.n_cols +
           lambda * parameters.col(0);
     }
     else
@@ -339,6 +619,77 @@ inline void SoftmaxRegressionFunction::PartialGradient(
   }
 }
 
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::PartialGradientColumn(
+    const CoordinatesType& parameters,
+    const size_t j,
+    arma::Col<ElemType>& column) const
+{
+  CoordinatesType probabilities;
+  Probabilities(parameters, data, probabilities, NULL);
+
+  // Calculate the required part of the gradient.
+  CoordinatesType inner = probabilities - groundTruth;
+  if (fitIntercept && j == 0)
+  {
+    column = arma::sum(inner, 1) / data.n_cols + lambda * parameters.col(0);
+  }
+  else
+  {
+    column = inner * data.row(j).t() / data.n_cols + lambda *
+        parameters.col(j);
+  }
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::HessianVectorProduct(
+    const CoordinatesType& parameters,
+    const CoordinatesType& direction,
+    CoordinatesType& product) const
+{
+  HessianProduct(parameters, data, direction, product);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::HessianVectorProduct(
+    const CoordinatesType& parameters,
+    const size_t start,
+    const CoordinatesType& direction,
+    CoordinatesType& product,
+    const size_t batchSize) const
+{
+  HessianProduct(parameters, BatchData(start, batchSize), direction, product);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunctionType<MatType>::HessianProduct(
+    const CoordinatesType& parameters,
+    const MatType& points,
+    const CoordinatesType& direction,
+    CoordinatesType& product) const
+{
+  CoordinatesType probabilities;
+  Probabilities(parameters, points, probabilities, NULL);
+
+  // The directional derivatives of the scores.
+  CoordinatesType inner;
+  if (fitIntercept)
+  {
+    inner = direction.cols(1, direction.n_cols - 1) * points;
+    inner.each_col() += direction.col(0);
+  }
+  else
+  {
+    inner = direction * points;
+  }
+
+  // The directional derivatives of the probabilities; the gradient assembly
+  // then adds lambda * direction, the product with the regularization.
+  inner.each_row() -= arma::sum(probabilities % inner, 0);
+  inner %= probabilities;
+  AssembleGradient(direction, points, inner, product);
+}
+
 } // namespace test
 } // namespace ens
 
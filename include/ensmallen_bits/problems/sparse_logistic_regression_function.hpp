@@ -0,0 +1,175 @@
+/**
+ * @file sparse_logistic_regression_function.hpp
+ *
+ * Definition of a logistic regression function on sparse data, with a
+ * generator of synthetic problems of any size.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_HPP
+#define ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_HPP
+
+namespace ens {
+namespace test {
+
+/**
+ * The negative log-likelihood of logistic regression on sparse predictors,
+ * defined by
+ *
+ *  f(w, b) = sum_j^N log(1 + exp(-y_j (w^T x_j + b))) + lambda / 2 ||w||^2
+ *
+ * with responses y_j in {-1, 1} (given as 0 or 1).  The coordinates are a
+ * column vector of size d + 1, where the last element is the intercept b.
+ *
+ * The function is separable over the N points, so it can be used with SGD-like
+ * optimizers.  Gradient() also accepts an arma::sp_mat, whose non-zero
+ * elements are only the features of the points in the batch (and the
+ * intercept) if lambda is 0; so the function can be used with ParallelSGD.
+ *
+ * Problems of any size can be generated with the second constructor: the
+ * predictors are uniformly random with the given density, and the responses
+ * are given by a random linear model with some label noise.  This is useful to
+ * measure how optimizers scale with the dimensionality d, the number of points
+ * N and the density of the data.
+ */
+class SparseLogisticRegressionFunction
+{
+ public:
+  /**
+   * Create the function for the given data.
+   *
+   * @param predictors The predictors; each column is a point.
+   * @param responses The responses (0 or 1) of the points.
+   * @param lambda The L2-regularization parameter.
+   */
+  SparseLogisticRegressionFunction(const arma::sp_mat& predictors,
+                                   const arma::Row<size_t>& responses,
+                                   const double lambda = 0.0);
+
+  /**
+   * Generate a random problem.  The generated data depends on the seed of the
+   * Armadillo random number generator.
+   *
+   * @param dimensionality The number of features d.
+   * @param numPoints The number of points N.
+   * @param density The fraction of non-zero predictors.
+   * @param lambda The L2-regularization parameter.
+   */
+  SparseLogisticRegressionFunction(const size_t dimensionality,
+                                   const size_t numPoints,
+                                   const double density,
+                                   const double lambda = 0.0);
+
+  /**
+   * Shuffle the order of function visitation.  This may be called by the
+   * optimizer.
+   */
+  void Shuffle();
+
+  //! Return the number of functions (points).
+  size_t NumFunctions() const { return predictors.n_cols; }
+
+  //! Get the starting point.
+  template<typename MatType = arma::mat>
+  MatType GetInitialPoint() const
+  {
+    return arma::zeros<MatType>(predictors.n_rows + 1, 1);
+  }
+
+  /**
+   * Evaluate the function for the given batch of points.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param batchSize Number of points to process.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates,
+                                       const size_t begin,
+                                       const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the function with the given coordinates.
+   *
+   * @param coordinates The function coordinates.
+   */
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const;
+
+  /**
+   * Evaluate the gradient of the function for the given batch of points.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of points to process.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the sparse gradient of the function for the given batch of
+   * points.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of points to process.
+   */
+  template<typename MatType>
+  void Gradient(const MatType& coordinates,
+                const size_t begin,
+                arma::SpMat<typename MatType::elem_type>& gradient,
+                const size_t batchSize = 1) const;
+
+  /**
+   * Evaluate the gradient of the function with the given coordinates.
+   *
+   * @param coordinates The function coordinates.
+   * @param gradient The function gradient.
+   */
+  template<typename MatType, typename GradType>
+  void Gradient(const MatType& coordinates, GradType& gradient) const;
+
+  //! Get the predictors.
+  const arma::sp_mat& Predictors() const { return predictors; }
+  //! Get the responses.
+  const arma::Row<size_t>& Responses() const { return responses; }
+
+  //! Get the L2-regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the L2-regularization parameter.
+  double& Lambda() { return lambda; }
+
+ private:
+  //! Return the linear model w^T x_j + b of the given point.
+  template<typename MatType>
+  typename MatType::elem_type Margin(const MatType& coordinates,
+                                     const size_t j) const;
+
+  //! The predictors.
+  arma::sp_mat predictors;
+
+  //! The responses.
+  arma::Row<size_t> responses;
+
+  //! The L2-regularization parameter.
+  double lambda;
+
+  //! For shuffling.
+  arma::Row<size_t> visitationOrder;
+};
+
+} // namespace test
+} // namespace ens
+
+// Include implementation.
+#include "sparse_logistic_regression_function_impl.hpp"
+
+#endif // ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_HPP
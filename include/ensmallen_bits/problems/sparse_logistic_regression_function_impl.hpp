@@ -0,0 +1,199 @@
+/**
+ * @file sparse_logistic_regression_function_impl.hpp
+ *
+ * Implementation of the SparseLogisticRegressionFunction class.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+#define ENSMALLEN_PROBLEMS_SPARSE_LOGISTIC_REGRESSION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sparse_logistic_regression_function.hpp"
+
+namespace ens {
+namespace test {
+
+inline SparseLogisticRegressionFunction::SparseLogisticRegressionFunction(
+    const arma::sp_mat& predictors,
+    const arma::Row<size_t>& responses,
+    const double lambda) :
+    predictors(predictors),
+    responses(responses),
+    lambda(lambda),
+    visitationOrder(arma::linspace<arma::Row<size_t>>(0,
+        predictors.n_cols - 1, predictors.n_cols))
+{
+  if (responses.n_elem != predictors.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "SparseLogisticRegressionFunction::"
+        << "SparseLogisticRegressionFunction(): predictors matrix has "
+        << predictors.n_cols << " points, but responses vector has "
+        << responses.n_elem << " elements!";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+inline SparseLogisticRegressionFunction::SparseLogisticRegressionFunction(
+    const size_t dimensionality,
+    const size_t numPoints,
+    const double density,
+    const double lambda) :
+    predictors(arma::sprandn<arma::sp_mat>(dimensionality, numPoints,
+        density)),
+    lambda(lambda),
+    visitationOrder(arma::linspace<arma::Row<size_t>>(0, numPoints - 1,
+        numPoints))
+{
+  // The responses are given by a random linear model; the noise flips the
+  // labels of points close to the decision boundary.
+  const arma::vec weights(dimensionality, arma::fill::randn);
+  const arma::rowvec margins = weights.t() * predictors;
+  const double noise = 0.1 * std::sqrt(density * dimensionality);
+  const arma::urowvec positive = (margins +
+      noise * arma::rowvec(numPoints, arma::fill::randn)) > 0;
+  responses = arma::conv_to<arma::Row<size_t>>::from(positive);
+}
+
+inline void SparseLogisticRegressionFunction::Shuffle()
+{
+  visitationOrder = arma::shuffle(visitationOrder);
+}
+
+template<typename MatType>
+typename MatType::elem_type SparseLogisticRegressionFunction::Margin(
+    const MatType& coordinates,
+    const size_t j) const
+{
+  typename MatType::elem_type margin = coordinates[predictors.n_rows];
+  arma::sp_mat::const_iterator it = predictors.begin_col(j);
+  const arma::sp_mat::const_iterator end = predictors.end_col(j);
+  for (; it != end; ++it)
+    margin += (*it) * coordinates[it.row()];
+
+  return margin;
+}
+
+template<typename MatType>
+typename MatType::elem_type SparseLogisticRegressionFunction::Evaluate(
+    const MatType& coordinates,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t d = predictors.n_rows;
+  ElemType objective = lambda * batchSize / (2.0 * NumFunctions()) *
+      arma::dot(coordinates.head_rows(d), coordinates.head_rows(d));
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t j = visitationOrder[i];
+    const ElemType y = (responses[j] == 1) ? 1 : -1;
+    // log(1 + exp(-t)), computed without overflow.
+    const ElemType t = y * Margin(coordinates, j);
+    objective += (t > 0) ? std::log1p(std::exp(-t)) :
+        -t + std::log1p(std::exp(t));
+  }
+
+  return objective;
+}
+
+template<typename MatType>
+typename MatType::elem_type SparseLogisticRegressionFunction::Evaluate(
+    const MatType& coordinates) const
+{
+  return Evaluate(coordinates, 0, NumFunctions());
+}
+
+template<typename MatType, typename GradType>
+void SparseLogisticRegressionFunction::Gradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t d = predictors.n_rows;
+  gradient.zeros(d + 1, 1);
+  gradient.head_rows(d) = (lambda * batchSize / NumFunctions()) *
+      coordinates.head_rows(d);
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t j = visitationOrder[i];
+    const ElemType y = (responses[j] == 1) ? 1 : -1;
+    // The derivative of log(1 + exp(-y m)) with respect to the margin m.
+    const ElemType derivative = -y / (1 + std::exp(y * Margin(coordinates,
+        j)));
+
+    arma::sp_mat::const_iterator it = predictors.begin_col(j);
+    const arma::sp_mat::const_iterator end = predictors.end_col(j);
+    for (; it != end; ++it)
+      gradient[it.row()] += derivative * (*it);
+    gradient[d] += derivative;
+  }
+}
+
+template<typename MatType>
+void SparseLogisticRegressionFunction::Gradient(
+    const MatType& coordinates,
+    const size_t begin,
+    arma::SpMat<typename MatType::elem_type>& gradient,
+    const size_t batchSize) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Collect the contributions of all points; the constructor of the sparse
+  // matrix sums duplicate locations.
+  const size_t d = predictors.n_rows;
+  std::vector<arma::uword> rows;
+  std::vector<ElemType> values;
+  for (size_t i = begin; i < begin + batchSize; ++i)
+  {
+    const size_t j = visitationOrder[i];
+    const ElemType y = (responses[j] == 1) ? 1 : -1;
+    const ElemType derivative = -y / (1 + std::exp(y * Margin(coordinates,
+        j)));
+
+    arma::sp_mat::const_iterator it = predictors.begin_col(j);
+    const arma::sp_mat::const_iterator end = predictors.end_col(j);
+    for (; it != end; ++it)
+    {
+      rows.push_back(it.row());
+      values.push_back(derivative * (*it));
+    }
+    rows.push_back(d);
+    values.push_back(derivative);
+  }
+
+  // The regularization makes the gradient dense.
+  if (lambda != 0.0)
+  {
+    for (size_t k = 0; k < d; ++k)
+    {
+      rows.push_back(k);
+      values.push_back(lambda * batchSize / NumFunctions() * coordinates[k]);
+    }
+  }
+
+  arma::umat locations(2, rows.size(), arma::fill::zeros);
+  locations.row(0) = arma::urowvec(rows);
+  gradient = arma::SpMat<ElemType>(true, locations, arma::Col<ElemType>(values),
+      d + 1, 1);
+}
+
+template<typename MatType, typename GradType>
+void SparseLogisticRegressionFunction::Gradient(const MatType& coordinates,
+                                                GradType& gradient) const
+{
+  Gradient(coordinates, 0, gradient, NumFunctions());
+}
+
+} // namespace test
+} // namespace ens
+
+#endif
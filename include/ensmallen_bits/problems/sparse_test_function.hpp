@@ -68,6 +68,32 @@ class SparseTestFunction
                        const size_t j,
                        GradType& gradient) const;
 
+  //! Evaluate the only nonzero column of the gradient of a feature function.
+  template<typename MatType>
+  void PartialGradientColumn(const MatType& coordinates,
+                             const size_t j,
+                             arma::Col<typename MatType::elem_type>& column)
+      const
+  {
+    column.set_size(1);
+    column[0] = 2 * coordinates[j] + bi[j];
+  }
+
+  //! The partial gradient of each feature only depends on the feature itself.
+  void AffectedFeatures(const size_t j, arma::uvec& features) const
+  {
+    features.set_size(1);
+    features[0] = j;
+  }
+
+  //! Function i only depends on the feature i.
+  void SparsityPattern(const size_t i,
+                       const size_t batchSize,
+                       arma::uvec& elements) const
+  {
+    elements = arma::regspace<arma::uvec>(i, i + batchSize - 1);
+  }
+
  private:
   // Each quadratic polynomial is monic. The intercept and coefficient of the
   // first order term is stored.
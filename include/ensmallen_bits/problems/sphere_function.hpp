@@ -114,9 +114,90 @@ class SphereFunction
    * @param gradient The function gradient.
    */
   template<typename MatType, typename GradType>
-  void Gradient(const MatType& coordinates, GradType& gradient);
+  void Gradient(const MatType& coordinates, GradType& gradient) const;
+
+  /**
+   * Evaluate the objective and the gradient of a function for a particular
+   * batch-size, in a single pass over the batch.
+   *
+   * @param coordinates The function coordinates.
+   * @param begin The first function.
+   * @param gradient The function gradient.
+   * @param batchSize Number of points to process.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(
+      const MatType& coordinates,
+      const size_t begin,
+      GradType& gradient,
+      const size_t batchSize) const;
+
+  /**
+   * Evaluate the objective and the gradient of a function with the given
+   * coordinates, in a single pass over the coordinates.
+   *
+   * @param coordinates The function coordinates.
+   * @param gradient The function gradient.
+   */
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type EvaluateWithGradient(const MatType& coordinates,
+                                                   GradType& gradient) const;
+
+  /**
+   * Evaluate the objective of each candidate (slice) of the given population,
+   * for the population-based optimizers (see EvaluateBatch()).  The candidates
+   * are evaluated in parallel.
+   *
+   * @param candidates The candidates to evaluate, one per slice.
+   * @param objectives Vector to store the objectives into.
+   */
+  template<typename ElemType>
+  void EvaluateBatch(const arma::Cube<ElemType>& candidates,
+                     arma::Col<ElemType>& objectives) const;
 
  private:
+  //! Evaluate() for dense matrices: one loop over the raw memory.
+  template<typename MatType>
+  typename MatType::elem_type FusedEvaluate(const MatType& coordinates,
+                                            std::true_type /* fused */) const;
+
+  //! Evaluate() for all other matrix types.
+  template<typename MatType>
+  typename MatType::elem_type FusedEvaluate(const MatType& coordinates,
+                                            std::false_type /* fused */) const;
+
+  //! Gradient() for dense matrices: one loop over the raw memory.
+  template<typename MatType, typename GradType>
+  void FusedGradient(const MatType& coordinates,
+                     GradType& gradient,
+                     std::true_type /* fused */) const;
+
+  //! Gradient() for all other matrix types.
+  template<typename MatType, typename GradType>
+  void FusedGradient(const MatType& coordinates,
+                     GradType& gradient,
+                     std::false_type /* fused */) const;
+
+  //! EvaluateWithGradient() for dense matrices: one loop over the raw memory.
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type FusedEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::true_type /* fused */) const;
+
+  //! EvaluateWithGradient() for all other matrix types.
+  template<typename MatType, typename GradType>
+  typename MatType::elem_type FusedEvaluateWithGradient(
+      const MatType& coordinates,
+      GradType& gradient,
+      std::false_type /* fused */) const;
+
+  //! Return the sum of x_i^2 over the elements [begin, end) of x.
+  template<typename ElemType>
+  static ElemType ObjectiveKernel(const ElemType* x,
+                                  const size_t begin,
+                                  const size_t end);
+
   //! Number of dimensions for the function.
   size_t n;
 
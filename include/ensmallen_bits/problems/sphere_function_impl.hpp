@@ -45,11 +45,14 @@ typename MatType::elem_type SphereFunction::Evaluate(
     const size_t begin,
     const size_t batchSize) const
 {
-  typename MatType::elem_type objective = 0.0;
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  ElemType objective = 0;
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
-    const size_t p = visitationOrder[j];
-    objective += std::pow(coordinates(p), 2);
+    const ElemType x = coordinates(visitationOrder[j]);
+    objective += x * x;
   }
 
   return objective;
@@ -59,7 +62,7 @@ template<typename MatType>
 typename MatType::elem_type SphereFunction::Evaluate(
     const MatType& coordinates) const
 {
-  return Evaluate(coordinates, 0, NumFunctions());
+  return FusedEvaluate(coordinates, UseFusedUpdate<MatType, MatType>());
 }
 
 template<typename MatType, typename GradType>
@@ -68,22 +71,169 @@ void SphereFunction::Gradient(const MatType& coordinates,
                               GradType& gradient,
                               const size_t batchSize) const
 {
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
   gradient.zeros(n, 1);
 
   for (size_t j = begin; j < begin + batchSize; ++j)
   {
     const size_t p = visitationOrder[j];
-    gradient(p) += 2.0 * coordinates[p];
+    const ElemType x = coordinates(p);
+    gradient(p) += 2 * x;
   }
 }
 
 template<typename MatType, typename GradType>
 void SphereFunction::Gradient(const MatType& coordinates,
-                              GradType& gradient)
+                              GradType& gradient) const
+{
+  FusedGradient(coordinates, gradient, UseFusedUpdate<MatType, GradType>());
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type SphereFunction::EvaluateWithGradient(
+    const MatType& coordinates,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.zeros(n, 1);
+
+  ElemType objective = 0;
+  for (size_t j = begin; j < begin + batchSize; ++j)
+  {
+    const size_t p = visitationOrder[j];
+    const ElemType x = coordinates(p);
+    objective += x * x;
+    gradient(p) += 2 * x;
+  }
+
+  return objective;
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type SphereFunction::EvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient) const
+{
+  return FusedEvaluateWithGradient(coordinates, gradient,
+      UseFusedUpdate<MatType, GradType>());
+}
+
+template<typename ElemType>
+void SphereFunction::EvaluateBatch(const arma::Cube<ElemType>& candidates,
+                                   arma::Col<ElemType>& objectives) const
+{
+  objectives.set_size(candidates.n_slices);
+  ParallelFor(candidates.n_slices, [&](const size_t i)
+  {
+    objectives[i] = ObjectiveKernel(candidates.slice_memptr(i), 0,
+        candidates.n_elem_slice);
+  });
+}
+
+template<typename MatType>
+typename MatType::elem_type SphereFunction::FusedEvaluate(
+    const MatType& coordinates,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  const ElemType* x = coordinates.memptr();
+  return FusedSum<ElemType>(n, [&](const size_t begin, const size_t end)
+  {
+    return ObjectiveKernel(x, begin, end);
+  });
+}
+
+template<typename MatType>
+typename MatType::elem_type SphereFunction::FusedEvaluate(
+    const MatType& coordinates,
+    std::false_type /* fused */) const
+{
+  return Evaluate(coordinates, 0, NumFunctions());
+}
+
+template<typename MatType, typename GradType>
+void SphereFunction::FusedGradient(const MatType& coordinates,
+                                   GradType& gradient,
+                                   std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.set_size(n, 1);
+  const ElemType* x = coordinates.memptr();
+  ElemType* g = gradient.memptr();
+  FusedForEach(n, [&](const size_t begin, const size_t end)
+  {
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = begin; i < end; ++i)
+      g[i] = 2 * x[i];
+  });
+}
+
+template<typename MatType, typename GradType>
+void SphereFunction::FusedGradient(const MatType& coordinates,
+                                   GradType& gradient,
+                                   std::false_type /* fused */) const
 {
   Gradient(coordinates, 0, gradient, NumFunctions());
 }
 
+template<typename MatType, typename GradType>
+typename MatType::elem_type SphereFunction::FusedEvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::true_type /* fused */) const
+{
+  // Convenience typedef.
+  typedef typename MatType::elem_type ElemType;
+
+  gradient.set_size(n, 1);
+  const ElemType* x = coordinates.memptr();
+  ElemType* g = gradient.memptr();
+  return FusedSum<ElemType>(n, [&](const size_t begin, const size_t end)
+  {
+    ElemType objective = 0;
+    ENS_PRAGMA_OMP_SIMD_SUM(objective)
+    for (size_t i = begin; i < end; ++i)
+    {
+      objective += x[i] * x[i];
+      g[i] = 2 * x[i];
+    }
+
+    return objective;
+  });
+}
+
+template<typename MatType, typename GradType>
+typename MatType::elem_type SphereFunction::FusedEvaluateWithGradient(
+    const MatType& coordinates,
+    GradType& gradient,
+    std::false_type /* fused */) const
+{
+  return EvaluateWithGradient(coordinates, 0, gradient, NumFunctions());
+}
+
+template<typename ElemType>
+inline ElemType SphereFunction::ObjectiveKernel(const ElemType* x,
+                                                const size_t begin,
+                                                const size_t end)
+{
+  ElemType objective = 0;
+  ENS_PRAGMA_OMP_SIMD_SUM(objective)
+  for (size_t i = begin; i < end; ++i)
+    objective += x[i] * x[i];
+
+  return objective;
+}
+
 } // namespace test
 } // namespace ens
 
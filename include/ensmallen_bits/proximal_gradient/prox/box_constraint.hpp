@@ -0,0 +1,72 @@
+/**
+ * @file box_constraint.hpp
+ *
+ * Box constraints, for ProximalGradient and ProximalUpdate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROX_BOX_CONSTRAINT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROX_BOX_CONSTRAINT_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The constraint that each coordinate is in [lower, upper].  Its proximal
+ * operator is the projection onto the box, so that ProximalGradient becomes
+ * projected gradient descent.  Evaluate() returns 0: the coordinates are
+ * feasible after every step.  See L1Penalty for the interface of proximal
+ * operators.
+ */
+class BoxConstraint
+{
+ public:
+  /**
+   * Construct the box constraint.
+   *
+   * @param lower Lower bound of each coordinate.
+   * @param upper Upper bound of each coordinate.
+   */
+  BoxConstraint(const double lower = 0.0, const double upper = 1.0) :
+      lower(lower),
+      upper(upper)
+  { /* Nothing to do. */ }
+
+  //! Return the penalty of the given coordinates (0).
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& /* coordinates */) const
+  {
+    return 0;
+  }
+
+  //! Project the coordinates onto the box.
+  template<typename MatType>
+  void Prox(MatType& coordinates, const double /* stepSize */) const
+  {
+    Proximal::ProjectToBox(coordinates, lower, upper);
+  }
+
+  //! Get the lower bound.
+  double Lower() const { return lower; }
+  //! Modify the lower bound.
+  double& Lower() { return lower; }
+
+  //! Get the upper bound.
+  double Upper() const { return upper; }
+  //! Modify the upper bound.
+  double& Upper() { return upper; }
+
+ private:
+  //! Lower bound of each coordinate.
+  double lower;
+  //! Upper bound of each coordinate.
+  double upper;
+};
+
+} // namespace ens
+
+#endif
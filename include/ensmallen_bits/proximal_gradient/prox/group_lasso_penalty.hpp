@@ -0,0 +1,79 @@
+/**
+ * @file group_lasso_penalty.hpp
+ *
+ * The group lasso penalty, for ProximalGradient and ProximalUpdate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROX_GROUP_LASSO_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROX_GROUP_LASSO_PENALTY_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The group lasso penalty \f$ h(x) = \lambda \sum_g ||x_g||_2 \f$, which sets
+ * whole groups of coordinates to zero.  The groups are given as lists of
+ * indices, as for the GroupLpBall used by ConstrStructGroupSolver; they must
+ * not overlap, and coordinates that are in no group are not penalized.  See
+ * L1Penalty for the interface of proximal operators.
+ */
+class GroupLassoPenalty
+{
+ public:
+  /**
+   * Construct the group lasso penalty.
+   *
+   * @param lambda The weight of the penalty.
+   * @param groups Indices of the coordinates of each group.
+   */
+  GroupLassoPenalty(const double lambda,
+                    const std::vector<arma::uvec>& groups) :
+      lambda(lambda),
+      groups(groups)
+  { /* Nothing to do. */ }
+
+  //! Return the penalty of the given coordinates.
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const
+  {
+    typedef typename MatType::elem_type ElemType;
+
+    ElemType penalty = 0;
+    for (size_t g = 0; g < groups.size(); ++g)
+      penalty += arma::norm(coordinates.elem(groups[g]), 2);
+
+    return ElemType(lambda) * penalty;
+  }
+
+  //! Apply the proximal operator of the penalty with the given step size.
+  template<typename MatType>
+  void Prox(MatType& coordinates, const double stepSize) const
+  {
+    Proximal::GroupSoftThreshold(coordinates, stepSize * lambda, groups);
+  }
+
+  //! Get the weight of the penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the weight of the penalty.
+  double& Lambda() { return lambda; }
+
+  //! Get the groups.
+  const std::vector<arma::uvec>& Groups() const { return groups; }
+  //! Modify the groups.
+  std::vector<arma::uvec>& Groups() { return groups; }
+
+ private:
+  //! The weight of the penalty.
+  double lambda;
+  //! Indices of the coordinates of each group.
+  std::vector<arma::uvec> groups;
+};
+
+} // namespace ens
+
+#endif
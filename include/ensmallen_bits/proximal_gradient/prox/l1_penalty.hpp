@@ -0,0 +1,74 @@
+/**
+ * @file l1_penalty.hpp
+ *
+ * The l1 penalty, for ProximalGradient and ProximalUpdate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROX_L1_PENALTY_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROX_L1_PENALTY_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The l1 penalty \f$ h(x) = \lambda ||x||_1 \f$, whose proximal operator is
+ * soft thresholding; with it, ProximalGradient solves lasso problems.
+ *
+ * The proximal operators used by ProximalGradient and ProximalUpdate (the
+ * ProxType) must implement the following two methods:
+ *
+ * @code
+ * // Return the value h(x) of the non-smooth term.
+ * template<typename MatType>
+ * typename MatType::elem_type Evaluate(const MatType& coordinates) const;
+ *
+ * // Replace the coordinates v with
+ * //   argmin_x h(x) + ||x - v||^2 / (2 * stepSize).
+ * template<typename MatType>
+ * void Prox(MatType& coordinates, const double stepSize) const;
+ * @endcode
+ */
+class L1Penalty
+{
+ public:
+  /**
+   * Construct the l1 penalty.
+   *
+   * @param lambda The weight of the penalty.
+   */
+  L1Penalty(const double lambda = 0.01) : lambda(lambda)
+  { /* Nothing to do. */ }
+
+  //! Return the penalty of the given coordinates.
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& coordinates) const
+  {
+    return typename MatType::elem_type(lambda) *
+        arma::accu(arma::abs(coordinates));
+  }
+
+  //! Apply the proximal operator of the penalty with the given step size.
+  template<typename MatType>
+  void Prox(MatType& coordinates, const double stepSize) const
+  {
+    Proximal::SoftThreshold(coordinates, stepSize * lambda);
+  }
+
+  //! Get the weight of the penalty.
+  double Lambda() const { return lambda; }
+  //! Modify the weight of the penalty.
+  double& Lambda() { return lambda; }
+
+ private:
+  //! The weight of the penalty.
+  double lambda;
+};
+
+} // namespace ens
+
+#endif
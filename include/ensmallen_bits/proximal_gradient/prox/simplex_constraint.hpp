@@ -0,0 +1,62 @@
+/**
+ * @file simplex_constraint.hpp
+ *
+ * Simplex constraint, for ProximalGradient and ProximalUpdate.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROX_SIMPLEX_CONSTRAINT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROX_SIMPLEX_CONSTRAINT_HPP
+
+#include <ensmallen_bits/fw/proximal/proximal.hpp>
+
+namespace ens {
+
+/**
+ * The constraint that the coordinates are nonnegative and sum to the given
+ * radius (e.g. 1 for probability vectors).  Its proximal operator is the
+ * projection onto the simplex, which takes O(n) time in practice.  Evaluate()
+ * returns 0: the coordinates are feasible after every step.  See L1Penalty for
+ * the interface of proximal operators.
+ */
+class SimplexConstraint
+{
+ public:
+  /**
+   * Construct the simplex constraint.
+   *
+   * @param radius Sum of the coordinates.
+   */
+  SimplexConstraint(const double radius = 1.0) : radius(radius)
+  { /* Nothing to do. */ }
+
+  //! Return the penalty of the given coordinates (0).
+  template<typename MatType>
+  typename MatType::elem_type Evaluate(const MatType& /* coordinates */) const
+  {
+    return 0;
+  }
+
+  //! Project the coordinates onto the simplex.
+  template<typename MatType>
+  void Prox(MatType& coordinates, const double /* stepSize */) const
+  {
+    Proximal::ProjectToSimplex(coordinates, radius);
+  }
+
+  //! Get the sum of the coordinates.
+  double Radius() const { return radius; }
+  //! Modify the sum of the coordinates.
+  double& Radius() { return radius; }
+
+ private:
+  //! Sum of the coordinates.
+  double radius;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file proximal_gradient.hpp
+ *
+ * Proximal gradient descent and its accelerated variant (FISTA).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_HPP
+
+#include "prox/l1_penalty.hpp"
+#include "prox/group_lasso_penalty.hpp"
+#include "prox/box_constraint.hpp"
+#include "prox/simplex_constraint.hpp"
+
+namespace ens {
+
+/**
+ * Proximal gradient descent minimizes the sum \f$ F(x) = f(x) + h(x) \f$ of a
+ * differentiable function \f$ f \f$ and of a non-smooth function \f$ h \f$
+ * (e.g. an l1 penalty, or the indicator function of a constraint set) whose
+ * proximal operator is cheap, with the update
+ *
+ * \f[
+ * x_{j + 1} = \textrm{prox}_{\alpha h}(x_j - \alpha \nabla f(x_j)),
+ * \f]
+ *
+ * where \f$ \alpha \f$ is the step size, which should be at most \f$ 1 / L \f$
+ * for a gradient of \f$ f \f$ that is L-Lipschitz.  The proximal operator is
+ * given by the ProxType (see L1Penalty, GroupLassoPenalty, BoxConstraint and
+ * SimplexConstraint).
+ *
+ * If `accelerated` is true, this is FISTA: the gradient step is taken from an
+ * extrapolation of the last two iterates, which improves the convergence rate
+ * from O(1 / j) to O(1 / j^2); the momentum is reset whenever the objective
+ * increases.  Each accelerated iteration also evaluates f at the iterate,
+ * unless the line search already did.
+ *
+ * If `backtracking` is true, the step size is halved until the quadratic model
+ * of f at the point of the gradient step is an upper bound of f at the new
+ * iterate, so that the step size only needs to be an upper bound of 1 / L.
+ * The step size is kept for the next iterations.
+ *
+ * The optimization terminates when the objective F of an iterate is within the
+ * tolerance of the objective of the last iterate.
+ *
+ * @code
+ * @article{Beck2009,
+ *   author  = {Beck, Amir and Teboulle, Marc},
+ *   title   = {A Fast Iterative Shrinkage-Thresholding Algorithm for Linear
+ *              Inverse Problems},
+ *   journal = {SIAM Journal on Imaging Sciences},
+ *   volume  = {2},
+ *   number  = {1},
+ *   pages   = {183--202},
+ *   year    = {2009}
+ * }
+ * @endcode
+ *
+ * ProximalGradient can optimize differentiable functions, with the non-smooth
+ * term given by the ProxType.  For more details, see the documentation on
+ * function types included with this distribution or on the ensmallen website.
+ *
+ * @tparam ProxType The non-smooth term and its proximal operator.
+ */
+template<typename ProxType = L1Penalty>
+class ProximalGradientType
+{
+ public:
+  /**
+   * Construct the proximal gradient optimizer with the given parameters.
+   *
+   * @param prox The non-smooth term and its proximal operator.
+   * @param stepSize Step size for each iteration.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param accelerated If true, use the accelerated steps of FISTA.
+   * @param backtracking If true, decrease the step size with a backtracking
+   *     line search.
+   */
+  ProximalGradientType(const ProxType& prox = ProxType(),
+                       const double stepSize = 0.01,
+                       const size_t maxIterations = 100000,
+                       const double tolerance = 1e-10,
+                       const bool accelerated = false,
+                       const bool backtracking = false);
+
+  /**
+   * Optimize the given function with proximal gradient descent.  The given
+   * starting point will be modified to store the finishing point of the
+   * algorithm, and the final objective value (including the non-smooth term)
+   * is returned.
+   *
+   * @tparam FunctionType Type of the function to optimize.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsMatrixType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(FunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename FunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(FunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<FunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the proximal operator.
+  const ProxType& Prox() const { return prox; }
+  //! Modify the proximal operator.
+  ProxType& Prox() { return prox; }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the accelerated steps are used.
+  bool Accelerated() const { return accelerated; }
+  //! Modify whether or not the accelerated steps are used.
+  bool& Accelerated() { return accelerated; }
+
+  //! Get whether or not the backtracking line search is used.
+  bool Backtracking() const { return backtracking; }
+  //! Modify whether or not the backtracking line search is used.
+  bool& Backtracking() { return backtracking; }
+
+ private:
+  //! The non-smooth term and its proximal operator.
+  ProxType prox;
+
+  //! The step size for each iteration.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Whether or not the accelerated steps are used.
+  bool accelerated;
+
+  //! Whether or not the backtracking line search is used.
+  bool backtracking;
+};
+
+using ProximalGradient = ProximalGradientType<L1Penalty>;
+
+} // namespace ens
+
+#include "proximal_gradient_impl.hpp"
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file proximal_gradient_impl.hpp
+ *
+ * Implementation of proximal gradient descent and FISTA.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_IMPL_HPP
+#define ENSMALLEN_PROXIMAL_GRADIENT_PROXIMAL_GRADIENT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "proximal_gradient.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+//! Constructor.
+template<typename ProxType>
+ProximalGradientType<ProxType>::ProximalGradientType(
+    const ProxType& prox,
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool accelerated,
+    const bool backtracking) :
+    prox(prox),
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    accelerated(accelerated),
+    backtracking(backtracking)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename ProxType>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsMatrixType<GradType>::value,
+typename MatType::elem_type>::type
+ProximalGradientType<ProxType>::Optimize(FunctionType& function,
+                                         MatType& iterateIn,
+                                         CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Use the Function<> wrapper type to provide additional functionality.
+  typedef Function<FunctionType, BaseMatType, BaseGradType> FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have the methods that we need.
+  traits::CheckFunctionTypeAPI<FullFunctionType, BaseMatType, BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  // To keep track of where we are and how things are going.
+  ElemType overallObjective = std::numeric_limits<ElemType>::max();
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+
+  // The last iterate, the extrapolated point of the accelerated steps, and the
+  // step of the line search.  Their memory is reused by every iteration.
+  BaseMatType lastIterate(iterate.n_rows, iterate.n_cols);
+  BaseMatType extrapolated;
+  BaseMatType difference;
+  if (accelerated)
+    extrapolated = iterate;
+
+  // The value of f at the iterate, if the line search has computed it.
+  ElemType smoothObjective = 0;
+  bool knownObjective = false;
+
+  double t = 1.0;
+  double step = stepSize;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  // Now iterate!
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  for (size_t i = 1; i != maxIterations && !terminate; ++i)
+  {
+    // Without acceleration, the gradient step is taken from the iterate.
+    const BaseMatType& point = accelerated ? extrapolated : iterate;
+    const ElemType pointObjective = f.EvaluateWithGradient(point, gradient);
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, point,
+        pointObjective, gradient, callbacks...);
+
+    if (!accelerated)
+      smoothObjective = pointObjective;
+    else if (!knownObjective)
+      smoothObjective = f.Evaluate(iterate);
+    knownObjective = false;
+
+    overallObjective = smoothObjective + prox.Evaluate(iterate);
+
+    // Output current objective function.
+    Info << "Proximal Gradient: iteration " << i << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Warn << "Proximal Gradient: converged to " << overallObjective
+          << "; terminating" << " with failure.  Try a smaller step size?"
+          << std::endl;
+
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Info << "Proximal Gradient: minimized within tolerance "
+          << tolerance << "; " << "terminating optimization." << std::endl;
+
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
+      return overallObjective;
+    }
+
+    // Reset the momentum if the objective increased.
+    if (accelerated && overallObjective > lastObjective)
+      t = 1.0;
+
+    lastObjective = overallObjective;
+
+    // Take the proximal gradient step from the point, which is the last
+    // iterate without acceleration.
+    lastIterate = iterate;
+    const BaseMatType& from = accelerated ? extrapolated : lastIterate;
+    for (size_t k = 0; ; ++k)
+    {
+      iterate = from - step * gradient;
+      prox.Prox(iterate, step);
+
+      // Halve the step size (at most 50 times) until the quadratic model of f
+      // at the point bounds f at the new iterate.
+      if (!backtracking || k == 50)
+        break;
+
+      difference = iterate - from;
+      smoothObjective = f.Evaluate(iterate);
+      if (smoothObjective <= pointObjective + arma::dot(gradient, difference) +
+          arma::dot(difference, difference) / (2 * step))
+      {
+        knownObjective = true;
+        break;
+      }
+
+      step *= 0.5;
+    }
+
+    if (accelerated)
+    {
+      // The next point is x_j + (t_j - 1) / t_{j + 1} (x_j - x_{j - 1}).
+      const double nextT = (1 + std::sqrt(1 + 4 * t * t)) / 2;
+      extrapolated = iterate - lastIterate;
+      extrapolated *= (t - 1) / nextT;
+      extrapolated += iterate;
+      t = nextT;
+    }
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+  }
+
+  Info << "Proximal Gradient: maximum iterations (" << maxIterations
+      << ") reached; " << "terminating optimization." << std::endl;
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
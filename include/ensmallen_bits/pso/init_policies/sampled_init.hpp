@@ -0,0 +1,149 @@
+/**
+ * @file sampled_init.hpp
+ *
+ * An initialization policy for the PSO optimizer that samples the particle
+ * positions with a sampling policy.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_PSO_INIT_POLICIES_SAMPLED_INIT_HPP
+#define ENSMALLEN_PSO_INIT_POLICIES_SAMPLED_INIT_HPP
+#include <assert.h>
+
+namespace ens {
+
+/**
+ * An initialization policy for the PSO optimizer that draws the particle
+ * positions in [lowerBound, upperBound] (by default [-1, 1]) with the given
+ * sampling policy, for the whole swarm at once; the velocities are drawn
+ * uniformly in [0, 1], the personal bests of the particles are set to the
+ * initial positions, and all fitness values to
+ * std::numeric_limits<double>::max().  With a low-discrepancy sampling policy
+ * (e.g. SobolSampling or LatinHypercubeSampling), the swarm covers the bounds
+ * more evenly than with independent uniform positions (UniformSampling, see
+ * DefaultInit), so fewer particles are needed for the same coverage.
+ *
+ * @tparam SamplingType Sampling policy of the positions.
+ */
+template<typename SamplingType = UniformSampling>
+class SampledInit
+{
+ public:
+  /**
+   * Construct the policy with the given sampling policy.
+   *
+   * @param sampling Sampling policy of the positions.
+   */
+  SampledInit(const SamplingType& sampling = SamplingType()) :
+      sampling(sampling)
+  {
+    /* Nothing to do.*/
+  }
+
+  //! Get the sampling policy of the positions.
+  const SamplingType& Sampling() const { return sampling; }
+  //! Modify the sampling policy of the positions.
+  SamplingType& Sampling() { return sampling; }
+
+  /**
+   * The InitializeParticles method of the init policy. Any class that is used
+   * in place of this default must implement this method which is used by the
+   * optimizer.
+   *
+   * @param iterate Coordinates of the initial point for training.
+   * @param numParticles The number of particles in the swarm.
+   * @param lowerBound Lower bound of the position initialization range.
+   * @param upperBound Upper bound of the position initialization range.
+   * @param particlePositions Current positions of particles.
+   * @param particleVelocities Current velocities of particles.
+   * @param particleFitnesses Current fitness values of particles.
+   * @param particleBestPositions Best positions attained by each particle.
+   * @param particleBestFitnesses Best fitness values attained by each particle.
+   */
+  template<typename MatType,
+           typename BoundMatType,
+           typename VecType,
+           typename CubeType>
+  void Initialize(const MatType& iterate,
+                  const size_t numParticles,
+                  BoundMatType& lowerBound,
+                  BoundMatType& upperBound,
+                  CubeType& particlePositions,
+                  CubeType& particleVelocities,
+                  VecType& particleFitnesses,
+                  CubeType& particleBestPositions,
+                  VecType& particleBestFitnesses)
+  {
+    // Convenience typedef.
+    typedef typename MatType::elem_type ElemType;
+    typedef typename CubeType::elem_type CubeElemType;
+
+    // All the random numbers of the initialization are drawn from this
+    // stream.
+    RandomStream rng;
+
+    // Initialize the particle positions in [0, 1) with the sampling policy;
+    // the slices of the cube are contiguous, so the whole swarm is sampled at
+    // once as a matrix with one particle per column.
+    particlePositions.set_size(iterate.n_rows, iterate.n_cols, numParticles);
+    arma::Mat<CubeElemType> positions(particlePositions.memptr(),
+        iterate.n_elem, numParticles, false, true);
+    sampling.Fill(positions, rng);
+
+    // Check if lowerBound is equal to upperBound. If equal, reinitialize.
+    arma::umat lbEquality = (lowerBound == upperBound);
+    if (lbEquality.n_rows == 1 && lbEquality(0, 0) == 1)
+    {
+      lowerBound.set_size(iterate.n_rows, iterate.n_cols);
+      lowerBound.fill(-1.0);
+
+      upperBound.set_size(iterate.n_rows, iterate.n_cols);
+      upperBound.fill(1.0);
+    }
+    // Check if lowerBound and upperBound are vectors of a single dimension.
+    else if (lbEquality.n_rows == 1 && lbEquality(0, 0) == 0)
+    {
+      lowerBound = -lowerBound(0) * arma::ones(iterate.n_rows, iterate.n_cols);
+      upperBound = upperBound(0) * arma::ones(iterate.n_rows, iterate.n_cols);
+    }
+
+    // Check the dimensions of lowerBound and upperBound.
+    assert(lowerBound.n_rows == iterate.n_rows && "The dimensions of "
+        "lowerBound are not the same as the dimensions of iterate.");
+    assert(upperBound.n_rows == iterate.n_rows && "The dimensions of "
+        "upperBound are not the same as the dimensions of iterate.");
+
+    // Distribute particles in [lowerBound, upperBound].
+    for (size_t i = 0; i < numParticles; i++)
+    {
+      particlePositions.slice(i) = particlePositions.slice(i) %
+          arma::conv_to<arma::Mat<CubeElemType> >::from(upperBound - lowerBound)
+          + arma::conv_to<arma::Mat<CubeElemType> >::from(lowerBound);
+    }
+
+    // Randomly initialize particle velocities.
+    particleVelocities.set_size(iterate.n_rows, iterate.n_cols, numParticles);
+    rng.FillUniform(particleVelocities);
+
+    // Initialize current fitness values to infinity.
+    particleFitnesses.set_size(numParticles);
+    particleFitnesses.fill(std::numeric_limits<ElemType>::max());
+
+    // Copy to personal best values for first iteration.
+    particleBestPositions = particlePositions;
+    // Initialize personal best fitness values to infinity.
+    particleBestFitnesses.set_size(numParticles);
+    particleBestFitnesses.fill(std::numeric_limits<ElemType>::max());
+  }
+
+ private:
+  //! The sampling policy of the positions.
+  SamplingType sampling;
+};
+
+} // ens
+
+#endif
@@ -18,6 +18,28 @@
 
 namespace ens {
 
+namespace traits {
+
+//! Detect an UpdateParticle() method of a velocity update policy, which the
+//! steady-state PSO needs.
+template<typename PolicyType, typename ElemType>
+struct HasUpdateParticle
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().UpdateParticle(
+      size_t(0), std::declval<arma::Cube<ElemType>&>(),
+      std::declval<arma::Cube<ElemType>&>(),
+      std::declval<arma::Cube<ElemType>&>(),
+      std::declval<arma::Col<ElemType>&>()), std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+} // namespace traits
+
 /**
  * Particle Swarm Optimization (PSO) is an evolutionary approach to optimization
  * that is inspired by flocks or birds or fishes. The fundamental analogy is
@@ -60,6 +82,22 @@ namespace ens {
  *
  *    double Evaluate(const arma::mat& x);
  *
+ * If ParallelEvaluation() is set to true (and OpenMP is enabled), the fitness
+ * of the particles is computed on multiple threads, so Evaluate() must be safe
+ * to call concurrently.  This has no effect if the function has an
+ * EvaluateBatch() method.
+ *
+ * If AsyncEvaluation() is set to true, PSO is steady-state instead: as many
+ * particles as there are workers are evaluated at once (see AsyncEvaluator),
+ * and as soon as the evaluation of a particle is done, its personal best is
+ * updated, and it is moved with the current personal bests of its neighbours
+ * and evaluated again, so the workers are kept busy when the evaluation times
+ * vary.  The budget is still maxIterations times numParticles evaluations, and
+ * the improvement over the horizon is checked after each numParticles
+ * evaluations.  This needs a velocity update policy with an UpdateParticle()
+ * method (as LBestUpdate has), and Evaluate() must be safe to call
+ * concurrently, unless the function has EvaluateAsync().
+ *
  * @tparam VelocityUpdatePolicy Velocity update policy. By default LBest update
  *     policy (see ens::LBestUpdate) is used.
  * @tparam InitPolicy Particle initialization policy. By default DefaultInit
@@ -107,7 +145,9 @@ class PSOType
           exploitationFactor(exploitationFactor),
           explorationFactor(explorationFactor),
           velocityUpdatePolicy(velocityUpdatePolicy),
-          initPolicy(initPolicy)
+          initPolicy(initPolicy),
+          parallelEvaluation(false),
+          asyncEvaluation(false)
   { /* Nothing to do. */ }
 
   /**
@@ -153,7 +193,9 @@ class PSOType
           exploitationFactor(exploitationFactor),
           explorationFactor(explorationFactor),
           velocityUpdatePolicy(velocityUpdatePolicy),
-          initPolicy(initPolicy)
+          initPolicy(initPolicy),
+          parallelEvaluation(false),
+          asyncEvaluation(false)
   { /* Nothing to do. */ }
 
   /**
@@ -225,6 +267,16 @@ class PSOType
   //! Modify the update policy.
   VelocityUpdatePolicy& UpdatePolicy() { return velocityUpdatePolicy; }
 
+  //! Get whether or not the particles are evaluated in parallel.
+  bool ParallelEvaluation() const { return parallelEvaluation; }
+  //! Modify whether or not the particles are evaluated in parallel.
+  bool& ParallelEvaluation() { return parallelEvaluation; }
+
+  //! Get whether or not the swarm is steady-state and asynchronous.
+  bool AsyncEvaluation() const { return asyncEvaluation; }
+  //! Modify whether or not the swarm is steady-state and asynchronous.
+  bool& AsyncEvaluation() { return asyncEvaluation; }
+
   //! Get the instantiated update policy type.  Be sure to check its type with
   //! Has() before using!
   const Any& InstUpdatePolicy() const { return instUpdatePolicy; }
@@ -233,6 +285,52 @@ class PSOType
   Any& InstUpdatePolicy() { return instUpdatePolicy; }
 
  private:
+  /**
+   * Run the steady-state PSO from the evaluated initial swarm, and return the
+   * index of the best particle.
+   */
+  template<typename ArbitraryFunctionType,
+           typename InstUpdatePolicyType,
+           typename ElemType,
+           typename... CallbackTypes>
+  size_t OptimizeAsync(ArbitraryFunctionType& function,
+                       InstUpdatePolicyType& policy,
+                       arma::Cube<ElemType>& particlePositions,
+                       arma::Cube<ElemType>& particleVelocities,
+                       arma::Cube<ElemType>& particleBestPositions,
+                       arma::Col<ElemType>& particleBestFitnesses,
+                       ElemType& bestFitness,
+                       bool& terminate,
+                       CallbackTypes&... callbacks);
+
+  //! Update the velocity of one particle with the update policy.
+  template<typename InstUpdatePolicyType, typename ElemType>
+  static void UpdateParticle(InstUpdatePolicyType& policy,
+                             const size_t i,
+                             arma::Cube<ElemType>& particlePositions,
+                             arma::Cube<ElemType>& particleVelocities,
+                             arma::Cube<ElemType>& particleBestPositions,
+                             arma::Col<ElemType>& particleBestFitnesses,
+                             const std::true_type /* hasUpdateParticle */)
+  {
+    policy.UpdateParticle(i, particlePositions, particleVelocities,
+        particleBestPositions, particleBestFitnesses);
+  }
+
+  //! The update policy can't move a single particle.
+  template<typename InstUpdatePolicyType, typename ElemType>
+  static void UpdateParticle(InstUpdatePolicyType& /* policy */,
+                             const size_t /* i */,
+                             arma::Cube<ElemType>& /* particlePositions */,
+                             arma::Cube<ElemType>& /* particleVelocities */,
+                             arma::Cube<ElemType>& /* particleBestPositions */,
+                             arma::Col<ElemType>& /* particleBestFitnesses */,
+                             const std::false_type /* hasUpdateParticle */)
+  {
+    throw std::logic_error("PSO::Optimize(): AsyncEvaluation() requires a "
+        "velocity update policy with an UpdateParticle() method.");
+  }
+
   //! Number of particles in the swarm.
   size_t numParticles;
 
@@ -262,6 +360,12 @@ class PSOType
   //! Particle initialization policy used.
   InitPolicy initPolicy;
 
+  //! Whether or not the particles are evaluated in parallel.
+  bool parallelEvaluation;
+
+  //! Whether or not the swarm is steady-state and asynchronous.
+  bool asyncEvaluation;
+
   //! The initialized update policy.
   Any instUpdatePolicy;
 };
@@ -15,6 +15,7 @@
 
 #include "pso.hpp"
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/evaluate_batch.hpp>
 #include <queue>
 
 namespace ens {
@@ -63,11 +64,7 @@ typename MatType::elem_type PSOType<VelocityUpdatePolicy, InitPolicy>::Optimize(
   bool terminate = false;
 
   if (!instUpdatePolicy.Has<InstUpdatePolicyType>())
-  {
-    instUpdatePolicy.Clean();
-    instUpdatePolicy.Set<InstUpdatePolicyType>(
-        new InstUpdatePolicyType(velocityUpdatePolicy));
-  }
+    instUpdatePolicy.Emplace<InstUpdatePolicyType>(velocityUpdatePolicy);
 
   // Initialize helper variables.
   arma::Cube<ElemType> particlePositions;
@@ -95,11 +92,22 @@ typename MatType::elem_type PSOType<VelocityUpdatePolicy, InitPolicy>::Optimize(
       callbacks...);
 
   // Calculate initial fitness of population.
-  for (size_t i = 0; i < numParticles; i++)
+  EvaluateBatch(function, particlePositions, particleFitnesses,
+      parallelEvaluation);
+  particleBestFitnesses = particleFitnesses;
+
+  if (asyncEvaluation)
   {
-    // Calculate fitness value.
-    particleFitnesses(i) = function.Evaluate(particlePositions.slice(i));
-    particleBestFitnesses(i) = particleFitnesses(i);
+    ElemType bestFitness = std::numeric_limits<ElemType>::max();
+    const size_t bestParticle = OptimizeAsync(function,
+        instUpdatePolicy.As<InstUpdatePolicyType>(), particlePositions,
+        particleVelocities, particleBestPositions, particleBestFitnesses,
+        bestFitness, terminate, callbacks...);
+
+    iterate = particleBestPositions.slice(bestParticle);
+
+    Callback::EndOptimization(*this, function, iterate, callbacks...);
+    return bestFitness;
   }
 
   // Declare queue to keep track of improvements over a number of iterations.
@@ -118,9 +126,10 @@ typename MatType::elem_type PSOType<VelocityUpdatePolicy, InitPolicy>::Optimize(
   for (size_t i = 0; i < horizonSize; i++)
   {
     // Calculate fitness and evaluate personal best.
+    EvaluateBatch(function, particlePositions, particleFitnesses,
+        parallelEvaluation);
     for (size_t j = 0; j < numParticles; j++)
     {
-      particleFitnesses(j) = function.Evaluate(particlePositions.slice(j));
       Callback::Evaluate(*this, function, particlePositions.slice(j),
           particleFitnesses(j), callbacks...);
 
@@ -166,9 +175,10 @@ typename MatType::elem_type PSOType<VelocityUpdatePolicy, InitPolicy>::Optimize(
       break;
 
     // Calculate fitness and evaluate personal best.
+    EvaluateBatch(function, particlePositions, particleFitnesses,
+        parallelEvaluation);
     for (size_t j = 0; j < numParticles; j++)
     {
-      particleFitnesses(j) = function.Evaluate(particlePositions.slice(j));
       Callback::Evaluate(*this, function, particlePositions.slice(j),
           particleFitnesses(j), callbacks...);
 
@@ -214,6 +224,101 @@ typename MatType::elem_type PSOType<VelocityUpdatePolicy, InitPolicy>::Optimize(
   return bestFitness;
 }
 
+//! Run the steady-state PSO.
+template<typename VelocityUpdatePolicy,
+         typename InitPolicy>
+template<typename ArbitraryFunctionType,
+         typename InstUpdatePolicyType,
+         typename ElemType,
+         typename... CallbackTypes>
+size_t PSOType<VelocityUpdatePolicy, InitPolicy>::OptimizeAsync(
+    ArbitraryFunctionType& function,
+    InstUpdatePolicyType& policy,
+    arma::Cube<ElemType>& particlePositions,
+    arma::Cube<ElemType>& particleVelocities,
+    arma::Cube<ElemType>& particleBestPositions,
+    arma::Col<ElemType>& particleBestFitnesses,
+    ElemType& bestFitness,
+    bool& terminate,
+    CallbackTypes&... callbacks)
+{
+  typedef arma::Mat<ElemType> BaseMatType;
+  typedef std::integral_constant<bool, traits::HasUpdateParticle<
+      InstUpdatePolicyType, ElemType>::value> HasUpdateParticleType;
+
+  size_t bestParticle = particleBestFitnesses.index_min();
+  bestFitness = particleBestFitnesses(bestParticle);
+
+  // Move the whole swarm once; then the particles are moved one at a time.
+  policy.Update(particlePositions, particleVelocities, particleBestPositions,
+      particleBestFitnesses);
+  particlePositions += particleVelocities;
+
+  AsyncEvaluator<ArbitraryFunctionType, BaseMatType> evaluator(function);
+  const size_t slots = std::min(evaluator.Concurrency(), numParticles);
+  const size_t budget = maxIterations * numParticles;
+  std::queue<size_t> ready;
+  for (size_t j = 0; j < numParticles; j++)
+    ready.push(j);
+
+  std::queue<ElemType> performanceHorizon;
+  size_t submitted = 0, completed = 0;
+  while (completed < budget && !terminate)
+  {
+    while (evaluator.Pending() < slots && !ready.empty() && submitted < budget)
+    {
+      evaluator.Submit(ready.front(), particlePositions.slice(ready.front()));
+      ready.pop();
+      ++submitted;
+    }
+
+    ElemType fitness;
+    const size_t j = evaluator.WaitAny(fitness);
+    ++completed;
+    Callback::Evaluate(*this, function, particlePositions.slice(j), fitness,
+        callbacks...);
+
+    // Compare and copy fitness and position to particle best.
+    if (fitness < particleBestFitnesses(j))
+    {
+      particleBestFitnesses(j) = fitness;
+      particleBestPositions.slice(j) = particlePositions.slice(j);
+      if (fitness < bestFitness)
+      {
+        bestParticle = j;
+        bestFitness = fitness;
+      }
+    }
+
+    // Move the particle with the current bests of its neighbours.
+    UpdateParticle(policy, j, particlePositions, particleVelocities,
+        particleBestPositions, particleBestFitnesses, HasUpdateParticleType());
+    particlePositions.slice(j) += particleVelocities.slice(j);
+    ready.push(j);
+
+    // After each numParticles evaluations, check the improvement over the
+    // horizon.
+    if (completed % numParticles == 0)
+    {
+      terminate |= Callback::StepTaken(*this, function,
+          particleBestPositions.slice(bestParticle), callbacks...);
+
+      performanceHorizon.push(bestFitness);
+      if (performanceHorizon.size() > horizonSize)
+      {
+        performanceHorizon.pop();
+        if (performanceHorizon.front() - performanceHorizon.back() <
+            impTolerance)
+        {
+          break;
+        }
+      }
+    }
+  }
+
+  return bestParticle;
+}
+
 } // ens
 
 #endif
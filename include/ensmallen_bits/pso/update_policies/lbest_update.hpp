@@ -97,26 +97,30 @@ class LBestUpdate
        c2 = explorationFactor;
 
        // Calculate the constriction factor
-       static double phi = c1 + c2;
+       const double phi = c1 + c2;
        assert(phi > 4.0 && "The sum of the exploitation and exploration "
            "factors must be greater than 4.");
 
        chi = 2.0 / std::abs(2.0 - phi - std::sqrt((phi - 4.0) * phi));
 
        // Initialize local best indices to self indices of particles.
-       localBestIndices = arma::linspace<
-           arma::Col<typename MatType::elem_type> >(0, n-1, n);
+       localBestIndices = arma::linspace<arma::uvec>(0, n - 1, n);
 
-       // Set sizes r1 and r2.
-       r1.set_size(iterate.n_rows, iterate.n_cols);
-       r2.set_size(iterate.n_rows, iterate.n_cols);
+       // Set sizes r1 and r2; they hold the random numbers for the whole
+       // swarm.
+       r1.set_size(iterate.n_rows, iterate.n_cols, n);
+       r2.set_size(iterate.n_rows, iterate.n_cols, n);
+
+       // The random numbers of this optimization are drawn from a new stream.
+       rng = RandomStream();
      }
 
      /**
       * Update step for LBestPSO. Compares personal best of each particle with
       * that of its neighbours, and sets the best of the 3 as the lobal best.
       * This particle is then used for calculating the velocity for the update
-      * step.
+      * step.  The velocities of the whole swarm are updated in a single pass
+      * over the contiguous memory of the cubes.
       *
       * @param particlePositions The current coordinates of particles.
       * @param particleVelocities The current velocities (will be modified).
@@ -130,31 +134,92 @@ class LBestUpdate
                  arma::Cube<typename MatType::elem_type>& particleBestPositions,
                  arma::Col<typename MatType::elem_type>& particleBestFitnesses)
      {
-       // Velocity update logic.
+       // Find the best of each particle and its two neighbours.
        for (size_t i = 0; i < n; i++)
        {
-         localBestIndices(i) =
-             particleBestFitnesses(left(i)) < particleBestFitnesses(i) ?
-             left(i) : i;
-         localBestIndices(i) =
-             particleBestFitnesses(right(i)) < particleBestFitnesses(i) ?
-             right(i) : i;
+         size_t best = i;
+         if (particleBestFitnesses(left(i)) < particleBestFitnesses(best))
+           best = left(i);
+         if (particleBestFitnesses(right(i)) < particleBestFitnesses(best))
+           best = right(i);
+         localBestIndices(i) = best;
        }
 
+       // Generate random numbers for all particles.
+       rng.FillUniform(r1);
+       rng.FillUniform(r2);
+
        for (size_t i = 0; i < n; i++)
        {
-         // Generate random numbers for current particle.
-         r1.randu();
-         r2.randu();
-         particleVelocities.slice(i) = chi * (particleVelocities.slice(i) +
-             c1 * r1 % (particleBestPositions.slice(i) -
-             particlePositions.slice(i)) + c2 * r2 %
-             (particleBestPositions.slice(localBestIndices(i)) -
-             particlePositions.slice(i)));
+         UpdateVelocity(i, particlePositions, particleVelocities,
+             particleBestPositions);
        }
      }
 
+     /**
+      * Update the velocity of a single particle from the current personal
+      * bests of the swarm, for the steady-state (asynchronous) PSO, which
+      * moves each particle as soon as its evaluation is done.
+      *
+      * @param i Index of the particle.
+      * @param particlePositions The current coordinates of particles.
+      * @param particleVelocities The current velocities (will be modified).
+      * @param particleBestPositions The personal best coordinates of particles.
+      * @param particleBestFitnesses The personal best fitness values of
+      *     particles.
+      */
+     void UpdateParticle(
+         const size_t i,
+         arma::Cube<typename MatType::elem_type>& particlePositions,
+         arma::Cube<typename MatType::elem_type>& particleVelocities,
+         arma::Cube<typename MatType::elem_type>& particleBestPositions,
+         arma::Col<typename MatType::elem_type>& particleBestFitnesses)
+     {
+       size_t best = i;
+       if (particleBestFitnesses(left(i)) < particleBestFitnesses(best))
+         best = left(i);
+       if (particleBestFitnesses(right(i)) < particleBestFitnesses(best))
+         best = right(i);
+       localBestIndices(i) = best;
+
+       rng.FillUniform(r1.slice(i));
+       rng.FillUniform(r2.slice(i));
+       UpdateVelocity(i, particlePositions, particleVelocities,
+           particleBestPositions);
+     }
+
     private:
+     //! Update the velocity of the given particle from its local best and the
+     //! random numbers in r1 and r2.
+     void UpdateVelocity(
+         const size_t i,
+         const arma::Cube<typename MatType::elem_type>& particlePositions,
+         arma::Cube<typename MatType::elem_type>& particleVelocities,
+         const arma::Cube<typename MatType::elem_type>& particleBestPositions)
+     {
+       typedef typename MatType::elem_type ElemType;
+
+       const size_t elements = particleVelocities.n_rows *
+           particleVelocities.n_cols;
+       const size_t offset = i * elements;
+       ElemType* velocities = particleVelocities.memptr() + offset;
+       const ElemType* positions = particlePositions.memptr() + offset;
+       const ElemType* bestPositions = particleBestPositions.memptr() + offset;
+       const ElemType* localBest = particleBestPositions.memptr() +
+           localBestIndices(i) * elements;
+       const ElemType* rand1 = r1.memptr() + offset;
+       const ElemType* rand2 = r2.memptr() + offset;
+
+       ENS_PRAGMA_OMP_SIMD
+       for (size_t k = 0; k < elements; k++)
+       {
+         const ElemType position = positions[k];
+         velocities[k] = chi * (velocities[k] + c1 * rand1[k] *
+             (bestPositions[k] - position) + c2 * rand2[k] *
+             (localBest[k] - position));
+       }
+     }
+
      //! Number of particles.
      size_t n;
 
@@ -167,11 +232,14 @@ class LBestUpdate
      //! Constriction factor chi.
      typename MatType::elem_type chi;
 
-     //! Vectors of random numbers.
-     MatType r1, r2;
+     //! Random numbers for the whole swarm.
+     arma::Cube<typename MatType::elem_type> r1, r2;
+
+     //! The stream that the random numbers are drawn from.
+     RandomStream rng;
 
      //! Indices of each particle's best neighbour.
-     arma::Col<typename MatType::elem_type> localBestIndices;
+     arma::uvec localBestIndices;
 
      // Helper functions for calculating neighbours.
     inline size_t left(size_t index) { return (index + n - 1) % n; }
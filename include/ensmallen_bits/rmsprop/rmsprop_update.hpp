@@ -15,6 +15,8 @@
 #ifndef ENSMALLEN_RMSPROP_RMSPROP_UPDATE_HPP
 #define ENSMALLEN_RMSPROP_RMSPROP_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -66,6 +68,12 @@ class RMSPropUpdate
   //! Modify the smoothing parameter.
   double& Alpha() { return alpha; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the moving average of the squared gradients.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -101,6 +109,57 @@ class RMSPropUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the mean squared gradient, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(meanSquaredGradient);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType alpha = ElemType(parent.alpha);
+      const ElemType oneMinusAlpha = ElemType(1 - parent.alpha);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* msg = meanSquaredGradient.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType si = alpha * msg[i] + oneMinusAlpha * (gi * gi);
+          msg[i] = si;
+          x[i] -= a * gi / (std::sqrt(si) + eps);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* fused */)
     {
       meanSquaredGradient *= parent.alpha;
       meanSquaredGradient += (1 - parent.alpha) * (gradient % gradient);
@@ -108,7 +167,6 @@ class RMSPropUpdate
           parent.epsilon);
     }
 
-   private:
     // Leaky sum of squares of parameter gradient.
     GradType meanSquaredGradient;
     // Reference to instantiated parent object.
@@ -38,6 +38,33 @@ namespace ens {
  * The system is considered "frozen" when its score fails to change more then
  * tolerance for maxToleranceSweep consecutive sweeps.
  *
+ * If Chains() is set to a value K greater than 1, SA runs in parallel tempering
+ * (replica exchange) mode: K chains are run at a ladder of temperatures, where
+ * chain k starts at temperature initT * TemperatureRatio()^k and is cooled with
+ * its own copy of the cooling schedule.  The chains run on separate threads
+ * (if OpenMP is enabled), so the function's Evaluate() must be safe to call
+ * concurrently.  Every SwapInterval() moves, the states of neighboring chains
+ * are swapped with probability
+ * min{1, exp((1 / T_k - 1 / T_{k + 1}) (E_k - E_{k + 1}))}, so that good states
+ * found by the hot chains move to the cold ones.  Callbacks are only called
+ * between swaps, with the state of the coldest chain; the system is frozen when
+ * the coldest chain is, and the best final state of all chains is returned.
+ *
+ * If BatchedSweeps() is true, the moves are made one sweep (or the rest of a
+ * sweep) at a time: the random numbers for all the proposals and all the
+ * acceptance tests of the sweep are drawn together, the Laplace moves are
+ * computed in one vectorized pass, and the Metropolis criterion is tested
+ * against precomputed thresholds, without an exp() per move.  The moves are
+ * still accepted or rejected one after the other, so any objective can be
+ * used; callbacks are then called once per sweep instead of once per move.  If
+ * SeparableSweeps() is also true and the function has an EvaluateDelta()
+ * method (see EvaluateMove()), the changes of the objective of all the moves
+ * of a sweep are computed in parallel, for the iterate at the start of the
+ * sweep.  This is only correct if the objective is a sum of functions of one
+ * coordinate each, since then the change for a coordinate doesn't depend on
+ * the moves of the others; EvaluateDelta() must then be safe to call
+ * concurrently.
+ *
  * SA can optimize arbitrary functions.  For more details, see the documentation
  * on function types included with this distribution or on the ensmallen
  * website.
@@ -142,6 +169,31 @@ class SA
   //! Modify the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the number of parallel tempering chains.
+  size_t Chains() const { return chains; }
+  //! Modify the number of parallel tempering chains.
+  size_t& Chains() { return chains; }
+
+  //! Get the ratio between the temperatures of neighboring chains.
+  double TemperatureRatio() const { return temperatureRatio; }
+  //! Modify the ratio between the temperatures of neighboring chains.
+  double& TemperatureRatio() { return temperatureRatio; }
+
+  //! Get the number of moves of each chain between swaps.
+  size_t SwapInterval() const { return swapInterval; }
+  //! Modify the number of moves of each chain between swaps.
+  size_t& SwapInterval() { return swapInterval; }
+
+  //! Get whether the moves are made one sweep at a time.
+  bool BatchedSweeps() const { return batchedSweeps; }
+  //! Modify whether the moves are made one sweep at a time.
+  bool& BatchedSweeps() { return batchedSweeps; }
+
+  //! Get whether the moves of a sweep are evaluated in parallel.
+  bool SeparableSweeps() const { return separableSweeps; }
+  //! Modify whether the moves of a sweep are evaluated in parallel.
+  bool& SeparableSweeps() { return separableSweeps; }
+
  private:
   //! The cooling schedule being used.
   CoolingScheduleType coolingSchedule;
@@ -163,6 +215,74 @@ class SA
   double initMoveCoef;
   //! Proportional control in feedback move control.
   double gain;
+  //! Number of parallel tempering chains.
+  size_t chains;
+  //! Ratio between the temperatures of neighboring chains.
+  double temperatureRatio;
+  //! Number of moves of each chain between swaps.
+  size_t swapInterval;
+  //! Whether the moves are made one sweep at a time.
+  bool batchedSweeps;
+  //! Whether the moves of a sweep are evaluated in parallel.
+  bool separableSweeps;
+
+  /**
+   * The buffers used by GenerateMoves(), which are kept between sweeps.
+   */
+  template<typename MatType>
+  struct SweepWorkspace
+  {
+    //! The moves of the sweep.
+    MatType moves;
+    //! The acceptance thresholds of the moves, -log(xi).
+    MatType thresholds;
+    //! The changes of the objective, when they are computed in parallel.
+    MatType deltas;
+  };
+
+  /**
+   * The state of one chain in parallel tempering mode.
+   */
+  template<typename MatType>
+  struct Chain
+  {
+    //! Current position of the chain.
+    MatType iterate;
+    //! Which parameters have had accepted moves.
+    MatType accept;
+    //! Strides for a move.
+    MatType moveSize;
+    //! Current energy of the chain.
+    typename MatType::elem_type energy;
+    //! Current temperature of the chain.
+    double temperature;
+    //! The cooling schedule of the chain.
+    CoolingScheduleType coolingSchedule;
+    //! Current parameter to modify.
+    size_t idx;
+    //! Number of sweeps since the last MoveControl() call.
+    size_t sweepCounter;
+    //! Number of consecutive moves within tolerance.
+    size_t frozenCount;
+    //! The buffers of the batched sweeps of the chain.
+    SweepWorkspace<MatType> workspace;
+    //! The random number stream of the chain.
+    RandomStream rng;
+  };
+
+  /**
+   * Optimize the given function with parallel tempering, using the given
+   * number of chains.
+   *
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename FunctionType, typename MatType, typename... CallbackTypes>
+  typename MatType::elem_type ParallelTempering(FunctionType& function,
+                                                MatType& iterate,
+                                                CallbackTypes&... callbacks);
 
   /**
    * GenerateMove proposes a move on element iterate(idx), and determines if
@@ -179,6 +299,8 @@ class SA
    * @param idx Current parameter to modify.
    * @param sweepCounter Current counter representing how many sweeps have been
    *      completed.
+   * @param currentTemperature Temperature for the Metropolis criterion.
+   * @param rng Random number stream to draw the move from.
    */
   template<typename FunctionType, typename MatType, typename... CallbackTypes>
   void GenerateMove(FunctionType& function,
@@ -188,8 +310,69 @@ class SA
                     typename MatType::elem_type& energy,
                     size_t& idx,
                     size_t& sweepCounter,
+                    const double currentTemperature,
+                    RandomStream& rng,
                     CallbackTypes&... callbacks);
 
+  /**
+   * GenerateMoves() makes the given number of moves, like that many calls to
+   * GenerateMove(), but one sweep (or the rest of a sweep) at a time: the moves
+   * and the acceptance thresholds of each sweep are drawn at once, and if
+   * SeparableSweeps() is true and the function has EvaluateDelta(), the
+   * changes of the objective are computed in parallel.  If a cooling schedule
+   * is given, the temperature is updated after each move, and frozenCount
+   * counts the consecutive moves that changed the energy by less than the
+   * tolerance; otherwise, the temperature is constant.
+   *
+   * @param iterate Current optimization position.
+   * @param accept Matrix representing which parameters have had accepted moves.
+   * @param moveSize Strides for a move.
+   * @param energy Current energy of the system.
+   * @param idx Current parameter to modify.
+   * @param sweepCounter Current counter representing how many sweeps have been
+   *      completed.
+   * @param moves Number of moves to make.
+   * @param currentTemperature Temperature for the Metropolis criterion.
+   * @param schedule Cooling schedule to update the temperature with, or NULL.
+   * @param frozenCount Number of consecutive moves within tolerance.
+   * @param workspace Buffers for the sweeps.
+   * @param rng Random number stream to draw the moves from.
+   */
+  template<typename FunctionType, typename MatType>
+  void GenerateMoves(FunctionType& function,
+                     MatType& iterate,
+                     MatType& accept,
+                     MatType& moveSize,
+                     typename MatType::elem_type& energy,
+                     size_t& idx,
+                     size_t& sweepCounter,
+                     size_t moves,
+                     double& currentTemperature,
+                     CoolingScheduleType* schedule,
+                     size_t& frozenCount,
+                     SweepWorkspace<MatType>& workspace,
+                     RandomStream& rng);
+
+  //! Compute the changes of the objective of the given moves in parallel, and
+  //! return true.
+  template<typename FunctionType, typename MatType>
+  bool SweepDeltas(FunctionType& function,
+                   const MatType& iterate,
+                   const size_t begin,
+                   SweepWorkspace<MatType>& workspace,
+                   std::true_type /* hasEvaluateDelta */) const;
+
+  //! The function has no EvaluateDelta(), so return false.
+  template<typename FunctionType, typename MatType>
+  bool SweepDeltas(FunctionType& /* function */,
+                   const MatType& /* iterate */,
+                   const size_t /* begin */,
+                   SweepWorkspace<MatType>& /* workspace */,
+                   std::false_type /* hasEvaluateDelta */) const
+  {
+    return false;
+  }
+
   /**
    * MoveControl() uses a proportional feedback control to determine the size
    * parameter to pass to the move generation distribution. The target of such
@@ -209,7 +392,9 @@ class SA
    * @param accept Matrix representing which parameters have had accepted moves.
    */
   template<typename MatType>
-  void MoveControl(const size_t nMoves, MatType& accept, MatType& moveSize);
+  void MoveControl(const size_t nMoves,
+                   MatType& accept,
+                   MatType& moveSize) const;
 };
 
 } // namespace ens
@@ -13,6 +13,7 @@
 #define ENSMALLEN_SA_SA_IMPL_HPP
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/evaluate_delta.hpp>
 
 namespace ens {
 
@@ -37,7 +38,12 @@ SA<CoolingScheduleType>::SA(
     maxToleranceSweep(maxToleranceSweep),
     maxMoveCoef(maxMoveCoef),
     initMoveCoef(initMoveCoef),
-    gain(gain)
+    gain(gain),
+    chains(1),
+    temperatureRatio(2.0),
+    swapInterval(100),
+    batchedSweeps(false),
+    separableSweeps(false)
 {
   // Nothing to do.
 }
@@ -60,6 +66,9 @@ typename MatType::elem_type SA<CoolingScheduleType>::Optimize(
 
   BaseMatType& iterate = (BaseMatType&) iterateIn;
 
+  if (chains > 1)
+    return ParallelTempering(function, iterate, callbacks...);
+
   const size_t rows = iterate.n_rows;
   const size_t cols = iterate.n_cols;
 
@@ -82,26 +91,59 @@ typename MatType::elem_type SA<CoolingScheduleType>::Optimize(
   terminate |= Callback::BeginOptimization(*this, function, iterate,
       callbacks...);
 
+  SweepWorkspace<BaseMatType> workspace;
+  RandomStream rng;
+
   // Initial moves to get rid of dependency of initial states.
-  for (size_t i = 0; i < initMoves; ++i)
-    GenerateMove(function, iterate, accept, moveSize, energy, idx,
-        sweepCounter, callbacks...);
+  if (batchedSweeps)
+  {
+    GenerateMoves(function, iterate, accept, moveSize, energy, idx,
+        sweepCounter, initMoves, temperature, NULL, frozenCount, workspace,
+        rng);
+    Callback::Evaluate(*this, function, iterate, energy, callbacks...);
+  }
+  else
+  {
+    for (size_t i = 0; i < initMoves; ++i)
+      GenerateMove(function, iterate, accept, moveSize, energy, idx,
+          sweepCounter, temperature, rng, callbacks...);
+  }
 
   // Iterating and cooling.
   for (size_t i = 0; i != maxIterations && !terminate; ++i)
   {
-    oldEnergy = energy;
-    GenerateMove(function, iterate, accept, moveSize, energy, idx,
-        sweepCounter, callbacks...);
-    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
-    temperature = coolingSchedule.NextTemperature(temperature, energy);
-
-    // Determine if the optimization has entered (or continues to be in) a
-    // frozen state.
-    if (std::abs(energy - oldEnergy) < tolerance)
-      ++frozenCount;
+    if (batchedSweeps)
+    {
+      // Make the rest of the current sweep, up to the maximum number of
+      // iterations.
+      size_t moves = iterate.n_elem - idx;
+      if (maxIterations != 0)
+        moves = std::min(moves, maxIterations - i);
+
+      GenerateMoves(function, iterate, accept, moveSize, energy, idx,
+          sweepCounter, moves, temperature, &coolingSchedule, frozenCount,
+          workspace, rng);
+      Callback::Evaluate(*this, function, iterate, energy, callbacks...);
+      terminate |= Callback::StepTaken(*this, function, iterate,
+          callbacks...);
+      i += moves - 1;
+    }
     else
-      frozenCount = 0;
+    {
+      oldEnergy = energy;
+      GenerateMove(function, iterate, accept, moveSize, energy, idx,
+          sweepCounter, temperature, rng, callbacks...);
+      terminate |= Callback::StepTaken(*this, function, iterate,
+          callbacks...);
+      temperature = coolingSchedule.NextTemperature(temperature, energy);
+
+      // Determine if the optimization has entered (or continues to be in) a
+      // frozen state.
+      if (std::abs(energy - oldEnergy) < tolerance)
+        ++frozenCount;
+      else
+        frozenCount = 0;
+    }
 
     // Terminate, if possible.
     if (frozenCount >= maxToleranceSweep * moveCtrlSweep * iterate.n_elem)
@@ -122,6 +164,180 @@ typename MatType::elem_type SA<CoolingScheduleType>::Optimize(
   return energy;
 }
 
+//! Optimize the function (minimize) with parallel tempering.
+template<typename CoolingScheduleType>
+template<typename FunctionType, typename MatType, typename... CallbackTypes>
+typename MatType::elem_type SA<CoolingScheduleType>::ParallelTempering(
+    FunctionType& function,
+    MatType& iterate,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (swapInterval == 0)
+  {
+    throw std::invalid_argument("SA::Optimize(): swapInterval must be "
+        "greater than 0 when using parallel tempering!");
+  }
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  const ElemType initialEnergy = function.Evaluate(iterate);
+  Callback::Evaluate(*this, function, iterate, initialEnergy, callbacks...);
+
+  // All chains start from the given point, at a ladder of temperatures.
+  MatType accept(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  MatType moveSize(iterate.n_rows, iterate.n_cols);
+  moveSize.fill(initMoveCoef);
+
+  // Each chain draws its moves from its own stream, and the swaps are drawn
+  // from this one.
+  RandomStream rng;
+
+  std::vector<Chain<MatType> > state;
+  state.reserve(chains);
+  for (size_t k = 0; k < chains; ++k)
+  {
+    Chain<MatType> chain = { iterate, accept, moveSize, initialEnergy,
+        temperature * std::pow(temperatureRatio, (double) k), coolingSchedule,
+        0, 0, 0, SweepWorkspace<MatType>(), rng.Split(k) };
+    state.push_back(chain);
+  }
+
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  const size_t frozenLimit = maxToleranceSweep * moveCtrlSweep * iterate.n_elem;
+  bool frozen = false;
+
+  // The moves of each chain are drawn from the stream of the chain.  The
+  // function may also use the random number generator of its thread, which is
+  // seeded from a seed of the chain that is drawn from this thread's
+  // generator, and this thread's generator is reseeded afterwards; so the
+  // results only depend on the seed, not on the number of threads or on
+  // scheduling.
+  arma::uvec seeds = arma::randi<arma::uvec>(chains + 1,
+      arma::distr_param(0, std::numeric_limits<int>::max()));
+
+  // Initial moves to get rid of dependency of initial states.
+  ParallelFor(chains, [&](const size_t k)
+  {
+    arma::arma_rng::set_seed(seeds(k));
+    Chain<MatType>& chain = state[k];
+    if (batchedSweeps)
+    {
+      GenerateMoves(function, chain.iterate, chain.accept, chain.moveSize,
+          chain.energy, chain.idx, chain.sweepCounter, initMoves,
+          chain.temperature, NULL, chain.frozenCount, chain.workspace,
+          chain.rng);
+      return;
+    }
+
+    for (size_t i = 0; i < initMoves; ++i)
+    {
+      GenerateMove(function, chain.iterate, chain.accept, chain.moveSize,
+          chain.energy, chain.idx, chain.sweepCounter, chain.temperature,
+          chain.rng);
+    }
+  });
+  arma::arma_rng::set_seed(seeds(chains));
+
+  // Iterating and cooling; the chains run independently for swapInterval
+  // moves, then the neighbors try to swap their states.
+  for (size_t i = 0; (maxIterations == 0 || i < maxIterations) && !terminate;)
+  {
+    const size_t moves = (maxIterations == 0) ? swapInterval :
+        std::min(swapInterval, maxIterations - i);
+
+    seeds = arma::randi<arma::uvec>(chains + 1,
+        arma::distr_param(0, std::numeric_limits<int>::max()));
+
+    ParallelFor(chains, [&](const size_t k)
+    {
+      arma::arma_rng::set_seed(seeds(k));
+      Chain<MatType>& chain = state[k];
+      if (batchedSweeps)
+      {
+        GenerateMoves(function, chain.iterate, chain.accept, chain.moveSize,
+            chain.energy, chain.idx, chain.sweepCounter, moves,
+            chain.temperature, &chain.coolingSchedule, chain.frozenCount,
+            chain.workspace, chain.rng);
+        return;
+      }
+
+      for (size_t j = 0; j < moves; ++j)
+      {
+        const ElemType oldEnergy = chain.energy;
+        GenerateMove(function, chain.iterate, chain.accept, chain.moveSize,
+            chain.energy, chain.idx, chain.sweepCounter, chain.temperature,
+            chain.rng);
+        chain.temperature = chain.coolingSchedule.NextTemperature(
+            chain.temperature, chain.energy);
+
+        if (std::abs(chain.energy - oldEnergy) < tolerance)
+          ++chain.frozenCount;
+        else
+          chain.frozenCount = 0;
+      }
+    });
+    arma::arma_rng::set_seed(seeds(chains));
+    i += moves;
+
+    // Try to swap the states of neighboring chains, starting with the
+    // coldest.
+    for (size_t k = 0; k + 1 < chains; ++k)
+    {
+      Chain<MatType>& cold = state[k];
+      Chain<MatType>& hot = state[k + 1];
+      const double exponent = (1.0 / cold.temperature - 1.0 / hot.temperature)
+          * (double) (cold.energy - hot.energy);
+      if (exponent >= 0 || std::exp(exponent) > rng.Uniform())
+      {
+        cold.iterate.swap(hot.iterate);
+        std::swap(cold.energy, hot.energy);
+        cold.frozenCount = 0;
+        hot.frozenCount = 0;
+      }
+    }
+
+    terminate |= Callback::StepTaken(*this, function, state[0].iterate,
+        callbacks...);
+    Callback::Evaluate(*this, function, state[0].iterate, state[0].energy,
+        callbacks...);
+
+    // Determine if the coldest chain has entered a frozen state.
+    if (state[0].frozenCount >= frozenLimit)
+    {
+      Info << "SA: minimized within tolerance " << tolerance << " for "
+          << maxToleranceSweep << " sweeps after " << i << " iterations; "
+          << "terminating optimization." << std::endl;
+      frozen = true;
+      break;
+    }
+  }
+
+  if (!frozen && !terminate)
+  {
+    Warn << "SA: maximum iterations (" << maxIterations << ") reached; "
+        << "terminating optimization." << std::endl;
+  }
+
+  // Return the best final state of all chains.
+  size_t best = 0;
+  for (size_t k = 1; k < chains; ++k)
+  {
+    if (state[k].energy < state[best].energy)
+      best = k;
+  }
+
+  temperature = state[0].temperature;
+  iterate = state[best].iterate;
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return state[best].energy;
+}
+
 /**
  * GenerateMove proposes a move on element iterate(idx), and determines
  * it that move is acceptable or not according to the Metropolis criterion.
@@ -140,6 +356,8 @@ void SA<CoolingScheduleType>::GenerateMove(
     typename MatType::elem_type& energy,
     size_t& idx,
     size_t& sweepCounter,
+    const double currentTemperature,
+    RandomStream& rng,
     CallbackTypes&... callbacks)
 {
   typedef typename MatType::elem_type ElemType;
@@ -152,20 +370,26 @@ void SA<CoolingScheduleType>::GenerateMove(
   // MoveControl() is derived for the Laplace distribution.
 
   // Sample from a Laplace distribution with scale parameter moveSize(idx).
-  const double unif = 2.0 * arma::randu() - 1.0;
+  const double unif = 2.0 * rng.Uniform() - 1.0;
   const ElemType move = (unif < 0) ? (moveSize(idx) * std::log(1 + unif)) :
       (-moveSize(idx) * std::log(1 - unif));
 
-  iterate(idx) += move;
-  energy = function.Evaluate(iterate);
+  // According to the Metropolis criterion, accept the move with probability
+  // min{1, exp(-(E_new - E_old) / T)}, i.e. if E_new < E_old - T log(xi) for
+  // uniform xi.  That bound is drawn first, so that the evaluation can stop
+  // once the new energy exceeds it (see EvaluateBounded()).
+  const double xi = rng.Uniform();
+  const ElemType bound = ElemType(prevEnergy -
+      currentTemperature * std::log(xi));
+
+  // The energy is updated incrementally if the function has EvaluateDelta().
+  energy = EvaluateMove(function, iterate, idx, ElemType(prevValue + move),
+      prevEnergy, bound);
 
   Callback::Evaluate(*this, function, iterate, energy, callbacks...);
 
-  // According to the Metropolis criterion, accept the move with probability
-  // min{1, exp(-(E_new - E_old) / T)}.
-  const double xi = arma::randu();
   const double delta = energy - prevEnergy;
-  const double criterion = std::exp(-delta / temperature);
+  const double criterion = std::exp(-delta / currentTemperature);
   if (delta <= 0. || criterion > xi)
   {
     accept(idx) += ElemType(1.);
@@ -190,6 +414,134 @@ void SA<CoolingScheduleType>::GenerateMove(
   }
 }
 
+//! Make the given number of moves, one sweep at a time.
+template<typename CoolingScheduleType>
+template<typename FunctionType, typename MatType>
+void SA<CoolingScheduleType>::GenerateMoves(
+    FunctionType& function,
+    MatType& iterate,
+    MatType& accept,
+    MatType& moveSize,
+    typename MatType::elem_type& energy,
+    size_t& idx,
+    size_t& sweepCounter,
+    size_t moves,
+    double& currentTemperature,
+    CoolingScheduleType* schedule,
+    size_t& frozenCount,
+    SweepWorkspace<MatType>& workspace,
+    RandomStream& rng)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  while (moves > 0)
+  {
+    const size_t count = std::min(moves, (size_t) iterate.n_elem - idx);
+
+    // Draw the random numbers of the whole (rest of the) sweep at once, and
+    // turn them into Laplace moves with scale moveSize and into acceptance
+    // thresholds.  A move is accepted with probability min{1, exp(-delta / T)},
+    // i.e. if delta <= 0 or xi < exp(-delta / T) for uniform xi, which is
+    // delta < T * (-log(xi)); so no exp() is needed for each move.
+    workspace.moves.set_size(count, 1);
+    workspace.thresholds.set_size(count, 1);
+    rng.FillUniform(workspace.moves);
+    rng.FillUniform(workspace.thresholds);
+
+    ElemType* move = workspace.moves.memptr();
+    ElemType* threshold = workspace.thresholds.memptr();
+    const ElemType* size = moveSize.memptr() + idx;
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t j = 0; j < count; ++j)
+    {
+      const ElemType unif = 2 * move[j] - 1;
+      move[j] = (unif < 0) ? (size[j] * std::log(1 + unif)) :
+          (-size[j] * std::log(1 - unif));
+      threshold[j] = -std::log(threshold[j]);
+    }
+
+    const bool hasDeltas = separableSweeps && SweepDeltas(function, iterate,
+        idx, workspace, std::integral_constant<bool,
+        traits::HasEvaluateDeltaSignature<FunctionType, MatType>::value>());
+
+    for (size_t j = 0; j < count; ++j)
+    {
+      const size_t i = idx + j;
+      const ElemType prevEnergy = energy;
+      const ElemType prevValue = iterate(i);
+      if (hasDeltas)
+      {
+        iterate(i) = prevValue + move[j];
+        energy = prevEnergy + workspace.deltas[j];
+      }
+      else
+      {
+        energy = EvaluateMove(function, iterate, i,
+            ElemType(prevValue + move[j]), prevEnergy,
+            ElemType(prevEnergy + currentTemperature * threshold[j]));
+      }
+
+      const double delta = energy - prevEnergy;
+      if (delta <= 0. || delta < currentTemperature * threshold[j])
+      {
+        accept(i) += ElemType(1.);
+      }
+      else // Reject the move; restore previous state.
+      {
+        iterate(i) = prevValue;
+        energy = prevEnergy;
+      }
+
+      if (schedule != NULL)
+      {
+        currentTemperature = schedule->NextTemperature(currentTemperature,
+            energy);
+
+        if (std::abs(energy - prevEnergy) < tolerance)
+          ++frozenCount;
+        else
+          frozenCount = 0;
+      }
+    }
+
+    moves -= count;
+    idx += count;
+    if (idx == iterate.n_elem) // Finished with a sweep.
+    {
+      idx = 0;
+      ++sweepCounter;
+    }
+
+    if (sweepCounter == moveCtrlSweep) // Do MoveControl().
+    {
+      MoveControl(moveCtrlSweep, accept, moveSize);
+      sweepCounter = 0;
+    }
+  }
+}
+
+//! Compute the changes of the objective of the moves of a sweep in parallel.
+template<typename CoolingScheduleType>
+template<typename FunctionType, typename MatType>
+bool SA<CoolingScheduleType>::SweepDeltas(
+    FunctionType& function,
+    const MatType& iterate,
+    const size_t begin,
+    SweepWorkspace<MatType>& workspace,
+    std::true_type /* hasEvaluateDelta */) const
+{
+  typedef typename MatType::elem_type ElemType;
+
+  workspace.deltas.set_size(workspace.moves.n_elem, 1);
+  ParallelFor(workspace.moves.n_elem, [&](const size_t j)
+  {
+    workspace.deltas[j] = function.EvaluateDelta(iterate, begin + j,
+        ElemType(iterate(begin + j) + workspace.moves[j]));
+  });
+
+  return true;
+}
+
 /**
  * MoveControl() uses a proportional feedback control to determine the size
  * parameter to pass to the move generation distribution. The target of such
@@ -208,7 +560,7 @@ template<typename CoolingScheduleType>
 template<typename MatType>
 inline void SA<CoolingScheduleType>::MoveControl(const size_t nMoves,
                                                  MatType& accept,
-                                                 MatType& moveSize)
+                                                 MatType& moveSize) const
 {
   MatType target;
   target.copy_size(accept);
@@ -0,0 +1,165 @@
+/**
+ * @file saga.hpp
+ *
+ * SAGA, an incremental gradient method with support for non-strongly convex
+ * composite objectives.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_HPP
+#define ENSMALLEN_SAGA_SAGA_HPP
+
+#include "saga_gradient_table.hpp"
+
+namespace ens {
+
+/**
+ * SAGA is a variance reduced stochastic gradient method for minimizing a
+ * function which can be expressed as a sum of other functions.  Instead of
+ * periodically computing the full gradient like SVRG or SARAH, SAGA stores the
+ * last gradient of each batch, and in each step replaces the stored gradient of
+ * one randomly chosen batch j:
+ *
+ * \f[
+ * x_{k + 1} = x_k - \alpha \left( \frac{g_j(x_k) - g_j^{old}}{b} +
+ *     \frac{1}{n} \sum_i g_i^{old} \right)
+ * \f]
+ *
+ * Only one pass over the data is needed to fill the table at the start.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{Defazio2014,
+ *   author    = {Defazio, Aaron and Bach, Francis and Lacoste-Julien, Simon},
+ *   title     = {SAGA: A Fast Incremental Gradient Method With Support for
+ *                Non-Strongly Convex Composite Objectives},
+ *   booktitle = {Advances in Neural Information Processing Systems 27},
+ *   pages     = {1646--1654},
+ *   year      = {2014}
+ * }
+ * @endcode
+ *
+ * SAGA can optimize differentiable separable functions.  For more details, see
+ * the documentation on function types included with this distribution or on the
+ * ensmallen website.
+ *
+ * By default the table holds one gradient per batch.  If the function also
+ * implements EvaluateWithPredictionGradient(), AddFeatureGradient() and
+ * RegularizationGradient() (as LogisticRegressionFunction does), only one
+ * derivative per function is stored instead; see SAGAGradientTable.
+ */
+class SAGA
+{
+ public:
+  /**
+   * Construct the SAGA optimizer with the given parameters.  The defaults here
+   * are not necessarily good for the given problem, so it is suggested that the
+   * values used be tailored to the task at hand.  The maximum number of
+   * iterations refers to the maximum number of points that are processed
+   * (i.e., one iteration equals one point; one iteration does not equal one
+   * pass over the dataset).  The initial pass that fills the gradient table is
+   * not counted.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of iterations allowed (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param exactObjective Calculate the exact objective (Default: estimate the
+   *        final objective obtained on the last pass over the data).
+   */
+  SAGA(const double stepSize = 0.01,
+       const size_t batchSize = 32,
+       const size_t maxIterations = 100000,
+       const double tolerance = 1e-5,
+       const bool exactObjective = false);
+
+  /**
+   * Optimize the given function using SAGA.  The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam SeparableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsArmaType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(SeparableFunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<SeparableFunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the actual objective is calculated.
+  bool ExactObjective() const { return exactObjective; }
+  //! Modify whether or not the actual objective is calculated.
+  bool& ExactObjective() { return exactObjective; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the actual Objective value is calculated.
+  bool exactObjective;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "saga_impl.hpp"
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * @file saga_gradient_table.hpp
+ *
+ * Tables of the last gradient of each batch, used by SAGA.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_GRADIENT_TABLE_HPP
+#define ENSMALLEN_SAGA_SAGA_GRADIENT_TABLE_HPP
+
+namespace ens {
+
+/**
+ * The gradient table stores the last gradient that was computed for each batch
+ * of the function.  Initialize() fills the table and computes the average
+ * gradient, and Step() computes the gradient of one batch at the current
+ * iterate, stores the difference to its last gradient in `direction`, and
+ * replaces the stored gradient.  AddRegularization() adds any part of the
+ * gradient that is not stored in the table.
+ *
+ * The general table stores the full gradient of each batch, so it needs
+ * O(d N / b) memory for N functions in batches of b and d coordinates.
+ *
+ * @tparam MatType Type of the iterate.
+ * @tparam GradType Type of the gradient.
+ * @tparam Linear Whether the function implements the linear-model API.
+ */
+template<typename MatType, typename GradType, bool Linear>
+class SAGAGradientTable
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Compute and store the gradient of every batch, and store their average in
+   * `average`.  The sum of the objectives is returned.
+   *
+   * @param function Function to use.
+   * @param iterate Current iterate.
+   * @param numFunctions Number of functions.
+   * @param batchSize Number of functions in each batch.
+   * @param average Matrix to store the average gradient into.
+   */
+  template<typename FunctionType>
+  ElemType Initialize(FunctionType& function,
+                      const MatType& iterate,
+                      const size_t numFunctions,
+                      const size_t batchSize,
+                      GradType& average)
+  {
+    const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+    gradients.resize(numBatches);
+
+    ElemType objective = 0;
+    average.zeros(iterate.n_rows, iterate.n_cols);
+    for (size_t k = 0; k < numBatches; ++k)
+    {
+      const size_t begin = k * batchSize;
+      objective += function.EvaluateWithGradient(iterate, begin, gradients[k],
+          std::min(batchSize, numFunctions - begin));
+      average += gradients[k];
+    }
+    average /= (ElemType) numFunctions;
+
+    return objective;
+  }
+
+  /**
+   * Compute the gradient of the given batch, store its difference to the
+   * stored gradient in `direction`, and replace the stored gradient.  The
+   * objective of the batch is returned.
+   *
+   * @param function Function to use.
+   * @param iterate Current iterate.
+   * @param batch Index of the batch.
+   * @param begin Index of the first function of the batch.
+   * @param batchSize Number of functions in the batch.
+   * @param direction Matrix to store the difference into.
+   */
+  template<typename FunctionType>
+  ElemType Step(FunctionType& function,
+                const MatType& iterate,
+                const size_t batch,
+                const size_t begin,
+                const size_t batchSize,
+                GradType& direction)
+  {
+    const ElemType objective = function.EvaluateWithGradient(iterate, begin,
+        gradient, batchSize);
+    direction = gradient - gradients[batch];
+    std::swap(gradients[batch], gradient);
+
+    return objective;
+  }
+
+  //! The whole gradient is stored in the table, so nothing has to be added.
+  template<typename FunctionType>
+  void AddRegularization(FunctionType& /* function */,
+                         const MatType& /* iterate */,
+                         const size_t /* numFunctions */,
+                         GradType& /* step */)
+  { }
+
+ private:
+  //! The last gradient of each batch.
+  std::vector<GradType> gradients;
+  //! The gradient of the current batch.
+  GradType gradient;
+};
+
+/**
+ * The gradient of a linear model (like LogisticRegressionFunction) for the
+ * function i has the form f_i'(<x_i, w>) [1, x_i] plus a regularization term,
+ * so it is enough to store the derivative f_i' of each function.  This needs
+ * O(N) memory, and the difference of the gradients of a batch costs the same
+ * as one gradient.  The regularization term is not stored, but computed
+ * exactly at the current iterate in every step.
+ *
+ * See the documentation on function types for the methods the function has to
+ * implement.
+ */
+template<typename MatType, typename GradType>
+class SAGAGradientTable<MatType, GradType, true>
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Compute and store the derivatives of every function, and store the
+  //! average of the (unregularized) gradients in `average`.
+  template<typename FunctionType>
+  ElemType Initialize(FunctionType& function,
+                      const MatType& iterate,
+                      const size_t numFunctions,
+                      const size_t batchSize,
+                      GradType& average)
+  {
+    derivatives.set_size(numFunctions);
+
+    ElemType objective = 0;
+    average.zeros(iterate.n_rows, iterate.n_cols);
+    for (size_t begin = 0; begin < numFunctions; begin += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+      objective += function.EvaluateWithPredictionGradient(iterate, begin,
+          newDerivatives, effectiveBatchSize);
+      derivatives.subvec(begin, begin + effectiveBatchSize - 1) =
+          newDerivatives;
+      function.AddFeatureGradient(begin, newDerivatives, average,
+          effectiveBatchSize);
+    }
+    average /= (ElemType) numFunctions;
+
+    return objective;
+  }
+
+  //! Compute the derivatives of the given batch, store the difference of the
+  //! (unregularized) gradients in `direction`, and replace the stored
+  //! derivatives.
+  template<typename FunctionType>
+  ElemType Step(FunctionType& function,
+                const MatType& iterate,
+                const size_t /* batch */,
+                const size_t begin,
+                const size_t batchSize,
+                GradType& direction)
+  {
+    const ElemType objective = function.EvaluateWithPredictionGradient(
+        iterate, begin, newDerivatives, batchSize);
+
+    const size_t end = begin + batchSize - 1;
+    difference = newDerivatives - derivatives.subvec(begin, end);
+    derivatives.subvec(begin, end) = newDerivatives;
+
+    direction.zeros(iterate.n_rows, iterate.n_cols);
+    function.AddFeatureGradient(begin, difference, direction, batchSize);
+
+    return objective;
+  }
+
+  //! Add the average regularization gradient at the current iterate.
+  template<typename FunctionType>
+  void AddRegularization(FunctionType& function,
+                         const MatType& iterate,
+                         const size_t numFunctions,
+                         GradType& step)
+  {
+    function.RegularizationGradient(iterate, regularization);
+    step += regularization / (ElemType) numFunctions;
+  }
+
+ private:
+  //! The last derivative of each function.
+  arma::Row<ElemType> derivatives;
+  //! The derivatives of the current batch.
+  arma::Row<ElemType> newDerivatives;
+  //! The difference of the derivatives of the current batch.
+  arma::Row<ElemType> difference;
+  //! The gradient of the regularization.
+  GradType regularization;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file saga_impl.hpp
+ *
+ * Implementation of the SAGA optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAGA_SAGA_IMPL_HPP
+#define ENSMALLEN_SAGA_SAGA_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "saga.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline SAGA::SAGA(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool exactObjective) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    exactObjective(exactObjective)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsArmaType<GradType>::value,
+typename MatType::elem_type>::type
+SAGA::Optimize(SeparableFunctionType& functionIn,
+               MatType& iterateIn,
+               CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& function(static_cast<FullFunctionType&>(functionIn));
+
+  traits::CheckSeparableFunctionTypeAPI<SeparableFunctionType,
+      BaseMatType, BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  // Store one derivative per function if the function is a linear model.
+  typedef SAGAGradientTable<BaseMatType, BaseGradType,
+      traits::HasLinearGradientSignature<SeparableFunctionType, BaseMatType,
+          BaseGradType>::value> TableType;
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+
+  // Find the number of batches.
+  size_t numBatches = numFunctions / batchSize;
+  if (numFunctions % batchSize != 0)
+    ++numBatches; // Capture last few.
+
+  // To keep track of where we are and how things are going.
+  size_t epoch = 1;
+  size_t epochFunctions = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = DBL_MAX;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  BaseGradType average, direction, step;
+  TableType table;
+
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  // Fill the gradient table; its objective is the first estimate.
+  lastObjective = table.Initialize(function, iterate, numFunctions,
+      batchSize, average);
+  Callback::Evaluate(*this, function, iterate, lastObjective, callbacks...);
+
+  terminate |= Callback::BeginEpoch(*this, function, iterate, epoch,
+      overallObjective, callbacks...);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Choose a batch uniformly at random.
+    const size_t batch = arma::randi<arma::uword>(
+        arma::distr_param(0, (int) numBatches - 1));
+    const size_t begin = batch * batchSize;
+    const size_t effectiveBatchSize = std::min(batchSize,
+        numFunctions - begin);
+
+    const ElemType objective = table.Step(function, iterate, batch, begin,
+        effectiveBatchSize, direction);
+    overallObjective += objective;
+
+    terminate |= Callback::Evaluate(*this, function, iterate, objective,
+        callbacks...);
+
+    // Take a step in the direction of the variance reduced gradient.
+    step = direction / (ElemType) effectiveBatchSize + average;
+    table.AddRegularization(function, iterate, numFunctions, step);
+    iterate -= stepSize * step;
+
+    terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
+
+    // Update the average of the stored gradients.
+    average += direction / (ElemType) numFunctions;
+
+    i += effectiveBatchSize;
+    epochFunctions += effectiveBatchSize;
+
+    // Has (about) one pass over the data been done?
+    if (epochFunctions >= numFunctions)
+    {
+      terminate |= Callback::EndEpoch(*this, function, iterate, epoch++,
+          overallObjective / (ElemType) epochFunctions, callbacks...);
+
+      // Output current objective function.
+      Info << "SAGA: iteration " << i << ", objective " << overallObjective
+          << "." << std::endl;
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "SAGA: converged to " << overallObjective << "; terminating"
+            << " with failure.  Try a smaller step size?" << std::endl;
+
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance ||
+          Callback::BeginEpoch(*this, function, iterate, epoch,
+              overallObjective, callbacks...))
+      {
+        Info << "SAGA: minimized within tolerance " << tolerance << "; "
+            << "terminating optimization." << std::endl;
+
+        Callback::EndOptimization(*this, function, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      epochFunctions = 0;
+    }
+  }
+
+  Info << "SAGA: maximum iterations (" << maxIterations << ") reached; "
+      << "terminating optimization." << std::endl;
+
+  // Calculate final objective.
+  if (exactObjective)
+  {
+    overallObjective = 0;
+    for (size_t i = 0; i < numFunctions; i += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+      const ElemType objective = function.Evaluate(iterate, i,
+          effectiveBatchSize);
+      overallObjective += objective;
+
+      Callback::Evaluate(*this, function, iterate, objective, callbacks...);
+    }
+  }
+  else
+  {
+    // Use the objective of the last complete pass, or of the initial pass.
+    overallObjective = lastObjective;
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file halton_sampling.hpp
+ *
+ * Randomly shifted Halton samples, for the initial populations of the
+ * population-based optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAMPLING_HALTON_SAMPLING_HPP
+#define ENSMALLEN_SAMPLING_HALTON_SAMPLING_HPP
+
+#include "normal_quantile.hpp"
+
+namespace ens {
+
+/**
+ * HaltonSampling fills the points with the Halton sequence: coordinate d of
+ * point j is the radical inverse of j + skip in the d'th prime base, i.e. the
+ * digits of j + skip in that base mirrored around the radix point.  Every
+ * coordinate is then shifted by an independent uniform offset modulo 1
+ * (Cranley-Patterson rotation), so that each optimization uses a different
+ * sample that keeps the low discrepancy of the sequence.
+ *
+ * The coordinates of the Halton sequence in large prime bases are correlated
+ * for the first points, so for more than about 20 dimensions SobolSampling or
+ * LatinHypercubeSampling usually spread the points better.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{halton1960,
+ *   author  = {Halton, J. H.},
+ *   title   = {On the efficiency of certain quasi-random sequences of points
+ *              in evaluating multi-dimensional integrals},
+ *   journal = {Numerische Mathematik},
+ *   year    = {1960},
+ *   volume  = {2},
+ *   number  = {1},
+ *   pages   = {84--90}
+ * }
+ * @endcode
+ */
+class HaltonSampling
+{
+ public:
+  /**
+   * Construct the Halton sampling policy.
+   *
+   * @param skip Number of points of the sequence to skip (Default 1, which
+   *     skips the origin).
+   */
+  HaltonSampling(const size_t skip = 1) : skip(skip) { }
+
+  //! Get the number of skipped points.
+  size_t Skip() const { return skip; }
+  //! Modify the number of skipped points.
+  size_t& Skip() { return skip; }
+
+  /**
+   * Fill the given matrix with randomly shifted Halton points in [0, 1).
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the shifts from.
+   */
+  template<typename MatType>
+  void Fill(MatType& points, RandomStream& rng) const
+  {
+    typedef typename MatType::elem_type eT;
+
+    size_t base = 1;
+    for (size_t d = 0; d < points.n_rows; ++d)
+    {
+      base = NextPrime(base);
+      const double shift = rng.Uniform();
+      for (size_t j = 0; j < points.n_cols; ++j)
+      {
+        // The radical inverse of j + skip in the given base.
+        double value = 0.0, scale = 1.0;
+        for (size_t i = j + skip; i > 0; i /= base)
+        {
+          scale /= base;
+          value += (i % base) * scale;
+        }
+
+        value += shift;
+        // Keep the values below 1 in the precision of eT.
+        const eT x = eT((value >= 1.0) ? value - 1.0 : value);
+        points(d, j) = (x < eT(1)) ? x : std::nextafter(eT(1), eT(0));
+      }
+    }
+  }
+
+  /**
+   * Fill the given matrix with standard normal values from randomly shifted
+   * Halton points.
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the shifts from.
+   */
+  template<typename MatType>
+  void FillNormal(MatType& points, RandomStream& rng) const
+  {
+    Fill(points, rng);
+    UniformToNormal(points);
+  }
+
+ private:
+  //! Return the smallest prime greater than n.
+  static size_t NextPrime(size_t n)
+  {
+    while (true)
+    {
+      ++n;
+      bool prime = (n >= 2);
+      for (size_t k = 2; k * k <= n && prime; ++k)
+        prime = (n % k != 0);
+      if (prime)
+        return n;
+    }
+  }
+
+  //! The number of points of the sequence to skip.
+  size_t skip;
+};
+
+} // namespace ens
+
+#endif
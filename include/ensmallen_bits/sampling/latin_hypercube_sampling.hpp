@@ -0,0 +1,92 @@
+/**
+ * @file latin_hypercube_sampling.hpp
+ *
+ * Latin hypercube samples, for the initial populations of the population-based
+ * optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAMPLING_LATIN_HYPERCUBE_SAMPLING_HPP
+#define ENSMALLEN_SAMPLING_LATIN_HYPERCUBE_SAMPLING_HPP
+
+#include "normal_quantile.hpp"
+
+namespace ens {
+
+/**
+ * LatinHypercubeSampling splits [0, 1) into as many strata of equal width as
+ * there are points, for each coordinate, and puts exactly one point in each
+ * stratum: coordinate d of point j is (pi_d(j) + u) / n, for an independent
+ * random permutation pi_d of the n points and uniform u.  So every projection
+ * of the points on a single coordinate is evenly spread, for any number of
+ * points and dimensions.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{mckay1979,
+ *   author  = {McKay, M. D. and Beckman, R. J. and Conover, W. J.},
+ *   title   = {A Comparison of Three Methods for Selecting Values of Input
+ *              Variables in the Analysis of Output from a Computer Code},
+ *   journal = {Technometrics},
+ *   year    = {1979},
+ *   volume  = {21},
+ *   number  = {2},
+ *   pages   = {239--245}
+ * }
+ * @endcode
+ */
+class LatinHypercubeSampling
+{
+ public:
+  /**
+   * Fill the given matrix with a Latin hypercube sample in [0, 1).
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the permutations and the offsets
+   *     in the strata from.
+   */
+  template<typename MatType>
+  void Fill(MatType& points, RandomStream& rng) const
+  {
+    typedef typename MatType::elem_type eT;
+
+    const size_t n = points.n_cols;
+    std::vector<size_t> strata(n);
+    rng.FillUniform(points);
+    for (size_t d = 0; d < points.n_rows; ++d)
+    {
+      // A random permutation of the strata (inside-out Fisher-Yates).
+      for (size_t j = 0; j < n; ++j)
+      {
+        const size_t k = rng.Integer(j + 1);
+        strata[j] = strata[k];
+        strata[k] = j;
+      }
+
+      for (size_t j = 0; j < n; ++j)
+        points(d, j) = (eT(strata[j]) + points(d, j)) / eT(n);
+    }
+  }
+
+  /**
+   * Fill the given matrix with standard normal values, one per stratum of
+   * equal probability for each coordinate.
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the sample from.
+   */
+  template<typename MatType>
+  void FillNormal(MatType& points, RandomStream& rng) const
+  {
+    Fill(points, rng);
+    UniformToNormal(points);
+  }
+};
+
+} // namespace ens
+
+#endif
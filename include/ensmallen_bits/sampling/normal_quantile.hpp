@@ -0,0 +1,80 @@
+/**
+ * @file normal_quantile.hpp
+ *
+ * The quantile function (inverse CDF) of the standard normal distribution, to
+ * map uniform samples to normal samples.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAMPLING_NORMAL_QUANTILE_HPP
+#define ENSMALLEN_SAMPLING_NORMAL_QUANTILE_HPP
+
+namespace ens {
+
+/**
+ * Return the quantile of the standard normal distribution at p, with the
+ * rational approximation of Acklam (relative error below 1.2e-9).  p is
+ * clamped to [eps, 1 - eps], where eps is the machine epsilon of eT, so the
+ * result is always finite.
+ *
+ * @param p Probability, in [0, 1].
+ * @return The value x such that P(X <= x) = p for standard normal X.
+ */
+template<typename eT>
+inline eT NormalQuantile(const eT p)
+{
+  static const double a[6] = { -3.969683028665376e+01, 2.209460984245205e+02,
+      -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+      2.506628277459239e+00 };
+  static const double b[5] = { -5.447609879822406e+01, 1.615858368580409e+02,
+      -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01 };
+  static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01,
+      -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+      2.938163982698783e+00 };
+  static const double d[4] = { 7.784695709041462e-03, 3.224671290700398e-01,
+      2.445134137142996e+00, 3.754408661907416e+00 };
+  const double low = 0.02425;
+
+  const double eps = std::numeric_limits<eT>::epsilon();
+  const double x = std::min(std::max(double(p), eps), 1.0 - eps);
+  if (x < low || x > 1.0 - low)
+  {
+    // The tails.
+    const double q = std::sqrt(-2.0 * std::log(std::min(x, 1.0 - x)));
+    const double value = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q +
+        c[4]) * q + c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q +
+        1.0);
+    return eT((x < low) ? value : -value);
+  }
+
+  // The central region.
+  const double q = x - 0.5;
+  const double r = q * q;
+  return eT((((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r +
+      a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) *
+      r + 1.0));
+}
+
+/**
+ * Map every element of the given matrix from a uniform sample in [0, 1) to a
+ * standard normal sample with NormalQuantile(), so that a low-discrepancy set
+ * of uniform points becomes a low-discrepancy set of normal points.
+ *
+ * @param points Matrix to transform in place.
+ */
+template<typename MatType>
+inline void UniformToNormal(MatType& points)
+{
+  typedef typename MatType::elem_type eT;
+
+  eT* x = points.memptr();
+  for (size_t i = 0; i < points.n_elem; ++i)
+    x[i] = NormalQuantile(x[i]);
+}
+
+} // namespace ens
+
+#endif
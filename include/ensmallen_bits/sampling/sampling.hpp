@@ -0,0 +1,21 @@
+/**
+ * @file sampling.hpp
+ *
+ * The sampling policies for the initial populations of the population-based
+ * optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAMPLING_SAMPLING_HPP
+#define ENSMALLEN_SAMPLING_SAMPLING_HPP
+
+#include "normal_quantile.hpp"
+#include "uniform_sampling.hpp"
+#include "halton_sampling.hpp"
+#include "latin_hypercube_sampling.hpp"
+#include "sobol_sampling.hpp"
+
+#endif
@@ -0,0 +1,274 @@
+/**
+ * @file sobol_sampling.hpp
+ *
+ * Digitally shifted Sobol samples, for the initial populations of the
+ * population-based optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAMPLING_SOBOL_SAMPLING_HPP
+#define ENSMALLEN_SAMPLING_SOBOL_SAMPLING_HPP
+
+#include "normal_quantile.hpp"
+
+namespace ens {
+
+/**
+ * SobolSampling fills the points with the Sobol sequence, a digital sequence
+ * in base 2: each coordinate has 32 direction numbers, derived from a
+ * primitive polynomial over GF(2), and the points are generated in Gray code
+ * order, so each point of a coordinate is the previous one with a single
+ * direction number xor'ed in.  The first 2^k points of every coordinate are
+ * then exactly one per interval [i / 2^k, (i + 1) / 2^k).  Every coordinate is
+ * xor'ed with an independent random 32-bit shift (a digital shift), so that
+ * each optimization uses a different sample that keeps the structure of the
+ * sequence, and the points are the centers of their intervals of width 2^-32.
+ *
+ * The initial direction numbers of the first 21 coordinates are those of Joe
+ * and Kuo; the other coordinates use the next primitive polynomials, with
+ * initial direction numbers drawn from a fixed random stream, so the sample
+ * only depends on the dimension and on the shifts.  The points are most evenly
+ * spread for powers of 2.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{joe2008,
+ *   author  = {Joe, Stephen and Kuo, Frances Y.},
+ *   title   = {Constructing Sobol Sequences with Better Two-Dimensional
+ *              Projections},
+ *   journal = {SIAM Journal on Scientific Computing},
+ *   year    = {2008},
+ *   volume  = {30},
+ *   number  = {5},
+ *   pages   = {2635--2654}
+ * }
+ * @endcode
+ */
+class SobolSampling
+{
+ public:
+  /**
+   * Fill the given matrix with digitally shifted Sobol points in (0, 1).
+   *
+   * @param points Matrix to fill, one point per column (at most 2^32 points).
+   * @param rng Random number stream to draw the shifts from.
+   */
+  template<typename MatType>
+  void Fill(MatType& points, RandomStream& rng) const
+  {
+    typedef typename MatType::elem_type eT;
+
+    if (uint64_t(points.n_cols) > (uint64_t(1) << 32))
+    {
+      throw std::invalid_argument("SobolSampling::Fill(): at most 2^32 points "
+          "can be sampled!");
+    }
+
+    uint32_t directions[32];
+    PolynomialGenerator polynomials;
+    RandomStream initial(0x50b01ULL);
+    for (size_t d = 0; d < points.n_rows; ++d)
+    {
+      Directions(d, polynomials, initial, directions);
+      const uint32_t shift = uint32_t(rng.Next() >> 32);
+
+      uint32_t x = 0;
+      for (size_t j = 0; j < points.n_cols; ++j)
+      {
+        // Keep the values below 1 in the precision of eT.
+        const eT u = eT((double(x ^ shift) + 0.5) * (1.0 / 4294967296.0));
+        points(d, j) = (u < eT(1)) ? u : std::nextafter(eT(1), eT(0));
+
+        // The next point flips the direction number of the lowest zero bit
+        // of j.
+        size_t c = 0;
+        for (uint64_t i = j; i & 1; i >>= 1)
+          ++c;
+        if (c < 32)
+          x ^= directions[c];
+      }
+    }
+  }
+
+  /**
+   * Fill the given matrix with standard normal values from digitally shifted
+   * Sobol points.
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the shifts from.
+   */
+  template<typename MatType>
+  void FillNormal(MatType& points, RandomStream& rng) const
+  {
+    Fill(points, rng);
+    UniformToNormal(points);
+  }
+
+ private:
+  /**
+   * Enumerate the primitive polynomials over GF(2) by increasing degree, and
+   * by increasing coefficients for the same degree, as in the table of Joe
+   * and Kuo.  A polynomial x^s + a_1 x^(s - 1) + ... + a_(s - 1) x + 1 is
+   * represented by its degree s and a = (a_1 ... a_(s - 1)) in binary.
+   */
+  class PolynomialGenerator
+  {
+   public:
+    PolynomialGenerator() : degree(0), coefficients(0) { }
+
+    //! Move to the next primitive polynomial.
+    void Next(size_t& s, uint64_t& a)
+    {
+      do
+      {
+        if (degree == 0 || coefficients + 1 >= (uint64_t(1) << (degree - 1)))
+        {
+          ++degree;
+          coefficients = 0;
+          Factorize((uint64_t(1) << degree) - 1);
+        }
+        else
+        {
+          ++coefficients;
+        }
+      } while (!Primitive());
+
+      s = degree;
+      a = coefficients;
+    }
+
+   private:
+    //! Store the prime factors of n.
+    void Factorize(uint64_t n)
+    {
+      factors.clear();
+      for (uint64_t q = 2; q * q <= n; ++q)
+      {
+        if (n % q == 0)
+        {
+          factors.push_back(q);
+          while (n % q == 0)
+            n /= q;
+        }
+      }
+      if (n > 1)
+        factors.push_back(n);
+    }
+
+    //! Return a * b modulo the current polynomial p.
+    uint64_t MultiplyMod(uint64_t a, uint64_t b, const uint64_t p) const
+    {
+      uint64_t result = 0;
+      while (b)
+      {
+        if (b & 1)
+          result ^= a;
+        b >>= 1;
+        a <<= 1;
+        if (a >> degree)
+          a ^= p;
+      }
+      return result;
+    }
+
+    //! Return x^e modulo the polynomial p.
+    uint64_t PowerMod(uint64_t e, const uint64_t p) const
+    {
+      uint64_t result = 1;
+      // x is 1 modulo x + 1.
+      uint64_t base = (degree == 1) ? 1 : 2;
+      while (e)
+      {
+        if (e & 1)
+          result = MultiplyMod(result, base, p);
+        base = MultiplyMod(base, base, p);
+        e >>= 1;
+      }
+      return result;
+    }
+
+    //! Return whether the current polynomial is primitive, i.e. whether x has
+    //! order 2^s - 1 modulo it.
+    bool Primitive() const
+    {
+      const uint64_t p = (uint64_t(1) << degree) | (coefficients << 1) | 1;
+      const uint64_t order = (uint64_t(1) << degree) - 1;
+      if (PowerMod(order, p) != 1)
+        return false;
+
+      for (size_t i = 0; i < factors.size(); ++i)
+      {
+        if (factors[i] != order && PowerMod(order / factors[i], p) == 1)
+          return false;
+      }
+      return true;
+    }
+
+    //! The degree of the current polynomial.
+    size_t degree;
+    //! The coefficients of the current polynomial.
+    uint64_t coefficients;
+    //! The prime factors of 2^degree - 1.
+    std::vector<uint64_t> factors;
+  };
+
+  /**
+   * Compute the direction numbers of coordinate d; the coordinates must be
+   * visited in order, with the same generator and stream.
+   */
+  static void Directions(const size_t d,
+                         PolynomialGenerator& polynomials,
+                         RandomStream& initial,
+                         uint32_t* directions)
+  {
+    // The first coordinate is the van der Corput sequence.
+    if (d == 0)
+    {
+      for (size_t k = 0; k < 32; ++k)
+        directions[k] = uint32_t(1) << (31 - k);
+      return;
+    }
+
+    // The initial direction numbers m_1, ..., m_s of Joe and Kuo
+    // (new-joe-kuo-6.21201) for the coordinates 2 to 21.
+    static const uint32_t table[20][7] = {
+        { 1 }, { 1, 3 }, { 1, 3, 1 }, { 1, 1, 1 }, { 1, 1, 3, 3 },
+        { 1, 3, 5, 13 }, { 1, 1, 5, 5, 17 }, { 1, 1, 5, 5, 5 },
+        { 1, 1, 7, 11, 19 }, { 1, 1, 5, 1, 1 }, { 1, 1, 1, 3, 11 },
+        { 1, 3, 5, 5, 31 }, { 1, 3, 3, 9, 7, 49 }, { 1, 1, 1, 15, 21, 21 },
+        { 1, 3, 1, 13, 27, 49 }, { 1, 1, 1, 15, 7, 5 },
+        { 1, 3, 1, 15, 13, 25 }, { 1, 1, 5, 5, 19, 61 },
+        { 1, 3, 7, 11, 23, 15, 103 }, { 1, 3, 7, 13, 13, 15, 69 } };
+
+    size_t s;
+    uint64_t a;
+    polynomials.Next(s, a);
+    const size_t initialCount = std::min(s, (size_t) 32);
+    for (size_t k = 0; k < initialCount; ++k)
+    {
+      // m_k is odd and below 2^k.
+      const uint32_t m = (d <= 20) ? table[d - 1][k] :
+          uint32_t(2 * initial.Integer(size_t(1) << k) + 1);
+      directions[k] = m << (31 - k);
+    }
+
+    for (size_t k = s; k < 32; ++k)
+    {
+      uint32_t v = directions[k - s] ^ (directions[k - s] >> s);
+      for (size_t j = 1; j < s; ++j)
+      {
+        if ((a >> (s - 1 - j)) & 1)
+          v ^= directions[k - j];
+      }
+      directions[k] = v;
+    }
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file uniform_sampling.hpp
+ *
+ * Independent uniform random samples, for the initial populations of the
+ * population-based optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SAMPLING_UNIFORM_SAMPLING_HPP
+#define ENSMALLEN_SAMPLING_UNIFORM_SAMPLING_HPP
+
+namespace ens {
+
+/**
+ * UniformSampling draws every coordinate of every point independently.  It is
+ * the default sampling policy of PSO (see SampledInit), CNE and DE.
+ *
+ * A sampling policy fills a matrix with one point per column, and has the
+ * following two methods:
+ *
+ * @code
+ * // Fill points with values in [0, 1).
+ * template<typename MatType>
+ * void Fill(MatType& points, RandomStream& rng) const;
+ *
+ * // Fill points with standard normal values.
+ * template<typename MatType>
+ * void FillNormal(MatType& points, RandomStream& rng) const;
+ * @endcode
+ *
+ * Low-discrepancy policies (HaltonSampling, SobolSampling and
+ * LatinHypercubeSampling) spread the points of a whole population evenly
+ * instead, so fewer points cover the space as well.
+ */
+class UniformSampling
+{
+ public:
+  /**
+   * Fill the given matrix with independent uniform values in [0, 1).
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the values from.
+   */
+  template<typename MatType>
+  void Fill(MatType& points, RandomStream& rng) const
+  {
+    rng.FillUniform(points);
+  }
+
+  /**
+   * Fill the given matrix with independent standard normal values, one point
+   * at a time.
+   *
+   * @param points Matrix to fill, one point per column.
+   * @param rng Random number stream to draw the values from.
+   */
+  template<typename MatType>
+  void FillNormal(MatType& points, RandomStream& rng) const
+  {
+    typedef typename MatType::elem_type eT;
+
+    for (size_t j = 0; j < points.n_cols; ++j)
+    {
+      arma::Mat<eT> point(points.colptr(j), points.n_rows, 1, false, true);
+      rng.FillNormal(point);
+    }
+  }
+};
+
+} // namespace ens
+
+#endif
@@ -40,6 +40,33 @@ namespace ens {
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
  *
+ * If ParallelFullGradient() is set to true (and OpenMP is enabled), the full
+ * objective and the full gradient of each outer iteration are computed by
+ * splitting the functions into contiguous ranges that are evaluated on separate
+ * threads, and then reduced; see ParallelEvaluateWithGradient().  The separable
+ * Evaluate() and Gradient() must then be safe to call concurrently on disjoint
+ * batches.  If DeterministicReduction() is also set, the functions are split
+ * into batches of BatchSize() that are reduced in a fixed order, so results do
+ * not depend on the number of threads.
+ *
+ * If ParallelChains() is set to true, the inner loop is split into independent
+ * chains, one per thread of the executor: every chain starts from the outer
+ * iterate and the full gradient, and runs its own recursion on every
+ * MaxThreads()-th batch, and the next outer iteration starts from the average
+ * of the final points of the chains.  (The recursive gradient estimate of
+ * SARAH depends on the previous step, so the chains can't share one iterate
+ * without locks.)  The separable Gradient() must then be safe to call
+ * concurrently.
+ *
+ * The Gradient() and StepTaken() callbacks of the chains are never called
+ * concurrently, so callbacks need no locks.  Each chain records its steps (and
+ * copies of the gradients, if a callback has a Gradient() method), and the
+ * steps are replayed by the calling thread after the chains join, in the order
+ * of the chains, each with the final point of its chain.  If
+ * CallbackBufferSize() is not 0, a chain also replays its steps under a lock
+ * once it has recorded that many.  When a callback asks to terminate, every
+ * chain stops before its next step.
+ *
  * @tparam UpdatePolicyType update policy used by SARAHType during the iterative
  *    update process.
  */
@@ -151,12 +178,62 @@ class SARAHType
   //! Modify whether or not the actual objective is calculated.
   bool& ExactObjective() { return exactObjective; }
 
+  //! Get whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool DeterministicReduction() const { return deterministicReduction; }
+  //! Modify whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool& DeterministicReduction() { return deterministicReduction; }
+
+  //! Get whether or not the inner loop runs as parallel chains.
+  bool ParallelChains() const { return parallelChains; }
+  //! Modify whether or not the inner loop runs as parallel chains.
+  bool& ParallelChains() { return parallelChains; }
+
+  //! Get the number of steps a parallel chain records before replaying them to
+  //! the callbacks (0 means only after the chains join).
+  size_t CallbackBufferSize() const { return callbackBufferSize; }
+  //! Modify the number of steps a parallel chain records before replaying them
+  //! to the callbacks (0 means only after the chains join).
+  size_t& CallbackBufferSize() { return callbackBufferSize; }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
   UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
 
  private:
+  /**
+   * Run the inner loop as independent chains on all threads, and store the
+   * average of their final points in the iterate; see ParallelChains().
+   *
+   * @param function Function to optimize.
+   * @param iterate The outer iterate (will be modified).
+   * @param v The full gradient.
+   * @param vNorm The norm of the full gradient.
+   * @param numSteps The total number of steps of all chains.
+   * @param terminate Set to true if a callback requested termination.
+   * @param callbacks Callback functions.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  void ParallelChainSteps(FunctionType& function,
+                          MatType& iterate,
+                          const GradType& v,
+                          const double vNorm,
+                          const size_t numSteps,
+                          bool& terminate,
+                          CallbackTypes&... callbacks);
+
   //! The step size for each example.
   double stepSize;
 
@@ -179,6 +256,21 @@ class SARAHType
   //! Controls whether or not the actual Objective value is calculated.
   bool exactObjective;
 
+  //! Controls whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool parallelFullGradient;
+
+  //! Controls whether or not parallel reductions are independent of the number
+  //! of threads.
+  bool deterministicReduction;
+
+  //! Controls whether or not the inner loop runs as parallel chains.
+  bool parallelChains;
+
+  //! The number of steps a parallel chain records before replaying them to the
+  //! callbacks.
+  size_t callbackBufferSize;
+
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
 };
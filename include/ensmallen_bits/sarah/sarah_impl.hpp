@@ -16,6 +16,7 @@
 #include "sarah.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/parallel_sgd/callback_events.hpp>
 
 namespace ens {
 
@@ -36,6 +37,10 @@ SARAHType<UpdatePolicyType>::SARAHType(
     tolerance(tolerance),
     shuffle(shuffle),
     exactObjective(exactObjective),
+    parallelFullGradient(false),
+    deterministicReduction(false),
+    parallelChains(false),
+    callbackBufferSize(64),
     updatePolicy(updatePolicy)
 { /* Nothing to do. */ }
 
@@ -89,6 +94,9 @@ SARAHType<UpdatePolicyType>::Optimize(
   BaseGradType gradient0(iterate.n_rows, iterate.n_cols);
   BaseMatType iterate0;
 
+  // Per-thread gradient buffers, only used if parallelFullGradient is true.
+  std::vector<BaseGradType> threadGradients;
+
   // Find the number of batches.
   size_t numBatches = numFunctions / batchSize;
   if (numFunctions % batchSize != 0)
@@ -102,14 +110,25 @@ SARAHType<UpdatePolicyType>::Optimize(
   {
     // Calculate the objective function.
     overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
+    if (parallelFullGradient)
     {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      const ElemType objective = function.Evaluate(iterate, f,
-          effectiveBatchSize);
-      overallObjective += objective;
+      overallObjective = ParallelEvaluate(function, iterate, 0, numFunctions,
+          deterministicReduction, batchSize);
+      Callback::Evaluate(*this, function, iterate, overallObjective,
+          callbacks...);
+    }
+    else
+    {
+      for (size_t f = 0; f < numFunctions; f += batchSize)
+      {
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - f);
+        const ElemType objective = function.Evaluate(iterate, f,
+            effectiveBatchSize);
+        overallObjective += objective;
 
-      Callback::Evaluate(*this, function, iterate, objective, callbacks...);
+        Callback::Evaluate(*this, function, iterate, objective, callbacks...);
+      }
     }
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
@@ -135,20 +154,31 @@ SARAHType<UpdatePolicyType>::Optimize(
 
     // Compute the full gradient.
     size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    function.Gradient(iterate, 0, v, effectiveBatchSize);
+    if (parallelFullGradient)
+    {
+      ParallelGradient(function, iterate, 0, v, numFunctions,
+          threadGradients, deterministicReduction, batchSize);
+      terminate |= Callback::Gradient(*this, function, iterate, v,
+          callbacks...);
+    }
+    else
+    {
+      function.Gradient(iterate, 0, v, effectiveBatchSize);
 
-    terminate |= Callback::Gradient(*this, function, iterate, v, callbacks...);
+      terminate |= Callback::Gradient(*this, function, iterate, v,
+          callbacks...);
 
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
-    {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
+      for (size_t f = effectiveBatchSize; f < numFunctions;
+          /* incrementing done manually */)
+      {
+        // Find the effective batch size (the last batch may be smaller).
+        effectiveBatchSize = std::min(batchSize, numFunctions - f);
 
-      function.Gradient(iterate, f, gradient, effectiveBatchSize);
-      v += gradient;
+        function.Gradient(iterate, f, gradient, effectiveBatchSize);
+        v += gradient;
 
-      f += effectiveBatchSize;
+        f += effectiveBatchSize;
+      }
     }
     v /= (double) numFunctions;
 
@@ -157,6 +187,20 @@ SARAHType<UpdatePolicyType>::Optimize(
 
     const ElemType vNorm = arma::norm(v);
 
+    if (parallelChains)
+    {
+      if (shuffle)
+        function.Shuffle();
+
+      // Take as many steps in total as the sequential inner loop.
+      const size_t rest = innerIterations % numFunctions;
+      const size_t numSteps = (innerIterations / numFunctions) * numBatches +
+          (rest + batchSize - 1) / batchSize;
+      ParallelChainSteps(function, iterate, v, vNorm, numSteps, terminate,
+          callbacks...);
+      continue;
+    }
+
     for (size_t f = 0, currentFunction = 0; f < innerIterations;
         /* incrementing done manually */)
     {
@@ -241,6 +285,115 @@ SARAHType<UpdatePolicyType>::Optimize(
   return overallObjective;
 }
 
+template<typename UpdatePolicyType>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+void SARAHType<UpdatePolicyType>::ParallelChainSteps(
+    FunctionType& function,
+    MatType& iterate,
+    const GradType& v,
+    const double vNorm,
+    const size_t numSteps,
+    bool& terminate,
+    CallbackTypes&... callbacks)
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const size_t chains = std::max(std::min(MaxThreads(), numSteps),
+      (size_t) 1);
+
+  // The Gradient() and StepTaken() callbacks are never called concurrently:
+  // each chain records its steps, and the steps are replayed under a lock when
+  // a buffer is full, and by this thread after the chains join (in the order
+  // of the chains).  The gradients are only copied if a callback needs them.
+  typedef SARAHType<UpdatePolicyType> OptimizerType;
+  const bool keepGradients = callbacks::traits::AnyOf<callbacks::traits::
+      HasGradientSignature<typename std::remove_reference<CallbackTypes>::type,
+      OptimizerType, FunctionType, MatType, GradType>::value...>::value;
+  const bool recordSteps = keepGradients || callbacks::traits::AnyOf<
+      !callbacks::traits::HasStepTakenSignature<typename std::remove_reference<
+      CallbackTypes>::type, OptimizerType, FunctionType,
+      MatType>::hasNone...>::value;
+
+  // Chain t visits batches t, t + chains, t + 2 * chains, ...; each chain has
+  // its own iterate, estimate and update policy.
+  std::vector<MatType> chainIterates(chains, iterate);
+  std::vector<CallbackEvents<GradType>> events(chains,
+      CallbackEvents<GradType>(callbackBufferSize));
+  std::mutex callbackMutex;
+  std::atomic<bool> stop(false);
+  ParallelFor(chains, [&](const size_t t)
+  {
+    MatType& chainIterate = chainIterates[t];
+    MatType iterate0;
+    GradType chainV(v);
+    GradType gradient, gradient0;
+    UpdatePolicyType policy(updatePolicy);
+
+    for (size_t k = t; k < numSteps && !stop.load(); k += chains)
+    {
+      const size_t begin = (k % numBatches) * batchSize;
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+
+      function.Gradient(chainIterate, begin, gradient, effectiveBatchSize);
+
+      // The first step of each chain only moves along the full gradient.
+      bool done;
+      if (k > t)
+      {
+        function.Gradient(iterate0, begin, gradient0, effectiveBatchSize);
+        iterate0 = chainIterate;
+        done = policy.Update(chainIterate, chainV, gradient, gradient0,
+            effectiveBatchSize, stepSize, vNorm);
+      }
+      else
+      {
+        iterate0 = chainIterate;
+        done = policy.Update(chainIterate, chainV, gradient, gradient,
+            effectiveBatchSize, stepSize, vNorm);
+      }
+
+      if (done)
+        break;
+
+      if (!recordSteps)
+        continue;
+
+      events[t].Add(gradient, keepGradients);
+      if (events[t].Full())
+      {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        if (events[t].Replay(*this, function, chainIterate, keepGradients,
+            callbacks...))
+        {
+          stop.store(true);
+        }
+      }
+    }
+  });
+
+  // Replay the rest of the steps of each chain with its final point.
+  for (size_t t = 0; t < chains; ++t)
+  {
+    if (events[t].Steps() > 0 && events[t].Replay(*this, function,
+        chainIterates[t], keepGradients, callbacks...))
+    {
+      stop.store(true);
+    }
+  }
+
+  // The next outer iteration starts from the average of the chains.
+  iterate = chainIterates[0];
+  for (size_t t = 1; t < chains; ++t)
+    iterate += chainIterates[t];
+  iterate /= (typename MatType::elem_type) chains;
+
+  terminate |= stop.load();
+}
+
 } // namespace ens
 
 #endif
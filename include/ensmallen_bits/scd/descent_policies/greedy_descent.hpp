@@ -31,10 +31,30 @@ namespace ens {
  *   eprint = {arXiv:1506.00552}
  * }
  * @endcode
+ *
+ * By default, the partial gradient of every feature is computed in each
+ * iteration.  If the function also implements
+ *
+ * @code
+ * void AffectedFeatures(const size_t j, arma::uvec& features) const;
+ * @endcode
+ *
+ * which stores in `features` the indices of all features whose partial
+ * gradient may change when feature j of the iterate changes (including j
+ * itself), then the descent of every feature is kept in an indexed max-heap.
+ * After the first iteration, only the descents of the features affected by the
+ * previously selected feature are recomputed, so each selection costs
+ * O(k log n) heap operations and k partial gradients for k affected features.
+ * This assumes that only the selected feature of the iterate is changed
+ * between calls, as in SCD; the heap is rebuilt when `iteration` is 0 or 1,
+ * i.e. at the start of each optimization.
  */
 class GreedyDescent
 {
  public:
+  //! Construct the greedy descent policy.
+  GreedyDescent() : lastFeature(0), initialized(false) { }
+
   /**
    * The DescentFeature method is used to get the descent coordinate for the
    * current iteration.
@@ -47,9 +67,11 @@ class GreedyDescent
    * @return The index of the coordinate to be descended.
    */
   template<typename ResolvableFunctionType, typename MatType, typename GradType>
-  static size_t DescentFeature(const size_t /* iteration */,
-                               const MatType& iterate,
-                               const ResolvableFunctionType& function)
+  typename std::enable_if<!traits::HasAffectedFeaturesSignature<
+      ResolvableFunctionType>::value, size_t>::type
+  DescentFeature(const size_t /* iteration */,
+                 const MatType& iterate,
+                 const ResolvableFunctionType& function)
   {
     typedef typename MatType::elem_type ElemType;
 
@@ -71,6 +93,132 @@ class GreedyDescent
 
     return bestFeature;
   }
+
+  /**
+   * Get the descent coordinate for the current iteration, updating only the
+   * descents of the features affected by the previously selected feature.
+   *
+   * @tparam ResolvableFunctionType The type of the function to be optimized.
+   * @param iteration The iteration number for which the feature is to be
+   *    obtained.
+   * @param iterate The current value of the decision variable.
+   * @param function The function to be optimized.
+   * @return The index of the coordinate to be descended.
+   */
+  template<typename ResolvableFunctionType, typename MatType, typename GradType>
+  typename std::enable_if<traits::HasAffectedFeaturesSignature<
+      ResolvableFunctionType>::value, size_t>::type
+  DescentFeature(const size_t iteration,
+                 const MatType& iterate,
+                 const ResolvableFunctionType& function)
+  {
+    const size_t numFeatures = function.NumFeatures();
+    if (!initialized || iteration <= 1 || descents.size() != numFeatures)
+    {
+      // Compute every descent and build the heap.
+      descents.resize(numFeatures);
+      heap.resize(numFeatures);
+      position.resize(numFeatures);
+      for (size_t i = 0; i < numFeatures; ++i)
+      {
+        descents[i] = Descent<GradType>(iterate, i, function);
+        heap[i] = i;
+        position[i] = i;
+      }
+
+      for (size_t i = numFeatures / 2; i > 0; --i)
+        SiftDown(i - 1);
+
+      initialized = true;
+    }
+    else
+    {
+      function.AffectedFeatures(lastFeature, affected);
+      for (size_t i = 0; i < affected.n_elem; ++i)
+      {
+        const size_t feature = affected[i];
+        descents[feature] = Descent<GradType>(iterate, feature, function);
+        SiftUp(position[feature]);
+        SiftDown(position[feature]);
+      }
+    }
+
+    // As in the full search, no feature is preferred if none has a positive
+    // descent.
+    lastFeature = (numFeatures > 0 && descents[heap[0]] > 0) ? heap[0] : 0;
+    return lastFeature;
+  }
+
+ private:
+  //! Compute the descent of the given feature.
+  template<typename GradType, typename MatType, typename FunctionType>
+  static double Descent(const MatType& iterate,
+                        const size_t feature,
+                        const FunctionType& function)
+  {
+    GradType fGrad;
+    function.PartialGradient(iterate, feature, fGrad);
+    return arma::accu(fGrad);
+  }
+
+  //! Return whether feature a should be closer to the top of the heap than
+  //! feature b; ties are broken by the lower index, as in the full search.
+  bool Before(const size_t a, const size_t b) const
+  {
+    return (descents[a] > descents[b]) ||
+        (descents[a] == descents[b] && a < b);
+  }
+
+  //! Swap two entries of the heap.
+  void Swap(const size_t i, const size_t j)
+  {
+    std::swap(heap[i], heap[j]);
+    position[heap[i]] = i;
+    position[heap[j]] = j;
+  }
+
+  //! Move the entry at index i of the heap up until the heap is valid.
+  void SiftUp(size_t i)
+  {
+    while (i > 0 && Before(heap[i], heap[(i - 1) / 2]))
+    {
+      Swap(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  //! Move the entry at index i of the heap down until the heap is valid.
+  void SiftDown(size_t i)
+  {
+    while (true)
+    {
+      size_t best = i;
+      const size_t left = 2 * i + 1;
+      const size_t right = 2 * i + 2;
+      if (left < heap.size() && Before(heap[left], heap[best]))
+        best = left;
+      if (right < heap.size() && Before(heap[right], heap[best]))
+        best = right;
+      if (best == i)
+        return;
+
+      Swap(i, best);
+      i = best;
+    }
+  }
+
+  //! The descent of each feature.
+  std::vector<double> descents;
+  //! The heap of features, ordered by descent.
+  std::vector<size_t> heap;
+  //! The position of each feature in the heap.
+  std::vector<size_t> position;
+  //! The features affected by the last selected feature.
+  arma::uvec affected;
+  //! The last selected feature.
+  size_t lastFeature;
+  //! Whether or not the heap has been built.
+  bool initialized;
 };
 
 } // namespace ens
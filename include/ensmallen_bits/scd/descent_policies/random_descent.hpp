@@ -48,13 +48,21 @@ class RandomDescent
    * @return The index of the coordinate to be descended.
    */
   template<typename ResolvableFunctionType, typename MatType, typename GradType>
-  static size_t DescentFeature(const size_t /* iteration */,
-                               const MatType& /* iterate */,
-                               const ResolvableFunctionType& function)
+  size_t DescentFeature(const size_t iteration,
+                        const MatType& /* iterate */,
+                        const ResolvableFunctionType& function)
   {
-    return arma::as_scalar(arma::randi<arma::uvec>(
-          1, arma::distr_param(0, function.NumFeatures() - 1)));
+    // The stream is seeded from the generator of Armadillo at the start of
+    // each optimization.
+    if (iteration == 1)
+      rng = RandomStream();
+
+    return rng.Integer(function.NumFeatures());
   }
+
+ private:
+  //! The stream that the coordinates are drawn from.
+  RandomStream rng;
 };
 
 } // namespace ens
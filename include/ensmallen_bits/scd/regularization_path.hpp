@@ -0,0 +1,284 @@
+/**
+ * @file regularization_path.hpp
+ *
+ * Coordinate descent over a decreasing grid of l1 (or elastic net) penalties,
+ * with warm starts and screening of the features that stay zero.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_REGULARIZATION_PATH_HPP
+#define ENSMALLEN_SCD_REGULARIZATION_PATH_HPP
+
+namespace ens {
+
+/**
+ * RegularizationPath computes the solutions of the elastic net problems
+ *
+ * \f[
+ * \min_x f(x) + \lambda \sum_j w_j (\alpha ||x_j||_1 +
+ *     \frac{1 - \alpha}{2} ||x_j||_2^2)
+ * \f]
+ *
+ * for a decreasing grid of penalties \f$ \lambda_0 > \lambda_1 > ... \f$,
+ * where \f$ x_j \f$ is the column of the coordinates of feature j of the
+ * partially differentiable function f (e.g. the lasso for alpha = 1).  Each
+ * problem is solved by cyclic proximal coordinate descent, started from the
+ * solution of the previous penalty (warm start).
+ *
+ * Before each penalty, the sequential strong rule discards the features whose
+ * partial gradient at the previous solution satisfies
+ * \f$ ||\nabla_j f||_\infty < \alpha w_j (2 \lambda_k - \lambda_{k - 1}) \f$
+ * and that are zero; these features are very likely to stay zero, so the
+ * coordinate updates only touch the remaining (active) features.  Once the
+ * active features have converged, the optimality conditions
+ * \f$ ||\nabla_j f||_\infty \le \alpha w_j \lambda_k \f$ of the discarded
+ * features are checked, and the violating features are added to the active set
+ * before solving again, so the screening never changes the solutions.  On
+ * problems with many more features than nonzero coefficients, this is much
+ * less work than solving each problem over all the features.
+ *
+ * If Lambdas() is empty (the default), the grid has numLambdas values, evenly
+ * spaced on a log scale from the smallest penalty \f$ \lambda_{max} \f$ at
+ * which the initial point is a solution (after the unpenalized features have
+ * been fit) down to lambdaMinRatio times \f$ \lambda_{max} \f$; the initial
+ * point should then be zero on the penalized features.  The penalty factors
+ * \f$ w_j \f$ are 1 unless PenaltyFactors() is set; a factor of 0 leaves a
+ * feature (e.g. an intercept) unpenalized and never discards it.
+ *
+ * The solution of every penalty is stored in Path(), and the coordinates are
+ * set to the solution of the last penalty.  The step size of the coordinate
+ * updates should be at most the inverse of the Lipschitz constant of the
+ * partial gradients.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{tibshirani2012strong,
+ *   title   = {Strong Rules for Discarding Predictors in Lasso-Type
+ *              Problems},
+ *   author  = {Tibshirani, Robert and Bien, Jacob and Friedman, Jerome and
+ *              Hastie, Trevor and Simon, Noah and Taylor, Jonathan and
+ *              Tibshirani, Ryan J.},
+ *   journal = {Journal of the Royal Statistical Society: Series B},
+ *   volume  = {74},
+ *   number  = {2},
+ *   pages   = {245--266},
+ *   year    = {2012}
+ * }
+ * @endcode
+ *
+ * RegularizationPath can optimize partially differentiable functions.  For
+ * more details, see the documentation on function types included with this
+ * distribution or on the ensmallen website.
+ */
+class RegularizationPath
+{
+ public:
+  /**
+   * Construct the RegularizationPath optimizer with the given parameters.
+   *
+   * @param stepSize Step size of each coordinate update.
+   * @param numLambdas Number of penalties of the automatic grid.
+   * @param lambdaMinRatio Ratio of the smallest to the largest penalty of the
+   *     automatic grid.
+   * @param alpha Fraction of the penalty that is the l1 norm (1 for the
+   *     lasso).
+   * @param maxPasses Maximum number of passes over the active features for
+   *     each penalty (0 means no limit).
+   * @param tolerance Maximum absolute change of a coordinate in one pass to
+   *     terminate the descent of a penalty.
+   */
+  RegularizationPath(const double stepSize = 0.01,
+                     const size_t numLambdas = 100,
+                     const double lambdaMinRatio = 1e-3,
+                     const double alpha = 1.0,
+                     const size_t maxPasses = 1000,
+                     const double tolerance = 1e-6);
+
+  /**
+   * Compute the regularization path of the given function.  The given
+   * starting point will be modified to store the solution of the last
+   * penalty, and the (penalized) objective of that solution is returned.
+   *
+   * @tparam ResolvableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value at the solution of the last penalty.
+   */
+  template<typename ResolvableFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsArmaType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(ResolvableFunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward arma::SpMat<typename MatType::elem_type> as GradType.
+  template<typename ResolvableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(ResolvableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<ResolvableFunctionType, MatType,
+        arma::SpMat<typename MatType::elem_type>, CallbackTypes...>(
+        function, iterate, std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the number of penalties of the automatic grid.
+  size_t NumLambdas() const { return numLambdas; }
+  //! Modify the number of penalties of the automatic grid.
+  size_t& NumLambdas() { return numLambdas; }
+
+  //! Get the ratio of the smallest to the largest automatic penalty.
+  double LambdaMinRatio() const { return lambdaMinRatio; }
+  //! Modify the ratio of the smallest to the largest automatic penalty.
+  double& LambdaMinRatio() { return lambdaMinRatio; }
+
+  //! Get the fraction of the penalty that is the l1 norm.
+  double Alpha() const { return alpha; }
+  //! Modify the fraction of the penalty that is the l1 norm.
+  double& Alpha() { return alpha; }
+
+  //! Get the maximum number of passes for each penalty (0 means no limit).
+  size_t MaxPasses() const { return maxPasses; }
+  //! Modify the maximum number of passes for each penalty (0 means no limit).
+  size_t& MaxPasses() { return maxPasses; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the decreasing grid of penalties (empty for the automatic grid).
+  const arma::vec& Lambdas() const { return lambdas; }
+  //! Modify the decreasing grid of penalties (empty for the automatic grid).
+  arma::vec& Lambdas() { return lambdas; }
+
+  //! Get the penalty factor of each feature (empty means all 1).
+  const arma::vec& PenaltyFactors() const { return penaltyFactors; }
+  //! Modify the penalty factor of each feature (empty means all 1).
+  arma::vec& PenaltyFactors() { return penaltyFactors; }
+
+  //! Get whether features are discarded with the strong rule.
+  bool Screening() const { return screening; }
+  //! Modify whether features are discarded with the strong rule.
+  bool& Screening() { return screening; }
+
+  //! Get the penalties of the last path.
+  const arma::vec& PathLambdas() const { return pathLambdas; }
+
+  //! Get the solutions of the last path; slice k is the solution of penalty
+  //! k.
+  const arma::cube& Path() const { return path; }
+
+  //! Get the penalized objective of each solution of the last path.
+  const arma::vec& Objectives() const { return objectives; }
+
+  //! Get the number of active features of each solution of the last path.
+  const arma::uvec& ActiveFeatures() const { return activeFeatures; }
+
+  //! Get the number of coordinate updates of the last path.
+  size_t Updates() const { return updates; }
+
+  //! Get the number of discarded features of the last path that violated the
+  //! optimality conditions.
+  size_t Violations() const { return violations; }
+
+ private:
+  /**
+   * Run proximal coordinate descent over the given features until convergence
+   * for the given penalty.
+   *
+   * @return true if a callback asked to terminate the optimization.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  bool Descend(FunctionType& function,
+               MatType& iterate,
+               const arma::uvec& features,
+               const arma::vec& factors,
+               const double lambda,
+               GradType& gradient,
+               arma::Col<typename MatType::elem_type>& column,
+               CallbackTypes&... callbacks);
+
+  /**
+   * Store the largest absolute partial gradient of each feature in `scores`.
+   */
+  template<typename FunctionType, typename MatType, typename GradType>
+  void Scores(FunctionType& function,
+              const MatType& iterate,
+              GradType& gradient,
+              arma::Col<typename MatType::elem_type>& column,
+              arma::vec& scores);
+
+  //! The step size of each coordinate update.
+  double stepSize;
+
+  //! The number of penalties of the automatic grid.
+  size_t numLambdas;
+
+  //! The ratio of the smallest to the largest automatic penalty.
+  double lambdaMinRatio;
+
+  //! The fraction of the penalty that is the l1 norm.
+  double alpha;
+
+  //! The maximum number of passes for each penalty.
+  size_t maxPasses;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The grid of penalties given by the user.
+  arma::vec lambdas;
+
+  //! The penalty factor of each feature.
+  arma::vec penaltyFactors;
+
+  //! Whether features are discarded with the strong rule.
+  bool screening;
+
+  //! The penalties of the last path.
+  arma::vec pathLambdas;
+
+  //! The solutions of the last path.
+  arma::cube path;
+
+  //! The objectives of the solutions of the last path.
+  arma::vec objectives;
+
+  //! The number of active features of each solution of the last path.
+  arma::uvec activeFeatures;
+
+  //! The number of coordinate updates of the last path.
+  size_t updates;
+
+  //! The number of violations of the optimality conditions of the last path.
+  size_t violations;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "regularization_path_impl.hpp"
+
+#endif
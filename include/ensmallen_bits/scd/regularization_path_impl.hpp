@@ -0,0 +1,312 @@
+/**
+ * @file regularization_path_impl.hpp
+ *
+ * Implementation of the RegularizationPath optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_REGULARIZATION_PATH_IMPL_HPP
+#define ENSMALLEN_SCD_REGULARIZATION_PATH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "regularization_path.hpp"
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/partial_gradient_column.hpp>
+
+namespace ens {
+
+inline RegularizationPath::RegularizationPath(const double stepSize,
+                                              const size_t numLambdas,
+                                              const double lambdaMinRatio,
+                                              const double alpha,
+                                              const size_t maxPasses,
+                                              const double tolerance) :
+    stepSize(stepSize),
+    numLambdas(numLambdas),
+    lambdaMinRatio(lambdaMinRatio),
+    alpha(alpha),
+    maxPasses(maxPasses),
+    tolerance(tolerance),
+    screening(true),
+    updates(0),
+    violations(0)
+{ /* Nothing to do. */ }
+
+//! Compute the regularization path of the function.
+template<typename ResolvableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsArmaType<GradType>::value,
+typename MatType::elem_type>::type
+RegularizationPath::Optimize(ResolvableFunctionType& function,
+                             MatType& iterateIn,
+                             CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  // Make sure we have the methods that we need.
+  traits::CheckResolvableFunctionTypeAPI<ResolvableFunctionType, BaseMatType,
+      BaseGradType>();
+  RequireDenseFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+  const size_t numFeatures = function.NumFeatures();
+
+  if (alpha <= 0.0 || alpha > 1.0)
+  {
+    throw std::invalid_argument("RegularizationPath::Optimize(): alpha must "
+        "be in (0, 1]");
+  }
+  if (!penaltyFactors.is_empty() && penaltyFactors.n_elem != numFeatures)
+  {
+    std::ostringstream oss;
+    oss << "RegularizationPath::Optimize(): there are " << numFeatures
+        << " features, but " << penaltyFactors.n_elem << " penalty factors";
+    throw std::invalid_argument(oss.str());
+  }
+  if (lambdas.is_empty() && numLambdas == 0)
+  {
+    throw std::invalid_argument("RegularizationPath::Optimize(): numLambdas "
+        "must be positive");
+  }
+  for (size_t k = 1; k < lambdas.n_elem; ++k)
+  {
+    if (lambdas(k) > lambdas(k - 1))
+    {
+      throw std::invalid_argument("RegularizationPath::Optimize(): the "
+          "penalties must be decreasing");
+    }
+  }
+
+  const arma::vec factors = penaltyFactors.is_empty() ?
+      arma::vec(arma::ones<arma::vec>(numFeatures)) : penaltyFactors;
+  const arma::uvec unpenalized = arma::find(factors == 0.0);
+
+  BaseGradType gradient;
+  arma::Col<ElemType> column(iterate.n_rows);
+  arma::vec scores(numFeatures);
+  std::vector<bool> active(numFeatures);
+
+  updates = 0;
+  violations = 0;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+  terminate |= Callback::BeginOptimization(*this, function, iterate,
+      callbacks...);
+
+  // The automatic grid starts at the smallest penalty at which the penalized
+  // features of the initial point are optimal, once the unpenalized features
+  // have been fit.
+  if (lambdas.is_empty() && !unpenalized.is_empty() && !terminate)
+  {
+    terminate |= Descend(function, iterate, unpenalized, factors, 0.0,
+        gradient, column, callbacks...);
+  }
+
+  Scores(function, iterate, gradient, column, scores);
+  double lambdaMax = 0.0;
+  for (size_t j = 0; j < numFeatures; ++j)
+  {
+    if (factors(j) > 0.0)
+      lambdaMax = std::max(lambdaMax, scores(j) / (alpha * factors(j)));
+  }
+
+  if (lambdas.is_empty())
+  {
+    pathLambdas.set_size(numLambdas);
+    for (size_t k = 0; k < numLambdas; ++k)
+    {
+      pathLambdas(k) = (numLambdas == 1) ? lambdaMax : lambdaMax *
+          std::pow(lambdaMinRatio, double(k) / (numLambdas - 1));
+    }
+  }
+  else
+  {
+    pathLambdas = lambdas;
+  }
+
+  path.set_size(iterate.n_rows, iterate.n_cols, pathLambdas.n_elem);
+  objectives.set_size(pathLambdas.n_elem);
+  activeFeatures.set_size(pathLambdas.n_elem);
+
+  ElemType objective = 0;
+  double lastLambda = std::max(lambdaMax, pathLambdas(0));
+  size_t solved = 0;
+  for (size_t k = 0; k < pathLambdas.n_elem && !terminate; ++k)
+  {
+    const double lambda = pathLambdas(k);
+
+    // Sequential strong rule: keep the nonzero features, and the features
+    // whose partial gradient may exceed the threshold at this penalty.
+    const double strongLambda = 2 * lambda - lastLambda;
+    for (size_t j = 0; j < numFeatures; ++j)
+    {
+      active[j] = !screening || factors(j) == 0.0 ||
+          scores(j) >= alpha * factors(j) * strongLambda ||
+          arma::any(iterate.col(j) != 0);
+    }
+
+    while (true)
+    {
+      arma::uvec features(numFeatures);
+      size_t numActive = 0;
+      for (size_t j = 0; j < numFeatures; ++j)
+      {
+        if (active[j])
+          features(numActive++) = j;
+      }
+      features.resize(numActive);
+
+      terminate |= Descend(function, iterate, features, factors, lambda,
+          gradient, column, callbacks...);
+      activeFeatures(k) = numActive;
+      if (terminate)
+        break;
+
+      // Check the optimality conditions of the discarded features; the
+      // scores are also used by the strong rule of the next penalty.
+      if (!screening)
+        break;
+
+      Scores(function, iterate, gradient, column, scores);
+      size_t added = 0;
+      for (size_t j = 0; j < numFeatures; ++j)
+      {
+        if (!active[j] && scores(j) > alpha * factors(j) * lambda)
+        {
+          active[j] = true;
+          ++added;
+        }
+      }
+
+      if (added == 0)
+        break;
+
+      violations += added;
+      Info << "RegularizationPath: " << added << " discarded features "
+          << "violate the optimality conditions at penalty " << lambda
+          << "; solving again." << std::endl;
+    }
+
+    if (terminate)
+      break;
+
+    // Compute the penalized objective of the solution.
+    objective = function.Evaluate(iterate);
+    for (size_t j = 0; j < numFeatures; ++j)
+    {
+      objective += ElemType(lambda * factors(j) * (alpha *
+          arma::accu(arma::abs(iterate.col(j))) + (1.0 - alpha) / 2.0 *
+          arma::accu(arma::square(iterate.col(j)))));
+    }
+    terminate |= Callback::Evaluate(*this, function, iterate, objective,
+        callbacks...);
+
+    Info << "RegularizationPath: penalty " << lambda << ", objective "
+        << objective << ", " << activeFeatures(k) << " active features."
+        << std::endl;
+
+    path.slice(k) = arma::conv_to<arma::mat>::from(iterate);
+    objectives(k) = objective;
+    lastLambda = lambda;
+    ++solved;
+  }
+
+  // Only keep the solutions that were computed.
+  if (solved < pathLambdas.n_elem)
+  {
+    pathLambdas.resize(solved);
+    path.resize(iterate.n_rows, iterate.n_cols, solved);
+    objectives.resize(solved);
+    activeFeatures.resize(solved);
+  }
+
+  Callback::EndOptimization(*this, function, iterate, callbacks...);
+  return objective;
+}
+
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+bool RegularizationPath::Descend(
+    FunctionType& function,
+    MatType& iterate,
+    const arma::uvec& features,
+    const arma::vec& factors,
+    const double lambda,
+    GradType& gradient,
+    arma::Col<typename MatType::elem_type>& column,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  bool terminate = false;
+  for (size_t pass = 0; pass != maxPasses; ++pass)
+  {
+    ElemType maxChange = 0;
+    for (size_t p = 0; p < features.n_elem; ++p)
+    {
+      const size_t j = features(p);
+      PartialGradientColumn(function, iterate, j, gradient, column);
+      terminate |= Callback::Gradient(*this, function, iterate, column,
+          callbacks...);
+
+      // The proximal operator of the elastic net penalty: soft thresholding
+      // and shrinkage.
+      const ElemType threshold = ElemType(stepSize * lambda * alpha *
+          factors(j));
+      const ElemType shrinkage = ElemType(1.0 + stepSize * lambda *
+          (1.0 - alpha) * factors(j));
+      for (size_t r = 0; r < iterate.n_rows; ++r)
+      {
+        const ElemType value = iterate(r, j) - ElemType(stepSize) * column(r);
+        const ElemType newValue = (value > threshold) ?
+            (value - threshold) / shrinkage : (value < -threshold) ?
+            (value + threshold) / shrinkage : ElemType(0);
+        maxChange = std::max(maxChange, std::abs(newValue - iterate(r, j)));
+        iterate(r, j) = newValue;
+      }
+      ++updates;
+
+      terminate |= Callback::StepTaken(*this, function, iterate,
+          callbacks...);
+      if (terminate)
+        return true;
+    }
+
+    if (maxChange < tolerance)
+      break;
+  }
+
+  return false;
+}
+
+template<typename FunctionType, typename MatType, typename GradType>
+void RegularizationPath::Scores(FunctionType& function,
+                                const MatType& iterate,
+                                GradType& gradient,
+                                arma::Col<typename MatType::elem_type>& column,
+                                arma::vec& scores)
+{
+  for (size_t j = 0; j < scores.n_elem; ++j)
+  {
+    PartialGradientColumn(function, iterate, j, gradient, column);
+    scores(j) = (column.n_elem == 0) ? 0.0 : double(arma::max(
+        arma::abs(column)));
+  }
+}
+
+} // namespace ens
+
+#endif
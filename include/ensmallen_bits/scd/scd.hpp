@@ -15,6 +15,7 @@
 #include "descent_policies/cyclic_descent.hpp"
 #include "descent_policies/random_descent.hpp"
 #include "descent_policies/greedy_descent.hpp"
+#include "shotgun_coordinates.hpp"
 
 namespace ens {
 
@@ -46,6 +47,14 @@ namespace ens {
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
  *
+ * If ParallelCoordinates() is set to P > 1, each iteration selects P
+ * coordinates with the descent policy (duplicates are only updated once),
+ * computes their partial gradients at the same point on separate OpenMP
+ * threads, and then applies all of the updates, as in the Shotgun algorithm.
+ * This works well for problems whose features are nearly uncorrelated; see
+ * ShotgunCoordinates() for an estimate of P.  PartialGradient() must then be
+ * safe to call concurrently.
+ *
  * @tparam DescentPolicy Descent policy to decide the order in which the
  *     coordinate for descent is selected.
  */
@@ -133,6 +142,11 @@ class SCD
   //! Modify the update interval for reporting objective.
   size_t& UpdateInterval() { return updateInterval; }
 
+  //! Get the number of coordinates updated in parallel in each iteration.
+  size_t ParallelCoordinates() const { return parallelCoordinates; }
+  //! Modify the number of coordinates updated in parallel in each iteration.
+  size_t& ParallelCoordinates() { return parallelCoordinates; }
+
   //! Get the descent policy.
   DescentPolicyType DescentPolicy() const { return descentPolicy; }
   //! Modify the descent policy.
@@ -151,6 +165,9 @@ class SCD
   //! The update interval for reporting objective and testing for convergence.
   size_t updateInterval;
 
+  //! The number of coordinates updated in parallel in each iteration.
+  size_t parallelCoordinates;
+
   //! The descent policy used to pick the coordinates for the update.
   DescentPolicyType descentPolicy;
 };
@@ -16,6 +16,8 @@
 #include "scd.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/evaluate_delta.hpp>
+#include <ensmallen_bits/utility/partial_gradient_column.hpp>
 
 namespace ens {
 
@@ -30,6 +32,7 @@ SCD<DescentPolicyType>::SCD(
     maxIterations(maxIterations),
     tolerance(tolerance),
     updateInterval(updateInterval),
+    parallelCoordinates(1),
     descentPolicy(descentPolicy)
 { /* Nothing to do */ }
 
@@ -61,7 +64,23 @@ SCD<DescentPolicyType>::Optimize(
   ElemType lastObjective = std::numeric_limits<ElemType>::max();
 
   BaseMatType& iterate = (BaseMatType&) iterateIn;
-  BaseGradType gradient;
+
+  // The coordinates of the current iteration and the columns of their partial
+  // gradients.  The full partial gradients are only used if the function has
+  // no PartialGradientColumn().
+  const size_t numCoordinates = std::max(parallelCoordinates, (size_t) 1);
+  arma::uvec features(1);
+  std::vector<BaseGradType> gradients(1);
+  std::vector<arma::Col<ElemType>> columns(1,
+      arma::Col<ElemType>(iterate.n_rows));
+
+  // If the function has EvaluateDelta(), the objective is tracked
+  // incrementally through each coordinate update, instead of evaluating the
+  // whole function every updateInterval iterations.
+  const bool useDelta = traits::HasEvaluateDeltaSignature<
+      ResolvableFunctionType, BaseMatType>::value;
+  if (useDelta)
+    overallObjective = function.Evaluate(iterate);
 
   // Controls early termination of the optimization process.
   bool terminate = false;
@@ -71,25 +90,71 @@ SCD<DescentPolicyType>::Optimize(
       callbacks...);
   for (size_t i = 1; i != maxIterations && !terminate; ++i)
   {
-    // Get the coordinate to descend on.
-    size_t featureIdx = descentPolicy.template DescentFeature<
-        ResolvableFunctionType, BaseMatType, BaseGradType>(i, iterate,
-        function);
+    if (numCoordinates == 1)
+    {
+      // Get the coordinate to descend on.
+      features(0) = descentPolicy.template DescentFeature<
+          ResolvableFunctionType, BaseMatType, BaseGradType>(i, iterate,
+          function);
+
+      // Get the partial gradient with respect to this feature.
+      PartialGradientColumn(function, iterate, features(0), gradients[0],
+          columns[0]);
+    }
+    else
+    {
+      // Get the coordinates to descend on; each is only updated once.
+      features.set_size(numCoordinates);
+      for (size_t p = 0; p < numCoordinates; ++p)
+      {
+        features(p) = descentPolicy.template DescentFeature<
+            ResolvableFunctionType, BaseMatType, BaseGradType>(
+            (i - 1) * numCoordinates + p + 1, iterate, function);
+      }
+      features = arma::unique(features);
 
-    // Get the partial gradient with respect to this feature.
-    function.PartialGradient(iterate, featureIdx, gradient);
+      // Get the partial gradients at the current point in parallel.
+      gradients.resize(features.n_elem);
+      columns.resize(features.n_elem, arma::Col<ElemType>(iterate.n_rows));
+      ParallelFor(features.n_elem, [&](const size_t p)
+      {
+        PartialGradientColumn(function, iterate, features(p), gradients[p],
+            columns[p]);
+      });
+    }
 
-    terminate |= Callback::Gradient(*this, function, iterate, overallObjective,
-        gradient, callbacks...);
+    for (size_t p = 0; p < features.n_elem; ++p)
+    {
+      const size_t featureIdx = features(p);
+      const arma::Col<ElemType>& gradient = columns[p];
+
+      terminate |= Callback::Gradient(*this, function, iterate,
+          overallObjective, gradient, callbacks...);
 
-    // Update the decision variable with the partial gradient.
-    iterate.col(featureIdx) -= stepSize * gradient.col(featureIdx);
+      // Update the decision variable with the partial gradient.
+      if (useDelta)
+      {
+        for (size_t r = 0; r < iterate.n_rows; ++r)
+        {
+          const size_t index = featureIdx * iterate.n_rows + r;
+          const ElemType newValue = iterate(index) -
+              stepSize * gradient(r);
+          overallObjective = EvaluateMove(function, iterate, index, newValue,
+              overallObjective);
+        }
+      }
+      else
+      {
+        iterate.col(featureIdx) -= stepSize * gradient;
+      }
+    }
     terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
 
     // Check for convergence.
     if (i % updateInterval == 0)
     {
-      overallObjective = function.Evaluate(iterate);
+      if (!useDelta)
+        overallObjective = function.Evaluate(iterate);
       terminate |= Callback::Evaluate(*this, function, iterate,
           overallObjective, callbacks...);
 
@@ -0,0 +1,83 @@
+/**
+ * @file shotgun_coordinates.hpp
+ *
+ * Estimate the number of coordinates that SCD can update in parallel on a
+ * dataset, as proposed for the Shotgun algorithm.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SCD_SHOTGUN_COORDINATES_HPP
+#define ENSMALLEN_SCD_SHOTGUN_COORDINATES_HPP
+
+namespace ens {
+
+/**
+ * Estimate how many coordinates of a linear model on the given data can be
+ * updated in parallel without slowing down convergence.  For features
+ * normalized to unit length, Bradley et al. show that up to d / rho
+ * coordinates can be updated at the same time, where d is the number of
+ * features and rho is the spectral radius of the correlation matrix of the
+ * features.  rho is estimated here with a few power iterations, so the result
+ * is a heuristic value for SCD::ParallelCoordinates().
+ *
+ * @code
+ * @inproceedings{Bradley2011,
+ *   author    = {Bradley, Joseph K. and Kyrola, Aapo and Bickson, Danny and
+ *                Guestrin, Carlos},
+ *   title     = {Parallel Coordinate Descent for L1-Regularized Loss
+ *                Minimization},
+ *   booktitle = {Proceedings of the 28th International Conference on Machine
+ *                Learning},
+ *   year      = {2011}
+ * }
+ * @endcode
+ *
+ * @param data Dataset with one point per column, so each row holds the values
+ *     of one feature.
+ * @param iterations Number of power iterations.
+ * @return Number of coordinates to update in parallel (at least 1).
+ */
+template<typename MatType>
+size_t ShotgunCoordinates(const MatType& data, const size_t iterations = 30)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (data.n_rows == 0 || data.n_cols == 0)
+    return 1;
+
+  // Scale each feature to unit length; empty features are left at zero.
+  arma::Col<ElemType> scales = arma::vectorise(arma::Mat<ElemType>(
+      arma::sum(arma::square(data), 1)));
+  scales.transform([](const ElemType x)
+      { return (x > 0) ? 1 / std::sqrt(x) : ElemType(0); });
+
+  // Power iteration on the correlation matrix, which is never formed.
+  arma::Col<ElemType> v(data.n_rows, arma::fill::randu);
+  ElemType rho = 0;
+  for (size_t i = 0; i < iterations; ++i)
+  {
+    const ElemType norm = arma::norm(v);
+    if (norm == 0)
+      return 1;
+    v /= norm;
+
+    const arma::Row<ElemType> projection = (v % scales).t() * data;
+    v = (data * projection.t()) % scales;
+    rho = arma::norm(v);
+  }
+
+  if (rho <= 1)
+    return data.n_rows;
+
+  // Allow for round-off errors in the estimate of rho.
+  const size_t coordinates = (size_t) std::floor(data.n_rows / rho *
+      (1 + 1e-6));
+  return std::min((size_t) data.n_rows, std::max((size_t) 1, coordinates));
+}
+
+} // namespace ens
+
+#endif
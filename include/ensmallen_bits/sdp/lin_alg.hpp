@@ -150,6 +150,172 @@ inline void SymKronId(const MatAType& A, MatBType& op)
   }
 }
 
+/**
+ * Compute the largest eigenvalue of a symmetric n x n operator that is only
+ * available through products with vectors, with the Lanczos method and full
+ * reorthogonalization.  Each iteration costs one product and O(nk) for k
+ * iterations.  The iteration stops when the residual bound of the largest Ritz
+ * value is below tolerance * max(1, |lambda|), or when the Krylov subspace is
+ * invariant.  The start vector is a fixed low-discrepancy sequence, so the
+ * result does not depend on (or change) the state of the random number
+ * generator.
+ *
+ * @param op Operator; op(v, out) must store the product with v in out.
+ * @param n Size of the operator.
+ * @param lambda Output largest eigenvalue.
+ * @param eigvec Output unit eigenvector (Ritz vector) of the eigenvalue.
+ * @param maxIterations Maximum number of Lanczos iterations.
+ * @param tolerance Relative tolerance of the residual bound.
+ * @return Whether or not the eigenvalue converged.
+ */
+template<typename OperatorType>
+inline bool LanczosLargestEigenvalue(const OperatorType& op,
+                                     const size_t n,
+                                     double& lambda,
+                                     arma::vec& eigvec,
+                                     const size_t maxIterations = 100,
+                                     const double tolerance = 1e-10)
+{
+  const size_t k = std::min(n, maxIterations);
+  arma::mat v(n, k + 1);
+  arma::vec alpha(k), beta(k);
+
+  // Start from the fractional parts of multiples of the golden ratio, shifted
+  // to have a nonzero mean: unlike a constant vector, this is very unlikely to
+  // be orthogonal to the eigenvector we are looking for.
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double g = 0.6180339887498949 * (i + 1);
+    v(i, 0) = 0.5 + (g - std::floor(g));
+  }
+  v.col(0) = arma::normalise(v.col(0));
+  arma::vec w;
+  arma::vec theta;
+  arma::mat s;
+  for (size_t j = 0; j < k; ++j)
+  {
+    op(arma::vec(v.col(j)), w);
+    alpha(j) = arma::dot(w, v.col(j));
+
+    // Full reorthogonalization against all the previous Lanczos vectors.
+    w -= v.cols(0, j) * (v.cols(0, j).t() * w);
+    w -= v.cols(0, j) * (v.cols(0, j).t() * w);
+    beta(j) = arma::norm(w);
+
+    arma::mat t = arma::diagmat(alpha.head(j + 1));
+    if (j > 0)
+    {
+      t.diag(1) = beta.head(j);
+      t.diag(-1) = beta.head(j);
+    }
+
+    if (!arma::eig_sym(theta, s, t))
+      return false;
+
+    lambda = theta(j);
+    const double residual = beta(j) * std::abs(s(j, j));
+    if (residual <= tolerance * std::max(1.0, std::abs(lambda)) ||
+        j + 1 == n)
+    {
+      eigvec = v.cols(0, j) * s.col(j);
+      return true;
+    }
+
+    v.col(j + 1) = w / beta(j);
+  }
+
+  if (k > 0)
+    eigvec = v.cols(0, k - 1) * s.col(k - 1);
+  return false;
+}
+
+/**
+ * Compute the largest eigenvalue of a symmetric n x n operator, as above,
+ * without its eigenvector.
+ *
+ * @param op Operator; op(v, out) must store the product with v in out.
+ * @param n Size of the operator.
+ * @param lambda Output largest eigenvalue.
+ * @param maxIterations Maximum number of Lanczos iterations.
+ * @param tolerance Relative tolerance of the residual bound.
+ * @return Whether or not the eigenvalue converged.
+ */
+template<typename OperatorType>
+inline bool LanczosLargestEigenvalue(const OperatorType& op,
+                                     const size_t n,
+                                     double& lambda,
+                                     const size_t maxIterations = 100,
+                                     const double tolerance = 1e-10)
+{
+  arma::vec eigvec;
+  return LanczosLargestEigenvalue(op, n, lambda, eigvec, maxIterations,
+      tolerance);
+}
+
+/**
+ * Solve the (possibly nonsymmetric) linear system M x = b with the Jacobi
+ * preconditioned BiCGSTAB method, where M is only available through products
+ * with vectors.  The iteration stops when the residual norm is below
+ * tolerance * norm(b).
+ *
+ * @param op Operator; op(v, out) must store the product M v in out.
+ * @param inverseDiagonal Inverse of the diagonal of M (the preconditioner).
+ * @param b Right hand side.
+ * @param x Output solution.
+ * @param maxIterations Maximum number of iterations.
+ * @param tolerance Relative tolerance of the residual norm.
+ * @return Whether or not the method converged.
+ */
+template<typename OperatorType>
+inline bool BiCGStab(const OperatorType& op,
+                     const arma::vec& inverseDiagonal,
+                     const arma::vec& b,
+                     arma::vec& x,
+                     const size_t maxIterations,
+                     const double tolerance)
+{
+  x.zeros(b.n_elem);
+  const double bNorm = arma::norm(b);
+  if (bNorm == 0)
+    return true;
+
+  arma::vec r = b;
+  const arma::vec rHat = r;
+  arma::vec p(b.n_elem, arma::fill::zeros), v(b.n_elem, arma::fill::zeros);
+  arma::vec y, s, z, t;
+  double rho = 1, alpha = 1, omega = 1;
+  for (size_t i = 0; i < maxIterations; ++i)
+  {
+    const double rhoNew = arma::dot(rHat, r);
+    if (rhoNew == 0 || omega == 0)
+      return false;
+
+    p = r + (rhoNew / rho) * (alpha / omega) * (p - omega * v);
+    y = inverseDiagonal % p;
+    op(y, v);
+    alpha = rhoNew / arma::dot(rHat, v);
+
+    s = r - alpha * v;
+    if (arma::norm(s) <= tolerance * bNorm)
+    {
+      x += alpha * y;
+      return true;
+    }
+
+    z = inverseDiagonal % s;
+    op(z, t);
+    omega = arma::dot(t, s) / arma::dot(t, t);
+    x += alpha * y + omega * z;
+    r = s - omega * t;
+    if (arma::norm(r) <= tolerance * bNorm)
+      return true;
+
+    rho = rhoNew;
+  }
+
+  return false;
+}
+
 } // namespace math
 } // namespace ens
 
@@ -27,6 +27,18 @@ namespace ens {
  * LRSDP can optimize semidefinite programs.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * By default, the rank is that of the initial coordinates.  If MaxRank() is
+ * larger than that, the rank is adapted instead: after each solve, the dual
+ * slack S = C - sum_i y_i A_i of the estimated multipliers y_i is checked for
+ * positive semidefiniteness, with the Lanczos method (so S is never formed).
+ * If its smallest eigenvalue is below -RankTolerance() * max(1, max_i |y_i|),
+ * the factor is not optimal, and RankIncrement() columns are appended: the
+ * eigenvector of that eigenvalue (a descent direction) and random columns,
+ * scaled to a small fraction of the current columns.  The augmented Lagrangian
+ * optimization is then warm-started from the new factor, with the multipliers
+ * and the penalty of the previous solve.  This stops once S is positive
+ * semidefinite (up to the tolerance), or the rank reaches MaxRank().
  */
 template <typename SDPType>
 class LRSDP
@@ -75,6 +87,41 @@ class LRSDP
   typename MatType::elem_type Optimize(MatType& coordinates,
                                        CallbackTypes&&... callbacks);
 
+  /**
+   * Compute a starting point for PrimalDualSolver from the factor R returned
+   * by Optimize(), so that the interior point method only has to refine the
+   * LRSDP solution.  The primal point is X = R R^T, the multipliers y are
+   * estimated from the augmented Lagrangian, and the dual slack is
+   * Z = C - sum_i y_i A_i.  X is singular and Z is only positive semidefinite
+   * at the optimum (and may be indefinite if R is not optimal), so both are
+   * shifted into the interior of the cone:
+   *
+   *   X := R R^T + shift * sx * I,
+   *   Z := Z + (max(0, -lambda_min(Z)) + shift * sz) * I,
+   *
+   * where sx and sz are the root mean square eigenvalues of X and Z (at least
+   * 1).  The shifts keep X Z close to (shift * sx * sz) I, which is the
+   * centrality PrimalDualSolver needs.  The results can be passed directly to
+   * the PrimalDualSolver::Optimize() overload that takes initial primal and
+   * dual points.  Optimize() must have been called first.
+   *
+   * @param coordinates Factor R of the primal solution returned by Optimize().
+   * @param primal Matrix to store the primal starting point X into.
+   * @param ySparse Vector to store the multipliers of the sparse constraints
+   *     into.
+   * @param yDense Vector to store the multipliers of the dense constraints
+   *     into.
+   * @param dual Matrix to store the dual slack starting point Z into.
+   * @param shift Relative shift of X and Z into the interior of the cone.
+   */
+  template<typename MatType>
+  void GetPrimalDualPoints(const MatType& coordinates,
+                           MatType& primal,
+                           MatType& ySparse,
+                           MatType& yDense,
+                           MatType& dual,
+                           const double shift = 1e-2);
+
   //! Return the SDP that will be solved.
   const SDPType& SDP() const { return function.SDP(); }
   //! Modify the SDP that will be solved.
@@ -90,11 +137,37 @@ class LRSDP
   //! Modify the augmented Lagrangian object.
   AugLagrangian& AugLag() { return augLag; }
 
+  //! Get whether or not the function avoids forming n x n matrices (see
+  //! LRSDPFunction).
+  bool LowMemory() const { return function.LowMemory(); }
+  //! Modify whether or not the function avoids forming n x n matrices (see
+  //! LRSDPFunction).
+  bool& LowMemory() { return function.LowMemory(); }
+
   //! Get the maximum number of iterations.
   size_t MaxIterations() const { return maxIterations; }
   //! Modify the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the maximum rank of the rank-adaptive mode (0 or the initial rank to
+  //! keep the rank fixed).
+  size_t MaxRank() const { return maxRank; }
+  //! Modify the maximum rank of the rank-adaptive mode (0 or the initial rank
+  //! to keep the rank fixed).
+  size_t& MaxRank() { return maxRank; }
+
+  //! Get the number of columns added each time the rank increases.
+  size_t RankIncrement() const { return rankIncrement; }
+  //! Modify the number of columns added each time the rank increases.
+  size_t& RankIncrement() { return rankIncrement; }
+
+  //! Get the relative tolerance of the optimality check of the rank-adaptive
+  //! mode.
+  double RankTolerance() const { return rankTolerance; }
+  //! Modify the relative tolerance of the optimality check of the
+  //! rank-adaptive mode.
+  double& RankTolerance() { return rankTolerance; }
+
  private:
   //! Augmented lagrangian optimizer.
   AugLagrangian augLag;
@@ -102,6 +175,12 @@ class LRSDP
   LRSDPFunction<SDPType> function;
   //! The maximum number of iterations for optimization.
   size_t maxIterations;
+  //! The maximum rank of the rank-adaptive mode.
+  size_t maxRank;
+  //! The number of columns added each time the rank increases.
+  size_t rankIncrement;
+  //! The relative tolerance of the optimality check.
+  double rankTolerance;
 };
 
 } // namespace ens
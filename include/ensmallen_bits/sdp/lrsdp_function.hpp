@@ -29,11 +29,22 @@ namespace ens {
  * R(coordinates) matrix. So, be careful while using LRSDP with some other
  * optimizer. You may need to modify caching process of R * R^T matrix.
  * See EvaluateImpl() in lrsdp_function_impl.hpp for more details.
+ *
+ * The cached R * R^T matrix and the matrix S = C - sum_i y_i A_i of the
+ * gradient are dense n x n matrices, even if R is a skinny n x r matrix.  If
+ * LowMemory() is set to true, neither is formed: each constraint is evaluated
+ * as Tr(A_i R R^T) = <A_i R, R>, with only the entries of R R^T at the
+ * nonzeros of the stacked sparse constraints, and the gradient is computed as
+ * 2 (C R - sum_i y_i A_i R).  The memory used is then O(nnz(A) + n r) for
+ * sparse C and A_i, and the time O(nnz(A) r) per evaluation.
  */
 template<typename SDPType>
 class LRSDPFunction
 {
  public:
+  //! The element type of the sparse constraint matrices.
+  typedef typename SDPType::SparseConstraintType::elem_type SparseElemType;
+
   /**
    * Construct the LRSDPFunction from the given SDP.
    *
@@ -85,6 +96,16 @@ class LRSDPFunction
       const size_t index,
       const MatType& coordinates) const;
 
+  /**
+   * Evaluate all constraints of the LRSDP at the given coordinates, using the
+   * cached R*R^T matrix (and the stacked sparse constraint matrix, if it
+   * matches the SDP).
+   */
+  template<typename MatType>
+  void EvaluateConstraints(
+      const MatType& coordinates,
+      arma::Col<typename MatType::elem_type>& constraints) const;
+
   /**
    * Evaluate the gradient of a particular constraint of the LRSDP at the given
    * coordinates.
@@ -128,6 +149,28 @@ class LRSDPFunction
   //! Get the Any object for rrt.
   Any& RRTAny() { return rrt; }
 
+  //! Get whether or not R * R^T and S are never formed (see above).
+  bool LowMemory() const { return lowMemory; }
+  //! Modify whether or not R * R^T and S are never formed (see above).
+  bool& LowMemory() { return lowMemory; }
+
+  /**
+   * Stack the sparse constraint matrices of the SDP into a single sparse matrix
+   * whose i'th column is vec(A_i) (see SDP::PackSparseConstraints()).  When
+   * AugLagrangian is used, the values of all sparse constraints and their
+   * contribution to the gradient are then each computed with a single sparse
+   * matrix-vector product instead of one product per constraint.
+   * LRSDP::Optimize() calls this automatically; if the sparse constraints are
+   * modified afterwards, it must be called again.  If the stacked matrix does
+   * not match the number of sparse constraints, the constraints are evaluated
+   * one at a time (in parallel).
+   */
+  void StackSparseConstraints() { sdp.PackSparseConstraints(); }
+
+  //! Get the stacked sparse constraint matrix.
+  const arma::SpMat<SparseElemType>& StackedSparseA() const
+  { return sdp.PackedSparseA(); }
+
  private:
   //! SDP object representing the problem
   SDPType sdp;
@@ -137,6 +180,9 @@ class LRSDPFunction
 
   //! Cache R*R^T matrix.
   Any rrt;
+
+  //! If true, the constraints and the gradient are computed from R only.
+  bool lowMemory;
 };
 
 // Declare specializations in lrsdp_function.cpp.
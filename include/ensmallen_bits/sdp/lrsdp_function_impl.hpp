@@ -23,7 +23,8 @@ LRSDPFunction<SDPType>::LRSDPFunction(
     const SDPType& sdp,
     const arma::Mat<typename SDPType::ElemType>& initialPoint):
     sdp(sdp),
-    initialPoint(initialPoint)
+    initialPoint(initialPoint),
+    lowMemory(false)
 {
   if (initialPoint.n_rows < initialPoint.n_cols)
   {
@@ -39,7 +40,8 @@ LRSDPFunction<SDPType>::LRSDPFunction(
     const size_t numDenseConstraints,
     const arma::Mat<typename SDPType::ElemType>& initialPoint):
     sdp(initialPoint.n_rows, numSparseConstraints, numDenseConstraints),
-    initialPoint(initialPoint)
+    initialPoint(initialPoint),
+    lowMemory(false)
 {
   if (initialPoint.n_rows < initialPoint.n_cols)
   {
@@ -58,11 +60,14 @@ LRSDPFunction<SDPType>::~LRSDPFunction()
 template<typename SDPType>
 template<typename MatType>
 typename MatType::elem_type LRSDPFunction<SDPType>::Evaluate(
-    const MatType& /* coordinates */) const
+    const MatType& coordinates) const
 {
   // Note: We don't require to update the R*R^T matrix here as the current
   // function is only used by AugLagrangian, which do not update the coordinates
   // matrix.
+  if (lowMemory)
+    return trace((trans(coordinates) * SDP().C()) * coordinates);
+
   return arma::accu(SDP().C() % rrt.As<MatType>());
 }
 
@@ -85,8 +90,14 @@ typename MatType::elem_type LRSDPFunction<SDPType>::EvaluateConstraint(
   // function is only used by AugLagrangian, which do not update the coordinates
   // matrix.
 
+  // In low-memory mode, Tr(A_i * (R R^T)) is the sum of (A_i R) % R.
+  if (index < SDP().NumSparseConstraints() && lowMemory)
+  {
+    return accu((SDP().SparseA()[index] * coordinates) % coordinates) -
+        SDP().SparseB()[index];
+  }
   // Using cached R*R^T gives better optimization for sparse matrices.
-  if (index < SDP().NumSparseConstraints())
+  else if (index < SDP().NumSparseConstraints())
   {
     return accu(SDP().SparseA()[index] % rrt.As<MatType>()) -
         SDP().SparseB()[index];
@@ -120,53 +131,308 @@ void UpdateRRT(LRSDPFunction<SDPType>& function,
   function.template RRT<MatType>() = std::move(newrrt);
 }
 
-//! Utility function for calculating part of the objective when AugLagrangian is
-//! used with an LRSDPFunction.
+//! Utility function for computing the values Tr(A_i * (R R^T)) - b_i of a set
+//! of constraints.  The constraints are independent, so they are computed in
+//! parallel.
 template <typename MatrixType, typename VecType, typename MatType>
 static inline void
-UpdateObjective(typename MatType::elem_type& objective,
-                const MatType& rrt,
-                const std::vector<MatrixType>& ais,
-                const VecType& bis,
+ConstraintValues(arma::Col<typename MatType::elem_type>& values,
+                 const MatType& rrt,
+                 const std::vector<MatrixType>& ais,
+                 const VecType& bis)
+{
+  values.set_size(ais.size());
+
+  // Here taking R^T * A first is not recommended as we are already
+  // using pre-computed R * R^T. Taking R^T * A first will result in increase
+  // in number of computations.
+  ParallelFor(ais.size(), [&](const size_t i)
+  {
+    values[i] = arma::accu(ais[i] % rrt) - bis[i];
+  });
+}
+
+//! Utility function for computing the values of all sparse constraints at once
+//! from the stacked matrix whose i'th column is vec(A_i), with a single
+//! sparse matrix-vector product.
+template <typename ElemType, typename VecType, typename MatType>
+static inline void
+StackedConstraintValues(arma::Col<typename MatType::elem_type>& values,
+                        const MatType& rrt,
+                        const arma::SpMat<ElemType>& stackedAis,
+                        const VecType& bis)
+{
+  PackedConstraintValues(values, rrt, stackedAis);
+  for (size_t i = 0; i < values.n_elem; ++i)
+    values[i] -= bis[i];
+}
+
+//! Utility function for computing the values Tr(A_i * (R R^T)) - b_i of a set
+//! of constraints without R R^T, as the sums of the elements of (A_i R) % R.
+//! The constraints are independent, so they are computed in parallel.
+template <typename MatrixType, typename VecType, typename MatType>
+static inline void
+LowMemoryConstraintValues(arma::Col<typename MatType::elem_type>& values,
+                          const MatType& coordinates,
+                          const std::vector<MatrixType>& ais,
+                          const VecType& bis)
+{
+  values.set_size(ais.size());
+  ParallelFor(ais.size(), [&](const size_t i)
+  {
+    values[i] = arma::accu((ais[i] * coordinates) % coordinates) - bis[i];
+  });
+}
+
+//! Utility function for computing the values of all sparse constraints from
+//! the stacked constraint matrix without R R^T: each nonzero (r, c) of A_i
+//! only needs the entry (R R^T)(r, c), the dot product of the rows r and c of
+//! R, which are the columns of rt = R^T.
+template <typename ElemType, typename VecType, typename MatType>
+static inline void
+LowMemoryStackedConstraintValues(arma::Col<typename MatType::elem_type>& values,
+                                 const MatType& rt,
+                                 const arma::SpMat<ElemType>& stackedAis,
+                                 const VecType& bis)
+{
+  typedef typename MatType::elem_type RElemType;
+
+  const size_t n = rt.n_cols;
+  const size_t rank = rt.n_rows;
+  stackedAis.sync();
+  values.set_size(stackedAis.n_cols);
+  ParallelFor(stackedAis.n_cols, [&](const size_t i)
+  {
+    RElemType value = 0;
+    for (size_t k = stackedAis.col_ptrs[i]; k < stackedAis.col_ptrs[i + 1];
+        ++k)
+    {
+      const size_t location = stackedAis.row_indices[k];
+      const RElemType* x = rt.colptr(location % n);
+      const RElemType* y = rt.colptr(location / n);
+      RElemType entry = 0;
+      for (size_t j = 0; j < rank; ++j)
+        entry += x[j] * y[j];
+      value += RElemType(stackedAis.values[k]) * entry;
+    }
+    values[i] = value - bis[i];
+  });
+}
+
+//! Utility function for calculating part of the objective when AugLagrangian is
+//! used with an LRSDPFunction, given the values of the constraints.
+template <typename ElemType>
+static inline void
+UpdateObjective(ElemType& objective,
+                const arma::Col<ElemType>& constraints,
                 const arma::vec& lambda,
                 const size_t lambdaOffset,
                 const double sigma)
 {
-  for (size_t i = 0; i < ais.size(); ++i)
+  for (size_t i = 0; i < constraints.n_elem; ++i)
   {
-    // Take the trace subtracted by the b_i.
-    // Here taking R^T * A first is not recommended as we are already
-    // using pre-computed R * R^T. Taking R^T * A first will result in increase
-    // in number of computations.
-    const double constraint = arma::accu(ais[i] % rrt) - bis[i];
-    objective -= (lambda[lambdaOffset + i] * constraint);
-    objective += (sigma / 2.) * constraint * constraint;
+    objective -= (lambda[lambdaOffset + i] * constraints[i]);
+    objective += (sigma / 2.) * constraints[i] * constraints[i];
   }
 }
 
+//! Utility function for calculating the multipliers
+//! y'_i = y_i - sigma * (Tr(A_i * (R R^T)) - b_i) of a set of constraints.
+template <typename ElemType>
+static inline void
+UpdateMultipliers(arma::Col<ElemType>& y,
+                  const arma::Col<ElemType>& constraints,
+                  const arma::vec& lambda,
+                  const size_t lambdaOffset,
+                  const double sigma)
+{
+  y.set_size(constraints.n_elem);
+  for (size_t i = 0; i < constraints.n_elem; ++i)
+    y[i] = lambda[lambdaOffset + i] - sigma * constraints[i];
+}
+
 //! Utility function for calculating part of the gradient when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType, typename VecType, typename MatType>
+//! used with an LRSDPFunction: s -= sum_i y'_i A_i.  The constraints are split
+//! into one range per thread, and the sums of the ranges are combined with
+//! ParallelReduce().
+template <typename MatrixType, typename MatType>
 static inline void
 UpdateGradient(MatType& s,
-               const MatType& rrt,
                const std::vector<MatrixType>& ais,
-               const VecType& bis,
-               const arma::vec& lambda,
-               const size_t lambdaOffset,
-               const double sigma)
+               const arma::Col<typename MatType::elem_type>& y)
+{
+  const size_t rangeSize = RangeSize(ais.size());
+  MatType zero;
+  zero.zeros(s.n_rows, s.n_cols);
+  s -= ParallelReduce(NumRanges(ais.size(), rangeSize), zero,
+      [&](const size_t r) -> MatType
+      {
+        const size_t begin = r * rangeSize;
+        const size_t end = std::min(begin + rangeSize, ais.size());
+
+        MatType sum = zero;
+        for (size_t i = begin; i < end; ++i)
+          sum += y[i] * ais[i];
+        return sum;
+      },
+      [](MatType sum, const MatType& rangeSum) -> MatType
+      {
+        sum += rangeSum;
+        return sum;
+      });
+}
+
+//! Utility function for calculating the sparse part of the gradient from the
+//! stacked constraint matrix, with a single sparse matrix-vector product.
+template <typename ElemType, typename MatType>
+static inline void
+StackedUpdateGradient(MatType& s,
+                      const arma::SpMat<ElemType>& stackedAis,
+                      const arma::Col<typename MatType::elem_type>& y)
+{
+  AddPackedConstraints(s, stackedAis, y, -1.0);
+}
+
+//! Utility function for calculating part of the gradient in low-memory mode:
+//! g -= sum_i y'_i A_i R, with one sparse- or dense-times-skinny product per
+//! constraint.
+template <typename MatrixType, typename MatType>
+static inline void
+LowMemoryUpdateGradient(MatType& g,
+                        const MatType& coordinates,
+                        const std::vector<MatrixType>& ais,
+                        const arma::Col<typename MatType::elem_type>& y)
 {
   for (size_t i = 0; i < ais.size(); ++i)
+    g -= y[i] * (ais[i] * coordinates);
+}
+
+//! Utility function for calculating the sparse part of the gradient in
+//! low-memory mode from the stacked constraint matrix: each nonzero (r, c) of
+//! A_i subtracts y'_i A_i(r, c) times the row c of R from the row r of g.  The
+//! rows are the columns of the transposed matrices gt and rt.
+template <typename ElemType, typename MatType>
+static inline void
+LowMemoryStackedUpdateGradient(MatType& gt,
+                               const MatType& rt,
+                               const arma::SpMat<ElemType>& stackedAis,
+                               const arma::Col<typename MatType::elem_type>& y)
+{
+  typedef typename MatType::elem_type RElemType;
+
+  const size_t n = rt.n_cols;
+  const size_t rank = rt.n_rows;
+  stackedAis.sync();
+  for (size_t i = 0; i < stackedAis.n_cols; ++i)
   {
-    // Here taking R^T * A first is not recommended as we are already
-    // using pre-computed R * R^T. Taking R^T * A first will result in increase
-    // in number of computations.
-    const double constraint = arma::accu(ais[i] % rrt) - bis[i];
-    const double y = lambda[lambdaOffset + i] - sigma * constraint;
-    s -= y * ais[i];
+    for (size_t k = stackedAis.col_ptrs[i]; k < stackedAis.col_ptrs[i + 1];
+        ++k)
+    {
+      const size_t location = stackedAis.row_indices[k];
+      const RElemType w = y[i] * RElemType(stackedAis.values[k]);
+      RElemType* g = gt.colptr(location % n);
+      const RElemType* x = rt.colptr(location / n);
+      for (size_t j = 0; j < rank; ++j)
+        g[j] -= w * x[j];
+    }
   }
 }
 
+//! Return whether the stacked sparse constraint matrix of the function matches
+//! its SDP, so that it can be used instead of the individual matrices.
+template<typename SDPType>
+static inline bool UseStackedSparseA(const LRSDPFunction<SDPType>& function)
+{
+  return function.SDP().HasPackedSparseA();
+}
+
+//! Utility function for computing the values of the sparse constraints in
+//! low-memory mode.
+template<typename SDPType, typename MatType>
+static inline void
+LowMemorySparseConstraintValues(
+    const LRSDPFunction<SDPType>& function,
+    const MatType& coordinates,
+    arma::Col<typename MatType::elem_type>& constraints)
+{
+  if (UseStackedSparseA(function))
+  {
+    const MatType rt = trans(coordinates);
+    LowMemoryStackedConstraintValues(constraints, rt,
+        function.StackedSparseA(), function.SDP().SparseB());
+  }
+  else
+  {
+    LowMemoryConstraintValues(constraints, coordinates,
+        function.SDP().SparseA(), function.SDP().SparseB());
+  }
+}
+
+//! The augmented Lagrangian objective in low-memory mode: as EvaluateImpl(),
+//! but without R*R^T.
+template<typename SDPType, typename MatType>
+static inline double
+LowMemoryEvaluateImpl(const LRSDPFunction<SDPType>& function,
+                      const MatType& coordinates,
+                      const arma::vec& lambda,
+                      const double sigma)
+{
+  typename MatType::elem_type objective =
+      trace((trans(coordinates) * function.SDP().C()) * coordinates);
+
+  arma::Col<typename MatType::elem_type> constraints;
+  LowMemorySparseConstraintValues(function, coordinates, constraints);
+  UpdateObjective(objective, constraints, lambda, 0, sigma);
+
+  LowMemoryConstraintValues(constraints, coordinates, function.SDP().DenseA(),
+      function.SDP().DenseB());
+  UpdateObjective(objective, constraints, lambda,
+      function.SDP().NumSparseConstraints(), sigma);
+
+  return objective;
+}
+
+//! The augmented Lagrangian gradient in low-memory mode: as GradientImpl(),
+//! but 2 * S' * R is computed as 2 * (C R - sum_i y'_i A_i R), without S'.
+template<typename SDPType, typename MatType, typename GradType>
+static inline void
+LowMemoryGradientImpl(const LRSDPFunction<SDPType>& function,
+                      const MatType& coordinates,
+                      const arma::vec& lambda,
+                      const double sigma,
+                      GradType& gradient)
+{
+  MatType g = function.SDP().C() * coordinates;
+
+  arma::Col<typename MatType::elem_type> constraints, y;
+  if (UseStackedSparseA(function))
+  {
+    const MatType rt = trans(coordinates);
+    LowMemoryStackedConstraintValues(constraints, rt,
+        function.StackedSparseA(), function.SDP().SparseB());
+    UpdateMultipliers(y, constraints, lambda, 0, sigma);
+
+    MatType gt(rt.n_rows, rt.n_cols, arma::fill::zeros);
+    LowMemoryStackedUpdateGradient(gt, rt, function.StackedSparseA(), y);
+    g += trans(gt);
+  }
+  else
+  {
+    LowMemoryConstraintValues(constraints, coordinates,
+        function.SDP().SparseA(), function.SDP().SparseB());
+    UpdateMultipliers(y, constraints, lambda, 0, sigma);
+    LowMemoryUpdateGradient(g, coordinates, function.SDP().SparseA(), y);
+  }
+
+  LowMemoryConstraintValues(constraints, coordinates, function.SDP().DenseA(),
+      function.SDP().DenseB());
+  UpdateMultipliers(y, constraints, lambda,
+      function.SDP().NumSparseConstraints(), sigma);
+  LowMemoryUpdateGradient(g, coordinates, function.SDP().DenseA(), y);
+
+  gradient = 2 * g;
+}
+
 template<typename SDPType, typename MatType>
 static inline double
 EvaluateImpl(LRSDPFunction<SDPType>& function,
@@ -174,6 +440,9 @@ EvaluateImpl(LRSDPFunction<SDPType>& function,
              const arma::vec& lambda,
              const double sigma)
 {
+  if (function.LowMemory())
+    return LowMemoryEvaluateImpl(function, coordinates, lambda, sigma);
+
   // We can calculate the entire objective in a smart way.
   // L(R, y, s) = Tr(C * (R R^T)) -
   //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
@@ -211,10 +480,22 @@ EvaluateImpl(LRSDPFunction<SDPType>& function,
       trace((trans(coordinates) * function.SDP().C()) * coordinates);
 
   // Now each constraint.
-  UpdateObjective(objective, function.template RRT<MatType>(),
-      function.SDP().SparseA(), function.SDP().SparseB(), lambda, 0, sigma);
-  UpdateObjective(objective, function.template RRT<MatType>(),
-      function.SDP().DenseA(), function.SDP().DenseB(), lambda,
+  arma::Col<typename MatType::elem_type> constraints;
+  if (UseStackedSparseA(function))
+  {
+    StackedConstraintValues(constraints, function.template RRT<MatType>(),
+        function.StackedSparseA(), function.SDP().SparseB());
+  }
+  else
+  {
+    ConstraintValues(constraints, function.template RRT<MatType>(),
+        function.SDP().SparseA(), function.SDP().SparseB());
+  }
+  UpdateObjective(objective, constraints, lambda, 0, sigma);
+
+  ConstraintValues(constraints, function.template RRT<MatType>(),
+      function.SDP().DenseA(), function.SDP().DenseB());
+  UpdateObjective(objective, constraints, lambda,
       function.SDP().NumSparseConstraints(), sigma);
 
   return objective;
@@ -233,21 +514,76 @@ GradientImpl(const LRSDPFunction<SDPType>& function,
   //   with
   // S' = C - sum_{i = 1}^{m} y'_i A_i
   // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
+  if (function.LowMemory())
+  {
+    LowMemoryGradientImpl(function, coordinates, lambda, sigma, gradient);
+    return;
+  }
 
   // Directly retrieve R*R^T from cache.
   const MatType& rrt = function.template RRT<MatType>();
   MatType s(function.SDP().C());
 
-  UpdateGradient(
-      s, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateGradient(
-      s, rrt, function.SDP().DenseA(), function.SDP().DenseB(),
-      lambda, function.SDP().NumSparseConstraints(), sigma);
+  arma::Col<typename MatType::elem_type> constraints, y;
+  if (UseStackedSparseA(function))
+  {
+    StackedConstraintValues(constraints, rrt, function.StackedSparseA(),
+        function.SDP().SparseB());
+    UpdateMultipliers(y, constraints, lambda, 0, sigma);
+    StackedUpdateGradient(s, function.StackedSparseA(), y);
+  }
+  else
+  {
+    ConstraintValues(constraints, rrt, function.SDP().SparseA(),
+        function.SDP().SparseB());
+    UpdateMultipliers(y, constraints, lambda, 0, sigma);
+    UpdateGradient(s, function.SDP().SparseA(), y);
+  }
+
+  ConstraintValues(constraints, rrt, function.SDP().DenseA(),
+      function.SDP().DenseB());
+  UpdateMultipliers(y, constraints, lambda,
+      function.SDP().NumSparseConstraints(), sigma);
+  UpdateGradient(s, function.SDP().DenseA(), y);
 
   gradient = 2 * s * coordinates;
 }
 
+template<typename SDPType>
+template<typename MatType>
+void LRSDPFunction<SDPType>::EvaluateConstraints(
+    const MatType& coordinates,
+    arma::Col<typename MatType::elem_type>& constraints) const
+{
+  if (lowMemory)
+  {
+    arma::Col<typename MatType::elem_type> sparseConstraints,
+        denseConstraints;
+    LowMemorySparseConstraintValues(*this, coordinates, sparseConstraints);
+    LowMemoryConstraintValues(denseConstraints, coordinates, sdp.DenseA(),
+        sdp.DenseB());
+    constraints = arma::join_cols(sparseConstraints, denseConstraints);
+    return;
+  }
+
+  // As in EvaluateConstraint(), the cached R*R^T matrix is used.
+  const MatType& rrtMatrix = RRT<MatType>();
+  arma::Col<typename MatType::elem_type> sparseConstraints, denseConstraints;
+  if (UseStackedSparseA(*this))
+  {
+    StackedConstraintValues(sparseConstraints, rrtMatrix, StackedSparseA(),
+        sdp.SparseB());
+  }
+  else
+  {
+    ConstraintValues(sparseConstraints, rrtMatrix, sdp.SparseA(),
+        sdp.SparseB());
+  }
+  ConstraintValues(denseConstraints, rrtMatrix, sdp.DenseA(), sdp.DenseB());
+
+  constraints = arma::join_cols(sparseConstraints, denseConstraints);
+}
+
 // Template specializations for function and gradient evaluation.
 // Note that C++ does not allow partial specialization of class members,
 // so we have to go about this in a somewhat round-about way.
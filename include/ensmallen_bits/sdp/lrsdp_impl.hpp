@@ -23,25 +23,185 @@ LRSDP<SDPType>::LRSDP(const size_t numSparseConstraints,
                       const arma::Mat<typename SDPType::ElemType>& initialPoint,
                       const size_t maxIterations) :
     function(numSparseConstraints, numDenseConstraints, initialPoint),
-    maxIterations(maxIterations)
+    maxIterations(maxIterations),
+    maxRank(0),
+    rankIncrement(1),
+    rankTolerance(1e-3)
 { }
 
+/**
+ * Compute the smallest eigenvalue of the dual slack S = C - sum_i y_i A_i and
+ * its eigenvector, with the Lanczos method on -S; each iteration computes the
+ * product of S with one vector, from the constraint matrices directly.
+ */
+template<typename SDPType>
+static inline bool DualSlackMinEigenvalue(const SDPType& sdp,
+                                          const arma::vec& y,
+                                          double& lambda,
+                                          arma::vec& eigvec)
+{
+  const size_t numSparse = sdp.NumSparseConstraints();
+  auto op = [&](const arma::vec& v, arma::vec& out)
+  {
+    out = -arma::vec(sdp.C() * v);
+    for (size_t i = 0; i < numSparse; ++i)
+      out += y[i] * arma::vec(sdp.SparseA()[i] * v);
+    for (size_t i = 0; i < sdp.NumDenseConstraints(); ++i)
+      out += y[numSparse + i] * arma::vec(sdp.DenseA()[i] * v);
+  };
+
+  double negativeLambda;
+  const bool converged = math::LanczosLargestEigenvalue(op, sdp.N(),
+      negativeLambda, eigvec);
+  lambda = -negativeLambda;
+  return converged;
+}
+
 template<typename SDPType>
 template<typename MatType, typename... CallbackTypes>
 typename MatType::elem_type LRSDP<SDPType>::Optimize(
     MatType& coordinates, CallbackTypes&&... callbacks)
 {
   function.RRTAny().Clean();
-  function.RRTAny().template Set<MatType>(
-      new MatType(coordinates * coordinates.t()));
+  if (!function.LowMemory())
+  {
+    function.RRTAny().template Set<MatType>(
+        new MatType(coordinates * coordinates.t()));
+  }
+  function.StackSparseConstraints();
 
   augLag.Sigma() = 10;
   augLag.MaxIterations() = maxIterations;
   augLag.Optimize(function, coordinates, callbacks...);
 
+  while (coordinates.n_cols < maxRank && !augLag.Lambda().is_empty())
+  {
+    // Estimate the multipliers y'_i = y_i - sigma * (Tr(A_i R R^T) - b_i) of
+    // the final point; the cached R * R^T may be that of another point.
+    if (!function.LowMemory())
+    {
+      function.RRTAny().Clean();
+      function.RRTAny().template Set<MatType>(
+          new MatType(coordinates * coordinates.t()));
+    }
+    arma::Col<typename MatType::elem_type> constraints;
+    function.EvaluateConstraints(coordinates, constraints);
+    const arma::vec y = augLag.Lambda() - augLag.Sigma() *
+        arma::conv_to<arma::vec>::from(constraints);
+
+    // If S is positive semidefinite, R R^T is optimal, and a larger rank is
+    // not needed.
+    double minEigenvalue;
+    arma::vec eigvec;
+    if (!DualSlackMinEigenvalue(function.SDP(), y, minEigenvalue, eigvec) ||
+        minEigenvalue >= -rankTolerance * std::max(1.0, arma::abs(y).max()))
+      break;
+
+    // Warm-start from the current factor, with the new columns scaled to a
+    // small fraction of the norm of the current columns.
+    const size_t newColumns = std::min(std::max(rankIncrement, (size_t) 1),
+        maxRank - coordinates.n_cols);
+    const double scale = 1e-2 * std::max(arma::norm(coordinates, "fro") /
+        std::sqrt((double) std::max(coordinates.n_cols, (arma::uword) 1)),
+        1e-8);
+    MatType columns(coordinates.n_rows, newColumns);
+    columns.col(0) = arma::conv_to<arma::Col<typename MatType::elem_type>>::
+        from(scale * eigvec);
+    for (size_t c = 1; c < newColumns; ++c)
+    {
+      columns.col(c) = arma::conv_to<arma::Col<typename MatType::elem_type>>::
+          from(scale * arma::normalise(arma::randn<arma::vec>(
+          coordinates.n_rows)));
+    }
+    coordinates = arma::join_rows(coordinates, columns);
+
+    function.RRTAny().Clean();
+    if (!function.LowMemory())
+    {
+      function.RRTAny().template Set<MatType>(
+          new MatType(coordinates * coordinates.t()));
+    }
+
+    // Keep the multipliers and the penalty of the previous solve.
+    const arma::vec lambda = augLag.Lambda();
+    const double sigma = augLag.Sigma();
+    augLag.Optimize(function, coordinates, lambda, sigma, callbacks...);
+  }
+
   return function.Evaluate(coordinates);
 }
 
+template<typename SDPType>
+template<typename MatType>
+void LRSDP<SDPType>::GetPrimalDualPoints(const MatType& coordinates,
+                                         MatType& primal,
+                                         MatType& ySparse,
+                                         MatType& yDense,
+                                         MatType& dual,
+                                         const double shift)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (augLag.Lambda().is_empty())
+  {
+    throw std::logic_error("LRSDP::GetPrimalDualPoints(): Optimize() must be "
+        "called before the primal-dual points can be computed");
+  }
+
+  const SDPType& sdp = function.SDP();
+  const size_t n = sdp.N();
+  const size_t numSparse = sdp.NumSparseConstraints();
+  const size_t numDense = sdp.NumDenseConstraints();
+
+  // Estimate the multipliers y'_i = y_i - sigma * (Tr(A_i R R^T) - b_i), as in
+  // the rank-adaptive mode of Optimize().
+  function.RRTAny().Clean();
+  if (!function.LowMemory())
+  {
+    function.RRTAny().template Set<MatType>(
+        new MatType(coordinates * coordinates.t()));
+  }
+  arma::Col<ElemType> constraints;
+  function.EvaluateConstraints(coordinates, constraints);
+  const arma::vec y = augLag.Lambda() - augLag.Sigma() *
+      arma::conv_to<arma::vec>::from(constraints);
+
+  ySparse.set_size(numSparse, 1);
+  for (size_t i = 0; i < numSparse; ++i)
+    ySparse(i) = ElemType(y[i]);
+  yDense.set_size(numDense, 1);
+  for (size_t i = 0; i < numDense; ++i)
+    yDense(i) = ElemType(y[numSparse + i]);
+
+  // The dual slack Z = C - sum_i y_i A_i.
+  typedef arma::Mat<typename SDPType::ElemType> ObjectiveDenseType;
+  typedef arma::Mat<typename SDPType::SparseElemType> SparseDenseType;
+  arma::mat z = arma::conv_to<arma::mat>::from(ObjectiveDenseType(sdp.C()));
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    z -= y[i] * arma::conv_to<arma::mat>::from(
+        SparseDenseType(sdp.SparseA()[i]));
+  }
+  for (size_t i = 0; i < numDense; ++i)
+    z -= y[numSparse + i] * arma::conv_to<arma::mat>::from(sdp.DenseA()[i]);
+  z = 0.5 * (z + z.t());
+
+  // Shift X and Z into the interior of the cone.  The root mean square
+  // eigenvalue of a symmetric matrix is its Frobenius norm over sqrt(n).
+  arma::mat x = arma::conv_to<arma::mat>::from(coordinates * coordinates.t());
+  const double xScale = std::max(1.0, arma::norm(x, "fro") /
+      std::sqrt((double) n));
+  const double zScale = std::max(1.0, arma::norm(z, "fro") /
+      std::sqrt((double) n));
+  const double zMinEigenvalue = arma::eig_sym(z).min();
+
+  x.diag() += shift * xScale;
+  z.diag() += std::max(0.0, -zMinEigenvalue) + shift * zScale;
+
+  primal = arma::conv_to<MatType>::from(x);
+  dual = arma::conv_to<MatType>::from(z);
+}
+
 } // namespace ens
 
 #endif
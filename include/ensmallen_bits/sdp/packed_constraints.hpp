@@ -0,0 +1,155 @@
+/**
+ * @file packed_constraints.hpp
+ *
+ * Packed storage of the sparse constraint matrices of an SDP, and batched
+ * kernels over all of the packed constraints.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_PACKED_CONSTRAINTS_HPP
+#define ENSMALLEN_SDP_PACKED_CONSTRAINTS_HPP
+
+#include "lin_alg.hpp"
+
+namespace ens {
+
+/**
+ * Pack the given n x n sparse constraint matrices into a single n^2 x m sparse
+ * matrix whose i'th column is vec(A_i).  The compressed sparse column arrays
+ * of the packed matrix hold all of the nonzeros of the constraints in one
+ * block, and its column pointers are the offsets of each constraint in that
+ * block, so a kernel over all constraints walks contiguous memory instead of
+ * one small heap-allocated matrix per constraint.  The nonzeros of each A_i are
+ * already in column-major order, so they are not sorted again.
+ *
+ * @param ais The sparse constraint matrices.
+ * @param n Number of rows (and columns) of each constraint matrix.
+ * @param packed The packed constraint matrix.
+ */
+template<typename ElemType>
+inline void PackConstraints(const std::vector<arma::SpMat<ElemType>>& ais,
+                            const size_t n,
+                            arma::SpMat<ElemType>& packed)
+{
+  size_t nonzeros = 0;
+  for (size_t i = 0; i < ais.size(); ++i)
+    nonzeros += ais[i].n_nonzero;
+
+  arma::umat locations(2, nonzeros);
+  arma::Col<ElemType> values(nonzeros);
+  size_t k = 0;
+  for (size_t i = 0; i < ais.size(); ++i)
+  {
+    typename arma::SpMat<ElemType>::const_iterator it = ais[i].begin();
+    for (; it != ais[i].end(); ++it, ++k)
+    {
+      locations(0, k) = it.col() * n + it.row();
+      locations(1, k) = i;
+      values[k] = (*it);
+    }
+  }
+
+  packed = arma::SpMat<ElemType>(locations, values, n * n, ais.size(), false);
+}
+
+/**
+ * Compute the inner products <A_i, X> of all of the packed constraints with
+ * the given n x n matrix, as one sparse matrix-vector product vec(X)^T * P.
+ *
+ * @param values The inner products, one per constraint.
+ * @param x The matrix X.
+ * @param packed The packed constraint matrix (see PackConstraints()).
+ */
+template<typename ElemType, typename MatType>
+inline void PackedConstraintValues(
+    arma::Col<typename MatType::elem_type>& values,
+    const MatType& x,
+    const arma::SpMat<ElemType>& packed)
+{
+  typedef typename MatType::elem_type XElemType;
+
+  const arma::Row<XElemType> xRow(const_cast<XElemType*>(x.memptr()),
+      x.n_elem, false, true);
+  values = arma::trans(xRow * packed);
+}
+
+/**
+ * Add scale * sum_i y_i A_i of the packed constraints to the given n x n
+ * matrix, as one sparse matrix-vector product P * y.
+ *
+ * @param s The matrix to add to.
+ * @param packed The packed constraint matrix (see PackConstraints()).
+ * @param y The coefficient of each constraint.
+ * @param scale The factor of the sum.
+ */
+template<typename ElemType, typename MatType>
+inline void AddPackedConstraints(
+    MatType& s,
+    const arma::SpMat<ElemType>& packed,
+    const arma::Col<typename MatType::elem_type>& y,
+    const double scale = 1.0)
+{
+  typedef typename MatType::elem_type SElemType;
+
+  const arma::Col<SElemType> sum = packed * y;
+  const arma::Mat<SElemType> sumMat(const_cast<SElemType*>(sum.memptr()),
+      s.n_rows, s.n_cols, false, true);
+  s += SElemType(scale) * sumMat;
+}
+
+/**
+ * Form the m x n(n + 1) / 2 matrix whose i'th row is Svec(A_i)^T, for the
+ * packed symmetric constraints A_i (see math::Svec()), from a single pass over
+ * the nonzeros of the packed matrix.
+ *
+ * @param packed The packed constraint matrix (see PackConstraints()).
+ * @param n Number of rows (and columns) of each constraint matrix.
+ * @param output The matrix of the Svec() of the constraints.
+ */
+template<typename ElemType>
+inline void PackedSvecRows(const arma::SpMat<ElemType>& packed,
+                           const size_t n,
+                           arma::SpMat<ElemType>& output)
+{
+  packed.sync();
+
+  // Only the upper triangle of each constraint is kept.
+  size_t nonzeros = 0;
+  for (size_t k = 0; k < packed.n_nonzero; ++k)
+  {
+    const size_t location = packed.row_indices[k];
+    if (location % n <= location / n)
+      ++nonzeros;
+  }
+
+  arma::umat locations(2, nonzeros);
+  arma::Col<ElemType> values(nonzeros);
+  size_t j = 0;
+  for (size_t i = 0; i < packed.n_cols; ++i)
+  {
+    for (size_t k = packed.col_ptrs[i]; k < packed.col_ptrs[i + 1]; ++k)
+    {
+      const size_t location = packed.row_indices[k];
+      const size_t r = location % n;
+      const size_t c = location / n;
+      if (r > c)
+        continue;
+
+      locations(0, j) = i;
+      locations(1, j) = math::SvecIndex(r, c, n);
+      values[j] = (r == c) ? packed.values[k] :
+          ElemType(arma::datum::sqrt2) * packed.values[k];
+      ++j;
+    }
+  }
+
+  output = arma::SpMat<ElemType>(locations, values, packed.n_cols,
+      n * (n + 1) / 2);
+}
+
+} // namespace ens
+
+#endif
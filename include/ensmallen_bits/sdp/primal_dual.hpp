@@ -22,6 +22,13 @@ namespace ens {
  * PrimalDualSolver can optimize semidefinite programs.  For more details, see the
  * documentation on function types included with this distribution or on the
  * ensmallen website.
+ *
+ * If DetectBlocks() is true and the SDP has no BlockSizes(), the aggregate
+ * sparsity pattern of C and all the A_i is computed first.  If the graph of
+ * that pattern has several connected components, the SDP is permuted so that
+ * each component is a diagonal block, and solved with the block diagonal path
+ * (factorizations and eigendecompositions of each block); the solution is
+ * permuted back.
  */
 class PrimalDualSolver
 {
@@ -35,12 +42,19 @@ class PrimalDualSolver
    *      the primal coordinates, Z is the dual coordinates.)
    * @param primalInfeasTol Primal infeasibility tolerance for termination.
    * @param dualInfeasTol Dual infeasibility tolerance for termination.
+   * @param krylovConstraints Minimum number of constraints for which the KKT
+   *      system is solved iteratively with BiCGSTAB instead of factorizing the
+   *      Schur complement (0 means never).
+   * @param krylovTolerance Relative residual tolerance of the iterative KKT
+   *      solver.
    */
   PrimalDualSolver(const size_t maxIterations = 1000,
                    const double tau = 0.99,
                    const double normXzTol = 1e-7,
                    const double primalInfeasTol = 1e-7,
-                   const double dualInfeasTol = 1e-7);
+                   const double dualInfeasTol = 1e-7,
+                   const size_t krylovConstraints = 0,
+                   const double krylovTolerance = 1e-10);
 
   /**
    * Optimize the given SDP with the given initial coordinates.  To get a set of
@@ -110,6 +124,24 @@ class PrimalDualSolver
   //! Modify the dual infeasibility tolerance.
   double& DualInfeasTol() { return dualInfeasTol; }
 
+  //! Get the minimum number of constraints for the iterative KKT solver.
+  size_t KrylovConstraints() const { return krylovConstraints; }
+  //! Modify the minimum number of constraints for the iterative KKT solver (0
+  //! means never).
+  size_t& KrylovConstraints() { return krylovConstraints; }
+
+  //! Get the tolerance of the iterative KKT solver.
+  double KrylovTolerance() const { return krylovTolerance; }
+  //! Modify the tolerance of the iterative KKT solver.
+  double& KrylovTolerance() { return krylovTolerance; }
+
+  //! Get whether or not the block structure of the aggregate sparsity pattern
+  //! is detected.
+  bool DetectBlocks() const { return detectBlocks; }
+  //! Modify whether or not the block structure of the aggregate sparsity
+  //! pattern is detected.
+  bool& DetectBlocks() { return detectBlocks; }
+
  private:
   //! Maximum number of iterations to run. Set to 0 for no limit.
   size_t maxIterations;
@@ -126,6 +158,16 @@ class PrimalDualSolver
 
   //! The tolerance required on the dual constraint required before terminating.
   double dualInfeasTol;
+
+  //! The minimum number of constraints for the iterative KKT solver.
+  size_t krylovConstraints;
+
+  //! The relative residual tolerance of the iterative KKT solver.
+  double krylovTolerance;
+
+  //! Whether or not the block structure of the aggregate sparsity pattern is
+  //! detected.
+  bool detectBlocks;
 };
 
 } // namespace ens
@@ -37,16 +37,117 @@ inline PrimalDualSolver::PrimalDualSolver(const size_t maxIterations,
                                           const double tau,
                                           const double normXzTol,
                                           const double primalInfeasTol,
-                                          const double dualInfeasTol) :
+                                          const double dualInfeasTol,
+                                          const size_t krylovConstraints,
+                                          const double krylovTolerance) :
     maxIterations(maxIterations),
     tau(tau),
     normXzTol(normXzTol),
     primalInfeasTol(primalInfeasTol),
-    dualInfeasTol(dualInfeasTol)
+    dualInfeasTol(dualInfeasTol),
+    krylovConstraints(krylovConstraints),
+    krylovTolerance(krylovTolerance),
+    detectBlocks(false)
 {
   // Nothing to do.
 }
 
+// The union-find helpers of the block detection are internal, so they are kept
+// out of namespace ens.
+namespace detail {
+
+//! Return the root of the given vertex in the union-find forest, compressing
+//! the path to it.
+inline size_t FindRoot(arma::uvec& parents, size_t i)
+{
+  while (parents(i) != i)
+  {
+    parents(i) = parents(parents(i));
+    i = parents(i);
+  }
+  return i;
+}
+
+//! Join the components of the given vertices in the union-find forest.
+inline void JoinRoots(arma::uvec& parents, const size_t i, const size_t j)
+{
+  const size_t r = FindRoot(parents, i);
+  const size_t c = FindRoot(parents, j);
+  if (r != c)
+    parents(std::max(r, c)) = std::min(r, c);
+}
+
+//! Join the components of the row and column of each nonzero of the given
+//! sparse matrix.
+template<typename ElemType>
+static inline void JoinPattern(arma::uvec& parents,
+                               const arma::SpMat<ElemType>& a)
+{
+  typename arma::SpMat<ElemType>::const_iterator it = a.begin();
+  for (; it != a.end(); ++it)
+    JoinRoots(parents, it.row(), it.col());
+}
+
+//! Join the components of the row and column of each nonzero of the given
+//! dense matrix.
+template<typename ElemType>
+static inline void JoinPattern(arma::uvec& parents,
+                               const arma::Mat<ElemType>& a)
+{
+  for (size_t c = 0; c < a.n_cols; ++c)
+    for (size_t r = 0; r < a.n_rows; ++r)
+      if (a(r, c) != ElemType(0))
+        JoinRoots(parents, r, c);
+}
+
+/**
+ * Compute the connected components of the graph of the aggregate sparsity
+ * pattern of C and all the A_i of the given SDP, where i and j are adjacent if
+ * any of these matrices has a nonzero at (i, j).  The permutation lists the
+ * vertices of each component in turn, and the block sizes are the sizes of the
+ * components, in the same order.
+ *
+ * @return The number of components.
+ */
+template<typename SDPType>
+static inline size_t
+AggregateSparsityBlocks(const SDPType& sdp,
+                        arma::uvec& permutation,
+                        arma::uvec& blockSizes)
+{
+  const size_t n = sdp.N();
+  arma::uvec parents = arma::regspace<arma::uvec>(0, n - 1);
+
+  JoinPattern(parents, sdp.C());
+  for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    JoinPattern(parents, sdp.SparseA()[i]);
+  for (size_t i = 0; i < sdp.NumDenseConstraints(); ++i)
+    JoinPattern(parents, sdp.DenseA()[i]);
+
+  // Each component is numbered by its smallest vertex, so the components are
+  // ordered by their first vertex, and the vertices of each component keep
+  // their order.
+  arma::uvec component(n), componentIndex(n);
+  componentIndex.fill(n);
+  size_t numComponents = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const size_t root = FindRoot(parents, i);
+    if (componentIndex(root) == n)
+      componentIndex(root) = numComponents++;
+    component(i) = componentIndex(root);
+  }
+
+  blockSizes.zeros(numComponents);
+  for (size_t i = 0; i < n; ++i)
+    ++blockSizes(component(i));
+  permutation = arma::stable_sort_index(component);
+
+  return numComponents;
+}
+
+} // namespace detail
+
 /**
  * Compute
  *
@@ -57,6 +158,12 @@ inline PrimalDualSolver::PrimalDualSolver(const size_t maxIterations,
  *     alphahat = sup{ alphahat : A + dA is psd }
  *
  * See (2.18) of [AHO98] for more details.
+ *
+ * With the Cholesky factorization A = L L^T, 1 / alphahat is the largest
+ * eigenvalue of -L^{-1} dA L^{-T}, which is computed with the Lanczos method
+ * using two triangular solves and a product with dA per iteration, instead of
+ * forming the matrix explicitly.  If Lanczos does not converge, the full
+ * eigendecomposition is used instead.
  */
 template<typename MatType>
 static inline bool
@@ -66,16 +173,25 @@ Alpha(const MatType& a, const MatType& dA, double tau, double& alpha)
   if (!arma::chol(l, a, "lower"))
     return false;
 
-  arma::mat lInv;
-  if (!arma::inv(lInv, arma::trimatl(l)))
-    return false;
+  const arma::mat u = l.t();
+  auto op = [&](const arma::vec& v, arma::vec& out)
+  {
+    const arma::vec x = arma::solve(arma::trimatu(u), v);
+    out = -arma::solve(arma::trimatl(l), arma::vec(dA * x));
+  };
 
-  // TODO(stephentu): We only want the top eigenvalue, we should
-  // be able to do better than full eigen-decomposition.
-  arma::Col<typename MatType::elem_type> evals;
-  if (!arma::eig_sym(evals, -lInv * dA * lInv.t()))
-    return false;
-  const double alphahatInv = evals(evals.n_elem - 1);
+  double alphahatInv;
+  if (!math::LanczosLargestEigenvalue(op, l.n_rows, alphahatInv))
+  {
+    arma::mat lInv;
+    if (!arma::inv(lInv, arma::trimatl(l)))
+      return false;
+
+    arma::Col<typename MatType::elem_type> evals;
+    if (!arma::eig_sym(evals, -lInv * dA * lInv.t()))
+      return false;
+    alphahatInv = evals(evals.n_elem - 1);
+  }
   double alphahat = 1. / alphahatInv;
 
   if (alphahat < 0.)
@@ -85,23 +201,168 @@ Alpha(const MatType& a, const MatType& dA, double tau, double& alpha)
   return true;
 }
 
+/**
+ * Compute alpha as above for a block diagonal A and dA, whose blocks are
+ * [bounds(b), bounds(b + 1)).  Each block is handled separately, and blocks of
+ * size 1 only need a ratio test.
+ */
+template<typename MatType>
+static inline bool
+Alpha(const MatType& a,
+      const MatType& dA,
+      const arma::uvec& bounds,
+      double tau,
+      double& alpha)
+{
+  if (bounds.n_elem == 2)
+    return Alpha(a, dA, tau, alpha);
+
+  alpha = 1.;
+  for (size_t b = 0; b + 1 < bounds.n_elem; ++b)
+  {
+    double blockAlpha = 1.;
+    if (bounds(b + 1) - bounds(b) == 1)
+    {
+      const size_t i = bounds(b);
+      if (a(i, i) <= 0.)
+        return false;
+      if (dA(i, i) < 0.)
+        blockAlpha = std::min(1., -tau * a(i, i) / dA(i, i));
+    }
+    else
+    {
+      const arma::span block(bounds(b), bounds(b + 1) - 1);
+      if (!Alpha(MatType(a(block, block)), MatType(dA(block, block)), tau,
+          blockAlpha))
+        return false;
+    }
+
+    alpha = std::min(alpha, blockAlpha);
+  }
+
+  return true;
+}
+
+/**
+ * Compute the eigendecomposition of the block diagonal symmetric matrix z,
+ * whose blocks are [bounds(b), bounds(b + 1)), block by block.  The
+ * eigenvectors are stored in the corresponding blocks of eigvec.
+ */
+template<typename MatType>
+static inline bool
+BlockEigSym(arma::vec& eigval,
+            MatType& eigvec,
+            const MatType& z,
+            const arma::uvec& bounds)
+{
+  if (bounds.n_elem == 2)
+    return arma::eig_sym(eigval, eigvec, z);
+
+  eigval.set_size(z.n_rows);
+  eigvec.zeros(z.n_rows, z.n_rows);
+  arma::vec blockEigval;
+  MatType blockEigvec;
+  for (size_t b = 0; b + 1 < bounds.n_elem; ++b)
+  {
+    const arma::span block(bounds(b), bounds(b + 1) - 1);
+    if (!arma::eig_sym(blockEigval, blockEigvec, MatType(z(block, block))))
+      return false;
+
+    eigval(block) = blockEigval;
+    eigvec(block, block) = blockEigvec;
+  }
+
+  return true;
+}
+
 /**
  * Solve the following Lyapunov equation (for X)
  *
  *   AX + XA = H
  *
- * where A, H are symmetric matrices.
+ * where A, H are symmetric matrices, and A is positive definite.  Given the
+ * eigendecomposition A = Q diag(lambda) Q^T, the solution is
  *
- * TODO(stephentu): Note this method current uses arma's builtin arma::syl
- * method, which is overkill for this situation. See Lemma 7.2 of [AHO98] for
- * how to solve this Lyapunov equation using an eigenvalue decomposition of A.
+ *   X = Q ((Q^T H Q) ./ D) Q^T,  D_ij = lambda_i + lambda_j,
  *
+ * see Lemma 7.2 of [AHO98].  The eigendecomposition only needs to be computed
+ * once for all the equations with the same A.  If A and H are block diagonal
+ * with blocks [bounds(b), bounds(b + 1)), so is X, and each block is solved
+ * separately.
+ *
+ * @param x Output solution.
+ * @param eigvec Eigenvectors Q of A.
+ * @param denominator Sums D of pairs of eigenvalues of A.
+ * @param bounds First row of each block, followed by the size of A.
+ * @param h Right hand side.
  */
-template<typename MatType, typename AType, typename BType>
+template<typename MatType, typename BType>
 static inline void
-SolveLyapunov(MatType& x, const AType& a, const BType& h)
+SolveLyapunov(MatType& x,
+              const MatType& eigvec,
+              const MatType& denominator,
+              const arma::uvec& bounds,
+              const BType& h)
 {
-  arma::syl(x, a, a, -h);
+  if (bounds.n_elem == 2)
+  {
+    x = (eigvec.t() * MatType(h) * eigvec) / denominator;
+    x = eigvec * x * eigvec.t();
+    return;
+  }
+
+  const MatType hMat(h);
+  x.zeros(hMat.n_rows, hMat.n_cols);
+  for (size_t b = 0; b + 1 < bounds.n_elem; ++b)
+  {
+    const arma::span block(bounds(b), bounds(b + 1) - 1);
+    const MatType q = eigvec(block, block);
+    x(block, block) = q * ((q.t() * hMat(block, block) * q) /
+        denominator(block, block)) * q.t();
+  }
+}
+
+/**
+ * Form the Schur complement M = A E^(-1) F A^T of (2.15), given the columns of
+ * E^(-1) F A^T for the sparse and dense constraints.  Since we split A up into
+ * its sparse and dense components, we have to handle each block separately.
+ */
+template<typename MatType,
+         typename SparseConstraintType,
+         typename DenseConstraintType>
+static inline void
+FormSchurComplement(const SparseConstraintType& aSparse,
+                    const DenseConstraintType& aDense,
+                    const MatType& eInvFaSparseT,
+                    const MatType& eInvFaDenseT,
+                    MatType& m)
+{
+  const size_t numSparse = aSparse.n_rows;
+  const size_t numConstraints = aSparse.n_rows + aDense.n_rows;
+  m.set_size(numConstraints, numConstraints);
+  if (numSparse)
+  {
+    m.submat(arma::span(0, numSparse - 1), arma::span(0, numSparse - 1)) =
+        aSparse * eInvFaSparseT;
+    if (aDense.n_rows)
+    {
+      m.submat(arma::span(0, numSparse - 1),
+               arma::span(numSparse, numConstraints - 1)) =
+          aSparse * eInvFaDenseT;
+    }
+  }
+  if (aDense.n_rows)
+  {
+    if (numSparse)
+    {
+      m.submat(arma::span(numSparse, numConstraints - 1),
+               arma::span(0, numSparse - 1)) =
+          aDense * eInvFaSparseT;
+    }
+    m.submat(arma::span(numSparse, numConstraints - 1),
+             arma::span(numSparse, numConstraints - 1)) =
+        aDense * eInvFaDenseT;
+  }
 }
 
 /**
@@ -120,15 +381,23 @@ SolveLyapunov(MatType& x, const AType& a, const BType& h)
  *     E  = Z sym I
  *     F  = X sym I
  *
+ * The system with the Schur complement M = A E^(-1) F A^T is solved by
+ * solveSchur(rhs, dy), so that its factorization can be shared by the
+ * predictor and the corrector steps.  zEigvec and zDenominator are the
+ * eigendecomposition of Z used by SolveLyapunov(), and bounds are the bounds of
+ * its diagonal blocks.
  */
 template<typename MatType,
          typename SparseConstraintType,
-         typename DenseConstraintType>
+         typename DenseConstraintType,
+         typename SchurSolverType>
 static inline void
 SolveKKTSystem(const SparseConstraintType& aSparse,
                const DenseConstraintType& aDense,
-               const MatType& dualCoordinates,
-               const MatType& m,
+               const MatType& zEigvec,
+               const MatType& zDenominator,
+               const arma::uvec& bounds,
+               const SchurSolverType& solveSchur,
                const MatType& fMat,
                const MatType& rp,
                const MatType& rd,
@@ -146,7 +415,8 @@ SolveKKTSystem(const SparseConstraintType& aSparse,
 
   // Compute the RHS of (2.12)
   math::Smat(fMat * rd - rc, frdRcMat);
-  SolveLyapunov(eInvFrdRcMat, dualCoordinates, 2. * frdRcMat);
+  SolveLyapunov(eInvFrdRcMat, zEigvec, zDenominator, bounds,
+      2. * frdRcMat);
   math::Svec(eInvFrdRcMat, eInvFrdRc);
 
   MatType rhs = rp;
@@ -156,11 +426,7 @@ SolveKKTSystem(const SparseConstraintType& aSparse,
   if (aDense.n_rows)
     rhs(arma::span(aSparse.n_rows, numConstraints - 1), 0) += aDense * eInvFrdRc;
 
-  if (!arma::solve(dy, m, rhs, arma::solve_opts::fast))
-  {
-    throw std::logic_error("PrimalDualSolver::SolveKKTSystem(): Could not "
-        "solve KKT system.");
-  }
+  solveSchur(rhs, dy);
 
   MatType subTerm(aSparse.n_cols, 1);
   subTerm.zeros();
@@ -178,7 +444,8 @@ SolveKKTSystem(const SparseConstraintType& aSparse,
   // Compute dx from (2.13)
   math::Smat(fMat * (rd - subTerm) - rc,
       frdATdyRcMat);
-  SolveLyapunov(eInvFrdATdyRcMat, dualCoordinates, 2. * frdATdyRcMat);
+  SolveLyapunov(eInvFrdATdyRcMat, zEigvec, zDenominator, bounds,
+      2. * frdATdyRcMat);
   math::Svec(eInvFrdATdyRcMat, eInvFrdATdyRc);
   dsX = -eInvFrdATdyRc;
 
@@ -261,21 +528,101 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
         " to be symmetric positive definite.");
   }
 
+  // Solve the SDP permuted to the blocks of its aggregate sparsity pattern,
+  // if there are several of them.
+  arma::uvec permutation, blockSizes;
+  if (detectBlocks && sdp.BlockSizes().is_empty() && sdp.N() > 1 &&
+      detail::AggregateSparsityBlocks(sdp, permutation, blockSizes) > 1)
+  {
+    // P A P^T, with P(k, permutation(k)) = 1, has the element
+    // A(permutation(k), permutation(l)) at (k, l).
+    arma::umat locations(2, sdp.N());
+    locations.row(0) = arma::regspace<arma::urowvec>(0, sdp.N() - 1);
+    locations.row(1) = permutation.t();
+    const arma::SpMat<typename SDPType::ElemType> p(locations,
+        arma::ones<arma::Col<typename SDPType::ElemType>>(sdp.N()), sdp.N(),
+        sdp.N());
+    const arma::SpMat<typename MatType::elem_type> pm(locations,
+        arma::ones<arma::Col<typename MatType::elem_type>>(sdp.N()), sdp.N(),
+        sdp.N());
+
+    SDPType permuted(sdp.N(), sdp.NumSparseConstraints(),
+        sdp.NumDenseConstraints());
+    permuted.C() = typename SDPType::ObjectiveType(p * sdp.C() * p.t());
+    for (size_t i = 0; i < sdp.NumSparseConstraints(); ++i)
+    {
+      permuted.SparseA()[i] = typename SDPType::SparseConstraintType(
+          p * sdp.SparseA()[i] * p.t());
+    }
+    for (size_t i = 0; i < sdp.NumDenseConstraints(); ++i)
+    {
+      permuted.DenseA()[i] = typename SDPType::DenseConstraintType(
+          p * sdp.DenseA()[i] * p.t());
+    }
+    permuted.SparseB() = sdp.SparseB();
+    permuted.DenseB() = sdp.DenseB();
+    permuted.BlockSizes() = blockSizes;
+
+    // Only the diagonal blocks of the (positive definite) coordinates are
+    // kept, which keeps them positive definite.
+    MatType permutedCoordinates(pm * coordinates * pm.t());
+    MatType permutedDual(pm * dualCoordinates * pm.t());
+    size_t first = 0;
+    for (size_t b = 0; b < blockSizes.n_elem; ++b)
+    {
+      const size_t last = first + blockSizes(b);
+      if (first > 0)
+      {
+        permutedCoordinates.submat(first, 0, last - 1, first - 1).zeros();
+        permutedCoordinates.submat(0, first, first - 1, last - 1).zeros();
+        permutedDual.submat(first, 0, last - 1, first - 1).zeros();
+        permutedDual.submat(0, first, first - 1, last - 1).zeros();
+      }
+      first = last;
+    }
+
+    const typename MatType::elem_type objective = Optimize(permuted,
+        permutedCoordinates, ySparse, yDense, permutedDual, callbacks...);
+
+    coordinates = pm.t() * permutedCoordinates * pm;
+    dualCoordinates = pm.t() * permutedDual * pm;
+    return objective;
+  }
+
   const size_t n = sdp.N();
   const size_t n2bar = sdp.N2bar();
 
+  // First row of each diagonal block, followed by n.
+  arma::uvec bounds(sdp.BlockSizes().n_elem + 1);
+  bounds(0) = 0;
+  for (size_t b = 0; b < sdp.BlockSizes().n_elem; ++b)
+    bounds(b + 1) = bounds(b) + sdp.BlockSizes()(b);
+  if (sdp.BlockSizes().is_empty())
+  {
+    bounds.set_size(2);
+    bounds(1) = n;
+  }
+
+  if (bounds(bounds.n_elem - 1) != n)
+  {
+    throw std::logic_error("PrimalDualSolver::Optimize(): the block sizes of "
+        "the SDP must sum to its size.");
+  }
+
   // Form the A matrix in (2.7). Note we explicitly handle
-  // sparse and dense constraints separately.
+  // sparse and dense constraints separately.  The sparse constraints are used
+  // in their packed form, so that the rows of A and the sums of the sparse
+  // constraints are each formed with a single pass over all of the nonzeros.
+  arma::SpMat<typename SDPType::SparseElemType> localPackedSparseA;
+  if (!sdp.HasPackedSparseA() && sdp.NumSparseConstraints() > 0)
+    PackConstraints(sdp.SparseA(), n, localPackedSparseA);
+  const arma::SpMat<typename SDPType::SparseElemType>& packedSparseA =
+      sdp.HasPackedSparseA() ? sdp.PackedSparseA() : localPackedSparseA;
 
   typename SDPType::SparseConstraintType aSparse(sdp.NumSparseConstraints(),
                                                  n2bar);
-  typename SDPType::SparseConstraintType aiSparse;
-
-  for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
-  {
-    math::Svec(sdp.SparseA()[i], aiSparse);
-    aSparse.row(i) = aiSparse.t();
-  }
+  if (sdp.NumSparseConstraints() > 0)
+    PackedSvecRows(packedSparseA, n, aSparse);
 
   typename SDPType::DenseConstraintType aDense(sdp.NumDenseConstraints(),
                                                n2bar);
@@ -294,16 +641,80 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
   math::Svec(coordinates, sx);
   math::Svec(dualCoordinates, sz);
 
-  MatType rp, rd, rc, gk;
+  MatType rp, rd, rc;
 
-  MatType rcMat, fMat, eInvFaSparseT, eInvFaDenseT, gkMat,
-      m, dualCheck;
+  MatType rcMat, fMat, eInvFaSparseT, eInvFaDenseT, m, mL, mU, mP, dualCheck,
+      zEigvec, zDenominator;
+  arma::vec zEigval, inverseDiagonal;
 
   rp.set_size(sdp.NumConstraints(), 1);
 
   eInvFaSparseT.set_size(n2bar, sdp.NumSparseConstraints());
   eInvFaDenseT.set_size(n2bar, sdp.NumDenseConstraints());
-  m.set_size(sdp.NumConstraints(), sdp.NumConstraints());
+
+  // For large numbers of constraints, the system with the Schur complement is
+  // solved iteratively; its diagonal is used as preconditioner.
+  const size_t numSparse = sdp.NumSparseConstraints();
+  const size_t numDense = sdp.NumDenseConstraints();
+  const bool iterative = (krylovConstraints > 0 &&
+      sdp.NumConstraints() >= krylovConstraints);
+  typename SDPType::SparseConstraintType aSparseT;
+  if (iterative)
+  {
+    aSparseT = aSparse.t();
+    inverseDiagonal.set_size(sdp.NumConstraints());
+  }
+
+  // Products with the Schur complement M = A E^(-1) F A^T, without forming it.
+  auto schurProduct = [&](const arma::vec& v, arma::vec& out)
+  {
+    arma::vec w(n2bar, arma::fill::zeros);
+    if (numSparse)
+      w += eInvFaSparseT * v.head(numSparse);
+    if (numDense)
+      w += eInvFaDenseT * v.tail(numDense);
+
+    out.set_size(v.n_elem);
+    if (numSparse)
+      out.head(numSparse) = aSparse * w;
+    if (numDense)
+      out.tail(numDense) = aDense * w;
+  };
+
+  // Solve the system with the Schur complement.  Its LU factorization is
+  // computed at most once per iteration, and shared by the predictor and the
+  // corrector steps.
+  bool factorized = false;
+  auto solveSchur = [&](const MatType& rhs, MatType& dy)
+  {
+    if (iterative && !factorized)
+    {
+      arma::vec x;
+      if (math::BiCGStab(schurProduct, inverseDiagonal, arma::vec(rhs), x,
+          std::max((size_t) 100, sdp.NumConstraints()), krylovTolerance))
+      {
+        dy = x;
+        return;
+      }
+
+      Warn << "PrimalDualSolver::Optimize(): iterative solution of the KKT "
+          << "system did not converge; factorizing it instead." << std::endl;
+    }
+
+    if (!factorized)
+    {
+      FormSchurComplement(aSparse, aDense, eInvFaSparseT, eInvFaDenseT, m);
+      if (!arma::lu(mL, mU, mP, m))
+      {
+        throw std::logic_error("PrimalDualSolver::SolveKKTSystem(): Could not "
+            "solve KKT system.");
+      }
+      factorized = true;
+    }
+
+    dy = arma::solve(arma::trimatu(mU), arma::solve(arma::trimatl(mL),
+        mP * rhs));
+  };
 
   // Controls early termination of the optimization process.
   bool terminate = false;
@@ -336,56 +747,65 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
 
     math::SymKronId(coordinates, fMat);
 
+    // The Lyapunov equations with Z are solved with its eigendecomposition.
+    if (!BlockEigSym(zEigval, zEigvec, dualCoordinates, bounds))
+    {
+      Warn << "PrimalDualSolver::Optimize(): eigendecomposition of Z "
+          << "failed!  Terminating optimization.";
+
+      Callback::EndOptimization(*this, sdp, coordinates, callbacks...);
+      return primalObj;
+    }
+    zDenominator = arma::repmat(zEigval, 1, n) +
+        arma::repmat(zEigval.t(), n, 1);
+
     // We compute E^(-1) F A^T by solving Lyapunov equations.
-    // See (2.16).
-    for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
+    // See (2.16).  All of them share the eigendecomposition of Z, and they
+    // are independent, so they are solved in parallel, each into its own
+    // column.  Since X and A_i are symmetric, X A_i + A_i X = G + G^T with
+    // G = X A_i, which saves a product.
+    ParallelFor(sdp.NumSparseConstraints(), [&](const size_t i)
     {
-      SolveLyapunov(gkMat, dualCoordinates, coordinates * sdp.SparseA()[i] +
-          sdp.SparseA()[i] * coordinates);
+      const MatType g = coordinates * sdp.SparseA()[i];
+      MatType gkMat, gk;
+      SolveLyapunov(gkMat, zEigvec, zDenominator, bounds, g + g.t());
       math::Svec(gkMat, gk);
       eInvFaSparseT.col(i) = gk;
-    }
+    });
 
-    for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
+    ParallelFor(sdp.NumDenseConstraints(), [&](const size_t i)
     {
-      SolveLyapunov(gkMat, dualCoordinates, coordinates * sdp.DenseA()[i] +
-          sdp.DenseA()[i] * coordinates);
+      const MatType g = coordinates * sdp.DenseA()[i];
+      MatType gkMat, gk;
+      SolveLyapunov(gkMat, zEigvec, zDenominator, bounds, g + g.t());
       math::Svec(gkMat, gk);
       eInvFaDenseT.col(i) = gk;
-    }
+    });
 
-    // Form the M = A E^(-1) F A^T matrix (2.15)
-    //
-    // Since we split A up into its sparse and dense components,
-    // we have to handle each block separately.
-    if (sdp.NumSparseConstraints())
+    // The Schur complement M = A E^(-1) F A^T of (2.15) is factorized on the
+    // first solve of this iteration.  In the iterative case only its diagonal
+    // is needed, for the Jacobi preconditioner.
+    factorized = false;
+    if (iterative)
     {
-      m.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-               arma::span(0, sdp.NumSparseConstraints() - 1)) =
-          aSparse * eInvFaSparseT;
-      if (sdp.NumDenseConstraints())
+      for (size_t i = 0; i < numSparse; i++)
       {
-        m.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-                 arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1)) =
-            aSparse * eInvFaDenseT;
+        double d = 0;
+        for (auto it = aSparseT.begin_col(i); it != aSparseT.end_col(i); ++it)
+          d += (*it) * eInvFaSparseT(it.row(), i);
+        inverseDiagonal(i) = d;
       }
-    }
-    if (sdp.NumDenseConstraints())
-    {
-      if (sdp.NumSparseConstraints())
+      for (size_t i = 0; i < numDense; i++)
       {
-        m.submat(arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1),
-                 arma::span(0,
-                            sdp.NumSparseConstraints() - 1)) =
-            aDense * eInvFaSparseT;
+        inverseDiagonal(numSparse + i) = arma::dot(aDense.row(i),
+            eInvFaDenseT.col(i));
+      }
+
+      for (size_t i = 0; i < inverseDiagonal.n_elem; i++)
+      {
+        inverseDiagonal(i) = (inverseDiagonal(i) > 0) ?
+            1. / inverseDiagonal(i) : 1.;
       }
-      m.submat(arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1),
-               arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1)) =
-          aDense * eInvFaDenseT;
     }
 
     const typename MatType::elem_type sxdotsz = arma::dot(sx, sz);
@@ -397,13 +817,13 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
     // This solves step (1) of Section 7, the "predictor" step.
     rcMat = -0.5 * (coordinates * dualCoordinates + dualCoordinates * coordinates);
     math::Svec(rcMat, rc);
-    SolveKKTSystem(aSparse, aDense, dualCoordinates, m, fMat, rp, rd, rc, dsx,
-        dySparse, dyDense, dsz);
+    SolveKKTSystem(aSparse, aDense, zEigvec, zDenominator, bounds, solveSchur,
+        fMat, rp, rd, rc, dsx, dySparse, dyDense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
 
     // Step (2), determine step size lengths (alpha, beta)
-    bool success = Alpha(coordinates, dX, tau, alpha);
+    bool success = Alpha(coordinates, dX, bounds, tau, alpha);
     if (!success)
     {
       Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of X "
@@ -413,7 +833,7 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
       return primalObj;
     }
 
-    success = Alpha(dualCoordinates, dZ, tau, beta);
+    success = Alpha(dualCoordinates, dZ, bounds, tau, beta);
     if (!success)
     {
       Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
@@ -436,11 +856,11 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
          dX * dZ +
          dZ * dX);
     math::Svec(rcMat, rc);
-    SolveKKTSystem(aSparse, aDense, dualCoordinates, m, fMat, rp, rd, rc, dsx,
-        dySparse, dyDense, dsz);
+    SolveKKTSystem(aSparse, aDense, zEigvec, zDenominator, bounds, solveSchur,
+        fMat, rp, rd, rc, dsx, dySparse, dyDense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
-    if (!Alpha(coordinates, dX, tau, alpha))
+    if (!Alpha(coordinates, dX, bounds, tau, alpha))
     {
       Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of X "
           << "failed!  Terminating optimization.";
@@ -448,7 +868,7 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
       Callback::EndOptimization(*this, sdp, coordinates, callbacks...);
       return primalObj;
     }
-    if (!Alpha(dualCoordinates, dZ, tau, beta))
+    if (!Alpha(dualCoordinates, dZ, bounds, tau, beta))
     {
       Warn << "PrimalDualSolver::Optimize(): cholesky decomposition of Z "
           << "failed!  Terminating optimization.";
@@ -499,8 +919,12 @@ typename MatType::elem_type PrimalDualSolver::Optimize(
     // TODO(stephentu): this dual check is quite expensive,
     // maybe make it optional?
     dualCheck = dualCoordinates - sdp.C();
-    for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
-      dualCheck += ySparse(i) * sdp.SparseA()[i];
+    if (sdp.NumSparseConstraints() > 0)
+    {
+      AddPackedConstraints(dualCheck, packedSparseA,
+          arma::Col<typename MatType::elem_type>(ySparse.memptr(),
+          ySparse.n_elem, false, true));
+    }
     for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
       dualCheck += yDense(i) * sdp.DenseA()[i];
     const double dualInfeas = arma::norm(dualCheck, "fro");
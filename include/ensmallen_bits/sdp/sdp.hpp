@@ -11,6 +11,8 @@
 #ifndef ENSMALLEN_SDP_SDP_HPP
 #define ENSMALLEN_SDP_SDP_HPP
 
+#include "packed_constraints.hpp"
+
 namespace ens {
 
 /**
@@ -29,6 +31,22 @@ namespace ens {
  * The objective matrix (C) may be stored as either dense or sparse depending on
  * the ObjectiveMatrixType parameter.
  *
+ * If C and all the A_i are block diagonal, the sizes of the diagonal blocks can
+ * be given with BlockSizes(); then PrimalDualSolver keeps the coordinates block
+ * diagonal, and its factorizations and eigendecompositions are computed for
+ * each block separately.  A diagonal (LP) block of k variables is given as k
+ * blocks of size 1.  If BlockSizes() is empty, the SDP has a single block.
+ *
+ * With many small sparse constraints (e.g. the single-entry diagonal
+ * constraints of max-cut), the per-matrix overhead of SparseA() dominates the
+ * solvers.  PackSparseConstraints() packs them into the single sparse matrix
+ * PackedSparseA(), whose i'th column is vec(A_i) (see PackConstraints()); the
+ * solvers then compute <A_i, X> for all i and sum_i y_i A_i with one sparse
+ * matrix-vector product each.  SparseA() is still the definition of the
+ * constraints: the non-const SparseA() discards the packed matrix, which must
+ * then be formed again (LRSDP does this in each call to Optimize(), and
+ * PrimalDualSolver packs a local copy if it is missing).
+ *
  * @tparam ObjectiveMatrixType Should be either arma::mat or arma::sp_mat.
  */
 template<typename ObjectiveMatrixType,
@@ -51,6 +69,8 @@ class SDP
   typedef SparseConstraintMatrixType SparseConstraintType;
   //! Type of B values.
   typedef BVectorType BType;
+  //! Type of element held by the sparse constraints.
+  typedef typename SparseConstraintMatrixType::elem_type SparseElemType;
 
   /**
    * Initialize this SDP to an empty state.  To add constraints, you will have
@@ -103,8 +123,13 @@ class SDP
   { return sparseA; }
 
   //! Modify the vector of sparse A matrices (which correspond to the sparse
-  //! constraints).
-  std::vector<SparseConstraintMatrixType>& SparseA() { return sparseA; }
+  //! constraints).  This discards PackedSparseA(), so the returned reference
+  //! must not be kept and used after PackSparseConstraints() is called.
+  std::vector<SparseConstraintMatrixType>& SparseA()
+  {
+    packedSparseA.reset();
+    return sparseA;
+  }
 
   //! Return the vector of dense A matrices (which correspond to the dense
   //! constraints).
@@ -125,6 +150,37 @@ class SDP
   //! Modify the vector of dense B values.
   BVectorType& DenseB() { return denseB; }
 
+  //! Return the sizes of the diagonal blocks (empty for a single block).
+  const arma::uvec& BlockSizes() const { return blockSizes; }
+  //! Modify the sizes of the diagonal blocks (empty for a single block).  The
+  //! sizes must sum to N().
+  arma::uvec& BlockSizes() { return blockSizes; }
+
+  /**
+   * Pack the sparse constraint matrices into PackedSparseA(), whose i'th
+   * column is vec(A_i).  This must be called again after the non-const
+   * SparseA() is used.
+   */
+  void PackSparseConstraints();
+
+  //! Return the packed sparse constraint matrices (see
+  //! PackSparseConstraints()); this is empty until they are packed.
+  const arma::SpMat<SparseElemType>& PackedSparseA() const
+  { return packedSparseA; }
+  //! Modify the packed sparse constraint matrices; they must stay equal to
+  //! the packed form of SparseA(), and must be set after SparseA() is
+  //! modified.
+  arma::SpMat<SparseElemType>& PackedSparseA() { return packedSparseA; }
+
+  //! Return whether or not PackedSparseA() matches the number and size of the
+  //! sparse constraints, so that it can be used instead of SparseA().
+  bool HasPackedSparseA() const
+  {
+    return (NumSparseConstraints() > 0) &&
+        (packedSparseA.n_cols == NumSparseConstraints()) &&
+        (packedSparseA.n_rows == N() * N());
+  }
+
   /**
    * Check whether or not the constraint matrices are linearly independent.
    *
@@ -151,11 +207,16 @@ class SDP
   std::vector<SparseConstraintMatrixType> sparseA;
   //! b_i for each sparse constraint.
   BVectorType sparseB;
+  //! vec(A_i) of each sparse constraint, one per column.
+  arma::SpMat<SparseElemType> packedSparseA;
 
   //! A_i for each dense constraint.
   std::vector<DenseConstraintMatrixType> denseA;
   //! b_i for each dense constraint.
   BVectorType denseB;
+
+  //! Sizes of the diagonal blocks.
+  arma::uvec blockSizes;
 };
 
 } // namespace ens
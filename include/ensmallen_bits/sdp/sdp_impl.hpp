@@ -27,8 +27,10 @@ SDP<ObjectiveMatrixType,
     c(),
     sparseA(),
     sparseB(),
+    packedSparseA(),
     denseA(),
-    denseB()
+    denseB(),
+    blockSizes()
 { /* Nothing to do. */ }
 
 template<typename ObjectiveMatrixType,
@@ -44,8 +46,10 @@ SDP<ObjectiveMatrixType,
     c(n, n),
     sparseA(numSparseConstraints),
     sparseB(numSparseConstraints),
+    packedSparseA(),
     denseA(numDenseConstraints),
-    denseB(numDenseConstraints)
+    denseB(numDenseConstraints),
+    blockSizes()
 {
   for (size_t i = 0; i < numSparseConstraints; i++)
     sparseA[i].zeros(n, n);
@@ -53,6 +57,18 @@ SDP<ObjectiveMatrixType,
     denseA[i].zeros(n, n);
 }
 
+template<typename ObjectiveMatrixType,
+         typename DenseConstraintMatrixType,
+         typename SparseConstraintMatrixType,
+         typename BVectorType>
+void SDP<ObjectiveMatrixType,
+         DenseConstraintMatrixType,
+         SparseConstraintMatrixType,
+         BVectorType>::PackSparseConstraints()
+{
+  PackConstraints(sparseA, N(), packedSparseA);
+}
+
 template<typename ObjectiveMatrixType,
          typename DenseConstraintMatrixType,
          typename SparseConstraintMatrixType,
@@ -0,0 +1,518 @@
+/**
+ * @file sdpa.hpp
+ *
+ * Loading of SDPs in the sparse SDPA format, and a binary cached form of
+ * loaded SDPs.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SDP_SDPA_HPP
+#define ENSMALLEN_SDP_SDPA_HPP
+
+#include <ensmallen_bits/utility/mapped_matrix.hpp>
+#include <ensmallen_bits/utility/executor.hpp>
+#include "sdp.hpp"
+
+namespace ens {
+
+namespace sdpa {
+
+//! The first bytes of the binary form written by SaveSDPABinary().
+inline const char* Magic() { return "ENSSDPA1"; }
+
+//! Return whether the given character separates the tokens of an SDPA file.
+inline bool IsSeparator(const char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' ||
+      c == '{' || c == '}' || c == '(' || c == ')' || c == '=';
+}
+
+//! Move p to the start of the next token, or to end.
+inline void SkipSeparators(const char*& p, const char* end)
+{
+  while (p < end && IsSeparator(*p))
+    ++p;
+}
+
+//! Move p past the end of the current line.
+inline void SkipLine(const char*& p, const char* end)
+{
+  while (p < end && *p != '\n')
+    ++p;
+  if (p < end)
+    ++p;
+}
+
+/**
+ * Parse the next token as a number, and move p past it.  The token is copied
+ * to a terminated buffer first, so that the parse never reads past the end of
+ * the (not terminated) mapped file.
+ *
+ * @return Whether or not the token is a number.
+ */
+inline bool ParseNumber(const char*& p, const char* end, double& value)
+{
+  SkipSeparators(p, end);
+  char token[64];
+  size_t length = 0;
+  while (p < end && !IsSeparator(*p) && length + 1 < sizeof(token))
+    token[length++] = *p++;
+  token[length] = '\0';
+  if (length == 0)
+    return false;
+
+  char* tokenEnd;
+  value = std::strtod(token, &tokenEnd);
+  return (tokenEnd == token + length);
+}
+
+//! Parse the next token as an integer (see ParseNumber()).
+inline bool ParseInteger(const char*& p, const char* end, long& value)
+{
+  double number;
+  if (!ParseNumber(p, end, number) || number != std::floor(number))
+    return false;
+
+  value = (long) number;
+  return true;
+}
+
+//! One nonzero of an SDPA file: the (upper triangular) element (row, col) of
+//! the given matrix, where matrix 0 is F_0.
+struct Entry
+{
+  size_t matrix;
+  size_t row;
+  size_t col;
+  double value;
+};
+
+/**
+ * Parse the nonzeros of the lines of [begin, end), which must start at the
+ * start of a line, into the given entries.  The rows and columns are
+ * converted from (block, index within the block) to indices of the full
+ * matrices.
+ *
+ * @return Whether or not all the lines were valid.
+ */
+inline bool ParseEntries(const char* begin,
+                         const char* end,
+                         const size_t numMatrices,
+                         const std::vector<long>& blockStructure,
+                         const std::vector<size_t>& blockOffsets,
+                         std::vector<Entry>& entries)
+{
+  const char* p = begin;
+  while (true)
+  {
+    SkipSeparators(p, end);
+    if (p >= end)
+      return true;
+
+    long matrix, block, i, j;
+    double value;
+    if (!ParseInteger(p, end, matrix) || !ParseInteger(p, end, block) ||
+        !ParseInteger(p, end, i) || !ParseInteger(p, end, j) ||
+        !ParseNumber(p, end, value))
+      return false;
+
+    if (matrix < 0 || (size_t) matrix > numMatrices || block < 1 ||
+        (size_t) block > blockStructure.size())
+      return false;
+
+    const long size = std::abs(blockStructure[block - 1]);
+    if (i < 1 || j < 1 || i > size || j > size ||
+        (blockStructure[block - 1] < 0 && i != j))
+      return false;
+
+    Entry entry;
+    entry.matrix = (size_t) matrix;
+    entry.row = blockOffsets[block - 1] + std::min(i, j) - 1;
+    entry.col = blockOffsets[block - 1] + std::max(i, j) - 1;
+    entry.value = value;
+    if (value != 0.0)
+      entries.push_back(entry);
+  }
+}
+
+/**
+ * Fill the given SDP from the parsed SDPA data: C = -F_0, A_i = F_i, b = c.
+ * The nonzeros are bucketed by matrix with a counting sort, mirrored to the
+ * lower triangle, and then each matrix and the packed constraint matrix are
+ * built with one batch construction each.
+ */
+template<typename SDPType>
+inline void BuildSDP(const size_t n,
+                     const std::vector<long>& blockStructure,
+                     const arma::vec& c,
+                     const std::vector<std::vector<Entry>>& chunks,
+                     SDPType& sdp)
+{
+  typedef typename SDPType::SparseElemType SparseElemType;
+
+  const size_t m = c.n_elem;
+
+  // Count the (mirrored) nonzeros of each matrix.
+  std::vector<size_t> offsets(m + 2, 0);
+  for (size_t t = 0; t < chunks.size(); ++t)
+  {
+    for (size_t k = 0; k < chunks[t].size(); ++k)
+    {
+      const Entry& e = chunks[t][k];
+      offsets[e.matrix + 1] += (e.row == e.col) ? 1 : 2;
+    }
+  }
+  for (size_t i = 0; i <= m; ++i)
+    offsets[i + 1] += offsets[i];
+
+  arma::umat locations(2, offsets[m + 1]);
+  arma::vec values(offsets[m + 1]);
+  std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t t = 0; t < chunks.size(); ++t)
+  {
+    for (size_t k = 0; k < chunks[t].size(); ++k)
+    {
+      const Entry& e = chunks[t][k];
+      size_t& q = next[e.matrix];
+      locations(0, q) = e.row;
+      locations(1, q) = e.col;
+      values[q++] = e.value;
+      if (e.row != e.col)
+      {
+        locations(0, q) = e.col;
+        locations(1, q) = e.row;
+        values[q++] = e.value;
+      }
+    }
+  }
+
+  // Build one matrix from its range of the bucketed nonzeros; duplicates are
+  // added.
+  auto build = [&](const size_t i, const double sign)
+  {
+    const size_t first = offsets[i];
+    const size_t count = offsets[i + 1] - first;
+    arma::umat l = (count > 0) ? arma::umat(locations.cols(first,
+        first + count - 1)) : arma::umat(2, 0);
+    arma::Col<SparseElemType> v(count);
+    for (size_t k = 0; k < count; ++k)
+      v[k] = SparseElemType(sign * values[first + k]);
+    return arma::SpMat<SparseElemType>(true, l, v, n, n);
+  };
+
+  sdp = SDPType();
+  sdp.C() = typename SDPType::ObjectiveType(build(0, -1.0));
+  // The non-const SparseA() discards the packed constraints, so it is only
+  // called once, and not from the parallel tasks.
+  std::vector<typename SDPType::SparseConstraintType>& sparseA =
+      sdp.SparseA();
+  sparseA.resize(m);
+  ParallelFor(m, [&](const size_t i)
+  {
+    sparseA[i] = build(i + 1, 1.0);
+  });
+  sdp.SparseB() = arma::conv_to<typename SDPType::BType>::from(c);
+  sdp.DenseA().clear();
+  sdp.DenseB().set_size(0);
+
+  // Diagonal blocks of size k are k blocks of size 1.
+  std::vector<arma::uword> blockSizes;
+  for (size_t b = 0; b < blockStructure.size(); ++b)
+  {
+    if (blockStructure[b] > 0)
+      blockSizes.push_back(blockStructure[b]);
+    else
+      blockSizes.insert(blockSizes.end(), (size_t) -blockStructure[b],
+          (arma::uword) 1);
+  }
+  sdp.BlockSizes() = (blockSizes.size() > 1) ? arma::uvec(blockSizes) :
+      arma::uvec();
+
+  // The packed matrix of the constraints is formed from the same nonzeros,
+  // whose locations must be converted to (c * n + r, i).
+  const size_t first = offsets[1];
+  const size_t count = offsets[m + 1] - first;
+  arma::umat packedLocations(2, count);
+  arma::Col<SparseElemType> packedValues(count);
+  for (size_t i = 0; i < m; ++i)
+  {
+    for (size_t k = offsets[i + 1]; k < offsets[i + 2]; ++k)
+    {
+      packedLocations(0, k - first) = locations(1, k) * n + locations(0, k);
+      packedLocations(1, k - first) = i;
+      packedValues[k - first] = SparseElemType(values[k]);
+    }
+  }
+  sdp.PackedSparseA() = arma::SpMat<SparseElemType>(true, packedLocations,
+      packedValues, n * n, m);
+}
+
+//! Parse the SDPA text in [begin, end) into the given SDP.
+template<typename SDPType>
+inline void ParseSDPA(const char* begin,
+                      const char* end,
+                      const std::string& filename,
+                      SDPType& sdp)
+{
+  const std::string error = "LoadSDPA(): '" + filename + "' is not a valid "
+      "SDPA file: ";
+
+  // Skip the comment lines.
+  const char* p = begin;
+  while (true)
+  {
+    SkipSeparators(p, end);
+    if (p < end && (*p == '"' || *p == '*'))
+      SkipLine(p, end);
+    else
+      break;
+  }
+
+  long m, numBlocks;
+  if (!ParseInteger(p, end, m) || m < 0)
+    throw std::runtime_error(error + "invalid number of constraints.");
+  SkipLine(p, end);
+  if (!ParseInteger(p, end, numBlocks) || numBlocks < 1)
+    throw std::runtime_error(error + "invalid number of blocks.");
+  SkipLine(p, end);
+
+  std::vector<long> blockStructure(numBlocks);
+  std::vector<size_t> blockOffsets(numBlocks);
+  size_t n = 0;
+  for (long b = 0; b < numBlocks; ++b)
+  {
+    if (!ParseInteger(p, end, blockStructure[b]) || blockStructure[b] == 0)
+      throw std::runtime_error(error + "invalid block structure.");
+    blockOffsets[b] = n;
+    n += std::abs(blockStructure[b]);
+  }
+  SkipLine(p, end);
+
+  arma::vec c(m);
+  for (long i = 0; i < m; ++i)
+  {
+    if (!ParseNumber(p, end, c[i]))
+      throw std::runtime_error(error + "invalid objective vector.");
+  }
+  SkipLine(p, end);
+
+  // Split the nonzeros into one range of lines per thread, and parse the
+  // ranges in parallel.
+  const size_t numChunks = std::max((size_t) 1, std::min(MaxThreads(),
+      (size_t) (end - p) / 4096 + 1));
+  std::vector<const char*> bounds(numChunks + 1, end);
+  bounds[0] = p;
+  for (size_t t = 1; t < numChunks; ++t)
+  {
+    const char* q = std::max(bounds[t - 1], p + (end - p) * t / numChunks);
+    if (q > p && q < end && *(q - 1) != '\n')
+      SkipLine(q, end);
+    bounds[t] = q;
+  }
+
+  std::vector<std::vector<Entry>> chunks(numChunks);
+  std::vector<char> valid(numChunks, 1);
+  ParallelFor(numChunks, [&](const size_t t)
+  {
+    valid[t] = ParseEntries(bounds[t], bounds[t + 1], (size_t) m,
+        blockStructure, blockOffsets, chunks[t]) ? 1 : 0;
+  });
+  for (size_t t = 0; t < numChunks; ++t)
+  {
+    if (!valid[t])
+      throw std::runtime_error(error + "invalid matrix entry.");
+  }
+
+  BuildSDP(n, blockStructure, c, chunks, sdp);
+}
+
+} // namespace sdpa
+
+/**
+ * Load the SDP in the given file, in the sparse SDPA format, or in the binary
+ * form written by SaveSDPABinary().  An SDPA file describes the problem
+ *
+ *     max    dot(F_0, X)
+ *     s.t.   dot(F_i, X) = c_i, i = 1, ..., m, X >= 0,
+ *
+ * (the dual of the SDPA primal), which is loaded as the equivalent SDP with
+ * C = -F_0, A_i = F_i and b = c, so the objective of the solvers is the
+ * negative of the SDPA objective.  All the constraints are sparse; the
+ * constraints are also packed (see SDP::PackSparseConstraints()), and the
+ * block structure sets BlockSizes() (a diagonal block of size k is k blocks of
+ * size 1).  Only the upper triangle of each block may be given, and
+ * duplicates are added.
+ *
+ * On POSIX platforms, the text file is memory-mapped and its nonzeros are
+ * parsed in parallel, one range of lines per thread; the nonzeros are then
+ * bucketed by matrix, so each A_i and the packed matrix are formed with a
+ * single batch construction.  A std::runtime_error is thrown if the file can't
+ * be read or is not valid.
+ *
+ * @code
+ * SDP<arma::sp_mat> sdp;
+ * LoadSDPA("problem.dat-s", sdp);
+ * SaveSDPABinary("problem.bin", sdp); // Loads faster next time.
+ * @endcode
+ *
+ * @param filename The file to load.
+ * @param sdp The loaded SDP.
+ */
+template<typename SDPType>
+inline void LoadSDPA(const std::string& filename, SDPType& sdp)
+{
+  // The binary form is read directly.
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary);
+    if (!stream)
+    {
+      throw std::runtime_error("LoadSDPA(): cannot open '" + filename +
+          "' for reading.");
+    }
+
+    char magic[8] = { 0 };
+    stream.read(magic, 8);
+    if (stream && std::memcmp(magic, sdpa::Magic(), 8) == 0)
+    {
+      // The reader counts the magic for the alignment of the matrices.
+      stream.seekg(0);
+      CheckpointReader ar(stream);
+      ar.ReadBytes(magic, 8);
+
+      arma::SpMat<typename SDPType::SparseElemType> c, packed;
+      arma::vec b;
+      arma::uvec blockSizes;
+      size_t n;
+      ar(n);
+      ar(blockSizes);
+      ar(c);
+      ar(b);
+      ar(packed);
+      if (c.n_rows != n || c.n_cols != n || packed.n_rows != n * n ||
+          packed.n_cols != b.n_elem)
+      {
+        throw std::runtime_error("LoadSDPA(): '" + filename + "' is not a "
+            "valid binary SDP.");
+      }
+
+      sdp = SDPType();
+      sdp.C() = typename SDPType::ObjectiveType(c);
+      std::vector<typename SDPType::SparseConstraintType>& sparseA =
+          sdp.SparseA();
+      sparseA.resize(b.n_elem);
+      ParallelFor(b.n_elem, [&](const size_t i)
+      {
+        const size_t first = packed.col_ptrs[i];
+        const size_t count = packed.col_ptrs[i + 1] - first;
+        arma::umat locations(2, count);
+        arma::Col<typename SDPType::SparseElemType> values(count);
+        for (size_t k = 0; k < count; ++k)
+        {
+          locations(0, k) = packed.row_indices[first + k] % n;
+          locations(1, k) = packed.row_indices[first + k] / n;
+          values[k] = packed.values[first + k];
+        }
+        sparseA[i] = arma::SpMat<typename SDPType::SparseElemType>(
+            locations, values, n, n, false);
+      });
+      sdp.SparseB() = arma::conv_to<typename SDPType::BType>::from(b);
+      sdp.BlockSizes() = blockSizes;
+      sdp.PackedSparseA() = std::move(packed);
+      return;
+    }
+  }
+
+  #ifdef ENS_HAVE_MMAP
+  const int fd = open(filename.c_str(), O_RDONLY);
+  struct stat status;
+  if (fd < 0 || fstat(fd, &status) != 0)
+  {
+    if (fd >= 0)
+      close(fd);
+    throw std::runtime_error("LoadSDPA(): cannot open '" + filename +
+        "' for reading.");
+  }
+
+  const size_t length = (size_t) status.st_size;
+  if (length == 0)
+  {
+    close(fd);
+    throw std::runtime_error("LoadSDPA(): '" + filename + "' is empty.");
+  }
+
+  void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+  {
+    throw std::runtime_error("LoadSDPA(): cannot map '" + filename + "'.");
+  }
+  (void) madvise(mapped, length, MADV_SEQUENTIAL);
+
+  const char* begin = static_cast<const char*>(mapped);
+  try
+  {
+    sdpa::ParseSDPA(begin, begin + length, filename, sdp);
+  }
+  catch (...)
+  {
+    munmap(mapped, length);
+    throw;
+  }
+  munmap(mapped, length);
+  #else
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  const std::string text((std::istreambuf_iterator<char>(stream)),
+      std::istreambuf_iterator<char>());
+  sdpa::ParseSDPA(text.data(), text.data() + text.size(), filename, sdp);
+  #endif
+}
+
+/**
+ * Save the given SDP, whose constraints must all be sparse, in a binary form
+ * that LoadSDPA() reads without any parsing: the objective, the b values, the
+ * block sizes and the packed sparse constraints, in the format of
+ * CheckpointWriter.  A std::runtime_error is thrown if the file can't be
+ * written, or if the SDP has dense constraints.
+ *
+ * @param filename The file to save to.
+ * @param sdp The SDP to save.
+ */
+template<typename SDPType>
+inline void SaveSDPABinary(const std::string& filename, const SDPType& sdp)
+{
+  if (sdp.NumDenseConstraints() > 0)
+  {
+    throw std::runtime_error("SaveSDPABinary(): only SDPs with sparse "
+        "constraints can be saved.");
+  }
+
+  arma::SpMat<typename SDPType::SparseElemType> packed;
+  if (sdp.HasPackedSparseA() || sdp.NumSparseConstraints() == 0)
+    packed = sdp.PackedSparseA();
+  else
+    PackConstraints(sdp.SparseA(), sdp.N(), packed);
+  if (packed.n_rows != sdp.N() * sdp.N())
+    packed.set_size(sdp.N() * sdp.N(), sdp.NumSparseConstraints());
+
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream)
+  {
+    throw std::runtime_error("SaveSDPABinary(): cannot open '" + filename +
+        "' for writing.");
+  }
+
+  CheckpointWriter ar(stream);
+  ar.WriteBytes(sdpa::Magic(), 8);
+  ar(sdp.N());
+  ar(sdp.BlockSizes());
+  ar(arma::SpMat<typename SDPType::SparseElemType>(sdp.C()));
+  ar(arma::conv_to<arma::vec>::from(sdp.SparseB()));
+  ar(packed);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,205 @@
+/**
+ * @file importance_sampler.hpp
+ *
+ * Importance sampling of the separable functions visited by SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_IMPORTANCE_SAMPLER_HPP
+#define ENSMALLEN_SGD_IMPORTANCE_SAMPLER_HPP
+
+#include <ensmallen_bits/utility/alias_table.hpp>
+#include <ensmallen_bits/utility/batch_prefetcher.hpp>
+
+namespace ens {
+
+/**
+ * ImportanceSampler builds the minibatches of SGD with ImportanceSampling()
+ * set: each minibatch is made of functions drawn with replacement with
+ * probabilities
+ *
+ * \f[
+ * p_i = (1 - \lambda) \frac{w_i}{\sum_j w_j} + \frac{\lambda}{n},
+ * \f]
+ *
+ * from an alias table (see AliasTable), and the objective and gradient of
+ * function i are scaled by \f$ 1 / (n p_i) \f$, so that the sum over a
+ * minibatch has the same expectation as for a minibatch visited in order.  The
+ * smoothing \f$ \lambda \f$ bounds the scale of the functions with small
+ * weights.
+ *
+ * The weights \f$ w_i \f$ are either given, or estimated with the norm of the
+ * last gradient computed for each function; then the table starts uniform, and
+ * is rebuilt from the estimates after each epoch (a function that wasn't drawn
+ * yet gets the mean estimate of the others).
+ *
+ * @tparam MatType Type of the coordinates.
+ * @tparam GradType Type of the gradient.
+ */
+template<typename MatType, typename GradType>
+class ImportanceSampler
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  //! Create a sampler; Reset() must be called before use.
+  ImportanceSampler() : numFunctions(0), smoothing(0), adaptive(false) { }
+
+  /**
+   * Prepare the sampler for the given number of functions.
+   *
+   * @param numFunctions Number of functions.
+   * @param weights The weights of the functions, or an empty vector to estimate
+   *     them from the gradient norms.
+   * @param smoothing The proportion of the uniform distribution in the sampling
+   *     distribution, in [0, 1].
+   */
+  void Reset(const size_t numFunctions,
+             const arma::vec& weights,
+             const double smoothing)
+  {
+    if (smoothing < 0 || smoothing > 1)
+    {
+      throw std::invalid_argument("SGD: the sampling smoothing must be in "
+          "[0, 1]!");
+    }
+
+    if (!weights.is_empty() && weights.n_elem != numFunctions)
+    {
+      throw std::invalid_argument("SGD: the number of sampling weights must be "
+          "the number of functions!");
+    }
+
+    this->numFunctions = numFunctions;
+    this->smoothing = smoothing;
+    adaptive = weights.is_empty();
+    if (adaptive)
+    {
+      // -1 marks the functions whose gradient wasn't computed yet.
+      estimates.set_size(numFunctions);
+      estimates.fill(-1);
+      table.Reset(arma::vec(numFunctions, arma::fill::ones));
+    }
+    else
+    {
+      Rebuild(weights);
+    }
+  }
+
+  /**
+   * Compute the scaled objective and gradient of a minibatch of the given size
+   * drawn from the sampling distribution.  The functions are prepared one at a
+   * time with PrepareBatch(), if the function has that method.
+   *
+   * @param function Function to use, to prepare the functions with.
+   * @param f The function wrapped with the separable function API.
+   * @param iterate Coordinates to evaluate the function at.
+   * @param gradient The scaled gradient of the minibatch.
+   * @param batchSize Number of functions to draw.
+   * @param computeObjective Whether or not the objective is computed.
+   * @param rng Random number stream to draw the functions from.
+   * @return The scaled objective of the minibatch (0 if not computed).
+   */
+  template<typename SeparableFunctionType, typename FullFunctionType>
+  ElemType EvaluateWithGradient(SeparableFunctionType& function,
+                                FullFunctionType& f,
+                                const MatType& iterate,
+                                GradType& gradient,
+                                const size_t batchSize,
+                                const bool computeObjective,
+                                RandomStream& rng)
+  {
+    gradient.zeros(iterate.n_rows, iterate.n_cols);
+    ElemType objective = 0;
+    for (size_t k = 0; k < batchSize; ++k)
+    {
+      const size_t i = table.Sample(rng);
+      const ElemType scale = ElemType(1.0 / (numFunctions *
+          table.Probability(i)));
+
+      BatchPrefetcher<SeparableFunctionType>::PrepareNow(function, i, 1);
+      if (computeObjective)
+      {
+        objective += scale * f.EvaluateWithGradient(iterate, i,
+            functionGradient, 1);
+      }
+      else
+      {
+        f.Gradient(iterate, i, functionGradient, 1);
+      }
+
+      gradient += scale * functionGradient;
+      if (adaptive)
+        estimates[i] = arma::norm(arma::vectorise(functionGradient), 2);
+    }
+
+    return objective;
+  }
+
+  //! Rebuild the table from the estimated weights at the end of an epoch.
+  void EndEpoch()
+  {
+    if (!adaptive)
+      return;
+
+    // The functions without an estimate get the mean of the others.
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < numFunctions; ++i)
+    {
+      if (estimates[i] >= 0)
+      {
+        sum += estimates[i];
+        ++count;
+      }
+    }
+
+    const double mean = (count > 0) ? sum / count : 1;
+    arma::vec weights(estimates);
+    for (size_t i = 0; i < numFunctions; ++i)
+    {
+      if (weights[i] < 0)
+        weights[i] = mean;
+    }
+
+    Rebuild(weights);
+  }
+
+ private:
+  //! Rebuild the table from the given weights, with the smoothing.
+  void Rebuild(const arma::vec& weights)
+  {
+    const double sum = arma::accu(weights);
+    if (sum > 0 && std::isfinite(sum))
+    {
+      const arma::vec smoothed = (1 - smoothing) * weights / sum +
+          smoothing / numFunctions;
+      table.Reset(smoothed);
+    }
+    else
+    {
+      // All the gradients are 0 (or not finite): sample uniformly.
+      table.Reset(arma::vec(numFunctions, arma::fill::ones));
+    }
+  }
+
+  //! The number of functions.
+  size_t numFunctions;
+  //! The proportion of the uniform distribution.
+  double smoothing;
+  //! Whether or not the weights are estimated from the gradient norms.
+  bool adaptive;
+  //! The estimated weight of each function, or -1.
+  arma::vec estimates;
+  //! The alias table of the sampling distribution.
+  AliasTable table;
+  //! The gradient of one function.
+  GradType functionGradient;
+};
+
+} // namespace ens
+
+#endif
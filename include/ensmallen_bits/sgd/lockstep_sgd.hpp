@@ -0,0 +1,277 @@
+/**
+ * @file lockstep_sgd.hpp
+ *
+ * Lockstep SGD: several models, e.g. the variants of a hyperparameter sweep,
+ * trained with SGD in one pass over the data.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LOCKSTEP_SGD_HPP
+#define ENSMALLEN_SGD_LOCKSTEP_SGD_HPP
+
+#include "sgd.hpp"
+
+namespace ens {
+
+namespace traits {
+
+//! Detect an EvaluateWithGradients() method, which computes the objectives and
+//! gradients of all the models of LockstepSGD on a batch at once.
+template<typename FunctionType, typename MatType, typename GradType>
+struct HasEvaluateWithGradients
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().EvaluateWithGradients(
+      std::declval<const MatType&>(), (size_t) 0, std::declval<GradType&>(),
+      std::declval<arma::Col<typename MatType::elem_type>&>(), (size_t) 0),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<FunctionType>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * LockstepSGD trains K models of the same shape with SGD at the same time,
+ * e.g. the variants of a hyperparameter sweep over the regularization or the
+ * step size, so that the data is read once per epoch instead of K times.  The
+ * models are stored side by side in the coordinates: with K models of c
+ * columns each, the coordinates have K * c columns, and columns
+ * [k * c, (k + 1) * c) hold model k (for linear models, c = 1 and each column
+ * is a model).  Each model has its own step size (StepSizes(), whose size is
+ * K), its own instantiated update and decay policies (UpdatePolicies() holds
+ * one update policy per model), and its own objective.
+ *
+ * The function is a separable function (with NumFunctions() and Shuffle()),
+ * which computes all the models on each batch at once with
+ *
+ * @code
+ * // For each model k, store the sum of the objectives of the points
+ * // [begin, begin + batchSize) in objectives[k], and the sum of their
+ * // gradients into the columns of model k of gradients, which must not be
+ * // resized.
+ * void EvaluateWithGradients(const arma::mat& coordinates,
+ *                            const size_t begin,
+ *                            arma::mat& gradients,
+ *                            arma::vec& objectives,
+ *                            const size_t batchSize);
+ * @endcode
+ *
+ * so that, e.g. for a linear model, the predictions and gradients of all the
+ * models are one matrix product each over the batch.  Without that method,
+ * the separable EvaluateWithGradient() (or Evaluate() and Gradient()) of a
+ * SeparableFunctionType is called for each model on the same batch; if the
+ * function also has a PrepareBatch() method, each batch is then still loaded
+ * or constructed once for all the models, on a background thread while the
+ * previous batch is used (see BatchPrefetcher).
+ *
+ * A model stops being updated once its objective over an epoch changed by
+ * less than Tolerance(), or once its objective is not finite (with a
+ * warning); the optimization terminates when no model is updated any more,
+ * after MaxIterations() points, or when a callback terminates it.  With
+ * EvaluateWithGradients(), the models that are not updated any more are still
+ * computed on every batch (their results are ignored), since the function
+ * computes all the models at once.  The callbacks are given all the
+ * coordinates, and EndEpoch() and BeginEpoch() the lowest mean objective of
+ * the models over the last epoch.  Optimize() returns the lowest objective, and
+ * Objectives() holds the objective of each model over its last epoch (or over
+ * the points seen so far, if no epoch was completed).
+ *
+ * @code
+ * // Three step sizes, one column (a linear model) each.
+ * LockstepSGD<AdamUpdate> optimizer({ 0.001, 0.003, 0.01 }, 64);
+ * arma::mat coordinates(dimensionality, 3, arma::fill::zeros);
+ * optimizer.Optimize(f, coordinates);
+ * const arma::uword best = optimizer.Objectives().index_min();
+ * @endcode
+ *
+ * @tparam UpdatePolicyType Update policy used to take the steps of each model
+ *     (see ens::VanillaUpdate and the other policies of SGD).
+ * @tparam DecayPolicyType Decay policy used to adjust the step size of each
+ *     model.
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay>
+class LockstepSGD
+{
+ public:
+  /**
+   * Construct the LockstepSGD optimizer with the given parameters; there is
+   * one model per step size, and each model gets a copy of the given update
+   * policy.
+   *
+   * @param stepSizes Step size of each model.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of points to process (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute change of the objective of a model over
+   *     an epoch to stop updating it.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters of each model.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size
+   *     of each model.
+   */
+  LockstepSGD(const std::vector<double>& stepSizes =
+                  std::vector<double>(1, 0.01),
+              const size_t batchSize = 32,
+              const size_t maxIterations = 100000,
+              const double tolerance = 1e-5,
+              const bool shuffle = true,
+              const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+              const DecayPolicyType& decayPolicy = DecayPolicyType());
+
+  /**
+   * Optimize the models in the given coordinates, whose number of columns must
+   * be a multiple of Models() (otherwise a std::invalid_argument is thrown).
+   * The coordinates will be modified to store the finishing point of each
+   * model, and the lowest objective of the models is returned.
+   *
+   * @tparam SeparableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting points of the models (will be modified).
+   * @param callbacks Callback functions.
+   * @return Lowest objective of the models.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsMatrixType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(SeparableFunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<SeparableFunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the number of models.
+  size_t Models() const { return stepSizes.size(); }
+
+  //! Get the step size of each model.
+  const std::vector<double>& StepSizes() const { return stepSizes; }
+  //! Modify the step size of each model; the number of update policies must
+  //! be changed too if the number of models changes.
+  std::vector<double>& StepSizes() { return stepSizes; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of points (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of points (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the update policy of each model.
+  const std::vector<UpdatePolicyType>& UpdatePolicies() const
+  { return updatePolicies; }
+  //! Modify the update policy of each model.
+  std::vector<UpdatePolicyType>& UpdatePolicies() { return updatePolicies; }
+
+  //! Get the step size decay policy (each model gets an instance).
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy (each model gets an instance).
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the objective of each model over its last epoch.
+  const arma::vec& Objectives() const { return objectives; }
+
+ private:
+  //! Compute the objectives and gradients of all the models at once.
+  template<typename SeparableFunctionType,
+           typename FullFunctionType,
+           typename ModelMatType,
+           typename ElemType>
+  void EvaluateModels(SeparableFunctionType& function,
+                      FullFunctionType& f,
+                      const ModelMatType& iterate,
+                      ModelMatType& gradients,
+                      std::vector<ModelMatType>& modelIterates,
+                      std::vector<ModelMatType>& modelGradients,
+                      const std::vector<char>& active,
+                      arma::Col<ElemType>& batchObjectives,
+                      const size_t begin,
+                      const size_t batchSize,
+                      std::true_type /* shared */);
+
+  //! Compute the objective and gradient of each active model separately.
+  template<typename SeparableFunctionType,
+           typename FullFunctionType,
+           typename ModelMatType,
+           typename ElemType>
+  void EvaluateModels(SeparableFunctionType& function,
+                      FullFunctionType& f,
+                      const ModelMatType& iterate,
+                      ModelMatType& gradients,
+                      std::vector<ModelMatType>& modelIterates,
+                      std::vector<ModelMatType>& modelGradients,
+                      const std::vector<char>& active,
+                      arma::Col<ElemType>& batchObjectives,
+                      const size_t begin,
+                      const size_t batchSize,
+                      std::false_type /* shared */);
+
+  //! The step size of each model.
+  std::vector<double> stepSizes;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of points to process.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled.
+  bool shuffle;
+
+  //! The update policy of each model.
+  std::vector<UpdatePolicyType> updatePolicies;
+
+  //! The decay policy used to update the step size of each model.
+  DecayPolicyType decayPolicy;
+
+  //! The objective of each model over its last epoch.
+  arma::vec objectives;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "lockstep_sgd_impl.hpp"
+
+#endif
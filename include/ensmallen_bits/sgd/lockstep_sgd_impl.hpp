@@ -0,0 +1,372 @@
+/**
+ * @file lockstep_sgd_impl.hpp
+ *
+ * Implementation of lockstep SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_LOCKSTEP_SGD_IMPL_HPP
+#define ENSMALLEN_SGD_LOCKSTEP_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lockstep_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/batch_prefetcher.hpp>
+#include <ensmallen_bits/utility/compensated_sum.hpp>
+#include <ensmallen_bits/utility/objective_feedback.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+LockstepSGD<UpdatePolicyType, DecayPolicyType>::LockstepSGD(
+    const std::vector<double>& stepSizes,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const UpdatePolicyType& updatePolicy,
+    const DecayPolicyType& decayPolicy) :
+    stepSizes(stepSizes),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    updatePolicies(stepSizes.size(), updatePolicy),
+    decayPolicy(decayPolicy)
+{ /* Nothing to do. */ }
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsMatrixType<GradType>::value,
+typename MatType::elem_type>::type
+LockstepSGD<UpdatePolicyType, DecayPolicyType>::Optimize(
+    SeparableFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.  The models are views of the columns of the
+  // coordinates, so they are dense matrices.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef arma::Mat<ElemType> ModelMatType;
+  // The objective of an epoch is summed in at least double precision.
+  typedef typename AccumulatorType<ElemType>::type AccumType;
+
+  typedef Function<SeparableFunctionType, ModelMatType, ModelMatType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  typedef typename UpdatePolicyType::template Policy<ModelMatType,
+      ModelMatType> InstUpdatePolicyType;
+  typedef typename DecayPolicyType::template Policy<ModelMatType,
+      ModelMatType> InstDecayPolicyType;
+
+  // Make sure we have all the methods that we need; a function that computes
+  // all the models at once doesn't need the methods of each model.  Such a
+  // function still computes the models that are not updated any more; their
+  // objectives and gradients are ignored.
+  typedef traits::HasEvaluateWithGradients<SeparableFunctionType,
+      ModelMatType, ModelMatType> SharedType;
+  if (!SharedType::value)
+  {
+    traits::CheckSeparableFunctionTypeAPI<FullFunctionType, ModelMatType,
+        ModelMatType>();
+  }
+  RequireDenseFloatingPointType<BaseMatType>();
+  RequireSameInternalTypes<BaseMatType, GradType>();
+
+  ModelMatType& iterate = (ModelMatType&) iterateIn;
+
+  const size_t models = stepSizes.size();
+  if (models == 0 || iterate.n_cols % models != 0)
+  {
+    std::ostringstream oss;
+    oss << "LockstepSGD::Optimize(): the number of columns of the coordinates ("
+        << iterate.n_cols << ") is not a multiple of the number of models ("
+        << models << ")";
+    throw std::invalid_argument(oss.str());
+  }
+  if (updatePolicies.size() != models)
+  {
+    std::ostringstream oss;
+    oss << "LockstepSGD::Optimize(): there are " << updatePolicies.size()
+        << " update policies for " << models << " models";
+    throw std::invalid_argument(oss.str());
+  }
+  const size_t cols = iterate.n_cols / models;
+
+  // The models and their gradients are views of the columns of the
+  // coordinates and of the gradients; the vectors are never reallocated, so
+  // the views stay views.
+  ModelMatType gradients(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  std::vector<ModelMatType> modelIterates;
+  std::vector<ModelMatType> modelGradients;
+  modelIterates.reserve(models);
+  modelGradients.reserve(models);
+  for (size_t k = 0; k < models; ++k)
+  {
+    modelIterates.emplace_back(iterate.colptr(k * cols), iterate.n_rows, cols,
+        false, true);
+    modelGradients.emplace_back(gradients.colptr(k * cols), iterate.n_rows,
+        cols, false, true);
+  }
+
+  // Each model has its own policies and step size.
+  std::vector<InstUpdatePolicyType> instUpdates;
+  std::vector<InstDecayPolicyType> instDecays;
+  instUpdates.reserve(models);
+  instDecays.reserve(models);
+  for (size_t k = 0; k < models; ++k)
+  {
+    instUpdates.emplace_back(updatePolicies[k], iterate.n_rows, cols);
+    instDecays.emplace_back(decayPolicy);
+  }
+  std::vector<double> modelStepSizes(stepSizes);
+
+  // The state of each model.
+  std::vector<char> active(models, 1);
+  std::vector<AccumType> epochObjectives(models, 0);
+  std::vector<AccumType> compensations(models, 0);
+  std::vector<AccumType> lastObjectives(models, DBL_MAX);
+  arma::Col<ElemType> batchObjectives(models, arma::fill::zeros);
+  objectives.zeros(models);
+  size_t activeModels = models;
+
+  // Find the number of functions to use.
+  const size_t numFunctions = f.NumFunctions();
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  size_t epoch = 1;
+  bool completedEpoch = false;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  // If the function has a PrepareBatch() method, the next batch is prepared on
+  // a background thread while the current batch is used by all the models.
+  BatchPrefetcher<SeparableFunctionType> prefetcher(function);
+  prefetcher.Prepare(currentFunction, std::min(std::min(batchSize,
+      actualMaxIterations), numFunctions));
+
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  terminate |= Callback::BeginEpoch(*this, f, iterate, epoch, 0.0,
+      callbacks...);
+  size_t i = 0;
+  while (i < actualMaxIterations && activeModels > 0 && !terminate)
+  {
+    // The same batches as in SGD.
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - i),
+        numFunctions - currentFunction);
+
+    // Make sure the current batch is ready, and start preparing the next one
+    // if it is in the same epoch.
+    prefetcher.Wait();
+    const size_t nextFunction = currentFunction + effectiveBatchSize;
+    const size_t nextIteration = i + effectiveBatchSize;
+    if (nextFunction < numFunctions && nextIteration < actualMaxIterations)
+    {
+      prefetcher.Prefetch(nextFunction, std::min(std::min(batchSize,
+          actualMaxIterations - nextIteration), numFunctions - nextFunction));
+    }
+
+    Callback::BeginPhase(*this, f, iterate, Phase::Function, callbacks...);
+    EvaluateModels(function, f, iterate, gradients, modelIterates,
+        modelGradients, active, batchObjectives, currentFunction,
+        effectiveBatchSize, std::integral_constant<bool,
+        SharedType::value>());
+    Callback::EndPhase(*this, f, iterate, Phase::Function, callbacks...);
+
+    // A model whose objective is not finite is not updated any more.
+    for (size_t k = 0; k < models; ++k)
+    {
+      if (!active[k])
+        continue;
+
+      CompensatedAdd(epochObjectives[k], compensations[k],
+          (AccumType) batchObjectives[k]);
+      if (!std::isfinite(epochObjectives[k]))
+      {
+        Warn << "LockstepSGD: model " << k << " converged to "
+            << epochObjectives[k] << " at iteration " << i << "; it is not "
+            << "updated any more.  Try a smaller step size?" << std::endl;
+        objectives[k] = epochObjectives[k];
+        active[k] = 0;
+        --activeModels;
+      }
+    }
+
+    // Use the update policies to take a step with each model.
+    Callback::BeginPhase(*this, f, iterate, Phase::Update, callbacks...);
+    for (size_t k = 0; k < models; ++k)
+    {
+      if (!active[k])
+        continue;
+
+      NotifyObjective(instUpdates[k], batchObjectives[k]);
+      instUpdates[k].Update(modelIterates[k], modelStepSizes[k],
+          modelGradients[k]);
+    }
+    Callback::EndPhase(*this, f, iterate, Phase::Update, callbacks...);
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Now update the learning rates if requested by the user.
+    Callback::BeginPhase(*this, f, iterate, Phase::Decay, callbacks...);
+    for (size_t k = 0; k < models; ++k)
+    {
+      if (active[k])
+      {
+        instDecays[k].Update(modelIterates[k], modelStepSizes[k],
+            modelGradients[k]);
+      }
+    }
+    Callback::EndPhase(*this, f, iterate, Phase::Decay, callbacks...);
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+    if (currentFunction < numFunctions)
+      continue;
+
+    // The epoch is complete; models that converged are not updated any more.
+    double bestObjective = DBL_MAX;
+    for (size_t k = 0; k < models; ++k)
+    {
+      if (active[k])
+      {
+        objectives[k] = epochObjectives[k];
+        if (std::abs(lastObjectives[k] - epochObjectives[k]) < tolerance)
+        {
+          Info << "LockstepSGD: model " << k << " minimized within tolerance "
+              << tolerance << "." << std::endl;
+          active[k] = 0;
+          --activeModels;
+        }
+
+        lastObjectives[k] = epochObjectives[k];
+        epochObjectives[k] = 0;
+        compensations[k] = 0;
+      }
+
+      if (std::isfinite(objectives[k]))
+        bestObjective = std::min(bestObjective, objectives[k]);
+    }
+    completedEpoch = true;
+
+    terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+        bestObjective / (double) numFunctions, callbacks...);
+
+    Info << "LockstepSGD: iteration " << i << ", lowest objective "
+        << bestObjective << ", " << activeModels << " of " << models
+        << " models still updated." << std::endl;
+
+    if (activeModels == 0 || i >= actualMaxIterations || terminate)
+      break;
+
+    terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
+        bestObjective / (double) numFunctions, callbacks...);
+
+    currentFunction = 0;
+    if (shuffle) // Determine order of visitation.
+    {
+      Callback::BeginPhase(*this, f, iterate, Phase::Shuffle, callbacks...);
+      f.Shuffle();
+      Callback::EndPhase(*this, f, iterate, Phase::Shuffle, callbacks...);
+    }
+
+    // The first batch of the next epoch can only be prepared after
+    // shuffling.
+    prefetcher.Prepare(0, std::min(std::min(batchSize,
+        actualMaxIterations - i), numFunctions));
+  }
+
+  if (activeModels == 0)
+  {
+    Info << "LockstepSGD: no model is updated any more; terminating "
+        << "optimization." << std::endl;
+  }
+  else if (i >= actualMaxIterations)
+  {
+    Info << "LockstepSGD: maximum iterations (" << maxIterations << ") "
+        << "reached; terminating optimization." << std::endl;
+  }
+
+  // Without a complete epoch, the batches seen so far are all there is.
+  if (!completedEpoch)
+  {
+    for (size_t k = 0; k < models; ++k)
+      if (active[k])
+        objectives[k] = epochObjectives[k];
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+
+  const arma::uvec finite = arma::find_finite(objectives);
+  return finite.is_empty() ? ElemType(objectives[0]) :
+      ElemType(arma::min(objectives.elem(finite)));
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename SeparableFunctionType,
+         typename FullFunctionType,
+         typename ModelMatType,
+         typename ElemType>
+void LockstepSGD<UpdatePolicyType, DecayPolicyType>::EvaluateModels(
+    SeparableFunctionType& function,
+    FullFunctionType& /* f */,
+    const ModelMatType& iterate,
+    ModelMatType& gradients,
+    std::vector<ModelMatType>& /* modelIterates */,
+    std::vector<ModelMatType>& /* modelGradients */,
+    const std::vector<char>& /* active */,
+    arma::Col<ElemType>& batchObjectives,
+    const size_t begin,
+    const size_t batchSize,
+    std::true_type /* shared */)
+{
+  function.EvaluateWithGradients(iterate, begin, gradients, batchObjectives,
+      batchSize);
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename SeparableFunctionType,
+         typename FullFunctionType,
+         typename ModelMatType,
+         typename ElemType>
+void LockstepSGD<UpdatePolicyType, DecayPolicyType>::EvaluateModels(
+    SeparableFunctionType& /* function */,
+    FullFunctionType& f,
+    const ModelMatType& /* iterate */,
+    ModelMatType& /* gradients */,
+    std::vector<ModelMatType>& modelIterates,
+    std::vector<ModelMatType>& modelGradients,
+    const std::vector<char>& active,
+    arma::Col<ElemType>& batchObjectives,
+    const size_t begin,
+    const size_t batchSize,
+    std::false_type /* shared */)
+{
+  for (size_t k = 0; k < modelIterates.size(); ++k)
+  {
+    if (active[k])
+    {
+      batchObjectives[k] = f.EvaluateWithGradient(modelIterates[k], begin,
+          modelGradients[k], batchSize);
+    }
+  }
+}
+
+} // namespace ens
+
+#endif
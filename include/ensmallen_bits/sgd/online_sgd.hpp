@@ -0,0 +1,290 @@
+/**
+ * @file online_sgd.hpp
+ *
+ * Online SGD: stochastic gradient descent over an unbounded stream of
+ * minibatches.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_ONLINE_SGD_HPP
+#define ENSMALLEN_SGD_ONLINE_SGD_HPP
+
+#include "sgd.hpp"
+
+namespace ens {
+
+/**
+ * OnlineSGD runs stochastic gradient descent over a stream of points that
+ * has no fixed size, e.g. events that keep arriving while the optimizer runs.
+ * There are no epochs, so nothing is shuffled or revisited: each batch is
+ * used for exactly one step, and the optimization runs until the stream ends,
+ * MaxIterations() points have been processed (0, the default, means no
+ * limit), or a callback terminates it.
+ *
+ * The function (a StreamFunctionType) has the separable EvaluateWithGradient()
+ * (or Evaluate() and Gradient()) of a SeparableFunctionType, where `begin` is
+ * the position of the first point of the batch in the stream, and
+ *
+ * @code
+ * // Return the number of points of the batch that starts at position begin,
+ * // at most batchSize, waiting for them to arrive if need be; fewer than
+ * // batchSize points (or 0) mean that the stream has ended.
+ * size_t Available(const size_t begin, const size_t batchSize);
+ * @endcode
+ *
+ * The positions of consecutive batches are consecutive, so a stream only has
+ * to keep the current batch.  If the function also has a PrepareBatch()
+ * method, the next batch is prepared on a background thread while the current
+ * one is used (see BatchPrefetcher), so PrepareBatch() of the next batch may
+ * run concurrently with the evaluation of the current one; Available() is
+ * called on the optimizer thread once that preparation has finished.
+ *
+ * The objective is tracked over windows of WindowSize() batches: at the end
+ * of each window, the mean objective of its points is computed, checked for
+ * divergence, and given to the EndEpoch() callbacks as if the window were an
+ * epoch, so that callbacks such as Checkpoint and EarlyStopAtMinLoss work
+ * unchanged; if it changed by less than Tolerance() since the last window,
+ * the optimization terminates (the default tolerance of 0 disables this).
+ *
+ * Position() is the position of the next batch, and it is kept across calls
+ * to Optimize() and in the state saved by SaveState(), so a long-lived
+ * process that is restarted from a Checkpoint continues the stream after the
+ * last saved window, with the same update policy state:
+ *
+ * @code
+ * OnlineSGD<AdamUpdate> optimizer(0.001, 64);
+ * if (std::ifstream("trainer.ckpt"))
+ *   Checkpoint::Load("trainer.ckpt", optimizer, coordinates);
+ * optimizer.Optimize(stream, coordinates, Checkpoint("trainer.ckpt", 10));
+ * @endcode
+ *
+ * @tparam UpdatePolicyType Update policy used to take the steps (see
+ *     ens::VanillaUpdate and the other policies of SGD).
+ * @tparam DecayPolicyType Decay policy used to adjust the step size.
+ */
+template<typename UpdatePolicyType = VanillaUpdate,
+         typename DecayPolicyType = NoDecay>
+class OnlineSGD
+{
+ public:
+  /**
+   * Construct the OnlineSGD optimizer with the given parameters.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Batch size to use for each step.
+   * @param maxIterations Maximum number of points to process in each call to
+   *     Optimize() (0 means no limit).
+   * @param windowSize Number of batches of each window of the objective.
+   * @param tolerance Minimum change of the objective between two windows to
+   *     continue the optimization (0 means never terminate on it).
+   * @param updatePolicy Instantiated update policy used to adjust the given
+   *     parameters.
+   * @param decayPolicy Instantiated decay policy used to adjust the step size.
+   * @param resetPolicy Flag that determines whether update policy parameters
+   *     are reset before every Optimize call.
+   */
+  OnlineSGD(const double stepSize = 0.01,
+            const size_t batchSize = 32,
+            const size_t maxIterations = 0,
+            const size_t windowSize = 100,
+            const double tolerance = 0.0,
+            const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+            const DecayPolicyType& decayPolicy = DecayPolicyType(),
+            const bool resetPolicy = true);
+
+  /**
+   * Clean any memory associated with the OnlineSGD object.
+   */
+  ~OnlineSGD();
+
+  /**
+   * Optimize the given stream function, starting at the batch at Position().
+   * The given starting point will be modified to store the finishing point of
+   * the algorithm, and the mean objective of the last window (or of the
+   * batches since, if no window was completed) is returned.
+   *
+   * @tparam StreamFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Mean objective of the points of the last window.
+   */
+  template<typename StreamFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsMatrixType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(StreamFunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename StreamFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(StreamFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<StreamFunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  /**
+   * Save the position in the stream, the objective of the last window, the
+   * step size and the state of the instantiated update and decay policies, so
+   * that the optimization can be resumed later with LoadState().  A
+   * std::logic_error is thrown if Optimize() has not been called with the
+   * given matrix types yet.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param ar The CheckpointWriter to save to.
+   * @param iterate The coordinates of the optimization.
+   */
+  template<typename MatType, typename GradType = MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& iterate);
+
+  /**
+   * Restore the state saved by SaveState().  The next call to Optimize()
+   * continues with this state (and at the saved position) even if
+   * ResetPolicy() is true.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param ar The CheckpointReader to restore from.
+   * @param iterate The coordinates of the optimization.
+   */
+  template<typename MatType, typename GradType = MatType>
+  void LoadState(CheckpointReader& ar, const MatType& iterate);
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of points of each call (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of points of each call (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of batches of each window.
+  size_t WindowSize() const { return windowSize; }
+  //! Modify the number of batches of each window.
+  size_t& WindowSize() { return windowSize; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the update policy parameters are reset before
+  //! Optimize call.
+  bool ResetPolicy() const { return resetPolicy; }
+  //! Modify whether or not the update policy parameters are reset before
+  //! Optimize call.
+  bool& ResetPolicy() { return resetPolicy; }
+
+  //! Get the position of the next batch in the stream.
+  size_t Position() const { return position; }
+  //! Modify the position of the next batch in the stream.
+  size_t& Position() { return position; }
+
+  //! Get the number of windows completed so far.
+  size_t Windows() const { return windows; }
+
+  //! Get the mean objective of the last completed window.
+  double WindowObjective() const { return windowObjective; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the instantiated update policy type.  Be sure to check its type with
+  //! Has() before using!
+  const Any& InstUpdatePolicy() const { return instUpdatePolicy; }
+  //! Modify the instantiated update policy type.  Be sure to check its type
+  //! with Has() before using!
+  Any& InstUpdatePolicy() { return instUpdatePolicy; }
+
+  //! Get the step size decay policy.
+  const DecayPolicyType& DecayPolicy() const { return decayPolicy; }
+  //! Modify the step size decay policy.
+  DecayPolicyType& DecayPolicy() { return decayPolicy; }
+
+  //! Get the instantiated decay policy type.  Be sure to check its type with
+  //! Has() before using!
+  const Any& InstDecayPolicy() const { return instDecayPolicy; }
+  //! Modify the instantiated decay policy type.  Be sure to check its type with
+  //! Has() before using!
+  Any& InstDecayPolicy() { return instDecayPolicy; }
+
+ private:
+  //! The step size for each example.
+  double stepSize;
+
+  //! The batch size for processing.
+  size_t batchSize;
+
+  //! The maximum number of points of each call.
+  size_t maxIterations;
+
+  //! The number of batches of each window.
+  size_t windowSize;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! The update policy used to update the parameters in each iteration.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay policy used to update the step size.
+  DecayPolicyType decayPolicy;
+
+  //! Flag indicating whether update policy should be reset before running
+  //! optimization.
+  bool resetPolicy;
+
+  //! Flag indicating whether the update policy parameters have been
+  //! initialized.
+  bool isInitialized;
+
+  //! Flag indicating whether the policies were restored by LoadState() and
+  //! must not be reset by the next Optimize() call.
+  bool isRestored;
+
+  //! The position of the next batch in the stream.
+  size_t position;
+
+  //! The number of windows completed so far.
+  size_t windows;
+
+  //! The mean objective of the last completed window.
+  double windowObjective;
+
+  //! The initialized update policy.
+  Any instUpdatePolicy;
+  //! The initialized decay policy.
+  Any instDecayPolicy;
+};
+
+} // namespace ens
+
+// Include implementation.
+#include "online_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,310 @@
+/**
+ * @file online_sgd_impl.hpp
+ *
+ * Implementation of online SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_ONLINE_SGD_IMPL_HPP
+#define ENSMALLEN_SGD_ONLINE_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_sgd.hpp"
+
+#include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/batch_prefetcher.hpp>
+#include <ensmallen_bits/utility/compensated_sum.hpp>
+#include <ensmallen_bits/utility/objective_feedback.hpp>
+
+namespace ens {
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+OnlineSGD<UpdatePolicyType, DecayPolicyType>::OnlineSGD(
+    const double stepSize,
+    const size_t batchSize,
+    const size_t maxIterations,
+    const size_t windowSize,
+    const double tolerance,
+    const UpdatePolicyType& updatePolicy,
+    const DecayPolicyType& decayPolicy,
+    const bool resetPolicy) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    windowSize(windowSize),
+    tolerance(tolerance),
+    updatePolicy(updatePolicy),
+    decayPolicy(decayPolicy),
+    resetPolicy(resetPolicy),
+    isInitialized(false),
+    isRestored(false),
+    position(0),
+    windows(0),
+    windowObjective(0)
+{ /* Nothing to do. */ }
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+OnlineSGD<UpdatePolicyType, DecayPolicyType>::~OnlineSGD()
+{
+  // Clean decay and update policies, if they were initialized.
+  instDecayPolicy.Clean();
+  instUpdatePolicy.Clean();
+}
+
+//! Optimize the function (minimize).
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename StreamFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsMatrixType<GradType>::value,
+typename MatType::elem_type>::type
+OnlineSGD<UpdatePolicyType, DecayPolicyType>::Optimize(
+    StreamFunctionType& function,
+    MatType& iterateIn,
+    CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  // The objective of a window is summed in at least double precision.
+  typedef typename AccumulatorType<ElemType>::type AccumType;
+
+  typedef Function<StreamFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+  typedef typename DecayPolicyType::template Policy<BaseMatType, BaseGradType>
+      InstDecayPolicyType;
+
+  // Make sure we have all the methods that we need.
+  traits::CheckStreamFunctionTypeAPI<StreamFunctionType, FullFunctionType,
+      BaseMatType, BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  // Initialize the decay policy if needed.
+  if (!isInitialized || !instDecayPolicy.Has<InstDecayPolicyType>())
+    instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
+
+  // Initialize the update policy.
+  if ((resetPolicy && !isRestored) || !isInitialized ||
+      !instUpdatePolicy.Has<InstUpdatePolicyType>())
+  {
+    instUpdatePolicy.Emplace<InstUpdatePolicyType>(
+        updatePolicy, iterate.n_rows, iterate.n_cols);
+    isInitialized = true;
+  }
+  isRestored = false;
+
+  InstUpdatePolicyType& instUpdate =
+      instUpdatePolicy.As<InstUpdatePolicyType>();
+  InstDecayPolicyType& instDecay = instDecayPolicy.As<InstDecayPolicyType>();
+
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+
+  // The objective of the current window so far; the tolerance is checked
+  // against the last window, which may have been restored by LoadState().
+  AccumType windowSum = 0;
+  AccumType compensation = 0;
+  size_t windowPoints = 0;
+  size_t windowBatches = 0;
+  size_t completedWindows = 0;
+  double lastObjective = (windows > 0) ? windowObjective : DBL_MAX;
+  const size_t actualWindowSize = std::max(windowSize, (size_t) 1);
+
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  size_t i = 0;
+  bool streamEnded = false;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  // If the function has a PrepareBatch() method, the next batch is prepared on
+  // a background thread while the current batch is being used.
+  BatchPrefetcher<StreamFunctionType> prefetcher(function);
+  prefetcher.Prepare(position, std::min(batchSize, actualMaxIterations));
+
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  terminate |= Callback::BeginEpoch(*this, f, iterate, windows + 1,
+      windowObjective, callbacks...);
+  while (i < actualMaxIterations && !streamEnded && !terminate)
+  {
+    // Wait for the batch; a short batch is the last one of the stream.
+    const size_t requested = std::min(batchSize, actualMaxIterations - i);
+    prefetcher.Wait();
+    const size_t points = std::min(function.Available(position, requested),
+        requested);
+    streamEnded = (points < requested);
+    if (points == 0)
+      break;
+
+    // The next batch can be prepared while this one is used.
+    if (!streamEnded && i + points < actualMaxIterations)
+    {
+      prefetcher.Prefetch(position + points, std::min(batchSize,
+          actualMaxIterations - i - points));
+    }
+
+    Callback::BeginPhase(*this, f, iterate, Phase::Function, callbacks...);
+    const ElemType objective = f.EvaluateWithGradient(iterate, position,
+        gradient, points);
+    Callback::EndPhase(*this, f, iterate, Phase::Function, callbacks...);
+
+    CompensatedAdd(windowSum, compensation, (AccumType) objective);
+    windowPoints += points;
+    position += points;
+    i += points;
+    ++windowBatches;
+
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Use the update policy to take a step.
+    Callback::BeginPhase(*this, f, iterate, Phase::Update, callbacks...);
+    NotifyObjective(instUpdate, objective);
+    instUpdate.Update(iterate, stepSize, gradient);
+    Callback::EndPhase(*this, f, iterate, Phase::Update, callbacks...);
+
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Now update the learning rate if requested by the user.
+    Callback::BeginPhase(*this, f, iterate, Phase::Decay, callbacks...);
+    instDecay.Update(iterate, stepSize, gradient);
+    Callback::EndPhase(*this, f, iterate, Phase::Decay, callbacks...);
+
+    if (windowBatches < actualWindowSize)
+      continue;
+
+    // The window is complete.
+    windowObjective = double(windowSum / (AccumType) windowPoints);
+    ++windows;
+    ++completedWindows;
+    terminate |= Callback::EndEpoch(*this, f, iterate, windows,
+        windowObjective, callbacks...);
+
+    Info << "OnlineSGD: window " << windows << ", position " << position
+        << ", objective " << windowObjective << "." << std::endl;
+
+    if (std::isnan(windowObjective) || std::isinf(windowObjective))
+    {
+      Warn << "OnlineSGD: converged to " << windowObjective << " at position "
+          << position << "; terminating with failure.  Try a smaller step "
+          << "size?" << std::endl;
+
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
+      return windowObjective;
+    }
+
+    if (std::abs(lastObjective - windowObjective) < tolerance)
+    {
+      Info << "OnlineSGD: minimized within tolerance " << tolerance << "; "
+          << "terminating optimization." << std::endl;
+
+      Callback::EndOptimization(*this, f, iterate, callbacks...);
+      return windowObjective;
+    }
+
+    lastObjective = windowObjective;
+    windowSum = 0;
+    compensation = 0;
+    windowPoints = 0;
+    windowBatches = 0;
+
+    if (!terminate && !streamEnded && i < actualMaxIterations)
+    {
+      terminate |= Callback::BeginEpoch(*this, f, iterate, windows + 1,
+          windowObjective, callbacks...);
+    }
+  }
+
+  if (streamEnded)
+  {
+    Info << "OnlineSGD: end of the stream at position " << position << "; "
+        << "terminating optimization." << std::endl;
+  }
+  else if (i >= actualMaxIterations)
+  {
+    Info << "OnlineSGD: maximum iterations (" << maxIterations << ") "
+        << "reached; terminating optimization." << std::endl;
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+
+  // Without a complete window, the batches of this call are all there is.
+  if (completedWindows == 0 && windowPoints > 0)
+    return ElemType(windowSum / (AccumType) windowPoints);
+
+  return ElemType(windowObjective);
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType>
+void OnlineSGD<UpdatePolicyType, DecayPolicyType>::SaveState(
+    CheckpointWriter& ar,
+    const MatType& /* iterate */)
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+  typedef typename DecayPolicyType::template Policy<BaseMatType, BaseGradType>
+      InstDecayPolicyType;
+
+  if (!isInitialized || !instUpdatePolicy.Has<InstUpdatePolicyType>() ||
+      !instDecayPolicy.Has<InstDecayPolicyType>())
+  {
+    throw std::logic_error("OnlineSGD::SaveState(): the policies have not "
+        "been instantiated for this matrix type; call Optimize() first.");
+  }
+
+  ar(position);
+  ar(windows);
+  ar(windowObjective);
+  ar(stepSize);
+  SerializeState(instUpdatePolicy.As<InstUpdatePolicyType>(), ar);
+  SerializeState(instDecayPolicy.As<InstDecayPolicyType>(), ar);
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType>
+void OnlineSGD<UpdatePolicyType, DecayPolicyType>::LoadState(
+    CheckpointReader& ar,
+    const MatType& iterate)
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+  typedef typename DecayPolicyType::template Policy<BaseMatType, BaseGradType>
+      InstDecayPolicyType;
+
+  ar(position);
+  ar(windows);
+  ar(windowObjective);
+  ar(stepSize);
+
+  instUpdatePolicy.Emplace<InstUpdatePolicyType>(
+      updatePolicy, iterate.n_rows, iterate.n_cols);
+  SerializeState(instUpdatePolicy.As<InstUpdatePolicyType>(), ar);
+
+  instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
+  SerializeState(instDecayPolicy.As<InstDecayPolicyType>(), ar);
+
+  isInitialized = true;
+  isRestored = true;
+}
+
+} // namespace ens
+
+#endif
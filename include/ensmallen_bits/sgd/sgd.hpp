@@ -20,6 +20,9 @@
 #include "update_policies/nesterov_momentum_update.hpp"
 #include "decay_policies/no_decay.hpp"
 #include "update_policies/quasi_hyperbolic_update.hpp"
+#include "update_policies/adafactor_update.hpp"
+#include "update_policies/proximal_update.hpp"
+#include "importance_sampler.hpp"
 
 namespace ens {
 
@@ -56,6 +59,43 @@ namespace ens {
  * the documentation on function types included with this distribution or on the
  * ensmallen website.
  *
+ * If ParallelBatch() is set to true (and OpenMP is enabled), each minibatch is
+ * split into contiguous ranges that are evaluated on separate threads with
+ * per-thread gradient buffers, which are then summed before the update policy
+ * is applied.  In that case the function's EvaluateWithGradient() must be safe
+ * to call concurrently on disjoint batches.  If DeterministicReduction() is
+ * also set, the ranges and the reduction order do not depend on the number of
+ * threads, so results are reproducible regardless of the thread count.
+ *
+ * The objectives of the minibatches of an epoch are summed with compensated
+ * (Kahan) summation.  SGD stops with a warning as soon as that sum is NaN or
+ * infinite; this is checked at the end of each epoch, and also every
+ * DivergenceCheckInterval() batches if that is not 0, so that a long epoch
+ * that diverges early doesn't run to its end.  If ComputeObjective() is set
+ * to false, only Gradient() is called for each minibatch, instead of
+ * EvaluateWithGradient(); the objectives are then not known, so the coordinates
+ * themselves are checked for divergence, the tolerance is not used, and
+ * Optimize() returns 0 unless ExactObjective() is set.
+ *
+ * If AccumulationSteps() is set to n > 1, the gradients of n consecutive
+ * minibatches (micro-batches) are summed in place into one buffer, and the
+ * update policy, the decay policy and the EvaluateWithGradient() and
+ * StepTaken() callbacks are only called once for the sum, as for a minibatch
+ * of n * BatchSize() points that doesn't have to fit in memory at once.  The
+ * last step of an epoch may accumulate fewer micro-batches.  This composes
+ * with ParallelBatch(), which splits each micro-batch.
+ *
+ * If ImportanceSampling() is set to true, the functions of each minibatch are
+ * not visited in order, but drawn with replacement with probabilities
+ * proportional to SamplingWeights(), or, if no weights are given, to the norms
+ * of their last gradients, which are re-estimated in each epoch; the
+ * distribution is mixed with the uniform distribution in the proportion
+ * SamplingSmoothing().  The objective and gradient of each function are scaled
+ * by the inverse of its probability, so the minibatch gradients stay unbiased,
+ * and an epoch is still NumFunctions() draws (see ImportanceSampler).  The
+ * functions are then evaluated one at a time, so Shuffle() and ParallelBatch()
+ * are not used.
+ *
  * @tparam UpdatePolicyType Update policy used by SGD during the iterative
  *     update process. By default vanilla update policy (see ens::VanillaUpdate)
  *     is used.
@@ -124,7 +164,7 @@ class SGD
            typename MatType,
            typename GradType,
            typename... CallbackTypes>
-  typename std::enable_if<IsArmaType<GradType>::value,
+  typename std::enable_if<IsMatrixType<GradType>::value,
       typename MatType::elem_type>::type
   Optimize(SeparableFunctionType& function,
            MatType& iterate,
@@ -143,6 +183,210 @@ class SGD
         std::forward<CallbackTypes>(callbacks)...);
   }
 
+  /**
+   * The state of an optimization that is run step by step with Begin() and
+   * Step().  It refers to the function and the coordinates given to Begin(),
+   * which must outlive it, and holds everything else (including its own
+   * instances of the update and decay policies and its own step size), so
+   * that many optimizations can be interleaved with the same optimizer.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  class State
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+    typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+    typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+    typedef typename AccumulatorType<ElemType>::type AccumType;
+    typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
+        FullFunctionType;
+    typedef typename UpdatePolicyType::template Policy<BaseMatType,
+        BaseGradType> InstUpdatePolicyType;
+    typedef typename DecayPolicyType::template Policy<BaseMatType,
+        BaseGradType> InstDecayPolicyType;
+
+    //! Create the state of an optimization of the given function with the
+    //! given optimizer.
+    State(SGD& optimizer,
+          SeparableFunctionType& function,
+          MatType& iterate) :
+        function(&function),
+        iterate(&((BaseMatType&) iterate)),
+        update(optimizer.UpdatePolicy(), iterate.n_rows, iterate.n_cols),
+        decay(optimizer.DecayPolicy()),
+        stepSize(optimizer.StepSize()),
+        gradient(iterate.n_rows, iterate.n_cols),
+        iterations(0),
+        currentFunction(0),
+        batches(0),
+        microBatch(0),
+        stepObjective(0),
+        overallObjective(0),
+        compensation(0),
+        lastObjective(DBL_MAX),
+        objective(0),
+        finished(false),
+        rng(0)
+    {
+      if (optimizer.ImportanceSampling())
+      {
+        sampler.Reset(function.NumFunctions(), optimizer.SamplingWeights(),
+            optimizer.SamplingSmoothing());
+        rng = RandomStream();
+      }
+    }
+
+    //! Get the current coordinates.
+    const BaseMatType& Iterate() const { return *iterate; }
+    //! Get the objective of the current epoch so far, or the final objective
+    //! once the optimization has terminated.
+    ElemType Objective() const
+    { return finished ? objective : ElemType(overallObjective); }
+    //! Get the number of functions visited so far.
+    size_t Iterations() const { return iterations; }
+    //! Get whether or not the optimization has terminated.
+    bool Finished() const { return finished; }
+
+    //! Get the step size of this optimization.
+    double StepSize() const { return stepSize; }
+    //! Modify the step size of this optimization.
+    double& StepSize() { return stepSize; }
+
+   private:
+    friend class SGD;
+
+    //! The function to optimize.
+    SeparableFunctionType* function;
+    //! The coordinates.
+    BaseMatType* iterate;
+    //! The instantiated update policy.
+    InstUpdatePolicyType update;
+    //! The instantiated decay policy.
+    InstDecayPolicyType decay;
+    //! The step size, which the decay policy may change.
+    double stepSize;
+    //! The gradient of the current batch.
+    BaseGradType gradient;
+    //! Per-thread gradient buffers, only used if parallelBatch is true.
+    std::vector<BaseGradType> threadGradients;
+    //! The number of functions visited so far.
+    size_t iterations;
+    //! The first function of the next batch.
+    size_t currentFunction;
+    //! The number of batches visited so far.
+    size_t batches;
+    //! The gradient accumulated over the micro-batches of the current step,
+    //! only used if AccumulationSteps() is more than 1.
+    BaseGradType accumulatedGradient;
+    //! The number of micro-batches of the current step visited so far.
+    size_t microBatch;
+    //! The objective of the micro-batches of the current step.
+    ElemType stepObjective;
+    //! The objective of the current epoch so far.
+    AccumType overallObjective;
+    //! The compensation of the sum of the objective (see CompensatedAdd()).
+    AccumType compensation;
+    //! The objective of the last epoch.
+    AccumType lastObjective;
+    //! The final objective.
+    ElemType objective;
+    //! Whether or not the optimization has terminated.
+    bool finished;
+    //! The sampler of the functions, only used with importance sampling.
+    ImportanceSampler<BaseMatType, BaseGradType> sampler;
+    //! The random stream of the sampler.
+    RandomStream rng;
+  };
+
+  /**
+   * Start an optimization of the given function that is run step by step with
+   * Step(), instead of to completion; e.g. a scheduler can interleave many
+   * such optimizations on a few threads, or stop one at a deadline.  The
+   * optimization is the same as with Optimize(), except that no callbacks are
+   * called and PrepareBatch() is called on the calling thread.  The state
+   * starts with fresh update and decay policies.
+   *
+   * @code
+   * StandardSGD sgd;
+   * auto state = sgd.Begin(f, coordinates);
+   * while (sgd.Step(state, 100))
+   * {
+   *   // Do other work between every 100 batches.
+   * }
+   * @endcode
+   *
+   * @param function Function to optimize; it must outlive the state.
+   * @param iterate Starting point (will be modified); it must outlive the
+   *     state.
+   * @return The state of the optimization.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType = MatType>
+  State<SeparableFunctionType, MatType, GradType> Begin(
+      SeparableFunctionType& function,
+      MatType& iterate);
+
+  /**
+   * Run up to n batches of the optimization of the given state, with the
+   * parameters of this optimizer.  Once the optimization has terminated, the
+   * coordinates are the final point and state.Objective() is the value
+   * Optimize() would have returned.
+   *
+   * @param state State returned by Begin().
+   * @param n Maximum number of batches to run.
+   * @return false if the optimization has terminated.
+   */
+  template<typename SeparableFunctionType, typename MatType, typename GradType>
+  bool Step(State<SeparableFunctionType, MatType, GradType>& state,
+            const size_t n = 1);
+
+  /**
+   * Save the step size and the state of the instantiated update and decay
+   * policies (e.g. the moment estimates of Adam) of the last call to
+   * Optimize(), so that the optimization can be resumed later with
+   * LoadState().  Only policies that implement Serialize() have state to save;
+   * see CheckpointWriter.  A std::logic_error is thrown if Optimize() has not
+   * been called with the given matrix types yet.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param ar The CheckpointWriter to save to.
+   * @param iterate The coordinates of the optimization.
+   */
+  template<typename MatType, typename GradType = MatType>
+  void SaveState(CheckpointWriter& ar, const MatType& iterate);
+
+  /**
+   * Restore the state saved by SaveState().  The policies are instantiated for
+   * the shape of the given coordinates, and the next call to Optimize()
+   * continues with this state even if ResetPolicy() is true.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param ar The CheckpointReader to restore from.
+   * @param iterate The coordinates of the optimization.
+   */
+  template<typename MatType, typename GradType = MatType>
+  void LoadState(CheckpointReader& ar, const MatType& iterate);
+
+  /**
+   * Return the number of bytes that Optimize() keeps for coordinates of the
+   * given size: the state of the instantiated update and decay policies (see
+   * ens::PolicyStateBytes()), the gradient buffer, the per-thread gradient
+   * buffers if ParallelBatch() is true, and the accumulated gradient if
+   * AccumulationSteps() is more than 1.
+   *
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @param rows Number of rows of the coordinates.
+   * @param cols Number of columns of the coordinates.
+   */
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const;
+
   //! Get the step size.
   double StepSize() const { return stepSize; }
   //! Modify the step size.
@@ -180,6 +424,56 @@ class SGD
   //! are reset before Optimize call.
   bool& ResetPolicy() { return resetPolicy; }
 
+  //! Get whether or not each minibatch is split across multiple threads.
+  bool ParallelBatch() const { return parallelBatch; }
+  //! Modify whether or not each minibatch is split across multiple threads.
+  bool& ParallelBatch() { return parallelBatch; }
+
+  //! Get whether or not parallel minibatch reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool DeterministicReduction() const { return deterministicReduction; }
+  //! Modify whether or not parallel minibatch reductions are deterministic
+  //! (i.e., independent of the number of threads).
+  bool& DeterministicReduction() { return deterministicReduction; }
+
+  //! Get whether or not the objective of each minibatch is computed.
+  bool ComputeObjective() const { return computeObjective; }
+  //! Modify whether or not the objective of each minibatch is computed.
+  bool& ComputeObjective() { return computeObjective; }
+
+  //! Get the number of batches between divergence checks (0 means only at the
+  //! end of each epoch).
+  size_t DivergenceCheckInterval() const { return divergenceCheckInterval; }
+  //! Modify the number of batches between divergence checks (0 means only at
+  //! the end of each epoch).
+  size_t& DivergenceCheckInterval() { return divergenceCheckInterval; }
+
+  //! Get the number of micro-batches whose gradients are accumulated into
+  //! each step.
+  size_t AccumulationSteps() const { return accumulationSteps; }
+  //! Modify the number of micro-batches whose gradients are accumulated into
+  //! each step.
+  size_t& AccumulationSteps() { return accumulationSteps; }
+
+  //! Get whether or not the functions are drawn by importance sampling.
+  bool ImportanceSampling() const { return importanceSampling; }
+  //! Modify whether or not the functions are drawn by importance sampling.
+  bool& ImportanceSampling() { return importanceSampling; }
+
+  //! Get the sampling weights of the functions (empty if they are estimated
+  //! from the gradient norms).
+  const arma::vec& SamplingWeights() const { return samplingWeights; }
+  //! Modify the sampling weights of the functions (empty if they are
+  //! estimated from the gradient norms).
+  arma::vec& SamplingWeights() { return samplingWeights; }
+
+  //! Get the proportion of the uniform distribution in the sampling
+  //! distribution.
+  double SamplingSmoothing() const { return samplingSmoothing; }
+  //! Modify the proportion of the uniform distribution in the sampling
+  //! distribution.
+  double& SamplingSmoothing() { return samplingSmoothing; }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
@@ -224,6 +518,32 @@ class SGD
   //! Controls whether or not the actual Objective value is calculated.
   bool exactObjective;
 
+  //! Controls whether or not each minibatch is split across multiple threads.
+  bool parallelBatch;
+
+  //! Controls whether or not parallel minibatch reductions are independent of
+  //! the number of threads.
+  bool deterministicReduction;
+
+  //! Controls whether or not the objective of each minibatch is computed.
+  bool computeObjective;
+
+  //! The number of batches between divergence checks, or 0.
+  size_t divergenceCheckInterval;
+
+  //! The number of micro-batches whose gradients are accumulated into each
+  //! step.
+  size_t accumulationSteps;
+
+  //! Controls whether or not the functions are drawn by importance sampling.
+  bool importanceSampling;
+
+  //! The sampling weights of the functions, or an empty vector.
+  arma::vec samplingWeights;
+
+  //! The proportion of the uniform distribution in the sampling distribution.
+  double samplingSmoothing;
+
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
 
@@ -238,10 +558,33 @@ class SGD
   //! parameters have been initialized.
   bool isInitialized;
 
+  //! Flag indicating whether the policies were restored by LoadState() and
+  //! must not be reset by the next Optimize() call.
+  bool isRestored;
+
   //! The initialized update policy.
   Any instUpdatePolicy;
   //! The initialized decay policy.
   Any instDecayPolicy;
+
+  /**
+   * The buffers used by Optimize(); they are kept between calls, so that
+   * repeated calls on problems of the same size do not allocate them again.
+   */
+  template<typename GradType>
+  struct Workspace
+  {
+    //! The gradient of the current batch.
+    GradType gradient;
+    //! Per-thread gradient buffers, only used if parallelBatch is true.
+    std::vector<GradType> threadGradients;
+    //! The gradient accumulated over the micro-batches of a step, only used if
+    //! accumulationSteps is more than 1.
+    GradType accumulatedGradient;
+  };
+
+  //! The workspace of the last call to Optimize().
+  Any workspace;
 };
 
 using StandardSGD = SGD<VanillaUpdate>;
@@ -251,6 +594,10 @@ using MomentumSGD = SGD<MomentumUpdate>;
 using NesterovMomentumSGD = SGD<NesterovMomentumUpdate>;
 
 using QHSGD = SGD<QHUpdate>;
+
+using Adafactor = SGD<AdafactorUpdate>;
+
+using ProximalSGD = SGD<ProximalUpdate<>>;
 } // namespace ens
 
 // Include implementation.
@@ -18,6 +18,9 @@
 #include "sgd.hpp"
 
 #include <ensmallen_bits/function.hpp>
+#include <ensmallen_bits/utility/batch_prefetcher.hpp>
+#include <ensmallen_bits/utility/compensated_sum.hpp>
+#include <ensmallen_bits/utility/objective_feedback.hpp>
 
 namespace ens {
 
@@ -38,10 +41,18 @@ SGD<UpdatePolicyType, DecayPolicyType>::SGD(
     tolerance(tolerance),
     shuffle(shuffle),
     exactObjective(exactObjective),
+    parallelBatch(false),
+    deterministicReduction(false),
+    computeObjective(true),
+    divergenceCheckInterval(0),
+    accumulationSteps(1),
+    importanceSampling(false),
+    samplingSmoothing(0.1),
     updatePolicy(updatePolicy),
     decayPolicy(decayPolicy),
     resetPolicy(resetPolicy),
-    isInitialized(false)
+    isInitialized(false),
+    isRestored(false)
 { /* Nothing to do. */ }
 
 template<typename UpdatePolicyType, typename DecayPolicyType>
@@ -50,6 +61,7 @@ SGD<UpdatePolicyType, DecayPolicyType>::~SGD()
   // Clean decay and update policies, if they were initialized.
   instDecayPolicy.Clean();
   instUpdatePolicy.Clean();
+  workspace.Clean();
 }
 
 //! Optimize the function (minimize).
@@ -58,7 +70,7 @@ template<typename SeparableFunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
-typename std::enable_if<IsArmaType<GradType>::value,
+typename std::enable_if<IsMatrixType<GradType>::value,
 typename MatType::elem_type>::type
 SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
     SeparableFunctionType& function,
@@ -69,6 +81,8 @@ SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
   typedef typename MatType::elem_type ElemType;
   typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
   typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  // The objective of an epoch is summed in at least double precision.
+  typedef typename AccumulatorType<ElemType>::type AccumType;
 
   typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
       FullFunctionType;
@@ -96,34 +110,76 @@ SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
   // To keep track of where we are and how things are going.
   size_t currentFunction = 0;
   size_t epoch = 1;
-  ElemType overallObjective = 0;
-  ElemType lastObjective = DBL_MAX;
+  size_t batches = 0;
+  AccumType overallObjective = 0;
+  AccumType compensation = 0;
+  AccumType lastObjective = DBL_MAX;
 
   // Controls early termination of the optimization process.
   bool terminate = false;
 
   // Initialize the decay policy if needed.
   if (!isInitialized || !instDecayPolicy.Has<InstDecayPolicyType>())
-  {
-    instDecayPolicy.Clean();
-    instDecayPolicy.Set<InstDecayPolicyType>(
-        new InstDecayPolicyType(decayPolicy));
-  }
+    instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
 
   // Initialize the update policy.
-  if (resetPolicy || !isInitialized ||
+  if ((resetPolicy && !isRestored) || !isInitialized ||
       !instUpdatePolicy.Has<InstUpdatePolicyType>())
   {
-    instUpdatePolicy.Clean();
-    instUpdatePolicy.Set<InstUpdatePolicyType>(
-        new InstUpdatePolicyType(updatePolicy, iterate.n_rows, iterate.n_cols));
+    instUpdatePolicy.Emplace<InstUpdatePolicyType>(
+        updatePolicy, iterate.n_rows, iterate.n_cols);
     isInitialized = true;
   }
+  isRestored = false;
+
+  // Look the policies up once, rather than in every step.
+  InstUpdatePolicyType& instUpdate =
+      instUpdatePolicy.As<InstUpdatePolicyType>();
+  InstDecayPolicyType& instDecay = instDecayPolicy.As<InstDecayPolicyType>();
+
+  // The buffers of the previous call are reused; if the problem has the same
+  // size, nothing is allocated.
+  if (!workspace.Has<Workspace<BaseGradType>>())
+    workspace.Emplace<Workspace<BaseGradType>>();
+  BaseGradType& gradient = workspace.As<Workspace<BaseGradType>>().gradient;
+  gradient.zeros(iterate.n_rows, iterate.n_cols);
+  std::vector<BaseGradType>& threadGradients =
+      workspace.As<Workspace<BaseGradType>>().threadGradients;
+
+  // With gradient accumulation, the gradient of the first micro-batch of each
+  // step is computed directly into the accumulated gradient, and the gradients
+  // of the others are added to it; without it, the gradient of each batch is
+  // used directly.
+  const bool accumulate = (accumulationSteps > 1);
+  BaseGradType& stepGradient = accumulate ?
+      workspace.As<Workspace<BaseGradType>>().accumulatedGradient : gradient;
+  if (accumulate)
+    stepGradient.zeros(iterate.n_rows, iterate.n_cols);
+  size_t microBatch = 0;
+  ElemType stepObjective = 0;
+
+  // With importance sampling, the functions of each minibatch are drawn from
+  // the sampler instead of being visited in order.
+  ImportanceSampler<BaseMatType, BaseGradType> sampler;
+  RandomStream rng(0);
+  if (importanceSampling)
+  {
+    sampler.Reset(numFunctions, samplingWeights, samplingSmoothing);
+    rng = RandomStream();
+  }
 
   // Now iterate!
-  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
   const size_t actualMaxIterations = (maxIterations == 0) ?
       std::numeric_limits<size_t>::max() : maxIterations;
+  // If the function has a PrepareBatch() method, the next batch is prepared on
+  // a background thread while the current batch is being used.
+  BatchPrefetcher<SeparableFunctionType> prefetcher(function);
+  if (!importanceSampling)
+  {
+    prefetcher.Prepare(currentFunction, std::min(std::min(batchSize,
+        actualMaxIterations), numFunctions));
+  }
+
   terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
   terminate |= Callback::BeginEpoch(*this, f, iterate, epoch,
       overallObjective, callbacks...);
@@ -140,48 +196,131 @@ SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
         std::min(batchSize, actualMaxIterations - i),
         numFunctions - currentFunction);
 
+    // Make sure the current batch is ready, and start preparing the next one
+    // if it is in the same epoch.
+    prefetcher.Wait();
+    const size_t nextFunction = currentFunction + effectiveBatchSize;
+    const size_t nextIteration = i + effectiveBatchSize;
+    if (nextFunction < numFunctions && nextIteration < actualMaxIterations &&
+        !importanceSampling)
+    {
+      prefetcher.Prefetch(nextFunction, std::min(std::min(batchSize,
+          actualMaxIterations - nextIteration), numFunctions - nextFunction));
+    }
+
     // Technically we are computing the objective before we take the step, but
-    // for many FunctionTypes it may be much quicker to do it like this.
-    const ElemType objective = f.EvaluateWithGradient(iterate, currentFunction,
-        gradient, effectiveBatchSize);
-    overallObjective += objective;
+    // for many FunctionTypes it may be much quicker to do it like this.  If
+    // the objective isn't needed, only the gradient is computed.
+    Callback::BeginPhase(*this, f, iterate, Phase::Function, callbacks...);
+    BaseGradType& batchGradient = (microBatch == 0) ? stepGradient : gradient;
+    ElemType objective = 0;
+    if (importanceSampling)
+    {
+      objective = sampler.EvaluateWithGradient(function, f, iterate,
+          batchGradient, effectiveBatchSize, computeObjective, rng);
+    }
+    else if (computeObjective)
+    {
+      objective = parallelBatch ?
+          ParallelEvaluateWithGradient(f, iterate, currentFunction,
+              batchGradient, effectiveBatchSize, threadGradients,
+              deterministicReduction) :
+          f.EvaluateWithGradient(iterate, currentFunction, batchGradient,
+              effectiveBatchSize);
+    }
+    else if (parallelBatch)
+    {
+      ParallelGradient(f, iterate, currentFunction, batchGradient,
+          effectiveBatchSize, threadGradients, deterministicReduction);
+    }
+    else
+    {
+      f.Gradient(iterate, currentFunction, batchGradient, effectiveBatchSize);
+    }
+    if (microBatch > 0)
+      stepGradient += gradient;
+    Callback::EndPhase(*this, f, iterate, Phase::Function, callbacks...);
 
-    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
-        gradient, callbacks...);
+    if (computeObjective)
+      CompensatedAdd(overallObjective, compensation, (AccumType) objective);
+    stepObjective += objective;
 
-    // Use the update policy to take a step.
-    instUpdatePolicy.As<InstUpdatePolicyType>().Update(iterate, stepSize,
-        gradient);
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+    ++batches;
+    ++microBatch;
 
-    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+    // The step is taken once all the micro-batches of the step have been
+    // computed, or at the end of the epoch or of the optimization.
+    if (microBatch == accumulationSteps || !accumulate ||
+        (currentFunction % numFunctions) == 0 || i >= actualMaxIterations)
+    {
+      if (computeObjective)
+      {
+        terminate |= Callback::EvaluateWithGradient(*this, f, iterate,
+            stepObjective, stepGradient, callbacks...);
+      }
+      else
+      {
+        terminate |= Callback::Gradient(*this, f, iterate, stepGradient,
+            callbacks...);
+      }
 
-    // Now update the learning rate if requested by the user.
-    instDecayPolicy.As<InstDecayPolicyType>().Update(iterate, stepSize,
-        gradient);
+      // Use the update policy to take a step.
+      Callback::BeginPhase(*this, f, iterate, Phase::Update, callbacks...);
+      if (computeObjective)
+        NotifyObjective(instUpdate, stepObjective);
+      instUpdate.Update(iterate, stepSize, stepGradient);
+      Callback::EndPhase(*this, f, iterate, Phase::Update, callbacks...);
 
-    i += effectiveBatchSize;
-    currentFunction += effectiveBatchSize;
+      terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+      // Now update the learning rate if requested by the user.
+      Callback::BeginPhase(*this, f, iterate, Phase::Decay, callbacks...);
+      instDecay.Update(iterate, stepSize, stepGradient);
+      Callback::EndPhase(*this, f, iterate, Phase::Decay, callbacks...);
+
+      microBatch = 0;
+      stepObjective = 0;
+    }
 
     // Is this iteration the start of a sequence?
-    if ((currentFunction % numFunctions) == 0)
+    const bool endOfEpoch = ((currentFunction % numFunctions) == 0);
+
+    // Check for divergence at the end of each epoch, and every
+    // divergenceCheckInterval batches if that is set.
+    if (endOfEpoch || (divergenceCheckInterval > 0 &&
+        (batches % divergenceCheckInterval) == 0))
     {
-      terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
-          overallObjective / (ElemType) numFunctions, callbacks...);
+      if (endOfEpoch)
+      {
+        terminate |= Callback::EndEpoch(*this, f, iterate, epoch++,
+            overallObjective / (AccumType) numFunctions, callbacks...);
 
-      // Output current objective function.
-      Info << "SGD: iteration " << i << ", objective " << overallObjective
-         << "." << std::endl;
+        // Output current objective function.
+        Info << "SGD: iteration " << i << ", objective " << overallObjective
+           << "." << std::endl;
+      }
 
-      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      // Without the objective, the coordinates themselves are checked.
+      using arma::accu;
+      const AccumType check = computeObjective ? overallObjective :
+          (AccumType) accu(iterate);
+      if (std::isnan(check) || std::isinf(check))
       {
-        Warn << "SGD: converged to " << overallObjective << "; terminating"
-            << " with failure.  Try a smaller step size?" << std::endl;
+        Warn << "SGD: converged to " << check << " at iteration " << i
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
 
         Callback::EndOptimization(*this, f, iterate, callbacks...);
-        return overallObjective;
+        return check;
       }
+    }
 
-      if (std::abs(lastObjective - overallObjective) < tolerance ||
+    if (endOfEpoch)
+    {
+      if ((computeObjective &&
+          std::abs(lastObjective - overallObjective) < tolerance) ||
           Callback::BeginEpoch(*this, f, iterate, epoch, overallObjective,
               callbacks...))
       {
@@ -195,10 +334,28 @@ SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
       // Reset the counter variables.
       lastObjective = overallObjective;
       overallObjective = 0;
+      compensation = 0;
       currentFunction = 0;
 
-      if (shuffle) // Determine order of visitation.
+      if (importanceSampling)
+      {
+        // Rebuild the sampling distribution from the new estimates.
+        sampler.EndEpoch();
+      }
+      else if (shuffle) // Determine order of visitation.
+      {
+        Callback::BeginPhase(*this, f, iterate, Phase::Shuffle, callbacks...);
         f.Shuffle();
+        Callback::EndPhase(*this, f, iterate, Phase::Shuffle, callbacks...);
+      }
+
+      // The first batch of the next epoch can only be prepared after
+      // shuffling.
+      if (i < actualMaxIterations && !importanceSampling)
+      {
+        prefetcher.Prepare(0, std::min(std::min(batchSize,
+            actualMaxIterations - i), numFunctions));
+      }
     }
   }
 
@@ -209,11 +366,15 @@ SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
   if (exactObjective)
   {
     overallObjective = 0;
+    compensation = 0;
     for (size_t i = 0; i < numFunctions; i += batchSize)
     {
       const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+      prefetcher.Prepare(i, effectiveBatchSize);
+      Callback::BeginPhase(*this, f, iterate, Phase::Function, callbacks...);
       const ElemType objective = f.Evaluate(iterate, i, effectiveBatchSize);
-      overallObjective += objective;
+      Callback::EndPhase(*this, f, iterate, Phase::Function, callbacks...);
+      CompensatedAdd(overallObjective, compensation, (AccumType) objective);
 
       Callback::Evaluate(*this, f, iterate, objective, callbacks...);
     }
@@ -223,6 +384,261 @@ SGD<UpdatePolicyType, DecayPolicyType>::Optimize(
   return overallObjective;
 }
 
+//! Start an optimization that is run with Step().
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename SeparableFunctionType, typename MatType, typename GradType>
+typename SGD<UpdatePolicyType, DecayPolicyType>::template State<
+    SeparableFunctionType, MatType, GradType>
+SGD<UpdatePolicyType, DecayPolicyType>::Begin(
+    SeparableFunctionType& function,
+    MatType& iterate)
+{
+  typedef State<SeparableFunctionType, MatType, GradType> StateType;
+  typedef typename StateType::BaseMatType BaseMatType;
+  typedef typename StateType::BaseGradType BaseGradType;
+
+  // Make sure we have all the methods that we need.
+  traits::CheckSeparableFunctionTypeAPI<typename StateType::FullFunctionType,
+      BaseMatType, BaseGradType>();
+  RequireFloatingPointType<BaseMatType>();
+  RequireFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  return StateType(*this, function, iterate);
+}
+
+//! Run up to n batches of an optimization started with Begin().
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename SeparableFunctionType, typename MatType, typename GradType>
+bool SGD<UpdatePolicyType, DecayPolicyType>::Step(
+    State<SeparableFunctionType, MatType, GradType>& state,
+    const size_t n)
+{
+  typedef State<SeparableFunctionType, MatType, GradType> StateType;
+  typedef typename StateType::ElemType ElemType;
+
+  typename StateType::FullFunctionType& f =
+      static_cast<typename StateType::FullFunctionType&>(*state.function);
+  typename StateType::BaseMatType& iterate = *state.iterate;
+
+  const size_t numFunctions = f.NumFunctions();
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+
+  for (size_t k = 0; k < n && !state.finished; ++k)
+  {
+    // The same batches as in Optimize().
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - state.iterations),
+        numFunctions - state.currentFunction);
+
+    // The same gradient accumulation as in Optimize().
+    const bool accumulate = (accumulationSteps > 1);
+    if (accumulate && state.accumulatedGradient.n_elem != iterate.n_elem)
+      state.accumulatedGradient.zeros(iterate.n_rows, iterate.n_cols);
+    typename StateType::BaseGradType& stepGradient = accumulate ?
+        state.accumulatedGradient : state.gradient;
+    typename StateType::BaseGradType& batchGradient =
+        (state.microBatch == 0) ? stepGradient : state.gradient;
+
+    // With importance sampling, the functions are prepared by the sampler.
+    if (!importanceSampling)
+    {
+      BatchPrefetcher<SeparableFunctionType>::PrepareNow(*state.function,
+          state.currentFunction, effectiveBatchSize);
+    }
+
+    if (importanceSampling || computeObjective)
+    {
+      const ElemType objective = importanceSampling ?
+          state.sampler.EvaluateWithGradient(*state.function, f, iterate,
+              batchGradient, effectiveBatchSize, computeObjective,
+              state.rng) :
+          parallelBatch ?
+          ParallelEvaluateWithGradient(f, iterate, state.currentFunction,
+              batchGradient, effectiveBatchSize, state.threadGradients,
+              deterministicReduction) :
+          f.EvaluateWithGradient(iterate, state.currentFunction,
+              batchGradient, effectiveBatchSize);
+      CompensatedAdd(state.overallObjective, state.compensation,
+          (typename StateType::AccumType) objective);
+      state.stepObjective += objective;
+    }
+    else if (parallelBatch)
+    {
+      ParallelGradient(f, iterate, state.currentFunction, batchGradient,
+          effectiveBatchSize, state.threadGradients, deterministicReduction);
+    }
+    else
+    {
+      f.Gradient(iterate, state.currentFunction, batchGradient,
+          effectiveBatchSize);
+    }
+    if (state.microBatch > 0)
+      stepGradient += state.gradient;
+
+    state.iterations += effectiveBatchSize;
+    state.currentFunction += effectiveBatchSize;
+    ++state.batches;
+    ++state.microBatch;
+
+    if (state.microBatch == accumulationSteps || !accumulate ||
+        (state.currentFunction % numFunctions) == 0 ||
+        state.iterations >= actualMaxIterations)
+    {
+      if (computeObjective)
+        NotifyObjective(state.update, state.stepObjective);
+      state.update.Update(iterate, state.stepSize, stepGradient);
+      state.decay.Update(iterate, state.stepSize, stepGradient);
+
+      state.microBatch = 0;
+      state.stepObjective = 0;
+    }
+
+    // Check for divergence as in Optimize().
+    const bool endOfEpoch = ((state.currentFunction % numFunctions) == 0);
+    if (endOfEpoch || (divergenceCheckInterval > 0 &&
+        (state.batches % divergenceCheckInterval) == 0))
+    {
+      using arma::accu;
+      const typename StateType::AccumType check = computeObjective ?
+          state.overallObjective :
+          (typename StateType::AccumType) accu(iterate);
+      if (std::isnan(check) || std::isinf(check))
+      {
+        state.objective = ElemType(check);
+        state.finished = true;
+        break;
+      }
+    }
+
+    // At the end of an epoch, check for convergence.
+    if (endOfEpoch)
+    {
+      if (computeObjective &&
+          std::abs(state.lastObjective - state.overallObjective) < tolerance)
+      {
+        state.objective = ElemType(state.overallObjective);
+        state.finished = true;
+        break;
+      }
+
+      state.lastObjective = state.overallObjective;
+      state.overallObjective = 0;
+      state.compensation = 0;
+      state.currentFunction = 0;
+
+      if (importanceSampling)
+        state.sampler.EndEpoch();
+      else if (shuffle)
+        f.Shuffle();
+    }
+
+    if (state.iterations >= actualMaxIterations)
+    {
+      // Calculate the final objective if exactObjective is set to true.
+      if (exactObjective)
+      {
+        state.overallObjective = 0;
+        state.compensation = 0;
+        for (size_t i = 0; i < numFunctions; i += batchSize)
+        {
+          const size_t batch = std::min(batchSize, numFunctions - i);
+          BatchPrefetcher<SeparableFunctionType>::PrepareNow(*state.function,
+              i, batch);
+          CompensatedAdd(state.overallObjective, state.compensation,
+              (typename StateType::AccumType) f.Evaluate(iterate, i, batch));
+        }
+      }
+
+      state.objective = ElemType(state.overallObjective);
+      state.finished = true;
+    }
+  }
+
+  return !state.finished;
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType>
+void SGD<UpdatePolicyType, DecayPolicyType>::SaveState(
+    CheckpointWriter& ar,
+    const MatType& /* iterate */)
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+  typedef typename DecayPolicyType::template Policy<BaseMatType, BaseGradType>
+      InstDecayPolicyType;
+
+  if (!isInitialized || !instUpdatePolicy.Has<InstUpdatePolicyType>() ||
+      !instDecayPolicy.Has<InstDecayPolicyType>())
+  {
+    throw std::logic_error("SGD::SaveState(): the policies have not been "
+        "instantiated for this matrix type; call Optimize() first.");
+  }
+
+  ar(stepSize);
+  SerializeState(instUpdatePolicy.As<InstUpdatePolicyType>(), ar);
+  SerializeState(instDecayPolicy.As<InstDecayPolicyType>(), ar);
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType>
+void SGD<UpdatePolicyType, DecayPolicyType>::LoadState(
+    CheckpointReader& ar,
+    const MatType& iterate)
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+  typedef typename UpdatePolicyType::template Policy<BaseMatType, BaseGradType>
+      InstUpdatePolicyType;
+  typedef typename DecayPolicyType::template Policy<BaseMatType, BaseGradType>
+      InstDecayPolicyType;
+
+  ar(stepSize);
+
+  instUpdatePolicy.Emplace<InstUpdatePolicyType>(
+      updatePolicy, iterate.n_rows, iterate.n_cols);
+  SerializeState(instUpdatePolicy.As<InstUpdatePolicyType>(), ar);
+
+  instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
+  SerializeState(instDecayPolicy.As<InstDecayPolicyType>(), ar);
+
+  isInitialized = true;
+  isRestored = true;
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType>
+size_t SGD<UpdatePolicyType, DecayPolicyType>::StateBytes(
+    const size_t rows,
+    const size_t cols) const
+{
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  const size_t gradientBytes = MatrixBytes<BaseGradType>(rows, cols);
+  size_t bytes = ens::PolicyStateBytes<BaseMatType, BaseGradType>(
+      updatePolicy, rows, cols) + ens::PolicyStateBytes<BaseMatType,
+      BaseGradType>(decayPolicy, rows, cols) + gradientBytes;
+
+  // The per-thread buffers; see ParallelEvaluateWithGradient().
+  if (parallelBatch)
+  {
+    const size_t chunks = deterministicReduction ? (batchSize + 31) / 32 :
+        std::min(MaxThreads(), batchSize);
+    if (chunks > 1)
+      bytes += chunks * gradientBytes;
+  }
+
+  if (accumulationSteps > 1)
+    bytes += gradientBytes;
+
+  return bytes;
+}
+
 } // namespace ens
 
 #endif
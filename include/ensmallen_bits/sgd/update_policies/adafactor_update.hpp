@@ -0,0 +1,440 @@
+/**
+ * @file adafactor_update.hpp
+ *
+ * Adafactor update for Stochastic Gradient Descent: an adaptive update whose
+ * second moment estimates of a matrix are factored into per-row and
+ * per-column estimates.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_ADAFACTOR_UPDATE_HPP
+#define ENSMALLEN_SGD_ADAFACTOR_UPDATE_HPP
+
+#include <ensmallen_bits/utility/fused_update.hpp>
+
+namespace ens {
+
+/**
+ * Adafactor update policy for Stochastic Gradient Descent.  Like RMSProp and
+ * Adam, the gradient is divided by the square root of an exponential moving
+ * average of its squares; but for an n x m matrix of coordinates, this average
+ * is estimated from the moving averages of the means of each row and of each
+ * column of the squared gradient, so that the state has n + m elements
+ * instead of n * m.  Coordinate vectors are not factored.
+ *
+ * At step t, with beta2_t = 1 - t^decayRate and G = g^2 + epsilon1, the update
+ * is
+ *
+ *   R = beta2_t R + (1 - beta2_t) rowMeans(G)
+ *   C = beta2_t C + (1 - beta2_t) colMeans(G)
+ *   V = R C^T / mean(R)
+ *   U = g / sqrt(V)
+ *   U = U / max(1, RMS(U) / clipThreshold)
+ *   x = x - stepSize U
+ *
+ * If beta1 > 0, U is also smoothed by a momentum term (which takes as much
+ * memory as the coordinates), and if scaleParameter is true, the step size is
+ * relative to the RMS of the coordinates (at least epsilon2).  For dense
+ * matrices of floating-point elements, the update takes three passes over the
+ * gradient and allocates no temporaries; sparse gradients are made dense
+ * first.  The coordinates must be a dense Armadillo matrix.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{shazeer2018adafactor,
+ *   title     = {Adafactor: Adaptive Learning Rates with Sublinear Memory
+ *                Cost},
+ *   author    = {Shazeer, Noam and Stern, Mitchell},
+ *   booktitle = {Proceedings of the 35th International Conference on Machine
+ *                Learning},
+ *   pages     = {4596--4604},
+ *   year      = {2018}
+ * }
+ * @endcode
+ */
+class AdafactorUpdate
+{
+ public:
+  /**
+   * Construct the Adafactor update policy with the given parameters.
+   *
+   * @param beta1 Momentum term for the updates (0 disables the momentum).
+   * @param decayRate Exponent of the decay of the second moment estimates;
+   *     beta2_t = 1 - t^decayRate.
+   * @param clipThreshold The largest RMS of an update, before the step size.
+   * @param epsilon1 Value added to the squared gradient.
+   * @param epsilon2 Smallest RMS of the coordinates that scales the step size.
+   * @param scaleParameter If true, the step size is multiplied with the RMS of
+   *     the coordinates.
+   */
+  AdafactorUpdate(const double beta1 = 0.0,
+                  const double decayRate = -0.8,
+                  const double clipThreshold = 1.0,
+                  const double epsilon1 = 1e-30,
+                  const double epsilon2 = 1e-3,
+                  const bool scaleParameter = false) :
+      beta1(beta1),
+      decayRate(decayRate),
+      clipThreshold(clipThreshold),
+      epsilon1(epsilon1),
+      epsilon2(epsilon2),
+      scaleParameter(scaleParameter)
+  { /* Nothing to do. */ }
+
+  //! Get the momentum term.
+  double Beta1() const { return beta1; }
+  //! Modify the momentum term.
+  double& Beta1() { return beta1; }
+
+  //! Get the exponent of the decay of the second moment estimates.
+  double DecayRate() const { return decayRate; }
+  //! Modify the exponent of the decay of the second moment estimates.
+  double& DecayRate() { return decayRate; }
+
+  //! Get the largest RMS of an update.
+  double ClipThreshold() const { return clipThreshold; }
+  //! Modify the largest RMS of an update.
+  double& ClipThreshold() { return clipThreshold; }
+
+  //! Get the value added to the squared gradient.
+  double Epsilon1() const { return epsilon1; }
+  //! Modify the value added to the squared gradient.
+  double& Epsilon1() { return epsilon1; }
+
+  //! Get the smallest RMS of the coordinates that scales the step size.
+  double Epsilon2() const { return epsilon2; }
+  //! Modify the smallest RMS of the coordinates that scales the step size.
+  double& Epsilon2() { return epsilon2; }
+
+  //! Get whether or not the step size is relative to the coordinates.
+  bool ScaleParameter() const { return scaleParameter; }
+  //! Modify whether or not the step size is relative to the coordinates.
+  bool& ScaleParameter() { return scaleParameter; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the factored (or, for vectors, full) second moment
+  //! estimates, and the momentum if beta1 > 0.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    const size_t moments = (rows > 1 && cols > 1) ? 2 * (rows + cols) :
+        rows * cols;
+    return (moments + ((beta1 > 0) ? rows * cols : 0)) *
+        sizeof(typename MatType::elem_type);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    //! The type of the elements of the coordinates.
+    typedef typename MatType::elem_type ElemType;
+
+    static_assert(std::is_floating_point<ElemType>::value &&
+        std::is_base_of<arma::Mat<ElemType>, MatType>::value,
+        "AdafactorUpdate: the coordinates must be a dense Armadillo matrix of "
+        "floating-point elements.");
+
+    /**
+     * This constructor is called by the SGD Optimize() method before the start
+     * of the iteration update process.  A matrix with more than one row and
+     * more than one column gets factored second moment estimates.
+     *
+     * @param parent AdafactorUpdate object.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(AdafactorUpdate& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        rows(rows),
+        cols(cols),
+        iteration(0)
+    {
+      if (Factored())
+      {
+        r.zeros(rows, 1);
+        c.zeros(cols, 1);
+        rowScale.zeros(rows, 1);
+        colScale.zeros(cols, 1);
+      }
+      else
+      {
+        v.zeros(rows * cols, 1);
+      }
+
+      if (parent.beta1 > 0)
+        m.zeros(rows, cols);
+    }
+
+    /**
+     * Update step for Adafactor.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the second moment estimates, the momentum and the
+     * iteration counter, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(r);
+      ar(c);
+      ar(v);
+      ar(m);
+      ar(iteration);
+    }
+
+   private:
+    //! Whether or not the second moment estimates are factored.
+    bool Factored() const { return rows > 1 && cols > 1; }
+
+    //! Update with a dense gradient.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::true_type /* dense */)
+    {
+      Step(iterate, stepSize, gradient.memptr());
+    }
+
+    //! Update with any other gradient, which is made dense first.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* dense */)
+    {
+      const arma::Mat<ElemType> denseGradient(gradient);
+      Step(iterate, stepSize, denseGradient.memptr());
+    }
+
+    /**
+     * The fused update.  The first pass updates the second moment estimates,
+     * and the second computes the RMS of the unclipped update (and of the
+     * coordinates, if needed) without storing it; the last one recomputes the
+     * update and applies it.
+     */
+    void Step(MatType& iterate, const double stepSize, const ElemType* g)
+    {
+      ++iteration;
+      const double beta2 = 1.0 - std::pow((double) iteration,
+          parent.decayRate);
+      const ElemType b2 = ElemType(beta2);
+      const ElemType oneMinusB2 = ElemType(1 - beta2);
+      const ElemType eps1 = ElemType(parent.epsilon1);
+      const size_t n = rows * cols;
+      ElemType* x = iterate.memptr();
+
+      double squaredUpdate = 0.0;
+      double squaredIterate = 0.0;
+      if (Factored())
+      {
+        // Accumulate the row and column means of the squared gradient into
+        // the moving averages (rowScale holds the row sums meanwhile).
+        ElemType* rowSums = rowScale.memptr();
+        std::fill(rowSums, rowSums + rows, ElemType(0));
+        ElemType* cp = c.memptr();
+        for (size_t j = 0; j < cols; ++j)
+        {
+          const ElemType* gj = g + j * rows;
+          ElemType colSum = ElemType(0);
+          ENS_PRAGMA_OMP_SIMD_SUM(colSum)
+          for (size_t i = 0; i < rows; ++i)
+          {
+            const ElemType gi = gj[i] * gj[i] + eps1;
+            rowSums[i] += gi;
+            colSum += gi;
+          }
+          cp[j] = b2 * cp[j] + oneMinusB2 * (colSum / ElemType(rows));
+        }
+
+        ElemType* rp = r.memptr();
+        double meanR = 0.0;
+        for (size_t i = 0; i < rows; ++i)
+        {
+          rp[i] = b2 * rp[i] + oneMinusB2 * (rowSums[i] / ElemType(cols));
+          meanR += rp[i];
+        }
+        meanR /= rows;
+
+        // V_ij = R_i C_j / mean(R), so 1 / sqrt(V_ij) = rowScale_i *
+        // colScale_j.
+        ElemType* rs = rowScale.memptr();
+        ElemType* cs = colScale.memptr();
+        for (size_t i = 0; i < rows; ++i)
+          rs[i] = ElemType(1) / std::sqrt(rp[i]);
+        for (size_t j = 0; j < cols; ++j)
+          cs[j] = ElemType(std::sqrt(meanR)) / std::sqrt(cp[j]);
+
+        for (size_t j = 0; j < cols; ++j)
+        {
+          const ElemType* gj = g + j * rows;
+          const ElemType* xj = x + j * rows;
+          const ElemType csj = cs[j];
+          double su = 0.0;
+          double sx = 0.0;
+          ENS_PRAGMA_OMP_SIMD_SUM2(su, sx)
+          for (size_t i = 0; i < rows; ++i)
+          {
+            const ElemType u = gj[i] * rs[i] * csj;
+            su += double(u) * double(u);
+            sx += double(xj[i]) * double(xj[i]);
+          }
+          squaredUpdate += su;
+          squaredIterate += sx;
+        }
+      }
+      else
+      {
+        ElemType* vp = v.memptr();
+        double su = 0.0;
+        double sx = 0.0;
+        ENS_PRAGMA_OMP_SIMD_SUM2(su, sx)
+        for (size_t i = 0; i < n; ++i)
+        {
+          const ElemType vi = b2 * vp[i] + oneMinusB2 * (g[i] * g[i] + eps1);
+          vp[i] = vi;
+          const ElemType u = g[i] / std::sqrt(vi);
+          su += double(u) * double(u);
+          sx += double(x[i]) * double(x[i]);
+        }
+        squaredUpdate = su;
+        squaredIterate = sx;
+      }
+
+      // Clip the update by its RMS, and scale the step size.
+      const double rms = std::sqrt(squaredUpdate / n);
+      double alpha = stepSize / std::max(1.0, rms / parent.clipThreshold);
+      if (parent.scaleParameter)
+        alpha *= std::max(parent.epsilon2, std::sqrt(squaredIterate / n));
+
+      const ElemType a = ElemType(alpha);
+      const bool momentum = (parent.beta1 > 0);
+      if (momentum && m.n_elem != n)
+        m.zeros(rows, cols);
+      ElemType* mp = momentum ? m.memptr() : NULL;
+
+      if (Factored())
+      {
+        const ElemType* rs = rowScale.memptr();
+        for (size_t j = 0; j < cols; ++j)
+        {
+          const ElemType* gj = g + j * rows;
+          const ElemType csj = colScale[j];
+          Apply(x + j * rows, momentum ? mp + j * rows : NULL, rows, a,
+              [&](const size_t i) { return gj[i] * rs[i] * csj; });
+        }
+      }
+      else
+      {
+        const ElemType* vp = v.memptr();
+        Apply(x, mp, n, a,
+            [&](const size_t i) { return g[i] / std::sqrt(vp[i]); });
+      }
+    }
+
+    /**
+     * Apply the update u(i) to the elements [0, length) of the coordinates,
+     * through the momentum `mp` unless it is NULL.
+     */
+    template<typename UpdateType>
+    void Apply(ElemType* x,
+               ElemType* mp,
+               const size_t length,
+               const ElemType a,
+               const UpdateType& u)
+    {
+      if (mp == NULL)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = 0; i < length; ++i)
+          x[i] -= a * u(i);
+        return;
+      }
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < length; ++i)
+      {
+        const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * u(i);
+        mp[i] = mi;
+        x[i] -= a * mi;
+      }
+    }
+
+    //! Instantiated parent object.
+    AdafactorUpdate& parent;
+
+    //! The number of rows of the coordinates.
+    size_t rows;
+
+    //! The number of columns of the coordinates.
+    size_t cols;
+
+    //! The moving average of the row means of the squared gradient.
+    arma::Mat<ElemType> r;
+
+    //! The moving average of the column means of the squared gradient.
+    arma::Mat<ElemType> c;
+
+    //! The moving average of the squared gradient, if it isn't factored.
+    arma::Mat<ElemType> v;
+
+    //! The momentum of the updates, if beta1 > 0.
+    arma::Mat<ElemType> m;
+
+    //! The row factors of the inverse square root of the second moments.
+    arma::Mat<ElemType> rowScale;
+
+    //! The column factors of the inverse square root of the second moments.
+    arma::Mat<ElemType> colScale;
+
+    //! The number of steps taken.
+    size_t iteration;
+  };
+
+ private:
+  //! The momentum term.
+  double beta1;
+
+  //! The exponent of the decay of the second moment estimates.
+  double decayRate;
+
+  //! The largest RMS of an update.
+  double clipThreshold;
+
+  //! The value added to the squared gradient.
+  double epsilon1;
+
+  //! The smallest RMS of the coordinates that scales the step size.
+  double epsilon2;
+
+  //! Whether or not the step size is relative to the coordinates.
+  bool scaleParameter;
+};
+
+} // namespace ens
+
+#endif
@@ -14,11 +14,41 @@
 
 namespace ens {
 
+namespace traits {
+
+//! Detect an Update() overload of an instantiated update policy that applies
+//! an element-wise transform to the gradient (see ClipTransform).
+template<typename PolicyType, typename MatType, typename GradType>
+struct HasTransformUpdate
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().Update(
+      std::declval<MatType&>(), 0.0, std::declval<const GradType&>(),
+      std::declval<const ClipTransform<typename GradType::elem_type>&>()),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+} // namespace traits
+
 /**
  * Interface for wrapping around update policies (e.g., VanillaUpdate)
  * and feeding a clipped gradient to them instead of the normal one.
- * (Clipping here is implemented as
- * \f$ g_{\text{clipped}} = \max(g_{\text{min}}, \min(g_{\text{min}}, g))) \f$.)
+ * The gradient can be clipped by its global norm, and each of its elements can
+ * be clipped to a range:
+ * \f$ g_{\text{clipped}} = \max(g_{\text{min}}, \min(g_{\text{max}}, s g)) \f$,
+ * where \f$ s = \min(1, \text{maxNorm} / \|g\|) \f$.
+ *
+ * If the wrapped policy has a fused update that can transform the gradient as
+ * it is read (as VanillaUpdate, MomentumUpdate and the policies based on Adam
+ * do for dense matrices), the clipping is done inside that update, so it costs
+ * at most one reduction (for the norm) and no temporary.  Otherwise, the
+ * clipped gradient is written to a buffer that is reused between steps, and
+ * then given to the wrapped policy.
  *
  * @tparam UpdatePolicy A type of UpdatePolicy that sould be wrapped around.
  */
@@ -27,25 +57,48 @@ class GradientClipping
 {
  public:
   /**
-   * Constructor for creating a GradientClipping instance.
+   * Constructor for creating a GradientClipping instance that clips each
+   * element of the gradient to the given range.
    *
    * @param minGradient Minimum possible value of gradient element.
    * @param maxGradient Maximum possible value of gradient element.
    * @param updatePolicy An instance of the UpdatePolicyType
    *                     used for actual optimization.
+   * @param maxNorm Maximum norm of the gradient; the gradient is scaled down to
+   *     this norm before its elements are clipped.  0 means the norm is not
+   *     clipped.
    */
   GradientClipping(const double minGradient,
                    const double maxGradient,
-                   UpdatePolicyType& updatePolicy) :
+                   UpdatePolicyType& updatePolicy,
+                   const double maxNorm = 0.0) :
       minGradient(minGradient),
       maxGradient(maxGradient),
+      maxNorm(maxNorm),
+      updatePolicy(updatePolicy)
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Constructor for creating a GradientClipping instance that only clips the
+   * gradient by its global (Frobenius) norm.
+   *
+   * @param maxNorm Maximum norm of the gradient.
+   * @param updatePolicy An instance of the UpdatePolicyType
+   *                     used for actual optimization.
+   */
+  GradientClipping(const double maxNorm, UpdatePolicyType& updatePolicy) :
+      minGradient(-std::numeric_limits<double>::infinity()),
+      maxGradient(std::numeric_limits<double>::infinity()),
+      maxNorm(maxNorm),
       updatePolicy(updatePolicy)
   {
     // Nothing to do here.
   }
 
   //! Get the update policy.
-  UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
   UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
 
@@ -59,6 +112,24 @@ class GradientClipping
   //! Modify the maximum gradient value.
   double& MaxGradient() { return maxGradient; }
 
+  //! Get the maximum gradient norm (0 if the norm is not clipped).
+  double MaxNorm() const { return maxNorm; }
+  //! Modify the maximum gradient norm (0 if the norm is not clipped).
+  double& MaxNorm() { return maxNorm; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the state of the wrapped policy, and the clipped
+  //! gradient if the wrapped policy can't clip it in its fused update.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    const bool fused = UseFusedUpdate<MatType, GradType>::value &&
+        traits::HasTransformUpdate<typename UpdatePolicyType::template
+        Policy<MatType, GradType>, MatType, GradType>::value;
+    return ens::PolicyStateBytes<MatType, GradType>(updatePolicy, rows,
+        cols) + (fused ? 0 : MatrixBytes<GradType>(rows, cols));
+  }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -77,7 +148,7 @@ class GradientClipping
      * @param rows Number of rows in the gradient matrix.
      * @param cols Number of columns in the gradient matrix.
      */
-    Policy(const GradientClipping<UpdatePolicyType>& parent,
+    Policy(GradientClipping<UpdatePolicyType>& parent,
            const size_t rows,
            const size_t cols) :
         parent(parent),
@@ -100,20 +171,70 @@ class GradientClipping
     {
       typedef typename GradType::elem_type GradElemType;
 
-      // First, clip the gradient.
-      GradType clippedGradient = arma::clamp(gradient,
-          GradElemType(parent.minGradient),
-          GradElemType(parent.maxGradient));
+      double scale = 1.0;
+      if (parent.maxNorm > 0.0)
+      {
+        const double norm = arma::norm(gradient, "fro");
+        if (norm > parent.maxNorm)
+          scale = parent.maxNorm / norm;
+      }
 
-      // And only then do the update.
-      instPolicy.Update(iterate, stepSize, clippedGradient);
+      const ClipTransform<GradElemType> transform(GradElemType(scale),
+          GradElemType(parent.minGradient), GradElemType(parent.maxGradient));
+
+      Update(iterate, stepSize, gradient, transform,
+          std::integral_constant<bool, UseFusedUpdate<MatType, GradType>::value
+          && traits::HasTransformUpdate<InstPolicyType, MatType,
+          GradType>::value>());
+    }
+
+    /**
+     * Give the objective of the current batch to the wrapped policy.
+     *
+     * @param objective The objective of the current batch.
+     */
+    void ObjectiveFeedback(const double objective)
+    {
+      NotifyObjective(instPolicy, objective);
     }
 
    private:
+    //! The type of the instantiated update policy.
+    typedef typename UpdatePolicyType::template Policy<MatType, GradType>
+        InstPolicyType;
+
+    //! Clip the gradient inside the fused update of the wrapped policy.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const ClipTransform<typename GradType::elem_type>& transform,
+                std::true_type /* fused */)
+    {
+      instPolicy.Update(iterate, stepSize, gradient, transform);
+    }
+
+    //! Clip the gradient into the buffer, and then do the update.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const ClipTransform<typename GradType::elem_type>& transform,
+                std::false_type /* fused */)
+    {
+      if (transform.scale != 1)
+        clippedGradient = arma::clamp(transform.scale * gradient,
+            transform.min, transform.max);
+      else
+        clippedGradient = arma::clamp(gradient, transform.min, transform.max);
+
+      instPolicy.Update(iterate, stepSize, clippedGradient);
+    }
+
     // The instantiated parent class.
-    const GradientClipping<UpdatePolicyType>& parent;
+    GradientClipping<UpdatePolicyType>& parent;
     // The instantiated update policy we will use.
-    typename UpdatePolicyType::template Policy<MatType, GradType> instPolicy;
+    InstPolicyType instPolicy;
+    // The clipped gradient, if the wrapped policy can't clip it itself.
+    GradType clippedGradient;
   };
 
  private:
@@ -123,6 +244,9 @@ class GradientClipping
   //! Maximum possible value of gradient element.
   double maxGradient;
 
+  //! Maximum norm of the gradient (0 if the norm is not clipped).
+  double maxNorm;
+
   //! An instance of the UpdatePolicy used for actual optimization.
   UpdatePolicyType updatePolicy;
 };
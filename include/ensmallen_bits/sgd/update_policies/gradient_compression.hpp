@@ -0,0 +1,360 @@
+/**
+ * @file gradient_compression.hpp
+ *
+ * Gradient compression update wrapper, and the compression methods that can
+ * be used with it.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_GRADIENT_COMPRESSION_HPP
+#define ENSMALLEN_SGD_GRADIENT_COMPRESSION_HPP
+
+namespace ens {
+
+/**
+ * Top-k sparsification: only the given fraction of the gradient elements with
+ * the largest absolute values is kept, and all other elements are set to zero.
+ * At least one element is always kept.
+ */
+class TopKCompression
+{
+ public:
+  /**
+   * Construct the top-k compression.
+   *
+   * @param ratio Fraction of the gradient elements to keep.
+   */
+  TopKCompression(const double ratio = 0.01) : ratio(ratio)
+  { /* Nothing to do. */ }
+
+  /**
+   * Compress the given dense gradient in place.
+   *
+   * @param gradient Gradient to compress.
+   */
+  template<typename GradType>
+  void Compress(GradType& gradient) const
+  {
+    typedef typename GradType::elem_type ElemType;
+
+    const size_t n = gradient.n_elem;
+    const size_t k = KeepCount(n, ratio);
+    if (k >= n)
+      return;
+
+    // Find the k'th largest absolute value.
+    arma::Col<ElemType> magnitudes = arma::abs(arma::vectorise(gradient));
+    std::nth_element(magnitudes.begin(), magnitudes.begin() + (n - k),
+        magnitudes.end());
+    const ElemType threshold = magnitudes[n - k];
+
+    ElemType* g = gradient.memptr();
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (std::abs(g[i]) < threshold)
+        g[i] = 0;
+    }
+  }
+
+  //! Get the fraction of the gradient elements to keep.
+  double Ratio() const { return ratio; }
+  //! Modify the fraction of the gradient elements to keep.
+  double& Ratio() { return ratio; }
+
+  //! Return the number of elements to keep out of n.
+  static size_t KeepCount(const size_t n, const double ratio)
+  {
+    const size_t k = (size_t) std::ceil(ratio * n);
+    return std::max(std::min(k, n), (size_t) 1);
+  }
+
+ private:
+  //! The fraction of the gradient elements to keep.
+  double ratio;
+};
+
+/**
+ * Random-k sparsification: a random subset containing the given fraction of the
+ * gradient elements is kept, and all other elements are set to zero.
+ */
+class RandomKCompression
+{
+ public:
+  /**
+   * Construct the random-k compression.
+   *
+   * @param ratio Fraction of the gradient elements to keep.
+   */
+  RandomKCompression(const double ratio = 0.01) : ratio(ratio)
+  { /* Nothing to do. */ }
+
+  /**
+   * Compress the given dense gradient in place.
+   *
+   * @param gradient Gradient to compress.
+   */
+  template<typename GradType>
+  void Compress(GradType& gradient) const
+  {
+    const size_t n = gradient.n_elem;
+    const size_t k = TopKCompression::KeepCount(n, ratio);
+    if (k >= n)
+      return;
+
+    arma::uvec drop = arma::randperm(n);
+    drop = drop.tail(n - k);
+    gradient.elem(drop).zeros();
+  }
+
+  //! Get the fraction of the gradient elements to keep.
+  double Ratio() const { return ratio; }
+  //! Modify the fraction of the gradient elements to keep.
+  double& Ratio() { return ratio; }
+
+ private:
+  //! The fraction of the gradient elements to keep.
+  double ratio;
+};
+
+/**
+ * Quantization of the gradient to the given number of bits per element.  With
+ * b > 1 bits, each element is rounded to one of the 2^(b - 1) - 1 evenly spaced
+ * levels on either side of zero, scaled by the largest absolute value of the
+ * gradient.  With 1 bit, each element is replaced by its sign times the mean
+ * absolute value of the gradient.
+ */
+class QuantizedCompression
+{
+ public:
+  /**
+   * Construct the quantized compression.
+   *
+   * @param bits Number of bits per gradient element (between 1 and 32).
+   */
+  QuantizedCompression(const size_t bits = 8) : bits(bits)
+  { /* Nothing to do. */ }
+
+  /**
+   * Compress the given dense gradient in place.
+   *
+   * @param gradient Gradient to compress.
+   */
+  template<typename GradType>
+  void Compress(GradType& gradient) const
+  {
+    typedef typename GradType::elem_type ElemType;
+
+    // More levels than a 32-bit integer can count are never useful, and the
+    // shift below must stay within a size_t.
+    if (bits == 0 || bits > 32)
+    {
+      throw std::invalid_argument("QuantizedCompression::Compress(): the "
+          "number of bits must be between 1 and 32");
+    }
+
+    if (gradient.n_elem == 0)
+      return;
+
+    if (bits == 1)
+    {
+      const ElemType scale = arma::mean(arma::abs(arma::vectorise(gradient)));
+      gradient = scale * arma::sign(gradient);
+      return;
+    }
+
+    const ElemType scale = arma::abs(gradient).max();
+    if (scale == 0)
+      return;
+
+    const ElemType levels = ElemType((size_t(1) << (bits - 1)) - 1);
+    gradient = arma::round(gradient * (levels / scale)) * (scale / levels);
+  }
+
+  //! Get the number of bits per gradient element.
+  size_t Bits() const { return bits; }
+  //! Modify the number of bits per gradient element.
+  size_t& Bits() { return bits; }
+
+ private:
+  //! The number of bits per gradient element.
+  size_t bits;
+};
+
+/**
+ * Interface for wrapping around update policies (e.g., VanillaUpdate) and
+ * feeding a compressed gradient to them instead of the normal one.  The
+ * compression is done by the given CompressionType, which must provide a method
+ * `void Compress(GradType& gradient) const`; TopKCompression,
+ * RandomKCompression and QuantizedCompression are available.
+ *
+ * If error feedback is enabled, the part of the gradient that was lost in the
+ * compression is kept, and added to the next gradient before it is compressed;
+ * this makes sure that all of the gradient is eventually applied, which is
+ * needed for aggressive compression (e.g. top-k with a small ratio, or 1-bit
+ * quantization) to converge.
+ *
+ * For more information, see the following.
+ *
+ * @code
+ * @inproceedings{stich2018sparsified,
+ *   title     = {Sparsified {SGD} with Memory},
+ *   author    = {Stich, Sebastian U. and Cordonnier, Jean-Baptiste and
+ *                Jaggi, Martin},
+ *   booktitle = {Advances in Neural Information Processing Systems},
+ *   pages     = {4447--4458},
+ *   year      = {2018}
+ * }
+ * @endcode
+ *
+ * The gradient must be a dense matrix.
+ *
+ * @tparam CompressionType Type of the compression to use.
+ * @tparam UpdatePolicyType A type of UpdatePolicy that should be wrapped
+ *     around.
+ */
+template<typename CompressionType, typename UpdatePolicyType = VanillaUpdate>
+class GradientCompression
+{
+ public:
+  /**
+   * Constructor for creating a GradientCompression instance.
+   *
+   * @param compression An instance of the CompressionType.
+   * @param updatePolicy An instance of the UpdatePolicyType used for actual
+   *     optimization.
+   * @param errorFeedback If true, the compression error is added to the next
+   *     gradient.
+   */
+  GradientCompression(
+      const CompressionType& compression = CompressionType(),
+      const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+      const bool errorFeedback = true) :
+      compression(compression),
+      updatePolicy(updatePolicy),
+      errorFeedback(errorFeedback)
+  {
+    // Nothing to do here.
+  }
+
+  //! Get the compression.
+  const CompressionType& Compression() const { return compression; }
+  //! Modify the compression.
+  CompressionType& Compression() { return compression; }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get whether or not error feedback is used.
+  bool ErrorFeedback() const { return errorFeedback; }
+  //! Modify whether or not error feedback is used.
+  bool& ErrorFeedback() { return errorFeedback; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the state of the wrapped policy, the compressed
+  //! gradient, and the residual if error feedback is used.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return ens::PolicyStateBytes<MatType, GradType>(updatePolicy, rows,
+        cols) + (errorFeedback ? 2 : 1) * MatrixBytes<GradType>(rows, cols);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(GradientCompression& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instPolicy(parent.UpdatePolicy(), rows, cols)
+    {
+      if (parent.ErrorFeedback())
+        residual.zeros(rows, cols);
+    }
+
+    /**
+     * Update step. First, the gradient is compressed, and then the actual
+     * update policy does whatever update it needs to do.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      if (parent.ErrorFeedback())
+      {
+        // Compress the gradient plus the error of the previous steps, and keep
+        // the new error.
+        residual += gradient;
+        compressed = residual;
+        parent.Compression().Compress(compressed);
+        residual -= compressed;
+      }
+      else
+      {
+        compressed = gradient;
+        parent.Compression().Compress(compressed);
+      }
+
+      // And only then do the update.
+      instPolicy.Update(iterate, stepSize, compressed);
+    }
+
+    /**
+     * Give the objective of the current batch to the wrapped policy.
+     *
+     * @param objective The objective of the current batch.
+     */
+    void ObjectiveFeedback(const double objective)
+    {
+      NotifyObjective(instPolicy, objective);
+    }
+
+   private:
+    // The instantiated parent class.
+    GradientCompression& parent;
+    // The instantiated update policy we will use.
+    typename UpdatePolicyType::template Policy<MatType, GradType> instPolicy;
+    // The part of the gradient that has not been applied yet.
+    GradType residual;
+    // The compressed gradient.
+    GradType compressed;
+  };
+
+ private:
+  //! The compression to use.
+  CompressionType compression;
+
+  //! An instance of the UpdatePolicy used for actual optimization.
+  UpdatePolicyType updatePolicy;
+
+  //! Whether or not the compression error is added to the next gradient.
+  bool errorFeedback;
+};
+
+} // namespace ens
+
+#endif
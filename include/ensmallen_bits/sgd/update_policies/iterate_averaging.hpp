@@ -0,0 +1,322 @@
+/**
+ * @file iterate_averaging.hpp
+ *
+ * Polyak and exponential moving averages of the iterates of SGD, computed
+ * inside the update step.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_ITERATE_AVERAGING_HPP
+#define ENSMALLEN_SGD_ITERATE_AVERAGING_HPP
+
+#include <ensmallen_bits/utility/fused_update.hpp>
+
+namespace ens {
+
+namespace traits {
+
+//! Detect a SinkUpdate() method of an instantiated update policy, which passes
+//! each element of the new iterate to a sink (see AverageSink).
+template<typename PolicyType, typename MatType, typename GradType>
+struct HasSinkUpdate
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().SinkUpdate(
+      std::declval<MatType&>(), 0.0, std::declval<const GradType&>(),
+      std::declval<const AverageSink<typename MatType::elem_type>&>()),
+      std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * IterateAveraging wraps an update policy, and keeps an average of the
+ * iterates that it produces, which is often a better solution than the last
+ * iterate (e.g. for evaluation while training).  Two averages are available:
+ *
+ *  - with a decay of 0 (the default), the Polyak-Ruppert average: the uniform
+ *    average of the iterates since step Start();
+ *  - with a decay in (0, 1), the exponential moving average
+ *    average = decay * average + (1 - decay) * iterate, which starts at the
+ *    first averaged iterate.
+ *
+ * The average is updated every Interval() steps after step Start(); for an
+ * exponential moving average over every k-th iterate, the decay is applied
+ * once per averaged iterate.  For dense matrices and the VanillaUpdate,
+ * MomentumUpdate, NesterovMomentumUpdate, QHUpdate and AdamUpdate policies,
+ * the average is updated inside the fused update step of the wrapped policy
+ * (see AverageSink), so averaging costs no extra pass over the iterate; for
+ * the other policies, it costs one extra (fused) pass after their update.
+ *
+ * The average is held by this object, and can be used directly after (or
+ * during) the optimization without copying it:
+ *
+ * @code
+ * typedef IterateAveraging<AdamUpdate> AveragedAdam;
+ * SGD<AveragedAdam> optimizer(0.001, 32, 100000, 1e-5, true,
+ *     AveragedAdam(AdamUpdate(), 0.999));
+ * optimizer.Optimize(f, coordinates);
+ * const arma::mat& average = optimizer.UpdatePolicy().Average();
+ * @endcode
+ *
+ * @tparam UpdatePolicyType The update policy to wrap.
+ */
+template<typename UpdatePolicyType>
+class IterateAveraging
+{
+ public:
+  /**
+   * Construct the averaging of the iterates of the given update policy.
+   *
+   * @param updatePolicy The update policy to wrap.
+   * @param decay Decay of the exponential moving average, or 0 for the
+   *     uniform average.
+   * @param start Number of steps before the first averaged iterate.
+   * @param interval Number of steps between two averaged iterates.
+   */
+  IterateAveraging(const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
+                   const double decay = 0.0,
+                   const size_t start = 0,
+                   const size_t interval = 1) :
+      updatePolicy(updatePolicy),
+      decay(decay),
+      start(start),
+      interval(interval)
+  {
+    // Nothing to do.
+  }
+
+  //! Get the update policy.
+  const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
+  //! Modify the update policy.
+  UpdatePolicyType& UpdatePolicy() { return updatePolicy; }
+
+  //! Get the decay of the exponential moving average (0 for the uniform
+  //! average).
+  double Decay() const { return decay; }
+  //! Modify the decay of the exponential moving average (0 for the uniform
+  //! average).
+  double& Decay() { return decay; }
+
+  //! Get the number of steps before the first averaged iterate.
+  size_t Start() const { return start; }
+  //! Modify the number of steps before the first averaged iterate.
+  size_t& Start() { return start; }
+
+  //! Get the number of steps between two averaged iterates.
+  size_t Interval() const { return interval; }
+  //! Modify the number of steps between two averaged iterates.
+  size_t& Interval() { return interval; }
+
+  /**
+   * Get the average of the iterates of the current (or last) optimization,
+   * which has the type of the coordinates.  A std::invalid_argument is thrown
+   * if no optimization with that type was started yet.
+   *
+   * @tparam MatType Type of the coordinates.
+   */
+  template<typename MatType = arma::mat>
+  const MatType& Average() const { return average.As<MatType>(); }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the state of the wrapped policy, and the average.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return ens::PolicyStateBytes<MatType, GradType>(updatePolicy, rows,
+        cols) + MatrixBytes<MatType>(rows, cols);
+  }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  The average of the parent is reset.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(IterateAveraging<UpdatePolicyType>& parent,
+           const size_t rows,
+           const size_t cols) :
+        parent(parent),
+        instPolicy(parent.UpdatePolicy(), rows, cols),
+        average(parent.average.template Emplace<MatType>()),
+        steps(0),
+        count(0)
+    {
+      average.zeros(rows, cols);
+    }
+
+    /**
+     * Update step: the wrapped policy takes the step, and if this step is
+     * averaged, the new iterate is added to the average.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      ++steps;
+      const size_t actualInterval = std::max(parent.interval, (size_t) 1);
+      if (steps <= parent.start ||
+          (steps - parent.start) % actualInterval != 0)
+      {
+        instPolicy.Update(iterate, stepSize, gradient);
+        return;
+      }
+
+      // The first averaged iterate replaces the (zero) average.
+      ++count;
+      const ElemType weight = (count == 1) ? ElemType(1) :
+          (parent.decay > 0.0) ? ElemType(1 - parent.decay) :
+          ElemType(1.0 / count);
+
+      Update(iterate, stepSize, gradient, weight,
+          std::integral_constant<bool, UseFusedUpdate<MatType, GradType>::value
+          && traits::HasSinkUpdate<InstPolicyType, MatType,
+          GradType>::value>());
+    }
+
+    /**
+     * Give the objective of the current batch to the wrapped policy.
+     *
+     * @param objective The objective of the current batch.
+     */
+    void ObjectiveFeedback(const double objective)
+    {
+      NotifyObjective(instPolicy, objective);
+    }
+
+    /**
+     * Save or restore the average, the step counters and the state of the
+     * wrapped policy, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(average);
+      ar(steps);
+      ar(count);
+      SerializeState(instPolicy, ar);
+    }
+
+    //! Get the instantiated wrapped policy.
+    const typename UpdatePolicyType::template Policy<MatType, GradType>&
+    InstPolicy() const { return instPolicy; }
+
+    //! Get the average of the iterates.
+    const MatType& Average() const { return average; }
+
+    //! Get the number of averaged iterates.
+    size_t Count() const { return count; }
+
+   private:
+    //! The type of the instantiated update policy.
+    typedef typename UpdatePolicyType::template Policy<MatType, GradType>
+        InstPolicyType;
+
+    //! Update the average inside the fused update of the wrapped policy.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const typename MatType::elem_type weight,
+                std::true_type /* fused */)
+    {
+      instPolicy.SinkUpdate(iterate, stepSize, gradient,
+          AverageSink<typename MatType::elem_type>(average.memptr(), weight));
+    }
+
+    //! Take the step, and then update the average.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const typename MatType::elem_type weight,
+                std::false_type /* fused */)
+    {
+      instPolicy.Update(iterate, stepSize, gradient);
+      Accumulate(iterate, weight, UseFusedUpdate<MatType, MatType>());
+    }
+
+    //! Update the average of dense matrices in one pass.
+    void Accumulate(const MatType& iterate,
+                    const typename MatType::elem_type weight,
+                    std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const AverageSink<ElemType> sink(average.memptr(), weight);
+      const ElemType* x = iterate.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+          sink(i, x[i]);
+      });
+    }
+
+    //! Update the average of any other matrix type.
+    void Accumulate(const MatType& iterate,
+                    const typename MatType::elem_type weight,
+                    std::false_type /* fused */)
+    {
+      average += weight * (iterate - average);
+    }
+
+    //! The instantiated parent class.
+    IterateAveraging<UpdatePolicyType>& parent;
+    //! The instantiated update policy we will use.
+    InstPolicyType instPolicy;
+    //! The average, which is held by the parent.
+    MatType& average;
+    //! The number of steps taken so far.
+    size_t steps;
+    //! The number of averaged iterates so far.
+    size_t count;
+  };
+
+ private:
+  //! The wrapped update policy.
+  UpdatePolicyType updatePolicy;
+
+  //! The decay of the exponential moving average (0 for the uniform average).
+  double decay;
+
+  //! The number of steps before the first averaged iterate.
+  size_t start;
+
+  //! The number of steps between two averaged iterates.
+  size_t interval;
+
+  //! The average of the iterates, with the type of the coordinates.
+  Any average;
+};
+
+} // namespace ens
+
+#endif
@@ -12,6 +12,9 @@
 #ifndef ENSMALLEN_SGD_MOMENTUM_UPDATE_HPP
 #define ENSMALLEN_SGD_MOMENTUM_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+#include <ensmallen_bits/utility/state_allocator.hpp>
+
 namespace ens {
 
 /**
@@ -74,6 +77,12 @@ class MomentumUpdate
   //! Modify the momentum.
   double& Momentum() { return momentum; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the velocity.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return MatrixBytes<MatType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -93,10 +102,9 @@ class MomentumUpdate
      * @param cols Number of columns in the gradient matrix.
      */
     Policy(const MomentumUpdate& parent, const size_t rows, const size_t cols) :
-        parent(parent),
-        velocity(arma::zeros<MatType>(rows, cols))
+        parent(parent)
     {
-      // Nothing to do.
+      velocityMemory.Zeros(velocity, rows, cols);
     }
 
     /**
@@ -111,14 +119,159 @@ class MomentumUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for momentum SGD, where each element of the gradient is
+     * passed through the given element-wise transform (see ClipTransform) as it
+     * is read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> or UseSparseUpdate<MatType, GradType>
+     * is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
+    {
+      Update(iterate, stepSize, gradient, transform,
+          UseSparseUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Update step for momentum SGD, where each element of the iterate is passed
+     * to the given sink (see AverageSink) after it is written.  This is only
+     * supported if UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param sink The sink to pass each element of the iterate to.
+     */
+    template<typename SinkType>
+    void SinkUpdate(MatType& iterate,
+                    const double stepSize,
+                    const GradType& gradient,
+                    const SinkType& sink)
+    {
+      DenseUpdate(iterate, stepSize, gradient, IdentityTransform(), sink,
+          std::true_type());
+    }
+
+    /**
+     * Save or restore the velocity, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(velocity);
+    }
+
+   private:
+    //! Sparse update for dense iterates: the velocity decays in one pass over
+    //! the dense elements, and then the nonzero elements of the gradient are
+    //! scattered into the velocity and the iterate.
+    template<typename SparseGradType, typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const SparseGradType& gradient,
+                const TransformType& transform,
+                std::true_type /* sparse */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType mu = ElemType(parent.momentum);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      ElemType* vp = velocity.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          vp[i] *= mu;
+          x[i] += vp[i];
+        }
+      });
+
+      ForEachNonzero(gradient, [&](const size_t i, const ElemType g)
+      {
+        const ElemType step = a * transform(g);
+        vp[i] -= step;
+        x[i] -= step;
+      });
+    }
+
+    //! Dense update: fused if the matrices are dense.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::false_type /* sparse */)
+    {
+      DenseUpdate(iterate, stepSize, gradient, transform, NoSink(),
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType, typename SinkType>
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     const TransformType& transform,
+                     const SinkType& sink,
+                     std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType mu = ElemType(parent.momentum);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* vp = velocity.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType vi = mu * vp[i] - a * transform(g[i]);
+          vp[i] = vi;
+          x[i] += vi;
+          sink(i, x[i]);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     const IdentityTransform& /* transform */,
+                     const NoSink& /* sink */,
+                     std::false_type /* fused */)
     {
       velocity = parent.momentum * velocity - stepSize * gradient;
       iterate += velocity;
     }
 
-   private:
     // The instantiated parent class.
     const MomentumUpdate& parent;
+    // The memory of the StateAllocator for the velocity, if any.
+    StateMemory velocityMemory;
     // The velocity matrix.
     MatType velocity;
   };
@@ -0,0 +1,395 @@
+/**
+ * @file parameter_groups.hpp
+ *
+ * Update policy that applies a different update policy and step size to each
+ * group of parameters, and leaves all other parameters unchanged.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_PARAMETER_GROUPS_HPP
+#define ENSMALLEN_SGD_PARAMETER_GROUPS_HPP
+
+#include <ensmallen_bits/utility/checkpoint.hpp>
+#include <ensmallen_bits/utility/executor.hpp>
+#include <ensmallen_bits/utility/objective_feedback.hpp>
+#include <algorithm>
+
+namespace ens {
+
+/**
+ * A group of parameters for ParameterGroups: a contiguous range of elements of
+ * the coordinates, in memory (column-major) order.  For a column vector of
+ * parameters, this is a block of rows; for a matrix, a block of whole columns
+ * is a range with a begin and size that are multiples of the number of rows.
+ */
+class ParameterGroup
+{
+ public:
+  /**
+   * Construct the group.
+   *
+   * @param begin Index of the first element of the group.
+   * @param size Number of elements in the group.
+   * @param stepScale Factor the step size of the optimizer is multiplied with
+   *     for this group.
+   * @param frozen If true, the group is not updated.
+   */
+  ParameterGroup(const size_t begin = 0,
+                 const size_t size = 0,
+                 const double stepScale = 1.0,
+                 const bool frozen = false) :
+      begin(begin),
+      size(size),
+      stepScale(stepScale),
+      frozen(frozen)
+  { /* Nothing to do. */ }
+
+  //! Get the index of the first element of the group.
+  size_t Begin() const { return begin; }
+  //! Modify the index of the first element of the group.
+  size_t& Begin() { return begin; }
+
+  //! Get the number of elements in the group.
+  size_t Size() const { return size; }
+  //! Modify the number of elements in the group.
+  size_t& Size() { return size; }
+
+  //! Get the factor the step size is multiplied with for this group.
+  double StepScale() const { return stepScale; }
+  //! Modify the factor the step size is multiplied with for this group.
+  double& StepScale() { return stepScale; }
+
+  //! Get whether or not the group is frozen.
+  bool Frozen() const { return frozen; }
+  //! Modify whether or not the group is frozen.
+  bool& Frozen() { return frozen; }
+
+ private:
+  //! The index of the first element of the group.
+  size_t begin;
+  //! The number of elements in the group.
+  size_t size;
+  //! The factor the step size is multiplied with.
+  double stepScale;
+  //! Whether or not the group is frozen.
+  bool frozen;
+};
+
+/**
+ * Update policy that splits the coordinates into groups of parameters, each
+ * with its own update policy and step size; e.g. plain steps for embeddings,
+ * Adam for dense layers, and a smaller step size for the last layer.  Group i
+ * is updated by an instance of the i'th of the UpdatePolicyTypes, which only
+ * holds the state (e.g. moment estimates) of the parameters of the group, and
+ * with the step size of the optimizer times the StepScale() of the group.
+ *
+ * Parameters that are in no group, and the groups that are Frozen(), are not
+ * updated at all, so their part of the gradient is never read.  The groups can
+ * be frozen and unfrozen, and their step sizes changed, during the
+ * optimization (e.g. from a callback); their ranges are fixed when the
+ * optimization starts.  The groups are updated in parallel, with the current
+ * executor, unless Parallel() is false.
+ *
+ * @code
+ * // Plain steps for the first 1000 parameters, Adam with half the step size
+ * // for the next 200, and nothing for the rest.
+ * std::vector<ParameterGroup> groups;
+ * groups.push_back(ParameterGroup(0, 1000));
+ * groups.push_back(ParameterGroup(1000, 200, 0.5));
+ *
+ * typedef ParameterGroups<VanillaUpdate, AdamUpdate> GroupUpdate;
+ * SGD<GroupUpdate> sgd(0.01, 32, 100000, 1e-5, true,
+ *     GroupUpdate(groups, VanillaUpdate(), AdamUpdate()));
+ * @endcode
+ *
+ * The coordinates and the gradient must be dense Armadillo matrices (arma::Mat,
+ * not arma::Col or arma::Row), since the groups are updated through aliases of
+ * their memory.
+ *
+ * @tparam UpdatePolicyTypes The update policies of the groups, in order.
+ */
+template<typename... UpdatePolicyTypes>
+class ParameterGroups
+{
+ public:
+  /**
+   * Construct the grouped update.  A std::invalid_argument is thrown if the
+   * number of groups is not the number of update policies.
+   *
+   * @param groups The groups of parameters; they must not overlap.
+   * @param updatePolicies The update policy of each group.
+   */
+  ParameterGroups(const std::vector<ParameterGroup>& groups,
+                  const UpdatePolicyTypes&... updatePolicies) :
+      groups(groups),
+      updatePolicies(updatePolicies...),
+      parallel(true)
+  {
+    if (groups.size() != sizeof...(UpdatePolicyTypes))
+    {
+      throw std::invalid_argument("ParameterGroups: the number of groups must "
+          "be the number of update policies.");
+    }
+  }
+
+  //! Get the groups of parameters.
+  const std::vector<ParameterGroup>& Groups() const { return groups; }
+  //! Modify the groups of parameters.
+  std::vector<ParameterGroup>& Groups() { return groups; }
+
+  //! Get the update policy of group I.
+  template<size_t I>
+  const typename std::tuple_element<I, std::tuple<UpdatePolicyTypes...>>::type&
+  UpdatePolicy() const { return std::get<I>(updatePolicies); }
+  //! Modify the update policy of group I.
+  template<size_t I>
+  typename std::tuple_element<I, std::tuple<UpdatePolicyTypes...>>::type&
+  UpdatePolicy() { return std::get<I>(updatePolicies); }
+
+  //! Get whether or not the groups are updated in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether or not the groups are updated in parallel.
+  bool& Parallel() { return parallel; }
+
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the state of the policy of each group, for the size of
+  //! the group.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t /* rows */, const size_t /* cols */) const
+  {
+    return GroupStateBytes<MatType, GradType>(
+        std::integral_constant<size_t, 0>());
+  }
+
+ private:
+  //! Return the number of bytes of state of the policies of groups I and
+  //! later.
+  template<typename MatType, typename GradType, size_t I>
+  size_t GroupStateBytes(std::integral_constant<size_t, I> /* group */) const
+  {
+    return ens::PolicyStateBytes<MatType, GradType>(
+        std::get<I>(updatePolicies), groups[I].Size(), 1) +
+        GroupStateBytes<MatType, GradType>(
+        std::integral_constant<size_t, I + 1>());
+  }
+
+  //! There are no more groups.
+  template<typename MatType, typename GradType>
+  size_t GroupStateBytes(std::integral_constant<size_t,
+      sizeof...(UpdatePolicyTypes)> /* group */) const
+  {
+    return 0;
+  }
+
+  //! The type of the parents of the instantiated update policies.
+  typedef std::tuple<UpdatePolicyTypes...> ParentsType;
+
+  //! The instantiated update policies of groups I and later.
+  template<size_t I, typename MatType, typename GradType, typename... Types>
+  struct InstPolicies
+  {
+    InstPolicies(ParentsType& /* parents */,
+                 const std::vector<ParameterGroup>& /* groups */)
+    { }
+
+    void Update(const size_t /* group */,
+                MatType& /* block */,
+                const double /* stepSize */,
+                const GradType& /* gradient */)
+    { }
+
+    void ObjectiveFeedback(const double /* objective */) { }
+
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& /* ar */) { }
+  };
+
+  template<size_t I,
+           typename MatType,
+           typename GradType,
+           typename HeadType,
+           typename... TailTypes>
+  struct InstPolicies<I, MatType, GradType, HeadType, TailTypes...>
+  {
+    InstPolicies(ParentsType& parents,
+                 const std::vector<ParameterGroup>& groups) :
+        head(std::get<I>(parents), groups[I].Size(), 1),
+        tail(parents, groups)
+    { }
+
+    //! Update the given block with the policy of the given group.
+    void Update(const size_t group,
+                MatType& block,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      if (group == I)
+        head.Update(block, stepSize, gradient);
+      else
+        tail.Update(group, block, stepSize, gradient);
+    }
+
+    //! Give the objective of the current batch to each policy.
+    void ObjectiveFeedback(const double objective)
+    {
+      NotifyObjective(head, objective);
+      tail.ObjectiveFeedback(objective);
+    }
+
+    //! Save or restore the state of each policy.
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      SerializeState(head, ar);
+      tail.Serialize(ar);
+    }
+
+    //! The instantiated update policy of group I.
+    typename HeadType::template Policy<MatType, GradType> head;
+    //! The instantiated update policies of the later groups.
+    InstPolicies<I + 1, MatType, GradType, TailTypes...> tail;
+  };
+
+ public:
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization, and holds parameters
+   * specific to an individual optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.  A std::invalid_argument is thrown if a group is not
+     * within the coordinates, or if two groups overlap.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(ParameterGroups& parent, const size_t rows, const size_t cols) :
+        parent(parent),
+        begins(Check(parent.Groups(), rows * cols)),
+        instPolicies(parent.updatePolicies, parent.Groups())
+    {
+      for (size_t g = 0; g < parent.Groups().size(); ++g)
+        sizes.push_back(parent.Groups()[g].Size());
+    }
+
+    /**
+     * Update step.  Each group that isn't frozen is updated by its own policy,
+     * through an alias of its part of the coordinates and the gradient.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      typedef typename GradType::elem_type GradElemType;
+
+      ParallelFor(begins.size(), [&](const size_t g)
+      {
+        const ParameterGroup& group = parent.Groups()[g];
+        if (group.Frozen() || sizes[g] == 0)
+          return;
+
+        MatType block(iterate.memptr() + begins[g], sizes[g], 1, false, true);
+        const GradType gradientBlock(const_cast<GradElemType*>(
+            gradient.memptr()) + begins[g], sizes[g], 1, false, true);
+        instPolicies.Update(g, block, stepSize * group.StepScale(),
+            gradientBlock);
+      }, parent.Parallel() && begins.size() > 1);
+    }
+
+    /**
+     * Give the objective of the current batch to the policy of each group.
+     *
+     * @param objective The objective of the current batch.
+     */
+    void ObjectiveFeedback(const double objective)
+    {
+      instPolicies.ObjectiveFeedback(objective);
+    }
+
+    /**
+     * Save or restore the state of the policy of each group, e.g. for a
+     * checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      instPolicies.Serialize(ar);
+    }
+
+   private:
+    //! Make sure the groups are within the coordinates and don't overlap, and
+    //! return the index of the first element of each group.
+    static std::vector<size_t> Check(const std::vector<ParameterGroup>& groups,
+                                     const size_t elements)
+    {
+      std::vector<size_t> begins(groups.size());
+      std::vector<std::pair<size_t, size_t>> ranges(groups.size());
+      for (size_t g = 0; g < groups.size(); ++g)
+      {
+        if (groups[g].Begin() + groups[g].Size() > elements)
+        {
+          std::ostringstream oss;
+          oss << "ParameterGroups: group " << g << " ends at element "
+              << groups[g].Begin() + groups[g].Size() << ", but the "
+              << "coordinates only have " << elements << " elements.";
+          throw std::invalid_argument(oss.str());
+        }
+
+        begins[g] = groups[g].Begin();
+        ranges[g] = std::make_pair(groups[g].Begin(),
+            groups[g].Begin() + groups[g].Size());
+      }
+
+      std::sort(ranges.begin(), ranges.end());
+      for (size_t g = 1; g < ranges.size(); ++g)
+      {
+        if (ranges[g].first < ranges[g - 1].second)
+        {
+          throw std::invalid_argument("ParameterGroups: the groups must not "
+              "overlap.");
+        }
+      }
+
+      return begins;
+    }
+
+    //! The instantiated parent class.
+    ParameterGroups& parent;
+    //! The index of the first element of each group.
+    std::vector<size_t> begins;
+    //! The number of elements in each group.
+    std::vector<size_t> sizes;
+    //! The instantiated update policies of the groups.
+    InstPolicies<0, MatType, GradType, UpdatePolicyTypes...> instPolicies;
+  };
+
+ private:
+  //! The groups of parameters.
+  std::vector<ParameterGroup> groups;
+
+  //! The update policy of each group.
+  ParentsType updatePolicies;
+
+  //! Whether or not the groups are updated in parallel.
+  bool parallel;
+};
+
+} // namespace ens
+
+#endif
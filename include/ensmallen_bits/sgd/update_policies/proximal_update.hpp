@@ -0,0 +1,102 @@
+/**
+ * @file proximal_update.hpp
+ *
+ * Proximal update policy for SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGD_PROXIMAL_UPDATE_HPP
+#define ENSMALLEN_SGD_PROXIMAL_UPDATE_HPP
+
+#include <ensmallen_bits/proximal_gradient/proximal_gradient.hpp>
+
+namespace ens {
+
+/**
+ * Proximal update policy for Stochastic Gradient Descent (SGD).  Each step is
+ * a vanilla SGD step followed by the proximal operator of the non-smooth term
+ * given by the ProxType (see L1Penalty, GroupLassoPenalty, BoxConstraint and
+ * SimplexConstraint):
+ *
+ * \f[
+ * A_{j + 1} = \textrm{prox}_{\alpha h}(A_j - \alpha \nabla f_i(A_j))
+ * \f]
+ *
+ * so that e.g. an l1 penalty yields exactly sparse iterates, which a
+ * subgradient of the penalty would not.  The objective reported by SGD is that
+ * of the differentiable function only, without the non-smooth term.
+ *
+ * @tparam ProxType The non-smooth term and its proximal operator.
+ */
+template<typename ProxType = L1Penalty>
+class ProximalUpdate
+{
+ public:
+  /**
+   * Construct the proximal update policy.
+   *
+   * @param prox The non-smooth term and its proximal operator.
+   */
+  ProximalUpdate(const ProxType& prox = ProxType()) : prox(prox)
+  { /* Nothing to do. */ }
+
+  //! Get the proximal operator.
+  const ProxType& Prox() const { return prox; }
+  //! Modify the proximal operator.
+  ProxType& Prox() { return prox; }
+
+  /**
+   * The UpdatePolicyType policy classes must contain an internal 'Policy'
+   * template class with two template arguments: MatType and GradType.  This is
+   * instantiated at the start of the optimization.
+   */
+  template<typename MatType, typename GradType>
+  class Policy
+  {
+   public:
+    /**
+     * This is called by the optimizer method before the start of the iteration
+     * update process.
+     *
+     * @param parent Instantiated parent class.
+     * @param rows Number of rows in the gradient matrix.
+     * @param cols Number of columns in the gradient matrix.
+     */
+    Policy(const ProximalUpdate& parent,
+           const size_t /* rows */,
+           const size_t /* cols */) :
+        parent(parent)
+    { /* Nothing to do. */ }
+
+    /**
+     * Update step for proximal SGD: a gradient step, and then the proximal
+     * operator with the same step size.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     */
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient)
+    {
+      iterate -= stepSize * gradient;
+      parent.prox.Prox(iterate, stepSize);
+    }
+
+   private:
+    //! The instantiated parent class.
+    const ProximalUpdate& parent;
+  };
+
+ private:
+  //! The non-smooth term and its proximal operator.
+  ProxType prox;
+};
+
+} // namespace ens
+
+#endif
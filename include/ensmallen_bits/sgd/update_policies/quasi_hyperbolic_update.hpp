@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_SGD_QH_UPDATE_HPP
 #define ENSMALLEN_SGD_QH_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -58,6 +60,12 @@ class QHUpdate
   //! Modify the value used to initialize the momentum coefficient.
   double& V() { return v; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the velocity.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return MatrixBytes<MatType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -76,7 +84,7 @@ class QHUpdate
      * @param rows Number of rows in the gradient matrix.
      * @param cols Number of columns in the gradient matrix.
      */
-    Policy(QHUpdate& parent, const size_t rows, const size_t cols) :
+    Policy(const QHUpdate& parent, const size_t rows, const size_t cols) :
         parent(parent)
     {
       // Initialize an empty velocity matrix.
@@ -93,6 +101,130 @@ class QHUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseSparseUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Update step for QHSGD, where each element of the iterate is passed to the
+     * given sink (see AverageSink) after it is written.  This is only supported
+     * if UseFusedUpdate<MatType, GradType> is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param sink The sink to pass each element of the iterate to.
+     */
+    template<typename SinkType>
+    void SinkUpdate(MatType& iterate,
+                    const double stepSize,
+                    const GradType& gradient,
+                    const SinkType& sink)
+    {
+      DenseUpdate(iterate, stepSize, gradient, sink, std::true_type());
+    }
+
+    /**
+     * Save or restore the velocity, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(velocity);
+    }
+
+   private:
+    //! Sparse update for dense iterates: the velocity decays (and moves the
+    //! iterate) in one pass over the dense elements, and then the nonzero
+    //! elements of the gradient are scattered into the velocity and the
+    //! iterate.
+    template<typename SparseGradType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const SparseGradType& gradient,
+                std::true_type /* sparse */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta = ElemType(parent.momentum);
+      const ElemType oneMinusBeta = ElemType(1 - parent.momentum);
+      const ElemType cv = ElemType(stepSize * parent.v);
+      // A nonzero g moves the iterate by cg * g directly, and by cv times its
+      // share (1 - beta) * g of the velocity.
+      const ElemType cg = ElemType(stepSize * (1 - parent.v)) +
+          cv * oneMinusBeta;
+
+      ElemType* x = iterate.memptr();
+      ElemType* vp = velocity.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          vp[i] *= beta;
+          x[i] -= cv * vp[i];
+        }
+      });
+
+      ForEachNonzero(gradient, [&](const size_t i, const ElemType g)
+      {
+        vp[i] += oneMinusBeta * g;
+        x[i] -= cg * g;
+      });
+    }
+
+    //! Dense update: fused if the matrices are dense.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* sparse */)
+    {
+      DenseUpdate(iterate, stepSize, gradient, NoSink(),
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename SinkType>
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     const SinkType& sink,
+                     std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta = ElemType(parent.momentum);
+      const ElemType oneMinusBeta = ElemType(1 - parent.momentum);
+      const ElemType cg = ElemType(stepSize * (1 - parent.v));
+      const ElemType cv = ElemType(stepSize * parent.v);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* vp = velocity.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gi = g[i];
+          const ElemType vi = beta * vp[i] + oneMinusBeta * gi;
+          vp[i] = vi;
+          x[i] -= cg * gi + cv * vi;
+          sink(i, x[i]);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     const NoSink& /* sink */,
+                     std::false_type /* fused */)
     {
       velocity *= parent.momentum;
       velocity += (1 - parent.momentum) * gradient;
@@ -100,12 +232,11 @@ class QHUpdate
       iterate -= stepSize * ((1 - parent.v) * gradient + parent.v * velocity);
     }
 
-   private:
     //! Instantiated parent object.
-    QHUpdate& parent;
+    const QHUpdate& parent;
 
     //! The velocity matrix.
-    GradType velocity;
+    MatType velocity;
   };
 
  private:
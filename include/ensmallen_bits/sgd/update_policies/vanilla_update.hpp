@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_SGD_EMPTY_UPDATE_HPP
 #define ENSMALLEN_SGD_EMPTY_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -24,6 +26,10 @@ namespace ens {
  *
  * where \f$ \alpha \f$ is a parameter which specifies the step size.  \f$ i \f$
  * is chosen according to \f$ j \f$ (the iteration number).
+ *
+ * If the gradient is sparse and the iterate is dense, only the nonzero elements
+ * of the gradient are visited, and they are subtracted from the iterate
+ * directly, without a temporary sparse matrix.
  */
 class VanillaUpdate
 {
@@ -61,6 +67,117 @@ class VanillaUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, IdentityTransform());
+    }
+
+    /**
+     * Update step for SGD, where each element of the gradient is passed
+     * through the given element-wise transform (see ClipTransform) as it is
+     * read.  Transforms other than IdentityTransform are only supported if
+     * UseFusedUpdate<MatType, GradType> or UseSparseUpdate<MatType, GradType>
+     * is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param transform The transform to apply to each gradient element.
+     */
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform)
+    {
+      Update(iterate, stepSize, gradient, transform,
+          UseSparseUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Update step for SGD, where each element of the iterate is passed to the
+     * given sink (see AverageSink) after it is written, in one pass over the
+     * elements.  This is only supported if UseFusedUpdate<MatType, GradType>
+     * is true.
+     *
+     * @param iterate Parameters that minimize the function.
+     * @param stepSize Step size to be used for the given iteration.
+     * @param gradient The gradient matrix.
+     * @param sink The sink to pass each element of the iterate to.
+     */
+    template<typename SinkType>
+    void SinkUpdate(MatType& iterate,
+                    const double stepSize,
+                    const GradType& gradient,
+                    const SinkType& sink)
+    {
+      DenseUpdate(iterate, stepSize, gradient, IdentityTransform(), sink,
+          std::true_type());
+    }
+
+   private:
+    //! Sparse update: only the nonzero elements of the gradient are visited.
+    template<typename SparseGradType, typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const SparseGradType& gradient,
+                const TransformType& transform,
+                std::true_type /* sparse */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType a = ElemType(stepSize);
+      ElemType* x = iterate.memptr();
+      ForEachNonzero(gradient, [&](const size_t i, const ElemType g)
+      {
+        x[i] -= a * transform(g);
+      });
+    }
+
+    //! Dense update: fused if the matrices are dense.
+    template<typename TransformType>
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                const TransformType& transform,
+                std::false_type /* sparse */)
+    {
+      DenseUpdate(iterate, stepSize, gradient, transform, NoSink(),
+          UseFusedUpdate<MatType, GradType>());
+    }
+
+    //! Fused update for dense matrices: one pass over all the elements.
+    template<typename TransformType, typename SinkType>
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     const TransformType& transform,
+                     const SinkType& sink,
+                     std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType a = ElemType(stepSize);
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          x[i] -= a * transform(g[i]);
+          sink(i, x[i]);
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void DenseUpdate(MatType& iterate,
+                     const double stepSize,
+                     const GradType& gradient,
+                     const IdentityTransform& /* transform */,
+                     const NoSink& /* sink */,
+                     std::false_type /* fused */)
     {
       // Perform the vanilla SGD update.
       iterate -= stepSize * gradient;
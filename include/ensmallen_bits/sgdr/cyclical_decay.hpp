@@ -151,6 +151,21 @@ class CyclicalDecay
       parent.epoch++;
     }
 
+    /**
+     * Save or restore the restart schedule, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(parent.epochRestart);
+      ar(parent.nextRestart);
+      ar(parent.batchRestart);
+      ar(parent.epochBatches);
+      ar(parent.epoch);
+    }
+
    private:
     // Reference to the parent object.
     CyclicalDecay& parent;
@@ -14,6 +14,8 @@
 #ifndef ENSMALLEN_SGDR_SNAPSHOT_ENSEMBLES_HPP
 #define ENSMALLEN_SGDR_SNAPSHOT_ENSEMBLES_HPP
 
+#include "snapshot_storage.hpp"
+
 namespace ens {
 
 /**
@@ -35,8 +37,12 @@ namespace ens {
  *   url       = {https://arxiv.org/abs/1704.00109}
  * }
  * @endcode
+ *
+ * @tparam SnapshotStorageType The storage of the snapshots: InMemorySnapshots
+ *     (the default), DiskSnapshots, or DeltaSnapshots.
  */
-class SnapshotEnsembles
+template<typename SnapshotStorageType = InMemorySnapshots>
+class SnapshotEnsemblesType
 {
  public:
   /**
@@ -53,18 +59,22 @@ class SnapshotEnsembles
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *        limit).
    * @param snapshots Maximum number of snapshots.
+   * @param snapshotStorage Instantiated storage policy of the snapshots.
    */
-  SnapshotEnsembles(const size_t epochRestart,
-                    const double multFactor,
-                    const double stepSize,
-                    const size_t maxIterations,
-                    const size_t snapshots) :
+  SnapshotEnsemblesType(const size_t epochRestart,
+                        const double multFactor,
+                        const double stepSize,
+                        const size_t maxIterations,
+                        const size_t snapshots,
+                        const SnapshotStorageType& snapshotStorage =
+                            SnapshotStorageType()) :
     epochRestart(epochRestart),
     multFactor(multFactor),
     constStepSize(stepSize),
     nextRestart(epochRestart),
     batchRestart(0),
-    epoch(0)
+    epoch(0),
+    snapshotStorage(snapshotStorage)
   {
     snapshotEpochs = 0;
     for (size_t i = 0, er = epochRestart, nr = nextRestart;
@@ -122,6 +132,11 @@ class SnapshotEnsembles
   //! Modify the number of epochs needed for a new snapshot.
   size_t& SnapshotEpochs() { return snapshotEpochs; }
 
+  //! Get the storage policy of the snapshots.
+  const SnapshotStorageType& SnapshotStorage() const { return snapshotStorage; }
+  //! Modify the storage policy of the snapshots.
+  SnapshotStorageType& SnapshotStorage() { return snapshotStorage; }
+
   /**
    * The DecayPolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -132,11 +147,18 @@ class SnapshotEnsembles
   class Policy
   {
    public:
+    //! The type of the instantiated storage.
+    typedef typename SnapshotStorageType::template Policy<MatType>
+        StoragePolicyType;
+
     /**
      * This constructor is called by the SGD Optimize() method before the start
      * of the iteration update process.
      */
-    Policy(SnapshotEnsembles& parent) : parent(parent) { }
+    Policy(SnapshotEnsemblesType& parent) :
+        parent(parent),
+        storage(parent.snapshotStorage)
+    { }
 
     /**
      * This function is called in each iteration after the policy update.
@@ -172,7 +194,7 @@ class SnapshotEnsembles
         // Create a new snapshot.
         if (parent.epochRestart >= parent.snapshotEpochs)
         {
-          snapshots.push_back(iterate);
+          storage.Add(iterate);
         }
 
         // Update the time for the next restart.
@@ -182,16 +204,24 @@ class SnapshotEnsembles
       parent.epoch++;
     }
 
-    //! Get the snapshots.
-    std::vector<MatType> Snapshots() const { return snapshots; }
-    //! Modify the snapshots.
-    std::vector<MatType>& Snapshots() { return snapshots; }
+    //! Get the stored snapshots.
+    const StoragePolicyType& Storage() const { return storage; }
+    //! Modify the stored snapshots.
+    StoragePolicyType& Storage() { return storage; }
+
+    //! Get the snapshots (only available for InMemorySnapshots).
+    const std::vector<MatType>& Snapshots() const
+    {
+      return storage.Snapshots();
+    }
+    //! Modify the snapshots (only available for InMemorySnapshots).
+    std::vector<MatType>& Snapshots() { return storage.Snapshots(); }
 
    private:
     // Reference to the instantiated parent object.
-    SnapshotEnsembles& parent;
+    SnapshotEnsemblesType& parent;
     //! Locally-stored parameter snapshots.
-    std::vector<MatType> snapshots;
+    StoragePolicyType storage;
   };
 
  private:
@@ -218,8 +248,13 @@ class SnapshotEnsembles
 
   //! Epochs where a new snapshot is created.
   size_t snapshotEpochs;
+
+  //! The storage policy of the snapshots.
+  SnapshotStorageType snapshotStorage;
 };
 
+using SnapshotEnsembles = SnapshotEnsemblesType<InMemorySnapshots>;
+
 } // namespace ens
 
 #endif // ENSMALLEN_SGDR_CYCLICAL_DECAY_HPP
@@ -57,13 +57,18 @@ namespace ens {
  * @tparam UpdatePolicyType Update policy used during the iterative update
  *         process. By default the momentum update policy (see
  *         ens::MomentumUpdate) is used.
+ * @tparam SnapshotStorageType Storage of the snapshots (see
+ *         ens::InMemorySnapshots, ens::DiskSnapshots and ens::DeltaSnapshots).
  */
-template<typename UpdatePolicyType = MomentumUpdate>
+template<typename UpdatePolicyType = MomentumUpdate,
+         typename SnapshotStorageType = InMemorySnapshots>
 class SnapshotSGDR
 {
  public:
+  //! Convenience typedef for the decay policy, which takes the snapshots.
+  using DecayPolicyType = SnapshotEnsemblesType<SnapshotStorageType>;
   //! Convenience typedef for the internal optimizer construction.
-  using OptimizerType = SGD<UpdatePolicyType, SnapshotEnsembles>;
+  using OptimizerType = SGD<UpdatePolicyType, DecayPolicyType>;
 
   /**
    * Construct the SnapshotSGDR optimizer with snapshot ensembles with the given
@@ -88,6 +93,7 @@ class SnapshotSGDR
    *        call; otherwise, their values are retained.
    * @param exactObjective Calculate the exact objective (Default: estimate the
    *        final objective obtained on the last pass over the data).
+   * @param snapshotStorage Instantiated storage policy of the snapshots.
    */
   SnapshotSGDR(const size_t epochRestart = 50,
                const double multFactor = 2.0,
@@ -100,7 +106,9 @@ class SnapshotSGDR
                const bool accumulate = true,
                const UpdatePolicyType& updatePolicy = UpdatePolicyType(),
                const bool resetPolicy = true,
-               const bool exactObjective = false);
+               const bool exactObjective = false,
+               const SnapshotStorageType& snapshotStorage =
+                   SnapshotStorageType());
 
   /**
    * Optimize the given function using SGDR.  The given starting point
@@ -169,15 +177,38 @@ class SnapshotSGDR
   //! Modify whether or not the actual objective is calculated.
   bool& ExactObjective() { return optimizer.ExactObjective(); }
 
-  //! Get the snapshots.
-  std::vector<arma::mat> Snapshots() const
+  /**
+   * Get the snapshots taken by the last call to Optimize() with the given
+   * matrix types.  The storage does not copy the snapshots.
+   */
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  const typename DecayPolicyType::template Policy<MatType,
+      GradType>::StoragePolicyType& Storage() const
+  {
+    return optimizer.InstDecayPolicy().template As<typename DecayPolicyType::
+        template Policy<MatType, GradType>>().Storage();
+  }
+  //! Modify the snapshots taken by the last call to Optimize() with the given
+  //! matrix types.
+  template<typename MatType = arma::mat, typename GradType = MatType>
+  typename DecayPolicyType::template Policy<MatType,
+      GradType>::StoragePolicyType& Storage()
+  {
+    return optimizer.InstDecayPolicy().template As<typename DecayPolicyType::
+        template Policy<MatType, GradType>>().Storage();
+  }
+
+  //! Get the snapshots taken by the last call to Optimize() with arma::mat
+  //! coordinates (only available for InMemorySnapshots).
+  const std::vector<arma::mat>& Snapshots() const
   {
-    return optimizer.DecayPolicy().Snapshots();
+    return Storage<arma::mat>().Snapshots();
   }
-  //! Modify the snapshots.
+  //! Modify the snapshots taken by the last call to Optimize() with arma::mat
+  //! coordinates (only available for InMemorySnapshots).
   std::vector<arma::mat>& Snapshots()
   {
-    return optimizer.DecayPolicy().Snapshots();
+    return Storage<arma::mat>().Snapshots();
   }
 
   //! Get whether or not to accumulate the snapshots.
@@ -17,8 +17,8 @@
 
 namespace ens {
 
-template<typename UpdatePolicyType>
-SnapshotSGDR<UpdatePolicyType>::SnapshotSGDR(
+template<typename UpdatePolicyType, typename SnapshotStorageType>
+SnapshotSGDR<UpdatePolicyType, SnapshotStorageType>::SnapshotSGDR(
     const size_t epochRestart,
     const double multFactor,
     const size_t batchSize,
@@ -30,7 +30,8 @@ SnapshotSGDR<UpdatePolicyType>::SnapshotSGDR(
     const bool accumulate,
     const UpdatePolicyType& updatePolicy,
     const bool resetPolicy,
-    const bool exactObjective) :
+    const bool exactObjective,
+    const SnapshotStorageType& snapshotStorage) :
     batchSize(batchSize),
     accumulate(accumulate),
     exactObjective(exactObjective),
@@ -40,26 +41,27 @@ SnapshotSGDR<UpdatePolicyType>::SnapshotSGDR(
                             tolerance,
                             shuffle,
                             updatePolicy,
-                            SnapshotEnsembles(
+                            DecayPolicyType(
                                 epochRestart,
                                 multFactor,
                                 stepSize,
                                 maxIterations,
-                                snapshots),
+                                snapshots,
+                                snapshotStorage),
                             resetPolicy,
                             exactObjective))
 {
   /* Nothing to do here */
 }
 
-template<typename UpdatePolicyType>
+template<typename UpdatePolicyType, typename SnapshotStorageType>
 template<typename SeparableFunctionType,
          typename MatType,
          typename GradType,
          typename... CallbackTypes>
 typename std::enable_if<IsArmaType<GradType>::value,
 typename MatType::elem_type>::type
-SnapshotSGDR<UpdatePolicyType>::Optimize(
+SnapshotSGDR<UpdatePolicyType, SnapshotStorageType>::Optimize(
     SeparableFunctionType& function,
     MatType& iterate,
     CallbackTypes&&... callbacks)
@@ -87,20 +89,17 @@ SnapshotSGDR<UpdatePolicyType>::Optimize(
   typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
   typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
 
-  typedef SnapshotEnsembles::Policy<BaseMatType, BaseGradType>
-      InstDecayPolicyType;
+  typedef typename DecayPolicyType::template Policy<BaseMatType,
+      BaseGradType> InstDecayPolicyType;
 
   // Accumulate snapshots.
   if (accumulate)
   {
-    Any& instDecayPolicy = optimizer.InstDecayPolicy();
-    size_t numSnapshots =
-        instDecayPolicy.As<InstDecayPolicyType>().Snapshots().size();
-
-    for (size_t i = 0; i < numSnapshots; ++i)
-    {
-      iterate += instDecayPolicy.As<InstDecayPolicyType>().Snapshots()[i];
-    }
+    typename InstDecayPolicyType::StoragePolicyType& storage =
+        optimizer.InstDecayPolicy().template As<InstDecayPolicyType>()
+        .Storage();
+    const size_t numSnapshots = storage.Size();
+    storage.Accumulate((BaseMatType&) iterate);
     iterate /= (numSnapshots + 1);
 
     // Calculate final objective.
@@ -0,0 +1,371 @@
+/**
+ * @file snapshot_storage.hpp
+ *
+ * Storage policies for the parameter snapshots taken by SnapshotEnsembles: in
+ * memory (optionally as a ring of bounded size), on disk (written on a
+ * background thread), or in memory as sparse deltas to the previous snapshot.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SGDR_SNAPSHOT_STORAGE_HPP
+#define ENSMALLEN_SGDR_SNAPSHOT_STORAGE_HPP
+
+#include <ensmallen_bits/utility/checkpoint.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace ens {
+
+/**
+ * InMemorySnapshots keeps a full copy of each snapshot in memory.  If a
+ * capacity is given, only the most recent `capacity` snapshots are kept, and
+ * the memory of the oldest snapshot is reused for each new one.
+ *
+ * Like all snapshot storage policies, this class holds the configuration, and
+ * its internal Policy<MatType> class (instantiated at the start of the
+ * optimization) holds the snapshots.  A Policy provides
+ *
+ * @code
+ * void Add(const MatType& snapshot);            // Store a new snapshot.
+ * size_t Size() const;                          // Number of stored snapshots.
+ * void Load(const size_t i, MatType& out);      // Restore snapshot i.
+ * void Accumulate(MatType& sum);                // Add all snapshots to sum.
+ * @endcode
+ *
+ * where the snapshots are numbered from the oldest (0) to the most recent.
+ */
+class InMemorySnapshots
+{
+ public:
+  /**
+   * Construct the in-memory storage.
+   *
+   * @param capacity The maximum number of snapshots to keep (0 means no
+   *     limit).
+   */
+  InMemorySnapshots(const size_t capacity = 0) : capacity(capacity) { }
+
+  //! Get the maximum number of snapshots to keep (0 means no limit).
+  size_t Capacity() const { return capacity; }
+  //! Modify the maximum number of snapshots to keep (0 means no limit).
+  size_t& Capacity() { return capacity; }
+
+  template<typename MatType>
+  class Policy
+  {
+   public:
+    //! Create the storage with the configuration of the given parent.
+    Policy(const InMemorySnapshots& parent) : capacity(parent.Capacity()) { }
+
+    //! Store a copy of the given snapshot.
+    void Add(const MatType& snapshot)
+    {
+      if (capacity == 0 || snapshots.size() < capacity)
+      {
+        snapshots.push_back(snapshot);
+        return;
+      }
+
+      // Move the oldest snapshot to the end, and overwrite its memory.
+      std::rotate(snapshots.begin(), snapshots.begin() + 1, snapshots.end());
+      snapshots.back() = snapshot;
+    }
+
+    //! Get the number of stored snapshots.
+    size_t Size() const { return snapshots.size(); }
+
+    //! Copy snapshot i into `out`.
+    void Load(const size_t i, MatType& out) const { out = snapshots[i]; }
+
+    //! Add all snapshots to `sum`.
+    void Accumulate(MatType& sum) const
+    {
+      for (size_t i = 0; i < snapshots.size(); ++i)
+        sum += snapshots[i];
+    }
+
+    //! Get the snapshots, from the oldest to the most recent.
+    const std::vector<MatType>& Snapshots() const { return snapshots; }
+    //! Modify the snapshots.
+    std::vector<MatType>& Snapshots() { return snapshots; }
+
+   private:
+    //! The maximum number of snapshots to keep.
+    size_t capacity;
+    //! The stored snapshots.
+    std::vector<MatType> snapshots;
+  };
+
+ private:
+  //! The maximum number of snapshots to keep.
+  size_t capacity;
+};
+
+/**
+ * DiskSnapshots writes each snapshot to its own file, `prefix_<i>.bin`, in the
+ * format of CheckpointWriter; a dense snapshot file can thus be memory-mapped
+ * with MappedMatrix.  The snapshot is copied into a buffer that is reused, and
+ * the file is written on a background thread while the optimization
+ * continues, so only one snapshot is held in memory.  A std::runtime_error is
+ * thrown if a file can't be written (when the next snapshot is added or the
+ * snapshots are read) or can't be read.  The files are not removed.
+ */
+class DiskSnapshots
+{
+ public:
+  /**
+   * Construct the disk storage.
+   *
+   * @param prefix The prefix of the snapshot files, which may include a
+   *     directory.
+   */
+  DiskSnapshots(const std::string& prefix = "snapshot") : prefix(prefix) { }
+
+  //! Get the prefix of the snapshot files.
+  const std::string& Prefix() const { return prefix; }
+  //! Modify the prefix of the snapshot files.
+  std::string& Prefix() { return prefix; }
+
+  template<typename MatType>
+  class Policy
+  {
+   public:
+    //! Create the storage with the configuration of the given parent.
+    Policy(const DiskSnapshots& parent) : prefix(parent.Prefix()), size(0) { }
+
+    //! The files are being written by the background thread, so the storage
+    //! can't be copied.
+    Policy(const Policy&) = delete;
+    //! The storage can't be copied.
+    Policy& operator=(const Policy&) = delete;
+
+    //! Wait for the last file to be written.
+    ~Policy()
+    {
+      if (writer.joinable())
+        writer.join();
+    }
+
+    //! Start writing the given snapshot to its file.
+    void Add(const MatType& snapshot)
+    {
+      Wait();
+      pending = snapshot;
+
+      const std::string filename = Filename(size++);
+      writer = std::thread([this, filename]()
+          {
+            try
+            {
+              Write(filename, pending);
+            }
+            catch (std::exception& e)
+            {
+              error = e.what();
+            }
+          });
+    }
+
+    //! Get the number of stored snapshots.
+    size_t Size() const { return size; }
+
+    //! Read snapshot i into `out`.
+    void Load(const size_t i, MatType& out)
+    {
+      Wait();
+      std::ifstream stream(Filename(i).c_str(), std::ios::binary);
+      if (!stream)
+      {
+        throw std::runtime_error("DiskSnapshots: cannot open '" +
+            Filename(i) + "'.");
+      }
+
+      CheckpointReader ar(stream);
+      ar(out);
+    }
+
+    //! Add all snapshots to `sum`, reading them one at a time.
+    void Accumulate(MatType& sum)
+    {
+      MatType snapshot;
+      for (size_t i = 0; i < size; ++i)
+      {
+        Load(i, snapshot);
+        sum += snapshot;
+      }
+    }
+
+    //! Get the name of the file of snapshot i.
+    std::string Filename(const size_t i) const
+    {
+      std::ostringstream filename;
+      filename << prefix << "_" << i << ".bin";
+      return filename.str();
+    }
+
+    /**
+     * Wait until the last snapshot has been written.  A std::runtime_error is
+     * thrown if writing it failed.
+     */
+    void Wait()
+    {
+      if (writer.joinable())
+        writer.join();
+
+      if (!error.empty())
+      {
+        const std::string message = error;
+        error.clear();
+        throw std::runtime_error(message);
+      }
+    }
+
+   private:
+    //! Write a snapshot to the given file.
+    static void Write(const std::string& filename, const MatType& snapshot)
+    {
+      std::ofstream stream(filename.c_str(), std::ios::binary);
+      if (!stream)
+      {
+        throw std::runtime_error("DiskSnapshots: cannot open '" + filename +
+            "' for writing.");
+      }
+
+      CheckpointWriter ar(stream);
+      ar(snapshot);
+    }
+
+    //! The prefix of the snapshot files.
+    std::string prefix;
+    //! The number of stored snapshots.
+    size_t size;
+    //! The snapshot being written.
+    MatType pending;
+    //! The thread writing the last snapshot.
+    std::thread writer;
+    //! The error raised by the thread, if any.
+    std::string error;
+  };
+
+ private:
+  //! The prefix of the snapshot files.
+  std::string prefix;
+};
+
+/**
+ * DeltaSnapshots keeps the first snapshot in full, and each later snapshot as
+ * a sparse matrix of its differences to the previous one.  Differences with an
+ * absolute value of at most `tolerance` are dropped; each difference is taken
+ * to the reconstructed previous snapshot, so the error of a snapshot never
+ * exceeds `tolerance` per element, however many snapshots are stored.  Since
+ * consecutive snapshots often differ in few parameters (or only slightly, with
+ * a positive tolerance), this can need much less memory than full copies.
+ */
+class DeltaSnapshots
+{
+ public:
+  /**
+   * Construct the delta storage.
+   *
+   * @param tolerance Differences with an absolute value of at most this are
+   *     not stored (0 keeps the snapshots exactly).
+   */
+  DeltaSnapshots(const double tolerance = 0.0) : tolerance(tolerance) { }
+
+  //! Get the tolerance of the differences.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance of the differences.
+  double& Tolerance() { return tolerance; }
+
+  template<typename MatType>
+  class Policy
+  {
+   public:
+    typedef typename MatType::elem_type ElemType;
+
+    //! Create the storage with the configuration of the given parent.
+    Policy(const DeltaSnapshots& parent) :
+        tolerance(ElemType(parent.Tolerance())),
+        size(0)
+    { }
+
+    //! Store the differences of the given snapshot to the previous one.
+    void Add(const MatType& snapshot)
+    {
+      if (size++ == 0)
+      {
+        first = snapshot;
+        last = snapshot;
+        return;
+      }
+
+      MatType difference = snapshot - last;
+      const ElemType tol = tolerance;
+      difference.transform([tol](const ElemType x)
+          { return (std::abs(x) <= tol) ? ElemType(0) : x; });
+
+      deltas.push_back(arma::SpMat<ElemType>(difference));
+      last += deltas.back();
+    }
+
+    //! Get the number of stored snapshots.
+    size_t Size() const { return size; }
+
+    //! Reconstruct snapshot i into `out`.
+    void Load(const size_t i, MatType& out) const
+    {
+      out = first;
+      for (size_t j = 0; j < i; ++j)
+        out += deltas[j];
+    }
+
+    //! Add all snapshots to `sum`, reconstructing them in order.
+    void Accumulate(MatType& sum) const
+    {
+      if (size == 0)
+        return;
+
+      MatType snapshot = first;
+      sum += snapshot;
+      for (size_t j = 0; j < deltas.size(); ++j)
+      {
+        snapshot += deltas[j];
+        sum += snapshot;
+      }
+    }
+
+    //! Get the number of elements stored for the differences.
+    size_t DeltaElements() const
+    {
+      size_t elements = 0;
+      for (size_t j = 0; j < deltas.size(); ++j)
+        elements += deltas[j].n_nonzero;
+      return elements;
+    }
+
+   private:
+    //! The differences to drop.
+    ElemType tolerance;
+    //! The number of stored snapshots.
+    size_t size;
+    //! The first snapshot.
+    MatType first;
+    //! The reconstructed most recent snapshot.
+    MatType last;
+    //! The differences between consecutive snapshots.
+    std::vector<arma::SpMat<ElemType>> deltas;
+  };
+
+ private:
+  //! The differences to drop.
+  double tolerance;
+};
+
+} // namespace ens
+
+#endif
@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_SMORMS3_SMORMS3_UPDATE_HPP
 #define ENSMALLEN_SMORMS3_SMORMS3_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -48,6 +50,15 @@ class SMORMS3Update
   //! Modify the value used to initialise the mean squared gradient parameter.
   double& Epsilon() { return epsilon; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the memory and the moving averages of the gradients.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  {
+    return MatrixBytes<MatType>(rows, cols) +
+        2 * MatrixBytes<GradType>(rows, cols);
+  }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -84,6 +95,64 @@ class SMORMS3Update
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+    /**
+     * Save or restore the memory and gradient estimates, e.g. for a checkpoint.
+     *
+     * @param ar The CheckpointWriter or CheckpointReader.
+     */
+    template<typename ArchiveType>
+    void Serialize(ArchiveType& ar)
+    {
+      ar(mem);
+      ar(g);
+      ar(g2);
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over all the elements.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(stepSize);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* grad = gradient.memptr();
+      ElemType* memp = mem.memptr();
+      ElemType* gp = g.memptr();
+      ElemType* g2p = g2.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType gradi = grad[i];
+          const ElemType r = 1 / (memp[i] + 1);
+          const ElemType gi = (1 - r) * gp[i] + r * gradi;
+          const ElemType g2i = (1 - r) * g2p[i] + r * (gradi * gradi);
+          const ElemType lr = std::min((gi * gi) / (g2i + eps), a);
+          gp[i] = gi;
+          g2p[i] = g2i;
+          x[i] -= gradi * lr / (std::sqrt(g2i) + eps);
+          memp[i] = memp[i] * (1 - lr) + 1;
+        }
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* fused */)
     {
       // Update the iterate.
       MatType r = 1 / (mem + 1);
@@ -105,7 +174,6 @@ class SMORMS3Update
       mem += 1;
     }
 
-   private:
     // Instantiated parent object.
     SMORMS3Update& parent;
     // Memory parameter.
@@ -115,20 +115,14 @@ SPALeRASGD<DecayPolicyType>::Optimize(
 
   // Initialize the decay policy if needed.
   if (!isInitialized || !instDecayPolicy.Has<InstDecayPolicyType>())
-  {
-    instDecayPolicy.Clean();
-    instDecayPolicy.Set<InstDecayPolicyType>(
-        new InstDecayPolicyType(decayPolicy));
-  }
+    instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
 
   // Initialize the update policy.
   if (resetPolicy || !isInitialized ||
       !instUpdatePolicy.Has<InstUpdatePolicyType>())
   {
-    instUpdatePolicy.Clean();
-    instUpdatePolicy.Set<InstUpdatePolicyType>(
-        new InstUpdatePolicyType(updatePolicy, iterate.n_rows, iterate.n_cols,
-                                 currentObjective * lambda));
+    instUpdatePolicy.Emplace<InstUpdatePolicyType>(updatePolicy,
+        iterate.n_rows, iterate.n_cols, currentObjective * lambda);
     isInitialized = true;
   }
 
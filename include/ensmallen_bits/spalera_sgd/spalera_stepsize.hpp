@@ -15,6 +15,8 @@
 #ifndef ENSMALLEN_SPALERA_SGD_SPALERA_STEPSIZE_HPP
 #define ENSMALLEN_SPALERA_SGD_SPALERA_STEPSIZE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -109,12 +111,17 @@ class SPALeRAStepsize
     {
       learningRates.ones(rows, cols);
       relaxedSums.zeros(rows, cols);
+      previousIterate.zeros(rows, cols);
 
       parent.lambda = lambda;
     }
 
     /**
-     * This function is called in each iteration.
+     * This function is called in each iteration.  For dense matrices, the
+     * learning rate adaptation and the step are fused into two passes: one
+     * over the gradient for its norm, and one that updates the relaxed sums,
+     * the learning rates, the backup of the iterate and the iterate.  The
+     * backtracking is a single pass too.
      *
      * @param stepSize Step size to be used for the given iteration.
      * @param objective The current function loss.
@@ -132,10 +139,49 @@ class SPALeRAStepsize
                 MatType& iterate,
                 const GradType& gradient)
     {
-      // The ratio of mini-batch size to training set size; needed for the
-      // Page-Hinkley relaxed objective computations.
-      const double mbRatio = batchSize / (double) numFunctions;
+      // If a change is detected, we reset the parameter and the learning
+      // rates.
+      if (DetectChange(objective, batchSize / (double) numFunctions))
+      {
+        // Backtracking, reset the parameter; stop if the learning rate is too
+        // low.
+        if (!Backtrack(iterate, UseFusedUpdate<MatType, GradType>()))
+          return false;
 
+        // Reset evaluation and Page-Hinkley counter parameter.
+        mu0 = un = mn = relaxedObjective = phCounter = eveCounter = 0;
+      }
+      else
+      {
+        const double paramMean = (parent.alpha / (2 - parent.alpha) *
+            (1 - std::pow(1 - parent.alpha, 2 * (eveCounter + 1)))) /
+            iterate.n_elem;
+
+        const double paramStd = (parent.alpha / std::sqrt(iterate.n_elem)) /
+            std::sqrt(iterate.n_elem);
+
+        Step(stepSize, paramMean, parent.adaptRate / paramStd, iterate,
+            gradient, UseFusedUpdate<MatType, GradType>());
+
+        // Keep track of the the number of evaluations and Page-Hinkley steps.
+        eveCounter++;
+        phCounter++;
+      }
+
+      return true;
+    }
+
+   private:
+    /**
+     * Update the Page-Hinkley statistics of the relaxed objective, and return
+     * whether they detect a change (i.e. whether the objective increases).
+     *
+     * @param objective The current function loss.
+     * @param mbRatio The ratio of the batch size to the number of functions.
+     */
+    bool DetectChange(const typename MatType::elem_type objective,
+                      const double mbRatio)
+    {
       // Page-Hinkley iteration, check if we have to reset the parameter and
       // adjust the step size.
       if (phCounter > (1 / mbRatio))
@@ -160,58 +206,126 @@ class SPALeRAStepsize
       if (un < mn)
         mn = un;
 
-      // If the condition is true we reset the parameter and update parameter.
-      if ((un - mn) > parent.lambda)
-      {
-        // Backtracking, reset the parameter.
-        iterate = previousIterate;
+      return (un - mn) > parent.lambda;
+    }
 
-        // Dividing learning rates by 2 as proposed in:
-        // Stochastic Gradient Descent: Going As Fast As Possible But Not
-        // Faster.
-        learningRates /= 2;
+    //! Fused backtracking for dense matrices: restore the iterate and halve
+    //! the learning rates in one pass, and return false if one of them is too
+    //! low.
+    bool Backtrack(MatType& iterate, std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
 
-        if (arma::any(arma::vectorise(learningRates) <= 1e-15))
+      ElemType* x = iterate.memptr();
+      ElemType* rates = learningRates.memptr();
+      const ElemType* previous = previousIterate.memptr();
+
+      // Dividing learning rates by 2 as proposed in:
+      // Stochastic Gradient Descent: Going As Fast As Possible But Not
+      // Faster.
+      const size_t lowRates = FusedSum<size_t>(iterate.n_elem,
+          [&](const size_t begin, const size_t end)
+      {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i)
         {
-          // Stop because learning rate too low.
-          return false;
+          x[i] = previous[i];
+          rates[i] *= ElemType(0.5);
+          count += (rates[i] <= ElemType(1e-15)) ? 1 : 0;
         }
+        return count;
+      });
 
-        // Reset evaluation and Page-Hinkley counter parameter.
-        mu0 = un = mn = relaxedObjective = phCounter = eveCounter = 0;
-      }
-      else
-      {
-        const double paramMean = (parent.alpha / (2 - parent.alpha) *
-            (1 - std::pow(1 - parent.alpha, 2 * (eveCounter + 1)))) /
-            iterate.n_elem;
+      return (lowRates == 0);
+    }
 
-        const double paramStd = (parent.alpha / std::sqrt(iterate.n_elem)) /
-            std::sqrt(iterate.n_elem);
+    //! Generic backtracking, for all other matrix types.
+    bool Backtrack(MatType& iterate, std::false_type /* fused */)
+    {
+      iterate = previousIterate;
+
+      // Dividing learning rates by 2 as proposed in:
+      // Stochastic Gradient Descent: Going As Fast As Possible But Not
+      // Faster.
+      learningRates /= 2;
 
-        const typename MatType::elem_type normGradient =
-            std::sqrt(arma::accu(arma::pow(gradient, 2)));
+      // Stop if the learning rate is too low.
+      return !arma::any(arma::vectorise(learningRates) <= 1e-15);
+    }
+
+    //! Fused step for dense matrices: one pass over the gradient for its norm
+    //! (accumulated in double precision), and one for the relaxed sums, the
+    //! learning rates, the backup of the iterate and the step.
+    void Step(const double stepSize,
+              const double paramMean,
+              const double adaptScale,
+              MatType& iterate,
+              const GradType& gradient,
+              std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      ElemType* x = iterate.memptr();
+      ElemType* rates = learningRates.memptr();
+      ElemType* sums = relaxedSums.memptr();
+      ElemType* previous = previousIterate.memptr();
+      const ElemType* g = gradient.memptr();
 
-        relaxedSums *= (1 - parent.alpha);
-        if (normGradient > parent.epsilon)
-          relaxedSums += gradient * (parent.alpha / normGradient);
+      const double squaredNorm = FusedSum<double>(gradient.n_elem,
+          [&](const size_t begin, const size_t end)
+      {
+        double sum = 0.0;
+        ENS_PRAGMA_OMP_SIMD_SUM(sum)
+        for (size_t i = begin; i < end; ++i)
+          sum += double(g[i]) * double(g[i]);
+        return sum;
+      });
+
+      const ElemType normGradient = ElemType(std::sqrt(squaredNorm));
+      const ElemType decay = ElemType(1 - parent.alpha);
+      const ElemType weight = (normGradient > parent.epsilon) ?
+          ElemType(parent.alpha) / normGradient : ElemType(0);
+      const ElemType mean = ElemType(paramMean);
+      const ElemType scale = ElemType(adaptScale);
+      const ElemType a = ElemType(stepSize);
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType r = decay * sums[i] + weight * g[i];
+          sums[i] = r;
+          rates[i] *= std::exp((r * r - mean) * scale);
+          previous[i] = x[i];
+          x[i] -= a * (rates[i] * g[i]);
+        }
+      });
+    }
 
-        learningRates %= arma::exp((arma::pow(relaxedSums, 2) - paramMean) *
-            (parent.adaptRate / paramStd));
+    //! Generic step, for all other matrix types.
+    void Step(const double stepSize,
+              const double paramMean,
+              const double adaptScale,
+              MatType& iterate,
+              const GradType& gradient,
+              std::false_type /* fused */)
+    {
+      const typename MatType::elem_type normGradient =
+          std::sqrt(arma::accu(arma::pow(gradient, 2)));
 
-        previousIterate = iterate;
+      relaxedSums *= (1 - parent.alpha);
+      if (normGradient > parent.epsilon)
+        relaxedSums += gradient * (parent.alpha / normGradient);
 
-        iterate -= stepSize * (learningRates % gradient);
+      learningRates %= arma::exp((arma::pow(relaxedSums, 2) - paramMean) *
+          adaptScale);
 
-        // Keep track of the the number of evaluations and Page-Hinkley steps.
-        eveCounter++;
-        phCounter++;
-      }
+      previousIterate = iterate;
 
-      return true;
+      iterate -= stepSize * (learningRates % gradient);
     }
 
-   private:
     //! Instantiated parent object.
     SPALeRAStepsize& parent;
 
@@ -34,6 +34,10 @@ namespace ens {
  * }
  * @endcode
  *
+ * In each iteration, the gradient estimates of `numPerturbations` independent
+ * perturbation pairs are averaged, which lowers their variance; the 2 *
+ * numPerturbations perturbed points can be evaluated in parallel.
+ *
  * SPSA can optimize arbitrary functions.  For more details,
  * see the documentation on function types included with this distribution or on
  * the ensmallen website.
@@ -54,13 +58,23 @@ class SPSA
    * @param maxIterations Maximum number of iterations allowed (0 means no
    *     limit).
    * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param numPerturbations Number of perturbation pairs whose gradient
+   *     estimates are averaged in each iteration.
+   * @param exactObjective If true, evaluate the objective at the new iterate
+   *     after each step; otherwise, use the mean of the objectives at the
+   *     perturbed points (which needs no extra evaluation).
+   * @param parallel If true, evaluate the perturbed points on several OpenMP
+   *     threads; Evaluate() must then be safe to call concurrently.
    */
   SPSA(const double alpha = 0.602,
        const double gamma = 0.101,
        const double stepSize = 0.16,
        const double evaluationStepSize = 0.3,
        const size_t maxIterations = 100000,
-       const double tolerance = 1e-5);
+       const double tolerance = 1e-5,
+       const size_t numPerturbations = 1,
+       const bool exactObjective = true,
+       const bool parallel = false);
 
   /**
    * Optimize the given function, starting from the coordinates given in the
@@ -108,6 +122,26 @@ class SPSA
   //! Modify the maximum number of iterations (0 indicates no limit).
   size_t& MaxIterations() { return maxIterations; }
 
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the number of perturbation pairs of each iteration.
+  size_t NumPerturbations() const { return numPerturbations; }
+  //! Modify the number of perturbation pairs of each iteration.
+  size_t& NumPerturbations() { return numPerturbations; }
+
+  //! Get whether the objective is evaluated exactly after each step.
+  bool ExactObjective() const { return exactObjective; }
+  //! Modify whether the objective is evaluated exactly after each step.
+  bool& ExactObjective() { return exactObjective; }
+
+  //! Get whether the perturbed points are evaluated in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the perturbed points are evaluated in parallel.
+  bool& Parallel() { return parallel; }
+
  private:
   //! Scaling exponent for the step size.
   double alpha;
@@ -129,6 +163,15 @@ class SPSA
 
   //! The tolerance for termination.
   double tolerance;
+
+  //! The number of perturbation pairs of each iteration.
+  size_t numPerturbations;
+
+  //! Whether the objective is evaluated exactly after each step.
+  bool exactObjective;
+
+  //! Whether the perturbed points are evaluated in parallel.
+  bool parallel;
 };
 
 } // namespace ens
@@ -26,14 +26,20 @@ inline SPSA::SPSA(const double alpha,
                   const double stepSize,
                   const double evaluationStepSize,
                   const size_t maxIterations,
-                  const double tolerance) :
+                  const double tolerance,
+                  const size_t numPerturbations,
+                  const bool exactObjective,
+                  const bool parallel) :
     alpha(alpha),
     gamma(gamma),
     stepSize(stepSize),
     evaluationStepSize(evaluationStepSize),
     ak(0.001 * maxIterations),
     maxIterations(maxIterations),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    numPerturbations(numPerturbations),
+    exactObjective(exactObjective),
+    parallel(parallel)
 { /* Nothing to do. */ }
 
 template<typename ArbitraryFunctionType,
@@ -52,8 +58,21 @@ typename MatType::elem_type SPSA::Optimize(ArbitraryFunctionType& function,
       MatType>();
   RequireFloatingPointType<MatType>();
 
+  if (numPerturbations == 0)
+  {
+    throw std::invalid_argument("SPSA::Optimize(): numPerturbations must be "
+        "positive");
+  }
+
   BaseMatType gradient(iterate.n_rows, iterate.n_cols);
-  arma::Mat<ElemType> spVector(iterate.n_rows, iterate.n_cols);
+
+  // The directions of the perturbation pairs, and the points iterate + ck *
+  // direction and iterate - ck * direction of each pair, with their
+  // objectives.
+  std::vector<arma::Mat<ElemType>> spVectors(numPerturbations);
+  std::vector<BaseMatType> points(2 * numPerturbations);
+  std::vector<ElemType> objectives(2 * numPerturbations);
+  RandomStream rng;
 
   // To keep track of where we are and how things are going.
   ElemType overallObjective = 0;
@@ -94,29 +113,55 @@ typename MatType::elem_type SPSA::Optimize(ArbitraryFunctionType& function,
     const double akLocal = stepSize / std::pow(k + 1 + ak, alpha);
     const double ck = evaluationStepSize / std::pow(k + 1, gamma);
 
-    // Choose stochastic directions.
-    spVector = arma::conv_to<arma::Mat<ElemType>>::from(
-        arma::randi(iterate.n_rows, iterate.n_cols,
-        arma::distr_param(0, 1))) * 2 - 1;
-
-    iterate += ck * spVector;
-    const double fPlus = function.Evaluate(iterate);
-    Callback::Evaluate(*this, function, iterate, fPlus, callbacks...);
-
-    iterate -= 2 * ck * spVector;
-    const double fMinus = function.Evaluate(iterate);
-    Callback::Evaluate(*this, function, iterate, fMinus, callbacks...);
+    // Choose the stochastic directions.  They are drawn serially, so the
+    // random numbers don't depend on the number of threads.
+    for (size_t p = 0; p < numPerturbations; ++p)
+    {
+      spVectors[p].set_size(iterate.n_rows, iterate.n_cols);
+      rng.FillSigns(spVectors[p]);
+    }
 
-    iterate += ck * spVector;
+    // Evaluate both points of each perturbation pair.
+    ParallelFor(2 * numPerturbations, [&](const size_t i)
+    {
+      const ElemType sign = (i % 2 == 0) ? ElemType(1) : ElemType(-1);
+      points[i] = iterate + (sign * ElemType(ck)) * spVectors[i / 2];
+      objectives[i] = function.Evaluate(points[i]);
+    }, parallel);
+
+    // Average the gradient estimates of the pairs.  The elements of each
+    // direction are +1 or -1, so dividing by them is multiplying by them.
+    gradient.zeros();
+    ElemType meanObjective = 0;
+    for (size_t p = 0; p < numPerturbations; ++p)
+    {
+      const ElemType fPlus = objectives[2 * p];
+      const ElemType fMinus = objectives[2 * p + 1];
+      Callback::Evaluate(*this, function, points[2 * p], fPlus, callbacks...);
+      Callback::Evaluate(*this, function, points[2 * p + 1], fMinus,
+          callbacks...);
+
+      gradient += ElemType((fPlus - fMinus) / (2 * ck * numPerturbations)) *
+          spVectors[p];
+      meanObjective += (fPlus + fMinus) / (2 * numPerturbations);
+    }
 
-    gradient = (fPlus - fMinus) * (1 / (2 * ck * spVector));
     iterate -= akLocal * gradient;
 
     terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
 
-    overallObjective = function.Evaluate(iterate);
-    Callback::Evaluate(*this, function, iterate, overallObjective,
-        callbacks...);
+    if (exactObjective)
+    {
+      overallObjective = function.Evaluate(iterate);
+      Callback::Evaluate(*this, function, iterate, overallObjective,
+          callbacks...);
+    }
+    else
+    {
+      // The mean of the objectives at the perturbed points estimates the
+      // objective before the step, without another evaluation.
+      overallObjective = meanObjective;
+    }
   }
 
   // Calculate final objective.
@@ -0,0 +1,236 @@
+/**
+ * @file sqn.hpp
+ *
+ * Stochastic quasi-Newton method (SQN) for separable functions, with curvature
+ * pairs from subsampled Hessian-vector products.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SQN_SQN_HPP
+#define ENSMALLEN_SQN_SQN_HPP
+
+#include <ensmallen_bits/lbfgs/lbfgs.hpp>
+
+namespace ens {
+
+/**
+ * SQN is the stochastic quasi-Newton method of Byrd et al.  Each step moves
+ * along -H g, where g is the average gradient of a minibatch and H is the
+ * L-BFGS approximation of the inverse Hessian.  Unlike L-BFGS, the curvature
+ * pairs (s, y) are not differences of the noisy minibatch gradients: every
+ * `updateInterval` steps, s is the difference of the averages of the iterates
+ * of the last two intervals, and y is the product of the Hessian of a separate
+ * (larger) random batch with s.  So the curvature is estimated from stable
+ * quantities, at a cost of about hessianBatchSize / updateInterval gradient
+ * evaluations per step, and the cost of a step is close to that of a minibatch
+ * SGD step (plus O(numBasis) vector operations).  Until the first pair is
+ * stored, the steps are SGD steps.
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @article{Byrd2016,
+ *   author  = {Byrd, Richard H. and Hansen, Samantha L. and Nocedal, Jorge and
+ *              Singer, Yoram},
+ *   title   = {A Stochastic Quasi-Newton Method for Large-Scale Optimization},
+ *   journal = {SIAM Journal on Optimization},
+ *   volume  = {26},
+ *   number  = {2},
+ *   pages   = {1008--1031},
+ *   year    = {2016}
+ * }
+ * @endcode
+ *
+ * If the function has a method
+ *
+ * @code
+ * void HessianVectorProduct(const MatType& coordinates,
+ *                           const size_t begin,
+ *                           const MatType& direction,
+ *                           MatType& product,
+ *                           const size_t batchSize);
+ * @endcode
+ *
+ * (which may be const) it is used for y; otherwise y is the difference of the
+ * gradients of the Hessian batch at the two averages, at the cost of one more
+ * gradient evaluation.  The search direction is computed with the compact
+ * representation of L_BFGS.
+ *
+ * SQN can optimize differentiable separable functions.  For more details, see
+ * the documentation on function types included with this distribution or on
+ * the ensmallen website.
+ */
+class SQN
+{
+ public:
+  /**
+   * Construct the SQN optimizer with the given parameters.  The defaults here
+   * are not necessarily good for the given problem, so it is suggested that the
+   * values used be tailored to the task at hand.
+   *
+   * @param stepSize Step size for each iteration.
+   * @param batchSize Number of functions of the minibatch of each step.
+   * @param hessianBatchSize Number of functions of the batch of each
+   *     Hessian-vector product.
+   * @param updateInterval Number of steps between two curvature pairs.
+   * @param numBasis Number of curvature pairs to store.
+   * @param maxIterations Maximum number of function evaluations allowed (0
+   *     means no limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled; otherwise, each
+   *     function is visited in linear order.
+   * @param exactObjective Calculate the exact objective (Default: estimate the
+   *     final objective obtained on the last pass over the data).
+   */
+  SQN(const double stepSize = 0.1,
+      const size_t batchSize = 32,
+      const size_t hessianBatchSize = 320,
+      const size_t updateInterval = 10,
+      const size_t numBasis = 10,
+      const size_t maxIterations = 100000,
+      const double tolerance = 1e-5,
+      const bool shuffle = true,
+      const bool exactObjective = false);
+
+  /**
+   * Optimize the given function using SQN.  The given starting point will be
+   * modified to store the finishing point of the algorithm, and the final
+   * objective value is returned.
+   *
+   * @tparam SeparableFunctionType Type of the function to be optimized.
+   * @tparam MatType Type of matrix to optimize with.
+   * @tparam GradType Type of matrix to use to represent function gradients.
+   * @tparam CallbackTypes Types of callback functions.
+   * @param function Function to optimize.
+   * @param iterate Starting point (will be modified).
+   * @param callbacks Callback functions.
+   * @return Objective value of the final point.
+   */
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  typename std::enable_if<IsArmaType<GradType>::value,
+      typename MatType::elem_type>::type
+  Optimize(SeparableFunctionType& function,
+           MatType& iterate,
+           CallbackTypes&&... callbacks);
+
+  //! Forward the MatType as GradType.
+  template<typename SeparableFunctionType,
+           typename MatType,
+           typename... CallbackTypes>
+  typename MatType::elem_type Optimize(SeparableFunctionType& function,
+                                       MatType& iterate,
+                                       CallbackTypes&&... callbacks)
+  {
+    return Optimize<SeparableFunctionType, MatType, MatType,
+        CallbackTypes...>(function, iterate,
+        std::forward<CallbackTypes>(callbacks)...);
+  }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the batch size.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the batch size.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the batch size of the Hessian-vector products.
+  size_t HessianBatchSize() const { return hessianBatchSize; }
+  //! Modify the batch size of the Hessian-vector products.
+  size_t& HessianBatchSize() { return hessianBatchSize; }
+
+  //! Get the number of steps between two curvature pairs.
+  size_t UpdateInterval() const { return updateInterval; }
+  //! Modify the number of steps between two curvature pairs.
+  size_t& UpdateInterval() { return updateInterval; }
+
+  //! Get the number of stored curvature pairs.
+  size_t NumBasis() const { return lbfgs.NumBasis(); }
+  //! Modify the number of stored curvature pairs.
+  size_t& NumBasis() { return lbfgs.NumBasis(); }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get whether or not the actual objective is calculated.
+  bool ExactObjective() const { return exactObjective; }
+  //! Modify whether or not the actual objective is calculated.
+  bool& ExactObjective() { return exactObjective; }
+
+ private:
+  /**
+   * Store the product of the Hessian of the given batch at the current average
+   * with s, with the HessianVectorProduct() method of the function.
+   */
+  template<typename FunctionType, typename MatType>
+  static void CurvatureProduct(FunctionType& function,
+                               const MatType& average,
+                               const MatType& oldAverage,
+                               const MatType& s,
+                               const size_t begin,
+                               const size_t batchSize,
+                               MatType& product,
+                               const std::true_type /* hasProduct */);
+
+  /**
+   * Store the difference of the gradients of the given batch at the current
+   * and the previous averages, an approximation of the product of the Hessian
+   * with s.
+   */
+  template<typename FunctionType, typename MatType>
+  static void CurvatureProduct(FunctionType& function,
+                               const MatType& average,
+                               const MatType& oldAverage,
+                               const MatType& s,
+                               const size_t begin,
+                               const size_t batchSize,
+                               MatType& product,
+                               const std::false_type /* hasProduct */);
+
+  //! The step size for each example.
+  double stepSize;
+  //! The size of each minibatch.
+  size_t batchSize;
+  //! The size of the batch of each Hessian-vector product.
+  size_t hessianBatchSize;
+  //! The number of steps between two curvature pairs.
+  size_t updateInterval;
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+  //! The tolerance for termination.
+  double tolerance;
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+  //! Controls whether or not the actual objective is calculated.
+  bool exactObjective;
+  //! The L-BFGS optimizer whose inverse Hessian approximation is used; it
+  //! holds the number of stored pairs.
+  L_BFGS lbfgs;
+};
+
+} // namespace ens
+
+#include "sqn_impl.hpp"
+
+#endif
@@ -0,0 +1,267 @@
+/**
+ * @file sqn_impl.hpp
+ *
+ * Implementation of the stochastic quasi-Newton method (SQN).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_SQN_SQN_IMPL_HPP
+#define ENSMALLEN_SQN_SQN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sqn.hpp"
+
+#include <ensmallen_bits/function.hpp>
+
+namespace ens {
+
+inline SQN::SQN(const double stepSize,
+                const size_t batchSize,
+                const size_t hessianBatchSize,
+                const size_t updateInterval,
+                const size_t numBasis,
+                const size_t maxIterations,
+                const double tolerance,
+                const bool shuffle,
+                const bool exactObjective) :
+    stepSize(stepSize),
+    batchSize(batchSize),
+    hessianBatchSize(hessianBatchSize),
+    updateInterval(updateInterval),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    exactObjective(exactObjective),
+    lbfgs(numBasis)
+{ /* Nothing to do. */ }
+
+template<typename FunctionType, typename MatType>
+inline void SQN::CurvatureProduct(FunctionType& function,
+                                  const MatType& average,
+                                  const MatType& /* oldAverage */,
+                                  const MatType& s,
+                                  const size_t begin,
+                                  const size_t batchSize,
+                                  MatType& product,
+                                  const std::true_type /* hasProduct */)
+{
+  function.HessianVectorProduct(average, begin, s, product, batchSize);
+}
+
+template<typename FunctionType, typename MatType>
+inline void SQN::CurvatureProduct(FunctionType& function,
+                                  const MatType& average,
+                                  const MatType& oldAverage,
+                                  const MatType& /* s */,
+                                  const size_t begin,
+                                  const size_t batchSize,
+                                  MatType& product,
+                                  const std::false_type /* hasProduct */)
+{
+  MatType oldGradient;
+  function.Gradient(average, begin, product, batchSize);
+  function.Gradient(oldAverage, begin, oldGradient, batchSize);
+  product -= oldGradient;
+}
+
+//! Optimize the function (minimize).
+template<typename SeparableFunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+typename std::enable_if<IsArmaType<GradType>::value,
+typename MatType::elem_type>::type
+SQN::Optimize(SeparableFunctionType& function,
+              MatType& iterateIn,
+              CallbackTypes&&... callbacks)
+{
+  // Convenience typedefs.
+  typedef typename MatType::elem_type ElemType;
+  typedef typename MatTypeTraits<MatType>::BaseMatType BaseMatType;
+  typedef typename MatTypeTraits<GradType>::BaseMatType BaseGradType;
+
+  typedef Function<SeparableFunctionType, BaseMatType, BaseGradType>
+      FullFunctionType;
+  FullFunctionType& f(static_cast<FullFunctionType&>(function));
+
+  // Make sure we have all the methods that we need.
+  traits::CheckSeparableFunctionTypeAPI<FullFunctionType, BaseMatType,
+      BaseGradType>();
+  RequireDenseFloatingPointType<BaseMatType>();
+  RequireDenseFloatingPointType<BaseGradType>();
+  RequireSameInternalTypes<BaseMatType, BaseGradType>();
+
+  typedef std::integral_constant<bool,
+      traits::HasSeparableHessianVectorProductSignature<SeparableFunctionType,
+      BaseMatType>::value> HasProductType;
+
+  if (batchSize == 0 || updateInterval == 0 || lbfgs.NumBasis() == 0)
+  {
+    throw std::invalid_argument("SQN::Optimize(): the batch size, the update "
+        "interval and the number of stored pairs must be positive!");
+  }
+
+  BaseMatType& iterate = (BaseMatType&) iterateIn;
+
+  // Find the number of functions to use.
+  const size_t numFunctions = f.NumFunctions();
+  const size_t actualHessianBatchSize = std::min(hessianBatchSize,
+      numFunctions);
+
+  // To keep track of where we are and how things are going.
+  size_t currentFunction = 0;
+  ElemType overallObjective = 0;
+  ElemType lastObjective = std::numeric_limits<ElemType>::max();
+
+  // The stored s and y vectors and their inner products, in the layout of
+  // L_BFGS.
+  const size_t numBasis = lbfgs.NumBasis();
+  arma::Mat<ElemType> history(iterate.n_elem, 2 * numBasis);
+  arma::Mat<ElemType> gram(2 * numBasis, 2 * numBasis, arma::fill::zeros);
+  size_t pairs = 0;
+
+  BaseGradType gradient(iterate.n_rows, iterate.n_cols);
+  BaseMatType direction(iterate.n_rows, iterate.n_cols);
+  BaseMatType sum(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  BaseMatType average, oldAverage, s, y;
+  const BaseMatType zero(iterate.n_rows, iterate.n_cols, arma::fill::zeros);
+  size_t steps = 0;
+
+  // The Hessian batches are drawn from their own stream.
+  RandomStream rng;
+
+  // Controls early termination of the optimization process.
+  bool terminate = false;
+
+  // Now iterate!
+  terminate |= Callback::BeginOptimization(*this, f, iterate, callbacks...);
+  const size_t actualMaxIterations = (maxIterations == 0) ?
+      std::numeric_limits<size_t>::max() : maxIterations;
+  for (size_t i = 0; i < actualMaxIterations && !terminate;
+      /* incrementing done manually */)
+  {
+    // Find the effective batch size; we have to take the minimum of three
+    // things:
+    // - the batch size can't be larger than the user-specified batch size;
+    // - the batch size can't be larger than the number of iterations left
+    //       before actualMaxIterations is hit;
+    // - the batch size can't be larger than the number of functions left.
+    const size_t effectiveBatchSize = std::min(
+        std::min(batchSize, actualMaxIterations - i),
+        numFunctions - currentFunction);
+
+    const ElemType objective = f.EvaluateWithGradient(iterate,
+        currentFunction, gradient, effectiveBatchSize);
+    overallObjective += objective;
+    terminate |= Callback::EvaluateWithGradient(*this, f, iterate, objective,
+        gradient, callbacks...);
+
+    // Step along -H g with the average gradient of the minibatch; H is the
+    // identity until the first pair is stored.
+    gradient /= (ElemType) effectiveBatchSize;
+    if (pairs == 0)
+    {
+      iterate -= stepSize * gradient;
+    }
+    else
+    {
+      const double scalingFactor = lbfgs.ChooseScalingFactor(pairs, gradient,
+          gram);
+      lbfgs.SearchDirection(gradient, pairs, scalingFactor, history, gram,
+          direction);
+      iterate += stepSize * direction;
+    }
+    terminate |= Callback::StepTaken(*this, f, iterate, callbacks...);
+
+    // Every updateInterval steps, store a pair from the averages of the
+    // iterates of the last two intervals.
+    sum += iterate;
+    if (++steps % updateInterval == 0)
+    {
+      average = sum / (ElemType) updateInterval;
+      sum.zeros();
+      if (steps > updateInterval)
+      {
+        s = average - oldAverage;
+        const size_t begin = rng.Integer(numFunctions -
+            actualHessianBatchSize + 1);
+        CurvatureProduct(f, average, oldAverage, s, begin,
+            actualHessianBatchSize, y, HasProductType());
+        y /= (ElemType) actualHessianBatchSize;
+
+        // Pairs without positive curvature would make H indefinite.
+        const ElemType curvature = arma::dot(s, y);
+        if (curvature > std::numeric_limits<ElemType>::epsilon() *
+            arma::norm(s, "fro") * arma::norm(y, "fro"))
+        {
+          lbfgs.UpdateBasisSet(pairs, average, oldAverage, y, zero, history,
+              gram);
+          ++pairs;
+        }
+      }
+      oldAverage = average;
+    }
+
+    i += effectiveBatchSize;
+    currentFunction += effectiveBatchSize;
+
+    // Is this iteration the start of a sequence?
+    if ((currentFunction % numFunctions) == 0)
+    {
+      // Output current objective function.
+      Info << "SQN: iteration " << i << ", objective " << overallObjective
+          << ", " << std::min(pairs, numBasis) << " curvature pairs."
+          << std::endl;
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Warn << "SQN: converged to " << overallObjective << "; terminating"
+            << " with failure.  Try a smaller step size?" << std::endl;
+
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Info << "SQN: minimized within tolerance " << tolerance << "; "
+            << "terminating optimization." << std::endl;
+
+        Callback::EndOptimization(*this, f, iterate, callbacks...);
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentFunction = 0;
+
+      if (shuffle) // Determine order of visitation.
+        f.Shuffle();
+    }
+  }
+
+  Info << "SQN: maximum iterations (" << maxIterations << ") reached; "
+      << "terminating optimization." << std::endl;
+
+  // Calculate final objective if exactObjective is set to true.
+  if (exactObjective)
+  {
+    overallObjective = 0;
+    for (size_t i = 0; i < numFunctions; i += batchSize)
+    {
+      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - i);
+      overallObjective += f.Evaluate(iterate, i, effectiveBatchSize);
+    }
+  }
+
+  Callback::EndOptimization(*this, f, iterate, callbacks...);
+  return overallObjective;
+}
+
+} // namespace ens
+
+#endif
@@ -53,6 +53,43 @@ namespace ens {
  * details, see the documentation on function types included with this
  * distribution or on the ensmallen website.
  *
+ * If ParallelFullGradient() is set to true (and OpenMP is enabled), the full
+ * objective and the full gradient of each outer iteration are computed by
+ * splitting the functions into contiguous ranges that are evaluated on separate
+ * threads, and then reduced; see ParallelEvaluateWithGradient().  The separable
+ * Evaluate() and Gradient() must then be safe to call concurrently on disjoint
+ * batches.  If DeterministicReduction() is also set, the functions are split
+ * into batches of BatchSize() that are reduced in a fixed order, so results do
+ * not depend on the number of threads.
+ *
+ * If CacheSnapshotGradients() is set to true, the gradient of each batch at
+ * the snapshot is kept when the full gradient is computed, and reused in the
+ * inner loop, which then computes one gradient per step instead of two.  This
+ * needs memory for one gradient per batch.  With shuffling, the functions are
+ * then shuffled once per outer iteration, before the full gradient.
+ *
+ * If AsynchronousInnerLoop() is set to true, the inner loop runs lock-free on
+ * all the threads of the executor, in the style of Hogwild! (see ParallelSGD):
+ * every thread takes vanilla SVRG steps with the shared full gradient on the
+ * shared iterate, applying each change with an atomic update.  For sparse
+ * gradients (e.g. arma::sp_mat as GradType), a step only writes the
+ * coordinates that the two batch gradients touch: the full gradient term of
+ * the steps taken since a coordinate was last written is applied lazily the
+ * next time it is written (and to all coordinates at the end of the inner
+ * loop), so that no step writes the whole iterate.  With shuffling, the
+ * functions are then shuffled once per outer iteration.  The update policy is
+ * not used, and the separable Gradient() must be safe to call concurrently.
+ *
+ * The Gradient() and StepTaken() callbacks of the asynchronous inner loop are
+ * never called concurrently, so callbacks need no locks.  Each thread records
+ * its steps (and copies of the gradients, if a callback has a Gradient()
+ * method), and the steps are replayed by the calling thread after the inner
+ * loop, in the order of the threads, with the final iterate.  If
+ * CallbackBufferSize() is not 0, a thread also replays its steps under a lock
+ * once it has recorded that many; the callbacks then see the iterate while the
+ * other threads update it.  When a callback asks to terminate, no thread
+ * starts another step.
+ *
  * For more information, please refer to:
  *
  * @code
@@ -204,6 +241,40 @@ class SVRGType
   //! are reset before Optimize call.
   bool& ResetPolicy() { return resetPolicy; }
 
+  //! Get whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool ParallelFullGradient() const { return parallelFullGradient; }
+  //! Modify whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool& ParallelFullGradient() { return parallelFullGradient; }
+
+  //! Get whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool DeterministicReduction() const { return deterministicReduction; }
+  //! Modify whether or not parallel reductions are deterministic (i.e.,
+  //! independent of the number of threads).
+  bool& DeterministicReduction() { return deterministicReduction; }
+
+  //! Get whether or not the batch gradients at the snapshot are reused in the
+  //! inner loop.
+  bool CacheSnapshotGradients() const { return cacheSnapshotGradients; }
+  //! Modify whether or not the batch gradients at the snapshot are reused in
+  //! the inner loop.
+  bool& CacheSnapshotGradients() { return cacheSnapshotGradients; }
+
+  //! Get whether or not the inner loop runs asynchronously on all threads.
+  bool AsynchronousInnerLoop() const { return asynchronousInnerLoop; }
+  //! Modify whether or not the inner loop runs asynchronously on all threads.
+  bool& AsynchronousInnerLoop() { return asynchronousInnerLoop; }
+
+  //! Get the number of steps a thread of the asynchronous inner loop records
+  //! before replaying them to the callbacks (0 means only after the loop).
+  size_t CallbackBufferSize() const { return callbackBufferSize; }
+  //! Modify the number of steps a thread of the asynchronous inner loop
+  //! records before replaying them to the callbacks (0 means only after the
+  //! loop).
+  size_t& CallbackBufferSize() { return callbackBufferSize; }
+
   //! Get the update policy.
   const UpdatePolicyType& UpdatePolicy() const { return updatePolicy; }
   //! Modify the update policy.
@@ -215,6 +286,63 @@ class SVRGType
   DecayPolicyType& DecayPolicy() { return decayPolicy; }
 
  private:
+  /**
+   * Run the inner loop on all threads asynchronously, with lazy updates of
+   * the full gradient term; see AsynchronousInnerLoop().
+   *
+   * @param function Function to optimize.
+   * @param iterate The shared iterate (will be modified).
+   * @param iterate0 The snapshot.
+   * @param fullGradient The average gradient at the snapshot.
+   * @param snapshotGradients The gradient of each batch at the snapshot, or
+   *     empty if they are not cached.
+   * @param numSteps The number of steps to take.
+   * @param terminate Set to true if a callback requested termination.
+   * @param callbacks Callback functions.
+   */
+  template<typename FunctionType,
+           typename MatType,
+           typename GradType,
+           typename... CallbackTypes>
+  void AsynchronousSteps(FunctionType& function,
+                         MatType& iterate,
+                         const MatType& iterate0,
+                         const GradType& fullGradient,
+                         const std::vector<GradType>& snapshotGradients,
+                         const size_t numSteps,
+                         bool& terminate,
+                         CallbackTypes&... callbacks);
+
+  /**
+   * Subtract scale * stepSize times the given dense gradient from the iterate
+   * with atomic updates, together with the lazy full gradient term of every
+   * coordinate.
+   */
+  template<typename MatType, typename GradType, typename ElemType>
+  static void LazyUpdate(MatType& iterate,
+                         const GradType& gradient,
+                         const double scale,
+                         const double stepSize,
+                         const arma::Mat<ElemType>& fullGradient,
+                         std::vector<std::atomic<size_t>>& applied,
+                         const size_t step,
+                         const std::false_type /* isSparse */);
+
+  /**
+   * Subtract scale * stepSize times the given sparse gradient from the iterate
+   * with atomic updates, together with the lazy full gradient term of the
+   * coordinates that it touches.
+   */
+  template<typename MatType, typename GradType, typename ElemType>
+  static void LazyUpdate(MatType& iterate,
+                         const GradType& gradient,
+                         const double scale,
+                         const double stepSize,
+                         const arma::Mat<ElemType>& fullGradient,
+                         std::vector<std::atomic<size_t>>& applied,
+                         const size_t step,
+                         const std::true_type /* isSparse */);
+
   //! The step size for each example.
   double stepSize;
 
@@ -237,6 +365,26 @@ class SVRGType
   //! Controls whether or not the actual Objective value is calculated.
   bool exactObjective;
 
+  //! Controls whether or not the full objective and gradient are computed in
+  //! parallel.
+  bool parallelFullGradient;
+
+  //! Controls whether or not parallel reductions are independent of the number
+  //! of threads.
+  bool deterministicReduction;
+
+  //! Controls whether or not the batch gradients at the snapshot are reused in
+  //! the inner loop.
+  bool cacheSnapshotGradients;
+
+  //! Controls whether or not the inner loop runs asynchronously on all
+  //! threads.
+  bool asynchronousInnerLoop;
+
+  //! The number of steps a thread of the asynchronous inner loop records
+  //! before replaying them to the callbacks.
+  size_t callbackBufferSize;
+
   //! The update policy used to update the parameters in each iteration.
   UpdatePolicyType updatePolicy;
 
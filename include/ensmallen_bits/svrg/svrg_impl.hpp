@@ -15,6 +15,8 @@
 // In case it hasn't been included yet.
 #include "svrg.hpp"
 
+#include <ensmallen_bits/parallel_sgd/parallel_sgd.hpp>
+
 namespace ens {
 
 template<typename UpdatePolicyType, typename DecayPolicyType>
@@ -36,6 +38,11 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::SVRGType(
     tolerance(tolerance),
     shuffle(shuffle),
     exactObjective(exactObjective),
+    parallelFullGradient(false),
+    deterministicReduction(false),
+    cacheSnapshotGradients(false),
+    asynchronousInnerLoop(false),
+    callbackBufferSize(64),
     updatePolicy(updatePolicy),
     decayPolicy(decayPolicy),
     resetPolicy(resetPolicy),
@@ -82,6 +89,14 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   typedef typename DecayPolicyType::template Policy<BaseMatType, BaseGradType>
       InstDecayPolicyType;
 
+  // Other threads read the iterate while it is updated, so its structure
+  // can't change.
+  if (asynchronousInnerLoop && arma::is_arma_sparse_type<BaseMatType>::value)
+  {
+    throw std::invalid_argument("SVRG::Optimize(): the asynchronous inner "
+        "loop needs a dense iterate!");
+  }
+
   BaseMatType& iterate = (BaseMatType&) iterateIn;
 
   // Find the number of functions to use.
@@ -102,18 +117,15 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   if (!isInitialized ||
       !instDecayPolicy.Has<InstDecayPolicyType>())
   {
-    instDecayPolicy.Clean();
-    instDecayPolicy.Set<InstDecayPolicyType>(
-        new InstDecayPolicyType(decayPolicy));
+    instDecayPolicy.Emplace<InstDecayPolicyType>(decayPolicy);
   }
 
   // Initialize the update policy.
   if (resetPolicy || !isInitialized ||
       !instUpdatePolicy.Has<InstUpdatePolicyType>())
   {
-    instUpdatePolicy.Clean();
-    instUpdatePolicy.Set<InstUpdatePolicyType>(
-        new InstUpdatePolicyType(updatePolicy, iterate.n_rows, iterate.n_cols));
+    instUpdatePolicy.Emplace<InstUpdatePolicyType>(
+        updatePolicy, iterate.n_rows, iterate.n_cols);
     isInitialized = true;
   }
 
@@ -121,6 +133,14 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   BaseGradType gradient(iterate.n_rows, iterate.n_cols);
   BaseGradType gradient0(iterate.n_rows, iterate.n_cols);
   BaseMatType iterate0;
+  BaseGradType fullGradient(iterate.n_rows, iterate.n_cols);
+
+  // Per-thread gradient buffers, only used if parallelFullGradient is true.
+  std::vector<BaseGradType> threadGradients;
+
+  // The gradient of each batch at the snapshot, only used if
+  // cacheSnapshotGradients is true.
+  std::vector<BaseGradType> snapshotGradients;
 
   // Find the number of batches.
   size_t numBatches = numFunctions / batchSize;
@@ -135,13 +155,24 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   {
     // Calculate the objective function.
     overallObjective = 0;
-    for (size_t f = 0; f < numFunctions; f += batchSize)
+    if (parallelFullGradient)
     {
-      const size_t effectiveBatchSize = std::min(batchSize, numFunctions - f);
-      const ElemType objective = function.Evaluate(iterate, f,
-          effectiveBatchSize);
-      Callback::Evaluate(*this, function, iterate, objective, callbacks...);
-      overallObjective += objective;
+      overallObjective = ParallelEvaluate(function, iterate, 0, numFunctions,
+          deterministicReduction, batchSize);
+      Callback::Evaluate(*this, function, iterate, overallObjective,
+          callbacks...);
+    }
+    else
+    {
+      for (size_t f = 0; f < numFunctions; f += batchSize)
+      {
+        const size_t effectiveBatchSize = std::min(batchSize,
+            numFunctions - f);
+        const ElemType objective = function.Evaluate(iterate, f,
+            effectiveBatchSize);
+        Callback::Evaluate(*this, function, iterate, objective, callbacks...);
+        overallObjective += objective;
+      }
     }
 
     if (std::isnan(overallObjective) || std::isinf(overallObjective))
@@ -167,24 +198,47 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
 
     // Compute the full gradient.
     size_t effectiveBatchSize = std::min(batchSize, numFunctions);
-    BaseGradType fullGradient(iterate.n_rows, iterate.n_cols);
-    function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
+    if (cacheSnapshotGradients)
+    {
+      // The inner loop visits the batches in the order of this pass.
+      if (shuffle)
+        function.Shuffle();
 
-    terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
-        callbacks...);
-    for (size_t f = effectiveBatchSize; f < numFunctions;
-        /* incrementing done manually */)
+      BatchGradients(function, iterate, batchSize, snapshotGradients,
+          fullGradient, parallelFullGradient);
+      for (size_t b = 0; b < snapshotGradients.size(); ++b)
+      {
+        terminate |= Callback::Gradient(*this, function, iterate,
+            snapshotGradients[b], callbacks...);
+      }
+    }
+    else if (parallelFullGradient)
+    {
+      ParallelGradient(function, iterate, 0, fullGradient, numFunctions,
+          threadGradients, deterministicReduction, batchSize);
+      terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
+          callbacks...);
+    }
+    else
     {
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - f);
+      function.Gradient(iterate, 0, fullGradient, effectiveBatchSize);
+
+      terminate |= Callback::Gradient(*this, function, iterate, fullGradient,
+          callbacks...);
+      for (size_t f = effectiveBatchSize; f < numFunctions;
+          /* incrementing done manually */)
+      {
+        // Find the effective batch size (the last batch may be smaller).
+        effectiveBatchSize = std::min(batchSize, numFunctions - f);
 
-      function.Gradient(iterate, f, gradient, effectiveBatchSize);
-      terminate |= Callback::Gradient(*this, function, iterate, gradient,
-        callbacks...);
+        function.Gradient(iterate, f, gradient, effectiveBatchSize);
+        terminate |= Callback::Gradient(*this, function, iterate, gradient,
+          callbacks...);
 
-      fullGradient += gradient;
+        fullGradient += gradient;
 
-      f += effectiveBatchSize;
+        f += effectiveBatchSize;
+      }
     }
     fullGradient /= (double) numFunctions;
 
@@ -192,41 +246,64 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
     // gradient.
     iterate0 = iterate;
 
-    for (size_t f = 0, currentFunction = 0; f < innerIterations;
-        /* incrementing done manually */)
+    if (asynchronousInnerLoop)
+    {
+      if (shuffle && !cacheSnapshotGradients)
+        function.Shuffle();
+
+      // Take as many steps as the sequential inner loop.
+      const size_t rest = innerIterations % numFunctions;
+      const size_t numSteps = (innerIterations / numFunctions) * numBatches +
+          (rest + batchSize - 1) / batchSize;
+      AsynchronousSteps(function, iterate, iterate0, fullGradient,
+          snapshotGradients, numSteps, terminate, callbacks...);
+    }
+    else
     {
-      // Is this iteration the start of a sequence?
-      if ((currentFunction % numFunctions) == 0)
+      for (size_t f = 0, currentFunction = 0; f < innerIterations;
+          /* incrementing done manually */)
       {
-        currentFunction = 0;
-
-        // Determine order of visitation.
-        if (shuffle)
-          function.Shuffle();
+        // Is this iteration the start of a sequence?
+        if ((currentFunction % numFunctions) == 0)
+        {
+          currentFunction = 0;
+
+          // Determine order of visitation; the cached snapshot gradients need
+          // the order of the full gradient pass.
+          if (shuffle && !cacheSnapshotGradients)
+            function.Shuffle();
+        }
+
+        // Find the effective batch size (the last batch may be smaller).
+        effectiveBatchSize = std::min(batchSize,
+            numFunctions - currentFunction);
+
+        // Calculate variance reduced gradient.
+        function.Gradient(iterate, currentFunction, gradient,
+            effectiveBatchSize);
+        terminate |= Callback::Gradient(*this, function, iterate, gradient,
+          callbacks...);
+
+        if (!cacheSnapshotGradients)
+        {
+          function.Gradient(iterate0, currentFunction, gradient0,
+              effectiveBatchSize);
+          terminate |= Callback::Gradient(*this, function, iterate0, gradient0,
+            callbacks...);
+        }
+
+        // Use the update policy to take a step.
+        instUpdatePolicy.As<InstUpdatePolicyType>().Update(iterate,
+            fullGradient, gradient, cacheSnapshotGradients ?
+            snapshotGradients[currentFunction / batchSize] : gradient0,
+            effectiveBatchSize, stepSize);
+
+        terminate |= Callback::StepTaken(*this, function, iterate,
+            callbacks...);
+
+        currentFunction += effectiveBatchSize;
+        f += effectiveBatchSize;
       }
-
-      // Find the effective batch size (the last batch may be smaller).
-      effectiveBatchSize = std::min(batchSize, numFunctions - currentFunction);
-
-      // Calculate variance reduced gradient.
-      function.Gradient(iterate, currentFunction, gradient,
-          effectiveBatchSize);
-      terminate |= Callback::Gradient(*this, function, iterate, gradient,
-        callbacks...);
-
-      function.Gradient(iterate0, currentFunction, gradient0,
-          effectiveBatchSize);
-      terminate |= Callback::Gradient(*this, function, iterate0, gradient0,
-        callbacks...);
-
-      // Use the update policy to take a step.
-      instUpdatePolicy.As<InstUpdatePolicyType>().Update(iterate, fullGradient,
-          gradient, gradient0, effectiveBatchSize, stepSize);
-
-      terminate |= Callback::StepTaken(*this, function, iterate, callbacks...);
-
-      currentFunction += effectiveBatchSize;
-      f += effectiveBatchSize;
     }
 
     // Update the learning rate if requested by the user.
@@ -256,6 +333,175 @@ SVRGType<UpdatePolicyType, DecayPolicyType>::Optimize(
   return overallObjective;
 }
 
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename FunctionType,
+         typename MatType,
+         typename GradType,
+         typename... CallbackTypes>
+void SVRGType<UpdatePolicyType, DecayPolicyType>::AsynchronousSteps(
+    FunctionType& function,
+    MatType& iterate,
+    const MatType& iterate0,
+    const GradType& fullGradient,
+    const std::vector<GradType>& snapshotGradients,
+    const size_t numSteps,
+    bool& terminate,
+    CallbackTypes&... callbacks)
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef std::integral_constant<bool,
+      arma::is_arma_sparse_type<GradType>::value> IsSparseType;
+
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBatches = (numFunctions + batchSize - 1) / batchSize;
+  const arma::Mat<ElemType> denseFullGradient(fullGradient);
+
+  // applied[j] is the number of steps whose full gradient term has been
+  // applied to coordinate j.  Since it is exchanged atomically, the lags added
+  // by all threads sum to the last value, even if they race.
+  std::vector<std::atomic<size_t>> applied(iterate.n_elem);
+  for (size_t j = 0; j < applied.size(); ++j)
+    applied[j].store(0);
+
+  // The Gradient() and StepTaken() callbacks are never called concurrently:
+  // each thread records its steps, and the steps are replayed under a lock
+  // when a buffer is full, and by this thread after the loop (in the order of
+  // the threads).  The gradients are only copied if a callback needs them.
+  typedef SVRGType<UpdatePolicyType, DecayPolicyType> OptimizerType;
+  const bool keepGradients = callbacks::traits::AnyOf<callbacks::traits::
+      HasGradientSignature<typename std::remove_reference<CallbackTypes>::type,
+      OptimizerType, FunctionType, MatType, GradType>::value...>::value;
+  const bool recordSteps = keepGradients || callbacks::traits::AnyOf<
+      !callbacks::traits::HasStepTakenSignature<typename std::remove_reference<
+      CallbackTypes>::type, OptimizerType, FunctionType,
+      MatType>::hasNone...>::value;
+
+  // Steps are claimed in order; step k visits batch k % numBatches.  Every
+  // claimed step is taken, so the steps taken are always the first ones, and
+  // once a callback asks to terminate, no more steps are claimed.
+  std::atomic<size_t> nextStep(0);
+  std::atomic<size_t> takenSteps(0);
+  std::atomic<bool> stop(false);
+  const size_t threads = MaxThreads();
+  std::vector<CallbackEvents<GradType>> events(threads,
+      CallbackEvents<GradType>(callbackBufferSize));
+  std::mutex callbackMutex;
+  ParallelFor(threads, [&](const size_t t)
+  {
+    GradType gradient, gradient0;
+    size_t k;
+    while ((k = nextStep.fetch_add(1)) < numSteps)
+    {
+      const size_t batch = k % numBatches;
+      const size_t begin = batch * batchSize;
+      const size_t effectiveBatchSize = std::min(batchSize,
+          numFunctions - begin);
+      const double scale = 1.0 / (double) effectiveBatchSize;
+
+      function.Gradient(iterate, begin, gradient, effectiveBatchSize);
+      LazyUpdate(iterate, gradient, scale, stepSize, denseFullGradient,
+          applied, k + 1, IsSparseType());
+      if (snapshotGradients.empty())
+      {
+        function.Gradient(iterate0, begin, gradient0, effectiveBatchSize);
+        LazyUpdate(iterate, gradient0, -scale, stepSize, denseFullGradient,
+            applied, k + 1, IsSparseType());
+      }
+      else
+      {
+        LazyUpdate(iterate, snapshotGradients[batch], -scale, stepSize,
+            denseFullGradient, applied, k + 1, IsSparseType());
+      }
+      takenSteps.fetch_add(1);
+
+      if (!recordSteps)
+        continue;
+
+      events[t].Add(gradient, keepGradients);
+      if (events[t].Full())
+      {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        if (events[t].Replay(*this, function, iterate, keepGradients,
+            callbacks...))
+        {
+          stop.store(true);
+          nextStep.store(numSteps);
+        }
+      }
+    }
+  });
+
+  // Apply the rest of the full gradient term of the steps that were taken.
+  const size_t steps = takenSteps.load();
+  for (size_t j = 0; j < iterate.n_elem; ++j)
+  {
+    const double lag = (double) steps - (double) applied[j].load();
+    if (lag != 0.0)
+    {
+      iterate[j] -= (ElemType) (stepSize * lag) * denseFullGradient[j];
+    }
+  }
+
+  // Replay the rest of the steps with the final iterate.
+  for (size_t t = 0; t < threads; ++t)
+  {
+    if (events[t].Steps() > 0 && events[t].Replay(*this, function, iterate,
+        keepGradients, callbacks...))
+    {
+      stop.store(true);
+    }
+  }
+
+  terminate |= stop.load();
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType, typename ElemType>
+void SVRGType<UpdatePolicyType, DecayPolicyType>::LazyUpdate(
+    MatType& iterate,
+    const GradType& gradient,
+    const double scale,
+    const double stepSize,
+    const arma::Mat<ElemType>& fullGradient,
+    std::vector<std::atomic<size_t>>& applied,
+    const size_t step,
+    const std::false_type /* isSparse */)
+{
+  for (size_t j = 0; j < gradient.n_elem; ++j)
+  {
+    const double lag = (double) step - (double) applied[j].exchange(step);
+    UpdateLocation(iterate, j % iterate.n_rows, j / iterate.n_rows,
+        (ElemType) (stepSize * (lag * fullGradient[j] + scale * gradient[j])));
+  }
+}
+
+template<typename UpdatePolicyType, typename DecayPolicyType>
+template<typename MatType, typename GradType, typename ElemType>
+void SVRGType<UpdatePolicyType, DecayPolicyType>::LazyUpdate(
+    MatType& iterate,
+    const GradType& gradient,
+    const double scale,
+    const double stepSize,
+    const arma::Mat<ElemType>& fullGradient,
+    std::vector<std::atomic<size_t>>& applied,
+    const size_t step,
+    const std::true_type /* isSparse */)
+{
+  for (size_t i = 0; i < gradient.n_cols; ++i)
+  {
+    // Iterate over the non-zero elements.
+    const typename GradType::const_iterator curEnd = gradient.end_col(i);
+    for (typename GradType::const_iterator cur = gradient.begin_col(i);
+        cur != curEnd; ++cur)
+    {
+      const size_t j = i * iterate.n_rows + cur.row();
+      const double lag = (double) step - (double) applied[j].exchange(step);
+      UpdateLocation(iterate, cur.row(), i, (ElemType) (stepSize *
+          (lag * fullGradient[j] + scale * (*cur))));
+    }
+  }
+}
+
 } // namespace ens
 
 #endif
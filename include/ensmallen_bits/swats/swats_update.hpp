@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_SWATS_SWATS_UPDATE_HPP
 #define ENSMALLEN_SWATS_SWATS_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -19,6 +21,11 @@ namespace ens {
  * condition is satisfied. The condition relates to the projection of Adam steps
  * on the gradient subspace.
  *
+ * For dense matrices, the Adam step and the two dot products of the switching
+ * condition are computed in one pass over the elements.  Once the update has
+ * switched to SGD, the first moment estimates are released, and only the
+ * momentum of the SGD steps is kept.
+ *
  * For more information, see the following.
  *
  * @code
@@ -93,6 +100,13 @@ class SWATSUpdate
   //! Modify the SGD step size.
   double& SGDLambda() { return sgdLambda; }
 
+  //! Return the number of bytes of state that the policy keeps for coordinates
+  //! of the given size: the moment estimates, or the momentum after the switch
+  //! to SGD.
+  template<typename MatType, typename GradType = MatType>
+  size_t StateBytes(const size_t rows, const size_t cols) const
+  { return (phaseSGD ? 1 : 2) * MatrixBytes<GradType>(rows, cols); }
+
   /**
    * The UpdatePolicyType policy classes must contain an internal 'Policy'
    * template class with two template arguments: MatType and GradType.  This is
@@ -113,10 +127,10 @@ class SWATSUpdate
     Policy(SWATSUpdate& parent, const size_t rows, const size_t cols) :
         parent(parent)
     {
-      m.zeros(rows, cols);
+      // The first moment estimates are only needed before the switch to SGD.
+      if (!parent.phaseSGD)
+        m.zeros(rows, cols);
       v.zeros(rows, cols);
-
-      sgdV.zeros(rows, cols);
     }
 
     /**
@@ -135,34 +149,28 @@ class SWATSUpdate
 
       if (parent.phaseSGD)
       {
-        // Note we reuse the exponential moving average parameter here instead
-        // of introducing a new parameter (sgdV) as done in the paper.
-        v *= parent.beta1;
-        v += gradient;
-
-        iterate -= (1 - parent.beta1) * parent.sgdRate * v;
+        SGDUpdate(iterate, gradient, UseFusedUpdate<MatType, GradType>());
         return;
       }
 
-      m *= parent.beta1;
-      m += (1 - parent.beta1) * gradient;
-
-      v *= parent.beta2;
-      v += (1 - parent.beta2) * (gradient % gradient);
+      // The phase may have been reset to Adam after the switch.
+      if (m.n_elem != v.n_elem)
+        m.zeros(v.n_rows, v.n_cols);
 
       const double biasCorrection1 = 1.0 - std::pow(parent.beta1,
           parent.iteration);
       const double biasCorrection2 = 1.0 - std::pow(parent.beta2,
           parent.iteration);
 
-      GradType delta = stepSize * m / biasCorrection1 /
-          (arma::sqrt(v / biasCorrection2) + parent.epsilon);
-      iterate -= delta;
+      double deltaGradient = 0.0;
+      double deltaSquared = 0.0;
+      AdamUpdate(iterate, stepSize / biasCorrection1, biasCorrection2,
+          gradient, deltaGradient, deltaSquared,
+          UseFusedUpdate<MatType, GradType>());
 
-      const double deltaGradient = arma::dot(delta, gradient);
       if (deltaGradient != 0)
       {
-        const double rate = arma::dot(delta, delta) / deltaGradient;
+        const double rate = deltaSquared / deltaGradient;
         parent.sgdLambda = parent.beta2 * parent.sgdLambda +
             (1 - parent.beta2) * rate;
         parent.sgdRate = parent.sgdLambda / biasCorrection2;
@@ -170,24 +178,141 @@ class SWATSUpdate
         if (std::abs(parent.sgdRate - rate) < parent.epsilon &&
             parent.iteration > 1)
         {
+          // Reuse the second moment estimates for the momentum of the SGD
+          // steps, and release the first moment estimates.
           parent.phaseSGD = true;
           v.zeros();
+          m.reset();
         }
       }
     }
 
+    //! Get the first moment estimates (empty after the switch to SGD).
+    const GradType& M() const { return m; }
+    //! Get the second moment estimates, or the momentum after the switch.
+    const GradType& V() const { return v; }
+
    private:
+    /**
+     * Fused Adam step for dense matrices: one pass over all the elements,
+     * which also accumulates the dot products of the Adam step `delta` with
+     * itself and with the gradient, in double precision.
+     */
+    void AdamUpdate(MatType& iterate,
+                    const double alpha,
+                    const double biasCorrection2,
+                    const GradType& gradient,
+                    double& deltaGradient,
+                    double& deltaSquared,
+                    std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType beta2 = ElemType(parent.beta2);
+      const ElemType oneMinusBeta1 = ElemType(1 - parent.beta1);
+      const ElemType oneMinusBeta2 = ElemType(1 - parent.beta2);
+      const ElemType eps = ElemType(parent.epsilon);
+      const ElemType a = ElemType(alpha);
+      const ElemType c2 = ElemType(1.0 / biasCorrection2);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* mp = m.memptr();
+      ElemType* vp = v.memptr();
+      const size_t n = iterate.n_elem;
+
+      double dg = 0.0;
+      double dd = 0.0;
+      ENS_PRAGMA_OMP_SIMD_SUM2(dg, dd)
+      for (size_t i = 0; i < n; ++i)
+      {
+        const ElemType gi = g[i];
+        const ElemType mi = beta1 * mp[i] + oneMinusBeta1 * gi;
+        const ElemType vi = beta2 * vp[i] + oneMinusBeta2 * (gi * gi);
+        const ElemType delta = a * mi / (std::sqrt(vi * c2) + eps);
+        mp[i] = mi;
+        vp[i] = vi;
+        x[i] -= delta;
+        dg += double(delta) * double(gi);
+        dd += double(delta) * double(delta);
+      }
+
+      deltaGradient = dg;
+      deltaSquared = dd;
+    }
+
+    //! Generic Adam step, for all other matrix types.
+    void AdamUpdate(MatType& iterate,
+                    const double alpha,
+                    const double biasCorrection2,
+                    const GradType& gradient,
+                    double& deltaGradient,
+                    double& deltaSquared,
+                    std::false_type /* fused */)
+    {
+      m *= parent.beta1;
+      m += (1 - parent.beta1) * gradient;
+
+      v *= parent.beta2;
+      v += (1 - parent.beta2) * (gradient % gradient);
+
+      GradType delta = alpha * m / (arma::sqrt(v / biasCorrection2) +
+          parent.epsilon);
+      iterate -= delta;
+
+      deltaGradient = arma::dot(delta, gradient);
+      deltaSquared = arma::dot(delta, delta);
+    }
+
+    //! Fused momentum SGD step for dense matrices.
+    void SGDUpdate(MatType& iterate,
+                   const GradType& gradient,
+                   std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      const ElemType beta1 = ElemType(parent.beta1);
+      const ElemType a = ElemType((1 - parent.beta1) * parent.sgdRate);
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+      ElemType* vp = v.memptr();
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+        {
+          const ElemType vi = beta1 * vp[i] + g[i];
+          vp[i] = vi;
+          x[i] -= a * vi;
+        }
+      });
+    }
+
+    //! Generic momentum SGD step, for all other matrix types.
+    void SGDUpdate(MatType& iterate,
+                   const GradType& gradient,
+                   std::false_type /* fused */)
+    {
+      // Note we reuse the exponential moving average parameter here instead
+      // of introducing a new parameter (sgdV) as done in the paper.
+      v *= parent.beta1;
+      v += gradient;
+
+      iterate -= (1 - parent.beta1) * parent.sgdRate * v;
+    }
+
     //! Reference to instantiated parent object.
     SWATSUpdate& parent;
 
-    //! The exponential moving average of gradient values.
+    //! The exponential moving average of gradient values (Adam only).
     GradType m;
 
-    //! The exponential moving average of squared gradient values (Adam).
+    //! The exponential moving average of squared gradient values (Adam), or
+    //! the momentum of the steps (SGD).
     GradType v;
-
-    //! The exponential moving average of squared gradient values (SGD).
-    GradType sgdV;
   };
 
  private:
@@ -0,0 +1,141 @@
+/**
+ * @file alias_table.hpp
+ *
+ * An alias table, to draw indices from a discrete distribution in constant
+ * time.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ALIAS_TABLE_HPP
+#define ENSMALLEN_UTILITY_ALIAS_TABLE_HPP
+
+namespace ens {
+
+/**
+ * AliasTable draws indices in [0, n) with probabilities proportional to given
+ * non-negative weights, in constant time per draw, with Walker's alias method
+ * (built in O(n) time with Vose's algorithm).  Each of the n slots of the table
+ * holds an index, its alias and the probability of keeping the index; a draw
+ * picks a slot uniformly and then the index or its alias.
+ *
+ * @code
+ * arma::vec weights("1 2 7");
+ * ens::AliasTable table(weights);
+ * ens::RandomStream rng;
+ * const size_t i = table.Sample(rng); // 2 in 70% of the draws.
+ * @endcode
+ */
+class AliasTable
+{
+ public:
+  //! Create an empty table; Reset() must be called before use.
+  AliasTable() { }
+
+  /**
+   * Create a table for the given weights.
+   *
+   * @param weights Non-negative weights, not all zero.
+   */
+  template<typename VecType>
+  explicit AliasTable(const VecType& weights) { Reset(weights); }
+
+  /**
+   * Rebuild the table for the given weights, in O(n) time; the buffers are
+   * reused if the number of weights doesn't change.
+   *
+   * @param weights Non-negative weights, not all zero.
+   */
+  template<typename VecType>
+  void Reset(const VecType& weights)
+  {
+    const size_t n = weights.n_elem;
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (!(weights[i] >= 0) || !std::isfinite((double) weights[i]))
+      {
+        throw std::invalid_argument("AliasTable::Reset(): the weights must be "
+            "finite and non-negative!");
+      }
+      sum += weights[i];
+    }
+
+    if (n == 0 || sum <= 0)
+    {
+      throw std::invalid_argument("AliasTable::Reset(): the sum of the weights "
+          "must be positive!");
+    }
+
+    probabilities.set_size(n);
+    keep.set_size(n);
+    alias.set_size(n);
+    small.clear();
+    large.clear();
+    for (size_t i = 0; i < n; ++i)
+    {
+      probabilities[i] = weights[i] / sum;
+      keep[i] = probabilities[i] * n;
+      alias[i] = i;
+      if (keep[i] < 1)
+        small.push_back(i);
+      else
+        large.push_back(i);
+    }
+
+    // Each small slot is filled up to 1 with an alias from a large slot.
+    while (!small.empty() && !large.empty())
+    {
+      const size_t s = small.back();
+      small.pop_back();
+      const size_t l = large.back();
+
+      alias[s] = l;
+      keep[l] -= 1 - keep[s];
+      if (keep[l] < 1)
+      {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+
+    // The remaining slots are full, up to rounding errors.
+    for (size_t i = 0; i < small.size(); ++i)
+      keep[small[i]] = 1;
+    for (size_t i = 0; i < large.size(); ++i)
+      keep[large[i]] = 1;
+  }
+
+  //! Get the number of indices of the table.
+  size_t Size() const { return probabilities.n_elem; }
+
+  //! Get the probability of drawing the given index.
+  double Probability(const size_t i) const { return probabilities[i]; }
+
+  /**
+   * Draw an index, in constant time.
+   *
+   * @param rng Random number stream to draw from.
+   */
+  size_t Sample(RandomStream& rng) const
+  {
+    const size_t slot = rng.Integer(probabilities.n_elem);
+    return (rng.Uniform() < keep[slot]) ? slot : alias[slot];
+  }
+
+ private:
+  //! The probability of each index.
+  arma::vec probabilities;
+  //! The probability of keeping the index of each slot.
+  arma::vec keep;
+  //! The alias of each slot.
+  arma::uvec alias;
+  //! Work lists of the construction, kept to avoid allocations.
+  std::vector<size_t> small, large;
+};
+
+} // namespace ens
+
+#endif
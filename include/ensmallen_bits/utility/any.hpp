@@ -14,8 +14,12 @@
 #ifndef ENSMALLEN_UTILITY_ANY_HPP
 #define ENSMALLEN_UTILITY_ANY_HPP
 
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+#include <string>
 #include <typeinfo>
-#include <typeindex>
+#include <utility>
 
 namespace ens {
 
@@ -24,37 +28,53 @@ namespace ens {
  * basic type checking to ensure that you cast it correctly.  If you call
  * Clean(), it will properly call the destructor on the given type.
  *
+ * Objects created with Emplace() are constructed in a small buffer inside the
+ * Any if they fit (see BufferSize), so that no memory is allocated; larger
+ * objects are allocated with new.  The type checks of As() and Has() first
+ * compare a pointer that is unique to each type within a binary, and only if
+ * that differs (e.g. for an object created in another shared library) compare
+ * the std::type_info of the types.
+ *
+ * A copy of an Any holds nothing, since the held object can't be copied
+ * without knowing its type.
+ *
  * The Any is holding nothing if Has<void>() returns true.
  */
 class Any
 {
  public:
+  //! Objects up to this size are held in the buffer of the Any.
+  static const size_t BufferSize = 4 * sizeof(void*);
+
   /**
    * Create an Any object that holds nothing.
    */
   Any() :
       held(NULL),
-      type(typeid(void)),
-      destructor([](const void*) {}) // Fake destructor.
+      tag(Tag<void>()),
+      name(&typeid(void)),
+      destructor([](void*, bool) {}) // Fake destructor.
   {
     // Nothing to do.
   }
 
+  //! A copy holds nothing.
+  Any(const Any& /* other */) : Any() { }
+
+  //! Destroy the held object, if any.
+  ~Any() { Clean(); }
+
+  //! Assignment leaves this object unchanged, since a copy holds nothing.
+  Any& operator=(const Any& /* other */) { return *this; }
+
   /**
    * Get the Any, cast as the thing we want.
    */
   template<typename T>
   const T& As() const
   {
-    if (std::type_index(typeid(T)) != type)
-    {
-      std::string error = "Invalid cast to type '";
-      error += typeid(T).name();
-      error += "' when Any is holding '";
-      error += type.name();
-      error += "'!";
-      throw std::invalid_argument(error);
-    }
+    if (!Holds<T>())
+      InvalidCast(typeid(T));
 
     return *reinterpret_cast<const T*>(held);
   }
@@ -65,62 +85,124 @@ class Any
   template<typename T>
   T& As()
   {
-    if (std::type_index(typeid(T)) != type)
-    {
-      std::string error = "Invalid cast to type '";
-      error += typeid(T).name();
-      error += "' when Any is holding '";
-      error += type.name();
-      error += "'!";
-      throw std::invalid_argument(error);
-    }
+    if (!Holds<T>())
+      InvalidCast(typeid(T));
 
     return *reinterpret_cast<T*>(held);
   }
 
   /**
-   * Set the Any as the given type.
+   * Set the Any as the given type.  The Any takes ownership of t, which must
+   * have been allocated with new.
    */
   template<typename T>
   void Set(T* t)
   {
-    type = std::type_index(typeid(T));
+    tag = Tag<T>();
+    name = &typeid(T);
+    held = (void*) t;
+    destructor = [](void* x, bool /* inBuffer */)
+    {
+      delete static_cast<T*>(x);
+    };
+  }
+
+  /**
+   * Construct an object of the given type with the given arguments, in the
+   * buffer of the Any if it fits, replacing any object that is currently held.
+   *
+   * @return The new object.
+   */
+  template<typename T, typename... Args>
+  T& Emplace(Args&&... args)
+  {
+    Clean();
+
+    const bool fits = (sizeof(T) <= BufferSize) &&
+        (alignof(T) <= alignof(std::max_align_t));
+    T* t = fits ? new (buffer) T(std::forward<Args>(args)...) :
+        new T(std::forward<Args>(args)...);
+
+    tag = Tag<T>();
+    name = &typeid(T);
     held = (void*) t;
-    destructor = [](const void* x) { delete static_cast<const T*>(x); };
+    destructor = [](void* x, bool inBuffer)
+    {
+      if (inBuffer)
+        static_cast<T*>(x)->~T();
+      else
+        delete static_cast<T*>(x);
+    };
+
+    return *t;
   }
 
   /**
    * Determine if the Any is currently holding the given type.
    */
   template<typename T>
-  bool Has()
+  bool Has() const
   {
-    return (std::type_index(typeid(T)) == type);
+    return Holds<T>();
   }
 
   /**
    * Call delete on the thing we are holding.  Be careful with this one.  It
    * automatically does nothing if 'held' is NULL, but that's the only guarantee
-   * you get.  Also, I hope you used 'new' to make the thing you're holding.
+   * you get.  Also, I hope you used 'new' (or Emplace()) to make the thing
+   * you're holding.
    */
   void Clean()
   {
     if (held)
     {
-      destructor(held);
+      destructor(held, held == (void*) buffer);
       held = NULL;
-      type = std::type_index(typeid(void));
-      destructor = [](const void*) { }; // Fake destructor.
+      tag = Tag<void>();
+      name = &typeid(void);
+      destructor = [](void*, bool) { }; // Fake destructor.
     }
   }
 
  private:
+  //! Get a pointer that is unique to the given type within a binary.
+  template<typename T>
+  static const void* Tag()
+  {
+    static const char tag = 0;
+    return &tag;
+  }
+
+  //! Return whether the held object has the given type.  The tags can differ
+  //! for the same type if the object was created in another shared library,
+  //! so then the type_info objects are compared.
+  template<typename T>
+  bool Holds() const
+  {
+    return (Tag<T>() == tag) || (*name == typeid(T));
+  }
+
+  //! Throw the error for an invalid cast.
+  void InvalidCast(const std::type_info& requested) const
+  {
+    std::string error = "Invalid cast to type '";
+    error += requested.name();
+    error += "' when Any is holding '";
+    error += name->name();
+    error += "'!";
+    throw std::invalid_argument(error);
+  }
+
   // The thing we are holding.
   void* held;
-  // The type of the thing we are holding.
-  std::type_index type;
-  // A pointer to the destructor.
-  void (*destructor)(const void*);
+  // The tag of the type of the thing we are holding.
+  const void* tag;
+  // The type of the thing we are holding, for error messages.
+  const std::type_info* name;
+  // A pointer to the destructor; the flag is true for objects in the buffer.
+  void (*destructor)(void*, bool);
+  // The buffer for objects created with Emplace().
+  alignas(std::max_align_t) unsigned char buffer[BufferSize];
 };
 
 } // namespace ens
@@ -147,6 +147,76 @@ struct IsArmaType<arma::subview_cube<eT> >
   const static bool value = true;
 };
 
+/**
+ * If value == true, then MatType is a Bandicoot (GPU) matrix, vector or
+ * subview.  Bandicoot matrices are only known to ensmallen if bandicoot is
+ * included before ensmallen (see ENS_HAVE_COOT).
+ */
+template<typename MatType>
+struct IsCootType
+{
+  const static bool value = false;
+};
+
+#ifdef ENS_HAVE_COOT
+
+template<typename eT>
+struct IsCootType<coot::Mat<eT> >
+{
+  const static bool value = true;
+};
+
+template<typename eT>
+struct IsCootType<coot::Col<eT> >
+{
+  const static bool value = true;
+};
+
+template<typename eT>
+struct IsCootType<coot::Row<eT> >
+{
+  const static bool value = true;
+};
+
+template<typename eT>
+struct IsCootType<coot::subview<eT> >
+{
+  const static bool value = true;
+};
+
+#endif
+
+template<typename eT>
+class RowSparseMat;
+
+/**
+ * If value == true, then MatType is a RowSparseMat, i.e. a gradient whose
+ * nonzero elements are in a few dense rows.
+ */
+template<typename MatType>
+struct IsRowSparseType
+{
+  const static bool value = false;
+};
+
+template<typename eT>
+struct IsRowSparseType<RowSparseMat<eT> >
+{
+  const static bool value = true;
+};
+
+/**
+ * If value == true, then MatType is an Armadillo or a Bandicoot type, or a
+ * RowSparseMat, i.e. a type that the first-order optimizers can take as
+ * coordinates or gradients.
+ */
+template<typename MatType>
+struct IsMatrixType
+{
+  const static bool value = IsArmaType<MatType>::value ||
+      IsCootType<MatType>::value || IsRowSparseType<MatType>::value;
+};
+
 
 template <int N, typename... T>
 struct tuple_element;
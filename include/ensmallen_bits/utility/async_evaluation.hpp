@@ -0,0 +1,269 @@
+/**
+ * @file async_evaluation.hpp
+ *
+ * Asynchronous evaluation of candidates, for the steady-state variants of the
+ * population-based optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ASYNC_EVALUATION_HPP
+#define ENSMALLEN_UTILITY_ASYNC_EVALUATION_HPP
+
+#include <ensmallen_bits/utility/executor.hpp>
+
+namespace ens {
+
+namespace traits {
+
+//! Detect an EvaluateAsync(coordinates) method returning a std::future of the
+//! objective.
+template<typename FunctionType, typename MatType>
+struct HasEvaluateAsync
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().EvaluateAsync(
+      std::declval<const MatType&>()).get(), std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<FunctionType>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * AsyncEvaluator runs the evaluations of candidates in the background and
+ * returns their results in the order in which they finish, so that the
+ * steady-state optimizers (e.g. DE and PSO with AsyncEvaluation()) can
+ * generate a new candidate as soon as any evaluation is done, instead of
+ * waiting for the slowest candidate of a generation.
+ *
+ * If the function has a method
+ *
+ * @code
+ * std::future<double> EvaluateAsync(const arma::mat& coordinates);
+ * @endcode
+ *
+ * (for instance, one that sends the candidate to a job queue of its own), it
+ * is used, and Concurrency() candidates are kept in flight; the futures, which
+ * hold the element type of the coordinates, are polled.  Otherwise, each
+ * candidate is copied and evaluated with Evaluate() by a task given to
+ * Executor::Submit() of the executor set with SetExecutor(), or, if none is
+ * set, by a pool of MaxThreads() threads that the evaluator owns; Evaluate()
+ * must then be safe to call concurrently.
+ *
+ * @code
+ * AsyncEvaluator<FunctionType, arma::mat> evaluator(function);
+ * for (size_t i = 0; i < evaluator.Concurrency(); ++i)
+ *   evaluator.Submit(i, candidates[i]);
+ *
+ * double objective;
+ * const size_t id = evaluator.WaitAny(objective);
+ * @endcode
+ *
+ * The destructor waits for the evaluations that are still running.
+ *
+ * @tparam FunctionType Type of the function to evaluate.
+ * @tparam MatType Type of the candidates.
+ */
+template<typename FunctionType, typename MatType>
+class AsyncEvaluator
+{
+ public:
+  typedef typename MatType::elem_type ElemType;
+
+  /**
+   * Create an evaluator for the given function.
+   *
+   * @param function Function to evaluate.
+   * @param concurrency Number of evaluations to keep in flight (0 uses the
+   *     number of threads of the executor, or MaxThreads()).
+   */
+  AsyncEvaluator(FunctionType& function, const size_t concurrency = 0) :
+      function(function),
+      executor(CurrentExecutor()),
+      concurrency(0),
+      pending(0),
+      running(0)
+  {
+    const size_t threads = (executor != NULL) ? executor->NumThreads() :
+        MaxThreads();
+    this->concurrency = std::max((size_t) 1,
+        (concurrency == 0) ? threads : concurrency);
+
+    // Without an executor, the evaluations run on a pool of their own; the
+    // pool counts the calling thread, which only waits for the results.
+    if (executor == NULL &&
+        !traits::HasEvaluateAsync<FunctionType, MatType>::value)
+    {
+      pool.reset(new ThreadPoolExecutor(this->concurrency + 1));
+      executor = pool.get();
+    }
+  }
+
+  //! The running evaluations refer to the evaluator.
+  AsyncEvaluator(const AsyncEvaluator&) = delete;
+  //! The running evaluations refer to the evaluator.
+  AsyncEvaluator& operator=(const AsyncEvaluator&) = delete;
+
+  //! Wait for the evaluations that are still running.
+  ~AsyncEvaluator()
+  {
+    for (size_t i = 0; i < futures.size(); ++i)
+      futures[i].second.wait();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return running == 0; });
+  }
+
+  //! Get the number of evaluations to keep in flight.
+  size_t Concurrency() const { return concurrency; }
+
+  //! Get the number of evaluations whose result wasn't returned yet.
+  size_t Pending() const { return pending; }
+
+  /**
+   * Start the evaluation of the given candidate; its result is returned by
+   * WaitAny() with the given identifier.  The candidate may be modified once
+   * this returns.
+   *
+   * @param id Identifier of the evaluation.
+   * @param candidate Candidate to evaluate.
+   */
+  void Submit(const size_t id, const MatType& candidate)
+  {
+    ++pending;
+    Start(id, candidate, std::integral_constant<bool,
+        traits::HasEvaluateAsync<FunctionType, MatType>::value>());
+  }
+
+  /**
+   * Wait until any of the pending evaluations is done, and return its
+   * identifier.  If the evaluation threw an exception, it is rethrown.
+   *
+   * @param objective The objective of the candidate.
+   * @return The identifier given to Submit().
+   */
+  size_t WaitAny(ElemType& objective)
+  {
+    if (pending == 0)
+    {
+      throw std::logic_error("AsyncEvaluator::WaitAny(): no evaluation is "
+          "pending.");
+    }
+
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (futures.empty())
+          finished.wait(lock, [this]() { return !results.empty(); });
+
+        if (!results.empty())
+        {
+          Result result = std::move(results.front());
+          results.pop_front();
+          --pending;
+          if (result.error)
+            std::rethrow_exception(result.error);
+
+          objective = result.objective;
+          return result.id;
+        }
+      }
+
+      // Poll the futures of EvaluateAsync(), waiting a little on the oldest.
+      for (size_t i = 0; i < futures.size(); ++i)
+      {
+        const std::chrono::microseconds wait((i == 0) ? 100 : 0);
+        if (futures[i].second.wait_for(wait) != std::future_status::ready)
+          continue;
+
+        const size_t id = futures[i].first;
+        std::future<ElemType> future = std::move(futures[i].second);
+        futures.erase(futures.begin() + i);
+        --pending;
+        objective = future.get();
+        return id;
+      }
+    }
+  }
+
+ private:
+  //! The result of an evaluation run by the executor.
+  struct Result
+  {
+    size_t id;
+    ElemType objective;
+    std::exception_ptr error;
+  };
+
+  //! Start an evaluation with the EvaluateAsync() method of the function.
+  void Start(const size_t id,
+             const MatType& candidate,
+             const std::true_type /* hasEvaluateAsync */)
+  {
+    futures.emplace_back(id, function.EvaluateAsync(candidate));
+  }
+
+  //! Start an evaluation with a task of the executor.
+  void Start(const size_t id,
+             const MatType& candidate,
+             const std::false_type /* hasEvaluateAsync */)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      ++running;
+    }
+
+    std::shared_ptr<MatType> copy = std::make_shared<MatType>(candidate);
+    executor->Submit([this, id, copy]()
+    {
+      Result result;
+      result.id = id;
+      result.objective = 0;
+      try
+      {
+        result.objective = function.Evaluate(*copy);
+      }
+      catch (...)
+      {
+        result.error = std::current_exception();
+      }
+
+      std::unique_lock<std::mutex> lock(mutex);
+      results.push_back(std::move(result));
+      --running;
+      finished.notify_all();
+    });
+  }
+
+  //! The function to evaluate.
+  FunctionType& function;
+  //! The executor that runs the evaluations.
+  Executor* executor;
+  //! The pool of the evaluations, if no executor is set.
+  std::unique_ptr<ThreadPoolExecutor> pool;
+  //! The number of evaluations to keep in flight.
+  size_t concurrency;
+  //! The number of evaluations whose result wasn't returned yet.
+  size_t pending;
+  //! The number of evaluations that the executor is running.
+  size_t running;
+  //! The results of the finished evaluations of the executor.
+  std::deque<Result> results;
+  //! The evaluations started with EvaluateAsync().
+  std::vector<std::pair<size_t, std::future<ElemType>>> futures;
+  //! The lock of the results.
+  std::mutex mutex;
+  //! Signaled when an evaluation of the executor is done.
+  std::condition_variable finished;
+};
+
+} // namespace ens
+
+#endif
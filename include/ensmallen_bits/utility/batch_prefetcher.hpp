@@ -0,0 +1,216 @@
+/**
+ * @file batch_prefetcher.hpp
+ *
+ * A utility class that calls the optional PrepareBatch() method of a separable
+ * function on a background thread, so that the construction or loading of the
+ * next batch overlaps with the computation on the current batch.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_BATCH_PREFETCHER_HPP
+#define ENSMALLEN_UTILITY_BATCH_PREFETCHER_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace ens {
+
+/**
+ * The BatchPrefetcher is used by optimizers for separable functions to give the
+ * function a chance to prepare (e.g. load or construct) a batch before it is
+ * used.  If the FunctionType has a method
+ *
+ * @code
+ * void PrepareBatch(const size_t begin, const size_t batchSize);
+ * @endcode
+ *
+ * (const or non-const), then Prefetch() will call it for the given batch on a
+ * background thread, and Wait() will block until that call has finished.  Note
+ * that this means PrepareBatch() for the next batch runs concurrently with
+ * Evaluate()/Gradient() on the current batch, so the function must be written
+ * with that in mind.
+ *
+ * If the FunctionType does not have a PrepareBatch() method, this class does
+ * nothing and no thread is created.
+ *
+ * @tparam FunctionType Type of the separable function.
+ */
+template<typename FunctionType, typename = void>
+class BatchPrefetcher
+{
+ public:
+  //! Construct the prefetcher; this does nothing.
+  BatchPrefetcher(FunctionType& /* function */) { }
+
+  //! Prepare the given batch synchronously; this does nothing.
+  void Prepare(const size_t /* begin */, const size_t /* batchSize */) { }
+
+  //! Prepare the given batch asynchronously; this does nothing.
+  void Prefetch(const size_t /* begin */, const size_t /* batchSize */) { }
+
+  //! Wait for the pending batch; this does nothing.
+  void Wait() { }
+
+  //! Prepare the given batch of the given function; this does nothing.
+  static void PrepareNow(FunctionType& /* function */,
+                         const size_t /* begin */,
+                         const size_t /* batchSize */) { }
+};
+
+//! Specialization for functions that do have a PrepareBatch() method.
+template<typename FunctionType>
+class BatchPrefetcher<FunctionType, typename std::enable_if<
+    traits::HasPrepareBatchSignature<FunctionType>::value>::type>
+{
+ public:
+  /**
+   * Construct the prefetcher and start the background thread.
+   *
+   * @param function Function whose batches will be prepared.
+   */
+  BatchPrefetcher(FunctionType& function) :
+      function(function),
+      begin(0),
+      batchSize(0),
+      pending(false),
+      stop(false),
+      worker(&BatchPrefetcher::Work, this)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Finish any pending batch, then stop the background thread.
+   */
+  ~BatchPrefetcher()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+    }
+    condition.notify_all();
+    worker.join();
+  }
+
+  /**
+   * Prepare the given batch on the calling thread, after any pending
+   * asynchronous preparation has finished.
+   *
+   * @param begin Index of the first point in the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  void Prepare(const size_t begin, const size_t batchSize)
+  {
+    Wait();
+    function.PrepareBatch(begin, batchSize);
+  }
+
+  /**
+   * Prepare the given batch of the given function on the calling thread,
+   * without a prefetcher (and so without a background thread).
+   *
+   * @param function Function whose batch will be prepared.
+   * @param begin Index of the first point in the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  static void PrepareNow(FunctionType& function,
+                         const size_t begin,
+                         const size_t batchSize)
+  {
+    function.PrepareBatch(begin, batchSize);
+  }
+
+  /**
+   * Start preparing the given batch on the background thread.  If another
+   * batch is still being prepared, this waits for it first.
+   *
+   * @param begin Index of the first point in the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  void Prefetch(const size_t begin, const size_t batchSize)
+  {
+    Wait();
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      this->begin = begin;
+      this->batchSize = batchSize;
+      pending = true;
+    }
+    condition.notify_all();
+  }
+
+  /**
+   * Block until the batch being prepared (if any) is ready.  If PrepareBatch()
+   * threw an exception on the background thread, it is rethrown here.
+   */
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [this] { return !pending; });
+
+    if (error)
+    {
+      std::exception_ptr e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+
+ private:
+  //! The loop run by the background thread.
+  void Work()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      condition.wait(lock, [this] { return pending || stop; });
+      if (!pending)
+        return;
+
+      lock.unlock();
+      try
+      {
+        function.PrepareBatch(begin, batchSize);
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+      lock.lock();
+
+      pending = false;
+      condition.notify_all();
+    }
+  }
+
+  //! The function whose batches are prepared.
+  FunctionType& function;
+  //! The index of the first point of the batch to prepare.
+  size_t begin;
+  //! The size of the batch to prepare.
+  size_t batchSize;
+  //! Whether or not a batch is waiting to be prepared or being prepared.
+  bool pending;
+  //! Whether or not the background thread should stop.
+  bool stop;
+  //! An exception thrown by PrepareBatch(), if any.
+  std::exception_ptr error;
+  //! Lock for the members above.
+  std::mutex mutex;
+  //! Signals changes of pending and stop.
+  std::condition_variable condition;
+  //! The background thread; must be declared last so that it is started after
+  //! all other members are initialized.
+  std::thread worker;
+};
+
+} // namespace ens
+
+#endif
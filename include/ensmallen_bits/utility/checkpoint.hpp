@@ -0,0 +1,287 @@
+/**
+ * @file checkpoint.hpp
+ *
+ * A simple aligned binary format to save and restore the state of optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_CHECKPOINT_HPP
+#define ENSMALLEN_UTILITY_CHECKPOINT_HPP
+
+namespace ens {
+
+/**
+ * CheckpointWriter writes values and matrices to a stream in a simple binary
+ * format.  A scalar is stored in 8 bytes (as a uint64_t or a double), and a
+ * matrix as its number of rows, columns and the size of its elements (as
+ * uint64_t), followed by its elements in column-major order, starting at an
+ * offset that is a multiple of 64 bytes.  Since the elements are stored
+ * unchanged and aligned, a checkpoint file can also be memory-mapped and the
+ * matrices used in place.  The byte order is the one of the machine that
+ * wrote the file.
+ *
+ * Classes that have state to save implement
+ *
+ * @code
+ * template<typename ArchiveType>
+ * void Serialize(ArchiveType& ar)
+ * {
+ *   ar(someMatrix);
+ *   ar(someCounter);
+ * }
+ * @endcode
+ *
+ * which is called with a CheckpointWriter to save the state, and with a
+ * CheckpointReader to restore it.
+ */
+class CheckpointWriter
+{
+ public:
+  /**
+   * Write to the given stream.
+   *
+   * @param stream The stream to write to.
+   */
+  CheckpointWriter(std::ostream& stream) : stream(stream), offset(0) { }
+
+  //! Write an integral value.
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type
+  operator()(const T& value)
+  {
+    const uint64_t stored = (uint64_t) value;
+    WriteBytes(&stored, sizeof(stored));
+  }
+
+  //! Write a floating point value.
+  template<typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type
+  operator()(const T& value)
+  {
+    const double stored = (double) value;
+    WriteBytes(&stored, sizeof(stored));
+  }
+
+  //! Write a dense matrix or vector.
+  template<typename eT>
+  void operator()(const arma::Mat<eT>& matrix)
+  {
+    (*this)(matrix.n_rows);
+    (*this)(matrix.n_cols);
+    (*this)(sizeof(eT));
+    Pad(64);
+    WriteBytes(matrix.memptr(), sizeof(eT) * matrix.n_elem);
+    Pad(8);
+  }
+
+  //! Write a sparse matrix as its values, row indices and column pointers.
+  template<typename eT>
+  void operator()(const arma::SpMat<eT>& matrix)
+  {
+    matrix.sync();
+    (*this)(matrix.n_rows);
+    (*this)(matrix.n_cols);
+    (*this)(matrix.n_nonzero);
+    (*this)(arma::Col<eT>(const_cast<eT*>(matrix.values), matrix.n_nonzero,
+        false, true));
+    (*this)(arma::uvec(const_cast<arma::uword*>(matrix.row_indices),
+        matrix.n_nonzero, false, true));
+    (*this)(arma::uvec(const_cast<arma::uword*>(matrix.col_ptrs),
+        matrix.n_cols + 1, false, true));
+  }
+
+  //! Write the given number of bytes.
+  void WriteBytes(const void* data, const size_t n)
+  {
+    stream.write(static_cast<const char*>(data), n);
+    offset += n;
+    if (!stream)
+      throw std::runtime_error("CheckpointWriter: writing failed.");
+  }
+
+ private:
+  //! Write zeros until the offset is a multiple of the given alignment.
+  void Pad(const size_t alignment)
+  {
+    static const char zeros[64] = { 0 };
+    const size_t padding = (alignment - offset % alignment) % alignment;
+    WriteBytes(zeros, padding);
+  }
+
+  //! The stream to write to.
+  std::ostream& stream;
+  //! The number of bytes written.
+  size_t offset;
+};
+
+/**
+ * CheckpointReader reads values and matrices written by a CheckpointWriter.
+ * Matrices are resized to their stored size.  A std::runtime_error is thrown
+ * if the stream ends early, or if the element size of a stored matrix is
+ * different.
+ */
+class CheckpointReader
+{
+ public:
+  /**
+   * Read from the given stream.
+   *
+   * @param stream The stream to read from.
+   */
+  CheckpointReader(std::istream& stream) : stream(stream), offset(0) { }
+
+  //! Read an integral value.
+  template<typename T>
+  typename std::enable_if<std::is_integral<T>::value>::type
+  operator()(T& value)
+  {
+    uint64_t stored;
+    ReadBytes(&stored, sizeof(stored));
+    value = (T) stored;
+  }
+
+  //! Read a floating point value.
+  template<typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type
+  operator()(T& value)
+  {
+    double stored;
+    ReadBytes(&stored, sizeof(stored));
+    value = (T) stored;
+  }
+
+  //! Read a dense matrix or vector.
+  template<typename eT>
+  void operator()(arma::Mat<eT>& matrix)
+  {
+    size_t rows, cols, elemSize;
+    (*this)(rows);
+    (*this)(cols);
+    (*this)(elemSize);
+    if (elemSize != sizeof(eT))
+    {
+      throw std::runtime_error("CheckpointReader: the stored matrix has a "
+          "different element type.");
+    }
+
+    // Vectors can't be resized to an arbitrary shape.
+    if (matrix.vec_state == 1 && cols != 1)
+      throw std::runtime_error("CheckpointReader: expected a column vector.");
+    if (matrix.vec_state == 2 && rows != 1)
+      throw std::runtime_error("CheckpointReader: expected a row vector.");
+
+    matrix.set_size(rows, cols);
+    Skip(64);
+    ReadBytes(matrix.memptr(), sizeof(eT) * matrix.n_elem);
+    Skip(8);
+  }
+
+  //! Read a sparse matrix.
+  template<typename eT>
+  void operator()(arma::SpMat<eT>& matrix)
+  {
+    size_t rows, cols, nonzero;
+    (*this)(rows);
+    (*this)(cols);
+    (*this)(nonzero);
+
+    arma::Col<eT> values;
+    arma::uvec rowIndices, colPtrs;
+    (*this)(values);
+    (*this)(rowIndices);
+    (*this)(colPtrs);
+    if (values.n_elem != nonzero || colPtrs.n_elem != cols + 1)
+      throw std::runtime_error("CheckpointReader: invalid sparse matrix.");
+
+    matrix = arma::SpMat<eT>(rowIndices, colPtrs, values, rows, cols);
+  }
+
+  //! Read the given number of bytes.
+  void ReadBytes(void* data, const size_t n)
+  {
+    stream.read(static_cast<char*>(data), n);
+    offset += n;
+    if (!stream)
+      throw std::runtime_error("CheckpointReader: unexpected end of stream.");
+  }
+
+ private:
+  //! Skip the padding up to the given alignment.
+  void Skip(const size_t alignment)
+  {
+    char padding[64];
+    ReadBytes(padding, (alignment - offset % alignment) % alignment);
+  }
+
+  //! The stream to read from.
+  std::istream& stream;
+  //! The number of bytes read.
+  size_t offset;
+};
+
+namespace traits {
+
+//! Detect a Serialize() method that accepts the given archive type.
+template<typename T, typename ArchiveType>
+struct HasSerialize
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<U&>().Serialize(
+      std::declval<ArchiveType&>()), std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<T>(0))::value;
+};
+
+} // namespace traits
+
+//! Write whether an object has state.
+inline void SerializeFlag(CheckpointWriter& ar, const bool hasState)
+{
+  ar(hasState ? 1 : 0);
+}
+
+//! Read whether an object has state, and make sure that this matches.
+inline void SerializeFlag(CheckpointReader& ar, const bool hasState)
+{
+  size_t stored;
+  ar(stored);
+  if ((stored != 0) != hasState)
+  {
+    throw std::runtime_error("SerializeState(): the stored state does not "
+        "match the type of the policy.");
+  }
+}
+
+/**
+ * Save or restore the state of the given object with its Serialize() method.
+ * A flag is stored first that records whether the object has any state, so
+ * that a mismatch between the saved and the restored type is detected.
+ *
+ * @param object The object to save or restore.
+ * @param ar The CheckpointWriter or CheckpointReader.
+ */
+template<typename T, typename ArchiveType>
+typename std::enable_if<traits::HasSerialize<T, ArchiveType>::value>::type
+SerializeState(T& object, ArchiveType& ar)
+{
+  SerializeFlag(ar, true);
+  object.Serialize(ar);
+}
+
+//! Objects without a Serialize() method have no state to save.
+template<typename T, typename ArchiveType>
+typename std::enable_if<!traits::HasSerialize<T, ArchiveType>::value>::type
+SerializeState(T& /* object */, ArchiveType& ar)
+{
+  SerializeFlag(ar, false);
+}
+
+} // namespace ens
+
+#endif
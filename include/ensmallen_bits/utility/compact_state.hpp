@@ -0,0 +1,242 @@
+/**
+ * @file compact_state.hpp
+ *
+ * Storage for the state of the fused update policies (e.g. the moment
+ * estimates of FTMLUpdate and PadamUpdate) in full precision, in bfloat16, or
+ * in 8-bit block-quantized form.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_COMPACT_STATE_HPP
+#define ENSMALLEN_UTILITY_COMPACT_STATE_HPP
+
+#include <cstdint>
+#include <cstring>
+
+namespace ens {
+
+/**
+ * A buffer of n elements of the state of an update policy, stored with the
+ * given number of bits per element:
+ *
+ *  - 0: full precision (eT);
+ *  - 16: bfloat16, i.e. the upper 16 bits of the float, rounded to nearest;
+ *  - 8: blocks of BlockSize elements, each element stored as a signed 8-bit
+ *    code q, and each block as the largest absolute value s of its elements;
+ *    the element is s * (q / 127)^3, so that small elements (e.g. second
+ *    moment estimates that are much smaller than the largest of their block)
+ *    keep about six orders of magnitude of dynamic range.
+ *
+ * The fused update kernels work one block at a time: Block() returns the
+ * decoded elements of a block, and Store() encodes them again after the
+ * update.  In full precision, Block() returns the storage itself and Store()
+ * does nothing, so there is no copy.
+ *
+ * @code
+ * eT scratch[CompactState<eT>::BlockSize];
+ * for (size_t b = 0; b < state.NumBlocks(); ++b)
+ * {
+ *   eT* s = state.Block(b, scratch);
+ *   for (size_t i = 0; i < state.BlockLength(b); ++i)
+ *     s[i] = ...;
+ *   state.Store(b, s);
+ * }
+ * @endcode
+ *
+ * @tparam eT Type of the decoded elements.
+ */
+template<typename eT>
+class CompactState
+{
+ public:
+  //! The number of elements of each block.
+  static const size_t BlockSize = 256;
+
+  /**
+   * Create an empty state, with the given number of bits per element.  A
+   * std::invalid_argument is thrown if the number of bits is not 0, 16 or 8.
+   *
+   * @param bits Number of bits per element.
+   */
+  CompactState(const size_t bits = 0) : bits(bits), n(0)
+  {
+    if (bits != 0 && bits != 16 && bits != 8)
+    {
+      throw std::invalid_argument("CompactState: the number of bits per "
+          "element must be 0 (full precision), 16 or 8.");
+    }
+  }
+
+  //! Set the state to n elements that are all zero.
+  void Zeros(const size_t elements)
+  {
+    n = elements;
+    if (bits == 0)
+      full.assign(n, eT(0));
+    else if (bits == 16)
+      half.assign(n, 0);
+    else
+    {
+      codes.assign(n, 0);
+      scales.assign(NumBlocks(), 0.0f);
+    }
+  }
+
+  //! Release the memory of the state.
+  void Reset()
+  {
+    n = 0;
+    std::vector<eT>().swap(full);
+    std::vector<uint16_t>().swap(half);
+    std::vector<int8_t>().swap(codes);
+    std::vector<float>().swap(scales);
+  }
+
+  //! Get the number of bits per element.
+  size_t Bits() const { return bits; }
+
+  //! Get the number of elements.
+  size_t NumElem() const { return n; }
+
+  //! Get the number of blocks.
+  size_t NumBlocks() const { return (n + BlockSize - 1) / BlockSize; }
+
+  //! Get the number of elements of the given block.
+  size_t BlockLength(const size_t block) const
+  {
+    return std::min(BlockSize, n - block * BlockSize);
+  }
+
+  //! Get the number of bytes used to store the elements.
+  size_t Bytes() const
+  {
+    return full.size() * sizeof(eT) + half.size() * sizeof(uint16_t) +
+        codes.size() * sizeof(int8_t) + scales.size() * sizeof(float);
+  }
+
+  /**
+   * Return the decoded elements of the given block: the storage itself in
+   * full precision, and otherwise the given scratch buffer of BlockSize
+   * elements, filled with the decoded elements.
+   *
+   * @param block Index of the block.
+   * @param scratch Buffer of BlockSize elements.
+   */
+  eT* Block(const size_t block, eT* scratch)
+  {
+    const size_t begin = block * BlockSize;
+    const size_t length = BlockLength(block);
+    if (bits == 0)
+      return full.data() + begin;
+
+    if (bits == 16)
+    {
+      const uint16_t* h = half.data() + begin;
+      for (size_t i = 0; i < length; ++i)
+        scratch[i] = eT(FromBFloat16(h[i]));
+    }
+    else
+    {
+      const int8_t* q = codes.data() + begin;
+      const eT scale = eT(scales[block]) / eT(127 * 127 * 127);
+      ENS_PRAGMA_OMP_SIMD
+      for (size_t i = 0; i < length; ++i)
+      {
+        const eT qi = eT(q[i]);
+        scratch[i] = scale * (qi * qi * qi);
+      }
+    }
+
+    return scratch;
+  }
+
+  /**
+   * Store the given decoded elements of the given block, as returned by
+   * Block() and then updated.
+   *
+   * @param block Index of the block.
+   * @param values The decoded elements of the block.
+   */
+  void Store(const size_t block, const eT* values)
+  {
+    const size_t begin = block * BlockSize;
+    const size_t length = BlockLength(block);
+    if (bits == 0)
+    {
+      if (values != full.data() + begin)
+        std::copy(values, values + length, full.data() + begin);
+      return;
+    }
+
+    if (bits == 16)
+    {
+      uint16_t* h = half.data() + begin;
+      for (size_t i = 0; i < length; ++i)
+        h[i] = ToBFloat16(float(values[i]));
+      return;
+    }
+
+    eT absMax = eT(0);
+    for (size_t i = 0; i < length; ++i)
+      absMax = std::max(absMax, std::abs(values[i]));
+
+    int8_t* q = codes.data() + begin;
+    scales[block] = float(absMax);
+    if (absMax == eT(0))
+    {
+      std::fill(q, q + length, int8_t(0));
+      return;
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+      const eT level = std::cbrt(values[i] / absMax) * eT(127);
+      q[i] = int8_t(std::lround(double(level)));
+    }
+  }
+
+ private:
+  //! Round the given float to the nearest bfloat16 (ties to even).
+  static uint16_t ToBFloat16(const float value)
+  {
+    if (value != value)
+      return 0x7FC0;
+
+    uint32_t u;
+    std::memcpy(&u, &value, sizeof(u));
+    u += 0x7FFF + ((u >> 16) & 1);
+    return uint16_t(u >> 16);
+  }
+
+  //! Convert the given bfloat16 to a float.
+  static float FromBFloat16(const uint16_t value)
+  {
+    const uint32_t u = uint32_t(value) << 16;
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+  }
+
+  //! The number of bits per element.
+  size_t bits;
+  //! The number of elements.
+  size_t n;
+  //! The elements, in full precision.
+  std::vector<eT> full;
+  //! The elements, in bfloat16.
+  std::vector<uint16_t> half;
+  //! The 8-bit codes of the elements.
+  std::vector<int8_t> codes;
+  //! The largest absolute value of each block.
+  std::vector<float> scales;
+};
+
+template<typename eT>
+const size_t CompactState<eT>::BlockSize;
+
+} // namespace ens
+
+#endif
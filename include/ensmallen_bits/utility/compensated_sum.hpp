@@ -0,0 +1,42 @@
+/**
+ * @file compensated_sum.hpp
+ *
+ * Compensated (Kahan) summation, used to accumulate the objectives of the
+ * batches of an epoch.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_COMPENSATED_SUM_HPP
+#define ENSMALLEN_UTILITY_COMPENSATED_SUM_HPP
+
+namespace ens {
+
+/**
+ * Add the given value to the given sum with Kahan's compensated summation.
+ * `compensation` holds the low-order part that was lost in the previous
+ * additions; it must start at 0, and be reset with the sum.  The error of a
+ * sum of n values then stays at about one rounding error, instead of growing
+ * with n, so that e.g. the objective of a long epoch can be compared with the
+ * tolerance.  Once the sum is not finite, it stays the same (e.g. inf stays
+ * inf, instead of becoming NaN).  This relies on strict floating-point
+ * semantics, so it has no effect if the code is compiled with -ffast-math.
+ *
+ * @param sum The sum to add to.
+ * @param compensation The compensation of the sum.
+ * @param value The value to add.
+ */
+template<typename T>
+inline void CompensatedAdd(T& sum, T& compensation, const T value)
+{
+  const T y = value - compensation;
+  const T t = sum + y;
+  compensation = std::isfinite(t) ? (t - sum) - y : T(0);
+  sum = t;
+}
+
+} // namespace ens
+
+#endif
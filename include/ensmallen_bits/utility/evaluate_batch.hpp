@@ -0,0 +1,142 @@
+/**
+ * @file evaluate_batch.hpp
+ *
+ * Utility to evaluate the objective of a whole population of candidates, using
+ * the optional EvaluateBatch() method of the function when it is available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_EVALUATE_BATCH_HPP
+#define ENSMALLEN_UTILITY_EVALUATE_BATCH_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+
+namespace ens {
+
+/**
+ * Evaluate the objective of every candidate (slice) in `candidates` and store
+ * the results in `objectives`.  If the FunctionType has a method
+ *
+ * @code
+ * void EvaluateBatch(const arma::Cube<eT>& candidates,
+ *                    arma::Col<eT>& objectives);
+ * @endcode
+ *
+ * (const or non-const), then it is called once for the whole population, with
+ * `objectives` already set to the right size.  Since the slices of a cube are
+ * stored contiguously, a population of column vector candidates can be viewed
+ * as a matrix with one candidate per column, e.g. to score all of them with a
+ * single matrix multiplication:
+ *
+ * @code
+ * const arma::mat population(const_cast<double*>(candidates.memptr()),
+ *     candidates.n_rows, candidates.n_slices, false, true);
+ * @endcode
+ *
+ * Otherwise, Evaluate() is called for each candidate.  If `parallel` is true,
+ * these calls are spread over OpenMP threads, and so Evaluate() must be safe to
+ * call concurrently.
+ *
+ * @param function Function to evaluate.
+ * @param candidates Candidates to evaluate, one per slice.
+ * @param objectives Vector to store the objectives into.
+ * @param parallel Whether or not to call Evaluate() in parallel.
+ */
+template<typename FunctionType, typename ElemType>
+typename std::enable_if<traits::HasEvaluateBatchSignature<
+    FunctionType, arma::Mat<ElemType>>::value, void>::type
+EvaluateBatch(FunctionType& function,
+              const arma::Cube<ElemType>& candidates,
+              arma::Col<ElemType>& objectives,
+              const bool /* parallel */ = false)
+{
+  objectives.set_size(candidates.n_slices);
+  function.EvaluateBatch(candidates, objectives);
+}
+
+//! Evaluate each candidate (slice) separately.
+template<typename FunctionType, typename ElemType>
+typename std::enable_if<!traits::HasEvaluateBatchSignature<
+    FunctionType, arma::Mat<ElemType>>::value, void>::type
+EvaluateBatch(FunctionType& function,
+              const arma::Cube<ElemType>& candidates,
+              arma::Col<ElemType>& objectives,
+              const bool parallel = false)
+{
+  objectives.set_size(candidates.n_slices);
+  if (parallel)
+  {
+    ParallelFor(candidates.n_slices, [&](const size_t i)
+    {
+      objectives(i) = function.Evaluate(candidates.slice(i));
+    });
+  }
+  else
+  {
+    for (size_t i = 0; i < candidates.n_slices; ++i)
+      objectives(i) = function.Evaluate(candidates.slice(i));
+  }
+}
+
+/**
+ * Evaluate the objective of every candidate in `candidates` and store the
+ * results in `objectives`.  If the FunctionType has an EvaluateBatch() method
+ * (see above), the candidates are copied into a cube, one per slice, and it is
+ * called once.  Otherwise Evaluate() is called for each candidate, in parallel
+ * if `parallel` is true.
+ *
+ * @param function Function to evaluate.
+ * @param candidates Candidates to evaluate.
+ * @param objectives Vector to store the objectives into.
+ * @param parallel Whether or not to call Evaluate() in parallel.
+ */
+template<typename FunctionType, typename MatType>
+typename std::enable_if<traits::HasEvaluateBatchSignature<
+    FunctionType, MatType>::value, void>::type
+EvaluateBatch(FunctionType& function,
+              const std::vector<MatType>& candidates,
+              arma::Col<typename MatType::elem_type>& objectives,
+              const bool /* parallel */ = false)
+{
+  objectives.set_size(candidates.size());
+  if (candidates.empty())
+    return;
+
+  arma::Cube<typename MatType::elem_type> packed(candidates[0].n_rows,
+      candidates[0].n_cols, candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i)
+    packed.slice(i) = candidates[i];
+
+  function.EvaluateBatch(packed, objectives);
+}
+
+//! Evaluate each candidate separately.
+template<typename FunctionType, typename MatType>
+typename std::enable_if<!traits::HasEvaluateBatchSignature<
+    FunctionType, MatType>::value, void>::type
+EvaluateBatch(FunctionType& function,
+              const std::vector<MatType>& candidates,
+              arma::Col<typename MatType::elem_type>& objectives,
+              const bool parallel = false)
+{
+  objectives.set_size(candidates.size());
+  if (parallel)
+  {
+    ParallelFor(candidates.size(), [&](const size_t i)
+    {
+      objectives(i) = function.Evaluate(candidates[i]);
+    });
+  }
+  else
+  {
+    for (size_t i = 0; i < candidates.size(); ++i)
+      objectives(i) = function.Evaluate(candidates[i]);
+  }
+}
+
+} // namespace ens
+
+#endif
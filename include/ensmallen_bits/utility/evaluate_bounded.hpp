@@ -0,0 +1,212 @@
+/**
+ * @file evaluate_bounded.hpp
+ *
+ * Utilities to evaluate the objective of a candidate that only has to be
+ * compared with a bound, using the optional EvaluateBounded() method of the
+ * function when it is available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_EVALUATE_BOUNDED_HPP
+#define ENSMALLEN_UTILITY_EVALUATE_BOUNDED_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+#include "evaluate_batch.hpp"
+#include <queue>
+
+namespace ens {
+
+/**
+ * Return the objective of the given candidate if it is at most `bound`, or any
+ * value above `bound` otherwise.  If the FunctionType has a method
+ *
+ * @code
+ * eT EvaluateBounded(const MatType& coordinates, const eT bound);
+ * @endcode
+ *
+ * (const or non-const), then it is used, so the evaluation can stop as soon as
+ * the objective is known to exceed the bound (see EvaluateSeparableBounded()).
+ * Otherwise, Evaluate() is called.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Candidate to evaluate.
+ * @param bound The largest objective whose exact value is needed.
+ * @return The objective, or a value above the bound.
+ */
+template<typename FunctionType, typename MatType>
+typename std::enable_if<traits::HasEvaluateBoundedSignature<
+    FunctionType, MatType>::value, typename MatType::elem_type>::type
+EvaluateBounded(FunctionType& function,
+                const MatType& coordinates,
+                const typename MatType::elem_type bound)
+{
+  return function.EvaluateBounded(coordinates, bound);
+}
+
+//! Evaluate the whole objective.
+template<typename FunctionType, typename MatType>
+typename std::enable_if<!traits::HasEvaluateBoundedSignature<
+    FunctionType, MatType>::value, typename MatType::elem_type>::type
+EvaluateBounded(FunctionType& function,
+                const MatType& coordinates,
+                const typename MatType::elem_type /* bound */)
+{
+  return function.Evaluate(coordinates);
+}
+
+/**
+ * Sum the objectives of the batches of `batchSize` functions of a separable
+ * function, and stop as soon as the partial sum exceeds `bound`.  This is only
+ * correct if the objective of every batch is nonnegative (e.g. a loss plus a
+ * share of a regularization), so that the partial sums never decrease; it can
+ * then be used to implement EvaluateBounded():
+ *
+ * @code
+ * double EvaluateBounded(const arma::mat& x, const double bound)
+ * {
+ *   return ens::EvaluateSeparableBounded(*this, x, bound, 256);
+ * }
+ * @endcode
+ *
+ * @param function Separable function to evaluate.
+ * @param coordinates Candidate to evaluate.
+ * @param bound The largest objective whose exact value is needed.
+ * @param batchSize Number of functions to evaluate between two comparisons
+ *     with the bound.
+ * @return The objective, or a partial sum above the bound.
+ */
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type EvaluateSeparableBounded(
+    FunctionType& function,
+    const MatType& coordinates,
+    const typename MatType::elem_type bound,
+    const size_t batchSize)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  const size_t numFunctions = function.NumFunctions();
+  const size_t step = std::max(batchSize, (size_t) 1);
+  ElemType objective = 0;
+  for (size_t i = 0; i < numFunctions; i += step)
+  {
+    objective += function.Evaluate(coordinates, i,
+        std::min(step, numFunctions - i));
+    if (objective > bound)
+      break;
+  }
+
+  return objective;
+}
+
+/**
+ * SelectionBound keeps the `count` best objectives added so far, for a
+ * selection that only needs the exact objectives of its `count` best
+ * candidates: once `count` objectives were added, any candidate whose
+ * objective exceeds the `count`'th best of them can't be selected, so Bound()
+ * can be passed to EvaluateBounded() for the next candidate.
+ *
+ * @tparam eT Type of the objectives.
+ */
+template<typename eT>
+class SelectionBound
+{
+ public:
+  /**
+   * Create the bound of a selection of the given number of candidates.
+   *
+   * @param count Number of candidates to select.
+   */
+  explicit SelectionBound(const size_t count) : count(count) { }
+
+  //! Add the objective of a candidate.
+  void Add(const eT objective)
+  {
+    if (best.size() < count)
+    {
+      best.push(objective);
+    }
+    else if (count > 0 && objective < best.top())
+    {
+      best.pop();
+      best.push(objective);
+    }
+  }
+
+  //! Get the bound: the count'th best objective so far, or the largest value
+  //! of eT if fewer objectives were added.
+  eT Bound() const
+  {
+    return (count > 0 && best.size() == count) ? best.top() :
+        std::numeric_limits<eT>::max();
+  }
+
+ private:
+  //! The number of candidates to select.
+  size_t count;
+  //! The count best objectives so far, with the largest on top.
+  std::priority_queue<eT> best;
+};
+
+/**
+ * Evaluate every candidate in `candidates`, of which only the `count` best are
+ * selected, and store the objectives in `objectives`.  If the FunctionType has
+ * an EvaluateBounded() method (and neither an EvaluateBatch() method nor
+ * `parallel` is used), the candidates are evaluated one after the other, each
+ * with the bound of the `count`'th best objective so far (see SelectionBound),
+ * so that the objectives of the candidates that can't be selected may only be
+ * partial sums above that bound.  The `count` best candidates are the same as
+ * with EvaluateBatch(), and have exact objectives.  Otherwise, EvaluateBatch()
+ * is used.
+ *
+ * @param function Function to evaluate.
+ * @param candidates Candidates to evaluate.
+ * @param objectives Vector to store the objectives into.
+ * @param count Number of candidates that are selected.
+ * @param parallel Whether or not to call Evaluate() in parallel.
+ */
+template<typename FunctionType, typename MatType>
+typename std::enable_if<traits::HasEvaluateBoundedSignature<
+    FunctionType, MatType>::value, void>::type
+EvaluateSelection(FunctionType& function,
+                  const std::vector<MatType>& candidates,
+                  arma::Col<typename MatType::elem_type>& objectives,
+                  const size_t count,
+                  const bool parallel = false)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (parallel ||
+      traits::HasEvaluateBatchSignature<FunctionType, MatType>::value)
+  {
+    EvaluateBatch(function, candidates, objectives, parallel);
+    return;
+  }
+
+  objectives.set_size(candidates.size());
+  SelectionBound<ElemType> bound(count);
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    objectives(i) = function.EvaluateBounded(candidates[i], bound.Bound());
+    bound.Add(objectives(i));
+  }
+}
+
+//! Evaluate every candidate with EvaluateBatch().
+template<typename FunctionType, typename MatType>
+typename std::enable_if<!traits::HasEvaluateBoundedSignature<
+    FunctionType, MatType>::value, void>::type
+EvaluateSelection(FunctionType& function,
+                  const std::vector<MatType>& candidates,
+                  arma::Col<typename MatType::elem_type>& objectives,
+                  const size_t /* count */,
+                  const bool parallel = false)
+{
+  EvaluateBatch(function, candidates, objectives, parallel);
+}
+
+} // namespace ens
+
+#endif
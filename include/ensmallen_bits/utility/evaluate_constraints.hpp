@@ -0,0 +1,150 @@
+/**
+ * @file evaluate_constraints.hpp
+ *
+ * Utilities to evaluate all constraints of a constrained function, and the
+ * weighted sum of their gradients, using the optional EvaluateConstraints() and
+ * GradientConstraints() methods of the function when they are available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_EVALUATE_CONSTRAINTS_HPP
+#define ENSMALLEN_UTILITY_EVALUATE_CONSTRAINTS_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+#include <ensmallen_bits/utility/parallel_batch.hpp>
+
+namespace ens {
+
+/**
+ * Evaluate every constraint of `function` at `coordinates` and store the
+ * results in `constraints`.  If the FunctionType has a method
+ *
+ * @code
+ * void EvaluateConstraints(const MatType& coordinates,
+ *                          arma::Col<eT>& constraints);
+ * @endcode
+ *
+ * (const or non-const), then it is called once, with `constraints` already set
+ * to NumConstraints() elements.  Otherwise EvaluateConstraint() is called for
+ * each constraint.  If `parallel` is true, these calls are spread over threads
+ * with ParallelFor(), and so EvaluateConstraint() must be safe to call
+ * concurrently.
+ *
+ * @param function Constrained function to evaluate.
+ * @param coordinates Coordinates to evaluate the constraints at.
+ * @param constraints Vector to store the constraint values into.
+ * @param parallel Whether or not to call EvaluateConstraint() in parallel.
+ */
+template<typename FunctionType, typename MatType>
+typename std::enable_if<traits::HasEvaluateConstraintsSignature<
+    FunctionType, MatType>::value, void>::type
+EvaluateConstraints(FunctionType& function,
+                    const MatType& coordinates,
+                    arma::Col<typename MatType::elem_type>& constraints,
+                    const bool /* parallel */ = false)
+{
+  constraints.set_size(function.NumConstraints());
+  function.EvaluateConstraints(coordinates, constraints);
+}
+
+//! Evaluate each constraint separately.
+template<typename FunctionType, typename MatType>
+typename std::enable_if<!traits::HasEvaluateConstraintsSignature<
+    FunctionType, MatType>::value, void>::type
+EvaluateConstraints(FunctionType& function,
+                    const MatType& coordinates,
+                    arma::Col<typename MatType::elem_type>& constraints,
+                    const bool parallel = false)
+{
+  const size_t numConstraints = function.NumConstraints();
+  constraints.set_size(numConstraints);
+  ParallelFor(numConstraints, [&](const size_t i)
+  {
+    constraints[i] = function.EvaluateConstraint(i, coordinates);
+  }, parallel);
+}
+
+/**
+ * Store the weighted sum of the gradients of all constraints of `function`,
+ * sum_i weights[i] * c'_i(coordinates), in `gradient`.  If the FunctionType
+ * has a method
+ *
+ * @code
+ * void GradientConstraints(const MatType& coordinates,
+ *                          const arma::Col<eT>& weights,
+ *                          GradType& gradient);
+ * @endcode
+ *
+ * (const or non-const), then it is called once.  Otherwise
+ * GradientConstraint() is called for each constraint with a nonzero weight.
+ * If `parallel` is true, the constraints are split into one range per thread,
+ * and the sums of the ranges are combined with ParallelReduce();
+ * GradientConstraint() must then be safe to call concurrently.
+ *
+ * @param function Constrained function to evaluate.
+ * @param coordinates Coordinates to evaluate the gradients at.
+ * @param weights Weight of each constraint.
+ * @param gradient Matrix to store the weighted sum of the gradients into.
+ * @param parallel Whether or not to call GradientConstraint() in parallel.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<traits::HasGradientConstraintsSignature<
+    FunctionType, MatType, GradType>::value, void>::type
+GradientConstraints(FunctionType& function,
+                    const MatType& coordinates,
+                    const arma::Col<typename MatType::elem_type>& weights,
+                    GradType& gradient,
+                    const bool /* parallel */ = false)
+{
+  function.GradientConstraints(coordinates, weights, gradient);
+}
+
+//! Sum the gradient of each constraint separately.
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<!traits::HasGradientConstraintsSignature<
+    FunctionType, MatType, GradType>::value, void>::type
+GradientConstraints(FunctionType& function,
+                    const MatType& coordinates,
+                    const arma::Col<typename MatType::elem_type>& weights,
+                    GradType& gradient,
+                    const bool parallel = false)
+{
+  const size_t numConstraints = function.NumConstraints();
+  const size_t rangeSize = parallel ? RangeSize(numConstraints) :
+      std::max(numConstraints, (size_t) 1);
+
+  // Each range of constraints is summed into its own matrix, and the sums are
+  // then added in order.
+  GradType zero;
+  zero.zeros(coordinates.n_rows, coordinates.n_cols);
+  gradient = ParallelReduce(NumRanges(numConstraints, rangeSize), zero,
+      [&](const size_t r) -> GradType
+      {
+        const size_t begin = r * rangeSize;
+        const size_t end = std::min(begin + rangeSize, numConstraints);
+
+        GradType sum = zero;
+        GradType constraintGradient;
+        for (size_t i = begin; i < end; ++i)
+        {
+          if (weights[i] == 0)
+            continue;
+
+          function.GradientConstraint(i, coordinates, constraintGradient);
+          sum += weights[i] * constraintGradient;
+        }
+        return sum;
+      },
+      [](GradType sum, const GradType& rangeSum) -> GradType
+      {
+        sum += rangeSum;
+        return sum;
+      }, parallel);
+}
+
+} // namespace ens
+
+#endif
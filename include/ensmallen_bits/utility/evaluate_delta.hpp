@@ -0,0 +1,81 @@
+/**
+ * @file evaluate_delta.hpp
+ *
+ * Utility to update the objective after a change of a single coordinate, using
+ * the optional EvaluateDelta() method of the function when it is available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_EVALUATE_DELTA_HPP
+#define ENSMALLEN_UTILITY_EVALUATE_DELTA_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+#include "evaluate_bounded.hpp"
+
+namespace ens {
+
+/**
+ * Set coordinate `index` of the iterate to `newValue`, and return the objective
+ * at the new iterate, given the objective at the old one.  If the FunctionType
+ * has a method
+ *
+ * @code
+ * eT EvaluateDelta(const MatType& iterate,
+ *                  const size_t index,
+ *                  const eT newValue);
+ * @endcode
+ *
+ * (const or non-const), which returns f(x') - f(x) where x is the given iterate
+ * and x' is x with x(index) = newValue, then that method is used and the
+ * objective is updated incrementally.  Otherwise, the new iterate is evaluated
+ * with EvaluateBounded() (see evaluate_bounded.hpp), so if the objective at the
+ * new iterate is above `bound`, only a value above `bound` may be returned.
+ *
+ * @param function Function to evaluate.
+ * @param iterate Iterate to change.
+ * @param index Index of the coordinate to change.
+ * @param newValue New value of the coordinate.
+ * @param objective Objective at the old iterate.
+ * @param bound The largest objective at the new iterate whose exact value is
+ *     needed.
+ * @return Objective at the new iterate.
+ */
+template<typename FunctionType, typename MatType>
+typename std::enable_if<traits::HasEvaluateDeltaSignature<
+    FunctionType, MatType>::value, typename MatType::elem_type>::type
+EvaluateMove(FunctionType& function,
+             MatType& iterate,
+             const size_t index,
+             const typename MatType::elem_type newValue,
+             const typename MatType::elem_type objective,
+             const typename MatType::elem_type /* bound */ =
+                 std::numeric_limits<typename MatType::elem_type>::max())
+{
+  const typename MatType::elem_type delta =
+      function.EvaluateDelta(iterate, index, newValue);
+  iterate(index) = newValue;
+  return objective + delta;
+}
+
+//! Change the coordinate and evaluate the whole function.
+template<typename FunctionType, typename MatType>
+typename std::enable_if<!traits::HasEvaluateDeltaSignature<
+    FunctionType, MatType>::value, typename MatType::elem_type>::type
+EvaluateMove(FunctionType& function,
+             MatType& iterate,
+             const size_t index,
+             const typename MatType::elem_type newValue,
+             const typename MatType::elem_type /* objective */,
+             const typename MatType::elem_type bound =
+                 std::numeric_limits<typename MatType::elem_type>::max())
+{
+  iterate(index) = newValue;
+  return EvaluateBounded(function, iterate, bound);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,472 @@
+/**
+ * @file executor.hpp
+ *
+ * The executors that run the parallel loops of ensmallen: OpenMP (the
+ * default), a pool of std::threads, TBB, or any thread pool of the caller.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_EXECUTOR_HPP
+#define ENSMALLEN_UTILITY_EXECUTOR_HPP
+
+#include <ensmallen_bits/utility/timeline.hpp>
+
+namespace ens {
+
+/**
+ * An Executor runs the parallel loops of ensmallen.  By default, no executor is
+ * set and the loops use OpenMP; if the process already has a thread pool, an
+ * executor that forwards to it can be set with SetExecutor(), so that ensmallen
+ * doesn't start a (possibly nested) OpenMP team of its own.  An executor
+ * implements
+ *
+ * @code
+ * size_t NumThreads() const;
+ * void ParallelFor(const size_t n, const std::function<void(size_t)>& task);
+ * @endcode
+ *
+ * where ParallelFor() calls task(i) for every i in [0, n), in any order and on
+ * any threads, and returns once all calls are done.  Each task may itself run
+ * parallel loops, so a pool must not block its workers waiting for nested
+ * tasks.  ParallelFor() may throw the first exception thrown by a task.
+ *
+ * Submit() runs a single task asynchronously; by default, it runs the task
+ * before returning.
+ */
+class Executor
+{
+ public:
+  //! Nothing to clean.
+  virtual ~Executor() { }
+
+  //! Return the number of tasks that run concurrently.
+  virtual size_t NumThreads() const = 0;
+
+  //! Call task(i) for each i in [0, n), and wait until all calls are done.
+  virtual void ParallelFor(const size_t n,
+                           const std::function<void(size_t)>& task) = 0;
+
+  //! Run the given task, possibly asynchronously.
+  virtual std::future<void> Submit(std::function<void()> task)
+  {
+    std::packaged_task<void()> packagedTask(std::move(task));
+    std::future<void> future = packagedTask.get_future();
+    packagedTask();
+    return future;
+  }
+};
+
+/**
+ * SerialExecutor runs every loop on the calling thread.
+ */
+class SerialExecutor : public Executor
+{
+ public:
+  //! Only the calling thread is used.
+  size_t NumThreads() const { return 1; }
+
+  //! Call the tasks in order.
+  void ParallelFor(const size_t n, const std::function<void(size_t)>& task)
+  {
+    for (size_t i = 0; i < n; ++i)
+      task(i);
+  }
+};
+
+/**
+ * OpenMPExecutor runs each loop on an OpenMP team; this is what ensmallen does
+ * when no executor is set.  Without OpenMP, the loops are serial.
+ */
+class OpenMPExecutor : public Executor
+{
+ public:
+  //! Return the maximum number of OpenMP threads.
+  size_t NumThreads() const
+  {
+    #ifdef ENS_USE_OPENMP
+      return (size_t) omp_get_max_threads();
+    #else
+      return 1;
+    #endif
+  }
+
+  //! Call the tasks on an OpenMP team.
+  void ParallelFor(const size_t n, const std::function<void(size_t)>& task)
+  {
+    // Exceptions can't leave the parallel region.
+    std::exception_ptr error;
+    ENS_PRAGMA_OMP_PARALLEL_FOR
+    for (omp_size_t i = 0; i < (omp_size_t) n; ++i)
+    {
+      try
+      {
+        task((size_t) i);
+      }
+      catch (...)
+      {
+        ENS_PRAGMA_OMP_CRITICAL
+        {
+          if (!error)
+            error = std::current_exception();
+        }
+      }
+    }
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+};
+
+/**
+ * ThreadPoolExecutor keeps a pool of std::threads, which wait for tasks.  A
+ * loop is split into one range of iterations per thread; the calling thread
+ * runs one of the ranges, and while it waits for the others it runs queued
+ * tasks, so loops can be nested without deadlocks.
+ */
+class ThreadPoolExecutor : public Executor
+{
+ public:
+  /**
+   * Start the pool.
+   *
+   * @param numThreads Number of threads, including the calling thread (0 uses
+   *     the number of hardware threads).
+   */
+  ThreadPoolExecutor(const size_t numThreads = 0) :
+      numThreads(numThreads == 0 ?
+          std::max((size_t) std::thread::hardware_concurrency(), (size_t) 1) :
+          numThreads),
+      stop(false)
+  {
+    for (size_t i = 1; i < this->numThreads; ++i)
+      workers.emplace_back([this]() { Work(); });
+  }
+
+  //! The running threads can't be copied.
+  ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+  //! The running threads can't be copied.
+  ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+  //! Finish the queued tasks and stop the threads.
+  ~ThreadPoolExecutor()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+    }
+    available.notify_all();
+    for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+  }
+
+  //! Return the number of threads, including the calling thread.
+  size_t NumThreads() const { return numThreads; }
+
+  //! Run one range of iterations per thread.
+  void ParallelFor(const size_t n, const std::function<void(size_t)>& task)
+  {
+    const size_t numRanges = std::min(numThreads, n);
+    if (numRanges <= 1)
+    {
+      for (size_t i = 0; i < n; ++i)
+        task(i);
+      return;
+    }
+
+    const size_t rangeSize = (n + numRanges - 1) / numRanges;
+    std::atomic<size_t> remaining(numRanges);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto runRange = [&](const size_t r)
+    {
+      try
+      {
+        const size_t end = std::min((r + 1) * rangeSize, n);
+        for (size_t i = r * rangeSize; i < end; ++i)
+          task(i);
+      }
+      catch (...)
+      {
+        std::unique_lock<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+      }
+
+      // Once the counter reaches zero the caller may return, so nothing on
+      // its stack can be used after the decrement.
+      std::mutex& poolMutex = mutex;
+      std::condition_variable& poolAvailable = available;
+      if (--remaining == 0)
+      {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        poolAvailable.notify_all();
+      }
+    };
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      for (size_t r = 1; r < numRanges; ++r)
+        tasks.push_back([&runRange, r]() { runRange(r); });
+    }
+    available.notify_all();
+
+    runRange(0);
+    WaitFor(remaining);
+
+    if (error)
+      std::rethrow_exception(error);
+  }
+
+  //! Queue the given task; it is run by one of the threads of the pool.
+  std::future<void> Submit(std::function<void()> task)
+  {
+    std::shared_ptr<std::packaged_task<void()>> packagedTask =
+        std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> future = packagedTask->get_future();
+    if (workers.empty())
+    {
+      (*packagedTask)();
+      return future;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      tasks.push_back([packagedTask]() { (*packagedTask)(); });
+    }
+    available.notify_one();
+    return future;
+  }
+
+ private:
+  //! Run queued tasks until the pool is stopped.
+  void Work()
+  {
+    while (true)
+    {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this]() { return stop || !tasks.empty(); });
+        if (tasks.empty())
+          return;
+
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+
+      task();
+    }
+  }
+
+  //! Run queued tasks until the counter reaches zero.
+  void WaitFor(const std::atomic<size_t>& remaining)
+  {
+    while (remaining > 0)
+    {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this, &remaining]()
+            { return remaining == 0 || !tasks.empty(); });
+        if (remaining == 0)
+          return;
+
+        task = std::move(tasks.front());
+        tasks.pop_front();
+      }
+
+      task();
+    }
+  }
+
+  //! The number of threads, including the calling thread.
+  size_t numThreads;
+  //! The threads of the pool.
+  std::vector<std::thread> workers;
+  //! The queued tasks.
+  std::deque<std::function<void()>> tasks;
+  //! The lock of the queue.
+  std::mutex mutex;
+  //! Signaled when a task is queued or a loop is done.
+  std::condition_variable available;
+  //! Whether the threads should stop.
+  bool stop;
+};
+
+#if defined(ENS_USE_TBB)
+
+/**
+ * TBBExecutor runs each loop with tbb::parallel_for, in the current task
+ * arena, and submits tasks to a tbb::task_group.  It is only available if
+ * ENS_USE_TBB is defined before including ensmallen.
+ */
+class TBBExecutor : public Executor
+{
+ public:
+  //! Finish the submitted tasks.
+  ~TBBExecutor() { group.wait(); }
+
+  //! Return the concurrency of the current task arena.
+  size_t NumThreads() const
+  {
+    return (size_t) tbb::this_task_arena::max_concurrency();
+  }
+
+  //! Call the tasks with tbb::parallel_for.
+  void ParallelFor(const size_t n, const std::function<void(size_t)>& task)
+  {
+    tbb::parallel_for((size_t) 0, n, [&task](const size_t i) { task(i); });
+  }
+
+  //! Run the given task in the task group.
+  std::future<void> Submit(std::function<void()> task)
+  {
+    std::shared_ptr<std::packaged_task<void()>> packagedTask =
+        std::make_shared<std::packaged_task<void()>>(std::move(task));
+    std::future<void> future = packagedTask->get_future();
+    group.run([packagedTask]() { (*packagedTask)(); });
+    return future;
+  }
+
+ private:
+  //! The group of the submitted tasks.
+  tbb::task_group group;
+};
+
+#endif
+
+//! Return the storage of the executor set with SetExecutor().
+inline std::shared_ptr<Executor>& ExecutorStorage()
+{
+  static std::shared_ptr<Executor> executor;
+  return executor;
+}
+
+/**
+ * Set the executor that runs the parallel loops of ensmallen (nullptr restores
+ * the default, OpenMP).  This must not be called while an optimization runs.
+ *
+ * @code
+ * ens::SetExecutor(std::make_shared<ens::ThreadPoolExecutor>(8));
+ * @endcode
+ *
+ * @param executor The executor to use.
+ */
+inline void SetExecutor(std::shared_ptr<Executor> executor)
+{
+  ExecutorStorage() = std::move(executor);
+}
+
+//! Return the executor set with SetExecutor(), or nullptr if OpenMP is used.
+inline Executor* CurrentExecutor() { return ExecutorStorage().get(); }
+
+/**
+ * Call task(i) for each i in [0, n), in parallel if `parallel` is true, with
+ * the executor set with SetExecutor() or else with OpenMP.  Exceptions thrown
+ * by the tasks are rethrown (only the first one, if several tasks throw).
+ * With ENS_TIMELINE, each parallel task is recorded into the timeline (see
+ * Timeline).
+ *
+ * @param n Number of iterations.
+ * @param task Task to call for each iteration.
+ * @param parallel Whether or not to run the iterations in parallel.
+ */
+template<typename TaskType>
+inline void ParallelFor(const size_t n,
+                        TaskType&& task,
+                        const bool parallel = true)
+{
+  if (!parallel || n <= 1)
+  {
+    for (size_t i = 0; i < n; ++i)
+      task(i);
+    return;
+  }
+
+  // Each parallel task is an interval of the timeline.
+  auto run = [&task](const size_t i)
+  {
+    ENS_TIMELINE_SCOPE("parallel task");
+    task(i);
+  };
+
+  Executor* executor = CurrentExecutor();
+  if (executor != NULL)
+  {
+    executor->ParallelFor(n, std::function<void(size_t)>(std::ref(run)));
+    return;
+  }
+
+  std::exception_ptr error;
+  ENS_PRAGMA_OMP_PARALLEL_FOR
+  for (omp_size_t i = 0; i < (omp_size_t) n; ++i)
+  {
+    try
+    {
+      run((size_t) i);
+    }
+    catch (...)
+    {
+      ENS_PRAGMA_OMP_CRITICAL
+      {
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  }
+
+  if (error)
+    std::rethrow_exception(error);
+}
+
+/**
+ * Compute map(i) for each i in [0, n) in parallel, and combine the results
+ * with reduce() in the order of i, starting from init; the result is thus the
+ * same for any number of threads.
+ *
+ * @param n Number of iterations.
+ * @param init Initial value of the reduction.
+ * @param map Function computing the value of an iteration.
+ * @param reduce Function combining two values.
+ * @param parallel Whether or not to run the iterations in parallel.
+ * @return The reduction of all values.
+ */
+template<typename T, typename MapType, typename ReduceType>
+inline T ParallelReduce(const size_t n,
+                        T init,
+                        MapType&& map,
+                        ReduceType&& reduce,
+                        const bool parallel = true)
+{
+  std::vector<T> values(n);
+  ParallelFor(n, [&](const size_t i) { values[i] = map(i); }, parallel);
+
+  for (size_t i = 0; i < n; ++i)
+    init = reduce(init, values[i]);
+  return init;
+}
+
+/**
+ * Return the number of threads that parallel loops will use: the number of
+ * threads of the executor set with SetExecutor(), or else the maximum number of
+ * OpenMP threads (1 if OpenMP is not enabled).
+ */
+inline size_t MaxThreads()
+{
+  Executor* executor = CurrentExecutor();
+  if (executor != NULL)
+    return executor->NumThreads();
+
+  #ifdef ENS_USE_OPENMP
+    return (size_t) omp_get_max_threads();
+  #else
+    return 1;
+  #endif
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,298 @@
+/**
+ * @file fused_update.hpp
+ *
+ * Utilities for the fused, single-pass implementations of the update policies.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_FUSED_UPDATE_HPP
+#define ENSMALLEN_UTILITY_FUSED_UPDATE_HPP
+
+#include <ensmallen_bits/utility/executor.hpp>
+
+namespace ens {
+
+/**
+ * Many update policies (e.g. AdamUpdate) provide a fused implementation for
+ * dense matrices that reads and writes each element of the iterate, the
+ * gradient and the policy state exactly once, in a simple loop over the raw
+ * memory that the compiler can vectorize.  This avoids the multiple passes and
+ * temporaries of the equivalent Armadillo expressions, which matters when the
+ * update step is memory-bandwidth bound.  For any other matrix type (sparse
+ * matrices, for instance), the policies fall back to the Armadillo expressions.
+ *
+ * UseFusedUpdate<MatType, GradType> is std::true_type if the fused
+ * implementation can be used for the given types, and std::false_type
+ * otherwise, so it can be used directly for tag dispatch:
+ *
+ * @code
+ * Update(iterate, gradient, UseFusedUpdate<MatType, GradType>());
+ * @endcode
+ */
+template<typename MatType, typename GradType>
+struct UseFusedUpdate : public std::integral_constant<bool,
+    std::is_floating_point<typename MatType::elem_type>::value &&
+    std::is_base_of<arma::Mat<typename MatType::elem_type>, MatType>::value &&
+    std::is_base_of<arma::Mat<typename MatType::elem_type>, GradType>::value>
+{ };
+
+/**
+ * Some update policies (e.g. AdaGradUpdate) also provide an implementation for
+ * sparse gradients of dense iterates that only visits the nonzero elements of
+ * the gradient, and keeps its state in dense matrices so that each of these
+ * visits takes constant time.  The gradient is either an arma::SpMat or a
+ * RowSparseMat.
+ *
+ * UseSparseUpdate<MatType, GradType> is std::true_type if that implementation
+ * can be used for the given types, and std::false_type otherwise.
+ */
+template<typename MatType, typename GradType>
+struct UseSparseUpdate : public std::integral_constant<bool,
+    std::is_floating_point<typename MatType::elem_type>::value &&
+    std::is_base_of<arma::Mat<typename MatType::elem_type>, MatType>::value &&
+    (std::is_base_of<arma::SpMat<typename MatType::elem_type>,
+        GradType>::value ||
+     std::is_same<RowSparseMat<typename MatType::elem_type>, GradType>::value)>
+{ };
+
+/**
+ * Call kernel(i, g) for each nonzero element g of the given sparse gradient,
+ * where i is the index of that element in the (column-major) memory of a dense
+ * matrix of the same size.  The compressed sparse column arrays of the gradient
+ * are walked directly, so the sparse implementations of the update policies
+ * (see UseSparseUpdate) scatter into the raw memory of the iterate and of their
+ * state without creating any temporary sparse matrix:
+ *
+ * @code
+ * ForEachNonzero(gradient, [&](const size_t i, const eT g) { x[i] -= a * g; });
+ * @endcode
+ *
+ * The overload for RowSparseMat gradients is in row_sparse_mat.hpp.
+ *
+ * @param gradient The sparse gradient.
+ * @param kernel Kernel to call for each nonzero element.
+ */
+template<typename eT, typename KernelType>
+inline void ForEachNonzero(const arma::SpMat<eT>& gradient,
+                           KernelType&& kernel)
+{
+  // Make sure that the compressed representation is up to date.
+  gradient.sync();
+
+  const arma::uword* colPtrs = gradient.col_ptrs;
+  const arma::uword* rowIndices = gradient.row_indices;
+  const eT* values = gradient.values;
+  for (size_t c = 0; c < gradient.n_cols; ++c)
+  {
+    const size_t offset = c * gradient.n_rows;
+    for (size_t k = colPtrs[c]; k < colPtrs[c + 1]; ++k)
+      kernel(offset + rowIndices[k], values[k]);
+  }
+}
+
+/**
+ * The fused implementations of VanillaUpdate, MomentumUpdate and the update
+ * policies that are based on Adam can apply an element-wise transform to each
+ * element of the gradient as it is read, so that e.g. gradient clipping (see
+ * GradientClipping) costs no extra pass over the gradient and no temporary.  A
+ * transform is a functor that maps a gradient element to the element that the
+ * update uses.
+ *
+ * IdentityTransform leaves the gradient unchanged; it is the transform used by
+ * the regular Update() of these policies.
+ */
+struct IdentityTransform
+{
+  template<typename eT>
+  eT operator()(const eT g) const { return g; }
+};
+
+/**
+ * ClipTransform scales each gradient element by `scale`, and then clamps it to
+ * [min, max].  With scale = min(1, maxNorm / ||g||), this clips the gradient
+ * by its global norm; with scale = 1, it only clips the elements.
+ *
+ * @tparam eT Type of the elements of the gradient.
+ */
+template<typename eT>
+struct ClipTransform
+{
+  ClipTransform(const eT scale, const eT min, const eT max) :
+      scale(scale), min(min), max(max)
+  { /* Nothing to do here. */ }
+
+  eT operator()(const eT g) const
+  {
+    return std::min(std::max(scale * g, min), max);
+  }
+
+  //! The factor that each element is multiplied with.
+  eT scale;
+  //! The lower bound of each element.
+  eT min;
+  //! The upper bound of each element.
+  eT max;
+};
+
+/**
+ * The fused implementations of the most used update policies (VanillaUpdate,
+ * MomentumUpdate, NesterovMomentumUpdate, QHUpdate and AdamUpdate) can also
+ * pass each element of the iterate to an element-wise sink right after it is
+ * written, so that e.g. an average of the iterates (see IterateAveraging)
+ * costs no extra pass over the iterate; this is their SinkUpdate() method.  A
+ * sink is a functor that is called as sink(i, x) with the index and the new
+ * value of the element.
+ *
+ * NoSink does nothing; it is the sink used by the regular Update() of these
+ * policies.
+ */
+struct NoSink
+{
+  template<typename eT>
+  void operator()(const size_t /* i */, const eT /* x */) const { }
+};
+
+/**
+ * AverageSink moves each element of an average towards the new value of the
+ * corresponding element of the iterate, by the given weight:
+ * average[i] += weight * (x - average[i]).  A weight of 1 / (n + 1) gives the
+ * uniform average of n + 1 iterates, and a constant weight (1 - decay) the
+ * exponential moving average with that decay.
+ *
+ * @tparam eT Type of the elements of the iterate.
+ */
+template<typename eT>
+struct AverageSink
+{
+  AverageSink(eT* average, const eT weight) :
+      average(average), weight(weight)
+  { /* Nothing to do here. */ }
+
+  void operator()(const size_t i, const eT x) const
+  {
+    average[i] += weight * (x - average[i]);
+  }
+
+  //! The memory of the average.
+  eT* average;
+  //! The weight of the new iterate.
+  eT weight;
+};
+
+//! Return the storage of the threshold set with SetFusedUpdateThreshold().
+inline size_t& FusedUpdateThresholdStorage()
+{
+  static size_t threshold = 0;
+  return threshold;
+}
+
+/**
+ * Set the number of elements above which the fused update kernels are split
+ * into ranges of that many elements, which are run in parallel with the
+ * current executor (see SetExecutor()).  0 (the default) disables this, so the
+ * kernels always run on the calling thread.  The size of the ranges is rounded
+ * up to a multiple of FusedRangeAlignment elements, so that two threads never
+ * write to the same cache line of the iterate or of the policy state.  Since
+ * these ranges only depend on the threshold, the result doesn't depend on the
+ * number of threads.  Only
+ * very large iterates (millions of elements) benefit from this, and it should
+ * not be used when the update is itself run in parallel (e.g. by
+ * ParallelSGD).  This must not be called while an optimization runs.
+ *
+ * @code
+ * ens::SetFusedUpdateThreshold(1 << 20);
+ * @endcode
+ *
+ * @param threshold The number of elements of each range, or 0.
+ */
+inline void SetFusedUpdateThreshold(const size_t threshold)
+{
+  FusedUpdateThresholdStorage() = threshold;
+}
+
+//! Return the threshold set with SetFusedUpdateThreshold().
+inline size_t FusedUpdateThreshold() { return FusedUpdateThresholdStorage(); }
+
+//! The number of elements that the size of the ranges of the fused kernels is
+//! a multiple of: 64 bytes (one cache line) of float, or two of double.
+static const size_t FusedRangeAlignment = 16;
+
+//! Return the number of elements of each range of the fused kernels, i.e. the
+//! threshold rounded up to a multiple of FusedRangeAlignment.
+inline size_t FusedRangeSize()
+{
+  const size_t threshold = FusedUpdateThreshold();
+  return (threshold + FusedRangeAlignment - 1) / FusedRangeAlignment *
+      FusedRangeAlignment;
+}
+
+/**
+ * Run the given fused kernel over the elements [0, n): kernel(begin, end) is
+ * called for each range of FusedRangeSize() elements, in parallel, if n is
+ * above that size, and with one range [0, n) otherwise.
+ * The kernel is typically a vectorized loop over the raw memory of the
+ * iterate, the gradient and the policy state:
+ *
+ * @code
+ * FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+ * {
+ *   ENS_PRAGMA_OMP_SIMD
+ *   for (size_t i = begin; i < end; ++i)
+ *     x[i] -= a * g[i];
+ * });
+ * @endcode
+ *
+ * @param n Number of elements.
+ * @param kernel Kernel to call for each range of elements.
+ */
+template<typename KernelType>
+inline void FusedForEach(const size_t n, KernelType&& kernel)
+{
+  const size_t range = FusedRangeSize();
+  if (range == 0 || n <= range)
+  {
+    kernel((size_t) 0, n);
+    return;
+  }
+
+  ParallelFor((n + range - 1) / range, [&](const size_t r)
+  {
+    kernel(r * range, std::min((r + 1) * range, n));
+  });
+}
+
+/**
+ * Run the given fused reduction kernel over the elements [0, n), as with
+ * FusedForEach(), and return the sum of the values that kernel(begin, end)
+ * returns for each range.  The partial sums are added in the order of the
+ * ranges, so the result doesn't depend on the number of threads.
+ *
+ * @param n Number of elements.
+ * @param kernel Kernel returning the sum over a range of elements.
+ * @return The sum over all elements.
+ */
+template<typename eT, typename KernelType>
+inline eT FusedSum(const size_t n, KernelType&& kernel)
+{
+  const size_t range = FusedRangeSize();
+  if (range == 0 || n <= range)
+    return kernel((size_t) 0, n);
+
+  std::vector<eT> sums((n + range - 1) / range);
+  ParallelFor(sums.size(), [&](const size_t r)
+  {
+    sums[r] = kernel(r * range, std::min((r + 1) * range, n));
+  });
+
+  eT sum = eT(0);
+  for (size_t r = 0; r < sums.size(); ++r)
+    sum += sums[r];
+  return sum;
+}
+
+} // namespace ens
+
+#endif
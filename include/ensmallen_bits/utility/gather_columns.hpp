@@ -0,0 +1,111 @@
+/**
+ * @file gather_columns.hpp
+ *
+ * Utilities to extract a set of columns of a dense or sparse matrix with as
+ * little copying as possible.  These are used by the separable test problems to
+ * assemble their batches.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_GATHER_COLUMNS_HPP
+#define ENSMALLEN_UTILITY_GATHER_COLUMNS_HPP
+
+namespace ens {
+
+/**
+ * Return the contiguous columns [begin, begin + n) of the given dense matrix.
+ * The result is an alias of the memory of the matrix, so nothing is copied;
+ * the matrix must outlive the result and must not be modified through it.
+ *
+ * @param matrix The matrix to take the columns of.
+ * @param begin The first column.
+ * @param n The number of columns.
+ */
+template<typename eT>
+arma::Mat<eT> ColumnRange(const arma::Mat<eT>& matrix,
+                          const size_t begin,
+                          const size_t n)
+{
+  return arma::Mat<eT>(const_cast<eT*>(matrix.colptr(begin)), matrix.n_rows, n,
+      false, true);
+}
+
+/**
+ * Return the contiguous columns [begin, begin + n) of the given sparse matrix.
+ * Only the nonzero elements of those columns are copied.
+ *
+ * @param matrix The matrix to take the columns of.
+ * @param begin The first column.
+ * @param n The number of columns.
+ */
+template<typename eT>
+arma::SpMat<eT> ColumnRange(const arma::SpMat<eT>& matrix,
+                            const size_t begin,
+                            const size_t n)
+{
+  return matrix.cols(begin, begin + n - 1);
+}
+
+/**
+ * Return the columns of the given dense matrix with the given indices, in the
+ * order of the indices.
+ *
+ * @param matrix The matrix to take the columns of.
+ * @param indices The indices of the columns.
+ */
+template<typename eT>
+arma::Mat<eT> GatherColumns(const arma::Mat<eT>& matrix,
+                            const arma::uvec& indices)
+{
+  arma::Mat<eT> result(matrix.n_rows, indices.n_elem);
+  for (size_t i = 0; i < indices.n_elem; ++i)
+    result.col(i) = matrix.col(indices[i]);
+
+  return result;
+}
+
+/**
+ * Return the columns of the given sparse matrix with the given indices, in the
+ * order of the indices.  The result is assembled directly in compressed sparse
+ * column format, so the cost is linear in the number of nonzero elements of the
+ * gathered columns.
+ *
+ * @param matrix The matrix to take the columns of.
+ * @param indices The indices of the columns.
+ */
+template<typename eT>
+arma::SpMat<eT> GatherColumns(const arma::SpMat<eT>& matrix,
+                              const arma::uvec& indices)
+{
+  matrix.sync();
+
+  size_t nonzero = 0;
+  for (size_t i = 0; i < indices.n_elem; ++i)
+    nonzero += matrix.col_ptrs[indices[i] + 1] - matrix.col_ptrs[indices[i]];
+
+  arma::uvec rowIndices(nonzero);
+  arma::uvec colPointers(indices.n_elem + 1);
+  arma::Col<eT> values(nonzero);
+  colPointers[0] = 0;
+  size_t k = 0;
+  for (size_t i = 0; i < indices.n_elem; ++i)
+  {
+    for (size_t p = matrix.col_ptrs[indices[i]];
+         p < matrix.col_ptrs[indices[i] + 1]; ++p, ++k)
+    {
+      rowIndices[k] = matrix.row_indices[p];
+      values[k] = matrix.values[p];
+    }
+    colPointers[i + 1] = k;
+  }
+
+  return arma::SpMat<eT>(rowIndices, colPointers, values, matrix.n_rows,
+      indices.n_elem);
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * @file gradient_moments.hpp
+ *
+ * Utility to compute the sum of the per-sample gradients of a batch together
+ * with the sum of their squared norms, using the optional GradientMoments()
+ * method of the function when it is available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_GRADIENT_MOMENTS_HPP
+#define ENSMALLEN_UTILITY_GRADIENT_MOMENTS_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+#include <ensmallen_bits/utility/parallel_batch.hpp>
+
+namespace ens {
+
+/**
+ * Compute the sum of the gradients of the separable functions
+ * [begin, begin + batchSize) into `gradient`, and return the sum of the squared
+ * norms of these per-sample gradients.  Together, they give the variance of
+ * the per-sample gradients, which is what BigBatchSGD uses to adapt its batch
+ * size.  If the FunctionType has a method
+ *
+ * @code
+ * eT GradientMoments(const MatType& coordinates,
+ *                    const size_t begin,
+ *                    GradType& gradient,
+ *                    const size_t batchSize);
+ * @endcode
+ *
+ * (const or non-const), then it is called once for the whole batch; e.g. for a
+ * linear model the per-sample gradients are the data points scaled by the
+ * errors, so both moments can be computed from one pass over the batch.
+ *
+ * Otherwise, Gradient() is called for each sample.  If `parallel` is true,
+ * these calls are spread over OpenMP threads, each accumulating into its own
+ * buffers in `buffers` (which is resized as needed and can be reused across
+ * calls), and so Gradient() must be safe to call concurrently.  If
+ * `deterministic` is true, the batch is instead split into ranges of
+ * `chunkSize` samples, whose sums are reduced in a fixed pairwise order, so the
+ * result doesn't depend on the number of threads.
+ *
+ * @param function Separable function to differentiate.
+ * @param iterate Coordinates to compute the gradients at.
+ * @param begin Index of the first sample in the batch.
+ * @param gradient Matrix to store the summed gradient into.
+ * @param batchSize Number of samples in the batch.
+ * @param buffers Per-thread gradient buffers.
+ * @param parallel Whether or not to call Gradient() in parallel.
+ * @param deterministic Whether or not the ranges should be independent of the
+ *     number of threads.
+ * @param chunkSize Number of samples in each range in deterministic mode.
+ * @return Sum of the squared norms of the per-sample gradients.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<traits::HasGradientMomentsSignature<
+    FunctionType, MatType, GradType>::value,
+    typename MatType::elem_type>::type
+GradientMoments(FunctionType& function,
+                const MatType& iterate,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize,
+                std::vector<GradType>& /* buffers */,
+                const bool /* parallel */ = false,
+                const bool /* deterministic */ = false,
+                const size_t /* chunkSize */ = 32)
+{
+  return function.GradientMoments(iterate, begin, gradient, batchSize);
+}
+
+//! Compute the gradient of each sample separately.
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<!traits::HasGradientMomentsSignature<
+    FunctionType, MatType, GradType>::value,
+    typename MatType::elem_type>::type
+GradientMoments(FunctionType& function,
+                const MatType& iterate,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize,
+                std::vector<GradType>& buffers,
+                const bool parallel = false,
+                const bool deterministic = false,
+                const size_t chunkSize = 32)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  // Each range r of samples uses two buffers: the sum of its gradients (in
+  // buffers[r]), and the gradient of the current sample (in
+  // buffers[numRanges + r]).
+  size_t rangeSize = std::max(batchSize, (size_t) 1);
+  if (deterministic)
+    rangeSize = RangeSize(batchSize, std::max(chunkSize, (size_t) 1));
+  else if (parallel)
+    rangeSize = RangeSize(batchSize);
+  const size_t numRanges = std::max(NumRanges(batchSize, rangeSize),
+      (size_t) 1);
+  if (buffers.size() < 2 * numRanges)
+    buffers.resize(2 * numRanges);
+  std::vector<ElemType> squaredNorms(numRanges, ElemType(0));
+
+  ParallelFor(numRanges, [&](const size_t r)
+  {
+    GradType& sum = buffers[r];
+    GradType& sample = buffers[numRanges + r];
+    sum.zeros(iterate.n_rows, iterate.n_cols);
+
+    const size_t rangeBegin = std::min((size_t) r * rangeSize, batchSize);
+    const size_t rangeEnd = std::min(rangeBegin + rangeSize, batchSize);
+    for (size_t i = rangeBegin; i < rangeEnd; ++i)
+    {
+      function.Gradient(iterate, begin + i, sample, 1);
+      squaredNorms[r] += arma::dot(sample, sample);
+      sum += sample;
+    }
+  }, parallel);
+
+  if (deterministic)
+  {
+    PairwiseReduce(buffers, numRanges);
+    PairwiseReduce(squaredNorms, numRanges);
+    gradient = buffers[0];
+    return squaredNorms[0];
+  }
+
+  gradient = buffers[0];
+  ElemType squaredNorm = squaredNorms[0];
+  for (size_t r = 1; r < numRanges; ++r)
+  {
+    gradient += buffers[r];
+    squaredNorm += squaredNorms[r];
+  }
+
+  return squaredNorm;
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file island_model.hpp
+ *
+ * Migration between the sub-populations (islands) of the island models of the
+ * population-based optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ISLAND_MODEL_HPP
+#define ENSMALLEN_UTILITY_ISLAND_MODEL_HPP
+
+namespace ens {
+
+//! Return a member of a population stored as a vector of candidates.
+template<typename MatType>
+inline MatType& PopulationMember(std::vector<MatType>& population,
+                                 const size_t i)
+{
+  return population[i];
+}
+
+//! Return a member of a population stored as a cube, one member per slice.
+template<typename ElemType>
+inline arma::Mat<ElemType>& PopulationMember(arma::Cube<ElemType>& population,
+                                             const size_t i)
+{
+  return population.slice(i);
+}
+
+/**
+ * In the island models of DE and CNE (see DE::Islands() and CNE::Islands()),
+ * the population is split into islands that evolve independently, each on its
+ * own thread, and every few generations the best members of each island
+ * migrate to another island, where each of them replaces the worst member if
+ * it is better.  The islands exchange their members on a ring (island k sends
+ * to island k + 1), or, if `randomTopology` is true, each island sends to
+ * another island drawn at random.  The emigrants of all islands are chosen
+ * before any of them is inserted, so the result doesn't depend on the order of
+ * the islands.  The population of an island is either a vector of candidates
+ * or a cube with one candidate per slice.
+ *
+ * @param populations The members of each island.
+ * @param fitnessValues The objective of each member of each island.
+ * @param migrants Number of members that each island sends.
+ * @param randomTopology Whether or not the destinations are drawn at random.
+ * @param rng Random number stream to draw the destinations from.
+ */
+template<typename PopulationType, typename ElemType>
+inline void MigrateIslands(
+    std::vector<PopulationType>& populations,
+    std::vector<arma::Col<ElemType>>& fitnessValues,
+    const size_t migrants,
+    const bool randomTopology,
+    RandomStream& rng)
+{
+  typedef typename std::decay<decltype(PopulationMember(populations[0],
+      0))>::type MatType;
+
+  const size_t islands = populations.size();
+  if (islands < 2 || migrants == 0)
+    return;
+
+  // Copy the best members of every island first.
+  std::vector<std::vector<MatType>> emigrants(islands);
+  std::vector<arma::Col<ElemType>> emigrantFitness(islands);
+  for (size_t k = 0; k < islands; ++k)
+  {
+    const arma::uvec order = arma::sort_index(fitnessValues[k]);
+    const size_t count = std::min(migrants, (size_t) order.n_elem);
+    emigrantFitness[k].set_size(count);
+    for (size_t j = 0; j < count; ++j)
+    {
+      emigrants[k].push_back(PopulationMember(populations[k], order(j)));
+      emigrantFitness[k](j) = fitnessValues[k](order(j));
+    }
+  }
+
+  for (size_t k = 0; k < islands; ++k)
+  {
+    const size_t destination = randomTopology ?
+        (k + 1 + rng.Integer(islands - 1)) % islands : (k + 1) % islands;
+
+    // The worst members of the destination are replaced, if the emigrants are
+    // better.
+    PopulationType& population = populations[destination];
+    arma::Col<ElemType>& fitness = fitnessValues[destination];
+    const arma::uvec worst = arma::sort_index(fitness, "descend");
+    for (size_t j = 0; j < emigrants[k].size() && j < worst.n_elem; ++j)
+    {
+      if (emigrantFitness[k](j) < fitness(worst(j)))
+      {
+        PopulationMember(population, worst(j)) = emigrants[k][j];
+        fitness(worst(j)) = emigrantFitness[k](j);
+      }
+    }
+  }
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,220 @@
+/**
+ * @file locality_ordering.hpp
+ *
+ * Reordering of the features and examples of sparse data, so that the sparse
+ * optimizers access the coordinates with more locality.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_LOCALITY_ORDERING_HPP
+#define ENSMALLEN_UTILITY_LOCALITY_ORDERING_HPP
+
+namespace ens {
+
+/**
+ * Return the inverse of the given permutation, i.e. the new position of each
+ * original index if order[i] is the original index at position i.
+ *
+ * @param order A permutation of [0, n).
+ */
+inline arma::uvec InversePermutation(const arma::uvec& order)
+{
+  arma::uvec rank(order.n_elem);
+  for (size_t i = 0; i < order.n_elem; ++i)
+    rank[order[i]] = i;
+  return rank;
+}
+
+/**
+ * Compute orders of the features (rows) and examples (columns) of the given
+ * sparse data, so that the examples that are visited together use features
+ * that are stored close together.  With sparse gradients, ParallelSGD and SCD
+ * then touch a compact set of cache lines of the coordinates in each batch,
+ * instead of (nearly) random ones.
+ *
+ * By default, the orders are the reverse Cuthill-McKee ordering of the
+ * bipartite graph of the features and the examples (where each nonzero element
+ * is an edge), which reduces the bandwidth of the data: each connected
+ * component is traversed breadth-first from a node of minimal degree, visiting
+ * the neighbours of each node by increasing degree, and the resulting order is
+ * reversed.  This takes time linear in the number of nonzero elements (up to
+ * the sorting of the neighbours) and doesn't build the co-occurrence graph of
+ * the features, which can be dense when some features are frequent.
+ *
+ * If byFrequency is true, the features are instead sorted by decreasing number
+ * of examples (so that the frequent features share a few cache lines), and the
+ * examples by the position of their first feature.
+ *
+ * The reordered data is PermuteSparse(data, featureOrder, exampleOrder); the
+ * coordinates of the optimization follow the order of the features (e.g.
+ * coordinates.rows(featureOrder) if each row of the coordinates is one
+ * feature), and are mapped back with the inverse permutation (see
+ * InversePermutation()).
+ *
+ * @code
+ * arma::uvec featureOrder, exampleOrder;
+ * ens::LocalityOrdering(data, featureOrder, exampleOrder);
+ * const arma::sp_mat reordered = ens::PermuteSparse(data, featureOrder,
+ *     exampleOrder);
+ *
+ * // ... optimize a function on the reordered data ...
+ *
+ * arma::mat original(coordinates.n_rows, coordinates.n_cols);
+ * original.rows(featureOrder) = coordinates;
+ * @endcode
+ *
+ * @param data Sparse data, with one example per column.
+ * @param featureOrder The original index of the feature at each new position.
+ * @param exampleOrder The original index of the example at each new position.
+ * @param byFrequency Whether or not the features are sorted by frequency.
+ */
+template<typename eT>
+inline void LocalityOrdering(const arma::SpMat<eT>& data,
+                             arma::uvec& featureOrder,
+                             arma::uvec& exampleOrder,
+                             const bool byFrequency = false)
+{
+  const size_t numFeatures = data.n_rows;
+  const size_t numExamples = data.n_cols;
+  data.sync();
+
+  // The transpose gives the examples of each feature.
+  const arma::SpMat<eT> transposed = data.t();
+  transposed.sync();
+
+  if (byFrequency)
+  {
+    arma::uvec frequency(numFeatures);
+    for (size_t f = 0; f < numFeatures; ++f)
+      frequency[f] = transposed.col_ptrs[f + 1] - transposed.col_ptrs[f];
+    featureOrder = arma::stable_sort_index(frequency, "descend");
+
+    // Examples without features go last.
+    const arma::uvec rank = InversePermutation(featureOrder);
+    arma::uvec first(numExamples);
+    first.fill(numFeatures);
+    for (size_t e = 0; e < numExamples; ++e)
+    {
+      for (size_t k = data.col_ptrs[e]; k < data.col_ptrs[e + 1]; ++k)
+        first[e] = std::min(first[e], (arma::uword) rank[data.row_indices[k]]);
+    }
+    exampleOrder = arma::stable_sort_index(first);
+    return;
+  }
+
+  // The nodes are the features [0, numFeatures) and then the examples.
+  const size_t numNodes = numFeatures + numExamples;
+  arma::uvec degree(numNodes);
+  for (size_t f = 0; f < numFeatures; ++f)
+    degree[f] = transposed.col_ptrs[f + 1] - transposed.col_ptrs[f];
+  for (size_t e = 0; e < numExamples; ++e)
+    degree[numFeatures + e] = data.col_ptrs[e + 1] - data.col_ptrs[e];
+
+  // Each component starts from its unvisited node of minimal degree.
+  const arma::uvec starts = arma::stable_sort_index(degree);
+  std::vector<char> visited(numNodes, 0);
+  std::vector<size_t> order;
+  order.reserve(numNodes);
+  std::vector<size_t> neighbours;
+  for (size_t s = 0; s < numNodes; ++s)
+  {
+    if (visited[starts[s]])
+      continue;
+
+    visited[starts[s]] = 1;
+    order.push_back(starts[s]);
+    for (size_t head = order.size() - 1; head < order.size(); ++head)
+    {
+      const size_t node = order[head];
+      neighbours.clear();
+      if (node < numFeatures)
+      {
+        for (size_t k = transposed.col_ptrs[node];
+            k < transposed.col_ptrs[node + 1]; ++k)
+        {
+          neighbours.push_back(numFeatures + transposed.row_indices[k]);
+        }
+      }
+      else
+      {
+        const size_t e = node - numFeatures;
+        for (size_t k = data.col_ptrs[e]; k < data.col_ptrs[e + 1]; ++k)
+          neighbours.push_back(data.row_indices[k]);
+      }
+
+      // Visit the unvisited neighbours by increasing degree.
+      size_t count = 0;
+      for (size_t k = 0; k < neighbours.size(); ++k)
+      {
+        if (!visited[neighbours[k]])
+        {
+          visited[neighbours[k]] = 1;
+          neighbours[count++] = neighbours[k];
+        }
+      }
+      std::stable_sort(neighbours.begin(), neighbours.begin() + count,
+          [&degree](const size_t a, const size_t b)
+          { return degree[a] < degree[b]; });
+      order.insert(order.end(), neighbours.begin(),
+          neighbours.begin() + count);
+    }
+  }
+
+  // Reverse the Cuthill-McKee order, and split it into features and examples.
+  featureOrder.set_size(numFeatures);
+  exampleOrder.set_size(numExamples);
+  size_t f = 0, e = 0;
+  for (size_t k = numNodes; k > 0; --k)
+  {
+    const size_t node = order[k - 1];
+    if (node < numFeatures)
+      featureOrder[f++] = node;
+    else
+      exampleOrder[e++] = node - numFeatures;
+  }
+}
+
+/**
+ * Return the given sparse matrix with its rows and columns permuted: element
+ * (i, j) of the result is element (rowOrder[i], colOrder[j]) of the matrix.
+ *
+ * @param data The sparse matrix.
+ * @param rowOrder The original index of the row at each new position.
+ * @param colOrder The original index of the column at each new position.
+ */
+template<typename eT>
+inline arma::SpMat<eT> PermuteSparse(const arma::SpMat<eT>& data,
+                                     const arma::uvec& rowOrder,
+                                     const arma::uvec& colOrder)
+{
+  if (rowOrder.n_elem != data.n_rows || colOrder.n_elem != data.n_cols)
+  {
+    throw std::invalid_argument("PermuteSparse(): the orders must have the "
+        "size of the matrix!");
+  }
+
+  data.sync();
+  const arma::uvec rowRank = InversePermutation(rowOrder);
+  arma::umat locations(2, data.n_nonzero);
+  arma::Col<eT> values(data.n_nonzero);
+  size_t n = 0;
+  for (size_t j = 0; j < colOrder.n_elem; ++j)
+  {
+    const size_t c = colOrder[j];
+    for (size_t k = data.col_ptrs[c]; k < data.col_ptrs[c + 1]; ++k)
+    {
+      locations(0, n) = rowRank[data.row_indices[k]];
+      locations(1, n) = j;
+      values[n++] = data.values[k];
+    }
+  }
+
+  return arma::SpMat<eT>(locations, values, data.n_rows, data.n_cols);
+}
+
+} // namespace ens
+
+#endif
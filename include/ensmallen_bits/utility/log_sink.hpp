@@ -0,0 +1,506 @@
+/**
+ * @file log_sink.hpp
+ *
+ * Log sinks with severity levels, to which Info and Warn send their messages
+ * when ENS_LOG_SINK is defined.  The messages are recorded as compact binary
+ * records, and BufferedLogSink formats and writes them on a thread of its own.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_LOG_SINK_HPP
+#define ENSMALLEN_UTILITY_LOG_SINK_HPP
+
+namespace ens {
+
+/**
+ * The severity levels of log messages, in increasing order.
+ */
+enum class LogLevel
+{
+  //! Progress of the optimization (the messages of Info).
+  Info,
+  //! Problems of the optimization (the messages of Warn).
+  Warn
+};
+
+/**
+ * A LogRecord holds one log message as a sequence of typed fields, encoded in
+ * a single byte buffer: each field is a tag followed by the raw bytes of the
+ * value (strings are copied, with their length).  Recording a message thus
+ * costs a few copies, and the numbers are only converted to text by Format(),
+ * which may run much later, on another thread.  Values of other types are
+ * converted to a string when they are appended.
+ */
+class LogRecord
+{
+ public:
+  //! Create an empty record of the given level.
+  LogRecord(const LogLevel level = LogLevel::Info) : level(level) { }
+
+  //! Append a boolean.
+  void Append(const bool value) { AppendField(BoolField, value); }
+  //! Append an integer.
+  void Append(const short value) { AppendSigned(value); }
+  //! Append an integer.
+  void Append(const unsigned short value) { AppendUnsigned(value); }
+  //! Append an integer.
+  void Append(const int value) { AppendSigned(value); }
+  //! Append an integer.
+  void Append(const unsigned int value) { AppendUnsigned(value); }
+  //! Append an integer.
+  void Append(const long value) { AppendSigned(value); }
+  //! Append an integer.
+  void Append(const unsigned long value) { AppendUnsigned(value); }
+  //! Append an integer.
+  void Append(const long long value) { AppendSigned(value); }
+  //! Append an integer.
+  void Append(const unsigned long long value) { AppendUnsigned(value); }
+  //! Append a number; floats are printed like doubles by streams anyway.
+  void Append(const float value) { AppendField(DoubleField, (double) value); }
+  //! Append a number.
+  void Append(const double value) { AppendField(DoubleField, value); }
+  //! Append a number.
+  void Append(const long double value) { AppendField(LongDoubleField, value); }
+  //! Append a pointer (its address is printed).
+  void Append(const void* value) { AppendField(PointerField, value); }
+
+  //! Append a string.
+  void Append(const char* value)
+  {
+    AppendString(value, (value == NULL) ? 0 : std::strlen(value));
+  }
+
+  //! Append a string.
+  void Append(const std::string& value)
+  {
+    AppendString(value.data(), value.size());
+  }
+
+  //! Append a manipulator (e.g. std::fixed), applied when formatting.
+  void Append(std::ios_base& (*manipulator)(std::ios_base&))
+  {
+    AppendField(BaseManipulatorField, manipulator);
+  }
+
+  //! Append a manipulator, applied when formatting.
+  void Append(std::ios& (*manipulator)(std::ios&))
+  {
+    AppendField(IosManipulatorField, manipulator);
+  }
+
+  //! Append any other printable value, as the string it is printed as.
+  template<typename T>
+  void Append(const T& value)
+  {
+    std::ostringstream stream;
+    stream << value;
+    Append(stream.str());
+  }
+
+  //! Print the fields of the message to the given stream, in order.
+  void Format(std::ostream& stream) const
+  {
+    size_t position = 0;
+    while (position < data.size())
+    {
+      const char tag = data[position++];
+      switch (tag)
+      {
+        case BoolField:
+          stream << Read<bool>(position);
+          break;
+        case SignedField:
+          stream << Read<long long>(position);
+          break;
+        case UnsignedField:
+          stream << Read<unsigned long long>(position);
+          break;
+        case DoubleField:
+          stream << Read<double>(position);
+          break;
+        case LongDoubleField:
+          stream << Read<long double>(position);
+          break;
+        case PointerField:
+          stream << Read<const void*>(position);
+          break;
+        case StringField:
+        {
+          const size_t length = Read<size_t>(position);
+          stream.write(data.data() + position, length);
+          position += length;
+          break;
+        }
+        case BaseManipulatorField:
+          stream << Read<std::ios_base& (*)(std::ios_base&)>(position);
+          break;
+        case IosManipulatorField:
+          stream << Read<std::ios& (*)(std::ios&)>(position);
+          break;
+      }
+    }
+  }
+
+  //! Remove all fields from the record.
+  void Clear() { data.clear(); }
+
+  //! Return whether the record has no fields.
+  bool Empty() const { return data.empty(); }
+
+  //! Get the level of the message.
+  LogLevel Level() const { return level; }
+  //! Modify the level of the message.
+  LogLevel& Level() { return level; }
+
+ private:
+  //! The tags of the fields.
+  enum FieldTag
+  {
+    BoolField,
+    SignedField,
+    UnsignedField,
+    DoubleField,
+    LongDoubleField,
+    PointerField,
+    StringField,
+    BaseManipulatorField,
+    IosManipulatorField
+  };
+
+  //! Append a signed integer, widened to long long.
+  void AppendSigned(const long long value) { AppendField(SignedField, value); }
+
+  //! Append an unsigned integer, widened to unsigned long long.
+  void AppendUnsigned(const unsigned long long value)
+  {
+    AppendField(UnsignedField, value);
+  }
+
+  //! Append a string field of the given length.
+  void AppendString(const char* value, const size_t length)
+  {
+    AppendField(StringField, length);
+    data.insert(data.end(), value, value + length);
+  }
+
+  //! Append a tag and the bytes of the given value.
+  template<typename T>
+  void AppendField(const FieldTag tag, const T& value)
+  {
+    const size_t position = data.size();
+    data.resize(position + 1 + sizeof(T));
+    data[position] = (char) tag;
+    std::memcpy(data.data() + position + 1, &value, sizeof(T));
+  }
+
+  //! Read a value at the given position, and advance the position past it.
+  template<typename T>
+  T Read(size_t& position) const
+  {
+    T value;
+    std::memcpy(&value, data.data() + position, sizeof(T));
+    position += sizeof(T);
+    return value;
+  }
+
+  //! The level of the message.
+  LogLevel level;
+  //! The tags and values of the fields.
+  std::vector<char> data;
+};
+
+/**
+ * A LogSink receives the complete messages of Info and Warn (and of any other
+ * LogStream) as LogRecords.  Messages below the level of the sink are dropped
+ * by the LogStream before any of their fields is recorded.  A custom sink can
+ * be written by deriving from LogSink:
+ *
+ * @code
+ * class MySink : public ens::LogSink
+ * {
+ *  public:
+ *   // Take the message; this may be called from several threads at once.
+ *   void Record(ens::LogRecord&& record) { ... }
+ *
+ *   // Write all messages received so far.
+ *   void Flush() { ... }
+ * };
+ * @endcode
+ */
+class LogSink
+{
+ public:
+  //! Create a sink that receives the messages of the given level and above.
+  LogSink(const LogLevel level = LogLevel::Info) : level(level) { }
+
+  //! Nothing to do.
+  virtual ~LogSink() { }
+
+  //! Return whether messages of the given level are received.
+  bool Enabled(const LogLevel messageLevel) const
+  {
+    return messageLevel >= level;
+  }
+
+  /**
+   * Receive a complete message.  This is called by the thread that logged the
+   * message, and the sink may take the contents of the record.
+   *
+   * @param record The message.
+   */
+  virtual void Record(LogRecord&& record) = 0;
+
+  //! Write all of the messages received so far.
+  virtual void Flush() { }
+
+  //! Get the lowest level of the received messages.
+  LogLevel Level() const { return level; }
+  //! Modify the lowest level of the received messages.
+  LogLevel& Level() { return level; }
+
+ private:
+  //! The lowest level of the received messages.
+  LogLevel level;
+};
+
+/**
+ * BufferedLogSink queues the records it receives, and a thread of its own
+ * formats them and writes them to the given stream, one line per message: when
+ * the queue holds the given number of records, and otherwise every given
+ * number of milliseconds.  The stream is flushed once per batch of records,
+ * instead of once per line as with std::endl, and the logging threads only pay
+ * for moving the record into the queue.  Flush() and the destructor write all
+ * queued records.
+ *
+ * @code
+ * ens::SetLogSink(std::make_shared<ens::BufferedLogSink>(std::cout));
+ * @endcode
+ */
+class BufferedLogSink : public LogSink
+{
+ public:
+  /**
+   * Create the sink and start its thread.
+   *
+   * @param stream Stream to write the messages to.
+   * @param level Lowest level of the received messages.
+   * @param capacity Number of queued records that triggers a write.
+   * @param flushInterval Maximum time between writes, in milliseconds.
+   */
+  BufferedLogSink(std::ostream& stream = arma::get_cout_stream(),
+                  const LogLevel level = LogLevel::Info,
+                  const size_t capacity = 1024,
+                  const size_t flushInterval = 100) :
+      LogSink(level),
+      stream(stream),
+      capacity(capacity),
+      flushInterval(flushInterval),
+      stop(false)
+  {
+    queue.reserve(capacity);
+    worker = std::thread(&BufferedLogSink::Run, this);
+  }
+
+  //! Stop the thread, and write the remaining records.
+  ~BufferedLogSink()
+  {
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      stop = true;
+    }
+    ready.notify_one();
+    worker.join();
+    Write();
+  }
+
+  //! Queue the given record.
+  void Record(LogRecord&& record)
+  {
+    bool full;
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      queue.push_back(std::move(record));
+      full = (queue.size() >= capacity);
+    }
+    if (full)
+      ready.notify_one();
+  }
+
+  //! Write all queued records, on the calling thread.
+  void Flush() { Write(); }
+
+  //! Get the number of queued records that triggers a write.
+  size_t Capacity() const { return capacity; }
+
+  //! Get the maximum time between writes, in milliseconds.
+  size_t FlushInterval() const { return flushInterval; }
+
+ private:
+  //! Write the queued records until the sink is destroyed.
+  void Run()
+  {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    while (!stop)
+    {
+      ready.wait_for(lock, std::chrono::milliseconds(flushInterval),
+          [this]() { return stop || queue.size() >= capacity; });
+
+      lock.unlock();
+      Write();
+      lock.lock();
+    }
+  }
+
+  //! Format the queued records, write them to the stream and flush it.
+  void Write()
+  {
+    // Holding writeMutex while taking the queue keeps the batches in order.
+    std::lock_guard<std::mutex> writeLock(writeMutex);
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      records.swap(queue);
+    }
+    if (records.empty())
+      return;
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+      records[i].Format(stream);
+      stream << '\n';
+    }
+    stream.flush();
+    records.clear();
+  }
+
+  //! The stream to write the messages to.
+  std::ostream& stream;
+  //! The number of queued records that triggers a write.
+  size_t capacity;
+  //! The maximum time between writes, in milliseconds.
+  size_t flushInterval;
+
+  //! The records that haven't been taken by Write() yet.
+  std::vector<LogRecord> queue;
+  //! The records being written (kept to reuse its memory).
+  std::vector<LogRecord> records;
+  //! Protects the queue and the stop flag.
+  std::mutex queueMutex;
+  //! Serializes the writes to the stream.
+  std::mutex writeMutex;
+  //! Wakes the thread when the queue is full or the sink is destroyed.
+  std::condition_variable ready;
+  //! Whether the sink is being destroyed.
+  bool stop;
+  //! The thread that writes the records.
+  std::thread worker;
+};
+
+//! Return the storage of the sink set with SetLogSink().
+inline std::shared_ptr<LogSink>& LogSinkStorage()
+{
+  static std::shared_ptr<LogSink> sink;
+  return sink;
+}
+
+/**
+ * Set the sink that receives the messages of Info and Warn, when ENS_LOG_SINK
+ * is defined (nullptr drops all messages, which is the default).  The sink
+ * must not be changed while an optimization runs.
+ *
+ * @code
+ * ens::SetLogSink(std::make_shared<ens::BufferedLogSink>(std::cout,
+ *     ens::LogLevel::Warn));
+ * @endcode
+ */
+inline void SetLogSink(std::shared_ptr<LogSink> sink)
+{
+  LogSinkStorage() = sink;
+}
+
+//! Return the sink set with SetLogSink(), or nullptr if there is none.
+inline LogSink* CurrentLogSink() { return LogSinkStorage().get(); }
+
+/**
+ * A LogStream is used like an output stream; the values given to operator<<
+ * are appended to a record of the calling thread, and std::endl sends the
+ * record to the sink set with SetLogSink().  If there is no sink, or the level
+ * of the stream is below the level of the sink, the values are ignored without
+ * being formatted or copied.  Info and Warn are LogStreams when ENS_LOG_SINK
+ * is defined.
+ */
+class LogStream
+{
+ public:
+  //! Create a stream for messages of the given level.
+  LogStream(const LogLevel level) : level(level) { }
+
+  //! Append a value to the message of the calling thread.
+  template<typename T>
+  LogStream& operator<<(const T& value)
+  {
+    LogSink* sink = CurrentLogSink();
+    if (sink != NULL && sink->Enabled(level))
+      PendingRecord().Append(value);
+    return *this;
+  }
+
+  //! Append a manipulator to the message of the calling thread.
+  LogStream& operator<<(std::ios_base& (*manipulator)(std::ios_base&))
+  {
+    LogSink* sink = CurrentLogSink();
+    if (sink != NULL && sink->Enabled(level))
+      PendingRecord().Append(manipulator);
+    return *this;
+  }
+
+  //! Append a manipulator to the message of the calling thread.
+  LogStream& operator<<(std::ios& (*manipulator)(std::ios&))
+  {
+    LogSink* sink = CurrentLogSink();
+    if (sink != NULL && sink->Enabled(level))
+      PendingRecord().Append(manipulator);
+    return *this;
+  }
+
+  /**
+   * Handle std::endl, which sends the message of the calling thread to the
+   * sink; other manipulators (e.g. std::flush) do nothing, since the sink
+   * decides when to write.
+   */
+  LogStream& operator<<(std::ostream& (*manipulator)(std::ostream&))
+  {
+    if (manipulator != &std::endl<char, std::char_traits<char>>)
+      return *this;
+
+    LogRecord& record = PendingRecord();
+    LogSink* sink = CurrentLogSink();
+    if (sink != NULL && sink->Enabled(level))
+    {
+      record.Level() = level;
+      sink->Record(std::move(record));
+    }
+    record.Clear();
+    return *this;
+  }
+
+  //! Get the level of the messages.
+  LogLevel Level() const { return level; }
+
+ private:
+  //! Return the message being recorded by the calling thread at this level.
+  LogRecord& PendingRecord() const
+  {
+    static thread_local LogRecord records[2];
+    return records[(size_t) level];
+  }
+
+  //! The level of the messages.
+  LogLevel level;
+};
+
+} // namespace ens
+
+#endif
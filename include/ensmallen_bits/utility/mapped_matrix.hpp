@@ -0,0 +1,371 @@
+/**
+ * @file mapped_matrix.hpp
+ *
+ * A dense matrix that is memory-mapped from a file, so that datasets larger
+ * than the available memory can be used by the separable functions, and a
+ * function wrapper that prefetches the upcoming batches of such a matrix.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_MAPPED_MATRIX_HPP
+#define ENSMALLEN_UTILITY_MAPPED_MATRIX_HPP
+
+#include <ensmallen_bits/utility/checkpoint.hpp>
+#include <fstream>
+#include <memory>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #define ENS_HAVE_MMAP
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace ens {
+
+/**
+ * MappedMatrix memory-maps a matrix stored in a file, and makes it available
+ * as an arma::Mat that uses the mapped memory directly.  Pages of the file are
+ * only read when they are used, and the operating system can evict them again
+ * under memory pressure, so the matrix can be larger than the available
+ * memory.  The file has the format of a single matrix written by a
+ * CheckpointWriter (see Save()): a 64-byte header and the elements in
+ * column-major order.
+ *
+ * The mapping is private, so writing to Matrix() never changes the file.
+ * Since each column is contiguous in the file, the columns of the upcoming
+ * batches can be read ahead with Prefetch(); PrefetchedFunction does this
+ * automatically for the optimizers that support PrepareBatch() (SGD and the
+ * optimizers based on it).
+ *
+ * @code
+ * MappedMatrix<double>::Save("data.bin", data);
+ * // Later, possibly in another process:
+ * MappedMatrix<double> mapped("data.bin");
+ * LogisticRegressionFunction<> f(mapped.Matrix(), responses);
+ * @endcode
+ *
+ * Memory-mapping is only available on POSIX platforms; elsewhere, the
+ * constructor throws a std::runtime_error.
+ *
+ * @tparam eT Type of the elements of the matrix.
+ */
+template<typename eT = double>
+class MappedMatrix
+{
+ public:
+  /**
+   * Map the matrix stored in the given file.  A std::runtime_error is thrown
+   * if the file can't be mapped, or if it does not hold a matrix with elements
+   * of type eT.
+   *
+   * @param filename The file to map.
+   */
+  MappedMatrix(const std::string& filename) : address(NULL), length(0)
+  {
+    #ifdef ENS_HAVE_MMAP
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      throw std::runtime_error("MappedMatrix::MappedMatrix(): cannot open '" +
+          filename + "'.");
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || (size_t) status.st_size < HeaderSize())
+    {
+      close(fd);
+      throw std::runtime_error("MappedMatrix::MappedMatrix(): '" + filename +
+          "' is not a matrix file.");
+    }
+
+    length = (size_t) status.st_size;
+    void* mapped = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+        0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+      throw std::runtime_error("MappedMatrix::MappedMatrix(): cannot map '" +
+          filename + "'.");
+    }
+    address = static_cast<char*>(mapped);
+
+    // The header holds the number of rows, the number of columns and the size
+    // of the elements.
+    uint64_t header[3];
+    std::memcpy(header, address, sizeof(header));
+    if (header[2] != sizeof(eT) ||
+        length < HeaderSize() + header[0] * header[1] * sizeof(eT))
+    {
+      Unmap();
+      throw std::runtime_error("MappedMatrix::MappedMatrix(): '" + filename +
+          "' does not hold a matrix of the expected element type.");
+    }
+
+    matrix.reset(new arma::Mat<eT>(reinterpret_cast<eT*>(address +
+        HeaderSize()), header[0], header[1], false, true));
+    #else
+    throw std::runtime_error("MappedMatrix::MappedMatrix(): memory-mapping is "
+        "not supported on this platform; cannot map '" + filename + "'.");
+    #endif
+  }
+
+  //! The mapping is owned by this object, so it can't be copied.
+  MappedMatrix(const MappedMatrix&) = delete;
+  //! The mapping is owned by this object, so it can't be copied.
+  MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+  //! Unmap the matrix.  Any alias of Matrix() becomes invalid.
+  ~MappedMatrix()
+  {
+    matrix.reset();
+    Unmap();
+  }
+
+  /**
+   * Save the given matrix to a file that can be mapped by MappedMatrix.  A
+   * std::runtime_error is thrown if the file can't be written.
+   *
+   * @param filename The file to save to.
+   * @param matrix The matrix to save.
+   */
+  static void Save(const std::string& filename, const arma::Mat<eT>& matrix)
+  {
+    std::ofstream stream(filename.c_str(), std::ios::binary);
+    if (!stream)
+    {
+      throw std::runtime_error("MappedMatrix::Save(): cannot open '" +
+          filename + "' for writing.");
+    }
+
+    CheckpointWriter ar(stream);
+    ar(matrix);
+  }
+
+  //! Get the mapped matrix.
+  const arma::Mat<eT>& Matrix() const { return *matrix; }
+  //! Modify the mapped matrix.  Changes are not written to the file.
+  arma::Mat<eT>& Matrix() { return *matrix; }
+
+  /**
+   * Ask the operating system to start reading the given columns, so that they
+   * are in memory when they are used.  This returns immediately.
+   *
+   * @param begin The first column.
+   * @param n The number of columns.
+   */
+  void Prefetch(const size_t begin, const size_t n) const
+  {
+    #ifdef ENS_HAVE_MMAP
+    Advise(begin, n, MADV_WILLNEED);
+    #else
+    (void) begin;
+    (void) n;
+    #endif
+  }
+
+  /**
+   * Prefetch the given (not necessarily contiguous) columns.  Runs of
+   * consecutive columns are prefetched together.
+   *
+   * @param columns The indices of the columns.
+   */
+  void Prefetch(const arma::uvec& columns) const
+  {
+    size_t first = 0;
+    for (size_t i = 1; i <= columns.n_elem; ++i)
+    {
+      if (i == columns.n_elem || columns[i] != columns[i - 1] + 1)
+      {
+        Prefetch(columns[first], i - first);
+        first = i;
+      }
+    }
+  }
+
+  /**
+   * Tell the operating system that the given columns are not needed for now,
+   * so that their memory can be reused right away.  Any changes made to these
+   * columns through Matrix() are lost.
+   *
+   * @param begin The first column.
+   * @param n The number of columns.
+   */
+  void Release(const size_t begin, const size_t n) const
+  {
+    #ifdef ENS_HAVE_MMAP
+    Advise(begin, n, MADV_DONTNEED);
+    #else
+    (void) begin;
+    (void) n;
+    #endif
+  }
+
+ private:
+  //! The offset of the elements in the file.
+  static size_t HeaderSize() { return 64; }
+
+  #ifdef ENS_HAVE_MMAP
+  //! Give the operating system advice about the pages of the given columns.
+  void Advise(const size_t begin, const size_t n, const int advice) const
+  {
+    if (n == 0 || begin >= matrix->n_cols)
+      return;
+
+    const size_t columnBytes = matrix->n_rows * sizeof(eT);
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t first = HeaderSize() + begin * columnBytes;
+    const size_t last = HeaderSize() +
+        std::min(begin + n, (size_t) matrix->n_cols) * columnBytes;
+    const size_t alignedFirst = first - first % pageSize;
+
+    // The advice is only a hint, so failures are ignored.
+    (void) madvise(address + alignedFirst, last - alignedFirst, advice);
+  }
+  #endif
+
+  //! Remove the mapping, if any.
+  void Unmap()
+  {
+    #ifdef ENS_HAVE_MMAP
+    if (address != NULL)
+      munmap(address, length);
+    #endif
+    address = NULL;
+    length = 0;
+  }
+
+  //! The start of the mapping.
+  char* address;
+  //! The length of the mapping in bytes.
+  size_t length;
+  //! The matrix, an alias of the mapped memory.
+  std::unique_ptr<arma::Mat<eT>> matrix;
+};
+
+/**
+ * PrefetchedFunction wraps a separable function whose data is a MappedMatrix,
+ * and implements PrepareBatch() by prefetching the columns of the batch.  SGD
+ * (and the optimizers based on it) call PrepareBatch() for the next batch while
+ * the current one is being used, so reading the data from disk overlaps with
+ * the computation.  The batches are assumed to be contiguous columns, so the
+ * function should be optimized without shuffling; to visit the points in a
+ * random order, shuffle the columns once before saving the matrix.
+ *
+ * @code
+ * MappedMatrix<double> mapped("data.bin");
+ * LogisticRegressionFunction<> f(mapped.Matrix(), responses);
+ * PrefetchedFunction<LogisticRegressionFunction<>> prefetched(f, mapped);
+ *
+ * StandardSGD sgd(0.01, 256, 10 * responses.n_elem, 1e-5, false);
+ * sgd.Optimize(prefetched, coordinates);
+ * @endcode
+ *
+ * @tparam FunctionType Type of the wrapped separable function.
+ * @tparam eT Type of the elements of the mapped matrix.
+ */
+template<typename FunctionType, typename eT = double>
+class PrefetchedFunction
+{
+ public:
+  /**
+   * Wrap the given function.
+   *
+   * @param function The separable function.
+   * @param data The mapped data used by the function.
+   */
+  PrefetchedFunction(FunctionType& function, const MappedMatrix<eT>& data) :
+      function(function),
+      data(data)
+  { /* Nothing to do here. */ }
+
+  //! Prefetch the columns of the given batch.
+  void PrepareBatch(const size_t begin, const size_t batchSize) const
+  {
+    data.Prefetch(begin, batchSize);
+  }
+
+  //! Return the number of separable functions.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Shuffle the wrapped function.
+  void Shuffle() { function.Shuffle(); }
+
+  //! Evaluate the wrapped function.
+  template<typename MatType>
+  auto Evaluate(const MatType& coordinates) const
+      -> decltype(std::declval<FunctionType&>().Evaluate(coordinates))
+  {
+    return function.Evaluate(coordinates);
+  }
+
+  //! Evaluate the wrapped function on the given batch.
+  template<typename MatType>
+  auto Evaluate(const MatType& coordinates,
+                const size_t begin,
+                const size_t batchSize) const
+      -> decltype(std::declval<FunctionType&>().Evaluate(coordinates, begin,
+          batchSize))
+  {
+    return function.Evaluate(coordinates, begin, batchSize);
+  }
+
+  //! Compute the gradient of the wrapped function.
+  template<typename MatType, typename GradType>
+  auto Gradient(const MatType& coordinates, GradType& gradient) const
+      -> decltype(std::declval<FunctionType&>().Gradient(coordinates,
+          gradient))
+  {
+    function.Gradient(coordinates, gradient);
+  }
+
+  //! Compute the gradient of the wrapped function on the given batch.
+  template<typename MatType, typename GradType>
+  auto Gradient(const MatType& coordinates,
+                const size_t begin,
+                GradType& gradient,
+                const size_t batchSize) const
+      -> decltype(std::declval<FunctionType&>().Gradient(coordinates, begin,
+          gradient, batchSize))
+  {
+    function.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+  //! Evaluate the wrapped function and compute its gradient.
+  template<typename MatType, typename GradType>
+  auto EvaluateWithGradient(const MatType& coordinates,
+                            GradType& gradient) const
+      -> decltype(std::declval<FunctionType&>().EvaluateWithGradient(
+          coordinates, gradient))
+  {
+    return function.EvaluateWithGradient(coordinates, gradient);
+  }
+
+  //! Evaluate the wrapped function and compute its gradient on the given
+  //! batch.
+  template<typename MatType, typename GradType>
+  auto EvaluateWithGradient(const MatType& coordinates,
+                            const size_t begin,
+                            GradType& gradient,
+                            const size_t batchSize) const
+      -> decltype(std::declval<FunctionType&>().EvaluateWithGradient(
+          coordinates, begin, gradient, batchSize))
+  {
+    return function.EvaluateWithGradient(coordinates, begin, gradient,
+        batchSize);
+  }
+
+ private:
+  //! The wrapped function.
+  FunctionType& function;
+  //! The mapped data used by the function.
+  const MappedMatrix<eT>& data;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file objective_feedback.hpp
+ *
+ * Utility to give the objective of each batch to the update policies that use
+ * it (e.g. EveUpdate).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_OBJECTIVE_FEEDBACK_HPP
+#define ENSMALLEN_UTILITY_OBJECTIVE_FEEDBACK_HPP
+
+namespace ens {
+
+namespace traits {
+
+//! Detect an ObjectiveFeedback() method of an instantiated update policy.
+template<typename PolicyType>
+struct HasObjectiveFeedback
+{
+  template<typename U>
+  static auto Check(int) -> decltype(
+      std::declval<U&>().ObjectiveFeedback(0.0), std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<PolicyType>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * Give the objective of the current batch to the given instantiated update
+ * policy, before its Update() is called for the batch.  If the policy has a
+ * method
+ *
+ * @code
+ * void ObjectiveFeedback(const double objective);
+ * @endcode
+ *
+ * then it is called; e.g. EveUpdate scales its step size by the relative
+ * change of the objective.  Otherwise, this does nothing.  The policies that
+ * wrap other policies (e.g. GradientClipping) forward the objective.
+ *
+ * @param policy The instantiated update policy.
+ * @param objective The objective of the current batch.
+ */
+template<typename PolicyType>
+typename std::enable_if<traits::HasObjectiveFeedback<PolicyType>::value>::type
+NotifyObjective(PolicyType& policy, const double objective)
+{
+  policy.ObjectiveFeedback(objective);
+}
+
+//! The policy doesn't use the objective.
+template<typename PolicyType>
+typename std::enable_if<!traits::HasObjectiveFeedback<PolicyType>::value>::type
+NotifyObjective(PolicyType& /* policy */, const double /* objective */)
+{ }
+
+} // namespace ens
+
+#endif
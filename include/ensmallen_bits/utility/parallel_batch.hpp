@@ -0,0 +1,361 @@
+/**
+ * @file parallel_batch.hpp
+ *
+ * Utility to split the evaluation of a separable minibatch across multiple
+ * threads, accumulating into per-thread (or per-chunk) gradient buffers that
+ * are then reduced into a single gradient.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_PARALLEL_BATCH_HPP
+#define ENSMALLEN_UTILITY_PARALLEL_BATCH_HPP
+
+#include "executor.hpp"
+
+#include <stdexcept>
+
+namespace ens {
+
+/**
+ * Return the size of the contiguous ranges that a loop over n items is split
+ * into: chunkSize if it is nonzero, and otherwise the size that gives one range
+ * per available thread.  The result is always at least 1.
+ *
+ * @param n Number of items in the loop.
+ * @param chunkSize Fixed range size, or 0 to use one range per thread.
+ */
+inline size_t RangeSize(const size_t n, const size_t chunkSize = 0)
+{
+  if (chunkSize > 0)
+    return chunkSize;
+
+  const size_t numThreads = std::max(std::min(MaxThreads(), n), (size_t) 1);
+  return std::max((n + numThreads - 1) / numThreads, (size_t) 1);
+}
+
+/**
+ * Return the number of ranges of rangeSize items that a loop over n items is
+ * split into.  The last range may be smaller than the others.
+ */
+inline size_t NumRanges(const size_t n, const size_t rangeSize)
+{
+  return (n + rangeSize - 1) / rangeSize;
+}
+
+/**
+ * Split the loop over [0, n) into NumRanges(n, rangeSize) contiguous ranges,
+ * and call task(r, begin, end) for each range r (covering [begin, end)) with
+ * ParallelFor().
+ *
+ * @param n Number of items in the loop.
+ * @param rangeSize Number of items in each range (see RangeSize()).
+ * @param task Task to call for each range.
+ * @param parallel Whether or not to run the ranges in parallel.
+ */
+template<typename TaskType>
+inline void ParallelForRanges(const size_t n,
+                              const size_t rangeSize,
+                              TaskType&& task,
+                              const bool parallel = true)
+{
+  ParallelFor(NumRanges(n, rangeSize), [&](const size_t r)
+  {
+    const size_t begin = r * rangeSize;
+    task(r, begin, std::min(begin + rangeSize, n));
+  }, parallel);
+}
+
+/**
+ * Sum the first n elements of `values` into values[0] with a fixed pairwise
+ * tree: the association order only depends on n, so the result doesn't depend
+ * on the number of threads that computed the values.  The other elements are
+ * overwritten with partial sums.
+ *
+ * @param values Values to sum (e.g. objectives or gradient buffers).
+ * @param n Number of values to sum.
+ */
+template<typename T>
+inline void PairwiseReduce(std::vector<T>& values, const size_t n)
+{
+  for (size_t stride = 1; stride < n; stride *= 2)
+    for (size_t c = 0; c + stride < n; c += 2 * stride)
+      values[c] += values[c + stride];
+}
+
+/**
+ * Evaluate the objective and gradient of the separable function `function` on
+ * the points [begin, begin + batchSize), splitting the batch into contiguous
+ * ranges that are evaluated on separate threads.  Each range accumulates into
+ * its own buffer in `buffers` (which is resized as needed and can be reused
+ * across calls to avoid allocations), and the buffers are then summed into
+ * `gradient`.
+ *
+ * If `deterministic` is false, the batch is divided into one range per
+ * available thread; the result is then reproducible for a fixed number of
+ * threads.  If `deterministic` is true, the batch is divided into ranges of
+ * `chunkSize` points regardless of the number of threads, and the chunk results
+ * are reduced in a fixed pairwise order, so the result does not depend on the
+ * number of threads or on scheduling.
+ *
+ * Since the given function is called concurrently from multiple threads, its
+ * EvaluateWithGradient() (or Evaluate() and Gradient()) must be safe to call in
+ * parallel on disjoint batches.  If OpenMP is not available, or the batch is
+ * too small to split, this simply calls function.EvaluateWithGradient().
+ *
+ * @param function Separable function to evaluate.
+ * @param iterate Coordinates to evaluate the function at.
+ * @param begin Index of the first point in the batch.
+ * @param gradient Matrix to store the summed gradient into.
+ * @param batchSize Number of points in the batch.
+ * @param buffers Per-thread or per-chunk gradient buffers.
+ * @param deterministic Whether or not the chunking should be independent of the
+ *     number of threads.
+ * @param chunkSize Number of points in each chunk in deterministic mode.
+ * @return Sum of the objectives of all points in the batch.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename MatType::elem_type ParallelEvaluateWithGradient(
+    FunctionType& function,
+    const MatType& iterate,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize,
+    std::vector<GradType>& buffers,
+    const bool deterministic = false,
+    const size_t chunkSize = 32)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("ParallelEvaluateWithGradient(): the batch "
+        "size must be positive");
+  }
+
+  // Determine how many ranges we split the batch into, and how large each range
+  // is.  The last range may be smaller than the others.
+  const size_t rangeSize = RangeSize(batchSize,
+      deterministic ? std::max(chunkSize, (size_t) 1) : 0);
+  const size_t numChunks = NumRanges(batchSize, rangeSize);
+
+  if (numChunks <= 1)
+    return function.EvaluateWithGradient(iterate, begin, gradient, batchSize);
+
+  if (buffers.size() < numChunks)
+    buffers.resize(numChunks);
+  std::vector<ElemType> objectives(numChunks, ElemType(0));
+
+  ParallelForRanges(batchSize, rangeSize,
+      [&](const size_t c, const size_t rangeBegin, const size_t rangeEnd)
+  {
+    objectives[c] = function.EvaluateWithGradient(iterate, begin + rangeBegin,
+        buffers[c], rangeEnd - rangeBegin);
+  });
+
+  // Reduce the buffers.  In deterministic mode we use a fixed pairwise tree so
+  // that the association order depends only on the number of chunks.
+  if (deterministic)
+  {
+    PairwiseReduce(buffers, numChunks);
+    PairwiseReduce(objectives, numChunks);
+
+    gradient = buffers[0];
+    return objectives[0];
+  }
+
+  gradient = buffers[0];
+  ElemType objective = objectives[0];
+  for (size_t c = 1; c < numChunks; ++c)
+  {
+    gradient += buffers[c];
+    objective += objectives[c];
+  }
+
+  return objective;
+}
+
+/**
+ * Evaluate the objective of the separable function `function` on the points
+ * [begin, begin + batchSize), splitting the batch into contiguous ranges that
+ * are evaluated on separate threads, in the same way as
+ * ParallelEvaluateWithGradient().
+ *
+ * @param function Separable function to evaluate.
+ * @param iterate Coordinates to evaluate the function at.
+ * @param begin Index of the first point in the batch.
+ * @param batchSize Number of points in the batch.
+ * @param deterministic Whether or not the chunking should be independent of the
+ *     number of threads.
+ * @param chunkSize Number of points in each chunk in deterministic mode.
+ * @return Sum of the objectives of all points in the batch.
+ */
+template<typename FunctionType, typename MatType>
+typename MatType::elem_type ParallelEvaluate(
+    FunctionType& function,
+    const MatType& iterate,
+    const size_t begin,
+    const size_t batchSize,
+    const bool deterministic = false,
+    const size_t chunkSize = 32)
+{
+  typedef typename MatType::elem_type ElemType;
+
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("ParallelEvaluate(): the batch size must be "
+        "positive");
+  }
+
+  const size_t rangeSize = RangeSize(batchSize,
+      deterministic ? std::max(chunkSize, (size_t) 1) : 0);
+  const size_t numChunks = NumRanges(batchSize, rangeSize);
+
+  if (numChunks <= 1)
+    return function.Evaluate(iterate, begin, batchSize);
+
+  std::vector<ElemType> objectives(numChunks, ElemType(0));
+
+  ParallelForRanges(batchSize, rangeSize,
+      [&](const size_t c, const size_t rangeBegin, const size_t rangeEnd)
+  {
+    objectives[c] = function.Evaluate(iterate, begin + rangeBegin,
+        rangeEnd - rangeBegin);
+  });
+
+  if (deterministic)
+  {
+    PairwiseReduce(objectives, numChunks);
+    return objectives[0];
+  }
+
+  ElemType objective = objectives[0];
+  for (size_t c = 1; c < numChunks; ++c)
+    objective += objectives[c];
+
+  return objective;
+}
+
+/**
+ * Compute the gradient of the separable function `function` on the points
+ * [begin, begin + batchSize), splitting the batch into contiguous ranges that
+ * are computed on separate threads, in the same way as
+ * ParallelEvaluateWithGradient().
+ *
+ * @param function Separable function to differentiate.
+ * @param iterate Coordinates to compute the gradient at.
+ * @param begin Index of the first point in the batch.
+ * @param gradient Matrix to store the summed gradient into.
+ * @param batchSize Number of points in the batch.
+ * @param buffers Per-thread or per-chunk gradient buffers.
+ * @param deterministic Whether or not the chunking should be independent of the
+ *     number of threads.
+ * @param chunkSize Number of points in each chunk in deterministic mode.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+void ParallelGradient(
+    FunctionType& function,
+    const MatType& iterate,
+    const size_t begin,
+    GradType& gradient,
+    const size_t batchSize,
+    std::vector<GradType>& buffers,
+    const bool deterministic = false,
+    const size_t chunkSize = 32)
+{
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("ParallelGradient(): the batch size must be "
+        "positive");
+  }
+
+  const size_t rangeSize = RangeSize(batchSize,
+      deterministic ? std::max(chunkSize, (size_t) 1) : 0);
+  const size_t numChunks = NumRanges(batchSize, rangeSize);
+
+  if (numChunks <= 1)
+  {
+    function.Gradient(iterate, begin, gradient, batchSize);
+    return;
+  }
+
+  if (buffers.size() < numChunks)
+    buffers.resize(numChunks);
+
+  ParallelForRanges(batchSize, rangeSize,
+      [&](const size_t c, const size_t rangeBegin, const size_t rangeEnd)
+  {
+    function.Gradient(iterate, begin + rangeBegin, buffers[c],
+        rangeEnd - rangeBegin);
+  });
+
+  if (deterministic)
+  {
+    PairwiseReduce(buffers, numChunks);
+    gradient = buffers[0];
+    return;
+  }
+
+  gradient = buffers[0];
+  for (size_t c = 1; c < numChunks; ++c)
+    gradient += buffers[c];
+}
+
+/**
+ * Compute the gradient of each batch of the separable functions, i.e. of the
+ * functions [b * batchSize, (b + 1) * batchSize) for each batch b, into
+ * batchGradients[b], and their sum into `gradient`.  The variance reduced
+ * optimizers keep these gradients at the snapshot, so they don't have to
+ * compute them again in their inner loop.  If `parallel` is true, the batches
+ * are spread over threads, so Gradient() must be safe to call concurrently on
+ * different batches.  The batch gradients are summed in order either way, so
+ * the result doesn't depend on the number of threads.
+ *
+ * @param function Separable function to differentiate.
+ * @param iterate Coordinates to compute the gradients at.
+ * @param batchSize Number of functions in each batch (the last batch may be
+ *     smaller).
+ * @param batchGradients Gradients of the batches; resized as needed.
+ * @param gradient Matrix to store the sum of the gradients into.
+ * @param parallel Whether or not to compute the batches in parallel.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+void BatchGradients(FunctionType& function,
+                    const MatType& iterate,
+                    const size_t batchSize,
+                    std::vector<GradType>& batchGradients,
+                    GradType& gradient,
+                    const bool parallel = false)
+{
+  if (batchSize == 0)
+  {
+    throw std::invalid_argument("BatchGradients(): the batch size must be "
+        "positive");
+  }
+
+  const size_t numFunctions = function.NumFunctions();
+  if (numFunctions == 0)
+  {
+    throw std::invalid_argument("BatchGradients(): the function has no "
+        "separable functions");
+  }
+
+  const size_t numBatches = NumRanges(numFunctions, batchSize);
+  batchGradients.resize(numBatches);
+
+  ParallelForRanges(numFunctions, batchSize,
+      [&](const size_t b, const size_t begin, const size_t end)
+  {
+    function.Gradient(iterate, begin, batchGradients[b], end - begin);
+  }, parallel);
+
+  gradient = batchGradients[0];
+  for (size_t b = 1; b < numBatches; ++b)
+    gradient += batchGradients[b];
+}
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * @file partial_gradient_column.hpp
+ *
+ * Utility to compute the column of the partial gradient with respect to one
+ * feature, using the optional PartialGradientColumn() method of the function
+ * when it is available.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_PARTIAL_GRADIENT_COLUMN_HPP
+#define ENSMALLEN_UTILITY_PARTIAL_GRADIENT_COLUMN_HPP
+
+#include <ensmallen_bits/function/traits.hpp>
+
+namespace ens {
+
+/**
+ * Store column j of the partial gradient with respect to feature j in
+ * `column`, which has one element per row of the iterate.  If the FunctionType
+ * has a method
+ *
+ * @code
+ * void PartialGradientColumn(const MatType& iterate,
+ *                            const size_t j,
+ *                            arma::Col<eT>& column);
+ * @endcode
+ *
+ * (const or non-const), then it is used, and `gradient` is not touched; since
+ * `column` keeps its size between calls, this does not allocate memory.
+ * Otherwise, PartialGradient() is called with `gradient`, and its column j is
+ * copied.
+ *
+ * @param function Function to use.
+ * @param iterate Current iterate.
+ * @param j Index of the feature.
+ * @param gradient Matrix for the full partial gradient, if it is needed.
+ * @param column Vector to store the column of the partial gradient into.
+ */
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<traits::HasPartialGradientColumnSignature<
+    FunctionType, MatType>::value, void>::type
+PartialGradientColumn(FunctionType& function,
+                      const MatType& iterate,
+                      const size_t j,
+                      GradType& /* gradient */,
+                      arma::Col<typename MatType::elem_type>& column)
+{
+  function.PartialGradientColumn(iterate, j, column);
+}
+
+//! Compute the full partial gradient and copy its column j.
+template<typename FunctionType, typename MatType, typename GradType>
+typename std::enable_if<!traits::HasPartialGradientColumnSignature<
+    FunctionType, MatType>::value, void>::type
+PartialGradientColumn(FunctionType& function,
+                      const MatType& iterate,
+                      const size_t j,
+                      GradType& gradient,
+                      arma::Col<typename MatType::elem_type>& column)
+{
+  function.PartialGradient(iterate, j, gradient);
+  column = arma::Mat<typename MatType::elem_type>(gradient.col(j));
+}
+
+} // namespace ens
+
+#endif
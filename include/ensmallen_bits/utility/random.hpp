@@ -0,0 +1,239 @@
+/**
+ * @file random.hpp
+ *
+ * A small, fast random number generator with independent seeded streams, used
+ * by the stochastic optimizers.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_RANDOM_HPP
+#define ENSMALLEN_UTILITY_RANDOM_HPP
+
+namespace ens {
+
+/**
+ * RandomStream is a xoshiro256** generator, whose state is set from a seed and
+ * a stream index with splitmix64, so that the streams of different indices are
+ * independent.  The stochastic optimizers (e.g. CMAES, SA, CNE) draw all of
+ * their random numbers from streams that they own, instead of from the global
+ * generator of Armadillo: each candidate or chain that runs on a thread of the
+ * executor (see ParallelFor()) has its own stream, split from the stream of
+ * the optimizer with Split(), so there are no races, and the results only
+ * depend on the seed and not on the number of threads.
+ *
+ * The default constructor seeds the stream from the generator of Armadillo on
+ * the calling thread, so arma::arma_rng::set_seed() still makes the
+ * optimizations reproducible.
+ *
+ * Matrices are filled with FillUniform() and FillNormal(), which first draw
+ * the raw bits of all the elements, and then transform them in a simple loop
+ * over the memory of the matrix that the compiler can vectorize (normal values
+ * use the Box-Muller transform on pairs of elements).
+ *
+ * @code
+ * ens::RandomStream rng;
+ * arma::mat z(10, 5);
+ * rng.FillNormal(z);
+ *
+ * ParallelFor(n, [&](const size_t i)
+ * {
+ *   ens::RandomStream local = rng.Split(i);
+ *   const double u = local.Uniform();
+ *   ...
+ * });
+ * @endcode
+ */
+class RandomStream
+{
+ public:
+  //! Create a stream seeded from the generator of Armadillo.
+  RandomStream()
+  {
+    // Two draws of 31 bits each (randi() is limited to int).
+    const arma::uvec bits = arma::randi<arma::uvec>(2,
+        arma::distr_param(0, std::numeric_limits<int>::max()));
+    Seed((uint64_t(bits(0)) << 31) ^ uint64_t(bits(1)));
+  }
+
+  /**
+   * Create a stream with the given seed and stream index.
+   *
+   * @param seed Seed of the stream.
+   * @param stream Index of the stream.
+   */
+  explicit RandomStream(const uint64_t seed, const uint64_t stream = 0)
+  {
+    Seed(seed, stream);
+  }
+
+  /**
+   * Reset the stream to the given seed and stream index.
+   *
+   * @param seed Seed of the stream.
+   * @param stream Index of the stream.
+   */
+  void Seed(const uint64_t seed, const uint64_t stream = 0)
+  {
+    uint64_t x = Mix(seed) ^ Mix(stream + 0x632be59bd9b4e019ULL);
+    key = x;
+    for (size_t i = 0; i < 4; ++i)
+      state[i] = SplitMix(x);
+  }
+
+  /**
+   * Return an independent stream with the given index, which only depends on
+   * the seed of this stream (not on the numbers drawn from it so far).
+   *
+   * @param stream Index of the new stream.
+   */
+  RandomStream Split(const uint64_t stream) const
+  {
+    return RandomStream(key, stream);
+  }
+
+  //! Return 64 random bits.
+  uint64_t Next()
+  {
+    const uint64_t result = Rotate(state[1] * 5, 7) * 9;
+    const uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = Rotate(state[3], 45);
+    return result;
+  }
+
+  //! Return a uniform random number in [0, 1).
+  template<typename eT = double>
+  eT Uniform() { return ToUniform<eT>(Next()); }
+
+  //! Return a random number from the standard normal distribution.
+  template<typename eT = double>
+  eT Normal()
+  {
+    const eT u = eT(1) - Uniform<eT>();
+    const eT v = Uniform<eT>();
+    return std::sqrt(eT(-2) * std::log(u)) * std::cos(TwoPi<eT>() * v);
+  }
+
+  /**
+   * Return a uniform random integer in [0, n), without bias.
+   *
+   * @param n Number of values; must be positive.
+   */
+  size_t Integer(const size_t n)
+  {
+    const uint64_t range = (uint64_t) n;
+    // Reject the lowest (2^64 mod n) values, so each value is equally likely.
+    const uint64_t threshold = (0 - range) % range;
+    uint64_t r;
+    do
+    {
+      r = Next();
+    } while (r < threshold);
+    return (size_t) (r % range);
+  }
+
+  //! Fill the given dense matrix (or cube) with uniform values in [0, 1).
+  template<typename MatType>
+  void FillUniform(MatType& x)
+  {
+    typedef typename MatType::elem_type eT;
+
+    eT* out = x.memptr();
+    for (size_t i = 0; i < x.n_elem; ++i)
+      out[i] = ToUniform<eT>(Next());
+  }
+
+  //! Fill the given dense matrix (or cube) with values from the standard
+  //! normal distribution.
+  template<typename MatType>
+  void FillNormal(MatType& x)
+  {
+    typedef typename MatType::elem_type eT;
+
+    const size_t n = x.n_elem;
+    const size_t half = n / 2;
+    eT* out = x.memptr();
+    for (size_t i = 0; i < 2 * half; ++i)
+      out[i] = ToUniform<eT>(Next());
+
+    // Box-Muller on the pairs (out[i], out[half + i]).
+    const eT twoPi = TwoPi<eT>();
+    ENS_PRAGMA_OMP_SIMD
+    for (size_t i = 0; i < half; ++i)
+    {
+      const eT r = std::sqrt(eT(-2) * std::log(eT(1) - out[i]));
+      const eT theta = twoPi * out[half + i];
+      out[i] = r * std::cos(theta);
+      out[half + i] = r * std::sin(theta);
+    }
+
+    if (n % 2 == 1)
+      out[n - 1] = Normal<eT>();
+  }
+
+  //! Fill the given dense matrix (or cube) with random signs (+1 or -1 with
+  //! equal probability), using one random bit per element.
+  template<typename MatType>
+  void FillSigns(MatType& x)
+  {
+    typedef typename MatType::elem_type eT;
+
+    eT* out = x.memptr();
+    for (size_t i = 0; i < x.n_elem; i += 64)
+    {
+      const uint64_t bits = Next();
+      const size_t count = std::min((size_t) 64, (size_t) x.n_elem - i);
+      for (size_t j = 0; j < count; ++j)
+        out[i + j] = ((bits >> j) & 1) ? eT(1) : eT(-1);
+    }
+  }
+
+ private:
+  //! Return the next value of a splitmix64 sequence with the given state.
+  static uint64_t SplitMix(uint64_t& x)
+  {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  //! Mix the given value with splitmix64.
+  static uint64_t Mix(uint64_t x) { return SplitMix(x); }
+
+  //! Rotate the given value left by k bits.
+  static uint64_t Rotate(const uint64_t x, const int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  //! Map 64 random bits to [0, 1), with the precision of eT.
+  template<typename eT>
+  static eT ToUniform(const uint64_t bits)
+  {
+    return (sizeof(eT) > 4) ?
+        eT((bits >> 11) * (1.0 / 9007199254740992.0)) :
+        eT(float((bits >> 40) * (1.0f / 16777216.0f)));
+  }
+
+  //! Return 2 pi.
+  template<typename eT>
+  static eT TwoPi() { return eT(6.283185307179586476925286766559); }
+
+  //! The state of the generator.
+  uint64_t state[4];
+
+  //! The key that the streams returned by Split() are derived from.
+  uint64_t key;
+};
+
+} // namespace ens
+
+#endif
@@ -0,0 +1,162 @@
+/**
+ * @file random_permutation.hpp
+ *
+ * A keyed pseudo-random permutation of [0, n) that is evaluated one index at a
+ * time, without storing the permuted order.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_RANDOM_PERMUTATION_HPP
+#define ENSMALLEN_UTILITY_RANDOM_PERMUTATION_HPP
+
+#include "random.hpp"
+
+namespace ens {
+
+/**
+ * RandomPermutation maps [0, n) onto itself with a bijection drawn from a
+ * RandomStream, so that a shuffled visitation order of n items takes O(1)
+ * memory instead of n indices, and each index is mapped in O(1) time.  The
+ * permutation is a balanced Feistel network on the smallest domain of 2^(2h)
+ * values that holds n, whose round functions are keyed hashes of the half
+ * blocks; an index that is mapped outside of [0, n) is mapped again until it
+ * falls inside (cycle walking), which takes fewer than 4 rounds of the network
+ * on average.  Reshuffle() draws new keys, so a new order for each epoch costs
+ * a few random numbers.
+ *
+ * The permutations are not uniformly distributed among all the n!
+ * permutations, but they are indistinguishable from random orders for the
+ * needs of stochastic optimization.  Instead of shuffling a dataset in
+ * Shuffle(), a separable function can also keep a RandomPermutation and visit
+ * the functions through it.
+ *
+ * @code
+ * ens::RandomStream rng(42);
+ * ens::RandomPermutation order(data.n_cols, rng);
+ * for (size_t i = 0; i < data.n_cols; ++i)
+ *   Visit(data.col(order(i)));
+ * order.Reshuffle(rng); // A new order for the next epoch.
+ * @endcode
+ *
+ * For more information, see the following:
+ *
+ * @code
+ * @inproceedings{black2002,
+ *   author    = {Black, John and Rogaway, Phillip},
+ *   title     = {Ciphers with Arbitrary Finite Domains},
+ *   booktitle = {Topics in Cryptology -- CT-RSA 2002},
+ *   year      = {2002},
+ *   pages     = {114--130}
+ * }
+ * @endcode
+ */
+class RandomPermutation
+{
+ public:
+  //! Create the permutation of an empty set.
+  RandomPermutation() : n(0), halfBits(0), mask(0)
+  {
+    for (size_t r = 0; r < Rounds; ++r)
+      keys[r] = 0;
+  }
+
+  /**
+   * Create a random permutation of [0, n).
+   *
+   * @param n Number of items to permute.
+   * @param rng Stream to draw the keys of the permutation from.
+   */
+  RandomPermutation(const size_t n, RandomStream& rng)
+  {
+    Reset(n, rng);
+  }
+
+  /**
+   * Reset to a random permutation of [0, n).
+   *
+   * @param n Number of items to permute.
+   * @param rng Stream to draw the keys of the permutation from.
+   */
+  void Reset(const size_t n, RandomStream& rng)
+  {
+    this->n = (uint64_t) n;
+
+    // The smallest even number of bits (at least 2) that holds n - 1.
+    size_t bits = 2;
+    while (bits < 64 && (this->n - 1) >> bits != 0)
+      bits += 2;
+    halfBits = bits / 2;
+    mask = (halfBits == 32) ? 0xffffffffULL : (uint64_t(1) << halfBits) - 1;
+
+    Reshuffle(rng);
+  }
+
+  //! Draw new keys from the given stream, for a new random permutation.
+  void Reshuffle(RandomStream& rng)
+  {
+    for (size_t r = 0; r < Rounds; ++r)
+      keys[r] = rng.Next();
+  }
+
+  //! Get the number of permuted items.
+  size_t Size() const { return (size_t) n; }
+
+  /**
+   * Return the item at the given position of the permutation.
+   *
+   * @param i Position in [0, Size()).
+   */
+  size_t operator()(const size_t i) const
+  {
+    if (n <= 1)
+      return i;
+
+    uint64_t x = Encrypt((uint64_t) i);
+    while (x >= n)
+      x = Encrypt(x);
+    return (size_t) x;
+  }
+
+ private:
+  //! The number of rounds of the Feistel network.
+  static const size_t Rounds = 4;
+
+  //! Apply the Feistel network to a value of 2 * halfBits bits.
+  uint64_t Encrypt(const uint64_t x) const
+  {
+    uint64_t left = x >> halfBits;
+    uint64_t right = x & mask;
+    for (size_t r = 0; r < Rounds; ++r)
+    {
+      const uint64_t next = left ^ (Hash(right ^ keys[r]) & mask);
+      left = right;
+      right = next;
+    }
+    return (left << halfBits) | right;
+  }
+
+  //! Mix the bits of the given value (the finalizer of splitmix64).
+  static uint64_t Hash(uint64_t z)
+  {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  //! The number of permuted items.
+  uint64_t n;
+  //! The number of bits of each half of the domain of the network.
+  size_t halfBits;
+  //! The mask of the bits of a half.
+  uint64_t mask;
+  //! The keys of the rounds.
+  uint64_t keys[Rounds];
+};
+
+} // namespace ens
+
+#endif
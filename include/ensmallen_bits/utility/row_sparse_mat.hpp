@@ -0,0 +1,245 @@
+/**
+ * @file row_sparse_mat.hpp
+ *
+ * A gradient type for functions whose gradient is nonzero in only a few rows,
+ * each of which is dense (e.g. the gradient of an embedding table).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_ROW_SPARSE_MAT_HPP
+#define ENSMALLEN_UTILITY_ROW_SPARSE_MAT_HPP
+
+namespace ens {
+
+/**
+ * RowSparseMat is an n_rows x n_cols matrix in which only some rows (the
+ * touched rows) can be nonzero.  It stores the indices of the touched rows,
+ * in the order in which they were touched, and their values as a dense block
+ * of n_cols elements per touched row.  Row() returns the values of a row,
+ * touching it (with zeros) if needed, so the Gradient() of an embedding
+ * lookup can accumulate into the rows of the batch only:
+ *
+ * @code
+ * void Gradient(const arma::mat& x, const size_t begin,
+ *               ens::RowSparseMat<double>& g, const size_t batchSize)
+ * {
+ *   g.zeros(x.n_rows, x.n_cols);
+ *   for (size_t i = begin; i < begin + batchSize; ++i)
+ *   {
+ *     double* row = g.Row(ids[i]);
+ *     for (size_t c = 0; c < x.n_cols; ++c)
+ *       row[c] += ...;
+ *   }
+ * }
+ * @endcode
+ *
+ * A RowSparseMat can be used as the GradType of SGD (with VanillaUpdate,
+ * MomentumUpdate, NesterovMomentumUpdate, AdaGradUpdate, AdamUpdate or
+ * LazyAdamUpdate, whose state is then dense; see UseSparseUpdate) and of
+ * ParallelSGD, with a dense iterate.  Except for AdamUpdate, which decays all
+ * of its moments in each step, the update then costs O(touched rows x n_cols).
+ *
+ * zeros() only clears the touched rows, so a gradient that is reused for each
+ * batch costs nothing to reset; to find a row in constant time, the matrix
+ * keeps an index of n_rows entries, which is only allocated when the size
+ * changes.
+ *
+ * @tparam eT Type of the elements of the matrix.
+ */
+template<typename eT>
+class RowSparseMat
+{
+ public:
+  //! The type of the elements (as for Armadillo matrices).
+  typedef eT elem_type;
+
+  //! Create an empty matrix.
+  RowSparseMat() : n_rows(0), n_cols(0), n_elem(0) { }
+
+  /**
+   * Create a matrix of the given size, without any touched row.
+   *
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   */
+  RowSparseMat(const size_t rows, const size_t cols) :
+      n_rows(0), n_cols(0), n_elem(0)
+  {
+    zeros(rows, cols);
+  }
+
+  //! Copy the given matrix.
+  RowSparseMat(const RowSparseMat& other) : n_rows(0), n_cols(0), n_elem(0)
+  {
+    *this = other;
+  }
+
+  //! Copy the given matrix; if it has the same size, this only takes time
+  //! proportional to the touched rows of both matrices.
+  RowSparseMat& operator=(const RowSparseMat& other)
+  {
+    if (this == &other)
+      return *this;
+
+    zeros(other.n_rows, other.n_cols);
+    for (size_t k = 0; k < other.rows.size(); ++k)
+    {
+      const eT* values = other.RowValues(k);
+      std::copy(values, values + n_cols, Row(other.rows[k]));
+    }
+
+    return *this;
+  }
+
+  /**
+   * Set the size of the matrix, and make all of its elements zero.  If the
+   * size doesn't change, only the touched rows are cleared, and the memory is
+   * kept for the next touched rows.
+   *
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   */
+  void zeros(const size_t rows, const size_t cols)
+  {
+    if (rows != n_rows || cols != n_cols)
+    {
+      n_rows = rows;
+      n_cols = cols;
+      n_elem = rows * cols;
+      slots.assign(rows, NoSlot());
+      this->rows.clear();
+      values.clear();
+      return;
+    }
+
+    for (size_t k = 0; k < this->rows.size(); ++k)
+      slots[this->rows[k]] = NoSlot();
+    this->rows.clear();
+    values.clear();
+  }
+
+  //! Make all the elements zero, keeping the size.
+  void zeros() { zeros(n_rows, n_cols); }
+
+  /**
+   * Return the n_cols values of the given row, touching it (with zeros) if it
+   * wasn't yet.  The pointer is valid until the next row is touched.
+   *
+   * @param row Index of the row.
+   */
+  eT* Row(const size_t row)
+  {
+    size_t slot = slots[row];
+    if (slot == NoSlot())
+    {
+      slot = rows.size();
+      slots[row] = slot;
+      rows.push_back(row);
+      values.resize(values.size() + n_cols, eT(0));
+    }
+
+    return values.data() + slot * n_cols;
+  }
+
+  //! Get the number of touched rows.
+  size_t NumTouchedRows() const { return rows.size(); }
+
+  //! Get the index of the k'th touched row.
+  size_t RowIndex(const size_t k) const { return rows[k]; }
+
+  //! Get the n_cols values of the k'th touched row.
+  const eT* RowValues(const size_t k) const
+  {
+    return values.data() + k * n_cols;
+  }
+  //! Modify the n_cols values of the k'th touched row.
+  eT* RowValues(const size_t k) { return values.data() + k * n_cols; }
+
+  /**
+   * Add the given matrix, which must have the same size, to this one; the
+   * rows that are only touched in the given matrix are touched here.  A
+   * std::invalid_argument is thrown if the sizes differ.
+   *
+   * @param other Matrix to add.
+   */
+  RowSparseMat& operator+=(const RowSparseMat& other)
+  {
+    if (other.n_rows != n_rows || other.n_cols != n_cols)
+    {
+      throw std::invalid_argument("RowSparseMat::operator+=(): the matrices "
+          "must have the same size.");
+    }
+
+    for (size_t k = 0; k < other.rows.size(); ++k)
+    {
+      const eT* o = other.RowValues(k);
+      eT* r = Row(other.rows[k]);
+      for (size_t c = 0; c < n_cols; ++c)
+        r[c] += o[c];
+    }
+
+    return *this;
+  }
+
+  //! Return the matrix as a dense Armadillo matrix.
+  arma::Mat<eT> Dense() const
+  {
+    arma::Mat<eT> dense(n_rows, n_cols, arma::fill::zeros);
+    for (size_t k = 0; k < rows.size(); ++k)
+    {
+      const eT* r = RowValues(k);
+      for (size_t c = 0; c < n_cols; ++c)
+        dense(rows[k], c) = r[c];
+    }
+
+    return dense;
+  }
+
+  //! The number of rows.
+  size_t n_rows;
+  //! The number of columns.
+  size_t n_cols;
+  //! The number of elements (touched or not).
+  size_t n_elem;
+
+ private:
+  //! The slot of the rows that aren't touched.
+  static size_t NoSlot() { return std::numeric_limits<size_t>::max(); }
+
+  //! The indices of the touched rows, in the order in which they were touched.
+  std::vector<size_t> rows;
+  //! The values of the touched rows, n_cols per row, in the same order.
+  std::vector<eT> values;
+  //! The slot (position in rows) of each row, or NoSlot().
+  std::vector<size_t> slots;
+};
+
+/**
+ * Call kernel(i, g) for each element g of the touched rows of the given
+ * gradient, where i is the index of that element in the (column-major) memory
+ * of a dense matrix of the same size, as ForEachNonzero() does for the
+ * nonzero elements of a sparse matrix (see fused_update.hpp).
+ *
+ * @param gradient The row-sparse gradient.
+ * @param kernel Kernel to call for each element of the touched rows.
+ */
+template<typename eT, typename KernelType>
+inline void ForEachNonzero(const RowSparseMat<eT>& gradient,
+                           KernelType&& kernel)
+{
+  const size_t nRows = gradient.n_rows;
+  for (size_t k = 0; k < gradient.NumTouchedRows(); ++k)
+  {
+    const size_t row = gradient.RowIndex(k);
+    const eT* values = gradient.RowValues(k);
+    for (size_t c = 0; c < gradient.n_cols; ++c)
+      kernel(row + c * nRows, values[c]);
+  }
+}
+
+} // namespace ens
+
+#endif
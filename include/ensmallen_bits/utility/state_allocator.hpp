@@ -0,0 +1,370 @@
+/**
+ * @file state_allocator.hpp
+ *
+ * A hook to allocate the large state of the optimizers and of their update
+ * policies (e.g. the moments of Adam) in huge pages, possibly interleaved over
+ * the NUMA nodes.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_STATE_ALLOCATOR_HPP
+#define ENSMALLEN_UTILITY_STATE_ALLOCATOR_HPP
+
+#include <ensmallen_bits/utility/fused_update.hpp>
+#include <memory>
+
+#if defined(__linux__) && !defined(ENS_DISABLE_HUGE_PAGES)
+  #define ENS_HAVE_HUGE_PAGES
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace ens {
+
+/**
+ * A StateAllocator provides the memory of the large dense matrices that hold
+ * the state of an optimization: the moment estimates of AdamUpdate, the
+ * velocity of MomentumUpdate, and the history of L_BFGS.  By default, no
+ * allocator is set and these matrices use the memory of Armadillo; an
+ * allocator can be set with SetStateAllocator().  An allocator implements
+ *
+ * @code
+ * void* Allocate(const size_t bytes);
+ * void Deallocate(void* memory, const size_t bytes);
+ * @endcode
+ *
+ * where Allocate() returns memory for the given number of bytes, aligned to at
+ * least 64 bytes, or NULL to let Armadillo allocate the matrix (e.g. because
+ * it is small), and Deallocate() frees memory returned by Allocate() for the
+ * same number of bytes.
+ */
+class StateAllocator
+{
+ public:
+  //! Nothing to clean.
+  virtual ~StateAllocator() { }
+
+  //! Return memory for the given number of bytes, or NULL.
+  virtual void* Allocate(const size_t bytes) = 0;
+
+  //! Free memory returned by Allocate() for the given number of bytes.
+  virtual void Deallocate(void* memory, const size_t bytes) = 0;
+};
+
+/**
+ * HugePageAllocator maps the state in huge pages, which reduces the TLB misses
+ * of the update kernels on large iterates.  Pages of the given size are
+ * requested from the reserved huge pages of the system (see
+ * /proc/sys/vm/nr_hugepages); if none are available, the memory is mapped in
+ * regular pages and marked for transparent huge pages instead.  With
+ * `interleave`, the pages are interleaved over all NUMA nodes, which spreads
+ * the memory bandwidth of a parallel update over the nodes.  Otherwise, pages
+ * are placed on the node of the thread that first touches them: the state is
+ * zeroed with FusedForEach(), so each page lands on the node of the thread
+ * that runs the fused update kernels on it (see SetFusedUpdateThreshold()).
+ *
+ * @code
+ * ens::SetStateAllocator(std::make_shared<ens::HugePageAllocator>());
+ * @endcode
+ *
+ * Huge pages are only available on Linux (and can be disabled by defining
+ * ENS_DISABLE_HUGE_PAGES); elsewhere, Allocate() returns NULL, so Armadillo
+ * allocates the state as usual.
+ */
+class HugePageAllocator : public StateAllocator
+{
+ public:
+  /**
+   * Set up the allocator.
+   *
+   * @param minBytes Matrices smaller than this are left to Armadillo.
+   * @param pageSize Size of the huge pages (2MB or 1GB on x86-64).
+   * @param interleave Whether to interleave the pages over the NUMA nodes.
+   */
+  HugePageAllocator(const size_t minBytes = (size_t) 1 << 24,
+                    const size_t pageSize = (size_t) 1 << 21,
+                    const bool interleave = false) :
+      minBytes(minBytes),
+      pageSize(pageSize),
+      interleave(interleave)
+  { /* Nothing to do. */ }
+
+  //! Map memory for the given number of bytes, or return NULL if it is too
+  //! small or can't be mapped.
+  void* Allocate(const size_t bytes)
+  {
+    #ifdef ENS_HAVE_HUGE_PAGES
+    if (bytes == 0 || bytes < minBytes)
+      return NULL;
+
+    const size_t length = Length(bytes);
+    const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    void* memory = MAP_FAILED;
+    #ifdef MAP_HUGETLB
+    memory = mmap(NULL, length, PROT_READ | PROT_WRITE,
+        flags | MAP_HUGETLB | PageSizeFlag(), -1, 0);
+    #endif
+    if (memory == MAP_FAILED)
+    {
+      // No huge pages of that size are reserved: fall back to transparent huge
+      // pages.
+      memory = mmap(NULL, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if (memory == MAP_FAILED)
+        return NULL;
+      #ifdef MADV_HUGEPAGE
+      madvise(memory, length, MADV_HUGEPAGE);
+      #endif
+    }
+
+    if (interleave)
+      InterleavePages(memory, length);
+    return memory;
+    #else
+    (void) bytes;
+    return NULL;
+    #endif
+  }
+
+  //! Unmap memory returned by Allocate().
+  void Deallocate(void* memory, const size_t bytes)
+  {
+    #ifdef ENS_HAVE_HUGE_PAGES
+    munmap(memory, Length(bytes));
+    #else
+    (void) memory;
+    (void) bytes;
+    #endif
+  }
+
+  //! Get the size below which matrices are left to Armadillo.
+  size_t MinBytes() const { return minBytes; }
+  //! Modify the size below which matrices are left to Armadillo.
+  size_t& MinBytes() { return minBytes; }
+
+  //! Get the size of the huge pages.
+  size_t PageSize() const { return pageSize; }
+  //! Modify the size of the huge pages.
+  size_t& PageSize() { return pageSize; }
+
+  //! Get whether the pages are interleaved over the NUMA nodes.
+  bool Interleave() const { return interleave; }
+  //! Modify whether the pages are interleaved over the NUMA nodes.
+  bool& Interleave() { return interleave; }
+
+ private:
+  //! Return the given size rounded up to a multiple of the page size.
+  size_t Length(const size_t bytes) const
+  {
+    const size_t page = std::max(pageSize, (size_t) 4096);
+    return (bytes + page - 1) / page * page;
+  }
+
+  #ifdef ENS_HAVE_HUGE_PAGES
+  //! Return the flags of mmap() that select the page size.
+  int PageSizeFlag() const
+  {
+    #ifdef MAP_HUGE_SHIFT
+    int log = 0;
+    while (((size_t) 2 << log) <= pageSize)
+      ++log;
+    return log << MAP_HUGE_SHIFT;
+    #else
+    return 0;
+    #endif
+  }
+
+  //! Interleave the pages of the given mapping over all NUMA nodes.  This is
+  //! only a hint, so errors (e.g. on a kernel without NUMA) are ignored.
+  static void InterleavePages(void* memory, const size_t length)
+  {
+    #ifdef SYS_mbind
+    // MPOL_INTERLEAVE of <linux/mempolicy.h>; the kernel drops the nodes of the
+    // mask that have no memory.
+    const int mpolInterleave = 3;
+    const unsigned long nodes = ~0UL;
+    syscall(SYS_mbind, memory, length, mpolInterleave, &nodes,
+        8 * sizeof(nodes) + 1, 0);
+    #else
+    (void) memory;
+    (void) length;
+    #endif
+  }
+  #endif
+
+  //! The size below which matrices are left to Armadillo.
+  size_t minBytes;
+  //! The size of the huge pages.
+  size_t pageSize;
+  //! Whether the pages are interleaved over the NUMA nodes.
+  bool interleave;
+};
+
+//! Return the storage of the allocator set with SetStateAllocator().
+inline std::shared_ptr<StateAllocator>& StateAllocatorStorage()
+{
+  static std::shared_ptr<StateAllocator> allocator;
+  return allocator;
+}
+
+/**
+ * Set the allocator of the state of the optimizers and of the update policies;
+ * nullptr restores the memory of Armadillo.  The state allocated before is
+ * still freed by the allocator that allocated it.  This must not be called
+ * while an optimization runs.
+ *
+ * @param allocator The allocator to use, or nullptr.
+ */
+inline void SetStateAllocator(std::shared_ptr<StateAllocator> allocator)
+{
+  StateAllocatorStorage() = std::move(allocator);
+}
+
+//! Return the allocator set with SetStateAllocator(), or NULL if none is set.
+inline StateAllocator* CurrentStateAllocator()
+{
+  return StateAllocatorStorage().get();
+}
+
+/**
+ * StateMemory owns the memory that the current StateAllocator provides for one
+ * matrix of state.  The matrix uses that memory as (non-strict) auxiliary
+ * memory, so the StateMemory must be declared before the matrix, and outlive
+ * it.  A copy of a StateMemory is empty, since the copy of the matrix gets
+ * memory of its own, while moving it moves the memory along with the matrix.
+ * If the matrix is later resized, it stops using the memory, which is then
+ * only freed with the StateMemory.
+ *
+ * @code
+ * StateMemory mMemory;
+ * arma::mat m;
+ * mMemory.Zeros(m, rows, cols);
+ * @endcode
+ */
+class StateMemory
+{
+ public:
+  //! Create an empty StateMemory.
+  StateMemory() : memory(NULL), bytes(0) { }
+
+  //! The copy of the matrix has memory of its own, so the copy is empty.
+  StateMemory(const StateMemory& /* other */) : memory(NULL), bytes(0) { }
+
+  //! Take the memory of the given StateMemory, which moving the matrix takes.
+  StateMemory(StateMemory&& other) :
+      allocator(std::move(other.allocator)),
+      memory(other.memory),
+      bytes(other.bytes)
+  {
+    other.memory = NULL;
+    other.bytes = 0;
+  }
+
+  //! Keep the memory: copy assignment of the matrix keeps it if the sizes
+  //! match.
+  StateMemory& operator=(const StateMemory& /* other */) { return *this; }
+
+  //! Take the memory of the given StateMemory, which move assignment of the
+  //! matrix takes.
+  StateMemory& operator=(StateMemory&& other)
+  {
+    if (this != &other)
+    {
+      Reset();
+      allocator = std::move(other.allocator);
+      memory = other.memory;
+      bytes = other.bytes;
+      other.memory = NULL;
+      other.bytes = 0;
+    }
+    return *this;
+  }
+
+  //! Free the memory.
+  ~StateMemory() { Reset(); }
+
+  /**
+   * Set the given matrix to a zero matrix of the given size, in memory of the
+   * current StateAllocator if it provides any.  The zeros are written with
+   * FusedForEach(), so that the pages are first touched by the threads that
+   * run the fused update kernels.
+   *
+   * @param matrix Matrix to set.
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   */
+  template<typename eT>
+  void Zeros(arma::Mat<eT>& matrix, const size_t rows, const size_t cols)
+  {
+    StateAllocator* current = CurrentStateAllocator();
+    const size_t size = rows * cols * sizeof(eT);
+    eT* newMemory = (current == NULL || size == 0) ? NULL :
+        static_cast<eT*>(current->Allocate(size));
+
+    if (newMemory == NULL)
+    {
+      matrix.zeros(rows, cols);
+      if (matrix.memptr() != memory)
+        Reset();
+      return;
+    }
+
+    FusedForEach(rows * cols, [&](const size_t begin, const size_t end)
+    {
+      std::fill(newMemory + begin, newMemory + end, eT(0));
+    });
+    matrix = arma::Mat<eT>(newMemory, rows, cols, false, false);
+
+    // The moved matrix normally keeps using the memory; if it doesn't, the
+    // memory is freed now.
+    if (matrix.memptr() == newMemory)
+    {
+      Reset();
+      allocator = StateAllocatorStorage();
+      memory = newMemory;
+      bytes = size;
+    }
+    else
+    {
+      current->Deallocate(newMemory, size);
+      if (matrix.memptr() != memory)
+        Reset();
+    }
+  }
+
+  //! Set any other type of matrix to zeros of the given size; the memory of
+  //! the matrix type is used.
+  template<typename MatType>
+  void Zeros(MatType& matrix, const size_t rows, const size_t cols)
+  {
+    matrix.zeros(rows, cols);
+  }
+
+  //! Return whether the memory of a StateAllocator is held.
+  bool Empty() const { return memory == NULL; }
+
+ private:
+  //! Free the held memory, if any.
+  void Reset()
+  {
+    if (memory != NULL)
+      allocator->Deallocate(memory, bytes);
+    allocator.reset();
+    memory = NULL;
+    bytes = 0;
+  }
+
+  //! The allocator of the memory.
+  std::shared_ptr<StateAllocator> allocator;
+  //! The held memory.
+  void* memory;
+  //! The size of the held memory.
+  size_t bytes;
+};
+
+} // namespace ens
+
+#endif
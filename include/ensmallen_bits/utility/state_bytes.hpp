@@ -0,0 +1,131 @@
+/**
+ * @file state_bytes.hpp
+ *
+ * Estimates of the memory that the optimizers and their policies keep for an
+ * optimization.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_STATE_BYTES_HPP
+#define ENSMALLEN_UTILITY_STATE_BYTES_HPP
+
+namespace ens {
+
+/**
+ * Return the number of bytes of the elements of a dense matrix of the given
+ * type and size.  This is also used for the state of sparse types, for which
+ * it is an upper bound.
+ *
+ * @tparam MatType Type of the matrix.
+ * @param rows Number of rows.
+ * @param cols Number of columns.
+ */
+template<typename MatType>
+inline size_t MatrixBytes(const size_t rows, const size_t cols)
+{
+  return rows * cols * sizeof(typename MatType::elem_type);
+}
+
+namespace traits {
+
+//! Detect a StateBytes() method for the given matrix types.
+template<typename T, typename MatType, typename GradType>
+struct HasStateBytes
+{
+  template<typename U>
+  static auto Check(int) -> decltype(std::declval<const U&>().template
+      StateBytes<MatType, GradType>(size_t(), size_t()), std::true_type());
+
+  template<typename U>
+  static std::false_type Check(...);
+
+  static const bool value = decltype(Check<T>(0))::value;
+};
+
+} // namespace traits
+
+/**
+ * The value that StateBytes() returns for an optimizer that doesn't estimate
+ * its state.  It is distinct from 0, so that an optimizer without an estimate
+ * is never mistaken for one that keeps no state.
+ */
+const size_t UnknownStateBytes = size_t(-1);
+
+/**
+ * Return the number of bytes that the given optimizer or policy keeps for the
+ * optimization of coordinates of the given size, with its StateBytes() method:
+ *
+ * @code
+ * template<typename MatType, typename GradType = MatType>
+ * size_t StateBytes(const size_t rows, const size_t cols) const;
+ * @endcode
+ *
+ * This counts the state and the buffers that are proportional to the size of
+ * the coordinates (e.g. the moment estimates of AdamUpdate), but not the
+ * coordinates themselves, nor the memory of the function.  If the object has
+ * no StateBytes() method, UnknownStateBytes is returned; use
+ * PolicyStateBytes() for policies, which keep no state in that case.
+ *
+ * @code
+ * Adam adam;
+ * const size_t bytes = StateBytes<arma::mat>(adam, 1000, 1000);
+ * @endcode
+ *
+ * @param object The optimizer or policy.
+ * @param rows Number of rows of the coordinates.
+ * @param cols Number of columns of the coordinates.
+ */
+template<typename MatType, typename GradType = MatType, typename T>
+inline typename std::enable_if<traits::HasStateBytes<T, MatType,
+    GradType>::value, size_t>::type
+StateBytes(const T& object, const size_t rows, const size_t cols)
+{
+  return object.template StateBytes<MatType, GradType>(rows, cols);
+}
+
+//! The state of objects without a StateBytes() method is unknown.
+template<typename MatType, typename GradType = MatType, typename T>
+inline typename std::enable_if<!traits::HasStateBytes<T, MatType,
+    GradType>::value, size_t>::type
+StateBytes(const T& /* object */,
+           const size_t /* rows */,
+           const size_t /* cols */)
+{
+  return UnknownStateBytes;
+}
+
+/**
+ * Return the number of bytes that the given policy (e.g. an update, decay,
+ * line search or step size policy) keeps for coordinates of the given size,
+ * with its StateBytes() method.  Policies without a StateBytes() method (e.g.
+ * VanillaUpdate) keep no such state, so 0 is returned for them.
+ *
+ * @param policy The policy.
+ * @param rows Number of rows of the coordinates.
+ * @param cols Number of columns of the coordinates.
+ */
+template<typename MatType, typename GradType = MatType, typename T>
+inline typename std::enable_if<traits::HasStateBytes<T, MatType,
+    GradType>::value, size_t>::type
+PolicyStateBytes(const T& policy, const size_t rows, const size_t cols)
+{
+  return policy.template StateBytes<MatType, GradType>(rows, cols);
+}
+
+//! Policies without a StateBytes() method keep no state.
+template<typename MatType, typename GradType = MatType, typename T>
+inline typename std::enable_if<!traits::HasStateBytes<T, MatType,
+    GradType>::value, size_t>::type
+PolicyStateBytes(const T& /* policy */,
+                 const size_t /* rows */,
+                 const size_t /* cols */)
+{
+  return 0;
+}
+
+} // namespace ens
+
+#endif
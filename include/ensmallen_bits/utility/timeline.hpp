@@ -0,0 +1,445 @@
+/**
+ * @file timeline.hpp
+ *
+ * A timeline of the phases of an optimization and of its parallel tasks on
+ * each thread, recorded when ENS_TIMELINE is defined and written in the Chrome
+ * trace format.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef ENSMALLEN_UTILITY_TIMELINE_HPP
+#define ENSMALLEN_UTILITY_TIMELINE_HPP
+
+#include <fstream>
+
+namespace ens {
+
+/**
+ * A Timeline records the begin and end events of named intervals on each
+ * thread, e.g. the phases of SGD or the tasks of a parallel loop, so that the
+ * stalls of a parallel optimization can be seen on a timeline instead of
+ * being averaged away by the totals of the Profiler callback.  The events are
+ * written with WriteChromeTrace() or Save() as a Chrome trace (JSON), which
+ * chrome://tracing and the Perfetto UI (https://ui.perfetto.dev) can open.
+ *
+ * Each thread records into a buffer of its own, which it finds through a
+ * thread-local cache, so recording an event takes no lock and no atomic
+ * operation: only a clock read and a store (tens of nanoseconds).  The buffer
+ * of a thread is registered with the timeline (under a lock) the first time
+ * the thread records an event.  Each thread records at most `maxEvents`
+ * events; the later ones are dropped and counted (see Dropped()), so the
+ * trace may then end with intervals that are still open.
+ *
+ * The names of the events are not copied, so they must outlive the timeline
+ * (e.g. string literals).  Recording may happen on any number of threads at
+ * the same time, but Events(), WriteChromeTrace(), Save() and Clear() must not
+ * be called while events are recorded, e.g. during an optimization.
+ *
+ * When ENS_TIMELINE is defined, the optimizers record their phases (see Phase)
+ * and the time spent in the callbacks, ParallelFor() records each of its
+ * tasks, and ParallelSGD records the gradient and update of each batch, into
+ * the timeline set with SetTimeline(); functions can record their own
+ * intervals with ENS_TIMELINE_SCOPE().  Without ENS_TIMELINE, these all
+ * compile to nothing.
+ *
+ * @code
+ * #define ENS_TIMELINE
+ * #include <ensmallen.hpp>
+ *
+ * std::shared_ptr<ens::Timeline> timeline =
+ *     std::make_shared<ens::Timeline>();
+ * ens::SetTimeline(timeline);
+ * optimizer.Optimize(f, coordinates);
+ * ens::SetTimeline(nullptr);
+ * timeline->Save("trace.json");
+ * @endcode
+ */
+class Timeline
+{
+ public:
+  /**
+   * Create an empty timeline; its clock starts now.
+   *
+   * @param maxEvents Maximum number of events recorded by each thread.
+   */
+  Timeline(const size_t maxEvents = 1000000) :
+      maxEvents(maxEvents),
+      id(NextId()),
+      start(std::chrono::steady_clock::now())
+  { /* Nothing to do. */ }
+
+  //! A timeline can't be copied, since threads cache their buffers.
+  Timeline(const Timeline&) = delete;
+  //! A timeline can't be copied, since threads cache their buffers.
+  Timeline& operator=(const Timeline&) = delete;
+
+  //! Record the beginning of the given interval on the calling thread.
+  void Begin(const char* name) { Record(name, 'B'); }
+
+  //! Record the end of the given interval on the calling thread.
+  void End(const char* name) { Record(name, 'E'); }
+
+  //! Record an instant event on the calling thread.
+  void Instant(const char* name) { Record(name, 'i'); }
+
+  //! Give a name to the calling thread (the default is "thread <index>",
+  //! where the index is the order in which the threads started recording).
+  void NameThread(const std::string& name) { LocalBuffer().name = name; }
+
+  //! Get the number of recorded events.
+  size_t Events() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t events = 0;
+    for (size_t i = 0; i < buffers.size(); ++i)
+      events += buffers[i]->events;
+    return events;
+  }
+
+  //! Get the number of events that were dropped because a thread had already
+  //! recorded MaxEvents() events.
+  size_t Dropped() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t dropped = 0;
+    for (size_t i = 0; i < buffers.size(); ++i)
+      dropped += buffers[i]->dropped;
+    return dropped;
+  }
+
+  //! Get the number of threads that recorded events.
+  size_t Threads() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return buffers.size();
+  }
+
+  //! Get the maximum number of events recorded by each thread.
+  size_t MaxEvents() const { return maxEvents; }
+  //! Modify the maximum number of events recorded by each thread.
+  size_t& MaxEvents() { return maxEvents; }
+
+  //! Forget all the recorded events, and restart the clock; the threads and
+  //! their names are kept.
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+      buffers[i]->chunks.clear();
+      buffers[i]->used = ChunkSize;
+      buffers[i]->events = 0;
+      buffers[i]->dropped = 0;
+    }
+    start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * Write the recorded events as a Chrome trace: a JSON object whose
+   * "traceEvents" array holds the name of each thread, and then the events of
+   * each thread in the order they were recorded, with their time since the
+   * start of the timeline in microseconds.
+   *
+   * @param out The output stream.
+   */
+  void WriteChromeTrace(std::ostream& out) const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+      const ThreadBuffer& buffer = *buffers[i];
+      out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\","
+          << "\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.index
+          << ",\"args\":{\"name\":";
+      if (buffer.name.empty())
+        WriteString(out, "thread " + std::to_string(buffer.index));
+      else
+        WriteString(out, buffer.name);
+      out << "}}";
+      first = false;
+    }
+
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+      const ThreadBuffer& buffer = *buffers[i];
+      for (size_t e = 0; e < buffer.events; ++e)
+      {
+        const Event& event = buffer.chunks[e / ChunkSize][e % ChunkSize];
+        out << ",\n{\"name\":";
+        WriteString(out, event.name);
+        out << ",\"cat\":\"ensmallen\",\"ph\":\"" << event.type << "\","
+            << "\"ts\":" << (event.time / 1000) << '.'
+            << (char) ('0' + event.time / 100 % 10)
+            << (char) ('0' + event.time / 10 % 10)
+            << (char) ('0' + event.time % 10)
+            << ",\"pid\":1,\"tid\":" << buffer.index;
+        if (event.type == 'i')
+          out << ",\"s\":\"t\"";
+        out << "}";
+      }
+    }
+    out << "\n]}\n";
+  }
+
+  /**
+   * Write the recorded events as a Chrome trace into the given file.  A
+   * std::runtime_error is thrown if the file can't be written.
+   *
+   * @param filename The name of the file.
+   */
+  void Save(const std::string& filename) const
+  {
+    std::ofstream out(filename.c_str());
+    if (!out.is_open())
+    {
+      throw std::runtime_error("Timeline::Save(): could not open '" +
+          filename + "' for writing");
+    }
+
+    WriteChromeTrace(out);
+    out.close();
+    if (out.fail())
+    {
+      throw std::runtime_error("Timeline::Save(): could not write '" +
+          filename + "'");
+    }
+  }
+
+ private:
+  //! The number of events of each block of a buffer.
+  static constexpr size_t ChunkSize = 4096;
+
+  //! A recorded event.
+  struct Event
+  {
+    //! The name of the interval.
+    const char* name;
+    //! The time since the start of the timeline, in nanoseconds.
+    uint64_t time;
+    //! The type of the event in the Chrome trace: 'B', 'E' or 'i'.
+    char type;
+  };
+
+  //! The events of one thread, in blocks that are never moved.
+  struct ThreadBuffer
+  {
+    ThreadBuffer(const std::thread::id thread, const size_t index) :
+        thread(thread), index(index), used(ChunkSize), events(0), dropped(0)
+    { }
+
+    //! The thread that records into this buffer.
+    std::thread::id thread;
+    //! The index of the thread in the trace.
+    size_t index;
+    //! The name of the thread, if it was given one.
+    std::string name;
+    //! The blocks of events.
+    std::vector<std::unique_ptr<Event[]>> chunks;
+    //! The number of events in the last block.
+    size_t used;
+    //! The number of recorded events.
+    size_t events;
+    //! The number of dropped events.
+    size_t dropped;
+  };
+
+  //! Record an event of the given type on the calling thread.
+  void Record(const char* name, const char type)
+  {
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    ThreadBuffer& buffer = LocalBuffer();
+    if (buffer.events >= maxEvents)
+    {
+      ++buffer.dropped;
+      return;
+    }
+
+    if (buffer.used == ChunkSize)
+    {
+      buffer.chunks.emplace_back(new Event[ChunkSize]);
+      buffer.used = 0;
+    }
+
+    Event& event = buffer.chunks.back()[buffer.used++];
+    event.name = name;
+    event.time = (uint64_t) std::chrono::duration_cast<
+        std::chrono::nanoseconds>(now - start).count();
+    event.type = type;
+    ++buffer.events;
+  }
+
+  //! Return the buffer of the calling thread, from the thread-local cache if
+  //! the thread last recorded into this timeline.
+  ThreadBuffer& LocalBuffer()
+  {
+    struct Cache
+    {
+      uint64_t id;
+      ThreadBuffer* buffer;
+    };
+    static thread_local Cache cache = { 0, NULL };
+
+    if (cache.id != id)
+    {
+      cache.buffer = &Register();
+      cache.id = id;
+    }
+
+    return *cache.buffer;
+  }
+
+  //! Return the buffer of the calling thread, and create it if needed.
+  ThreadBuffer& Register()
+  {
+    const std::thread::id thread = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+      if (buffers[i]->thread == thread)
+        return *buffers[i];
+    }
+
+    buffers.emplace_back(new ThreadBuffer(thread, buffers.size()));
+    return *buffers.back();
+  }
+
+  //! Write the given string as a JSON string.
+  static void WriteString(std::ostream& out, const std::string& value)
+  {
+    out << '"';
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+      const unsigned char c = (unsigned char) value[i];
+      if (c == '"' || c == '\\')
+      {
+        out << '\\' << value[i];
+      }
+      else if (c < 0x20)
+      {
+        const char* digits = "0123456789abcdef";
+        out << "\\u00" << digits[c >> 4] << digits[c & 0xf];
+      }
+      else
+      {
+        out << value[i];
+      }
+    }
+    out << '"';
+  }
+
+  //! Return a new identifier for a timeline; identifiers are never reused, so
+  //! the thread-local caches can't mistake a new timeline for a deleted one.
+  static uint64_t NextId()
+  {
+    static std::atomic<uint64_t> next(1);
+    return next++;
+  }
+
+  //! The maximum number of events recorded by each thread.
+  size_t maxEvents;
+  //! The identifier of this timeline.
+  uint64_t id;
+  //! The time of the start of the timeline.
+  std::chrono::steady_clock::time_point start;
+  //! The buffer of each thread that recorded events.
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  //! Lock for the list of buffers.
+  mutable std::mutex mutex;
+};
+
+//! Return the storage of the timeline set with SetTimeline().
+inline std::shared_ptr<Timeline>& TimelineStorage()
+{
+  static std::shared_ptr<Timeline> timeline;
+  return timeline;
+}
+
+/**
+ * Set the timeline that receives the events of the optimizers when
+ * ENS_TIMELINE is defined (nullptr, the default, records nothing).  The
+ * timeline must not be changed while an optimization runs.
+ */
+inline void SetTimeline(std::shared_ptr<Timeline> timeline)
+{
+  TimelineStorage() = std::move(timeline);
+}
+
+//! Return the timeline set with SetTimeline(), or nullptr if there is none.
+inline Timeline* CurrentTimeline() { return TimelineStorage().get(); }
+
+/**
+ * A TimelineScope records the interval of its own lifetime, with the given
+ * name, into the timeline set with SetTimeline() (if any) when it is created.
+ * ENS_TIMELINE_SCOPE() creates one when ENS_TIMELINE is defined.
+ */
+class TimelineScope
+{
+ public:
+  //! Record the beginning of the interval.
+  TimelineScope(const char* name) :
+      timeline(CurrentTimeline()),
+      name(name)
+  {
+    if (timeline != NULL)
+      timeline->Begin(name);
+  }
+
+  TimelineScope(const TimelineScope&) = delete;
+  TimelineScope& operator=(const TimelineScope&) = delete;
+
+  //! Record the end of the interval.
+  ~TimelineScope()
+  {
+    if (timeline != NULL)
+      timeline->End(name);
+  }
+
+ private:
+  //! The timeline that records the interval.
+  Timeline* timeline;
+  //! The name of the interval.
+  const char* name;
+};
+
+//! Record the beginning of the given interval into the timeline set with
+//! SetTimeline(), if any.
+inline void TimelineBegin(const char* name)
+{
+  Timeline* timeline = CurrentTimeline();
+  if (timeline != NULL)
+    timeline->Begin(name);
+}
+
+//! Record the end of the given interval into the timeline set with
+//! SetTimeline(), if any.
+inline void TimelineEnd(const char* name)
+{
+  Timeline* timeline = CurrentTimeline();
+  if (timeline != NULL)
+    timeline->End(name);
+}
+
+} // namespace ens
+
+// The instrumentation of the optimizers, which compiles to nothing without
+// ENS_TIMELINE.
+#if defined(ENS_TIMELINE)
+  #define ENS_TIMELINE_CONCAT_IMPL(a, b) a##b
+  #define ENS_TIMELINE_CONCAT(a, b) ENS_TIMELINE_CONCAT_IMPL(a, b)
+  #define ENS_TIMELINE_SCOPE(name) ::ens::TimelineScope \
+      ENS_TIMELINE_CONCAT(ensTimelineScope, __LINE__)(name)
+  #define ENS_TIMELINE_BEGIN(name) ::ens::TimelineBegin(name)
+  #define ENS_TIMELINE_END(name) ::ens::TimelineEnd(name)
+#else
+  #define ENS_TIMELINE_SCOPE(name)
+  #define ENS_TIMELINE_BEGIN(name)
+  #define ENS_TIMELINE_END(name)
+#endif
+
+#endif
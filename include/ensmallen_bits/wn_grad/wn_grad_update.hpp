@@ -12,6 +12,8 @@
 #ifndef ENSMALLEN_WN_GRAD_WN_GRAD_UPDATE_HPP
 #define ENSMALLEN_WN_GRAD_WN_GRAD_UPDATE_HPP
 
+#include <ensmallen_bits/utility/fused_update.hpp>
+
 namespace ens {
 
 /**
@@ -82,13 +84,55 @@ class WNGradUpdate
     void Update(MatType& iterate,
                 const double stepSize,
                 const GradType& gradient)
+    {
+      Update(iterate, stepSize, gradient, UseFusedUpdate<MatType, GradType>());
+    }
+
+   private:
+    //! Fused update for dense matrices: one pass over the gradient for its
+    //! squared norm (accumulated in double precision), and one for the step.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::true_type /* fused */)
+    {
+      typedef typename MatType::elem_type ElemType;
+
+      ElemType* x = iterate.memptr();
+      const ElemType* g = gradient.memptr();
+
+      const double squaredNorm = FusedSum<double>(gradient.n_elem,
+          [&](const size_t begin, const size_t end)
+      {
+        double sum = 0.0;
+        ENS_PRAGMA_OMP_SIMD_SUM(sum)
+        for (size_t i = begin; i < end; ++i)
+          sum += double(g[i]) * double(g[i]);
+        return sum;
+      });
+
+      parent.b += stepSize * stepSize / parent.b * squaredNorm;
+      const ElemType a = ElemType(stepSize / parent.b);
+
+      FusedForEach(iterate.n_elem, [&](const size_t begin, const size_t end)
+      {
+        ENS_PRAGMA_OMP_SIMD
+        for (size_t i = begin; i < end; ++i)
+          x[i] -= a * g[i];
+      });
+    }
+
+    //! Generic update, for all other matrix types.
+    void Update(MatType& iterate,
+                const double stepSize,
+                const GradType& gradient,
+                std::false_type /* fused */)
     {
       parent.b += std::pow(stepSize, 2.0) / parent.b *
           std::pow(arma::norm(gradient), 2);
       iterate -= stepSize * gradient / parent.b;
     }
 
-   private:
     //! Reference to the instantiated parent object.
     WNGradUpdate& parent;
   };
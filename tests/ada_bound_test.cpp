@@ -112,4 +112,41 @@ TEST_CASE("AMSBoundSphereFunctionTestSpMatDenseGradient", "[AdaBoundTest]")
   REQUIRE(coordinates(1) == Approx(0.0).margin(0.1));
 }
 
+/**
+ * Run a few steps of the given update policy with dense matrices (which uses
+ * the fused implementation) and with sparse matrices (which uses the generic
+ * implementation), and make sure the results are the same.
+ */
+template<typename UpdateType>
+void FusedUpdateTest()
+{
+  arma::mat denseIterate(5, 4, arma::fill::randu);
+  arma::sp_mat sparseIterate(denseIterate);
+
+  UpdateType denseUpdate, sparseUpdate;
+  typename UpdateType::template Policy<arma::mat, arma::mat>
+      densePolicy(denseUpdate, 5, 4);
+  typename UpdateType::template Policy<arma::sp_mat, arma::sp_mat>
+      sparsePolicy(sparseUpdate, 5, 4);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::mat gradient(5, 4, arma::fill::randn);
+    densePolicy.Update(denseIterate, 0.01, gradient);
+    sparsePolicy.Update(sparseIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  CheckMatrices(denseIterate, arma::mat(sparseIterate), 1e-5);
+}
+
+/**
+ * Make sure the fused dense update of AdaBound and AMSBound matches the generic
+ * update.
+ */
+TEST_CASE("AdaBoundFusedUpdateTest", "[AdaBoundTest]")
+{
+  FusedUpdateTest<AdaBoundUpdate>();
+  FusedUpdateTest<AMSBoundUpdate>();
+}
+
 #endif
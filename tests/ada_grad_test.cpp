@@ -34,3 +34,27 @@ TEST_CASE("AdaGradLogisticRegressionTestFMat", "[AdaGradTest]")
   AdaGrad adagrad(0.99, 32, 1e-8, 5000000, 1e-9, true);
   LogisticRegressionFunctionTest<arma::fmat>(adagrad, 0.003, 0.006);
 }
+
+/**
+ * Make sure that the sparse AdaGrad update (dense iterate, sparse gradient)
+ * gives the same result as the dense update.
+ */
+TEST_CASE("AdaGradSparseGradientUpdateTest", "[AdaGradTest]")
+{
+  arma::mat denseIterate(50, 4, arma::fill::randu);
+  arma::mat sparseIterate(denseIterate);
+
+  AdaGradUpdate denseUpdate, sparseUpdate;
+  AdaGradUpdate::Policy<arma::mat, arma::mat> densePolicy(denseUpdate, 50, 4);
+  AdaGradUpdate::Policy<arma::mat, arma::sp_mat> sparsePolicy(sparseUpdate,
+      50, 4);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::sp_mat gradient = arma::sprandn<arma::sp_mat>(50, 4, 0.1);
+    densePolicy.Update(denseIterate, 0.01, arma::mat(gradient));
+    sparsePolicy.Update(sparseIterate, 0.01, gradient);
+  }
+
+  CheckMatrices(denseIterate, sparseIterate, 1e-8);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file adafactor_test.cpp
+ *
+ * Test file for the Adafactor update policy.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The squared distance of a matrix of coordinates to a target matrix; the i'th
+ * separable function is the error of column i.
+ */
+class MatrixTargetFunction
+{
+ public:
+  MatrixTargetFunction(const arma::mat& target) : target(target) { }
+
+  size_t NumFunctions() const { return target.n_cols; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    const size_t end = begin + batchSize - 1;
+    return 0.5 * arma::accu(arma::square(coordinates.cols(begin, end) -
+        target.cols(begin, end)));
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    const size_t end = begin + batchSize - 1;
+    gradient.zeros(coordinates.n_rows, coordinates.n_cols);
+    gradient.cols(begin, end) = coordinates.cols(begin, end) -
+        target.cols(begin, end);
+  }
+
+ private:
+  arma::mat target;
+};
+
+/**
+ * Run Adafactor on logistic regression (whose coordinates are a vector, so the
+ * second moments are not factored) and make sure the results are acceptable.
+ */
+TEST_CASE("AdafactorLogisticRegressionTest", "[AdafactorTest]")
+{
+  Adafactor optimizer(0.01, 32, 100000, 1e-5, true);
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006, 3);
+}
+
+/**
+ * Run Adafactor on logistic regression and make sure the results are
+ * acceptable.  Use arma::fmat.
+ */
+TEST_CASE("AdafactorLogisticRegressionFMatTest", "[AdafactorTest]")
+{
+  Adafactor optimizer(0.01, 32, 100000, 1e-5, true);
+  LogisticRegressionFunctionTest<arma::fmat>(optimizer, 0.003, 0.006, 3);
+}
+
+/**
+ * Make sure that Adafactor, with factored second moments, with and without
+ * momentum, finds the given target matrix.
+ */
+TEST_CASE("AdafactorFactoredMatrixTest", "[AdafactorTest]")
+{
+  const arma::mat target(10, 20, arma::fill::randn);
+  MatrixTargetFunction f(target);
+
+  for (const double beta1 : { 0.0, 0.9 })
+  {
+    Adafactor optimizer(0.01, 5, 100000, -1, true, AdafactorUpdate(beta1));
+
+    arma::mat coordinates(10, 20, arma::fill::zeros);
+    optimizer.Optimize(f, coordinates);
+
+    REQUIRE(arma::abs(coordinates - target).max() < 0.05);
+  }
+}
@@ -217,6 +217,21 @@ TEST_CASE("PadamLogisticRegressionTest", "[AdamTest]")
   LogisticRegressionFunctionTest(optimizer, 0.003, 0.006);
 }
 
+/**
+ * Run Padam on logistic regression with the moment estimates in bfloat16 and
+ * in 8-bit blocks, and make sure the results are acceptable.
+ */
+TEST_CASE("PadamCompactStateLogisticRegressionTest", "[AdamTest]")
+{
+  Padam optimizer;
+
+  optimizer.StateBits() = 16;
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006, 3);
+
+  optimizer.StateBits() = 8;
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006, 3);
+}
+
 /**
  * Run QHAdam on logistic regression and make sure the results are acceptable.
  */
@@ -333,3 +348,263 @@ TEST_CASE("AdamSchafferFunctionN2Test", "[AdamTest]")
   Adam optimizer(0.001, 2, 0.7, 0.999, 1e-8, 500000, 1e-9, false);
   FunctionTest<SchafferFunctionN2>(optimizer, 0.1, 0.01);
 }
+
+/**
+ * Run a few steps of the given update policy with dense matrices (which uses
+ * the fused implementation) and with sparse matrices (which uses the generic
+ * implementation), and make sure the results are the same.
+ */
+template<typename UpdateType>
+void FusedUpdateTest()
+{
+  arma::mat denseIterate(5, 4, arma::fill::randu);
+  arma::sp_mat sparseIterate(denseIterate);
+
+  UpdateType denseUpdate, sparseUpdate;
+  typename UpdateType::template Policy<arma::mat, arma::mat>
+      densePolicy(denseUpdate, 5, 4);
+  typename UpdateType::template Policy<arma::sp_mat, arma::sp_mat>
+      sparsePolicy(sparseUpdate, 5, 4);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::mat gradient(5, 4, arma::fill::randn);
+    densePolicy.Update(denseIterate, 0.01, gradient);
+    sparsePolicy.Update(sparseIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  CheckMatrices(denseIterate, arma::mat(sparseIterate), 1e-5);
+}
+
+/**
+ * Make sure the fused dense update of the Adam variants matches the generic
+ * update.
+ */
+TEST_CASE("AdamFusedUpdateTest", "[AdamTest]")
+{
+  FusedUpdateTest<AdamUpdate>();
+  FusedUpdateTest<AdaMaxUpdate>();
+  FusedUpdateTest<AMSGradUpdate>();
+  FusedUpdateTest<NadamUpdate>();
+  FusedUpdateTest<NadaMaxUpdate>();
+  FusedUpdateTest<OptimisticAdamUpdate>();
+}
+
+/**
+ * Make sure that clipping inside the fused update of a policy matches clipping
+ * the gradient first, for both element-wise and global-norm clipping.
+ */
+template<typename UpdateType>
+void FusedClippingTest(const double minGradient,
+                       const double maxGradient,
+                       const double maxNorm)
+{
+  arma::mat clippedIterate(5, 4, arma::fill::randu);
+  arma::mat iterate(clippedIterate);
+
+  UpdateType clippedUpdate, update;
+  GradientClipping<UpdateType> clipping(minGradient, maxGradient,
+      clippedUpdate, maxNorm);
+  typename GradientClipping<UpdateType>::template Policy<arma::mat, arma::mat>
+      clippedPolicy(clipping, 5, 4);
+  typename UpdateType::template Policy<arma::mat, arma::mat> policy(update, 5,
+      4);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::mat gradient(5, 4, arma::fill::randn);
+    clippedPolicy.Update(clippedIterate, 0.01, gradient);
+
+    const double norm = arma::norm(gradient, "fro");
+    if (maxNorm > 0 && norm > maxNorm)
+      gradient *= maxNorm / norm;
+    policy.Update(iterate, 0.01, arma::clamp(gradient, minGradient,
+        maxGradient));
+  }
+
+  CheckMatrices(clippedIterate, iterate, 1e-10);
+}
+
+TEST_CASE("AdamFusedClippingTest", "[AdamTest]")
+{
+  const double inf = std::numeric_limits<double>::infinity();
+
+  FusedClippingTest<AdamUpdate>(-0.5, 0.5, 0.0);
+  FusedClippingTest<AdamUpdate>(-inf, inf, 1.0);
+  FusedClippingTest<AMSGradUpdate>(-0.5, 0.5, 2.0);
+  FusedClippingTest<NadamUpdate>(-0.5, 0.5, 2.0);
+  FusedClippingTest<NadaMaxUpdate>(-0.5, 0.5, 2.0);
+  FusedClippingTest<AdaMaxUpdate>(-0.5, 0.5, 2.0);
+  FusedClippingTest<OptimisticAdamUpdate>(-0.5, 0.5, 2.0);
+
+  FusedClippingTest<VanillaUpdate>(-0.5, 0.5, 2.0);
+  FusedClippingTest<MomentumUpdate>(-0.5, 0.5, 2.0);
+
+  // Policies without a transform in their update clip into a buffer.
+  FusedClippingTest<AdaGradUpdate>(-0.5, 0.5, 2.0);
+}
+
+/**
+ * A StateAllocator that counts its allocations.
+ */
+class CountingStateAllocator : public StateAllocator
+{
+ public:
+  CountingStateAllocator() : allocations(0), deallocations(0) { }
+
+  void* Allocate(const size_t bytes)
+  {
+    ++allocations;
+    return new double[(bytes + sizeof(double) - 1) / sizeof(double)];
+  }
+
+  void Deallocate(void* memory, const size_t /* bytes */)
+  {
+    ++deallocations;
+    delete[] static_cast<double*>(memory);
+  }
+
+  size_t allocations;
+  size_t deallocations;
+};
+
+/**
+ * Make sure that the moments of Adam are allocated by the state allocator, and
+ * freed once the optimization is done.
+ */
+TEST_CASE("AdamStateAllocatorTest", "[AdamTest]")
+{
+  std::shared_ptr<CountingStateAllocator> allocator =
+      std::make_shared<CountingStateAllocator>();
+  SetStateAllocator(allocator);
+
+  // The policy gives the same updates as with the memory of Armadillo.
+  arma::mat iterate(5, 4, arma::fill::randu);
+  arma::mat allocatedIterate(iterate);
+  AdamUpdate update;
+  {
+    AdamUpdate::Policy<arma::mat, arma::mat> allocatedPolicy(update, 5, 4);
+    REQUIRE(allocator->allocations == 2);
+    SetStateAllocator(nullptr);
+    AdamUpdate::Policy<arma::mat, arma::mat> policy(update, 5, 4);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+      arma::mat gradient(5, 4, arma::fill::randn);
+      allocatedPolicy.Update(allocatedIterate, 0.01, gradient);
+      policy.Update(iterate, 0.01, gradient);
+    }
+  }
+  REQUIRE(allocator->allocations == 2);
+  REQUIRE(allocator->deallocations == 2);
+  CheckMatrices(allocatedIterate, iterate, 1e-15);
+
+  SetStateAllocator(allocator);
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  {
+    Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 500000, 1e-9, true);
+    adam.Optimize(f, coordinates);
+  }
+  SetStateAllocator(nullptr);
+
+  REQUIRE(allocator->allocations == 4);
+  REQUIRE(allocator->deallocations == 4);
+  REQUIRE(f.Evaluate(coordinates) == Approx(-1.0).epsilon(0.0003));
+
+  // The huge pages fall back to regular allocations if they aren't available.
+  SetStateAllocator(std::make_shared<HugePageAllocator>(0));
+  RosenbrockFunction rosenbrock;
+  coordinates = rosenbrock.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.Optimize(rosenbrock, coordinates);
+  SetStateAllocator(nullptr);
+
+  REQUIRE(coordinates(0) == Approx(1.0).epsilon(1e-5));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(1e-5));
+}
+
+/**
+ * Make sure that LazyAdam with a sparse gradient only changes the coordinates
+ * with a nonzero gradient, and matches Adam when every coordinate has a
+ * nonzero gradient.
+ */
+TEST_CASE("LazyAdamSparseGradientUpdateTest", "[AdamTest]")
+{
+  arma::mat adamIterate(10, 3, arma::fill::randu);
+  arma::mat lazyIterate(adamIterate);
+
+  AdamUpdate adamUpdate;
+  LazyAdamUpdate lazyUpdate;
+  AdamUpdate::Policy<arma::mat, arma::mat> adamPolicy(adamUpdate, 10, 3);
+  LazyAdamUpdate::Policy<arma::mat, arma::sp_mat> lazyPolicy(lazyUpdate, 10,
+      3);
+
+  // With fully populated gradients, LazyAdam is Adam.
+  for (size_t i = 0; i < 5; ++i)
+  {
+    arma::mat gradient(10, 3, arma::fill::randn);
+    adamPolicy.Update(adamIterate, 0.01, gradient);
+    lazyPolicy.Update(lazyIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  CheckMatrices(adamIterate, lazyIterate, 1e-5);
+
+  // Now only the first column has a gradient; nothing else may move.
+  const arma::mat before(lazyIterate);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    arma::mat gradient(10, 3, arma::fill::zeros);
+    gradient.col(0).randn();
+    lazyPolicy.Update(lazyIterate, 0.01, arma::sp_mat(gradient));
+  }
+
+  CheckMatrices(arma::mat(before.cols(1, 2)),
+      arma::mat(lazyIterate.cols(1, 2)), 1e-10);
+  REQUIRE(arma::norm(lazyIterate.col(0) - before.col(0)) > 0.0);
+}
+
+/**
+ * Run Adam on a logistic regression function evaluated in single precision,
+ * while the coordinates and the moments are kept in double precision.
+ */
+TEST_CASE("AdamMixedPrecisionLogisticRegressionTest", "[AdamTest]")
+{
+  // Epoch objectives of float functions are summed in double.
+  REQUIRE(std::is_same<AccumulatorType<float>::type, double>::value);
+  REQUIRE(std::is_same<AccumulatorType<double>::type, double>::value);
+
+  arma::fmat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+
+  LogisticRegressionFunction<arma::fmat> lrf(shuffledData, shuffledResponses,
+      0.5);
+  MixedPrecisionFunction<LogisticRegressionFunction<arma::fmat>> f(lrf);
+
+  arma::mat coordinates =
+      arma::conv_to<arma::mat>::from(lrf.GetInitialPoint());
+  Adam adam(0.032, 32, 0.9, 0.999, 1e-8, 5 * responses.n_elem, 1e-6);
+  adam.Optimize(f, coordinates);
+
+  const arma::fmat lowCoordinates = arma::conv_to<arma::fmat>::from(
+      coordinates);
+  REQUIRE(lrf.ComputeAccuracy(data, responses, lowCoordinates) ==
+      Approx(100.0).epsilon(0.003));
+  REQUIRE(lrf.ComputeAccuracy(testData, testResponses, lowCoordinates) ==
+      Approx(100.0).epsilon(0.006));
+}
+
+#ifdef ENS_HAVE_COOT
+
+/**
+ * Run Adam with coordinates, gradients and moments on the GPU.
+ */
+TEST_CASE("AdamCootFunctionTest", "[AdamTest]")
+{
+  Adam adam(0.01, 100, 0.9, 0.999, 1e-8, 500000, 1e-9, false);
+  CootFunctionTest(adam, 0.05);
+}
+
+#endif
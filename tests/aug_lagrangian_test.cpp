@@ -19,6 +19,87 @@
 using namespace ens;
 using namespace ens::test;
 
+/**
+ * Minimize ||x||^2 subject to the linear constraints A x = b, with one call per
+ * constraint.
+ */
+class LinearConstraintsFunction
+{
+ public:
+  LinearConstraintsFunction(const arma::mat& a, const arma::vec& b) :
+      a(a), b(b), calls(0) { }
+
+  double Evaluate(const arma::mat& x) { return arma::dot(x, x); }
+  void Gradient(const arma::mat& x, arma::mat& g) { g = 2 * x; }
+
+  size_t NumConstraints() const { return a.n_rows; }
+
+  double EvaluateConstraint(const size_t i, const arma::mat& x)
+  {
+    ++calls;
+    return arma::dot(a.row(i), x) - b(i);
+  }
+
+  void GradientConstraint(const size_t i, const arma::mat& /* x */,
+                          arma::mat& g)
+  {
+    ++calls;
+    g = a.row(i).t();
+  }
+
+  const arma::mat& A() const { return a; }
+  const arma::vec& B() const { return b; }
+
+  //! The number of calls to the per-constraint methods.
+  size_t calls;
+
+ private:
+  arma::mat a;
+  arma::vec b;
+};
+
+/**
+ * The same function, which also provides the bulk constraint methods.
+ */
+class BulkLinearConstraintsFunction
+{
+ public:
+  BulkLinearConstraintsFunction(const arma::mat& a, const arma::vec& b) :
+      f(a, b), bulkCalls(0) { }
+
+  double Evaluate(const arma::mat& x) { return f.Evaluate(x); }
+  void Gradient(const arma::mat& x, arma::mat& g) { f.Gradient(x, g); }
+
+  size_t NumConstraints() const { return f.NumConstraints(); }
+
+  double EvaluateConstraint(const size_t i, const arma::mat& x)
+  {
+    return f.EvaluateConstraint(i, x);
+  }
+
+  void GradientConstraint(const size_t i, const arma::mat& x, arma::mat& g)
+  {
+    f.GradientConstraint(i, x, g);
+  }
+
+  void EvaluateConstraints(const arma::mat& x, arma::vec& c)
+  {
+    ++bulkCalls;
+    c = f.A() * x - f.B();
+  }
+
+  void GradientConstraints(const arma::mat& /* x */, const arma::vec& w,
+                           arma::mat& g)
+  {
+    ++bulkCalls;
+    g = f.A().t() * w;
+  }
+
+  LinearConstraintsFunction f;
+  //! The number of calls to the bulk methods.
+  size_t bulkCalls;
+};
+
 /**
  * Tests the Augmented Lagrangian optimizer using the
  * AugmentedLagrangianTestFunction class.
@@ -108,3 +189,157 @@ TEST_CASE("GockenbachFunctionSpMatTest", "[AugLagrangianTest]")
   REQUIRE(coords(1) == Approx(-1.10778185).epsilon(1e-7));
   REQUIRE(coords(2) == Approx(0.015099932).epsilon(1e-5));
 }
+
+/**
+ * Make sure that the bulk constraint methods are used instead of the
+ * per-constraint methods when they are available, and that both give the
+ * minimum-norm solution of A x = b.
+ */
+TEST_CASE("AugLagrangianBulkConstraintsTest", "[AugLagrangianTest]")
+{
+  const arma::mat a(4, 10, arma::fill::randu);
+  const arma::vec b(4, arma::fill::randu);
+  const arma::vec expected = a.t() * arma::solve(a * a.t(), b);
+
+  // The per-constraint methods count their calls, so they are not safe to
+  // call concurrently; they are called serially by default.
+  LinearConstraintsFunction f(a, b);
+  AugLagrangian aug;
+  REQUIRE(aug.ParallelConstraints() == false);
+  arma::mat coords(10, 1, arma::fill::zeros);
+  aug.Optimize(f, coords);
+
+  REQUIRE(f.calls > 0);
+  for (size_t i = 0; i < expected.n_elem; ++i)
+    REQUIRE(coords(i) == Approx(expected(i)).margin(1e-4));
+
+  BulkLinearConstraintsFunction bulk(a, b);
+  AugLagrangian bulkAug;
+  arma::mat bulkCoords(10, 1, arma::fill::zeros);
+  bulkAug.Optimize(bulk, bulkCoords);
+
+  REQUIRE(bulk.bulkCalls > 0);
+  REQUIRE(bulk.f.calls == 0);
+  for (size_t i = 0; i < expected.n_elem; ++i)
+    REQUIRE(bulkCoords(i) == Approx(expected(i)).margin(1e-4));
+}
+
+/**
+ * Calling the per-constraint methods in parallel should give the same result as
+ * calling them serially.
+ */
+TEST_CASE("GockenbachFunctionParallelConstraintsTest", "[AugLagrangianTest]")
+{
+  GockenbachFunction f;
+
+  AugLagrangian aug;
+  arma::mat coords = f.GetInitialPoint<arma::mat>();
+  aug.Optimize(f, coords);
+
+  AugLagrangian parallelAug;
+  parallelAug.ParallelConstraints() = true;
+  arma::mat parallelCoords = f.GetInitialPoint<arma::mat>();
+  parallelAug.Optimize(f, parallelCoords);
+
+  for (size_t i = 0; i < coords.n_elem; ++i)
+    REQUIRE(parallelCoords(i) == Approx(coords(i)).margin(1e-10));
+}
+
+/**
+ * Tests the Augmented Lagrangian optimizer with warm-started L-BFGS inner
+ * solves using the Gockenbach function.
+ */
+TEST_CASE("GockenbachFunctionWarmStartTest", "[AugLagrangianTest]")
+{
+  GockenbachFunction f;
+  AugLagrangian aug;
+  aug.WarmStart() = true;
+
+  arma::mat coords = f.GetInitialPoint<arma::mat>();
+
+  if (!aug.Optimize(f, coords))
+    FAIL("Optimization reported failure.");
+
+  double finalValue = f.Evaluate(coords);
+
+  REQUIRE(finalValue == Approx(29.633926).epsilon(1e-5));
+  REQUIRE(coords(0) == Approx(0.12288178).epsilon(1e-3));
+  REQUIRE(coords(1) == Approx(-1.10778185).epsilon(1e-5));
+  REQUIRE(coords(2) == Approx(0.015099932).epsilon(1e-3));
+
+  // The setting of the inner optimizer is restored.
+  REQUIRE(aug.InnerOptimizer().ResetPolicy() == true);
+}
+
+/**
+ * Count the outer iterations of AugLagrangian, but not the steps of its inner
+ * optimizer.
+ */
+class OuterIterationCounter
+{
+ public:
+  OuterIterationCounter() : iterations(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 const MatType& /* coordinates */)
+  {
+    if (std::is_same<OptimizerType, AugLagrangian>::value)
+      ++iterations;
+  }
+
+  size_t iterations;
+};
+
+/**
+ * Make sure that the multipliers are stored in a WarmStartStore, and that a
+ * solve restored from it needs fewer outer iterations.
+ */
+TEST_CASE("AugLagrangianWarmStartStoreTest", "[AugLagrangianTest]")
+{
+  GockenbachFunction f;
+  WarmStartStore store;
+  const arma::vec signature("1");
+
+  AugLagrangian cold;
+  OuterIterationCounter coldCounter;
+  arma::mat coords = f.GetInitialPoint<arma::mat>();
+  if (!cold.Optimize(f, coords, coldCounter, StoreWarmStart(store, signature)))
+    FAIL("Optimization reported failure.");
+  REQUIRE(store.Size() == 1);
+
+  AugLagrangian warm;
+  OuterIterationCounter warmCounter;
+  arma::mat warmCoords = f.GetInitialPoint<arma::mat>();
+  REQUIRE(store.Lookup(signature, warm, warmCoords));
+  REQUIRE(arma::approx_equal(warm.Lambda(), cold.Lambda(), "absdiff", 0.0));
+  REQUIRE(warm.Sigma() == cold.Sigma());
+
+  if (!warm.Optimize(f, warmCoords, warmCounter))
+    FAIL("Optimization reported failure.");
+
+  REQUIRE(warmCounter.iterations < coldCounter.iterations);
+  REQUIRE(f.Evaluate(warmCoords) == Approx(29.633926).epsilon(1e-7));
+  REQUIRE(warmCoords(1) == Approx(-1.10778185).epsilon(1e-7));
+}
+
+/**
+ * Tests the Augmented Lagrangian optimizer with another inner optimizer.
+ */
+TEST_CASE("AugLagrangianMoreThuenteTest", "[AugLagrangianTest]")
+{
+  AugLagrangianTestFunction f;
+  AugLagrangianType<L_BFGSType<MoreThuenteLineSearch>> aug;
+
+  arma::vec coords = f.GetInitialPoint();
+
+  if (!aug.Optimize(f, coords))
+    FAIL("Optimization reported failure.");
+
+  double finalValue = f.Evaluate(coords);
+
+  REQUIRE(finalValue == Approx(70.0).epsilon(1e-5));
+  REQUIRE(coords(0) == Approx(1.0).epsilon(1e-5));
+  REQUIRE(coords(1) == Approx(4.0).epsilon(1e-5));
+}
@@ -0,0 +1,111 @@
+/**
+ * @file autotuner_test.cpp
+ *
+ * Test file for the Autotuner.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Tune the batch size of SGD on logistic regression, and make sure that the
+ * best candidate is applied to the optimizer.
+ */
+TEST_CASE("AutotunerBatchSizeTest", "[AutotunerTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> lr(shuffledData, shuffledResponses, 0.5);
+
+  StandardSGD sgd(0.0003, 1, 0, 1e-9, true);
+  Autotuner<StandardSGD> tuner(0.01, 2);
+  tuner.AddBatchSize({ 1, 32 });
+  const double throughput = tuner.Tune(sgd, lr, lr.GetInitialPoint());
+
+  REQUIRE(tuner.Names().size() == 1);
+  REQUIRE(tuner.Configurations().n_rows == 1);
+  REQUIRE(tuner.Configurations().n_cols == 2);
+  REQUIRE(tuner.Configurations()(0, 0) == 1);
+  REQUIRE(tuner.Configurations()(0, 1) == 32);
+  REQUIRE(tuner.Throughputs().n_elem == 2);
+  REQUIRE(arma::all(tuner.Throughputs() > 0.0));
+  REQUIRE(throughput == Approx(arma::max(tuner.Throughputs())));
+  REQUIRE(tuner.Best().size() == 1);
+  REQUIRE((tuner.Best()[0] == 1 || tuner.Best()[0] == 32));
+  REQUIRE(sgd.BatchSize() == tuner.Best()[0]);
+  REQUIRE(!tuner.FromCache());
+
+  // The tuned optimizer still works.
+  sgd.MaxIterations() = 10000;
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double initialObjective = lr.Evaluate(coordinates);
+  sgd.Optimize(lr, coordinates);
+  REQUIRE(lr.Evaluate(coordinates) < initialObjective);
+}
+
+/**
+ * Every combination of the candidates of two settings is probed, with the
+ * first setting varying the slowest, and the cache gives the same result
+ * without probing again.
+ */
+TEST_CASE("AutotunerGridAndCacheTest", "[AutotunerTest]")
+{
+  SGDTestFunction f;
+  StandardSGD sgd(0.001, 1, 0, 1e-9, true);
+
+  const std::string cacheFile = "autotuner_test_cache.txt";
+  std::remove(cacheFile.c_str());
+
+  Autotuner<StandardSGD> tuner(0.005, 1, cacheFile);
+  tuner.AddBatchSize({ 1, 2, 3 }).AddParameter("stepScale", { 1, 2 },
+      [](StandardSGD& optimizer, const size_t value)
+      {
+        optimizer.StepSize() = 0.001 * value;
+      });
+  tuner.Tune(sgd, f, f.GetInitialPoint());
+
+  const arma::umat expected = { { 1, 1, 2, 2, 3, 3 },
+                                { 1, 2, 1, 2, 1, 2 } };
+  REQUIRE(tuner.Configurations().n_rows == 2);
+  REQUIRE(tuner.Configurations().n_cols == 6);
+  REQUIRE(arma::all(arma::vectorise(tuner.Configurations() == expected)));
+  REQUIRE(tuner.Throughputs().n_elem == 6);
+  REQUIRE(!tuner.FromCache());
+  REQUIRE(sgd.BatchSize() == tuner.Best()[0]);
+  REQUIRE(sgd.StepSize() == Approx(0.001 * tuner.Best()[1]));
+
+  StandardSGD cachedSGD(0.001, 1, 0, 1e-9, true);
+  Autotuner<StandardSGD> cachedTuner(0.005, 1, cacheFile);
+  cachedTuner.AddBatchSize({ 1, 2, 3 }).AddParameter("stepScale", { 1, 2 },
+      [](StandardSGD& optimizer, const size_t value)
+      {
+        optimizer.StepSize() = 0.001 * value;
+      });
+  cachedTuner.Tune(cachedSGD, f, f.GetInitialPoint());
+
+  REQUIRE(cachedTuner.FromCache());
+  REQUIRE(cachedTuner.Best() == tuner.Best());
+  REQUIRE(cachedTuner.Configurations().n_cols == 1);
+  REQUIRE(cachedSGD.BatchSize() == sgd.BatchSize());
+  REQUIRE(cachedSGD.StepSize() == Approx(sgd.StepSize()));
+
+  // Other candidates are another key of the cache.
+  Autotuner<StandardSGD> otherTuner(0.005, 1, cacheFile);
+  otherTuner.AddBatchSize({ 1, 3 });
+  otherTuner.Tune(cachedSGD, f, f.GetInitialPoint());
+  REQUIRE(!otherTuner.FromCache());
+  REQUIRE(otherTuner.Configurations().n_cols == 2);
+
+  std::remove(cacheFile.c_str());
+}
@@ -44,6 +44,17 @@ TEST_CASE("BBSArmijoLogisticRegressionTest", "[BigBatchSGDTest]")
   }
 }
 
+/**
+ * Run big-batch SGD using the backtracking line search with parallel trials
+ * on logistic regression.
+ */
+TEST_CASE("BBSArmijoParallelTrialsLogisticRegressionTest", "[BigBatchSGDTest]")
+{
+  BBS_Armijo bbsgd(40, 0.005, 0.1, 10000, 1e-6, true, true);
+  bbsgd.UpdatePolicy().ParallelTrials() = 4;
+  LogisticRegressionFunctionTest(bbsgd, 0.003, 0.006, 3);
+}
+
 /**
  * Run big-batch SGD using BBS_BB on logistic regression and make sure the
  * results are acceptable.  Use arma::fmat as the objective type.
@@ -72,6 +83,100 @@ TEST_CASE("BBSArmijoLogisticRegressionFMatTest", "[BigBatchSGDTest]")
   }
 }
 
+/**
+ * Logistic regression with a GradientMoments() method that counts its calls.
+ */
+class MomentsLogisticRegression : public LogisticRegression<arma::mat>
+{
+ public:
+  MomentsLogisticRegression(arma::mat& data, arma::Row<size_t>& responses) :
+      LogisticRegression<arma::mat>(data, responses, 0.5),
+      calls(0)
+  { }
+
+  double GradientMoments(const arma::mat& coordinates,
+                         const size_t begin,
+                         arma::mat& gradient,
+                         const size_t batchSize)
+  {
+    ++calls;
+    std::vector<arma::mat> buffers;
+    return ens::GradientMoments(
+        static_cast<LogisticRegression<arma::mat>&>(*this), coordinates,
+        begin, gradient, batchSize, buffers);
+  }
+
+  size_t calls;
+};
+
+/**
+ * Make sure GradientMoments() computes the summed gradient and the sum of the
+ * squared norms of the per-sample gradients, serially and in parallel.
+ */
+TEST_CASE("BBSGradientMomentsTest", "[BigBatchSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData, responses,
+      testResponses, shuffledResponses);
+  LogisticRegression<arma::mat> lr(shuffledData, shuffledResponses, 0.5);
+  const arma::mat coordinates(1, 4, arma::fill::randn);
+
+  arma::mat expected(1, 4, arma::fill::zeros), sample;
+  double expectedNorms = 0.0;
+  for (size_t i = 10; i < 110; ++i)
+  {
+    lr.Gradient(coordinates, i, sample, 1);
+    expected += sample;
+    expectedNorms += arma::dot(sample, sample);
+  }
+
+  std::vector<arma::mat> buffers;
+  arma::mat gradient;
+  for (size_t p = 0; p < 2; ++p)
+  {
+    const double norms = GradientMoments(lr, coordinates, 10, gradient, 100,
+        buffers, p == 1);
+    REQUIRE(norms == Approx(expectedNorms).epsilon(1e-10));
+    CheckMatrices(gradient, expected, 1e-8);
+  }
+
+  // A deterministic reduction gives the same bits serially and in parallel.
+  arma::mat serialGradient;
+  const double serialNorms = GradientMoments(lr, coordinates, 10,
+      serialGradient, 100, buffers, false, true, 16);
+  const double parallelNorms = GradientMoments(lr, coordinates, 10, gradient,
+      100, buffers, true, true, 16);
+  REQUIRE(serialNorms == Approx(expectedNorms).epsilon(1e-10));
+  REQUIRE(parallelNorms == serialNorms);
+  CheckMatrices(serialGradient, expected, 1e-8);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+    REQUIRE(gradient[i] == serialGradient[i]);
+}
+
+/**
+ * Make sure that big-batch SGD uses the GradientMoments() method of the
+ * function, once per batch.
+ */
+TEST_CASE("BBSGradientMomentsFunctionTest", "[BigBatchSGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData, responses,
+      testResponses, shuffledResponses);
+  MomentsLogisticRegression lr(shuffledData, shuffledResponses);
+
+  BBS_BB bbsgd(350, 0.001, 0.1, 10000, 1e-8, true, true);
+  arma::mat coordinates = lr.GetInitialPoint();
+  bbsgd.Optimize(lr, coordinates);
+
+  REQUIRE(lr.calls > 0);
+  REQUIRE(lr.calls < 10000 / 350 * 10);
+
+  const double acc = lr.ComputeAccuracy(data, responses, coordinates);
+  REQUIRE(acc == Approx(100.0).epsilon(0.01));
+}
+
 #if ARMA_VERSION_MAJOR > 9 ||\
     (ARMA_VERSION_MAJOR == 9 && ARMA_VERSION_MINOR >= 400)
 
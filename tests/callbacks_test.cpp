@@ -622,6 +622,32 @@ TEST_CASE("ProgressBarCallbackTest", "[CallbacksTest]")
   REQUIRE(stream.str().length() > 0);
 }
 
+/**
+ * Make sure the AsyncEarlyStopAtMinLoss callback will stop the optimization
+ * process, and keep the best coordinates.
+ */
+TEST_CASE("AsyncEarlyStopAtMinLossCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+
+  // Instantiate the optimizer with a number of iterations that will take a
+  // long time to finish.
+  StandardSGD s(0.0003, 1, 2000000000, -10);
+
+  AsyncEarlyStopAtMinLoss cb([&f](const arma::mat& coordinates)
+      {
+        return f.Evaluate(coordinates, 0, f.NumFunctions());
+      }, 100);
+  s.Optimize(f, coordinates, cb);
+
+  REQUIRE(cb.Validations() > 100);
+  REQUIRE(cb.BestObjective() == Approx(-1.0).epsilon(0.0005));
+  REQUIRE(cb.BestCoordinates()(0) == Approx(0.0).margin(1e-3));
+  REQUIRE(cb.BestCoordinates()(1) == Approx(0.0).margin(1e-7));
+  REQUIRE(cb.BestCoordinates()(2) == Approx(0.0).margin(1e-7));
+}
+
 /**
  * Make sure the StoreBestCoordinates callback will store the best coordinates
  * and objective.
@@ -642,6 +668,34 @@ TEST_CASE("StoreBestCoordinatesCallbackTest", "[CallbacksTest]")
   REQUIRE(cb.BestCoordinates()(1) == Approx(0.0).margin(1e-7));
 }
 
+/**
+ * Make sure the StoreBestCoordinates callback only considers every
+ * evaluationInterval-th evaluation, and copies large coordinates correctly.
+ */
+TEST_CASE("StoreBestCoordinatesIntervalCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::mat coordinates2 = coordinates;
+
+  StandardSGD s(0.0003, 1, 300000, 1e-9, false);
+
+  StoreBestCoordinates<arma::mat> cb;
+  StoreBestCoordinates<arma::mat> cb2(7);
+  s.Optimize(f, coordinates, cb);
+  s.Optimize(f, coordinates2, cb2);
+
+  REQUIRE(cb2.EvaluationInterval() == 7);
+  REQUIRE(cb.BestObjective() <= cb2.BestObjective());
+  REQUIRE(cb2.BestObjective() == Approx(cb.BestObjective()).epsilon(0.001));
+
+  // Coordinates larger than one chunk are copied in parts.
+  StoreBestCoordinates<arma::mat> cb3;
+  arma::mat large(300, 1000, arma::fill::randu);
+  cb3.Evaluate(s, f, large, 1.0);
+  REQUIRE(arma::approx_equal(cb3.BestCoordinates(), large, "absdiff", 0.0));
+}
+
 /**
  * Make sure the TimerStop callback will stop the optimization process.
  */
@@ -662,6 +716,123 @@ TEST_CASE("TimerStopCallbackTest", "[CallbacksTest]")
   REQUIRE(timer.toc() < 2);
 }
 
+/**
+ * Make sure the EvaluationBudget callback stops SGD exactly at the budget, and
+ * DE within a generation of it.
+ */
+TEST_CASE("EvaluationBudgetCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  StandardSGD s(0.0003, 1, 2000000000, -100, true);
+
+  EvaluationBudget budget(500);
+  s.Optimize(f, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() == 500);
+  REQUIRE(budget.GradientEvaluations() == 500);
+
+  // Each generation takes 20 evaluations.
+  RosenbrockFunction rf;
+  coordinates = rf.GetInitialPoint();
+  DE de(20, 1000, 0.6, 0.8, -1);
+  budget.MaxEvaluations() = 110;
+  de.Optimize(rf, coordinates, budget);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.Evaluations() >= 110);
+  REQUIRE(budget.Evaluations() <= 160);
+}
+
+/**
+ * Make sure the EvaluationBudget callback stops the optimization at the time
+ * budget.
+ */
+TEST_CASE("EvaluationBudgetTimeCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  Adam opt(0.5, 2, 0.7, 0.999, 1e-8, 2000000000, -100, false);
+  arma::wall_clock timer;
+
+  EvaluationBudget budget(0, 0.5);
+  timer.tic();
+  opt.Optimize(f, coordinates, budget);
+  REQUIRE(timer.toc() < 2);
+  REQUIRE(budget.Exhausted());
+  REQUIRE(budget.ElapsedTime() >= 0.5);
+  REQUIRE(budget.EvaluationsPerSecond() > 0);
+}
+
+/**
+ * A sphere function that allocates (and touches) a large buffer at its first
+ * evaluation, so that the resident memory grows during the optimization.
+ */
+class AllocatingSphereFunction
+{
+ public:
+  double Evaluate(const arma::mat& coordinates)
+  {
+    if (buffer.empty())
+      buffer.assign((size_t) 1 << 23, 1.0);
+    return arma::dot(coordinates, coordinates);
+  }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    gradient = 2 * coordinates;
+  }
+
+  std::vector<double> buffer;
+};
+
+/**
+ * Make sure the StateBytes() estimates count the state of the policies.
+ */
+TEST_CASE("StateBytesTest", "[CallbacksTest]")
+{
+  const size_t bytes = 1000 * 10 * sizeof(double);
+  REQUIRE(StateBytes<arma::mat>(AdamUpdate(), 1000, 10) == 2 * bytes);
+  REQUIRE(StateBytes<arma::fmat>(AdamUpdate(), 1000, 10) == bytes);
+  REQUIRE(StateBytes<arma::mat>(AMSGradUpdate(), 1000, 10) == 3 * bytes);
+  REQUIRE(StateBytes<arma::mat>(MomentumUpdate(), 1000, 10) == bytes);
+  REQUIRE(PolicyStateBytes<arma::mat>(VanillaUpdate(), 1000, 10) == 0);
+  REQUIRE(PolicyStateBytes<arma::mat>(MomentumUpdate(), 1000, 10) == bytes);
+
+  // The optimizers add their own buffers, e.g. the gradient.
+  Adam adam;
+  REQUIRE(StateBytes<arma::mat>(adam, 1000, 10) == 3 * bytes);
+  L_BFGS lbfgs(5);
+  REQUIRE(StateBytes<arma::mat>(lbfgs, 1000, 10) >= 15 * bytes);
+  REQUIRE(StateBytes<arma::mat>(FullCovariance(), 100, 1) ==
+      2 * 100 * 100 * sizeof(double));
+
+  // Optimizers without an estimate don't report an empty state.
+  SA<> sa;
+  REQUIRE(StateBytes<arma::mat>(sa, 1000, 10) == UnknownStateBytes);
+}
+
+/**
+ * Make sure the MemoryFootprint callback takes the estimate of the optimizer
+ * and measures the memory that the function allocates.
+ */
+TEST_CASE("MemoryFootprintCallbackTest", "[CallbacksTest]")
+{
+  AllocatingSphereFunction f;
+  arma::mat coordinates(100, 1, arma::fill::ones);
+  L_BFGS lbfgs;
+
+  MemoryFootprint footprint(1);
+  lbfgs.Optimize(f, coordinates, footprint);
+
+  REQUIRE(footprint.EstimatedBytes() ==
+      lbfgs.StateBytes<arma::mat>(100, 1));
+  #ifdef __linux__
+  REQUIRE(footprint.PeakBytes() >= f.buffer.size() * sizeof(double) / 2);
+  #else
+  REQUIRE(footprint.PeakBytes() == 0);
+  #endif
+}
+
 /**
  * Make sure the ProgressBar callback will show the progress on the specified
  * output stream if the MaxIterations parameter of the optimizer is 0.
@@ -714,6 +885,316 @@ TEST_CASE("ProgressBarCallbackEpochTest", "[CallbacksTest]")
   REQUIRE(stream.str().find("Epoch 1/1") != std::string::npos);
 }
 
+/**
+ * Make sure the AsyncCallback adapter replays the calls to the wrapped callback
+ * before the optimization ends.
+ */
+TEST_CASE("AsyncCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  StandardSGD s(0.0003, 1, 3000, -100, true);
+
+  AsyncCallback<CompleteCallbackTestFunction> async(
+      CompleteCallbackTestFunction(), 16, 10);
+  s.Optimize(f, coordinates, async);
+
+  REQUIRE(async.Wrapped().calledBeginOptimization == true);
+  REQUIRE(async.Wrapped().calledBeginEpoch == true);
+  REQUIRE(async.Wrapped().calledEndEpoch == true);
+  REQUIRE(async.Wrapped().calledStepTaken == true);
+  REQUIRE(async.Wrapped().calledEndOptimization == true);
+  // Gradients are not forwarded.
+  REQUIRE(async.Wrapped().calledGradient == false);
+  REQUIRE(async.Dropped() == 0);
+
+  // The output of PrintLoss must be complete once Optimize() returns.
+  std::stringstream syncStream, asyncStream;
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, PrintLoss(syncStream));
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates,
+      AsyncCallback<PrintLoss>(PrintLoss(asyncStream)));
+  const std::string syncOutput = syncStream.str();
+  const std::string asyncOutput = asyncStream.str();
+  REQUIRE(asyncOutput.length() > 0);
+  REQUIRE(std::count(asyncOutput.begin(), asyncOutput.end(), '\n') ==
+      std::count(syncOutput.begin(), syncOutput.end(), '\n'));
+}
+
+/**
+ * Callback that records the optimizer and the step size it is called with.
+ */
+struct StepSizeRecorder
+{
+  StepSizeRecorder() : optimizer(NULL) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void StepTaken(OptimizerType& optimizer,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    this->optimizer = &optimizer;
+    stepSizes.push_back(optimizer.StepSize());
+  }
+
+  const void* optimizer;
+  std::vector<double> stepSizes;
+};
+
+/**
+ * Make sure that the AsyncCallback adapter calls the wrapped callback with a
+ * copy of the optimizer that has the step size of each recorded call.
+ */
+TEST_CASE("AsyncCallbackSnapshotTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  StandardSGD s(0.0003, 1, 300, -100, true);
+
+  AsyncCallback<StepSizeRecorder> async(StepSizeRecorder(), 16, 1);
+  s.Optimize(f, coordinates, async);
+
+  REQUIRE(async.Wrapped().optimizer != NULL);
+  REQUIRE(async.Wrapped().optimizer != (const void*) &s);
+  REQUIRE(async.Wrapped().stepSizes.size() > 0);
+  for (size_t i = 0; i < async.Wrapped().stepSizes.size(); ++i)
+    REQUIRE(async.Wrapped().stepSizes[i] == 0.0003);
+}
+
+/**
+ * Make sure that an optimization resumed from a checkpoint continues exactly
+ * like an uninterrupted one.
+ */
+TEST_CASE("CheckpointCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  const std::string filename = "checkpoint_callback_test.bin";
+
+  // 3 functions with a batch size of 1, so 20 epochs.
+  Adam full(0.01, 1, 0.9, 0.999, 1e-8, 60, -100, false);
+  arma::mat fullCoordinates = f.GetInitialPoint();
+  full.Optimize(f, fullCoordinates);
+
+  Adam first(0.01, 1, 0.9, 0.999, 1e-8, 30, -100, false);
+  arma::mat coordinates = f.GetInitialPoint();
+  first.Optimize(f, coordinates, Checkpoint(filename, 5));
+
+  Adam second(0.01, 1, 0.9, 0.999, 1e-8, 30, -100, false);
+  arma::mat resumedCoordinates;
+  Checkpoint::Load(filename, second, resumedCoordinates);
+  REQUIRE(arma::approx_equal(resumedCoordinates, coordinates, "absdiff",
+      1e-15));
+  second.Optimize(f, resumedCoordinates);
+  std::remove(filename.c_str());
+
+  REQUIRE(arma::approx_equal(resumedCoordinates, fullCoordinates, "absdiff",
+      1e-12));
+}
+
+/**
+ * Make sure that the warm start store finds the nearest signature of the same
+ * optimizer type, that an L-BFGS run restored from it continues like a run that
+ * kept its history, and that the store survives a round trip through a file.
+ */
+TEST_CASE("WarmStartStoreCallbackTest", "[CallbacksTest]")
+{
+  RosenbrockFunction f;
+  WarmStartStore store(2);
+  const std::string filename = "warm_start_store_test.bin";
+
+  L_BFGS first(10, 3);
+  arma::mat coordinates = f.GetInitialPoint();
+  first.Optimize(f, coordinates, StoreWarmStart(store, arma::vec("1 2")));
+  REQUIRE(store.Size() == 1);
+
+  // The same two runs, keeping the history in the optimizer.
+  L_BFGS reference(10, 3);
+  reference.ResetPolicy() = false;
+  arma::mat referenceCoordinates = f.GetInitialPoint();
+  reference.Optimize(f, referenceCoordinates);
+  reference.Optimize(f, referenceCoordinates);
+
+  L_BFGS second(10, 3);
+  arma::mat warmCoordinates;
+  REQUIRE(store.Lookup(arma::vec("1.1 2"), second, warmCoordinates));
+  REQUIRE(arma::approx_equal(warmCoordinates, coordinates, "absdiff", 1e-15));
+  second.Optimize(f, warmCoordinates);
+  REQUIRE(arma::approx_equal(warmCoordinates, referenceCoordinates, "absdiff",
+      1e-12));
+
+  // Other optimizer types don't find the state of L-BFGS.
+  GradientDescent gd;
+  arma::mat gdCoordinates;
+  REQUIRE(!store.Lookup(arma::vec("1 2"), gd, gdCoordinates));
+
+  // The nearest signature is used, within the maximum distance.
+  const arma::mat zeros(2, 1, arma::fill::zeros);
+  store.Insert(arma::vec("5 5"), first, zeros);
+  REQUIRE(store.Lookup(arma::vec("4 4"), second, warmCoordinates));
+  REQUIRE(arma::all(arma::vectorise(warmCoordinates) == 0));
+  REQUIRE(!store.Lookup(arma::vec("100 100"), second, warmCoordinates, 1.0));
+
+  // The least recently used optimization is forgotten.
+  store.Insert(arma::vec("9 9"), first, coordinates);
+  REQUIRE(store.Size() == 2);
+  REQUIRE(!store.Lookup(arma::vec("1 2"), second, warmCoordinates, 1.0));
+  REQUIRE(store.Hits() == 2);
+  REQUIRE(store.Misses() == 3);
+
+  store.Save(filename);
+  WarmStartStore loaded;
+  loaded.Load(filename);
+  std::remove(filename.c_str());
+
+  REQUIRE(loaded.Size() == 2);
+  REQUIRE(loaded.Lookup(arma::vec("9 9"), second, warmCoordinates, 0.0));
+  REQUIRE(arma::approx_equal(warmCoordinates, coordinates, "absdiff", 1e-15));
+}
+
+/**
+ * The step size range test on the sphere function with full batches should
+ * pick a step size that converges (below 1), and not a tiny one.
+ */
+TEST_CASE("StepSizeFinderCallbackTest", "[CallbacksTest]")
+{
+  SphereFunction f(10);
+  StandardSGD s(1e-3, 10, 5000, -1.0, false);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  StepSizeFinder finder;
+  const double stepSize = finder.Find(s, f, coordinates);
+  REQUIRE(s.StepSize() == stepSize);
+  REQUIRE(stepSize > 0.1);
+  REQUIRE(stepSize < 1.0);
+
+  // The sweep doesn't change the coordinates.
+  REQUIRE(arma::approx_equal(coordinates, f.GetInitialPoint<arma::mat>(),
+      "absdiff", 0.0));
+
+  s.Optimize(f, coordinates);
+  REQUIRE(f.Evaluate(coordinates) < 1e-5);
+}
+
+/**
+ * If the step size diverges, StepSizeFinder::Optimize() should roll back and
+ * reduce it until the optimization converges.
+ */
+TEST_CASE("StepSizeFinderRollbackTest", "[CallbacksTest]")
+{
+  SphereFunction f(10);
+  StandardSGD s(1e-3, 10, 4000, 1e-9, false);
+  arma::mat coordinates = f.GetInitialPoint();
+
+  // Choose 10 times the step size with the lowest objective, which diverges.
+  StepSizeFinder finder;
+  finder.Divisor() = 0.1;
+  finder.Optimize(s, f, coordinates);
+
+  REQUIRE(finder.Rollbacks() > 0);
+  REQUIRE(finder.Rollbacks() <= finder.MaxRollbacks());
+  REQUIRE(s.StepSize() < 1.0);
+  REQUIRE(s.MaxIterations() == 4000);
+  REQUIRE(f.Evaluate(coordinates) < 1e-5);
+}
+
+/**
+ * Make sure the Metrics callback counts steps and epochs, and exports them in
+ * the OpenMetrics and StatsD formats.
+ */
+TEST_CASE("MetricsCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  StandardSGD s(0.0003, 1, 30, -100, true);
+
+  std::vector<std::string> pushes;
+  Metrics metrics("test", [&](const std::string& payload)
+      { pushes.push_back(payload); }, 1000.0);
+  s.Optimize(f, coordinates, metrics);
+
+  REQUIRE(metrics.Steps() == 30);
+  REQUIRE(metrics.Epochs() == 10);
+
+  std::ostringstream openMetrics;
+  metrics.WriteOpenMetrics(openMetrics);
+  REQUIRE(openMetrics.str().find("test_steps_total 30") != std::string::npos);
+  REQUIRE(openMetrics.str().find("test_epochs_total 10") != std::string::npos);
+  REQUIRE(openMetrics.str().find(
+      "test_epoch_duration_seconds_bucket{le=\"+Inf\"} 10") !=
+      std::string::npos);
+  REQUIRE(openMetrics.str().find("# EOF") != std::string::npos);
+
+  // The push interval was not reached, so the metrics are only pushed at the
+  // end of the optimization.
+  REQUIRE(pushes.size() == 1);
+  REQUIRE(pushes[0].find("test.steps:30|c") != std::string::npos);
+
+  // The next optimization continues the counters, and StatsD receives the
+  // increments.
+  s.Optimize(f, coordinates, metrics);
+  REQUIRE(metrics.Steps() == 60);
+  REQUIRE(pushes.size() == 2);
+  REQUIRE(pushes[1].find("test.steps:30|c") != std::string::npos);
+}
+
+/**
+ * Make sure the Profiler callback counts the phases reported by SGD.
+ */
+TEST_CASE("ProfilerCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+
+  // 3 functions with a batch size of 1, so 10 epochs.
+  StandardSGD s(0.0003, 1, 30, -100, true);
+
+  std::stringstream stream;
+  Profiler profiler(true, stream);
+  s.Optimize(f, coordinates, profiler);
+
+  REQUIRE(profiler.Calls(Phase::Function) == 30);
+  REQUIRE(profiler.Calls(Phase::Update) == 30);
+  REQUIRE(profiler.Calls(Phase::Decay) == 30);
+  REQUIRE(profiler.Calls(Phase::Shuffle) == 10);
+  REQUIRE(profiler.WallTime(Phase::Update) >= 0.0);
+  REQUIRE(profiler.TotalWallTime() >= profiler.WallTime(Phase::Function));
+  REQUIRE(stream.str().find("update policy") != std::string::npos);
+
+  // Optimizers that don't report phases only measure the total time.
+  RosenbrockWoodFunction f1;
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 10;
+  coordinates = f1.GetInitialPoint();
+  Profiler lbfgsProfiler(false);
+  lbfgs.Optimize(f1, coordinates, lbfgsProfiler);
+  REQUIRE(lbfgsProfiler.Calls(Phase::Function) == 0);
+  REQUIRE(lbfgsProfiler.TotalWallTime() > 0.0);
+}
+
+/**
+ * Without ENS_USE_PERF_EVENTS, asking for the hardware counters should leave
+ * the profiler with only its timers.
+ */
+TEST_CASE("ProfilerTimerOnlyTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  StandardSGD s(0.0003, 1, 30, -100, true);
+
+  std::stringstream stream;
+  Profiler profiler(true, stream, true);
+  s.Optimize(f, coordinates, profiler);
+
+  REQUIRE(profiler.Calls(Phase::Function) == 30);
+  REQUIRE(profiler.TotalWallTime() >= profiler.WallTime(Phase::Function));
+  #ifndef ENS_USE_PERF_EVENTS
+  REQUIRE(profiler.Cycles(Phase::Function) == 0);
+  REQUIRE(profiler.Instructions(Phase::Function) == 0);
+  REQUIRE(stream.str().find("cycles") == std::string::npos);
+  #endif
+}
+
 /**
  * Make sure the Report callback will show the report on the specified
  * output stream.
@@ -755,3 +1236,142 @@ TEST_CASE("ReportCallbackTest", "[CallbacksTest]")
   aug.Optimize(f3, coordinates, Report(0.1, stream));
   REQUIRE(stream.str().length() > 0);
 }
+
+/**
+ * Make sure the Report callback with a bounded history reports the same
+ * iterations and final loss as the Report callback that stores every step.
+ */
+TEST_CASE("ReportCallbackMaxStoredStepsTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 10000, -100, false);
+
+  std::stringstream fullStream;
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, Report(0.1, fullStream));
+
+  std::stringstream boundedStream;
+  coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates, Report(0.1, boundedStream, 4, 16));
+
+  // Extract the line with the given label from the report.
+  auto findLine = [](const std::string& report, const std::string& label)
+  {
+    const size_t start = report.find(label);
+    REQUIRE(start != std::string::npos);
+    return report.substr(start, report.find('\n', start) - start);
+  };
+
+  const std::string full = fullStream.str();
+  const std::string bounded = boundedStream.str();
+  REQUIRE(findLine(full, "Iterations:") == findLine(bounded, "Iterations:"));
+  REQUIRE(findLine(full, "Final    ") == findLine(bounded, "Final    "));
+  REQUIRE(findLine(full, "Change    ") == findLine(bounded, "Change    "));
+  REQUIRE(findLine(bounded, "Iterations:").find("10000") !=
+      std::string::npos);
+}
+
+/**
+ * A callback that only counts the epochs.
+ */
+class EndEpochCounter
+{
+ public:
+  EndEpochCounter() : epochs(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double /* objective */)
+  { ++epochs; }
+
+  size_t epochs;
+};
+
+/**
+ * Make sure that the callbacks of a stage are dispatched at compile time: the
+ * stages that no callback implements do nothing, and the others still call the
+ * callbacks that implement them.
+ */
+TEST_CASE("CallbackCompileTimeDispatchTest", "[CallbacksTest]")
+{
+  REQUIRE(!AnyOf<>::value);
+  REQUIRE(!AnyOf<false, false>::value);
+  REQUIRE(AnyOf<false, true>::value);
+  REQUIRE((std::is_base_of<std::false_type, AnyOf<> >::value));
+
+  typedef StandardSGD OptimizerType;
+  REQUIRE(!(AnyOf<!HasStepTakenSignature<EndEpochCounter, OptimizerType,
+      SGDTestFunction, arma::mat>::hasNone>::value));
+  REQUIRE((AnyOf<!HasEndEpochSignature<EndEpochCounter, OptimizerType,
+      SGDTestFunction, arma::mat>::hasNone>::value));
+
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 3 * f.NumFunctions(), -100, false);
+  arma::mat coordinates = f.GetInitialPoint();
+  EndEpochCounter counter;
+  REQUIRE(!Callback::StepTaken(s, f, coordinates));
+  REQUIRE(!Callback::StepTaken(s, f, coordinates, counter));
+
+  s.Optimize(f, coordinates, counter);
+  REQUIRE(counter.epochs == 3);
+}
+
+/**
+ * Make sure the TraceRecorder callback records every stepInterval'th step and
+ * every epoch, over several blocks, and that Load() reads the file back.
+ */
+TEST_CASE("TraceRecorderCallbackTest", "[CallbacksTest]")
+{
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  const std::string filename = "trace_recorder_callback_test.bin";
+
+  // 3 functions with a batch size of 1, so 300 steps and 100 epochs.
+  StandardSGD s(0.0003, 1, 300, -100, true);
+  TraceRecorder recorder(filename, 10, 16);
+  s.Optimize(f, coordinates, recorder);
+  REQUIRE(recorder.Rows() == 130);
+
+  arma::mat trace;
+  TraceRecorder::Load(filename, trace);
+  std::remove(filename.c_str());
+
+  REQUIRE(trace.n_rows == 130);
+  REQUIRE(trace.n_cols == TraceRecorder::NumColumns);
+
+  const arma::uvec stepRows = arma::find(trace.col(TraceRecorder::Kind) ==
+      double(TraceRecorder::StepEvent));
+  const arma::uvec epochRows = arma::find(trace.col(TraceRecorder::Kind) ==
+      double(TraceRecorder::EpochEvent));
+  REQUIRE(stepRows.n_elem == 30);
+  REQUIRE(epochRows.n_elem == 100);
+
+  for (size_t i = 0; i < stepRows.n_elem; ++i)
+  {
+    const arma::rowvec row = trace.row(stepRows[i]);
+    REQUIRE(row[TraceRecorder::Index] == 10.0 * (i + 1));
+    REQUIRE(row[TraceRecorder::StepSize] == Approx(0.0003));
+    REQUIRE(row[TraceRecorder::Gradients] >= row[TraceRecorder::Index]);
+    REQUIRE(std::isfinite(row[TraceRecorder::GradientNorm]));
+  }
+
+  // The rows are in the order of the events.
+  for (size_t i = 1; i < trace.n_rows; ++i)
+  {
+    REQUIRE(trace(i, TraceRecorder::Time) >= trace(i - 1,
+        TraceRecorder::Time));
+    REQUIRE(trace(i, TraceRecorder::Gradients) >= trace(i - 1,
+        TraceRecorder::Gradients));
+  }
+
+  // Epochs have an objective, but no gradient norm.
+  for (size_t i = 0; i < epochRows.n_elem; ++i)
+  {
+    REQUIRE(trace(epochRows[i], TraceRecorder::Index) == i);
+    REQUIRE(std::isfinite(trace(epochRows[i], TraceRecorder::Objective)));
+    REQUIRE(std::isnan(trace(epochRows[i], TraceRecorder::GradientNorm)));
+  }
+}
@@ -56,3 +56,308 @@ TEST_CASE("ApproxCMAESLogisticRegressionFMatTest", "[CMAESTest]")
   ApproxCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
   LogisticRegressionFunctionTest<arma::fmat>(cmaes, 0.01, 0.02, 5);
 }
+
+/**
+ * Run CMA-ES with the adaptive selection policy on logistic regression and
+ * make sure the results are acceptable.
+ */
+TEST_CASE("AdaptiveCMAESLogisticRegressionTest", "[CMAESTest]")
+{
+  CMAES<AdaptiveSelection> cmaes(0, -1, 1, 32, 200, 1e-3);
+  LogisticRegressionFunctionTest(cmaes, 0.003, 0.006, 5);
+  REQUIRE(cmaes.SelectionPolicy().BatchEvaluations() > 0);
+}
+
+/**
+ * Candidates that every batch ranks the same way should be ranked on a small
+ * subsample, with objectives that estimate the full objective.
+ */
+TEST_CASE("AdaptiveSelectionStableRankingTest", "[CMAESTest]")
+{
+  SphereFunction f(100);
+  std::vector<arma::mat> population(8);
+  for (size_t j = 0; j < population.size(); ++j)
+    population[j] = arma::mat(100, 1, arma::fill::ones) * (j + 1.0);
+
+  AdaptiveSelection selection(0.1, 2.0, 0.05);
+  arma::vec objectives;
+  selection.SelectPopulation(f, 1, population, objectives);
+
+  // The ranking is the same on the first 10 batches and on the first 20.
+  REQUIRE(selection.BatchEvaluations() == 20 * population.size());
+  for (size_t j = 0; j < population.size(); ++j)
+    REQUIRE(objectives(j) == Approx(f.Evaluate(population[j])));
+}
+
+/**
+ * Run CMA-ES with parallel evaluation of the population on logistic regression
+ * and make sure the results are acceptable.
+ */
+TEST_CASE("CMAESParallelEvaluationLogisticRegressionTest", "[CMAESTest]")
+{
+  CMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  cmaes.ParallelEvaluation() = true;
+  LogisticRegressionFunctionTest(cmaes, 0.003, 0.006, 5);
+}
+
+/**
+ * With parallel evaluation, the result of approximate CMA-ES for a given seed
+ * should not depend on the number of threads.
+ */
+TEST_CASE("ApproxCMAESParallelEvaluationThreadsTest", "[CMAESTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData, responses,
+      testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  ApproxCMAES<> cmaes(0, -1, 1, 32, 50, 1e-3);
+  cmaes.ParallelEvaluation() = true;
+
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  #ifdef ENS_USE_OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  #endif
+  arma::arma_rng::set_seed(42);
+  const double objective1 = cmaes.Optimize(lr, coordinates1);
+
+  arma::mat coordinates2 = lr.GetInitialPoint();
+  #ifdef ENS_USE_OPENMP
+  omp_set_num_threads(std::max(threads, 2));
+  #endif
+  arma::arma_rng::set_seed(42);
+  const double objective2 = cmaes.Optimize(lr, coordinates2);
+  #ifdef ENS_USE_OPENMP
+  omp_set_num_threads(threads);
+  #endif
+
+  REQUIRE(objective1 == objective2);
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates1[i] == coordinates2[i]);
+}
+
+/**
+ * Run CMA-ES with mirrored sampling, sequential selection and the active
+ * covariance update on logistic regression, and make sure the results are
+ * acceptable.
+ */
+TEST_CASE("CMAESMirroredActiveLogisticRegressionTest", "[CMAESTest]")
+{
+  CMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  cmaes.MirroredSampling() = true;
+  cmaes.SequentialSelection() = true;
+  cmaes.ActiveCovariance() = true;
+  LogisticRegressionFunctionTest(cmaes, 0.003, 0.006, 5);
+}
+
+/**
+ * Run CMA-ES with a diagonal covariance and the active covariance update on a
+ * Rosenbrock function, and make sure that the covariance stays positive.
+ */
+TEST_CASE("SepCMAESActiveRosenbrockTest", "[CMAESTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+  SepCMAES<> cmaes(0, -2, 2, 1, 2000, 1e-10);
+  cmaes.MirroredSampling() = true;
+  cmaes.ActiveCovariance() = true;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = cmaes.Optimize(f, coordinates);
+
+  REQUIRE(objective < f.Evaluate(f.GetInitialPoint()));
+  REQUIRE(coordinates.is_finite());
+}
+
+/**
+ * A sphere function that counts the calls to Evaluate(), and does not have
+ * EvaluateBatch(), so that CMA-ES evaluates each candidate.
+ */
+class CountingSphereFunction
+{
+ public:
+  CountingSphereFunction(const size_t n) : n(n), evaluations(0) { }
+
+  size_t NumFunctions() const { return 1; }
+
+  void Shuffle() { }
+
+  arma::mat GetInitialPoint() const { return arma::ones<arma::mat>(n, 1); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t /* begin */,
+                  const size_t /* batchSize */)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(coordinates));
+  }
+
+  size_t n;
+  size_t evaluations;
+};
+
+/**
+ * Make sure that pre-screening the candidates with the surrogate converges on
+ * a quadratic function with far fewer evaluations than plain CMA-ES.
+ */
+TEST_CASE("CMAESSurrogateSphereTest", "[CMAESTest]")
+{
+  CMAES<> cmaes(0, -2, 2, 1, 120, -1);
+  CountingSphereFunction f(5);
+  arma::mat coordinates = f.GetInitialPoint();
+  cmaes.Optimize(f, coordinates);
+  const size_t plainEvaluations = f.evaluations;
+
+  cmaes.Surrogate() = true;
+  CountingSphereFunction g(5);
+  arma::mat surrogateCoordinates = g.GetInitialPoint();
+  const double objective = cmaes.Optimize(g, surrogateCoordinates);
+
+  REQUIRE(objective < 1e-6);
+  REQUIRE(2 * g.evaluations < plainEvaluations);
+}
+
+/**
+ * Make sure that CMA-ES stops the evaluation of the candidates that can't be
+ * among the best mu when the function has EvaluateBounded(), and still
+ * converges.
+ */
+TEST_CASE("CMAESEvaluateBoundedTest", "[CMAESTest]")
+{
+  CMAES<> cmaes(0, -2, 2, 1, 500, -1);
+  BoundedSphereFunction f(8);
+  arma::mat coordinates(8, 1, arma::fill::zeros);
+  const double objective = cmaes.Optimize(f, coordinates);
+
+  REQUIRE(f.boundedCalls > 0);
+  REQUIRE(f.boundedTerms < f.n * f.boundedCalls);
+  REQUIRE(objective < 1e-4);
+}
+
+/**
+ * Run CMA-ES with a diagonal covariance on logistic regression and make sure
+ * the results are acceptable.
+ */
+TEST_CASE("SepCMAESLogisticRegressionTest", "[CMAESTest]")
+{
+  SepCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  LogisticRegressionFunctionTest(cmaes, 0.003, 0.006, 5);
+}
+
+/**
+ * Run CMA-ES with a limited-memory covariance on logistic regression and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("LMCMAESLogisticRegressionTest", "[CMAESTest]")
+{
+  LMCMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  LogisticRegressionFunctionTest(cmaes, 0.003, 0.006, 5);
+}
+
+/**
+ * Run CMA-ES with a diagonal covariance on a Rosenbrock function, and make sure
+ * it converges to the minimum even though the diagonal can't follow the
+ * curved valley.  All the generations are run, so that a generation without a
+ * better point doesn't end the optimization early.
+ */
+TEST_CASE("SepCMAESGeneralizedRosenbrockTest", "[CMAESTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+  SepCMAES<> cmaes(0, -2, 2, 1, 5000, -1.0);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = cmaes.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(f.GetFinalObjective()).margin(1e-6));
+  CheckMatrices(coordinates, f.GetFinalPoint(), 1e-3);
+}
+
+/**
+ * Run CMA-ES with a small population on a 64-dimensional sphere function, so
+ * that the lazy factorization of the covariance is only refreshed every few
+ * generations, and make sure that it converges as well as the factorization in
+ * every generation, with fewer factorizations.  The two runs draw different
+ * samples, so only their convergence is compared.
+ */
+TEST_CASE("CMAESLazyFactorizationTest", "[CMAESTest]")
+{
+  CountingSphereFunction f(64);
+
+  CMAES<> lazy(6, -1, 1, 1, 4000, -1.0);
+  arma::mat lazyCoordinates = f.GetInitialPoint();
+  auto lazyState = lazy.Begin(f, lazyCoordinates);
+  while (lazy.Step(lazyState, 100)) { }
+
+  CMAES<> eager(6, -1, 1, 1, 4000, -1.0);
+  eager.CovariancePolicy().LazyFactorization() = false;
+  arma::mat eagerCoordinates = f.GetInitialPoint();
+  auto eagerState = eager.Begin(f, eagerCoordinates);
+  while (eager.Step(eagerState, 100)) { }
+
+  REQUIRE(lazyState.Objective() == Approx(0.0).margin(1e-8));
+  REQUIRE(eagerState.Objective() == Approx(0.0).margin(1e-8));
+  REQUIRE(arma::abs(lazyCoordinates).max() < 1e-3);
+  REQUIRE(arma::abs(eagerCoordinates).max() < 1e-3);
+
+  REQUIRE(lazyState.Covariance().Factorizations() > 0);
+  REQUIRE(lazyState.Covariance().Factorizations() <
+      eagerState.Covariance().Factorizations());
+}
+
+/**
+ * Make sure that reusing the buffers of an earlier call, also for a problem of
+ * another size, gives the same results as a fresh optimizer.
+ */
+TEST_CASE("CMAESWorkspaceReuseTest", "[CMAESTest]")
+{
+  CMAES<FullSelection> cmaes(0, -10, 10, 1, 100, 1e-8);
+  CMAES<FullSelection> fresh(cmaes);
+
+  // Run on a problem of another size first, so the buffers are resized.
+  SGDTestFunction f;
+  GeneralizedRosenbrockFunction g(4);
+  arma::mat small = f.GetInitialPoint();
+  cmaes.Optimize(f, small);
+
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    arma::mat reused = g.GetInitialPoint();
+    arma::mat expected = g.GetInitialPoint();
+
+    arma::arma_rng::set_seed(trial + 1);
+    const double reusedObjective = cmaes.Optimize(g, reused);
+    arma::arma_rng::set_seed(trial + 1);
+    const double expectedObjective = CMAES<FullSelection>(fresh).Optimize(g,
+        expected);
+
+    REQUIRE(reusedObjective == Approx(expectedObjective).epsilon(1e-12));
+    CheckMatrices(reused, expected, 1e-12);
+  }
+}
+
+/**
+ * Make sure that running CMA-ES one generation at a time gives the same result
+ * as Optimize().
+ */
+TEST_CASE("CMAESStepTest", "[CMAESTest]")
+{
+  GeneralizedRosenbrockFunction f(4);
+  CMAES<FullSelection> cmaes(0, -10, 10, 1, 100, 1e-8);
+
+  arma::mat expected = f.GetInitialPoint();
+  arma::arma_rng::set_seed(3);
+  const double objective = cmaes.Optimize(f, expected);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::arma_rng::set_seed(3);
+  auto state = cmaes.Begin(f, coordinates);
+  size_t steps = 0;
+  while (cmaes.Step(state))
+    ++steps;
+
+  REQUIRE(steps > 0);
+  REQUIRE(state.Finished());
+  REQUIRE(state.Objective() == Approx(objective).epsilon(1e-12));
+  CheckMatrices(coordinates, expected, 1e-12);
+}
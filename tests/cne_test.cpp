@@ -28,6 +28,29 @@ TEST_CASE("CNELogisticRegressionTest", "[CNETest]")
   LogisticRegressionFunctionTest(opt, 0.003, 0.006);
 }
 
+/**
+ * Train and test a logistic regression function using CNE optimizer, evaluating
+ * the population in parallel.
+ */
+TEST_CASE("CNEParallelEvaluationLogisticRegressionTest", "[CNETest]")
+{
+  CNE opt(300, 150, 0.2, 0.2, 0.2, -1);
+  opt.ParallelEvaluation() = true;
+  LogisticRegressionFunctionTest(opt, 0.003, 0.006);
+}
+
+/**
+ * Train and test a logistic regression function using CNE optimizer, with an
+ * island model of three islands that migrate at random.
+ */
+TEST_CASE("CNEIslandsLogisticRegressionTest", "[CNETest]")
+{
+  CNE opt(300, 150, 0.2, 0.2, 0.2, -1);
+  opt.Islands() = 3;
+  opt.RandomMigration() = true;
+  LogisticRegressionFunctionTest(opt, 0.003, 0.006);
+}
+
 /**
  * Train and test a logistic regression function using CNE optimizer.  Use
  * arma::fmat.
@@ -152,3 +175,47 @@ TEST_CASE("CNESchafferFunctionN2Test", "[CNETest]")
   CNE optimizer(500, 1600, 0.3, 0.3, 0.3, -1);
   FunctionTest<SchafferFunctionN2>(optimizer, 0.5, 0.1, 7);
 }
+
+/**
+ * Make sure that CNE evaluates the population with EvaluateBatch() when the
+ * function provides it.
+ */
+TEST_CASE("CNEEvaluateBatchTest", "[CNETest]")
+{
+  BatchSphereFunction f;
+  CNE optimizer(200, 50, 0.2, 0.2, 0.3, 1e-10);
+
+  arma::mat coords(4, 1, arma::fill::ones);
+  optimizer.Optimize(f, coords);
+
+  // Only the starting point and the final point are evaluated separately.
+  REQUIRE(f.evaluateCalls == 2);
+  REQUIRE(f.evaluateBatchCalls > 0);
+}
+
+/**
+ * Make sure that CNE stops the evaluation of the candidates that can't be
+ * elite when the function has EvaluateBounded(), and still makes progress.
+ */
+TEST_CASE("CNEEvaluateBoundedTest", "[CNETest]")
+{
+  BoundedSphereFunction f(4);
+  CNE optimizer(200, 50, 0.2, 0.2, 0.3, 1e-10);
+
+  arma::mat coords(4, 1, arma::fill::zeros);
+  optimizer.Optimize(f, coords);
+
+  REQUIRE(f.boundedCalls > 0);
+  REQUIRE(f.boundedTerms < f.n * f.boundedCalls);
+  REQUIRE(arma::accu(arma::square(coords - 1.0)) < 0.5);
+}
+
+/**
+ * Train and test a logistic regression function using CNE optimizer, with an
+ * initial population from a Sobol sample.
+ */
+TEST_CASE("CNESobolLogisticRegressionTest", "[CNETest]")
+{
+  CNEType<SobolSampling> opt(300, 150, 0.2, 0.2, 0.2, -1);
+  LogisticRegressionFunctionTest(opt, 0.003, 0.006);
+}
@@ -33,3 +33,83 @@ TEST_CASE("DELogisticRegressionFMatTest", "[DETest]")
   DE opt(200, 1000, 0.6, 0.8, 1e-5);
   LogisticRegressionFunctionTest<arma::fmat>(opt, 0.03, 0.06, 3);
 }
+
+/**
+ * Train and test a logistic regression function using DE optimizer with
+ * synchronous generations that are evaluated in parallel.
+ */
+TEST_CASE("DEParallelEvaluationLogisticRegressionTest", "[DETest]")
+{
+  DE opt(200, 1000, 0.6, 0.8, 1e-5);
+  opt.ParallelEvaluation() = true;
+  LogisticRegressionFunctionTest(opt, 0.01, 0.02, 3);
+}
+
+/**
+ * Train and test a logistic regression function using the steady-state DE
+ * optimizer, whose trials are evaluated asynchronously.
+ */
+TEST_CASE("DEAsyncEvaluationLogisticRegressionTest", "[DETest]")
+{
+  DE opt(200, 1000, 0.6, 0.8, 1e-5);
+  opt.AsyncEvaluation() = true;
+  LogisticRegressionFunctionTest(opt, 0.01, 0.02, 3);
+}
+
+/**
+ * Train and test a logistic regression function using DE optimizer, with an
+ * island model of four islands.
+ */
+TEST_CASE("DEIslandsLogisticRegressionTest", "[DETest]")
+{
+  DE opt(200, 1000, 0.6, 0.8, 1e-5);
+  opt.Islands() = 4;
+  opt.MigrationInterval() = 5;
+  LogisticRegressionFunctionTest(opt, 0.01, 0.02, 3);
+}
+
+/**
+ * Make sure that with ParallelEvaluation(), DE evaluates each generation with
+ * a single call to EvaluateBatch() when the function provides it.
+ */
+TEST_CASE("DEEvaluateBatchTest", "[DETest]")
+{
+  BatchSphereFunction f;
+  DE opt(50, 200, 0.9, 0.8, 0.0);
+  opt.ParallelEvaluation() = true;
+
+  arma::mat coords(4, 1, arma::fill::ones);
+  opt.Optimize(f, coords);
+
+  // The initial population and each generation are evaluated once.
+  REQUIRE(f.evaluateCalls == 0);
+  REQUIRE(f.evaluateBatchCalls == 201);
+  REQUIRE(arma::accu(arma::square(coords)) < 1e-3);
+}
+
+/**
+ * Make sure that DE stops the evaluation of a trial once it is worse than its
+ * member when the function has EvaluateBounded(), and still converges.
+ */
+TEST_CASE("DEEvaluateBoundedTest", "[DETest]")
+{
+  BoundedSphereFunction f(8);
+  DE opt(50, 300, 0.9, 0.8, 0.0);
+
+  arma::mat coords(8, 1, arma::fill::zeros);
+  opt.Optimize(f, coords);
+
+  REQUIRE(f.boundedCalls == 300 * 50);
+  REQUIRE(f.boundedTerms < 0.9 * f.n * f.boundedCalls);
+  REQUIRE(arma::accu(arma::square(coords - 1.0)) < 1e-3);
+}
+
+/**
+ * Train and test a logistic regression function using DE optimizer, with an
+ * initial population from a Latin hypercube sample.
+ */
+TEST_CASE("DELatinHypercubeLogisticRegressionTest", "[DETest]")
+{
+  DEType<LatinHypercubeSampling> opt(200, 1000, 0.6, 0.8, 1e-5);
+  LogisticRegressionFunctionTest(opt, 0.01, 0.02, 3);
+}
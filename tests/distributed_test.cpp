@@ -0,0 +1,133 @@
+/**
+ * @file distributed_test.cpp
+ *
+ * Test the distributed optimization tools with a single process.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run L-BFGS on the Rosenbrock function through an AllReduceFunction.
+ */
+TEST_CASE("AllReduceFunctionLBFGSTest", "[DistributedTest]")
+{
+  RosenbrockFunction rf;
+  LocalCommunicator communicator;
+  AllReduceFunction<RosenbrockFunction> f(rf, communicator);
+
+  L_BFGS lbfgs;
+  arma::mat coordinates = rf.GetInitialPoint();
+  lbfgs.Optimize(f, coordinates);
+
+  REQUIRE(coordinates(0) == Approx(1.0).epsilon(1e-5));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(1e-5));
+}
+
+/**
+ * Run SGD on logistic regression through an AllReduceFunction.
+ */
+TEST_CASE("AllReduceFunctionSGDLogisticRegressionTest", "[DistributedTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  LocalCommunicator communicator;
+  AllReduceFunction<LogisticRegression<>> f(lr, communicator);
+
+  StandardSGD sgd;
+  arma::mat coordinates = lr.GetInitialPoint();
+  sgd.Optimize(f, coordinates);
+
+  REQUIRE(lr.ComputeAccuracy(data, responses, coordinates) ==
+      Approx(100.0).epsilon(0.003));
+  REQUIRE(lr.ComputeAccuracy(testData, testResponses, coordinates) ==
+      Approx(100.0).epsilon(0.006));
+}
+
+/**
+ * Run model averaging with SGD on logistic regression.
+ */
+TEST_CASE("ModelAveragingLogisticRegressionTest", "[DistributedTest]")
+{
+  ModelAveraging<> optimizer(StandardSGD(), LocalCommunicator(), 10000, 50);
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006);
+}
+
+/**
+ * Run consensus ADMM with L-BFGS on logistic regression split into four
+ * blocks, and make sure that it finds the minimum of the whole objective.
+ */
+TEST_CASE("ConsensusADMMLogisticRegressionTest", "[DistributedTest]")
+{
+  arma::mat data(5, 1000, arma::fill::randn);
+  arma::Row<size_t> responses(1000);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+  {
+    responses[i] = (data(0, i) + 0.5 * data(1, i) +
+        0.5 * arma::randn() > 0.0) ? 1 : 0;
+  }
+
+  // The regularization of the whole objective is split over the blocks.
+  std::vector<arma::mat> shardData(4);
+  std::vector<arma::Row<size_t>> shardResponses(4);
+  for (size_t k = 0; k < 4; ++k)
+  {
+    shardData[k] = data.cols(250 * k, 250 * k + 249);
+    shardResponses[k] = responses.cols(250 * k, 250 * k + 249);
+  }
+
+  std::vector<LogisticRegressionFunction<>> blocks;
+  for (size_t k = 0; k < 4; ++k)
+    blocks.push_back(LogisticRegressionFunction<>(shardData[k],
+        shardResponses[k], 0.25));
+
+  LogisticRegressionFunction<> lrf(data, responses, 1.0);
+  arma::mat lbfgsCoordinates = lrf.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.Optimize(lrf, lbfgsCoordinates);
+
+  ConsensusADMM<> optimizer(L_BFGS(), LocalCommunicator(), 10.0, 1.5, 200);
+  arma::mat coordinates = lrf.GetInitialPoint();
+  const double objective = optimizer.Optimize(blocks, coordinates);
+
+  REQUIRE(objective == Approx(lrf.Evaluate(lbfgsCoordinates)).epsilon(1e-5));
+  for (size_t i = 0; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates[i] == Approx(lbfgsCoordinates[i]).margin(1e-3));
+}
+
+/**
+ * Make sure that consensus ADMM rejects invalid parameters.
+ */
+TEST_CASE("ConsensusADMMInvalidParametersTest", "[DistributedTest]")
+{
+  std::vector<RosenbrockFunction> blocks(2);
+  arma::mat coordinates = blocks[0].GetInitialPoint();
+
+  ConsensusADMM<> optimizer(L_BFGS(), LocalCommunicator(), 0.0);
+  REQUIRE_THROWS_AS(optimizer.Optimize(blocks, coordinates),
+      std::invalid_argument);
+
+  optimizer.Rho() = 1.0;
+  optimizer.Alpha() = 2.0;
+  REQUIRE_THROWS_AS(optimizer.Optimize(blocks, coordinates),
+      std::invalid_argument);
+
+  std::vector<RosenbrockFunction> noBlocks;
+  optimizer.Alpha() = 1.5;
+  REQUIRE_THROWS_AS(optimizer.Optimize(noBlocks, coordinates),
+      std::invalid_argument);
+}
@@ -68,3 +68,43 @@ TEST_CASE("EveStyblinskiTangFunctionSpMatTest","[EveTest]")
 }
 
 #endif
+
+/**
+ * Make sure that Eve gives the same result as SGD with the EveUpdate policy,
+ * also as the policy of the only group of ParameterGroups.
+ */
+TEST_CASE("EveUpdatePolicyTest", "[EveTest]")
+{
+  SphereFunction f(2);
+  Eve eve(1e-3, 2, 0.9, 0.999, 0.999, 1e-8, 10000, 5000, 1e-9, false);
+  SGD<EveUpdate> sgd(1e-3, 2, 5000, 1e-9, false,
+      EveUpdate(0.9, 0.999, 0.999, 1e-8, 10000));
+
+  std::vector<ParameterGroup> groups(1, ParameterGroup(0, 2));
+  typedef ParameterGroups<EveUpdate> GroupUpdate;
+  SGD<GroupUpdate> grouped(1e-3, 2, 5000, 1e-9, false,
+      GroupUpdate(groups, EveUpdate(0.9, 0.999, 0.999, 1e-8, 10000)));
+
+  arma::mat eveCoordinates = f.GetInitialPoint();
+  arma::mat sgdCoordinates = f.GetInitialPoint();
+  arma::mat groupedCoordinates = f.GetInitialPoint();
+  const double eveObjective = eve.Optimize(f, eveCoordinates);
+  const double sgdObjective = sgd.Optimize(f, sgdCoordinates);
+  const double groupedObjective = grouped.Optimize(f, groupedCoordinates);
+
+  REQUIRE(eveObjective < f.Evaluate(f.GetInitialPoint()));
+  REQUIRE(sgdObjective == Approx(eveObjective).epsilon(1e-12));
+  REQUIRE(groupedObjective == Approx(eveObjective).epsilon(1e-12));
+  CheckMatrices(sgdCoordinates, eveCoordinates, 1e-12);
+  CheckMatrices(groupedCoordinates, eveCoordinates, 1e-12);
+}
+
+/**
+ * Run Eve on logistic regression with each minibatch split across threads.
+ */
+TEST_CASE("EveParallelBatchLogisticRegressionTest", "[EveTest]")
+{
+  Eve optimizer(1e-3, 32, 0.9, 0.999, 0.999, 1e-8, 10000, 500000, 1e-9, true);
+  optimizer.ParallelBatch() = true;
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file external_memory_test.cpp
+ *
+ * Make sure that the optimizers work in place on coordinates that use memory
+ * owned by someone else, without reallocating them.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Optimize the given function from the given point, with coordinates that use
+ * a buffer of their own as strict auxiliary memory (so that any change of
+ * their size throws), and make sure that the result is stored in the buffer.
+ */
+template<typename OptimizerType, typename FunctionType>
+void ExternalMemoryTest(OptimizerType& optimizer,
+                        FunctionType& f,
+                        const arma::mat& initialPoint)
+{
+  std::vector<double> buffer(initialPoint.begin(), initialPoint.end());
+  arma::mat coordinates(buffer.data(), initialPoint.n_rows,
+      initialPoint.n_cols, false, true);
+
+  optimizer.Optimize(f, coordinates);
+
+  REQUIRE(coordinates.memptr() == buffer.data());
+  REQUIRE(coordinates.n_rows == initialPoint.n_rows);
+  REQUIRE(coordinates.n_cols == initialPoint.n_cols);
+  REQUIRE(!arma::approx_equal(coordinates, initialPoint, "absdiff", 0.0));
+}
+
+/**
+ * Make sure L_BFGS keeps the memory of the coordinates, with all of its line
+ * searches.
+ */
+TEST_CASE("L_BFGSExternalMemoryTest", "[ExternalMemoryTest]")
+{
+  RosenbrockFunction f;
+  L_BFGS lbfgs;
+  ExternalMemoryTest(lbfgs, f, f.GetInitialPoint());
+
+  // The parallel line search moves to the best trial.
+  lbfgs.LineSearchPolicy() = WolfeBacktrackingLineSearch(4);
+  ExternalMemoryTest(lbfgs, f, f.GetInitialPoint());
+
+  L_BFGSType<MoreThuenteLineSearch> moreThuente;
+  ExternalMemoryTest(moreThuente, f, f.GetInitialPoint());
+}
+
+/**
+ * Make sure OWLQN keeps the memory of the coordinates.
+ */
+TEST_CASE("OWLQNExternalMemoryTest", "[ExternalMemoryTest]")
+{
+  RosenbrockFunction f;
+  OWLQN owlqn(0.01);
+  ExternalMemoryTest(owlqn, f, f.GetInitialPoint());
+}
+
+/**
+ * Make sure the first- and second-order optimizers keep the memory of the
+ * coordinates.
+ */
+TEST_CASE("GradientBasedExternalMemoryTest", "[ExternalMemoryTest]")
+{
+  RosenbrockFunction f;
+  GradientDescent gd(1e-3, 1000, 1e-9);
+  ExternalMemoryTest(gd, f, f.GetInitialPoint());
+
+  NewtonCG newtonCG(100);
+  ExternalMemoryTest(newtonCG, f, f.GetInitialPoint());
+
+  SGDTestFunction sgdf;
+  StandardSGD sgd(0.0003, 1, 10000, 1e-9, true);
+  ExternalMemoryTest(sgd, sgdf, sgdf.GetInitialPoint());
+
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 10000, 1e-9, true);
+  ExternalMemoryTest(adam, sgdf, sgdf.GetInitialPoint());
+}
+
+/**
+ * Make sure the derivative-free optimizers keep the memory of the
+ * coordinates.
+ */
+TEST_CASE("DerivativeFreeExternalMemoryTest", "[ExternalMemoryTest]")
+{
+  RosenbrockFunction f;
+  CMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  ExternalMemoryTest(cmaes, f, f.GetInitialPoint());
+
+  DE de(50, 100, 0.6, 0.8, 1e-5);
+  ExternalMemoryTest(de, f, f.GetInitialPoint());
+
+  SPSA spsa(0.1, 0.102, 0.16, 0.3, 1000, 0);
+  ExternalMemoryTest(spsa, f, f.GetInitialPoint());
+}
+
+/**
+ * Make sure FrankWolfe keeps the memory of the coordinates.
+ */
+TEST_CASE("FrankWolfeExternalMemoryTest", "[ExternalMemoryTest]")
+{
+  arma::mat A = arma::join_horiz(arma::eye(3, 3), 0.1 * arma::randn(3, 5));
+  arma::vec b("1 1 0");
+  FuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateSpan updateRule;
+  OMP omp(linearConstrSolver, updateRule);
+
+  ExternalMemoryTest(omp, f, arma::zeros<arma::mat>(8, 1));
+}
@@ -132,6 +132,80 @@ TEST_CASE("FWAtomNormConstraint", "[FrankWolfeTest]")
 }
 
 
+/**
+ * Make sure that the dual norms that GroupLpBall computes for all the groups at
+ * once give the same vertex as the projection to one group at a time.
+ */
+TEST_CASE("FWGroupLpBallDualNorms", "[FrankWolfeTest]")
+{
+  const size_t dim = 20;
+  std::vector<arma::uvec> groups;
+  groups.push_back(regspace<uvec>(0, 4));
+  groups.push_back(regspace<uvec>(3, 11));
+  groups.push_back(uvec({ 19, 2, 7 }));
+  groups.push_back(regspace<uvec>(12, 19));
+
+  const double ps[] = { 1.0, 1.5, 2.0, datum::inf };
+  for (size_t t = 0; t < 4; ++t)
+  {
+    GroupLpBall groupBall(ps[t], dim, groups);
+    mat v = randn<mat>(dim, 1);
+
+    vec norms;
+    groupBall.DualNorms(v, norms);
+    REQUIRE(norms.n_elem == groups.size());
+
+    size_t optimalGroup = 1;
+    double dualNorm = 0.0;
+    for (size_t i = 1; i <= groups.size(); ++i)
+    {
+      mat y;
+      groupBall.ProjectToGroup(v, i, y);
+      const double norm = groupBall.DualNorm(y, i);
+      REQUIRE(norms[i - 1] == Approx(norm).epsilon(1e-10));
+      if (norm > dualNorm)
+      {
+        optimalGroup = i;
+        dualNorm = norm;
+      }
+    }
+
+    mat expected, s;
+    groupBall.OptimalFromGroup(v, optimalGroup, expected);
+    ConstrStructGroupSolver<GroupLpBall> solver(groupBall);
+    solver.Optimize(v, s);
+    REQUIRE(approx_equal(s, expected, "absdiff", 1e-12));
+  }
+}
+
+/**
+ * Make sure that the Gram matrix of the projected atoms is kept up to date as
+ * atoms are added and removed.
+ */
+TEST_CASE("FWAtomsGramMatrix", "[FrankWolfeTest]")
+{
+  mat A = randn<mat>(10, 6);
+  vec b = randn<vec>(10);
+  FuncSq f(A, b);
+
+  Atoms atoms;
+  for (size_t i = 0; i < 6; ++i)
+  {
+    mat v = zeros<mat>(6, 1);
+    v(i) = (i % 2 == 0) ? 1.0 : -1.0;
+    atoms.AddAtom(v, f);
+  }
+  atoms.RemoveAtom(2);
+  atoms.RemoveAtom(0);
+
+  const mat& projected = atoms.ProjectedAtoms();
+  REQUIRE(atoms.Gram().n_rows == 4);
+  REQUIRE(approx_equal(atoms.Gram(), mat(projected.t() * projected),
+      "absdiff", 1e-10));
+  REQUIRE(approx_equal(atoms.ProjectedB(), vec(projected.t() * b),
+      "absdiff", 1e-10));
+}
+
 /**
  * A very simple test of classic Frank-Wolfe algorithm.
  * The constrained domain used is unit lp ball.
@@ -227,3 +301,195 @@ TEST_CASE("FWLineSearchFMat", "[FrankWolfeTest]")
   REQUIRE(coordinates(1) - 0.2 == Approx(0.0).margin(1e-4));
   REQUIRE(coordinates(2) - 0.3 == Approx(0.0).margin(1e-4));
 }
+
+/**
+ * Linear constrained solver that counts how often it is called.
+ */
+class CountingLpBallSolver
+{
+ public:
+  CountingLpBallSolver(const double p) : solver(p), calls(0) { }
+
+  template<typename MatType>
+  void Optimize(const MatType& v, MatType& s)
+  {
+    ++calls;
+    solver.Optimize(v, s);
+  }
+
+  ConstrLpBallSolver solver;
+  size_t calls;
+};
+
+/**
+ * Lazy Frank-Wolfe over the l1 ball should find the same solution as the
+ * standard algorithm, while reusing cached vertices for most iterations.
+ */
+TEST_CASE("FWLazyLineSearch", "[FrankWolfeTest]")
+{
+  mat A = randn(10, 5);
+  vec x;
+  x << 0.2 << -0.3 << 0 << 0.1 << 0;
+  vec b = A * x;
+
+  FuncSq f(A, b);
+  CountingLpBallSolver linearConstrSolver(1);
+  UpdateLineSearch updateRule;
+
+  FrankWolfe<CountingLpBallSolver, UpdateLineSearch>
+      s(linearConstrSolver, updateRule, 5000, 1e-8, true);
+
+  mat coordinates = zeros<mat>(5, 1);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-4));
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(coordinates(i) == Approx(x(i)).margin(1e-2));
+
+  // There are only 10 vertices, so most iterations must have been lazy.
+  REQUIRE(s.LinearConstrSolver().calls < 200);
+}
+
+/**
+ * Test the away-step update over the l1 ball, with the solution on a face of
+ * the ball.
+ */
+TEST_CASE("FWAwayStep", "[FrankWolfeTest]")
+{
+  mat A = randn(10, 5);
+  vec x;
+  x << 0.5 << -0.5 << 0 << 0 << 0;
+  vec b = A * x;
+
+  FuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateAwayStep updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateAwayStep>
+      s(linearConstrSolver, updateRule, 10000, 1e-12);
+
+  mat coordinates = zeros<mat>(5, 1);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(coordinates(i) == Approx(x(i)).margin(1e-3));
+}
+
+/**
+ * Make sure that the residual cached by the away-step update stays close to
+ * A * x - b over a long run.
+ */
+TEST_CASE("FWAwayStepResidualRefresh", "[FrankWolfeTest]")
+{
+  mat A = randn(20, 10);
+  vec x = zeros<vec>(10);
+  x(0) = 0.3;
+  x(3) = -0.4;
+  vec b = A * x;
+
+  FuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateAwayStep updateRule(25);
+  REQUIRE(updateRule.RefreshInterval() == 25);
+
+  FrankWolfe<ConstrLpBallSolver, UpdateAwayStep>
+      s(linearConstrSolver, updateRule, 2000, 0.0);
+
+  mat coordinates = zeros<mat>(10, 1);
+  s.Optimize(f, coordinates);
+
+  const vec exact = A * coordinates - b;
+  const vec cached = f.Residual(coordinates);
+  REQUIRE(arma::norm(cached - exact) <= 1e-10 * (1.0 + arma::norm(b)));
+}
+
+/**
+ * Test the pairwise update over the l1 ball, with the solution on a face of
+ * the ball.
+ */
+TEST_CASE("FWPairwise", "[FrankWolfeTest]")
+{
+  mat A = randn(10, 5);
+  vec x;
+  x << 0.5 << -0.5 << 0 << 0 << 0;
+  vec b = A * x;
+
+  FuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdatePairwise updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdatePairwise>
+      s(linearConstrSolver, updateRule, 10000, 1e-12);
+
+  mat coordinates = zeros<mat>(5, 1);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-8));
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(coordinates(i) == Approx(x(i)).margin(1e-3));
+}
+
+/**
+ * Orthogonal Matching Pursuit with a sparse dictionary should give the same
+ * result as with a dense one.
+ */
+TEST_CASE("FWSparseOMP", "[FrankWolfeTest]")
+{
+  const int k = 5;
+  mat B1 = eye(3, 3);
+  mat B2 = 0.1 * randn(3, k);
+  sp_mat A(join_horiz(B1, B2)); // The dictionary is input as columns of A.
+  vec b;
+  b << 1 << 1 << 0; // Vector to be sparsely approximated.
+
+  SparseFuncSq f(A, b);
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateSpan updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateSpan> s(linearConstrSolver, updateRule);
+
+  mat coordinates = zeros<mat>(k + 3, 1);
+  double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates(0) - 1 == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates(1) - 1 == Approx(0.0).margin(1e-10));
+  REQUIRE(coordinates(2) == Approx(0.0).margin(1e-10));
+  for (int ii = 0; ii < k; ++ii)
+    REQUIRE(coordinates[ii + 3] == Approx(0.0).margin(1e-10));
+
+  // The residual of the final point is cached and matches a new computation.
+  const vec r = f.Residual(coordinates);
+  REQUIRE(norm(r - (A * coordinates - b)) == Approx(0.0).margin(1e-10));
+}
+
+/**
+ * Stochastic Frank-Wolfe should find the same objective as Frank-Wolfe for
+ * logistic regression constrained to the unit l1 ball.
+ */
+TEST_CASE("StochasticFWLogisticRegressionL1Ball", "[FrankWolfeTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> lr(shuffledData, shuffledResponses, 0.0);
+
+  ConstrLpBallSolver linearConstrSolver(1);
+  UpdateClassic updateRule;
+
+  FrankWolfe<ConstrLpBallSolver, UpdateClassic> fw(linearConstrSolver,
+      updateRule, 1000);
+  arma::mat fwCoordinates = lr.GetInitialPoint();
+  const double fwObjective = fw.Optimize(lr, fwCoordinates);
+
+  StochasticFrankWolfe<ConstrLpBallSolver, UpdateClassic> sfw(
+      linearConstrSolver, updateRule, 10, 5000);
+  arma::mat coordinates = lr.GetInitialPoint();
+  const double objective = sfw.Optimize(lr, coordinates);
+
+  REQUIRE(objective == Approx(lr.Evaluate(coordinates)).epsilon(1e-10));
+  REQUIRE(objective == Approx(fwObjective).epsilon(0.005));
+  REQUIRE(arma::norm(coordinates, 1) <= 1.0 + 1e-10);
+}
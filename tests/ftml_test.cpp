@@ -56,3 +56,69 @@ TEST_CASE("FTMLStyblinskiTangFunctionFMatTest", "[FTMLTest]")
 
 // A test with sp_mat is not done, because FTML uses some parts internally that
 // assume the objective is dense.
+
+/**
+ * Run FTML on logistic regression with the moment estimates in bfloat16 and in
+ * 8-bit blocks, and make sure the results are acceptable.
+ */
+TEST_CASE("FTMLCompactStateLogisticRegressionTest", "[FTMLTest]")
+{
+  FTML optimizer(0.001, 1, 0.9, 0.999, 1e-8, 100000, 1e-5, true);
+
+  optimizer.StateBits() = 16;
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006, 3);
+
+  optimizer.StateBits() = 8;
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006, 3);
+}
+
+/**
+ * Make sure that CompactState stores its elements with the expected precision
+ * and memory.
+ */
+TEST_CASE("CompactStateRoundTripTest", "[FTMLTest]")
+{
+  const size_t n = 1000;
+  const size_t blockSize = CompactState<double>::BlockSize;
+  arma::vec values(n, arma::fill::randn);
+  values.subvec(0, 99) *= 1e-3;
+
+  for (size_t bits : { 0, 16, 8 })
+  {
+    CompactState<double> state(bits);
+    state.Zeros(n);
+
+    double scratch[CompactState<double>::BlockSize];
+    for (size_t b = 0; b < state.NumBlocks(); ++b)
+    {
+      double* s = state.Block(b, scratch);
+      for (size_t i = 0; i < state.BlockLength(b); ++i)
+        s[i] = values[b * blockSize + i];
+      state.Store(b, s);
+    }
+
+    for (size_t b = 0; b < state.NumBlocks(); ++b)
+    {
+      const arma::vec block = values.subvec(b * blockSize,
+          b * blockSize + state.BlockLength(b) - 1);
+      const double absMax = arma::abs(block).max();
+      const double* s = state.Block(b, scratch);
+      for (size_t i = 0; i < state.BlockLength(b); ++i)
+      {
+        const double error = std::abs(s[i] - block[i]);
+        if (bits == 0)
+          REQUIRE(error == 0.0);
+        else if (bits == 16)
+          REQUIRE(error <= std::abs(block[i]) / 200.0);
+        else
+          REQUIRE(error <= 0.012 * absMax);
+      }
+    }
+  }
+
+  CompactState<double> quantized(8);
+  quantized.Zeros(n);
+  REQUIRE(quantized.Bytes() == n + quantized.NumBlocks() * sizeof(float));
+
+  REQUIRE_THROWS_AS(CompactState<double>(4), std::invalid_argument);
+}
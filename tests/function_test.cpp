@@ -13,6 +13,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace ens;
 using namespace ens::test;
@@ -721,3 +722,1083 @@ TEST_CASE("ResolvableFunctionTypeCheckTest", "[FunctionTest]")
   static_assert(!CheckPartialGradient<D, arma::mat, arma::sp_mat>::value,
       "CheckPartialGradient static check failed.");
 }
+
+/**
+ * Utility class that counts the calls to Evaluate() and Gradient().
+ */
+class CountingTestFunction
+{
+ public:
+  CountingTestFunction() : evaluations(0), gradients(0) { }
+
+  double Evaluate(const arma::mat& coordinates)
+  {
+    ++evaluations;
+    return arma::accu(arma::square(coordinates));
+  }
+
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient)
+  {
+    ++gradients;
+    gradient = 2 * coordinates;
+  }
+
+  size_t evaluations;
+  size_t gradients;
+};
+
+/**
+ * Make sure MemoizedFunction only calls the wrapped function for new points or
+ * values it has not computed yet.
+ */
+TEST_CASE("MemoizedFunctionTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  MemoizedFunction<CountingTestFunction> memoized(f);
+
+  arma::mat x("1 2 3");
+  arma::mat g;
+
+  REQUIRE(memoized.Evaluate(x) == Approx(14.0));
+  REQUIRE(memoized.Evaluate(x) == Approx(14.0));
+  REQUIRE(f.evaluations == 1);
+
+  // Only the gradient is missing.
+  REQUIRE(memoized.EvaluateWithGradient(x, g) == Approx(14.0));
+  REQUIRE(f.evaluations == 1);
+  REQUIRE(f.gradients == 1);
+  REQUIRE(arma::approx_equal(g, 2 * x, "absdiff", 1e-10));
+
+  g.zeros();
+  memoized.Gradient(x, g);
+  REQUIRE(f.gradients == 1);
+  REQUIRE(arma::approx_equal(g, 2 * x, "absdiff", 1e-10));
+  REQUIRE(memoized.Hits() == 3);
+
+  // A different point has to be computed.
+  x(1) = 0.0;
+  REQUIRE(memoized.EvaluateWithGradient(x, g) == Approx(10.0));
+  REQUIRE(f.evaluations == 2);
+  REQUIRE(f.gradients == 2);
+
+  // After Clear(), nothing is stored anymore.
+  memoized.Clear();
+  REQUIRE(memoized.Evaluate(x) == Approx(10.0));
+  REQUIRE(f.evaluations == 3);
+}
+
+/**
+ * Make sure that an optimizer can be used with a MemoizedFunction.
+ */
+TEST_CASE("MemoizedFunctionOptimizeTest", "[FunctionTest]")
+{
+  RosenbrockFunction f;
+  MemoizedFunction<RosenbrockFunction> memoized(f);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.Optimize(memoized, coordinates);
+
+  REQUIRE(f.Evaluate(coordinates) == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates(0) == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Least squares linear regression, f(x) = ||y - x^T X||^2, whose Evaluate()
+ * can store the residuals in a workspace for its Gradient(); the number of
+ * times that the residuals are computed is counted.
+ */
+class WorkspaceTestFunction
+{
+ public:
+  struct Workspace
+  {
+    arma::rowvec residuals;
+  };
+
+  WorkspaceTestFunction() :
+      data(3, 20, arma::fill::randn),
+      responses(20, arma::fill::randn),
+      forwardPasses(0),
+      workspaceGradients(0)
+  { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    Workspace w;
+    return Evaluate(x, w);
+  }
+
+  double Evaluate(const arma::mat& x, Workspace& w)
+  {
+    ++forwardPasses;
+    w.residuals = responses - x.t() * data;
+    return arma::dot(w.residuals, w.residuals);
+  }
+
+  void Gradient(const arma::mat& x, arma::mat& g)
+  {
+    ++forwardPasses;
+    g = -2 * data * (responses - x.t() * data).t();
+  }
+
+  void Gradient(const arma::mat& /* x */, arma::mat& g, Workspace& w)
+  {
+    ++workspaceGradients;
+    g = -2 * data * w.residuals.t();
+  }
+
+  size_t NumFunctions() const { return data.n_cols; }
+
+  double Evaluate(const arma::mat& x,
+                  const size_t begin,
+                  const size_t batchSize)
+  {
+    Workspace w;
+    return Evaluate(x, begin, batchSize, w);
+  }
+
+  double Evaluate(const arma::mat& x,
+                  const size_t begin,
+                  const size_t batchSize,
+                  Workspace& w)
+  {
+    ++forwardPasses;
+    w.residuals = responses.subvec(begin, begin + batchSize - 1) -
+        x.t() * data.cols(begin, begin + batchSize - 1);
+    return arma::dot(w.residuals, w.residuals);
+  }
+
+  void Gradient(const arma::mat& x,
+                const size_t begin,
+                arma::mat& g,
+                const size_t batchSize)
+  {
+    Workspace w;
+    Evaluate(x, begin, batchSize, w);
+    Gradient(x, begin, g, batchSize, w);
+  }
+
+  void Gradient(const arma::mat& /* x */,
+                const size_t begin,
+                arma::mat& g,
+                const size_t batchSize,
+                Workspace& w)
+  {
+    ++workspaceGradients;
+    g = -2 * data.cols(begin, begin + batchSize - 1) * w.residuals.t();
+  }
+
+  arma::mat data;
+  arma::rowvec responses;
+  size_t forwardPasses;
+  size_t workspaceGradients;
+};
+
+/**
+ * Make sure that the EvaluateWithGradient() that is generated for a function
+ * with a Workspace computes the residuals once, and gives the same results as
+ * Evaluate() and Gradient().
+ */
+TEST_CASE("WorkspaceEvaluateWithGradientTest", "[FunctionTest]")
+{
+  REQUIRE(HasWorkspaceSignature<WorkspaceTestFunction, arma::mat,
+      arma::mat>::value == true);
+  REQUIRE(HasWorkspaceSignature<WorkspaceTestFunction, arma::mat,
+      arma::mat>::constValue == false);
+  REQUIRE(HasSeparableWorkspaceSignature<WorkspaceTestFunction, arma::mat,
+      arma::mat>::value == true);
+  REQUIRE(HasWorkspaceSignature<EvaluateGradientTestFunction, arma::mat,
+      arma::mat>::value == false);
+
+  WorkspaceTestFunction f;
+  Function<WorkspaceTestFunction, arma::mat, arma::mat>& wrapped =
+      static_cast<Function<WorkspaceTestFunction, arma::mat, arma::mat>&>(f);
+
+  const arma::mat x(3, 1, arma::fill::randn);
+  arma::mat g, expectedGradient;
+  const double objective = wrapped.EvaluateWithGradient(x, g);
+  REQUIRE(f.forwardPasses == 1);
+  REQUIRE(f.workspaceGradients == 1);
+
+  REQUIRE(objective == Approx(f.Evaluate(x)));
+  f.Gradient(x, expectedGradient);
+  CheckMatrices(g, expectedGradient, 1e-10);
+
+  // The same for the separable methods.
+  f.forwardPasses = f.workspaceGradients = 0;
+  const double batchObjective = wrapped.EvaluateWithGradient(x, 5, g, 10);
+  REQUIRE(f.forwardPasses == 1);
+  REQUIRE(f.workspaceGradients == 1);
+
+  REQUIRE(batchObjective == Approx(f.Evaluate(x, 5, 10)));
+  f.Gradient(x, 5, expectedGradient, 10);
+  CheckMatrices(g, expectedGradient, 1e-10);
+
+  // The optimizer finds the least squares solution.
+  arma::mat coordinates(3, 1, arma::fill::zeros);
+  L_BFGS lbfgs;
+  lbfgs.Optimize(f, coordinates);
+  const arma::vec solution = arma::solve(f.data.t(), f.responses.t());
+  CheckMatrices(coordinates, solution, 1e-5);
+}
+
+/**
+ * Make sure CachedFunction only evaluates new points, and forgets the least
+ * recently used point when its cache is full.
+ */
+TEST_CASE("CachedFunctionLRUTest", "[FunctionTest]")
+{
+  CountingTestFunction f;
+  CachedFunction<CountingTestFunction> cached(f, 2);
+
+  arma::mat x1("1 2 3");
+  arma::mat x2("0 1 0");
+  arma::mat x3("3 2 1");
+
+  REQUIRE(cached.Evaluate(x1) == Approx(14.0));
+  REQUIRE(cached.Evaluate(x1) == Approx(14.0));
+  REQUIRE(f.evaluations == 1);
+
+  // Using x1 again makes x2 the least recently used point, which is forgotten
+  // when x3 is inserted.
+  REQUIRE(cached.Evaluate(x2) == Approx(1.0));
+  REQUIRE(cached.Evaluate(x1) == Approx(14.0));
+  REQUIRE(cached.Evaluate(x3) == Approx(14.0));
+  REQUIRE(cached.Evaluate(x1) == Approx(14.0));
+  REQUIRE(f.evaluations == 3);
+  REQUIRE(cached.Evaluate(x2) == Approx(1.0));
+  REQUIRE(f.evaluations == 4);
+
+  REQUIRE(cached.Cache().Hits() == 3);
+  REQUIRE(cached.Cache().Misses() == 4);
+  REQUIRE(cached.Cache().Size() == 2);
+
+  // -0 is the same point as 0.
+  arma::mat negativeZero("-0.0 1 0");
+  REQUIRE(cached.Evaluate(negativeZero) == Approx(1.0));
+  REQUIRE(f.evaluations == 4);
+
+  cached.Cache().Clear();
+  REQUIRE(cached.Cache().Size() == 0);
+  REQUIRE(cached.Evaluate(x2) == Approx(1.0));
+  REQUIRE(f.evaluations == 5);
+}
+
+/**
+ * A categorical function with its optimum at [0, 2, 1] that counts its
+ * evaluations, from any number of threads.
+ */
+class CountingCategoricalFunction
+{
+ public:
+  CountingCategoricalFunction() : evaluations(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluations;
+    return std::abs(x(0)) + std::abs(x(1) - 2.0) + std::abs(x(2) - 1.0);
+  }
+
+  std::atomic<size_t> evaluations;
+};
+
+/**
+ * Make sure that a cache shared by two runs of GridSearch answers all the
+ * evaluations of the second run.
+ */
+TEST_CASE("CachedFunctionGridSearchTest", "[FunctionTest]")
+{
+  CountingCategoricalFunction f;
+  EvaluationCache<> cache;
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("5 3 12");
+
+  CachedFunction<CountingCategoricalFunction> first(f, cache);
+  arma::mat params("0 0 0");
+  GridSearch gs;
+  gs.Optimize(first, params, categoricalDimensions, numCategories);
+  REQUIRE(params(0) == 0);
+  REQUIRE(params(1) == 2);
+  REQUIRE(params(2) == 1);
+
+  const size_t evaluations = f.evaluations;
+  REQUIRE(evaluations >= 5 * 3 * 12);
+
+  CachedFunction<CountingCategoricalFunction> second(f, cache);
+  params.zeros();
+  gs.Optimize(second, params, categoricalDimensions, numCategories);
+  REQUIRE(params(0) == 0);
+  REQUIRE(params(1) == 2);
+  REQUIRE(params(2) == 1);
+  REQUIRE(f.evaluations == evaluations);
+  REQUIRE(cache.Hits() >= 5 * 3 * 12);
+}
+
+/**
+ * A Rosenbrock function that only has Evaluate().
+ */
+class EvaluateOnlyRosenbrockFunction
+{
+ public:
+  double Evaluate(const arma::mat& coordinates) const
+  {
+    return f.Evaluate(coordinates);
+  }
+
+ private:
+  RosenbrockFunction f;
+};
+
+/**
+ * Make sure the gradient of NumericalGradientFunction is close to the exact
+ * one, with both central and forward differences.
+ */
+TEST_CASE("NumericalGradientFunctionTest", "[FunctionTest]")
+{
+  EvaluateOnlyRosenbrockFunction f;
+  RosenbrockFunction rf;
+  arma::mat x("-1.2; 1.5");
+  arma::mat exact, central, forward;
+  rf.Gradient(x, exact);
+
+  NumericalGradientFunction<EvaluateOnlyRosenbrockFunction> g(f);
+  REQUIRE(g.EvaluateWithGradient(x, central) == Approx(rf.Evaluate(x)));
+  REQUIRE(arma::approx_equal(central, exact, "reldiff", 1e-7));
+
+  g.Central() = false;
+  g.Gradient(x, forward);
+  REQUIRE(arma::approx_equal(forward, exact, "reldiff", 1e-5));
+
+  // The result doesn't depend on the parallelism.
+  arma::mat serial;
+  g.Central() = true;
+  g.Parallel() = false;
+  g.Gradient(x, serial);
+  REQUIRE(arma::approx_equal(serial, central, "absdiff", 0.0));
+}
+
+/**
+ * Make sure that L_BFGS can optimize a function that only has Evaluate() with
+ * a NumericalGradientFunction.
+ */
+TEST_CASE("NumericalGradientFunctionOptimizeTest", "[FunctionTest]")
+{
+  EvaluateOnlyRosenbrockFunction f;
+  NumericalGradientFunction<EvaluateOnlyRosenbrockFunction> g(f);
+
+  arma::mat coordinates("-1.2; 1");
+  L_BFGS lbfgs;
+  lbfgs.Optimize(g, coordinates);
+
+  REQUIRE(f.Evaluate(coordinates) == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates(0) == Approx(1.0).epsilon(1e-3));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Make sure ParallelSeparableFunction sums the separable objectives and
+ * gradients correctly, in both modes.
+ */
+TEST_CASE("ParallelSeparableFunctionTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> lrf(data, responses, 0.5);
+
+  arma::mat coordinates(1, data.n_rows + 1, arma::fill::randu);
+  arma::mat gradient, parallelGradient;
+
+  const double objective = lrf.Evaluate(coordinates);
+  lrf.Gradient(coordinates, gradient);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    ParallelSeparableFunction<LogisticRegressionFunction<>> pf(lrf, (i == 1),
+        7);
+
+    REQUIRE(pf.NumFunctions() == lrf.NumFunctions());
+    REQUIRE(pf.Evaluate(coordinates) == Approx(objective).epsilon(1e-10));
+
+    pf.Gradient(coordinates, parallelGradient);
+    REQUIRE(arma::approx_equal(gradient, parallelGradient, "reldiff", 1e-8));
+
+    parallelGradient.zeros();
+    REQUIRE(pf.EvaluateWithGradient(coordinates, parallelGradient) ==
+        Approx(objective).epsilon(1e-10));
+    REQUIRE(arma::approx_equal(gradient, parallelGradient, "reldiff", 1e-8));
+  }
+}
+
+/**
+ * Make sure that a full-batch optimizer can be used with a
+ * ParallelSeparableFunction.
+ */
+TEST_CASE("ParallelSeparableFunctionOptimizeTest", "[FunctionTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> lrf(shuffledData, shuffledResponses, 0.5);
+  ParallelSeparableFunction<LogisticRegressionFunction<>> pf(lrf);
+
+  arma::mat coordinates = lrf.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.Optimize(pf, coordinates);
+
+  // Ensure that the predictions are good.
+  REQUIRE(lrf.ComputeAccuracy(data, responses, coordinates) ==
+      Approx(100.0).epsilon(0.003));
+  REQUIRE(lrf.ComputeAccuracy(testData, testResponses, coordinates) ==
+      Approx(100.0).epsilon(0.006));
+}
+
+/**
+ * Check the gradient of the given function against central differences, and
+ * check that the batch gradients (dense and sparse) sum to the full gradient.
+ */
+template<typename FunctionType>
+void CheckLargeScaleGradient(FunctionType& f, const arma::mat& coordinates)
+{
+  arma::mat gradient;
+  f.Gradient(coordinates, gradient);
+
+  const double h = 1e-6;
+  for (size_t i = 0; i < coordinates.n_elem; i += 7)
+  {
+    arma::mat plus = coordinates, minus = coordinates;
+    plus[i] += h;
+    minus[i] -= h;
+    const double difference = (f.Evaluate(plus) - f.Evaluate(minus)) / (2 * h);
+    REQUIRE(gradient[i] == Approx(difference).margin(1e-4));
+  }
+
+  arma::mat batchGradient, sum(arma::size(coordinates), arma::fill::zeros);
+  arma::sp_mat sparseGradient, sparseSum(arma::size(coordinates));
+  double objective = 0.0;
+  for (size_t i = 0; i < f.NumFunctions(); i += 3)
+  {
+    const size_t batchSize = std::min((size_t) 3, f.NumFunctions() - i);
+    objective += f.Evaluate(coordinates, i, batchSize);
+    f.Gradient(coordinates, i, batchGradient, batchSize);
+    f.Gradient(coordinates, i, sparseGradient, batchSize);
+    sum += batchGradient;
+    sparseSum += sparseGradient;
+  }
+
+  REQUIRE(objective == Approx(f.Evaluate(coordinates)).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(sum, gradient, "absdiff", 1e-8));
+  REQUIRE(arma::approx_equal(arma::mat(sparseSum), gradient, "absdiff", 1e-8));
+}
+
+/**
+ * Check the gradients of the IllConditionedQuadraticFunction, and make sure
+ * that L-BFGS finds its minimum.
+ */
+TEST_CASE("IllConditionedQuadraticFunctionTest", "[FunctionTest]")
+{
+  IllConditionedQuadraticFunction f(50, 100.0, 10);
+  REQUIRE(f.Eigenvalues()[0] == Approx(1.0));
+  REQUIRE(f.Eigenvalues()[49] == Approx(100.0));
+
+  arma::mat coordinates(50, 1, arma::fill::randn);
+  CheckLargeScaleGradient(f, coordinates);
+
+  coordinates = f.GetInitialPoint();
+  L_BFGS lbfgs;
+  REQUIRE(lbfgs.Optimize(f, coordinates) == Approx(0.0).margin(1e-10));
+  REQUIRE(arma::approx_equal(coordinates, f.GetFinalPoint(), "absdiff", 1e-4));
+}
+
+/**
+ * Check the gradients of the SparseLogisticRegressionFunction, and make sure
+ * that the generated problem can be learned.
+ */
+TEST_CASE("SparseLogisticRegressionFunctionTest", "[FunctionTest]")
+{
+  SparseLogisticRegressionFunction f(30, 200, 0.2, 0.5);
+  REQUIRE(f.Predictors().n_rows == 30);
+  REQUIRE(f.NumFunctions() == 200);
+
+  arma::mat coordinates(31, 1, arma::fill::randn);
+  CheckLargeScaleGradient(f, coordinates);
+
+  coordinates = f.GetInitialPoint();
+  const double initialObjective = f.Evaluate(coordinates);
+  L_BFGS lbfgs;
+  REQUIRE(lbfgs.Optimize(f, coordinates) < 0.5 * initialObjective);
+}
+
+/**
+ * Check the gradients of the MatrixFactorizationFunction, and make sure that
+ * SGD reduces the objective.
+ */
+TEST_CASE("MatrixFactorizationFunctionTest", "[FunctionTest]")
+{
+  MatrixFactorizationFunction f(20, 30, 3, 0.3);
+  REQUIRE(f.Rows() == 20);
+  REQUIRE(f.Cols() == 30);
+  REQUIRE(f.Rank() == 3);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  REQUIRE(coordinates.n_rows == 3);
+  REQUIRE(coordinates.n_cols == 50);
+  CheckLargeScaleGradient(f, coordinates);
+
+  const double initialObjective = f.Evaluate(coordinates);
+  StandardSGD sgd(0.01, 1, 50 * f.NumFunctions(), 1e-9);
+  REQUIRE(sgd.Optimize(f, coordinates) < 0.2 * initialObjective);
+}
+
+/**
+ * Make sure that the EvaluateWithGradient() and EvaluateBatch() methods of the
+ * given function agree with Evaluate() and Gradient(), and check the gradients.
+ */
+template<typename FunctionType>
+void CheckAnalyticFunction(FunctionType& f, const size_t n)
+{
+  static_assert(traits::HasEvaluateBatchSignature<FunctionType,
+      arma::mat>::value, "EvaluateBatch() not detected.");
+  static_assert(traits::HasEvaluateBatchSignature<FunctionType,
+      arma::fmat>::value, "EvaluateBatch() not detected.");
+
+  arma::mat coordinates(n, 1, arma::fill::randn);
+  CheckLargeScaleGradient(f, coordinates);
+
+  arma::mat gradient, fusedGradient;
+  f.Gradient(coordinates, gradient);
+  const double objective = f.Evaluate(coordinates);
+  REQUIRE(f.EvaluateWithGradient(coordinates, fusedGradient) ==
+      Approx(objective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(fusedGradient, gradient, "absdiff", 1e-10));
+  REQUIRE(f.EvaluateWithGradient(coordinates, 0, fusedGradient,
+      f.NumFunctions()) == Approx(objective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(fusedGradient, gradient, "absdiff", 1e-10));
+
+  arma::cube candidates(n, 1, 10, arma::fill::randn);
+  arma::vec objectives;
+  f.EvaluateBatch(candidates, objectives);
+  REQUIRE(objectives.n_elem == candidates.n_slices);
+  for (size_t i = 0; i < candidates.n_slices; ++i)
+  {
+    REQUIRE(objectives(i) ==
+        Approx(f.Evaluate(candidates.slice(i))).epsilon(1e-10));
+  }
+}
+
+/**
+ * Check the fused implementations of the analytic test functions used for the
+ * scaling benchmarks, with and without parallel ranges.
+ */
+TEST_CASE("AnalyticFunctionsTest", "[FunctionTest]")
+{
+  for (size_t threshold = 0; threshold <= 16; threshold += 16)
+  {
+    SetFusedUpdateThreshold(threshold);
+
+    SphereFunction sphere(50);
+    CheckAnalyticFunction(sphere, 50);
+    RastriginFunction rastrigin(50);
+    CheckAnalyticFunction(rastrigin, 50);
+    StyblinskiTangFunction styblinskiTang(50);
+    CheckAnalyticFunction(styblinskiTang, 50);
+    GeneralizedRosenbrockFunction rosenbrock(50);
+    CheckAnalyticFunction(rosenbrock, 50);
+    AckleyFunction ackley;
+    CheckAnalyticFunction(ackley, 2);
+  }
+
+  SetFusedUpdateThreshold(0);
+}
+
+/**
+ * Make sure that shuffling the regression problems only changes the order in
+ * which the points are visited, and leaves the data alone.
+ */
+TEST_CASE("RegressionFunctionShuffleTest", "[FunctionTest]")
+{
+  arma::mat data(5, 40, arma::fill::randn);
+  arma::Row<size_t> responses(40);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+    responses[i] = (arma::accu(data.col(i)) > 0.0) ? 1 : 0;
+  const arma::mat originalData = data;
+  const arma::Row<size_t> originalResponses = responses;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  arma::mat lrCoordinates(1, 6, arma::fill::randn);
+  const double lrObjective = lrf.Evaluate(lrCoordinates);
+  lrf.Shuffle();
+
+  double lrSum = 0.0;
+  for (size_t i = 0; i < data.n_cols; i += 8)
+    lrSum += lrf.Evaluate(lrCoordinates, i, 8);
+  REQUIRE(lrSum == Approx(lrObjective).epsilon(1e-7));
+
+  SoftmaxRegressionFunction srf(data, responses, 2, 0.1);
+  arma::mat srCoordinates = srf.GetInitialPoint();
+  arma::mat srGradient;
+  srf.Gradient(srCoordinates, srGradient);
+  srf.Shuffle();
+
+  arma::mat batchGradient, srSum(arma::size(srGradient), arma::fill::zeros);
+  for (size_t i = 0; i < data.n_cols; i += 8)
+  {
+    srf.Gradient(srCoordinates, i, batchGradient, 8);
+    srSum += batchGradient / 5.0;
+  }
+  REQUIRE(arma::approx_equal(srSum, srGradient, "absdiff", 1e-8));
+
+  REQUIRE(arma::approx_equal(data, originalData, "absdiff", 0.0));
+  REQUIRE(arma::all(responses == originalResponses));
+}
+
+/**
+ * Make sure that the regression problems give the same objective and gradients
+ * for sparse data as for the same dense data, and that sparse gradients match
+ * the dense ones.
+ */
+TEST_CASE("RegressionFunctionSparseDataTest", "[FunctionTest]")
+{
+  arma::sp_mat sparseData = arma::sprandn<arma::sp_mat>(30, 50, 0.1);
+  arma::mat data(sparseData);
+  arma::Row<size_t> responses(50);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+    responses[i] = (arma::accu(data.col(i)) > 0.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  LogisticRegressionFunction<arma::sp_mat> sparseLrf(sparseData, responses,
+      0.1);
+  arma::mat lrCoordinates(1, 31, arma::fill::randn);
+  REQUIRE(sparseLrf.Evaluate(lrCoordinates) ==
+      Approx(lrf.Evaluate(lrCoordinates)).epsilon(1e-7));
+
+  arma::mat lrGradient, sparseLrGradient;
+  arma::sp_mat lrSpGradient;
+  lrf.Gradient(lrCoordinates, 10, lrGradient, 10);
+  sparseLrf.Gradient(lrCoordinates, 10, sparseLrGradient, 10);
+  sparseLrf.Gradient(lrCoordinates, 10, lrSpGradient, 10);
+  REQUIRE(arma::approx_equal(sparseLrGradient, lrGradient, "absdiff", 1e-8));
+  REQUIRE(arma::approx_equal(arma::mat(lrSpGradient), lrGradient, "absdiff",
+      1e-8));
+
+  // Without regularization, only the features present in the batch are stored.
+  LogisticRegressionFunction<arma::sp_mat> unregularizedLrf(sparseData,
+      responses);
+  unregularizedLrf.Gradient(lrCoordinates, 10, lrSpGradient, 10);
+  REQUIRE(lrSpGradient.n_nonzero <= sparseData.cols(10, 19).n_nonzero + 1);
+
+  SoftmaxRegressionFunction srf(data, responses, 2, 0.1, true);
+  SoftmaxRegressionFunctionType<arma::sp_mat> sparseSrf(sparseData, responses,
+      2, 0.1, true);
+  arma::mat srCoordinates = srf.GetInitialPoint();
+  REQUIRE(sparseSrf.Evaluate(srCoordinates) ==
+      Approx(srf.Evaluate(srCoordinates)).epsilon(1e-7));
+
+  arma::mat srGradient, sparseSrGradient;
+  arma::sp_mat srSpGradient;
+  srf.Gradient(srCoordinates, 10, srGradient, 10);
+  sparseSrf.Gradient(srCoordinates, 10, sparseSrGradient, 10);
+  sparseSrf.Gradient(srCoordinates, 10, srSpGradient, 10);
+  REQUIRE(arma::approx_equal(sparseSrGradient, srGradient, "absdiff", 1e-8));
+  REQUIRE(arma::approx_equal(arma::mat(srSpGradient), srGradient, "absdiff",
+      1e-8));
+}
+
+/**
+ * Make sure that the sampled softmax gradients of SoftmaxRegressionFunction
+ * only touch the rows of the labels of the batch and of the sampled classes,
+ * that they are the same for all gradient types, and that the sampled loss
+ * tends to the full loss with many samples.
+ */
+TEST_CASE("SoftmaxRegressionSampledSoftmaxTest", "[FunctionTest]")
+{
+  const size_t numClasses = 40;
+  arma::mat data(5, 100, arma::fill::randn);
+  arma::Row<size_t> labels(100);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    labels[i] = i % numClasses;
+
+  SoftmaxRegressionFunction srf(data, labels, numClasses, 0.1, true, 6);
+  const arma::mat coordinates = srf.GetInitialPoint();
+
+  // The same seed gives the same sampled classes.
+  arma::mat dense;
+  arma::sp_mat sparse;
+  RowSparseMat<double> rowSparse;
+  arma::arma_rng::set_seed(7);
+  srf.Gradient(coordinates, 10, dense, 5);
+  arma::arma_rng::set_seed(7);
+  srf.Gradient(coordinates, 10, sparse, 5);
+  arma::arma_rng::set_seed(7);
+  srf.Gradient(coordinates, 10, rowSparse, 5);
+
+  REQUIRE(rowSparse.NumTouchedRows() <= 5 + 6);
+  REQUIRE(arma::approx_equal(rowSparse.Dense(), dense, "absdiff", 1e-12));
+  REQUIRE(arma::approx_equal(arma::mat(sparse), dense, "absdiff", 1e-12));
+  for (size_t i = 10; i < 15; ++i)
+    REQUIRE(arma::any(dense.row(labels[i]) != 0.0));
+
+  // Without sampling, all the rows are touched.
+  srf.NumSampled() = 0;
+  arma::mat full;
+  srf.Gradient(coordinates, 10, full, 5);
+  srf.Gradient(coordinates, 10, rowSparse, 5);
+  REQUIRE(rowSparse.NumTouchedRows() == numClasses);
+  REQUIRE(arma::approx_equal(rowSparse.Dense(), full, "absdiff", 1e-12));
+
+  // With many samples and no regularization, the sampled loss is close to the
+  // full loss.
+  SoftmaxRegressionFunction unregularized(data, labels, numClasses, 0.0, true,
+      20000);
+  const arma::mat randomCoordinates = 0.5 * arma::randn<arma::mat>(numClasses,
+      6);
+  const double sampledLoss = unregularized.EvaluateWithGradient(
+      randomCoordinates, 10, dense, 5);
+  REQUIRE(sampledLoss == Approx(unregularized.Evaluate(randomCoordinates, 10,
+      5)).margin(0.05));
+}
+
+/**
+ * Make sure the fused loss kernels of the regression problems agree with
+ * Evaluate() and Gradient(), and stay finite for very large margins.
+ */
+TEST_CASE("RegressionFunctionStableLossTest", "[FunctionTest]")
+{
+  arma::mat data(4, 30, arma::fill::randn);
+  arma::Row<size_t> responses(30);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+    responses[i] = (data(0, i) > 0.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  arma::mat lrCoordinates(1, 5, arma::fill::randn);
+  arma::mat lrGradient, lrFusedGradient;
+  lrf.Gradient(lrCoordinates, 5, lrGradient, 10);
+  const double lrObjective = lrf.EvaluateWithGradient(lrCoordinates, 5,
+      lrFusedGradient, 10);
+  REQUIRE(lrObjective == Approx(lrf.Evaluate(lrCoordinates, 5, 10)));
+  REQUIRE(arma::approx_equal(lrFusedGradient, lrGradient, "absdiff", 1e-10));
+
+  // Misclassify every point with a huge margin; the loss is then about the sum
+  // of the absolute margins, not infinite.
+  lrCoordinates.zeros();
+  lrCoordinates(1) = -1e4;
+  const double lrLarge = LogisticRegressionFunction<>(data, responses).Evaluate(
+      lrCoordinates);
+  REQUIRE(std::isfinite(lrLarge));
+  REQUIRE(lrLarge == Approx(1e4 * arma::accu(arma::abs(data.row(0))))
+      .epsilon(1e-4));
+
+  SoftmaxRegressionFunction srf(data, responses, 2, 0.1);
+  arma::mat srCoordinates = srf.GetInitialPoint();
+  arma::mat srGradient, srFusedGradient;
+  srf.Gradient(srCoordinates, 5, srGradient, 10);
+  const double srObjective = srf.EvaluateWithGradient(srCoordinates, 5,
+      srFusedGradient, 10);
+  REQUIRE(srObjective == Approx(srf.Evaluate(srCoordinates, 5, 10)));
+  REQUIRE(arma::approx_equal(srFusedGradient, srGradient, "absdiff", 1e-10));
+
+  // Huge scores would overflow exp() without the stabilization.
+  srCoordinates *= 1e6;
+  REQUIRE(std::isfinite(srf.Evaluate(srCoordinates)));
+  srf.Gradient(srCoordinates, srGradient);
+  REQUIRE(srGradient.is_finite());
+}
+
+/**
+ * Make sure the parallel loops give the same results with every executor, and
+ * that exceptions of the tasks are rethrown.
+ */
+TEST_CASE("ExecutorParallelForTest", "[FunctionTest]")
+{
+  std::vector<std::shared_ptr<Executor>> executors;
+  executors.push_back(nullptr);
+  executors.push_back(std::make_shared<SerialExecutor>());
+  executors.push_back(std::make_shared<OpenMPExecutor>());
+  executors.push_back(std::make_shared<ThreadPoolExecutor>(3));
+
+  for (size_t e = 0; e < executors.size(); ++e)
+  {
+    SetExecutor(executors[e]);
+    REQUIRE(MaxThreads() >= 1);
+
+    // Each task runs a nested loop.
+    arma::Mat<size_t> visits(20, 10, arma::fill::zeros);
+    ParallelFor(visits.n_cols, [&](const size_t j)
+    {
+      ParallelFor(visits.n_rows, [&](const size_t i) { visits(i, j) += j; });
+    });
+    for (size_t j = 0; j < visits.n_cols; ++j)
+      REQUIRE(arma::all(visits.col(j) == j));
+
+    const size_t sum = ParallelReduce(100, (size_t) 0,
+        [](const size_t i) { return i * i; },
+        [](const size_t a, const size_t b) { return a + b; });
+    REQUIRE(sum == 328350);
+
+    REQUIRE_THROWS_AS(ParallelFor(10, [](const size_t i)
+    {
+      if (i == 7)
+        throw std::runtime_error("task failed");
+    }), std::runtime_error);
+  }
+
+  SetExecutor(nullptr);
+}
+
+/**
+ * Run an optimizer and submitted tasks on a ThreadPoolExecutor.
+ */
+TEST_CASE("ThreadPoolExecutorOptimizerTest", "[FunctionTest]")
+{
+  std::shared_ptr<ThreadPoolExecutor> pool =
+      std::make_shared<ThreadPoolExecutor>(4);
+  REQUIRE(pool->NumThreads() == 4);
+
+  std::atomic<size_t> counter(0);
+  std::vector<std::future<void>> futures;
+  for (size_t i = 0; i < 10; ++i)
+    futures.push_back(pool->Submit([&counter]() { ++counter; }));
+  for (size_t i = 0; i < futures.size(); ++i)
+    futures[i].get();
+  REQUIRE(counter == 10);
+
+  SetExecutor(pool);
+  CMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  LogisticRegressionFunctionTest(cmaes, 0.003, 0.006, 5);
+  SetExecutor(nullptr);
+}
+
+/**
+ * Make sure that RandomStream gives reproducible, independent streams with the
+ * right distributions.
+ */
+TEST_CASE("RandomStreamTest", "[FunctionTest]")
+{
+  RandomStream a(42), b(42), c(42, 1);
+  arma::mat x(1000, 10), y(1000, 10), z(1000, 10);
+  a.FillUniform(x);
+  b.FillUniform(y);
+  c.FillUniform(z);
+  REQUIRE(arma::approx_equal(x, y, "absdiff", 0.0));
+  REQUIRE(!arma::approx_equal(x, z, "absdiff", 1e-3));
+  REQUIRE(x.min() >= 0.0);
+  REQUIRE(x.max() < 1.0);
+  REQUIRE(arma::mean(arma::vectorise(x)) == Approx(0.5).margin(0.02));
+
+  // Split() only depends on the seed.
+  RandomStream s1 = a.Split(3);
+  RandomStream s2 = b.Split(3);
+  REQUIRE(s1.Next() == s2.Next());
+
+  // Odd number of elements, to check the last normal value.
+  arma::fmat n(1001, 11);
+  a.FillNormal(n);
+  REQUIRE(n.is_finite());
+  REQUIRE(arma::mean(arma::vectorise(n)) == Approx(0.0).margin(0.02));
+  REQUIRE(arma::stddev(arma::vectorise(n)) == Approx(1.0).epsilon(0.02));
+
+  arma::vec signs(777);
+  a.FillSigns(signs);
+  REQUIRE(arma::all(arma::abs(signs) == 1.0));
+  REQUIRE(arma::mean(signs) == Approx(0.0).margin(0.1));
+
+  size_t counts[7] = { 0 };
+  for (size_t i = 0; i < 7000; ++i)
+    ++counts[a.Integer(7)];
+  for (size_t i = 0; i < 7; ++i)
+    REQUIRE(counts[i] == Approx(1000).margin(150));
+
+  // The default constructor is seeded from Armadillo.
+  arma::arma_rng::set_seed(7);
+  RandomStream d;
+  arma::arma_rng::set_seed(7);
+  RandomStream e;
+  REQUIRE(d.Next() == e.Next());
+}
+
+/**
+ * Make sure that AliasTable draws the indices with the right probabilities.
+ */
+TEST_CASE("AliasTableTest", "[FunctionTest]")
+{
+  const arma::vec weights("1 0 3 2 4");
+  AliasTable table(weights);
+  REQUIRE(table.Size() == 5);
+  REQUIRE(table.Probability(2) == Approx(0.3));
+
+  RandomStream rng(42);
+  arma::vec counts(5, arma::fill::zeros);
+  for (size_t i = 0; i < 100000; ++i)
+    ++counts[table.Sample(rng)];
+
+  REQUIRE(counts[1] == 0.0);
+  for (size_t i = 0; i < 5; ++i)
+    REQUIRE(counts[i] / 100000 == Approx(weights[i] / 10).margin(0.01));
+
+  // Invalid weights are rejected.
+  REQUIRE_THROWS_AS(table.Reset(arma::vec("1 -1")), std::invalid_argument);
+  REQUIRE_THROWS_AS(table.Reset(arma::vec("0 0")), std::invalid_argument);
+}
+
+/**
+ * Make sure that RandomPermutation is a bijection of [0, n), that depends on
+ * the keys drawn from the stream.
+ */
+TEST_CASE("RandomPermutationTest", "[FunctionTest]")
+{
+  const size_t sizes[] = { 0, 1, 2, 3, 17, 1000, 4097, 65536 };
+  RandomStream rng(42);
+  for (size_t s = 0; s < 8; ++s)
+  {
+    const size_t n = sizes[s];
+    RandomPermutation order(n, rng);
+    REQUIRE(order.Size() == n);
+
+    std::vector<char> seen(n, 0);
+    size_t fixed = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      const size_t j = order(i);
+      REQUIRE(j < n);
+      REQUIRE(seen[j] == 0);
+      seen[j] = 1;
+      fixed += (j == i) ? 1 : 0;
+    }
+
+    // A random order has one fixed point on average.
+    if (n >= 1000)
+      REQUIRE(fixed < 10);
+  }
+
+  // The same keys give the same order, and new keys give a new one.
+  RandomStream a(7), b(7);
+  RandomPermutation p(1000, a), q(1000, b);
+  size_t same = 0;
+  for (size_t i = 0; i < 1000; ++i)
+    REQUIRE(p(i) == q(i));
+  q.Reshuffle(b);
+  for (size_t i = 0; i < 1000; ++i)
+    same += (p(i) == q(i)) ? 1 : 0;
+  REQUIRE(same < 10);
+}
+
+// Return the sum over the examples of the spread of their features.
+static size_t SparseProfile(const arma::sp_mat& data)
+{
+  size_t profile = 0;
+  for (size_t e = 0; e < data.n_cols; ++e)
+  {
+    if (data.col_ptrs[e] == data.col_ptrs[e + 1])
+      continue;
+    profile += data.row_indices[data.col_ptrs[e + 1] - 1] -
+        data.row_indices[data.col_ptrs[e]];
+  }
+  return profile;
+}
+
+/**
+ * Make sure that LocalityOrdering() returns permutations that undo a shuffle of
+ * banded data, and that PermuteSparse() applies them.
+ */
+TEST_CASE("LocalityOrderingTest", "[FunctionTest]")
+{
+  // Example e uses the features e, e + 1 and e + 2.
+  const size_t n = 200;
+  arma::sp_mat banded(n + 2, n);
+  for (size_t e = 0; e < n; ++e)
+    for (size_t k = 0; k < 3; ++k)
+      banded(e + k, e) = 1.0 + e + k;
+
+  const arma::uvec rows = arma::randperm(n + 2);
+  const arma::uvec cols = arma::randperm(n);
+  const arma::sp_mat shuffled = PermuteSparse(banded, rows, cols);
+  REQUIRE(shuffled.n_nonzero == banded.n_nonzero);
+  REQUIRE(shuffled(0, 0) == banded(rows[0], cols[0]));
+
+  for (size_t byFrequency = 0; byFrequency < 2; ++byFrequency)
+  {
+    arma::uvec featureOrder, exampleOrder;
+    LocalityOrdering(shuffled, featureOrder, exampleOrder, byFrequency == 1);
+
+    // The orders are permutations.
+    REQUIRE(arma::all(arma::sort(featureOrder) ==
+        arma::regspace<arma::uvec>(0, n + 1)));
+    REQUIRE(arma::all(arma::sort(exampleOrder) ==
+        arma::regspace<arma::uvec>(0, n - 1)));
+    REQUIRE(arma::all(InversePermutation(featureOrder)(featureOrder) ==
+        arma::regspace<arma::uvec>(0, n + 1)));
+
+    // Reverse Cuthill-McKee recovers the band; both orders keep the data.
+    const arma::sp_mat reordered = PermuteSparse(shuffled, featureOrder,
+        exampleOrder);
+    if (byFrequency == 0)
+    {
+      REQUIRE(SparseProfile(reordered) <= 6 * n);
+      REQUIRE(SparseProfile(reordered) < SparseProfile(shuffled));
+    }
+    REQUIRE(arma::accu(reordered) == Approx(arma::accu(banded)));
+  }
+
+  REQUIRE_THROWS_AS(PermuteSparse(banded, cols, cols), std::invalid_argument);
+}
+
+/**
+ * A function whose evaluations run on threads of its own, returned as futures.
+ */
+class AsyncTestFunction
+{
+ public:
+  double Evaluate(const arma::mat& x) { return arma::accu(x); }
+
+  std::future<double> EvaluateAsync(const arma::mat& x)
+  {
+    return std::async(std::launch::async, [x]() { return arma::accu(x); });
+  }
+};
+
+/**
+ * Make sure that AsyncEvaluator returns the result of each submitted candidate
+ * once, both with EvaluateAsync() and with the pool of Evaluate() calls.
+ */
+TEST_CASE("AsyncEvaluatorTest", "[FunctionTest]")
+{
+  AsyncTestFunction f;
+  SphereFunction g(3);
+
+  AsyncEvaluator<AsyncTestFunction, arma::mat> asyncEvaluator(f, 3);
+  AsyncEvaluator<SphereFunction, arma::mat> poolEvaluator(g, 3);
+  REQUIRE(asyncEvaluator.Concurrency() == 3);
+
+  arma::mat x(3, 1);
+  for (size_t i = 0; i < 8; ++i)
+  {
+    x.fill(double(i));
+    asyncEvaluator.Submit(i, x);
+    poolEvaluator.Submit(i, x);
+  }
+  REQUIRE(asyncEvaluator.Pending() == 8);
+
+  std::vector<char> seen(8, 0), poolSeen(8, 0);
+  for (size_t k = 0; k < 8; ++k)
+  {
+    double objective;
+    const size_t i = asyncEvaluator.WaitAny(objective);
+    REQUIRE(!seen[i]);
+    seen[i] = 1;
+    REQUIRE(objective == Approx(3.0 * i));
+
+    const size_t j = poolEvaluator.WaitAny(objective);
+    REQUIRE(!poolSeen[j]);
+    poolSeen[j] = 1;
+    REQUIRE(objective == Approx(3.0 * j * j).margin(1e-12));
+  }
+
+  REQUIRE(asyncEvaluator.Pending() == 0);
+  double objective;
+  REQUIRE_THROWS_AS(asyncEvaluator.WaitAny(objective), std::logic_error);
+}
@@ -34,3 +34,90 @@ TEST_CASE("GDRosenbrockFMatTest", "[GradientDescentTest]")
   GradientDescent s(0.001, 0, 1e-15);
   FunctionTest<RosenbrockFunction, arma::fmat>(s, 0.1, 0.01);
 }
+
+/**
+ * Make sure that running gradient descent step by step, also interleaved with
+ * another optimization, gives the same result as Optimize().
+ */
+TEST_CASE("GDStepTest", "[GradientDescentTest]")
+{
+  RosenbrockFunction f;
+  GDTestFunction g;
+  GradientDescent s(0.001, 100000, 1e-15);
+
+  arma::mat expectedF = f.GetInitialPoint();
+  arma::mat expectedG = g.GetInitialPoint();
+  const double objectiveF = s.Optimize(f, expectedF);
+  const double objectiveG = s.Optimize(g, expectedG);
+
+  arma::mat coordinatesF = f.GetInitialPoint();
+  arma::mat coordinatesG = g.GetInitialPoint();
+  auto stateF = s.Begin(f, coordinatesF);
+  auto stateG = s.Begin(g, coordinatesG);
+
+  bool runningF = true, runningG = true;
+  while (runningF || runningG)
+  {
+    if (runningF)
+      runningF = s.Step(stateF, 7);
+    if (runningG)
+      runningG = s.Step(stateG, 3);
+  }
+
+  REQUIRE(stateF.Finished());
+  REQUIRE(stateF.Objective() == Approx(objectiveF).epsilon(1e-12));
+  REQUIRE(stateG.Objective() == Approx(objectiveG).epsilon(1e-12));
+  CheckMatrices(coordinatesF, expectedF, 1e-12);
+  CheckMatrices(coordinatesG, expectedG, 1e-12);
+}
+
+// Run the given optimizer on the Rosenbrock function step by step, and return
+// the number of iterations.
+template<typename OptimizerType>
+size_t RosenbrockIterations(OptimizerType& optimizer)
+{
+  RosenbrockFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  auto state = optimizer.Begin(f, coordinates);
+  while (optimizer.Step(state, 100)) { }
+
+  CheckMatrices(coordinates, arma::mat("1; 1"), 1e-2);
+  return state.Iterations();
+}
+
+/**
+ * Make sure that each step policy minimizes the Rosenbrock function, and that
+ * the accelerated and adaptive ones take fewer iterations than fixed steps.
+ */
+TEST_CASE("GDStepPolicyTest", "[GradientDescentTest]")
+{
+  GradientDescent fixed(0.001, 0, 1e-15);
+  AcceleratedGradientDescent nesterov(0.001, 0, 1e-15);
+  BBGradientDescent bb(0.001, 0, 1e-15);
+  ArmijoGradientDescent armijo(1.0, 0, 1e-15);
+
+  const size_t fixedIterations = RosenbrockIterations(fixed);
+  REQUIRE(RosenbrockIterations(nesterov) < fixedIterations);
+  REQUIRE(RosenbrockIterations(bb) < fixedIterations);
+  REQUIRE(RosenbrockIterations(armijo) < fixedIterations);
+}
+
+/**
+ * Make sure that Armijo backtracking rejects a step size that diverges with
+ * fixed steps.
+ */
+TEST_CASE("GDArmijoLargeStepTest", "[GradientDescentTest]")
+{
+  ArmijoGradientDescent s(10.0, 0, 1e-15);
+  FunctionTest<RosenbrockFunction>(s, 0.01, 0.001);
+}
+
+#ifdef ENS_HAVE_COOT
+
+TEST_CASE("GDCootFunctionTest", "[GradientDescentTest]")
+{
+  GradientDescent s(0.001, 100000, 1e-9);
+  CootFunctionTest(s, 1e-3);
+}
+
+#endif
@@ -14,6 +14,9 @@
 #include "catch.hpp"
 #include "test_function_tools.hpp"
 
+#include <mutex>
+#include <set>
+
 using namespace ens;
 using namespace ens::test;
 
@@ -135,3 +138,198 @@ TEST_CASE("GridSearchIMatTest", "[GridSearchTest]")
   REQUIRE(params(1) == 2);
   REQUIRE(params(2) == 1);
 }
+
+/**
+ * Make sure that GridSearch uses EvaluateDelta() when the function has that
+ * method.
+ */
+TEST_CASE("GridSearchEvaluateDeltaTest", "[GridSearchTest]")
+{
+  DeltaSphereFunction f;
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("4 3 5");
+
+  arma::mat params;
+  GridSearch gs;
+  const double objective = gs.Optimize(f, params, categoricalDimensions,
+      numCategories);
+
+  REQUIRE(f.evaluateCalls == 1);
+  REQUIRE(f.evaluateDeltaCalls > 0);
+  REQUIRE(objective == Approx(0.0).margin(1e-10));
+  REQUIRE(params(0) == 1);
+  REQUIRE(params(1) == 1);
+  REQUIRE(params(2) == 1);
+}
+
+/**
+ * Make sure that the parallel GridSearch finds the same point as the serial
+ * one.
+ */
+TEST_CASE("GridSearchParallelTest", "[GridSearchTest]")
+{
+  SimpleCategoricalFunction c;
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("3 3 3");
+
+  arma::mat params;
+  GridSearch gs(true);
+  const double objective = gs.Optimize(c, params, categoricalDimensions,
+      numCategories);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-10));
+  REQUIRE(params(0) == 0);
+  REQUIRE(params(1) == 2);
+  REQUIRE(params(2) == 1);
+}
+
+/**
+ * The shifted sphere function f(x) = |x - 1|^2, whose evaluation with a budget
+ * b adds 10 / b to the objective.  The number of evaluations with the largest
+ * budget is counted.
+ */
+class BudgetSphereFunction
+{
+ public:
+  BudgetSphereFunction(const size_t maxBudget) :
+      maxBudget(maxBudget), evaluateCalls(0), fullCalls(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluateCalls;
+    return arma::accu(arma::square(x - 1.0));
+  }
+
+  double EvaluateWithBudget(const arma::mat& x, const size_t budget)
+  {
+    if (budget == maxBudget)
+      ++fullCalls;
+    return arma::accu(arma::square(x - 1.0)) + 10.0 / budget;
+  }
+
+  size_t maxBudget;
+  size_t evaluateCalls;
+  size_t fullCalls;
+};
+
+/**
+ * Make sure that GridSearch with successive halving only evaluates the best
+ * points with the full budget.
+ */
+TEST_CASE("GridSearchSuccessiveHalvingTest", "[GridSearchTest]")
+{
+  BudgetSphereFunction f(9);
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("4 3 5");
+
+  // 60 points are evaluated with a budget of 1, 20 with 3, and 6 with 9.
+  arma::mat params;
+  GridSearch gs(false, 1, 9, 3.0);
+  const double objective = gs.Optimize(f, params, categoricalDimensions,
+      numCategories);
+
+  REQUIRE(f.evaluateCalls == 0);
+  REQUIRE(f.fullCalls == 6);
+  REQUIRE(objective == Approx(10.0 / 9.0).epsilon(1e-10));
+  REQUIRE(params(0) == 1);
+  REQUIRE(params(1) == 1);
+  REQUIRE(params(2) == 1);
+}
+
+/**
+ * The function f(x) = |x - t|^2 on ordered categories, shifted by offsets(x_0)
+ * if the first dimension is unordered; the evaluated points are recorded, also
+ * when the function is evaluated on several threads.
+ */
+class RefinementFunction
+{
+ public:
+  RefinementFunction(const arma::vec& target, const arma::vec& offsets) :
+      target(target), offsets(offsets) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    double objective = 0.0;
+    for (size_t d = 0; d < x.n_elem; ++d)
+    {
+      if (d == 0 && offsets.n_elem > 0)
+        objective += offsets((size_t) x(0));
+      else
+        objective += (x(d) - target(d)) * (x(d) - target(d));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    points.push_back(arma::conv_to<std::vector<double>>::from(x));
+    return objective;
+  }
+
+  arma::vec target;
+  arma::vec offsets;
+  std::vector<std::vector<double>> points;
+  std::mutex mutex;
+};
+
+/**
+ * Make sure that the coarse-to-fine GridSearch finds the optimum of the full
+ * grid while evaluating only a small part of it, each point at most once.
+ */
+TEST_CASE("GridSearchRefinementTest", "[GridSearchTest]")
+{
+  RefinementFunction f(arma::vec("5 17 26"), arma::vec());
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("33 33 33");
+
+  arma::mat params;
+  GridSearch gs(false, 1, 0, 3.0, 8);
+  const double objective = gs.Optimize(f, params, categoricalDimensions,
+      numCategories);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-10));
+  REQUIRE(params(0) == 5);
+  REQUIRE(params(1) == 17);
+  REQUIRE(params(2) == 26);
+
+  // 125 points in the coarse level, and at most 26 new ones in each of the
+  // three refinement levels, out of 35937.
+  REQUIRE(f.points.size() <= 125 + 3 * 26);
+  std::set<std::vector<double>> unique(f.points.begin(), f.points.end());
+  REQUIRE(unique.size() == f.points.size());
+
+  // The successive halving can't be combined with the refinement.
+  BudgetSphereFunction b(9);
+  GridSearch budgetGs(false, 1, 9, 3.0, 8);
+  REQUIRE_THROWS_AS(budgetGs.Optimize(b, params, categoricalDimensions,
+      numCategories), std::invalid_argument);
+}
+
+/**
+ * Make sure that the parallel coarse-to-fine GridSearch refines several cells,
+ * and evaluates every category of an unordered dimension.
+ */
+TEST_CASE("GridSearchRefinementUnorderedTest", "[GridSearchTest]")
+{
+  RefinementFunction f(arma::vec("0 11 3"), arma::vec("2 0 1"));
+
+  std::vector<bool> categoricalDimensions(3, true);
+  arma::Row<size_t> numCategories("3 20 10");
+
+  arma::mat params;
+  GridSearch gs(true, 1, 0, 3.0, 4, 2);
+  gs.OrderedDimensions() = { false, true, true };
+  const double objective = gs.Optimize(f, params, categoricalDimensions,
+      numCategories);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-10));
+  REQUIRE(params(0) == 1);
+  REQUIRE(params(1) == 11);
+  REQUIRE(params(2) == 3);
+  REQUIRE(f.points.size() < 3 * 20 * 10 / 4);
+
+  gs.OrderedDimensions() = { false, true };
+  REQUIRE_THROWS_AS(gs.Optimize(f, params, categoricalDimensions,
+      numCategories), std::invalid_argument);
+}
@@ -43,3 +43,17 @@ TEST_CASE("IQNLogisticRegressionFMatTest", "[IQNTest]")
     LogisticRegressionFunctionTest<arma::fmat>(iqn, 0.013, 0.016);
   }
 }
+
+/**
+ * Run IQN with limited-memory Hessian approximations on logistic regression
+ * and make sure the results are acceptable.
+ */
+TEST_CASE("IQNLimitedMemoryLogisticRegressionTest", "[IQNTest]")
+{
+  // Run on a couple of batch sizes.
+  for (size_t batchSize = 1; batchSize < 9; batchSize += 4)
+  {
+    IQN iqn(0.01, batchSize, 5000, 0.01, 5);
+    LogisticRegressionFunctionTest(iqn, 0.013, 0.016);
+  }
+}
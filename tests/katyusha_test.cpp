@@ -103,3 +103,73 @@ TEST_CASE("KatyushaProximalLogisticRegressionSpMatTest", "[KatyushaTest]")
 }
 
 #endif
+
+/**
+ * Run Katyusha on logistic regression with the full gradient computed in
+ * parallel, with and without a deterministic reduction.
+ */
+TEST_CASE("KatyushaParallelFullGradientLogisticRegressionTest",
+    "[KatyushaTest]")
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    Katyusha optimizer(1.0, 10.0, 35, 100, 0, 1e-10, true);
+    optimizer.ParallelFullGradient() = true;
+    optimizer.DeterministicReduction() = (i == 1);
+    LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+  }
+}
+
+/**
+ * Make sure that reusing the batch gradients at the snapshot gives the same
+ * result as computing them again, and that Katyusha still converges with
+ * shuffling.
+ */
+TEST_CASE("KatyushaCacheSnapshotGradientsTest", "[KatyushaTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  Katyusha cached(1.0, 10.0, 35, 10, 0, 1e-15, false);
+  cached.CacheSnapshotGradients() = true;
+  Katyusha uncached(cached);
+  uncached.CacheSnapshotGradients() = false;
+
+  arma::mat cachedCoordinates = lr.GetInitialPoint();
+  arma::mat uncachedCoordinates = lr.GetInitialPoint();
+  const double cachedObjective = cached.Optimize(lr, cachedCoordinates);
+  const double uncachedObjective = uncached.Optimize(lr, uncachedCoordinates);
+
+  REQUIRE(cachedObjective == Approx(uncachedObjective).epsilon(1e-10));
+  CheckMatrices(cachedCoordinates, uncachedCoordinates, 1e-10);
+
+  Katyusha optimizer(1.0, 10.0, 35, 100, 0, 1e-10, true);
+  optimizer.CacheSnapshotGradients() = true;
+  LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+}
+
+/**
+ * Make sure that the lazy updates for sparse gradients give the same result
+ * as updating all coordinates at every step.
+ */
+TEST_CASE("KatyushaLazyUpdatesTest", "[KatyushaTest]")
+{
+  SparseTestFunction f;
+  Katyusha lazy(1.0, 10.0, 1, 10, 0, 1e-15, false);
+  lazy.LazyUpdates() = true;
+  Katyusha eager(lazy);
+  eager.LazyUpdates() = false;
+
+  arma::mat lazyCoordinates = f.GetInitialPoint();
+  arma::mat eagerCoordinates = f.GetInitialPoint();
+  const double lazyObjective = lazy.Optimize<SparseTestFunction, arma::mat,
+      arma::sp_mat>(f, lazyCoordinates);
+  const double eagerObjective = eager.Optimize<SparseTestFunction, arma::mat,
+      arma::sp_mat>(f, eagerCoordinates);
+
+  REQUIRE(lazyObjective == Approx(eagerObjective).epsilon(1e-8));
+  CheckMatrices(lazyCoordinates, eagerCoordinates, 1e-6);
+}
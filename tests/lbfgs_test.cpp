@@ -125,3 +125,293 @@ TEST_CASE("RosenbrockWoodFunctionTest", "[LBFGSTest]")
   lbfgs.MaxIterations() = 10000;
   FunctionTest<RosenbrockWoodFunction>(lbfgs, 0.01, 0.001);
 }
+
+/**
+ * Tests the L-BFGS optimizer with a memory smaller than the number of
+ * iterations, so that the stored pairs (and their cached inner products) are
+ * overwritten many times.
+ */
+TEST_CASE("GeneralizedRosenbrockFunctionSmallBasisTest", "[LBFGSTest]")
+{
+  for (size_t numBasis = 1; numBasis <= 3; ++numBasis)
+  {
+    GeneralizedRosenbrockFunction f(16);
+    L_BFGS lbfgs(numBasis);
+    lbfgs.MaxIterations() = 100000;
+
+    arma::vec coords = f.GetInitialPoint();
+    lbfgs.Optimize(f, coords);
+
+    REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+    for (size_t j = 0; j < 16; j++)
+      REQUIRE(coords(j) == Approx(1.0).epsilon(1e-3));
+  }
+}
+
+/**
+ * Tests the L-BFGS optimizer with the history stored in single precision.
+ */
+TEST_CASE("GeneralizedRosenbrockFunctionFloatHistoryTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(64);
+  L_BFGS lbfgs(20);
+  lbfgs.MaxIterations() = 10000;
+  lbfgs.FloatHistory() = true;
+
+  arma::vec coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < 64; j++)
+    REQUIRE(coords(j) == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Tests the L-BFGS optimizer with the More-Thuente line search using the
+ * Rosenbrock function.
+ */
+TEST_CASE("RosenbrockFunctionMoreThuenteTest", "[LBFGSTest]")
+{
+  L_BFGSType<MoreThuenteLineSearch> lbfgs;
+  lbfgs.MaxIterations() = 10000;
+  FunctionTest<RosenbrockFunction>(lbfgs, 0.01, 0.001);
+}
+
+/**
+ * Tests the L-BFGS optimizer with the More-Thuente line search using the
+ * generalized Rosenbrock function.
+ */
+TEST_CASE("GeneralizedRosenbrockFunctionMoreThuenteTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(64);
+  L_BFGSType<MoreThuenteLineSearch> lbfgs(20);
+  lbfgs.MaxIterations() = 10000;
+
+  arma::vec coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+
+  REQUIRE(f.Evaluate(coords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < 64; j++)
+    REQUIRE(coords(j) == Approx(1.0).epsilon(1e-3));
+}
+
+/**
+ * Make sure that evaluating the line search trials in parallel takes the same
+ * steps as evaluating them one at a time.
+ */
+TEST_CASE("GeneralizedRosenbrockFunctionParallelTrialsTest", "[LBFGSTest]")
+{
+  GeneralizedRosenbrockFunction f(16);
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 10000;
+  arma::vec coords = f.GetInitialPoint();
+  lbfgs.Optimize(f, coords);
+
+  L_BFGS parallelLbfgs;
+  parallelLbfgs.MaxIterations() = 10000;
+  parallelLbfgs.LineSearchPolicy().ParallelTrials() = 4;
+  arma::vec parallelCoords = f.GetInitialPoint();
+  parallelLbfgs.Optimize(f, parallelCoords);
+
+  REQUIRE(f.Evaluate(parallelCoords) == Approx(0.0).margin(1e-5));
+  for (size_t j = 0; j < 16; j++)
+    REQUIRE(parallelCoords(j) == Approx(coords(j)).epsilon(1e-10));
+}
+
+/**
+ * Tests the batched L-BFGS optimizer on many small generalized Rosenbrock
+ * problems of different sizes.
+ */
+TEST_CASE("GeneralizedRosenbrockFunctionBatchTest", "[LBFGSTest]")
+{
+  std::vector<GeneralizedRosenbrockFunction> functions;
+  std::vector<arma::mat> coords;
+  for (size_t i = 0; i < 40; ++i)
+  {
+    functions.push_back(GeneralizedRosenbrockFunction(2 + (i % 4) * 2));
+    coords.push_back(functions.back().GetInitialPoint());
+  }
+
+  L_BFGS lbfgs(10);
+  arma::vec objectives;
+  lbfgs.Optimize(functions, coords, objectives);
+
+  REQUIRE(objectives.n_elem == 40);
+  for (size_t i = 0; i < 40; ++i)
+  {
+    REQUIRE(objectives(i) == Approx(0.0).margin(1e-5));
+    REQUIRE(functions[i].Evaluate(coords[i]) == Approx(objectives(i)));
+    for (size_t j = 0; j < coords[i].n_elem; ++j)
+      REQUIRE(coords[i](j) == Approx(1.0).epsilon(1e-3));
+  }
+}
+
+/**
+ * A convex quadratic 0.5 x^T H x - b^T x.
+ */
+class QuadraticFunction
+{
+ public:
+  QuadraticFunction(const arma::mat& h, const arma::vec& b) : h(h), b(b) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    return 0.5 * arma::as_scalar(x.t() * h * x) - arma::dot(b, x);
+  }
+
+  void Gradient(const arma::mat& x, arma::mat& g) { g = h * x - b; }
+
+ private:
+  arma::mat h;
+  arma::vec b;
+};
+
+/**
+ * Make sure that, with ResetPolicy() set to false, the history of a run is used
+ * by the next one, so that many short runs behave like one long run.
+ */
+TEST_CASE("LBFGSKeepHistoryTest", "[LBFGSTest]")
+{
+  const arma::vec eigval = arma::exp(arma::linspace<arma::vec>(0,
+      std::log(1000.0), 30));
+  arma::mat q, r;
+  arma::qr(q, r, arma::mat(30, 30, arma::fill::randn));
+  const arma::mat h = q * arma::diagmat(eigval) * q.t();
+  const arma::vec b(30, arma::fill::randn);
+  const arma::vec solution = arma::solve(h, b);
+
+  QuadraticFunction f(h, b);
+
+  L_BFGS cold(10, 3);
+  L_BFGS warm(10, 3);
+  warm.ResetPolicy() = false;
+
+  arma::mat coldCoordinates(30, 1, arma::fill::zeros);
+  arma::mat warmCoordinates(30, 1, arma::fill::zeros);
+  for (size_t i = 0; i < 10; ++i)
+  {
+    cold.Optimize(f, coldCoordinates);
+    warm.Optimize(f, warmCoordinates);
+  }
+
+  const double coldError = arma::norm(coldCoordinates - solution);
+  const double warmError = arma::norm(warmCoordinates - solution);
+  REQUIRE(warmError < coldError);
+  REQUIRE(warmError < 1e-3 * arma::norm(solution));
+}
+
+/**
+ * Make sure that running L-BFGS step by step, also interleaved with another
+ * optimization, gives the same result as Optimize().
+ */
+TEST_CASE("LBFGSStepTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+  WoodFunction g;
+  L_BFGS lbfgs;
+
+  arma::mat expectedF = f.GetInitialPoint();
+  arma::mat expectedG = g.GetInitialPoint();
+  const double objectiveF = lbfgs.Optimize(f, expectedF);
+  const double objectiveG = lbfgs.Optimize(g, expectedG);
+
+  arma::mat coordinatesF = f.GetInitialPoint();
+  arma::mat coordinatesG = g.GetInitialPoint();
+  auto stateF = lbfgs.Begin(f, coordinatesF);
+  auto stateG = lbfgs.Begin(g, coordinatesG);
+
+  bool runningF = true, runningG = true;
+  while (runningF || runningG)
+  {
+    if (runningF)
+      runningF = lbfgs.Step(stateF);
+    if (runningG)
+      runningG = lbfgs.Step(stateG, 2);
+  }
+
+  REQUIRE(stateF.Objective() == Approx(objectiveF).margin(1e-12));
+  REQUIRE(stateG.Objective() == Approx(objectiveG).margin(1e-12));
+  CheckMatrices(coordinatesF, expectedF, 1e-12);
+  CheckMatrices(coordinatesG, expectedG, 1e-12);
+}
+
+/**
+ * Minimize the Rosenbrock function with L-BFGS-B when the minimum (1, 1) is
+ * outside of the box; the solution of x_0 <= 0.5 is (0.5, 0.25).
+ */
+TEST_CASE("LBFGSBBoundedRosenbrockTest", "[LBFGSTest]")
+{
+  RosenbrockFunction f;
+  const arma::mat lower = { { -2.0 }, { -2.0 } };
+  const arma::mat upper = { { 0.5 }, { 2.0 } };
+  L_BFGS_B lbfgsb(lower, upper);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = lbfgsb.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.25).epsilon(1e-5));
+  REQUIRE(coordinates(0) == Approx(0.5).epsilon(1e-6));
+  REQUIRE(coordinates(1) == Approx(0.25).epsilon(1e-4));
+
+  // The same with arma::fmat.
+  arma::fmat floatCoordinates = f.GetInitialPoint<arma::fmat>();
+  lbfgsb.Optimize(f, floatCoordinates);
+  REQUIRE(floatCoordinates(0) == Approx(0.5).epsilon(1e-5));
+  REQUIRE(floatCoordinates(1) == Approx(0.25).epsilon(1e-2));
+}
+
+/**
+ * Without bounds, L-BFGS-B is L-BFGS.
+ */
+TEST_CASE("LBFGSBUnboundedTest", "[LBFGSTest]")
+{
+  L_BFGS_B lbfgsb;
+  lbfgsb.MinGradientNorm() = 1e-8;
+  FunctionTest<RosenbrockFunction>(lbfgsb, 0.01, 0.001);
+  FunctionTest<WoodFunction>(lbfgsb, 0.01, 0.001);
+}
+
+/**
+ * Minimize a convex quadratic over a box where many bounds are active, and
+ * compare with the result of many projected gradient steps.
+ */
+TEST_CASE("LBFGSBBoxQuadraticTest", "[LBFGSTest]")
+{
+  const arma::vec eigval = arma::linspace<arma::vec>(1.0, 100.0, 30);
+  arma::mat q, r;
+  arma::qr(q, r, arma::mat(30, 30, arma::fill::randn));
+  const arma::mat h = q * arma::diagmat(eigval) * q.t();
+  const arma::vec b = 20.0 * arma::vec(30, arma::fill::randn);
+
+  arma::vec expected(30, arma::fill::zeros);
+  for (size_t i = 0; i < 20000; ++i)
+    expected = arma::clamp(expected - (h * expected - b) / 100.0, -0.5, 0.5);
+
+  QuadraticFunction f(h, b);
+  L_BFGS_B lbfgsb(-0.5, 0.5);
+  lbfgsb.MinGradientNorm() = 1e-9;
+  arma::mat coordinates(30, 1, arma::fill::zeros);
+  lbfgsb.Optimize(f, coordinates);
+
+  REQUIRE(arma::all(arma::vectorise(coordinates) >= -0.5));
+  REQUIRE(arma::all(arma::vectorise(coordinates) <= 0.5));
+  REQUIRE(arma::any(arma::abs(expected) == 0.5));
+  REQUIRE(arma::norm(arma::vectorise(coordinates) - expected, "inf") < 1e-5);
+
+  // Bounds of the wrong size are rejected.
+  lbfgsb.LowerBound() = -0.5 * arma::ones(29, 1);
+  REQUIRE_THROWS_AS(lbfgsb.Optimize(f, coordinates), std::invalid_argument);
+}
+
+#ifdef ENS_HAVE_COOT
+
+/**
+ * Run L-BFGS with the coordinates, the gradients and the history on the GPU.
+ */
+TEST_CASE("LBFGSCootFunctionTest", "[LBFGSTest]")
+{
+  L_BFGS lbfgs;
+  CootFunctionTest(lbfgs, 1e-3);
+}
+
+#endif
@@ -0,0 +1,261 @@
+/**
+ * @file lockstep_sgd_test.cpp
+ *
+ * Test file for LockstepSGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * The squared loss of a linear model on the points
+ * x_p = (sin(0.37 p), cos(0.91 p), 1), with the responses
+ * y_p = 2 x_p(0) - x_p(1) + 0.5, as a separable function of one model.
+ */
+class LockstepRegressionFunction
+{
+ public:
+  LockstepRegressionFunction(const size_t points) :
+      data(3, points),
+      responses(points)
+  {
+    for (size_t i = 0; i < points; ++i)
+    {
+      data(0, i) = std::sin(0.37 * i);
+      data(1, i) = std::cos(0.91 * i);
+      data(2, i) = 1.0;
+    }
+    responses = 2.0 * data.row(0) - data.row(1) + 0.5;
+  }
+
+  size_t NumFunctions() const { return data.n_cols; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize)
+  {
+    const arma::rowvec residuals = coordinates.t() *
+        data.cols(begin, begin + batchSize - 1) -
+        responses.cols(begin, begin + batchSize - 1);
+    return 0.5 * arma::dot(residuals, residuals);
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize)
+  {
+    const arma::rowvec residuals = coordinates.t() *
+        data.cols(begin, begin + batchSize - 1) -
+        responses.cols(begin, begin + batchSize - 1);
+    gradient = data.cols(begin, begin + batchSize - 1) * residuals.t();
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    const arma::rowvec residuals = coordinates.t() *
+        data.cols(begin, begin + batchSize - 1) -
+        responses.cols(begin, begin + batchSize - 1);
+    gradient = data.cols(begin, begin + batchSize - 1) * residuals.t();
+    return 0.5 * arma::dot(residuals, residuals);
+  }
+
+ protected:
+  arma::mat data;
+  arma::rowvec responses;
+};
+
+/**
+ * The same function, which also computes all the models (one per column) at
+ * once with two matrix products per batch, and counts the batches.
+ */
+class LockstepSharedRegressionFunction : public LockstepRegressionFunction
+{
+ public:
+  LockstepSharedRegressionFunction(const size_t points) :
+      LockstepRegressionFunction(points),
+      batches(0)
+  { }
+
+  void EvaluateWithGradients(const arma::mat& coordinates,
+                             const size_t begin,
+                             arma::mat& gradients,
+                             arma::vec& objectives,
+                             const size_t batchSize)
+  {
+    // One column of residuals per model.
+    arma::mat residuals = data.cols(begin, begin + batchSize - 1).t() *
+        coordinates;
+    residuals.each_col() -= responses.cols(begin, begin + batchSize - 1).t();
+    gradients = data.cols(begin, begin + batchSize - 1) * residuals;
+    objectives = 0.5 * arma::sum(arma::square(residuals), 0).t();
+    ++batches;
+  }
+
+  size_t Batches() const { return batches; }
+
+ private:
+  size_t batches;
+};
+
+/**
+ * Record the objectives that BeginEpoch() and EndEpoch() are given.
+ */
+class EpochObjectives
+{
+ public:
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void BeginEpoch(OptimizerType& /* optimizer */,
+                  FunctionType& /* function */,
+                  const MatType& /* coordinates */,
+                  const size_t /* epoch */,
+                  const double objective)
+  { begin.push_back(objective); }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  void EndEpoch(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const size_t /* epoch */,
+                const double objective)
+  { end.push_back(objective); }
+
+  std::vector<double> begin;
+  std::vector<double> end;
+};
+
+/**
+ * Each model of the lockstep sweep ends where a separate SGD run with its step
+ * size ends, and each batch is computed once for all the models.
+ */
+TEST_CASE("LockstepSGDMatchesSeparateRunsTest", "[LockstepSGDTest]")
+{
+  const std::vector<double> stepSizes = { 0.001, 0.004, 0.01 };
+  LockstepSharedRegressionFunction f(1000);
+  LockstepSGD<> lockstep(stepSizes, 10, 5000, -1.0, false);
+
+  arma::mat coordinates(3, stepSizes.size(), arma::fill::zeros);
+  const double objective = lockstep.Optimize(f, coordinates);
+
+  // 5000 points in batches of 10.
+  REQUIRE(f.Batches() == 500);
+  REQUIRE(lockstep.Objectives().n_elem == stepSizes.size());
+  REQUIRE(objective == Approx(lockstep.Objectives().min()));
+
+  for (size_t k = 0; k < stepSizes.size(); ++k)
+  {
+    LockstepRegressionFunction g(1000);
+    SGD<> s(stepSizes[k], 10, 5000, -1.0, false);
+    arma::mat separate(3, 1, arma::fill::zeros);
+    s.Optimize(g, separate);
+
+    REQUIRE(arma::approx_equal(coordinates.col(k), separate, "reldiff",
+        1e-8));
+  }
+
+  // The largest step size gets closest to the solution.
+  REQUIRE(lockstep.Objectives().index_min() == 2);
+  REQUIRE(coordinates(0, 2) == Approx(2.0).margin(1e-3));
+  REQUIRE(coordinates(1, 2) == Approx(-1.0).margin(1e-3));
+  REQUIRE(coordinates(2, 2) == Approx(0.5).margin(1e-3));
+}
+
+/**
+ * BeginEpoch() is given the same lowest mean objective as the EndEpoch() of the
+ * epoch before it.
+ */
+TEST_CASE("LockstepSGDEpochObjectiveTest", "[LockstepSGDTest]")
+{
+  const std::vector<double> stepSizes = { 0.001, 0.01 };
+  LockstepSharedRegressionFunction f(1000);
+  LockstepSGD<> lockstep(stepSizes, 10, 5000, -1.0, false);
+
+  arma::mat coordinates(3, stepSizes.size(), arma::fill::zeros);
+  EpochObjectives epochs;
+  lockstep.Optimize(f, coordinates, epochs);
+
+  // 5000 points are five epochs; the first epoch begins without an objective.
+  REQUIRE(epochs.end.size() == 5);
+  REQUIRE(epochs.begin.size() == 5);
+  for (size_t e = 0; e + 1 < epochs.end.size(); ++e)
+    REQUIRE(epochs.begin[e + 1] == Approx(epochs.end[e]));
+  REQUIRE(epochs.end.back() ==
+      Approx(lockstep.Objectives().min() / f.NumFunctions()));
+}
+
+/**
+ * Without EvaluateWithGradients(), each model is computed separately on the
+ * same batches, with the same result.
+ */
+TEST_CASE("LockstepSGDSeparateModelsTest", "[LockstepSGDTest]")
+{
+  const std::vector<double> stepSizes = { 0.003, 0.01 };
+
+  LockstepSharedRegressionFunction shared(1000);
+  LockstepSGD<AdamUpdate> sharedOptimizer(stepSizes, 20, 10000, -1.0, false);
+  arma::mat sharedCoordinates(3, 2, arma::fill::zeros);
+  sharedOptimizer.Optimize(shared, sharedCoordinates);
+
+  LockstepRegressionFunction separate(1000);
+  LockstepSGD<AdamUpdate> separateOptimizer(stepSizes, 20, 10000, -1.0,
+      false);
+  arma::mat separateCoordinates(3, 2, arma::fill::zeros);
+  separateOptimizer.Optimize(separate, separateCoordinates);
+
+  REQUIRE(arma::approx_equal(sharedCoordinates, separateCoordinates,
+      "reldiff", 1e-8));
+  REQUIRE(arma::approx_equal(sharedOptimizer.Objectives(),
+      separateOptimizer.Objectives(), "reldiff", 1e-8));
+}
+
+/**
+ * A model that diverges stops being updated, without stopping the others, and
+ * models that converge stop once their objective doesn't change any more.
+ */
+TEST_CASE("LockstepSGDDivergentModelTest", "[LockstepSGDTest]")
+{
+  const std::vector<double> stepSizes = { 0.01, 10.0 };
+  LockstepSharedRegressionFunction f(1000);
+  LockstepSGD<> lockstep(stepSizes, 10, 0, 1e-10);
+
+  arma::mat coordinates(3, 2, arma::fill::zeros);
+  const double objective = lockstep.Optimize(f, coordinates);
+
+  REQUIRE(!std::isfinite(lockstep.Objectives()[1]));
+  REQUIRE(objective == Approx(lockstep.Objectives()[0]));
+  REQUIRE(objective < 1e-6);
+  REQUIRE(coordinates(0, 0) == Approx(2.0).margin(1e-3));
+  REQUIRE(coordinates(1, 0) == Approx(-1.0).margin(1e-3));
+  REQUIRE(coordinates(2, 0) == Approx(0.5).margin(1e-3));
+}
+
+/**
+ * The coordinates must hold a whole number of models.
+ */
+TEST_CASE("LockstepSGDInvalidShapeTest", "[LockstepSGDTest]")
+{
+  const std::vector<double> stepSizes = { 0.01, 0.02 };
+  LockstepSharedRegressionFunction f(100);
+  LockstepSGD<> lockstep(stepSizes);
+
+  arma::mat coordinates(3, 3, arma::fill::zeros);
+  REQUIRE_THROWS_AS(lockstep.Optimize(f, coordinates), std::invalid_argument);
+
+  lockstep.UpdatePolicies().pop_back();
+  coordinates.zeros(3, 2);
+  REQUIRE_THROWS_AS(lockstep.Optimize(f, coordinates), std::invalid_argument);
+}
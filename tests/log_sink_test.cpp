@@ -0,0 +1,91 @@
+/**
+ * @file log_sink_test.cpp
+ *
+ * Tests for the log sinks.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+
+/**
+ * Make sure that the fields of a message are formatted as a stream would print
+ * them, and that messages below the level of the sink are dropped.
+ */
+TEST_CASE("BufferedLogSinkLevelTest", "[LogSinkTest]")
+{
+  std::ostringstream output;
+  std::shared_ptr<BufferedLogSink> sink =
+      std::make_shared<BufferedLogSink>(output, LogLevel::Warn);
+  SetLogSink(sink);
+
+  LogStream info(LogLevel::Info);
+  LogStream warn(LogLevel::Warn);
+  info << "dropped " << 1 << std::endl;
+  warn << "objective " << 1.5 << ", " << (size_t) 3 << " steps" << -2 << 'c'
+      << std::string(" done") << std::endl;
+  warn << std::fixed << 0.25 << true << std::endl;
+  sink->Flush();
+
+  REQUIRE(output.str() == "objective 1.5, 3 steps-2c done\n0.2500001\n");
+
+  // Without a sink, nothing is recorded.
+  SetLogSink(nullptr);
+  warn << "dropped" << std::endl;
+  sink->Flush();
+  REQUIRE(output.str() == "objective 1.5, 3 steps-2c done\n0.2500001\n");
+}
+
+/**
+ * Make sure that the messages of several threads are not interleaved, and that
+ * none is lost when the queue fills up.
+ */
+TEST_CASE("BufferedLogSinkThreadsTest", "[LogSinkTest]")
+{
+  std::ostringstream output;
+  {
+    SetLogSink(std::make_shared<BufferedLogSink>(output, LogLevel::Info, 16,
+        1));
+
+    LogStream info(LogLevel::Info);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+      threads.push_back(std::thread([&info, t]()
+      {
+        for (size_t i = 0; i < 100; ++i)
+          info << "thread " << t << " message " << i << std::endl;
+      }));
+    }
+    for (size_t t = 0; t < threads.size(); ++t)
+      threads[t].join();
+
+    // Destroying the sink writes the remaining messages.
+    SetLogSink(nullptr);
+  }
+
+  std::istringstream lines(output.str());
+  std::string line;
+  std::vector<size_t> counts(4, 0);
+  while (std::getline(lines, line))
+  {
+    size_t t, i;
+    std::string thread, message;
+    std::istringstream fields(line);
+    fields >> thread >> t >> message >> i;
+    REQUIRE(thread == "thread");
+    REQUIRE(message == "message");
+    REQUIRE(t < 4);
+    REQUIRE(i == counts[t]);
+    ++counts[t];
+  }
+
+  for (size_t t = 0; t < 4; ++t)
+    REQUIRE(counts[t] == 100);
+}
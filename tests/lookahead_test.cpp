@@ -62,3 +62,33 @@ TEST_CASE("LookaheadAdamSimpleSphereFunctionFloat", "[LookaheadTest]")
       false, true);
   FunctionTest<SphereFunction, arma::fmat>(optimizer, 0.5, 0.2, 3);
 }
+
+/**
+ * Make sure that Lookahead with the reused fast weights matches a direct
+ * implementation of "k steps forward, 1 step back", on repeated calls.
+ */
+TEST_CASE("LookaheadInterpolationTest", "[LookaheadTest]")
+{
+  SphereFunction f(4);
+
+  StandardSGD sgd(0.05, 1, 5, -1.0, false);
+  sgd.ResetPolicy() = false;
+  Lookahead<StandardSGD> optimizer(sgd, 0.5, 5, 3, -1.0, NoDecay(), false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::mat expected = coordinates;
+  for (size_t trial = 0; trial < 2; ++trial)
+  {
+    optimizer.Optimize(f, coordinates);
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+      arma::mat fast = expected;
+      StandardSGD inner(0.05, 1, 5, -1.0, false);
+      inner.Optimize(f, fast);
+      expected += 0.5 * (fast - expected);
+    }
+
+    CheckMatrices(coordinates, expected, 1e-12);
+  }
+}
@@ -246,6 +246,60 @@ TEST_CASE("ErdosRenyiRandomGraphMaxCutSDP", "[LRSDPTest]")
   REQUIRE(finalValue == Approx(-3672.7).epsilon(1e-3));
 }
 
+/**
+ * Solve the max-cut SDP of ErdosRenyiRandomGraphMaxCutSDP starting from rank
+ * 2, and make sure that the rank-adaptive mode grows the rank until it finds
+ * the optimum.
+ */
+TEST_CASE("RankAdaptiveMaxCutSDP", "[LRSDPTest]")
+{
+  arma::mat edges;
+  if (edges.load("data/erdosrenyi-n100.csv", arma::csv_ascii) == false)
+  {
+    FAIL("couldn't load data");
+    return;
+  }
+
+  edges = edges.t();
+
+  arma::sp_mat laplacian;
+  CreateSparseGraphLaplacian(edges, laplacian);
+
+  float r = 0.5 + sqrt(0.25 + 2 * edges.n_cols);
+  if (ceil(r) > laplacian.n_rows)
+    r = laplacian.n_rows;
+
+  // Start from a feasible point of rank 2.
+  arma::mat coordinates(laplacian.n_rows, 2, arma::fill::zeros);
+  for (size_t i = 0; i < coordinates.n_rows; ++i)
+    coordinates(i, i % coordinates.n_cols) = 1.;
+
+  LRSDP<SDP<arma::sp_mat>> maxcut(laplacian.n_rows, 0, coordinates);
+  maxcut.SDP().C() = laplacian;
+  maxcut.SDP().C() *= -1.; // need to minimize the negative
+  maxcut.SDP().SparseB().ones(laplacian.n_rows);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+  {
+    maxcut.SDP().SparseA()[i].zeros(laplacian.n_rows, laplacian.n_rows);
+    maxcut.SDP().SparseA()[i](i, i) = 1.;
+  }
+  maxcut.MaxRank() = ceil(r);
+  maxcut.RankIncrement() = 2;
+
+  const double finalValue = maxcut.Optimize(coordinates);
+  REQUIRE(coordinates.n_cols > 2);
+  REQUIRE(coordinates.n_cols <= maxcut.MaxRank());
+
+  const arma::mat rrt = coordinates * trans(coordinates);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+  {
+    REQUIRE(rrt(i, i) == Approx(1.0).epsilon(1e-5));
+  }
+
+  // Final value taken by solving with Mosek
+  REQUIRE(finalValue == Approx(-3672.7).epsilon(1e-3));
+}
+
 /*
  * Test a nuclear norm minimization SDP.
  *
@@ -340,3 +394,223 @@ TEST_CASE("GaussianMatrixSensingSDP", "[LRSDPTest]")
       arma::norm(Xorig, "fro");
   REQUIRE(err == Approx(0.0).margin(0.05));
 }
+
+/**
+ * Make sure that the augmented Lagrangian of an LRSDP is the same whether the
+ * sparse constraints are evaluated one by one or through the stacked matrix.
+ */
+TEST_CASE("StackedSparseConstraints", "[LRSDPTest]")
+{
+  const size_t n = 20;
+  const size_t numSparse = 30;
+  const size_t numDense = 5;
+
+  arma::mat coordinates(n, 4, arma::fill::randn);
+  LRSDPFunction<SDP<arma::sp_mat>> function(numSparse, numDense, coordinates);
+
+  function.SDP().C().sprandu(n, n, 0.2);
+  function.SDP().C() += function.SDP().C().t();
+  function.SDP().SparseB().randu(numSparse);
+  function.SDP().DenseB().randu(numDense);
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    function.SDP().SparseA()[i].sprandu(n, n, 0.05);
+    function.SDP().SparseA()[i] += function.SDP().SparseA()[i].t();
+  }
+  for (size_t i = 0; i < numDense; ++i)
+  {
+    function.SDP().DenseA()[i].randu(n, n);
+    function.SDP().DenseA()[i] += function.SDP().DenseA()[i].t();
+  }
+
+  function.RRTAny().Set<arma::mat>(
+      new arma::mat(coordinates * coordinates.t()));
+
+  arma::vec lambda(numSparse + numDense, arma::fill::randn);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> augLag(function,
+      lambda, 10);
+
+  // Without the stacked matrix, the constraints are evaluated one by one.
+  REQUIRE(function.StackedSparseA().n_cols == 0);
+  const double objective = augLag.Evaluate(coordinates);
+  arma::mat gradient;
+  augLag.Gradient(coordinates, gradient);
+
+  function.StackSparseConstraints();
+  REQUIRE(function.StackedSparseA().n_rows == n * n);
+  REQUIRE(function.StackedSparseA().n_cols == numSparse);
+
+  const double stackedObjective = augLag.Evaluate(coordinates);
+  arma::mat stackedGradient;
+  augLag.Gradient(coordinates, stackedGradient);
+
+  REQUIRE(stackedObjective == Approx(objective).epsilon(1e-10));
+  REQUIRE(arma::approx_equal(stackedGradient, gradient, "reldiff", 1e-10));
+}
+
+/**
+ * Make sure that the low-memory mode of LRSDPFunction, which never forms
+ * R * R^T, gives the same objective, gradient and constraints as the default
+ * mode, with and without the stacked sparse constraints.
+ */
+TEST_CASE("LowMemoryLRSDPFunction", "[LRSDPTest]")
+{
+  const size_t n = 20;
+  const size_t numSparse = 30;
+  const size_t numDense = 5;
+
+  arma::mat coordinates(n, 4, arma::fill::randn);
+  LRSDPFunction<SDP<arma::sp_mat>> function(numSparse, numDense, coordinates);
+
+  function.SDP().C().sprandu(n, n, 0.2);
+  function.SDP().C() += function.SDP().C().t();
+  function.SDP().SparseB().randu(numSparse);
+  function.SDP().DenseB().randu(numDense);
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    function.SDP().SparseA()[i].sprandu(n, n, 0.05);
+    function.SDP().SparseA()[i] += function.SDP().SparseA()[i].t();
+  }
+  for (size_t i = 0; i < numDense; ++i)
+  {
+    function.SDP().DenseA()[i].randu(n, n);
+    function.SDP().DenseA()[i] += function.SDP().DenseA()[i].t();
+  }
+
+  arma::vec lambda(numSparse + numDense, arma::fill::randn);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> augLag(function,
+      lambda, 10);
+
+  for (size_t stacked = 0; stacked < 2; ++stacked)
+  {
+    if (stacked == 1)
+      function.StackSparseConstraints();
+
+    function.LowMemory() = false;
+    function.RRTAny().Clean();
+    function.RRTAny().Set<arma::mat>(
+        new arma::mat(coordinates * coordinates.t()));
+
+    const double objective = augLag.Evaluate(coordinates);
+    arma::mat gradient;
+    augLag.Gradient(coordinates, gradient);
+    arma::vec constraints;
+    function.EvaluateConstraints(coordinates, constraints);
+    const double cost = function.Evaluate(coordinates);
+
+    // The low-memory mode must not need the cached R * R^T.
+    function.LowMemory() = true;
+    function.RRTAny().Clean();
+
+    const double lowMemoryObjective = augLag.Evaluate(coordinates);
+    arma::mat lowMemoryGradient;
+    augLag.Gradient(coordinates, lowMemoryGradient);
+    arma::vec lowMemoryConstraints;
+    function.EvaluateConstraints(coordinates, lowMemoryConstraints);
+
+    REQUIRE(lowMemoryObjective == Approx(objective).epsilon(1e-10));
+    REQUIRE(function.Evaluate(coordinates) == Approx(cost).epsilon(1e-10));
+    REQUIRE(arma::approx_equal(lowMemoryGradient, gradient, "reldiff",
+        1e-10));
+    REQUIRE(arma::approx_equal(lowMemoryConstraints, constraints, "reldiff",
+        1e-10));
+    for (size_t i = 0; i < numSparse + numDense; ++i)
+    {
+      REQUIRE(function.EvaluateConstraint(i, coordinates) ==
+          Approx(constraints[i]).epsilon(1e-10).margin(1e-10));
+    }
+  }
+}
+
+// Count the iterations of PrimalDualSolver.
+struct SDPStepCounter
+{
+  SDPStepCounter() : steps(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    ++steps;
+    return false;
+  }
+
+  size_t steps;
+};
+
+/**
+ * Solve the max-cut SDP of ErdosRenyiRandomGraphMaxCutSDP with LRSDP, and use
+ * the solution to warm-start PrimalDualSolver.  The warm-started solver should
+ * reach the same optimum as a cold start, in fewer iterations.
+ */
+TEST_CASE("LRSDPWarmStartPrimalDualMaxCutSDP", "[LRSDPTest]")
+{
+  arma::mat edges;
+  if (edges.load("data/erdosrenyi-n100.csv", arma::csv_ascii) == false)
+  {
+    FAIL("couldn't load data");
+    return;
+  }
+
+  edges = edges.t();
+
+  arma::sp_mat laplacian;
+  CreateSparseGraphLaplacian(edges, laplacian);
+
+  float r = 0.5 + sqrt(0.25 + 2 * edges.n_cols);
+  if (ceil(r) > laplacian.n_rows)
+    r = laplacian.n_rows;
+
+  arma::mat coordinates(laplacian.n_rows, ceil(r), arma::fill::zeros);
+  for (size_t i = 0; i < coordinates.n_rows; ++i)
+    coordinates(i, i % coordinates.n_cols) = 1.;
+
+  LRSDP<SDP<arma::sp_mat>> maxcut(laplacian.n_rows, 0, coordinates);
+  maxcut.SDP().C() = laplacian;
+  maxcut.SDP().C() *= -1.; // need to minimize the negative
+  maxcut.SDP().SparseB().ones(laplacian.n_rows);
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+  {
+    maxcut.SDP().SparseA()[i].zeros(laplacian.n_rows, laplacian.n_rows);
+    maxcut.SDP().SparseA()[i](i, i) = 1.;
+  }
+
+  // The multipliers are only available after Optimize().
+  arma::mat X, ySparse, yDense, Z;
+  REQUIRE_THROWS_AS(maxcut.GetPrimalDualPoints(coordinates, X, ySparse,
+      yDense, Z), std::logic_error);
+
+  const double lrsdpValue = maxcut.Optimize(coordinates);
+  maxcut.GetPrimalDualPoints(coordinates, X, ySparse, yDense, Z);
+
+  REQUIRE(X.n_rows == laplacian.n_rows);
+  REQUIRE(ySparse.n_rows == laplacian.n_rows);
+  REQUIRE(ySparse.n_cols == 1);
+  REQUIRE(yDense.n_elem == 0);
+  REQUIRE(Z.n_rows == laplacian.n_rows);
+
+  // Both starting points must be in the interior of the cone.
+  arma::mat L;
+  REQUIRE(arma::chol(L, X));
+  REQUIRE(arma::chol(L, Z));
+
+  PrimalDualSolver warmSolver;
+  SDPStepCounter warmSteps;
+  const double warmValue = warmSolver.Optimize(maxcut.SDP(), X, ySparse,
+      yDense, Z, warmSteps);
+
+  arma::mat coldX, coldYSparse, coldYDense, coldZ;
+  maxcut.SDP().GetInitialPoints(coldX, coldYSparse, coldYDense, coldZ);
+  PrimalDualSolver coldSolver;
+  SDPStepCounter coldSteps;
+  const double coldValue = coldSolver.Optimize(maxcut.SDP(), coldX,
+      coldYSparse, coldYDense, coldZ, coldSteps);
+
+  for (size_t i = 0; i < laplacian.n_rows; ++i)
+    REQUIRE(X(i, i) == Approx(1.0).epsilon(1e-5));
+
+  REQUIRE(warmValue == Approx(coldValue).epsilon(1e-5));
+  REQUIRE(warmValue == Approx(lrsdpValue).epsilon(1e-3));
+  REQUIRE(warmSteps.steps < coldSteps.steps);
+}
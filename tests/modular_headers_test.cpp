@@ -0,0 +1,48 @@
+/**
+ * @file modular_headers_test.cpp
+ *
+ * Make sure that the headers in include/ensmallen/ can be used on their own,
+ * without ensmallen.hpp.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+// Only the headers of two optimizers and of the test problems are included.
+#include <ensmallen/adam.hpp>
+#include <ensmallen/lbfgs.hpp>
+#include <ensmallen/problems.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+#if defined(ENSMALLEN_HPP) || defined(ENSMALLEN_SGDR_SGDR_HPP) || \
+    defined(ENSMALLEN_CALLBACKS_PRINT_LOSS_HPP)
+  #error "the modular headers should not include the rest of ensmallen"
+#endif
+
+/**
+ * Optimize the Rosenbrock function with L-BFGS, and the sphere function with
+ * Adam, with only their own headers.
+ */
+TEST_CASE("ModularHeadersTest", "[ModularHeadersTest]")
+{
+  RosenbrockFunction rosenbrock;
+  arma::mat coordinates = rosenbrock.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.MaxIterations() = 10000;
+  lbfgs.Optimize(rosenbrock, coordinates);
+  REQUIRE(coordinates(0) == Approx(1.0).margin(0.001));
+  REQUIRE(coordinates(1) == Approx(1.0).margin(0.001));
+
+  SphereFunction sphere(2);
+  arma::mat sphereCoordinates = sphere.GetInitialPoint();
+  Adam adam(0.5, 2, 0.7, 0.999, 1e-8, 500000, 1e-3, false);
+  adam.Optimize(sphere, sphereCoordinates);
+  REQUIRE(sphere.Evaluate(sphereCoordinates) == Approx(0.0).margin(0.5));
+  REQUIRE(sphereCoordinates(0) == Approx(0.0).margin(0.2));
+  REQUIRE(sphereCoordinates(1) == Approx(0.0).margin(0.2));
+}
@@ -0,0 +1,154 @@
+/**
+ * @file moead_test.cpp
+ *
+ * Tests for the MOEA/D optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Optimize the Schaffer N.1 function with the given MOEA/D optimizer, and make
+ * sure that the front lies in [0, 2] (up to the given tolerance) and covers
+ * most of it.
+ */
+template<typename OptimizerType>
+void MOEADSchafferN1Test(OptimizerType& opt, const double tolerance)
+{
+  SchafferFunctionN1<arma::mat> SCH;
+
+  typedef decltype(SCH.objectiveA) ObjectiveTypeA;
+  typedef decltype(SCH.objectiveB) ObjectiveTypeB;
+
+  // We allow a few trials in case of poor convergence.
+  bool success = false;
+  for (size_t trial = 0; trial < 3 && !success; ++trial)
+  {
+    arma::mat coords = SCH.GetInitialPoint();
+    std::tuple<ObjectiveTypeA, ObjectiveTypeB> objectives =
+        SCH.GetObjectives();
+
+    opt.Optimize(objectives, coords);
+    const std::vector<arma::mat>& bestFront = opt.Front();
+
+    double low = std::numeric_limits<double>::max();
+    double high = -std::numeric_limits<double>::max();
+    for (const arma::mat& solution : bestFront)
+    {
+      low = std::min(low, arma::as_scalar(solution));
+      high = std::max(high, arma::as_scalar(solution));
+    }
+
+    success = (low >= -tolerance && high <= 2.0 + tolerance &&
+        high - low > 1.0);
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Optimize for the Schaffer N.1 function using MOEA/D.
+ */
+TEST_CASE("MOEADSchafferN1Test", "[MOEADTest]")
+{
+  MOEAD opt(50, 300, 1.0, 0.9, 10, 20, 0.5, 2, -1000.0, 1000.0);
+  MOEADSchafferN1Test(opt, 0.1);
+}
+
+/**
+ * Optimize for the Schaffer N.1 function using MOEA/D, with vector bounds.
+ */
+TEST_CASE("MOEADSchafferN1TestVectorBounds", "[MOEADTest]")
+{
+  const arma::vec lowerBound = {-1000};
+  const arma::vec upperBound = {1000};
+  MOEAD opt(50, 300, 1.0, 0.9, 10, 20, 0.5, 2, lowerBound, upperBound);
+  MOEADSchafferN1Test(opt, 0.1);
+}
+
+/**
+ * Optimize for the Schaffer N.1 function with the other decompositions.
+ */
+TEST_CASE("MOEADDecompositionPoliciesTest", "[MOEADTest]")
+{
+  MOEADType<PBI> pbi(50, 300, 1.0, 0.9, 10, 20, 0.5, 2, -1000.0, 1000.0);
+  MOEADSchafferN1Test(pbi, 0.1);
+
+  MOEADType<WeightedAverage> weighted(50, 300, 1.0, 0.9, 10, 20, 0.5, 2,
+      -1000.0, 1000.0);
+  MOEADSchafferN1Test(weighted, 0.1);
+}
+
+/**
+ * Optimize for the Fonseca Fleming function using MOEA/D, evaluating the
+ * objectives in parallel.
+ */
+TEST_CASE("MOEADFonsecaFlemingTest", "[MOEADTest]")
+{
+  FonsecaFlemingFunction<arma::mat> FON;
+  const double expectedBound = 1.0 / std::sqrt(3.0) + 0.05;
+
+  MOEAD opt(50, 300, 1.0, 0.9, 10, 20, 0.5, 2, -4.0, 4.0);
+  opt.ParallelEvaluation() = true;
+
+  typedef decltype(FON.objectiveA) ObjectiveTypeA;
+  typedef decltype(FON.objectiveB) ObjectiveTypeB;
+
+  arma::mat coords = FON.GetInitialPoint();
+  std::tuple<ObjectiveTypeA, ObjectiveTypeB> objectives = FON.GetObjectives();
+
+  opt.Optimize(objectives, coords);
+  const std::vector<arma::mat>& bestFront = opt.Front();
+
+  REQUIRE(bestFront.size() > 10);
+  for (const arma::mat& solution : bestFront)
+    REQUIRE(arma::abs(solution).max() <= expectedBound);
+}
+
+/**
+ * Objective that counts how often it is evaluated.
+ */
+class MOEADCountingObjective
+{
+ public:
+  MOEADCountingObjective(const double shift) : shift(shift), evaluations(0) { }
+
+  double Evaluate(const arma::mat& coords)
+  {
+    ++evaluations;
+    return std::pow(arma::as_scalar(coords) - shift, 2.0);
+  }
+
+  double shift;
+  size_t evaluations;
+};
+
+/**
+ * Make sure that each generation evaluates one child per subproblem, and that
+ * invalid parameters are rejected.
+ */
+TEST_CASE("MOEADEvaluationsTest", "[MOEADTest]")
+{
+  MOEAD opt(20, 50, 1.0, 0.9, 5, 20, 0.5, 2, -1000.0, 1000.0);
+
+  std::tuple<MOEADCountingObjective, MOEADCountingObjective> objectives(
+      MOEADCountingObjective(0), MOEADCountingObjective(2));
+  arma::mat coords(1, 1, arma::fill::zeros);
+  opt.Optimize(objectives, coords);
+
+  REQUIRE(std::get<0>(objectives).evaluations == 20 * (50 + 1));
+  REQUIRE(std::get<1>(objectives).evaluations == 20 * (50 + 1));
+  REQUIRE(opt.Front().size() > 0);
+
+  opt.NeighborSize() = 21;
+  REQUIRE_THROWS_AS(opt.Optimize(objectives, coords), std::logic_error);
+}
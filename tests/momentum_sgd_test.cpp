@@ -12,6 +12,7 @@
 
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace ens;
 using namespace ens::test;
@@ -69,6 +70,29 @@ TEST_CASE("MomentumSGDGeneralizedRosenbrockTest", "[MomentumSGDTest]")
   }
 }
 
+/**
+ * Make sure that splitting the fused momentum update into parallel,
+ * cache-line-aligned ranges gives the same result as the serial update.
+ */
+TEST_CASE("MomentumSGDFusedUpdateThresholdTest", "[MomentumSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(100);
+  MomentumUpdate momentumUpdate(0.4);
+  MomentumSGD s(0.0008, 1, 100000, 1e-15, false, momentumUpdate, NoDecay(),
+      true, true);
+
+  arma::mat serialCoordinates = f.GetInitialPoint();
+  s.Optimize(f, serialCoordinates);
+
+  // Ranges of 16 elements, so the 100 coordinates are split into 7 ranges.
+  SetFusedUpdateThreshold(1);
+  arma::mat parallelCoordinates = f.GetInitialPoint();
+  s.Optimize(f, parallelCoordinates);
+  SetFusedUpdateThreshold(0);
+
+  CheckMatrices(serialCoordinates, parallelCoordinates, 1e-10);
+}
+
 // Use arma::fmat.
 TEST_CASE("MomentumSGDGeneralizedRosenbrockFMatTest", "[MomentumSGDTest]")
 {
@@ -0,0 +1,103 @@
+/**
+ * @file multi_start_test.cpp
+ *
+ * Test file for the MultiStart meta-optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Run L-BFGS from many starts on the Rastrigin function, whose local minima
+ * are at the integer points, and make sure the global minimum is found.
+ */
+TEST_CASE("MultiStartLBFGSRastriginTest", "[MultiStartTest]")
+{
+  RastriginFunction f(2);
+  arma::mat coordinates("1.8; -1.7");
+
+  MultiStart<L_BFGS> ms(L_BFGS(), 100, -2.0, 2.0, 7);
+  const double objective = ms.Optimize(f, coordinates);
+
+  REQUIRE(objective == Approx(0.0).margin(1e-5));
+  REQUIRE(coordinates(0) == Approx(0.0).margin(1e-3));
+  REQUIRE(coordinates(1) == Approx(0.0).margin(1e-3));
+  REQUIRE(ms.Objectives().n_elem == 100);
+  REQUIRE(objective == Approx(ms.Objectives().min()).margin(1e-10));
+}
+
+/**
+ * Make sure that the parallel starts give the same result as the serial ones
+ * for the same seed, even though SA uses random numbers.
+ */
+TEST_CASE("MultiStartSADeterministicTest", "[MultiStartTest]")
+{
+  RastriginFunction f(2);
+  SA<> sa(ExponentialSchedule(), 10000);
+
+  arma::mat serialCoordinates("1.0; 1.0");
+  MultiStart<SA<>> serial(sa, 4, -2.0, 2.0, 11, false);
+  const double serialObjective = serial.Optimize(f, serialCoordinates);
+
+  arma::mat parallelCoordinates("1.0; 1.0");
+  MultiStart<SA<>> parallel(sa, 4, -2.0, 2.0, 11, true);
+  const double parallelObjective = parallel.Optimize(f, parallelCoordinates);
+
+  REQUIRE(serialObjective == parallelObjective);
+  REQUIRE(serial.BestStart() == parallel.BestStart());
+  REQUIRE(arma::approx_equal(serialCoordinates, parallelCoordinates,
+      "absdiff", 0.0));
+}
+
+/**
+ * Check the population sizes of the IPOP and BIPOP restart schedules.
+ */
+TEST_CASE("MultiStartRestartPoliciesTest", "[MultiStartTest]")
+{
+  std::mt19937 rng(0);
+  CMAES<> cmaes(10);
+
+  for (size_t i = 0; i < 4; ++i)
+  {
+    CMAES<> start(cmaes);
+    IPOPRestarts().Configure(start, i, 2, rng);
+    REQUIRE(start.PopulationSize() == (size_t) (10 << i));
+  }
+
+  // The large starts grow; the small ones are between the default population
+  // size and half of the previous large one.
+  for (size_t i = 0; i < 8; ++i)
+  {
+    CMAES<> start(cmaes);
+    BIPOPRestarts().Configure(start, i, 2, rng);
+    if (i % 2 == 1 || i == 0)
+    {
+      REQUIRE(start.PopulationSize() == (size_t) (10 << ((i + 1) / 2)));
+    }
+    else
+    {
+      REQUIRE(start.PopulationSize() >= 10);
+      REQUIRE(start.PopulationSize() <= (size_t) (5 << (i / 2)));
+    }
+  }
+}
+
+/**
+ * Run CMA-ES with the IPOP restart schedule on logistic regression and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("MultiStartIPOPCMAESLogisticRegressionTest", "[MultiStartTest]")
+{
+  CMAES<> cmaes(0, -1, 1, 32, 200, 1e-3);
+  MultiStart<CMAES<>, IPOPRestarts> ms(cmaes, 2, -1.0, 1.0);
+  LogisticRegressionFunctionTest(ms, 0.003, 0.006, 5);
+}
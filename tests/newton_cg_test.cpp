@@ -0,0 +1,98 @@
+/**
+ * @file newton_cg_test.cpp
+ *
+ * Tests for the Hessian-free trust-region Newton optimizer and the
+ * Hessian-vector products of the regression problems.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Make sure that the Hessian-vector products of the logistic and softmax
+ * regression functions match central differences of their gradients.
+ */
+TEST_CASE("NewtonCGHessianVectorProductTest", "[NewtonCGTest]")
+{
+  arma::mat data(5, 60, arma::fill::randn);
+  arma::Row<size_t> responses(60);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+    responses[i] = (arma::accu(data.col(i)) > 0.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  arma::mat coordinates(1, 6, arma::fill::randn);
+  arma::mat direction(1, 6, arma::fill::randn);
+  arma::mat product, gradientPlus, gradientMinus;
+  lrf.HessianVectorProduct(coordinates, direction, product);
+  lrf.Gradient(coordinates + 1e-5 * direction, gradientPlus);
+  lrf.Gradient(coordinates - 1e-5 * direction, gradientMinus);
+  REQUIRE(arma::approx_equal(product, (gradientPlus - gradientMinus) / 2e-5,
+      "absdiff", 1e-5));
+
+  for (size_t intercept = 0; intercept < 2; ++intercept)
+  {
+    SoftmaxRegressionFunction srf(data, responses, 2, 0.1, intercept == 1);
+    coordinates.randn(arma::size(srf.GetInitialPoint()));
+    direction.randn(arma::size(coordinates));
+    srf.HessianVectorProduct(coordinates, direction, product);
+    srf.Gradient(coordinates + 1e-5 * direction, gradientPlus);
+    srf.Gradient(coordinates - 1e-5 * direction, gradientMinus);
+    REQUIRE(arma::approx_equal(product, (gradientPlus - gradientMinus) / 2e-5,
+        "absdiff", 1e-6));
+  }
+}
+
+/**
+ * Run NewtonCG on logistic regression, with the Hessian-vector products of the
+ * function.
+ */
+TEST_CASE("NewtonCGLogisticRegressionTest", "[NewtonCGTest]")
+{
+  NewtonCG optimizer(100);
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006);
+}
+
+/**
+ * Run NewtonCG on the Rosenbrock function, which has no Hessian-vector product
+ * method, so the products are finite differences of the gradient.
+ */
+TEST_CASE("NewtonCGRosenbrockFunctionTest", "[NewtonCGTest]")
+{
+  NewtonCG optimizer(1000);
+  FunctionTest<RosenbrockFunction>(optimizer, 0.01, 0.001);
+}
+
+/**
+ * Make sure that NewtonCG converges in few iterations on softmax regression,
+ * to the same minimum as L-BFGS.
+ */
+TEST_CASE("NewtonCGSoftmaxRegressionTest", "[NewtonCGTest]")
+{
+  arma::mat data(10, 500, arma::fill::randn);
+  arma::Row<size_t> labels(500);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    labels[i] = (data(0, i) > 0.5) ? 2 : ((data(1, i) > 0.0) ? 1 : 0);
+
+  SoftmaxRegressionFunction srf(data, labels, 3, 0.01, true);
+  arma::mat coordinates = srf.GetInitialPoint();
+  arma::mat lbfgsCoordinates = coordinates;
+
+  NewtonCG optimizer(50, 0, 1e-8);
+  const double objective = optimizer.Optimize(srf, coordinates);
+
+  L_BFGS lbfgs;
+  lbfgs.MinGradientNorm() = 1e-8;
+  const double lbfgsObjective = lbfgs.Optimize(srf, lbfgsCoordinates);
+
+  REQUIRE(objective == Approx(lbfgsObjective).epsilon(1e-6));
+  REQUIRE(arma::approx_equal(coordinates, lbfgsCoordinates, "absdiff", 1e-3));
+}
@@ -211,3 +211,309 @@ TEST_CASE("NSGA2FonsecaFlemingTestVectorBounds", "[NSGA2Test]")
   }
   REQUIRE(allInRange);
 }
+
+/**
+ * Make sure that all non-dominated sort policies find the same fronts, also
+ * when many candidates have equal objective values.
+ */
+TEST_CASE("NSGA2SortPoliciesTest", "[NSGA2Test]")
+{
+  for (size_t numObjectives = 1; numObjectives <= 4; ++numObjectives)
+  {
+    // Few distinct values give many ties.
+    const arma::mat objectives = arma::conv_to<arma::mat>::from(
+        arma::randi<arma::imat>(numObjectives, 300, arma::distr_param(0, 5)));
+
+    std::vector<std::vector<size_t> > fronts, ensFronts, ssFronts, dcFronts;
+    std::vector<size_t> ranks, ensRanks, ssRanks, dcRanks;
+
+    FastNonDominatedSort().Sort(objectives, fronts, ranks);
+    EfficientNonDominatedSort().Sort(objectives, ensFronts, ensRanks);
+    EfficientNonDominatedSort(false).Sort(objectives, ssFronts, ssRanks);
+    DivideAndConquerSort().Sort(objectives, dcFronts, dcRanks);
+
+    REQUIRE(ensRanks == ranks);
+    REQUIRE(ssRanks == ranks);
+    REQUIRE(dcRanks == ranks);
+    REQUIRE(ensFronts.size() == fronts.size());
+    REQUIRE(ssFronts.size() == fronts.size());
+    REQUIRE(dcFronts.size() == fronts.size());
+
+    // Check the ranks against the definition of Pareto dominance.
+    for (size_t p = 0; p < objectives.n_cols; ++p)
+    {
+      for (size_t q = 0; q < objectives.n_cols; ++q)
+      {
+        if (arma::all(objectives.col(p) <= objectives.col(q)) &&
+            arma::any(objectives.col(p) < objectives.col(q)))
+        {
+          REQUIRE(ranks[p] < ranks[q]);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that the vectorized dominance tests of a block of candidates agree
+ * with ParetoDominates(), also for ties and for float objectives.
+ */
+TEST_CASE("NSGA2ParetoDominanceBlockTest", "[NSGA2Test]")
+{
+  for (size_t numObjectives = 1; numObjectives <= 5; ++numObjectives)
+  {
+    const arma::fmat objectives = arma::conv_to<arma::fmat>::from(
+        arma::randi<arma::imat>(numObjectives, 600, arma::distr_param(0, 3)));
+    const arma::fmat packed = objectives.t();
+
+    std::vector<unsigned char> better(600), worse(600);
+    for (size_t p = 0; p < objectives.n_cols; p += 37)
+    {
+      // A block that doesn't start at a multiple of the vector width.
+      const size_t begin = (p * 7) % 200 + 1;
+      ParetoDominanceBlock(packed, p, begin, objectives.n_cols, better.data(),
+          worse.data());
+      for (size_t q = begin; q < objectives.n_cols; ++q)
+      {
+        const bool b = better[q - begin];
+        const bool w = worse[q - begin];
+        REQUIRE((b && !w) == ParetoDominates(objectives.colptr(p),
+            objectives.colptr(q), numObjectives));
+        REQUIRE((w && !b) == ParetoDominates(objectives.colptr(q),
+            objectives.colptr(p), numObjectives));
+      }
+    }
+  }
+}
+
+/**
+ * Optimize for the Schaffer N.1 function using NSGA-II optimizer with the
+ * divide-and-conquer sort.
+ */
+TEST_CASE("NSGA2DivideAndConquerSortSchafferN1Test", "[NSGA2Test]")
+{
+  SchafferFunctionN1<arma::mat> SCH;
+  const double lowerBound = -1000;
+  const double upperBound = 1000;
+
+  NSGA2Type<DivideAndConquerSort> opt(20, 5000, 0.5, 0.5, 1e-3, 1e-6,
+      lowerBound, upperBound);
+
+  typedef decltype(SCH.objectiveA) ObjectiveTypeA;
+  typedef decltype(SCH.objectiveB) ObjectiveTypeB;
+
+  // We allow a few trials in case of poor convergence.
+  bool success = false;
+  for (size_t trial = 0; trial < 3; ++trial)
+  {
+    arma::mat coords = SCH.GetInitialPoint();
+    std::tuple<ObjectiveTypeA, ObjectiveTypeB> objectives = SCH.GetObjectives();
+
+    opt.Optimize(objectives, coords);
+    std::vector<arma::mat> bestFront = opt.Front();
+
+    bool allInRange = true;
+    for (arma::mat solution: bestFront)
+    {
+      double val = arma::as_scalar(solution);
+      if (val < 0.0 || val > 2.0)
+      {
+        allInRange = false;
+        break;
+      }
+    }
+
+    if (allInRange)
+    {
+      success = true;
+      break;
+    }
+  }
+
+  REQUIRE(success == true);
+}
+
+/**
+ * Objective that counts how often it is evaluated.
+ */
+class CountingObjective
+{
+ public:
+  CountingObjective(const double shift) : shift(shift), evaluations(0) { }
+
+  double Evaluate(const arma::mat& coords)
+  {
+    ++evaluations;
+    return std::pow(arma::as_scalar(coords) - shift, 2.0);
+  }
+
+  double shift;
+  size_t evaluations;
+};
+
+/**
+ * Make sure that only the children are evaluated in each generation.
+ */
+TEST_CASE("NSGA2CachedObjectivesTest", "[NSGA2Test]")
+{
+  NSGA2 opt(20, 50, 0.5, 0.5, 1e-3, 1e-6, -1000.0, 1000.0);
+
+  std::tuple<CountingObjective, CountingObjective> objectives(
+      CountingObjective(0), CountingObjective(2));
+  arma::mat coords(1, 1, arma::fill::zeros);
+  opt.Optimize(objectives, coords);
+
+  REQUIRE(std::get<0>(objectives).evaluations == 20 * (50 + 1));
+  REQUIRE(std::get<1>(objectives).evaluations == 20 * (50 + 1));
+  REQUIRE(opt.Front().size() > 0);
+}
+
+/**
+ * Make sure that the in-place reproduction creates one child per candidate,
+ * within the bounds, also when the population size is odd.
+ */
+TEST_CASE("NSGA2InPlaceReproductionTest", "[NSGA2Test]")
+{
+  NSGA2 opt(7, 30, 0.5, 0.5, 1e-1, 1e-6, -1.0, 3.0);
+
+  std::tuple<CountingObjective, CountingObjective> objectives(
+      CountingObjective(0), CountingObjective(2));
+  arma::mat coords(1, 1, arma::fill::zeros);
+  opt.Optimize(objectives, coords);
+
+  REQUIRE(std::get<0>(objectives).evaluations == 7 * (30 + 1));
+  REQUIRE(opt.Front().size() > 0);
+  for (const arma::mat& solution : opt.Front())
+  {
+    REQUIRE(solution(0) >= -1.0);
+    REQUIRE(solution(0) <= 3.0);
+  }
+}
+
+/**
+ * Optimize for the Fonseca Fleming function using NSGA-II optimizer, evaluating
+ * the objectives in parallel.
+ */
+TEST_CASE("NSGA2ParallelEvaluationFonsecaFlemingTest", "[NSGA2Test]")
+{
+  FonsecaFlemingFunction<arma::mat> FON;
+  const double lowerBound = -4;
+  const double upperBound = 4;
+  const double tolerance = 1e-6;
+  const double strength = 1e-4;
+  const double expectedLowerBound = -1.0 / sqrt(3);
+  const double expectedUpperBound = 1.0 / sqrt(3);
+
+  NSGA2 opt(20, 4000, 0.6, 0.3, strength, tolerance, lowerBound, upperBound);
+  opt.ParallelEvaluation() = true;
+
+  typedef decltype(FON.objectiveA) ObjectiveTypeA;
+  typedef decltype(FON.objectiveB) ObjectiveTypeB;
+
+  arma::mat coords = FON.GetInitialPoint();
+  std::tuple<ObjectiveTypeA, ObjectiveTypeB> objectives = FON.GetObjectives();
+
+  opt.Optimize(objectives, coords);
+  std::vector<arma::mat> bestFront = opt.Front();
+
+  bool allInRange = true;
+  for (size_t i = 0; i < bestFront.size(); i++)
+  {
+    const arma::mat solution = bestFront[i];
+    if (!IsInBounds(solution(0), expectedLowerBound, expectedUpperBound) ||
+        !IsInBounds(solution(1), expectedLowerBound, expectedUpperBound) ||
+        !IsInBounds(solution(2), expectedLowerBound, expectedUpperBound))
+    {
+      allInRange = false;
+      break;
+    }
+  }
+
+  REQUIRE(allInRange);
+}
+
+/**
+ * Make sure that the ParetoArchive keeps exactly the non-dominated candidates
+ * of those inserted, compared to a brute force update.
+ */
+TEST_CASE("ParetoArchiveTest", "[NSGA2Test]")
+{
+  for (size_t numObjectives = 2; numObjectives <= 4; ++numObjectives)
+  {
+    ParetoArchive archive(4);
+    std::vector<arma::vec> expected;
+    for (size_t i = 0; i < 500; ++i)
+    {
+      // Round some of the objectives, so that there are ties.
+      arma::vec y(numObjectives, arma::fill::randu);
+      if (i % 2 == 0)
+        y = arma::round(10 * y) / 10;
+
+      bool dominated = false;
+      for (const arma::vec& z : expected)
+        dominated |= arma::all(z <= y);
+
+      arma::mat coordinates(1, 1);
+      coordinates(0) = i;
+      const bool added = archive.Insert(coordinates, y);
+      REQUIRE(added == !dominated);
+      if (!dominated)
+      {
+        std::vector<arma::vec> kept;
+        for (const arma::vec& z : expected)
+        {
+          if (!(arma::all(y <= z) && arma::any(y < z)))
+            kept.push_back(z);
+        }
+        kept.push_back(y);
+        expected.swap(kept);
+      }
+      REQUIRE(archive.Size() == expected.size());
+    }
+
+    std::vector<arma::mat> coordinates;
+    arma::mat objectives;
+    archive.Front(coordinates, objectives);
+    REQUIRE(coordinates.size() == expected.size());
+    REQUIRE(objectives.n_cols == expected.size());
+    for (const arma::vec& z : expected)
+    {
+      bool found = false;
+      for (size_t j = 0; j < objectives.n_cols; ++j)
+        found |= arma::approx_equal(objectives.col(j), z, "absdiff", 0.0);
+      REQUIRE(found);
+    }
+  }
+}
+
+/**
+ * Make sure that with the archive, the best front of NSGA2 is the front of all
+ * evaluated candidates: mutually non-dominated, and at least as large as the
+ * front of the final population.
+ */
+TEST_CASE("NSGA2ArchiveTest", "[NSGA2Test]")
+{
+  SchafferFunctionN1<arma::mat> SCH;
+  NSGA2 opt(20, 200, 0.5, 0.5, 1e-3, 1e-6, -1000.0, 1000.0);
+  opt.UseArchive() = true;
+
+  typedef decltype(SCH.objectiveA) ObjectiveTypeA;
+  typedef decltype(SCH.objectiveB) ObjectiveTypeB;
+
+  arma::mat coords = SCH.GetInitialPoint();
+  std::tuple<ObjectiveTypeA, ObjectiveTypeB> objectives = SCH.GetObjectives();
+  const double performance = opt.Optimize(objectives, coords);
+
+  const std::vector<arma::mat>& bestFront = opt.Front();
+  REQUIRE(bestFront.size() == opt.Archive().Size());
+  REQUIRE(bestFront.size() >= 10);
+  for (size_t i = 0; i < bestFront.size(); ++i)
+  {
+    const double x = arma::as_scalar(bestFront[i]);
+    REQUIRE(x >= -0.1);
+    REQUIRE(x <= 2.1);
+  }
+
+  const double x = arma::as_scalar(coords);
+  REQUIRE(performance == Approx(x * x + (x - 2) * (x - 2)).epsilon(1e-10));
+}
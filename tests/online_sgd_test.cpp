@@ -0,0 +1,162 @@
+/**
+ * @file online_sgd_test.cpp
+ *
+ * Test file for OnlineSGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A stream of points x_p = (sin(0.37 p), cos(0.91 p) + 0.5) with the responses
+ * y_p = 2 x_p(0) - x_p(1), and the squared loss of a linear model.  Each batch
+ * is generated by PrepareBatch() into one of two buffers, so that the next
+ * batch can be prepared while the current one is used; a batch that is used
+ * without having been prepared is counted.
+ */
+class LinearStreamFunction
+{
+ public:
+  LinearStreamFunction(const size_t size, const size_t stride) :
+      size(size),
+      stride(stride),
+      unprepared(0),
+      prepareCalls(0)
+  {
+    begins[0] = begins[1] = size;
+  }
+
+  size_t Available(const size_t begin, const size_t batchSize) const
+  {
+    return (begin >= size) ? 0 : std::min(batchSize, size - begin);
+  }
+
+  void PrepareBatch(const size_t begin, const size_t batchSize)
+  {
+    const size_t slot = (begin / stride) % 2;
+    const size_t points = Available(begin, batchSize);
+    data[slot].set_size(2, points);
+    for (size_t i = 0; i < points; ++i)
+    {
+      data[slot](0, i) = std::sin(0.37 * (begin + i));
+      data[slot](1, i) = std::cos(0.91 * (begin + i)) + 0.5;
+    }
+    responses[slot] = 2.0 * data[slot].row(0) - data[slot].row(1);
+    begins[slot] = begin;
+    ++prepareCalls;
+  }
+
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              const size_t begin,
+                              arma::mat& gradient,
+                              const size_t batchSize)
+  {
+    const size_t slot = (begin / stride) % 2;
+    if (begins[slot] != begin || data[slot].n_cols < batchSize)
+    {
+      ++unprepared;
+      PrepareBatch(begin, batchSize);
+    }
+
+    const arma::rowvec residuals = coordinates.t() *
+        data[slot].head_cols(batchSize) -
+        responses[slot].head_cols(batchSize);
+    gradient = data[slot].head_cols(batchSize) * residuals.t();
+    return 0.5 * arma::dot(residuals, residuals);
+  }
+
+  size_t Unprepared() const { return unprepared; }
+  size_t PrepareCalls() const { return prepareCalls; }
+
+ private:
+  size_t size;
+  size_t stride;
+  arma::mat data[2];
+  arma::rowvec responses[2];
+  size_t begins[2];
+  size_t unprepared;
+  size_t prepareCalls;
+};
+
+/**
+ * Run OnlineSGD to the end of a stream, and make sure that it finds the linear
+ * model and that every batch was prefetched.
+ */
+TEST_CASE("OnlineSGDLinearStreamTest", "[OnlineSGDTest]")
+{
+  LinearStreamFunction f(20000, 10);
+  OnlineSGD<> s(0.05, 10);
+
+  arma::mat coordinates(2, 1, arma::fill::zeros);
+  const double objective = s.Optimize(f, coordinates);
+
+  REQUIRE(coordinates(0) == Approx(2.0).margin(1e-3));
+  REQUIRE(coordinates(1) == Approx(-1.0).margin(1e-3));
+  REQUIRE(objective < 1e-6);
+  REQUIRE(s.Position() == 20000);
+  // 2000 batches, in windows of 100 batches.
+  REQUIRE(s.Windows() == 20);
+  REQUIRE(f.Unprepared() == 0);
+  REQUIRE(f.PrepareCalls() > 0);
+}
+
+/**
+ * On a stream without an end, the optimization terminates once the windowed
+ * objective doesn't change any more.
+ */
+TEST_CASE("OnlineSGDWindowToleranceTest", "[OnlineSGDTest]")
+{
+  LinearStreamFunction f(std::numeric_limits<size_t>::max(), 10);
+  OnlineSGD<> s(0.05, 10, 0, 20, 1e-10);
+
+  arma::mat coordinates(2, 1, arma::fill::zeros);
+  s.Optimize(f, coordinates);
+
+  REQUIRE(s.Position() < 1000000);
+  REQUIRE(s.WindowObjective() < 1e-8);
+  REQUIRE(coordinates(0) == Approx(2.0).margin(1e-3));
+  REQUIRE(coordinates(1) == Approx(-1.0).margin(1e-3));
+}
+
+/**
+ * A trainer that is restarted from a checkpoint continues the stream where the
+ * checkpoint was saved, exactly like an uninterrupted one.
+ */
+TEST_CASE("OnlineSGDCheckpointResumeTest", "[OnlineSGDTest]")
+{
+  const std::string filename = "online_sgd_checkpoint_test.bin";
+
+  LinearStreamFunction fullStream(4000, 10);
+  OnlineSGD<AdamUpdate> full(0.01, 10, 0, 10);
+  arma::mat fullCoordinates(2, 1, arma::fill::zeros);
+  full.Optimize(fullStream, fullCoordinates);
+
+  // The first process stops after 200 batches, at the end of a window.
+  LinearStreamFunction firstStream(4000, 10);
+  OnlineSGD<AdamUpdate> first(0.01, 10, 2000, 10);
+  arma::mat coordinates(2, 1, arma::fill::zeros);
+  first.Optimize(firstStream, coordinates, Checkpoint(filename));
+  REQUIRE(first.Position() == 2000);
+
+  LinearStreamFunction secondStream(4000, 10);
+  OnlineSGD<AdamUpdate> second(0.01, 10, 0, 10);
+  arma::mat resumedCoordinates;
+  Checkpoint::Load(filename, second, resumedCoordinates);
+  REQUIRE(second.Position() == 2000);
+  REQUIRE(second.Windows() == 20);
+  second.Optimize(secondStream, resumedCoordinates);
+  std::remove(filename.c_str());
+
+  REQUIRE(second.Position() == 4000);
+  REQUIRE(arma::approx_equal(resumedCoordinates, fullCoordinates, "absdiff",
+      1e-12));
+}
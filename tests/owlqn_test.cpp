@@ -0,0 +1,96 @@
+/**
+ * @file owlqn_test.cpp
+ *
+ * Test file for the OWL-QN optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * f(x) = 0.5 |x - c|^2, so that the minimum of f(x) + lambda |x|_1 is the
+ * soft-thresholded c.
+ */
+class ShiftedQuadraticFunction
+{
+ public:
+  ShiftedQuadraticFunction(const arma::vec& c) : c(c) { }
+
+  double EvaluateWithGradient(const arma::mat& x, arma::mat& gradient) const
+  {
+    gradient = x - c;
+    return 0.5 * arma::dot(gradient, gradient);
+  }
+
+ private:
+  arma::vec c;
+};
+
+/**
+ * Check that OWL-QN finds the soft-thresholded solution, with exact zeros.
+ */
+TEST_CASE("OWLQNSoftThresholdTest", "[OWLQNTest]")
+{
+  const arma::vec c("3.0 -2.0 0.5 -0.25 1.5 0.0 -4.0 0.9");
+  ShiftedQuadraticFunction f(c);
+
+  OWLQN owlqn(1.0);
+  arma::mat coordinates(c.n_elem, 1, arma::fill::randn);
+  const double objective = owlqn.Optimize(f, coordinates);
+
+  double expectedObjective = 0.0;
+  for (size_t i = 0; i < c.n_elem; ++i)
+  {
+    const double expected = (std::abs(c(i)) > 1.0) ?
+        c(i) - ((c(i) > 0) ? 1.0 : -1.0) : 0.0;
+    if (expected == 0.0)
+      REQUIRE(coordinates(i) == 0.0);
+    else
+      REQUIRE(coordinates(i) == Approx(expected).epsilon(1e-5));
+
+    expectedObjective += 0.5 * std::pow(expected - c(i), 2.0) +
+        std::abs(expected);
+  }
+
+  REQUIRE(objective == Approx(expectedObjective).epsilon(1e-5));
+}
+
+/**
+ * Train an L1-regularized logistic regression model on data with irrelevant
+ * dimensions, and check that their weights are exactly zero.
+ */
+TEST_CASE("OWLQNSparseLogisticRegressionTest", "[OWLQNTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData, responses,
+      testResponses, shuffledResponses);
+
+  // Append seven dimensions of noise.
+  data = arma::join_cols(data, arma::randn(7, data.n_cols));
+  testData = arma::join_cols(testData, arma::randn(7, testData.n_cols));
+
+  LogisticRegressionFunction<> lr(data, responses);
+  arma::mat coordinates = lr.GetInitialPoint();
+
+  OWLQN owlqn(10.0);
+  owlqn.Optimize(lr, coordinates);
+
+  // The first element is the intercept.
+  for (size_t i = 4; i < coordinates.n_elem; ++i)
+    REQUIRE(coordinates(i) == 0.0);
+
+  REQUIRE(lr.ComputeAccuracy(data, responses, coordinates) ==
+      Approx(100.0).epsilon(0.003));
+  REQUIRE(lr.ComputeAccuracy(testData, testResponses, coordinates) ==
+      Approx(100.0).epsilon(0.006));
+}
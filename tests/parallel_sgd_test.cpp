@@ -20,6 +20,46 @@ using namespace arma;
 using namespace ens;
 using namespace ens::test;
 
+/**
+ * Make sure that ConflictGraph finds the connected components of the conflict
+ * graph, and that the batches of different threads never conflict.
+ */
+TEST_CASE("ConflictGraphTest", "[ParallelSGDTest]")
+{
+  // Batches 0, 2 and 3 share elements (0-2 through element 5, 2-3 through
+  // element 7); batches 1 and 4 are on their own.
+  std::vector<arma::uvec> patterns;
+  patterns.push_back(arma::uvec("0 5"));
+  patterns.push_back(arma::uvec("1"));
+  patterns.push_back(arma::uvec("5 7"));
+  patterns.push_back(arma::uvec("7 8"));
+  patterns.push_back(arma::uvec("2 3"));
+
+  ConflictGraph graph;
+  auto pattern = [&](const size_t u, arma::uvec& elements)
+  {
+    elements = patterns[u];
+  };
+  graph.Partition(patterns.size(), 10, 2, pattern);
+
+  REQUIRE(graph.NumComponents() == 3);
+  REQUIRE(graph.LargestComponent() == 3);
+
+  // The largest component goes to the first thread, in order.
+  REQUIRE(graph.Batches(0).size() == 3);
+  REQUIRE(graph.Batches(0)[0] == 0);
+  REQUIRE(graph.Batches(0)[1] == 2);
+  REQUIRE(graph.Batches(0)[2] == 3);
+  REQUIRE(graph.Batches(1).size() == 2);
+
+  // The graph can be reused, and elements outside of the iterate are
+  // rejected.
+  graph.Partition(2, 10, 4, pattern);
+  REQUIRE(graph.NumComponents() == 2);
+  REQUIRE_THROWS_AS(graph.Partition(patterns.size(), 6, 2, pattern),
+      std::invalid_argument);
+}
+
 // These tests are only compiled if OpenMP is used.
 #ifdef ENS_USE_OPENMP
 
@@ -129,6 +169,336 @@ TEST_CASE("ParallelSGDGeneralizedRosenbrockSpMatTest", "[ParallelSGDTest]")
   }
 }
 
+/**
+ * Check that parallel SGD works with arma::sp_mat when the sparsity pattern of
+ * the iterate is fixed.
+ */
+TEST_CASE("ParallelSGDGeneralizedRosenbrockFixedSparsityTest",
+    "[ParallelSGDTest]")
+{
+  // Loop over several variants.
+  for (size_t i = 10; i < 30; i += 5)
+  {
+    // Create the generalized Rosenbrock function.
+    GeneralizedRosenbrockFunction f(i);
+
+    ConstantStep decayPolicy(0.001);
+
+    ParallelSGD<ConstantStep> s(100000, f.NumFunctions(), 1e-12, true,
+        decayPolicy);
+    s.FixedSparsity() = true;
+
+    // All the elements of the initial point are nonzero, so the sparsity
+    // pattern contains the solution.
+    arma::sp_mat coordinates = f.GetInitialPoint<arma::sp_mat>();
+
+    omp_set_num_threads(1);
+    double result = s.Optimize(f, coordinates);
+
+    REQUIRE(result == Approx(0.0).margin(1e-8));
+    for (size_t j = 0; j < i; ++j)
+      REQUIRE(coordinates(j) == Approx(1.0).epsilon(0.0001));
+  }
+}
+
+/**
+ * Make sure that parallel SGD converges when each thread computes gradients of
+ * batches of more than one datapoint.
+ */
+TEST_CASE("ParallelSGDBatchSizeTest", "[ParallelSGDTest]")
+{
+  ConstantStep decayPolicy(0.4);
+
+  SparseTestFunction f;
+  size_t threadsAvailable = omp_get_max_threads();
+  for (size_t i = threadsAvailable; i > 0; --i)
+  {
+    omp_set_num_threads(i);
+
+    // Each thread has to see all the datapoints it is responsible for.
+    size_t threadShareSize = std::ceil((float) f.NumFunctions() / i);
+
+    ParallelSGD<ConstantStep> s(10000, threadShareSize, 1e-5, true,
+        decayPolicy, 2);
+    FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+  }
+}
+
+/**
+ * Make sure that parallel SGD converges with dynamic scheduling, even if the
+ * thread share size would not cover all datapoints.
+ */
+TEST_CASE("ParallelSGDDynamicSchedulingTest", "[ParallelSGDTest]")
+{
+  ConstantStep decayPolicy(0.4);
+
+  SparseTestFunction f;
+  size_t threadsAvailable = omp_get_max_threads();
+  for (size_t i = threadsAvailable; i > 0; --i)
+  {
+    omp_set_num_threads(i);
+
+    ParallelSGD<ConstantStep> s(10000, 1, 1e-5, true, decayPolicy);
+    s.DynamicScheduling() = true;
+    FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+  }
+}
+
+/**
+ * Make sure that parallel SGD converges when its threads are those of an
+ * executor set with SetExecutor(), with static and dynamic scheduling.
+ */
+TEST_CASE("ParallelSGDExecutorTest", "[ParallelSGDTest]")
+{
+  ConstantStep decayPolicy(0.4);
+  SetExecutor(std::make_shared<ThreadPoolExecutor>(4));
+
+  // Each of the four threads gets a quarter of the datapoints.
+  SparseTestFunction f;
+  ParallelSGD<ConstantStep> s(10000, (f.NumFunctions() + 3) / 4, 1e-5, true,
+      decayPolicy);
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+
+  s.DynamicScheduling() = true;
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+
+  SetExecutor(nullptr);
+}
+
+/**
+ * With a deterministic reduction, the result of parallel SGD should not depend
+ * on the number of threads.
+ */
+TEST_CASE("ParallelSGDDeterministicReductionTest", "[ParallelSGDTest]")
+{
+  ConstantStep decayPolicy(0.4);
+
+  SparseTestFunction f;
+  ParallelSGD<ConstantStep> s(10000, 2, 1e-5, true, decayPolicy);
+  s.DeterministicReduction() = true;
+
+  const int threads = omp_get_max_threads();
+  arma::mat coordinates1 = f.GetInitialPoint();
+  omp_set_num_threads(1);
+  arma::arma_rng::set_seed(42);
+  const double objective1 = s.Optimize(f, coordinates1);
+
+  arma::mat coordinates2 = f.GetInitialPoint();
+  omp_set_num_threads(std::max(threads, 2));
+  arma::arma_rng::set_seed(42);
+  const double objective2 = s.Optimize(f, coordinates2);
+  omp_set_num_threads(threads);
+
+  REQUIRE(objective1 == objective2);
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates1[i] == coordinates2[i]);
+
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+}
+
+/**
+ * With conflict scheduling, parallel SGD should give the same result as a
+ * serial visitation, for any number of threads.
+ */
+TEST_CASE("ParallelSGDConflictSchedulingTest", "[ParallelSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+  ParallelSGD<ConstantStep> s(50000, 4, 1e-12, true, ConstantStep(0.001));
+  s.ConflictScheduling() = true;
+
+  const int threads = omp_get_max_threads();
+  arma::mat coordinates1 = f.GetInitialPoint();
+  omp_set_num_threads(1);
+  arma::arma_rng::set_seed(42);
+  const double objective1 = s.Optimize(f, coordinates1);
+
+  arma::mat coordinates2 = f.GetInitialPoint();
+  omp_set_num_threads(std::max(threads, 4));
+  arma::arma_rng::set_seed(42);
+  const double objective2 = s.Optimize(f, coordinates2);
+  omp_set_num_threads(threads);
+
+  REQUIRE(objective1 == objective2);
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates1[i] == coordinates2[i]);
+
+  REQUIRE(objective1 == Approx(0.0).margin(1e-6));
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+}
+
+/**
+ * With the stratified scheduling, parallel SGD should factorize a matrix, and
+ * give the same result for any number of threads.
+ */
+TEST_CASE("ParallelSGDStratifiedSchedulingTest", "[ParallelSGDTest]")
+{
+  MatrixFactorizationFunction f(60, 40, 3, 0.3);
+  ParallelSGD<ConstantStep> s(200, 1, 1e-12, true, ConstantStep(0.02));
+  s.StratifiedScheduling() = true;
+  s.NumStrata() = 4;
+
+  const int threads = omp_get_max_threads();
+  arma::mat coordinates1 = f.GetInitialPoint();
+  omp_set_num_threads(1);
+  arma::arma_rng::set_seed(42);
+  const double objective1 = s.Optimize(f, coordinates1);
+
+  arma::mat coordinates2 = f.GetInitialPoint();
+  omp_set_num_threads(std::max(threads, 4));
+  arma::arma_rng::set_seed(42);
+  const double objective2 = s.Optimize(f, coordinates2);
+  omp_set_num_threads(threads);
+
+  REQUIRE(objective1 == objective2);
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates1[i] == coordinates2[i]);
+
+  REQUIRE(objective1 < 0.1 * f.Evaluate(f.GetInitialPoint()));
+
+  // The blocks cover all the functions.
+  arma::uvec offsets;
+  f.Stratify(3, offsets);
+  REQUIRE(offsets.n_elem == 10);
+  REQUIRE(offsets[9] == f.NumFunctions());
+
+  // Functions without a Stratify() method can't be stratified.
+  GeneralizedRosenbrockFunction g(10);
+  arma::mat coordinates = g.GetInitialPoint();
+  REQUIRE_THROWS_AS(s.Optimize(g, coordinates), std::logic_error);
+}
+
+/**
+ * With one replica of the iterate per group of threads, averaged every few
+ * iterations, parallel SGD should still converge.
+ */
+TEST_CASE("ParallelSGDReplicasTest", "[ParallelSGDTest]")
+{
+  ConstantStep decayPolicy(0.4);
+
+  ParallelSGD<ConstantStep> s(10000, 4, 1e-10, true, decayPolicy);
+  s.DynamicScheduling() = true;
+  s.Replicas() = 2;
+  s.AveragingInterval() = 3;
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+
+  // More replicas than threads are reduced to one per thread.
+  s.Replicas() = 1000;
+  s.AveragingInterval() = 1;
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+}
+
+/**
+ * Parallel SGD should converge when the convergence is checked on an objective
+ * that is evaluated in parallel on a subsample, and return the exact objective.
+ */
+TEST_CASE("ParallelSGDObjectiveSubsampleTest", "[ParallelSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+  ParallelSGD<ConstantStep> s(100000, f.NumFunctions(), 1e-12, true,
+      ConstantStep(0.001));
+  s.ParallelObjective() = true;
+  s.ObjectiveSubsample() = 5;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double result = s.Optimize(f, coordinates);
+
+  REQUIRE(result == Approx(f.Evaluate(coordinates)).margin(1e-12));
+  REQUIRE(result == Approx(0.0).margin(1e-6));
+  for (size_t j = 0; j < 20; ++j)
+    REQUIRE(coordinates(j) == Approx(1.0).epsilon(0.001));
+
+  // The whole objective can also be evaluated in parallel.
+  ParallelSGD<ConstantStep> s2(10000, 4, 1e-5, true, ConstantStep(0.4));
+  s2.DynamicScheduling() = true;
+  s2.ParallelObjective() = true;
+  FunctionTest<SparseTestFunction>(s2, 0.01, 0.001);
+}
+
+/**
+ * Parallel SGD should also minimize functions whose gradients are row-sparse,
+ * with and without a deterministic reduction.
+ */
+TEST_CASE("ParallelSGDRowSparseGradientTest", "[ParallelSGDTest]")
+{
+  EmbeddingTestFunction f;
+  const size_t threadShareSize = f.NumFunctions() / omp_get_max_threads() + 1;
+  ParallelSGD<ConstantStep> s(1000, threadShareSize, 1e-12, true,
+      ConstantStep(0.1));
+
+  for (size_t deterministic = 0; deterministic < 2; ++deterministic)
+  {
+    s.DeterministicReduction() = (deterministic == 1);
+    arma::mat coordinates = f.GetInitialPoint();
+    const double objective = s.Optimize<EmbeddingTestFunction, arma::mat,
+        RowSparseMat<double>>(f, coordinates);
+
+    REQUIRE(objective == Approx(0.0).margin(1e-6));
+    CheckMatrices(coordinates, f.GetFinalPoint(), 1e-3);
+  }
+}
+
+/**
+ * Make sure that the Gradient() and StepTaken() callbacks are called once for
+ * each step, but never concurrently, and that a callback can terminate the
+ * optimization from the parallel region.
+ */
+TEST_CASE("ParallelSGDCallbackEventsTest", "[ParallelSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+  const size_t threads = std::max(omp_get_max_threads(), 2);
+  omp_set_num_threads(threads);
+
+  // Only flush the buffers at the end of each iteration, and when they hold
+  // two steps.
+  for (size_t bufferSize = 0; bufferSize < 3; bufferSize += 2)
+  {
+    ParallelSGD<ConstantStep> s(101, 1, -1.0, true, ConstantStep(0.0001));
+    s.DynamicScheduling() = true;
+    s.CallbackBufferSize() = bufferSize;
+
+    arma::mat coordinates = f.GetInitialPoint();
+    ParallelCallbackCounter counter;
+    s.Optimize(f, coordinates, counter);
+
+    REQUIRE(counter.steps == 100 * f.NumFunctions());
+    REQUIRE(counter.gradients == counter.steps);
+    REQUIRE(!counter.overlap);
+
+    // The steps of an iteration are finished, but no step of the next
+    // iterations is taken.
+    coordinates = f.GetInitialPoint();
+    ParallelCallbackCounter stopper(3 * f.NumFunctions() + 1);
+    s.Optimize(f, coordinates, stopper);
+
+    REQUIRE(stopper.steps <= 4 * f.NumFunctions());
+    REQUIRE(stopper.steps > 3 * f.NumFunctions());
+    REQUIRE(!stopper.overlap);
+  }
+}
+
+/**
+ * With a deterministic reduction, every batch is processed in each iteration,
+ * and there is one step per round; the Gradient() callbacks are called in
+ * order, outside of the parallel part of the round.
+ */
+TEST_CASE("ParallelSGDDeterministicReductionCallbackTest", "[ParallelSGDTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+  const size_t threads = std::max(omp_get_max_threads(), 2);
+  omp_set_num_threads(threads);
+
+  ParallelSGD<ConstantStep> s(11, 3, -1.0, true, ConstantStep(0.0001));
+  s.DeterministicReduction() = true;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  ParallelCallbackCounter counter;
+  s.Optimize(f, coordinates, counter);
+
+  REQUIRE(counter.gradients == 10 * f.NumFunctions());
+  REQUIRE(counter.steps == 10 * ((f.NumFunctions() + 2) / 3));
+  REQUIRE(!counter.overlap);
+}
+
 #endif
 
 /**
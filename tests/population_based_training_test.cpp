@@ -0,0 +1,71 @@
+/**
+ * @file population_based_training_test.cpp
+ *
+ * Test file for the PopulationBasedTraining meta-optimizer.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * Start SGD with a step size that is much too small, and make sure that the
+ * population finds a larger step size and a better solution than a single
+ * training of the same length.
+ */
+TEST_CASE("PBTStandardSGDStepSizeTest", "[PopulationBasedTrainingTest]")
+{
+  SGDTestFunction f;
+  StandardSGD sgd(1e-5, 1, 3000, -100, false);
+
+  arma::mat sgdCoordinates = f.GetInitialPoint();
+  StandardSGD single(sgd);
+  single.Optimize(f, sgdCoordinates);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  PopulationBasedTraining<StandardSGD> pbt(sgd, 8, 10, 0.25, 3);
+  pbt.Optimize(f, coordinates);
+
+  REQUIRE(pbt.Objectives().n_elem == 8);
+  REQUIRE(pbt.Members().size() == 8);
+  REQUIRE(pbt.Exploits() > 0);
+  REQUIRE(pbt.Members()[pbt.BestMember()].StepSize() > 1e-5);
+  REQUIRE(f.Evaluate(coordinates) < f.Evaluate(sgdCoordinates));
+}
+
+/**
+ * Make sure that training the members of Adam in parallel gives the same
+ * result as training them serially, with the optimizer state copied between
+ * members.
+ */
+TEST_CASE("PBTAdamDeterministicTest", "[PopulationBasedTrainingTest]")
+{
+  SGDTestFunction f;
+  Adam adam(0.01, 1, 0.9, 0.999, 1e-8, 6000, -100, false);
+
+  arma::mat serialCoordinates = f.GetInitialPoint();
+  PopulationBasedTraining<Adam> serial(adam, 4, 100, 0.25, 11, false);
+  const double serialObjective = serial.Optimize(f, serialCoordinates);
+
+  arma::mat parallelCoordinates = f.GetInitialPoint();
+  PopulationBasedTraining<Adam> parallel(adam, 4, 100, 0.25, 11, true);
+  const double parallelObjective = parallel.Optimize(f, parallelCoordinates);
+
+  REQUIRE(serialObjective == parallelObjective);
+  REQUIRE(serial.BestMember() == parallel.BestMember());
+  // 20 rounds of 100 epochs, and one member is replaced after each round but
+  // the last.
+  REQUIRE(serial.Exploits() == 19);
+  REQUIRE(arma::approx_equal(serialCoordinates, parallelCoordinates,
+      "absdiff", 0.0));
+  REQUIRE(f.Evaluate(serialCoordinates) <
+      f.Evaluate(arma::mat(f.GetInitialPoint())));
+}
@@ -0,0 +1,183 @@
+/**
+ * @file proximal_gradient_test.cpp
+ *
+ * Tests for proximal gradient descent, FISTA and proximal SGD.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace arma;
+using namespace ens;
+using namespace ens::test;
+
+// Count the steps taken by an optimizer.
+struct ProximalStepCounter
+{
+  ProximalStepCounter() : steps(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    ++steps;
+    return false;
+  }
+
+  size_t steps;
+};
+
+// Create an ill-conditioned lasso problem 0.5 ||Ax - b||^2 + lambda ||x||_1
+// whose solution is sparse, and return the Lipschitz constant of the gradient.
+inline double LassoProblem(mat& A, vec& b)
+{
+  A = randn<mat>(100, 30);
+  for (size_t j = 0; j < A.n_cols; ++j)
+    A.col(j) *= 0.05 + double(j) / A.n_cols;
+
+  vec x = zeros<vec>(30);
+  x(2) = 1.5;
+  x(10) = -2.0;
+  x(20) = 0.7;
+  b = A * x;
+
+  const double l = norm(A, 2);
+  return l * l;
+}
+
+// Check the optimality conditions of the lasso problem: the gradient is
+// -lambda sign(x_i) where x_i is nonzero, and at most lambda elsewhere.
+inline void CheckLasso(const mat& A,
+                       const vec& b,
+                       const double lambda,
+                       const mat& x)
+{
+  const vec g = A.t() * (A * x - b);
+  for (size_t i = 0; i < x.n_elem; ++i)
+  {
+    if (x(i) > 0.0)
+      REQUIRE(g(i) + lambda == Approx(0.0).margin(1e-3));
+    else if (x(i) < 0.0)
+      REQUIRE(g(i) - lambda == Approx(0.0).margin(1e-3));
+    else
+      REQUIRE(std::abs(g(i)) <= lambda + 1e-3);
+  }
+}
+
+/**
+ * Solve a lasso problem with proximal gradient descent and FISTA, and make
+ * sure that FISTA takes far fewer iterations.
+ */
+TEST_CASE("ProximalGradientLassoTest", "[ProximalGradientTest]")
+{
+  mat A;
+  vec b;
+  const double l = LassoProblem(A, b);
+  FuncSq f(A, b);
+
+  ProximalGradient ista(L1Penalty(0.1), 1.0 / l, 0, 1e-10);
+  ProximalGradient fista(L1Penalty(0.1), 1.0 / l, 0, 1e-10, true);
+
+  mat coordinates = zeros<mat>(30, 1);
+  ProximalStepCounter istaSteps;
+  ista.Optimize(f, coordinates, istaSteps);
+  CheckLasso(A, b, 0.1, coordinates);
+
+  coordinates.zeros();
+  ProximalStepCounter fistaSteps;
+  const double objective = fista.Optimize(f, coordinates, fistaSteps);
+  CheckLasso(A, b, 0.1, coordinates);
+
+  REQUIRE(objective == Approx(f.Evaluate(coordinates) +
+      0.1 * accu(abs(coordinates))).epsilon(1e-10));
+  REQUIRE(2 * fistaSteps.steps < istaSteps.steps);
+}
+
+/**
+ * Make sure that the backtracking line search reduces a step size that is
+ * much too large.
+ */
+TEST_CASE("ProximalGradientBacktrackingTest", "[ProximalGradientTest]")
+{
+  mat A;
+  vec b;
+  LassoProblem(A, b);
+  FuncSq f(A, b);
+
+  ProximalGradient fista(L1Penalty(0.1), 1.0, 0, 1e-10, true, true);
+
+  mat coordinates = zeros<mat>(30, 1);
+  fista.Optimize(f, coordinates);
+  CheckLasso(A, b, 0.1, coordinates);
+}
+
+/**
+ * Minimize the distance to a point over the simplex; the solution is the
+ * projection of the point.
+ */
+TEST_CASE("ProximalGradientSimplexTest", "[ProximalGradientTest]")
+{
+  const vec c = randn<vec>(20);
+  FuncSq f(eye<mat>(20, 20), c);
+
+  ProximalGradientType<SimplexConstraint> s(SimplexConstraint(2.0), 1.0, 0,
+      1e-12, true);
+
+  mat coordinates = zeros<mat>(20, 1);
+  s.Optimize(f, coordinates);
+
+  vec expected = c;
+  Proximal::ProjectToSimplex(expected, 2.0);
+
+  REQUIRE(accu(coordinates) == Approx(2.0).epsilon(1e-10));
+  CheckMatrices(coordinates, mat(expected), 1e-5);
+}
+
+/**
+ * Make sure that the group lasso penalty sets the groups that are not in the
+ * solution exactly to zero.
+ */
+TEST_CASE("ProximalGradientGroupLassoTest", "[ProximalGradientTest]")
+{
+  mat A = randn<mat>(100, 30);
+  vec x = zeros<vec>(30);
+  x.subvec(5, 9) = randn<vec>(5) + 2.0;
+  const vec b = A * x;
+  FuncSq f(A, b);
+
+  std::vector<uvec> groups;
+  for (size_t g = 0; g < 6; ++g)
+    groups.push_back(regspace<uvec>(5 * g, 5 * g + 4));
+
+  const double l = norm(A, 2);
+  ProximalGradientType<GroupLassoPenalty> s(GroupLassoPenalty(1.0, groups),
+      1.0 / (l * l), 0, 1e-12, true);
+
+  mat coordinates = zeros<mat>(30, 1);
+  s.Optimize(f, coordinates);
+
+  for (size_t g = 0; g < 6; ++g)
+  {
+    if (g == 1)
+      REQUIRE(norm(coordinates.rows(5, 9)) > 1.0);
+    else
+      REQUIRE(accu(abs(coordinates.elem(groups[g]))) == 0.0);
+  }
+}
+
+/**
+ * Train logistic regression with proximal SGD and an l1 penalty.
+ */
+TEST_CASE("ProximalSGDLogisticRegressionTest", "[ProximalGradientTest]")
+{
+  ProximalSGD s(0.0003, 32, 5000000, 1e-9, true,
+      ProximalUpdate<>(L1Penalty(0.01)));
+  LogisticRegressionFunctionTest(s, 0.003, 0.006, 3);
+}
@@ -82,3 +82,96 @@ TEST_CASE("ProjectToL0", "[ProximalTest]")
     REQUIRE(distanceNew >= distance);
   }
 }
+
+/**
+ * Project a vector onto the simplex, and check the optimality conditions: the
+ * elements that are kept are shifted by the same threshold, and the others are
+ * below it.
+ */
+TEST_CASE("ProjectToSimplex", "[ProximalTest]")
+{
+  const vec v = randn<vec>(100);
+
+  vec w = v;
+  Proximal::ProjectToSimplex(w, 2.0);
+
+  REQUIRE(accu(w) == Approx(2.0).epsilon(1e-10));
+  REQUIRE(w.min() >= 0.0);
+
+  const uword kept = w.index_max();
+  const double theta = v(kept) - w(kept);
+  for (size_t i = 0; i < v.n_elem; ++i)
+  {
+    if (w(i) > 0.0)
+      REQUIRE(v(i) - w(i) == Approx(theta).epsilon(1e-10));
+    else
+      REQUIRE(v(i) <= theta + 1e-10);
+  }
+}
+
+/**
+ * Check soft thresholding and block soft thresholding on small vectors.
+ */
+TEST_CASE("SoftThreshold", "[ProximalTest]")
+{
+  vec v = { 3.0, -0.5, 0.2, -2.0 };
+  Proximal::SoftThreshold(v, 1.0);
+  REQUIRE(v(0) == Approx(2.0));
+  REQUIRE(v(1) == 0.0);
+  REQUIRE(v(2) == 0.0);
+  REQUIRE(v(3) == Approx(-1.0));
+
+  // The first group has norm 5, and the second norm 0.5.
+  vec w = { 3.0, 4.0, 0.3, 0.4, 7.0 };
+  std::vector<uvec> groups;
+  groups.push_back(uvec({ 0, 1 }));
+  groups.push_back(uvec({ 2, 3 }));
+  Proximal::GroupSoftThreshold(w, 1.0, groups);
+  REQUIRE(w(0) == Approx(2.4));
+  REQUIRE(w(1) == Approx(3.2));
+  REQUIRE(w(2) == 0.0);
+  REQUIRE(w(3) == 0.0);
+  REQUIRE(w(4) == Approx(7.0));
+}
+
+/**
+ * Make sure that the projections give the same results with a workspace that
+ * is reused for vectors of different sizes.
+ */
+TEST_CASE("ProjectionWorkspace", "[ProximalTest]")
+{
+  std::vector<double> workspace;
+  for (size_t n = 200; n >= 50; n -= 50)
+  {
+    const vec v = randn<vec>(n);
+
+    vec expected = v;
+    vec w = v;
+    Proximal::ProjectToL1Ball(expected, 2.0);
+    Proximal::ProjectToL1Ball(w, 2.0, workspace);
+    REQUIRE(accu(abs(w)) == Approx(2.0).epsilon(1e-10));
+    REQUIRE(norm(w - expected, 2) == Approx(0.0).margin(1e-12));
+
+    expected = v;
+    w = v;
+    Proximal::ProjectToL0Ball(expected, 10);
+    Proximal::ProjectToL0Ball(w, 10, workspace);
+    REQUIRE(accu(w != 0) == 10);
+    REQUIRE(norm(w - expected, 2) == Approx(0.0).margin(1e-12));
+  }
+}
+
+/**
+ * Make sure that exactly tau elements are kept when several elements have the
+ * same absolute value.
+ */
+TEST_CASE("ProjectToL0Ties", "[ProximalTest]")
+{
+  vec v = { 1.0, -2.0, 2.0, 0.5, -2.0, 3.0 };
+  Proximal::ProjectToL0Ball(v, 3);
+
+  REQUIRE(accu(v != 0) == 3);
+  REQUIRE(v(5) == 3.0);
+  REQUIRE(v(0) == 0.0);
+  REQUIRE(v(3) == 0.0);
+}
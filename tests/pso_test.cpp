@@ -12,6 +12,7 @@
  */
 #include <ensmallen.hpp>
 #include "catch.hpp"
+#include "test_function_tools.hpp"
 
 using namespace ens;
 using namespace ens::test;
@@ -53,6 +54,24 @@ TEST_CASE("LBestPSOSphereFunctionFMatTest", "[PSOTest]")
     REQUIRE(coords(j) <= 1e-3);
 }
 
+/**
+ * Test the PSO optimizer on the Sphere Function, with the initial positions of
+ * the swarm from Sobol and from Halton samples.
+ */
+TEST_CASE("LBestPSOLowDiscrepancyInitTest", "[PSOTest]")
+{
+  SphereFunction f(4);
+  PSOType<LBestUpdate, SampledInit<SobolSampling>> sobol;
+  arma::mat coords = f.GetInitialPoint<arma::mat>();
+  sobol.Optimize(f, coords);
+  REQUIRE(f.Evaluate(coords) <= 1e-5);
+
+  PSOType<LBestUpdate, SampledInit<HaltonSampling>> halton;
+  coords = f.GetInitialPoint<arma::mat>();
+  halton.Optimize(f, coords);
+  REQUIRE(f.Evaluate(coords) <= 1e-5);
+}
+
 /**
  * Test the PSO optimizer on the Rosenbrock Function.  Use arma::mat.
  */
@@ -392,3 +411,58 @@ TEST_CASE("LBestPSOScafferFunctionN4Test", "[PSOTest]")
   REQUIRE(abs(coordinates(1)) == Approx(1.25313).margin(0.1));
 }
 */
+
+/**
+ * Make sure that PSO evaluates the swarm with EvaluateBatch() when the function
+ * provides it.
+ */
+TEST_CASE("LBestPSOEvaluateBatchTest", "[PSOTest]")
+{
+  BatchSphereFunction f;
+  LBestPSO s;
+
+  arma::mat coords(4, 1, arma::fill::ones);
+  s.Optimize(f, coords);
+
+  REQUIRE(f.evaluateCalls == 0);
+  REQUIRE(f.evaluateBatchCalls > 0);
+  REQUIRE(arma::accu(arma::square(coords)) <= 1e-5);
+}
+
+/**
+ * Test the PSO optimizer with parallel evaluation on the Sphere Function.
+ */
+TEST_CASE("LBestPSOParallelEvaluationTest", "[PSOTest]")
+{
+  SphereFunction f(4);
+  LBestPSO s;
+  s.ParallelEvaluation() = true;
+
+  arma::mat coords = f.GetInitialPoint<arma::mat>();
+  if (!s.Optimize(f, coords))
+    FAIL("LBest PSO optimization reported failure for Sphere Function.");
+
+  double finalValue = f.Evaluate(coords);
+  REQUIRE(finalValue <= 1e-5);
+  for (size_t j = 0; j < 4; ++j)
+    REQUIRE(coords(j) <= 1e-3);
+}
+
+/**
+ * Test the steady-state PSO optimizer, whose particles are evaluated
+ * asynchronously, on the Sphere Function.
+ */
+TEST_CASE("LBestPSOAsyncEvaluationTest", "[PSOTest]")
+{
+  SphereFunction f(4);
+  LBestPSO s;
+  s.AsyncEvaluation() = true;
+
+  arma::mat coords = f.GetInitialPoint<arma::mat>();
+  s.Optimize(f, coords);
+
+  double finalValue = f.Evaluate(coords);
+  REQUIRE(finalValue <= 1e-5);
+  for (size_t j = 0; j < 4; ++j)
+    REQUIRE(coords(j) <= 1e-3);
+}
@@ -35,6 +35,31 @@ TEST_CASE("RMSPropLogisticRegressionFMatTest", "[rmsprop]")
   LogisticRegressionFunctionTest<arma::fmat>(optimizer, 0.003, 0.006);
 }
 
+/**
+ * Make sure that splitting the fused update into parallel ranges gives the same
+ * result as the serial update.
+ */
+TEST_CASE("RMSPropFusedUpdateThresholdTest", "[rmsprop]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  RMSProp optimizer(0.01, 32, 0.99, 1e-8, 5000, 1e-9, false);
+
+  arma::mat serialCoordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, serialCoordinates);
+
+  SetFusedUpdateThreshold(1);
+  arma::mat parallelCoordinates = lr.GetInitialPoint();
+  optimizer.Optimize(lr, parallelCoordinates);
+  SetFusedUpdateThreshold(0);
+
+  CheckMatrices(serialCoordinates, parallelCoordinates, 1e-10);
+}
+
 #if ARMA_VERSION_MAJOR > 9 ||\
     (ARMA_VERSION_MAJOR == 9 && ARMA_VERSION_MINOR >= 400)
 
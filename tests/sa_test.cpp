@@ -78,3 +78,116 @@ TEST_CASE("RastrigrinFunctionTest", "[SATest]")
   SA<> sa(schedule, 2000000, 100, 50, 1000, 1e-12, 2, 2.0, 0.5, 0.1);
   FunctionTest<RastriginFunction>(sa, 0.01, 0.001, 4);
 }
+
+/**
+ * The Rastrigin function with parallel tempering; the hot chains should help
+ * the coldest one to escape from local minima.
+ */
+TEST_CASE("SAParallelTemperingRastriginFunctionTest", "[SATest]")
+{
+  ExponentialSchedule schedule;
+  SA<> sa(schedule, 2000000, 100, 50, 1000, 1e-12, 2, 2.0, 0.5, 0.1);
+  sa.Chains() = 4;
+  sa.TemperatureRatio() = 3.0;
+  sa.SwapInterval() = 200;
+  FunctionTest<RastriginFunction>(sa, 0.01, 0.001, 4);
+}
+
+/**
+ * Make sure that SA updates the energy with EvaluateDelta() when the function
+ * has that method.
+ */
+TEST_CASE("SAEvaluateDeltaTest", "[SATest]")
+{
+  DeltaSphereFunction f;
+  SA<> sa(ExponentialSchedule(), 100000, 1000., 1000, 100, 1e-10, 3, 1.5, 0.5,
+      0.3);
+
+  arma::mat coordinates(5, 1, arma::fill::zeros);
+  const double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(f.evaluateCalls == 1);
+  REQUIRE(f.evaluateDeltaCalls > 0);
+  REQUIRE(result == Approx(arma::accu(arma::square(coordinates - 1.0)))
+      .margin(1e-5));
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * Make sure that SA stops the evaluation of a move once it is known to be
+ * rejected when the function has EvaluateBounded().
+ */
+TEST_CASE("SAEvaluateBoundedTest", "[SATest]")
+{
+  BoundedSphereFunction f(5);
+  SA<> sa(ExponentialSchedule(), 100000, 1000., 1000, 100, 1e-10, 3, 1.5, 0.5,
+      0.3);
+
+  arma::mat coordinates(5, 1, arma::fill::zeros);
+  const double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(f.boundedCalls > 0);
+  REQUIRE(f.boundedTerms < f.n * f.boundedCalls);
+  REQUIRE(result == Approx(arma::accu(arma::square(coordinates - 1.0)))
+      .margin(1e-5));
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+}
+
+/**
+ * A separable function, sum_i (x_i - 1)^2, whose EvaluateDelta() can be called
+ * concurrently.
+ */
+class SeparableSphereFunction
+{
+ public:
+  double Evaluate(const arma::mat& x) const
+  {
+    return arma::accu(arma::square(x - 1.0));
+  }
+
+  double EvaluateDelta(const arma::mat& x,
+                       const size_t index,
+                       const double newValue) const
+  {
+    return std::pow(newValue - 1.0, 2.0) - std::pow(x(index) - 1.0, 2.0);
+  }
+};
+
+/**
+ * Make sure that batched sweeps converge, and that evaluating the moves of the
+ * sweeps in parallel gives the same result for a separable function.
+ */
+TEST_CASE("SABatchedSweepsTest", "[SATest]")
+{
+  DeltaSphereFunction f;
+  SA<> sa(ExponentialSchedule(), 100000, 1000., 1000, 100, 1e-10, 3, 1.5, 0.5,
+      0.3);
+  sa.BatchedSweeps() = true;
+
+  arma::mat coordinates(7, 1, arma::fill::zeros);
+  const double result = sa.Optimize(f, coordinates);
+
+  REQUIRE(f.evaluateCalls == 1);
+  REQUIRE(f.evaluateDeltaCalls > 0);
+  REQUIRE(result == Approx(arma::accu(arma::square(coordinates - 1.0)))
+      .margin(1e-5));
+  REQUIRE(result == Approx(0.0).margin(1e-3));
+
+  SeparableSphereFunction g;
+  SA<> sequential(ExponentialSchedule(), 100000, 1000., 1000, 100, 1e-10, 3,
+      1.5, 0.5, 0.3);
+  sequential.BatchedSweeps() = true;
+  SA<> separable(sequential);
+  separable.SeparableSweeps() = true;
+
+  arma::mat x1(7, 1, arma::fill::zeros);
+  arma::mat x2(7, 1, arma::fill::zeros);
+  arma::arma_rng::set_seed(42);
+  const double result1 = sequential.Optimize(g, x1);
+  arma::arma_rng::set_seed(42);
+  const double result2 = separable.Optimize(g, x2);
+
+  REQUIRE(result2 == Approx(result1).margin(1e-12));
+  for (size_t i = 0; i < x1.n_elem; ++i)
+    REQUIRE(x2(i) == Approx(x1(i)).margin(1e-12));
+}
@@ -0,0 +1,103 @@
+/**
+ * @file saga_test.cpp
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A separable logistic regression function that only provides the separable
+ * Evaluate() and Gradient(), so that SAGA has to store full gradients.
+ */
+class SeparableLogisticRegression
+{
+ public:
+  SeparableLogisticRegression(LogisticRegressionFunction<>& lrf) : lrf(lrf) { }
+
+  size_t NumFunctions() const { return lrf.NumFunctions(); }
+
+  void Shuffle() { lrf.Shuffle(); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return lrf.Evaluate(coordinates, begin, batchSize);
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    lrf.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+ private:
+  LogisticRegressionFunction<>& lrf;
+};
+
+/**
+ * Run SAGA on logistic regression and make sure the results are acceptable.
+ * Only one derivative per point is stored.
+ */
+TEST_CASE("SAGALogisticRegressionTest", "[SAGATest]")
+{
+  static_assert(traits::HasLinearGradientSignature<
+      LogisticRegressionFunction<>, arma::mat, arma::mat>::value,
+      "LogisticRegressionFunction should implement the linear-model API");
+
+  // Run SAGA with a couple of batch sizes.
+  for (size_t batchSize = 30; batchSize < 45; batchSize += 5)
+  {
+    SAGA optimizer(0.005, batchSize, 300000, 1e-5, true);
+    LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+  }
+}
+
+/**
+ * Run SAGA on logistic regression with arma::fmat and make sure the results
+ * are acceptable.
+ */
+TEST_CASE("SAGALogisticRegressionFMatTest", "[SAGATest]")
+{
+  SAGA optimizer(0.005, 32, 300000, 1e-5, true);
+  LogisticRegressionFunctionTest<arma::fmat>(optimizer, 0.015, 0.015);
+}
+
+/**
+ * Run SAGA on a function without the linear-model API, so that the gradient of
+ * each batch is stored, and make sure the results are acceptable.
+ */
+TEST_CASE("SAGASeparableFunctionTest", "[SAGATest]")
+{
+  static_assert(!traits::HasLinearGradientSignature<
+      SeparableLogisticRegression, arma::mat, arma::mat>::value,
+      "SeparableLogisticRegression should not implement the linear-model API");
+
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegressionFunction<> lrf(shuffledData, shuffledResponses, 0.5);
+  SeparableLogisticRegression f(lrf);
+
+  arma::mat coordinates = lrf.GetInitialPoint();
+  SAGA optimizer(0.005, 32, 300000, 1e-5, true);
+  optimizer.Optimize(f, coordinates);
+
+  // Ensure that the predictions are good.
+  REQUIRE(lrf.ComputeAccuracy(data, responses, coordinates) ==
+      Approx(100.0).epsilon(0.015));
+  REQUIRE(lrf.ComputeAccuracy(testData, testResponses, coordinates) ==
+      Approx(100.0).epsilon(0.015));
+}
@@ -0,0 +1,107 @@
+/**
+ * @file sampling_test.cpp
+ *
+ * Test the sampling policies of the initial populations.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+
+/**
+ * Make sure that every coordinate of the given points has exactly one point in
+ * each of the n_cols intervals of equal width of [0, 1).
+ */
+inline void CheckStratified(const arma::mat& points)
+{
+  const size_t n = points.n_cols;
+  for (size_t d = 0; d < points.n_rows; ++d)
+  {
+    arma::uvec counts(n, arma::fill::zeros);
+    for (size_t j = 0; j < n; ++j)
+    {
+      REQUIRE(points(d, j) >= 0.0);
+      REQUIRE(points(d, j) < 1.0);
+      ++counts(std::min((size_t) (points(d, j) * n), n - 1));
+    }
+    REQUIRE(counts.min() == 1);
+  }
+}
+
+/**
+ * The first 2^k digitally shifted Sobol points are stratified in every
+ * coordinate, also for coordinates beyond the table of direction numbers.
+ */
+TEST_CASE("SobolSamplingStratificationTest", "[SamplingTest]")
+{
+  RandomStream rng(42);
+  arma::mat points(40, 256);
+  SobolSampling().Fill(points, rng);
+  CheckStratified(points);
+
+  // Two coordinates are not the same up to the shift.
+  arma::mat a = points.row(1) - points.row(2);
+  REQUIRE(arma::stddev(arma::vectorise(a)) > 0.1);
+}
+
+/**
+ * Latin hypercube samples are stratified in every coordinate for any number of
+ * points.
+ */
+TEST_CASE("LatinHypercubeSamplingStratificationTest", "[SamplingTest]")
+{
+  RandomStream rng(7);
+  arma::mat points(7, 50);
+  LatinHypercubeSampling().Fill(points, rng);
+  CheckStratified(points);
+}
+
+/**
+ * The first b^k randomly shifted Halton points of the coordinate with base b
+ * (without skipping the origin) are evenly spaced on the circle [0, 1).
+ */
+TEST_CASE("HaltonSamplingSpacingTest", "[SamplingTest]")
+{
+  RandomStream rng(3);
+  const size_t counts[2] = { 64, 81 };
+  for (size_t d = 0; d < 2; ++d)
+  {
+    arma::mat points(2, counts[d]);
+    HaltonSampling(0).Fill(points, rng);
+
+    const arma::vec x = arma::sort(arma::vec(points.row(d).t()));
+    const double spacing = 1.0 / counts[d];
+    for (size_t j = 1; j < x.n_elem; ++j)
+      REQUIRE(x(j) - x(j - 1) == Approx(spacing).epsilon(1e-9));
+    REQUIRE(1.0 - x(x.n_elem - 1) + x(0) == Approx(spacing).epsilon(1e-9));
+  }
+}
+
+/**
+ * Check the normal quantile function, and that normal Latin hypercube samples
+ * have nearly the moments of the standard normal distribution.
+ */
+TEST_CASE("NormalQuantileTest", "[SamplingTest]")
+{
+  REQUIRE(NormalQuantile(0.5) == Approx(0.0).margin(1e-9));
+  REQUIRE(NormalQuantile(0.975) == Approx(1.959963984540054).epsilon(1e-8));
+  REQUIRE(NormalQuantile(0.01) == Approx(-2.326347874040841).epsilon(1e-8));
+  REQUIRE(NormalQuantile(0.999) == Approx(3.090232306167814).epsilon(1e-8));
+  REQUIRE(std::isfinite(NormalQuantile(0.0)));
+  REQUIRE(std::isfinite(NormalQuantile(1.0f)));
+
+  RandomStream rng(11);
+  arma::mat points(3, 1000);
+  LatinHypercubeSampling().FillNormal(points, rng);
+  for (size_t d = 0; d < points.n_rows; ++d)
+  {
+    const arma::rowvec x = points.row(d);
+    REQUIRE(arma::mean(x) == Approx(0.0).margin(0.01));
+    REQUIRE(arma::var(x) == Approx(1.0).epsilon(0.05));
+  }
+}
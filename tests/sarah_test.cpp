@@ -44,6 +44,60 @@ TEST_CASE("SARAHPlusLogisticRegressionTest","[SARAHTest]")
   }
 }
 
+/**
+ * Run SARAH with parallel chains on logistic regression and make sure the
+ * results are acceptable.
+ */
+TEST_CASE("SARAHParallelChainsLogisticRegressionTest","[SARAHTest]")
+{
+  SARAH optimizer(0.01, 40, 250, 0, 1e-5, true);
+  optimizer.ParallelChains() = true;
+  LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+}
+
+/**
+ * Make sure that the Gradient() and StepTaken() callbacks of the parallel
+ * chains are called once for each step, but never concurrently, and that a
+ * callback stops all the chains.
+ */
+TEST_CASE("SARAHParallelChainsCallbackTest", "[SARAHTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+  SetExecutor(std::make_shared<ThreadPoolExecutor>(4));
+
+  // Only replay the steps after the chains join, and when a chain holds two.
+  for (size_t bufferSize = 0; bufferSize < 3; bufferSize += 2)
+  {
+    SARAH optimizer(0.0001, 1, 5, 0, -1.0, true);
+    optimizer.ParallelChains() = true;
+    optimizer.CallbackBufferSize() = bufferSize;
+
+    arma::mat coordinates = f.GetInitialPoint();
+    ParallelCallbackCounter counter;
+    optimizer.Optimize(f, coordinates, counter);
+
+    // Each function is a batch of the full gradient and a step.
+    REQUIRE(counter.steps == 5 * f.NumFunctions());
+    REQUIRE(counter.gradients == 2 * counter.steps);
+    REQUIRE(!counter.overlap);
+  }
+
+  // Each of the four chains can finish a step and hold one more step once the
+  // termination is requested, but the second inner loop is not finished.
+  SARAH optimizer(0.0001, 1, 5, 0, -1.0, true);
+  optimizer.ParallelChains() = true;
+  optimizer.CallbackBufferSize() = 2;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  ParallelCallbackCounter stopper(f.NumFunctions() + 1);
+  optimizer.Optimize(f, coordinates, stopper);
+  SetExecutor(nullptr);
+
+  REQUIRE(stopper.steps > f.NumFunctions());
+  REQUIRE(stopper.steps <= f.NumFunctions() + 9);
+  REQUIRE(!stopper.overlap);
+}
+
 /**
  * Run SARAH on logistic regression and make sure the results are
  * acceptable.  Use arma::fmat.
@@ -104,3 +158,18 @@ TEST_CASE("SARAHPlusLogisticRegressionSpMatTest","[SARAHTest]")
 }
 
 #endif
+
+/**
+ * Run SARAH on logistic regression with the full gradient computed in
+ * parallel, with and without a deterministic reduction.
+ */
+TEST_CASE("SARAHParallelFullGradientLogisticRegressionTest","[SARAHTest]")
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    SARAH optimizer(0.01, 40, 250, 0, 1e-5, true);
+    optimizer.ParallelFullGradient() = true;
+    optimizer.DeterministicReduction() = (i == 1);
+    LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+  }
+}
@@ -76,6 +76,42 @@ TEST_CASE("DisjointFeatureSpMatTest", "[SCDTest]")
   FunctionTest<SparseTestFunction, arma::sp_mat>(s, 0.01, 0.001);
 }
 
+/**
+ * Test the parallel (Shotgun) mode of SCD on the sparse test function, whose
+ * features are disjoint, so all coordinates can be updated at the same time.
+ */
+TEST_CASE("ParallelCoordinatesDisjointFeatureTest", "[SCDTest]")
+{
+  SCD<> s(0.4);
+  s.ParallelCoordinates() = 4;
+  FunctionTest<SparseTestFunction>(s, 0.01, 0.001);
+
+  SCD<CyclicDescent> cyclic(0.4);
+  cyclic.ParallelCoordinates() = 3;
+  FunctionTest<SparseTestFunction>(cyclic, 0.01, 0.001);
+}
+
+/**
+ * Make sure that ShotgunCoordinates() allows all coordinates to be updated for
+ * uncorrelated features, and only one for identical features.
+ */
+TEST_CASE("ShotgunCoordinatesTest", "[SCDTest]")
+{
+  arma::mat uncorrelated(10, 20, arma::fill::zeros);
+  for (size_t i = 0; i < 10; ++i)
+  {
+    uncorrelated(i, 2 * i) = 1.0 + i;
+    uncorrelated(i, 2 * i + 1) = -2.0;
+  }
+  REQUIRE(ShotgunCoordinates(uncorrelated) == 10);
+
+  arma::mat identical(10, 20);
+  identical.each_row() = arma::randu<arma::rowvec>(20) + 0.1;
+  REQUIRE(ShotgunCoordinates(identical) == 1);
+
+  REQUIRE(ShotgunCoordinates(arma::sp_mat(uncorrelated)) == 10);
+}
+
 /**
  * Test the greedy descent policy.
  */
@@ -102,6 +138,47 @@ TEST_CASE("GreedyDescentTest", "[SCDTest]")
                                        arma::mat>(0, point, f) == 1);
 }
 
+/**
+ * Make sure that the heap-based greedy descent policy, used for functions with
+ * AffectedFeatures(), selects the same features as the full search.
+ */
+TEST_CASE("GreedyDescentAffectedFeaturesTest", "[SCDTest]")
+{
+  // SparseTestFunction without AffectedFeatures().
+  struct FullSearchFunction
+  {
+    size_t NumFeatures() const { return f.NumFeatures(); }
+
+    void PartialGradient(const arma::mat& coordinates,
+                         const size_t j,
+                         arma::mat& gradient) const
+    {
+      f.PartialGradient(coordinates, j, gradient);
+    }
+
+    SparseTestFunction f;
+  };
+
+  SparseTestFunction f;
+  FullSearchFunction g;
+  REQUIRE(traits::HasAffectedFeaturesSignature<SparseTestFunction>::value);
+  REQUIRE(!traits::HasAffectedFeaturesSignature<FullSearchFunction>::value);
+
+  GreedyDescent heapPolicy, fullPolicy;
+  arma::mat point("1 2 3 4;");
+  for (size_t i = 1; i < 30; ++i)
+  {
+    const size_t feature = heapPolicy.DescentFeature<SparseTestFunction,
+        arma::mat, arma::mat>(i, point, f);
+    REQUIRE(feature == fullPolicy.DescentFeature<FullSearchFunction,
+        arma::mat, arma::mat>(i, point, g));
+
+    arma::mat gradient;
+    f.PartialGradient(point, feature, gradient);
+    point -= 0.3 * gradient;
+  }
+}
+
 /**
  * Test the cyclic descent policy.
  */
@@ -178,6 +255,12 @@ TEST_CASE("LogisticRegressionFunctionPartialGradientTest", "[SCDTest]")
     f.PartialGradient(testPoint, i, fGrad);
 
     CheckMatrices(arma::mat(testGradient.col(i)), arma::mat(fGrad.col(i)));
+
+    // The column form must give the same result.
+    arma::vec column;
+    f.PartialGradientColumn(testPoint, i, column);
+
+    CheckMatrices(arma::mat(testGradient.col(i)), arma::mat(column));
   }
 }
 
@@ -219,5 +302,84 @@ TEST_CASE("SoftmaxRegressionFunctionPartialGradientTest", "[SCDTest]")
     srf.PartialGradient(parameters, j, fGrad);
 
     CheckMatrices(arma::mat(gradient.col(j)), arma::mat(fGrad.col(j)));
+
+    // The column form must give the same result.
+    arma::vec column;
+    srf.PartialGradientColumn(parameters, j, column);
+
+    CheckMatrices(arma::mat(gradient.col(j)), arma::mat(column));
+  }
+}
+
+/**
+ * Compute the lasso path of a logistic regression with an unpenalized
+ * intercept, and make sure that every solution is optimal, and that screening
+ * gives the same path with far fewer coordinate updates.
+ */
+TEST_CASE("RegularizationPathLogisticRegressionTest", "[SCDTest]")
+{
+  const size_t dimensionality = 50;
+  arma::mat predictors(dimensionality, 200, arma::fill::randn);
+  arma::rowvec margins = 0.3 + 2.0 * predictors.row(1) -
+      2.0 * predictors.row(5) + 1.5 * predictors.row(10);
+  arma::Row<size_t> responses = arma::conv_to<arma::Row<size_t>>::from(
+      arma::randu<arma::rowvec>(200) < 1.0 / (1.0 + arma::exp(-margins)));
+
+  LogisticRegressionFunction<arma::mat> f(predictors, responses);
+
+  RegularizationPath path(0.01, 20, 0.05, 1.0, 0, 1e-6);
+  path.PenaltyFactors() = arma::ones<arma::vec>(dimensionality + 1);
+  path.PenaltyFactors()(0) = 0.0;
+
+  arma::mat coordinates = arma::zeros<arma::mat>(1, dimensionality + 1);
+  const double objective = path.Optimize(f, coordinates);
+
+  REQUIRE(path.PathLambdas().n_elem == 20);
+  REQUIRE(path.Path().n_slices == 20);
+  REQUIRE(objective == Approx(path.Objectives()(19)));
+  CheckMatrices(coordinates, path.Path().slice(19));
+
+  // The first penalty is the smallest one at which only the intercept is
+  // needed.
+  for (size_t j = 1; j <= dimensionality; ++j)
+    REQUIRE(path.Path().slice(0)(0, j) == Approx(0.0).margin(1e-3));
+
+  // Check the optimality conditions of each solution.
+  for (size_t k = 0; k < 20; ++k)
+  {
+    const double lambda = path.PathLambdas()(k);
+    const arma::mat x = path.Path().slice(k);
+    arma::mat g;
+    f.Gradient(x, g);
+
+    REQUIRE(g(0) == Approx(0.0).margin(1e-2));
+    for (size_t j = 1; j <= dimensionality; ++j)
+    {
+      if (x(0, j) > 0.0)
+        REQUIRE(g(j) + lambda == Approx(0.0).margin(1e-2));
+      else if (x(0, j) < 0.0)
+        REQUIRE(g(j) - lambda == Approx(0.0).margin(1e-2));
+      else
+        REQUIRE(std::abs(g(j)) <= lambda + 1e-2);
+    }
+  }
+
+  // The informative features come first along the path.
+  REQUIRE(path.Path().slice(19)(0, 2) > 0.5);
+  REQUIRE(path.Path().slice(19)(0, 6) < -0.5);
+
+  // Without screening, every update touches all the features.
+  RegularizationPath fullPath(path);
+  fullPath.Screening() = false;
+  coordinates.zeros();
+  fullPath.Optimize(f, coordinates);
+
+  REQUIRE(fullPath.Path().n_slices == 20);
+  for (size_t k = 0; k < 20; ++k)
+  {
+    REQUIRE(arma::abs(fullPath.Path().slice(k) -
+        path.Path().slice(k)).max() < 1e-2);
   }
+  REQUIRE(2 * path.Updates() < fullPath.Updates());
+  REQUIRE(path.ActiveFeatures()(0) < dimensionality / 2);
 }
@@ -312,6 +312,56 @@ TEST_CASE("SmallLovaszThetaSdp", "[SdpPrimalDualTest]")
   CheckKKT(sdp, X, ysparse, ydense, Z);
 }
 
+/**
+ * Solve the Lovasz theta SDP with the iterative KKT solver.
+ */
+TEST_CASE("SmallLovaszThetaSdpKrylov", "[SdpPrimalDualTest]")
+{
+  UndirectedGraph g;
+  UndirectedGraph::LoadFromEdges(g, "data/johnson8-4-4.csv", true);
+  auto sdp = ConstructLovaszThetaSDPFromGraph(g);
+
+  // Every SDP has at least one constraint, so the KKT system is always solved
+  // iteratively.
+  PrimalDualSolver solver(1000, 0.99, 1e-7, 1e-7, 1e-7, 1, 1e-12);
+
+  arma::mat X, Z, ysparse, ydense;
+  sdp.GetInitialPoints(X, ysparse, ydense, Z);
+  solver.Optimize(sdp, X, ysparse, ydense, Z);
+  CheckKKT(sdp, X, ysparse, ydense, Z);
+}
+
+/**
+ * Make sure the Lyapunov equations of the constraints give the same iterates
+ * when they are solved in parallel as when they are solved one after another.
+ */
+TEST_CASE("ParallelLyapunovSolveLovaszThetaSdp", "[SdpPrimalDualTest]")
+{
+  UndirectedGraph g;
+  UndirectedGraph::LoadFromEdges(g, "data/johnson8-4-4.csv", true);
+  auto sdp = ConstructLovaszThetaSDPFromGraph(g);
+  REQUIRE(sdp.NumSparseConstraints() > 4);
+
+  PrimalDualSolver solver(20);
+
+  arma::mat serialX, serialZ, serialYSparse, serialYDense;
+  sdp.GetInitialPoints(serialX, serialYSparse, serialYDense, serialZ);
+  SetExecutor(std::make_shared<SerialExecutor>());
+  const double serialObjective = solver.Optimize(sdp, serialX, serialYSparse,
+      serialYDense, serialZ);
+
+  arma::mat X, Z, ysparse, ydense;
+  sdp.GetInitialPoints(X, ysparse, ydense, Z);
+  SetExecutor(std::make_shared<ThreadPoolExecutor>(4));
+  const double objective = solver.Optimize(sdp, X, ysparse, ydense, Z);
+  SetExecutor(nullptr);
+
+  REQUIRE(objective == Approx(serialObjective).epsilon(1e-10));
+  CheckMatrices(X, serialX, 1e-8);
+  CheckMatrices(Z, serialZ, 1e-8);
+  CheckMatrices(ysparse, serialYSparse, 1e-8);
+}
+
 static inline arma::sp_mat
 RepeatBlockDiag(const arma::sp_mat& block, size_t repeat)
 {
@@ -427,6 +477,269 @@ RandomFullRowRankMatrix(size_t rows, size_t cols)
  *          [       0                  1             t ]
  *
  */
+/**
+ * A max-cut SDP of two disjoint copies of a graph should give the same
+ * solution when it is solved with its block structure.
+ */
+TEST_CASE("BlockDiagonalMaxCutSdp", "[SdpPrimalDualTest]")
+{
+  UndirectedGraph g;
+  UndirectedGraph::ErdosRenyiRandomGraph(g, 8, 0.5, true);
+  arma::sp_mat laplacian;
+  g.Laplacian(laplacian);
+
+  SDP<arma::sp_mat> sdp(16, 16, 0);
+  sdp.C() = -RepeatBlockDiag(laplacian, 2);
+  for (size_t i = 0; i < 16; i++)
+  {
+    sdp.SparseA()[i].zeros(16, 16);
+    sdp.SparseA()[i](i, i) = 1.;
+  }
+  sdp.SparseB().ones();
+
+  PrimalDualSolver solver;
+  arma::mat X, Z, ysparse, ydense;
+  sdp.GetInitialPoints(X, ysparse, ydense, Z);
+  const double objective = solver.Optimize(sdp, X, ysparse, ydense, Z);
+
+  sdp.BlockSizes() = arma::uvec({ 8, 8 });
+  arma::mat blockX, blockZ, blockYsparse, blockYdense;
+  sdp.GetInitialPoints(blockX, blockYsparse, blockYdense, blockZ);
+  const double blockObjective = solver.Optimize(sdp, blockX, blockYsparse,
+      blockYdense, blockZ);
+
+  REQUIRE(CheckKKT(sdp, blockX, blockYsparse, blockYdense, blockZ));
+  REQUIRE(blockObjective == Approx(objective).epsilon(1e-5));
+
+  // The coordinates stay block diagonal.
+  REQUIRE(arma::norm(blockX(arma::span(0, 7), arma::span(8, 15)), "fro") ==
+      Approx(0.0).margin(1e-10));
+}
+
+/**
+ * Blocks of size 1 can be used for nonnegative (LP) variables.  Minimize
+ * x_1 + 2 x_2 + X_33 subject to x_1 + x_2 = 1 and X_33 = 1, with x >= 0.
+ */
+TEST_CASE("DiagonalBlockSdp", "[SdpPrimalDualTest]")
+{
+  SDP<arma::sp_mat> sdp(3, 2, 0);
+  sdp.C().zeros(3, 3);
+  sdp.C()(0, 0) = 1.;
+  sdp.C()(1, 1) = 2.;
+  sdp.C()(2, 2) = 1.;
+  sdp.SparseA()[0](0, 0) = 1.;
+  sdp.SparseA()[0](1, 1) = 1.;
+  sdp.SparseA()[1](2, 2) = 1.;
+  sdp.SparseB().ones();
+  sdp.BlockSizes() = arma::uvec({ 1, 1, 1 });
+
+  PrimalDualSolver solver;
+  arma::mat X, Z, ysparse, ydense;
+  sdp.GetInitialPoints(X, ysparse, ydense, Z);
+  const double objective = solver.Optimize(sdp, X, ysparse, ydense, Z);
+
+  REQUIRE(objective == Approx(2.0).epsilon(1e-5));
+  REQUIRE(X(0, 0) == Approx(1.0).epsilon(1e-5));
+  REQUIRE(X(1, 1) == Approx(0.0).margin(1e-5));
+}
+
+/**
+ * Make sure that the batched kernels over the packed sparse constraints match
+ * the same computations done one constraint at a time.
+ */
+TEST_CASE("PackedSparseConstraints", "[SdpPrimalDualTest]")
+{
+  const size_t n = 15;
+  const size_t numConstraints = 40;
+
+  SDP<arma::sp_mat> sdp(n, numConstraints, 0);
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    // Mix single-entry diagonal constraints with random symmetric ones.
+    if (i % 2 == 0)
+    {
+      sdp.SparseA()[i](i % n, i % n) = 1.0;
+    }
+    else
+    {
+      sdp.SparseA()[i].sprandu(n, n, 0.1);
+      sdp.SparseA()[i] += sdp.SparseA()[i].t();
+    }
+  }
+
+  REQUIRE(!sdp.HasPackedSparseA());
+  sdp.PackSparseConstraints();
+  REQUIRE(sdp.HasPackedSparseA());
+  REQUIRE(sdp.PackedSparseA().n_rows == n * n);
+  REQUIRE(sdp.PackedSparseA().n_cols == numConstraints);
+
+  arma::mat x(n, n, arma::fill::randn);
+  arma::vec values;
+  PackedConstraintValues(values, x, sdp.PackedSparseA());
+  REQUIRE(values.n_elem == numConstraints);
+
+  arma::vec y(numConstraints, arma::fill::randn);
+  arma::mat sum(n, n, arma::fill::zeros), packedSum(n, n, arma::fill::zeros);
+  AddPackedConstraints(packedSum, sdp.PackedSparseA(), y);
+
+  arma::sp_mat rows, svecRows(numConstraints, n * (n + 1) / 2), svec;
+  PackedSvecRows(sdp.PackedSparseA(), n, rows);
+
+  for (size_t i = 0; i < numConstraints; ++i)
+  {
+    REQUIRE(values[i] == Approx(arma::accu(sdp.SparseA()[i] % x)).
+        epsilon(1e-10).margin(1e-12));
+    sum += y[i] * sdp.SparseA()[i];
+    math::Svec(sdp.SparseA()[i], svec);
+    svecRows.row(i) = svec.t();
+  }
+
+  REQUIRE(arma::approx_equal(packedSum, sum, "absdiff", 1e-10));
+  REQUIRE(arma::approx_equal(arma::mat(rows), arma::mat(svecRows), "absdiff",
+      1e-10));
+
+  // Modifying the constraints discards the packed matrix, so that it can't be
+  // used while it is stale.
+  sdp.PackSparseConstraints();
+  REQUIRE(sdp.HasPackedSparseA());
+  sdp.SparseA()[0](0, 0) = 2.0;
+  REQUIRE(!sdp.HasPackedSparseA());
+}
+
+/**
+ * Solve a max-cut SDP of a graph with two interleaved components with and
+ * without detecting the blocks of its aggregate sparsity pattern, and make sure
+ * that the solutions match.
+ */
+TEST_CASE("DetectBlocksMaxCutSdp", "[SdpPrimalDualTest]")
+{
+  const size_t n = 8;
+
+  // Connect the even vertices in a cycle, and the odd vertices in a path.
+  arma::mat laplacian(n, n, arma::fill::zeros);
+  for (size_t i = 0; i + 2 < n; ++i)
+  {
+    laplacian(i, i + 2) = laplacian(i + 2, i) = -1.0;
+    laplacian(i, i) += 1.0;
+    laplacian(i + 2, i + 2) += 1.0;
+  }
+  laplacian(0, n - 2) = laplacian(n - 2, 0) = -1.0;
+  laplacian(0, 0) += 1.0;
+  laplacian(n - 2, n - 2) += 1.0;
+
+  SDP<arma::sp_mat> sdp(n, n, 0);
+  sdp.C() = -arma::sp_mat(laplacian);
+  for (size_t i = 0; i < n; ++i)
+    sdp.SparseA()[i](i, i) = 1.0;
+  sdp.SparseB().ones();
+
+  PrimalDualSolver solver;
+  arma::mat x, z, ySparse, yDense;
+  sdp.GetInitialPoints(x, ySparse, yDense, z);
+  const double objective = solver.Optimize(sdp, x, ySparse, yDense, z);
+
+  solver.DetectBlocks() = true;
+  arma::mat blockX, blockZ, blockYSparse, blockYDense;
+  sdp.GetInitialPoints(blockX, blockYSparse, blockYDense, blockZ);
+  const double blockObjective = solver.Optimize(sdp, blockX, blockYSparse,
+      blockYDense, blockZ);
+
+  REQUIRE(blockObjective == Approx(objective).epsilon(1e-5));
+  REQUIRE(arma::approx_equal(blockX, x, "absdiff", 1e-4));
+  REQUIRE(arma::approx_equal(blockYSparse, ySparse, "absdiff", 1e-4));
+
+  // The even and odd vertices are not coupled.
+  for (size_t i = 0; i < n; i += 2)
+    REQUIRE(blockX(i, i + 1) == Approx(0.0).margin(1e-10));
+}
+
+/**
+ * Load a small SDP in the SDPA format, with a 2 x 2 block and a diagonal block
+ * of size 2, and make sure that the binary form gives the same SDP.
+ */
+TEST_CASE("LoadSDPAFile", "[SdpPrimalDualTest]")
+{
+  {
+    std::ofstream stream("sdpa_test.dat-s");
+    stream << "\"A small test problem.\n"
+           << "* Another comment line.\n"
+           << "2 = m\n"
+           << "2 = nBlocks\n"
+           << "{2, -2}\n"
+           << "{1.5, 2.0}\n"
+           << "0 1 1 1 1.0\n"
+           << "0 1 1 2 -0.5\n"
+           << "0 2 2 2 3.0\n"
+           << "1 1 1 1 1.0\n"
+           << "1 2 1 1 1.0\n"
+           << "2 1 2 2 1.0\n"
+           << "2 1 1 2 0.25\n"
+           << "2 2 2 2 2.0\n";
+  }
+
+  // The constraints are only read through a const reference, since the
+  // non-const SparseA() discards the packed constraints.
+  SDP<arma::sp_mat> sdp;
+  LoadSDPA("sdpa_test.dat-s", sdp);
+  const std::vector<arma::sp_mat>& sparseA =
+      static_cast<const SDP<arma::sp_mat>&>(sdp).SparseA();
+
+  REQUIRE(sdp.N() == 4);
+  REQUIRE(sdp.NumSparseConstraints() == 2);
+  REQUIRE(sdp.NumDenseConstraints() == 0);
+  REQUIRE(sdp.SparseB()[0] == Approx(1.5));
+  REQUIRE(sdp.SparseB()[1] == Approx(2.0));
+  REQUIRE(arma::approx_equal(sdp.BlockSizes(), arma::uvec({ 2, 1, 1 }),
+      "absdiff", 0));
+
+  // C = -F_0, mirrored to the lower triangle.
+  arma::mat c(4, 4, arma::fill::zeros);
+  c(0, 0) = -1.0;
+  c(0, 1) = c(1, 0) = 0.5;
+  c(3, 3) = -3.0;
+  REQUIRE(arma::approx_equal(arma::mat(sdp.C()), c, "absdiff", 1e-15));
+
+  arma::mat a1(4, 4, arma::fill::zeros), a2(4, 4, arma::fill::zeros);
+  a1(0, 0) = 1.0;
+  a1(2, 2) = 1.0;
+  a2(1, 1) = 1.0;
+  a2(0, 1) = a2(1, 0) = 0.25;
+  a2(3, 3) = 2.0;
+  REQUIRE(arma::approx_equal(arma::mat(sparseA[0]), a1, "absdiff",
+      1e-15));
+  REQUIRE(arma::approx_equal(arma::mat(sparseA[1]), a2, "absdiff",
+      1e-15));
+
+  // The constraints are packed while they are loaded.
+  REQUIRE(sdp.HasPackedSparseA());
+  arma::sp_mat packed;
+  PackConstraints(sparseA, sdp.N(), packed);
+  REQUIRE(arma::approx_equal(arma::mat(sdp.PackedSparseA()),
+      arma::mat(packed), "absdiff", 1e-15));
+
+  SaveSDPABinary("sdpa_test.bin", sdp);
+  SDP<arma::sp_mat> binarySDP;
+  LoadSDPA("sdpa_test.bin", binarySDP);
+  const std::vector<arma::sp_mat>& binarySparseA =
+      static_cast<const SDP<arma::sp_mat>&>(binarySDP).SparseA();
+
+  REQUIRE(binarySDP.N() == 4);
+  REQUIRE(arma::approx_equal(binarySDP.BlockSizes(), sdp.BlockSizes(),
+      "absdiff", 0));
+  REQUIRE(arma::approx_equal(binarySDP.SparseB(), sdp.SparseB(), "absdiff",
+      0));
+  REQUIRE(arma::approx_equal(arma::mat(binarySDP.C()), c, "absdiff", 0));
+  for (size_t i = 0; i < 2; ++i)
+  {
+    REQUIRE(arma::approx_equal(arma::mat(binarySparseA[i]),
+        arma::mat(sparseA[i]), "absdiff", 0));
+  }
+  REQUIRE(binarySDP.HasPackedSparseA());
+
+  std::remove("sdpa_test.dat-s");
+  std::remove("sdpa_test.bin");
+}
+
 TEST_CASE("LogChebychevApproxSdp","[SdpPrimalDualTest]")
 {
   // Sometimes, the optimization can fail randomly, so we will run the test
@@ -582,3 +895,39 @@ TEST_CASE("CorrelationCoeffToySdp","[SdpPrimalDualTest]")
   REQUIRE(success == true);
   REQUIRE(obj == Approx(2 * (-0.978)).epsilon(1e-5));
 }
+
+/**
+ * The Lanczos method used for the step lengths should find the largest
+ * eigenvalue of a symmetric matrix given only through products.
+ */
+TEST_CASE("LanczosLargestEigenvalue", "[SdpPrimalDualTest]")
+{
+  arma::mat x = arma::randn<arma::mat>(60, 60);
+  const arma::mat a = x + x.t();
+  auto op = [&](const arma::vec& v, arma::vec& out) { out = a * v; };
+
+  double lambda;
+  REQUIRE(math::LanczosLargestEigenvalue(op, a.n_rows, lambda, 60));
+
+  const arma::vec evals = arma::eig_sym(a);
+  REQUIRE(lambda == Approx(evals(evals.n_elem - 1)).epsilon(1e-6));
+}
+
+/**
+ * The Lanczos method should give the same result every time, since it doesn't
+ * use the random number generator.
+ */
+TEST_CASE("LanczosLargestEigenvalueDeterministic", "[SdpPrimalDualTest]")
+{
+  arma::mat x = arma::randn<arma::mat>(30, 30);
+  const arma::mat a = x * x.t();
+  auto op = [&](const arma::vec& v, arma::vec& out) { out = a * v; };
+
+  double lambda1, lambda2;
+  arma::vec eigvec1, eigvec2;
+  math::LanczosLargestEigenvalue(op, a.n_rows, lambda1, eigvec1, 10, 0.0);
+  math::LanczosLargestEigenvalue(op, a.n_rows, lambda2, eigvec2, 10, 0.0);
+
+  REQUIRE(lambda1 == lambda2);
+  REQUIRE(arma::approx_equal(eigvec1, eigvec2, "absdiff", 0.0));
+}
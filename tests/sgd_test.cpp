@@ -73,3 +73,859 @@ TEST_CASE("GeneralizedRosenbrockTestFloat", "[SGDTest]")
     }
   }
 }
+
+/**
+ * Make sure that SGD with minibatches split across threads still converges on
+ * the logistic regression test problem.
+ */
+TEST_CASE("SGDParallelBatchLogisticRegressionTest", "[SGDTest]")
+{
+  StandardSGD s(0.0003, 256, 2000000, 1e-9, true);
+  s.ParallelBatch() = true;
+  LogisticRegressionFunctionTest(s, 0.003, 0.006, 3);
+}
+
+/**
+ * Run SGD on logistic regression, drawing the points by importance sampling
+ * with weights estimated from the gradient norms.
+ */
+TEST_CASE("SGDImportanceSamplingLogisticRegressionTest", "[SGDTest]")
+{
+  StandardSGD s(0.0003, 32, 2000000, 1e-9, true);
+  s.ImportanceSampling() = true;
+  LogisticRegressionFunctionTest(s, 0.003, 0.006, 3);
+}
+
+/**
+ * With given sampling weights, the points with zero weight are only drawn
+ * through the smoothing; without smoothing, they are never visited.
+ */
+TEST_CASE("SGDImportanceSamplingWeightsTest", "[SGDTest]")
+{
+  // The objective of the generalized Rosenbrock function of 4 dimensions is
+  // the sum of 3 functions; a zero weight on the last function means that the
+  // last coordinate never moves.
+  GeneralizedRosenbrockFunction f(4);
+  StandardSGD s(0.001, 1, 30000, -1, false);
+  s.ImportanceSampling() = true;
+  s.SamplingWeights() = arma::vec("1 1 0");
+  s.SamplingSmoothing() = 0.0;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double last = coordinates(3);
+  s.Optimize(f, coordinates);
+  REQUIRE(coordinates.is_finite());
+  REQUIRE(coordinates(3) == last);
+
+  // The weights must match the number of functions.
+  s.SamplingWeights() = arma::vec("1 1");
+  REQUIRE_THROWS_AS(s.Optimize(f, coordinates), std::invalid_argument);
+}
+
+/**
+ * With a deterministic reduction, the result of a parallel minibatch step
+ * should not depend on the number of threads.
+ */
+TEST_CASE("SGDDeterministicParallelBatchTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData, responses,
+      testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  StandardSGD s(0.0003, 128, 10000, 1e-9, false);
+  s.ParallelBatch() = true;
+  s.DeterministicReduction() = true;
+
+  arma::mat coordinates1 = lr.GetInitialPoint();
+  #ifdef ENS_USE_OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  #endif
+  const double objective1 = s.Optimize(lr, coordinates1);
+
+  arma::mat coordinates2 = lr.GetInitialPoint();
+  #ifdef ENS_USE_OPENMP
+  omp_set_num_threads(std::max(threads, 2));
+  #endif
+  const double objective2 = s.Optimize(lr, coordinates2);
+  #ifdef ENS_USE_OPENMP
+  omp_set_num_threads(threads);
+  #endif
+
+  REQUIRE(objective1 == objective2);
+  for (size_t i = 0; i < coordinates1.n_elem; ++i)
+    REQUIRE(coordinates1[i] == coordinates2[i]);
+}
+
+/**
+ * A simple separable function f_i(x) = (x - c_i)^2 that records whether each
+ * batch was prepared with PrepareBatch() before it was used.
+ */
+class PrepareBatchTestFunction
+{
+ public:
+  PrepareBatchTestFunction() :
+      centers(arma::linspace<arma::vec>(-5.0, 5.0, 100)),
+      prepared(100, arma::fill::zeros),
+      unprepared(0),
+      prepareCalls(0)
+  { }
+
+  size_t NumFunctions() const { return centers.n_elem; }
+
+  void Shuffle() { }
+
+  void PrepareBatch(const size_t begin, const size_t batchSize)
+  {
+    prepared.subvec(begin, begin + batchSize - 1).ones();
+    ++prepareCalls;
+  }
+
+  double Evaluate(const arma::mat& x, const size_t begin,
+                  const size_t batchSize)
+  {
+    Check(begin, batchSize);
+    return arma::accu(arma::square(x(0) -
+        centers.subvec(begin, begin + batchSize - 1)));
+  }
+
+  void Gradient(const arma::mat& x, const size_t begin, arma::mat& gradient,
+                const size_t batchSize)
+  {
+    Check(begin, batchSize);
+    gradient.set_size(1, 1);
+    gradient(0) = 2.0 * arma::accu(x(0) -
+        centers.subvec(begin, begin + batchSize - 1));
+  }
+
+  size_t Unprepared() const { return unprepared; }
+  size_t PrepareCalls() const { return prepareCalls; }
+
+ private:
+  void Check(const size_t begin, const size_t batchSize)
+  {
+    unprepared += batchSize - (size_t) arma::accu(
+        prepared.subvec(begin, begin + batchSize - 1));
+  }
+
+  arma::vec centers;
+  arma::vec prepared;
+  size_t unprepared;
+  size_t prepareCalls;
+};
+
+/**
+ * Make sure that SGD calls PrepareBatch() for every batch before using it.
+ */
+TEST_CASE("SGDPrepareBatchTest", "[SGDTest]")
+{
+  PrepareBatchTestFunction f;
+  StandardSGD s(0.001, 10, 5000, 1e-10, true, VanillaUpdate(), NoDecay(), true,
+      true);
+
+  arma::mat coordinates("3.0");
+  s.Optimize(f, coordinates);
+
+  REQUIRE(f.Unprepared() == 0);
+  REQUIRE(f.PrepareCalls() > 0);
+  // The optimum is at 0; make sure we moved towards it.
+  REQUIRE(std::abs(coordinates(0)) < 1.0);
+}
+
+/**
+ * Make sure that the policy storage keeps small objects in its own buffer,
+ * destroys what it holds, and keeps checking the held type.
+ */
+TEST_CASE("SGDPolicyStorageTest", "[SGDTest]")
+{
+  struct Counted
+  {
+    Counted(size_t& destroyed) : destroyed(destroyed) { }
+    ~Counted() { ++destroyed; }
+    size_t& destroyed;
+  };
+
+  size_t destroyed = 0;
+  {
+    Any any;
+    REQUIRE(any.Has<void>());
+
+    const Counted& held = any.Emplace<Counted>(destroyed);
+    REQUIRE(any.Has<Counted>());
+    REQUIRE(!any.Has<arma::mat>());
+    REQUIRE_THROWS_AS(any.As<arma::mat>(), std::invalid_argument);
+
+    // The object is held inside the Any, so nothing was allocated.
+    const char* begin = reinterpret_cast<const char*>(&any);
+    const char* address = reinterpret_cast<const char*>(&held);
+    REQUIRE(address >= begin);
+    REQUIRE(address < begin + sizeof(Any));
+
+    // Replacing the object destroys the old one.
+    any.Emplace<Counted>(destroyed);
+    REQUIRE(destroyed == 1);
+
+    // Copies hold nothing.
+    Any copy(any);
+    REQUIRE(copy.Has<void>());
+
+    // Objects that do not fit are allocated.
+    struct Large { char data[Any::BufferSize + 1]; };
+    const Large& large = any.Emplace<Large>();
+    REQUIRE(destroyed == 2);
+    REQUIRE((reinterpret_cast<const char*>(&large) < begin ||
+        reinterpret_cast<const char*>(&large) >= begin + sizeof(Any)));
+    any.Clean();
+    REQUIRE(any.Has<void>());
+
+    any.Emplace<Counted>(destroyed);
+    any.Clean();
+    REQUIRE(destroyed == 3);
+  }
+
+  // A copied optimizer instantiates its own policies.
+  StandardSGD s(0.01, 1, 10000, 1e-9, true, VanillaUpdate(), NoDecay(), false);
+  SGDTestFunction f;
+  arma::mat coordinates = f.GetInitialPoint();
+  s.Optimize(f, coordinates);
+  StandardSGD copy(s);
+  coordinates = f.GetInitialPoint();
+  copy.Optimize(f, coordinates);
+  REQUIRE(copy.InstUpdatePolicy().Has<VanillaUpdate::Policy<arma::mat,
+      arma::mat>>());
+}
+
+#ifdef ENS_HAVE_MMAP
+/**
+ * Train logistic regression on a memory-mapped dataset, prefetching the
+ * batches.
+ */
+TEST_CASE("SGDMappedMatrixLogisticRegressionTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData, responses,
+      testResponses, shuffledResponses);
+
+  const std::string filename = "sgd_mapped_matrix_test.bin";
+  MappedMatrix<double>::Save(filename, shuffledData);
+  {
+    MappedMatrix<double> mapped(filename);
+    REQUIRE(arma::approx_equal(mapped.Matrix(), shuffledData, "absdiff", 0.0));
+
+    LogisticRegressionFunction<> lr(mapped.Matrix(), shuffledResponses, 0.5);
+    PrefetchedFunction<LogisticRegressionFunction<>> f(lr, mapped);
+
+    StandardSGD s(0.0003, 1, 2000000, 1e-9, false);
+    arma::mat coordinates = lr.GetInitialPoint();
+    s.Optimize(f, coordinates);
+
+    REQUIRE(lr.ComputeAccuracy(data, responses, coordinates) ==
+        Approx(100.0).epsilon(0.003));
+    REQUIRE(lr.ComputeAccuracy(testData, testResponses, coordinates) ==
+        Approx(100.0).epsilon(0.006));
+  }
+  std::remove(filename.c_str());
+
+  // A file that does not hold a matrix is rejected.
+  REQUIRE_THROWS_AS(MappedMatrix<double>("missing_mapped_matrix_test.bin"),
+      std::runtime_error);
+}
+#endif
+
+/**
+ * Make sure the gradient compression methods keep the right elements.
+ */
+TEST_CASE("SGDGradientCompressionTest", "[SGDTest]")
+{
+  arma::mat gradient("1.0 -5.0 0.5 3.0 -0.1 2.0");
+
+  arma::mat topK(gradient);
+  TopKCompression(0.5).Compress(topK);
+  CheckMatrices(topK, arma::mat("0.0 -5.0 0.0 3.0 0.0 2.0"));
+
+  arma::mat randomK(gradient);
+  RandomKCompression(0.5).Compress(randomK);
+  REQUIRE(arma::accu(randomK != 0) == 3);
+  for (size_t i = 0; i < randomK.n_elem; ++i)
+  {
+    if (randomK[i] != 0)
+      REQUIRE(randomK[i] == gradient[i]);
+  }
+
+  // With 2 bits there is one level on either side of zero.
+  arma::mat quantized(gradient);
+  QuantizedCompression(2).Compress(quantized);
+  CheckMatrices(quantized, arma::mat("0.0 -5.0 0.0 5.0 0.0 0.0"));
+
+  arma::mat sign(gradient);
+  QuantizedCompression(1).Compress(sign);
+  const double scale = arma::mean(arma::abs(arma::vectorise(gradient)));
+  CheckMatrices(sign, scale * arma::sign(gradient));
+
+  // The number of bits must be between 1 and 32.
+  arma::mat invalid(gradient);
+  REQUIRE_THROWS_AS(QuantizedCompression(0).Compress(invalid),
+      std::invalid_argument);
+  REQUIRE_THROWS_AS(QuantizedCompression(64).Compress(invalid),
+      std::invalid_argument);
+}
+
+/**
+ * Run SGD with compressed gradients and error feedback on logistic regression.
+ */
+TEST_CASE("SGDGradientCompressionLogisticRegressionTest", "[SGDTest]")
+{
+  typedef GradientCompression<TopKCompression> TopKUpdate;
+  SGD<TopKUpdate> topK(0.0003, 32, 5000000, 1e-9, true,
+      TopKUpdate(TopKCompression(0.5)));
+  LogisticRegressionFunctionTest(topK, 0.003, 0.006, 3);
+
+  typedef GradientCompression<QuantizedCompression> QuantizedUpdate;
+  SGD<QuantizedUpdate> quantized(0.0003, 32, 5000000, 1e-9, true,
+      QuantizedUpdate(QuantizedCompression(8)));
+  LogisticRegressionFunctionTest(quantized, 0.003, 0.006, 3);
+}
+
+/**
+ * Make sure that running SGD a few batches at a time gives the same result as
+ * Optimize(), and that two optimizations can be interleaved.
+ */
+TEST_CASE("SGDStepTest", "[SGDTest]")
+{
+  SGDTestFunction f;
+  StandardSGD s(0.0003, 1, 100000, 1e-9, true);
+
+  arma::mat expected = f.GetInitialPoint();
+  arma::arma_rng::set_seed(42);
+  const double objective = s.Optimize(f, expected);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  arma::arma_rng::set_seed(42);
+  auto state = s.Begin(f, coordinates);
+  while (s.Step(state, 5)) { }
+
+  REQUIRE(state.Finished());
+  REQUIRE(state.Objective() == Approx(objective).epsilon(1e-12));
+  CheckMatrices(coordinates, expected, 1e-12);
+
+  // Without shuffling, the interleaved optimizations don't depend on the
+  // order of the steps.
+  StandardSGD t(0.0003, 1, 100000, 1e-9, false);
+  GeneralizedRosenbrockFunction g(10);
+  arma::mat expectedF = f.GetInitialPoint();
+  arma::mat expectedG = g.GetInitialPoint();
+  const double objectiveF = t.Optimize(f, expectedF);
+  const double objectiveG = t.Optimize(g, expectedG);
+
+  arma::mat coordinatesF = f.GetInitialPoint();
+  arma::mat coordinatesG = g.GetInitialPoint();
+  auto stateF = t.Begin(f, coordinatesF);
+  auto stateG = t.Begin(g, coordinatesG);
+  bool runningF = true, runningG = true;
+  while (runningF || runningG)
+  {
+    if (runningF)
+      runningF = t.Step(stateF, 2);
+    if (runningG)
+      runningG = t.Step(stateG, 3);
+  }
+
+  REQUIRE(stateF.Objective() == Approx(objectiveF).epsilon(1e-12));
+  REQUIRE(stateG.Objective() == Approx(objectiveG).epsilon(1e-12));
+  CheckMatrices(coordinatesF, expectedF, 1e-12);
+  CheckMatrices(coordinatesG, expectedG, 1e-12);
+}
+
+/**
+ * Make sure that each parameter group is updated with its own policy and step
+ * size, and that the parameters outside the groups and the frozen groups are
+ * not changed.
+ */
+TEST_CASE("SGDParameterGroupsTest", "[SGDTest]")
+{
+  // Each function of SGDTestFunction only depends on one coordinate.
+  SGDTestFunction f;
+
+  // With one group of all parameters, the result is that of the plain policy.
+  std::vector<ParameterGroup> all(1, ParameterGroup(0, 3));
+  typedef ParameterGroups<MomentumUpdate> AllUpdate;
+  SGD<AllUpdate> grouped(0.0003, 1, 100000, 1e-9, false,
+      AllUpdate(all, MomentumUpdate(0.5)));
+  SGD<MomentumUpdate> plain(0.0003, 1, 100000, 1e-9, false,
+      MomentumUpdate(0.5));
+
+  arma::mat groupedCoordinates = f.GetInitialPoint();
+  arma::mat plainCoordinates = f.GetInitialPoint();
+  const double groupedObjective = grouped.Optimize(f, groupedCoordinates);
+  const double plainObjective = plain.Optimize(f, plainCoordinates);
+  REQUIRE(groupedObjective == Approx(plainObjective).epsilon(1e-12));
+  CheckMatrices(groupedCoordinates, plainCoordinates, 1e-12);
+
+  // Now use a different policy for the first two coordinates, and freeze the
+  // second one; the third one is in no group.
+  std::vector<ParameterGroup> groups;
+  groups.push_back(ParameterGroup(0, 1));
+  groups.push_back(ParameterGroup(1, 1, 2.0, true));
+  typedef ParameterGroups<VanillaUpdate, AdamUpdate> GroupUpdate;
+  SGD<GroupUpdate> s(0.0003, 1, 300000, 1e-9, false,
+      GroupUpdate(groups, VanillaUpdate(), AdamUpdate()));
+
+  const arma::mat initial = f.GetInitialPoint();
+  arma::mat coordinates = initial;
+  s.Optimize(f, coordinates);
+
+  REQUIRE(coordinates(0) == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates(1) == initial(1));
+  REQUIRE(coordinates(2) == initial(2));
+
+  // Unfreeze the second group.
+  s.UpdatePolicy().Groups()[1].Frozen() = false;
+  s.Optimize(f, coordinates);
+  REQUIRE(coordinates(1) == Approx(0.0).margin(0.1));
+  REQUIRE(coordinates(2) == initial(2));
+
+  // Overlapping groups are rejected.
+  s.UpdatePolicy().Groups()[1].Begin() = 0;
+  s.ResetPolicy() = true;
+  coordinates = initial;
+  REQUIRE_THROWS_AS(s.Optimize(f, coordinates), std::invalid_argument);
+}
+
+/**
+ * Take steps with the given update policy wrapped in IterateAveraging, and
+ * with a copy of it that isn't wrapped, and make sure that the iterates are
+ * the same and that the average is the reference average of the iterates.
+ */
+template<typename UpdateType>
+void CheckIterateAveraging(const UpdateType& update,
+                           const double decay,
+                           const size_t start,
+                           const size_t interval)
+{
+  arma::mat iterate(20, 3, arma::fill::randu);
+  arma::mat reference(iterate);
+
+  IterateAveraging<UpdateType> averaging(update, decay, start, interval);
+  typename IterateAveraging<UpdateType>::template Policy<arma::mat, arma::mat>
+      policy(averaging, 20, 3);
+  UpdateType referenceUpdate(update);
+  typename UpdateType::template Policy<arma::mat, arma::mat> referencePolicy(
+      referenceUpdate, 20, 3);
+
+  arma::mat referenceAverage;
+  size_t count = 0;
+  for (size_t i = 1; i <= 30; ++i)
+  {
+    const arma::mat gradient(20, 3, arma::fill::randn);
+    policy.Update(iterate, 0.01, gradient);
+    referencePolicy.Update(reference, 0.01, gradient);
+
+    if (i <= start || (i - start) % interval != 0)
+      continue;
+
+    ++count;
+    if (count == 1)
+      referenceAverage = reference;
+    else if (decay > 0.0)
+      referenceAverage = decay * referenceAverage + (1 - decay) * reference;
+    else
+      referenceAverage = ((count - 1) * referenceAverage + reference) / count;
+  }
+
+  CheckMatrices(iterate, reference, 1e-10);
+  REQUIRE(policy.Count() == count);
+  CheckMatrices(averaging.Average(), referenceAverage, 1e-10);
+  REQUIRE(&averaging.Average() == &policy.Average());
+}
+
+/**
+ * Make sure that the uniform and exponential moving averages of the iterates
+ * are right, both for the policies that update the average inside their fused
+ * update and for the other policies, and that the average of a whole SGD
+ * optimization can be retrieved from the optimizer.
+ */
+TEST_CASE("SGDIterateAveragingTest", "[SGDTest]")
+{
+  CheckIterateAveraging(VanillaUpdate(), 0.0, 0, 1);
+  CheckIterateAveraging(MomentumUpdate(0.9), 0.0, 10, 1);
+  CheckIterateAveraging(NesterovMomentumUpdate(0.9), 0.9, 0, 3);
+  CheckIterateAveraging(QHUpdate(0.7, 0.9), 0.99, 5, 2);
+  CheckIterateAveraging(AdamUpdate(), 0.0, 7, 4);
+  CheckIterateAveraging(AdamUpdate(), 0.9, 0, 1);
+  // RMSPropUpdate updates the average in a pass after its own update.
+  CheckIterateAveraging(RMSPropUpdate(), 0.9, 2, 2);
+
+  typedef IterateAveraging<AdamUpdate> AveragedAdam;
+  SGD<AveragedAdam> optimizer(0.5, 2, 500000, 1e-3, false,
+      AveragedAdam(AdamUpdate(1e-8, 0.7, 0.999), 0.5));
+  FunctionTest<SphereFunction>(optimizer, 0.5, 0.2);
+
+  const arma::mat& average = optimizer.UpdatePolicy().Average();
+  REQUIRE(average.n_elem == 2);
+  REQUIRE(arma::norm(average) < 0.5);
+  REQUIRE_THROWS_AS(optimizer.UpdatePolicy().Average<arma::fmat>(),
+      std::invalid_argument);
+}
+
+#ifdef ENS_HAVE_COOT
+
+/**
+ * Run SGD with coordinates and gradients on the GPU.
+ */
+TEST_CASE("SGDCootFunctionTest", "[SGDTest]")
+{
+  StandardSGD s(0.001, 100, 100000, 1e-9, false);
+  CootFunctionTest(s, 1e-3);
+}
+
+#endif
+
+/**
+ * Make sure that repeated calls that reuse the buffers of SGD give the same
+ * results as calls on fresh optimizers.
+ */
+TEST_CASE("SGDWorkspaceReuseTest", "[SGDTest]")
+{
+  StandardSGD s(0.01, 2, 1000, 1e-9, false);
+  for (size_t trial = 0; trial < 3; ++trial)
+  {
+    GeneralizedRosenbrockFunction f(4 + (trial % 2));
+    arma::mat reused = f.GetInitialPoint();
+    arma::mat expected = f.GetInitialPoint();
+
+    s.Optimize(f, reused);
+    StandardSGD(0.01, 2, 1000, 1e-9, false).Optimize(f, expected);
+
+    CheckMatrices(reused, expected, 1e-12);
+  }
+}
+
+/**
+ * Make sure that SGD gives the same coordinates when it only computes the
+ * gradients, and that it checks the coordinates for divergence then.
+ */
+TEST_CASE("SGDComputeObjectiveTest", "[SGDTest]")
+{
+  GeneralizedRosenbrockFunction f(10);
+  // A negative tolerance never terminates the optimization early.
+  StandardSGD s(0.001, 1, 50000, -1.0, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  const double objective = s.Optimize(f, coordinates);
+  REQUIRE(objective > 0.0);
+
+  s.ComputeObjective() = false;
+  arma::mat gradientOnlyCoordinates = f.GetInitialPoint();
+  REQUIRE(s.Optimize(f, gradientOnlyCoordinates) == 0.0);
+  CheckMatrices(coordinates, gradientOnlyCoordinates, 1e-12);
+
+  // With the exact objective, the same final objective is computed.
+  s.ExactObjective() = true;
+  gradientOnlyCoordinates = f.GetInitialPoint();
+  REQUIRE(s.Optimize(f, gradientOnlyCoordinates) ==
+      Approx(f.Evaluate(coordinates)).epsilon(1e-10));
+
+  // A far too large step size diverges.
+  s.StepSize() = 100.0;
+  s.ExactObjective() = false;
+  gradientOnlyCoordinates = f.GetInitialPoint();
+  REQUIRE(!std::isfinite(s.Optimize(f, gradientOnlyCoordinates)));
+}
+
+/**
+ * Count the steps that SGD takes.
+ */
+struct StepCounter
+{
+  StepCounter() : steps(0) { }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    ++steps;
+    return false;
+  }
+
+  size_t steps;
+};
+
+/**
+ * Make sure that a divergence is detected within DivergenceCheckInterval()
+ * batches, instead of at the end of the epoch.
+ */
+TEST_CASE("SGDDivergenceCheckIntervalTest", "[SGDTest]")
+{
+  GeneralizedRosenbrockFunction f(1000);
+  StandardSGD s(100.0, 1, 0, 1e-9, false);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  StepCounter epochCounter;
+  REQUIRE(!std::isfinite(s.Optimize(f, coordinates, epochCounter)));
+  REQUIRE(epochCounter.steps == f.NumFunctions());
+
+  s.DivergenceCheckInterval() = 10;
+  coordinates = f.GetInitialPoint();
+  StepCounter counter;
+  REQUIRE(!std::isfinite(s.Optimize(f, coordinates, counter)));
+  REQUIRE(counter.steps < 100);
+  REQUIRE((counter.steps % 10) == 0);
+}
+
+/**
+ * Make sure that accumulating the gradients of micro-batches gives the same
+ * steps as the corresponding large batches, with one StepTaken() callback per
+ * step.
+ */
+TEST_CASE("SGDGradientAccumulationTest", "[SGDTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+  const size_t numFunctions = lr.NumFunctions();
+
+  StandardSGD large(0.001, 32, numFunctions * 5, -1.0, false);
+  arma::mat largeCoordinates = lr.GetInitialPoint();
+  StepCounter largeCounter;
+  large.Optimize(lr, largeCoordinates, largeCounter);
+
+  StandardSGD accumulated(0.001, 4, numFunctions * 5, -1.0, false);
+  accumulated.AccumulationSteps() = 8;
+  arma::mat accumulatedCoordinates = lr.GetInitialPoint();
+  StepCounter accumulatedCounter;
+  accumulated.Optimize(lr, accumulatedCoordinates, accumulatedCounter);
+
+  // The last step of each epoch may have fewer points.
+  REQUIRE(largeCounter.steps == 5 * ((numFunctions + 31) / 32));
+  REQUIRE(accumulatedCounter.steps == largeCounter.steps);
+  CheckMatrices(largeCoordinates, accumulatedCoordinates, 1e-8);
+}
+
+/**
+ * Apply the given update policy to a dense iterate with sparse gradients, and
+ * to a copy of it with the same gradients stored densely, and make sure that
+ * the results are the same.
+ */
+template<typename UpdateType>
+void CheckSparseGradientUpdate(const UpdateType& update)
+{
+  arma::mat denseIterate(50, 4, arma::fill::randu);
+  arma::mat sparseIterate(denseIterate);
+
+  typename UpdateType::template Policy<arma::mat, arma::mat> densePolicy(
+      update, 50, 4);
+  typename UpdateType::template Policy<arma::mat, arma::sp_mat> sparsePolicy(
+      update, 50, 4);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::sp_mat gradient = arma::sprandn<arma::sp_mat>(50, 4, 0.1);
+    densePolicy.Update(denseIterate, 0.01, arma::mat(gradient));
+    sparsePolicy.Update(sparseIterate, 0.01, gradient);
+  }
+
+  CheckMatrices(denseIterate, sparseIterate, 1e-10);
+}
+
+/**
+ * Make sure that the sparse vanilla, momentum, Nesterov momentum and
+ * quasi-hyperbolic updates (dense iterate, sparse gradient) give the same
+ * results as the dense updates, both for single steps and for a whole
+ * optimization.
+ */
+TEST_CASE("SGDSparseGradientUpdateTest", "[SGDTest]")
+{
+  CheckSparseGradientUpdate(VanillaUpdate());
+  CheckSparseGradientUpdate(MomentumUpdate(0.9));
+  CheckSparseGradientUpdate(NesterovMomentumUpdate(0.9));
+  CheckSparseGradientUpdate(QHUpdate(0.7, 0.9));
+
+  SparseTestFunction f;
+  MomentumSGD sgd(0.1, 1, 400, -1.0, false);
+  arma::mat denseCoordinates = f.GetInitialPoint<arma::mat>();
+  sgd.Optimize(f, denseCoordinates);
+
+  arma::mat sparseCoordinates = f.GetInitialPoint<arma::mat>();
+  sgd.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      sparseCoordinates);
+
+  CheckMatrices(denseCoordinates, sparseCoordinates, 1e-10);
+}
+
+/**
+ * Apply the given update policy to a dense iterate with row-sparse gradients,
+ * and to a copy of it with the same gradients stored densely, and make sure
+ * that the results are the same.  Each policy has its own copy of the update,
+ * since some updates (e.g. AdamUpdate) keep the iteration counter there.
+ */
+template<typename UpdateType>
+void CheckRowSparseGradientUpdate(const UpdateType& update)
+{
+  arma::mat denseIterate(50, 4, arma::fill::randu);
+  arma::mat sparseIterate(denseIterate);
+
+  UpdateType denseUpdate(update), sparseUpdate(update);
+  typename UpdateType::template Policy<arma::mat, arma::mat> densePolicy(
+      denseUpdate, 50, 4);
+  typename UpdateType::template Policy<arma::mat, RowSparseMat<double>>
+      sparsePolicy(sparseUpdate, 50, 4);
+
+  RowSparseMat<double> gradient;
+  for (size_t i = 0; i < 10; ++i)
+  {
+    // Touch 5 rows; some of them twice.
+    gradient.zeros(50, 4);
+    for (size_t k = 0; k < 6; ++k)
+    {
+      const arma::vec values = arma::randn<arma::vec>(4);
+      double* row = gradient.Row((7 * i + 3 * (k % 5)) % 50);
+      for (size_t c = 0; c < 4; ++c)
+        row[c] += values[c];
+    }
+    REQUIRE(gradient.NumTouchedRows() == 5);
+
+    densePolicy.Update(denseIterate, 0.01, gradient.Dense());
+    sparsePolicy.Update(sparseIterate, 0.01, gradient);
+  }
+
+  CheckMatrices(denseIterate, sparseIterate, 1e-10);
+}
+
+/**
+ * Make sure that the policies that support row-sparse gradients give the same
+ * results as with dense gradients, both for single steps and for a whole
+ * optimization of a function over an embedding table, and that the
+ * optimization converges.
+ */
+TEST_CASE("SGDRowSparseGradientTest", "[SGDTest]")
+{
+  CheckRowSparseGradientUpdate(VanillaUpdate());
+  CheckRowSparseGradientUpdate(MomentumUpdate(0.9));
+  CheckRowSparseGradientUpdate(NesterovMomentumUpdate(0.9));
+  CheckRowSparseGradientUpdate(QHUpdate(0.7, 0.9));
+  CheckRowSparseGradientUpdate(AdaGradUpdate());
+  CheckRowSparseGradientUpdate(AdamUpdate());
+
+  EmbeddingTestFunction f;
+  SGD<AdamUpdate> denseSGD(0.01, 10, 20 * f.NumFunctions(), -1.0, false);
+  arma::mat denseCoordinates = f.GetInitialPoint();
+  denseSGD.Optimize(f, denseCoordinates);
+
+  SGD<AdamUpdate> sparseSGD(0.01, 10, 20 * f.NumFunctions(), -1.0, false);
+  arma::mat sparseCoordinates = f.GetInitialPoint();
+  sparseSGD.Optimize<EmbeddingTestFunction, arma::mat, RowSparseMat<double>>(
+      f, sparseCoordinates);
+
+  CheckMatrices(denseCoordinates, sparseCoordinates, 1e-10);
+
+  StandardSGD sgd(0.1, 10, 20 * f.NumFunctions(), -1.0, false);
+  arma::mat coordinates = f.GetInitialPoint();
+  sgd.Optimize<EmbeddingTestFunction, arma::mat, RowSparseMat<double>>(f,
+      coordinates);
+  CheckMatrices(coordinates, f.GetFinalPoint(), 1e-5);
+
+  // The gradient can be accumulated, and converted to a dense matrix.
+  RowSparseMat<double> a(3, 2), b(3, 2);
+  a.Row(2)[0] = 1.0;
+  b.Row(2)[1] = 2.0;
+  b.Row(0)[0] = 3.0;
+  a += b;
+  REQUIRE(a.NumTouchedRows() == 2);
+  CheckMatrices(a.Dense(), arma::mat("3 0; 0 0; 1 2"));
+  REQUIRE_THROWS_AS(a += RowSparseMat<double>(2, 2), std::invalid_argument);
+}
+
+/**
+ * Train a softmax regression model with many classes using the sampled softmax
+ * and row-sparse gradients, and make sure that the full objective decreases
+ * and that the training points are classified well.
+ */
+TEST_CASE("SGDSampledSoftmaxTest", "[SGDTest]")
+{
+  const size_t numClasses = 30;
+  const arma::mat centers = 3.0 * arma::randn<arma::mat>(6, numClasses);
+  arma::Row<size_t> labels(600);
+  arma::mat data(6, 600);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+  {
+    labels[i] = i % numClasses;
+    data.col(i) = centers.col(labels[i]) + arma::randn<arma::vec>(6);
+  }
+
+  SoftmaxRegressionFunction srf(data, labels, numClasses, 0.0001, true, 8);
+  arma::mat coordinates = srf.GetInitialPoint();
+  const double initialObjective = srf.Evaluate(coordinates);
+
+  StandardSGD sgd(0.1, 10, 10 * labels.n_elem, -1.0, true);
+  sgd.Optimize<SoftmaxRegressionFunction, arma::mat, RowSparseMat<double>>(
+      srf, coordinates);
+
+  REQUIRE(srf.Evaluate(coordinates) < 0.5 * initialObjective);
+
+  arma::mat scores = coordinates.cols(1, data.n_rows) * data;
+  scores.each_col() += coordinates.col(0);
+  size_t correct = 0;
+  for (size_t i = 0; i < labels.n_elem; ++i)
+  {
+    if (scores.col(i).index_max() == labels[i])
+      ++correct;
+  }
+  REQUIRE(correct >= 0.8 * labels.n_elem);
+}
+
+/**
+ * Take one step of the instantiated update policy on 0.5 * ||x||^2, in the
+ * same way as the per-step benchmark in benchmarks/sgd_update_bench.cpp, and
+ * make sure that it moves towards the minimum.
+ */
+template<typename UpdatePolicyType>
+void CheckSingleUpdateStep()
+{
+  const size_t n = 1000;
+  arma::mat iterate(n, 1, arma::fill::randn);
+  const arma::mat gradient = iterate;
+  const double norm = arma::norm(iterate);
+
+  UpdatePolicyType updatePolicy;
+  typename UpdatePolicyType::template Policy<arma::mat, arma::mat> policy(
+      updatePolicy, n, 1);
+  policy.Update(iterate, 1e-3, gradient);
+
+  REQUIRE(iterate.is_finite());
+  REQUIRE(arma::norm(iterate) < norm);
+}
+
+/**
+ * Make sure that every update policy covered by the per-step benchmark can be
+ * instantiated on its own and takes a descent step.
+ */
+TEST_CASE("SGDUpdatePolicySingleStepTest", "[SGDTest]")
+{
+  CheckSingleUpdateStep<VanillaUpdate>();
+  CheckSingleUpdateStep<MomentumUpdate>();
+  CheckSingleUpdateStep<NesterovMomentumUpdate>();
+  CheckSingleUpdateStep<QHUpdate>();
+  CheckSingleUpdateStep<AdaBoundUpdate>();
+  CheckSingleUpdateStep<AdaDeltaUpdate>();
+  CheckSingleUpdateStep<AdaGradUpdate>();
+  CheckSingleUpdateStep<AdamUpdate>();
+  CheckSingleUpdateStep<AdaMaxUpdate>();
+  CheckSingleUpdateStep<AMSBoundUpdate>();
+  CheckSingleUpdateStep<AMSGradUpdate>();
+  CheckSingleUpdateStep<FTMLUpdate>();
+  CheckSingleUpdateStep<NadamUpdate>();
+  CheckSingleUpdateStep<NadaMaxUpdate>();
+  CheckSingleUpdateStep<OptimisticAdamUpdate>();
+  CheckSingleUpdateStep<PadamUpdate>();
+  CheckSingleUpdateStep<QHAdamUpdate>();
+  CheckSingleUpdateStep<RMSPropUpdate>();
+  CheckSingleUpdateStep<SMORMS3Update>();
+  CheckSingleUpdateStep<SWATSUpdate>();
+  CheckSingleUpdateStep<WNGradUpdate>();
+}
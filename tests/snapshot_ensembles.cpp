@@ -85,6 +85,90 @@ TEST_CASE("SnapshotEnsemblesLogisticRegressionFMatTest","[SnapshotEnsemblesTest]
   }
 }
 
+/**
+ * Make sure that each snapshot storage returns the stored snapshots, and that
+ * the in-memory ring only keeps the most recent ones.
+ */
+template<typename StorageType>
+void SnapshotStorageTest(const StorageType& storage,
+                         const size_t capacity,
+                         const double tolerance)
+{
+  typename StorageType::template Policy<arma::mat> policy(storage);
+
+  std::vector<arma::mat> snapshots;
+  arma::mat snapshot(10, 3, arma::fill::randu);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    // Change only a few of the parameters between snapshots.
+    snapshot.col(i % 3) += 0.1;
+    snapshots.push_back(snapshot);
+    policy.Add(snapshot);
+  }
+
+  const size_t first = (capacity == 0) ? 0 : 5 - capacity;
+  REQUIRE(policy.Size() == 5 - first);
+
+  arma::mat loaded;
+  arma::mat sum(10, 3, arma::fill::zeros), expectedSum(sum);
+  for (size_t i = 0; i < policy.Size(); ++i)
+  {
+    policy.Load(i, loaded);
+    CheckMatrices(loaded, snapshots[first + i], tolerance + 1e-12);
+    expectedSum += snapshots[first + i];
+  }
+
+  policy.Accumulate(sum);
+  CheckMatrices(sum, expectedSum, 5 * tolerance + 1e-12);
+}
+
+TEST_CASE("SnapshotStorageTest", "[SnapshotEnsemblesTest]")
+{
+  SnapshotStorageTest(InMemorySnapshots(), 0, 0.0);
+  SnapshotStorageTest(InMemorySnapshots(3), 3, 0.0);
+  SnapshotStorageTest(DeltaSnapshots(), 0, 0.0);
+  SnapshotStorageTest(DeltaSnapshots(0.05), 0, 0.05);
+
+  const std::string prefix = "snapshot_storage_test";
+  SnapshotStorageTest(DiskSnapshots(prefix), 0, 0.0);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    std::ostringstream filename;
+    filename << prefix << "_" << i << ".bin";
+    std::remove(filename.str().c_str());
+  }
+}
+
+/**
+ * Make sure that DeltaSnapshots only stores the parameters that changed.
+ */
+TEST_CASE("DeltaSnapshotsElementsTest", "[SnapshotEnsemblesTest]")
+{
+  DeltaSnapshots storage;
+  DeltaSnapshots::Policy<arma::mat> policy(storage);
+
+  arma::mat snapshot(100, 1, arma::fill::randu);
+  policy.Add(snapshot);
+  snapshot(3) += 1.0;
+  policy.Add(snapshot);
+  snapshot(7) += 1.0;
+  policy.Add(snapshot);
+
+  REQUIRE(policy.DeltaElements() == 2);
+}
+
+/**
+ * Run SGDR with compressed snapshot ensembles on logistic regression and make
+ * sure the results are acceptable.
+ */
+TEST_CASE("SnapshotEnsemblesDeltaLogisticRegressionTest",
+          "[SnapshotEnsemblesTest]")
+{
+  SnapshotSGDR<MomentumUpdate, DeltaSnapshots> sgdr(50, 2.0, 5, 0.01, 10000,
+      1e-3);
+  LogisticRegressionFunctionTest(sgdr, 0.003, 0.006, 3);
+}
+
 #if ARMA_VERSION_MAJOR > 9 ||\
     (ARMA_VERSION_MAJOR == 9 && ARMA_VERSION_MINOR >= 400)
 
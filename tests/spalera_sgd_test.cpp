@@ -43,3 +43,48 @@ TEST_CASE("LogisticRegressionFMatTest","[SPALeRASGDTest]")
     LogisticRegressionFunctionTest<arma::fmat>(optimizer, 0.015, 0.024, 3);
   }
 }
+
+/**
+ * Make sure that the fused dense step of SPALeRAStepsize matches the
+ * Armadillo expressions of the learning rate adaptation, and that the fused
+ * backtracking restores the iterate.
+ */
+TEST_CASE("SPALeRAFusedUpdateTest", "[SPALeRASGDTest]")
+{
+  const double alpha = 0.1, adaptRate = 1e-3, stepSize = 0.01;
+  SPALeRAStepsize stepsize(alpha, 1e-6, adaptRate);
+  SPALeRAStepsize::Policy<arma::mat, arma::mat> policy(stepsize, 5, 4, 1e10);
+
+  arma::mat iterate(5, 4, arma::fill::randu);
+  arma::mat expected(iterate);
+  arma::mat learningRates(5, 4, arma::fill::ones);
+  arma::mat relaxedSums(5, 4, arma::fill::zeros);
+  const double n = iterate.n_elem;
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::mat gradient(5, 4, arma::fill::randn);
+    REQUIRE(policy.Update(stepSize, 1.0, 1, 1, iterate, gradient));
+
+    const double paramMean = (alpha / (2 - alpha) *
+        (1 - std::pow(1 - alpha, 2 * (i + 1)))) / n;
+    const double paramStd = alpha / n;
+    relaxedSums = (1 - alpha) * relaxedSums +
+        gradient * (alpha / arma::norm(gradient, "fro"));
+    learningRates %= arma::exp((arma::square(relaxedSums) - paramMean) *
+        (adaptRate / paramStd));
+    expected -= stepSize * (learningRates % gradient);
+  }
+
+  CheckMatrices(iterate, expected, 1e-5);
+
+  // An increasing objective is detected with a small lambda, and the step
+  // is undone.
+  SPALeRAStepsize::Policy<arma::mat, arma::mat> backtracking(stepsize, 5, 4,
+      1e-10);
+  const arma::mat start(iterate);
+  arma::mat gradient(5, 4, arma::fill::randn);
+  REQUIRE(backtracking.Update(stepSize, 1.0, 1, 1, iterate, gradient));
+  REQUIRE(arma::norm(iterate - start, "fro") > 0.0);
+  REQUIRE(backtracking.Update(stepSize, 2.0, 1, 1, iterate, gradient));
+  CheckMatrices(iterate, start);
+}
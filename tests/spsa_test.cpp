@@ -46,6 +46,17 @@ TEST_CASE("SPSASphereFunctionSpMatTest", "[SPSATest]")
   FunctionTest<SphereFunction, arma::sp_mat>(optimizer, 1.0, 0.1);
 }
 
+/**
+ * Test the SPSA optimizer on the Sphere function, averaging several
+ * perturbation pairs evaluated in parallel and estimating the objective from
+ * the perturbed points.
+ */
+TEST_CASE("SPSASphereFunctionPerturbationsTest", "[SPSATest]")
+{
+  SPSA optimizer(0.1, 0.102, 0.16, 0.3, 100000, 0, 4, false, true);
+  FunctionTest<SphereFunction>(optimizer, 1.0, 0.1);
+}
+
 /**
  * Test the SPSA optimizer on the Matyas function.
  */
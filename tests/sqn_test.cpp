@@ -0,0 +1,138 @@
+/**
+ * @file sqn_test.cpp
+ *
+ * Tests for the stochastic quasi-Newton method (SQN).
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+#include "test_function_tools.hpp"
+
+using namespace ens;
+using namespace ens::test;
+
+/**
+ * A logistic regression function that only has the separable Evaluate() and
+ * Gradient() methods, so that SQN uses gradient differences for the curvature
+ * pairs.
+ */
+class GradientOnlyLogisticRegression
+{
+ public:
+  GradientOnlyLogisticRegression(LogisticRegressionFunction<>& function) :
+      function(function)
+  { }
+
+  void Shuffle() { function.Shuffle(); }
+
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  double Evaluate(const arma::mat& coordinates,
+                  const size_t begin,
+                  const size_t batchSize) const
+  {
+    return function.Evaluate(coordinates, begin, batchSize);
+  }
+
+  void Gradient(const arma::mat& coordinates,
+                const size_t begin,
+                arma::mat& gradient,
+                const size_t batchSize) const
+  {
+    function.Gradient(coordinates, begin, gradient, batchSize);
+  }
+
+ private:
+  LogisticRegressionFunction<>& function;
+};
+
+/**
+ * Make sure that the Hessian-vector products of the batches of the regression
+ * functions sum to the product of the whole objective.
+ */
+TEST_CASE("SQNSeparableHessianVectorProductTest", "[SQNTest]")
+{
+  arma::mat data(5, 60, arma::fill::randn);
+  arma::Row<size_t> responses(60);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+    responses[i] = (arma::accu(data.col(i)) > 0.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.1);
+  arma::mat coordinates(1, 6, arma::fill::randn);
+  arma::mat direction(1, 6, arma::fill::randn);
+  arma::mat product, batchProduct;
+  lrf.HessianVectorProduct(coordinates, direction, product);
+  lrf.Shuffle();
+
+  arma::mat sum(arma::size(product), arma::fill::zeros);
+  for (size_t i = 0; i < data.n_cols; i += 20)
+  {
+    lrf.HessianVectorProduct(coordinates, i, direction, batchProduct, 20);
+    sum += batchProduct;
+  }
+  REQUIRE(arma::approx_equal(sum, product, "absdiff", 1e-8));
+
+  // The softmax regression objective of a batch is an average.
+  SoftmaxRegressionFunction srf(data, responses, 2, 0.1, true);
+  coordinates.randn(arma::size(srf.GetInitialPoint()));
+  direction.randn(arma::size(coordinates));
+  srf.HessianVectorProduct(coordinates, direction, product);
+
+  sum.zeros(arma::size(product));
+  for (size_t i = 0; i < data.n_cols; i += 20)
+  {
+    srf.HessianVectorProduct(coordinates, i, direction, batchProduct, 20);
+    sum += batchProduct / 3.0;
+  }
+  REQUIRE(arma::approx_equal(sum, product, "absdiff", 1e-8));
+}
+
+/**
+ * Run SQN on logistic regression, with the subsampled Hessian-vector products
+ * of the function.
+ */
+TEST_CASE("SQNLogisticRegressionTest", "[SQNTest]")
+{
+  SQN optimizer(0.1, 32, 320, 10, 10, 100000);
+  LogisticRegressionFunctionTest(optimizer, 0.003, 0.006, 3);
+}
+
+/**
+ * Run SQN on logistic regression with arma::fmat.
+ */
+TEST_CASE("SQNLogisticRegressionFMatTest", "[SQNTest]")
+{
+  SQN optimizer(0.1, 32, 320, 10, 10, 100000);
+  LogisticRegressionFunctionTest<arma::fmat>(optimizer, 0.003, 0.006, 3);
+}
+
+/**
+ * Make sure that SQN also converges without a Hessian-vector product method,
+ * to nearly the same point as L-BFGS on the whole objective.
+ */
+TEST_CASE("SQNGradientDifferenceTest", "[SQNTest]")
+{
+  arma::mat data(5, 2000, arma::fill::randn);
+  arma::Row<size_t> responses(2000);
+  for (size_t i = 0; i < responses.n_elem; ++i)
+    responses[i] = (data(0, i) + 0.5 * data(1, i) > 0.0) ? 1 : 0;
+
+  LogisticRegressionFunction<> lrf(data, responses, 1.0);
+  GradientOnlyLogisticRegression f(lrf);
+
+  arma::mat coordinates = lrf.GetInitialPoint();
+  SQN optimizer(0.1, 32, 320, 10, 10, 200000, 1e-8);
+  optimizer.Optimize(f, coordinates);
+
+  arma::mat lbfgsCoordinates = lrf.GetInitialPoint();
+  L_BFGS lbfgs;
+  lbfgs.Optimize(lrf, lbfgsCoordinates);
+
+  REQUIRE(lrf.Evaluate(coordinates) ==
+      Approx(lrf.Evaluate(lbfgsCoordinates)).epsilon(0.01));
+}
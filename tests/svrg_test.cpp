@@ -105,3 +105,122 @@ TEST_CASE("SVRGBBLogisticRegressionSpMatTest", "[SVRGTest]")
 }
 
 #endif
+
+/**
+ * Run SVRG on logistic regression with the full gradient computed in parallel,
+ * with and without a deterministic reduction.
+ */
+TEST_CASE("SVRGParallelFullGradientLogisticRegressionTest", "[SVRGTest]")
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    SVRG optimizer(0.005, 40, 300, 0, 1e-5, true);
+    optimizer.ParallelFullGradient() = true;
+    optimizer.DeterministicReduction() = (i == 1);
+    LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+  }
+}
+
+/**
+ * Make sure that reusing the batch gradients at the snapshot gives the same
+ * result as computing them again, and that SVRG still converges with
+ * shuffling.
+ */
+TEST_CASE("SVRGCacheSnapshotGradientsTest", "[SVRGTest]")
+{
+  arma::mat data, testData, shuffledData;
+  arma::Row<size_t> responses, testResponses, shuffledResponses;
+  LogisticRegressionTestData(data, testData, shuffledData,
+      responses, testResponses, shuffledResponses);
+  LogisticRegression<> lr(shuffledData, shuffledResponses, 0.5);
+
+  SVRG cached(0.005, 40, 10, 0, 1e-15, false);
+  cached.CacheSnapshotGradients() = true;
+  SVRG uncached(cached);
+  uncached.CacheSnapshotGradients() = false;
+
+  arma::mat cachedCoordinates = lr.GetInitialPoint();
+  arma::mat uncachedCoordinates = lr.GetInitialPoint();
+  const double cachedObjective = cached.Optimize(lr, cachedCoordinates);
+  const double uncachedObjective = uncached.Optimize(lr, uncachedCoordinates);
+
+  REQUIRE(cachedObjective == Approx(uncachedObjective).epsilon(1e-10));
+  CheckMatrices(cachedCoordinates, uncachedCoordinates, 1e-10);
+
+  SVRG optimizer(0.005, 40, 300, 0, 1e-5, true);
+  optimizer.CacheSnapshotGradients() = true;
+  LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+}
+
+/**
+ * Run SVRG with the asynchronous inner loop on logistic regression.
+ */
+TEST_CASE("SVRGAsynchronousInnerLoopLogisticRegressionTest", "[SVRGTest]")
+{
+  SVRG optimizer(0.005, 40, 300, 0, 1e-5, true);
+  optimizer.AsynchronousInnerLoop() = true;
+  LogisticRegressionFunctionTest(optimizer, 0.015, 0.015);
+}
+
+/**
+ * Make sure that the Gradient() and StepTaken() callbacks of the asynchronous
+ * inner loop are called once for each step, but never concurrently, and that a
+ * callback stops the inner loop.
+ */
+TEST_CASE("SVRGAsynchronousInnerLoopCallbackTest", "[SVRGTest]")
+{
+  GeneralizedRosenbrockFunction f(20);
+  SetExecutor(std::make_shared<ThreadPoolExecutor>(4));
+
+  // Only replay the steps after the inner loop, and when a thread holds two.
+  for (size_t bufferSize = 0; bufferSize < 3; bufferSize += 2)
+  {
+    SVRG optimizer(0.0001, 1, 5, 0, -1.0, true);
+    optimizer.AsynchronousInnerLoop() = true;
+    optimizer.CallbackBufferSize() = bufferSize;
+
+    arma::mat coordinates = f.GetInitialPoint();
+    ParallelCallbackCounter counter;
+    optimizer.Optimize(f, coordinates, counter);
+
+    // Each function is a batch of the full gradient and a step.
+    REQUIRE(counter.steps == 5 * f.NumFunctions());
+    REQUIRE(counter.gradients == 2 * counter.steps);
+    REQUIRE(!counter.overlap);
+  }
+
+  // Each of the four threads can finish a step and hold one more step once the
+  // termination is requested, but the second inner loop is not finished.
+  SVRG optimizer(0.0001, 1, 5, 0, -1.0, true);
+  optimizer.AsynchronousInnerLoop() = true;
+  optimizer.CallbackBufferSize() = 2;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  ParallelCallbackCounter stopper(f.NumFunctions() + 1);
+  optimizer.Optimize(f, coordinates, stopper);
+  SetExecutor(nullptr);
+
+  REQUIRE(stopper.steps > f.NumFunctions());
+  REQUIRE(stopper.steps <= f.NumFunctions() + 9);
+  REQUIRE(!stopper.overlap);
+}
+
+/**
+ * Run SVRG with the asynchronous inner loop and sparse gradients, so that the
+ * full gradient term is applied lazily.
+ */
+TEST_CASE("SVRGAsynchronousInnerLoopSparseGradientTest", "[SVRGTest]")
+{
+  SparseTestFunction f;
+  SVRG optimizer(0.2, 1, 1000, 0, 1e-10, true);
+  optimizer.AsynchronousInnerLoop() = true;
+
+  arma::mat coordinates = f.GetInitialPoint();
+  optimizer.Optimize<SparseTestFunction, arma::mat, arma::sp_mat>(f,
+      coordinates);
+
+  REQUIRE(coordinates(0) == Approx(2.0).epsilon(0.001));
+  REQUIRE(coordinates(1) == Approx(1.0).epsilon(0.001));
+  REQUIRE(coordinates(2) == Approx(1.5).epsilon(0.001));
+  REQUIRE(coordinates(3) == Approx(4.0).epsilon(0.001));
+}
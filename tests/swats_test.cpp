@@ -54,6 +54,116 @@ TEST_CASE("SWATSStyblinskiTangFunctionFMatTest", "[SWATSTest]")
   FunctionTest<StyblinskiTangFunction, arma::fmat>(optimizer, 3.0, 0.3);
 }
 
+/**
+ * A straightforward implementation of the SWATS update, without the fused
+ * kernels, to check the results of SWATSUpdate against.
+ */
+class ReferenceSWATS
+{
+ public:
+  ReferenceSWATS(const double epsilon, const size_t rows, const size_t cols) :
+      epsilon(epsilon), beta1(0.9), beta2(0.999), iteration(0),
+      phaseSGD(false), sgdRate(0), sgdLambda(0)
+  {
+    m.zeros(rows, cols);
+    v.zeros(rows, cols);
+  }
+
+  void Update(arma::mat& iterate,
+              const double stepSize,
+              const arma::mat& gradient)
+  {
+    ++iteration;
+
+    if (phaseSGD)
+    {
+      v *= beta1;
+      v += gradient;
+      iterate -= (1 - beta1) * sgdRate * v;
+      return;
+    }
+
+    m *= beta1;
+    m += (1 - beta1) * gradient;
+    v *= beta2;
+    v += (1 - beta2) * (gradient % gradient);
+
+    const double biasCorrection1 = 1.0 - std::pow(beta1, iteration);
+    const double biasCorrection2 = 1.0 - std::pow(beta2, iteration);
+
+    arma::mat delta = stepSize * m / biasCorrection1 /
+        (arma::sqrt(v / biasCorrection2) + epsilon);
+    iterate -= delta;
+
+    const double deltaGradient = arma::dot(delta, gradient);
+    if (deltaGradient != 0)
+    {
+      const double rate = arma::dot(delta, delta) / deltaGradient;
+      sgdLambda = beta2 * sgdLambda + (1 - beta2) * rate;
+      sgdRate = sgdLambda / biasCorrection2;
+
+      if (std::abs(sgdRate - rate) < epsilon && iteration > 1)
+      {
+        phaseSGD = true;
+        v.zeros();
+      }
+    }
+  }
+
+  double epsilon;
+  double beta1;
+  double beta2;
+  size_t iteration;
+  bool phaseSGD;
+  double sgdRate;
+  double sgdLambda;
+  arma::mat m;
+  arma::mat v;
+};
+
+/**
+ * Make sure that the fused SWATS update switches to SGD at the same iteration
+ * as the reference implementation, that the SGD steps after the switch match
+ * it, and that the first moment estimates are released at the switch.
+ */
+TEST_CASE("SWATSUpdateSwitchTest", "[SWATSTest]")
+{
+  // Gradients with a small amount of noise around a fixed gradient give
+  // nearly constant rates, so the switching condition is met early.
+  const arma::mat base(5, 4, arma::fill::randu);
+  const double epsilon = 1e-4;
+
+  SWATSUpdate update(epsilon);
+  SWATSUpdate::Policy<arma::mat, arma::mat> policy(update, 5, 4);
+  ReferenceSWATS reference(epsilon, 5, 4);
+
+  arma::mat iterate(5, 4, arma::fill::randu);
+  arma::mat referenceIterate(iterate);
+
+  size_t switchIteration = 0;
+  for (size_t i = 1; i <= 100; ++i)
+  {
+    const arma::mat gradient = base + 0.01 * arma::randn<arma::mat>(5, 4);
+    policy.Update(iterate, 0.01, gradient);
+    reference.Update(referenceIterate, 0.01, gradient);
+
+    REQUIRE(update.PhaseSGD() == reference.phaseSGD);
+    if (update.PhaseSGD() && switchIteration == 0)
+      switchIteration = i;
+  }
+
+  REQUIRE(switchIteration > 1);
+  REQUIRE(switchIteration < 100);
+  REQUIRE(update.SGDRate() == Approx(reference.sgdRate).epsilon(1e-5));
+
+  // The SGD steps after the switch follow the reference, and only the
+  // momentum is kept.
+  CheckMatrices(iterate, referenceIterate, 1e-5);
+  CheckMatrices(policy.V(), reference.v, 1e-5);
+  REQUIRE(policy.M().n_elem == 0);
+  REQUIRE(update.StateBytes<arma::mat>(5, 4) == 20 * sizeof(double));
+}
+
 #if ARMA_VERSION_MAJOR > 9 ||\
     (ARMA_VERSION_MAJOR == 9 && ARMA_VERSION_MINOR >= 400)
 
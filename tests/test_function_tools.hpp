@@ -218,4 +218,215 @@ void LogisticRegressionFunctionTest(OptimizerType& optimizer,
   }
 }
 
+/**
+ * The sphere function f(x) = |x|^2 with an EvaluateBatch() method, to test
+ * that population-based optimizers use it.  The number of calls to each
+ * method is counted.
+ */
+class BatchSphereFunction
+{
+ public:
+  BatchSphereFunction() : evaluateCalls(0), evaluateBatchCalls(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluateCalls;
+    return arma::accu(arma::square(x));
+  }
+
+  void EvaluateBatch(const arma::cube& candidates, arma::vec& objectives)
+  {
+    ++evaluateBatchCalls;
+    for (size_t i = 0; i < candidates.n_slices; ++i)
+      objectives(i) = arma::accu(arma::square(candidates.slice(i)));
+  }
+
+  size_t evaluateCalls;
+  size_t evaluateBatchCalls;
+};
+
+/**
+ * The shifted sphere function f(x) = |x - 1|^2 with an EvaluateDelta() method,
+ * to test that coordinate-wise optimizers use it.  The number of calls to each
+ * method is counted.
+ */
+class DeltaSphereFunction
+{
+ public:
+  DeltaSphereFunction() : evaluateCalls(0), evaluateDeltaCalls(0) { }
+
+  double Evaluate(const arma::mat& x)
+  {
+    ++evaluateCalls;
+    return arma::accu(arma::square(x - 1.0));
+  }
+
+  double EvaluateDelta(const arma::mat& x,
+                       const size_t index,
+                       const double newValue)
+  {
+    ++evaluateDeltaCalls;
+    return std::pow(newValue - 1.0, 2.0) - std::pow(x(index) - 1.0, 2.0);
+  }
+
+  size_t evaluateCalls;
+  size_t evaluateDeltaCalls;
+};
+
+/**
+ * The separable shifted sphere function f(x) = sum_i (x_i - 1)^2, with one
+ * function per coordinate, and an EvaluateBounded() method to test that
+ * comparison-based optimizers use it.  The number of calls to
+ * EvaluateBounded(), and of the terms that these calls evaluate, are counted.
+ */
+class BoundedSphereFunction
+{
+ public:
+  BoundedSphereFunction(const size_t n) :
+      n(n), boundedCalls(0), boundedTerms(0), terms(0) { }
+
+  size_t NumFunctions() const { return n; }
+
+  void Shuffle() { }
+
+  double Evaluate(const arma::mat& x, const size_t begin,
+                  const size_t batchSize)
+  {
+    double objective = 0.0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      objective += std::pow(x(i) - 1.0, 2.0);
+    terms += batchSize;
+    return objective;
+  }
+
+  double Evaluate(const arma::mat& x) { return Evaluate(x, 0, n); }
+
+  double EvaluateBounded(const arma::mat& x, const double bound)
+  {
+    ++boundedCalls;
+    const size_t before = terms;
+    const double objective = ens::EvaluateSeparableBounded(*this, x, bound, 1);
+    boundedTerms += terms - before;
+    return objective;
+  }
+
+  size_t n;
+  size_t boundedCalls;
+  size_t boundedTerms;
+
+ private:
+  size_t terms;
+};
+
+// Count the Gradient() and StepTaken() calls without any lock, record whether
+// two calls ever overlapped, and ask to terminate after the given number of
+// steps (if it is not 0).
+struct ParallelCallbackCounter
+{
+  ParallelCallbackCounter(const size_t maxSteps = 0) :
+      maxSteps(maxSteps), gradients(0), steps(0), inside(0), overlap(false)
+  { }
+
+  template<typename OptimizerType,
+           typename FunctionType,
+           typename MatType,
+           typename GradType>
+  void Gradient(OptimizerType& /* optimizer */,
+                FunctionType& /* function */,
+                const MatType& /* coordinates */,
+                const GradType& gradient)
+  {
+    Enter();
+    if (gradient.n_elem > 0)
+      ++gradients;
+    Leave();
+  }
+
+  template<typename OptimizerType, typename FunctionType, typename MatType>
+  bool StepTaken(OptimizerType& /* optimizer */,
+                 FunctionType& /* function */,
+                 MatType& /* coordinates */)
+  {
+    Enter();
+    ++steps;
+    Leave();
+    return maxSteps > 0 && steps >= maxSteps;
+  }
+
+  void Enter() { if (++inside > 1) overlap = true; }
+  void Leave() { --inside; }
+
+  size_t maxSteps;
+  size_t gradients;
+  size_t steps;
+  std::atomic<int> inside;
+  std::atomic<bool> overlap;
+};
+
+#ifdef ENS_HAVE_COOT
+
+/**
+ * The separable function f(x) = sum_i |x - c_i|^2 on Bandicoot (GPU) matrices,
+ * whose minimum is the mean of the centers c_i.  All of the arithmetic is done
+ * on the device.
+ */
+class CootQuadraticFunction
+{
+ public:
+  CootQuadraticFunction(const arma::fmat& centers) : centers(centers) { }
+
+  size_t NumFunctions() const { return centers.n_cols; }
+
+  void Shuffle() { }
+
+  float Evaluate(const coot::fmat& x, const size_t begin,
+                 const size_t batchSize)
+  {
+    float objective = 0;
+    for (size_t i = begin; i < begin + batchSize; ++i)
+      objective += coot::accu(coot::square(x - centers.col(i)));
+    return objective;
+  }
+
+  void Gradient(const coot::fmat& x, const size_t begin, coot::fmat& gradient,
+                const size_t batchSize)
+  {
+    gradient = 2 * (float(batchSize) * x -
+        coot::sum(centers.cols(begin, begin + batchSize - 1), 1));
+  }
+
+  float Evaluate(const coot::fmat& x)
+  {
+    return Evaluate(x, 0, NumFunctions());
+  }
+
+  void Gradient(const coot::fmat& x, coot::fmat& gradient)
+  {
+    Gradient(x, 0, gradient, NumFunctions());
+  }
+
+ private:
+  coot::fmat centers;
+};
+
+/**
+ * Optimize a CootQuadraticFunction with coordinates on the device, and check
+ * that the minimum is found.
+ */
+template<typename OptimizerType>
+inline void CootFunctionTest(OptimizerType& optimizer, const double tolerance)
+{
+  const arma::fmat centers(10, 100, arma::fill::randu);
+  CootQuadraticFunction f(centers);
+
+  coot::fmat coordinates(10, 1);
+  coordinates.zeros();
+  optimizer.Optimize(f, coordinates);
+
+  CheckMatrices(arma::fmat(coordinates),
+      arma::fmat(arma::mean(centers, 1)), tolerance);
+}
+
+#endif
+
 #endif
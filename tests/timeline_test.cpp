@@ -0,0 +1,138 @@
+/**
+ * @file timeline_test.cpp
+ *
+ * Tests for the timeline of optimization phases.
+ *
+ * ensmallen is free software; you may redistribute it and/or modify it under
+ * the terms of the 3-clause BSD license.  You should have received a copy of
+ * the 3-clause BSD license along with ensmallen.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+
+#include <ensmallen.hpp>
+#include "catch.hpp"
+
+using namespace ens;
+
+//! Return the number of occurrences of the given pattern in the given string.
+static size_t CountOccurrences(const std::string& s, const std::string& p)
+{
+  size_t count = 0;
+  for (size_t i = s.find(p); i != std::string::npos; i = s.find(p, i + 1))
+    ++count;
+  return count;
+}
+
+/**
+ * Each thread records into a track of its own, and every event is written.
+ */
+TEST_CASE("TimelineThreadsTest", "[TimelineTest]")
+{
+  Timeline timeline;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t)
+  {
+    threads.push_back(std::thread([&timeline, t]()
+    {
+      if (t == 0)
+        timeline.NameThread("first \"worker\"");
+      for (size_t i = 0; i < 5000; ++i)
+      {
+        timeline.Begin("task");
+        timeline.End("task");
+      }
+      timeline.Instant("done");
+    }));
+  }
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+
+  REQUIRE(timeline.Threads() == 4);
+  REQUIRE(timeline.Events() == 4 * 10001);
+  REQUIRE(timeline.Dropped() == 0);
+
+  std::ostringstream trace;
+  timeline.WriteChromeTrace(trace);
+  const std::string json = trace.str();
+  REQUIRE(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") == 0);
+  REQUIRE(CountOccurrences(json, "\"ph\":\"M\"") == 4);
+  REQUIRE(CountOccurrences(json, "\"ph\":\"B\"") == 20000);
+  REQUIRE(CountOccurrences(json, "\"ph\":\"E\"") == 20000);
+  REQUIRE(CountOccurrences(json, "\"ph\":\"i\"") == 4);
+  REQUIRE(json.find("\"name\":\"first \\\"worker\\\"\"") != std::string::npos);
+  REQUIRE(json.find("\"tid\":3") != std::string::npos);
+  REQUIRE(json.substr(json.size() - 4) == "\n]}\n");
+}
+
+/**
+ * Each thread records at most MaxEvents() events, and Clear() forgets the
+ * events but keeps the threads.
+ */
+TEST_CASE("TimelineMaxEventsTest", "[TimelineTest]")
+{
+  Timeline timeline(5000);
+  for (size_t i = 0; i < 3000; ++i)
+  {
+    timeline.Begin("step");
+    timeline.End("step");
+  }
+
+  REQUIRE(timeline.Events() == 5000);
+  REQUIRE(timeline.Dropped() == 1000);
+  REQUIRE(timeline.Threads() == 1);
+
+  timeline.Clear();
+  REQUIRE(timeline.Events() == 0);
+  REQUIRE(timeline.Dropped() == 0);
+  REQUIRE(timeline.Threads() == 1);
+
+  timeline.Begin("step");
+  timeline.End("step");
+  REQUIRE(timeline.Events() == 2);
+}
+
+/**
+ * A TimelineScope records its lifetime into the timeline set with
+ * SetTimeline(), and nothing when there is none; the timeline can be saved to
+ * a file.
+ */
+TEST_CASE("TimelineScopeTest", "[TimelineTest]")
+{
+  {
+    TimelineScope scope("unrecorded");
+  }
+
+  std::shared_ptr<Timeline> timeline = std::make_shared<Timeline>();
+  SetTimeline(timeline);
+  REQUIRE(CurrentTimeline() == timeline.get());
+  {
+    TimelineScope outer("outer");
+    TimelineScope inner("inner");
+  }
+  SetTimeline(nullptr);
+
+  {
+    TimelineScope scope("unrecorded");
+  }
+  REQUIRE(timeline->Events() == 4);
+
+  const std::string filename = "timeline_test.json";
+  timeline->Save(filename);
+  std::ifstream in(filename.c_str());
+  const std::string json((std::istreambuf_iterator<char>(in)),
+      std::istreambuf_iterator<char>());
+  in.close();
+  std::remove(filename.c_str());
+
+  // The inner interval is nested in the outer one.
+  const size_t outerBegin = json.find("{\"name\":\"outer\"");
+  const size_t innerBegin = json.find("{\"name\":\"inner\"");
+  const size_t innerEnd = json.find("{\"name\":\"inner\"", innerBegin + 1);
+  const size_t outerEnd = json.find("{\"name\":\"outer\"", outerBegin + 1);
+  REQUIRE(outerBegin < innerBegin);
+  REQUIRE(innerBegin < innerEnd);
+  REQUIRE(innerEnd < outerEnd);
+  REQUIRE(outerEnd != std::string::npos);
+  REQUIRE(json.find("unrecorded") == std::string::npos);
+  REQUIRE(json.find("\"name\":\"thread 0\"") != std::string::npos);
+}